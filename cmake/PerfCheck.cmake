@@ -0,0 +1,122 @@
+# Performance regression gate, run by the perf-check target
+#
+# Runs the microbenchmarks and the short end-to-end benchmarks, writes the results to RESULTS, and
+# compares the time of each benchmark with the one in BASELINE. The check fails if a benchmark is
+# slower than its baseline by more than TOLERANCE percent. Benchmarks missing from the baseline
+# are reported but not checked. With UPDATE_BASELINE, the results replace the baseline instead.
+#
+# Usage: cmake -DMICROBENCH=<path> -DBENCHMARK=<path> -DBASELINE=<file> -DRESULTS=<file>
+#              [-DTOLERANCE=<percent>] [-DUPDATE_BASELINE=ON] -P PerfCheck.cmake
+
+cmake_minimum_required(VERSION 3.13)
+
+foreach(var MICROBENCH BENCHMARK BASELINE RESULTS)
+	if(NOT DEFINED ${var})
+		message(FATAL_ERROR "${var} must be defined")
+	endif()
+endforeach()
+
+if(NOT DEFINED TOLERANCE OR TOLERANCE STREQUAL "")
+	set(TOLERANCE 20)
+endif()
+
+# Times are compared as integers in picoseconds since math() does not support decimals
+function(to_picoseconds value out)
+	if(NOT value MATCHES "^([0-9]+)(\\.([0-9]*))?$")
+		message(FATAL_ERROR "Invalid time value: ${value}")
+	endif()
+	set(integer "${CMAKE_MATCH_1}")
+	string(SUBSTRING "${CMAKE_MATCH_3}000" 0 3 fraction)
+	math(EXPR result "${integer} * 1000 + 1${fraction} - 1000")
+	set(${out} ${result} PARENT_SCOPE)
+endfunction()
+
+# Parses the benchmark entries of a JSON output, each on its own line
+function(parse_results content prefix)
+	string(REGEX MATCHALL "{\"name\": \"[^\"]+\"[^\n]*\"real_time\": [0-9.]+[^\n]*}" entries
+	       "${content}")
+	set(names "")
+	foreach(entry IN LISTS entries)
+		string(REGEX MATCH "\"name\": \"([^\"]+)\"" unused "${entry}")
+		set(name "${CMAKE_MATCH_1}")
+		string(REGEX MATCH "\"real_time\": ([0-9.]+)" unused "${entry}")
+		list(APPEND names "${name}")
+		set(${prefix}_${name} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+		set(${prefix}_${name}_entry "${entry}" PARENT_SCOPE)
+	endforeach()
+	set(${prefix}_names "${names}" PARENT_SCOPE)
+endfunction()
+
+function(run_benchmark output)
+	execute_process(COMMAND ${ARGN} --json
+	                OUTPUT_VARIABLE content
+	                RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "Benchmark failed: ${ARGN} (${result})")
+	endif()
+	set(${output} "${content}" PARENT_SCOPE)
+endfunction()
+
+message(STATUS "Running microbenchmarks")
+run_benchmark(micro_output "${MICROBENCH}")
+message(STATUS "Running short end-to-end benchmarks")
+run_benchmark(e2e_output "${BENCHMARK}" --short)
+
+parse_results("${micro_output}\n${e2e_output}" current)
+if(NOT current_names)
+	message(FATAL_ERROR "No benchmark results")
+endif()
+
+set(json "")
+foreach(name IN LISTS current_names)
+	if(NOT json STREQUAL "")
+		string(APPEND json ",\n")
+	endif()
+	string(APPEND json "    ${current_${name}_entry}")
+endforeach()
+cmake_host_system_information(RESULT host QUERY HOSTNAME)
+file(WRITE "${RESULTS}"
+     "{\n  \"context\": {\n    \"library\": \"libdatachannel\",\n    \"host\": \"${host}\"\n"
+     "  },\n  \"benchmarks\": [\n${json}\n  ]\n}\n")
+message(STATUS "Results written to ${RESULTS}")
+
+if(UPDATE_BASELINE)
+	configure_file("${RESULTS}" "${BASELINE}" COPYONLY)
+	message(STATUS "Baseline updated: ${BASELINE}")
+	return()
+endif()
+
+if(NOT EXISTS "${BASELINE}")
+	message(FATAL_ERROR "Baseline ${BASELINE} not found, create it with the perf-baseline target")
+endif()
+file(READ "${BASELINE}" baseline_content)
+parse_results("${baseline_content}" baseline)
+
+set(regressions "")
+foreach(name IN LISTS current_names)
+	if(NOT DEFINED baseline_${name})
+		message(STATUS "${name}: ${current_${name}} ns, no baseline")
+		continue()
+	endif()
+
+	to_picoseconds(${current_${name}} current_ps)
+	to_picoseconds(${baseline_${name}} baseline_ps)
+	if(baseline_ps EQUAL 0)
+		continue()
+	endif()
+
+	math(EXPR change "(${current_ps} - ${baseline_ps}) * 100 / ${baseline_ps}")
+	set(line "${name}: ${current_${name}} ns, baseline ${baseline_${name}} ns (${change}%)")
+	if(change GREATER TOLERANCE)
+		message(STATUS "${line} REGRESSION")
+		list(APPEND regressions "${name}")
+	else()
+		message(STATUS "${line}")
+	endif()
+endforeach()
+
+if(regressions)
+	list(LENGTH regressions count)
+	message(FATAL_ERROR "${count} benchmark(s) regressed by more than ${TOLERANCE}%: ${regressions}")
+endif()
+message(STATUS "No regression beyond ${TOLERANCE}%")
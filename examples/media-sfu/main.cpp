@@ -49,21 +49,16 @@ int main() {
 
 		auto track = pc->addTrack(media);
 
-		track->setMediaHandler(std::make_shared<rtc::RtcpReceivingSession>());
+		// The forwarder sends incoming RTP packets to every receiver track, new receivers start
+		// with the cached keyframe, and keyframe requests of receivers are coalesced
+		auto forwarder = std::make_shared<rtc::RtpForwarder>();
+		forwarder->setKeyframeCache(4 * 1024 * 1024);
+		track->setMediaHandler(std::make_shared<rtc::KeyframeRequestAggregator>());
+		track->chainMediaHandler(std::make_shared<rtc::RtcpReceivingSession>());
+		track->chainMediaHandler(forwarder);
+		track->onMessage([](rtc::binary message) {}, nullptr);
 
 		const rtc::SSRC targetSSRC = 42;
-		track->onMessage(
-		    [&receivers, targetSSRC](rtc::binary message) {
-			    // This is an RTP packet
-			    auto rtp = reinterpret_cast<rtc::RtpHeader *>(message.data());
-			    rtp->setSsrc(targetSSRC);
-			    for (auto pc : receivers) {
-				    if (pc->track != nullptr && pc->track->isOpen()) {
-					    pc->track->send(message);
-				    }
-			    }
-		    },
-		    nullptr);
 
 		pc->setLocalDescription();
 
@@ -100,8 +95,10 @@ int main() {
 
 			r->track = r->conn->addTrack(media);
 
-			r->track->onOpen([r]() {
-				r->track->requestKeyframe(); // So the receiver can start playing immediately
+			r->track->onOpen([track, forwarder]() {
+				// So the receiver can start playing immediately
+				if (!forwarder->hasCachedKeyframe())
+					track->requestKeyframe();
 			});
 			r->track->onMessage([](rtc::binary var) {}, nullptr);
 
@@ -115,6 +112,7 @@ int main() {
 			rtc::Description answer(j["sdp"].get<std::string>(), j["type"].get<std::string>());
 			r->conn->setRemoteDescription(answer);
 
+			forwarder->addTrack(r->track, targetSSRC);
 			receivers.push_back(r);
 		}
 
@@ -8,15 +8,14 @@
  */
 
 #include "fileparser.hpp"
-#include <fstream>
 
 using namespace std;
 
-FileParser::FileParser(string directory, string extension, uint32_t samplesPerSecond, bool loop) {
-    this->directory = directory;
-    this->extension = extension;
+FileParser::FileParser(string directory, string extension, uint32_t samplesPerSecond, bool loop,
+                       MediaIndex::KeyframeDetector isKeyframe) {
     this->loop = loop;
     this->sampleDuration_us = 1000 * 1000 / samplesPerSecond;
+    this->index = MediaIndex::Load(directory, extension, sampleDuration_us, std::move(isKeyframe));
 }
 
 FileParser::~FileParser() {
@@ -24,39 +23,38 @@ FileParser::~FileParser() {
 }
 
 void FileParser::start() {
-    sampleTime_us = std::numeric_limits<uint64_t>::max() - sampleDuration_us + 1;
+    loopTimestampOffset = 0;
     loadNextSample();
 }
 
 void FileParser::stop() {
     sample = {};
+    sampleIsKeyframe = false;
     sampleTime_us = 0;
     counter = -1;
 }
 
 void FileParser::loadNextSample() {
-    string frame_id = to_string(++counter);
-
-    string url = directory + "/sample-" + frame_id + extension;
-    ifstream source(url, ios_base::binary);
-    if (!source) {
+    const auto &frames = index->frames();
+    if (++counter >= frames.size()) {
         if (loop && counter > 0) {
-            loopTimestampOffset = sampleTime_us;
+            loopTimestampOffset = sampleTime_us + sampleDuration_us;
             counter = -1;
             loadNextSample();
             return;
         }
         sample = {};
+        sampleIsKeyframe = false;
         return;
     }
 
-    vector<char> contents((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
-    auto *b = reinterpret_cast<const std::byte*>(contents.data());
-    sample.assign(b, b + contents.size());
-    sampleTime_us += sampleDuration_us;
+    const auto &frame = frames[counter];
+    sample = Sample{frame.data, frame.size};
+    sampleIsKeyframe = frame.keyframe;
+    sampleTime_us = loopTimestampOffset + frame.timestamp_us;
 }
 
-rtc::binary FileParser::getSample() {
+Sample FileParser::getSample() {
 	return sample;
 }
 
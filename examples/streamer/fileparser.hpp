@@ -12,26 +12,29 @@
 
 #include <string>
 #include <vector>
+#include "mediaindex.hpp"
 #include "stream.hpp"
 
+/// Samples are memory-mapped and indexed once, then handed out without copy
 class FileParser: public StreamSource {
-    std::string directory;
-    std::string extension;
+    std::shared_ptr<const MediaIndex> index;
     uint64_t sampleDuration_us;
     uint64_t sampleTime_us = 0;
     uint32_t counter = -1;
     bool loop;
     uint64_t loopTimestampOffset = 0;
 protected:
-    rtc::binary sample = {};
+    Sample sample = {};
+    bool sampleIsKeyframe = false;
 public:
-    FileParser(std::string directory, std::string extension, uint32_t samplesPerSecond, bool loop);
+    FileParser(std::string directory, std::string extension, uint32_t samplesPerSecond, bool loop,
+               MediaIndex::KeyframeDetector isKeyframe = nullptr);
     virtual ~FileParser();
     virtual void start() override;
     virtual void stop() override;
     virtual void loadNextSample() override;
 
-    rtc::binary getSample() override;
+    Sample getSample() override;
     uint64_t getSampleTime_us() override;
     uint64_t getSampleDuration_us() override;
 };
@@ -10,7 +10,7 @@
 #include "h264fileparser.hpp"
 #include "rtc/rtc.hpp"
 
-#include <fstream>
+#include <cassert>
 #include <cstring>
 
 #ifdef _WIN32
@@ -21,51 +21,65 @@
 
 using namespace std;
 
-H264FileParser::H264FileParser(string directory, uint32_t fps, bool loop): FileParser(directory, ".h264", fps, loop) { }
-
-void H264FileParser::loadNextSample() {
-    FileParser::loadNextSample();
+namespace {
 
+// Calls f(start, end, type) for each length-prefixed NAL unit, start being the length prefix
+template <typename F> void forEachNalu(const std::byte *data, size_t size, F f) {
     size_t i = 0;
-    while (i < sample.size()) {
-        assert(i + 4 < sample.size());
-        auto lengthPtr = (uint32_t *) (sample.data() + i);
+    while (i < size) {
+        assert(i + 4 < size);
         uint32_t length;
-        std::memcpy(&length, lengthPtr, sizeof(uint32_t));
+        std::memcpy(&length, data + i, sizeof(uint32_t));
         length = ntohl(length);
         auto naluStartIndex = i + 4;
         auto naluEndIndex = naluStartIndex + length;
-        assert(naluEndIndex <= sample.size());
-        auto header = reinterpret_cast<rtc::NalUnitHeader *>(sample.data() + naluStartIndex);
-        auto type = header->unitType();
+        assert(naluEndIndex <= size);
+        auto header = reinterpret_cast<const rtc::NalUnitHeader *>(data + naluStartIndex);
+        f(i, naluEndIndex, header->unitType());
+        i = naluEndIndex;
+    }
+}
+
+bool containsIdr(const std::byte *data, size_t size) {
+    bool idr = false;
+    forEachNalu(data, size, [&idr](size_t, size_t, uint8_t type) { idr = idr || type == 5; });
+    return idr;
+}
+
+} // namespace
+
+H264FileParser::H264FileParser(string directory, uint32_t fps, bool loop): FileParser(directory, ".h264", fps, loop, containsIdr) { }
+
+void H264FileParser::loadNextSample() {
+    FileParser::loadNextSample();
+
+    // Parameter sets are sent along with IDR units, so only keyframes need to be parsed
+    if (!sampleIsKeyframe) {
+        return;
+    }
+
+    forEachNalu(sample.data, sample.size, [this](size_t start, size_t end, uint8_t type) {
+        Sample unit{sample.data + start, end - start};
         switch (type) {
             case 7:
-                previousUnitType7 = {sample.begin() + i, sample.begin() + naluEndIndex};
+                previousUnitType7 = unit;
                 break;
             case 8:
-                previousUnitType8 = {sample.begin() + i, sample.begin() + naluEndIndex};;
+                previousUnitType8 = unit;
                 break;
             case 5:
-                previousUnitType5 = {sample.begin() + i, sample.begin() + naluEndIndex};;
+                previousUnitType5 = unit;
                 break;
         }
-        i = naluEndIndex;
-    }
+    });
 }
 
 vector<std::byte> H264FileParser::initialNALUS() {
     vector<std::byte> units{};
-    if (previousUnitType7.has_value()) {
-        auto nalu = previousUnitType7.value();
-        units.insert(units.end(), nalu.begin(), nalu.end());
-    }
-    if (previousUnitType8.has_value()) {
-        auto nalu = previousUnitType8.value();
-        units.insert(units.end(), nalu.begin(), nalu.end());
-    }
-    if (previousUnitType5.has_value()) {
-        auto nalu = previousUnitType5.value();
-        units.insert(units.end(), nalu.begin(), nalu.end());
+    for (const auto &nalu : {previousUnitType7, previousUnitType8, previousUnitType5}) {
+        if (nalu.has_value()) {
+            units.insert(units.end(), nalu->data, nalu->data + nalu->size);
+        }
     }
     return units;
 }
@@ -14,9 +14,10 @@
 #include <optional>
 
 class H264FileParser: public FileParser {
-    std::optional<std::vector<std::byte>> previousUnitType5 = std::nullopt;
-    std::optional<std::vector<std::byte>> previousUnitType7 = std::nullopt;
-    std::optional<std::vector<std::byte>> previousUnitType8 = std::nullopt;
+    // Views into the mapped samples, with their length prefix
+    std::optional<Sample> previousUnitType5 = std::nullopt;
+    std::optional<Sample> previousUnitType7 = std::nullopt;
+    std::optional<Sample> previousUnitType8 = std::nullopt;
 
 public:
     H264FileParser(std::string directory, uint32_t fps, bool loop);
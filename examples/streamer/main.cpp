@@ -332,7 +332,7 @@ shared_ptr<Stream> createStream(const string h264Samples, const unsigned fps, co
 
     auto stream = make_shared<Stream>(video, audio);
     // set callback responsible for sample sending
-    stream->onSample([ws = make_weak_ptr(stream)](Stream::StreamSourceType type, uint64_t sampleTime, rtc::binary sample) {
+    stream->onSample([ws = make_weak_ptr(stream)](Stream::StreamSourceType type, uint64_t sampleTime, Sample sample) {
         vector<ClientTrack> tracks{};
         string streamType = type == Stream::StreamSourceType::Video ? "video" : "audio";
         // get track for given type
@@ -354,10 +354,11 @@ shared_ptr<Stream> createStream(const string h264Samples, const unsigned fps, co
                 auto client = clientTrack.id;
                 auto trackData = clientTrack.trackData;
 
-                cout << "Sending " << streamType << " sample with size: " << to_string(sample.size()) << " to " << client << endl;
+                cout << "Sending " << streamType << " sample with size: " << to_string(sample.size) << " to " << client << endl;
                 try {
-                    // send sample
-                    trackData->track->sendFrame(sample, std::chrono::duration<double, std::micro>(sampleTime));
+                    // send sample, the track reads it from the mapped file without a copy
+                    trackData->track->sendFrame(sample.data, sample.size,
+                                                rtc::FrameInfo(std::chrono::duration<double, std::micro>(sampleTime)));
                 } catch (const std::exception &e) {
                     cerr << "Unable to send "<< streamType << " packet: " << e.what() << endl;
                 }
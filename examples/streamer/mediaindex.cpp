@@ -0,0 +1,105 @@
+/**
+ * libdatachannel streamer example
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "mediaindex.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string &path) {
+    ifstream source(path, ios_base::binary);
+    if (!source)
+        throw runtime_error("Unable to open " + path);
+
+    vector<char> contents((istreambuf_iterator<char>(source)), istreambuf_iterator<char>());
+    auto *b = reinterpret_cast<const byte *>(contents.data());
+    mBuffer.assign(b, b + contents.size());
+    mData = mBuffer.data();
+    mSize = mBuffer.size();
+}
+
+MappedFile::~MappedFile() {}
+
+#else
+
+MappedFile::MappedFile(const string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw runtime_error("Unable to open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        throw runtime_error("Unable to stat " + path);
+    }
+
+    mSize = size_t(st.st_size);
+    if (mSize > 0) {
+        void *addr = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Unable to map " + path);
+        }
+        mData = static_cast<const byte *>(addr);
+    }
+    close(fd); // the mapping stays valid
+}
+
+MappedFile::~MappedFile() {
+    if (mData)
+        munmap(const_cast<byte *>(mData), mSize);
+}
+
+#endif
+
+shared_ptr<const MediaIndex> MediaIndex::Load(const string &directory, const string &extension,
+                                              uint64_t sampleDuration_us, KeyframeDetector isKeyframe) {
+    // Sources reading the same samples share the index, and so the mapped pages
+    static mutex cacheMutex;
+    static map<string, weak_ptr<const MediaIndex>> cache;
+
+    const string key = directory + "/sample-*" + extension + "@" + to_string(sampleDuration_us);
+    lock_guard lock(cacheMutex);
+    if (auto it = cache.find(key); it != cache.end())
+        if (auto index = it->second.lock())
+            return index;
+
+    auto index = make_shared<MediaIndex>();
+    for (uint32_t counter = 0;; ++counter) {
+        string url = directory + "/sample-" + to_string(counter) + extension;
+        if (!ifstream(url))
+            break;
+
+        auto file = make_unique<MappedFile>(url);
+        Frame frame;
+        frame.data = file->data();
+        frame.size = file->size();
+        frame.timestamp_us = counter * sampleDuration_us;
+        frame.keyframe = isKeyframe ? isKeyframe(frame.data, frame.size) : true;
+        index->mFrames.push_back(frame);
+        index->mFiles.push_back(std::move(file));
+    }
+
+    cache[key] = index;
+    return index;
+}
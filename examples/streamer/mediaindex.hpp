@@ -0,0 +1,61 @@
+/**
+ * libdatachannel streamer example
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef mediaindex_hpp
+#define mediaindex_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Read-only mapping of a whole file, memory-mapped on POSIX and read once on Windows
+class MappedFile {
+    const std::byte *mData = nullptr;
+    size_t mSize = 0;
+#ifdef _WIN32
+    std::vector<std::byte> mBuffer;
+#endif
+
+public:
+    MappedFile(const std::string &path); // throws std::runtime_error on failure
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const std::byte *data() const { return mData; }
+    size_t size() const { return mSize; }
+};
+
+/// Frames of a sample directory, mapped once and shared by all the sources reading it
+class MediaIndex {
+public:
+    struct Frame {
+        const std::byte *data; // points into the mapped file, valid as long as the index
+        size_t size;
+        uint64_t timestamp_us; // from the start of the media
+        bool keyframe;
+    };
+
+    using KeyframeDetector = std::function<bool (const std::byte *data, size_t size)>;
+
+    /// Index sample-0<extension>, sample-1<extension>... until a file is missing
+    static std::shared_ptr<const MediaIndex> Load(const std::string &directory, const std::string &extension,
+                                                  uint64_t sampleDuration_us, KeyframeDetector isKeyframe = nullptr);
+
+    const std::vector<Frame> &frames() const { return mFrames; }
+
+private:
+    std::vector<std::unique_ptr<MappedFile>> mFiles;
+    std::vector<Frame> mFrames;
+};
+
+#endif /* mediaindex_hpp */
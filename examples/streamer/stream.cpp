@@ -10,26 +10,6 @@
 #include "stream.hpp"
 #include "helpers.hpp"
 
-#ifdef _WIN32
-// taken from https://stackoverflow.com/questions/5801813/c-usleep-is-obsolete-workarounds-for-windows-mingw
-#include <windows.h>
-
-void usleep(__int64 usec)
-{
-    HANDLE timer;
-    LARGE_INTEGER ft;
-
-    ft.QuadPart = -(10*usec); // Convert to 100 nanosecond interval, negative value indicates relative time
-
-    timer = CreateWaitableTimer(NULL, TRUE, NULL);
-    SetWaitableTimer(timer, &ft, 0, NULL, NULL, 0);
-    WaitForSingleObject(timer, INFINITE);
-    CloseHandle(timer);
-}
-#else
-#include <unistd.h>
-#endif
-
 Stream::Stream(std::shared_ptr<StreamSource> video, std::shared_ptr<StreamSource> audio):
 	std::enable_shared_from_this<Stream>(), video(video), audio(audio) { }
 
@@ -37,49 +17,32 @@ Stream::~Stream() {
     stop();
 }
 
-std::pair<std::shared_ptr<StreamSource>, Stream::StreamSourceType> Stream::unsafePrepareForSample() {
-    std::shared_ptr<StreamSource> ss;
-    StreamSourceType sst;
-    uint64_t nextTime;
-    if (audio->getSampleTime_us() < video->getSampleTime_us()) {
-        ss = audio;
-        sst = StreamSourceType::Audio;
-        nextTime = audio->getSampleTime_us();
-    } else {
-        ss = video;
-        sst = StreamSourceType::Video;
-        nextTime = video->getSampleTime_us();
-    }
-
-    auto currentTime = currentTimeInMicroSeconds();
+rtc::MediaScheduler &Stream::scheduler() {
+    // One media clock for all streams, frames are delivered on the library thread pool
+    static rtc::MediaScheduler instance;
+    return instance;
+}
 
-    auto elapsed = currentTime - startTime;
-    if (nextTime > elapsed) {
-        auto waitTime = nextTime - elapsed;
-        mutex.unlock();
-        usleep(waitTime);
-        mutex.lock();
-    }
-    return {ss, sst};
+rtc::MediaScheduler::StreamId Stream::schedule(std::shared_ptr<StreamSource> source, StreamSourceType type) {
+    auto interval = std::chrono::microseconds(source->getSampleDuration_us());
+    return scheduler().addStream(interval, [weak_this = weak_from_this(), source, type](uint64_t, std::chrono::microseconds) {
+        auto locked = weak_this.lock();
+        return locked && locked->sendSample(source, type);
+    });
 }
 
-void Stream::sendSample() {
+bool Stream::sendSample(const std::shared_ptr<StreamSource> &source, StreamSourceType type) {
     std::lock_guard lock(mutex);
     if (!isRunning) {
-        return;
+        return false;
     }
-    auto ssSST = unsafePrepareForSample();
-    auto ss = ssSST.first;
-    auto sst = ssSST.second;
-    auto sample = ss->getSample();
-    sampleHandler(sst, ss->getSampleTime_us(), sample);
-    ss->loadNextSample();
-    dispatchQueue.dispatch([this]() {
-        this->sendSample();
-    });
+    auto sample = source->getSample();
+    sampleHandler(type, source->getSampleTime_us(), sample);
+    source->loadNextSample();
+    return true;
 }
 
-void Stream::onSample(std::function<void (StreamSourceType, uint64_t, rtc::binary)> handler) {
+void Stream::onSample(std::function<void (StreamSourceType, uint64_t, Sample)> handler) {
     sampleHandler = handler;
 }
 
@@ -89,12 +52,10 @@ void Stream::start() {
         return;
     }
     _isRunning = true;
-    startTime = currentTimeInMicroSeconds();
     audio->start();
     video->start();
-    dispatchQueue.dispatch([this]() {
-        this->sendSample();
-    });
+    audioId = schedule(audio, StreamSourceType::Audio);
+    videoId = schedule(video, StreamSourceType::Video);
 }
 
 void Stream::stop() {
@@ -103,7 +64,8 @@ void Stream::stop() {
         return;
     }
     _isRunning = false;
-    dispatchQueue.removePending();
+    scheduler().removeStream(audioId);
+    scheduler().removeStream(videoId);
     audio->stop();
     video->stop();
 };
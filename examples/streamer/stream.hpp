@@ -13,6 +13,14 @@
 #include "dispatchqueue.hpp"
 #include "rtc/rtc.hpp"
 
+/// View of a sample, valid as long as its source
+struct Sample {
+    const std::byte *data = nullptr;
+    size_t size = 0;
+
+    bool empty() const { return size == 0; }
+};
+
 class StreamSource {
 protected:
 
@@ -23,13 +31,14 @@ public:
 
     virtual uint64_t getSampleTime_us() = 0;
     virtual uint64_t getSampleDuration_us() = 0;
-	virtual rtc::binary getSample() = 0;
+	virtual Sample getSample() = 0;
 };
 
+/// Sends the samples of its sources on the shared rtc::MediaScheduler, without a thread per stream
 class Stream: public std::enable_shared_from_this<Stream> {
-    uint64_t startTime = 0;
     std::mutex mutex;
-    DispatchQueue dispatchQueue = DispatchQueue("StreamQueue");
+    rtc::MediaScheduler::StreamId audioId = 0;
+    rtc::MediaScheduler::StreamId videoId = 0;
 
     bool _isRunning = false;
 public:
@@ -45,14 +54,15 @@ public:
     };
 
 private:
-    rtc::synchronized_callback<StreamSourceType, uint64_t, rtc::binary> sampleHandler;
+    rtc::synchronized_callback<StreamSourceType, uint64_t, Sample> sampleHandler;
 
-    std::pair<std::shared_ptr<StreamSource>, StreamSourceType> unsafePrepareForSample();
+    static rtc::MediaScheduler &scheduler();
 
-    void sendSample();
+    rtc::MediaScheduler::StreamId schedule(std::shared_ptr<StreamSource> source, StreamSourceType type);
+    bool sendSample(const std::shared_ptr<StreamSource> &source, StreamSourceType type);
 
 public:
-    void onSample(std::function<void (StreamSourceType, uint64_t, rtc::binary)> handler);
+    void onSample(std::function<void (StreamSourceType, uint64_t, Sample)> handler);
     void start();
     void stop();
     const bool & isRunning = _isRunning;
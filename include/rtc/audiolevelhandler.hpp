@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_AUDIO_LEVEL_HANDLER_H
+#define RTC_AUDIO_LEVEL_HANDLER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc {
+
+/// Extracts the audio level of incoming packets from the client-to-mixer audio level header
+/// extension (RFC 6464) without decoding, smoothed per SSRC with an exponential moving average,
+/// so that an SFU can find the active speakers and forward only the last N of them.
+/// The extension must be negotiated with AudioLevelHandler::ExtensionUri in the media description.
+/// Handlers forked from the same one share the levels, to rank the speakers of a whole room.
+class RTC_CPP_EXPORT AudioLevelHandler final : public MediaHandler {
+public:
+	static constexpr const char *ExtensionUri = "urn:ietf:params:rtp-hdrext:ssrc-audio-level";
+	static constexpr double DefaultSmoothing = 0.1; // weight of each new packet, 20 ms for Opus
+	static constexpr auto DefaultTimeout = std::chrono::milliseconds(1000);
+
+	using clock = std::chrono::steady_clock;
+
+	struct Level {
+		SSRC ssrc = 0;
+		double level = 127.;        // smoothed, in -dBov, 0 is the loudest and 127 is silence
+		bool voiceActivity = false; // flag of the last packet, if set by the sender
+		clock::time_point lastTime; // arrival time of the last packet
+	};
+
+	/// @param smoothing Weight of each new packet in the moving average, between 0 and 1
+	/// @param timeout Time without packets after which a stream is not a speaker anymore, as
+	/// senders with discontinuous transmission stop sending in silence
+	AudioLevelHandler(double smoothing = DefaultSmoothing,
+	                  std::chrono::milliseconds timeout = DefaultTimeout);
+
+	/// Returns a handler for another track, sharing the levels
+	shared_ptr<AudioLevelHandler> fork() const;
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+
+	/// Returns the level of a stream, if it was heard before the timeout
+	optional<Level> level(SSRC ssrc) const;
+
+	/// Returns up to count streams heard before the timeout, the loudest first
+	std::vector<Level> topSpeakers(size_t count) const;
+
+private:
+	// Shared between forked handlers
+	struct Levels {
+		Levels(double smoothing, clock::duration timeout);
+
+		void record(SSRC ssrc, uint8_t value, clock::time_point now);
+
+		const double smoothing;
+		const clock::duration timeout;
+		std::unordered_map<SSRC, Level> levels;
+		mutable std::mutex mutex;
+	};
+
+	explicit AudioLevelHandler(shared_ptr<Levels> levels);
+
+	const shared_ptr<Levels> mLevels;
+	std::atomic<uint8_t> mExtId = 0;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_AUDIO_LEVEL_HANDLER_H */
@@ -36,15 +36,18 @@ public:
 	                 size_t maxFragmentSize = DefaultMaxFragmentSize);
 
 private:
-	static std::vector<binary> extractTemporalUnitObus(const binary &data);
-
-	std::vector<binary> fragment(binary data) override;
-	std::vector<binary> fragmentObu(const binary &data);
+	bool slice(const binary &frame, std::vector<Slice> &slices) override;
+	void sliceObu(const binary &frame, size_t offset, size_t size, std::vector<Slice> &slices);
 
 	const Packetization mPacketization;
 	const size_t mMaxFragmentSize;
 
-	std::unique_ptr<binary> mSequenceHeader;
+	// Sequence header to send with the next OBU, pointing either in the frame or in mSequenceHeader
+	const byte *mPendingHeader = nullptr;
+	size_t mPendingHeaderSize = 0;
+
+	binary mSequenceHeader;     // cached by the previous frame, unchanged until the next one
+	binary mNextSequenceHeader; // cached for the next frame
 };
 
 // For backward compatibility, do not use
@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_BROADCAST_GROUP_H
+#define RTC_BROADCAST_GROUP_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "common.hpp"
+#include "frameinfo.hpp"
+#include "mediahandler.hpp"
+#include "rtpforwarder.hpp"
+#include "track.hpp"
+
+#include <mutex>
+
+namespace rtc {
+
+/// Broadcasting of a media stream to many tracks
+/// Frames are packetized once by the media handler, typically a packetizer, and the packets are
+/// sent to every added track with an RtpForwarder, so each track only rewrites the SSRC, the
+/// sequence number, and the timestamp, then protects its own copy. The handlers of the tracks must
+/// not packetize, but may report or retransmit, like RtcpSrReporter and RtcpNackResponder.
+class RTC_CPP_EXPORT BroadcastGroup final {
+public:
+	BroadcastGroup(shared_ptr<MediaHandler> packetizer);
+
+	/// Adds a track to send to, see RtpForwarder::addTrack()
+	void addTrack(shared_ptr<Track> track, SSRC ssrc, optional<uint8_t> payloadType = nullopt);
+	void removeTrack(const shared_ptr<Track> &track);
+	size_t trackCount() const;
+
+	void sendFrame(binary data, FrameInfo info);
+	void sendFrame(const byte *data, size_t size, FrameInfo info);
+
+	/// Enables the keyframe cache so that added tracks start playing immediately, see
+	/// RtpForwarder::setKeyframeCache(). The codec is taken from the descriptions of added tracks,
+	/// which must use the payload type of the packetizer.
+	void setKeyframeCache(size_t maxSize);
+	bool hasCachedKeyframe() const;
+
+private:
+	void send(message_ptr frame);
+
+	const shared_ptr<MediaHandler> mPacketizer;
+	const shared_ptr<RtpForwarder> mForwarder;
+	std::mutex mSendMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_BROADCAST_GROUP_H */
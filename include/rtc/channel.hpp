@@ -10,6 +10,7 @@
 #define RTC_CHANNEL_H
 
 #include "common.hpp"
+#include "message.hpp"
 
 #include <atomic>
 #include <functional>
@@ -41,6 +42,13 @@ public:
 	void onMessage(std::function<void(binary data)> binaryCallback,
 	               std::function<void(string data)> stringCallback);
 
+	// Zero-copy reception: received messages are shared with the library instead of being moved or
+	// copied into a message_variant, so they must not be modified. Replaces onMessage callbacks.
+	void onMessageView(std::function<void(shared_ptr<const Message> message)> callback);
+	// Same with separate callbacks, views are only valid until the callback returns
+	void onMessageView(std::function<void(const byte *data, size_t size)> binaryCallback,
+	                   std::function<void(string_view data)> stringCallback);
+
 	void onBufferedAmountLow(std::function<void()> callback);
 	void setBufferedAmountLowThreshold(size_t amount);
 
@@ -49,6 +57,8 @@ public:
 	// Extended API
 	optional<message_variant> receive(); // only if onMessage unset
 	optional<message_variant> peek();    // only if onMessage unset
+	shared_ptr<const Message> receiveView(); // only if onMessage unset, null if none available
+	shared_ptr<const Message> peekView();    // only if onMessage unset, null if none available
 	size_t availableAmount() const;      // total size available to receive
 	void onAvailable(std::function<void()> callback);
 
@@ -11,6 +11,7 @@
 
 #include "common.hpp"
 
+#include <chrono>
 #include <vector>
 
 namespace rtc {
@@ -61,6 +62,26 @@ enum class CertificateType {
 	Rsa = RTC_CERTIFICATE_RSA
 };
 
+// DTLS-SRTP protection profiles, see RFC 5764 and RFC 7714
+enum class SrtpProfile { Aes128CmSha1_80, Aes128CmSha1_32, AeadAes128Gcm, AeadAes256Gcm };
+
+// Emulated network impairments applied to outgoing packets, for testing and benchmarking only
+struct NetworkImpairment {
+	double lossRate = 0.;      // probability of dropping a packet
+	double duplicateRate = 0.; // probability of sending a packet twice
+	double reorderRate = 0.;   // probability of a packet being sent without delay, like netem
+
+	std::chrono::milliseconds delay = std::chrono::milliseconds::zero();
+	std::chrono::milliseconds jitter = std::chrono::milliseconds::zero(); // uniform extra delay
+
+	// Token bucket bandwidth limit, packets are dropped once the queue delay exceeds the maximum
+	optional<size_t> bitrate;     // bits per second, not set means unlimited
+	size_t burstSize = 16 * 1024; // bytes
+	std::chrono::milliseconds maxQueueDelay = std::chrono::milliseconds(100);
+
+	unsigned int seed = 1; // random seed, so runs are reproducible
+};
+
 enum class TransportPolicy { All = RTC_TRANSPORT_POLICY_ALL, Relay = RTC_TRANSPORT_POLICY_RELAY };
 
 struct RTC_CPP_EXPORT Configuration {
@@ -74,10 +95,54 @@ struct RTC_CPP_EXPORT Configuration {
 	TransportPolicy iceTransportPolicy = TransportPolicy::All;
 	bool enableIceTcp = false;
 	bool enableIceUdpMux = false; // libjuice only
+	// With UDP mux, spread agents over consecutive ports from portRangeBegin, one socket each
+	unsigned int iceUdpMuxShards = 1;
 	bool disableAutoNegotiation = false;
 	bool disableAutoGathering = false;
 	bool forceMediaTransport = false;
 	bool disableFingerprintVerification = false;
+	bool enableDtlsSessionResumption = false; // abbreviated handshakes between same certificates
+	// Remember the selected candidate pair by remote fingerprint to check it first on reconnection,
+	// this also enables DTLS session resumption
+	bool enableConnectionCache = false;
+	bool enableDtls13 = false; // one round trip handshakes if both peers support it, OpenSSL only
+	bool enableParallelSrtp = false; // protect outgoing SRTP streams in parallel per SSRC
+	// SRTP profiles in order of preference, OpenSSL only. Empty means the cheapest ones first,
+	// which is AES-GCM on CPUs with AES instructions and AES-CM with HMAC-SHA1 otherwise.
+	// Aes128CmSha1_80 is always offered, last if missing, as it is mandatory per RFC 8827.
+	std::vector<SrtpProfile> srtpProfiles;
+	bool enableMediaEcn = false; // mark outgoing media ECT(1) for L4S, see RtcpCcfbReporter
+	bool enableSctpInterleaving = false; // RFC 8260 I-DATA, if supported by the remote peer
+	// Schedule data already passed to usrsctp by DataChannel priority, if supported by usrsctp.
+	// Otherwise priorities only apply to messages buffered by the library.
+	bool enableSctpStreamPriorities = false;
+	bool enableLowMemoryMode = false; // small buffers grown on demand, for many idle connections
+	bool enableUdpSegmentationOffload = false; // UDP GSO for packet runs, libnice on Linux only
+	// Run DTLS, SCTP, and callbacks on one executor thread instead of the thread pool workers, see
+	// ThreadPoolSettings for the executor count and pinning
+	bool enableExecutorAffinity = false;
+	// Unprotect incoming media on the ICE receive thread instead of handing it to a worker. With
+	// enableIceUdpMux, one receive loop per mux socket then serves media for every connection, and
+	// media callbacks are called from it, so they must return quickly.
+	bool enableInlineMediaReceive = false;
+
+	// If set, gathering is complete once a server-reflexive candidate is gathered or after the
+	// deadline, and later candidates like relayed ones trickle afterwards
+	optional<std::chrono::milliseconds> gatheringDeadline;
+
+	// If set, the connection survives an ICE disconnection for this long, so ICE can move to a
+	// new path, for instance after a NAT rebinding, without a new DTLS handshake
+	optional<std::chrono::milliseconds> iceDisconnectedTimeout;
+
+	// SCTP heartbeat interval for this PeerConnection, not set means the global setting and zero
+	// disables heartbeats. Idle-heavy deployments may raise it to cut wakeups.
+	optional<std::chrono::milliseconds> keepaliveInterval;
+
+	// Max TURN allocations per PeerConnection, not set means 2 with libjuice and unlimited with
+	// libnice. 1 is enough for most deployments and saves allocations and refresh traffic.
+	// Allocations are never shared between PeerConnections, as neither libjuice nor libnice
+	// allows an agent to use a relayed candidate allocated outside of it.
+	optional<unsigned int> maxTurnAllocations;
 
 	// Port range
 	uint16_t portRangeBegin = 1024;
@@ -93,13 +158,16 @@ struct RTC_CPP_EXPORT Configuration {
 	optional<string> certificatePemFile;
 	optional<string> keyPemFile;
 	optional<string> keyPemPass;
+
+	// Impairments of the network path for outgoing packets, for testing only
+	optional<NetworkImpairment> networkImpairment;
 };
 
 #ifdef RTC_ENABLE_WEBSOCKET
 
 struct WebSocketConfiguration {
 	bool disableTlsVerification = false; // if true, don't verify the TLS certificate
-	optional<ProxyServer> proxyServer;   // only non-authenticated http supported for now
+	optional<ProxyServer> proxyServer;   // HTTP CONNECT or SOCKS5, with optional credentials
 	std::vector<string> protocols;
 	optional<std::chrono::milliseconds> connectionTimeout; // zero to disable
 	optional<std::chrono::milliseconds> pingInterval;      // zero to disable
@@ -109,6 +177,18 @@ struct WebSocketConfiguration {
 	optional<string> keyPemFile;
 	optional<string> keyPemPass;
 	optional<size_t> maxMessageSize;
+
+	// permessage-deflate compression (RFC 7692), requires building with USE_ZLIB
+	bool enableCompression = false;
+	bool disableCompressionContextTakeover = false; // if true, compress each message independently
+	optional<int> compressionWindowBits;            // 9 to 15, default 15
+	optional<size_t> compressionThreshold;          // smaller messages are sent uncompressed
+
+	bool enableKernelTls = false; // offload TLS encryption to the kernel (Linux with OpenSSL)
+
+	// WebSocket over HTTP/2 (RFC 8441) for wss URLs, falls back to HTTP/1.1 if not supported by
+	// the server. WebSockets to the same server share a single TLS connection.
+	bool enableHttp2 = false;
 };
 
 struct WebSocketServerConfiguration {
@@ -119,7 +199,23 @@ struct WebSocketServerConfiguration {
 	optional<string> keyPemPass;
 	optional<string> bindAddress;
 	optional<std::chrono::milliseconds> connectionTimeout;
+	optional<unsigned int> acceptorsCount; // listeners sharing the port with SO_REUSEPORT, default 1
 	optional<size_t> maxMessageSize;
+
+	// permessage-deflate compression (RFC 7692), requires building with USE_ZLIB
+	bool enableCompression = false;
+	bool disableCompressionContextTakeover = false; // if true, compress each message independently
+	optional<int> compressionWindowBits;            // 9 to 15, default 15
+	optional<size_t> compressionThreshold;          // smaller messages are sent uncompressed
+
+	bool enableKernelTls = false; // offload TLS encryption to the kernel (Linux with OpenSSL)
+
+	// Admission control: connections accepted while this many clients are still in the TLS or
+	// HTTP handshake are closed immediately, default unlimited. connectionTimeout bounds the
+	// duration of each handshake.
+	optional<unsigned int> maxConcurrentHandshakes;
+	// TLS handshakes run on these dedicated threads, default on the control-plane thread pool
+	optional<unsigned int> handshakeThreads;
 };
 
 #endif
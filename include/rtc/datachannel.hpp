@@ -12,9 +12,19 @@
 #include "channel.hpp"
 #include "common.hpp"
 #include "reliability.hpp"
+#include "stats.hpp"
 
+#include <exception>
+#include <functional>
+#include <future>
 #include <type_traits>
 
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <atomic>
+#include <coroutine>
+#define RTC_HAS_COROUTINES 1
+#endif
+
 namespace rtc {
 
 namespace impl {
@@ -34,21 +44,85 @@ public:
 	string label() const;
 	string protocol() const;
 	Reliability reliability() const;
+	uint16_t priority() const;
 
 	bool isOpen(void) const override;
 	bool isClosed(void) const override;
 	size_t maxMessageSize() const override;
+	DataChannelStats getStats() const;
 
 	void close(void) override;
 	bool send(message_variant data) override;
 	bool send(const byte *data, size_t size) override;
+	// Sends caller-owned data without copying it. release is called exactly once, possibly before
+	// send() returns, when the data is not needed anymore, even if send() throws. Data is kept
+	// until then if it must be buffered.
+	bool send(const byte *data, size_t size, std::function<void()> release);
+	// Sends messages in order as a batch, cheaper than a loop on send() for many small messages
+	bool sendMany(std::vector<message_variant> messages); // returns false if any is buffered
 	template <typename Buffer> bool sendBuffer(const Buffer &buf);
 	template <typename Iterator> bool sendBuffer(Iterator first, Iterator last);
 
+	// Sends with backpressure: the message is handed to the transport, in order, once the buffered
+	// amount is lower than or equal to the high threshold. The callback is called with null or the
+	// error when done, possibly synchronously or from an internal thread, so it must not block.
+	void sendAsync(message_variant data, std::function<void(std::exception_ptr error)> callback);
+	std::future<void> sendAsync(message_variant data);
+	void setBufferedAmountHighThreshold(size_t amount); // defaults to 1 MiB
+
+	// Receive-side backpressure: while more than amount bytes are available to read, reception
+	// is paused until half is drained. Flow control is per connection, so reception pauses for
+	// all channels of the PeerConnection meanwhile. 0, the default, means no limit.
+	void setMaxAvailableAmount(size_t amount);
+
+#if RTC_HAS_COROUTINES
+	// co_await channel->sendAwait(data) suspends until the message is handed to the transport,
+	// the coroutine is then resumed from an internal thread.
+	class SendAwaiter;
+	SendAwaiter sendAwait(message_variant data);
+#endif
+
 private:
 	using CheshireCat<impl::DataChannel>::impl;
 };
 
+#if RTC_HAS_COROUTINES
+
+class DataChannel::SendAwaiter final {
+public:
+	SendAwaiter(DataChannel *channel, message_variant data)
+	    : mChannel(channel), mData(std::move(data)) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	bool await_suspend(std::coroutine_handle<> handle) {
+		// Whichever of the callback and this method comes last decides on resuming
+		mChannel->sendAsync(std::move(mData), [this, handle](std::exception_ptr error) {
+			mError = error;
+			if (mDone.exchange(true))
+				handle.resume();
+		});
+		return !mDone.exchange(true);
+	}
+
+	void await_resume() const {
+		if (mError)
+			std::rethrow_exception(mError);
+	}
+
+private:
+	DataChannel *mChannel;
+	message_variant mData;
+	std::exception_ptr mError;
+	std::atomic<bool> mDone = false;
+};
+
+inline DataChannel::SendAwaiter DataChannel::sendAwait(message_variant data) {
+	return SendAwaiter(this, std::move(data));
+}
+
+#endif
+
 template <typename Buffer> std::pair<const byte *, size_t> to_bytes(const Buffer &buf) {
 	using T = typename std::remove_pointer<decltype(buf.data())>::type;
 	using E = typename std::conditional<std::is_void<T>::value, byte, T>::type;
@@ -12,6 +12,7 @@
 #include "common.hpp"
 
 #include <bitset>
+#include <utility>
 
 namespace rtc {
 
@@ -36,6 +37,23 @@ private:
 	size_t mSize = 0;
 };
 
+struct BitReader {
+	static BitReader fromSizeBits(const byte *buf, size_t offsetBits, size_t sizeBits);
+
+	size_t getReadBits() const;
+
+	bool read(uint64_t &v, size_t bits);
+	// Read non-symmetric unsigned encoded integer
+	// ref: https://aomediacodec.github.io/av1-rtp-spec/#a82-syntax
+	bool readNonSymmetric(uint64_t &v, uint64_t n);
+
+private:
+	const byte *mBuf = nullptr;
+	size_t mInitialOffset = 0;
+	size_t mOffset = 0;
+	size_t mSize = 0;
+};
+
 enum class DecodeTargetIndication {
 	NotPresent = 0,
 	Discardable = 1,
@@ -63,6 +81,10 @@ struct FrameDependencyStructure {
 	std::vector<int> decodeTargetProtectedBy;
 	std::vector<RenderResolution> resolutions;
 	std::vector<FrameDependencyTemplate> templates;
+
+	// Returns the highest spatial and temporal ids of frames needed for a decode target
+	// ref: https://aomediacodec.github.io/av1-rtp-spec/#a9-decode-target-layers
+	std::pair<int, int> decodeTargetLayers(int decodeTarget) const;
 };
 
 struct DependencyDescriptor {
@@ -102,6 +124,24 @@ private:
 	const DependencyDescriptor &mDescriptor;
 };
 
+// Read dependency descriptor from RTP Header Extension
+// The structure of the context is required to read a descriptor without attached structure, it is
+// replaced when a new one is attached. Throws std::invalid_argument if the descriptor is invalid.
+class DependencyDescriptorReader {
+public:
+	DependencyDescriptorReader(const byte *buf, size_t sizeBytes);
+	void readTo(DependencyDescriptorContext &context) const;
+
+private:
+	void readStructure(BitReader &reader, FrameDependencyStructure &structure) const;
+	uint64_t readBits(BitReader &reader, size_t bits) const;
+	uint64_t readNonSymmetric(BitReader &reader, uint64_t n) const;
+
+private:
+	const byte *mBuf;
+	size_t mSize;
+};
+
 } // namespace rtc
 
 #endif
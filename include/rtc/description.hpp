@@ -120,7 +120,7 @@ public:
 			Direction direction = Direction::Unknown;
 		};
 
-		std::vector<int> extIds();
+		std::vector<int> extIds() const;
 		ExtMap *extMap(int id);
 		const ExtMap *extMap(int id) const;
 		void addExtMap(ExtMap map);
@@ -148,6 +148,9 @@ public:
 		std::vector<string> mRids;
 		Direction mDirection;
 		bool mIsRemoved;
+
+		friend class Description;
+		bool mIsShared = false; // interned, must be copied before any modification
 	};
 
 	struct RTC_CPP_EXPORT Application : public Entry {
@@ -194,6 +197,14 @@ public:
 		std::vector<uint32_t> getSSRCs() const;
 		optional<std::string> getCNameForSsrc(uint32_t ssrc) const;
 
+		// RTX (RFC 4588) streams, associated with their primary stream by an FID group
+		void addRtxSSRC(uint32_t ssrc, uint32_t rtxSsrc);
+		optional<uint32_t> getRtxSSRC(uint32_t ssrc) const;
+
+		// FlexFEC streams, associated with their primary stream by an FEC-FR group
+		void addFecSSRC(uint32_t ssrc, uint32_t fecSsrc);
+		optional<uint32_t> getFecSSRC(uint32_t ssrc) const;
+
 		int bitrate() const;
 		void setBitrate(int bitrate);
 
@@ -228,12 +239,19 @@ public:
 		void removeFormat(const string &format);
 
 		void addRtxCodec(int payloadType, int origPayloadType, unsigned int clockRate);
+		optional<int> getRtxPayloadType(int origPayloadType) const;
+
+		void addFlexFecCodec(int payloadType, unsigned int clockRate = 90000);
+		optional<int> getFlexFecPayloadType() const;
 
 		virtual void parseSdpLine(string_view line) override;
 
 	private:
 		virtual string generateSdpLines(string_view eol) const override;
 
+		void addSSRCGroup(string_view semantics, uint32_t ssrc, uint32_t other);
+		optional<uint32_t> getGroupedSSRC(string_view semantics, uint32_t ssrc) const;
+
 		int mBas = -1;
 
 		std::vector<int> mOrderedPayloadTypes;
@@ -276,6 +294,10 @@ public:
 	bool hasAudioOrVideo() const;
 	bool hasMid(string_view mid) const;
 
+	// Indexes of media absent from the previous description or differing from its media with the
+	// same mid, so that a renegotiation only needs to process those
+	std::vector<int> changedMedia(const Description &previous) const;
+
 	int addMedia(Media media);
 	int addMedia(Application application);
 	int addApplication(string mid = "data");
@@ -299,6 +321,8 @@ private:
 	optional<Candidate> defaultCandidate() const;
 	shared_ptr<Entry> createEntry(string mline, string mid, Direction dir);
 	void removeApplication();
+	void intern(int index, size_t hash);
+	const shared_ptr<Entry> &detach(int index); // copy on write
 
 	Type mType;
 
@@ -311,7 +335,7 @@ private:
 	optional<CertificateFingerprint> mFingerprint;
 	std::vector<string> mAttributes; // other attributes
 
-	// Entries
+	// Entries, shared between copies and between identical parsed descriptions
 	std::vector<shared_ptr<Entry>> mEntries;
 	shared_ptr<Application> mApplication;
 
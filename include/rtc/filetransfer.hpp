@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_FILE_TRANSFER_H
+#define RTC_FILE_TRANSFER_H
+
+#include "common.hpp"
+#include "datachannel.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace rtc {
+
+struct FileSenderInit {
+	uint64_t offset = 0;  // bytes before offset are not sent
+	size_t chunkSize = 0; // 0 means the max message size of the channels
+	size_t window = 16;   // max number of chunks in flight
+};
+
+/// Bulk transfer of a file over data channels
+/// The file is sent in chunks carrying their byte offset, so chunks may be spread over several
+/// data channels and arrive in any order, and an interrupted transfer may be resumed from the
+/// offset reported by FileReceiver::resumeOffset(). A window of chunks is kept in flight with
+/// DataChannel::sendAsync(), so reading follows the rate of the link.
+class RTC_CPP_EXPORT FileSender final {
+public:
+	/// Channels must be open and reliable, the file is opened immediately
+	FileSender(const string &path, std::vector<shared_ptr<DataChannel>> channels,
+	           FileSenderInit init = {});
+	FileSender(const string &path, shared_ptr<DataChannel> channel, FileSenderInit init = {});
+	~FileSender(); // stops the transfer
+
+	void start();
+	void cancel();
+
+	uint64_t size() const;
+	uint64_t sentAmount() const; // bytes acknowledged by sendAsync() including the offset
+	bool isComplete() const;
+
+	void onProgress(std::function<void(uint64_t sent)> callback);
+	void onComplete(std::function<void()> callback);
+	void onError(std::function<void(string error)> callback);
+
+private:
+	struct State;
+	const shared_ptr<State> mState;
+};
+
+struct FileReceiverInit {
+	uint64_t offset = 0; // bytes before offset are already present in the file
+};
+
+/// Reception of a file sent by FileSender
+/// The file is created if it does not exist and is never truncated, so a transfer may be resumed.
+/// Nothing is written beyond the size announced by the sender, the transfer fails instead.
+class RTC_CPP_EXPORT FileReceiver final {
+public:
+	/// Replaces the message callbacks of the channels
+	FileReceiver(const string &path, std::vector<shared_ptr<DataChannel>> channels,
+	             FileReceiverInit init = {});
+	FileReceiver(const string &path, shared_ptr<DataChannel> channel, FileReceiverInit init = {});
+	~FileReceiver();
+
+	uint64_t receivedAmount() const;
+	uint64_t resumeOffset() const; // every byte before it has been received
+	optional<uint64_t> size() const; // announced by the sender with the first chunk
+	bool isComplete() const;
+
+	void onProgress(std::function<void(uint64_t received)> callback);
+	void onComplete(std::function<void(uint64_t size)> callback);
+	void onError(std::function<void(string error)> callback);
+
+private:
+	struct State;
+	const shared_ptr<State> mState;
+};
+
+} // namespace rtc
+
+#endif /* RTC_FILE_TRANSFER_H */
@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_FLEXFEC_DECODER_H
+#define RTC_FLEXFEC_DECODER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc {
+
+/// Forward error correction with FlexFEC-03 (draft-ietf-payload-flexible-fec-scheme-03)
+/// Incoming FEC packets, identified by the negotiated payload type, are used to recover lost
+/// media packets, which are inserted in the incoming stream. FEC packets are not passed on.
+class RTC_CPP_EXPORT FlexFecDecoder final : public MediaHandler {
+public:
+	FlexFecDecoder();
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+
+	/// Returns the count of packets recovered so far
+	size_t recoveredCount() const;
+
+private:
+	static constexpr size_t HistorySize = 512;    // media packets per stream
+	static constexpr size_t MaxPendingCount = 64; // FEC packets waiting for missing packets
+
+	struct Fec {
+		message_ptr message;
+		SSRC ssrc;
+		std::vector<uint16_t> sequenceNumbers; // protected
+		size_t headerSize;                     // FEC header size
+	};
+
+	struct History {
+		std::vector<message_ptr> packets; // indexed by sequence number
+		uint16_t newest = 0;
+	};
+
+	// The following require mMutex to be locked
+	optional<Fec> parse(message_ptr message) const;
+	const message_ptr *find(SSRC ssrc, uint16_t sequenceNumber) const;
+	void store(message_ptr message);
+	message_ptr recover(const Fec &fec, uint16_t sequenceNumber) const;
+
+	optional<uint8_t> mPayloadType;
+	std::unordered_map<SSRC, History> mHistories;
+	std::deque<Fec> mPending;
+	size_t mRecovered = 0;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_FLEXFEC_DECODER_H */
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_FLEXFEC_ENCODER_H
+#define RTC_FLEXFEC_ENCODER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc {
+
+/// Forward error correction with FlexFEC-03 (draft-ietf-payload-flexible-fec-scheme-03)
+/// Outgoing packets of the streams with a negotiated FEC stream (ssrc-group FEC-FR) are protected
+/// by blocks with XOR parity packets. The size of blocks adapts to the fraction lost in RTCP
+/// reports. It should be placed after RtcpNackResponder in the chain.
+class RTC_CPP_EXPORT FlexFecEncoder final : public MediaHandler {
+public:
+	static constexpr size_t MaxBlockSize = 15;
+
+	/// @param minProtection Ratio of FEC packets without losses, 0 disables FEC until losses
+	/// @param maxProtection Maximum ratio of FEC packets
+	FlexFecEncoder(double minProtection = 0.05, double maxProtection = 0.5);
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+	void outgoing(message_vector &messages, const message_callback &send) override;
+
+	/// Returns the current ratio of FEC packets to media packets
+	double protection() const;
+
+private:
+	struct Stream {
+		SSRC fecSsrc;
+		uint16_t sequenceNumber;
+		std::vector<message_ptr> block;
+	};
+
+	// The following require mMutex to be locked
+	size_t blockSize() const;
+	message_ptr generate(Stream &stream);
+
+	const double mMinProtection;
+	const double mMaxProtection;
+	optional<uint8_t> mPayloadType;
+	std::unordered_map<SSRC, Stream> mStreams; // by protected SSRC
+	double mLoss = 0.;                         // smoothed fraction lost
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_FLEXFEC_ENCODER_H */
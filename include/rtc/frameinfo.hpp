@@ -25,6 +25,13 @@ struct RTC_CPP_EXPORT FrameInfo {
 	uint8_t payloadType = 0;
 
 	optional<std::chrono::duration<double>> timestampSeconds;
+
+	// Metadata of received frames, set by depacketizers when known
+	// For sent frames, keyframe and temporalLayer let PacingHandler drop frames in order
+	uint32_t ssrc = 0;
+	bool keyframe = false;
+	optional<uint8_t> spatialLayer;  // H265 nuh_layer_id
+	optional<uint8_t> temporalLayer; // H265 TemporalId
 };
 
 } // namespace rtc
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_GCC_HANDLER_H
+#define RTC_GCC_HANDLER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "pacinghandler.hpp"
+#include "twcchandler.hpp"
+#include "utils.hpp"
+
+#include <chrono>
+#include <mutex>
+
+namespace rtc {
+
+namespace impl {
+
+class GccEstimator;
+
+} // namespace impl
+
+/// Send-side bandwidth estimation with Google Congestion Control (draft-ietf-rmcat-gcc-02)
+/// It handles transport-wide congestion control like TwccHandler, and combines a delay-based
+/// estimate (trendline filter and AIMD rate control) with a loss-based one. The target bitrate is
+/// passed to the callback for the encoder, and drives the rate of the pacer if any. The pacer must
+/// be placed after this handler in the chain. It also probes the path with the pacer, with padding
+/// up to the target during startup, for at most a few seconds, and clusters above the target while
+/// increasing, so the estimate does not depend on the encoder filling it.
+class RTC_CPP_EXPORT GccHandler final : public MediaHandler {
+public:
+	static const unsigned int DefaultStartBitrate = 300000;
+	static const unsigned int DefaultMinBitrate = 30000;
+	static const unsigned int DefaultMaxBitrate = 5000000;
+
+	/// @param pacer Pacer to drive, may be null
+	/// @param startBitrate Initial target bitrate in bits per second
+	/// @param minBitrate Minimum target bitrate in bits per second
+	/// @param maxBitrate Maximum target bitrate in bits per second
+	GccHandler(shared_ptr<PacingHandler> pacer = nullptr,
+	           unsigned int startBitrate = DefaultStartBitrate,
+	           unsigned int minBitrate = DefaultMinBitrate,
+	           unsigned int maxBitrate = DefaultMaxBitrate);
+	~GccHandler();
+
+	/// Sets the callback called when the target bitrate changes
+	void onTargetBitrate(std::function<void(unsigned int bitrate)> callback);
+
+	/// Returns the current target bitrate in bits per second
+	unsigned int targetBitrate() const;
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+	void outgoing(message_vector &messages, const message_callback &send) override;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	void process(std::vector<TwccHandler::PacketResult> results);
+	void stopPadding();
+
+	const shared_ptr<TwccHandler> mTwcc;
+	const shared_ptr<PacingHandler> mPacer;
+	const double mMaxBitrate;
+	synchronized_callback<unsigned int> mOnTargetBitrate;
+
+	const unique_ptr<impl::GccEstimator> mEstimator; // protected by mMutex
+	bool mPadding = true;                            // pad up to the target during startup
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_GCC_HANDLER_H */
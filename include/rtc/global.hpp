@@ -10,10 +10,14 @@
 #define RTC_GLOBAL_H
 
 #include "common.hpp"
+#include "configuration.hpp" // for CertificateType
 
+#include <algorithm>
 #include <chrono>
 #include <future>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 namespace rtc {
 
@@ -32,9 +36,118 @@ typedef std::function<void(LogLevel level, string message)> LogCallback;
 RTC_CPP_EXPORT void InitLogger(LogLevel level, LogCallback callback = nullptr);
 
 RTC_CPP_EXPORT void SetThreadPoolSize(unsigned int count); // 0: hardware concurrency
+RTC_CPP_EXPORT void SetPollServiceSize(unsigned int count); // 0: hardware concurrency
+// With libnice, agents are spread over count glib main loop threads (default 1)
+RTC_CPP_EXPORT void SetIceThreadCount(unsigned int count); // 0: hardware concurrency
 
-struct SctpSettings {
+struct ThreadPoolSettings {
+	bool workStealing = false; // per-worker task queues, idle workers steal from the others
 	// For the following settings, not set means optimized default
+	optional<size_t> processorBatchSize;                     // in tasks per thread pool hop
+	optional<std::chrono::microseconds> processorTimeBudget; // per thread pool hop
+
+	// Executors for PeerConnections with Configuration::enableExecutorAffinity, which are spread
+	// over them in turn. Not set means the number of cores.
+	optional<unsigned int> executorCount;
+	bool pinExecutors = false; // pin each executor thread to a core (Linux only)
+
+	// CPU placement (Linux only), for instance next to the cores handling the NIC interrupts.
+	// Workers share their CPU set, while executors are pinned to the CPUs of their set in turn. An
+	// explicit CPU list takes precedence over a NUMA node. If a set is given, the default number of
+	// threads becomes its size. Worker placement applies on next init.
+	std::vector<unsigned int> workerCpus;
+	optional<unsigned int> workerNumaNode;
+	std::vector<unsigned int> executorCpus;
+	optional<unsigned int> executorNumaNode;
+
+	// No worker is spawned and the application runs the library tasks with RunOnce() from its own
+	// event loop, see below. Work stealing is ignored. Applies on next init.
+	bool externalLoop = false;
+
+	// Threads of the control-plane pool, which runs certificate generation, DTLS handshakes, and
+	// teardown with a lower priority than the media path. 0 means sharing the main pool. Not set
+	// means a quarter of the cores. Applies on next init.
+	optional<unsigned int> controlThreadCount;
+
+	// DTLS handshakes in progress beyond which new ones fail immediately instead of queuing on the
+	// control-plane pool during connection bursts. Not set means unlimited.
+	optional<size_t> maxPendingHandshakes;
+};
+
+RTC_CPP_EXPORT void SetThreadPoolSettings(ThreadPoolSettings s); // work stealing applies on next init
+
+// Introspection snapshots, for instance to detect saturation. Cumulative values like tasksExecuted
+// and wakeups should be sampled periodically to derive rates.
+struct ThreadPoolStats {
+	size_t workers = 0;
+	size_t busyWorkers = 0; // running a task
+	size_t queuedTasks = 0; // immediate or expired tasks waiting for a worker
+	std::chrono::microseconds oldestTaskAge = std::chrono::microseconds::zero(); // 0 if none
+	size_t pendingTimers = 0;
+	uint64_t tasksExecuted = 0;
+	size_t pendingHandshakes = 0; // DTLS handshakes in progress
+};
+
+struct PollServiceStats {
+	size_t threads = 0;
+	size_t sockets = 0;
+	uint64_t wakeups = 0;
+	std::chrono::nanoseconds busyTime = std::chrono::nanoseconds::zero(); // processing events
+};
+
+// External event loop integration, with ThreadPoolSettings::externalLoop
+// Register the event descriptor, readable when tasks are ready, with the loop (like asio or libuv)
+// and arm a loop timer with the next task timeout, then call RunOnce() when either fires. Only
+// tasks ready on entry are run, so RunOnce() must be called again if the descriptor is readable.
+// Library calls waiting for a task, like the future returned by Cleanup(), must not be waited on
+// from the loop thread.
+// Waits up to timeout for a task and returns the number of tasks run
+RTC_CPP_EXPORT size_t RunOnce(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+RTC_CPP_EXPORT int GetEventDescriptor(); // -1 if unsupported (Windows), poll with timeouts then
+RTC_CPP_EXPORT optional<std::chrono::milliseconds> GetNextTaskTimeout(); // nullopt if no task
+
+// Progress of teardown, for instance while draining a server or before Cleanup() completes
+struct TearDownStats {
+	size_t pendingTasks = 0; // closed objects waiting to be released
+	size_t runningTasks = 0;
+	uint64_t completedTasks = 0;
+};
+
+RTC_CPP_EXPORT ThreadPoolStats GetThreadPoolStats();
+RTC_CPP_EXPORT TearDownStats GetTearDownStats();
+RTC_CPP_EXPORT PollServiceStats GetPollServiceStats(); // empty without WebSocket support
+
+// Living threads of the library, so external profilers like perf can attribute CPU time to each
+// subsystem. Threads created internally by libjuice and usrsctp are not listed.
+struct ThreadInfo {
+	uint64_t id; // native thread id, like the TID on Linux
+	string name; // role, which is also set as thread name, like "RTC worker" or "RTC poll"
+};
+
+RTC_CPP_EXPORT std::vector<ThreadInfo> GetThreads();
+
+struct SctpSettings {
+	enum class Profile {
+		Default,    // balanced defaults
+		Throughput, // large buffers and high-speed congestion control for high-BDP links
+		Latency,    // small buffers and immediate acknowledgements to limit queuing delay
+		LowMemory,  // small buffers and queues for constrained devices
+	};
+
+	Profile profile = Profile::Default; // chooses the defaults of the settings below
+
+	// If enabled, usrsctp does not spawn its timer thread, timers are handled by the thread pool
+	// instead and only while associations exist. Applied on global initialization only.
+	bool threadlessTimers = false;
+	// With threadless timers, timers are ticked in slots aligned on this interval, so timers of
+	// idle associations like heartbeats are coalesced in the same wakeup. Not set means 10ms.
+	optional<std::chrono::milliseconds> timersTick;
+
+	// If enabled, the buffers of each association grow from the observed RTT and throughput
+	bool autoTuneBuffers = false;
+	optional<size_t> maxAutoTuneBufferSize; // in bytes, not set means 16MiB
+
+	// For the following settings, not set means optimized default for the profile
 	optional<size_t> recvBufferSize;                // in bytes
 	optional<size_t> sendBufferSize;                // in bytes
 	optional<size_t> maxChunksOnQueue;              // in chunks
@@ -51,6 +164,137 @@ struct SctpSettings {
 
 RTC_CPP_EXPORT void SetSctpSettings(SctpSettings s);
 
+struct MessagePoolSettings {
+	bool enabled = true; // if disabled, messages are allocated on the heap
+	// Not set means optimized default
+	optional<size_t> maxBuffersPerSizeClass; // in buffers
+	// Keep a pool per NUMA node, selected by the CPU of the calling thread, so that buffers are
+	// reused on the node where they were released (Linux only)
+	bool numaLocal = false;
+};
+
+RTC_CPP_EXPORT void SetMessagePoolSettings(MessagePoolSettings s);
+
+// Memory functions with the semantics of malloc, realloc, and free, for instance to allocate from
+// jemalloc arenas or hugepage-backed pools. They are used for pooled Message objects, and for
+// OpenSSL contexts, including the cipher contexts of libSRTP when it relies on OpenSSL. Message
+// buffers, usrsctp, libjuice, libnice, GnuTLS, and Mbed TLS use the global heap. Functions must be
+// all set or all unset, and they must be thread-safe.
+struct Allocator {
+	void *(*allocate)(size_t size) = nullptr;
+	void *(*reallocate)(void *ptr, size_t size) = nullptr;
+	void (*deallocate)(void *ptr) = nullptr;
+};
+
+// Must be called before any other call to the library, throws once memory is allocated
+RTC_CPP_EXPORT void SetAllocator(Allocator allocator);
+
+struct CertificatePoolSettings {
+	// Certificates are generated in the background after Preload()
+	// For the following settings, not set means optimized default
+	optional<size_t> size;                                // in certificates per type, 0 disables
+	optional<std::chrono::milliseconds> rotationInterval; // max age of a pooled certificate
+};
+
+RTC_CPP_EXPORT void SetCertificatePoolSettings(CertificatePoolSettings s);
+
+// Add an externally generated certificate to the pool, it is used once like generated ones
+RTC_CPP_EXPORT void AddPooledCertificate(CertificateType type, string certificatePem,
+                                         string keyPem);
+
+struct IcePortPoolSettings {
+	// Ports are reserved in the background after Preload(), for the ICE agents of PeerConnections
+	// configured with the same port range and bind address (libjuice only, not with UDP mux)
+	size_t size = 0; // in ports, 0 disables
+	uint16_t portRangeBegin = 1024;
+	uint16_t portRangeEnd = 65535;
+	optional<string> bindAddress;
+};
+
+RTC_CPP_EXPORT void SetIcePortPoolSettings(IcePortPoolSettings s);
+
+struct DnsCacheSettings {
+	// STUN and TURN server resolutions are shared by all PeerConnections until they expire
+	optional<std::chrono::milliseconds> ttl; // not set means 60s, 0 disables
+};
+
+RTC_CPP_EXPORT void SetDnsCacheSettings(DnsCacheSettings s);
+
+struct TearDownSettings {
+	// Transports of closed PeerConnections and WebSockets are released in parallel on the control
+	// thread pool, up to this many at once. Not set means 4.
+	optional<size_t> concurrency;
+	// If enabled, PeerConnection::close() aborts the SCTP association instead of shutting it down
+	// gracefully, dropping unsent messages, for instance to drain a server quickly
+	bool fastClose = false;
+};
+
+RTC_CPP_EXPORT void SetTearDownSettings(TearDownSettings s);
+
+// Counter of internal events, like dropped or invalid packets, since startup
+struct Metric {
+	string name; // stable, for instance rtc_srtp_replay_packets
+	string description;
+	uint64_t value = 0;
+};
+
+RTC_CPP_EXPORT std::vector<Metric> GetMetrics(); // sorted by name
+
+// Distribution of the latency of an internal stage, like SRTP protection or thread pool queuing
+struct Histogram {
+	string name; // stable, for instance rtc_srtp_protect_latency
+	string description;
+	uint64_t count = 0;
+	std::chrono::nanoseconds sum = std::chrono::nanoseconds::zero();
+	std::chrono::nanoseconds max = std::chrono::nanoseconds::zero();
+	// Non-empty buckets by increasing inclusive upper bound, with their counts
+	std::vector<std::pair<std::chrono::nanoseconds, uint64_t>> buckets;
+
+	// Upper bound of the bucket containing the given quantile, for instance 0.99
+	std::chrono::nanoseconds quantile(double q) const {
+		const double target = q * double(count);
+		uint64_t cumulated = 0;
+		for (const auto &[bound, n] : buckets)
+			if (double(cumulated += n) >= target)
+				return std::min(bound, max);
+
+		return max;
+	}
+};
+
+// Histograms are only recorded if the library is built with LATENCY_HISTOGRAMS, otherwise the
+// returned vector is empty
+RTC_CPP_EXPORT std::vector<Histogram> GetLatencyHistograms(); // sorted by name
+
+// Tracepoints, for instance to build timelines with Perfetto or Chrome tracing
+enum class TracePoint {
+	TransportSend = 0,    // object: transport, value: size in bytes, to the lower transport
+	TransportRecv,        // object: transport, value: size in bytes, to the upper layer
+	TransportStateChange, // object: transport, value: new state
+	DtlsHandshakeStart,   // object: DTLS transport
+	DtlsHandshakeStep,    // object: DTLS transport, on each handshake call
+	DtlsHandshakeDone,    // object: DTLS transport, value: 1 if resumed
+	SctpUpcall,           // object: SCTP transport, value: usrsctp events
+	TaskBegin,            // thread pool task
+	TaskEnd,
+	MediaIncomingBegin,   // object: media handler, value: count of messages
+	MediaIncomingEnd,
+	MediaOutgoingBegin,   // object: media handler, value: count of messages
+	MediaOutgoingEnd,
+};
+
+struct TraceEvent {
+	TracePoint point;
+	const void *object; // identifies the transport or handler, if any
+	uint64_t value;
+};
+
+typedef std::function<void(const TraceEvent &event)> TraceCallback;
+
+// The callback is called synchronously from internal threads, so it must be fast and must not call
+// the library, for instance it should only record a timestamp with the event. Null disables it.
+RTC_CPP_EXPORT void SetTraceCallback(TraceCallback callback);
+
 // Optional global preload and cleanup
 RTC_CPP_EXPORT void Preload();
 RTC_CPP_EXPORT std::shared_future<void> Cleanup();
@@ -30,7 +30,9 @@ public:
 
 private:
 	message_ptr reassemble(message_buffer &buffer) override;
-	void addSeparator(binary &frame);
+	// Returns true if the frame contains an IDR slice
+	template <typename Write> bool depacketize(const message_buffer &buffer, Write &&write) const;
+	template <typename Write> void writeSeparator(Write &&write) const;
 
 	const NalUnit::Separator mSeparator;
 };
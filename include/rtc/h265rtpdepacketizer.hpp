@@ -19,7 +19,9 @@
 #include "rtp.hpp"
 #include "rtpdepacketizer.hpp"
 
+#include <array>
 #include <set>
+#include <vector>
 
 namespace rtc {
 
@@ -32,10 +34,20 @@ public:
 	~H265RtpDepacketizer();
 
 private:
+	// Part of the frame, in a packet or in the chunk itself for rebuilt NAL unit headers
+	struct Chunk {
+		const byte *data; // null for the inline header
+		size_t size;
+		std::array<byte, 2> header;
+	};
+
 	message_ptr reassemble(message_buffer &buffer);
-	void addSeparator(binary &frame);
+	void depacketize(const message_buffer &buffer, std::vector<Chunk> &chunks,
+	                 FrameInfo &info) const;
+	void addSeparator(std::vector<Chunk> &chunks) const;
 
 	const NalUnit::Separator mSeparator;
+	std::vector<Chunk> mChunks; // reused between frames
 };
 
 } // namespace rtc
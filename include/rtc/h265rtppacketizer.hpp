@@ -38,8 +38,8 @@ public:
 	                  size_t maxFragmentSize = DefaultMaxFragmentSize);
 
 private:
-	std::vector<binary> fragment(binary data) override;
-	std::vector<H265NalUnit> splitFrame(const binary &frame);
+	bool slice(const binary &frame, std::vector<Slice> &slices) override;
+	template <typename F> void splitFrame(const binary &frame, F &&callback) const;
 
 	const NalUnit::Separator mSeparator;
 	const size_t mMaxFragmentSize;
@@ -25,11 +25,14 @@ struct IceUdpMuxRequest { // TODO change name
 	string remoteUfrag;
 	string remoteAddress;
 	uint16_t remotePort;
+	uint16_t localPort; // port of the shard which received the request
 };
 
 class RTC_CPP_EXPORT IceUdpMuxListener final : private CheshireCat<impl::IceUdpMuxListener> {
 public:
-	IceUdpMuxListener(uint16_t port, optional<string> bindAddress = nullopt);
+	// Listens on shards consecutive ports from port, matching Configuration::iceUdpMuxShards
+	IceUdpMuxListener(uint16_t port, optional<string> bindAddress = nullopt,
+	                  unsigned int shards = 1);
 	~IceUdpMuxListener();
 
 	void stop();
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_KEYFRAME_REQUEST_AGGREGATOR_H
+#define RTC_KEYFRAME_REQUEST_AGGREGATOR_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+
+#include <chrono>
+#include <mutex>
+
+namespace rtc {
+
+/// Keyframe request coalescing for selective forwarding units
+/// Keyframe requests on the incoming track, typically on behalf of subscribers, are forwarded to
+/// the next handler, like RtcpReceivingSession, at most once per window. Requests within the
+/// window are answered by the keyframe already requested. It must be chained before the handler
+/// sending requests. Late subscribers may also be served without any request by the keyframe
+/// cache of RtpForwarder.
+class RTC_CPP_EXPORT KeyframeRequestAggregator final : public MediaHandler {
+public:
+	static constexpr auto DefaultWindow = std::chrono::milliseconds(500);
+
+	KeyframeRequestAggregator(std::chrono::milliseconds window = DefaultWindow);
+
+	bool requestKeyframe(const message_callback &send) override;
+
+	void setWindow(std::chrono::milliseconds window);
+
+	/// Returns the count of requests coalesced so far
+	size_t coalescedCount() const;
+
+private:
+	std::chrono::milliseconds mWindow;
+	optional<std::chrono::steady_clock::time_point> mLastRequest;
+	size_t mCoalesced = 0;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_KEYFRAME_REQUEST_AGGREGATOR_H */
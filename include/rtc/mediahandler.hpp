@@ -37,6 +37,12 @@ public:
 
 	virtual bool requestKeyframe(const message_callback &send);
 	virtual bool requestBitrate(unsigned int bitrate, const message_callback &send);
+	virtual bool requestRetransmission(const std::vector<uint16_t> &sequenceNumbers,
+	                                   const message_callback &send);
+
+	/// Returns the first handler of the chain composed by this handler, if any, so that chains
+	/// can be searched for specific handlers
+	virtual shared_ptr<MediaHandler> inner() { return nullptr; }
 
 	void addToChain(shared_ptr<MediaHandler> handler);
 	void setNext(shared_ptr<MediaHandler> handler);
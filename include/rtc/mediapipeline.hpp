@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_MEDIA_PIPELINE_H
+#define RTC_MEDIA_PIPELINE_H
+
+#include "mediahandler.hpp"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace rtc {
+
+/// Media handler chain composed at compile time
+/// The handlers are called in order for outgoing messages and in reverse order for incoming
+/// messages, like a MediaHandler chain, but without walking the chain for every batch. Calls are
+/// resolved statically for final handler classes. Requests like keyframe requests are forwarded
+/// along the handlers, then to the next handler of the pipeline, which may itself be chained. The
+/// handlers must not be chained to other handlers.
+template <typename... Handlers> class MediaPipeline final : public MediaHandler {
+	static_assert(sizeof...(Handlers) > 0, "MediaPipeline requires at least one handler");
+	static_assert((std::is_base_of_v<MediaHandler, Handlers> && ...),
+	              "MediaPipeline handlers must derive from MediaHandler");
+
+public:
+	explicit MediaPipeline(shared_ptr<Handlers>... handlers) : mHandlers(std::move(handlers)...) {
+		link(std::index_sequence_for<Handlers...>());
+	}
+
+	template <size_t I> const auto &get() const { return std::get<I>(mHandlers); }
+
+	void media(const Description::Media &desc) override {
+		std::apply([&](const auto &...handlers) { (handlers->media(desc), ...); }, mHandlers);
+	}
+
+	void incoming(message_vector &messages, const message_callback &send) override {
+		incomingReversed(messages, send, std::index_sequence_for<Handlers...>());
+	}
+
+	void outgoing(message_vector &messages, const message_callback &send) override {
+		std::apply([&](const auto &...handlers) { (handlers->outgoing(messages, send), ...); },
+		           mHandlers);
+	}
+
+	bool requestKeyframe(const message_callback &send) override {
+		return std::get<0>(mHandlers)->requestKeyframe(send) || MediaHandler::requestKeyframe(send);
+	}
+
+	bool requestBitrate(unsigned int bitrate, const message_callback &send) override {
+		return std::get<0>(mHandlers)->requestBitrate(bitrate, send) ||
+		       MediaHandler::requestBitrate(bitrate, send);
+	}
+
+	bool requestRetransmission(const std::vector<uint16_t> &sequenceNumbers,
+	                           const message_callback &send) override {
+		return std::get<0>(mHandlers)->requestRetransmission(sequenceNumbers, send) ||
+		       MediaHandler::requestRetransmission(sequenceNumbers, send);
+	}
+
+	shared_ptr<MediaHandler> inner() override { return std::get<0>(mHandlers); }
+
+private:
+	template <size_t... I> void link(std::index_sequence<I...>) {
+		// Handlers are linked only for requests, which are forwarded to the next handler
+		constexpr size_t count = sizeof...(Handlers);
+		((I + 1 < count ? std::get<I>(mHandlers)->setNext(handlerAt<I + 1>()) : void()), ...);
+	}
+
+	template <size_t I> shared_ptr<MediaHandler> handlerAt() const {
+		if constexpr (I < sizeof...(Handlers))
+			return std::get<I>(mHandlers);
+		else
+			return nullptr;
+	}
+
+	template <size_t... I>
+	void incomingReversed(message_vector &messages, const message_callback &send,
+	                      std::index_sequence<I...>) {
+		constexpr size_t count = sizeof...(Handlers);
+		(std::get<count - 1 - I>(mHandlers)->incoming(messages, send), ...);
+	}
+
+	const std::tuple<shared_ptr<Handlers>...> mHandlers;
+};
+
+/// Creates a MediaPipeline from handlers, for instance:
+/// make_media_pipeline(packetizer, srReporter, nackResponder)
+template <typename... Handlers>
+shared_ptr<MediaPipeline<Handlers...>> make_media_pipeline(shared_ptr<Handlers>... handlers) {
+	return std::make_shared<MediaPipeline<Handlers...>>(std::move(handlers)...);
+}
+
+} // namespace rtc
+
+#endif // RTC_MEDIA_PIPELINE_H
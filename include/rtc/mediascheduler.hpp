@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_MEDIA_SCHEDULER_H
+#define RTC_MEDIA_SCHEDULER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "common.hpp"
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc {
+
+/// Media clock delivering the frames of many streams on the thread pool timers, instead of a
+/// sleeping thread per stream. Frames are due at absolute times from the stream start, so timer
+/// lateness is corrected on the next frame instead of accumulating. A stream lagging by more than
+/// the maximum lag, for instance after the process was suspended, is resynchronized instead of
+/// delivering a burst of late frames.
+class RTC_CPP_EXPORT MediaScheduler final {
+public:
+	using clock = std::chrono::steady_clock;
+	using StreamId = uint64_t;
+
+	/// Called for each frame with its index and its media time since the stream start, returning
+	/// false removes the stream. Callbacks of a stream are never called concurrently.
+	using FrameCallback = std::function<bool(uint64_t index, std::chrono::microseconds time)>;
+
+	static constexpr auto DefaultMaxLag = std::chrono::milliseconds(500);
+
+	MediaScheduler(std::chrono::milliseconds maxLag = DefaultMaxLag);
+	~MediaScheduler(); // removes all streams
+
+	MediaScheduler(const MediaScheduler &) = delete;
+	MediaScheduler &operator=(const MediaScheduler &) = delete;
+
+	/// Adds a stream with a frame every interval, the first frame is delivered immediately
+	StreamId addStream(std::chrono::microseconds interval, FrameCallback callback);
+
+	/// Removes a stream, its callback may still be running when this returns
+	void removeStream(StreamId id);
+
+	size_t streamsCount() const;
+
+	/// Returns the count of streams resynchronized because they lagged too much
+	size_t resyncCount() const;
+
+private:
+	// Shared with the timer tasks so that they don't outlive it
+	class Scheduler final : public std::enable_shared_from_this<Scheduler> {
+	public:
+		Scheduler(clock::duration maxLag);
+
+		StreamId add(clock::duration interval, FrameCallback callback);
+		void remove(StreamId id);
+		void clear();
+		size_t count() const;
+		size_t resyncCount() const;
+
+	private:
+		struct Stream {
+			clock::duration interval;
+			clock::time_point start;
+			uint64_t index = 0;
+			shared_ptr<FrameCallback> callback;
+		};
+
+		struct Entry {
+			clock::time_point time;
+			StreamId id;
+			bool operator>(const Entry &other) const { return time > other.time; }
+		};
+
+		void run();
+		void schedule(clock::time_point time); // requires mMutex to be locked
+
+		const clock::duration mMaxLag;
+		StreamId mNextId = 1;
+		std::unordered_map<StreamId, Stream> mStreams;
+		// Due times, entries of removed or running streams are skipped
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> mQueue;
+		optional<clock::time_point> mScheduled; // earliest pending timer
+		size_t mResyncCount = 0;
+		mutable std::mutex mMutex;
+	};
+
+	const shared_ptr<Scheduler> mScheduler;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_MEDIA_SCHEDULER_H */
@@ -13,7 +13,10 @@
 #include "frameinfo.hpp"
 #include "reliability.hpp"
 
+#include <algorithm>
 #include <functional>
+#include <iterator>
+#include <type_traits>
 
 namespace rtc {
 
@@ -29,9 +32,12 @@ struct RTC_CPP_EXPORT Message : binary {
 
 	Message(binary &&data, Type type_ = Binary) : binary(std::move(data)), type(type_) {}
 
+	size_t tailroom() const { return capacity() - size(); } // room reserved after the data
+
 	Type type;
 	unsigned int stream = 0; // Stream id (SCTP stream or SSRC)
 	unsigned int dscp = 0;   // Differentiated Services Code Point
+	unsigned int ecn = 0;    // Explicit Congestion Notification codepoint, 1 is ECT(1)
 	shared_ptr<Reliability> reliability;
 	shared_ptr<FrameInfo> frameInfo;
 };
@@ -40,6 +46,21 @@ using message_ptr = shared_ptr<Message>;
 using message_callback = std::function<void(message_ptr message)>;
 using message_vector = std::vector<message_ptr>;
 
+// Tailroom reserved for outgoing media packets so the SRTP authentication tag can be appended in
+// place (matches libSRTP SRTP_MAX_TRAILER_LEN)
+const size_t DEFAULT_MEDIA_TAILROOM = 144;
+
+// Iterators over contiguous bytes can be copied into a pooled buffer
+template <typename Iterator>
+constexpr bool is_pooled_message_iterator_v =
+    std::is_same_v<std::decay_t<typename std::iterator_traits<Iterator>::value_type>, byte> &&
+    std::is_base_of_v<std::random_access_iterator_tag,
+                      typename std::iterator_traits<Iterator>::iterator_category>;
+
+RTC_CPP_EXPORT message_ptr make_message(size_t size, Message::Type type = Message::Binary,
+                                        unsigned int stream = 0,
+                                        shared_ptr<Reliability> reliability = nullptr);
+
 inline size_t message_size_func(const message_ptr &m) {
 	return m->type == Message::Binary || m->type == Message::String ? m->size() : 0;
 }
@@ -47,17 +68,31 @@ inline size_t message_size_func(const message_ptr &m) {
 template <typename Iterator>
 message_ptr make_message(Iterator begin, Iterator end, Message::Type type = Message::Binary,
                          unsigned int stream = 0, shared_ptr<Reliability> reliability = nullptr) {
-	auto message = std::make_shared<Message>(begin, end, type);
-	message->stream = stream;
-	message->reliability = reliability;
-	return message;
+	if constexpr (is_pooled_message_iterator_v<Iterator>) {
+		auto message =
+		    make_message(size_t(std::distance(begin, end)), type, stream, std::move(reliability));
+		std::copy(begin, end, message->begin());
+		return message;
+	} else {
+		auto message = std::make_shared<Message>(begin, end, type);
+		message->stream = stream;
+		message->reliability = std::move(reliability);
+		return message;
+	}
 }
 
 template <typename Iterator>
 message_ptr make_message(Iterator begin, Iterator end, shared_ptr<FrameInfo> frameInfo) {
-	auto message = std::make_shared<Message>(begin, end);
-	message->frameInfo = frameInfo;
-	return message;
+	if constexpr (is_pooled_message_iterator_v<Iterator>) {
+		auto message = make_message(size_t(std::distance(begin, end)));
+		std::copy(begin, end, message->begin());
+		message->frameInfo = std::move(frameInfo);
+		return message;
+	} else {
+		auto message = std::make_shared<Message>(begin, end);
+		message->frameInfo = std::move(frameInfo);
+		return message;
+	}
 }
 
 // For backward compatibiity, do not use
@@ -70,9 +105,9 @@ template <typename Iterator>
 	return message;
 }
 
-RTC_CPP_EXPORT message_ptr make_message(size_t size, Message::Type type = Message::Binary,
-                                        unsigned int stream = 0,
-                                        shared_ptr<Reliability> reliability = nullptr);
+// Reserve room after the message data so it can grow without reallocation
+RTC_CPP_EXPORT message_ptr make_message_with_tailroom(size_t size, size_t tailroom,
+                                                      Message::Type type = Message::Binary);
 
 RTC_CPP_EXPORT message_ptr make_message(binary &&data, Message::Type type = Message::Binary,
                                         unsigned int stream = 0,
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_MTU_PROBER_H
+#define RTC_MTU_PROBER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtppacketizationconfig.hpp"
+#include "twcchandler.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace rtc {
+
+/// Datagram packetization layer path MTU discovery (RFC 8899) with media packets
+/// Probes are retransmissions of recent media packets on the RTX stream (RFC 4588), padded to the
+/// probed size, and transport-wide congestion control feedback acknowledges them. Once a larger
+/// MTU is confirmed, the max fragment size of the packetizer is raised accordingly and the callback
+/// is called, typically to call PeerConnection::setPathMtu() so SCTP uses it too.
+/// RTX must be negotiated, otherwise there is no probing. If retransmissions share the RTX stream,
+/// a PacingHandler must be chained after so that it numbers all RTX packets.
+/// It must be chained after the packetizer and before TwccHandler, and feedback() must be called
+/// from the TwccHandler feedback callback.
+class RTC_CPP_EXPORT MtuProber final : public MediaHandler {
+public:
+	static constexpr size_t DefaultMaxMtu = 1500; // Standard Ethernet
+	static constexpr int MaxProbes = 3;           // RFC 8899 MAX_PROBES
+	static constexpr auto ProbeInterval = std::chrono::milliseconds(500);
+	static constexpr auto RaiseInterval = std::chrono::minutes(10); // RFC 8899 PMTU_RAISE_TIMER
+
+	using clock = std::chrono::steady_clock;
+	using mtu_callback = std::function<void(size_t mtu)>;
+
+	/// @param rtpConfig RTP configuration of the packetizer
+	/// @param onMtu Callback called from the feedback thread when the confirmed MTU changes
+	/// @param baseMtu MTU assumed to work, like Configuration::mtu
+	/// @param maxMtu Maximum MTU to probe
+	MtuProber(shared_ptr<RtpPacketizationConfig> rtpConfig, mtu_callback onMtu = nullptr,
+	          size_t baseMtu = RTC_DEFAULT_MTU, size_t maxMtu = DefaultMaxMtu);
+
+	void media(const Description::Media &desc) override;
+	void outgoing(message_vector &messages, const message_callback &send) override;
+
+	// Feeds the results of transport-wide congestion control feedback
+	void feedback(const std::vector<TwccHandler::PacketResult> &results);
+
+	size_t mtu() const; // confirmed path MTU
+	bool isSearching() const;
+
+private:
+	// The packet sizes reported by TwccHandler exclude SRTP/UDP/IPv6
+	static constexpr size_t DatagramOverhead = 10 + 8 + 40;
+	// Room for header extensions added after the prober, like the transport-wide sequence number
+	static constexpr size_t ExtensionsMargin = 8;
+	static constexpr size_t MaxPaddingSize = 255;
+
+	void probe(message_vector &messages, clock::time_point now); // requires mMutex to be locked
+	void complete(clock::time_point now);                       // requires mMutex to be locked
+
+	const shared_ptr<RtpPacketizationConfig> mRtpConfig;
+	const mtu_callback mOnMtu;
+	std::vector<size_t> mCandidates; // MTUs to probe in increasing order
+
+	mutable std::mutex mMutex;
+	size_t mMtu;
+	size_t mConfirmedSize = 0;  // largest packet acknowledged
+	size_t mMaxHeaderSize = 0; // largest RTP header with extensions seen
+	size_t mCandidate = 0;     // index of the next candidate
+	size_t mProbeSize = 0;     // size of the pending probe, 0 if none
+	int mFailures = 0;
+	clock::time_point mLastProbe;
+	optional<clock::time_point> mCompleted; // search complete until RaiseInterval is elapsed
+	binary mTemplate;                       // copy of a recent media packet for probes
+	size_t mFragmentSize = 0;               // to set in the configuration, 0 if unchanged
+	optional<SSRC> mRtxSsrc;                // RTX stream of the media stream, if negotiated
+	uint8_t mRtxPayloadType = 0;
+	uint16_t mRtxSequenceNumber = 0;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_MTU_PROBER_H */
@@ -12,35 +12,170 @@
 #if RTC_ENABLE_MEDIA
 
 #include "mediahandler.hpp"
+#include "rtp.hpp"
 #include "utils.hpp"
 
+#include <array>
 #include <atomic>
-#include <queue>
+#include <deque>
+#include <functional>
+#include <unordered_map>
 
 namespace rtc {
 
 // Paced sending of RTP packets. It takes a stream of RTP packets that can have an uneven bitrate
-// and delivers them in a smoother manner by sending a fixed size of them on an interval
+// and delivers them in a smoother manner by sending a fixed size of them on an interval.
+// Packets are queued by priority: control and audio, then retransmissions, then padding, then
+// video, so that audio is not delayed behind a keyframe. Packets waiting longer than the maximum
+// queue delay are dropped, with the rest of their frame. DataChannel traffic may be paced too, see
+// PeerConnection::setDataChannelPacer().
+// For bandwidth estimation, the budget left when queues are empty may be filled with padding, up to
+// the padding rate or at the rate of a probe cluster. Padding-only packets are sent on the RTX
+// stream (RFC 4588) of video tracks, so RTX must be negotiated, and RTX sequence numbers are
+// then assigned by the handler.
+// Queue limits may also be set per track, beyond which whole frames not started yet are dropped:
+// frames of the highest temporal layer first, then the oldest frames up to the next queued
+// keyframe, as marked in the FrameInfo of sent frames.
 class RTC_CPP_EXPORT PacingHandler : public MediaHandler {
 public:
-	PacingHandler(double bitsPerSecond, std::chrono::milliseconds sendInterval);
+	enum class Priority { Audio = 0, Retransmission = 1, Padding = 2, Video = 3, Data = 4 };
 
+	static constexpr auto DefaultProbeDuration = std::chrono::milliseconds(100);
+
+	/// @param bitsPerSecond Sending rate
+	/// @param sendInterval Interval between sends, which bounds the size of bursts
+	/// @param maxQueueDelay Maximum time a packet can be queued, not set means unlimited
+	PacingHandler(double bitsPerSecond, std::chrono::milliseconds sendInterval,
+	              optional<std::chrono::milliseconds> maxQueueDelay = nullopt);
+	~PacingHandler();
+
+	/// Returns a handler for another track of the same PeerConnection, sharing the rate and the
+	/// queues so that priorities apply across tracks
+	/// @param priority Fixed priority for all packets, required to pace SCTP packets
+	shared_ptr<PacingHandler> fork(optional<Priority> priority = nullopt) const;
+
+	void media(const Description::Media &desc) override;
 	void outgoing(message_vector &messages, const message_callback &send) override;
 
+	// Changes the sending rate, for instance to follow a bandwidth estimation
+	void setBitrate(double bitsPerSecond);
+
+	// Starts a probe cluster, sending at least at the probe rate for the duration, with padding if
+	// there is not enough media
+	void probe(double bitsPerSecond, std::chrono::milliseconds duration = DefaultProbeDuration);
+
+	// Sets the rate up to which padding is sent when there is not enough media, 0 disables it
+	void setPaddingBitrate(double bitsPerSecond);
+
+	// Sets a handler through which padding packets of this track go before being sent, typically a
+	// TwccHandler so that the bandwidth estimator accounts for them
+	void setPaddingHandler(shared_ptr<MediaHandler> handler);
+
+	// Returns the count of padding bytes sent
+	size_t paddingBytes() const;
+
+	// Limits the size and the delay of the packets of this track in queues, not set means unlimited
+	void setQueueLimits(optional<size_t> maxBytes,
+	                    optional<std::chrono::milliseconds> maxDelay = nullopt);
+
+	// Sets the callback called when a reference frame is dropped and no keyframe is queued after
+	// it, the encoder should then send a keyframe
+	void onKeyframeNeeded(std::function<void()> callback);
+
+	// Returns the count of packets dropped because they were queued for too long
+	size_t droppedCount() const;
+
 private:
-	std::atomic<bool> mHaveScheduled = false;
+	using clock = std::chrono::steady_clock;
+
+	struct Entry {
+		message_ptr message;
+		message_callback send;
+		clock::time_point time;
+		const PacingHandler *owner = nullptr; // only compared
+	};
+
+	struct Limits {
+		optional<size_t> maxBytes;
+		optional<clock::duration> maxDelay;
+	};
+
+	// Shared between the handlers of the same transport
+	class Pacer final : public std::enable_shared_from_this<Pacer> {
+	public:
+		Pacer(double bitsPerSecond, clock::duration sendInterval,
+		      optional<clock::duration> maxQueueDelay);
+
+		void enqueue(Priority priority, Entry entry);
+		void setBitrate(double bitsPerSecond);
+		void probe(double bitsPerSecond, clock::duration duration);
+		void setPaddingBitrate(double bitsPerSecond);
+		void addPaddingSource(weak_ptr<MediaHandler> source);
+		void removeOwner(const PacingHandler *owner);
+		size_t droppedCount() const;
+
+		// Drops frames of the owner beyond the limits, returns true if a reference frame was
+		// dropped without a keyframe queued after it
+		bool limit(const PacingHandler *owner, const Limits &limits);
+		size_t paddingBytes() const;
+
+	private:
+		struct Probe {
+			double bytesPerSecond;
+			clock::time_point end;
+		};
+
+		void run();
+		// The following require mMutex to be locked
+		void schedule(clock::time_point now);
+		void refill(clock::time_point now);
+		void dropStale(clock::time_point now);
+		void drop(const std::vector<std::pair<SSRC, uint32_t>> &frames, const PacingHandler *owner);
+		bool isPadding() const;
+		shared_ptr<PacingHandler> nextPaddingSource();
+
+		const clock::duration mSendInterval;
+		const optional<clock::duration> mMaxQueueDelay;
+		double mBytesPerSecond;
+		double mBudget = 0.;
+		double mPaddingBytesPerSecond = 0.;
+		double mPaddingBudget = 0.;
+		optional<Probe> mProbe;
+		clock::time_point mLastRefill;
+		bool mScheduled = false;
+		size_t mDropped = 0;
+		size_t mPaddingBytes = 0;
+		std::array<std::deque<Entry>, 5> mQueues; // by priority
+		std::vector<weak_ptr<MediaHandler>> mPaddingSources;
+		size_t mNextPaddingSource = 0;
+		// SSRC and timestamp of the frame of the last packet sent, by owner
+		std::unordered_map<const PacingHandler *, std::pair<SSRC, uint32_t>> mLastFrames;
+		mutable std::mutex mMutex;
+	};
 
-	double mBytesPerSecond;
-	double mBudget;
+	PacingHandler(shared_ptr<Pacer> pacer, optional<Priority> priority);
 
-	std::chrono::milliseconds mSendInterval;
-	std::chrono::time_point<std::chrono::high_resolution_clock> mLastRun;
+	// Requires mMutex to be locked
+	Priority classify(const message_ptr &message) const;
 
-	std::mutex mMutex;
-	std::queue<message_ptr> mRtpBuffer;
+	// Returns padding packets for about the given size, empty if the track can't send padding
+	std::vector<Entry> generatePadding(size_t size);
 
-	void schedule(const message_callback &send);
-	void run(const message_callback &send);
+	const shared_ptr<Pacer> mPacer;
+	const optional<Priority> mPriority;
+	std::atomic<bool> mIsAudio = false;
+	std::vector<uint8_t> mRtxPayloadTypes;
+	optional<SSRC> mRtxSsrc; // of the video stream, if RTX is negotiated
+	uint8_t mRtxPayloadType = 0;
+	uint16_t mRtxSequenceNumber = 0;
+	uint32_t mLastTimestamp = 0;
+	message_callback mSend; // of the last outgoing packets
+	shared_ptr<MediaHandler> mPaddingHandler;
+	Limits mLimits;
+	bool mKeyframesMarked = false; // a keyframe was marked in a FrameInfo
+	bool mWaitingKeyframe = false; // drop frames until the next keyframe
+	synchronized_callback<> mOnKeyframeNeeded;
+	mutable std::mutex mMutex;
 };
 
 } // namespace rtc
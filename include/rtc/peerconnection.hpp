@@ -15,6 +15,7 @@
 #include "datachannel.hpp"
 #include "description.hpp"
 #include "reliability.hpp"
+#include "stats.hpp"
 #include "track.hpp"
 
 #include <chrono>
@@ -25,6 +26,7 @@ namespace rtc {
 namespace impl {
 
 struct PeerConnection;
+struct PeerConnectionPool;
 
 }
 
@@ -33,6 +35,15 @@ struct RTC_CPP_EXPORT DataChannelInit {
 	bool negotiated = false;
 	optional<uint16_t> id = nullopt;
 	string protocol = "";
+	uint16_t priority = 256; // RFC 8832: 128 below normal, 256 normal, 512 high, 1024 extra high
+
+	// Coalesce small messages sent within the window into single SCTP messages, to reduce the
+	// per-packet overhead. The remote peer must be libdatachannel, which unpacks them.
+	optional<std::chrono::milliseconds> coalescingWindow = nullopt;
+
+	// Reading from SCTP stops while more received data is waiting for the application, so the
+	// peer is throttled by the receive window, see DataChannel::setMaxAvailableAmount()
+	optional<size_t> maxAvailableAmount = nullopt;
 };
 
 struct RTC_CPP_EXPORT LocalDescriptionInit {
@@ -91,6 +102,7 @@ public:
 	optional<Description> localDescription() const;
 	optional<Description> remoteDescription() const;
 	size_t remoteMaxMessageSize() const;
+	size_t pathMtu() const; // Configuration::mtu or the default until set
 	optional<string> localAddress() const;
 	optional<string> remoteAddress() const;
 	uint16_t maxDataChannelId() const;
@@ -100,6 +112,7 @@ public:
 	void gatherLocalCandidates(std::vector<IceServer> additionalIceServers = {});
 	void setRemoteDescription(Description description);
 	void addRemoteCandidate(Candidate candidate);
+	void addRemoteCandidates(std::vector<Candidate> candidates); // locks once for the batch
 
 	// For specific use cases only
 	Description createOffer();
@@ -108,8 +121,21 @@ public:
 	void setMediaHandler(shared_ptr<MediaHandler> handler);
 	shared_ptr<MediaHandler> getMediaHandler();
 
+	// Updates the path MTU used by SCTP and for track message sizes, for instance with the one
+	// discovered by MtuProber
+	void setPathMtu(size_t mtu);
+
+	// Paces DataChannel traffic with media: SCTP packets go through the handler, typically a
+	// PacingHandler fork with Priority::Data, so that a large transfer does not queue in front of
+	// media at the bottleneck. Null disables it.
+	void setDataChannelPacer(shared_ptr<MediaHandler> pacer);
+
 	[[nodiscard]] shared_ptr<DataChannel> createDataChannel(string label,
 	                                                        DataChannelInit init = {});
+	// Creates negotiated DataChannels at once on consecutive stream ids starting at init.id,
+	// one per label. It throws if any of the stream ids is already used.
+	[[nodiscard]] std::vector<shared_ptr<DataChannel>>
+	createNegotiatedDataChannels(std::vector<string> labels, DataChannelInit init);
 	void onDataChannel(std::function<void(std::shared_ptr<DataChannel> dataChannel)> callback);
 
 	[[nodiscard]] shared_ptr<Track> addTrack(Description::Media description);
@@ -117,6 +143,9 @@ public:
 
 	void onLocalDescription(std::function<void(Description description)> callback);
 	void onLocalCandidate(std::function<void(Candidate candidate)> callback);
+	// Candidates gathered within a short window are passed together, so signaling can send them
+	// in a single message. If set, it takes precedence over onLocalCandidate().
+	void onLocalCandidates(std::function<void(std::vector<Candidate> candidates)> callback);
 	void onStateChange(std::function<void(State state)> callback);
 	void onIceStateChange(std::function<void(IceState state)> callback);
 	void onGatheringStateChange(std::function<void(GatheringState state)> callback);
@@ -130,6 +159,12 @@ public:
 	size_t bytesSent();
 	size_t bytesReceived();
 	optional<std::chrono::milliseconds> rtt();
+	optional<std::chrono::milliseconds> dtlsHandshakeDuration();
+	size_t memoryUsage(); // approximate bytes held in buffers by the connection
+	PeerConnectionStats getStats(); // unset for transports not created yet
+
+private:
+	friend struct impl::PeerConnectionPool; // prewarms pooled connections
 };
 
 RTC_CPP_EXPORT std::ostream &operator<<(std::ostream &out, PeerConnection::State state);
@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_PEER_CONNECTION_POOL_H
+#define RTC_PEER_CONNECTION_POOL_H
+
+#include "common.hpp"
+#include "configuration.hpp"
+#include "peerconnection.hpp"
+
+namespace rtc {
+
+namespace impl {
+
+struct PeerConnectionPool;
+
+} // namespace impl
+
+/// Pool of PeerConnections created in advance for a configuration, with their ICE agent bound and
+/// their certificate ready, so that taking one is cheap when a user joins. The pool is refilled
+/// in the background on the control thread pool.
+class RTC_CPP_EXPORT PeerConnectionPool final : private CheshireCat<impl::PeerConnectionPool> {
+public:
+	static constexpr size_t DefaultSize = 4;
+
+	PeerConnectionPool(Configuration config, size_t size = DefaultSize);
+	~PeerConnectionPool(); // closes the pooled connections
+
+	// Never blocks on the pool, creates a connection on the spot if the pool is empty
+	shared_ptr<PeerConnection> take();
+
+	size_t available() const; // connections ready to be taken
+
+private:
+	using CheshireCat<impl::PeerConnectionPool>::impl;
+};
+
+} // namespace rtc
+
+#endif
@@ -14,7 +14,10 @@
 #include "global.hpp"
 //
 #include "datachannel.hpp"
+#include "filetransfer.hpp"
 #include "peerconnection.hpp"
+#include "peerconnectionpool.hpp"
+#include "stats.hpp"
 #include "track.hpp"
 #include "iceudpmuxlistener.hpp"
 
@@ -39,7 +42,25 @@
 #include "plihandler.hpp"
 #include "rembhandler.hpp"
 #include "pacinghandler.hpp"
+#include "mediascheduler.hpp"
+#include "rtcpccfbreporter.hpp"
+#include "twcchandler.hpp"
+#include "mtuprober.hpp"
+#include "audiolevelhandler.hpp"
+#include "rtprecorder.hpp"
+#include "rtpreplayer.hpp"
+#include "gcchandler.hpp"
+#include "flexfecencoder.hpp"
+#include "flexfecdecoder.hpp"
+#include "rtpforwarder.hpp"
+#include "rtprewriter.hpp"
+#include "simulcastselector.hpp"
+#include "svclayerfilter.hpp"
+#include "broadcastgroup.hpp"
+#include "mediapipeline.hpp"
+#include "keyframerequestaggregator.hpp"
 #include "rtcpnackresponder.hpp"
+#include "rtcpnackrequester.hpp"
 #include "rtcpreceivingsession.hpp"
 #include "rtcpsrreporter.hpp"
 #include "rtppacketizer.hpp"
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_RTCP_CCFB_REPORTER_H
+#define RTC_RTCP_CCFB_REPORTER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc {
+
+/// Responds to incoming RTP streams with RFC 8888 congestion control feedback, reporting the
+/// arrival time and ECN codepoint of each packet, so the sender can react before losses.
+class RTC_CPP_EXPORT RtcpCcfbReporter final : public MediaHandler {
+public:
+	static constexpr auto DefaultInterval = std::chrono::milliseconds(100);
+
+	struct EcnCounts {
+		uint32_t notEct = 0;
+		uint32_t ect1 = 0;
+		uint32_t ect0 = 0;
+		uint32_t ce = 0;
+	};
+
+	/// @param senderSsrc SSRC of the feedback packets
+	/// @param interval Minimum interval between feedback packets
+	RtcpCcfbReporter(SSRC senderSsrc = 1, std::chrono::milliseconds interval = DefaultInterval);
+
+	void incoming(message_vector &messages, const message_callback &send) override;
+
+	/// Returns the counts of received packets per ECN codepoint for a stream
+	EcnCounts ecnCounts(SSRC ssrc) const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr uint16_t MaxReportsCount = 1024; // per stream and feedback packet
+
+	struct Arrival {
+		bool received = false;
+		uint8_t ecn = 0;
+		clock::time_point time;
+	};
+
+	struct Stream {
+		uint16_t beginSeq = 0;
+		std::vector<Arrival> arrivals; // indexed by sequence number from beginSeq
+		EcnCounts counts;
+	};
+
+	void record(SSRC ssrc, uint16_t seq, unsigned int ecn, clock::time_point now);
+	message_ptr generate(clock::time_point now); // requires mMutex to be locked
+
+	const SSRC mSenderSsrc;
+	const clock::duration mInterval;
+	clock::time_point mLastReport;
+	std::unordered_map<SSRC, Stream> mStreams;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_RTCP_CCFB_REPORTER_H */
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_RTCP_NACK_REQUESTER_H
+#define RTC_RTCP_NACK_REQUESTER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace rtc {
+
+/// Receive-side NACK generation (RFC 4585)
+/// Gaps in the sequence numbers of the incoming stream are requested for retransmission with
+/// requestRetransmission() on the next handler, typically RtcpReceivingSession which batches them
+/// in a single NACK packet. Requests are repeated every round-trip time, as reported by the
+/// RtcpReceivingSession of the chain if any, until the packet is received directly or in RTX. A
+/// keyframe is requested when a packet is not recovered after maxRetries requests or maxAge.
+/// It must be chained before the RtcpReceivingSession.
+class RTC_CPP_EXPORT RtcpNackRequester final : public MediaHandler {
+public:
+	static constexpr unsigned int DefaultMaxRetries = 10;
+	static constexpr auto DefaultMaxAge = std::chrono::milliseconds(1000);
+	static constexpr size_t DefaultMaxMissing = 1000;
+	static constexpr auto DefaultRoundTripTime = std::chrono::milliseconds(100);
+
+	/// @param maxRetries Maximum count of requests for a missing packet
+	/// @param maxAge Maximum time to wait for a missing packet
+	/// @param maxMissing Maximum count of missing packets, a keyframe is requested beyond
+	RtcpNackRequester(unsigned int maxRetries = DefaultMaxRetries,
+	                  std::chrono::milliseconds maxAge = DefaultMaxAge,
+	                  size_t maxMissing = DefaultMaxMissing);
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+
+	/// Returns the count of retransmissions requested so far
+	size_t requestedCount() const;
+
+	/// Returns the count of missing packets given up so far
+	size_t unrecoveredCount() const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct Missing {
+		clock::time_point detected;
+		clock::time_point nextRequest;
+		unsigned int retries = 0;
+	};
+
+	void run();
+	void request(clock::time_point now, const message_callback &send, bool keyframe);
+	std::chrono::microseconds roundTripTime();
+
+	// The following require mMutex to be locked
+	void received(uint16_t seqNo, clock::time_point now, bool &keyframe);
+	void recovered(uint16_t seqNo);
+	uint64_t extend(uint16_t seqNo) const;
+	void schedule();
+
+	const unsigned int mMaxRetries;
+	const std::chrono::milliseconds mMaxAge;
+	const size_t mMaxMissing;
+
+	std::vector<uint8_t> mRtxPayloadTypes;
+	optional<SSRC> mSsrc;
+	uint64_t mHighest = 0;                // extended sequence number of the highest packet
+	std::map<uint64_t, Missing> mMissing; // by extended sequence number
+	optional<clock::time_point> mLastKeyframeRequest;
+	message_callback mSend;
+	bool mScheduled = false;
+	size_t mRequested = 0;
+	size_t mUnrecovered = 0;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_RTCP_NACK_REQUESTER_H */
@@ -12,9 +12,12 @@
 #if RTC_ENABLE_MEDIA
 
 #include "mediahandler.hpp"
+#include "rtp.hpp"
 
-#include <queue>
+#include <chrono>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace rtc {
 
@@ -22,41 +25,33 @@ class RTC_CPP_EXPORT RtcpNackResponder final : public MediaHandler {
 public:
 	static const size_t DefaultMaxSize = 512;
 
-	RtcpNackResponder(size_t maxSize = DefaultMaxSize);
+	/// @param maxSize Maximum count of stored packets
+	/// @param maxAge Maximum age of stored packets, not set means unlimited
+	/// @param maxBytes Maximum total size of stored packets, not set means unlimited
+	RtcpNackResponder(size_t maxSize = DefaultMaxSize,
+	                  optional<std::chrono::milliseconds> maxAge = nullopt,
+	                  optional<size_t> maxBytes = nullopt);
 
 	void incoming(message_vector &messages, const message_callback &send) override;
 	void outgoing(message_vector &messages, const message_callback &send) override;
+	void media(const Description::Media &desc) override;
 
 private:
-	// Packet storage
-	class RTC_CPP_EXPORT Storage {
-
-		/// Packet storage element
-		struct RTC_CPP_EXPORT Element {
-			Element(message_ptr packet, uint16_t sequenceNumber, shared_ptr<Element> next = nullptr);
-			const message_ptr packet;
-			const uint16_t sequenceNumber;
-			/// Pointer to newer element
-			shared_ptr<Element> next = nullptr;
-		};
-
-	private:
-		/// Oldest packet in storage
-		shared_ptr<Element> oldest = nullptr;
-		/// Newest packet in storage
-		shared_ptr<Element> newest = nullptr;
-		/// Inner storage
-		std::unordered_map<uint16_t, shared_ptr<Element>> storage{};
-		std::mutex mutex;
-
-		/// Maximum storage size
-		const size_t maxSize;
+	// RTX (RFC 4588) stream associated with a primary stream
+	struct RtxStream {
+		SSRC ssrc;
+		uint16_t sequenceNumber;
+	};
 
-		/// Returns current size
-		size_t size();
+	// Returns the retransmission of a stored packet, wrapped in RTX if negotiated
+	message_ptr retransmission(message_ptr packet);
 
+	// Packet storage, a fixed-size ring indexed by sequence number so that storing and retrieving
+	// packets does not allocate
+	class RTC_CPP_EXPORT Storage {
 	public:
-		Storage(size_t _maxSize);
+		Storage(size_t maxSize, optional<std::chrono::milliseconds> maxAge,
+		        optional<size_t> maxBytes);
 
 		/// Returns packet with given sequence number
 		message_ptr get(uint16_t sequenceNumber);
@@ -64,9 +59,41 @@ private:
 		/// Stores packet
 		/// @param packet Packet
 		void store(message_ptr packet);
+
+	private:
+		using clock = std::chrono::steady_clock;
+
+		struct Slot {
+			message_ptr packet;
+			uint16_t sequenceNumber = 0;
+			clock::time_point time;
+		};
+
+		Slot &slot(uint16_t sequenceNumber);
+		// The following require mutex to be locked
+		void evict(uint16_t sequenceNumber);
+		void evictOldest();
+		void expire(clock::time_point now);
+
+		// The ring size is rounded up to a power of two so that it divides the sequence number
+		// space, consecutive sequence numbers then get distinct slots across the wraparound
+		const size_t capacity; // maximum count of stored packets
+		const size_t mask;
+		std::vector<Slot> ring;
+		uint16_t oldest = 0; // sequence number of the oldest packet in the window
+		uint16_t newest = 0; // sequence number of the newest packet in the window
+		bool empty = true;
+		size_t bytes = 0;
+		const optional<clock::duration> maxAge;
+		const optional<size_t> maxBytes;
+		std::mutex mutex;
 	};
 
 	const shared_ptr<Storage> mStorage;
+
+	std::unordered_map<SSRC, RtxStream> mRtxStreams;       // by primary SSRC
+	std::unordered_map<uint8_t, uint8_t> mRtxPayloadTypes; // by original payload type
+	std::mutex mRtxMutex;
 };
 
 } // namespace rtc
@@ -18,21 +18,40 @@
 #include "rtp.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #define RTP_SEQ_MOD (1<<16)
 
 namespace rtc {
 
 // An RtcpSession can be plugged into a Track to handle the whole RTCP session
+// Reception statistics are kept for each incoming stream as in RFC 3550, and reported in receiver
+// reports sent periodically by the peer connection for all tracks at once. The requested bitrate
+// is repeated in a REMB within the same compound packets.
 class RTC_CPP_EXPORT RtcpReceivingSession : public MediaHandler {
 public:
+	struct Stats {
+		SSRC ssrc;
+		uint32_t packetsReceived;
+		int32_t packetsLost;              // cumulative, negative if there are duplicates
+		double fractionLost;              // over the last report interval
+		uint32_t extendedHighestSeqNo;    // including sequence number cycles
+		std::chrono::microseconds jitter; // interarrival jitter
+	};
+
 	RtcpReceivingSession() = default;
 	virtual ~RtcpReceivingSession() = default;
 
+	void media(const Description::Media &desc) override;
 	void incoming(message_vector &messages, const message_callback &send) override;
 	bool requestKeyframe(const message_callback &send) override;
 	bool requestBitrate(unsigned int bitrate, const message_callback &send) override;
+	bool requestRetransmission(const std::vector<uint16_t> &sequenceNumbers,
+	                           const message_callback &send) override;
 
 	// For backward compatibility
 	[[deprecated("Use Track::requestKeyframe()")]] inline bool requestKeyframe() { return false; };
@@ -45,31 +64,67 @@ public:
 
 	SyncTimestamps getSyncTimestamps();
 
+	/// Returns the reception statistics of incoming streams
+	std::vector<Stats> stats() const;
+
+	/// Returns the round-trip time from the last report of the peer about a local stream
+	optional<std::chrono::microseconds> roundTripTime() const;
+
+	/// Returns report blocks for the streams received since the last report, and starts a new
+	/// report interval
+	std::vector<RtcpReportBlock> prepareReportBlocks();
+
+	/// Returns the feedback to append to the next report, the REMB of the requested bitrate if
+	/// any, or an empty packet
+	binary prepareFeedback();
+
 protected:
 	void pushREMB(const message_callback &send, unsigned int bitrate);
-	void pushRR(const message_callback &send,unsigned int lastSrDelay);
 	void pushPLI(const message_callback &send);
+	void pushNACK(const message_callback &send, const std::vector<uint16_t> &sequenceNumbers);
 
-	void initSeq(uint16_t seq);
-	bool updateSeq(uint16_t seq);
-	
 	SSRC mSsrc = 0;
-	uint32_t mGreatestSeqNo = 0;
-    uint16_t mMaxSeq = 0;			// highest seq. number seen
-    uint32_t mCycles = 0;			// shifted count of seq. number cycles
-	uint32_t mBaseSeq = 0;			// base seq number
-    uint32_t mBadSeq = 0;			// last 'bad' seq number + 1
-	uint32_t mProbation = 0;		// sequ. packets till source is valid
-    uint32_t mReceived = 0;			// packets received
-    uint32_t mExpectedPrior = 0;	// packet expected at last interval
-    uint32_t mReceivedPrior = 0;	// packet received at last interval
-	uint32_t mTransit = 0;			// relative trans time for prev pkt
-	uint32_t mJitter = 0;	
-	
 	SyncTimestamps mSyncTimestamps{0,0};
 
 	std::atomic<unsigned int> mRequestedBitrate = 0;
 	std::mutex mSyncMutex;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	// See https://www.rfc-editor.org/rfc/rfc3550.html#appendix-A.1
+	struct Source {
+		bool started = false;
+		uint16_t maxSeq = 0;          // highest seq. number seen
+		uint32_t cycles = 0;          // shifted count of seq. number cycles
+		uint32_t baseSeq = 0;         // base seq number
+		uint32_t badSeq = 0;          // last 'bad' seq number + 1
+		uint32_t probation = 0;       // sequ. packets till source is valid
+		uint32_t received = 0;        // packets received
+		uint32_t expectedPrior = 0;   // packet expected at last interval
+		uint32_t receivedPrior = 0;   // packet received at last interval
+		uint8_t fraction = 0;         // fraction lost at last interval
+		optional<uint32_t> transit;   // relative trans time for prev pkt
+		uint32_t jitter = 0;          // estimated jitter, scaled by 16
+		int clockRate = 90000;        // of the last packet payload type
+		uint32_t lastSrNtp = 0;       // middle 32 bits of the NTP timestamp of the last SR
+		clock::time_point lastSrTime; // arrival time of the last SR
+		bool reported = true;         // no packet received since the last report
+
+		void init(uint16_t seq);
+		bool update(uint16_t seq);
+		void updateJitter(uint32_t timestamp, clock::time_point arrival);
+		int32_t lost() const;
+	};
+
+	// Requires mStatsMutex to be locked
+	void processReport(const RtcpHeader *header, clock::time_point now);
+
+	std::unordered_map<SSRC, Source> mSources;
+	std::unordered_map<uint8_t, int> mClockRates; // by payload type
+	std::unordered_set<SSRC> mLocalSsrcs;
+	optional<std::chrono::microseconds> mRoundTripTime;
+	mutable std::mutex mStatsMutex;
 };
 
 } // namespace rtc
@@ -15,12 +15,38 @@
 #include "rtp.hpp"
 #include "rtppacketizationconfig.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <vector>
 
 namespace rtc {
 
+/// Sender report generation
+/// Outgoing packets are only counted, reports are prepared periodically by the peer connection,
+/// which sends the reports of all its tracks together in compound RTCP packets.
 class RTC_CPP_EXPORT RtcpSrReporter final : public MediaHandler {
 public:
+	struct Report {
+		SSRC ssrc;
+		string cname;
+		uint64_t ntpTimestamp;
+		uint32_t rtpTimestamp;
+		uint32_t packetCount;
+		uint32_t octetCount;
+	};
+
+	/// Builds compound RTCP packets, each holding sender reports, then receiver reports with the
+	/// report blocks, then one SDES packet with the CNAMEs of the senders, with as many reports
+	/// and blocks per packet as fit in maxSize. Feedback packets are appended at the end.
+	/// @param receiverSsrc The sender SSRC of receiver reports in packets without sender reports
+	/// @param receiverCname The CNAME sent with receiverSsrc in packets without sender reports
+	/// @param feedback RTCP feedback packets (RFC 4585) to append, like REMB
+	static std::vector<message_ptr> MakeCompoundPackets(const std::vector<Report> &reports,
+	                                                    const std::vector<RtcpReportBlock> &blocks,
+	                                                    SSRC receiverSsrc,
+	                                                    const string &receiverCname, size_t maxSize,
+	                                                    const std::vector<binary> &feedback = {});
+
 	RtcpSrReporter(shared_ptr<RtpPacketizationConfig> rtpConfig);
 	~RtcpSrReporter();
 
@@ -29,17 +55,21 @@ public:
 
 	void outgoing(message_vector &messages, const message_callback &send) override;
 
+	/// Returns the report for the packets sent so far, or nullopt if none was sent since the last
+	/// report
+	optional<Report> prepareReport();
+
 	// TODO: remove this
 	const shared_ptr<RtpPacketizationConfig> rtpConfig;
 
 private:
-	void addToReport(RtpHeader *header, size_t size);
-	message_ptr getSenderReport(uint32_t timestamp);
-
-	uint32_t mPacketCount = 0;
-	uint32_t mPayloadOctets = 0;
-	uint32_t mLastReportedTimestamp = 0;
-	std::chrono::steady_clock::time_point mLastReportTime;
+	// Counters are updated with relaxed atomics as they are only read for reports
+	std::atomic<uint32_t> mPacketCount = 0;
+	std::atomic<uint32_t> mPayloadOctets = 0;
+	std::atomic<uint32_t> mLastTimestamp = 0;
+	std::atomic<std::chrono::steady_clock::rep> mLastTime = 0; // when the last packet was sent
+	std::atomic<uint32_t> mLastReportedTimestamp = 0;
+	std::atomic<uint32_t> mReportedPacketCount = 0;
 };
 
 } // namespace rtc
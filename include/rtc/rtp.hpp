@@ -44,6 +44,9 @@ struct RTC_CPP_EXPORT RtpExtensionHeader {
 	size_t writeTwoByteHeader(size_t offset, uint8_t id, const byte *value, size_t size);
 	size_t writeHeader(bool twoByteHeader, size_t offset, uint8_t id, const byte *value,
 	                   size_t size);
+
+	// Returns the value of the element with the given id and sets size, or nullptr if not found
+	[[nodiscard]] const byte *findHeader(uint8_t id, size_t &size) const;
 };
 
 struct RTC_CPP_EXPORT RtpHeader {
@@ -80,6 +83,7 @@ struct RTC_CPP_EXPORT RtpHeader {
 	void setMarker(bool marker);
 	void setTimestamp(uint32_t i);
 	void setExtension(bool extension);
+	void setPadding(bool padding);
 };
 
 struct RTC_CPP_EXPORT RtcpReportBlock {
@@ -354,6 +358,8 @@ struct RTC_CPP_EXPORT RtpRtx {
 	[[nodiscard]] size_t getSize() const;
 	[[nodiscard]] uint16_t getOriginalSeqNo() const;
 
+	void setOriginalSeqNo(uint16_t osn);
+
 	// Returns the new size of the packet
 	size_t normalizePacket(size_t totalSize, SSRC originalSSRC, uint8_t originalPayloadType);
 
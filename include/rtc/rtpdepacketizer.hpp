@@ -14,10 +14,14 @@
 #include "mediahandler.hpp"
 #include "message.hpp"
 
-#include <set>
+#include <chrono>
+#include <mutex>
+#include <vector>
 
 namespace rtc {
 
+struct RtpHeader;
+
 // Base RTP depacketizer class
 class RTC_CPP_EXPORT RtpDepacketizer : public MediaHandler {
 public:
@@ -29,31 +33,75 @@ public:
 
 protected:
 	shared_ptr<FrameInfo> createFrameInfo(uint32_t timestamp, uint8_t payloadType) const;
+	shared_ptr<FrameInfo> createFrameInfo(const RtpHeader &header) const;
 
 private:
 	const uint32_t mClockRate;
 };
 
 // Base class for video RTP depacketizer
+// Packets go through a jitter buffer: complete frames are reassembled and emitted in order as soon
+// as possible, while missing packets are requested with NACK. Frames still incomplete after the
+// delay are dropped and a keyframe is requested. It should be chained before RtcpReceivingSession.
 class RTC_CPP_EXPORT VideoRtpDepacketizer : public RtpDepacketizer {
 public:
 	inline static const uint32_t ClockRate = 90000;
+	inline static const std::chrono::milliseconds DefaultTargetDelay{100};
+	static constexpr size_t MaxBufferedCount = 2048; // packets
+	static constexpr size_t MaxNackCount = 256;      // missing packets requested at once
 
 	VideoRtpDepacketizer();
 	virtual ~VideoRtpDepacketizer();
 
+	/// Set the target delay of the jitter buffer
+	/// @param delay Maximum time to wait for a missing packet. The actual wait adapts to the
+	/// observed reordering and retransmission delays, it is only reevaluated on incoming packets.
+	void setTargetDelay(std::chrono::milliseconds delay);
+
 protected:
-	struct sequence_cmp {
-		bool operator()(message_ptr a, message_ptr b) const;
-	};
-	using message_buffer = std::set<message_ptr, sequence_cmp>;
+	using message_buffer = std::vector<message_ptr>; // contiguous packets of a frame, in order
 
 	virtual message_ptr reassemble(message_buffer &messages) = 0;
 
 private:
+	using clock = std::chrono::steady_clock;
+
+	struct Packet {
+		message_ptr message;
+		clock::time_point arrival;
+		int64_t seqNumber = 0;
+	};
+
+	struct GiveUp {
+		int64_t begin, end; // sequence numbers given up on
+		clock::time_point detected;
+	};
+
 	void incoming(message_vector &messages, const message_callback &send) override;
 
-	message_buffer mBuffer;
+	// The following require mMutex to be locked
+	void insert(message_ptr message, clock::time_point now, const message_callback &send);
+	void process(message_vector &result, const message_callback &send, clock::time_point now);
+	void emit(int64_t begin, int64_t end, message_vector &result);
+	void erase(int64_t begin, int64_t end);
+	void reset();
+	Packet *find(int64_t seqNumber);
+	int64_t findNext(int64_t seqNumber); // first present from seqNumber, mCount must not be 0
+	void updateDelay(clock::duration sample);
+	clock::duration waitDelay() const;
+
+	std::vector<Packet> mPackets; // ring indexed by extended sequence number
+	size_t mCount = 0;
+	message_buffer mFrame;
+	optional<uint32_t> mSsrc;
+	optional<int64_t> mNextSeqNumber; // next to emit
+	int64_t mHighestSeqNumber = 0;
+	optional<uint32_t> mLastTimestamp; // of the last emitted or dropped frame
+	optional<GiveUp> mLastGiveUp;
+	std::chrono::milliseconds mTargetDelay = DefaultTargetDelay;
+	optional<clock::duration> mLateness; // smoothed delay of out-of-order packets
+	clock::duration mLatenessDeviation = clock::duration::zero();
+	std::mutex mMutex;
 };
 
 // Generic audio RTP depacketizer
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_RTP_FORWARDER_H
+#define RTC_RTP_FORWARDER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+#include "track.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc {
+
+namespace impl {
+
+enum class VideoCodec;
+
+} // namespace impl
+
+/// RTP forwarding for selective forwarding units
+/// Incoming RTP packets of the track are sent as-is to every added track, with the SSRC, the
+/// sequence number, and the timestamp rewritten for each one. Sequence numbers and timestamps stay
+/// continuous for a track if the incoming SSRC changes. Packets are not depacketized, the incoming
+/// plaintext buffer is shared and only copied once per track for protection. Retransmissions are
+/// not forwarded. It must receive packets before any depacketizer in the chain. The incoming track
+/// should be asked for a keyframe when a track is added so it can start playing immediately,
+/// unless the keyframe cache is enabled.
+class RTC_CPP_EXPORT RtpForwarder final : public MediaHandler {
+public:
+	RtpForwarder();
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+
+	/// Adds a track to forward to
+	/// @param track The outgoing track
+	/// @param ssrc The SSRC of outgoing packets
+	/// @param payloadType The payload type of outgoing packets, by default it is unchanged
+	void addTrack(shared_ptr<Track> track, SSRC ssrc, optional<uint8_t> payloadType = nullopt);
+	void removeTrack(const shared_ptr<Track> &track);
+	size_t trackCount() const;
+
+	/// Restricts forwarding to a track to the incoming packets with the given SSRC
+	/// @param track The outgoing track
+	/// @param source The incoming SSRC, or nullopt to forward all incoming packets
+	void setSource(const shared_ptr<Track> &track, optional<SSRC> source);
+
+	/// Enables caching of the incoming video packets since the last keyframe, so that added tracks
+	/// start with the cached keyframe, or wait for the next one, without requesting a keyframe
+	/// @param maxSize The maximum size of the cache in bytes, 0 to disable it (default)
+	void setKeyframeCache(size_t maxSize);
+
+	/// Returns true if a keyframe is cached for added tracks
+	bool hasCachedKeyframe() const;
+
+private:
+	struct Output {
+		shared_ptr<Track> track;
+		SSRC ssrc;
+		optional<uint8_t> payloadType;
+		optional<SSRC> filter; // the incoming SSRC to forward, all if unset
+		optional<SSRC> source; // the last incoming SSRC
+		uint16_t seqOffset = 0;
+		uint32_t timestampOffset = 0;
+		uint16_t lastSeqNumber = 0;
+		uint32_t lastTimestamp = 0;
+		std::chrono::steady_clock::time_point lastTime;
+		bool started = false; // whether packets were forwarded
+	};
+
+	struct Cache {
+		uint32_t timestamp = 0;           // of the keyframe
+		std::vector<message_ptr> packets; // since the keyframe, empty if none or too large
+		size_t size = 0;
+	};
+
+	// The following require mMutex to be locked
+	bool isKeyframeStart(const RtpHeader &rtp, const message_ptr &message) const;
+	void cache(const RtpHeader &rtp, bool keyframe, const message_ptr &message);
+	bool start(Output &output, const RtpHeader &rtp, bool keyframe);
+	void forward(Output &output, const RtpHeader &original, const message_ptr &message);
+
+	std::vector<uint8_t> mRtxPayloadTypes;
+	std::unordered_map<uint8_t, int> mClockRates;          // by payload type
+	std::unordered_map<uint8_t, impl::VideoCodec> mCodecs; // by payload type
+	std::unordered_map<SSRC, Cache> mCaches;
+	size_t mCacheMaxSize = 0;
+	std::vector<Output> mOutputs;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_RTP_FORWARDER_H */
@@ -83,6 +83,9 @@ public:
 	uint8_t colorTransfer = 1;              // BT.709-6
 	uint8_t colorMatrix = 1;                // BT.709-6
 
+	// Maximum fragment size set by MtuProber, overrides the one of the packetizer if not 0
+	size_t maxFragmentSize = 0;
+
 	/// Construct RTP configuration used in packetization process
 	/// @param ssrc SSRC of source
 	/// @param cname CNAME of source
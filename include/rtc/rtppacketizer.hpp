@@ -15,6 +15,10 @@
 #include "message.hpp"
 #include "rtppacketizationconfig.hpp"
 
+#include <array>
+#include <memory>
+#include <vector>
+
 namespace rtc {
 
 /// RTP packetizer
@@ -40,11 +44,35 @@ public:
 	const shared_ptr<RtpPacketizationConfig> rtpConfig;
 
 protected:
+	static const size_t MaxSlicePrefixSize = 3;
+
+	/// Payload of an RTP packet as a slice of the frame, after an optional prefix
+	struct Slice {
+		size_t offset;
+		size_t size;
+		std::array<byte, MaxSlicePrefixSize> prefix = {}; // for instance FU headers
+		size_t prefixSize = 0;
+		const byte *insert = nullptr; // written after the prefix, must outlive the call
+		size_t insertSize = 0;
+	};
+
 	/// Fragment data into payloads
 	/// Default implementation returns data as a single payload
 	/// @param message Input data
 	virtual std::vector<binary> fragment(binary data);
 
+	/// Fragment data into slices, so each packet is written straight from the frame
+	/// Default implementation returns false, fragment() is then called instead
+	/// @param frame Input data
+	/// @param slices Output slices
+	/// @return true if the frame was sliced
+	virtual bool slice(const binary &frame, std::vector<Slice> &slices);
+
+	/// Returns the maximum fragment size to use
+	/// @param maxFragmentSize Maximum fragment size of the packetizer, unless overridden by the
+	/// configuration
+	size_t maxFragmentSize(size_t maxFragmentSize) const;
+
 	/// Creates an RTP packet for a payload
 	/// @note This function increases the sequence number.
 	/// @param payload RTP payload
@@ -57,6 +85,16 @@ protected:
 private:
 	static const auto RtpHeaderSize = 12;
 	static const auto RtpExtHeaderCvoSize = 8;
+
+	// Creates an RTP packet with room for the payload at the end, and increases the sequence number
+	message_ptr createPacket(size_t payloadSize, bool mark);
+
+	// Header extensions which only depend on the configuration, encoded once
+	struct ExtensionTemplate;
+	const ExtensionTemplate &extensionTemplate();
+
+	std::vector<Slice> mSlices; // reused between frames
+	std::unique_ptr<ExtensionTemplate> mExtensionTemplate; // rebuilt when the config changes
 };
 
 // Generic audio RTP packetizer
@@ -69,6 +107,13 @@ public:
 
 	AudioRtpPacketizer(shared_ptr<RtpPacketizationConfig> rtpConfig)
 	    : RtpPacketizer(std::move(rtpConfig)) {}
+
+protected:
+	// Audio frames are never fragmented, each packet is written straight from its frame
+	bool slice(const binary &frame, std::vector<Slice> &slices) override {
+		slices.push_back(Slice{0, frame.size()});
+		return true;
+	}
 };
 
 // Audio RTP packetizers
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_RTP_RECORDER_H
+#define RTC_RTP_RECORDER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+
+#include <cstdint>
+
+namespace rtc {
+
+struct RtpRecorderInit {
+	bool recordOutgoing = false;              // record sent packets too
+	bool ioThread = false;                    // write on an I/O thread shared by recorders
+	size_t maxPendingSize = 16 * 1024 * 1024; // bytes to write, packets are dropped above
+};
+
+/// Recording of RTP and RTCP packets to a file in the rtpdump format, readable by rtpplay or
+/// Wireshark, without decoding. Packets are copied in pooled buffers and written in batches with
+/// vectored writes off the media path, so recording is bounded by disk bandwidth. Incoming packets
+/// go through the chain from the last handler, so it should be chained last to record packets as
+/// received, and outgoing packets are recorded as they leave the handler, before encryption.
+class RTC_CPP_EXPORT RtpRecorder final : public MediaHandler {
+public:
+	/// The file is created or truncated immediately
+	RtpRecorder(const string &path, RtpRecorderInit init = {});
+	~RtpRecorder(); // pending packets are still written, then the file is closed
+
+	void incoming(message_vector &messages, const message_callback &send) override;
+	void outgoing(message_vector &messages, const message_callback &send) override;
+
+	void flush(); // blocks until pending packets are written
+
+	uint64_t recordedCount() const;
+	uint64_t droppedCount() const; // packets dropped because the disk did not keep up
+
+private:
+	class Writer;
+	const shared_ptr<Writer> mWriter;
+	const bool mRecordOutgoing;
+};
+
+} // namespace rtc
+
+#endif // RTC_ENABLE_MEDIA
+
+#endif // RTC_RTP_RECORDER_H
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_RTP_REPLAYER_H
+#define RTC_RTP_REPLAYER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "common.hpp"
+#include "track.hpp"
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace rtc {
+
+/// Packets of an rtpdump file, like the ones written by RtpRecorder
+/// The file is memory-mapped and indexed once, then the dump may be shared by many replayers.
+class RTC_CPP_EXPORT RtpDump final {
+public:
+	struct Packet {
+		const byte *data;
+		size_t size;
+		std::chrono::milliseconds offset; // since the start of the recording
+		bool rtcp;
+	};
+
+	static shared_ptr<RtpDump> Load(const string &path); // throws on error
+	~RtpDump();
+
+	const std::vector<Packet> &packets() const;
+	std::chrono::milliseconds duration() const;
+	size_t rtpCount() const;
+
+private:
+	struct Mapping;
+	explicit RtpDump(unique_ptr<Mapping> mapping);
+
+	const unique_ptr<Mapping> mMapping;
+	std::vector<Packet> mPackets;
+	size_t mRtpCount = 0;
+};
+
+struct RtpReplayerInit {
+	double speed = 1.;          // relative to the original timing
+	bool loop = false;          // restart at the end, continuing sequence numbers and timestamps
+	uint32_t clockRate = 90000; // to shift timestamps when looping
+	optional<uint32_t> ssrc;    // replaces the SSRC of RTP packets, so a dump may feed many tracks
+	bool rtcp = false;          // also replay recorded RTCP packets
+};
+
+/// Replay of an rtpdump file with the original timing, or faster or slower, to generate realistic
+/// and reproducible traffic for benchmarks and load tests. Packets are sent as is with
+/// Track::send() from the thread pool, so the track must not have a packetizer.
+class RTC_CPP_EXPORT RtpReplayer final {
+public:
+	RtpReplayer(shared_ptr<RtpDump> dump, shared_ptr<Track> track, RtpReplayerInit init = {});
+	~RtpReplayer(); // stops the replay
+
+	void start();
+	void stop();
+
+	bool isRunning() const;
+	uint64_t sentCount() const;
+
+	// Called from the thread pool at the end of the dump, unless looping
+	void onComplete(std::function<void()> callback);
+
+private:
+	class Player;
+	const shared_ptr<Player> mPlayer;
+};
+
+} // namespace rtc
+
+#endif // RTC_ENABLE_MEDIA
+
+#endif // RTC_RTP_REPLAYER_H
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_RTP_REWRITER_H
+#define RTC_RTP_REWRITER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+#include <array>
+#include <chrono>
+#include <mutex>
+
+namespace rtc {
+
+/// RTP header rewriting for forwarded packets
+/// Outgoing RTP packets are rewritten in place with the SSRC of the track, and their sequence
+/// numbers and timestamps are translated so the stream stays continuous when the forwarded SSRC
+/// changes. Once the description of the forwarded packets is set with setSourceMedia(), payload
+/// types are mapped to the codecs of the track and header extension ids are remapped to the ones
+/// negotiated for the track, matching them by URI. Extensions which are not negotiated are
+/// overwritten with padding, and forwarded retransmissions are dropped. It should be placed first
+/// in the chain of the outgoing track.
+class RTC_CPP_EXPORT RtpRewriter final : public MediaHandler {
+public:
+	/// @param ssrc The SSRC of outgoing packets
+	RtpRewriter(SSRC ssrc);
+
+	void media(const Description::Media &desc) override;
+	void outgoing(message_vector &messages, const message_callback &send) override;
+
+	/// Sets the description of the forwarded packets, typically the one of the incoming track
+	void setSourceMedia(const Description::Media &source);
+
+	SSRC ssrc() const;
+
+	/// Returns the incoming SSRC currently forwarded, if any
+	optional<SSRC> source() const;
+
+private:
+	// The following require mMutex to be locked
+	void rebuildMaps();
+	bool rewrite(Message &message, std::chrono::steady_clock::time_point now);
+	void remapExtensions(RtpExtensionHeader *ext, size_t size);
+
+	const SSRC mSsrc;
+	optional<Description::Media> mMedia;
+	optional<Description::Media> mSourceMedia;
+
+	std::array<uint8_t, 128> mPayloadTypes; // by incoming payload type
+	std::array<uint8_t, 256> mExtIds;       // by incoming extension id, 0 to remove it
+	std::array<int, 128> mClockRates;       // by incoming payload type, 0 if unknown
+	std::array<bool, 128> mRtx;             // by incoming payload type
+	bool mRemapExtensions = false;
+
+	optional<SSRC> mSource; // the last incoming SSRC
+	uint16_t mSeqOffset = 0;
+	uint32_t mTimestampOffset = 0;
+	uint16_t mLastSeqNumber = 0;
+	uint32_t mLastTimestamp = 0;
+	std::chrono::steady_clock::time_point mLastTime;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_RTP_REWRITER_H */
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_SIMULCAST_SELECTOR_H
+#define RTC_SIMULCAST_SELECTOR_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+#include "rtpforwarder.hpp"
+#include "track.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc {
+
+namespace impl {
+
+enum class VideoCodec;
+
+} // namespace impl
+
+/// Simulcast layer selection for selective forwarding units
+/// Incoming layers are identified by their RID header extension (RFC 8852), or by their SSRC if it
+/// is not negotiated, and their bitrates are measured. Each added track is forwarded the highest
+/// layer fitting in its available bitrate, set with setBitrate(), or the highest layer if it is
+/// not set. Layers are switched on keyframes, which are requested on the target layer. It must
+/// receive packets before any depacketizer in the chain.
+class RTC_CPP_EXPORT SimulcastSelector final : public MediaHandler {
+public:
+	static constexpr const char *RidExtensionUri = "urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id";
+	static constexpr const char *RepairedRidExtensionUri =
+	    "urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id";
+
+	struct Layer {
+		string rid; // empty if the RID extension is not negotiated
+		SSRC ssrc;
+		unsigned int bitrate; // measured, in bits per second
+	};
+
+	SimulcastSelector();
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+
+	/// Adds a track to forward to, see RtpForwarder::addTrack()
+	void addTrack(shared_ptr<Track> track, SSRC ssrc, optional<uint8_t> payloadType = nullopt);
+	void removeTrack(const shared_ptr<Track> &track);
+
+	/// Sets the available bitrate for a track, typically from its bandwidth estimation
+	/// @param bitrate The bitrate in bits per second, or nullopt for the highest layer
+	void setBitrate(const shared_ptr<Track> &track, optional<unsigned int> bitrate);
+
+	/// Returns the active layers sorted by increasing bitrate
+	std::vector<Layer> layers() const;
+
+	/// Returns the incoming SSRC currently forwarded to a track, if any
+	optional<SSRC> selected(const shared_ptr<Track> &track) const;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr auto RateWindow = std::chrono::milliseconds(500);
+	static constexpr auto InactiveTimeout = std::chrono::seconds(2);
+	static constexpr auto KeyframeRequestInterval = std::chrono::seconds(1);
+	static constexpr double SwitchUpMargin = 1.2; // estimate over layer bitrate to switch up
+
+	struct Stream {
+		string rid;
+		bool repair = false;
+		size_t bytes = 0; // in the current window
+		clock::time_point windowStart;
+		clock::time_point lastReceived;
+		double bitrate = 0.;
+	};
+
+	struct Subscriber {
+		shared_ptr<Track> track;
+		SSRC ssrc;
+		optional<uint8_t> payloadType;
+		optional<unsigned int> bitrate;
+		optional<SSRC> current;
+		optional<SSRC> target;
+	};
+
+	using LayerList = std::vector<std::pair<SSRC, const Stream *>>;
+
+	// The following require mMutex to be locked
+	bool measure(Stream &stream, size_t size, clock::time_point now);
+	void select(Subscriber &subscriber, const LayerList &layers);
+	bool isKeyframe(const Message &message, const RtpHeader &rtp) const;
+	void pushPLI(SSRC ssrc, const message_callback &send, clock::time_point now);
+	LayerList activeLayers(clock::time_point now) const;
+
+	const shared_ptr<RtpForwarder> mForwarder;
+	uint8_t mRidExtId = 0;
+	uint8_t mRepairedRidExtId = 0;
+	std::unordered_map<uint8_t, impl::VideoCodec> mCodecs; // by payload type
+	std::unordered_map<SSRC, Stream> mStreams;
+	std::unordered_map<SSRC, clock::time_point> mKeyframeRequests;
+	std::vector<Subscriber> mSubscribers;
+	bool mReselect = false;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_SIMULCAST_SELECTOR_H */
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_STATS_H
+#define RTC_STATS_H
+
+#include "candidate.hpp"
+#include "common.hpp"
+
+#include <chrono>
+
+namespace rtc {
+
+// Counters of a transport: packets are passed to the lower layer or the network when sent, and
+// to the upper layer when received
+struct TransportStats {
+	uint64_t packetsSent = 0;
+	uint64_t bytesSent = 0;
+	uint64_t packetsReceived = 0;
+	uint64_t bytesReceived = 0;
+};
+
+struct IceTransportStats : TransportStats {
+	// Selected candidate pair
+	optional<Candidate> localCandidate;
+	optional<Candidate> remoteCandidate;
+
+	unsigned int turnAllocations = 0; // made by this PeerConnection, see maxTurnAllocations
+};
+
+struct DtlsTransportStats : TransportStats {
+	optional<std::chrono::milliseconds> handshakeDuration;
+	string version; // negotiated, like "DTLSv1.2", empty until connected
+
+	// SRTP, only for media transports
+	string srtpProfile; // negotiated profile, like "SRTP_AEAD_AES_128_GCM", empty if none
+	uint64_t rtpPacketsProtected = 0;
+	uint64_t rtcpPacketsProtected = 0;
+	uint64_t rtpPacketsUnprotected = 0;
+	uint64_t rtcpPacketsUnprotected = 0;
+	uint64_t rtpUnprotectFailures = 0;  // including replays and authentication failures
+	uint64_t rtcpUnprotectFailures = 0; // including replays and authentication failures
+};
+
+// Packets are messages for SCTP
+struct SctpTransportStats : TransportStats {
+	optional<std::chrono::milliseconds> rtt;
+	uint32_t congestionWindow = 0;  // bytes
+	uint32_t peerReceiveWindow = 0; // bytes
+	uint32_t pendingChunks = 0;     // chunks waiting to be sent
+	uint32_t unacknowledgedChunks = 0;
+	size_t memoryUsage = 0;       // bytes held in transport buffers
+	uint64_t expiredMessages = 0; // dropped from send queues once their lifetime was over
+};
+
+struct PeerConnectionStats {
+	optional<IceTransportStats> ice;
+	optional<DtlsTransportStats> dtls;
+	optional<SctpTransportStats> sctp;
+};
+
+struct DataChannelStats {
+	uint64_t messagesSent = 0;
+	uint64_t bytesSent = 0;
+	uint64_t messagesReceived = 0;
+	uint64_t bytesReceived = 0;
+	size_t bufferedAmount = 0;
+};
+
+// Packets are counted after outgoing media handlers and before incoming ones
+struct TrackStats {
+	uint64_t rtpPacketsSent = 0;
+	uint64_t rtpBytesSent = 0;
+	uint64_t rtcpPacketsSent = 0;
+	uint64_t rtpPacketsReceived = 0;
+	uint64_t rtpBytesReceived = 0;
+	uint64_t rtcpPacketsReceived = 0;
+
+	// RTCP feedback received
+	uint64_t nacksReceived = 0;
+	uint64_t plisReceived = 0;
+	uint64_t firsReceived = 0;
+
+	// Payload types of the last RTP packets, identifying the codecs in use
+	optional<int> sentPayloadType;
+	optional<int> receivedPayloadType;
+};
+
+} // namespace rtc
+
+#endif /* RTC_STATS_H */
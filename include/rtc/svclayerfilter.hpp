@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_SVC_LAYER_FILTER_H
+#define RTC_SVC_LAYER_FILTER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "dependencydescriptor.hpp"
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+#include <mutex>
+
+namespace rtc {
+
+/// Scalable video coding layer filtering with the Dependency Descriptor extension
+/// Outgoing packets of frames not present in the selected decode target are dropped, and sequence
+/// numbers are rewritten so that drops are not seen as losses. The decode target is switched on a
+/// switch frame for it. It is meant for forwarded AV1 or VP9 SVC streams, and should be placed
+/// first in the chain of the outgoing track. The extension id is taken from the description of the
+/// track, so it must match the one of forwarded packets.
+class RTC_CPP_EXPORT SvcLayerFilter final : public MediaHandler {
+public:
+	static constexpr const char *ExtensionUri =
+	    "https://aomediacodec.github.io/av1-rtp-spec/#dependency-descriptor-rtp-header-extension";
+
+	SvcLayerFilter();
+
+	void media(const Description::Media &desc) override;
+	void outgoing(message_vector &messages, const message_callback &send) override;
+
+	/// Sets the decode target to forward, or nullopt to forward all frames
+	void setDecodeTarget(optional<int> decodeTarget);
+
+	/// Sets the decode target to the highest one within the given spatial and temporal ids
+	void setMaxLayers(int spatialId, int temporalId);
+
+	/// Returns the decode target currently forwarded, nullopt if all frames are forwarded
+	optional<int> decodeTarget() const;
+
+	/// Returns the count of packets dropped so far
+	size_t droppedCount() const;
+
+private:
+	// The following require mMutex to be locked
+	bool filter(Message &message);
+	void resolveMaxLayers();
+
+	uint8_t mExtId = 0;
+	DependencyDescriptorContext mContext;
+	optional<int> mDecodeTarget;
+	optional<optional<int>> mPendingDecodeTarget; // switch on the next possible frame
+	optional<std::pair<int, int>> mMaxLayers;
+	uint16_t mSeqOffset = 0; // subtracted from sequence numbers
+	size_t mDropped = 0;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_SVC_LAYER_FILTER_H */
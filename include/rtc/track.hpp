@@ -13,6 +13,9 @@
 #include "common.hpp"
 #include "description.hpp"
 #include "mediahandler.hpp"
+#include "stats.hpp"
+
+#include <vector>
 
 namespace rtc {
 
@@ -40,11 +43,31 @@ public:
 	bool isOpen(void) const override;
 	bool isClosed(void) const override;
 	size_t maxMessageSize() const override;
+	TrackStats getStats() const;
 
 	void sendFrame(binary data, FrameInfo info);
 	void sendFrame(const byte *data, size_t size, FrameInfo info);
+
+	// Frame for sendFrames(), the data is copied during the call
+	struct FrameData {
+		const byte *data;
+		size_t size;
+		FrameInfo info;
+	};
+
+	// Sends frames with a single pass through the media handler chain and a single SRTP batch,
+	// for instance the audio frames of a mixer tick
+	void sendFrames(const std::vector<FrameData> &frames);
+
+	// Sends frames for many tracks, batched per track, returns false if a track failed or did not
+	// send its frames, like send()
+	static bool SendFrames(const std::vector<std::pair<shared_ptr<Track>, FrameData>> &frames);
 	void onFrame(std::function<void(binary data, FrameInfo info)> callback);
 
+	// Receives frames without copy, the buffer is shared and returns to the pool once released,
+	// and frame->frameInfo holds the metadata (timestamps, SSRC, keyframe flag, layers)
+	void onFrameView(std::function<void(shared_ptr<const Message> frame)> callback);
+
 	bool requestKeyframe();
 	bool requestBitrate(unsigned int bitrate);
 
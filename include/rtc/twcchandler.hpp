@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_TWCC_HANDLER_H
+#define RTC_TWCC_HANDLER_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace rtc {
+
+/// Transport-wide congestion control (draft-holmer-rmcat-transport-wide-cc-extensions-01)
+/// On send, stamps the transport-wide sequence number header extension and parses the RTCP
+/// transport-cc feedback into per-packet results. On receive, generates the feedback.
+/// The extension must be negotiated with TwccHandler::ExtensionUri in the media description.
+/// Only packets going through the chain are stamped, so it must be placed before handlers sending
+/// packets on their own like PacingHandler.
+class RTC_CPP_EXPORT TwccHandler final : public MediaHandler {
+public:
+	static constexpr const char *ExtensionUri =
+	    "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01";
+	static constexpr auto DefaultInterval = std::chrono::milliseconds(100);
+
+	using clock = std::chrono::steady_clock;
+
+	struct PacketResult {
+		uint16_t sequenceNumber = 0; // transport-wide sequence number
+		bool received = false;
+		optional<clock::time_point> sendTime; // not set if the packet is unknown
+		size_t size = 0;                      // 0 if the packet is unknown
+		// For received packets, the arrival time relative to the previous received packet in the
+		// feedback, and the arrival time in the receiver clock, with 250us resolution
+		std::chrono::microseconds arrivalDelta = std::chrono::microseconds::zero();
+		std::chrono::microseconds arrivalTime = std::chrono::microseconds::zero();
+	};
+
+	using feedback_callback = std::function<void(std::vector<PacketResult>)>;
+
+	/// @param onFeedback Callback called with the results of each feedback received
+	/// @param senderSsrc SSRC of the feedback packets
+	/// @param interval Minimum interval between feedback packets
+	TwccHandler(feedback_callback onFeedback = nullptr, SSRC senderSsrc = 1,
+	            std::chrono::milliseconds interval = DefaultInterval);
+
+	/// Returns a handler for another track of the same PeerConnection, sharing the transport-wide
+	/// sequence numbers and the feedback callback
+	shared_ptr<TwccHandler> fork() const;
+
+	void media(const Description::Media &desc) override;
+	void incoming(message_vector &messages, const message_callback &send) override;
+	void outgoing(message_vector &messages, const message_callback &send) override;
+
+private:
+	static constexpr size_t HistorySize = 4096;        // sent packets
+	static constexpr uint16_t MaxReportsCount = 0x4000; // per feedback packet
+
+	struct Sent {
+		bool valid = false;
+		uint16_t sequenceNumber = 0;
+		clock::time_point time;
+		size_t size = 0;
+	};
+
+	// Shared between the handlers of the same transport
+	struct Session {
+		Session(feedback_callback onFeedback, SSRC senderSsrc, clock::duration interval);
+
+		const SSRC senderSsrc;
+		const clock::duration interval;
+		const clock::time_point epoch;
+		synchronized_callback<std::vector<PacketResult>> onFeedback;
+
+		// Send side
+		uint16_t nextSequenceNumber;
+		std::vector<Sent> history; // indexed by sequence number
+		std::mutex sendMutex;
+
+		// Receive side
+		std::map<int64_t, clock::time_point> arrivals; // by unwrapped sequence number
+		optional<int64_t> lastReceived;
+		optional<int64_t> nextReported;
+		SSRC mediaSsrc = 0;
+		uint8_t feedbackCount = 0;
+		clock::time_point lastFeedback;
+		std::mutex receiveMutex;
+	};
+
+	explicit TwccHandler(shared_ptr<Session> session);
+
+	message_ptr stamp(message_ptr message, uint8_t id);
+	void parseFeedback(const byte *data, size_t size);
+	void record(const message_ptr &message, uint8_t id, clock::time_point now);
+	message_ptr generate(clock::time_point now); // requires receiveMutex to be locked
+
+	const shared_ptr<Session> mSession;
+	std::atomic<uint8_t> mExtId = 0;
+};
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif /* RTC_TWCC_HANDLER_H */
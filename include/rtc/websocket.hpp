@@ -51,11 +51,17 @@ public:
 	bool send(const message_variant data) override;
 	bool send(const byte *data, size_t size) override;
 
+	// Batched zero-copy reception: messages received together are passed at once in order, on
+	// the same terms as onMessageView(). Replaces onMessage and onMessageView callbacks.
+	void onMessages(std::function<void(std::vector<shared_ptr<const Message>> messages)> callback);
+
 	optional<string> remoteAddress() const;
 	optional<string> path() const;
 
 private:
 	using CheshireCat<impl::WebSocket>::impl;
+
+	friend class WebSocketServer;
 };
 
 std::ostream &operator<<(std::ostream &out, WebSocket::State state);
@@ -37,6 +37,11 @@ public:
 
 	void onClient(std::function<void(shared_ptr<WebSocket>)> callback);
 
+	// Sends the same message to many clients, the WebSocket frame is built once and shared
+	// instead of being copied for each client. Returns the number of clients it was sent to,
+	// clients not open are skipped.
+	size_t broadcast(const std::vector<shared_ptr<WebSocket>> &clients, message_variant data);
+
 private:
 	using CheshireCat<impl::WebSocketServer>::impl;
 };
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "audiolevelhandler.hpp"
+
+#include "impl/internals.hpp"
+
+#include <algorithm>
+
+namespace rtc {
+
+AudioLevelHandler::AudioLevelHandler(double smoothing, std::chrono::milliseconds timeout)
+    : AudioLevelHandler(std::make_shared<Levels>(std::clamp(smoothing, 0., 1.), timeout)) {}
+
+AudioLevelHandler::AudioLevelHandler(shared_ptr<Levels> levels) : mLevels(std::move(levels)) {}
+
+shared_ptr<AudioLevelHandler> AudioLevelHandler::fork() const {
+	return shared_ptr<AudioLevelHandler>(new AudioLevelHandler(mLevels));
+}
+
+void AudioLevelHandler::media(const Description::Media &desc) {
+	uint8_t id = 0;
+	for (int extId : desc.extIds())
+		if (desc.extMap(extId)->uri == ExtensionUri && extId > 0 && extId < 256)
+			id = uint8_t(extId);
+
+	if (id == 0) {
+		PLOG_DEBUG << "Audio level extension is not negotiated";
+	}
+	mExtId = id;
+}
+
+void AudioLevelHandler::incoming(message_vector &messages, const message_callback &) {
+	const uint8_t id = mExtId;
+	if (id == 0)
+		return;
+
+	const auto now = clock::now();
+	for (const auto &message : messages) {
+		if (message->type == Message::Control || message->size() < sizeof(RtpHeader))
+			continue;
+
+		auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+		if (rtp->version() != 2 || !rtp->extension() ||
+		    rtp->getSize() + sizeof(RtpExtensionHeader) > message->size() ||
+		    rtp->getSize() + rtp->getExtensionHeaderSize() > message->size())
+			continue;
+
+		// RFC 6464 3. The element is the voice activity flag followed by the level in -dBov
+		size_t size = 0;
+		auto element = rtp->getExtensionHeader()->findHeader(id, size);
+		if (!element || size < 1)
+			continue;
+
+		mLevels->record(rtp->ssrc(), std::to_integer<uint8_t>(element[0]), now);
+	}
+}
+
+optional<AudioLevelHandler::Level> AudioLevelHandler::level(SSRC ssrc) const {
+	const auto now = clock::now();
+	std::lock_guard lock(mLevels->mutex);
+	auto it = mLevels->levels.find(ssrc);
+	if (it == mLevels->levels.end() || now - it->second.lastTime > mLevels->timeout)
+		return nullopt;
+
+	return it->second;
+}
+
+std::vector<AudioLevelHandler::Level> AudioLevelHandler::topSpeakers(size_t count) const {
+	const auto now = clock::now();
+	std::vector<Level> result;
+	{
+		std::lock_guard lock(mLevels->mutex);
+		result.reserve(mLevels->levels.size());
+		for (const auto &[ssrc, level] : mLevels->levels)
+			if (now - level.lastTime <= mLevels->timeout)
+				result.push_back(level);
+	}
+
+	auto loudest = [](const Level &a, const Level &b) { return a.level < b.level; };
+	if (result.size() > count) {
+		std::partial_sort(result.begin(), result.begin() + count, result.end(), loudest);
+		result.resize(count);
+	} else {
+		std::sort(result.begin(), result.end(), loudest);
+	}
+	return result;
+}
+
+AudioLevelHandler::Levels::Levels(double smoothing, clock::duration timeout)
+    : smoothing(smoothing), timeout(timeout) {}
+
+void AudioLevelHandler::Levels::record(SSRC ssrc, uint8_t value, clock::time_point now) {
+	const bool voiceActivity = (value & 0x80) != 0;
+	const double sample = double(value & 0x7F);
+
+	std::lock_guard lock(mutex);
+	auto [it, inserted] = levels.try_emplace(ssrc);
+	auto &level = it->second;
+	if (inserted) {
+		// Forget the streams which stopped long ago, it only runs when a stream appears
+		for (auto jt = levels.begin(); jt != levels.end();) {
+			if (jt != it && now - jt->second.lastTime > 10 * timeout)
+				jt = levels.erase(jt);
+			else
+				++jt;
+		}
+
+		level.ssrc = ssrc;
+		level.level = sample;
+	} else if (now - level.lastTime > timeout) {
+		level.level = sample; // restart after a silence
+	} else {
+		level.level += smoothing * (sample - level.level);
+	}
+
+	level.voiceActivity = voiceActivity;
+	level.lastTime = now;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
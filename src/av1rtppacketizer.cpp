@@ -35,8 +35,6 @@ const auto obuFrameTypeSequenceHeader = byte(1);
 
 const auto obuTemporalUnitDelimiter = std::vector<byte>{byte(0x12), byte(0x00)};
 
-const auto oneByteLeb128Size = 1;
-
 const uint8_t sevenLsbBitmask = 0b01111111;
 const uint8_t msbBitmask = 0b10000000;
 
@@ -45,70 +43,65 @@ AV1RtpPacketizer::AV1RtpPacketizer(Packetization packetization,
                                    size_t maxFragmentSize)
     : RtpPacketizer(rtpConfig), mPacketization(packetization), mMaxFragmentSize(maxFragmentSize) {}
 
-std::vector<binary> AV1RtpPacketizer::extractTemporalUnitObus(const binary &data) {
-	std::vector<binary> obus;
-
-	if (data.size() == 0) {
-		return {};
-	}
-
-	// VAAPI doesn't seem to include delimiters
-	size_t index = 0;
-	if (data.size() > 2 && (data.at(0) == obuTemporalUnitDelimiter.at(0)) &&
-	    (data.at(1) == obuTemporalUnitDelimiter.at(1))) {
-		index = 2;
-	}
-	while (index < data.size()) {
-		if ((data.at(index) & obuHasSizeMask) == byte(0)) {
-			return obus;
-		}
+bool AV1RtpPacketizer::slice(const binary &frame, std::vector<Slice> &slices) {
+	// Slices may point to the sequence header cached by the previous frame
+	mSequenceHeader.clear();
+	mSequenceHeader.swap(mNextSequenceHeader);
+	mPendingHeader = !mSequenceHeader.empty() ? mSequenceHeader.data() : nullptr;
+	mPendingHeaderSize = mSequenceHeader.size();
 
-		if ((data.at(index) & obuHasExtensionMask) != byte(0)) {
-			index++;
+	if (mPacketization == AV1RtpPacketizer::Packetization::TemporalUnit) {
+		// VAAPI doesn't seem to include delimiters
+		size_t index = 0;
+		if (frame.size() > 2 && frame[0] == obuTemporalUnitDelimiter[0] &&
+		    frame[1] == obuTemporalUnitDelimiter[1]) {
+			index = 2;
 		}
-
-		// https://aomediacodec.github.io/av1-spec/#leb128
-		uint32_t obuLength = 0;
-		uint8_t leb128Size = 0;
-		while (leb128Size < 8) {
-			auto leb128Index = index + leb128Size + obuHeaderSize;
-			if (data.size() < leb128Index) {
+		while (index < frame.size()) {
+			if ((frame[index] & obuHasSizeMask) == byte(0))
 				break;
-			}
 
-			auto leb128_byte = uint8_t(data.at(leb128Index));
+			size_t headerSize = obuHeaderSize;
+			if ((frame[index] & obuHasExtensionMask) != byte(0))
+				headerSize++;
 
-			obuLength |= ((leb128_byte & sevenLsbBitmask) << (leb128Size * 7));
-			leb128Size++;
+			// https://aomediacodec.github.io/av1-spec/#leb128
+			uint32_t obuLength = 0;
+			uint8_t leb128Size = 0;
+			while (leb128Size < 8) {
+				auto leb128Index = index + headerSize + leb128Size;
+				if (leb128Index >= frame.size())
+					break;
 
-			if (!(leb128_byte & msbBitmask)) {
-				break;
-			}
-		}
+				auto leb128_byte = uint8_t(frame[leb128Index]);
 
-		obus.emplace_back(data.begin() + index,
-		                  data.begin() + index + obuHeaderSize + leb128Size + obuLength);
+				obuLength |= ((leb128_byte & sevenLsbBitmask) << (leb128Size * 7));
+				leb128Size++;
 
-		index += obuHeaderSize + leb128Size + obuLength;
-	}
+				if (!(leb128_byte & msbBitmask))
+					break;
+			}
 
-	return obus;
-}
+			size_t obuSize = headerSize + leb128Size + obuLength;
+			if (obuSize > frame.size() - index) {
+				PLOG_WARNING << "AV1 OBU is truncated, ignoring the end of the temporal unit";
+				break;
+			}
 
-std::vector<binary> AV1RtpPacketizer::fragment(binary data) {
-	if (mPacketization == AV1RtpPacketizer::Packetization::TemporalUnit) {
-		std::vector<binary> result;
-		auto obus = extractTemporalUnitObus(data);
-		for (auto obu : obus) {
-			auto fragments = fragmentObu(obu);
-			result.reserve(result.size() + fragments.size());
-			for(auto &fragment : fragments)
-				result.push_back(std::move(fragment));
+			sliceObu(frame, index, obuSize, slices);
+			index += obuSize;
 		}
-		return result;
 	} else {
-		return fragmentObu(data);
+		sliceObu(frame, 0, frame.size(), slices);
 	}
+
+	// Keep a sequence header not sent yet for the next frame
+	if (mPendingHeader)
+		mNextSequenceHeader.assign(mPendingHeader, mPendingHeader + mPendingHeaderSize);
+
+	mPendingHeader = nullptr;
+	mPendingHeaderSize = 0;
+	return true;
 }
 
 /*
@@ -142,69 +135,74 @@ std::vector<binary> AV1RtpPacketizer::fragment(binary data) {
  *
  **/
 
-std::vector<binary> AV1RtpPacketizer::fragmentObu(const binary &data) {
-	std::vector<binary> payloads;
+void AV1RtpPacketizer::sliceObu(const binary &frame, size_t offset, size_t size,
+                                std::vector<Slice> &slices) {
+	if (size < 1)
+		return;
 
-	if (data.size() < 1)
-		return {};
+	const size_t maxSize = maxFragmentSize(mMaxFragmentSize);
 
 	// Cache sequence header and packetize with next OBU
-	auto frameType = (data.at(0) & obuFrameTypeMask) >> obuFrameTypeBitshift;
+	auto frameType = (frame[offset] & obuFrameTypeMask) >> obuFrameTypeBitshift;
 	if (frameType == obuFrameTypeSequenceHeader) {
-		mSequenceHeader = std::make_unique<binary>(data.begin(), data.end());
-		return {};
+		mPendingHeader = frame.data() + offset;
+		mPendingHeaderSize = size;
+		return;
 	}
 
-	size_t index = 0;
-	size_t remaining = data.size();
-	while (remaining > 0) {
-		size_t obuCount = 1;
-		size_t metadataSize = payloadHeaderSize;
-
-		if (mSequenceHeader) {
-			obuCount++;
-			metadataSize += 1 + int(mSequenceHeader->size()); // 1 byte leb128
-		}
-
-		binary payload(std::min(size_t(mMaxFragmentSize), remaining + metadataSize));
-		size_t payloadOffset = payloadHeaderSize;
-
-		payload.at(0) = byte(obuCount) << wBitshift;
-
-		// Packetize cached SequenceHeader
-		if (obuCount == 2) {
-			payload.at(0) ^= nMask;
-			payload.at(1) = byte(mSequenceHeader->size() & sevenLsbBitmask);
-			payloadOffset += oneByteLeb128Size;
-
-			std::memcpy(payload.data() + payloadOffset, mSequenceHeader->data(),
-			            mSequenceHeader->size());
-			payloadOffset += int(mSequenceHeader->size());
-
-			mSequenceHeader = nullptr;
+	size_t pos = 0;
+	while (pos < size) {
+		Slice slice{offset + pos, 0};
+		slice.prefix[0] = byte(1) << wBitshift;
+		slice.prefixSize = payloadHeaderSize;
+
+		if (mPendingHeader) {
+			// Packetize cached sequence header as first OBU element, preceded by its length
+			// https://aomediacodec.github.io/av1-spec/#leb128
+			size_t lengthSize = 1;
+			while (lengthSize < 8 && (mPendingHeaderSize >> (7 * lengthSize)) > 0)
+				lengthSize++;
+
+			slice.prefix[0] |= nMask;
+			slice.insert = mPendingHeader;
+			slice.insertSize = mPendingHeaderSize;
+			if (payloadHeaderSize + lengthSize <= MaxSlicePrefixSize &&
+			    payloadHeaderSize + lengthSize + mPendingHeaderSize < maxSize) {
+				slice.prefix[0] = byte(2) << wBitshift | nMask;
+				for (size_t i = 0; i < lengthSize; i++) {
+					auto leb128_byte = uint8_t((mPendingHeaderSize >> (7 * i)) & sevenLsbBitmask);
+					if (i + 1 < lengthSize)
+						leb128_byte |= msbBitmask;
+
+					slice.prefix[payloadHeaderSize + i] = byte(leb128_byte);
+				}
+				slice.prefixSize += lengthSize;
+			} else {
+				// Does not fit with the OBU, send it alone
+				slices.push_back(slice);
+				slice = Slice{offset + pos, 0};
+				slice.prefix[0] = byte(1) << wBitshift;
+				slice.prefixSize = payloadHeaderSize;
+			}
+			mPendingHeader = nullptr;
+			mPendingHeaderSize = 0;
 		}
 
-		// Copy as much of OBU as possible into Payload
-		size_t payloadRemaining = payload.size() - payloadOffset;
-		std::memcpy(payload.data() + payloadOffset, data.data() + index,
-		            payloadRemaining);
-		remaining -= payloadRemaining;
-		index += payloadRemaining;
+		// Take as much of the OBU as possible
+		size_t available = maxSize - slice.prefixSize - slice.insertSize;
+		slice.size = std::min(available, size - pos);
+		pos += slice.size;
 
 		// Does this Fragment contain an OBU that started in a previous payload
-		if (payloads.size() > 0) {
-			payload.at(0) ^= zMask;
-		}
+		if (slice.offset > offset)
+			slice.prefix[0] |= zMask;
 
 		// This OBU will be continued in next Payload
-		if (index < data.size()) {
-			payload.at(0) ^= yMask;
-		}
+		if (pos < size)
+			slice.prefix[0] |= yMask;
 
-		payloads.push_back(std::move(payload));
+		slices.push_back(slice);
 	}
-
-	return payloads;
 }
 
 } // namespace rtc
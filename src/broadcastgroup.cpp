@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "broadcastgroup.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/messagepool.hpp"
+
+namespace rtc {
+
+BroadcastGroup::BroadcastGroup(shared_ptr<MediaHandler> packetizer)
+    : mPacketizer(std::move(packetizer)), mForwarder(std::make_shared<RtpForwarder>()) {
+	if (!mPacketizer)
+		throw std::invalid_argument("Broadcast group requires a packetizer");
+}
+
+void BroadcastGroup::addTrack(shared_ptr<Track> track, SSRC ssrc, optional<uint8_t> payloadType) {
+	if (!track)
+		throw std::invalid_argument("Broadcasting to a null track");
+
+	// The forwarder needs payload types for keyframe detection and clock rates
+	mForwarder->media(track->description());
+	mForwarder->addTrack(std::move(track), ssrc, payloadType);
+}
+
+void BroadcastGroup::removeTrack(const shared_ptr<Track> &track) { mForwarder->removeTrack(track); }
+
+size_t BroadcastGroup::trackCount() const { return mForwarder->trackCount(); }
+
+void BroadcastGroup::sendFrame(binary data, FrameInfo info) {
+	auto frameInfo = impl::MessagePool::Instance().makeFrameInfo(std::move(info));
+	send(make_message(std::move(data), std::move(frameInfo)));
+}
+
+void BroadcastGroup::sendFrame(const byte *data, size_t size, FrameInfo info) {
+	auto frameInfo = impl::MessagePool::Instance().makeFrameInfo(std::move(info));
+	send(make_message(data, data + size, std::move(frameInfo)));
+}
+
+void BroadcastGroup::setKeyframeCache(size_t maxSize) { mForwarder->setKeyframeCache(maxSize); }
+
+bool BroadcastGroup::hasCachedKeyframe() const { return mForwarder->hasCachedKeyframe(); }
+
+void BroadcastGroup::send(message_ptr frame) {
+	std::lock_guard lock(mSendMutex);
+	message_vector messages{std::move(frame)};
+
+	// Packets are generated once and shared by all tracks, sends of the packetizer are ignored
+	const message_callback discard = [](message_ptr) {};
+	mPacketizer->outgoingChain(messages, discard);
+	mForwarder->incoming(messages, discard);
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
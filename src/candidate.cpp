@@ -8,18 +8,21 @@
 
 #include "candidate.hpp"
 
+#include "impl/dnscache.hpp"
 #include "impl/internals.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cctype>
-#include <sstream>
+#include <charconv>
+#include <string_view>
 #include <unordered_map>
 
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #else
+#include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
@@ -29,23 +32,67 @@
 
 using std::array;
 using std::string;
+using std::string_view;
 
 namespace {
 
-inline bool match_prefix(const string &str, const string &prefix) {
+inline bool match_prefix(string_view str, string_view prefix) {
 	return str.size() >= prefix.size() &&
 	       std::mismatch(prefix.begin(), prefix.end(), str.begin()).first == prefix.end();
 }
 
-inline void trim_begin(string &str) {
-	str.erase(str.begin(),
-	          std::find_if(str.begin(), str.end(), [](char c) { return !std::isspace(c); }));
+inline bool is_space(char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+
+inline bool is_alpha(char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; }
+
+inline string_view trim(string_view str) {
+	while (!str.empty() && is_space(str.front()))
+		str.remove_prefix(1);
+	while (!str.empty() && is_space(str.back()))
+		str.remove_suffix(1);
+
+	return str;
+}
+
+// Returns the next whitespace-separated token and removes it from str
+inline string_view next_token(string_view &str) {
+	str = trim(str);
+	size_t end = 0;
+	while (end < str.size() && !is_space(str[end]))
+		++end;
+
+	string_view token = str.substr(0, end);
+	str.remove_prefix(end);
+	return token;
+}
+
+template <typename T> bool parse_integer(string_view str, T &result) {
+	auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), result);
+	return ec == std::errc() && !str.empty() && ptr == str.data() + str.size();
 }
 
-inline void trim_end(string &str) {
-	str.erase(
-	    std::find_if(str.rbegin(), str.rend(), [](char c) { return !std::isspace(c); }).base(),
-	    str.end());
+// Parses a numeric host without getaddrinfo(), which is costly even with AI_NUMERICHOST as
+// AI_ADDRCONFIG enumerates interfaces, and normalizes it. Returns the family or 0 on failure.
+int parse_numeric_host(const string &node, string &address) {
+	if (node.find('%') != string::npos)
+		return 0; // scoped IPv6 address, leave it to getaddrinfo()
+
+	char buffer[rtc::MAX_NUMERICNODE_LEN];
+	struct in_addr addr4;
+	if (inet_pton(AF_INET, node.c_str(), &addr4) == 1 &&
+	    inet_ntop(AF_INET, &addr4, buffer, sizeof(buffer))) {
+		address = buffer;
+		return AF_INET;
+	}
+
+	struct in6_addr addr6;
+	if (inet_pton(AF_INET6, node.c_str(), &addr6) == 1 &&
+	    inet_ntop(AF_INET6, &addr6, buffer, sizeof(buffer))) {
+		address = buffer;
+		return AF_INET6;
+	}
+
+	return 0;
 }
 
 } // namespace
@@ -70,8 +117,8 @@ Candidate::Candidate(string candidate, string mid) : Candidate() {
 }
 
 void Candidate::parse(string candidate) {
-	using TypeMap_t = std::unordered_map<string, Type>;
-	using TcpTypeMap_t = std::unordered_map<string, TransportType>;
+	using TypeMap_t = std::unordered_map<string_view, Type>;
+	using TcpTypeMap_t = std::unordered_map<string_view, TransportType>;
 
 	static const TypeMap_t TypeMap = {{"host", Type::Host},
 	                                  {"srflx", Type::ServerReflexive},
@@ -82,23 +129,33 @@ void Candidate::parse(string candidate) {
 	                                        {"passive", TransportType::TcpPassive},
 	                                        {"so", TransportType::TcpSo}};
 
-	const std::array prefixes{"a=", "candidate:"};
-	for (string prefix : prefixes)
-		if (match_prefix(candidate, prefix))
-			candidate.erase(0, prefix.size());
+	string_view str = candidate;
+	const std::array<string_view, 2> prefixes{"a=", "candidate:"};
+	for (string_view prefix : prefixes)
+		if (match_prefix(str, prefix))
+			str.remove_prefix(prefix.size());
 
-	PLOG_VERBOSE << "Parsing candidate: " << candidate;
+	PLOG_VERBOSE << "Parsing candidate: " << str;
 
 	// See RFC 8839 for format
-	std::istringstream iss(candidate);
-	string typ_;
-	if (!(iss >> mFoundation >> mComponent >> mTransportString >> mPriority &&
-	      iss >> mNode >> mService >> typ_ >> mTypeString && typ_ == "typ"))
+	string_view foundation = next_token(str);
+	string_view component = next_token(str);
+	string_view transport = next_token(str);
+	string_view priority = next_token(str);
+	string_view node = next_token(str);
+	string_view service = next_token(str);
+	string_view typ_ = next_token(str);
+	string_view type = next_token(str);
+	if (type.empty() || typ_ != "typ" || !parse_integer(component, mComponent) ||
+	    !parse_integer(priority, mPriority))
 		throw std::invalid_argument("Invalid candidate format");
 
-	std::getline(iss, mTail);
-	trim_begin(mTail);
-	trim_end(mTail);
+	mFoundation = foundation;
+	mTransportString = transport;
+	mNode = node;
+	mService = service;
+	mTypeString = type;
+	mTail = trim(str);
 
 	if (auto it = TypeMap.find(mTypeString); it != TypeMap.end())
 		mType = it->second;
@@ -109,9 +166,10 @@ void Candidate::parse(string candidate) {
 		mTransportType = TransportType::Udp;
 	} else if (mTransportString == "TCP" || mTransportString == "tcp") {
 		// Peek tail to find TCP type
-		std::istringstream tiss(mTail);
-		string tcptype_, tcptype;
-		if (tiss >> tcptype_ >> tcptype && tcptype_ == "tcptype") {
+		string_view tail = mTail;
+		string_view tcptype_ = next_token(tail);
+		string_view tcptype = next_token(tail);
+		if (tcptype_ == "tcptype" && !tcptype.empty()) {
 			if (auto it = TcpTypeMap.find(tcptype); it != TcpTypeMap.end())
 				mTransportType = it->second;
 			else
@@ -153,6 +211,37 @@ bool Candidate::resolve(ResolveMode mode) {
 	             << (mode == ResolveMode::Simple ? "simple" : "lookup") << "): " << mNode << ' '
 	             << mService;
 
+	// Fast path for numeric hosts and ports, which are the vast majority
+	uint16_t port = 0;
+	const bool numericService = parse_integer(string_view(mService), port);
+	if (numericService) {
+		if (int family = parse_numeric_host(mNode, mAddress)) {
+			mPort = port;
+			mFamily = family == AF_INET6 ? Family::Ipv6 : Family::Ipv4;
+			PLOG_VERBOSE << "Resolved candidate: " << mAddress << ' ' << mPort;
+			return true;
+		}
+
+		if (mode == ResolveMode::Lookup) {
+			// Hostnames, like mDNS ones, are resolved through the process-wide cache, so that
+			// concurrent and repeated lookups for the same host share a single resolution
+			const int socktype = mTransportType == TransportType::Udp ? SOCK_DGRAM : SOCK_STREAM;
+			auto addresses = impl::DnsCache::Instance().resolve(mNode, port, AF_UNSPEC, socktype);
+			if (!addresses.empty()) {
+				mAddress = addresses.front().node;
+				mPort = port;
+				mFamily = addresses.front().family == AF_INET6 ? Family::Ipv6 : Family::Ipv4;
+				PLOG_VERBOSE << "Resolved candidate: " << mAddress << ' ' << mPort;
+			}
+			return mFamily != Family::Unresolved;
+		}
+
+		// Hostnames need a lookup, other nodes might be legacy IPv4 forms or scoped IPv6
+		if (mNode.find(':') == string::npos &&
+		    std::any_of(mNode.begin(), mNode.end(), is_alpha))
+			return false;
+	}
+
 	// Try to resolve the node and service
 	struct addrinfo hints = {};
 	hints.ai_family = AF_UNSPEC;
@@ -204,28 +293,32 @@ uint32_t Candidate::priority() const { return mPriority; }
 
 string Candidate::candidate() const {
 	const char sp{' '};
-	std::ostringstream oss;
-	oss << "candidate:";
-	oss << mFoundation << sp << mComponent << sp << mTransportString << sp << mPriority << sp;
+	string str = "candidate:";
+	str.reserve(128);
+	str += mFoundation + sp + std::to_string(mComponent) + sp + mTransportString + sp +
+	       std::to_string(mPriority) + sp;
 	if (isResolved())
-		oss << mAddress << sp << mPort;
+		str += mAddress + sp + std::to_string(mPort);
 	else
-		oss << mNode << sp << mService;
+		str += mNode + sp + mService;
 
-	oss << sp << "typ" << sp << mTypeString;
+	str += sp;
+	str += "typ";
+	str += sp;
+	str += mTypeString;
 
-	if (!mTail.empty())
-		oss << sp << mTail;
+	if (!mTail.empty()) {
+		str += sp;
+		str += mTail;
+	}
 
-	return oss.str();
+	return str;
 }
 
 string Candidate::mid() const { return mMid.value_or("0"); }
 
 Candidate::operator string() const {
-	std::ostringstream line;
-	line << "a=" << candidate();
-	return line.str();
+	return "a=" + candidate();
 }
 
 bool Candidate::operator==(const Candidate &other) const {
@@ -9,175 +9,188 @@
 #include "rtc.h"
 #include "rtc.hpp"
 
+#include "impl/handletable.hpp"
 #include "impl/internals.hpp"
+#include "impl/lockfreequeue.hpp"
+#include "impl/logcounter.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <climits>
+#include <condition_variable>
 #include <exception>
 #include <mutex>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
 
 using namespace rtc;
 using namespace std::chrono_literals;
 using std::chrono::milliseconds;
 
+struct rtcMessageView {
+	shared_ptr<const Message> message;
+};
+
 namespace {
 
-std::unordered_map<int, shared_ptr<PeerConnection>> peerConnectionMap;
-std::unordered_map<int, shared_ptr<DataChannel>> dataChannelMap;
-std::unordered_map<int, shared_ptr<Track>> trackMap;
-#if RTC_ENABLE_MEDIA
-std::unordered_map<int, shared_ptr<RtcpSrReporter>> rtcpSrReporterMap;
-std::unordered_map<int, shared_ptr<RtpPacketizationConfig>> rtpConfigMap;
+// Object referenced by a C API handle, with its user pointer
+struct Handle {
+	Handle(shared_ptr<PeerConnection> ptr) : peerConnection(std::move(ptr)) {}
+	Handle(shared_ptr<DataChannel> ptr) : dataChannel(std::move(ptr)) {}
+	Handle(shared_ptr<Track> ptr) : track(std::move(ptr)) {}
+#if RTC_ENABLE_WEBSOCKET
+	Handle(shared_ptr<WebSocket> ptr) : webSocket(std::move(ptr)) {}
+	Handle(shared_ptr<WebSocketServer> ptr) : webSocketServer(std::move(ptr)) {}
 #endif
+
+	size_t count() const;
+
+	const shared_ptr<PeerConnection> peerConnection;
+	const shared_ptr<DataChannel> dataChannel;
+	const shared_ptr<Track> track;
 #if RTC_ENABLE_WEBSOCKET
-std::unordered_map<int, shared_ptr<WebSocket>> webSocketMap;
-std::unordered_map<int, shared_ptr<WebSocketServer>> webSocketServerMap;
+	const shared_ptr<WebSocket> webSocket;
+	const shared_ptr<WebSocketServer> webSocketServer;
 #endif
-std::unordered_map<int, void *> userPointerMap;
-std::mutex mutex;
-int lastId = 0;
+	std::atomic<void *> userPointer = nullptr;
+
+#if RTC_ENABLE_MEDIA
+	// Media objects are attached to a track after its creation
+	mutable std::mutex mediaMutex;
+	shared_ptr<RtcpSrReporter> rtcpSrReporter;
+	shared_ptr<RtpPacketizationConfig> rtpConfig;
+#endif
+};
+
+size_t Handle::count() const {
+	size_t count = 1;
+#if RTC_ENABLE_MEDIA
+	std::lock_guard lock(mediaMutex);
+	count += (rtcpSrReporter ? 1 : 0) + (rtpConfig ? 1 : 0);
+#endif
+	return count;
+}
+
+// Lookups take no lock, as bindings call the C API with many handles from many threads
+impl::HandleTable<Handle> handleTable;
+
+template <typename T>
+shared_ptr<T> getHandleObject(int id, const shared_ptr<T> Handle::*member) {
+	auto handle = handleTable.get(id);
+	return handle ? (*handle).*member : nullptr;
+}
 
 optional<void *> getUserPointer(int id) {
-	std::lock_guard lock(mutex);
-	auto it = userPointerMap.find(id);
-	return it != userPointerMap.end() ? std::make_optional(it->second) : nullopt;
+	auto handle = handleTable.get(id);
+	return handle ? std::make_optional(handle->userPointer.load()) : nullopt;
 }
 
 void setUserPointer(int i, void *ptr) {
-	std::lock_guard lock(mutex);
-	userPointerMap[i] = ptr;
+	if (auto handle = handleTable.get(i))
+		handle->userPointer.store(ptr);
 }
 
 shared_ptr<PeerConnection> getPeerConnection(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = peerConnectionMap.find(id); it != peerConnectionMap.end())
-		return it->second;
+	if (auto ptr = getHandleObject(id, &Handle::peerConnection))
+		return ptr;
 	else
 		throw std::invalid_argument("PeerConnection ID does not exist");
 }
 
 shared_ptr<DataChannel> getDataChannel(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = dataChannelMap.find(id); it != dataChannelMap.end())
-		return it->second;
+	if (auto ptr = getHandleObject(id, &Handle::dataChannel))
+		return ptr;
 	else
 		throw std::invalid_argument("DataChannel ID does not exist");
 }
 
 shared_ptr<Track> getTrack(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = trackMap.find(id); it != trackMap.end())
-		return it->second;
+	if (auto ptr = getHandleObject(id, &Handle::track))
+		return ptr;
 	else
 		throw std::invalid_argument("Track ID does not exist");
 }
 
 int emplacePeerConnection(shared_ptr<PeerConnection> ptr) {
-	std::lock_guard lock(mutex);
-	int pc = ++lastId;
-	peerConnectionMap.emplace(std::make_pair(pc, ptr));
-	userPointerMap.emplace(std::make_pair(pc, nullptr));
-	return pc;
+	return handleTable.emplace(std::move(ptr));
 }
 
-int emplaceDataChannel(shared_ptr<DataChannel> ptr) {
-	std::lock_guard lock(mutex);
-	int dc = ++lastId;
-	dataChannelMap.emplace(std::make_pair(dc, ptr));
-	userPointerMap.emplace(std::make_pair(dc, nullptr));
-	return dc;
-}
+int emplaceDataChannel(shared_ptr<DataChannel> ptr) { return handleTable.emplace(std::move(ptr)); }
 
-int emplaceTrack(shared_ptr<Track> ptr) {
-	std::lock_guard lock(mutex);
-	int tr = ++lastId;
-	trackMap.emplace(std::make_pair(tr, ptr));
-	userPointerMap.emplace(std::make_pair(tr, nullptr));
-	return tr;
-}
+int emplaceTrack(shared_ptr<Track> ptr) { return handleTable.emplace(std::move(ptr)); }
 
 void erasePeerConnection(int pc) {
-	std::lock_guard lock(mutex);
-	if (peerConnectionMap.erase(pc) == 0)
+	auto handle = handleTable.get(pc);
+	if (!handle || !handle->peerConnection || !handleTable.erase(pc))
 		throw std::invalid_argument("Peer Connection ID does not exist");
-	userPointerMap.erase(pc);
 }
 
 void eraseDataChannel(int dc) {
-	std::lock_guard lock(mutex);
-	if (dataChannelMap.erase(dc) == 0)
+	auto handle = handleTable.get(dc);
+	if (!handle || !handle->dataChannel || !handleTable.erase(dc))
 		throw std::invalid_argument("Data Channel ID does not exist");
-	userPointerMap.erase(dc);
 }
 
 void eraseTrack(int tr) {
-	std::lock_guard lock(mutex);
-	if (trackMap.erase(tr) == 0)
+	auto handle = handleTable.get(tr);
+	if (!handle || !handle->track || !handleTable.erase(tr))
 		throw std::invalid_argument("Track ID does not exist");
-#if RTC_ENABLE_MEDIA
-	rtcpSrReporterMap.erase(tr);
-	rtpConfigMap.erase(tr);
-#endif
-	userPointerMap.erase(tr);
 }
 
 size_t eraseAll() {
-	std::lock_guard lock(mutex);
-	size_t count = dataChannelMap.size() + trackMap.size() + peerConnectionMap.size();
-	dataChannelMap.clear();
-	trackMap.clear();
-	peerConnectionMap.clear();
-#if RTC_ENABLE_MEDIA
-	count += rtcpSrReporterMap.size() + rtpConfigMap.size();
-	rtcpSrReporterMap.clear();
-	rtpConfigMap.clear();
-#endif
-#if RTC_ENABLE_WEBSOCKET
-	count += webSocketMap.size() + webSocketServerMap.size();
-	webSocketMap.clear();
-	webSocketServerMap.clear();
-#endif
-	userPointerMap.clear();
+	size_t count = 0;
+	for (const auto &handle : handleTable.clear())
+		count += handle->count();
+
 	return count;
 }
 
 shared_ptr<Channel> getChannel(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = dataChannelMap.find(id); it != dataChannelMap.end())
-		return it->second;
-	if (auto it = trackMap.find(id); it != trackMap.end())
-		return it->second;
+	if (auto handle = handleTable.get(id)) {
+		if (handle->dataChannel)
+			return handle->dataChannel;
+		if (handle->track)
+			return handle->track;
 #if RTC_ENABLE_WEBSOCKET
-	if (auto it = webSocketMap.find(id); it != webSocketMap.end())
-		return it->second;
+		if (handle->webSocket)
+			return handle->webSocket;
 #endif
+	}
 	throw std::invalid_argument("DataChannel, Track, or WebSocket ID does not exist");
 }
 
 void eraseChannel(int id) {
-	std::lock_guard lock(mutex);
-	if (dataChannelMap.erase(id) != 0) {
-		userPointerMap.erase(id);
-		return;
-	}
-	if (trackMap.erase(id) != 0) {
-		userPointerMap.erase(id);
-#if RTC_ENABLE_MEDIA
-		rtcpSrReporterMap.erase(id);
-		rtpConfigMap.erase(id);
+	auto handle = handleTable.get(id);
+	bool isChannel = handle && (handle->dataChannel || handle->track);
+#if RTC_ENABLE_WEBSOCKET
+	isChannel = isChannel || (handle && handle->webSocket);
 #endif
+	if (!isChannel || !handleTable.erase(id))
+		throw std::invalid_argument("DataChannel, Track, or WebSocket ID does not exist");
+}
+
+// Events of objects with events enabled are posted to a queue polled by the application
+const size_t EVENT_QUEUE_SIZE = 65536;
+impl::LockFreeQueue<rtcEvent> eventQueue(EVENT_QUEUE_SIZE);
+std::mutex eventMutex;
+std::condition_variable eventCondition;
+std::atomic<int> eventWaiters = 0;
+impl::LogCounter COUNTER_DROPPED_EVENTS("rtc_capi_dropped_events", plog::warning,
+                                        "Number of events dropped as the queue was full");
+
+void postEvent(rtcEventType type, int id, int value = 0) {
+	if (!eventQueue.push(rtcEvent{type, id, value})) {
+		COUNTER_DROPPED_EVENTS++;
 		return;
 	}
-#if RTC_ENABLE_WEBSOCKET
-	if (webSocketMap.erase(id) != 0) {
-		userPointerMap.erase(id);
-		return;
+
+	// Either the poller sees the event, or the event sees the poller waiting
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (eventWaiters.load() > 0) {
+		std::lock_guard lock(eventMutex);
+		eventCondition.notify_all();
 	}
-#endif
-	throw std::invalid_argument("DataChannel, Track, or WebSocket ID does not exist");
 }
 
 int copyAndReturn(string s, char *buffer, int size) {
@@ -214,6 +227,31 @@ template <typename T> int copyAndReturn(std::vector<T> b, T *buffer, int size) {
 	return int(b.size());
 }
 
+// Sends count messages, getMessage(i) returns data and size like the arguments of rtcSendMessage
+template <typename F> void sendMessages(shared_ptr<Channel> channel, int count, F getMessage) {
+	std::vector<message_variant> messages;
+	messages.reserve(size_t(std::max(count, 0)));
+	for (int i = 0; i < count; ++i) {
+		auto [data, size] = getMessage(i);
+		if (!data && size != 0)
+			throw std::invalid_argument("Unexpected null pointer for data");
+
+		if (size >= 0) {
+			auto b = reinterpret_cast<const byte *>(data);
+			messages.emplace_back(binary(b, b + size));
+		} else {
+			messages.emplace_back(string(data));
+		}
+	}
+
+	if (auto dataChannel = std::dynamic_pointer_cast<DataChannel>(channel)) {
+		dataChannel->sendMany(std::move(messages));
+	} else {
+		for (auto &message : messages)
+			channel->send(std::move(message));
+	}
+}
+
 template <typename F> int wrap(F func) {
 	try {
 		return int(func());
@@ -236,31 +274,37 @@ string lowercased(string str) {
 }
 
 shared_ptr<RtcpSrReporter> getRtcpSrReporter(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = rtcpSrReporterMap.find(id); it != rtcpSrReporterMap.end()) {
-		return it->second;
-	} else {
-		throw std::invalid_argument("RTCP SR reporter ID does not exist");
+	if (auto handle = handleTable.get(id)) {
+		std::lock_guard lock(handle->mediaMutex);
+		if (handle->rtcpSrReporter)
+			return handle->rtcpSrReporter;
 	}
+	throw std::invalid_argument("RTCP SR reporter ID does not exist");
 }
 
 void emplaceRtcpSrReporter(shared_ptr<RtcpSrReporter> ptr, int tr) {
-	std::lock_guard lock(mutex);
-	rtcpSrReporterMap.emplace(std::make_pair(tr, ptr));
+	if (auto handle = handleTable.get(tr)) {
+		std::lock_guard lock(handle->mediaMutex);
+		if (!handle->rtcpSrReporter)
+			handle->rtcpSrReporter = std::move(ptr);
+	}
 }
 
 shared_ptr<RtpPacketizationConfig> getRtpConfig(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = rtpConfigMap.find(id); it != rtpConfigMap.end()) {
-		return it->second;
-	} else {
-		throw std::invalid_argument("RTP configuration ID does not exist");
+	if (auto handle = handleTable.get(id)) {
+		std::lock_guard lock(handle->mediaMutex);
+		if (handle->rtpConfig)
+			return handle->rtpConfig;
 	}
+	throw std::invalid_argument("RTP configuration ID does not exist");
 }
 
 void emplaceRtpConfig(shared_ptr<RtpPacketizationConfig> ptr, int tr) {
-	std::lock_guard lock(mutex);
-	rtpConfigMap.emplace(std::make_pair(tr, ptr));
+	if (auto handle = handleTable.get(tr)) {
+		std::lock_guard lock(handle->mediaMutex);
+		if (!handle->rtpConfig)
+			handle->rtpConfig = std::move(ptr);
+	}
 }
 
 shared_ptr<RtpPacketizationConfig>
@@ -329,49 +373,35 @@ private:
 #if RTC_ENABLE_WEBSOCKET
 
 shared_ptr<WebSocket> getWebSocket(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = webSocketMap.find(id); it != webSocketMap.end())
-		return it->second;
+	if (auto ptr = getHandleObject(id, &Handle::webSocket))
+		return ptr;
 	else
 		throw std::invalid_argument("WebSocket ID does not exist");
 }
 
-int emplaceWebSocket(shared_ptr<WebSocket> ptr) {
-	std::lock_guard lock(mutex);
-	int ws = ++lastId;
-	webSocketMap.emplace(std::make_pair(ws, ptr));
-	userPointerMap.emplace(std::make_pair(ws, nullptr));
-	return ws;
-}
+int emplaceWebSocket(shared_ptr<WebSocket> ptr) { return handleTable.emplace(std::move(ptr)); }
 
 void eraseWebSocket(int ws) {
-	std::lock_guard lock(mutex);
-	if (webSocketMap.erase(ws) == 0)
+	auto handle = handleTable.get(ws);
+	if (!handle || !handle->webSocket || !handleTable.erase(ws))
 		throw std::invalid_argument("WebSocket ID does not exist");
-	userPointerMap.erase(ws);
 }
 
 shared_ptr<WebSocketServer> getWebSocketServer(int id) {
-	std::lock_guard lock(mutex);
-	if (auto it = webSocketServerMap.find(id); it != webSocketServerMap.end())
-		return it->second;
+	if (auto ptr = getHandleObject(id, &Handle::webSocketServer))
+		return ptr;
 	else
 		throw std::invalid_argument("WebSocketServer ID does not exist");
 }
 
 int emplaceWebSocketServer(shared_ptr<WebSocketServer> ptr) {
-	std::lock_guard lock(mutex);
-	int wsserver = ++lastId;
-	webSocketServerMap.emplace(std::make_pair(wsserver, ptr));
-	userPointerMap.emplace(std::make_pair(wsserver, nullptr));
-	return wsserver;
+	return handleTable.emplace(std::move(ptr));
 }
 
 void eraseWebSocketServer(int wsserver) {
-	std::lock_guard lock(mutex);
-	if (webSocketServerMap.erase(wsserver) == 0)
+	auto handle = handleTable.get(wsserver);
+	if (!handle || !handle->webSocketServer || !handleTable.erase(wsserver))
 		throw std::invalid_argument("WebSocketServer ID does not exist");
-	userPointerMap.erase(wsserver);
 }
 
 #endif
@@ -718,6 +748,14 @@ int rtcGetRemoteMaxMessageSize(int pc) {
 	});
 }
 
+int rtcGetMemoryUsage(int pc) {
+	return wrap([&] {
+		auto peerConnection = getPeerConnection(pc);
+		// Clamp so a large usage is not mistaken for an error code
+		return int(std::min(peerConnection->memoryUsage(), size_t(INT_MAX)));
+	});
+}
+
 int rtcSetOpenCallback(int id, rtcOpenCallbackFunc cb) {
 	return wrap([&] {
 		auto channel = getChannel(id);
@@ -796,6 +834,29 @@ int rtcSendMessage(int id, const char *data, int size) {
 	});
 }
 
+int rtcSendMessages(int id, const char *const *data, const int *sizes, int count) {
+	return wrap([&] {
+		if ((!data || !sizes) && count > 0)
+			throw std::invalid_argument("Unexpected null pointer for data or sizes");
+
+		sendMessages(getChannel(id), count,
+		             [&](int i) { return std::make_pair(data[i], sizes[i]); });
+		return RTC_ERR_SUCCESS;
+	});
+}
+
+int rtcSendMessageBuffers(int id, const rtcMessageBuffer *buffers, int count) {
+	return wrap([&] {
+		if (!buffers && count > 0)
+			throw std::invalid_argument("Unexpected null pointer for buffers");
+
+		sendMessages(getChannel(id), count, [&](int i) {
+			return std::make_pair(static_cast<const char *>(buffers[i].data), buffers[i].size);
+		});
+		return RTC_ERR_SUCCESS;
+	});
+}
+
 int rtcClose(int id) {
 	return wrap([&] {
 		auto channel = getChannel(id);
@@ -923,6 +984,144 @@ int rtcReceiveMessage(int id, char *buffer, int *size) {
 	});
 }
 
+int rtcReceiveMessages(int id, rtcMessageBuffer *buffers, int count) {
+	return wrap([&] {
+		auto channel = getChannel(id);
+
+		if (!buffers && count > 0)
+			throw std::invalid_argument("Unexpected null pointer for buffers");
+
+		// Messages are peeked without conversion, then copied once into the buffers
+		int received = 0;
+		while (received < count) {
+			auto message = channel->peekView();
+			if (!message)
+				break;
+
+			auto &buffer = buffers[received];
+			const bool isString = message->type == Message::String;
+			const int size = int(message->size());
+			const int required = isString ? size + 1 : size;
+			if (!buffer.data || std::abs(buffer.size) < required) {
+				if (received > 0)
+					break;
+
+				buffer.size = isString ? -required : required;
+				return int(RTC_ERR_TOO_SMALL);
+			}
+
+			auto data = reinterpret_cast<const char *>(message->data());
+			std::copy(data, data + size, buffer.data);
+			if (isString)
+				buffer.data[size] = '\0';
+
+			buffer.size = isString ? -required : required;
+			channel->receiveView(); // discard
+			++received;
+		}
+
+		return received > 0 || count == 0 ? received : int(RTC_ERR_NOT_AVAIL);
+	});
+}
+
+int rtcSetMessageViewCallback(int id, rtcMessageViewCallbackFunc cb) {
+	return wrap([&] {
+		auto channel = getChannel(id);
+		if (cb)
+			channel->onMessageView([id, cb](shared_ptr<const Message> message) {
+				if (auto ptr = getUserPointer(id))
+					cb(id, new rtcMessageView{std::move(message)}, *ptr);
+			});
+		else
+			channel->onMessageView(nullptr);
+		return RTC_ERR_SUCCESS;
+	});
+}
+
+int rtcReceiveMessageView(int id, rtcMessageView **view) {
+	return wrap([&] {
+		auto channel = getChannel(id);
+
+		if (!view)
+			throw std::invalid_argument("Unexpected null pointer for view");
+
+		auto message = channel->receiveView();
+		if (!message)
+			return RTC_ERR_NOT_AVAIL;
+
+		*view = new rtcMessageView{std::move(message)};
+		return RTC_ERR_SUCCESS;
+	});
+}
+
+const char *rtcGetMessageViewData(const rtcMessageView *view) {
+	return view ? reinterpret_cast<const char *>(view->message->data()) : nullptr;
+}
+
+int rtcGetMessageViewSize(const rtcMessageView *view) {
+	return view ? int(view->message->size()) : RTC_ERR_INVALID;
+}
+
+bool rtcIsMessageViewString(const rtcMessageView *view) {
+	return view && view->message->type == Message::String;
+}
+
+void rtcReleaseMessageView(rtcMessageView *view) { delete view; }
+
+rtcMessage *rtcCreateOpaqueMessage(void *data, int size) {
+	auto src = reinterpret_cast<std::byte *>(data);
+	binary buffer;
+	buffer.reserve(size_t(size) + DEFAULT_MEDIA_TAILROOM); // so it can be protected in place
+	buffer.assign(src, src + size);
+	auto msg = new Message(std::move(buffer));
+	// Downgrade the message pointer to the opaque rtcMessage* type
+	return reinterpret_cast<rtcMessage *>(msg);
+}
+
+void rtcDeleteOpaqueMessage(rtcMessage *msg) {
+	// Cast the opaque pointer back to it's true type before deleting
+	delete reinterpret_cast<Message *>(msg);
+}
+
+int rtcReceiveOpaqueMessage(int id, rtcMessage **msg) {
+	return wrap([&] {
+		auto channel = getChannel(id);
+
+		if (!msg)
+			throw std::invalid_argument("Unexpected null pointer for message");
+
+		auto next = channel->receive();
+		if (!next)
+			return RTC_ERR_NOT_AVAIL;
+
+		// Binary data is moved out of the received message, strings are copied once
+		auto message = std::visit( //
+		    overloaded{
+		        [](binary b) { return new Message(std::move(b)); },
+		        [](string s) {
+			        auto b = reinterpret_cast<const byte *>(s.data());
+			        return new Message(b, b + s.size(), Message::String);
+		        },
+		    },
+		    std::move(*next));
+
+		*msg = reinterpret_cast<rtcMessage *>(message);
+		return RTC_ERR_SUCCESS;
+	});
+}
+
+char *rtcGetOpaqueMessageData(rtcMessage *msg) {
+	return msg ? reinterpret_cast<char *>(reinterpret_cast<Message *>(msg)->data()) : nullptr;
+}
+
+int rtcGetOpaqueMessageSize(const rtcMessage *msg) {
+	return msg ? int(reinterpret_cast<const Message *>(msg)->size()) : RTC_ERR_INVALID;
+}
+
+bool rtcIsOpaqueMessageString(const rtcMessage *msg) {
+	return msg && reinterpret_cast<const Message *>(msg)->type == Message::String;
+}
+
 int rtcCreateDataChannel(int pc, const char *label) {
 	return rtcCreateDataChannelEx(pc, label, nullptr);
 }
@@ -1215,18 +1414,6 @@ void setSSRC(Description::Media *description, uint32_t ssrc, const char *_name,
 	description->addSSRC(ssrc, name, msid, trackID);
 }
 
-rtcMessage *rtcCreateOpaqueMessage(void *data, int size) {
-	auto src = reinterpret_cast<std::byte *>(data);
-	auto msg = new Message(src, src + size);
-	// Downgrade the message pointer to the opaque rtcMessage* type
-	return reinterpret_cast<rtcMessage *>(msg);
-}
-
-void rtcDeleteOpaqueMessage(rtcMessage *msg) {
-	// Cast the opaque pointer back to it's true type before deleting
-	delete reinterpret_cast<Message *>(msg);
-}
-
 int rtcSetMediaInterceptorCallback(int pc, rtcInterceptorCallbackFunc cb) {
 	return wrap([&] {
 		auto peerConnection = getPeerConnection(pc);
@@ -1506,11 +1693,11 @@ int rtcGetSsrcsForType(const char *mediaType, const char *sdp, uint32_t *buffer,
 	return wrap([&] {
 		auto type = lowercased(string(mediaType));
 		auto oldSDP = string(sdp);
-		auto description = Description(oldSDP, "unspec");
+		const auto description = Description(oldSDP, "unspec");
 		auto mediaCount = description.mediaCount();
 		for (int i = 0; i < mediaCount; i++) {
-			if (std::holds_alternative<Description::Media *>(description.media(i))) {
-				auto media = std::get<Description::Media *>(description.media(i));
+			if (std::holds_alternative<const Description::Media *>(description.media(i))) {
+				auto media = std::get<const Description::Media *>(description.media(i));
 				auto currentMediaType = lowercased(media->type());
 				if (currentMediaType == type) {
 					auto ssrcs = media->getSSRCs();
@@ -1687,6 +1874,142 @@ int rtcGetWebSocketServerPort(int wsserver) {
 
 #endif
 
+namespace {
+
+void enableChannelEvents(int id, shared_ptr<Channel> channel, bool enable) {
+	if (enable) {
+		channel->onOpen([id]() { postEvent(RTC_EVENT_OPEN, id); });
+		channel->onClosed([id]() { postEvent(RTC_EVENT_CLOSED, id); });
+		channel->onError([id](string error) {
+			PLOG_WARNING << "Error on channel " << id << ": " << error;
+			postEvent(RTC_EVENT_ERROR, id);
+		});
+		channel->onAvailable([id]() { postEvent(RTC_EVENT_AVAILABLE, id); });
+		channel->onBufferedAmountLow([id]() { postEvent(RTC_EVENT_BUFFERED_AMOUNT_LOW, id); });
+	} else {
+		channel->onOpen(nullptr);
+		channel->onClosed(nullptr);
+		channel->onError(nullptr);
+		channel->onAvailable(nullptr);
+		channel->onBufferedAmountLow(nullptr);
+	}
+}
+
+void enablePeerConnectionEvents(int pc, shared_ptr<PeerConnection> peerConnection, bool enable) {
+	if (!enable) {
+		peerConnection->onStateChange(nullptr);
+		peerConnection->onIceStateChange(nullptr);
+		peerConnection->onGatheringStateChange(nullptr);
+		peerConnection->onSignalingStateChange(nullptr);
+		peerConnection->onDataChannel(nullptr);
+		peerConnection->onTrack(nullptr);
+		return;
+	}
+
+	peerConnection->onStateChange([pc](PeerConnection::State state) {
+		postEvent(RTC_EVENT_STATE_CHANGE, pc, int(state));
+	});
+	peerConnection->onIceStateChange([pc](PeerConnection::IceState state) {
+		postEvent(RTC_EVENT_ICE_STATE_CHANGE, pc, int(state));
+	});
+	peerConnection->onGatheringStateChange([pc](PeerConnection::GatheringState state) {
+		postEvent(RTC_EVENT_GATHERING_STATE_CHANGE, pc, int(state));
+	});
+	peerConnection->onSignalingStateChange([pc](PeerConnection::SignalingState state) {
+		postEvent(RTC_EVENT_SIGNALING_STATE_CHANGE, pc, int(state));
+	});
+	peerConnection->onDataChannel([pc](shared_ptr<DataChannel> dataChannel) {
+		int dc = emplaceDataChannel(dataChannel);
+		if (auto ptr = getUserPointer(pc))
+			rtcSetUserPointer(dc, *ptr);
+
+		enableChannelEvents(dc, std::move(dataChannel), true);
+		postEvent(RTC_EVENT_DATA_CHANNEL, pc, dc);
+	});
+	peerConnection->onTrack([pc](shared_ptr<Track> track) {
+		int tr = emplaceTrack(track);
+		if (auto ptr = getUserPointer(pc))
+			rtcSetUserPointer(tr, *ptr);
+
+		enableChannelEvents(tr, std::move(track), true);
+		postEvent(RTC_EVENT_TRACK, pc, tr);
+	});
+}
+
+} // namespace
+
+int rtcEnableEvents(int id, bool enable) {
+	return wrap([&] {
+		auto handle = handleTable.get(id);
+		if (!handle)
+			throw std::invalid_argument("ID does not exist");
+
+		if (handle->peerConnection) {
+			enablePeerConnectionEvents(id, handle->peerConnection, enable);
+			return RTC_ERR_SUCCESS;
+		}
+
+#if RTC_ENABLE_WEBSOCKET
+		if (handle->webSocketServer) {
+			if (enable)
+				handle->webSocketServer->onClient([id](shared_ptr<WebSocket> webSocket) {
+					int ws = emplaceWebSocket(webSocket);
+					if (auto ptr = getUserPointer(id))
+						rtcSetUserPointer(ws, *ptr);
+
+					enableChannelEvents(ws, std::move(webSocket), true);
+					postEvent(RTC_EVENT_WEBSOCKET_CLIENT, id, ws);
+				});
+			else
+				handle->webSocketServer->onClient(nullptr);
+
+			return RTC_ERR_SUCCESS;
+		}
+#endif
+
+		enableChannelEvents(id, getChannel(id), enable);
+		return RTC_ERR_SUCCESS;
+	});
+}
+
+int rtcPollEvents(rtcEvent *events, int max, int timeout) {
+	return wrap([&] {
+		if (!events && max > 0)
+			throw std::invalid_argument("Unexpected null pointer for events");
+
+		auto drain = [&]() {
+			int count = 0;
+			while (count < max) {
+				auto event = eventQueue.pop();
+				if (!event)
+					break;
+
+				events[count++] = *event;
+			}
+			return count;
+		};
+
+		int count = drain();
+		if (count > 0 || timeout == 0 || max <= 0)
+			return count;
+
+		const auto deadline = std::chrono::steady_clock::now() + milliseconds(timeout);
+		const auto available = []() { return !eventQueue.empty(); };
+
+		++eventWaiters;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		std::unique_lock lock(eventMutex);
+		while ((count = drain()) == 0) {
+			if (timeout < 0)
+				eventCondition.wait(lock, available);
+			else if (!eventCondition.wait_until(lock, deadline, available))
+				break;
+		}
+		--eventWaiters;
+		return count;
+	});
+}
+
 int rtcSetThreadPoolSize(unsigned int count) {
 	return wrap([&] {
 		SetThreadPoolSize(count);
@@ -1743,6 +2066,32 @@ int rtcSetSctpSettings(const rtcSctpSettings *settings) {
 	});
 }
 
+int rtcSetAllocator(rtcAllocateFunc allocate, rtcReallocateFunc reallocate,
+                    rtcDeallocateFunc deallocate) {
+	return wrap([&] {
+		Allocator allocator;
+		allocator.allocate = allocate;
+		allocator.reallocate = reallocate;
+		allocator.deallocate = deallocate;
+		SetAllocator(allocator);
+		return RTC_ERR_SUCCESS;
+	});
+}
+
+int rtcGetMetrics(char *buffer, int size) {
+	return wrap([&] {
+		// See https://prometheus.io/docs/instrumenting/exposition_formats/
+		string text;
+		for (const auto &metric : GetMetrics()) {
+			string name = metric.name + "_total";
+			text += "# HELP " + name + " " + metric.description + "\n";
+			text += "# TYPE " + name + " counter\n";
+			text += name + " " + std::to_string(metric.value) + "\n";
+		}
+		return copyAndReturn(std::move(text), buffer, size);
+	});
+}
+
 void rtcPreload() {
 	try {
 		rtc::Preload();
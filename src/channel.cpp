@@ -30,6 +30,8 @@ void Channel::onError(std::function<void(string error)> callback) {
 }
 
 void Channel::onMessage(std::function<void(message_variant data)> callback) {
+	impl()->messagesCallback = nullptr;
+	impl()->messageViewCallback = nullptr;
 	impl()->messageCallback = callback;
 	impl()->flushPendingMessages();
 }
@@ -41,6 +43,30 @@ void Channel::onMessage(std::function<void(binary data)> binaryCallback,
 	});
 }
 
+void Channel::onMessageView(std::function<void(shared_ptr<const Message> message)> callback) {
+	impl()->messagesCallback = nullptr;
+	impl()->messageCallback = nullptr;
+	if (callback)
+		impl()->messageViewCallback = [callback](message_ptr message) { callback(message); };
+	else
+		impl()->messageViewCallback = nullptr;
+
+	impl()->flushPendingMessages();
+}
+
+void Channel::onMessageView(std::function<void(const byte *data, size_t size)> binaryCallback,
+                            std::function<void(string_view data)> stringCallback) {
+	onMessageView([binaryCallback, stringCallback](shared_ptr<const Message> message) {
+		if (message->type == Message::String) {
+			if (stringCallback)
+				stringCallback(
+				    string_view(reinterpret_cast<const char *>(message->data()), message->size()));
+		} else if (binaryCallback) {
+			binaryCallback(message->data(), message->size());
+		}
+	});
+}
+
 void Channel::onBufferedAmountLow(std::function<void()> callback) {
 	impl()->bufferedAmountLowCallback = callback;
 }
@@ -55,6 +81,16 @@ optional<message_variant> Channel::receive() { return impl()->receive(); }
 
 optional<message_variant> Channel::peek() { return impl()->peek(); }
 
+shared_ptr<const Message> Channel::receiveView() {
+	auto next = impl()->receiveMessage();
+	return next ? std::move(*next) : nullptr;
+}
+
+shared_ptr<const Message> Channel::peekView() {
+	auto next = impl()->peekMessage();
+	return next ? std::move(*next) : nullptr;
+}
+
 size_t Channel::availableAmount() const { return impl()->availableAmount(); }
 
 void Channel::onAvailable(std::function<void()> callback) { impl()->availableCallback = callback; }
@@ -22,6 +22,13 @@
 
 namespace rtc {
 
+namespace {
+
+// Smaller strings are cheaper to copy into a pooled message than to lend
+constexpr size_t LentStringThreshold = 4096;
+
+} // namespace
+
 DataChannel::DataChannel(impl_ptr<impl::DataChannel> impl)
     : CheshireCat<impl::DataChannel>(impl),
       Channel(std::dynamic_pointer_cast<impl::Channel>(impl)) {}
@@ -40,18 +47,67 @@ string DataChannel::protocol() const { return impl()->protocol(); }
 
 Reliability DataChannel::reliability() const { return impl()->reliability(); }
 
+uint16_t DataChannel::priority() const { return impl()->priority(); }
+
 bool DataChannel::isOpen(void) const { return impl()->isOpen(); }
 
 bool DataChannel::isClosed(void) const { return impl()->isClosed(); }
 
 size_t DataChannel::maxMessageSize() const { return impl()->maxMessageSize(); }
 
+DataChannelStats DataChannel::getStats() const { return impl()->stats(); }
+
 bool DataChannel::send(message_variant data) {
+	// A large string is moved through and lent to the transport instead of being copied into a
+	// message, as a message can't take over the storage of a string
+	if (auto str = std::get_if<string>(&data); str && str->size() >= LentStringThreshold) {
+		auto owned = std::make_shared<string>(std::move(*str));
+		auto bytes = reinterpret_cast<const byte *>(owned->data());
+		return impl()->outgoing(
+		    bytes, owned->size(), [owned]() mutable { owned.reset(); }, Message::String);
+	}
+
 	return impl()->outgoing(make_message(std::move(data)));
 }
 
 bool DataChannel::send(const byte *data, size_t size) {
-	return impl()->outgoing(std::make_shared<Message>(data, data + size, Message::Binary));
+	return impl()->outgoing(make_message(data, data + size, Message::Binary));
+}
+
+bool DataChannel::sendMany(std::vector<message_variant> messages) {
+	message_vector batch;
+	batch.reserve(messages.size());
+	for (auto &data : messages)
+		batch.push_back(make_message(std::move(data)));
+
+	return impl()->outgoing(std::move(batch));
+}
+
+void DataChannel::sendAsync(message_variant data,
+                            std::function<void(std::exception_ptr error)> callback) {
+	impl()->outgoingAsync(make_message(std::move(data)), std::move(callback));
+}
+
+std::future<void> DataChannel::sendAsync(message_variant data) {
+	auto promise = std::make_shared<std::promise<void>>();
+	auto future = promise->get_future();
+	sendAsync(std::move(data), [promise](std::exception_ptr error) {
+		if (error)
+			promise->set_exception(error);
+		else
+			promise->set_value();
+	});
+	return future;
+}
+
+void DataChannel::setBufferedAmountHighThreshold(size_t amount) {
+	impl()->bufferedAmountHighThreshold = amount;
+}
+
+void DataChannel::setMaxAvailableAmount(size_t amount) { impl()->setMaxAvailableAmount(amount); }
+
+bool DataChannel::send(const byte *data, size_t size, std::function<void()> release) {
+	return impl()->outgoing(data, size, std::move(release));
 }
 
 } // namespace rtc
@@ -60,6 +60,10 @@ bool BitWriter::write(uint64_t v, size_t bits) {
 		mOffset += 8;
 	}
 
+	if (bits == 0) {
+		return true;
+	}
+
 	// Write the remaining bits
 	written_bits = writePartialByte(p, 0, v, bits);
 	bits -= written_bits;
@@ -126,6 +130,75 @@ size_t BitWriter::writePartialByte(uint8_t *p, size_t offset, uint64_t v, size_t
 	return need_write_bits;
 }
 
+BitReader BitReader::fromSizeBits(const byte *buf, size_t offsetBits, size_t sizeBits) {
+	BitReader reader;
+	reader.mBuf = buf;
+	reader.mInitialOffset = offsetBits;
+	reader.mOffset = offsetBits;
+	reader.mSize = sizeBits;
+	return reader;
+}
+
+size_t BitReader::getReadBits() const { return mOffset - mInitialOffset; }
+
+bool BitReader::read(uint64_t &v, size_t bits) {
+	if (bits > 64 || mOffset + bits > mSize) {
+		return false;
+	}
+	v = 0;
+	while (bits > 0) {
+		// Read up to the 8-bit boundary at a time
+		const uint8_t b = std::to_integer<uint8_t>(mBuf[mOffset / 8]);
+		const size_t offset = mOffset % 8;
+		const size_t count = std::min(8 - offset, bits);
+		const uint8_t mask = static_cast<uint8_t>((1 << count) - 1);
+		v = (v << count) | ((b >> (8 - offset - count)) & mask);
+		bits -= count;
+		mOffset += count;
+	}
+	return true;
+}
+
+bool BitReader::readNonSymmetric(uint64_t &v, uint64_t n) {
+	if (n <= 1) {
+		v = 0;
+		return true;
+	}
+	size_t w = 0;
+	uint64_t x = n;
+	while (x != 0) {
+		x = x >> 1;
+		w++;
+	}
+	uint64_t m = (1ULL << w) - n;
+	if (!read(v, w - 1)) {
+		return false;
+	}
+	if (v < m) {
+		return true;
+	}
+	uint64_t extraBit;
+	if (!read(extraBit, 1)) {
+		return false;
+	}
+	v = (v << 1) - m + extraBit;
+	return true;
+}
+
+std::pair<int, int> FrameDependencyStructure::decodeTargetLayers(int decodeTarget) const {
+	int spatialId = 0;
+	int temporalId = 0;
+	for (const auto &frameTemplate : templates) {
+		if (size_t(decodeTarget) < frameTemplate.decodeTargetIndications.size() &&
+		    frameTemplate.decodeTargetIndications[decodeTarget] !=
+		        DecodeTargetIndication::NotPresent) {
+			spatialId = std::max(spatialId, frameTemplate.spatialId);
+			temporalId = std::max(temporalId, frameTemplate.temporalId);
+		}
+	}
+	return std::make_pair(spatialId, temporalId);
+}
+
 using TemplateIterator = std::vector<FrameDependencyTemplate>::const_iterator;
 
 struct TemplateMatch {
@@ -406,4 +479,180 @@ void DependencyDescriptorWriter::writeNonSymmetric(BitWriter &writer, uint64_t v
 	}
 }
 
+DependencyDescriptorReader::DependencyDescriptorReader(const byte *buf, size_t sizeBytes)
+    : mBuf(buf), mSize(sizeBytes) {}
+
+void DependencyDescriptorReader::readTo(DependencyDescriptorContext &context) const {
+	auto r = BitReader::fromSizeBits(mBuf, 0, mSize * 8);
+	DependencyDescriptor descriptor;
+
+	// mandatory_descriptor_fields()
+	descriptor.startOfFrame = readBits(r, 1) != 0;
+	descriptor.endOfFrame = readBits(r, 1) != 0;
+	const uint32_t templateId = static_cast<uint32_t>(readBits(r, 6));
+	descriptor.frameNumber = static_cast<int>(readBits(r, 16));
+
+	bool activeDecodeTargetsPresentFlag = false;
+	bool customDtisFlag = false;
+	bool customFdiffsFlag = false;
+	bool customChainsFlag = false;
+	descriptor.structureAttached = false;
+	if (mSize > 3) {
+		// extended_descriptor_fields()
+		descriptor.structureAttached = readBits(r, 1) != 0;
+		activeDecodeTargetsPresentFlag = readBits(r, 1) != 0;
+		customDtisFlag = readBits(r, 1) != 0;
+		customFdiffsFlag = readBits(r, 1) != 0;
+		customChainsFlag = readBits(r, 1) != 0;
+	}
+
+	// The structure is only replaced once the whole descriptor is valid
+	FrameDependencyStructure attached;
+	if (descriptor.structureAttached) {
+		readStructure(r, attached);
+		descriptor.activeDecodeTargetsBitmask = (1ULL << attached.decodeTargetCount) - 1;
+	}
+	const auto &structure = descriptor.structureAttached ? attached : context.structure;
+	if (structure.templates.empty()) {
+		throw std::invalid_argument("Dependency descriptor without template dependency structure");
+	}
+	if (activeDecodeTargetsPresentFlag) {
+		descriptor.activeDecodeTargetsBitmask =
+		    static_cast<uint32_t>(readBits(r, structure.decodeTargetCount));
+	}
+
+	// frame_dependency_definition()
+	const size_t templateIndex =
+	    (templateId + MaxTemplates - structure.templateIdOffset) % MaxTemplates;
+	if (templateIndex >= structure.templates.size()) {
+		throw std::invalid_argument("Invalid dependency descriptor template id");
+	}
+	descriptor.dependencyTemplate = structure.templates[templateIndex];
+	auto &frameTemplate = descriptor.dependencyTemplate;
+	if (customDtisFlag) {
+		// frame_dtis()
+		for (auto &dti : frameTemplate.decodeTargetIndications) {
+			dti = static_cast<DecodeTargetIndication>(readBits(r, 2));
+		}
+	}
+	if (customFdiffsFlag) {
+		// frame_fdiffs()
+		frameTemplate.frameDiffs.clear();
+		while (size_t fdiffSize = readBits(r, 2)) {
+			frameTemplate.frameDiffs.push_back(static_cast<int>(readBits(r, 4 * fdiffSize)) + 1);
+		}
+	}
+	if (customChainsFlag) {
+		// frame_chains()
+		for (auto &chainDiff : frameTemplate.chainDiffs) {
+			chainDiff = static_cast<int>(readBits(r, 8));
+		}
+	}
+	if (!structure.resolutions.empty() &&
+	    static_cast<size_t>(frameTemplate.spatialId) < structure.resolutions.size()) {
+		descriptor.resolution = structure.resolutions[frameTemplate.spatialId];
+	}
+
+	if (descriptor.structureAttached) {
+		context.structure = std::move(attached);
+	}
+	if (descriptor.activeDecodeTargetsBitmask) {
+		// A chain is active if it protects an active decode target
+		context.activeChains.reset();
+		for (int dt = 0; dt < context.structure.decodeTargetCount; ++dt) {
+			if ((*descriptor.activeDecodeTargetsBitmask & (1u << dt)) &&
+			    static_cast<size_t>(dt) < context.structure.decodeTargetProtectedBy.size()) {
+				context.activeChains.set(context.structure.decodeTargetProtectedBy[dt]);
+			}
+		}
+	}
+	context.descriptor = std::move(descriptor);
+}
+
+void DependencyDescriptorReader::readStructure(BitReader &r,
+                                               FrameDependencyStructure &structure) const {
+	// template_dependency_structure()
+	structure.templateIdOffset = static_cast<int>(readBits(r, 6));
+	structure.decodeTargetCount = static_cast<int>(readBits(r, 5)) + 1;
+
+	// template_layers()
+	int spatialId = 0;
+	int temporalId = 0;
+	uint64_t nextLayerIdc;
+	do {
+		if (structure.templates.size() >= MaxTemplates) {
+			throw std::invalid_argument("Too many dependency descriptor templates");
+		}
+		FrameDependencyTemplate frameTemplate;
+		frameTemplate.spatialId = spatialId;
+		frameTemplate.temporalId = temporalId;
+		structure.templates.push_back(std::move(frameTemplate));
+
+		nextLayerIdc = readBits(r, 2);
+		if (nextLayerIdc == 1) {
+			// next temporal
+			temporalId++;
+		} else if (nextLayerIdc == 2) {
+			// new spatial
+			temporalId = 0;
+			spatialId++;
+		}
+	} while (nextLayerIdc != 3);
+
+	// template_dtis()
+	for (auto &frameTemplate : structure.templates) {
+		frameTemplate.decodeTargetIndications.resize(structure.decodeTargetCount);
+		for (auto &dti : frameTemplate.decodeTargetIndications) {
+			dti = static_cast<DecodeTargetIndication>(readBits(r, 2));
+		}
+	}
+
+	// template_fdiffs()
+	for (auto &frameTemplate : structure.templates) {
+		while (readBits(r, 1)) {
+			frameTemplate.frameDiffs.push_back(static_cast<int>(readBits(r, 4)) + 1);
+		}
+	}
+
+	// template_chains()
+	structure.chainCount = static_cast<int>(readNonSymmetric(r, structure.decodeTargetCount + 1));
+	if (structure.chainCount != 0) {
+		for (int i = 0; i < structure.decodeTargetCount; ++i) {
+			structure.decodeTargetProtectedBy.push_back(
+			    static_cast<int>(readNonSymmetric(r, structure.chainCount)));
+		}
+		for (auto &frameTemplate : structure.templates) {
+			for (int i = 0; i < structure.chainCount; ++i) {
+				frameTemplate.chainDiffs.push_back(static_cast<int>(readBits(r, 4)));
+			}
+		}
+	}
+
+	if (readBits(r, 1)) {
+		// render_resolutions()
+		for (int i = 0; i <= spatialId; ++i) {
+			RenderResolution resolution;
+			resolution.width = static_cast<int>(readBits(r, 16)) + 1;
+			resolution.height = static_cast<int>(readBits(r, 16)) + 1;
+			structure.resolutions.push_back(resolution);
+		}
+	}
+}
+
+uint64_t DependencyDescriptorReader::readBits(BitReader &reader, size_t bits) const {
+	uint64_t v;
+	if (!reader.read(v, bits)) {
+		throw std::invalid_argument("Dependency descriptor is truncated");
+	}
+	return v;
+}
+
+uint64_t DependencyDescriptorReader::readNonSymmetric(BitReader &reader, uint64_t n) const {
+	uint64_t v;
+	if (!reader.readNonSymmetric(v, n)) {
+		throw std::invalid_argument("Dependency descriptor is truncated");
+	}
+	return v;
+}
+
 } // namespace rtc
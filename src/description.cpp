@@ -15,10 +15,14 @@
 #include <algorithm>
 #include <array>
 #include <cctype>
+#include <charconv>
 #include <chrono>
 #include <iostream>
+#include <mutex>
 #include <random>
-#include <sstream>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 
 using std::chrono::system_clock;
@@ -33,17 +37,41 @@ inline bool match_prefix(string_view str, string_view prefix) {
 	       std::mismatch(prefix.begin(), prefix.end(), str.begin()).first == prefix.end();
 }
 
-inline void trim_end(string &str) {
-	str.erase(
-	    std::find_if(str.rbegin(), str.rend(), [](char c) { return !std::isspace(c); }).base(),
-	    str.end());
+inline string_view trim_end(string_view str) {
+	while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back())))
+		str.remove_suffix(1);
+
+	return str;
 }
 
-inline string get_first_line(const string &str) {
-	string line;
-	std::istringstream ss(str);
-	std::getline(ss, line);
-	return line;
+// Calls func for every non-empty line, with trailing whitespace removed
+template <typename F> void for_each_line(string_view str, F func) {
+	while (!str.empty()) {
+		size_t end = str.find('\n');
+		string_view line = trim_end(str.substr(0, end));
+		str = end != string_view::npos ? str.substr(end + 1) : string_view();
+		if (!line.empty())
+			func(line);
+	}
+}
+
+inline string_view get_first_line(string_view str) {
+	return trim_end(str.substr(0, str.find('\n')));
+}
+
+// Returns the next whitespace-separated token and removes it from str
+inline string_view next_token(string_view &str) {
+	size_t begin = 0;
+	while (begin < str.size() && std::isspace(static_cast<unsigned char>(str[begin])))
+		++begin;
+
+	size_t end = begin;
+	while (end < str.size() && !std::isspace(static_cast<unsigned char>(str[end])))
+		++end;
+
+	string_view token = str.substr(begin, end - begin);
+	str.remove_prefix(end);
+	return token;
 }
 
 inline std::pair<string_view, string_view> parse_pair(string_view attr) {
@@ -58,14 +86,142 @@ inline std::pair<string_view, string_view> parse_pair(string_view attr) {
 }
 
 template <typename T> T to_integer(string_view s) {
-	const string str(s);
-	try {
-		return std::is_signed<T>::value ? T(std::stol(str)) : T(std::stoul(str));
-	} catch (...) {
-		throw std::invalid_argument("Invalid integer \"" + str + "\" in description");
+	// Leading whitespace and trailing characters are ignored
+	size_t begin = 0;
+	while (begin < s.size() && std::isspace(static_cast<unsigned char>(s[begin])))
+		++begin;
+
+	if (begin < s.size() && s[begin] == '+')
+		++begin;
+
+	T result = 0;
+	auto [ptr, ec] = std::from_chars(s.data() + begin, s.data() + s.size(), result);
+	if (ec != std::errc() || ptr == s.data() + begin)
+		throw std::invalid_argument("Invalid integer \"" + string(s) + "\" in description");
+
+	return result;
+}
+
+// Attribute keys known by parsers, interned so that they dispatch on the key with a single lookup
+enum class AttributeKey {
+	Unknown,
+	Setup,
+	Fingerprint,
+	IceUfrag,
+	IcePwd,
+	IceOptions,
+	Candidate,
+	EndOfCandidates,
+	Mid,
+	ExtMap,
+	SendOnly,
+	RecvOnly,
+	SendRecv,
+	Inactive,
+	BundleOnly,
+	SctpPort,
+	MaxMessageSize,
+	RtpMap,
+	RtcpFb,
+	Fmtp,
+	RtcpMux,
+	Ssrc,
+};
+
+AttributeKey intern_key(string_view key) {
+	static const std::unordered_map<string_view, AttributeKey> keys = {
+	    {"setup", AttributeKey::Setup},
+	    {"fingerprint", AttributeKey::Fingerprint},
+	    {"ice-ufrag", AttributeKey::IceUfrag},
+	    {"ice-pwd", AttributeKey::IcePwd},
+	    {"ice-options", AttributeKey::IceOptions},
+	    {"candidate", AttributeKey::Candidate},
+	    {"end-of-candidates", AttributeKey::EndOfCandidates},
+	    {"mid", AttributeKey::Mid},
+	    {"extmap", AttributeKey::ExtMap},
+	    {"sendonly", AttributeKey::SendOnly},
+	    {"recvonly", AttributeKey::RecvOnly},
+	    {"sendrecv", AttributeKey::SendRecv},
+	    {"inactive", AttributeKey::Inactive},
+	    {"bundle-only", AttributeKey::BundleOnly},
+	    {"sctp-port", AttributeKey::SctpPort},
+	    {"max-message-size", AttributeKey::MaxMessageSize},
+	    {"rtpmap", AttributeKey::RtpMap},
+	    {"rtcp-fb", AttributeKey::RtcpFb},
+	    {"fmtp", AttributeKey::Fmtp},
+	    {"rtcp-mux", AttributeKey::RtcpMux},
+	    {"ssrc", AttributeKey::Ssrc},
+	};
+	auto it = keys.find(key);
+	return it != keys.end() ? it->second : AttributeKey::Unknown;
+}
+
+// Attribute line "a=<key>[:<value>]" split in place
+struct Attribute {
+	string_view attr; // without "a="
+	string_view key;
+	string_view value;
+	AttributeKey id = AttributeKey::Unknown;
+};
+
+inline std::optional<Attribute> parse_attribute(string_view line) {
+	if (!match_prefix(line, "a="))
+		return std::nullopt;
+
+	Attribute attribute;
+	attribute.attr = line.substr(2);
+	std::tie(attribute.key, attribute.value) = parse_pair(attribute.attr);
+	attribute.id = intern_key(attribute.key);
+	return attribute;
+}
+
+inline string_view to_sdp(rtc::Description::Direction direction) {
+	using Direction = rtc::Description::Direction;
+	switch (direction) {
+	case Direction::RecvOnly:
+		return "recvonly";
+	case Direction::SendOnly:
+		return "sendonly";
+	case Direction::SendRecv:
+		return "sendrecv";
+	case Direction::Inactive:
+		return "inactive";
+	case Direction::Unknown:
+	default:
+		return "unknown";
+	}
+}
+
+inline string_view to_sdp(rtc::Description::Role role) {
+	using Role = rtc::Description::Role;
+	switch (role) {
+	case Role::Active:
+		return "active";
+	case Role::Passive:
+		return "passive";
+	default:
+		return "actpass";
 	}
 }
 
+// Appends pieces to an SDP string, avoiding the formatting machinery of streams
+template <typename... Args> void append(string &sdp, Args &&...args) {
+	auto piece = [&sdp](const auto &arg) {
+		using T = std::decay_t<decltype(arg)>;
+		if constexpr (std::is_same_v<T, char>)
+			sdp += arg;
+		else if constexpr (std::is_integral_v<T>)
+			sdp += std::to_string(arg);
+		else
+			sdp += arg;
+	};
+	(piece(args), ...);
+}
+
+inline size_t hash_combine(size_t seed, string_view str) {
+	return seed ^ (std::hash<string_view>()(str) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
 } // namespace
 
 namespace rtc {
@@ -78,26 +234,27 @@ Description::Description(const string &sdp, Type type, Role role)
 
 	int index = -1;
 	shared_ptr<Entry> current;
-	std::istringstream ss(sdp);
-	while (ss) {
-		string line;
-		std::getline(ss, line);
-		trim_end(line);
-		if (line.empty())
-			continue;
-
+	std::vector<std::pair<const Entry *, size_t>> hashes; // lines parsed by each entry
+	auto parseEntryLine = [&](string_view line) {
+		current->parseSdpLine(line);
+		hashes.back().second = hash_combine(hashes.back().second, line);
+	};
+	for_each_line(sdp, [&](string_view line) {
 		if (match_prefix(line, "m=")) { // Media description line (aka m-line)
-			current = createEntry(line.substr(2), std::to_string(++index), Direction::Unknown);
+			auto mid = std::to_string(++index);
+			hashes.emplace_back(nullptr, hash_combine(hash_combine(0, mid), line));
+			current = createEntry(string(line.substr(2)), std::move(mid), Direction::Unknown);
+			hashes.back().first = current.get();
 
 		} else if (match_prefix(line, "o=")) { // Origin line
-			std::istringstream origin(line.substr(2));
-			origin >> mUsername >> mSessionId;
+			string_view origin = line.substr(2);
+			mUsername = next_token(origin);
+			mSessionId = next_token(origin);
 
-		} else if (match_prefix(line, "a=")) { // Attribute line
-			string attr = line.substr(2);
-			auto [key, value] = parse_pair(attr);
+		} else if (auto attribute = parse_attribute(line)) { // Attribute line
+			const auto &[attr, key, value, id] = *attribute;
 
-			if (key == "setup") {
+			if (id == AttributeKey::Setup) {
 				if (value == "active")
 					mRole = Role::Active;
 				else if (value == "passive")
@@ -105,7 +262,7 @@ Description::Description(const string &sdp, Type type, Role role)
 				else
 					mRole = Role::ActPass;
 
-			} else if (key == "fingerprint") {
+			} else if (id == AttributeKey::Fingerprint) {
 				// RFC 8122: The fingerprint attribute may be either a session-level or a
 				// media-level SDP attribute. If it is a session-level attribute, it applies to all
 				// TLS sessions for which no media-level fingerprint attribute is defined.
@@ -113,7 +270,7 @@ Description::Description(const string &sdp, Type type, Role role)
 					auto fingerprintExploded = utils::explode(string(value), ' ');
 					if (fingerprintExploded.size() != 2) {
 						PLOG_WARNING << "Unknown SDP fingerprint format: " << value;
-						continue;
+						return;
 					}
 
 					auto first = fingerprintExploded.at(0);
@@ -141,36 +298,46 @@ Description::Description(const string &sdp, Type type, Role role)
 						PLOG_WARNING << "Unknown certificate fingerprint algorithm: " << first;
 					}
 				}
-			} else if (key == "ice-ufrag") {
+			} else if (id == AttributeKey::IceUfrag) {
 				// RFC 8839: The "ice-pwd" and "ice-ufrag" attributes can appear at either the
 				// session-level or media-level. When present in both, the value in the media-level
 				// takes precedence.
 				if (!mIceUfrag || index == 0) // media-level for first media overrides session-level
 					mIceUfrag = value;
-			} else if (key == "ice-pwd") {
+			} else if (id == AttributeKey::IcePwd) {
 				// RFC 8839: The "ice-pwd" and "ice-ufrag" attributes can appear at either the
 				// session-level or media-level. When present in both, the value in the media-level
 				// takes precedence.
 				if (!mIcePwd || index == 0) // media-level for first media overrides session-level
 					mIcePwd = value;
-			} else if (key == "ice-options") {
+			} else if (id == AttributeKey::IceOptions) {
 				// RFC 8839: The "ice-options" attribute is a session-level and media-level
 				// attribute.
 				if (mIceOptions.empty())
 					mIceOptions = utils::explode(string(value), ',');
-			} else if (key == "candidate") {
-				addCandidate(Candidate(attr, bundleMid()));
-			} else if (key == "end-of-candidates") {
+			} else if (id == AttributeKey::Candidate) {
+				addCandidate(Candidate(string(attr), bundleMid()));
+			} else if (id == AttributeKey::EndOfCandidates) {
 				mEnded = true;
 			} else if (current) {
-				current->parseSdpLine(std::move(line));
+				parseEntryLine(line);
 			} else {
 				mAttributes.emplace_back(attr);
 			}
 
 		} else if (current) {
-			current->parseSdpLine(std::move(line));
+			parseEntryLine(line);
 		}
+	});
+
+	// Share entries with identical ones from other descriptions, as peers typically negotiate the
+	// same media with the same codecs and extensions
+	current.reset();
+	for (int i = 0; i < int(mEntries.size()); ++i) {
+		auto it = std::find_if(hashes.begin(), hashes.end(),
+		                       [&](const auto &h) { return h.first == mEntries[i].get(); });
+		if (it != hashes.end())
+			intern(i, it->second);
 	}
 
 	if (mUsername.empty())
@@ -286,44 +453,45 @@ void Description::endCandidates() { mEnded = true; }
 Description::operator string() const { return generateSdp("\r\n"); }
 
 string Description::generateSdp(string_view eol) const {
-	std::ostringstream sdp;
+	string sdp;
+	sdp.reserve(2048);
 
 	// Header
-	sdp << "v=0" << eol;
-	sdp << "o=" << mUsername << " " << mSessionId << " 0 IN IP4 127.0.0.1" << eol;
-	sdp << "s=-" << eol;
-	sdp << "t=0 0" << eol;
+	append(sdp, "v=0", eol);
+	append(sdp, "o=", mUsername, ' ', mSessionId, " 0 IN IP4 127.0.0.1", eol);
+	append(sdp, "s=-", eol);
+	append(sdp, "t=0 0", eol);
 
 	// BUNDLE (RFC 8843 Negotiating Media Multiplexing Using the Session Description Protocol)
 	// https://www.rfc-editor.org/rfc/rfc8843.html
-	std::ostringstream bundleGroup;
+	string bundleGroup;
 	for (const auto &entry : mEntries)
 		if (!entry->isRemoved())
-			bundleGroup << ' ' << entry->mid();
+			append(bundleGroup, ' ', entry->mid());
 
-	if (!bundleGroup.str().empty())
-		sdp << "a=group:BUNDLE" << bundleGroup.str() << eol;
+	if (!bundleGroup.empty())
+		append(sdp, "a=group:BUNDLE", bundleGroup, eol);
 
 	// Lip-sync
-	std::ostringstream lsGroup;
+	string lsGroup;
 	for (const auto &entry : mEntries)
 		if (!entry->isRemoved() && entry != mApplication)
-			lsGroup << ' ' << entry->mid();
+			append(lsGroup, ' ', entry->mid());
 
-	if (!lsGroup.str().empty())
-		sdp << "a=group:LS" << lsGroup.str() << eol;
+	if (!lsGroup.empty())
+		append(sdp, "a=group:LS", lsGroup, eol);
 
 	// Session-level attributes
-	sdp << "a=msid-semantic:WMS *" << eol;
+	append(sdp, "a=msid-semantic:WMS *", eol);
 	if (!mIceOptions.empty())
-		sdp << "a=ice-options:" << utils::implode(mIceOptions, ',') << eol;
+		append(sdp, "a=ice-options:", utils::implode(mIceOptions, ','), eol);
 	if (mFingerprint)
-		sdp << "a=fingerprint:"
-		    << CertificateFingerprint::AlgorithmIdentifier(mFingerprint->algorithm) << " "
-		    << mFingerprint->value << eol;
+		append(sdp, "a=fingerprint:",
+		       CertificateFingerprint::AlgorithmIdentifier(mFingerprint->algorithm), ' ',
+		       mFingerprint->value, eol);
 
 	for (const auto &attr : mAttributes)
-		sdp << "a=" << attr << eol;
+		append(sdp, "a=", attr, eol);
 
 	auto cand = defaultCandidate();
 	const string addr = cand && cand->isResolved()
@@ -336,37 +504,38 @@ string Description::generateSdp(string_view eol) const {
 	// Entries
 	bool first = true;
 	for (const auto &entry : mEntries) {
-		sdp << entry->generateSdp(eol, addr, port);
+		sdp += entry->generateSdp(eol, addr, port);
 
 		// RFC 8829: Attributes that SDP permits to be at either the session level or the media level
 		// SHOULD generally be at the media level even if they are identical.
-		sdp << "a=setup:" << mRole << eol;
+		append(sdp, "a=setup:", to_sdp(mRole), eol);
 		if (mIceUfrag)
-			sdp << "a=ice-ufrag:" << *mIceUfrag << eol;
+			append(sdp, "a=ice-ufrag:", *mIceUfrag, eol);
 		if (mIcePwd)
-			sdp << "a=ice-pwd:" << *mIcePwd << eol;
+			append(sdp, "a=ice-pwd:", *mIcePwd, eol);
 
 		if (!entry->isRemoved() && std::exchange(first, false)) {
 			// Candidates
 			for (const auto &candidate : mCandidates)
-				sdp << string(candidate) << eol;
+				append(sdp, string(candidate), eol);
 
 			if (mEnded)
-				sdp << "a=end-of-candidates" << eol;
+				append(sdp, "a=end-of-candidates", eol);
 		}
 	}
 
-	return sdp.str();
+	return sdp;
 }
 
 string Description::generateApplicationSdp(string_view eol) const {
-	std::ostringstream sdp;
+	string sdp;
+	sdp.reserve(1024);
 
 	// Header
-	sdp << "v=0" << eol;
-	sdp << "o=" << mUsername << " " << mSessionId << " 0 IN IP4 127.0.0.1" << eol;
-	sdp << "s=-" << eol;
-	sdp << "t=0 0" << eol;
+	append(sdp, "v=0", eol);
+	append(sdp, "o=", mUsername, ' ', mSessionId, " 0 IN IP4 127.0.0.1", eol);
+	append(sdp, "s=-", eol);
+	append(sdp, "t=0 0", eol);
 
 	auto cand = defaultCandidate();
 	const string addr = cand && cand->isResolved()
@@ -377,36 +546,36 @@ string Description::generateApplicationSdp(string_view eol) const {
 	    cand && cand->isResolved() ? *cand->port() : 9; // Port 9 is the discard protocol
 
 	// Session-level attributes
-	sdp << "a=msid-semantic:WMS *" << eol;
+	append(sdp, "a=msid-semantic:WMS *", eol);
 	if (!mIceOptions.empty())
-		sdp << "a=ice-options:" << utils::implode(mIceOptions, ',') << eol;
+		append(sdp, "a=ice-options:", utils::implode(mIceOptions, ','), eol);
 
 	for (const auto &attr : mAttributes)
-		sdp << "a=" << attr << eol;
+		append(sdp, "a=", attr, eol);
 
 	// Application
 	auto app = mApplication ? mApplication : std::make_shared<Application>();
-	sdp << app->generateSdp(eol, addr, port);
+	sdp += app->generateSdp(eol, addr, port);
 
 	// Media-level attributes
-	sdp << "a=setup:" << mRole << eol;
+	append(sdp, "a=setup:", to_sdp(mRole), eol);
 	if (mIceUfrag)
-		sdp << "a=ice-ufrag:" << *mIceUfrag << eol;
+		append(sdp, "a=ice-ufrag:", *mIceUfrag, eol);
 	if (mIcePwd)
-		sdp << "a=ice-pwd:" << *mIcePwd << eol;
+		append(sdp, "a=ice-pwd:", *mIcePwd, eol);
 	if (mFingerprint)
-		sdp << "a=fingerprint:"
-		    << CertificateFingerprint::AlgorithmIdentifier(mFingerprint->algorithm) << " "
-		    << mFingerprint->value << eol;
+		append(sdp, "a=fingerprint:",
+		       CertificateFingerprint::AlgorithmIdentifier(mFingerprint->algorithm), ' ',
+		       mFingerprint->value, eol);
 
 	// Candidates
 	for (const auto &candidate : mCandidates)
-		sdp << string(candidate) << eol;
+		append(sdp, string(candidate), eol);
 
 	if (mEnded)
-		sdp << "a=end-of-candidates" << eol;
+		append(sdp, "a=end-of-candidates", eol);
 
-	return sdp.str();
+	return sdp;
 }
 
 optional<Candidate> Description::defaultCandidate() const {
@@ -467,13 +636,34 @@ bool Description::hasMid(string_view mid) const {
 	return false;
 }
 
+std::vector<int> Description::changedMedia(const Description &previous) const {
+	std::unordered_map<string, const Entry *> previousEntries;
+	previousEntries.reserve(previous.mEntries.size());
+	for (const auto &entry : previous.mEntries)
+		previousEntries.emplace(entry->mid(), entry.get());
+
+	std::vector<int> changed;
+	for (int i = 0; i < int(mEntries.size()); ++i) {
+		const auto &entry = mEntries[i];
+		auto it = previousEntries.find(entry->mid());
+		if (it == previousEntries.end())
+			changed.push_back(i);
+		else if (it->second != entry.get() && it->second->generateSdp() != entry->generateSdp())
+			changed.push_back(i);
+	}
+
+	return changed;
+}
+
 int Description::addMedia(Media media) {
+	media.mIsShared = false;
 	mEntries.emplace_back(std::make_shared<Media>(std::move(media)));
 	return int(mEntries.size()) - 1;
 }
 
 int Description::addMedia(Application application) {
 	removeApplication();
+	application.mIsShared = false;
 	mApplication = std::make_shared<Application>(std::move(application));
 	mEntries.emplace_back(mApplication);
 	return int(mEntries.size()) - 1;
@@ -483,7 +673,17 @@ int Description::addApplication(string mid) { return addMedia(Application(std::m
 
 const Description::Application *Description::application() const { return mApplication.get(); }
 
-Description::Application *Description::application() { return mApplication.get(); }
+Description::Application *Description::application() {
+	if (!mApplication)
+		return nullptr;
+
+	auto it = std::find(mEntries.begin(), mEntries.end(), mApplication);
+	if (it == mEntries.end())
+		return mApplication.get();
+
+	detach(int(it - mEntries.begin()));
+	return mApplication.get();
+}
 
 int Description::addVideo(string mid, Direction dir) {
 	return addMedia(Video(std::move(mid), dir));
@@ -502,7 +702,7 @@ variant<Description::Media *, Description::Application *> Description::media(int
 	if (index < 0 || index >= int(mEntries.size()))
 		throw std::out_of_range("Media index out of range");
 
-	const auto &entry = mEntries[index];
+	const auto &entry = detach(index);
 	if (entry == mApplication) {
 		auto result = dynamic_cast<Application *>(entry.get());
 		if (!result)
@@ -542,18 +742,96 @@ variant<const Description::Media *, const Description::Application *> Descriptio
 
 int Description::mediaCount() const { return int(mEntries.size()); }
 
+namespace {
+
+// Entries parsed from descriptions, indexed by a hash of their SDP lines
+struct EntryTable {
+	static EntryTable &Instance() {
+		static EntryTable table;
+		return table;
+	}
+
+	std::mutex mutex;
+	std::unordered_multimap<size_t, std::weak_ptr<Description::Entry>> entries;
+	size_t sweepThreshold = 1024;
+};
+
+} // namespace
+
+void Description::intern(int index, size_t hash) {
+	auto &entry = mEntries[index];
+	auto &table = EntryTable::Instance();
+
+	std::vector<shared_ptr<Entry>> candidates;
+	{
+		std::lock_guard lock(table.mutex);
+		auto [begin, end] = table.entries.equal_range(hash);
+		for (auto it = begin; it != end; ++it)
+			if (auto candidate = it->second.lock())
+				candidates.push_back(std::move(candidate));
+	}
+
+	// Shared entries are immutable, so they may be read without the lock
+	if (!candidates.empty()) {
+		const string sdp = entry->generateSdp();
+		for (auto &candidate : candidates) {
+			if (typeid(*candidate) == typeid(*entry) && candidate->generateSdp() == sdp) {
+				if (entry == mApplication)
+					mApplication = std::static_pointer_cast<Application>(candidate);
+
+				entry = std::move(candidate);
+				return;
+			}
+		}
+	}
+
+	entry->mIsShared = true;
+
+	std::lock_guard lock(table.mutex);
+	if (table.entries.size() >= table.sweepThreshold) {
+		for (auto it = table.entries.begin(); it != table.entries.end();)
+			it = it->second.expired() ? table.entries.erase(it) : std::next(it);
+
+		table.sweepThreshold = std::max(size_t(1024), table.entries.size() * 2);
+	}
+	table.entries.emplace(hash, entry);
+}
+
+const shared_ptr<Description::Entry> &Description::detach(int index) {
+	auto &entry = mEntries[index];
+	const bool isApplication = entry == mApplication;
+	const long owners = isApplication ? 2 : 1; // mApplication also references the application
+	if (!entry->mIsShared && entry.use_count() <= owners)
+		return entry;
+
+	if (isApplication) {
+		mApplication = std::make_shared<Application>(static_cast<const Application &>(*entry));
+		mApplication->mIsShared = false;
+		entry = mApplication;
+	} else {
+		auto media = std::make_shared<Media>(static_cast<const Media &>(*entry));
+		media->mIsShared = false;
+		entry = std::move(media);
+	}
+	return entry;
+}
+
 string Description::sessionId() const { return mSessionId; }
 
 Description::Entry::Entry(const string &mline, string mid, Direction dir)
     : mMid(std::move(mid)), mDirection(dir) {
 
+	string_view line = mline;
+	if (match_prefix(line, "m="))
+		line.remove_prefix(2);
+
+	mType = next_token(line);
+	string_view portStr = next_token(line);
+	mProtocol = next_token(line);
+	mDescription = get_first_line(line.substr(std::min(line.find_first_not_of(" \t"), line.size())));
+
 	uint16_t port = 0;
-	std::istringstream ss(match_prefix(mline, "m=") ? mline.substr(2) : mline);
-	ss >> mType;
-	ss >> port;
-	ss >> mProtocol;
-	ss >> std::ws;
-	std::getline(ss, mDescription);
+	std::from_chars(portStr.data(), portStr.data() + portStr.size(), port);
 
 	if (mType.empty() || mProtocol.empty())
 		throw std::invalid_argument("Invalid media description line");
@@ -598,7 +876,7 @@ void Description::removeAttribute(const string &attr) {
 	    mAttributes.end());
 }
 
-std::vector<int> Description::Entry::extIds() {
+std::vector<int> Description::Entry::extIds() const {
 	std::vector<int> result;
 	for (auto it = mExtMaps.begin(); it != mExtMaps.end(); ++it)
 		result.push_back(it->first);
@@ -632,79 +910,78 @@ void Description::Entry::removeExtMap(int id) { mExtMaps.erase(id); }
 Description::Entry::operator string() const { return generateSdp("\r\n", "IP4 0.0.0.0", 9); }
 
 string Description::Entry::generateSdp(string_view eol, string_view addr, uint16_t port) const {
-	std::ostringstream sdp;
+	string sdp;
 	// RFC 3264: Existing media streams are removed by creating a new SDP with the port number for
 	// that stream set to zero. [...] A stream that is offered with a port of zero MUST be marked
 	// with port zero in the answer.
-	sdp << "m=" << type() << ' ' << (mIsRemoved ? 0 : port) << ' ' << protocol() << ' '
-	    << description() << eol;
-	sdp << "c=IN " << addr << eol;
-	sdp << generateSdpLines(eol);
+	append(sdp, "m=", type(), ' ', mIsRemoved ? 0 : port, ' ', protocol(), ' ', description(), eol);
+	append(sdp, "c=IN ", addr, eol);
+	sdp += generateSdpLines(eol);
 
-	return sdp.str();
+	return sdp;
 }
 
 string Description::Entry::generateSdpLines(string_view eol) const {
-	std::ostringstream sdp;
-	sdp << "a=mid:" << mMid << eol;
+	string sdp;
+	sdp.reserve(512);
+	append(sdp, "a=mid:", mMid, eol);
 
 	for (auto it = mExtMaps.begin(); it != mExtMaps.end(); ++it) {
 		auto &map = it->second;
 
-		sdp << "a=extmap:" << map.id;
+		append(sdp, "a=extmap:", map.id);
 		if (map.direction != Direction::Unknown)
-			sdp << '/' << map.direction;
+			append(sdp, '/', to_sdp(map.direction));
 
-		sdp << ' ' << map.uri;
+		append(sdp, ' ', map.uri);
 		if (!map.attributes.empty())
-			sdp << ' ' << map.attributes;
+			append(sdp, ' ', map.attributes);
 
-		sdp << eol;
+		append(sdp, eol);
 	}
 
 	if (mDirection != Direction::Unknown)
-		sdp << "a=" << mDirection << eol;
+		append(sdp, "a=", to_sdp(mDirection), eol);
 
 	for (const auto &attr : mAttributes) {
 		if (mRids.size() != 0 && match_prefix(attr, "ssrc:")) {
 			continue;
 		}
 
-		sdp << "a=" << attr << eol;
+		append(sdp, "a=", attr, eol);
 	}
 
 	for (const auto &rid : mRids) {
-		sdp << "a=rid:" << rid << " send" << eol;
+		append(sdp, "a=rid:", rid, " send", eol);
 	}
 
 	if (mRids.size() != 0) {
-		sdp << "a=simulcast:send ";
+		append(sdp, "a=simulcast:send ");
 
 		bool first = true;
 		for (const auto &rid : mRids) {
 			if (first) {
 				first = false;
 			} else {
-				sdp << ";";
+				append(sdp, ';');
 			}
 
-			sdp << rid;
+			append(sdp, rid);
 		}
 
-		sdp << eol;
+		append(sdp, eol);
 	}
 
-	return sdp.str();
+	return sdp;
 }
 
 void Description::Entry::parseSdpLine(string_view line) {
-	if (match_prefix(line, "a=")) {
-		string_view attr = line.substr(2);
-		auto [key, value] = parse_pair(attr);
+	if (auto attribute = parse_attribute(line)) {
+		const auto &[attr, key, value, id] = *attribute;
 
-		if (key == "mid") {
+		if (id == AttributeKey::Mid) {
 			mMid = value;
-		} else if (key == "extmap") {
+		} else if (id == AttributeKey::ExtMap) {
 			auto id = Description::Media::ExtMap::parseId(value);
 			auto it = mExtMaps.find(id);
 			if (it == mExtMaps.end())
@@ -712,15 +989,15 @@ void Description::Entry::parseSdpLine(string_view line) {
 			else
 				it->second.setDescription(value);
 
-		} else if (attr == "sendonly")
+		} else if (id == AttributeKey::SendOnly)
 			mDirection = Direction::SendOnly;
-		else if (attr == "recvonly")
+		else if (id == AttributeKey::RecvOnly)
 			mDirection = Direction::RecvOnly;
-		else if (key == "sendrecv")
+		else if (id == AttributeKey::SendRecv)
 			mDirection = Direction::SendRecv;
-		else if (key == "inactive")
+		else if (id == AttributeKey::Inactive)
 			mDirection = Direction::Inactive;
-		else if (key == "bundle-only") {
+		else if (id == AttributeKey::BundleOnly) {
 			// RFC 8843: When an offerer generates a subsequent offer, in which it wants to disable
 			// a bundled "m=" section from a BUNDLE group, the offerer [...] MUST NOT assign an SDP
 			// 'bundle-only' attribute to the "m=" section.
@@ -804,6 +1081,20 @@ void Description::Media::removeSSRC(uint32_t ssrc) {
 	                                 [&](const auto &a) { return match_prefix(a, prefix); }),
 	                  mAttributes.end());
 
+	// Remove the groups the SSRC belongs to
+	const string value = std::to_string(ssrc);
+	auto it = mAttributes.begin();
+	while (it != mAttributes.end()) {
+		if (match_prefix(*it, "ssrc-group:")) {
+			auto fields = utils::explode(*it, ' ');
+			if (std::find(fields.begin() + 1, fields.end(), value) != fields.end()) {
+				it = mAttributes.erase(it);
+				continue;
+			}
+		}
+		++it;
+	}
+
 	mSsrcs.erase(std::remove(mSsrcs.begin(), mSsrcs.end(), ssrc), mSsrcs.end());
 }
 
@@ -820,7 +1111,7 @@ bool Description::Media::hasSSRC(uint32_t ssrc) const {
 void Description::Media::clearSSRCs() {
 	auto it = mAttributes.begin();
 	while (it != mAttributes.end()) {
-		if (match_prefix(*it, "ssrc:"))
+		if (match_prefix(*it, "ssrc:") || match_prefix(*it, "ssrc-group:"))
 			it = mAttributes.erase(it);
 		else
 			++it;
@@ -840,6 +1131,44 @@ optional<string> Description::Media::getCNameForSsrc(uint32_t ssrc) const {
 	return nullopt;
 }
 
+void Description::Media::addRtxSSRC(uint32_t ssrc, uint32_t rtxSsrc) {
+	addSSRCGroup("FID", ssrc, rtxSsrc);
+}
+
+optional<uint32_t> Description::Media::getRtxSSRC(uint32_t ssrc) const {
+	return getGroupedSSRC("FID", ssrc);
+}
+
+void Description::Media::addFecSSRC(uint32_t ssrc, uint32_t fecSsrc) {
+	addSSRCGroup("FEC-FR", ssrc, fecSsrc);
+}
+
+optional<uint32_t> Description::Media::getFecSSRC(uint32_t ssrc) const {
+	return getGroupedSSRC("FEC-FR", ssrc);
+}
+
+void Description::Media::addSSRCGroup(string_view semantics, uint32_t ssrc, uint32_t other) {
+	if (!hasSSRC(other))
+		addSSRC(other, getCNameForSsrc(ssrc));
+
+	addAttribute("ssrc-group:" + string(semantics) + " " + std::to_string(ssrc) + " " +
+	             std::to_string(other));
+}
+
+optional<uint32_t> Description::Media::getGroupedSSRC(string_view semantics, uint32_t ssrc) const {
+	// RFC 5576: a=ssrc-group:<semantics> <primary ssrc> <other ssrc>
+	const string prefix = "ssrc-group:" + string(semantics) + " ";
+	for (const auto &attr : mAttributes) {
+		if (!match_prefix(attr, prefix))
+			continue;
+
+		auto ssrcs = utils::explode(attr.substr(prefix.size()), ' ');
+		if (ssrcs.size() >= 2 && ssrcs[0] == std::to_string(ssrc))
+			return to_integer<uint32_t>(ssrcs[1]);
+	}
+	return nullopt;
+}
+
 Description::Application::Application(string mid)
     : Entry("application 9 UDP/DTLS/SCTP webrtc-datachannel", std::move(mid), Direction::SendRecv) {
 }
@@ -866,30 +1195,23 @@ optional<uint16_t> Description::Application::sctpPort() const { return mSctpPort
 optional<size_t> Description::Application::maxMessageSize() const { return mMaxMessageSize; }
 
 string Description::Application::generateSdpLines(string_view eol) const {
-	std::ostringstream sdp;
-	sdp << Entry::generateSdpLines(eol);
+	string sdp = Entry::generateSdpLines(eol);
 
 	if (mSctpPort)
-		sdp << "a=sctp-port:" << *mSctpPort << eol;
+		append(sdp, "a=sctp-port:", *mSctpPort, eol);
 
 	if (mMaxMessageSize)
-		sdp << "a=max-message-size:" << *mMaxMessageSize << eol;
+		append(sdp, "a=max-message-size:", *mMaxMessageSize, eol);
 
-	return sdp.str();
+	return sdp;
 }
 
 void Description::Application::parseSdpLine(string_view line) {
-	if (match_prefix(line, "a=")) {
-		string_view attr = line.substr(2);
-		auto [key, value] = parse_pair(attr);
-
-		if (key == "sctp-port") {
-			mSctpPort = to_integer<uint16_t>(value);
-		} else if (key == "max-message-size") {
-			mMaxMessageSize = to_integer<size_t>(value);
-		} else {
-			Entry::parseSdpLine(line);
-		}
+	auto attribute = parse_attribute(line);
+	if (attribute && attribute->id == AttributeKey::SctpPort) {
+		mSctpPort = to_integer<uint16_t>(attribute->value);
+	} else if (attribute && attribute->id == AttributeKey::MaxMessageSize) {
+		mMaxMessageSize = to_integer<size_t>(attribute->value);
 	} else {
 		Entry::parseSdpLine(line);
 	}
@@ -897,39 +1219,38 @@ void Description::Application::parseSdpLine(string_view line) {
 
 Description::Media::Media(const string &mline, string mid, Direction dir)
     : Entry(mline, std::move(mid), dir) {
-	std::istringstream ss(Entry::description());
-	int payloadType;
-	while (ss >> payloadType)
+	const string desc = Entry::description();
+	string_view formats = desc;
+	for (string_view token = next_token(formats); !token.empty(); token = next_token(formats)) {
+		int payloadType = 0;
+		auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), payloadType);
+		if (ec != std::errc() || ptr != token.data() + token.size())
+			break;
+
 		mOrderedPayloadTypes.push_back(payloadType);
+	}
 }
 
-Description::Media::Media(const string &sdp) : Media(get_first_line(sdp), "", Direction::Unknown) {
-	string line;
-	std::istringstream ss(sdp);
-	std::getline(ss, line); // discard first line
-	while (ss) {
-		std::getline(ss, line);
-		trim_end(line);
-		if (line.empty())
-			continue;
-
-		parseSdpLine(line);
-	}
+Description::Media::Media(const string &sdp)
+    : Media(string(get_first_line(sdp)), "", Direction::Unknown) {
+	string_view lines = sdp;
+	lines.remove_prefix(std::min(lines.find('\n'), lines.size())); // discard first line
+	for_each_line(lines, [this](string_view line) { parseSdpLine(line); });
 
 	if (mid().empty())
 		throw std::invalid_argument("Missing mid in media description");
 }
 
 string Description::Media::description() const {
-	std::ostringstream ss;
+	string desc;
 	for (auto it = mOrderedPayloadTypes.begin(); it != mOrderedPayloadTypes.end(); ++it) {
 		if (it != mOrderedPayloadTypes.begin())
-			ss << ' ';
+			desc += ' ';
 
-		ss << *it;
+		desc += std::to_string(*it);
 	}
 
-	return ss.str();
+	return desc;
 }
 
 Description::Media Description::Media::reciprocate() const {
@@ -1048,40 +1369,67 @@ void Description::Media::addRtxCodec(int payloadType, int origPayloadType, unsig
 	addRtpMap(rtp);
 }
 
+optional<int> Description::Media::getRtxPayloadType(int origPayloadType) const {
+	const string apt = "apt=" + std::to_string(origPayloadType);
+	for (const auto &[pt, map] : mRtpMaps) {
+		if (map.format != "rtx" && map.format != "RTX")
+			continue;
+
+		for (const auto &fmtp : map.fmtps)
+			if (fmtp == apt || match_prefix(fmtp, apt + ";"))
+				return pt;
+	}
+	return nullopt;
+}
+
+void Description::Media::addFlexFecCodec(int payloadType, unsigned int clockRate) {
+	RtpMap rtp(std::to_string(payloadType) + " flexfec-03/" + std::to_string(clockRate));
+	rtp.fmtps.emplace_back("repair-window=10000000");
+	addRtpMap(rtp);
+}
+
+optional<int> Description::Media::getFlexFecPayloadType() const {
+	for (const auto &[pt, map] : mRtpMaps)
+		if (map.format == "flexfec-03")
+			return pt;
+
+	return nullopt;
+}
+
 string Description::Media::generateSdpLines(string_view eol) const {
-	std::ostringstream sdp;
+	string sdp;
+	sdp.reserve(1024);
 	if (mBas >= 0)
-		sdp << "b=AS:" << mBas << eol;
+		append(sdp, "b=AS:", mBas, eol);
 
-	sdp << Entry::generateSdpLines(eol);
-	sdp << "a=rtcp-mux" << eol;
+	sdp += Entry::generateSdpLines(eol);
+	append(sdp, "a=rtcp-mux", eol);
 
 	for (auto it = mRtpMaps.begin(); it != mRtpMaps.end(); ++it) {
 		auto &map = it->second;
 
 		// Create the a=rtpmap
-		sdp << "a=rtpmap:" << map.payloadType << ' ' << map.format << '/' << map.clockRate;
+		append(sdp, "a=rtpmap:", map.payloadType, ' ', map.format, '/', map.clockRate);
 		if (!map.encParams.empty())
-			sdp << '/' << map.encParams;
+			append(sdp, '/', map.encParams);
 
-		sdp << eol;
+		append(sdp, eol);
 
 		for (const auto &val : map.rtcpFbs)
-			sdp << "a=rtcp-fb:" << map.payloadType << ' ' << val << eol;
+			append(sdp, "a=rtcp-fb:", map.payloadType, ' ', val, eol);
 
 		for (const auto &val : map.fmtps)
-			sdp << "a=fmtp:" << map.payloadType << ' ' << val << eol;
+			append(sdp, "a=fmtp:", map.payloadType, ' ', val, eol);
 	}
 
-	return sdp.str();
+	return sdp;
 }
 
 void Description::Media::parseSdpLine(string_view line) {
-	if (match_prefix(line, "a=")) {
-		string_view attr = line.substr(2);
-		auto [key, value] = parse_pair(attr);
+	if (auto attribute = parse_attribute(line)) {
+		const auto &[attr, key, value, id] = *attribute;
 
-		if (key == "rtpmap") {
+		if (id == AttributeKey::RtpMap) {
 			auto pt = Description::Media::RtpMap::parsePayloadType(value);
 			auto it = mRtpMaps.find(pt);
 			if (it == mRtpMaps.end())
@@ -1089,7 +1437,7 @@ void Description::Media::parseSdpLine(string_view line) {
 			else
 				it->second.setDescription(value);
 
-		} else if (key == "rtcp-fb") {
+		} else if (id == AttributeKey::RtcpFb) {
 			size_t p = value.find(' ');
 			int pt = to_integer<int>(value.substr(0, p));
 			auto it = mRtpMaps.find(pt);
@@ -1098,7 +1446,7 @@ void Description::Media::parseSdpLine(string_view line) {
 
 			it->second.rtcpFbs.emplace_back(value.substr(p + 1));
 
-		} else if (key == "fmtp") {
+		} else if (id == AttributeKey::Fmtp) {
 			size_t p = value.find(' ');
 			int pt = to_integer<int>(value.substr(0, p));
 			auto it = mRtpMaps.find(pt);
@@ -1107,10 +1455,10 @@ void Description::Media::parseSdpLine(string_view line) {
 
 			it->second.fmtps.emplace_back(value.substr(p + 1));
 
-		} else if (key == "rtcp-mux") {
+		} else if (id == AttributeKey::RtcpMux) {
 			// always added
 
-		} else if (key == "ssrc") {
+		} else if (id == AttributeKey::Ssrc) {
 			auto ssrc = to_integer<uint32_t>(value);
 			if (!hasSSRC(ssrc))
 				mSsrcs.emplace_back(ssrc);
@@ -1385,43 +1733,13 @@ std::ostream &operator<<(std::ostream &out, Description::Type type) {
 }
 
 std::ostream &operator<<(std::ostream &out, Description::Role role) {
-	using Role = Description::Role;
 	// Used for SDP generation, do not change
-	switch (role) {
-	case Role::Active:
-		out << "active";
-		break;
-	case Role::Passive:
-		out << "passive";
-		break;
-	default:
-		out << "actpass";
-		break;
-	}
-	return out;
+	return out << to_sdp(role);
 }
 
 std::ostream &operator<<(std::ostream &out, const Description::Direction &direction) {
 	// Used for SDP generation, do not change
-	switch (direction) {
-	case Description::Direction::RecvOnly:
-		out << "recvonly";
-		break;
-	case Description::Direction::SendOnly:
-		out << "sendonly";
-		break;
-	case Description::Direction::SendRecv:
-		out << "sendrecv";
-		break;
-	case Description::Direction::Inactive:
-		out << "inactive";
-		break;
-	case Description::Direction::Unknown:
-	default:
-		out << "unknown";
-		break;
-	}
-	return out;
+	return out << to_sdp(direction);
 }
 
 } // namespace rtc
@@ -0,0 +1,473 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "filetransfer.hpp"
+
+#include "impl/internals.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace rtc {
+
+namespace {
+
+/*
+ * Every message starts with a type byte and two 64-bit big-endian values: the offset of the data
+ * in the file for data chunks or the file size for the end message, then the file size. As every
+ * chunk announces the size, the receiver never writes beyond it, whatever the arrival order.
+ */
+const size_t ChunkHeaderSize = 1 + 8 + 8;
+const byte DataChunkType = byte(0);
+const byte EndChunkType = byte(1);
+
+void write_chunk_value(byte *header, size_t index, uint64_t value) {
+	for (size_t i = 0; i < 8; ++i)
+		header[1 + 8 * index + i] = byte((value >> (8 * (7 - i))) & 0xFF);
+}
+
+uint64_t read_chunk_value(const byte *header, size_t index) {
+	uint64_t value = 0;
+	for (size_t i = 0; i < 8; ++i)
+		value = (value << 8) | std::to_integer<uint64_t>(header[1 + 8 * index + i]);
+
+	return value;
+}
+
+binary make_chunk(byte type, uint64_t value, uint64_t fileSize, size_t dataSize) {
+	binary chunk(ChunkHeaderSize + dataSize);
+	chunk[0] = type;
+	write_chunk_value(chunk.data(), 0, value);
+	write_chunk_value(chunk.data(), 1, fileSize);
+	return chunk;
+}
+
+void check_channels(const std::vector<shared_ptr<DataChannel>> &channels) {
+	if (channels.empty())
+		throw std::invalid_argument("File transfer requires at least one data channel");
+
+	for (const auto &channel : channels)
+		if (!channel)
+			throw std::invalid_argument("File transfer over a null data channel");
+}
+
+} // namespace
+
+struct FileSender::State : std::enable_shared_from_this<FileSender::State> {
+	void pump();
+	void send(const shared_ptr<DataChannel> &channel, binary chunk, size_t dataSize);
+	void sent(size_t dataSize, std::exception_ptr error);
+	void fail(string error);
+
+	std::vector<shared_ptr<DataChannel>> channels;
+	size_t chunkSize = 0;
+	size_t window = 0;
+	std::ifstream file;
+	uint64_t size = 0;
+
+	mutable std::mutex mutex;
+	uint64_t next = 0; // offset of the next chunk to read
+	uint64_t sentAmount = 0;
+	size_t inFlight = 0;
+	size_t nextChannel = 0;
+	bool started = false;
+	bool pumping = false;
+	bool finished = false;
+	bool complete = false;
+	bool failed = false;
+
+	synchronized_callback<uint64_t> progressCallback;
+	synchronized_callback<> completeCallback;
+	synchronized_callback<string> errorCallback;
+};
+
+void FileSender::State::pump() {
+	std::unique_lock lock(mutex);
+	if (std::exchange(pumping, true))
+		return; // the pumping loop will take care of it
+
+	// Completions may be called synchronously by sendAsync(), so they only wake up this loop
+	while (!failed && !finished) {
+		binary chunk;
+		size_t dataSize = 0;
+		if (next < size) {
+			if (inFlight >= window)
+				break;
+
+			// Data is read directly into the message buffer, which is then moved to the channel
+			dataSize = size_t(std::min(uint64_t(chunkSize), size - next));
+			chunk = make_chunk(DataChunkType, next, size, dataSize);
+			file.seekg(std::streamoff(next));
+			file.read(reinterpret_cast<char *>(chunk.data() + ChunkHeaderSize),
+			          std::streamsize(dataSize));
+			if (!file) {
+				lock.unlock();
+				fail("Failed to read file at offset " + std::to_string(next));
+				lock.lock();
+				break;
+			}
+			next += dataSize;
+
+		} else if (inFlight == 0) {
+			// Every chunk has been sent, announce the end with the file size
+			chunk = make_chunk(EndChunkType, size, size, 0);
+			finished = true;
+
+		} else {
+			break;
+		}
+
+		++inFlight;
+		auto channel = channels[nextChannel++ % channels.size()];
+		lock.unlock();
+		send(channel, std::move(chunk), dataSize);
+		lock.lock();
+	}
+
+	pumping = false;
+}
+
+void FileSender::State::send(const shared_ptr<DataChannel> &channel, binary chunk,
+                             size_t dataSize) {
+	std::weak_ptr<State> weak_this = weak_from_this();
+	try {
+		channel->sendAsync(std::move(chunk), [weak_this, dataSize](std::exception_ptr error) {
+			if (auto locked = weak_this.lock())
+				locked->sent(dataSize, std::move(error));
+		});
+	} catch (const std::exception &e) {
+		fail(e.what());
+	}
+}
+
+void FileSender::State::sent(size_t dataSize, std::exception_ptr error) {
+	if (error) {
+		try {
+			std::rethrow_exception(error);
+		} catch (const std::exception &e) {
+			fail(e.what());
+		}
+		return;
+	}
+
+	std::unique_lock lock(mutex);
+	if (failed)
+		return;
+
+	--inFlight;
+	sentAmount += dataSize;
+	uint64_t progress = sentAmount;
+	bool done = finished && inFlight == 0 && !std::exchange(complete, true);
+	lock.unlock();
+
+	if (dataSize > 0)
+		progressCallback(progress);
+
+	if (done) {
+		PLOG_DEBUG << "File transfer completed, size=" << size;
+		completeCallback();
+	} else {
+		pump();
+	}
+}
+
+void FileSender::State::fail(string error) {
+	{
+		std::lock_guard lock(mutex);
+		if (failed || complete)
+			return;
+
+		failed = true;
+	}
+
+	PLOG_WARNING << "File transfer failed: " << error;
+	errorCallback(std::move(error));
+}
+
+FileSender::FileSender(const string &path, std::vector<shared_ptr<DataChannel>> channels,
+                       FileSenderInit init)
+    : mState(std::make_shared<State>()) {
+	check_channels(channels);
+
+	size_t maxMessageSize = std::numeric_limits<size_t>::max();
+	for (const auto &channel : channels)
+		maxMessageSize = std::min(maxMessageSize, channel->maxMessageSize());
+
+	if (maxMessageSize <= ChunkHeaderSize)
+		throw std::invalid_argument("Data channel max message size is too small");
+
+	if (init.chunkSize == 0)
+		init.chunkSize = maxMessageSize - ChunkHeaderSize;
+	else if (init.chunkSize > maxMessageSize - ChunkHeaderSize)
+		throw std::invalid_argument("File chunk size exceeds the data channel max message size");
+
+	mState->file.open(path, std::ios::binary | std::ios::ate);
+	if (!mState->file)
+		throw std::runtime_error("Failed to open file for reading: " + path);
+
+	mState->size = uint64_t(mState->file.tellg());
+	if (init.offset > mState->size)
+		throw std::invalid_argument("File transfer offset exceeds the file size");
+
+	mState->channels = std::move(channels);
+	mState->chunkSize = init.chunkSize;
+	mState->window = std::max(init.window, size_t(1));
+	mState->next = init.offset;
+	mState->sentAmount = init.offset;
+}
+
+FileSender::FileSender(const string &path, shared_ptr<DataChannel> channel, FileSenderInit init)
+    : FileSender(path, std::vector<shared_ptr<DataChannel>>{std::move(channel)},
+                 std::move(init)) {}
+
+FileSender::~FileSender() { cancel(); }
+
+void FileSender::start() {
+	{
+		std::lock_guard lock(mState->mutex);
+		if (std::exchange(mState->started, true))
+			return;
+	}
+
+	PLOG_DEBUG << "Starting file transfer, size=" << mState->size << ", offset=" << mState->next;
+	mState->pump();
+}
+
+void FileSender::cancel() {
+	std::lock_guard lock(mState->mutex);
+	if (!mState->complete)
+		mState->failed = true;
+}
+
+uint64_t FileSender::size() const { return mState->size; }
+
+uint64_t FileSender::sentAmount() const {
+	std::lock_guard lock(mState->mutex);
+	return mState->sentAmount;
+}
+
+bool FileSender::isComplete() const {
+	std::lock_guard lock(mState->mutex);
+	return mState->complete;
+}
+
+void FileSender::onProgress(std::function<void(uint64_t sent)> callback) {
+	mState->progressCallback = std::move(callback);
+}
+
+void FileSender::onComplete(std::function<void()> callback) {
+	mState->completeCallback = std::move(callback);
+}
+
+void FileSender::onError(std::function<void(string error)> callback) {
+	mState->errorCallback = std::move(callback);
+}
+
+struct FileReceiver::State : std::enable_shared_from_this<FileReceiver::State> {
+	void incoming(const shared_ptr<const Message> &message);
+	void insert(uint64_t begin, uint64_t end);
+	uint64_t contiguous() const;
+	void fail(string error);
+
+	std::fstream file;
+
+	mutable std::mutex mutex;
+	std::map<uint64_t, uint64_t> ranges; // begin to end of disjoint received ranges
+	uint64_t receivedAmount = 0;
+	optional<uint64_t> size;
+	bool complete = false;
+	bool failed = false;
+
+	synchronized_callback<uint64_t> progressCallback;
+	synchronized_callback<uint64_t> completeCallback;
+	synchronized_callback<string> errorCallback;
+};
+
+void FileReceiver::State::incoming(const shared_ptr<const Message> &message) {
+	if (message->type != Message::Binary || message->size() < ChunkHeaderSize) {
+		PLOG_WARNING << "Ignoring unexpected message during file transfer";
+		return;
+	}
+
+	const byte type = message->front();
+	const uint64_t value = read_chunk_value(message->data(), 0);
+	const uint64_t fileSize = read_chunk_value(message->data(), 1);
+	const size_t dataSize = message->size() - ChunkHeaderSize;
+
+	std::unique_lock lock(mutex);
+	if (complete || failed)
+		return;
+
+	// The size is announced by every chunk, it bounds writes and must never change
+	if (size && *size != fileSize) {
+		lock.unlock();
+		fail("File size changed during transfer");
+		return;
+	}
+	if (!size && contiguous() > fileSize) {
+		lock.unlock();
+		fail("File transfer offset exceeds the announced size");
+		return;
+	}
+	size = fileSize;
+
+	if (type == DataChunkType) {
+		if (value > fileSize || dataSize > fileSize - value) {
+			lock.unlock();
+			fail("File chunk at offset " + std::to_string(value) +
+			     " exceeds the announced size");
+			return;
+		}
+
+		file.seekp(std::streamoff(value));
+		file.write(reinterpret_cast<const char *>(message->data() + ChunkHeaderSize),
+		           std::streamsize(dataSize));
+		if (!file) {
+			lock.unlock();
+			fail("Failed to write file at offset " + std::to_string(value));
+			return;
+		}
+		insert(value, value + dataSize);
+
+	} else if (type == EndChunkType) {
+		if (value != fileSize) {
+			lock.unlock();
+			fail("Invalid file transfer end message");
+			return;
+		}
+
+	} else {
+		PLOG_WARNING << "Ignoring unknown file transfer message type";
+		return;
+	}
+
+	// Chunks may arrive in any order over several channels, even after the end message
+	const uint64_t progress = receivedAmount;
+	const bool done = size && contiguous() >= *size;
+	if (done) {
+		file.flush();
+		complete = true;
+	}
+	lock.unlock();
+
+	if (type == DataChunkType)
+		progressCallback(progress);
+
+	if (done) {
+		PLOG_DEBUG << "File reception completed, size=" << *size;
+		completeCallback(*size);
+	}
+}
+
+void FileReceiver::State::insert(uint64_t begin, uint64_t end) {
+	if (begin >= end)
+		return;
+
+	// Merge with the previous range if it overlaps or touches, then with all following ones
+	auto it = ranges.upper_bound(begin);
+	if (it != ranges.begin() && std::prev(it)->second >= begin) {
+		--it;
+		begin = it->first;
+	}
+
+	uint64_t covered = 0;
+	while (it != ranges.end() && it->first <= end) {
+		covered += it->second - it->first;
+		end = std::max(end, it->second);
+		it = ranges.erase(it);
+	}
+
+	ranges.emplace(begin, end);
+	receivedAmount += (end - begin) - covered;
+}
+
+uint64_t FileReceiver::State::contiguous() const {
+	auto it = ranges.begin();
+	return it != ranges.end() && it->first == 0 ? it->second : 0;
+}
+
+void FileReceiver::State::fail(string error) {
+	{
+		std::lock_guard lock(mutex);
+		if (failed || complete)
+			return;
+
+		failed = true;
+	}
+
+	PLOG_WARNING << "File reception failed: " << error;
+	errorCallback(std::move(error));
+}
+
+FileReceiver::FileReceiver(const string &path, std::vector<shared_ptr<DataChannel>> channels,
+                           FileReceiverInit init)
+    : mState(std::make_shared<State>()) {
+	check_channels(channels);
+
+	// Create the file if necessary without truncating it
+	std::ofstream(path, std::ios::binary | std::ios::app);
+	mState->file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+	if (!mState->file)
+		throw std::runtime_error("Failed to open file for writing: " + path);
+
+	mState->insert(0, init.offset);
+
+	std::weak_ptr<State> weak_state = mState;
+	for (const auto &channel : channels) {
+		// Views avoid copying chunks before they are written
+		channel->onMessageView([weak_state](shared_ptr<const Message> message) {
+			if (auto state = weak_state.lock())
+				state->incoming(message);
+		});
+	}
+}
+
+FileReceiver::FileReceiver(const string &path, shared_ptr<DataChannel> channel,
+                           FileReceiverInit init)
+    : FileReceiver(path, std::vector<shared_ptr<DataChannel>>{std::move(channel)},
+                   std::move(init)) {}
+
+FileReceiver::~FileReceiver() {}
+
+uint64_t FileReceiver::receivedAmount() const {
+	std::lock_guard lock(mState->mutex);
+	return mState->receivedAmount;
+}
+
+uint64_t FileReceiver::resumeOffset() const {
+	std::lock_guard lock(mState->mutex);
+	return mState->contiguous();
+}
+
+optional<uint64_t> FileReceiver::size() const {
+	std::lock_guard lock(mState->mutex);
+	return mState->size;
+}
+
+bool FileReceiver::isComplete() const {
+	std::lock_guard lock(mState->mutex);
+	return mState->complete;
+}
+
+void FileReceiver::onProgress(std::function<void(uint64_t received)> callback) {
+	mState->progressCallback = std::move(callback);
+}
+
+void FileReceiver::onComplete(std::function<void(uint64_t size)> callback) {
+	mState->completeCallback = std::move(callback);
+}
+
+void FileReceiver::onError(std::function<void(string error)> callback) {
+	mState->errorCallback = std::move(callback);
+}
+
+} // namespace rtc
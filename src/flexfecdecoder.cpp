@@ -0,0 +1,272 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "flexfecdecoder.hpp"
+
+#include "impl/fec.hpp"
+#include "impl/internals.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace rtc {
+
+using impl::FLEXFEC_HEADER_SIZE;
+using impl::FLEXFEC_RTP_HEADER_SIZE;
+
+namespace {
+
+uint16_t read16(const byte *p) {
+	return uint16_t(std::to_integer<uint16_t>(p[0]) << 8 | std::to_integer<uint16_t>(p[1]));
+}
+
+uint32_t read32(const byte *p) { return uint32_t(read16(p)) << 16 | read16(p + 2); }
+
+} // namespace
+
+FlexFecDecoder::FlexFecDecoder() {}
+
+void FlexFecDecoder::media(const Description::Media &desc) {
+	std::lock_guard lock(mMutex);
+	if (auto pt = desc.getFlexFecPayloadType())
+		mPayloadType = uint8_t(*pt);
+	else
+		mPayloadType.reset();
+}
+
+void FlexFecDecoder::incoming(message_vector &messages,
+                              [[maybe_unused]] const message_callback &send) {
+	std::lock_guard lock(mMutex);
+	if (!mPayloadType)
+		return;
+
+	message_vector result;
+	result.reserve(messages.size());
+	for (auto &message : messages) {
+		if (message->type != Message::Binary || message->size() < sizeof(RtpHeader)) {
+			result.push_back(std::move(message));
+			continue;
+		}
+
+		auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+		if (rtp->payloadType() == *mPayloadType) {
+			if (auto fec = parse(std::move(message))) {
+				if (mPending.size() >= MaxPendingCount)
+					mPending.pop_front();
+
+				mPending.push_back(std::move(*fec));
+			}
+			continue; // FEC packets are not passed on
+		}
+
+		store(message);
+		result.push_back(std::move(message));
+	}
+
+	// A recovered packet may allow recovering another one with a different FEC packet
+	bool progress = true;
+	while (progress && !mPending.empty()) {
+		progress = false;
+		auto it = mPending.begin();
+		while (it != mPending.end()) {
+			std::vector<uint16_t> missing;
+			for (auto sequenceNumber : it->sequenceNumbers)
+				if (!find(it->ssrc, sequenceNumber))
+					missing.push_back(sequenceNumber);
+
+			// Packets protecting an unknown stream can't be recovered
+			auto hit = mHistories.find(it->ssrc);
+			if (hit == mHistories.end()) {
+				it = mPending.erase(it);
+				continue;
+			}
+
+			if (missing.size() > 1) {
+				// Wait for more packets, unless the protected ones are too old
+				const auto &history = hit->second;
+				const uint16_t age = uint16_t(history.newest - it->sequenceNumbers.back());
+				if (int16_t(age) > 0 && age >= HistorySize / 2)
+					it = mPending.erase(it);
+				else
+					++it;
+
+				continue;
+			}
+
+			if (missing.size() == 1) {
+				if (auto recovered = recover(*it, missing.front())) {
+					PLOG_VERBOSE << "Recovered RTP packet with FEC, SSRC=" << it->ssrc
+					             << ", seq=" << missing.front();
+					++mRecovered;
+					store(recovered);
+					result.push_back(std::move(recovered));
+					progress = true;
+				}
+			}
+
+			it = mPending.erase(it);
+		}
+	}
+
+	messages.swap(result);
+}
+
+size_t FlexFecDecoder::recoveredCount() const {
+	std::lock_guard lock(mMutex);
+	return mRecovered;
+}
+
+optional<FlexFecDecoder::Fec> FlexFecDecoder::parse(message_ptr message) const {
+	// Requires mMutex to be locked
+	// See draft-ietf-payload-flexible-fec-scheme-03 4.2. FEC Header
+	if (message->size() < sizeof(RtpHeader) + FLEXFEC_HEADER_SIZE)
+		return nullopt;
+
+	auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+	if (rtp->getSize() + FLEXFEC_HEADER_SIZE > message->size())
+		return nullopt;
+
+	const auto fec = message->data() + rtp->getSize();
+	const size_t available = message->size() - rtp->getSize();
+
+	if (std::to_integer<uint8_t>(fec[0]) & 0xC0) {
+		PLOG_VERBOSE << "Unsupported FlexFEC packet, retransmission or fixed mask";
+		return nullopt;
+	}
+
+	if (std::to_integer<uint8_t>(fec[8]) != 1) {
+		PLOG_VERBOSE << "Unsupported FlexFEC packet protecting multiple streams";
+		return nullopt;
+	}
+
+	Fec result;
+	result.ssrc = read32(fec + 12);
+	const uint16_t base = read16(fec + 16);
+
+	// The mask is 15, 46, or 109 bits long, a k bit set to 1 ends it
+	auto add = [&](uint64_t bits, size_t count, size_t offset) {
+		for (size_t i = 0; i < count; ++i)
+			if (bits & (uint64_t(1) << (count - 1 - i)))
+				result.sequenceNumbers.push_back(uint16_t(base + offset + i));
+	};
+
+	const uint16_t mask0 = read16(fec + 18);
+	add(mask0 & 0x7FFF, 15, 0);
+	result.headerSize = FLEXFEC_HEADER_SIZE;
+	if (!(mask0 & 0x8000)) {
+		if (available < result.headerSize + 4)
+			return nullopt;
+
+		const uint32_t mask1 = read32(fec + 20);
+		add(mask1 & 0x7FFFFFFF, 31, 15);
+		result.headerSize += 4;
+		if (!(mask1 & 0x80000000)) {
+			if (available < result.headerSize + 8)
+				return nullopt;
+
+			const uint64_t mask2 = uint64_t(read32(fec + 24)) << 32 | read32(fec + 28);
+			add(mask2 & 0x7FFFFFFFFFFFFFFF, 63, 46);
+			result.headerSize += 8;
+		}
+	}
+
+	if (result.sequenceNumbers.empty())
+		return nullopt;
+
+	result.headerSize += rtp->getSize();
+	result.message = std::move(message);
+	return result;
+}
+
+const message_ptr *FlexFecDecoder::find(SSRC ssrc, uint16_t sequenceNumber) const {
+	// Requires mMutex to be locked
+	auto it = mHistories.find(ssrc);
+	if (it == mHistories.end())
+		return nullptr;
+
+	const auto &packet = it->second.packets[sequenceNumber % HistorySize];
+	if (!packet)
+		return nullptr;
+
+	auto rtp = reinterpret_cast<const RtpHeader *>(packet->data());
+	if (rtp->seqNumber() != sequenceNumber)
+		return nullptr;
+
+	return &packet;
+}
+
+void FlexFecDecoder::store(message_ptr message) {
+	// Requires mMutex to be locked
+	auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+	const uint16_t sequenceNumber = rtp->seqNumber();
+	auto &history = mHistories[rtp->ssrc()];
+	if (history.packets.empty()) {
+		history.packets.resize(HistorySize);
+		history.newest = sequenceNumber;
+	} else if (int16_t(sequenceNumber - history.newest) > 0) {
+		history.newest = sequenceNumber;
+	}
+
+	history.packets[sequenceNumber % HistorySize] = std::move(message);
+}
+
+message_ptr FlexFecDecoder::recover(const Fec &fec, uint16_t sequenceNumber) const {
+	// Requires mMutex to be locked
+	const auto data = fec.message->data();
+	const auto fecHeader = data + reinterpret_cast<const RtpHeader *>(data)->getSize();
+	const size_t payloadSize = fec.message->size() - fec.headerSize;
+	const auto payload = data + fec.headerSize;
+
+	uint8_t first = std::to_integer<uint8_t>(fecHeader[0]);
+	uint8_t second = std::to_integer<uint8_t>(fecHeader[1]);
+	uint16_t length = read16(fecHeader + 2);
+	uint32_t timestamp = read32(fecHeader + 4);
+	for (auto other : fec.sequenceNumbers) {
+		if (other == sequenceNumber)
+			continue;
+
+		const auto &packet = *find(fec.ssrc, other);
+		auto rtp = reinterpret_cast<const RtpHeader *>(packet->data());
+		first ^= std::to_integer<uint8_t>(packet->data()[0]);
+		second ^= std::to_integer<uint8_t>(packet->data()[1]);
+		length ^= uint16_t(packet->size() - FLEXFEC_RTP_HEADER_SIZE);
+		timestamp ^= rtp->timestamp();
+	}
+
+	if (length > payloadSize) {
+		PLOG_VERBOSE << "Invalid FlexFEC recovered length";
+		return nullptr;
+	}
+
+	auto message = make_message(FLEXFEC_RTP_HEADER_SIZE + length, Message::Binary);
+	std::memcpy(message->data() + FLEXFEC_RTP_HEADER_SIZE, payload, length);
+	for (auto other : fec.sequenceNumbers) {
+		if (other == sequenceNumber)
+			continue;
+
+		const auto &packet = *find(fec.ssrc, other);
+		const size_t size = std::min(packet->size() - FLEXFEC_RTP_HEADER_SIZE, size_t(length));
+		impl::fec_xor(message->data() + FLEXFEC_RTP_HEADER_SIZE,
+		              packet->data() + FLEXFEC_RTP_HEADER_SIZE, size);
+	}
+
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	message->data()[0] = byte(0x80 | (first & 0x3F)); // V=2
+	message->data()[1] = byte(second);
+	rtp->setSeqNumber(sequenceNumber);
+	rtp->setTimestamp(timestamp);
+	rtp->setSsrc(fec.ssrc);
+	message->stream = fec.ssrc;
+	return message;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -0,0 +1,234 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "flexfecencoder.hpp"
+
+#include "impl/fec.hpp"
+#include "impl/internals.hpp"
+#include "impl/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace rtc {
+
+using impl::FLEXFEC_HEADER_SIZE;
+using impl::FLEXFEC_RTP_HEADER_SIZE;
+
+namespace {
+
+const size_t FLEXFEC_MASK_BITS = 15; // in the shortest mask
+const double LOSS_SMOOTHING = 0.5;
+
+void write16(byte *p, uint16_t value) {
+	p[0] = byte(value >> 8);
+	p[1] = byte(value);
+}
+
+void write32(byte *p, uint32_t value) {
+	write16(p, uint16_t(value >> 16));
+	write16(p + 2, uint16_t(value));
+}
+
+} // namespace
+
+FlexFecEncoder::FlexFecEncoder(double minProtection, double maxProtection)
+    : mMinProtection(std::clamp(minProtection, 0., 1.)),
+      mMaxProtection(std::clamp(maxProtection, mMinProtection, 1.)) {}
+
+void FlexFecEncoder::media(const Description::Media &desc) {
+	std::lock_guard lock(mMutex);
+	if (auto pt = desc.getFlexFecPayloadType())
+		mPayloadType = uint8_t(*pt);
+	else
+		mPayloadType.reset();
+
+	// Keep the sequence numbers of the existing FEC streams on renegotiation
+	std::unordered_map<SSRC, Stream> streams;
+	for (auto ssrc : desc.getSSRCs()) {
+		auto fecSsrc = desc.getFecSSRC(ssrc);
+		if (!fecSsrc)
+			continue;
+
+		if (auto it = mStreams.find(ssrc); it != mStreams.end() && it->second.fecSsrc == *fecSsrc) {
+			streams.emplace(ssrc, std::move(it->second));
+		} else {
+			// RFC 3550: The initial value of the sequence number SHOULD be random
+			auto uniform = std::uniform_int_distribution<uint32_t>(0, 0xFFFF);
+			auto engine = impl::utils::random_engine();
+			streams.emplace(ssrc, Stream{*fecSsrc, uint16_t(uniform(engine)), {}});
+		}
+	}
+	mStreams = std::move(streams);
+}
+
+void FlexFecEncoder::incoming(message_vector &messages,
+                              [[maybe_unused]] const message_callback &send) {
+	std::lock_guard lock(mMutex);
+	for (const auto &message : messages) {
+		if (message->type != Message::Control)
+			continue;
+
+		size_t offset = 0;
+		while (offset + sizeof(RtcpHeader) <= message->size()) {
+			auto header = reinterpret_cast<const RtcpHeader *>(message->data() + offset);
+			const size_t length = header->lengthInBytes();
+			if (length < sizeof(RtcpHeader) || offset + length > message->size())
+				break;
+
+			// Report blocks of sender and receiver reports
+			const RtcpReportBlock *blocks = nullptr;
+			size_t blocksSize = 0;
+			if (header->payloadType() == 200 &&
+			    length >= sizeof(RtcpSr) - sizeof(RtcpReportBlock)) {
+				auto sr = reinterpret_cast<const RtcpSr *>(header);
+				blocks = sr->getReportBlock(0);
+				blocksSize = length - (sizeof(RtcpSr) - sizeof(RtcpReportBlock));
+			} else if (header->payloadType() == 201 &&
+			           length >= sizeof(RtcpRr) - sizeof(RtcpReportBlock)) {
+				auto rr = reinterpret_cast<const RtcpRr *>(header);
+				blocks = rr->getReportBlock(0);
+				blocksSize = length - (sizeof(RtcpRr) - sizeof(RtcpReportBlock));
+			}
+
+			const size_t count =
+			    std::min(size_t(header->reportCount()), blocksSize / sizeof(RtcpReportBlock));
+			for (size_t i = 0; i < count; ++i) {
+				if (mStreams.find(blocks[i].getSSRC()) == mStreams.end())
+					continue;
+
+				const double fraction = double(blocks[i].getFractionLost()) / 256.;
+				mLoss = LOSS_SMOOTHING * mLoss + (1. - LOSS_SMOOTHING) * fraction;
+			}
+
+			offset += length;
+		}
+	}
+}
+
+void FlexFecEncoder::outgoing(message_vector &messages,
+                              [[maybe_unused]] const message_callback &send) {
+	std::lock_guard lock(mMutex);
+	if (!mPayloadType || mStreams.empty())
+		return;
+
+	const size_t size = blockSize();
+	message_vector result;
+	result.reserve(messages.size() + messages.size() / std::max(size, size_t(1)) + 1);
+	for (auto &message : messages) {
+		if (message->type != Message::Binary || message->size() < sizeof(RtpHeader)) {
+			result.push_back(std::move(message));
+			continue;
+		}
+
+		auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+		auto it = mStreams.find(rtp->ssrc());
+		if (it == mStreams.end()) {
+			result.push_back(std::move(message));
+			continue;
+		}
+
+		auto &stream = it->second;
+		if (size == 0) {
+			stream.block.clear();
+			result.push_back(std::move(message));
+			continue;
+		}
+
+		// The block must fit in the mask
+		if (!stream.block.empty()) {
+			auto first = reinterpret_cast<const RtpHeader *>(stream.block.front()->data());
+			if (uint16_t(rtp->seqNumber() - first->seqNumber()) >= FLEXFEC_MASK_BITS)
+				result.push_back(generate(stream));
+		}
+
+		const bool marker = rtp->marker();
+		stream.block.push_back(message);
+		result.push_back(std::move(message));
+
+		// Protect up to the end of the frame so it can be recovered without waiting
+		if (stream.block.size() >= size || (marker && stream.block.size() >= (size + 1) / 2))
+			result.push_back(generate(stream));
+	}
+
+	messages.swap(result);
+}
+
+double FlexFecEncoder::protection() const {
+	std::lock_guard lock(mMutex);
+	const size_t size = blockSize();
+	return size > 0 ? 1. / double(size) : 0.;
+}
+
+size_t FlexFecEncoder::blockSize() const {
+	// Requires mMutex to be locked
+	// Twice the fraction lost is protected, to cover its variance
+	const double protection = std::clamp(2. * mLoss, mMinProtection, mMaxProtection);
+	if (protection <= 0.)
+		return 0;
+
+	return std::clamp(size_t(std::ceil(1. / protection)), size_t(1), MaxBlockSize);
+}
+
+message_ptr FlexFecEncoder::generate(Stream &stream) {
+	// Requires mMutex to be locked
+	auto first = reinterpret_cast<const RtpHeader *>(stream.block.front()->data());
+	auto last = reinterpret_cast<const RtpHeader *>(stream.block.back()->data());
+	const uint16_t base = first->seqNumber();
+
+	size_t maxSize = 0;
+	for (const auto &packet : stream.block)
+		maxSize = std::max(maxSize, packet->size() - FLEXFEC_RTP_HEADER_SIZE);
+
+	const size_t headerSize = sizeof(RtpHeader) + FLEXFEC_HEADER_SIZE;
+	auto message = make_message_with_tailroom(headerSize + maxSize, DEFAULT_MEDIA_TAILROOM,
+	                                          Message::Binary);
+	message->dscp = stream.block.back()->dscp;
+	std::fill(message->begin(), message->end(), byte(0));
+
+	// See draft-ietf-payload-flexible-fec-scheme-03 4.2. FEC Header
+	auto fec = message->data() + sizeof(RtpHeader);
+	uint16_t lengthRecovery = 0;
+	uint32_t timestampRecovery = 0;
+	uint16_t mask = 0;
+	for (const auto &packet : stream.block) {
+		auto rtp = reinterpret_cast<const RtpHeader *>(packet->data());
+		fec[0] ^= packet->data()[0]; // P, X, CC
+		fec[1] ^= packet->data()[1]; // M, PT
+		lengthRecovery ^= uint16_t(packet->size() - FLEXFEC_RTP_HEADER_SIZE);
+		timestampRecovery ^= rtp->timestamp();
+		mask |= uint16_t(1 << (FLEXFEC_MASK_BITS - 1 - uint16_t(rtp->seqNumber() - base)));
+		impl::fec_xor(fec + FLEXFEC_HEADER_SIZE, packet->data() + FLEXFEC_RTP_HEADER_SIZE,
+		              packet->size() - FLEXFEC_RTP_HEADER_SIZE);
+	}
+
+	fec[0] &= byte(0x3F); // R=0, F=0
+	write16(fec + 2, lengthRecovery);
+	write32(fec + 4, timestampRecovery);
+	fec[8] = byte(1); // SSRC count
+	write32(fec + 12, first->ssrc());
+	write16(fec + 16, base);
+	write16(fec + 18, uint16_t(0x8000 | mask)); // k=1, the mask ends here
+
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(*mPayloadType);
+	rtp->setSeqNumber(stream.sequenceNumber++);
+	rtp->setTimestamp(last->timestamp());
+	rtp->setSsrc(stream.fecSsrc);
+
+	stream.block.clear();
+	return message;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "gcchandler.hpp"
+
+#include "impl/gccestimator.hpp"
+#include "impl/internals.hpp"
+#include "impl/threadpool.hpp"
+
+#include <algorithm>
+
+namespace rtc {
+
+namespace {
+
+const double PACING_FACTOR = 2.5; // the pacer must absorb the bursts from the encoder
+const double INITIAL_PROBE_FACTOR = 3.;
+const double PROBE_FACTOR = 2.;
+const auto PROBE_INTERVAL = std::chrono::seconds(5);
+const auto MAX_PADDING_DURATION = std::chrono::seconds(5); // after media starts flowing
+
+} // namespace
+
+GccHandler::GccHandler(shared_ptr<PacingHandler> pacer, unsigned int startBitrate,
+                       unsigned int minBitrate, unsigned int maxBitrate)
+    : mTwcc(std::make_shared<TwccHandler>(
+          // The TWCC handler is owned and only called by this handler
+          [this](std::vector<TwccHandler::PacketResult> results) { process(std::move(results)); })),
+      mPacer(std::move(pacer)), mMaxBitrate(std::max(minBitrate, maxBitrate)),
+      mEstimator(std::make_unique<impl::GccEstimator>(startBitrate, minBitrate, maxBitrate)) {
+	if (mPacer) {
+		const double targetBitrate = mEstimator->targetBitrate();
+		mPacer->setBitrate(targetBitrate * PACING_FACTOR);
+
+		// Padding goes through the TWCC handler so it is accounted for in feedback
+		mPacer->setPaddingHandler(mTwcc);
+		mPacer->setPaddingBitrate(targetBitrate);
+	}
+}
+
+GccHandler::~GccHandler() = default;
+
+void GccHandler::onTargetBitrate(std::function<void(unsigned int bitrate)> callback) {
+	mOnTargetBitrate = std::move(callback);
+}
+
+unsigned int GccHandler::targetBitrate() const {
+	std::lock_guard lock(mMutex);
+	return static_cast<unsigned int>(mEstimator->targetBitrate());
+}
+
+void GccHandler::media(const Description::Media &desc) { mTwcc->media(desc); }
+
+void GccHandler::incoming(message_vector &messages, const message_callback &send) {
+	mTwcc->incoming(messages, send);
+}
+
+void GccHandler::outgoing(message_vector &messages, const message_callback &send) {
+	mTwcc->outgoing(messages, send);
+
+	if (!mPacer)
+		return;
+
+	// Probe as soon as media flows, the startup ramp would take seconds otherwise
+	optional<double> probe;
+	{
+		std::lock_guard lock(mMutex);
+		if (!mEstimator->lastProbe()) {
+			mEstimator->probed(clock::now());
+			probe = std::min(mEstimator->targetBitrate() * INITIAL_PROBE_FACTOR, mMaxBitrate);
+		}
+	}
+
+	if (probe) {
+		mPacer->probe(*probe);
+
+		// Without a congestion signal, for instance on a clean link with a low-rate encoder,
+		// padding would go on forever
+		impl::ThreadPool::Instance().setTimer(MAX_PADDING_DURATION,
+		                                      weak_bind(&GccHandler::stopPadding, this));
+	}
+}
+
+void GccHandler::stopPadding() {
+	{
+		std::lock_guard lock(mMutex);
+		if (!mPadding)
+			return;
+
+		mPadding = false;
+	}
+
+	PLOG_DEBUG << "Stopping padding";
+	mPacer->setPaddingBitrate(0.);
+}
+
+void GccHandler::process(std::vector<TwccHandler::PacketResult> results) {
+	const auto now = clock::now();
+	optional<unsigned int> changed;
+	optional<double> probe;
+	optional<double> padding;
+	{
+		std::lock_guard lock(mMutex);
+		const auto previous = static_cast<unsigned int>(mEstimator->targetBitrate());
+		mEstimator->update(results, now);
+		const double targetBitrate = mEstimator->targetBitrate();
+		if (auto target = static_cast<unsigned int>(targetBitrate); target != previous)
+			changed = target;
+
+		// Probe above the target from time to time while increasing, for instance once
+		// congestion cleared
+		const auto lastProbe = mEstimator->lastProbe();
+		if (mEstimator->isIncreasing() && targetBitrate < mMaxBitrate &&
+		    (!lastProbe || now - *lastProbe >= PROBE_INTERVAL)) {
+			mEstimator->probed(now);
+			probe = std::min(targetBitrate * PROBE_FACTOR, mMaxBitrate);
+		}
+
+		// Padding fills up to the target until the first congestion signal, or for a bounded
+		// time, see outgoing()
+		if (mPadding && !mEstimator->isStartup()) {
+			mPadding = false;
+			padding = 0.;
+		} else if (mPadding && changed) {
+			padding = double(*changed);
+		}
+	}
+
+	if (changed) {
+		PLOG_VERBOSE << "Target bitrate is now " << *changed << " bps";
+		if (mPacer)
+			mPacer->setBitrate(*changed * PACING_FACTOR);
+
+		mOnTargetBitrate(*changed);
+	}
+
+	if (mPacer) {
+		if (padding)
+			mPacer->setPaddingBitrate(*padding);
+
+		if (probe) {
+			PLOG_VERBOSE << "Probing at " << *probe << " bps";
+			mPacer->probe(*probe);
+		}
+	}
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
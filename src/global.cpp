@@ -16,7 +16,20 @@
 //
 #include "global.hpp"
 
+#include "impl/certificatepool.hpp"
+#include "impl/dnscache.hpp"
+#include "impl/dtlstransport.hpp"
+#include "impl/iceportpool.hpp"
 #include "impl/init.hpp"
+#include "impl/latencyhistogram.hpp"
+#include "impl/logcounter.hpp"
+#include "impl/memoryhooks.hpp"
+#include "impl/messagepool.hpp"
+#include "impl/pollservice.hpp"
+#include "impl/processor.hpp"
+#include "impl/threadpool.hpp"
+#include "impl/tracing.hpp"
+#include "impl/utils.hpp"
 
 #include <mutex>
 
@@ -84,7 +97,75 @@ void InitLogger(plog::Severity severity, plog::IAppender *appender) {
 }
 
 void SetThreadPoolSize(unsigned int count) { impl::Init::Instance().setThreadPoolSize(count); }
+void SetPollServiceSize(unsigned int count) { impl::Init::Instance().setPollServiceSize(count); }
+void SetIceThreadCount(unsigned int count) { impl::Init::Instance().setIceThreadCount(count); }
+void SetThreadPoolSettings(ThreadPoolSettings s) {
+	impl::Init::Instance().setThreadPoolSettings(std::move(s));
+}
+size_t RunOnce(std::chrono::milliseconds timeout) {
+	return impl::ThreadPool::Instance().runExternal(timeout);
+}
+
+int GetEventDescriptor() { return impl::ThreadPool::Instance().eventDescriptor(); }
+
+optional<std::chrono::milliseconds> GetNextTaskTimeout() {
+	// Rounded up so that the loop does not wake up before the timer expires
+	auto timeout = impl::ThreadPool::Instance().nextTimeout();
+	if (!timeout)
+		return nullopt;
+
+	return std::chrono::ceil<std::chrono::milliseconds>(*timeout);
+}
+
+ThreadPoolStats GetThreadPoolStats() {
+	auto stats = impl::ThreadPool::Instance().stats();
+	stats.pendingHandshakes = impl::DtlsTransport::PendingHandshakesCount();
+	return stats;
+}
+
+TearDownStats GetTearDownStats() { return impl::TearDownProcessor::Instance().stats(); }
+
+PollServiceStats GetPollServiceStats() {
+#if RTC_ENABLE_WEBSOCKET
+	return impl::PollService::Instance().stats();
+#else
+	return {};
+#endif
+}
+
+std::vector<ThreadInfo> GetThreads() {
+	std::vector<ThreadInfo> result;
+	for (auto &[id, name] : impl::utils::registered_threads())
+		result.push_back({id, std::move(name)});
+
+	return result;
+}
+
 void SetSctpSettings(SctpSettings s) { impl::Init::Instance().setSctpSettings(std::move(s)); }
+void SetMessagePoolSettings(MessagePoolSettings s) { impl::MessagePool::Instance().setSettings(s); }
+void SetAllocator(Allocator allocator) { impl::MemoryHooks::Set(allocator); }
+void SetCertificatePoolSettings(CertificatePoolSettings s) {
+	impl::CertificatePool::Instance().setSettings(s);
+}
+void AddPooledCertificate(CertificateType type, string certificatePem, string keyPem) {
+	impl::CertificatePool::Instance().add(
+	    type, std::make_shared<impl::Certificate>(
+	              impl::Certificate::FromString(std::move(certificatePem), std::move(keyPem))));
+}
+
+void SetIcePortPoolSettings(IcePortPoolSettings s) {
+	impl::IcePortPool::Instance().setSettings(std::move(s));
+}
+
+void SetDnsCacheSettings(DnsCacheSettings s) { impl::DnsCache::Instance().setSettings(s); }
+
+void SetTearDownSettings(TearDownSettings s) { impl::TearDownProcessor::Instance().setSettings(s); }
+
+std::vector<Metric> GetMetrics() { return impl::LogCounter::Snapshot(); }
+
+std::vector<Histogram> GetLatencyHistograms() { return impl::LatencyHistogram::Snapshot(); }
+
+void SetTraceCallback(TraceCallback callback) { impl::Tracing::SetCallback(std::move(callback)); }
 
 void Preload() { impl::Init::Instance().preload(); }
 std::shared_future<void> Cleanup() { return impl::Init::Instance().cleanup(); }
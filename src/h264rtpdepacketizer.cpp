@@ -16,12 +16,14 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstring>
 
 namespace rtc {
 
 const binary naluLongStartCode = {byte{0}, byte{0}, byte{0}, byte{1}};
 const binary naluShortStartCode = {byte{0}, byte{0}, byte{1}};
 
+const uint8_t naluTypeIDR = 5;
 const uint8_t naluTypeSTAPA = 24;
 const uint8_t naluTypeFUA = 28;
 
@@ -38,13 +40,30 @@ message_ptr H264RtpDepacketizer::reassemble(message_buffer &buffer) {
 	if (buffer.empty())
 		return nullptr;
 
-	auto first = *buffer.begin();
-	auto firstRtpHeader = reinterpret_cast<const RtpHeader *>(first->data());
-	uint8_t payloadType = firstRtpHeader->payloadType();
-	uint32_t timestamp = firstRtpHeader->timestamp();
-	uint16_t nextSeqNumber = firstRtpHeader->seqNumber();
+	// Compute the size first so the frame is written at once in a pooled message
+	size_t size = 0;
+	const bool keyframe =
+	    depacketize(buffer, [&size](const byte *, size_t length) { size += length; });
+
+	auto frame = make_message(size);
+	auto data = frame->data();
+	depacketize(buffer, [&data](const byte *src, size_t length) {
+		std::memcpy(data, src, length);
+		data += length;
+	});
+
+	auto first = reinterpret_cast<const RtpHeader *>(buffer.front()->data());
+	frame->frameInfo = createFrameInfo(*first);
+	frame->frameInfo->keyframe = keyframe;
+	return frame;
+}
+
+template <typename Write>
+bool H264RtpDepacketizer::depacketize(const message_buffer &buffer, Write &&write) const {
+	auto first = reinterpret_cast<const RtpHeader *>(buffer.front()->data());
+	uint16_t nextSeqNumber = first->seqNumber();
+	bool keyframe = false;
 
-	binary frame;
 	bool continuousFragments = false;
 	for (const auto &packet : buffer) {
 		auto rtpHeader = reinterpret_cast<const rtc::RtpHeader *>(packet->data());
@@ -80,8 +99,10 @@ message_ptr H264RtpDepacketizer::reassemble(message_buffer &buffer) {
 			// unit. When the following FU payload is not the start of a fragmented NAL unit
 			// payload, the Start bit is set to zero.
 			if (nalUnitFragmentHeader.isStart()) {
-				addSeparator(frame);
-				frame.emplace_back(byte(nalUnitHeader.idc() | nalUnitFragmentHeader.unitType()));
+				keyframe |= nalUnitFragmentHeader.unitType() == naluTypeIDR;
+				writeSeparator(write);
+				const byte header{uint8_t(nalUnitHeader.idc() | nalUnitFragmentHeader.unitType())};
+				write(&header, 1);
 				continuousFragments = true;
 			}
 
@@ -89,8 +110,8 @@ message_ptr H264RtpDepacketizer::reassemble(message_buffer &buffer) {
 			// fragmentation units in transmission order corresponding to the same fragmented NAL
 			// unit.
 			if (continuousFragments) {
-				frame.insert(frame.end(), packet->begin() + rtpHeaderSize + 2,
-				             packet->end() - paddingSize);
+				write(packet->data() + rtpHeaderSize + 2,
+				      packet->size() - (rtpHeaderSize + 2) - paddingSize);
 			}
 
 			// RFC 6184: When set to one, the End bit indicates the end of a fragmented NAL unit,
@@ -115,17 +136,19 @@ message_ptr H264RtpDepacketizer::reassemble(message_buffer &buffer) {
 					if (offset + naluSize > packet->size() - paddingSize)
 						throw std::runtime_error("H264 STAP-A size is larger than payload");
 
-					addSeparator(frame);
-					frame.insert(frame.end(), packet->begin() + offset,
-					             packet->begin() + offset + naluSize);
+					keyframe |= naluSize > 0 && NalUnitHeader{std::to_integer<uint8_t>(
+					                                 packet->at(offset))}.unitType() == naluTypeIDR;
+					writeSeparator(write);
+					write(packet->data() + offset, naluSize);
 
 					offset += naluSize;
 				}
 
 			} else if (nalUnitHeader.unitType() > 0 && nalUnitHeader.unitType() < 24) {
-				addSeparator(frame);
-				frame.insert(frame.end(), packet->begin() + rtpHeaderSize,
-				             packet->end() - paddingSize);
+				keyframe |= nalUnitHeader.unitType() == naluTypeIDR;
+				writeSeparator(write);
+				write(packet->data() + rtpHeaderSize,
+				      packet->size() - rtpHeaderSize - paddingSize);
 
 			} else {
 				throw std::runtime_error("Unknown H264 RTP Packetization");
@@ -133,18 +156,18 @@ message_ptr H264RtpDepacketizer::reassemble(message_buffer &buffer) {
 		}
 	}
 
-	return make_message(std::move(frame), createFrameInfo(timestamp, payloadType));
+	return keyframe;
 }
 
-void H264RtpDepacketizer::addSeparator(binary &frame) {
+template <typename Write> void H264RtpDepacketizer::writeSeparator(Write &&write) const {
 	switch (mSeparator) {
 	case Separator::StartSequence:
 		[[fallthrough]];
 	case Separator::LongStartSequence:
-		frame.insert(frame.end(), naluLongStartCode.begin(), naluLongStartCode.end());
+		write(naluLongStartCode.data(), naluLongStartCode.size());
 		break;
 	case Separator::ShortStartSequence:
-		frame.insert(frame.end(), naluShortStartCode.begin(), naluShortStartCode.end());
+		write(naluShortStartCode.data(), naluShortStartCode.size());
 		break;
 	default:
 		throw std::invalid_argument("Invalid separator");
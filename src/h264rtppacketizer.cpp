@@ -11,9 +11,12 @@
 #include "h264rtppacketizer.hpp"
 
 #include "impl/internals.hpp"
+#include "impl/startcode.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -23,6 +26,8 @@
 
 namespace rtc {
 
+const uint8_t naluTypeFUA = 28;
+
 H264RtpPacketizer::H264RtpPacketizer(shared_ptr<RtpPacketizationConfig> rtpConfig,
                                      size_t maxFragmentSize)
     : RtpPacketizer(std::move(rtpConfig)), mSeparator(Separator::Length), mMaxFragmentSize(maxFragmentSize) {}
@@ -32,12 +37,40 @@ H264RtpPacketizer::H264RtpPacketizer(Separator separator,
                                      size_t maxFragmentSize)
     : RtpPacketizer(rtpConfig), mSeparator(separator), mMaxFragmentSize(maxFragmentSize) {}
 
-std::vector<binary> H264RtpPacketizer::fragment(binary data) {
-	return NalUnit::GenerateFragments(splitFrame(data), mMaxFragmentSize);
+bool H264RtpPacketizer::slice(const binary &frame, std::vector<Slice> &slices) {
+	const size_t maxSize = maxFragmentSize(mMaxFragmentSize);
+	splitFrame(frame, [&](size_t offset, size_t size) {
+		if (size <= maxSize) {
+			slices.push_back(Slice{offset, size});
+			return;
+		}
+
+		// RFC 6184 5.8. Fragmentation Units (FUs), fragments have about the same size
+		const uint8_t header = std::to_integer<uint8_t>(frame[offset]);
+		const double count = std::ceil(double(size) / double(maxSize));
+		const size_t fragmentSize = size_t(std::ceil(double(size) / count)) - 2;
+		const size_t payloadSize = size - 1;
+		size_t pos = 0;
+		while (pos < payloadSize) {
+			const size_t length = std::min(fragmentSize, payloadSize - pos);
+			uint8_t fuHeader = header & 0x1F;
+			if (pos == 0)
+				fuHeader |= 0x80; // Start
+			else if (pos + length == payloadSize)
+				fuHeader |= 0x40; // End
+
+			Slice slice{offset + 1 + pos, length};
+			slice.prefix = {byte((header & 0xE0) | naluTypeFUA), byte(fuHeader)};
+			slice.prefixSize = 2;
+			slices.push_back(slice);
+			pos += length;
+		}
+	});
+	return true;
 }
 
-std::vector<NalUnit> H264RtpPacketizer::splitFrame(const binary &frame) {
-	std::vector<NalUnit> nalus;
+template <typename F>
+void H264RtpPacketizer::splitFrame(const binary &frame, F &&callback) const {
 	if (mSeparator == Separator::Length) {
 		size_t index = 0;
 		while (index < frame.size()) {
@@ -57,42 +90,12 @@ std::vector<NalUnit> H264RtpPacketizer::splitFrame(const binary &frame) {
 				LOG_WARNING << "Invalid NAL Unit data (incomplete unit), ignoring!";
 				break;
 			}
-			auto begin = frame.begin() + naluStartIndex;
-			auto end = frame.begin() + naluEndIndex;
-			nalus.emplace_back(begin, end);
+			callback(naluStartIndex, naluEndIndex - naluStartIndex);
 			index = naluEndIndex;
 		}
 	} else {
-		NalUnitStartSequenceMatch match = NUSM_noMatch;
-		size_t index = 0;
-		while (index < frame.size()) {
-			match = NalUnit::StartSequenceMatchSucc(match, frame[index++], mSeparator);
-			if (match == NUSM_longMatch || match == NUSM_shortMatch) {
-				match = NUSM_noMatch;
-				break;
-			}
-		}
-
-		size_t naluStartIndex = index;
-
-		while (index < frame.size()) {
-			match = NalUnit::StartSequenceMatchSucc(match, frame[index], mSeparator);
-			if (match == NUSM_longMatch || match == NUSM_shortMatch) {
-				auto sequenceLength = match == NUSM_longMatch ? 4 : 3;
-				size_t naluEndIndex = index - sequenceLength;
-				match = NUSM_noMatch;
-				auto begin = frame.begin() + naluStartIndex;
-				auto end = frame.begin() + naluEndIndex + 1;
-				nalus.emplace_back(begin, end);
-				naluStartIndex = index + 1;
-			}
-			index++;
-		}
-		auto begin = frame.begin() + naluStartIndex;
-		auto end = frame.end();
-		nalus.emplace_back(begin, end);
+		impl::split_start_sequences(frame, mSeparator, std::forward<F>(callback));
 	}
-	return nalus;
 }
 
 } // namespace rtc
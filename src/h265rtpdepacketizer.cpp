@@ -15,12 +15,16 @@
 #include "impl/internals.hpp"
 
 #include <algorithm>
+#include <cstring>
 
 namespace rtc {
 
 const binary naluLongStartCode = {byte{0}, byte{0}, byte{0}, byte{1}};
 const binary naluShortStartCode = {byte{0}, byte{0}, byte{1}};
 
+const uint8_t naluTypeVCLMax = 31;
+const uint8_t naluTypeIRAPMin = 16;
+const uint8_t naluTypeIRAPMax = 23;
 const uint8_t naluTypeAP = 48;
 const uint8_t naluTypeFU = 49;
 
@@ -37,21 +41,57 @@ message_ptr H265RtpDepacketizer::reassemble(message_buffer &buffer) {
 	if (buffer.empty())
 		return nullptr;
 
-	auto first = *buffer.begin();
-	auto firstRtpHeader = reinterpret_cast<const RtpHeader *>(first->data());
-	uint8_t payloadType = firstRtpHeader->payloadType();
-	uint32_t timestamp = firstRtpHeader->timestamp();
-	uint16_t nextSeqNumber = firstRtpHeader->seqNumber();
+	auto first = reinterpret_cast<const RtpHeader *>(buffer.front()->data());
+	auto frameInfo = createFrameInfo(*first);
+
+	// Parse the packets once, then write the frame at once in a pooled message
+	mChunks.clear();
+	depacketize(buffer, mChunks, *frameInfo);
+
+	size_t size = 0;
+	for (const auto &chunk : mChunks)
+		size += chunk.size;
+
+	auto frame = make_message(size);
+	auto data = frame->data();
+	for (const auto &chunk : mChunks) {
+		std::memcpy(data, chunk.data ? chunk.data : chunk.header.data(), chunk.size);
+		data += chunk.size;
+	}
+
+	frame->frameInfo = std::move(frameInfo);
+	return frame;
+}
+
+void H265RtpDepacketizer::depacketize(const message_buffer &buffer, std::vector<Chunk> &chunks,
+                                      FrameInfo &info) const {
+	auto first = reinterpret_cast<const RtpHeader *>(buffer.front()->data());
+	uint16_t nextSeqNumber = first->seqNumber();
+
+	// Layers are taken from the first slice, as all slices of a picture share them
+	auto inspect = [&info](H265NalUnitHeader header) {
+		const uint8_t type = header.unitType();
+		if (type > naluTypeVCLMax)
+			return;
+
+		info.keyframe |= type >= naluTypeIRAPMin && type <= naluTypeIRAPMax;
+		if (!info.spatialLayer && header.nuhTempIdPlus1() > 0) {
+			info.spatialLayer = header.nuhLayerId();
+			info.temporalLayer = uint8_t(header.nuhTempIdPlus1() - 1);
+		}
+	};
 
-	binary frame;
 	bool continuousFragments = false;
 	for (const auto &packet : buffer) {
 		auto rtpHeader = reinterpret_cast<const rtc::RtpHeader *>(packet->data());
-		if (rtpHeader->seqNumber() < nextSeqNumber) {
+
+		// Compare sequence numbers modulo 2^16, as the frame may span a wraparound
+		const auto seqDiff = int16_t(uint16_t(rtpHeader->seqNumber() - nextSeqNumber));
+		if (seqDiff < 0) {
 			// Skip
 			continue;
 		}
-		if (rtpHeader->seqNumber() > nextSeqNumber) {
+		if (seqDiff > 0) {
 			// Missing packet(s)
 			continuousFragments = false;
 		}
@@ -59,46 +99,46 @@ message_ptr H265RtpDepacketizer::reassemble(message_buffer &buffer) {
 		nextSeqNumber = rtpHeader->seqNumber() + 1;
 
 		auto rtpHeaderSize = rtpHeader->getSize() + rtpHeader->getExtensionHeaderSize();
-		auto paddingSize = 0;
+		size_t paddingSize = 0;
 		if (rtpHeader->padding())
 			paddingSize = std::to_integer<uint8_t>(packet->back());
 
 		if (packet->size() <= rtpHeaderSize + paddingSize)
 			continue; // Empty payload
 
-		size_t payloadSize = packet->size() - (rtpHeaderSize + paddingSize);
+		// Bounds are checked once here, so the payload is accessed directly below
+		const byte *payload = packet->data() + rtpHeaderSize;
+		const size_t payloadSize = packet->size() - (rtpHeaderSize + paddingSize);
 		if (payloadSize < 2)
 			throw std::runtime_error("Truncated H265 NAL unit");
 
-		auto nalUnitHeader =
-		    H265NalUnitHeader{std::to_integer<uint8_t>(packet->at(rtpHeaderSize)),
-		                      std::to_integer<uint8_t>(packet->at(rtpHeaderSize + 1))};
+		auto nalUnitHeader = H265NalUnitHeader{std::to_integer<uint8_t>(payload[0]),
+		                                       std::to_integer<uint8_t>(payload[1])};
 
 		if (nalUnitHeader.unitType() == naluTypeFU) {
 			if (payloadSize <= 2)
 				continue; // Empty FU
 
 			auto nalUnitFragmentHeader =
-			    H265NalUnitFragmentHeader{std::to_integer<uint8_t>(packet->at(rtpHeaderSize + 2))};
+			    H265NalUnitFragmentHeader{std::to_integer<uint8_t>(payload[2])};
 
 			// RFC 7798: When set to 1, the S bit indicates the start of a fragmented
 			// NAL unit, i.e., the first byte of the FU payload is also the first byte of
 			// the payload of the fragmented NAL unit. When the FU payload is not the start
 			// of the fragmented NAL unit payload, the S bit MUST be set to 0.
 			if (nalUnitFragmentHeader.isStart()) {
-				addSeparator(frame);
+				addSeparator(chunks);
 				nalUnitHeader.setUnitType(nalUnitFragmentHeader.unitType());
-				frame.emplace_back(byte(nalUnitHeader._first));
-				frame.emplace_back(byte(nalUnitHeader._second));
+				inspect(nalUnitHeader);
+				chunks.push_back(
+				    Chunk{nullptr, 2, {byte(nalUnitHeader._first), byte(nalUnitHeader._second)}});
 				continuousFragments = true;
 			}
 
 			// RFC 7798: If an FU is lost, the receiver SHOULD discard all following fragmentation
 			// units in transmission order corresponding to the same fragmented NAL unit
-			if (continuousFragments) {
-				frame.insert(frame.end(), packet->begin() + rtpHeaderSize + 3,
-				             packet->end() - paddingSize);
-			}
+			if (continuousFragments)
+				chunks.push_back(Chunk{payload + 3, payloadSize - 3, {}});
 
 			// RFC 7798: When set to 1, the E bit indicates the end of a fragmented NAL unit, i.e.,
 			// the last byte of the payload is also the last byte of the fragmented NAL unit.  When
@@ -111,20 +151,22 @@ message_ptr H265RtpDepacketizer::reassemble(message_buffer &buffer) {
 			continuousFragments = false;
 
 			if (nalUnitHeader.unitType() == naluTypeAP) {
-				auto offset = rtpHeaderSize + 2;
-
-				while (offset + 2 < packet->size() - paddingSize) {
-					auto naluSize = std::to_integer<uint16_t>(packet->at(offset)) << 8 |
-					                std::to_integer<uint16_t>(packet->at(offset + 1));
+				size_t offset = 2;
+				while (offset + 2 < payloadSize) {
+					size_t naluSize = std::to_integer<size_t>(payload[offset]) << 8 |
+					                  std::to_integer<size_t>(payload[offset + 1]);
 
 					offset += 2;
 
-					if (offset + naluSize > packet->size() - paddingSize)
+					if (offset + naluSize > payloadSize)
 						throw std::runtime_error("H265 STAP size is larger than payload");
 
-					addSeparator(frame);
-					frame.insert(frame.end(), packet->begin() + offset,
-					             packet->begin() + offset + naluSize);
+					if (naluSize >= 2)
+						inspect(H265NalUnitHeader{std::to_integer<uint8_t>(payload[offset]),
+						                          std::to_integer<uint8_t>(payload[offset + 1])});
+
+					addSeparator(chunks);
+					chunks.push_back(Chunk{payload + offset, naluSize, {}});
 
 					offset += naluSize;
 				}
@@ -132,9 +174,9 @@ message_ptr H265RtpDepacketizer::reassemble(message_buffer &buffer) {
 			} else if (nalUnitHeader.unitType() < 47) {
 				// RFC 7798: NAL units with NAL unit type values in the range of 0 to 47, inclusive,
 				// may be passed to the decoder.
-				addSeparator(frame);
-				frame.insert(frame.end(), packet->begin() + rtpHeaderSize,
-				             packet->end() - paddingSize);
+				inspect(nalUnitHeader);
+				addSeparator(chunks);
+				chunks.push_back(Chunk{payload, payloadSize, {}});
 
 			} else {
 				// RFC 7798: NAL-unit-like structures with NAL unit type values in the range of 48
@@ -142,19 +184,17 @@ message_ptr H265RtpDepacketizer::reassemble(message_buffer &buffer) {
 			}
 		}
 	}
-
-	return make_message(std::move(frame), createFrameInfo(timestamp, payloadType));
 }
 
-void H265RtpDepacketizer::addSeparator(binary &frame) {
+void H265RtpDepacketizer::addSeparator(std::vector<Chunk> &chunks) const {
 	switch (mSeparator) {
 	case Separator::StartSequence:
 		[[fallthrough]];
 	case Separator::LongStartSequence:
-		frame.insert(frame.end(), naluLongStartCode.begin(), naluLongStartCode.end());
+		chunks.push_back(Chunk{naluLongStartCode.data(), naluLongStartCode.size(), {}});
 		break;
 	case Separator::ShortStartSequence:
-		frame.insert(frame.end(), naluShortStartCode.begin(), naluShortStartCode.end());
+		chunks.push_back(Chunk{naluShortStartCode.data(), naluShortStartCode.size(), {}});
 		break;
 	default:
 		throw std::invalid_argument("Invalid separator");
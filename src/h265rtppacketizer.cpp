@@ -11,8 +11,12 @@
 #include "h265rtppacketizer.hpp"
 
 #include "impl/internals.hpp"
+#include "impl/startcode.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -22,6 +26,8 @@
 
 namespace rtc {
 
+const uint8_t naluTypeFU = 49;
+
 H265RtpPacketizer::H265RtpPacketizer(shared_ptr<RtpPacketizationConfig> rtpConfig,
                                      size_t maxFragmentSize)
     : RtpPacketizer(std::move(rtpConfig)), mSeparator(NalUnit::Separator::Length),
@@ -32,12 +38,42 @@ H265RtpPacketizer::H265RtpPacketizer(NalUnit::Separator separator,
                                      size_t maxFragmentSize)
     : RtpPacketizer(std::move(rtpConfig)), mSeparator(separator), mMaxFragmentSize(maxFragmentSize) {}
 
-std::vector<binary> H265RtpPacketizer::fragment(binary data) {
-	return H265NalUnit::GenerateFragments(splitFrame(data), mMaxFragmentSize);
+bool H265RtpPacketizer::slice(const binary &frame, std::vector<Slice> &slices) {
+	const size_t maxSize = maxFragmentSize(mMaxFragmentSize);
+	splitFrame(frame, [&](size_t offset, size_t size) {
+		if (size <= maxSize) {
+			slices.push_back(Slice{offset, size});
+			return;
+		}
+
+		// RFC 7798 4.4.3. Fragmentation Units, fragments have about the same size
+		const uint8_t first = std::to_integer<uint8_t>(frame[offset]);
+		const uint8_t second = std::to_integer<uint8_t>(frame[offset + 1]);
+		const double count = std::ceil(double(size) / double(maxSize));
+		const size_t fragmentSize = size_t(std::ceil(double(size) / count)) -
+		                            (H265_NAL_HEADER_SIZE + H265_FU_HEADER_SIZE);
+		const size_t payloadSize = size - H265_NAL_HEADER_SIZE;
+		size_t pos = 0;
+		while (pos < payloadSize) {
+			const size_t length = std::min(fragmentSize, payloadSize - pos);
+			uint8_t fuHeader = (first >> 1) & 0x3F;
+			if (pos == 0)
+				fuHeader |= 0x80; // Start
+			else if (pos + length == payloadSize)
+				fuHeader |= 0x40; // End
+
+			Slice slice{offset + H265_NAL_HEADER_SIZE + pos, length};
+			slice.prefix = {byte((first & 0x81) | (naluTypeFU << 1)), byte(second), byte(fuHeader)};
+			slice.prefixSize = H265_NAL_HEADER_SIZE + H265_FU_HEADER_SIZE;
+			slices.push_back(slice);
+			pos += length;
+		}
+	});
+	return true;
 }
 
-std::vector<H265NalUnit> H265RtpPacketizer::splitFrame(const binary &frame) {
-	std::vector<H265NalUnit> nalus;
+template <typename F>
+void H265RtpPacketizer::splitFrame(const binary &frame, F &&callback) const {
 	if (mSeparator == NalUnit::Separator::Length) {
 		size_t index = 0;
 		while (index < frame.size()) {
@@ -57,42 +93,12 @@ std::vector<H265NalUnit> H265RtpPacketizer::splitFrame(const binary &frame) {
 				LOG_WARNING << "Invalid NAL Unit data (incomplete unit), ignoring!";
 				break;
 			}
-			auto begin = frame.begin() + naluStartIndex;
-			auto end = frame.begin() + naluEndIndex;
-			nalus.emplace_back(begin, end);
+			callback(naluStartIndex, naluEndIndex - naluStartIndex);
 			index = naluEndIndex;
 		}
 	} else {
-		NalUnitStartSequenceMatch match = NUSM_noMatch;
-		size_t index = 0;
-		while (index < frame.size()) {
-			match = NalUnit::StartSequenceMatchSucc(match, frame[index++], mSeparator);
-			if (match == NUSM_longMatch || match == NUSM_shortMatch) {
-				match = NUSM_noMatch;
-				break;
-			}
-		}
-
-		size_t naluStartIndex = index;
-
-		while (index < frame.size()) {
-			match = NalUnit::StartSequenceMatchSucc(match, frame[index], mSeparator);
-			if (match == NUSM_longMatch || match == NUSM_shortMatch) {
-				auto sequenceLength = match == NUSM_longMatch ? 4 : 3;
-				size_t naluEndIndex = index - sequenceLength;
-				match = NUSM_noMatch;
-				auto begin = frame.begin() + naluStartIndex;
-				auto end = frame.begin() + naluEndIndex + 1;
-				nalus.emplace_back(begin, end);
-				naluStartIndex = index + 1;
-			}
-			index++;
-		}
-		auto begin = frame.begin() + naluStartIndex;
-		auto end = frame.end();
-		nalus.emplace_back(begin, end);
+		impl::split_start_sequences(frame, mSeparator, std::forward<F>(callback));
 	}
-	return nalus;
 }
 
 } // namespace rtc
@@ -13,8 +13,9 @@
 
 namespace rtc {
 
-IceUdpMuxListener::IceUdpMuxListener(uint16_t port, optional<string> bindAddress)
-    : CheshireCat<impl::IceUdpMuxListener>(port, std::move(bindAddress)) {}
+IceUdpMuxListener::IceUdpMuxListener(uint16_t port, optional<string> bindAddress,
+                                     unsigned int shards)
+    : CheshireCat<impl::IceUdpMuxListener>(port, std::move(bindAddress), shards) {}
 
 IceUdpMuxListener::~IceUdpMuxListener() {}
 
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "candidatepaircache.hpp"
+#include "internals.hpp"
+
+namespace rtc::impl {
+
+namespace {
+
+// RFC 8445 5.1.2.1. The priority MUST be a positive integer between 1 and (2**31 - 1)
+const uint32_t MAX_PRIORITY = 0x7FFFFFFF;
+
+const char *type_string(Candidate::Type type) {
+	switch (type) {
+	case Candidate::Type::Host:
+		return "host";
+	case Candidate::Type::ServerReflexive:
+		return "srflx";
+	case Candidate::Type::PeerReflexive:
+		return "prflx";
+	default:
+		return nullptr;
+	}
+}
+
+} // namespace
+
+CandidatePairCache &CandidatePairCache::Instance() {
+	static CandidatePairCache *instance = new CandidatePairCache;
+	return *instance;
+}
+
+CandidatePairCache::CandidatePairCache() {}
+
+CandidatePairCache::~CandidatePairCache() {}
+
+optional<Candidate> CandidatePairCache::retrieve(const string &key) {
+	Candidate remote;
+	{
+		std::lock_guard lock(mMutex);
+		auto it = mIndex.find(key);
+		if (it == mIndex.end())
+			return nullopt;
+
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		remote = it->second->second;
+	}
+
+	// The remote priority only orders our checks, the peer computes pair priorities from the
+	// priority we advertise in requests
+	string sdp = "candidate:cached 1 UDP " + std::to_string(MAX_PRIORITY) + ' ' +
+	             *remote.address() + ' ' + std::to_string(*remote.port()) + " typ " +
+	             type_string(remote.type());
+
+	Candidate candidate(std::move(sdp));
+	candidate.resolve(Candidate::ResolveMode::Simple);
+	return candidate;
+}
+
+void CandidatePairCache::store(const string &key, Candidate remote) {
+	if (!remote.isResolved() || remote.transportType() != Candidate::TransportType::Udp ||
+	    !type_string(remote.type())) {
+		erase(key);
+		return;
+	}
+
+	PLOG_DEBUG << "Caching selected remote candidate " << *remote.address() << ':'
+	           << *remote.port();
+
+	std::lock_guard lock(mMutex);
+	if (auto it = mIndex.find(key); it != mIndex.end()) {
+		it->second->second = std::move(remote);
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		return;
+	}
+
+	mEntries.emplace_front(key, std::move(remote));
+	mIndex.emplace(key, mEntries.begin());
+
+	if (mEntries.size() > MaxEntriesCount) {
+		mIndex.erase(mEntries.back().first);
+		mEntries.pop_back();
+	}
+}
+
+void CandidatePairCache::erase(const string &key) {
+	std::lock_guard lock(mMutex);
+	if (auto it = mIndex.find(key); it != mIndex.end()) {
+		mEntries.erase(it->second);
+		mIndex.erase(it);
+	}
+}
+
+void CandidatePairCache::clear() {
+	std::lock_guard lock(mMutex);
+	mIndex.clear();
+	mEntries.clear();
+}
+
+} // namespace rtc::impl
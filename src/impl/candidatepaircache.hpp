@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_CANDIDATE_PAIR_CACHE_H
+#define RTC_IMPL_CANDIDATE_PAIR_CACHE_H
+
+#include "candidate.hpp"
+#include "common.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace rtc::impl {
+
+// Cache of the remote candidates of the last selected pairs, keyed by remote fingerprint, so that
+// connections to a known peer check the pair which succeeded last time first. Least recently used
+// entries are evicted.
+class CandidatePairCache final {
+public:
+	static CandidatePairCache &Instance();
+
+	CandidatePairCache(const CandidatePairCache &) = delete;
+	CandidatePairCache &operator=(const CandidatePairCache &) = delete;
+	CandidatePairCache(CandidatePairCache &&) = delete;
+	CandidatePairCache &operator=(CandidatePairCache &&) = delete;
+
+	// Returns the remote candidate with the highest priority, so that its pairs are checked first
+	optional<Candidate> retrieve(const string &key);
+
+	// Only direct UDP candidates are stored, as relayed addresses change on each allocation
+	void store(const string &key, Candidate remote);
+	void erase(const string &key);
+	void clear();
+
+private:
+	CandidatePairCache();
+	~CandidatePairCache();
+
+	static constexpr size_t MaxEntriesCount = 1024;
+
+	using Entry = std::pair<string, Candidate>;
+	std::list<Entry> mEntries; // most recently used first
+	std::unordered_map<string, std::list<Entry>::iterator> mIndex;
+	std::mutex mMutex;
+};
+
+} // namespace rtc::impl
+
+#endif
@@ -7,6 +7,7 @@
  */
 
 #include "certificate.hpp"
+#include "certificatepool.hpp"
 #include "threadpool.hpp"
 
 #include <algorithm>
@@ -595,9 +596,7 @@ string make_fingerprint(X509 *x509, CertificateFingerprint::Algorithm fingerprin
 // Common for GnuTLS, Mbed TLS, and OpenSSL
 
 future_certificate_ptr make_certificate(CertificateType type) {
-	return ThreadPool::Instance().enqueue([type, token = Init::Instance().token()]() {
-		return std::make_shared<Certificate>(Certificate::Generate(type, "libdatachannel"));
-	});
+	return CertificatePool::Instance().get(type);
 }
 
 CertificateFingerprint Certificate::fingerprint() const {
@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "certificatepool.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace rtc::impl {
+
+namespace {
+
+certificate_ptr generate_certificate(CertificateType type) {
+	return std::make_shared<Certificate>(Certificate::Generate(type, "libdatachannel"));
+}
+
+} // namespace
+
+CertificatePool &CertificatePool::Instance() {
+	static CertificatePool *instance = new CertificatePool;
+	return *instance;
+}
+
+CertificatePool::CertificatePool() { mBuckets[Index(CertificateType::Default)].requested = true; }
+
+CertificatePool::~CertificatePool() {}
+
+void CertificatePool::setSettings(const CertificatePoolSettings &s) {
+	std::vector<Entry> dropped; // destroyed after unlocking
+	std::lock_guard lock(mMutex);
+	mSize = s.size.value_or(DefaultSize);
+	mRotationInterval = s.rotationInterval
+	                        ? std::chrono::duration_cast<clock::duration>(*s.rotationInterval)
+	                        : DefaultRotationInterval;
+
+	for (size_t i = 0; i < TypesCount; ++i) {
+		auto &entries = mBuckets[i].entries;
+		while (entries.size() > mSize) {
+			dropped.push_back(std::move(entries.back()));
+			entries.pop_back();
+		}
+		refill(i);
+	}
+}
+
+void CertificatePool::start() {
+	std::lock_guard lock(mMutex);
+	if (std::exchange(mStarted, true))
+		return;
+
+	PLOG_DEBUG << "Starting certificate pool, size=" << mSize;
+	for (size_t i = 0; i < TypesCount; ++i)
+		refill(i);
+
+	scheduleRotation();
+}
+
+void CertificatePool::stop() {
+	std::vector<Entry> dropped; // destroyed after unlocking
+	std::lock_guard lock(mMutex);
+	if (mStarted) {
+		PLOG_DEBUG << "Stopping certificate pool";
+	}
+
+	mStarted = false;
+	mRotationScheduled = false;
+	++mEpoch; // invalidate the scheduled rotation
+	for (auto &bucket : mBuckets) {
+		std::move(bucket.entries.begin(), bucket.entries.end(), std::back_inserter(dropped));
+		bucket.entries.clear();
+	}
+}
+
+future_certificate_ptr CertificatePool::get(CertificateType type) {
+	const size_t index = Index(type);
+	std::vector<Entry> dropped; // destroyed after unlocking
+	std::unique_lock lock(mMutex);
+	auto &bucket = mBuckets[index];
+	bucket.requested = true;
+	expire(clock::now(), dropped);
+
+	if (!bucket.entries.empty()) {
+		PLOG_VERBOSE << "Using pooled certificate";
+		std::promise<certificate_ptr> promise;
+		promise.set_value(std::move(bucket.entries.front().certificate));
+		bucket.entries.pop_front();
+		refill(index);
+		return promise.get_future().share();
+	}
+
+	refill(index);
+	lock.unlock();
+
+	if (ThreadPool::Instance().isExternal()) {
+		// Waiting for a task would block the external loop which is supposed to run it
+		PLOG_DEBUG << "Certificate pool is empty, generating certificate synchronously";
+		std::promise<certificate_ptr> promise;
+		promise.set_value(generate_certificate(type));
+		return promise.get_future().share();
+	}
+
+	PLOG_DEBUG << "Certificate pool is empty, generating certificate";
+	return ThreadPool::Control().enqueue(
+	    [type, token = Init::Instance().token()]() { return generate_certificate(type); });
+}
+
+void CertificatePool::add(CertificateType type, certificate_ptr certificate) {
+	if (!certificate)
+		throw std::invalid_argument("Pooled certificate is null");
+
+	std::lock_guard lock(mMutex);
+	mBuckets[Index(type)].entries.push_back({std::move(certificate), clock::now()});
+	scheduleRotation();
+}
+
+size_t CertificatePool::Index(CertificateType type) {
+	switch (type) {
+	case CertificateType::Default:
+	case CertificateType::Ecdsa:
+		return 0;
+	case CertificateType::Rsa:
+		return 1;
+	default:
+		throw std::invalid_argument("Unknown certificate type");
+	}
+}
+
+CertificateType CertificatePool::Type(size_t index) {
+	return index == 0 ? CertificateType::Ecdsa : CertificateType::Rsa;
+}
+
+void CertificatePool::refill(size_t index) {
+	// Requires mMutex to be locked
+	auto &bucket = mBuckets[index];
+	if (!mStarted || !bucket.requested || bucket.refilling || bucket.entries.size() >= mSize)
+		return;
+
+	// Certificates are generated one at a time per type not to hog the thread pool
+	bucket.refilling = true;
+	ThreadPool::Control().post([this, index, token = Init::Instance().token()]() {
+		certificate_ptr certificate;
+		try {
+			certificate = generate_certificate(Type(index));
+		} catch (const std::exception &e) {
+			PLOG_WARNING << "Failed to generate pooled certificate: " << e.what();
+		}
+		generated(index, std::move(certificate));
+	});
+}
+
+void CertificatePool::expire(clock::time_point now, std::vector<Entry> &dropped) {
+	// Requires mMutex to be locked
+	for (auto &bucket : mBuckets)
+		while (!bucket.entries.empty() && now - bucket.entries.front().time >= mRotationInterval) {
+			dropped.push_back(std::move(bucket.entries.front()));
+			bucket.entries.pop_front();
+		}
+}
+
+void CertificatePool::generated(size_t index, certificate_ptr certificate) {
+	std::lock_guard lock(mMutex);
+	auto &bucket = mBuckets[index];
+	bucket.refilling = false;
+	if (!certificate || !mStarted || bucket.entries.size() >= mSize)
+		return; // a failed generation is not retried until the next request
+
+	bucket.entries.push_back({std::move(certificate), clock::now()});
+	refill(index);
+	scheduleRotation();
+}
+
+void CertificatePool::scheduleRotation() {
+	// Requires mMutex to be locked
+	if (!mStarted || mRotationScheduled)
+		return;
+
+	// Entries are sorted by time in each bucket, so the oldest one is in front
+	optional<clock::time_point> oldest;
+	for (const auto &bucket : mBuckets)
+		if (!bucket.entries.empty() && (!oldest || bucket.entries.front().time < *oldest))
+			oldest = bucket.entries.front().time;
+
+	if (!oldest)
+		return;
+
+	mRotationScheduled = true;
+	ThreadPool::Instance().schedule(*oldest + mRotationInterval,
+	                                [this, epoch = mEpoch]() { rotate(epoch); });
+}
+
+void CertificatePool::rotate(unsigned int epoch) {
+	std::vector<Entry> dropped; // destroyed after unlocking
+	std::lock_guard lock(mMutex);
+	if (!mStarted || epoch != mEpoch)
+		return;
+
+	mRotationScheduled = false;
+	expire(clock::now(), dropped);
+
+	PLOG_VERBOSE << "Rotating pooled certificates, expired=" << dropped.size();
+	for (size_t i = 0; i < TypesCount; ++i)
+		refill(i);
+
+	scheduleRotation();
+}
+
+} // namespace rtc::impl
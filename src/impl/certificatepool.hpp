@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_CERTIFICATE_POOL_H
+#define RTC_IMPL_CERTIFICATE_POOL_H
+
+#include "certificate.hpp"
+#include "common.hpp"
+#include "global.hpp" // for CertificatePoolSettings
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace rtc::impl {
+
+// Keeps certificates generated in advance so that creating a PeerConnection does not wait for key
+// generation. The pool is refilled in the background while the library is preloaded, since pooled
+// certificates hold init tokens. The default type is warmed on start, the others once requested.
+class CertificatePool final {
+public:
+	static CertificatePool &Instance();
+
+	CertificatePool(const CertificatePool &) = delete;
+	CertificatePool &operator=(const CertificatePool &) = delete;
+	CertificatePool(CertificatePool &&) = delete;
+	CertificatePool &operator=(CertificatePool &&) = delete;
+
+	void setSettings(const CertificatePoolSettings &s);
+
+	void start(); // start refilling, called on preload
+	void stop();  // stop refilling and drop pooled certificates, called on cleanup
+
+	future_certificate_ptr get(CertificateType type); // falls back to generating if empty
+	void add(CertificateType type, certificate_ptr certificate);
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	CertificatePool();
+	~CertificatePool();
+
+	static constexpr size_t TypesCount = 2; // ECDSA and RSA
+	static constexpr size_t DefaultSize = 2; // per type
+	static constexpr auto DefaultRotationInterval = std::chrono::hours(1);
+
+	struct Entry {
+		certificate_ptr certificate;
+		clock::time_point time;
+	};
+
+	struct Bucket {
+		std::deque<Entry> entries;
+		bool requested = false; // refilled only once requested
+		bool refilling = false;
+	};
+
+	static size_t Index(CertificateType type);
+	static CertificateType Type(size_t index);
+
+	// The following require mMutex to be locked
+	void refill(size_t index);
+	void expire(clock::time_point now, std::vector<Entry> &dropped);
+	void scheduleRotation();
+
+	void generated(size_t index, certificate_ptr certificate);
+	void rotate(unsigned int epoch);
+
+	std::array<Bucket, TypesCount> mBuckets;
+	bool mStarted = false;
+	bool mRotationScheduled = false;
+	unsigned int mEpoch = 0; // incremented on stop
+	size_t mSize = DefaultSize;
+	clock::duration mRotationInterval = DefaultRotationInterval;
+	std::mutex mMutex;
+};
+
+} // namespace rtc::impl
+
+#endif
@@ -9,8 +9,18 @@
 #include "channel.hpp"
 #include "internals.hpp"
 
+#include <algorithm>
+
 namespace rtc::impl {
 
+std::vector<message_ptr> Channel::receiveMessages() {
+	std::vector<message_ptr> messages;
+	while (auto next = receiveMessage())
+		messages.emplace_back(std::move(*next));
+
+	return messages;
+}
+
 void Channel::triggerOpen() {
 	mOpenTriggered = true;
 	try {
@@ -37,7 +47,7 @@ void Channel::triggerError(string error) {
 	}
 }
 
-void Channel::triggerAvailable(size_t count) {
+void Channel::triggerAvailable(size_t count, bool flush) {
 	if (count == 1) {
 		try {
 			availableCallback();
@@ -46,11 +56,31 @@ void Channel::triggerAvailable(size_t count) {
 		}
 	}
 
-	flushPendingMessages();
+	if (flush)
+		flushPendingMessages();
 }
 
 void Channel::triggerBufferedAmount(size_t amount) {
 	size_t previous = bufferedAmount.exchange(amount);
+	triggerBufferedAmountLow(previous, amount);
+	if (amount < previous)
+		triggerBufferedAmountDecrease(amount);
+}
+
+void Channel::updateBufferedAmount(ptrdiff_t delta) {
+	size_t previous = bufferedAmount.load();
+	size_t amount;
+	do {
+		amount = size_t(std::max(ptrdiff_t(previous) + delta, ptrdiff_t(0)));
+	} while (!bufferedAmount.compare_exchange_weak(previous, amount));
+
+	triggerBufferedAmountLow(previous, amount);
+	if (amount < previous)
+		triggerBufferedAmountDecrease(amount);
+}
+
+void Channel::triggerBufferedAmountLow(size_t previous, size_t amount) {
+	// Only a crossing of the threshold triggers the callback
 	size_t threshold = bufferedAmountLowThreshold.load();
 	if (previous > threshold && amount <= threshold) {
 		try {
@@ -61,17 +91,33 @@ void Channel::triggerBufferedAmount(size_t amount) {
 	}
 }
 
+void Channel::triggerBufferedAmountDecrease(size_t) {}
+
 void Channel::flushPendingMessages() {
 	if (!mOpenTriggered)
 		return;
 
-	while (messageCallback) {
-		auto next = receive();
-		if (!next)
-			break;
-
+	while (messagesCallback || messageViewCallback || messageCallback) {
 		try {
-			messageCallback(*next);
+			if (messagesCallback) {
+				auto messages = receiveMessages();
+				if (messages.empty())
+					break;
+
+				messagesCallback(std::move(messages));
+			} else if (messageViewCallback) {
+				auto next = receiveMessage();
+				if (!next)
+					break;
+
+				messageViewCallback(std::move(*next));
+			} else {
+				auto next = receive();
+				if (!next)
+					break;
+
+				messageCallback(std::move(*next));
+			}
 		} catch (const std::exception &e) {
 			PLOG_WARNING << "Uncaught exception in callback: " << e.what();
 		}
@@ -91,6 +137,8 @@ void Channel::resetCallbacks() {
 	availableCallback = nullptr;
 	bufferedAmountLowCallback = nullptr;
 	messageCallback = nullptr;
+	messageViewCallback = nullptr;
+	messagesCallback = nullptr;
 }
 
 } // namespace rtc::impl
@@ -20,13 +20,17 @@ namespace rtc::impl {
 struct Channel {
 	virtual optional<message_variant> receive() = 0;
 	virtual optional<message_variant> peek() = 0;
+	virtual optional<message_ptr> receiveMessage() = 0; // without conversion
+	virtual optional<message_ptr> peekMessage() = 0;
+	virtual std::vector<message_ptr> receiveMessages(); // all available, without conversion
 	virtual size_t availableAmount() const = 0;
 
 	virtual void triggerOpen();
 	virtual void triggerClosed();
 	virtual void triggerError(string error);
-	virtual void triggerAvailable(size_t count);
+	virtual void triggerAvailable(size_t count, bool flush = true); // flush pending messages
 	virtual void triggerBufferedAmount(size_t amount);
+	void updateBufferedAmount(ptrdiff_t delta); // lock-free
 
 	virtual void flushPendingMessages();
 	void resetOpenCallback();
@@ -39,11 +43,16 @@ struct Channel {
 	synchronized_stored_callback<> bufferedAmountLowCallback;
 
 	synchronized_callback<message_variant> messageCallback;
+	synchronized_callback<message_ptr> messageViewCallback; // takes precedence
+	synchronized_callback<std::vector<message_ptr>> messagesCallback; // takes precedence too
 
 	std::atomic<size_t> bufferedAmount = 0;
 	std::atomic<size_t> bufferedAmountLowThreshold = 0;
 
 protected:
+	void triggerBufferedAmountLow(size_t previous, size_t amount);
+	virtual void triggerBufferedAmountDecrease(size_t amount);
+
 	std::atomic<bool> mOpenTriggered = false;
 };
 
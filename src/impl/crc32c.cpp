@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define RTC_CRC32C_SSE42 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h> // for __cpuid and _mm_crc32_*
+#define RTC_CRC32C_SSE42 1
+#elif (defined(__ARM_FEATURE_CRC32) && !defined(__ARM_BIG_ENDIAN)) || defined(_M_ARM64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <arm_acle.h>
+#endif
+#define RTC_CRC32C_ARM 1
+#endif
+
+namespace rtc::impl {
+
+namespace {
+
+constexpr uint32_t Polynomial = 0x82F63B78; // reversed 0x1EDC6F41
+
+constexpr std::array<uint32_t, 256> make_table() {
+	std::array<uint32_t, 256> table = {};
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t c = i;
+		for (int k = 0; k < 8; ++k)
+			c = (c & 1) ? (c >> 1) ^ Polynomial : c >> 1;
+
+		table[i] = c;
+	}
+	return table;
+}
+
+constexpr auto Table = make_table();
+
+uint32_t crc32c_software(uint32_t crc, const byte *data, size_t size) {
+	for (size_t i = 0; i < size; ++i)
+		crc = Table[(crc ^ std::to_integer<uint32_t>(data[i])) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if RTC_CRC32C_SSE42
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("sse4.2")))
+#endif
+uint32_t crc32c_sse42(uint32_t crc, const byte *data, size_t size) {
+	const byte *p = data;
+	const byte *end = data + size;
+#if defined(__x86_64__) || defined(_M_X64)
+	uint64_t crc64 = crc;
+	for (; end - p >= 8; p += 8) {
+		uint64_t v;
+		std::memcpy(&v, p, 8);
+		crc64 = _mm_crc32_u64(crc64, v);
+	}
+	crc = uint32_t(crc64);
+#endif
+	for (; end - p >= 4; p += 4) {
+		uint32_t v;
+		std::memcpy(&v, p, 4);
+		crc = _mm_crc32_u32(crc, v);
+	}
+	for (; p != end; ++p)
+		crc = _mm_crc32_u8(crc, std::to_integer<uint8_t>(*p));
+
+	return crc;
+}
+
+bool has_sse42() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 20)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+#elif RTC_CRC32C_ARM
+
+uint32_t crc32c_arm(uint32_t crc, const byte *data, size_t size) {
+	const byte *p = data;
+	const byte *end = data + size;
+	for (; end - p >= 8; p += 8) {
+		uint64_t v;
+		std::memcpy(&v, p, 8);
+		crc = __crc32cd(crc, v);
+	}
+	for (; p != end; ++p)
+		crc = __crc32cb(crc, std::to_integer<uint8_t>(*p));
+
+	return crc;
+}
+
+#endif
+
+} // namespace
+
+bool crc32c_accelerated() {
+#if RTC_CRC32C_SSE42
+	static const bool accelerated = has_sse42();
+	return accelerated;
+#elif RTC_CRC32C_ARM
+	return true; // enabled at compile time
+#else
+	return false;
+#endif
+}
+
+// Instructions consume the data in little-endian words, which matches the reflected CRC
+uint32_t crc32c(const byte *data, size_t size) {
+	uint32_t crc = 0xFFFFFFFF;
+#if RTC_CRC32C_SSE42
+	if (crc32c_accelerated())
+		crc = crc32c_sse42(crc, data, size);
+	else
+		crc = crc32c_software(crc, data, size);
+#elif RTC_CRC32C_ARM
+	crc = crc32c_arm(crc, data, size);
+#else
+	crc = crc32c_software(crc, data, size);
+#endif
+	return ~crc;
+}
+
+} // namespace rtc::impl
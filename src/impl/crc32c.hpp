@@ -0,0 +1,24 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_CRC32C_H
+#define RTC_IMPL_CRC32C_H
+
+#include "common.hpp"
+
+namespace rtc::impl {
+
+// CRC32c (Castagnoli) as used by SCTP (RFC 9260 Appendix A), with the final inversion
+uint32_t crc32c(const byte *data, size_t size);
+
+// Whether crc32c() uses CPU instructions, SSE4.2 on x86 or the CRC extension on ARMv8
+bool crc32c_accelerated();
+
+} // namespace rtc::impl
+
+#endif
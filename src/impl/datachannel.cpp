@@ -75,9 +75,9 @@ bool DataChannel::IsOpenMessage(message_ptr message) {
 }
 
 DataChannel::DataChannel(weak_ptr<PeerConnection> pc, string label, string protocol,
-                         Reliability reliability)
+                         Reliability reliability, uint16_t priority)
     : mPeerConnection(pc), mLabel(std::move(label)), mProtocol(std::move(protocol)),
-      mRecvQueue(RECV_QUEUE_LIMIT, message_size_func) {
+      mPriority(priority), mRecvQueue(RECV_QUEUE_LIMIT, message_size_func) {
 
 	if(reliability.maxPacketLifeTime && reliability.maxRetransmits)
 		throw std::invalid_argument("Both maxPacketLifeTime and maxRetransmits are set");
@@ -107,6 +107,8 @@ void DataChannel::close() {
 		if (transport && mStream.has_value())
 			transport->closeStream(mStream.value());
 
+		flushAsyncSends(); // pending async sends fail as the channel is closed
+		updateRecvPause(); // a closed channel must not hold reception
 		triggerClosed();
 		resetCallbacks();
 	}	
@@ -116,6 +118,9 @@ void DataChannel::remoteClose() { close(); }
 
 optional<message_variant> DataChannel::receive() {
 	auto next = mRecvQueue.pop();
+	if (mRecvPaused)
+		updateRecvPause();
+
 	return next ? std::make_optional(to_variant(std::move(**next))) : nullopt;
 }
 
@@ -124,6 +129,16 @@ optional<message_variant> DataChannel::peek() {
 	return next ? std::make_optional(to_variant(**next)) : nullopt;
 }
 
+optional<message_ptr> DataChannel::receiveMessage() {
+	auto next = mRecvQueue.pop();
+	if (mRecvPaused)
+		updateRecvPause();
+
+	return next;
+}
+
+optional<message_ptr> DataChannel::peekMessage() { return mRecvQueue.peek(); }
+
 size_t DataChannel::availableAmount() const { return mRecvQueue.amount(); }
 
 optional<uint16_t> DataChannel::stream() const {
@@ -146,6 +161,11 @@ Reliability DataChannel::reliability() const {
 	return *mReliability;
 }
 
+uint16_t DataChannel::priority() const {
+	std::shared_lock lock(mMutex);
+	return mPriority;
+}
+
 bool DataChannel::isOpen(void) const { return !mIsClosed && mIsOpen; }
 
 bool DataChannel::isClosed(void) const { return mIsClosed; }
@@ -164,44 +184,177 @@ void DataChannel::assignStream(uint16_t stream) {
 	mStream = stream;
 }
 
+void DataChannel::setMaxAvailableAmount(size_t amount) {
+	mMaxAvailableAmount = amount;
+	updateRecvPause();
+}
+
+void DataChannel::updateRecvPause() {
+	// Pausing stops reading from usrsctp, so its receive buffer fills up and the advertised
+	// receive window shrinks, throttling the sender instead of buffering without bound here
+	const size_t limit = mMaxAvailableAmount;
+	shared_ptr<SctpTransport> transport;
+	while (true) {
+		const size_t amount = mRecvQueue.amount();
+		const bool pause = limit > 0 && !mIsClosed &&
+		                   (amount > limit || (mRecvPaused && amount > limit / 2));
+		if (mRecvPaused.exchange(pause) == pause)
+			return;
+
+		if (!transport) {
+			std::shared_lock lock(mMutex);
+			transport = mSctpTransport.lock();
+		}
+
+		if (!transport)
+			return;
+
+		PLOG_VERBOSE << (pause ? "Pausing" : "Resuming") << " reception for DataChannel";
+		if (pause)
+			transport->pauseRecv();
+		else
+			transport->resumeRecv();
+
+		// A concurrent drain might have seen the previous state and returned, so check the level
+		// again, otherwise reception could stay paused with nothing left to read. The transport
+		// counts pauses, so the calls don't need to be ordered.
+	}
+}
+
+void DataChannel::setCoalescingWindow(std::chrono::milliseconds window) {
+	std::unique_lock lock(mMutex);
+	mCoalescingWindow = window;
+}
+
 void DataChannel::open(shared_ptr<SctpTransport> transport) {
 	{
 		std::unique_lock lock(mMutex);
 		mSctpTransport = transport;
+		if (mStream.has_value())
+			attachToTransport(transport);
 	}
 
 	if (!mIsClosed && !mIsOpen.exchange(true))
 		triggerOpen();
 }
 
+void DataChannel::attachToTransport(const shared_ptr<SctpTransport> &transport) {
+	// Requires mMutex to be locked
+	transport->attachStream(mStream.value(), weak_from_this());
+	transport->setStreamPriority(mStream.value(), mPriority);
+	if (mCoalescingWindow)
+		transport->setStreamCoalescing(mStream.value(), *mCoalescingWindow);
+}
+
 void DataChannel::processOpenMessage(message_ptr) {
 	PLOG_WARNING << "Received an open message for a user-negotiated DataChannel, ignoring";
 }
 
 bool DataChannel::outgoing(message_ptr message) {
+	auto transport = prepareOutgoing(*message, message->size());
+	return transport->send(message);
+}
+
+bool DataChannel::outgoing(const byte *data, size_t size, std::function<void()> release,
+                           Message::Type type) {
+	// Owning the lent data first ensures it is released even if sending throws
+	auto lent = std::make_unique<SctpTransport::LentData>(data, size, std::move(release));
+
+	auto message = make_message(0, type);
+	auto transport = prepareOutgoing(*message, size);
+	return transport->send(std::move(message), std::move(lent));
+}
+
+bool DataChannel::outgoing(message_vector messages) {
+	if (messages.empty())
+		return true;
+
 	shared_ptr<SctpTransport> transport;
+	for (auto &message : messages)
+		transport = prepareOutgoing(*message, message->size());
+
+	return transport->send(std::move(messages));
+}
+
+void DataChannel::outgoingAsync(message_ptr message,
+                                std::function<void(std::exception_ptr)> callback) {
 	{
-		std::shared_lock lock(mMutex);
-		transport = mSctpTransport.lock();
+		std::lock_guard lock(mAsyncSendsMutex);
+		mAsyncSends.push_back({std::move(message), std::move(callback)});
+	}
 
-		if (mIsClosed)
-			throw std::runtime_error("DataChannel is closed");
+	flushAsyncSends();
+}
 
-		if (!transport)
-			throw std::runtime_error("DataChannel not open");
+void DataChannel::triggerBufferedAmountDecrease(size_t amount) {
+	if (amount <= bufferedAmountHighThreshold.load())
+		flushAsyncSends();
+}
 
-		if (!mStream.has_value())
-			throw std::logic_error("DataChannel has no stream assigned");
+void DataChannel::flushAsyncSends() {
+	std::unique_lock lock(mAsyncSendsMutex);
+	if (std::exchange(mFlushingAsyncSends, true))
+		return; // the flushing loop will take care of it
+
+	// Sends are handed to the transport in order, while the high threshold is not crossed
+	while (!mAsyncSends.empty() &&
+	       (bufferedAmount.load() <= bufferedAmountHighThreshold.load() || mIsClosed)) {
+		auto next = std::move(mAsyncSends.front());
+		mAsyncSends.pop_front();
+		lock.unlock();
+
+		std::exception_ptr error;
+		try {
+			outgoing(std::move(next.message));
+		} catch (...) {
+			error = std::current_exception();
+		}
 
-		if (message->size() > maxMessageSize())
-			throw std::invalid_argument("Message size exceeds limit");
+		try {
+			next.callback(error);
+		} catch (const std::exception &e) {
+			PLOG_WARNING << "Uncaught exception in callback: " << e.what();
+		}
 
-		// Before the ACK has been received on a DataChannel, all messages must be sent ordered
-		message->reliability = mIsOpen ? mReliability : nullptr;
-		message->stream = mStream.value();
+		lock.lock();
 	}
 
-	return transport->send(message);
+	mFlushingAsyncSends = false;
+}
+
+shared_ptr<SctpTransport> DataChannel::prepareOutgoing(Message &message, size_t size) {
+	std::shared_lock lock(mMutex);
+	auto transport = mSctpTransport.lock();
+
+	if (mIsClosed)
+		throw std::runtime_error("DataChannel is closed");
+
+	if (!transport)
+		throw std::runtime_error("DataChannel not open");
+
+	if (!mStream.has_value())
+		throw std::logic_error("DataChannel has no stream assigned");
+
+	if (size > maxMessageSize())
+		throw std::invalid_argument("Message size exceeds limit");
+
+	// Before the ACK has been received on a DataChannel, all messages must be sent ordered
+	message.reliability = mIsOpen ? mReliability : nullptr;
+	message.stream = mStream.value();
+
+	mMessagesSent.fetch_add(1, std::memory_order_relaxed);
+	mBytesSent.fetch_add(size, std::memory_order_relaxed);
+	return transport;
+}
+
+DataChannelStats DataChannel::stats() const {
+	DataChannelStats stats;
+	stats.messagesSent = mMessagesSent.load(std::memory_order_relaxed);
+	stats.bytesSent = mBytesSent.load(std::memory_order_relaxed);
+	stats.messagesReceived = mMessagesReceived.load(std::memory_order_relaxed);
+	stats.bytesReceived = mBytesReceived.load(std::memory_order_relaxed);
+	stats.bufferedAmount = bufferedAmount.load();
+	return stats;
 }
 
 void DataChannel::incoming(message_ptr message) {
@@ -233,7 +386,12 @@ void DataChannel::incoming(message_ptr message) {
 		break;
 	case Message::String:
 	case Message::Binary:
+		mMessagesReceived.fetch_add(1, std::memory_order_relaxed);
+		mBytesReceived.fetch_add(message->size(), std::memory_order_relaxed);
 		mRecvQueue.push(message);
+		if (mMaxAvailableAmount > 0)
+			updateRecvPause();
+
 		triggerAvailable(mRecvQueue.size());
 		break;
 	default:
@@ -243,8 +401,8 @@ void DataChannel::incoming(message_ptr message) {
 }
 
 OutgoingDataChannel::OutgoingDataChannel(weak_ptr<PeerConnection> pc, string label, string protocol,
-                                         Reliability reliability)
-    : DataChannel(pc, std::move(label), std::move(protocol), std::move(reliability)) {}
+                                         Reliability reliability, uint16_t priority)
+    : DataChannel(pc, std::move(label), std::move(protocol), std::move(reliability), priority) {}
 
 OutgoingDataChannel::~OutgoingDataChannel() {}
 
@@ -255,6 +413,8 @@ void OutgoingDataChannel::open(shared_ptr<SctpTransport> transport) {
 	if (!mStream.has_value())
 		throw std::runtime_error("DataChannel has no stream assigned");
 
+	attachToTransport(transport);
+
 	uint8_t channelType;
 	uint32_t reliabilityParameter;
 	if (mReliability->maxPacketLifeTime) {
@@ -295,7 +455,7 @@ void OutgoingDataChannel::open(shared_ptr<SctpTransport> transport) {
 	auto &open = *reinterpret_cast<OpenMessage *>(buffer.data());
 	open.type = MESSAGE_OPEN;
 	open.channelType = channelType;
-	open.priority = htons(0);
+	open.priority = htons(mPriority);
 	open.reliabilityParameter = htonl(reliabilityParameter);
 	open.labelLength = htons(to_uint16(mLabel.size()));
 	open.protocolLength = htons(to_uint16(mProtocol.size()));
@@ -351,6 +511,10 @@ void IncomingDataChannel::processOpenMessage(message_ptr message) {
 	mLabel.assign(end, open.labelLength);
 	mProtocol.assign(end + open.labelLength, open.protocolLength);
 
+	// Peers not implementing RFC 8832 priorities send 0
+	mPriority = open.priority > 0 ? open.priority : DEFAULT_DATA_CHANNEL_PRIORITY;
+	attachToTransport(transport);
+
 	mReliability->unordered = (open.channelType & 0x80) != 0;
 	mReliability->maxPacketLifeTime.reset();
 	mReliability->maxRetransmits.reset();
@@ -18,6 +18,9 @@
 #include "sctptransport.hpp"
 
 #include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <shared_mutex>
 
 namespace rtc::impl {
@@ -28,32 +31,49 @@ struct DataChannel : Channel, std::enable_shared_from_this<DataChannel> {
 	static bool IsOpenMessage(message_ptr message);
 
 	DataChannel(weak_ptr<PeerConnection> pc, string label, string protocol,
-	            Reliability reliability);
+	            Reliability reliability, uint16_t priority = DEFAULT_DATA_CHANNEL_PRIORITY);
 	virtual ~DataChannel();
 
 	void close();
 	void remoteClose();
 	bool outgoing(message_ptr message);
+	bool outgoing(const byte *data, size_t size, std::function<void()> release, // lent data
+	              Message::Type type = Message::Binary);
+	bool outgoing(message_vector messages);
+	void outgoingAsync(message_ptr message, std::function<void(std::exception_ptr)> callback);
 	void incoming(message_ptr message);
 
 	optional<message_variant> receive() override;
 	optional<message_variant> peek() override;
+	optional<message_ptr> receiveMessage() override;
+	optional<message_ptr> peekMessage() override;
 	size_t availableAmount() const override;
 
 	optional<uint16_t> stream() const;
 	string label() const;
 	string protocol() const;
 	Reliability reliability() const;
+	uint16_t priority() const;
 
 	bool isOpen(void) const;
 	bool isClosed(void) const;
 	size_t maxMessageSize() const;
 
+	void setCoalescingWindow(std::chrono::milliseconds window);
+
+	DataChannelStats stats() const;
+
+	std::atomic<size_t> bufferedAmountHighThreshold = DEFAULT_BUFFERED_AMOUNT_HIGH_THRESHOLD;
+
+	void setMaxAvailableAmount(size_t amount); // 0 means no limit
+
 	virtual void assignStream(uint16_t stream);
 	virtual void open(shared_ptr<SctpTransport> transport);
 	virtual void processOpenMessage(message_ptr);
 
 protected:
+	void attachToTransport(const shared_ptr<SctpTransport> &transport); // requires mMutex locked
+
 	const weak_ptr<impl::PeerConnection> mPeerConnection;
 	weak_ptr<SctpTransport> mSctpTransport;
 
@@ -61,6 +81,8 @@ protected:
 	string mLabel;
 	string mProtocol;
 	shared_ptr<Reliability> mReliability;
+	uint16_t mPriority;
+	optional<std::chrono::milliseconds> mCoalescingWindow;
 
 	mutable std::shared_mutex mMutex;
 
@@ -68,12 +90,32 @@ protected:
 	std::atomic<bool> mIsClosed = false;
 
 private:
+	shared_ptr<SctpTransport> prepareOutgoing(Message &message, size_t size);
+	void triggerBufferedAmountDecrease(size_t amount) override;
+	void flushAsyncSends();
+
+	struct AsyncSend {
+		message_ptr message;
+		std::function<void(std::exception_ptr)> callback;
+	};
+	std::deque<AsyncSend> mAsyncSends;
+	bool mFlushingAsyncSends = false;
+	std::mutex mAsyncSendsMutex;
+
 	Queue<message_ptr> mRecvQueue;
+
+	// Reception is paused on the transport above the max available amount, until half is drained
+	void updateRecvPause();
+	std::atomic<size_t> mMaxAvailableAmount = 0;
+	std::atomic<bool> mRecvPaused = false;
+
+	std::atomic<uint64_t> mMessagesSent = 0, mBytesSent = 0;
+	std::atomic<uint64_t> mMessagesReceived = 0, mBytesReceived = 0;
 };
 
 struct OutgoingDataChannel final : public DataChannel {
 	OutgoingDataChannel(weak_ptr<PeerConnection> pc, string label, string protocol,
-	                    Reliability reliability);
+	                    Reliability reliability, uint16_t priority = DEFAULT_DATA_CHANNEL_PRIORITY);
 	~OutgoingDataChannel();
 
 	void open(shared_ptr<SctpTransport> transport) override;
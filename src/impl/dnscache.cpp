@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "dnscache.hpp"
+#include "internals.hpp"
+#include "socket.hpp"
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+DnsCache &DnsCache::Instance() {
+	static DnsCache *instance = new DnsCache;
+	return *instance;
+}
+
+DnsCache::DnsCache() {}
+
+DnsCache::~DnsCache() {}
+
+void DnsCache::setSettings(const DnsCacheSettings &s) {
+	std::lock_guard lock(mMutex);
+	mTtl = s.ttl ? std::chrono::duration_cast<clock::duration>(*s.ttl) : DefaultTtl;
+	mEntries.clear();
+}
+
+std::vector<DnsCache::Address> DnsCache::resolve(const string &hostname, uint16_t port,
+                                                 int family, int socktype) {
+	const string key = MakeKey(hostname, port, family, socktype);
+
+	std::promise<std::vector<Address>> promise;
+	future_addresses future;
+	optional<uint64_t> id;
+	bool disabled = false;
+	{
+		std::lock_guard lock(mMutex);
+		disabled = mTtl <= clock::duration::zero();
+		if (!disabled) {
+			const auto now = clock::now();
+			if (auto it = mEntries.find(key); it != mEntries.end()) {
+				if (it->second.expiry > now)
+					future = it->second.future;
+				else
+					mEntries.erase(it);
+			}
+
+			if (!future.valid()) {
+				evict(now);
+				future = promise.get_future().share();
+				id = mNextId++;
+				mEntries.emplace(key, Entry{future, now + mTtl, *id});
+			}
+		}
+	}
+
+	// Resolve without holding the lock, as resolution may block
+	if (disabled)
+		return Resolve(hostname, port, family, socktype);
+
+	if (!id) {
+		PLOG_VERBOSE << "Using cached resolution for " << hostname << ':' << port;
+		return future.get();
+	}
+
+	auto addresses = Resolve(hostname, port, family, socktype);
+	{
+		// The TTL starts once resolved, and failures are retried sooner
+		std::lock_guard lock(mMutex);
+		if (auto it = mEntries.find(key); it != mEntries.end() && it->second.id == *id)
+			it->second.expiry = clock::now() + (addresses.empty()
+			                                        ? std::min<clock::duration>(mTtl, NegativeTtl)
+			                                        : mTtl);
+	}
+
+	promise.set_value(addresses);
+	return addresses;
+}
+
+void DnsCache::clear() {
+	std::lock_guard lock(mMutex);
+	mEntries.clear();
+}
+
+void DnsCache::insert(const string &hostname, uint16_t port, int family, int socktype,
+                      std::vector<Address> addresses) {
+	std::promise<std::vector<Address>> promise;
+	promise.set_value(std::move(addresses));
+
+	std::lock_guard lock(mMutex);
+	if (mTtl <= clock::duration::zero())
+		return;
+
+	const auto now = clock::now();
+	const string key = MakeKey(hostname, port, family, socktype);
+	mEntries.erase(key);
+	evict(now);
+	mEntries.emplace(key, Entry{promise.get_future().share(), now + mTtl, mNextId++});
+}
+
+string DnsCache::MakeKey(const string &hostname, uint16_t port, int family, int socktype) {
+	return hostname + ':' + std::to_string(port) + '/' + std::to_string(family) + '/' +
+	       std::to_string(socktype);
+}
+
+std::vector<DnsCache::Address> DnsCache::Resolve(const string &hostname, uint16_t port, int family,
+                                                 int socktype) {
+	struct addrinfo hints = {};
+	hints.ai_family = family;
+	hints.ai_socktype = socktype;
+	hints.ai_protocol = socktype == SOCK_DGRAM ? IPPROTO_UDP : IPPROTO_TCP;
+	hints.ai_flags = AI_ADDRCONFIG;
+	struct addrinfo *result = nullptr;
+	if (getaddrinfo(hostname.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
+		return {};
+
+	std::vector<Address> addresses;
+	for (auto p = result; p; p = p->ai_next) {
+		if (p->ai_family != AF_INET && p->ai_family != AF_INET6)
+			continue;
+
+		char node[MAX_NUMERICNODE_LEN];
+		if (getnameinfo(p->ai_addr, socklen_t(p->ai_addrlen), node, MAX_NUMERICNODE_LEN, nullptr,
+		                0, NI_NUMERICHOST) == 0)
+			addresses.push_back({p->ai_family, string(node)});
+	}
+
+	freeaddrinfo(result);
+	return addresses;
+}
+
+void DnsCache::evict(clock::time_point now) {
+	// Requires mMutex to be locked
+	if (mEntries.size() < MaxEntriesCount)
+		return;
+
+	for (auto it = mEntries.begin(); it != mEntries.end();)
+		it = it->second.expiry <= now ? mEntries.erase(it) : std::next(it);
+
+	// Still full, drop the entry expiring first
+	if (mEntries.size() >= MaxEntriesCount) {
+		auto it = std::min_element(mEntries.begin(), mEntries.end(), [](const auto &a, const auto &b) {
+			return a.second.expiry < b.second.expiry;
+		});
+		mEntries.erase(it);
+	}
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_DNS_CACHE_H
+#define RTC_IMPL_DNS_CACHE_H
+
+#include "common.hpp"
+#include "global.hpp" // for DnsCacheSettings
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace rtc::impl {
+
+// Process-wide cache of resolved ICE server and TCP connection addresses, so that agents and
+// WebSockets created close together do not resolve the same hostname again. Concurrent lookups of
+// the same key share a single resolution. Failed resolutions are cached for a short time only.
+class DnsCache final {
+public:
+	struct Address {
+		int family; // AF_INET or AF_INET6
+		string node; // numeric host
+	};
+
+	static DnsCache &Instance();
+
+	DnsCache(const DnsCache &) = delete;
+	DnsCache &operator=(const DnsCache &) = delete;
+	DnsCache(DnsCache &&) = delete;
+	DnsCache &operator=(DnsCache &&) = delete;
+
+	void setSettings(const DnsCacheSettings &s);
+
+	// Blocks while resolving, returns an empty vector on failure
+	std::vector<Address> resolve(const string &hostname, uint16_t port, int family, int socktype);
+	void clear();
+
+	// Caches addresses as if they had been resolved for the TTL, ignored if the cache is disabled
+	void insert(const string &hostname, uint16_t port, int family, int socktype,
+	            std::vector<Address> addresses);
+
+private:
+	using clock = std::chrono::steady_clock;
+	using future_addresses = std::shared_future<std::vector<Address>>;
+
+	DnsCache();
+	~DnsCache();
+
+	static constexpr auto DefaultTtl = std::chrono::seconds(60);
+	static constexpr auto NegativeTtl = std::chrono::seconds(5);
+	static constexpr size_t MaxEntriesCount = 256;
+
+	struct Entry {
+		future_addresses future;
+		clock::time_point expiry;
+		uint64_t id;
+	};
+
+	static string MakeKey(const string &hostname, uint16_t port, int family, int socktype);
+	static std::vector<Address> Resolve(const string &hostname, uint16_t port, int family,
+	                                    int socktype);
+
+	void evict(clock::time_point now); // requires mMutex to be locked
+
+	std::unordered_map<string, Entry> mEntries;
+	clock::duration mTtl = DefaultTtl;
+	uint64_t mNextId = 0;
+	std::mutex mMutex;
+};
+
+} // namespace rtc::impl
+
+#endif
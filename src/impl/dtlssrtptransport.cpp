@@ -7,40 +7,60 @@
  */
 
 #include "dtlssrtptransport.hpp"
+#include "latencyhistogram.hpp"
 #include "logcounter.hpp"
 #include "rtp.hpp"
 #include "tls.hpp"
 
 #if RTC_ENABLE_MEDIA
 
+#include <algorithm>
 #include <cstring>
 #include <exception>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h> // for __cpuid
+#elif defined(__aarch64__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h> // for getauxval
+#endif
+
 using std::to_integer;
 using std::to_string;
 
 namespace rtc::impl {
 
-static LogCounter COUNTER_MEDIA_TRUNCATED(plog::warning,
+static LogCounter COUNTER_MEDIA_TRUNCATED("rtc_srtp_truncated_packets", plog::warning,
                                           "Number of truncated SRT(C)P packets received");
 static LogCounter
-    COUNTER_UNKNOWN_PACKET_TYPE(plog::warning,
+    COUNTER_UNKNOWN_PACKET_TYPE("rtc_srtp_unknown_packet_types", plog::warning,
                                 "Number of RTP packets received with an unknown packet type");
-static LogCounter COUNTER_SRTCP_REPLAY(plog::warning, "Number of SRTCP replay packets received");
+static LogCounter COUNTER_SRTCP_REPLAY("rtc_srtcp_replay_packets", plog::warning,
+                                       "Number of SRTCP replay packets received");
 static LogCounter
-    COUNTER_SRTCP_AUTH_FAIL(plog::warning,
+    COUNTER_SRTCP_AUTH_FAIL("rtc_srtcp_authentication_failures", plog::warning,
                             "Number of SRTCP packets received that failed authentication checks");
 static LogCounter
-    COUNTER_SRTCP_FAIL(plog::warning,
+    COUNTER_SRTCP_FAIL("rtc_srtcp_unprotect_failures", plog::warning,
                        "Number of SRTCP packets received that had an unknown libSRTP failure");
-static LogCounter COUNTER_SRTP_REPLAY(plog::warning, "Number of SRTP replay packets received");
+static LogCounter COUNTER_SRTP_REPLAY("rtc_srtp_replay_packets", plog::warning,
+                                      "Number of SRTP replay packets received");
 static LogCounter
-    COUNTER_SRTP_AUTH_FAIL(plog::warning,
+    COUNTER_SRTP_AUTH_FAIL("rtc_srtp_authentication_failures", plog::warning,
                            "Number of SRTP packets received that failed authentication checks");
 static LogCounter
-    COUNTER_SRTP_FAIL(plog::warning,
+    COUNTER_SRTP_FAIL("rtc_srtp_unprotect_failures", plog::warning,
                       "Number of SRTP packets received that had an unknown libSRTP failure");
 
+static LatencyHistogram HISTOGRAM_PROTECT("rtc_srtp_protect_latency",
+                                          "Time spent protecting outgoing SRTP and SRTCP packets");
+static LatencyHistogram
+    HISTOGRAM_UNPROTECT("rtc_srtp_unprotect_latency",
+                        "Time spent unprotecting incoming SRTP and SRTCP packets");
+
+static_assert(DEFAULT_MEDIA_TAILROOM >= SRTP_MAX_TRAILER_LEN,
+              "Default media tailroom is too small for the SRTP trailer");
+
 void DtlsSrtpTransport::Init() { srtp_init(); }
 
 void DtlsSrtpTransport::Cleanup() { srtp_shutdown(); }
@@ -56,11 +76,86 @@ bool DtlsSrtpTransport::IsGcmSupported() {
 #endif
 }
 
+bool DtlsSrtpTransport::IsAesAccelerated() {
+	// AES-GCM needs both AES rounds and carry-less multiplication for GHASH to be fast
+	static const bool accelerated = []() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 25)) != 0 && (info[2] & (1 << 1)) != 0; // AES-NI and PCLMULQDQ
+#elif defined(__aarch64__) && defined(__linux__)
+		const auto hwcap = getauxval(AT_HWCAP);
+		return (hwcap & HWCAP_AES) != 0 && (hwcap & HWCAP_PMULL) != 0;
+#elif defined(__aarch64__) && defined(__APPLE__)
+		return true; // the cryptography extension is always present
+#else
+		return false;
+#endif
+	}();
+	return accelerated;
+}
+
+std::vector<SrtpProfile> DtlsSrtpTransport::DefaultProfiles() {
+	if (!IsGcmSupported())
+		return {SrtpProfile::Aes128CmSha1_80};
+
+	// With AES instructions, AES-GCM is much cheaper than AES-CM with HMAC-SHA1, and AES-128 has
+	// fewer rounds than AES-256. Without them, HMAC-SHA1 is cheaper than GHASH.
+	if (IsAesAccelerated())
+		return {SrtpProfile::AeadAes128Gcm, SrtpProfile::AeadAes256Gcm,
+		        SrtpProfile::Aes128CmSha1_80};
+
+	return {SrtpProfile::Aes128CmSha1_80, SrtpProfile::AeadAes128Gcm, SrtpProfile::AeadAes256Gcm};
+}
+
+#if !USE_GNUTLS && !USE_MBEDTLS
+string DtlsSrtpTransport::ProfileNames(std::vector<SrtpProfile> profiles) {
+	// RFC 8827: The DTLS-SRTP protection profile SRTP_AES128_CM_HMAC_SHA1_80 MUST be supported
+	// See https://www.rfc-editor.org/rfc/rfc8827.html#section-6.5
+	if (std::find(profiles.begin(), profiles.end(), SrtpProfile::Aes128CmSha1_80) == profiles.end())
+		profiles.push_back(SrtpProfile::Aes128CmSha1_80);
+
+	const bool gcm = IsGcmSupported();
+	string names;
+	for (auto profile : profiles) {
+		const char *name;
+		switch (profile) {
+		case SrtpProfile::Aes128CmSha1_80:
+			name = "SRTP_AES128_CM_SHA1_80";
+			break;
+		case SrtpProfile::Aes128CmSha1_32:
+			name = "SRTP_AES128_CM_SHA1_32";
+			break;
+		case SrtpProfile::AeadAes128Gcm:
+			name = gcm ? "SRTP_AEAD_AES_128_GCM" : nullptr;
+			break;
+		case SrtpProfile::AeadAes256Gcm:
+			name = gcm ? "SRTP_AEAD_AES_256_GCM" : nullptr;
+			break;
+		default:
+			throw std::invalid_argument("Unknown SRTP profile");
+		}
+
+		if (!name || names.find(name) != string::npos)
+			continue;
+
+		if (!names.empty())
+			names += ':';
+
+		names += name;
+	}
+	return names;
+}
+#endif
+
 DtlsSrtpTransport::DtlsSrtpTransport(shared_ptr<IceTransport> lower,
                                      shared_ptr<Certificate> certificate, optional<size_t> mtu,
                                      CertificateFingerprint::Algorithm fingerprintAlgorithm,
                                      verifier_callback verifierCallback,
-                                     message_callback srtpRecvCallback,
+                                     media_callback srtpRecvCallback,
                                      state_callback stateChangeCallback)
     : DtlsTransport(lower, certificate, mtu, fingerprintAlgorithm, std::move(verifierCallback),
                     std::move(stateChangeCallback)),
@@ -80,30 +175,183 @@ DtlsSrtpTransport::DtlsSrtpTransport(shared_ptr<IceTransport> lower,
 DtlsSrtpTransport::~DtlsSrtpTransport() {
 	stop(); // stop before deallocating
 
+	mOutboundStreams.clear(); // joins processors
 	srtp_dealloc(mSrtpIn);
 	srtp_dealloc(mSrtpOut);
 }
 
+DtlsSrtpTransport::OutboundStream::~OutboundStream() {
+	processor.join();
+	if (session)
+		srtp_dealloc(session);
+}
+
+void DtlsSrtpTransport::enableParallelProtection() {
+	std::lock_guard lock(sendMutex);
+	mParallelProtection = true;
+}
+
+void DtlsSrtpTransport::enableEcn() { mEcn = true; }
+
+void DtlsSrtpTransport::setSrtpProfiles(std::vector<SrtpProfile> profiles) {
+#if USE_GNUTLS || USE_MBEDTLS
+	(void)profiles;
+	PLOG_WARNING << "SRTP profile preference is only supported with OpenSSL, using "
+	                "SRTP_AES128_CM_SHA1_80";
+#else
+	const string names = ProfileNames(std::move(profiles));
+	PLOG_DEBUG << "Offering SRTP profiles: " << names;
+
+	// Warning: SSL_set_tlsext_use_srtp() returns 0 on success and 1 on error
+	if (SSL_set_tlsext_use_srtp(mSsl, names.c_str()))
+		throw std::runtime_error("Failed to set SRTP profiles: " +
+		                         openssl::error_string(ERR_get_error()));
+#endif
+}
+
+DtlsTransportStats DtlsSrtpTransport::dtlsStats() const {
+	auto stats = DtlsTransport::dtlsStats();
+	if (mInitDone)
+		stats.srtpProfile = mSrtpProfileName;
+
+	stats.rtpPacketsProtected = mRtpPacketsProtected.load(std::memory_order_relaxed);
+	stats.rtcpPacketsProtected = mRtcpPacketsProtected.load(std::memory_order_relaxed);
+	stats.rtpPacketsUnprotected = mRtpPacketsUnprotected.load(std::memory_order_relaxed);
+	stats.rtcpPacketsUnprotected = mRtcpPacketsUnprotected.load(std::memory_order_relaxed);
+	stats.rtpUnprotectFailures = mRtpUnprotectFailures.load(std::memory_order_relaxed);
+	stats.rtcpUnprotectFailures = mRtcpUnprotectFailures.load(std::memory_order_relaxed);
+	return stats;
+}
+
 bool DtlsSrtpTransport::sendMedia(message_ptr message) {
 	std::lock_guard lock(sendMutex);
 	if (!message)
 		return false;
 
+	if (mParallelProtection)
+		return parallelSend(message_vector{std::move(message)});
+
+	if (!protectMedia(message))
+		return false;
+
+	return Transport::outgoing(message); // bypass DTLS DSCP marking
+}
+
+bool DtlsSrtpTransport::sendMedia(message_vector messages) {
+	std::lock_guard lock(sendMutex);
+	if (mParallelProtection)
+		return parallelSend(std::move(messages));
+
+	message_vector packets;
+	packets.reserve(messages.size());
+	bool complete = true;
+	for (auto &message : messages) {
+		if (!message)
+			continue;
+
+		// A packet failing protection must not prevent the following ones from being sent
+		if (!protectMedia(message)) {
+			complete = false;
+			continue;
+		}
+
+		packets.push_back(std::move(message));
+	}
+
+	if (packets.empty())
+		return false;
+
+	// Pass the whole batch down at once, bypassing DTLS DSCP marking
+	return Transport::outgoingBatch(std::move(packets)) && complete;
+}
+
+bool DtlsSrtpTransport::parallelSend(message_vector messages) {
+	// Requires sendMutex to be locked
 	if (!mInitDone) {
 		PLOG_ERROR << "SRTP media sent before keys are derived";
 		return false;
 	}
 
+	auto ssrc = [](const Message &m) {
+		return IsRtcp(m) ? reinterpret_cast<const RtcpSr *>(m.data())->senderSSRC()
+		                 : reinterpret_cast<const RtpHeader *>(m.data())->ssrc();
+	};
+
+	// Group consecutive packets of the same SSRC in a single task
+	auto it = messages.begin();
+	while (it != messages.end()) {
+		if (!*it || (*it)->size() < 8) { // too short to hold an SSRC
+			++it;
+			continue;
+		}
+
+		const uint32_t current = ssrc(**it);
+		message_vector group;
+		while (it != messages.end() && *it && (*it)->size() >= 8 && ssrc(**it) == current)
+			group.push_back(std::move(*it++));
+
+		OutboundStream &stream = outboundStream(current);
+		stream.processor.enqueue(
+		    [this, &stream, group = std::move(group)]() mutable { protectAndSend(stream, group); });
+	}
+
+	return true; // the result of sending is not known yet
+}
+
+DtlsSrtpTransport::OutboundStream &DtlsSrtpTransport::outboundStream(uint32_t ssrc) {
+	// Requires sendMutex to be locked
+	auto it = mOutboundStreams.find(ssrc);
+	if (it != mOutboundStreams.end())
+		return *it->second;
+
+	PLOG_DEBUG << "Creating SRTP outbound session for SSRC " << ssrc;
+	auto stream = std::make_unique<OutboundStream>();
+	stream->session = createOutboundSession();
+	return *mOutboundStreams.emplace(ssrc, std::move(stream)).first->second;
+}
+
+void DtlsSrtpTransport::protectAndSend(OutboundStream &stream, message_vector &messages) {
+	// Tasks are joined before the transport is destroyed
+	message_vector packets;
+	packets.reserve(messages.size());
+	for (auto &message : messages) {
+		if (!protectMedia(stream.session, message))
+			continue;
+
+		packets.push_back(std::move(message));
+	}
+
+	if (!packets.empty())
+		Transport::outgoingBatch(std::move(packets)); // bypass DTLS DSCP marking
+}
+
+bool DtlsSrtpTransport::protectMedia(message_ptr &message) {
+	// Requires sendMutex to be locked
+	if (!mInitDone) {
+		PLOG_ERROR << "SRTP media sent before keys are derived";
+		return false;
+	}
+
+	return protectMedia(mSrtpOut, message);
+}
+
+bool DtlsSrtpTransport::protectMedia(srtp_t session, message_ptr &message) {
+	LatencyScope latency(HISTOGRAM_PROTECT);
 	int size = int(message->size());
 	PLOG_VERBOSE << "Send size=" << size;
 
 	// srtp_protect() and srtp_protect_rtcp() assume that they can write SRTP_MAX_TRAILER_LEN (for
 	// the authentication tag) into the location in memory immediately following the RTP packet.
-	// Copy instead of resizing so we don't interfere with media handlers keeping references
-	message = make_message(size + SRTP_MAX_TRAILER_LEN, message);
+	// If we hold the only reference and the message has enough tailroom, protect it in place,
+	// otherwise copy so we don't interfere with media handlers keeping references.
+	if (message.use_count() == 1 && message->tailroom() >= SRTP_MAX_TRAILER_LEN) {
+		message->resize(size + SRTP_MAX_TRAILER_LEN); // does not reallocate
+	} else {
+		message = make_message(size + SRTP_MAX_TRAILER_LEN, message);
+	}
 
 	if (IsRtcp(*message)) { // Demultiplex RTCP and RTP using payload type
-		if (srtp_err_status_t err = srtp_protect_rtcp(mSrtpOut, message->data(), &size)) {
+		if (srtp_err_status_t err = srtp_protect_rtcp(session, message->data(), &size)) {
 			if (err == srtp_err_status_replay_fail)
 				throw std::runtime_error("Outgoing SRTCP packet is a replay");
 			else
@@ -111,9 +359,10 @@ bool DtlsSrtpTransport::sendMedia(message_ptr message) {
 				                         to_string(static_cast<int>(err)));
 		}
 		PLOG_VERBOSE << "Protected SRTCP packet, size=" << size;
+		mRtcpPacketsProtected.fetch_add(1, std::memory_order_relaxed);
 
 	} else {
-		if (srtp_err_status_t err = srtp_protect(mSrtpOut, message->data(), &size)) {
+		if (srtp_err_status_t err = srtp_protect(session, message->data(), &size)) {
 			if (err == srtp_err_status_replay_fail)
 				throw std::runtime_error("Outgoing SRTP packet is a replay");
 			else
@@ -121,6 +370,7 @@ bool DtlsSrtpTransport::sendMedia(message_ptr message) {
 				                         to_string(static_cast<int>(err)));
 		}
 		PLOG_VERBOSE << "Protected SRTP packet, size=" << size;
+		mRtpPacketsProtected.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	message->resize(size);
@@ -131,17 +381,23 @@ bool DtlsSrtpTransport::sendMedia(message_ptr message) {
 		message->dscp = 36; // AF42: Assured Forwarding class 4, medium drop probability
 	}
 
-	return Transport::outgoing(message); // bypass DTLS DSCP marking
+	// RFC 9331: ECT(1) identifies L4S traffic
+	// See https://www.rfc-editor.org/rfc/rfc9331.html#section-4
+	if (mEcn && message->ecn == 0)
+		message->ecn = 1;
+
+	return true;
 }
 
-void DtlsSrtpTransport::recvMedia(message_ptr message) {
+bool DtlsSrtpTransport::unprotectMedia(message_ptr &message) {
+	LatencyScope latency(HISTOGRAM_UNPROTECT);
 	// The RTP header has a minimum size of 12 bytes
 	// An RTCP packet can have a minimum size of 8 bytes
 	int size = int(message->size());
 	if (size < 8) {
 		COUNTER_MEDIA_TRUNCATED++;
 		PLOG_VERBOSE << "Incoming SRTP/SRTCP packet too short, size=" << size;
-		return;
+		return false;
 	}
 
 	uint8_t value2 = to_integer<uint8_t>(*(message->begin() + 1)) & 0x7F;
@@ -162,9 +418,11 @@ void DtlsSrtpTransport::recvMedia(message_ptr message) {
 				COUNTER_SRTCP_FAIL++;
 			}
 
-			return;
+			mRtcpUnprotectFailures.fetch_add(1, std::memory_order_relaxed);
+			return false;
 		}
 		PLOG_VERBOSE << "Unprotected SRTCP packet, size=" << size;
+		mRtcpPacketsUnprotected.fetch_add(1, std::memory_order_relaxed);
 		message->type = Message::Control;
 		message->stream = reinterpret_cast<RtcpSr *>(message->data())->senderSSRC();
 
@@ -181,15 +439,35 @@ void DtlsSrtpTransport::recvMedia(message_ptr message) {
 				PLOG_DEBUG << "SRTP unprotect error, status=" << err;
 				COUNTER_SRTP_FAIL++;
 			}
-			return;
+
+			mRtpUnprotectFailures.fetch_add(1, std::memory_order_relaxed);
+			return false;
 		}
 		PLOG_VERBOSE << "Unprotected SRTP packet, size=" << size;
+		mRtpPacketsUnprotected.fetch_add(1, std::memory_order_relaxed);
 		message->type = Message::Binary;
 		message->stream = reinterpret_cast<RtpHeader *>(message->data())->ssrc();
 	}
 
 	message->resize(size);
-	mSrtpRecvCallback(message);
+	return true;
+}
+
+void DtlsSrtpTransport::recvMedia(message_vector &messages) {
+	if (messages.empty())
+		return;
+
+	// Packets are passed up as a batch, so that media handlers process them at once
+	message_vector batch;
+	batch.reserve(messages.size());
+	for (auto &message : messages)
+		if (unprotectMedia(message))
+			batch.push_back(std::move(message));
+
+	messages.clear();
+
+	if (!batch.empty())
+		mSrtpRecvCallback(std::move(batch));
 }
 
 bool DtlsSrtpTransport::demuxMessage(message_ptr message) {
@@ -198,8 +476,10 @@ bool DtlsSrtpTransport::demuxMessage(message_ptr message) {
 		return false;
 	}
 
-	if (message->size() == 0)
+	if (message->size() == 0) {
+		recvMedia(mRecvBatch);
 		return false;
+	}
 
 	// RFC 5764 5.1.2. Reception
 	// https://www.rfc-editor.org/rfc/rfc5764.html#section-5.1.2
@@ -212,13 +492,19 @@ bool DtlsSrtpTransport::demuxMessage(message_ptr message) {
 
 	if (value1 >= 20 && value1 <= 63) {
 		PLOG_VERBOSE << "Incoming DTLS packet, size=" << message->size();
+		recvMedia(mRecvBatch); // keep ordering with pending media
 		return false;
 
 	} else if (value1 >= 128 && value1 <= 191) {
-		recvMedia(std::move(message));
+		// Batch consecutive media packets and process them once the incoming queue is drained
+		mRecvBatch.push_back(std::move(message));
+		if (mRecvBatch.size() >= RecvBatchSize || mIncomingQueue.empty())
+			recvMedia(mRecvBatch);
+
 		return true;
 
 	} else {
+		recvMedia(mRecvBatch);
 		COUNTER_UNKNOWN_PACKET_TYPE++;
 		PLOG_DEBUG << "Unknown packet type, value=" << unsigned(value1)
 		           << ", size=" << message->size();
@@ -234,6 +520,7 @@ void DtlsSrtpTransport::postHandshake() {
 	PLOG_INFO << "Deriving SRTP keying material (GnuTLS)";
 
 	const srtp_profile_t srtpProfile = srtp_profile_aes128_cm_sha1_80;
+	mSrtpProfileName = "SRTP_AES128_CM_SHA1_80";
 	const size_t keySize = SRTP_AES_128_KEY_LEN;
 	const size_t saltSize = SRTP_SALT_LEN;
 	const size_t keySizeWithSalt = SRTP_AES_ICM_128_KEY_LEN_WSALT;
@@ -270,6 +557,7 @@ void DtlsSrtpTransport::postHandshake() {
 		throw std::runtime_error("Failed to get SRTP profile");
 
 	const srtp_profile_t srtpProfile = srtp_profile_aes128_cm_sha1_80;
+	mSrtpProfileName = "SRTP_AES128_CM_SHA1_80";
 	const size_t keySize = SRTP_AES_128_KEY_LEN;
 	const size_t saltSize = SRTP_SALT_LEN;
 	const size_t keySizeWithSalt = SRTP_AES_ICM_128_KEY_LEN_WSALT;
@@ -301,7 +589,8 @@ void DtlsSrtpTransport::postHandshake() {
 		throw std::runtime_error("Failed to get SRTP profile: " +
 		                         openssl::error_string(ERR_get_error()));
 
-	PLOG_DEBUG << "SRTP profile is: " << profile->name;
+	PLOG_INFO << "SRTP profile is: " << profile->name;
+	mSrtpProfileName = profile->name;
 
 	const auto [srtpProfile, keySize, saltSize] = getProfileParamsFromName(profile->name);
 	const size_t keySizeWithSalt = keySize + saltSize;
@@ -349,10 +638,23 @@ void DtlsSrtpTransport::postHandshake() {
 		throw std::runtime_error("SRTP add inbound stream failed, status=" +
 		                         to_string(static_cast<int>(err)));
 
+	mSrtpProfile = srtpProfile;
+	{
+		std::lock_guard lock(sendMutex);
+		srtp_policy_t outbound = outboundPolicy();
+		if (srtp_err_status_t err = srtp_add_stream(mSrtpOut, &outbound))
+			throw std::runtime_error("SRTP add outbound stream failed, status=" +
+			                         to_string(static_cast<int>(err)));
+	}
+
+	mInitDone = true;
+}
+
+srtp_policy_t DtlsSrtpTransport::outboundPolicy() {
 	srtp_policy_t outbound = {};
-	if (srtp_crypto_policy_set_from_profile_for_rtp(&outbound.rtp, srtpProfile))
+	if (srtp_crypto_policy_set_from_profile_for_rtp(&outbound.rtp, mSrtpProfile))
 		throw std::runtime_error("SRTP profile is not supported");
-	if (srtp_crypto_policy_set_from_profile_for_rtcp(&outbound.rtcp, srtpProfile))
+	if (srtp_crypto_policy_set_from_profile_for_rtcp(&outbound.rtcp, mSrtpProfile))
 		throw std::runtime_error("SRTP profile is not supported");
 
 	outbound.ssrc.type = ssrc_any_outbound;
@@ -360,12 +662,17 @@ void DtlsSrtpTransport::postHandshake() {
 	outbound.window_size = 1024;
 	outbound.allow_repeat_tx = true;
 	outbound.next = nullptr;
+	return outbound;
+}
 
-	if (srtp_err_status_t err = srtp_add_stream(mSrtpOut, &outbound))
-		throw std::runtime_error("SRTP add outbound stream failed, status=" +
-		                         to_string(static_cast<int>(err)));
+srtp_t DtlsSrtpTransport::createOutboundSession() {
+	// Each SSRC is only ever protected by a single session, so sharing the master key is safe
+	srtp_policy_t outbound = outboundPolicy();
+	srtp_t session;
+	if (srtp_err_status_t err = srtp_create(&session, &outbound))
+		throw std::runtime_error("srtp_create failed, status=" + to_string(static_cast<int>(err)));
 
-	mInitDone = true;
+	return session;
 }
 
 #if !USE_GNUTLS && !USE_MBEDTLS
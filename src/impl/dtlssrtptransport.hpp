@@ -20,7 +20,10 @@
 #include "srtp.h"
 #endif
 
+#include "processor.hpp"
+
 #include <atomic>
+#include <unordered_map>
 
 namespace rtc::impl {
 
@@ -29,17 +32,56 @@ public:
 	static void Init();
 	static void Cleanup();
 	static bool IsGcmSupported();
+	static bool IsAesAccelerated();                    // AES instructions detected at runtime
+	static std::vector<SrtpProfile> DefaultProfiles(); // cheapest first on this CPU
+#if !USE_GNUTLS && !USE_MBEDTLS
+	static string ProfileNames(std::vector<SrtpProfile> profiles); // for SSL_set_tlsext_use_srtp
+#endif
+
+	using media_callback = std::function<void(message_vector messages)>; // batch of packets
 
 	DtlsSrtpTransport(shared_ptr<IceTransport> lower, certificate_ptr certificate,
 	                  optional<size_t> mtu, CertificateFingerprint::Algorithm fingerprintAlgorithm,
-	                  verifier_callback verifierCallback, message_callback srtpRecvCallback,
+	                  verifier_callback verifierCallback, media_callback srtpRecvCallback,
 	                  state_callback stateChangeCallback);
 	~DtlsSrtpTransport();
 
 	bool sendMedia(message_ptr message);
+	bool sendMedia(message_vector messages); // protects the whole batch under a single lock
+
+	// Protect outgoing packets on the thread pool with one libSRTP session per SSRC, so that
+	// streams are processed in parallel while preserving per-SSRC order, call before start()
+	void enableParallelProtection();
+
+	// Mark outgoing media packets as ECN-capable with ECT(1), as expected by L4S
+	void enableEcn();
+
+	// Offer SRTP profiles in order of preference instead of the default ones, call before start()
+	void setSrtpProfiles(std::vector<SrtpProfile> profiles);
+
+	DtlsTransportStats dtlsStats() const override;
 
 private:
-	void recvMedia(message_ptr message);
+	static constexpr size_t RecvBatchSize = 32;
+
+	// Outgoing session for a single SSRC, only accessed from its processor
+	struct OutboundStream {
+		srtp_t session = nullptr;
+		Processor processor;
+
+		~OutboundStream();
+	};
+
+	srtp_policy_t outboundPolicy();
+	srtp_t createOutboundSession();
+	OutboundStream &outboundStream(uint32_t ssrc); // requires sendMutex to be locked
+	bool parallelSend(message_vector messages);    // requires sendMutex to be locked
+	void protectAndSend(OutboundStream &stream, message_vector &messages);
+
+	bool protectMedia(message_ptr &message); // requires sendMutex to be locked
+	bool protectMedia(srtp_t session, message_ptr &message);
+	bool unprotectMedia(message_ptr &message);
+	void recvMedia(message_vector &messages);
 	bool demuxMessage(message_ptr message) override;
 	void postHandshake() override;
 
@@ -53,12 +95,23 @@ private:
 	ProfileParams getProfileParamsFromName(string_view name);
 #endif
 
-	message_callback mSrtpRecvCallback;
+	media_callback mSrtpRecvCallback;
 	srtp_t mSrtpIn, mSrtpOut;
 	std::atomic<bool> mInitDone = false;
 	std::vector<unsigned char> mClientSessionKey;
 	std::vector<unsigned char> mServerSessionKey;
+	srtp_profile_t mSrtpProfile = srtp_profile_reserved;
+	string mSrtpProfileName; // set before mInitDone
 	std::mutex sendMutex;
+
+	bool mParallelProtection = false;
+	std::atomic<bool> mEcn = false;
+	std::unordered_map<uint32_t, std::unique_ptr<OutboundStream>> mOutboundStreams;
+	message_vector mRecvBatch; // only accessed from doRecv()
+
+	std::atomic<uint64_t> mRtpPacketsProtected = 0, mRtcpPacketsProtected = 0;
+	std::atomic<uint64_t> mRtpPacketsUnprotected = 0, mRtcpPacketsUnprotected = 0;
+	std::atomic<uint64_t> mRtpUnprotectFailures = 0, mRtcpUnprotectFailures = 0;
 };
 
 } // namespace rtc::impl
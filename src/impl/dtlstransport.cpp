@@ -10,12 +10,17 @@
 #include "dtlssrtptransport.hpp"
 #include "icetransport.hpp"
 #include "internals.hpp"
+#include "latencyhistogram.hpp"
+#include "logcounter.hpp"
 #include "threadpool.hpp"
+#include "tlssessioncache.hpp"
+#include "tracing.hpp"
 
 #include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <exception>
+#include <unordered_map>
 
 #if !USE_GNUTLS
 #ifdef _WIN32
@@ -29,20 +34,194 @@ using namespace std::chrono;
 
 namespace rtc::impl {
 
+static LogCounter
+    COUNTER_QUEUE_FULL("rtc_dtls_queue_full_drops", plog::warning,
+                       "Number of DTLS packets dropped due to a full incoming queue");
+static LogCounter COUNTER_HANDSHAKE_REJECTED(
+    "rtc_dtls_handshakes_rejected", plog::warning,
+    "Number of DTLS handshakes rejected because too many handshakes were pending");
+
+static LatencyHistogram HISTOGRAM_HANDSHAKE("rtc_dtls_handshake_duration",
+                                            "Time from starting a DTLS handshake to finishing it");
+
+std::atomic<size_t> DtlsTransport::PendingHandshakes = 0;
+std::atomic<size_t> DtlsTransport::MaxPendingHandshakes = 0;
+
+void DtlsTransport::SetMaxPendingHandshakes(optional<size_t> count) {
+	MaxPendingHandshakes = count.value_or(0);
+}
+
+size_t DtlsTransport::PendingHandshakesCount() { return PendingHandshakes.load(); }
+
 void DtlsTransport::enqueueRecv() {
 	if (mPendingRecvCount > 0)
 		return;
 
 	++mPendingRecvCount;
 
-	ThreadPool::Instance().enqueue([weak_this = weak_from_this()]() {
+	auto task = [weak_this = weak_from_this()]() {
 		if (auto locked = weak_this.lock())
 			locked->doRecv();
+	};
+
+	// The handshake is CPU-heavy, so it runs on the control-plane pool until connected
+	if (mExecutor)
+		mExecutor->post(std::move(task));
+	else if (state() != State::Connected)
+		ThreadPool::Control().post(std::move(task));
+	else
+		ThreadPool::Instance().post(std::move(task));
+}
+
+void DtlsTransport::setExecutor(shared_ptr<Executor> executor) { mExecutor = std::move(executor); }
+
+void DtlsTransport::enableInlineDemux() { mInlineDemux = true; }
+
+bool DtlsTransport::demuxInline(message_ptr message) {
+	// Records pending in the queue must be processed first to keep the order
+	if (state() != State::Connected || !mIncomingQueue.empty())
+		return false;
+
+	// If a worker is processing records, the message goes through the queue
+	std::unique_lock lock(mRecvMutex, std::try_to_lock);
+	if (!lock.owns_lock() || !mIncomingQueue.empty())
+		return false;
+
+	return demuxMessage(std::move(message));
+}
+
+void DtlsTransport::setRetransmitTimer(std::chrono::steady_clock::time_point time) {
+	std::lock_guard lock(mRetransmitTimerMutex);
+	mRetransmitTimer.cancel(); // superseded by the new timeout
+	mRetransmitTimer = ThreadPool::Instance().setTimer(time, [weak_this = weak_from_this()]() {
+		auto locked = weak_this.lock();
+		if (!locked)
+			return;
+
+		// Timers fire on the thread pool, so the retransmission is handed to the executor
+		if (auto executor = locked->mExecutor)
+			executor->post([locked = std::move(locked)]() { locked->doRecv(); });
+		else
+			locked->doRecv();
 	});
 }
 
+void DtlsTransport::cancelRetransmitTimer() {
+	std::lock_guard lock(mRetransmitTimerMutex);
+	mRetransmitTimer.cancel();
+	mRetransmitTimer = Timer();
+}
+
+bool DtlsTransport::outgoing(message_ptr message) {
+	message->dscp = mCurrentDscp;
+
+	if (CurrentOutgoingBatch.transport == this) {
+		CurrentOutgoingBatch.records->push_back(std::move(message));
+		return true;
+	}
+
+	bool result = Transport::outgoing(std::move(message));
+	mOutgoingResult = result;
+	return result;
+}
+
+bool DtlsTransport::flushOutgoingBatch(message_vector records) {
+	if (records.empty())
+		return mOutgoingResult;
+
+	bool result = Transport::outgoingBatch(std::move(records));
+	mOutgoingResult = result;
+	return result;
+}
+
+thread_local DtlsTransport::OutgoingBatch DtlsTransport::CurrentOutgoingBatch;
+
+DtlsTransport::OutgoingBatchScope::OutgoingBatchScope(DtlsTransport *transport,
+                                                      message_vector *records)
+    : mPrevious(std::exchange(CurrentOutgoingBatch, {transport, records})) {}
+
+DtlsTransport::OutgoingBatchScope::~OutgoingBatchScope() { CurrentOutgoingBatch = mPrevious; }
+
+optional<milliseconds> DtlsTransport::handshakeDuration() const {
+	auto duration = mHandshakeDuration.load();
+	return duration >= 0 ? optional<milliseconds>(duration) : nullopt;
+}
+
+size_t DtlsTransport::memoryUsage() const {
+	return mIncomingQueue.footprint() + mIncomingQueue.amount();
+}
+
+DtlsTransportStats DtlsTransport::dtlsStats() const {
+	DtlsTransportStats stats;
+	static_cast<TransportStats &>(stats) = Transport::stats();
+	stats.handshakeDuration = handshakeDuration();
+	if (stats.handshakeDuration)
+		stats.version = mVersion; // written before the duration, so complete here
+	return stats;
+}
+
+bool DtlsTransport::beginHandshake() {
+	// Reject early rather than queuing handshakes which would time out anyway
+	const size_t max = MaxPendingHandshakes.load();
+	if (++PendingHandshakes > max && max > 0) {
+		--PendingHandshakes;
+		COUNTER_HANDSHAKE_REJECTED++;
+		changeState(State::Failed);
+		return false;
+	}
+
+	mHandshakePending = true;
+	mHandshakeStart = steady_clock::now();
+	Tracing::Trace(TracePoint::DtlsHandshakeStart, this);
+	return true;
+}
+
+void DtlsTransport::endHandshake() {
+	if (mHandshakePending.exchange(false))
+		--PendingHandshakes;
+}
+
+void DtlsTransport::finishHandshake(bool resumed) {
+	endHandshake();
+#if USE_GNUTLS
+	const char *version = gnutls_protocol_get_name(gnutls_protocol_get_version(mSession));
+#elif USE_MBEDTLS
+	const char *version = mbedtls_ssl_get_version(&mSsl);
+#else
+	const char *version = SSL_get_version(mSsl);
+#endif
+	mVersion = version ? version : "";
+
+	const auto elapsed = steady_clock::now() - mHandshakeStart;
+	HISTOGRAM_HANDSHAKE.record(elapsed);
+	auto duration = duration_cast<milliseconds>(elapsed);
+	mHandshakeDuration = duration.count();
+	Tracing::Trace(TracePoint::DtlsHandshakeDone, this, resumed ? 1 : 0);
+	PLOG_INFO << "DTLS handshake finished" << (resumed ? " (resumed)" : "")
+	          << ", version=" << mVersion << ", duration=" << duration.count() << "ms";
+
+	if (resumed)
+		TlsSessionCache::Instance().countResumed();
+}
+
 #if USE_GNUTLS
 
+namespace {
+
+// Process-wide key so that session tickets are valid across server transports
+const gnutls_datum_t *session_ticket_key() {
+	static std::mutex mutex;
+	static gnutls_datum_t key = {};
+
+	std::lock_guard lock(mutex);
+	if (!key.data)
+		gnutls::check(gnutls_session_ticket_key_generate(&key));
+
+	return &key;
+}
+
+} // namespace
+
 void DtlsTransport::Init() {
 	gnutls_global_init(); // optional
 }
@@ -116,8 +295,12 @@ DtlsTransport::~DtlsTransport() {
 
 void DtlsTransport::start() {
 	PLOG_DEBUG << "Starting DTLS transport";
+	if (!beginHandshake())
+		return;
+
 	registerIncoming();
 	changeState(State::Connecting);
+	restoreSession();
 
 	size_t mtu = mMtu.value_or(DEFAULT_MTU) - 8 - 40; // UDP/IPv6
 	gnutls_dtls_set_mtu(mSession, static_cast<unsigned int>(mtu));
@@ -129,6 +312,8 @@ void DtlsTransport::start() {
 void DtlsTransport::stop() {
 	PLOG_DEBUG << "Stopping DTLS transport";
 	unregisterIncoming();
+	endHandshake();
+	cancelRetransmitTimer();
 	mIncomingQueue.stop();
 	enqueueRecv();
 }
@@ -155,6 +340,35 @@ bool DtlsTransport::send(message_ptr message) {
 	return mOutgoingResult;
 }
 
+bool DtlsTransport::sendBatch(message_vector messages) {
+	if (state() != State::Connected)
+		return false;
+
+	bool result = true;
+	message_vector records;
+	{
+		std::lock_guard lock(mSendMutex);
+		OutgoingBatchScope scope(this, &records);
+		for (auto &message : messages) {
+			if (!message)
+				continue;
+
+			PLOG_VERBOSE << "Send size=" << message->size();
+
+			ssize_t ret;
+			do {
+				mCurrentDscp = message->dscp;
+				ret = gnutls_record_send(mSession, message->data(), message->size());
+			} while (ret == GNUTLS_E_INTERRUPTED || ret == GNUTLS_E_AGAIN);
+
+			if (ret == GNUTLS_E_LARGE_PACKET || !gnutls::check(ret))
+				result = false;
+		}
+	}
+
+	return flushOutgoingBatch(std::move(records)) && result;
+}
+
 void DtlsTransport::incoming(message_ptr message) {
 	if (!message) {
 		mIncomingQueue.stop();
@@ -162,25 +376,12 @@ void DtlsTransport::incoming(message_ptr message) {
 	}
 
 	PLOG_VERBOSE << "Incoming size=" << message->size();
-	mIncomingQueue.push(message);
-	enqueueRecv();
-}
-
-bool DtlsTransport::outgoing(message_ptr message) {
-	message->dscp = mCurrentDscp;
-
-	bool result = Transport::outgoing(std::move(message));
-	mOutgoingResult = result;
-	return result;
-}
-
-bool DtlsTransport::demuxMessage(message_ptr) {
-	// Dummy
-	return false;
-}
+	if (mInlineDemux && demuxInline(message))
+		return;
 
-void DtlsTransport::postHandshake() {
-	// Dummy
+	if (!mIncomingQueue.push(std::move(message)))
+		COUNTER_QUEUE_FULL++; // datagrams may be dropped
+	enqueueRecv();
 }
 
 void DtlsTransport::doRecv() {
@@ -192,21 +393,18 @@ void DtlsTransport::doRecv() {
 
 	try {
 		const size_t bufferSize = 4096;
-		char buffer[bufferSize];
 
 		// Handle handshake if connecting
 		if (state() == State::Connecting) {
 			int ret;
 			do {
+				Tracing::Trace(TracePoint::DtlsHandshakeStep, this);
 				ret = gnutls_handshake(mSession);
 
 				if (ret == GNUTLS_E_AGAIN) {
 					// Schedule next call on timeout and return
 					auto timeout = milliseconds(gnutls_dtls_get_timeout(mSession));
-					ThreadPool::Instance().schedule(timeout, [weak_this = weak_from_this()]() {
-						if (auto locked = weak_this.lock())
-							locked->doRecv();
-					});
+					setRetransmitTimer(std::chrono::steady_clock::now() + timeout);
 					return;
 				}
 
@@ -220,14 +418,24 @@ void DtlsTransport::doRecv() {
 			// See https://www.rfc-editor.org/rfc/rfc8261.html#section-5
 			gnutls_dtls_set_mtu(mSession, bufferSize + 1);
 
-			PLOG_INFO << "DTLS handshake finished";
+			// The verify function is not called when resuming, check the peer stored in the session
+			const bool resumed = gnutls_session_is_resumed(mSession) != 0;
+			if (resumed && CertificateCallback(mSession) != GNUTLS_E_SUCCESS)
+				throw std::runtime_error("Resumed DTLS session failed certificate verification");
+
+			storeSession();
+			finishHandshake(resumed);
 			changeState(State::Connected);
 			postHandshake();
 		}
 
 		if (state() == State::Connected) {
+			message_ptr decrypted; // decrypt directly into a pooled message, kept until filled
 			while (true) {
-				ssize_t ret = gnutls_record_recv(mSession, buffer, bufferSize);
+				if (!decrypted)
+					decrypted = make_message(bufferSize);
+
+				ssize_t ret = gnutls_record_recv(mSession, decrypted->data(), bufferSize);
 
 				if (ret == GNUTLS_E_AGAIN) {
 					return;
@@ -257,8 +465,8 @@ void DtlsTransport::doRecv() {
 						PLOG_DEBUG << "DTLS connection cleanly closed";
 						break;
 					}
-					auto *b = reinterpret_cast<byte *>(buffer);
-					recv(make_message(b, b + ret));
+					decrypted->resize(size_t(ret));
+					recv(std::move(decrypted));
 				}
 			}
 		}
@@ -274,10 +482,49 @@ void DtlsTransport::doRecv() {
 		recv(nullptr);
 	} else {
 		PLOG_ERROR << "DTLS handshake failed";
+		endHandshake();
 		changeState(State::Failed);
 	}
 }
 
+void DtlsTransport::enableSessionResumption(string key) {
+	mSessionKey = "dtls:" + std::move(key);
+	if (!mIsClient)
+		gnutls::check(gnutls_session_ticket_enable_server(mSession, session_ticket_key()),
+		              "Failed to enable DTLS session tickets");
+}
+
+void DtlsTransport::enableDtls13() {
+	PLOG_WARNING << "DTLS 1.3 is not supported with GnuTLS, using DTLS 1.2";
+}
+
+void DtlsTransport::restoreSession() {
+	if (!mIsClient || !mSessionKey)
+		return;
+
+	if (auto session = TlsSessionCache::Instance().retrieve(*mSessionKey)) {
+		PLOG_DEBUG << "Resuming DTLS session";
+		if (gnutls_session_set_data(mSession, session->data(), session->size()) !=
+		    GNUTLS_E_SUCCESS) {
+			PLOG_WARNING << "Failed to restore DTLS session";
+			TlsSessionCache::Instance().erase(*mSessionKey);
+		}
+	}
+}
+
+void DtlsTransport::storeSession() {
+	if (!mIsClient || !mSessionKey)
+		return;
+
+	gnutls_datum_t data = {};
+	if (gnutls_session_get_data2(mSession, &data) != GNUTLS_E_SUCCESS)
+		return;
+
+	auto *b = reinterpret_cast<const byte *>(data.data);
+	TlsSessionCache::Instance().store(*mSessionKey, binary(b, b + data.size));
+	gnutls_free(data.data);
+}
+
 int DtlsTransport::CertificateCallback(gnutls_session_t session) {
 	DtlsTransport *t = static_cast<DtlsTransport *>(gnutls_session_get_ptr(session));
 	try {
@@ -454,6 +701,9 @@ void DtlsTransport::Cleanup() {
 
 void DtlsTransport::start() {
 	PLOG_DEBUG << "Starting DTLS transport";
+	if (!beginHandshake())
+		return;
+
 	registerIncoming();
 	changeState(State::Connecting);
 
@@ -470,6 +720,8 @@ void DtlsTransport::start() {
 void DtlsTransport::stop() {
 	PLOG_DEBUG << "Stopping DTLS transport";
 	unregisterIncoming();
+	endHandshake();
+	cancelRetransmitTimer();
 	mIncomingQueue.stop();
 	enqueueRecv();
 }
@@ -494,6 +746,39 @@ bool DtlsTransport::send(message_ptr message) {
 	return mOutgoingResult;
 }
 
+bool DtlsTransport::sendBatch(message_vector messages) {
+	if (state() != State::Connected)
+		return false;
+
+	bool result = true;
+	message_vector records;
+	{
+		std::lock_guard lock(mSslMutex);
+		OutgoingBatchScope scope(this, &records);
+		for (auto &message : messages) {
+			if (!message)
+				continue;
+
+			PLOG_VERBOSE << "Send size=" << message->size();
+
+			if (message->size() > size_t(mbedtls_ssl_get_max_out_record_payload(&mSsl))) {
+				result = false;
+				continue;
+			}
+
+			int ret;
+			do {
+				mCurrentDscp = message->dscp;
+				ret = mbedtls_ssl_write(&mSsl,
+				                        reinterpret_cast<const unsigned char *>(message->data()),
+				                        message->size());
+			} while (!mbedtls::check(ret));
+		}
+	}
+
+	return flushOutgoingBatch(std::move(records)) && result;
+}
+
 void DtlsTransport::incoming(message_ptr message) {
 	if (!message) {
 		mIncomingQueue.stop();
@@ -501,25 +786,12 @@ void DtlsTransport::incoming(message_ptr message) {
 	}
 
 	PLOG_VERBOSE << "Incoming size=" << message->size();
-	mIncomingQueue.push(message);
-	enqueueRecv();
-}
-
-bool DtlsTransport::outgoing(message_ptr message) {
-	message->dscp = mCurrentDscp;
-
-	bool result = Transport::outgoing(std::move(message));
-	mOutgoingResult = result;
-	return result;
-}
-
-bool DtlsTransport::demuxMessage(message_ptr) {
-	// Dummy
-	return false;
-}
+	if (mInlineDemux && demuxInline(message))
+		return;
 
-void DtlsTransport::postHandshake() {
-	// Dummy
+	if (!mIncomingQueue.push(std::move(message)))
+		COUNTER_QUEUE_FULL++; // datagrams may be dropped
+	enqueueRecv();
 }
 
 void DtlsTransport::doRecv() {
@@ -531,7 +803,6 @@ void DtlsTransport::doRecv() {
 
 	try {
 		const size_t bufferSize = 4096;
-		char buffer[bufferSize];
 
 		// Handle handshake if connecting
 		if (state() == State::Connecting) {
@@ -539,15 +810,12 @@ void DtlsTransport::doRecv() {
 				int ret;
 				{
 					std::lock_guard lock(mSslMutex);
+					Tracing::Trace(TracePoint::DtlsHandshakeStep, this);
 					ret = mbedtls_ssl_handshake(&mSsl);
 				}
 
 				if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
-					ThreadPool::Instance().schedule(mTimerSetAt + milliseconds(mFinMs),
-					                                [weak_this = weak_from_this()]() {
-						                                if (auto locked = weak_this.lock())
-							                                locked->doRecv();
-					                                });
+					setRetransmitTimer(mTimerSetAt + milliseconds(mFinMs));
 					return;
 				}
 
@@ -559,7 +827,7 @@ void DtlsTransport::doRecv() {
 						mbedtls_ssl_set_mtu(&mSsl, static_cast<unsigned int>(bufferSize + 1));
 					}
 
-					PLOG_INFO << "DTLS handshake finished";
+					finishHandshake(false);
 					changeState(State::Connected);
 					postHandshake();
 					break;
@@ -568,12 +836,16 @@ void DtlsTransport::doRecv() {
 		}
 
 		if (state() == State::Connected) {
+			message_ptr decrypted; // decrypt directly into a pooled message, kept until filled
 			while (true) {
+				if (!decrypted)
+					decrypted = make_message(bufferSize);
+
 				int ret;
 				{
 					std::lock_guard lock(mSslMutex);
-					ret = mbedtls_ssl_read(&mSsl, reinterpret_cast<unsigned char *>(buffer),
-					                       bufferSize);
+					ret = mbedtls_ssl_read(
+					    &mSsl, reinterpret_cast<unsigned char *>(decrypted->data()), bufferSize);
 				}
 
 				if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
@@ -590,8 +862,8 @@ void DtlsTransport::doRecv() {
 						PLOG_DEBUG << "DTLS connection terminated";
 						break;
 					}
-					auto *b = reinterpret_cast<byte *>(buffer);
-					recv(make_message(b, b + ret));
+					decrypted->resize(size_t(ret));
+					recv(std::move(decrypted));
 				}
 			}
 		}
@@ -605,10 +877,20 @@ void DtlsTransport::doRecv() {
 		recv(nullptr);
 	} else {
 		PLOG_ERROR << "DTLS handshake failed";
+		endHandshake();
 		changeState(State::Failed);
 	}
 }
 
+void DtlsTransport::enableSessionResumption(string) {
+	PLOG_WARNING << "DTLS session resumption is not supported with Mbed TLS";
+}
+
+void DtlsTransport::enableDtls13() {
+	// Mbed TLS 3.x implements TLS 1.3 but not DTLS 1.3
+	PLOG_WARNING << "DTLS 1.3 is not supported with Mbed TLS, using DTLS 1.2";
+}
+
 int DtlsTransport::CertificateCallback(void *ctx, mbedtls_x509_crt *crt, int /*depth*/,
                                        uint32_t * /*flags*/) {
 	auto this_ = static_cast<DtlsTransport *>(ctx);
@@ -700,7 +982,24 @@ int DtlsTransport::GetTimerCallback(void *ctx) {
 
 #else // OPENSSL
 
+namespace {
+
+// Process-wide keys so that session tickets are valid across server transports
+const unsigned char *session_ticket_keys() {
+	static unsigned char keys[80]; // name, HMAC secret, and AES key
+	static std::once_flag once;
+	std::call_once(once, []() {
+		openssl::check(RAND_bytes(keys, sizeof(keys)), "Failed to generate DTLS ticket keys");
+	});
+	return keys;
+}
+
+const unsigned char SessionIdContext[] = "libdatachannel-dtls";
+
+} // namespace
+
 BIO_METHOD *DtlsTransport::BioMethods = NULL;
+BIO_METHOD *DtlsTransport::BioReadMethods = NULL;
 int DtlsTransport::TransportExIndex = -1;
 std::mutex DtlsTransport::GlobalMutex;
 
@@ -718,6 +1017,15 @@ void DtlsTransport::Init() {
 		BIO_meth_set_write(BioMethods, BioMethodWrite);
 		BIO_meth_set_ctrl(BioMethods, BioMethodCtrl);
 	}
+	if (!BioReadMethods) {
+		BioReadMethods = BIO_meth_new(BIO_TYPE_BIO, "DTLS reader");
+		if (!BioReadMethods)
+			throw std::runtime_error("Failed to create BIO methods for DTLS reader");
+		BIO_meth_set_create(BioReadMethods, BioMethodNew);
+		BIO_meth_set_destroy(BioReadMethods, BioMethodFree);
+		BIO_meth_set_read(BioReadMethods, BioMethodRead);
+		BIO_meth_set_ctrl(BioReadMethods, BioMethodReadCtrl);
+	}
 	if (TransportExIndex < 0) {
 		TransportExIndex = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
 	}
@@ -727,6 +1035,76 @@ void DtlsTransport::Cleanup() {
 	// Nothing to do
 }
 
+shared_ptr<SSL_CTX> DtlsTransport::SharedContext(const certificate_ptr &certificate) {
+	// Contexts are immutable once created, so transports with the same certificate share one and
+	// only create their own SSL instance. Entries are keyed by fingerprint and expire with the
+	// last transport using them.
+	static std::mutex mutex;
+	static std::unordered_map<string, std::weak_ptr<SSL_CTX>> contexts;
+
+	const string key = certificate->fingerprint().value;
+	std::lock_guard lock(mutex);
+	if (auto it = contexts.find(key); it != contexts.end()) {
+		if (auto ctx = it->second.lock())
+			return ctx;
+	}
+
+	PLOG_DEBUG << "Creating shared DTLS context";
+	auto ctx = shared_ptr<SSL_CTX>(SSL_CTX_new(DTLS_method()), SSL_CTX_free);
+	if (!ctx)
+		throw std::runtime_error("Failed to create SSL context");
+
+	// RFC 8261: SCTP performs segmentation and reassembly based on the path MTU.
+	// Therefore, the DTLS layer MUST NOT use any compression algorithm.
+	// See https://www.rfc-editor.org/rfc/rfc8261.html#section-5
+	// RFC 8827: Implementations MUST NOT implement DTLS renegotiation
+	// See https://www.rfc-editor.org/rfc/rfc8827.html#section-6.5
+	SSL_CTX_set_options(ctx.get(), SSL_OP_NO_SSLv3 | SSL_OP_NO_COMPRESSION |
+	                                   SSL_OP_NO_QUERY_MTU | SSL_OP_NO_RENEGOTIATION);
+
+	// DTLS 1.3 is opt-in per instance, see enableDtls13()
+	SSL_CTX_set_min_proto_version(ctx.get(), DTLS1_VERSION);
+	SSL_CTX_set_max_proto_version(ctx.get(), DTLS1_2_VERSION);
+	SSL_CTX_set_read_ahead(ctx.get(), 1);
+	SSL_CTX_set_quiet_shutdown(ctx.get(), 0); // send the close_notify alert
+	SSL_CTX_set_info_callback(ctx.get(), InfoCallback);
+
+	SSL_CTX_set_verify(ctx.get(), SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
+	                   CertificateCallback);
+	SSL_CTX_set_verify_depth(ctx.get(), 1);
+
+	openssl::check(SSL_CTX_set_cipher_list(ctx.get(), "ALL:!SHA256:!SHA384:!aPSK:!ECDSA+SHA1:!ADH:!LOW:!EXP:!MD5:!3DES:!SSLv3:!TLSv1"),
+	               "Failed to set SSL priorities");
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000
+	openssl::check(SSL_CTX_set1_groups_list(ctx.get(), "P-256"), "Failed to set SSL groups");
+#else
+	auto ecdh = unique_ptr<EC_KEY, decltype(&EC_KEY_free)>(
+	    EC_KEY_new_by_curve_name(NID_X9_62_prime256v1), EC_KEY_free);
+	SSL_CTX_set_tmp_ecdh(ctx.get(), ecdh.get());
+#endif
+
+	auto [x509, pkey] = certificate->credentials();
+	SSL_CTX_use_certificate(ctx.get(), x509);
+	SSL_CTX_use_PrivateKey(ctx.get(), pkey);
+	openssl::check(SSL_CTX_check_private_key(ctx.get()), "SSL local private key check failed");
+
+	// Session resumption is set up for every transport, since callbacks only store sessions for
+	// transports with a session key, and tickets are only presented by clients which enabled it
+	SSL_CTX_set_session_cache_mode(ctx.get(),
+	                               SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(ctx.get(), NewSessionCallback);
+	openssl::check(SSL_CTX_set_tlsext_ticket_keys(
+	                   ctx.get(), const_cast<unsigned char *>(session_ticket_keys()), 80),
+	               "Failed to set DTLS ticket keys");
+
+	for (auto it = contexts.begin(); it != contexts.end();)
+		it = it->second.expired() ? contexts.erase(it) : std::next(it);
+
+	contexts[key] = ctx;
+	return ctx;
+}
+
 DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr certificate,
                              optional<size_t> mtu,
                              CertificateFingerprint::Algorithm fingerprintAlgorithm,
@@ -742,44 +1120,8 @@ DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr cer
 		throw std::invalid_argument("DTLS certificate is null");
 
 	try {
-		mCtx = SSL_CTX_new(DTLS_method());
-		if (!mCtx)
-			throw std::runtime_error("Failed to create SSL context");
-
-		// RFC 8261: SCTP performs segmentation and reassembly based on the path MTU.
-		// Therefore, the DTLS layer MUST NOT use any compression algorithm.
-		// See https://www.rfc-editor.org/rfc/rfc8261.html#section-5
-		// RFC 8827: Implementations MUST NOT implement DTLS renegotiation
-		// See https://www.rfc-editor.org/rfc/rfc8827.html#section-6.5
-		SSL_CTX_set_options(mCtx, SSL_OP_NO_SSLv3 | SSL_OP_NO_COMPRESSION | SSL_OP_NO_QUERY_MTU |
-		                              SSL_OP_NO_RENEGOTIATION);
-
-		SSL_CTX_set_min_proto_version(mCtx, DTLS1_VERSION);
-		SSL_CTX_set_read_ahead(mCtx, 1);
-		SSL_CTX_set_quiet_shutdown(mCtx, 0); // send the close_notify alert
-		SSL_CTX_set_info_callback(mCtx, InfoCallback);
-
-		SSL_CTX_set_verify(mCtx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT,
-		                   CertificateCallback);
-		SSL_CTX_set_verify_depth(mCtx, 1);
-
-		openssl::check(SSL_CTX_set_cipher_list(mCtx, "ALL:!SHA256:!SHA384:!aPSK:!ECDSA+SHA1:!ADH:!LOW:!EXP:!MD5:!3DES:!SSLv3:!TLSv1"),
-		               "Failed to set SSL priorities");
-
-#if OPENSSL_VERSION_NUMBER >= 0x30000000
-		openssl::check(SSL_CTX_set1_groups_list(mCtx, "P-256"), "Failed to set SSL groups");
-#else
-		auto ecdh = unique_ptr<EC_KEY, decltype(&EC_KEY_free)>(
-		    EC_KEY_new_by_curve_name(NID_X9_62_prime256v1), EC_KEY_free);
-		SSL_CTX_set_tmp_ecdh(mCtx, ecdh.get());
-#endif
-
-		auto [x509, pkey] = mCertificate->credentials();
-		SSL_CTX_use_certificate(mCtx, x509);
-		SSL_CTX_use_PrivateKey(mCtx, pkey);
-		openssl::check(SSL_CTX_check_private_key(mCtx), "SSL local private key check failed");
-
-		mSsl = SSL_new(mCtx);
+		mCtx = SharedContext(mCertificate);
+		mSsl = SSL_new(mCtx.get());
 		if (!mSsl)
 			throw std::runtime_error("Failed to create SSL instance");
 
@@ -790,12 +1132,12 @@ DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr cer
 		else
 			SSL_set_accept_state(mSsl);
 
-		mInBio = BIO_new(BIO_s_mem());
+		mInBio = BIO_new(BioReadMethods);
 		mOutBio = BIO_new(BioMethods);
 		if (!mInBio || !mOutBio)
 			throw std::runtime_error("Failed to create BIO");
 
-		BIO_set_mem_eof_return(mInBio, BIO_EOF);
+		BIO_set_data(mInBio, this);
 		BIO_set_data(mOutBio, this);
 		SSL_set_bio(mSsl, mInBio, mOutBio);
 
@@ -803,10 +1145,10 @@ DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr cer
 		// See https://www.rfc-editor.org/rfc/rfc8827.html#section-6.5
 		// Warning: SSL_set_tlsext_use_srtp() returns 0 on success and 1 on error
 #if RTC_ENABLE_MEDIA
-		// Try to use GCM suite
-		if (!DtlsSrtpTransport::IsGcmSupported() ||
-		    SSL_set_tlsext_use_srtp(
-		        mSsl, "SRTP_AEAD_AES_256_GCM:SRTP_AEAD_AES_128_GCM:SRTP_AES128_CM_SHA1_80")) {
+		// Offer the cheapest profiles on this CPU first
+		const string profiles =
+		    DtlsSrtpTransport::ProfileNames(DtlsSrtpTransport::DefaultProfiles());
+		if (SSL_set_tlsext_use_srtp(mSsl, profiles.c_str())) {
 			PLOG_WARNING << "AES-GCM for SRTP is not supported, falling back to default profile";
 			if (SSL_set_tlsext_use_srtp(mSsl, "SRTP_AES128_CM_SHA1_80"))
 				throw std::runtime_error("Failed to set SRTP profile: " +
@@ -820,8 +1162,6 @@ DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr cer
 	} catch (...) {
 		if (mSsl)
 			SSL_free(mSsl);
-		if (mCtx)
-			SSL_CTX_free(mCtx);
 		throw;
 	}
 
@@ -835,13 +1175,16 @@ DtlsTransport::~DtlsTransport() {
 
 	PLOG_DEBUG << "Destroying DTLS transport";
 	SSL_free(mSsl);
-	SSL_CTX_free(mCtx);
 }
 
 void DtlsTransport::start() {
 	PLOG_DEBUG << "Starting DTLS transport";
+	if (!beginHandshake())
+		return;
+
 	registerIncoming();
 	changeState(State::Connecting);
+	restoreSession();
 
 	int ret, err;
 	{
@@ -864,6 +1207,8 @@ void DtlsTransport::start() {
 void DtlsTransport::stop() {
 	PLOG_DEBUG << "Stopping DTLS transport";
 	unregisterIncoming();
+	endHandshake();
+	cancelRetransmitTimer();
 	mIncomingQueue.stop();
 	enqueueRecv();
 }
@@ -888,6 +1233,31 @@ bool DtlsTransport::send(message_ptr message) {
 	return mOutgoingResult;
 }
 
+bool DtlsTransport::sendBatch(message_vector messages) {
+	if (state() != State::Connected)
+		return false;
+
+	bool result = true;
+	message_vector records;
+	{
+		std::lock_guard lock(mSslMutex);
+		OutgoingBatchScope scope(this, &records);
+		for (auto &message : messages) {
+			if (!message)
+				continue;
+
+			PLOG_VERBOSE << "Send size=" << message->size();
+
+			mCurrentDscp = message->dscp;
+			int ret = SSL_write(mSsl, message->data(), int(message->size()));
+			if (!openssl::check_error(SSL_get_error(mSsl, ret)))
+				result = false;
+		}
+	}
+
+	return flushOutgoingBatch(std::move(records)) && result;
+}
+
 void DtlsTransport::incoming(message_ptr message) {
 	if (!message) {
 		mIncomingQueue.stop();
@@ -896,25 +1266,12 @@ void DtlsTransport::incoming(message_ptr message) {
 	}
 
 	PLOG_VERBOSE << "Incoming size=" << message->size();
-	mIncomingQueue.push(message);
-	enqueueRecv();
-}
-
-bool DtlsTransport::outgoing(message_ptr message) {
-	message->dscp = mCurrentDscp;
-
-	bool result = Transport::outgoing(std::move(message));
-	mOutgoingResult = result;
-	return result;
-}
-
-bool DtlsTransport::demuxMessage(message_ptr) {
-	// Dummy
-	return false;
-}
+	if (mInlineDemux && demuxInline(message))
+		return;
 
-void DtlsTransport::postHandshake() {
-	// Dummy
+	if (!mIncomingQueue.push(std::move(message)))
+		COUNTER_QUEUE_FULL++; // datagrams may be dropped
+	enqueueRecv();
 }
 
 void DtlsTransport::doRecv() {
@@ -926,7 +1283,6 @@ void DtlsTransport::doRecv() {
 
 	try {
 		const size_t bufferSize = 4096;
-		byte buffer[bufferSize];
 
 		// Process pending messages
 		while (mIncomingQueue.running()) {
@@ -943,13 +1299,18 @@ void DtlsTransport::doRecv() {
 			if (demuxMessage(message))
 				continue;
 
-			BIO_write(mInBio, message->data(), int(message->size()));
+			{
+				// The record is read by mInBio on the next SSL call, replacing an unread one
+				std::lock_guard lock(mSslMutex);
+				mInMessage = std::move(message);
+			}
 
 			if (state() == State::Connecting) {
 				// Continue the handshake
 				int ret, err;
 				{
 					std::lock_guard lock(mSslMutex);
+					Tracing::Trace(TracePoint::DtlsHandshakeStep, this);
 					ret = SSL_do_handshake(mSsl);
 					err = SSL_get_error(mSsl, ret);
 				}
@@ -957,22 +1318,41 @@ void DtlsTransport::doRecv() {
 				if (openssl::check_error(err, "Handshake failed")) {
 					// RFC 8261: DTLS MUST support sending messages larger than the current path MTU
 					// See https://www.rfc-editor.org/rfc/rfc8261.html#section-5
+					bool resumed;
+					string fingerprint;
 					{
 						std::lock_guard lock(mSslMutex);
 						SSL_set_mtu(mSsl, bufferSize + 1);
+
+						// The verify callback is not called when resuming, check the peer
+						// certificate stored in the session instead
+						if ((resumed = SSL_session_reused(mSsl) != 0)) {
+							X509 *crt = SSL_get_peer_certificate(mSsl);
+							if (!crt)
+								throw std::runtime_error("Resumed DTLS session has no certificate");
+
+							fingerprint = make_fingerprint(crt, mFingerprintAlgorithm);
+							X509_free(crt);
+						}
 					}
 
-					PLOG_INFO << "DTLS handshake finished";
+					if (resumed && !mVerifierCallback(fingerprint))
+						throw std::runtime_error(
+						    "Resumed DTLS session failed certificate verification");
+
+					finishHandshake(resumed);
 					postHandshake();
 					changeState(State::Connected);
 				}
 			}
 
 			if (state() == State::Connected) {
+				// Decrypt directly into a pooled message
+				auto decrypted = make_message(bufferSize);
 				int ret, err;
 				{
 					std::lock_guard lock(mSslMutex);
-					ret = SSL_read(mSsl, buffer, bufferSize);
+					ret = SSL_read(mSsl, decrypted->data(), int(bufferSize));
 					err = SSL_get_error(mSsl, ret);
 				}
 
@@ -981,8 +1361,10 @@ void DtlsTransport::doRecv() {
 					break;
 				}
 
-				if (openssl::check_error(err))
-					recv(make_message(buffer, buffer + ret));
+				if (openssl::check_error(err)) {
+					decrypted->resize(size_t(ret));
+					recv(std::move(decrypted));
+				}
 			}
 		}
 
@@ -999,6 +1381,7 @@ void DtlsTransport::doRecv() {
 		recv(nullptr);
 	} else {
 		PLOG_ERROR << "DTLS handshake failed";
+		endHandshake();
 		changeState(State::Failed);
 	}
 }
@@ -1025,10 +1408,50 @@ void DtlsTransport::handleTimeout() {
 			throw std::runtime_error("Handshake timeout");
 
 		LOG_VERBOSE << "DTLS retransmit timeout is " << timeout.count() << "ms";
-		ThreadPool::Instance().schedule(timeout, [weak_this = weak_from_this()]() {
-			if (auto locked = weak_this.lock())
-				locked->doRecv();
-		});
+		setRetransmitTimer(std::chrono::steady_clock::now() + timeout);
+	}
+}
+
+void DtlsTransport::enableDtls13() {
+#ifdef DTLS1_3_VERSION
+	// Peers without DTLS 1.3 negotiate DTLS 1.2, with the same supported versions as before
+	std::lock_guard lock(mSslMutex);
+	openssl::check(SSL_set_max_proto_version(mSsl, DTLS1_3_VERSION),
+	               "Failed to enable DTLS 1.3");
+#else
+	PLOG_WARNING << "DTLS 1.3 is not supported by this OpenSSL version, using DTLS 1.2";
+#endif
+}
+
+void DtlsTransport::enableSessionResumption(string key) {
+	std::lock_guard lock(mSslMutex);
+	mSessionKey = "dtls:" + std::move(key);
+	if (!mIsClient) {
+		// The shared context has the ticket keys, the session id context is copied from it when
+		// the SSL instance is created, so it must be set on the instance
+		openssl::check(
+		    SSL_set_session_id_context(mSsl, SessionIdContext, sizeof(SessionIdContext) - 1),
+		    "Failed to set DTLS session id context");
+	}
+}
+
+void DtlsTransport::restoreSession() {
+	if (!mIsClient || !mSessionKey)
+		return;
+
+	if (auto data = TlsSessionCache::Instance().retrieve(*mSessionKey)) {
+		PLOG_DEBUG << "Resuming DTLS session";
+		auto p = reinterpret_cast<const unsigned char *>(data->data());
+		SSL_SESSION *session = d2i_SSL_SESSION(NULL, &p, long(data->size()));
+		if (session && SSL_SESSION_is_resumable(session)) {
+			std::lock_guard lock(mSslMutex);
+			SSL_set_session(mSsl, session); // increments the reference count
+		} else {
+			PLOG_WARNING << "Failed to restore DTLS session";
+			TlsSessionCache::Instance().erase(*mSessionKey);
+		}
+		if (session)
+			SSL_SESSION_free(session);
 	}
 }
 
@@ -1056,6 +1479,25 @@ void DtlsTransport::InfoCallback(const SSL *ssl, int where, int ret) {
 	}
 }
 
+int DtlsTransport::NewSessionCallback(SSL *ssl, SSL_SESSION *session) {
+	DtlsTransport *t =
+	    static_cast<DtlsTransport *>(SSL_get_ex_data(ssl, DtlsTransport::TransportExIndex));
+
+	if (!t->mSessionKey)
+		return 0;
+
+	int len = i2d_SSL_SESSION(session, NULL);
+	if (len <= 0)
+		return 0;
+
+	binary data(len);
+	auto p = reinterpret_cast<unsigned char *>(data.data());
+	if (i2d_SSL_SESSION(session, &p) == len)
+		TlsSessionCache::Instance().store(*t->mSessionKey, std::move(data));
+
+	return 0; // the session is not retained
+}
+
 int DtlsTransport::BioMethodNew(BIO *bio) {
 	BIO_set_init(bio, 1);
 	BIO_set_data(bio, NULL);
@@ -1081,6 +1523,38 @@ int DtlsTransport::BioMethodWrite(BIO *bio, const char *in, int inl) {
 	return inl; // can't fail
 }
 
+int DtlsTransport::BioMethodRead(BIO *bio, char *out, int outl) {
+	BIO_clear_retry_flags(bio);
+	auto transport = reinterpret_cast<DtlsTransport *>(BIO_get_data(bio));
+	if (!transport)
+		return -1;
+
+	// Called with mSslMutex locked, each message is a whole datagram
+	auto message = std::move(transport->mInMessage);
+	if (!message) {
+		BIO_set_retry_read(bio);
+		return -1;
+	}
+
+	int len = std::min(outl, int(message->size()));
+	std::memcpy(out, message->data(), size_t(len));
+	return len;
+}
+
+long DtlsTransport::BioMethodReadCtrl(BIO *bio, int cmd, long /*num*/, void * /*ptr*/) {
+	switch (cmd) {
+	case BIO_CTRL_PENDING: {
+		auto transport = reinterpret_cast<DtlsTransport *>(BIO_get_data(bio));
+		return transport && transport->mInMessage ? long(transport->mInMessage->size()) : 0;
+	}
+	case BIO_CTRL_FLUSH:
+		return 1;
+	default:
+		break;
+	}
+	return 0;
+}
+
 long DtlsTransport::BioMethodCtrl(BIO * /*bio*/, int cmd, long /*num*/, void * /*ptr*/) {
 	switch (cmd) {
 	case BIO_CTRL_FLUSH:
@@ -11,11 +11,14 @@
 
 #include "certificate.hpp"
 #include "common.hpp"
-#include "queue.hpp"
+#include "executor.hpp"
+#include "lockfreequeue.hpp"
+#include "threadpool.hpp"
 #include "tls.hpp"
 #include "transport.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -24,11 +27,21 @@ namespace rtc::impl {
 
 class IceTransport;
 
+// DtlsSrtpTransport is the only subclass, so without media the class is final and calls on it are
+// resolved at compile time
+#if RTC_ENABLE_MEDIA
 class DtlsTransport : public Transport, public std::enable_shared_from_this<DtlsTransport> {
+#else
+class DtlsTransport final : public Transport, public std::enable_shared_from_this<DtlsTransport> {
+#endif
 public:
 	static void Init();
 	static void Cleanup();
 
+	// Handshakes in progress beyond which new ones fail immediately, not set means unlimited
+	static void SetMaxPendingHandshakes(optional<size_t> count);
+	static size_t PendingHandshakesCount();
+
 	using verifier_callback = std::function<bool(const std::string &fingerprint)>;
 
 	DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr certificate, optional<size_t> mtu,
@@ -39,17 +52,59 @@ public:
 	virtual void start() override;
 	virtual void stop() override;
 	virtual bool send(message_ptr message) override; // false if dropped
+	virtual bool sendBatch(message_vector messages) override; // encrypts all under a single lock
 
 	bool isClient() const { return mIsClient; }
 
+	// Opt-in session resumption, the key must identify both certificates, call before start()
+	void enableSessionResumption(string key);
+	// Offer DTLS 1.3 if the backend supports it, with fallback to DTLS 1.2, call before start()
+	void enableDtls13();
+	// Receive processing runs on the executor instead of the thread pool, call before start()
+	void setExecutor(shared_ptr<Executor> executor);
+	// Demultiplex incoming records on the receiving thread when possible, call before start()
+	void enableInlineDemux();
+	optional<std::chrono::milliseconds> handshakeDuration() const;
+	size_t memoryUsage() const; // bytes held in the incoming queue
+	virtual DtlsTransportStats dtlsStats() const;
+
 protected:
 	virtual void incoming(message_ptr message) override;
 	virtual bool outgoing(message_ptr message) override;
-	virtual bool demuxMessage(message_ptr message);
-	virtual void postHandshake();
+#if RTC_ENABLE_MEDIA
+	virtual bool demuxMessage(message_ptr) { return false; } // true if the message was consumed
+	virtual void postHandshake() {}
+#else
+	// Inlined in the record loop of the handshake and receive paths
+	bool demuxMessage(message_ptr) { return false; }
+	void postHandshake() {}
+#endif
+	bool demuxInline(message_ptr message); // true if the message was consumed
 
 	void enqueueRecv();
 	void doRecv();
+	void setRetransmitTimer(std::chrono::steady_clock::time_point time);
+	void cancelRetransmitTimer();
+	bool beginHandshake(); // false if rejected, the transport is then failed
+	void endHandshake();
+	void finishHandshake(bool resumed);
+	bool flushOutgoingBatch(message_vector records);
+
+	// Records written by the current thread during sendBatch(), they are passed down at once
+	struct OutgoingBatch {
+		DtlsTransport *transport = nullptr;
+		message_vector *records = nullptr;
+	};
+	static thread_local OutgoingBatch CurrentOutgoingBatch;
+
+	class OutgoingBatchScope final { // restores the previous batch on exit
+	public:
+		OutgoingBatchScope(DtlsTransport *transport, message_vector *records);
+		~OutgoingBatchScope();
+
+	private:
+		const OutgoingBatch mPrevious;
+	};
 
 	const optional<size_t> mMtu;
 	const certificate_ptr mCertificate;
@@ -57,16 +112,32 @@ protected:
 	const verifier_callback mVerifierCallback;
 	const bool mIsClient;
 
-	Queue<message_ptr> mIncomingQueue;
+	LockFreeQueue<message_ptr> mIncomingQueue; // pushed by ICE, popped by doRecv()
 	std::atomic<int> mPendingRecvCount = 0;
 	std::mutex mRecvMutex;
 	std::atomic<unsigned int> mCurrentDscp = 0;
 	std::atomic<bool> mOutgoingResult = true;
+	Timer mRetransmitTimer;
+	std::mutex mRetransmitTimerMutex;
+	shared_ptr<Executor> mExecutor;
+	bool mInlineDemux = false;
+
+	optional<string> mSessionKey; // set if session resumption is enabled
+	std::chrono::steady_clock::time_point mHandshakeStart;
+	std::atomic<bool> mHandshakePending = false; // counted in PendingHandshakes
+	std::atomic<int64_t> mHandshakeDuration = -1; // in milliseconds, -1 until finished
+	string mVersion; // negotiated, set before mHandshakeDuration
+
+	static std::atomic<size_t> PendingHandshakes;
+	static std::atomic<size_t> MaxPendingHandshakes; // 0 means unlimited
 
 #if USE_GNUTLS
 	gnutls_session_t mSession;
 	std::mutex mSendMutex;
 
+	void restoreSession();
+	void storeSession();
+
 	static int CertificateCallback(gnutls_session_t session);
 	static ssize_t WriteCallback(gnutls_transport_ptr_t ptr, const void *data, size_t len);
 	static ssize_t ReadCallback(gnutls_transport_ptr_t ptr, void *data, size_t maxlen);
@@ -99,24 +170,32 @@ protected:
 	static int GetTimerCallback(void *ctx);
 
 #else // OPENSSL
-	SSL_CTX *mCtx = NULL;
+	shared_ptr<SSL_CTX> mCtx; // shared with the transports using the same certificate
 	SSL *mSsl = NULL;
 	BIO *mInBio, *mOutBio;
+	message_ptr mInMessage; // incoming record read directly by mInBio, no intermediate copy
 	std::mutex mSslMutex;
 
+	static shared_ptr<SSL_CTX> SharedContext(const certificate_ptr &certificate);
+
 	void handleTimeout();
+	void restoreSession();
 
 	static BIO_METHOD *BioMethods;
+	static BIO_METHOD *BioReadMethods;
 	static int TransportExIndex;
 	static std::mutex GlobalMutex;
 
 	static int CertificateCallback(int preverify_ok, X509_STORE_CTX *ctx);
 	static void InfoCallback(const SSL *ssl, int where, int ret);
+	static int NewSessionCallback(SSL *ssl, SSL_SESSION *session);
 
 	static int BioMethodNew(BIO *bio);
 	static int BioMethodFree(BIO *bio);
 	static int BioMethodWrite(BIO *bio, const char *in, int inl);
 	static long BioMethodCtrl(BIO *bio, int cmd, long num, void *ptr);
+	static int BioMethodRead(BIO *bio, char *out, int outl);
+	static long BioMethodReadCtrl(BIO *bio, int cmd, long num, void *ptr);
 #endif
 };
 
@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "executor.hpp"
+#include "internals.hpp"
+#include "threadpool.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+Executor::Executor(optional<unsigned int> cpu) {
+	mThread = std::thread([this, cpu]() {
+		utils::this_thread::set_name("RTC executor");
+		if (cpu && !utils::this_thread::set_affinity({*cpu})) {
+			PLOG_WARNING << "Failed to pin executor thread to CPU " << *cpu;
+		}
+
+		run();
+	});
+}
+
+Executor::~Executor() { join(); }
+
+void Executor::post(Task task) noexcept {
+	std::unique_lock lock(mMutex);
+	if (mJoining) {
+		lock.unlock();
+		ThreadPool::Instance().post(std::move(task));
+		return;
+	}
+
+	mTasks.push_back(std::move(task));
+	mCondition.notify_one();
+}
+
+void Executor::join() {
+	{
+		std::unique_lock lock(mMutex);
+		if (mJoining)
+			return;
+
+		mJoining = true;
+		mCondition.notify_one();
+	}
+
+	if (!mThread.joinable())
+		return;
+
+	if (mThread.get_id() == std::this_thread::get_id())
+		mThread.detach(); // the last reference was released by a task
+	else
+		mThread.join();
+}
+
+void Executor::run() {
+	std::unique_lock lock(mMutex);
+	while (true) {
+		mCondition.wait(lock, [this]() { return !mTasks.empty() || mJoining; });
+		if (mTasks.empty())
+			break; // joining
+
+		Task task = std::move(mTasks.front());
+		mTasks.pop_front();
+
+		// A task may release the last reference to the executor, so keep it alive while running
+		auto self = weak_from_this().lock();
+		lock.unlock();
+		task();
+		task = nullptr; // destroy the task without the lock
+
+		if (self) {
+			// If the last reference is released here, the executor is destroyed on its own thread,
+			// which is then detached, so members must not be accessed anymore
+			weak_ptr<Executor> weak = self;
+			self.reset();
+			if (weak.expired())
+				return;
+		}
+
+		lock.lock();
+	}
+}
+
+ExecutorPool &ExecutorPool::Instance() {
+	static ExecutorPool *instance = new ExecutorPool;
+	return *instance;
+}
+
+ExecutorPool::ExecutorPool() {}
+
+ExecutorPool::~ExecutorPool() {}
+
+void ExecutorPool::setSettings(optional<unsigned int> count, bool pinned,
+                               std::vector<unsigned int> cpus) {
+	std::lock_guard lock(mMutex);
+	mCount = count;
+	mPinned = pinned || !cpus.empty();
+	mCpus = std::move(cpus);
+}
+
+shared_ptr<Executor> ExecutorPool::next() {
+	std::lock_guard lock(mMutex);
+	const unsigned int cores = std::max(std::thread::hardware_concurrency(), 1u);
+	const unsigned int defaultCount = !mCpus.empty() ? unsigned(mCpus.size()) : cores;
+	const size_t count = std::max(mCount.value_or(defaultCount), 1u);
+	if (mExecutors.size() < count) {
+		optional<unsigned int> cpu;
+		if (!mCpus.empty())
+			cpu = mCpus[mExecutors.size() % mCpus.size()];
+		else if (mPinned)
+			cpu = unsigned(mExecutors.size() % cores);
+
+		PLOG_DEBUG << "Spawning executor " << mExecutors.size();
+		mExecutors.push_back(std::make_shared<Executor>(cpu));
+		return mExecutors.back();
+	}
+
+	return mExecutors[mNext++ % mExecutors.size()];
+}
+
+void ExecutorPool::join() {
+	std::vector<shared_ptr<Executor>> executors;
+	{
+		std::lock_guard lock(mMutex);
+		executors = std::exchange(mExecutors, {});
+		mNext = 0;
+	}
+
+	for (auto &executor : executors)
+		executor->join();
+}
+
+} // namespace rtc::impl
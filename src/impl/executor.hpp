@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_EXECUTOR_H
+#define RTC_IMPL_EXECUTOR_H
+
+#include "common.hpp"
+#include "task.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rtc::impl {
+
+// Dedicated thread running tasks in order. Objects bound to an executor, like the processors and
+// transports of a PeerConnection with executor affinity, run to completion on the same thread,
+// which keeps their state in the caches of one core instead of bouncing between workers.
+class Executor final : public std::enable_shared_from_this<Executor> {
+public:
+	explicit Executor(optional<unsigned int> cpu = nullopt);
+	~Executor();
+
+	Executor(const Executor &) = delete;
+	Executor &operator=(const Executor &) = delete;
+
+	// Once the executor is joined, tasks are posted to the thread pool instead
+	void post(Task task) noexcept;
+	void join(); // runs the remaining tasks, then stops the thread
+
+private:
+	void run();
+
+	std::deque<Task> mTasks;
+	bool mJoining = false;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::thread mThread;
+};
+
+// Executors are spawned on demand up to the configured count and assigned in turn
+class ExecutorPool final {
+public:
+	static ExecutorPool &Instance();
+
+	ExecutorPool(const ExecutorPool &) = delete;
+	ExecutorPool &operator=(const ExecutorPool &) = delete;
+
+	// Applies to new executors, which are pinned in turn to cpus if not empty
+	void setSettings(optional<unsigned int> count, bool pinned, std::vector<unsigned int> cpus);
+	shared_ptr<Executor> next();
+	void join(); // called on cleanup
+
+private:
+	ExecutorPool();
+	~ExecutorPool();
+
+	std::vector<shared_ptr<Executor>> mExecutors;
+	size_t mNext = 0;
+	optional<unsigned int> mCount;
+	bool mPinned = false;
+	std::vector<unsigned int> mCpus;
+	std::mutex mMutex;
+};
+
+} // namespace rtc::impl
+
+#endif
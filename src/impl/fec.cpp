@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "fec.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RTC_FEC_XOR_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define RTC_FEC_XOR_NEON 1
+#endif
+
+namespace rtc::impl {
+
+// SSE2 and NEON are part of the baseline on x86_64 and ARM64, so no runtime dispatch is needed,
+// other targets process 8 bytes at a time.
+void fec_xor(byte *dst, const byte *src, size_t size) {
+	size_t i = 0;
+
+#if RTC_FEC_XOR_SSE2
+	for (; i + 16 <= size; i += 16) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(a, b));
+	}
+#elif RTC_FEC_XOR_NEON
+	for (; i + 16 <= size; i += 16) {
+		uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(dst + i));
+		uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(src + i));
+		vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), veorq_u8(a, b));
+	}
+#endif
+
+	for (; i + 8 <= size; i += 8) {
+		uint64_t a, b;
+		std::memcpy(&a, dst + i, 8);
+		std::memcpy(&b, src + i, 8);
+		a ^= b;
+		std::memcpy(dst + i, &a, 8);
+	}
+
+	for (; i < size; ++i)
+		dst[i] ^= src[i];
+}
+
+} // namespace rtc::impl
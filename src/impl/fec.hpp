@@ -0,0 +1,26 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_FEC_H
+#define RTC_IMPL_FEC_H
+
+#include "common.hpp"
+
+namespace rtc::impl {
+
+// FlexFEC-03 header (draft-ietf-payload-flexible-fec-scheme-03) with a single SSRC, as used by
+// browsers. The size is the one with the shortest mask, longer masks add 4 or 12 bytes.
+const size_t FLEXFEC_HEADER_SIZE = 20;
+const size_t FLEXFEC_RTP_HEADER_SIZE = 12; // protected bytes start after the fixed RTP header
+
+// XOR size bytes of src into dst
+void fec_xor(byte *dst, const byte *src, size_t size);
+
+} // namespace rtc::impl
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "gccestimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rtc::impl {
+
+namespace {
+
+using std::chrono::duration;
+
+// Parameters from draft-ietf-rmcat-gcc-02 and the libwebrtc trendline estimator
+const auto BURST_INTERVAL = std::chrono::milliseconds(5);
+const size_t TREND_WINDOW_SIZE = 20;
+const double TREND_SMOOTHING = 0.9;
+const double TREND_GAIN = 4.;
+const unsigned int TREND_MAX_DELTAS = 60;
+const double INITIAL_THRESHOLD = 12.5; // ms
+const double MIN_THRESHOLD = 6.;
+const double MAX_THRESHOLD = 600.;
+const double THRESHOLD_K_UP = 0.0087;
+const double THRESHOLD_K_DOWN = 0.039;
+const double OVERUSE_TIME_THRESHOLD = 10.; // ms
+const double BETA = 0.85;                   // multiplicative decrease
+const double INCREASE_FACTOR = 1.08;        // multiplicative increase per second
+const double STARTUP_INCREASE_FACTOR = 2.;  // per second, until the first congestion signal
+const double ADDITIVE_INCREASE = 50000.;    // bits per second per second, near convergence
+const double LOSS_HIGH = 0.10;
+const double LOSS_LOW = 0.02;
+const double LOSS_INCREASE_FACTOR = 1.05;
+const unsigned int LOSS_MIN_PACKETS = 20;
+const auto ACKNOWLEDGED_WINDOW = std::chrono::milliseconds(500);
+const double PROBE_ACCEPT_FACTOR = 0.85; // of the acknowledged bitrate after a probe
+
+template <typename Duration> double to_ms(Duration d) {
+	return duration<double, std::milli>(d).count();
+}
+
+} // namespace
+
+GccEstimator::GccEstimator(double startBitrate, double minBitrate, double maxBitrate)
+    : mMinBitrate(minBitrate), mMaxBitrate(std::max(minBitrate, maxBitrate)),
+      mThreshold(INITIAL_THRESHOLD),
+      mDelayBitrate(std::clamp(startBitrate, mMinBitrate, mMaxBitrate)),
+      mLossBitrate(mDelayBitrate), mTargetBitrate(mDelayBitrate) {}
+
+void GccEstimator::update(const std::vector<PacketResult> &results, clock::time_point now) {
+	for (const auto &result : results) {
+		++mLossTotal;
+		if (!result.received) {
+			++mLossCount;
+			continue;
+		}
+
+		if (!result.sendTime)
+			continue; // unknown packet
+
+		mAcknowledged.emplace_back(result.arrivalTime, result.size);
+
+		const auto sendTime = *result.sendTime;
+		if (mCurrentGroup && sendTime < mCurrentGroup->firstSend)
+			continue; // reordered, ignore for delay estimation
+
+		if (mCurrentGroup && sendTime - mCurrentGroup->firstSend <= BURST_INTERVAL) {
+			mCurrentGroup->lastSend = std::max(mCurrentGroup->lastSend, sendTime);
+			auto &lastArrival = mCurrentGroup->lastArrival;
+			lastArrival = std::max(lastArrival, result.arrivalTime);
+			continue;
+		}
+
+		// A new group starts, compute the delay variation between the two previous ones
+		if (mCurrentGroup && mPreviousGroup) {
+			const double sendDelta = to_ms(mCurrentGroup->lastSend - mPreviousGroup->lastSend);
+			const double arrivalDelta =
+			    to_ms(mCurrentGroup->lastArrival - mPreviousGroup->lastArrival);
+			updateTrendline(sendDelta, arrivalDelta, to_ms(mCurrentGroup->lastArrival));
+		}
+
+		mPreviousGroup = mCurrentGroup;
+		mCurrentGroup = Group{sendTime, sendTime, result.arrivalTime};
+	}
+
+	// Drop the acknowledged packets out of the window
+	if (!mAcknowledged.empty()) {
+		const auto last = mAcknowledged.back().first;
+		while (mAcknowledged.front().first < last - ACKNOWLEDGED_WINDOW)
+			mAcknowledged.pop_front();
+	}
+
+	updateRate(now);
+}
+
+void GccEstimator::probed(clock::time_point now) { mLastProbe = now; }
+
+double GccEstimator::targetBitrate() const { return mTargetBitrate; }
+
+bool GccEstimator::isIncreasing() const { return mRateState == RateState::Increase; }
+
+bool GccEstimator::isStartup() const { return mStartup; }
+
+optional<GccEstimator::clock::time_point> GccEstimator::lastProbe() const { return mLastProbe; }
+
+void GccEstimator::updateTrendline(double sendDelta, double arrivalDelta, double arrivalTime) {
+	const double delta = arrivalDelta - sendDelta;
+	mDeltasCount = std::min(mDeltasCount + 1, 1000u);
+	if (!mFirstArrival)
+		mFirstArrival = arrivalTime;
+
+	mAccumulatedDelay += delta;
+	mSmoothedDelay = TREND_SMOOTHING * mSmoothedDelay + (1. - TREND_SMOOTHING) * mAccumulatedDelay;
+	mTrendWindow.emplace_back(arrivalTime - *mFirstArrival, mSmoothedDelay);
+	if (mTrendWindow.size() > TREND_WINDOW_SIZE)
+		mTrendWindow.pop_front();
+
+	double trend = mPreviousTrend;
+	if (mTrendWindow.size() == TREND_WINDOW_SIZE) {
+		// Linear regression of the smoothed delay against the arrival time
+		double meanX = 0., meanY = 0.;
+		for (const auto &[x, y] : mTrendWindow) {
+			meanX += x;
+			meanY += y;
+		}
+		meanX /= double(mTrendWindow.size());
+		meanY /= double(mTrendWindow.size());
+
+		double numerator = 0., denominator = 0.;
+		for (const auto &[x, y] : mTrendWindow) {
+			numerator += (x - meanX) * (y - meanY);
+			denominator += (x - meanX) * (x - meanX);
+		}
+		if (denominator != 0.)
+			trend = numerator / denominator;
+	}
+
+	detect(trend, sendDelta, arrivalTime);
+}
+
+void GccEstimator::detect(double trend, double sendDelta, double now) {
+	const double modifiedTrend =
+	    double(std::min(mDeltasCount, TREND_MAX_DELTAS)) * trend * TREND_GAIN;
+	if (modifiedTrend > mThreshold) {
+		mOveruseTime = mOveruseTime < 0. ? sendDelta / 2. : mOveruseTime + sendDelta;
+		++mOveruseCount;
+		if (mOveruseTime > OVERUSE_TIME_THRESHOLD && mOveruseCount > 1 && trend >= mPreviousTrend) {
+			mOveruseTime = 0.;
+			mOveruseCount = 0;
+			mUsage = Usage::Overusing;
+		}
+	} else if (modifiedTrend < -mThreshold) {
+		mOveruseTime = -1.;
+		mOveruseCount = 0;
+		mUsage = Usage::Underusing;
+	} else {
+		mOveruseTime = -1.;
+		mOveruseCount = 0;
+		mUsage = Usage::Normal;
+	}
+
+	mPreviousTrend = trend;
+	updateThreshold(modifiedTrend, now);
+}
+
+void GccEstimator::updateThreshold(double modifiedTrend, double now) {
+	if (!mLastThresholdUpdate)
+		mLastThresholdUpdate = now;
+
+	// Do not adapt to sudden large spikes
+	const double absTrend = std::abs(modifiedTrend);
+	if (absTrend > mThreshold + 15.) {
+		mLastThresholdUpdate = now;
+		return;
+	}
+
+	const double k = absTrend < mThreshold ? THRESHOLD_K_DOWN : THRESHOLD_K_UP;
+	const double elapsed = std::min(now - *mLastThresholdUpdate, 100.);
+	mThreshold += k * (absTrend - mThreshold) * elapsed;
+	mThreshold = std::clamp(mThreshold, MIN_THRESHOLD, MAX_THRESHOLD);
+	mLastThresholdUpdate = now;
+}
+
+optional<double> GccEstimator::acknowledgedBitrate() const {
+	if (mAcknowledged.size() < 2)
+		return nullopt;
+
+	const double elapsed = to_ms(mAcknowledged.back().first - mAcknowledged.front().first);
+	if (elapsed < 50.)
+		return nullopt; // not meaningful yet
+
+	size_t bytes = 0;
+	for (const auto &[arrival, size] : mAcknowledged)
+		bytes += size;
+
+	return double(bytes) * 8. * 1000. / elapsed;
+}
+
+void GccEstimator::updateRate(clock::time_point now) {
+	const double elapsed =
+	    mLastRateUpdate ? std::min(duration<double>(now - *mLastRateUpdate).count(), 1.) : 0.;
+	mLastRateUpdate = now;
+
+	const auto acknowledged = acknowledgedBitrate();
+
+	// AIMD rate control driven by the overuse detector
+	switch (mUsage) {
+	case Usage::Overusing:
+		if (mRateState != RateState::Decrease)
+			mRateState = RateState::Decrease;
+		break;
+	case Usage::Underusing:
+		mRateState = RateState::Hold;
+		break;
+	case Usage::Normal:
+		if (mRateState == RateState::Hold)
+			mRateState = RateState::Increase;
+		else if (mRateState == RateState::Decrease)
+			mRateState = RateState::Hold;
+		break;
+	}
+
+	switch (mRateState) {
+	case RateState::Increase: {
+		const bool nearConvergence =
+		    mLastDecreaseBitrate && acknowledged &&
+		    std::abs(*acknowledged - *mLastDecreaseBitrate) < 0.2 * *mLastDecreaseBitrate;
+		if (nearConvergence)
+			mDelayBitrate += ADDITIVE_INCREASE * elapsed;
+		else
+			mDelayBitrate *=
+			    std::pow(mStartup ? STARTUP_INCREASE_FACTOR : INCREASE_FACTOR, elapsed);
+
+		// Do not go too far above what actually goes through, but accept what a probe got through
+		// without overuse
+		if (acknowledged) {
+			mDelayBitrate = std::min(mDelayBitrate, 1.5 * *acknowledged + 10000.);
+			if (mLastProbe && now - *mLastProbe <= ACKNOWLEDGED_WINDOW * 2)
+				mDelayBitrate = std::max(mDelayBitrate, PROBE_ACCEPT_FACTOR * *acknowledged);
+		}
+		break;
+	}
+	case RateState::Decrease:
+		mDelayBitrate = std::min(mDelayBitrate, BETA * acknowledged.value_or(mDelayBitrate));
+		mLastDecreaseBitrate = acknowledged;
+		mStartup = false;
+		mRateState = RateState::Hold; // decrease once per overuse
+		mUsage = Usage::Normal;
+		break;
+	case RateState::Hold:
+		break;
+	}
+
+	mDelayBitrate = std::clamp(mDelayBitrate, mMinBitrate, mMaxBitrate);
+
+	// Loss-based control, relative to the current target
+	if (mLossTotal >= LOSS_MIN_PACKETS) {
+		const double fraction = double(mLossCount) / double(mLossTotal);
+		if (fraction > LOSS_HIGH) {
+			mLossBitrate = mTargetBitrate * (1. - 0.5 * fraction);
+			mStartup = false;
+		} else if (fraction < LOSS_LOW) {
+			mLossBitrate = mTargetBitrate * LOSS_INCREASE_FACTOR;
+		} else {
+			mLossBitrate = mTargetBitrate;
+		}
+
+		mLossTotal = 0;
+		mLossCount = 0;
+	}
+
+	mLossBitrate = std::clamp(mLossBitrate, mMinBitrate, mMaxBitrate);
+	mTargetBitrate = std::min(mDelayBitrate, mLossBitrate);
+}
+
+} // namespace rtc::impl
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_GCC_ESTIMATOR_H
+#define RTC_IMPL_GCC_ESTIMATOR_H
+
+#include "common.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include "twcchandler.hpp"
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace rtc::impl {
+
+// Bandwidth estimation of Google Congestion Control (draft-ietf-rmcat-gcc-02), combining a
+// delay-based estimate (trendline filter, overuse detector, and AIMD rate control) with a
+// loss-based one. The current time is passed by the caller, and it is not thread-safe.
+class GccEstimator final {
+public:
+	using clock = std::chrono::steady_clock;
+	using PacketResult = TwccHandler::PacketResult;
+
+	GccEstimator(double startBitrate, double minBitrate, double maxBitrate);
+
+	void update(const std::vector<PacketResult> &results, clock::time_point now);
+	void probed(clock::time_point now); // what goes through shortly after is accepted
+
+	double targetBitrate() const;
+	bool isIncreasing() const;
+	bool isStartup() const; // true until the first congestion signal
+	optional<clock::time_point> lastProbe() const;
+
+private:
+	enum class Usage { Normal, Overusing, Underusing };
+	enum class RateState { Hold, Increase, Decrease };
+
+	// Packets sent in a short burst of time, the delay variation is measured between groups
+	struct Group {
+		clock::time_point firstSend;
+		clock::time_point lastSend;
+		std::chrono::microseconds lastArrival;
+	};
+
+	void updateTrendline(double sendDelta, double arrivalDelta, double arrivalTime);
+	void detect(double trend, double sendDelta, double now);
+	void updateThreshold(double modifiedTrend, double now);
+	optional<double> acknowledgedBitrate() const;
+	void updateRate(clock::time_point now);
+
+	const double mMinBitrate;
+	const double mMaxBitrate;
+
+	// Delay-based estimation
+	optional<Group> mCurrentGroup;
+	optional<Group> mPreviousGroup;
+	std::deque<std::pair<double, double>> mTrendWindow; // arrival time and smoothed delay in ms
+	optional<double> mFirstArrival;
+	double mAccumulatedDelay = 0.;
+	double mSmoothedDelay = 0.;
+	unsigned int mDeltasCount = 0;
+	double mPreviousTrend = 0.;
+	double mThreshold;
+	optional<double> mLastThresholdUpdate;
+	double mOveruseTime = -1.;
+	unsigned int mOveruseCount = 0;
+	Usage mUsage = Usage::Normal;
+	RateState mRateState = RateState::Hold;
+	double mDelayBitrate;
+	optional<double> mLastDecreaseBitrate;
+	bool mStartup = true; // ramp up quickly until the first congestion signal
+
+	// Acknowledged bitrate over a sliding window of arrival times
+	std::deque<std::pair<std::chrono::microseconds, size_t>> mAcknowledged;
+
+	// Loss-based estimation
+	unsigned int mLossTotal = 0;
+	unsigned int mLossCount = 0;
+	double mLossBitrate;
+
+	double mTargetBitrate;
+	optional<clock::time_point> mLastRateUpdate;
+	optional<clock::time_point> mLastProbe;
+};
+
+} // namespace rtc::impl
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_HANDLE_TABLE_H
+#define RTC_IMPL_HANDLE_TABLE_H
+
+#include "common.hpp"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace rtc::impl {
+
+// Table of objects referenced by positive integer handles, for the C API
+// A handle is a slot index tagged with the generation of the slot, so a stale handle does not
+// resolve to an object emplaced later in the same slot. get() takes no lock: readers pin the slot
+// with a per-slot counter, and erase() waits for the pinned readers before releasing the object.
+// emplace() and erase() are serialized by a mutex.
+template <typename T> class HandleTable final {
+public:
+	HandleTable() = default;
+	~HandleTable();
+
+	HandleTable(const HandleTable &) = delete;
+	HandleTable &operator=(const HandleTable &) = delete;
+
+	template <typename... Args> int emplace(Args &&...args);
+	shared_ptr<T> get(int id) const; // null if the handle does not exist
+	shared_ptr<T> erase(int id);     // null if the handle does not exist
+	std::vector<shared_ptr<T>> clear();
+
+private:
+	static const int IndexBits = 20; // up to 1M objects at the same time
+	static const uint32_t IndexMask = (uint32_t(1) << IndexBits) - 1;
+	static const uint32_t GenerationMask = (uint32_t(1) << (31 - IndexBits)) - 1;
+	static const int ChunkBits = 10;
+	static const size_t ChunkSize = size_t(1) << ChunkBits;
+	static const size_t MaxChunks = (size_t(IndexMask) + 1) >> ChunkBits;
+
+	struct Entry {
+		template <typename... Args>
+		Entry(int id_, Args &&...args) : id(id_), value(std::forward<Args>(args)...) {}
+
+		const int id;
+		T value;
+	};
+
+	struct Slot {
+		std::atomic<Entry *> entry = nullptr;
+		mutable std::atomic<unsigned int> readers = 0;
+		shared_ptr<Entry> owner; // written only while entry is null and no reader is pinned
+		uint32_t generation = 0; // guarded by mMutex
+	};
+
+	Slot *find(uint32_t index) const;
+	shared_ptr<T> release(Slot &slot);
+
+	// Chunks are allocated on demand and never freed before destruction, so lookups may
+	// dereference them without synchronization other than the atomic pointer
+	std::array<std::atomic<Slot *>, MaxChunks> mChunks = {};
+	std::mutex mMutex;
+	std::deque<uint32_t> mFreeIndexes; // reused in FIFO order to delay generation wrap-around
+	uint32_t mNextIndex = 1;           // index 0 is unused so handles are positive
+};
+
+template <typename T> HandleTable<T>::~HandleTable() {
+	for (auto &chunk : mChunks)
+		delete[] chunk.load();
+}
+
+template <typename T> template <typename... Args> int HandleTable<T>::emplace(Args &&...args) {
+	std::lock_guard lock(mMutex);
+	const bool reuse = !mFreeIndexes.empty();
+	const uint32_t index = reuse ? mFreeIndexes.front() : mNextIndex;
+	if (index > IndexMask)
+		throw std::runtime_error("Too many handles");
+
+	auto &chunk = mChunks[index >> ChunkBits];
+	if (!chunk.load(std::memory_order_relaxed))
+		chunk.store(new Slot[ChunkSize], std::memory_order_release);
+
+	Slot &slot = chunk.load(std::memory_order_relaxed)[index & (ChunkSize - 1)];
+	const int id = int(((slot.generation & GenerationMask) << IndexBits) | index);
+	slot.owner = std::make_shared<Entry>(id, std::forward<Args>(args)...);
+	slot.entry.store(slot.owner.get());
+
+	if (reuse)
+		mFreeIndexes.pop_front();
+	else
+		++mNextIndex;
+
+	return id;
+}
+
+template <typename T> shared_ptr<T> HandleTable<T>::get(int id) const {
+	if (id <= 0)
+		return nullptr;
+
+	Slot *slot = find(uint32_t(id) & IndexMask);
+	if (!slot)
+		return nullptr;
+
+	// Sequentially consistent operations guarantee that either erase() sees the reader, or the
+	// reader sees the null entry
+	slot->readers.fetch_add(1);
+	shared_ptr<T> result;
+	if (Entry *entry = slot->entry.load(); entry && entry->id == id)
+		result = shared_ptr<T>(slot->owner, &entry->value);
+
+	slot->readers.fetch_sub(1);
+	return result;
+}
+
+template <typename T> shared_ptr<T> HandleTable<T>::erase(int id) {
+	if (id <= 0)
+		return nullptr;
+
+	std::lock_guard lock(mMutex);
+	const uint32_t index = uint32_t(id) & IndexMask;
+	Slot *slot = find(index);
+	if (!slot)
+		return nullptr;
+
+	if (Entry *entry = slot->entry.load(); !entry || entry->id != id)
+		return nullptr;
+
+	auto result = release(*slot);
+	mFreeIndexes.push_back(index);
+	return result;
+}
+
+template <typename T> std::vector<shared_ptr<T>> HandleTable<T>::clear() {
+	std::lock_guard lock(mMutex);
+	std::vector<shared_ptr<T>> result;
+	for (uint32_t index = 1; index < mNextIndex; ++index) {
+		Slot *slot = find(index);
+		if (slot->entry.load()) {
+			result.push_back(release(*slot));
+			mFreeIndexes.push_back(index);
+		}
+	}
+	return result;
+}
+
+template <typename T> typename HandleTable<T>::Slot *HandleTable<T>::find(uint32_t index) const {
+	Slot *chunk = mChunks[index >> ChunkBits].load(std::memory_order_acquire);
+	return chunk ? &chunk[index & (ChunkSize - 1)] : nullptr;
+}
+
+template <typename T> shared_ptr<T> HandleTable<T>::release(Slot &slot) {
+	slot.entry.store(nullptr);
+
+	// Readers only copy the pointer, so they are never pinned for long
+	while (slot.readers.load() != 0)
+		std::this_thread::yield();
+
+	auto owner = std::move(slot.owner);
+	slot.owner.reset();
+	++slot.generation;
+	return shared_ptr<T>(owner, &owner->value);
+}
+
+} // namespace rtc::impl
+
+#endif
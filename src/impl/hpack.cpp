@@ -0,0 +1,405 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "hpack.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include <array>
+#include <stdexcept>
+
+namespace rtc::impl {
+
+namespace {
+
+struct StaticEntry {
+	const char *name;
+	const char *value;
+};
+
+// RFC 7541 Appendix A
+const StaticEntry StaticTable[] = {
+	{":authority", ""},
+	{":method", "GET"},
+	{":method", "POST"},
+	{":path", "/"},
+	{":path", "/index.html"},
+	{":scheme", "http"},
+	{":scheme", "https"},
+	{":status", "200"},
+	{":status", "204"},
+	{":status", "206"},
+	{":status", "304"},
+	{":status", "400"},
+	{":status", "404"},
+	{":status", "500"},
+	{"accept-charset", ""},
+	{"accept-encoding", "gzip, deflate"},
+	{"accept-language", ""},
+	{"accept-ranges", ""},
+	{"accept", ""},
+	{"access-control-allow-origin", ""},
+	{"age", ""},
+	{"allow", ""},
+	{"authorization", ""},
+	{"cache-control", ""},
+	{"content-disposition", ""},
+	{"content-encoding", ""},
+	{"content-language", ""},
+	{"content-length", ""},
+	{"content-location", ""},
+	{"content-range", ""},
+	{"content-type", ""},
+	{"cookie", ""},
+	{"date", ""},
+	{"etag", ""},
+	{"expect", ""},
+	{"expires", ""},
+	{"from", ""},
+	{"host", ""},
+	{"if-match", ""},
+	{"if-modified-since", ""},
+	{"if-none-match", ""},
+	{"if-range", ""},
+	{"if-unmodified-since", ""},
+	{"last-modified", ""},
+	{"link", ""},
+	{"location", ""},
+	{"max-forwards", ""},
+	{"proxy-authenticate", ""},
+	{"proxy-authorization", ""},
+	{"range", ""},
+	{"referer", ""},
+	{"refresh", ""},
+	{"retry-after", ""},
+	{"server", ""},
+	{"set-cookie", ""},
+	{"strict-transport-security", ""},
+	{"transfer-encoding", ""},
+	{"user-agent", ""},
+	{"vary", ""},
+	{"via", ""},
+	{"www-authenticate", ""},
+};
+
+const size_t StaticTableSize = sizeof(StaticTable) / sizeof(*StaticTable);
+
+// Size of an entry including the overhead (RFC 7541 4.1)
+const size_t EntryOverhead = 32;
+
+struct HuffmanCode {
+	uint32_t code;
+	uint8_t length;
+};
+
+// RFC 7541 Appendix B
+const HuffmanCode HuffmanCodes[256] = {
+	{0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+	{0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+	{0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+	{0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+	{0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+	{0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+	{0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+	{0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+	{0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+	{0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+	{0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+	{0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+	{0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+	{0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+	{0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+	{0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+	{0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+	{0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+	{0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+	{0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+	{0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+	{0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+	{0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+	{0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+	{0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+	{0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+	{0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+	{0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+	{0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+	{0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+	{0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+	{0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+	{0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+	{0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+	{0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+	{0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+	{0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+	{0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+	{0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+	{0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+	{0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+	{0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+	{0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+	{0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+	{0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+	{0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+	{0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+	{0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+	{0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+	{0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+	{0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+	{0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+	{0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+	{0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+	{0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+	{0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+	{0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+	{0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+	{0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+	{0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+	{0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+	{0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+	{0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+	{0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+};
+
+const HuffmanCode HuffmanEos = {0x3fffffff, 30};
+
+// Binary tree for decoding, children are node indexes or -(symbol + 1) for leaves
+class HuffmanTree {
+public:
+	static const HuffmanTree &Instance() {
+		static const HuffmanTree tree;
+		return tree;
+	}
+
+	string decode(const uint8_t *data, size_t size) const {
+		string out;
+		out.reserve(size * 8 / 5); // codes are at least 5 bits long
+		int node = 0;
+		int bits = 0; // since the last symbol
+		bool ones = true;
+		for (size_t i = 0; i < size; ++i) {
+			for (int shift = 7; shift >= 0; --shift) {
+				const int bit = (data[i] >> shift) & 1;
+				const int child = mNodes[node][bit];
+				++bits;
+				ones = ones && bit;
+				if (child < 0) {
+					const int symbol = -child - 1;
+					if (symbol == 256)
+						throw std::invalid_argument("HPACK string contains EOS");
+
+					out += char(symbol);
+					node = 0;
+					bits = 0;
+					ones = true;
+				} else if (child == 0) {
+					throw std::invalid_argument("Invalid HPACK Huffman code");
+				} else {
+					node = child;
+				}
+			}
+		}
+
+		// Padding must be the most significant bits of EOS, strictly shorter than 8 bits
+		if (bits > 7 || !ones)
+			throw std::invalid_argument("Invalid HPACK Huffman padding");
+
+		return out;
+	}
+
+private:
+	HuffmanTree() {
+		mNodes.push_back({0, 0});
+		for (int symbol = 0; symbol < 256; ++symbol)
+			insert(HuffmanCodes[symbol], symbol);
+
+		insert(HuffmanEos, 256);
+	}
+
+	void insert(HuffmanCode code, int symbol) {
+		int node = 0;
+		for (int shift = code.length - 1; shift > 0; --shift) {
+			const int bit = (code.code >> shift) & 1;
+			if (mNodes[node][bit] == 0) {
+				mNodes[node][bit] = int16_t(mNodes.size());
+				mNodes.push_back({0, 0});
+			}
+			node = mNodes[node][bit];
+		}
+		mNodes[node][code.code & 1] = int16_t(-(symbol + 1));
+	}
+
+	std::vector<std::array<int16_t, 2>> mNodes;
+};
+
+void encodeInteger(binary &out, uint8_t first, int prefixBits, uint64_t value) {
+	const uint64_t max = (uint64_t(1) << prefixBits) - 1;
+	if (value < max) {
+		out.push_back(byte(first | uint8_t(value)));
+		return;
+	}
+
+	out.push_back(byte(first | uint8_t(max)));
+	value -= max;
+	while (value >= 0x80) {
+		out.push_back(byte(0x80 | (value & 0x7F)));
+		value >>= 7;
+	}
+	out.push_back(byte(value));
+}
+
+void encodeString(binary &out, const string &str) {
+	encodeInteger(out, 0x00, 7, str.size()); // without Huffman coding
+	auto data = reinterpret_cast<const byte *>(str.data());
+	out.insert(out.end(), data, data + str.size());
+}
+
+uint64_t decodeInteger(const uint8_t *&p, const uint8_t *end, int prefixBits) {
+	const uint64_t max = (uint64_t(1) << prefixBits) - 1;
+	uint64_t value = *p++ & max;
+	if (value < max)
+		return value;
+
+	int shift = 0;
+	while (true) {
+		if (p == end)
+			throw std::invalid_argument("Truncated HPACK integer");
+
+		const uint8_t b = *p++;
+		value += uint64_t(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return value;
+
+		shift += 7;
+		if (shift > 28)
+			throw std::invalid_argument("HPACK integer overflow");
+	}
+}
+
+string decodeString(const uint8_t *&p, const uint8_t *end) {
+	if (p == end)
+		throw std::invalid_argument("Truncated HPACK string");
+
+	const bool huffman = (*p & 0x80) != 0;
+	const uint64_t length = decodeInteger(p, end, 7);
+	if (length > uint64_t(end - p))
+		throw std::invalid_argument("Truncated HPACK string");
+
+	const uint8_t *data = p;
+	p += length;
+	return huffman ? HuffmanTree::Instance().decode(data, size_t(length))
+	               : string(reinterpret_cast<const char *>(data), size_t(length));
+}
+
+} // namespace
+
+void HpackEncoder::Encode(const HeaderList &headers, binary &out) {
+	for (const auto &[name, value] : headers) {
+		size_t nameIndex = 0;
+		size_t index = 0;
+		for (size_t i = 0; i < StaticTableSize && index == 0; ++i) {
+			if (name == StaticTable[i].name) {
+				if (nameIndex == 0)
+					nameIndex = i + 1;
+				if (value == StaticTable[i].value)
+					index = i + 1;
+			}
+		}
+
+		if (index) {
+			encodeInteger(out, 0x80, 7, index); // indexed header field
+		} else if (nameIndex) {
+			encodeInteger(out, 0x00, 4, nameIndex); // literal without indexing, indexed name
+			encodeString(out, value);
+		} else {
+			out.push_back(byte(0x00)); // literal without indexing, new name
+			encodeString(out, name);
+			encodeString(out, value);
+		}
+	}
+}
+
+HpackDecoder::HpackDecoder(size_t maxTableSize)
+    : mMaxTableSize(maxTableSize), mTableMaxSize(maxTableSize) {}
+
+HeaderList HpackDecoder::decode(const byte *data, size_t size) {
+	auto p = reinterpret_cast<const uint8_t *>(data);
+	auto end = p + size;
+	HeaderList headers;
+	size_t listSize = 0;
+	while (p != end) {
+		const uint8_t first = *p;
+		if (first & 0x80) {
+			// Indexed header field
+			const uint64_t index = decodeInteger(p, end, 7);
+			headers.push_back(entry(index));
+
+		} else if ((first & 0xE0) == 0x20) {
+			// Dynamic table size update, only allowed at the beginning of a block
+			const uint64_t maxSize = decodeInteger(p, end, 5);
+			if (!headers.empty() || maxSize > mMaxTableSize)
+				throw std::invalid_argument("Invalid HPACK dynamic table size update");
+
+			mTableMaxSize = size_t(maxSize);
+			evict(mTableMaxSize);
+			continue;
+
+		} else {
+			// Literal header field, with incremental indexing, without indexing, or never indexed
+			const bool indexing = (first & 0xC0) == 0x40;
+			const uint64_t nameIndex = decodeInteger(p, end, indexing ? 6 : 4);
+			string name = nameIndex ? entry(nameIndex).first : decodeString(p, end);
+			string value = decodeString(p, end);
+			if (indexing)
+				insert(name, value);
+
+			headers.emplace_back(std::move(name), std::move(value));
+		}
+
+		const auto &[name, value] = headers.back();
+		listSize += name.size() + value.size() + EntryOverhead;
+		if (listSize > MaxHeaderListSize)
+			throw std::invalid_argument("HPACK header list too large");
+	}
+
+	return headers;
+}
+
+void HpackDecoder::insert(string name, string value) {
+	const size_t size = name.size() + value.size() + EntryOverhead;
+	evict(size <= mTableMaxSize ? mTableMaxSize - size : 0);
+	if (size > mTableMaxSize)
+		return; // an entry larger than the table empties it (RFC 7541 4.4)
+
+	mTable.emplace_front(std::move(name), std::move(value));
+	mTableSize += size;
+}
+
+void HpackDecoder::evict(size_t maxSize) {
+	while (mTableSize > maxSize && !mTable.empty()) {
+		const auto &[name, value] = mTable.back();
+		mTableSize -= name.size() + value.size() + EntryOverhead;
+		mTable.pop_back();
+	}
+}
+
+std::pair<string, string> HpackDecoder::entry(uint64_t index) const {
+	if (index == 0)
+		throw std::invalid_argument("Invalid HPACK index 0");
+
+	if (index <= StaticTableSize)
+		return {StaticTable[index - 1].name, StaticTable[index - 1].value};
+
+	if (index - StaticTableSize > mTable.size())
+		throw std::invalid_argument("Invalid HPACK index " + std::to_string(index));
+
+	return mTable[size_t(index - StaticTableSize - 1)];
+}
+
+} // namespace rtc::impl
+
+#endif
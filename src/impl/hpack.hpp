@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_HPACK_H
+#define RTC_IMPL_HPACK_H
+
+#include "common.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace rtc::impl {
+
+// Header fields in order, names are lowercase
+using HeaderList = std::vector<std::pair<string, string>>;
+
+// HPACK header compression for HTTP/2 (RFC 7541)
+class HpackEncoder final {
+public:
+	// Fields are encoded as references to the static table or as literals without indexing, so
+	// the decoder of the remote peer never needs to store anything for us
+	static void Encode(const HeaderList &headers, binary &out);
+};
+
+class HpackDecoder final {
+public:
+	static constexpr size_t DefaultTableSize = 4096; // SETTINGS_HEADER_TABLE_SIZE
+	static constexpr size_t MaxHeaderListSize = 64 * 1024;
+
+	HpackDecoder(size_t maxTableSize = DefaultTableSize);
+
+	// Decodes a complete header block, throws std::invalid_argument on compression error
+	HeaderList decode(const byte *data, size_t size);
+
+private:
+	void insert(string name, string value);
+	void evict(size_t maxSize);
+	std::pair<string, string> entry(uint64_t index) const;
+
+	const size_t mMaxTableSize; // as advertised in settings
+	size_t mTableMaxSize;       // as updated by the encoder
+	size_t mTableSize = 0;
+	std::deque<std::pair<string, string>> mTable; // newest first
+};
+
+} // namespace rtc::impl
+
+#endif
+
+#endif
@@ -9,6 +9,9 @@
 #include "http.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <utility>
 
 namespace rtc::impl {
 
@@ -63,4 +66,61 @@ std::multimap<string, string> parseHttpHeaders(const std::list<string> &lines) {
 	return headers;
 }
 
+optional<std::string_view> HttpHead::find(std::string_view name) const {
+	for (size_t i = 0; i < headersCount; ++i)
+		if (equalsIgnoreCase(headers[i].name, name))
+			return headers[i].value;
+
+	return nullopt;
+}
+
+bool HttpHead::equalsIgnoreCase(std::string_view a, std::string_view b) {
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+		       return std::tolower(static_cast<unsigned char>(x)) ==
+		              std::tolower(static_cast<unsigned char>(y));
+	       });
+}
+
+size_t parseHttpHead(const byte *buffer, size_t size, HttpHead &head) {
+	const std::string_view data(reinterpret_cast<const char *>(buffer), size);
+	head.startLine = {};
+	head.headersCount = 0;
+	bool first = true;
+	size_t pos = 0;
+	while (true) {
+		size_t eol = data.find('\n', pos);
+		if (eol == std::string_view::npos)
+			return 0;
+
+		auto line = data.substr(pos, eol - pos);
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+
+		pos = eol + 1;
+		if (line.empty())
+			break;
+
+		if (std::exchange(first, false)) {
+			head.startLine = line;
+			continue;
+		}
+
+		if (head.headersCount == HttpHead::MaxHeaders)
+			throw std::length_error("Too many HTTP headers");
+
+		// Like parseHttpHeaders(), a line without colon is a header without value
+		auto &header = head.headers[head.headersCount++];
+		if (size_t colon = line.find(':'); colon != std::string_view::npos) {
+			header.name = line.substr(0, colon);
+			size_t subPos = line.find_first_not_of(' ', colon + 1);
+			header.value = subPos != std::string_view::npos ? line.substr(subPos) : "";
+		} else {
+			header.name = line;
+			header.value = "";
+		}
+	}
+
+	return pos;
+}
+
 } // namespace rtc::impl
@@ -11,8 +11,10 @@
 
 #include "common.hpp"
 
+#include <array>
 #include <list>
 #include <map>
+#include <string_view>
 
 namespace rtc::impl {
 
@@ -25,6 +27,34 @@ size_t parseHttpLines(const byte *buffer, size_t size, std::list<string> &lines)
 // Parse headers of a http message
 std::multimap<string, string> parseHttpHeaders(const std::list<string> &lines);
 
+// Head of an http message parsed in place, views are valid as long as the parsed buffer is
+struct HttpHead {
+	static constexpr size_t MaxHeaders = 32;
+
+	struct Header {
+		std::string_view name;
+		std::string_view value;
+	};
+
+	std::string_view startLine;
+	std::array<Header, MaxHeaders> headers;
+	size_t headersCount = 0;
+
+	// Header names are compared case-insensitively
+	optional<std::string_view> find(std::string_view name) const;
+	template <typename F> void forEach(std::string_view name, F func) const {
+		for (size_t i = 0; i < headersCount; ++i)
+			if (equalsIgnoreCase(headers[i].name, name))
+				func(headers[i].value);
+	}
+
+	static bool equalsIgnoreCase(std::string_view a, std::string_view b);
+};
+
+// Parse the head of a http message in a single pass without allocation, returns its length or 0
+// if it is incomplete, throws std::length_error if there are more than HttpHead::MaxHeaders
+size_t parseHttpHead(const byte *buffer, size_t size, HttpHead &head);
+
 } // namespace rtc::impl
 
 #endif
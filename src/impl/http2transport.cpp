@@ -0,0 +1,833 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "http2transport.hpp"
+#include "internals.hpp"
+#include "processor.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace rtc::impl {
+
+namespace {
+
+const string ClientPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+enum FrameType : uint8_t {
+	DATA = 0x0,
+	HEADERS = 0x1,
+	PRIORITY = 0x2,
+	RST_STREAM = 0x3,
+	SETTINGS = 0x4,
+	PUSH_PROMISE = 0x5,
+	PING = 0x6,
+	GOAWAY = 0x7,
+	WINDOW_UPDATE = 0x8,
+	CONTINUATION = 0x9,
+};
+
+enum FrameFlag : uint8_t {
+	FLAG_END_STREAM = 0x1,
+	FLAG_ACK = 0x1,
+	FLAG_END_HEADERS = 0x4,
+	FLAG_PADDED = 0x8,
+	FLAG_PRIORITY = 0x20,
+};
+
+enum SettingId : uint16_t {
+	SETTINGS_HEADER_TABLE_SIZE = 0x1,
+	SETTINGS_ENABLE_PUSH = 0x2,
+	SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+	SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+	SETTINGS_MAX_FRAME_SIZE = 0x5,
+	SETTINGS_ENABLE_CONNECT_PROTOCOL = 0x8, // RFC 8441
+};
+
+enum ErrorCode : uint32_t {
+	NO_ERROR = 0x0,
+	PROTOCOL_ERROR = 0x1,
+	FLOW_CONTROL_ERROR = 0x3,
+	FRAME_SIZE_ERROR = 0x6,
+	CANCEL = 0x8,
+	COMPRESSION_ERROR = 0x9,
+};
+
+const size_t FrameHeaderSize = 9;
+const uint32_t DefaultMaxFrameSize = 16384; // we don't advertise a larger one
+const uint32_t DefaultWindowSize = 65535;
+const uint32_t StreamWindowSize = 1 << 20;
+const uint32_t ConnectionWindowSize = 1 << 24;
+const int64_t MaxWindowSize = 0x7FFFFFFF;
+
+class ConnectionError : public std::runtime_error {
+public:
+	ConnectionError(uint32_t code, const string &what) : std::runtime_error(what), mCode(code) {}
+	uint32_t code() const { return mCode; }
+
+private:
+	uint32_t mCode;
+};
+
+uint32_t readUint32(const byte *p) {
+	return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+void appendUint16(binary &out, uint16_t value) {
+	out.push_back(byte(value >> 8));
+	out.push_back(byte(value & 0xFF));
+}
+
+void appendUint32(binary &out, uint32_t value) {
+	appendUint16(out, uint16_t(value >> 16));
+	appendUint16(out, uint16_t(value & 0xFFFF));
+}
+
+struct Registry {
+	std::mutex mutex;
+	std::unordered_map<string, weak_ptr<Http2Transport>> connections;
+	std::unordered_set<string> unsupported;
+
+	static Registry &Instance() {
+		static Registry registry;
+		return registry;
+	}
+};
+
+} // namespace
+
+const string Http2Transport::AlpnProtocol = "h2";
+
+shared_ptr<Http2Transport> Http2Transport::Find(const string &key) {
+	// The connection might be released by its last owner meanwhile, and its destructor locks the
+	// registry, so it must not be destroyed with the lock held
+	shared_ptr<Http2Transport> connection;
+	{
+		auto &registry = Registry::Instance();
+		std::lock_guard lock(registry.mutex);
+		if (auto it = registry.connections.find(key); it != registry.connections.end())
+			connection = it->second.lock();
+	}
+
+	return connection && connection->isAvailable() ? connection : nullptr;
+}
+
+bool Http2Transport::IsUnsupported(const string &key) {
+	auto &registry = Registry::Instance();
+	std::lock_guard lock(registry.mutex);
+	return registry.unsupported.find(key) != registry.unsupported.end();
+}
+
+Http2Transport::Http2Transport(shared_ptr<Transport> lower, string key)
+    : Transport(lower, nullptr), mKey(std::move(key)) {
+	PLOG_DEBUG << "Initializing HTTP/2 transport";
+	if (lower->state() != State::Connected)
+		throw std::logic_error("HTTP/2 transport expects the lower transport to be connected");
+}
+
+Http2Transport::~Http2Transport() {
+	PLOG_DEBUG << "Destroying HTTP/2 transport";
+	stop();
+}
+
+void Http2Transport::start() {
+	registerIncoming();
+	changeState(State::Connected);
+
+	binary out(ClientPreface.size());
+	std::memcpy(out.data(), ClientPreface.data(), ClientPreface.size());
+
+	binary settings;
+	appendUint16(settings, SETTINGS_ENABLE_PUSH);
+	appendUint32(settings, 0);
+	appendUint16(settings, SETTINGS_INITIAL_WINDOW_SIZE);
+	appendUint32(settings, StreamWindowSize);
+
+	binary increment;
+	appendUint32(increment, ConnectionWindowSize - DefaultWindowSize);
+
+	{
+		std::lock_guard lock(mMutex);
+		appendFrame(out, SETTINGS, 0, 0, settings.data(), settings.size());
+		appendFrame(out, WINDOW_UPDATE, 0, 0, increment.data(), increment.size());
+		outgoing(make_message(std::move(out)));
+	}
+
+	auto &registry = Registry::Instance();
+	std::lock_guard lock(registry.mutex);
+	registry.connections[mKey] = weak_from_this();
+}
+
+void Http2Transport::stop() {
+	unregisterIncoming();
+
+	{
+		auto &registry = Registry::Instance();
+		std::lock_guard lock(registry.mutex);
+		if (auto it = registry.connections.find(mKey);
+		    it != registry.connections.end() && it->second.expired())
+			registry.connections.erase(it);
+	}
+
+	std::lock_guard lock(mMutex);
+	if (state() == State::Connected && !mGoingAway) {
+		mGoingAway = true;
+		binary payload;
+		appendUint32(payload, 0); // last stream id, we don't accept streams
+		appendUint32(payload, NO_ERROR);
+		try {
+			sendFrame(GOAWAY, 0, 0, payload.data(), payload.size());
+		} catch (const std::exception &e) {
+			PLOG_DEBUG << "HTTP/2 GOAWAY failed: " << e.what();
+		}
+	}
+}
+
+void Http2Transport::openStream(shared_ptr<Http2Stream> stream) {
+	bool unsupported = false;
+	{
+		std::lock_guard lock(mMutex);
+		if (!mSettingsReceived && !mGoingAway) {
+			mWaitingStreams.push_back(std::move(stream));
+			return;
+		}
+
+		if (!mGoingAway && mPeerSettings.enableConnectProtocol) {
+			startStream(std::move(stream));
+			return;
+		}
+
+		unsupported = !mPeerSettings.enableConnectProtocol;
+	}
+
+	stream->reset(unsupported);
+}
+
+bool Http2Transport::sendData(uint32_t id, message_ptr message) {
+	std::lock_guard lock(mMutex);
+	auto it = mStreams.find(id);
+	if (it == mStreams.end() || it->second.closing)
+		throw std::runtime_error("HTTP/2 stream is closed");
+
+	it->second.pending.push_back(std::move(message));
+	return flushPending(id, it->second);
+}
+
+void Http2Transport::closeStream(uint32_t id) {
+	std::lock_guard lock(mMutex);
+	auto it = mStreams.find(id);
+	if (it == mStreams.end())
+		return;
+
+	// Pending data is still sent, then the stream is closed with END_STREAM
+	it->second.closing = true;
+	if (state() != State::Connected || flushPending(id, it->second))
+		mStreams.erase(it);
+}
+
+void Http2Transport::incoming(message_ptr message) {
+	if (!message) {
+		fail(NO_ERROR, "HTTP/2 connection closed");
+		return;
+	}
+
+	if (message->empty()) {
+		// The connection is idle, let the WebSocket transports send pings
+		std::vector<shared_ptr<Http2Stream>> streams;
+		{
+			std::lock_guard lock(mMutex);
+			for (auto &[id, entry] : mStreams)
+				if (auto stream = entry.stream.lock())
+					streams.push_back(std::move(stream));
+		}
+		for (auto &stream : streams)
+			stream->incomingData(make_message(0), false);
+
+		return;
+	}
+
+	try {
+		mBuffer.insert(mBuffer.end(), message->begin(), message->end());
+		size_t offset = 0;
+		while (mBuffer.size() - offset >= FrameHeaderSize) {
+			auto header = reinterpret_cast<const uint8_t *>(mBuffer.data() + offset);
+			const size_t length = size_t(header[0]) << 16 | size_t(header[1]) << 8 | header[2];
+			const uint8_t type = header[3];
+			const uint8_t flags = header[4];
+			const uint32_t id = readUint32(mBuffer.data() + offset + 5) & 0x7FFFFFFF;
+			if (length > DefaultMaxFrameSize)
+				throw ConnectionError(FRAME_SIZE_ERROR, "HTTP/2 frame too large");
+
+			if (mBuffer.size() - offset < FrameHeaderSize + length)
+				break;
+
+			processFrame(type, flags, id, mBuffer.data() + offset + FrameHeaderSize, length);
+			offset += FrameHeaderSize + length;
+		}
+
+		mBuffer.erase(mBuffer.begin(), mBuffer.begin() + offset);
+
+	} catch (const ConnectionError &e) {
+		fail(e.code(), e.what());
+	}
+}
+
+void Http2Transport::processFrame(uint8_t type, uint8_t flags, uint32_t id, const byte *payload,
+                                  size_t length) {
+	// The server connection preface is a SETTINGS frame
+	if (!mSettingsReceived && type != SETTINGS)
+		throw ConnectionError(PROTOCOL_ERROR, "HTTP/2 preface is missing");
+
+	// A header block must not be interleaved with other frames
+	if (mHeaderStreamId != 0 && (type != CONTINUATION || id != mHeaderStreamId))
+		throw ConnectionError(PROTOCOL_ERROR, "Unexpected HTTP/2 frame in header block");
+
+	switch (type) {
+	case DATA:
+		if (id == 0)
+			throw ConnectionError(PROTOCOL_ERROR, "HTTP/2 DATA frame on stream 0");
+
+		processData(id, flags, payload, length);
+		break;
+
+	case HEADERS: {
+		if (id == 0)
+			throw ConnectionError(PROTOCOL_ERROR, "HTTP/2 HEADERS frame on stream 0");
+
+		size_t padding = 0;
+		if (flags & FLAG_PADDED) {
+			if (length < 1)
+				throw ConnectionError(FRAME_SIZE_ERROR, "Invalid HTTP/2 HEADERS frame");
+
+			padding = std::to_integer<size_t>(payload[0]);
+			++payload;
+			--length;
+		}
+		if (flags & FLAG_PRIORITY) {
+			if (length < 5)
+				throw ConnectionError(FRAME_SIZE_ERROR, "Invalid HTTP/2 HEADERS frame");
+
+			payload += 5;
+			length -= 5;
+		}
+		if (padding > length)
+			throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 HEADERS padding");
+
+		mHeaderBlock.assign(payload, payload + length - padding);
+		mHeaderStreamId = id;
+		mHeaderEndStream = (flags & FLAG_END_STREAM) != 0;
+		if (flags & FLAG_END_HEADERS)
+			processHeaders(id, mHeaderEndStream);
+
+		break;
+	}
+
+	case CONTINUATION:
+		if (mHeaderStreamId == 0)
+			throw ConnectionError(PROTOCOL_ERROR, "Unexpected HTTP/2 CONTINUATION frame");
+
+		if (mHeaderBlock.size() + length > HpackDecoder::MaxHeaderListSize)
+			throw ConnectionError(PROTOCOL_ERROR, "HTTP/2 header block too large");
+
+		mHeaderBlock.insert(mHeaderBlock.end(), payload, payload + length);
+		if (flags & FLAG_END_HEADERS)
+			processHeaders(id, mHeaderEndStream);
+
+		break;
+
+	case RST_STREAM: {
+		if (id == 0 || length != 4)
+			throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 RST_STREAM frame");
+
+		shared_ptr<Http2Stream> stream;
+		{
+			std::lock_guard lock(mMutex);
+			if (auto it = mStreams.find(id); it != mStreams.end()) {
+				stream = it->second.stream.lock();
+				mStreams.erase(it);
+			}
+		}
+		PLOG_DEBUG << "HTTP/2 stream " << id << " reset, code=" << readUint32(payload);
+		if (stream)
+			stream->reset();
+
+		break;
+	}
+
+	case SETTINGS:
+		if (id != 0)
+			throw ConnectionError(PROTOCOL_ERROR, "HTTP/2 SETTINGS frame on a stream");
+
+		if (flags & FLAG_ACK) {
+			if (length != 0)
+				throw ConnectionError(FRAME_SIZE_ERROR, "Invalid HTTP/2 SETTINGS ACK");
+
+			break;
+		}
+
+		if (length % 6 != 0)
+			throw ConnectionError(FRAME_SIZE_ERROR, "Invalid HTTP/2 SETTINGS frame");
+
+		processSettings(payload, length);
+		break;
+
+	case PUSH_PROMISE:
+		throw ConnectionError(PROTOCOL_ERROR, "HTTP/2 server push is disabled");
+
+	case PING:
+		if (id != 0 || length != 8)
+			throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 PING frame");
+
+		if (!(flags & FLAG_ACK)) {
+			std::lock_guard lock(mMutex);
+			sendFrame(PING, FLAG_ACK, 0, payload, length);
+		}
+		break;
+
+	case GOAWAY:
+		if (id != 0 || length < 8)
+			throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 GOAWAY frame");
+
+		processGoAway(payload, length);
+		break;
+
+	case WINDOW_UPDATE:
+		if (length != 4)
+			throw ConnectionError(FRAME_SIZE_ERROR, "Invalid HTTP/2 WINDOW_UPDATE frame");
+
+		processWindowUpdate(id, payload, length);
+		break;
+
+	default:
+		// PRIORITY and unknown frames are ignored
+		break;
+	}
+}
+
+void Http2Transport::processHeaders(uint32_t id, bool end) {
+	mHeaderStreamId = 0;
+
+	// The block must be decoded even if the stream is gone, to keep the table synchronized
+	HeaderList headers;
+	try {
+		headers = mDecoder.decode(mHeaderBlock.data(), mHeaderBlock.size());
+	} catch (const std::invalid_argument &e) {
+		throw ConnectionError(COMPRESSION_ERROR, e.what());
+	}
+	mHeaderBlock.clear();
+
+	shared_ptr<Http2Stream> stream;
+	{
+		std::lock_guard lock(mMutex);
+		if (auto it = mStreams.find(id); it != mStreams.end())
+			stream = it->second.stream.lock();
+	}
+
+	if (stream)
+		stream->incomingHeaders(headers, end);
+}
+
+void Http2Transport::processSettings(const byte *payload, size_t length) {
+	// Waiting streams might hold their last reference, and ~Http2Stream() locks mMutex, so they
+	// must be released after it is unlocked
+	std::vector<shared_ptr<Http2Stream>> waiting;
+	bool unsupported = false;
+	{
+		std::lock_guard lock(mMutex);
+		for (size_t i = 0; i + 6 <= length; i += 6) {
+			auto p = reinterpret_cast<const uint8_t *>(payload + i);
+			const uint16_t setting = uint16_t(p[0] << 8 | p[1]);
+			const uint32_t value = readUint32(payload + i + 2);
+			switch (setting) {
+			case SETTINGS_MAX_CONCURRENT_STREAMS:
+				mPeerSettings.maxConcurrentStreams = value;
+				break;
+
+			case SETTINGS_INITIAL_WINDOW_SIZE: {
+				if (value > MaxWindowSize)
+					throw ConnectionError(FLOW_CONTROL_ERROR, "Invalid HTTP/2 window size");
+
+				// The change applies to the windows of all streams (RFC 9113 6.9.2)
+				const int64_t delta = int64_t(value) - int64_t(mPeerSettings.initialWindowSize);
+				for (auto &[streamId, entry] : mStreams)
+					entry.sendWindow += delta;
+
+				mPeerSettings.initialWindowSize = value;
+				break;
+			}
+
+			case SETTINGS_MAX_FRAME_SIZE:
+				if (value < 16384 || value > 16777215)
+					throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 max frame size");
+
+				mPeerSettings.maxFrameSize = value;
+				break;
+
+			case SETTINGS_ENABLE_CONNECT_PROTOCOL:
+				if (value > 1)
+					throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 CONNECT setting");
+
+				mPeerSettings.enableConnectProtocol = value == 1;
+				break;
+
+			default:
+				// The header table size does not matter as we don't index, others are ignored
+				break;
+			}
+		}
+
+		sendFrame(SETTINGS, FLAG_ACK, 0);
+
+		if (!std::exchange(mSettingsReceived, true)) {
+			waiting.swap(mWaitingStreams);
+			if (mPeerSettings.enableConnectProtocol) {
+				PLOG_DEBUG << "HTTP/2 server supports extended CONNECT";
+				for (const auto &stream : waiting)
+					startStream(stream);
+			} else {
+				PLOG_WARNING << "HTTP/2 server does not support extended CONNECT";
+				unsupported = true;
+				mGoingAway = true;
+			}
+		}
+
+		for (auto &[streamId, entry] : mStreams)
+			flushPending(streamId, entry);
+	}
+
+	if (unsupported) {
+		{
+			auto &registry = Registry::Instance();
+			std::lock_guard lock(registry.mutex);
+			registry.unsupported.insert(mKey);
+		}
+
+		for (auto &stream : waiting)
+			stream->reset(true);
+	}
+}
+
+void Http2Transport::processData(uint32_t id, uint8_t flags, const byte *payload, size_t length) {
+	const byte *data = payload;
+	size_t size = length;
+	if (flags & FLAG_PADDED) {
+		const size_t padding = length > 0 ? std::to_integer<size_t>(payload[0]) : 0;
+		if (length == 0 || padding >= length)
+			throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 DATA padding");
+
+		data = payload + 1;
+		size = length - 1 - padding;
+	}
+
+	shared_ptr<Http2Stream> stream;
+	{
+		std::lock_guard lock(mMutex);
+
+		// The whole frame counts for flow control, even for a closed stream (RFC 9113 6.9)
+		mRecvConsumed += length;
+		if (mRecvConsumed >= ConnectionWindowSize / 2) {
+			binary increment;
+			appendUint32(increment, uint32_t(std::exchange(mRecvConsumed, 0)));
+			sendFrame(WINDOW_UPDATE, 0, 0, increment.data(), increment.size());
+		}
+
+		if (auto it = mStreams.find(id); it != mStreams.end()) {
+			auto &entry = it->second;
+			stream = entry.stream.lock();
+			entry.recvConsumed += length;
+			if (entry.recvConsumed >= StreamWindowSize / 2 && !(flags & FLAG_END_STREAM)) {
+				binary increment;
+				appendUint32(increment, uint32_t(std::exchange(entry.recvConsumed, 0)));
+				sendFrame(WINDOW_UPDATE, 0, id, increment.data(), increment.size());
+			}
+		}
+	}
+
+	if (stream)
+		stream->incomingData(size > 0 ? make_message(data, data + size) : nullptr,
+		                     (flags & FLAG_END_STREAM) != 0);
+}
+
+void Http2Transport::processWindowUpdate(uint32_t id, const byte *payload, size_t) {
+	const uint32_t increment = readUint32(payload) & 0x7FFFFFFF;
+	if (increment == 0)
+		throw ConnectionError(PROTOCOL_ERROR, "Invalid HTTP/2 window increment");
+
+	std::lock_guard lock(mMutex);
+	if (id == 0) {
+		mSendWindow += increment;
+		if (mSendWindow > MaxWindowSize)
+			throw ConnectionError(FLOW_CONTROL_ERROR, "HTTP/2 connection window overflow");
+
+	} else if (auto it = mStreams.find(id); it != mStreams.end()) {
+		it->second.sendWindow += increment;
+		if (it->second.sendWindow > MaxWindowSize)
+			throw ConnectionError(FLOW_CONTROL_ERROR, "HTTP/2 stream window overflow");
+	}
+
+	for (auto it = mStreams.begin(); it != mStreams.end();) {
+		if (flushPending(it->first, it->second) && it->second.closing)
+			it = mStreams.erase(it);
+		else
+			++it;
+	}
+}
+
+void Http2Transport::processGoAway(const byte *payload, size_t length) {
+	const uint32_t lastStreamId = readUint32(payload) & 0x7FFFFFFF;
+	const uint32_t errorCode = readUint32(payload + 4);
+	if (errorCode != NO_ERROR) {
+		const string debug(reinterpret_cast<const char *>(payload + 8), length - 8);
+		PLOG_WARNING << "HTTP/2 connection closed by server, code=" << errorCode << ", " << debug;
+	} else {
+		PLOG_DEBUG << "HTTP/2 server is going away";
+	}
+
+	// Streams above the last one were not processed, the others may complete
+	std::vector<shared_ptr<Http2Stream>> streams;
+	{
+		std::lock_guard lock(mMutex);
+		mGoingAway = true;
+		for (auto it = mStreams.begin(); it != mStreams.end();) {
+			if (it->first > lastStreamId) {
+				if (auto stream = it->second.stream.lock())
+					streams.push_back(std::move(stream));
+
+				it = mStreams.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	for (auto &stream : streams)
+		stream->reset();
+}
+
+void Http2Transport::fail(uint32_t errorCode, const string &reason) {
+	if (errorCode != NO_ERROR)
+		PLOG_WARNING << reason;
+	else
+		PLOG_DEBUG << reason;
+
+	std::vector<shared_ptr<Http2Stream>> streams;
+	{
+		std::lock_guard lock(mMutex);
+		if (errorCode != NO_ERROR && state() == State::Connected) {
+			binary payload;
+			appendUint32(payload, 0);
+			appendUint32(payload, errorCode);
+			try {
+				sendFrame(GOAWAY, 0, 0, payload.data(), payload.size());
+			} catch (const std::exception &e) {
+				PLOG_DEBUG << "HTTP/2 GOAWAY failed: " << e.what();
+			}
+		}
+
+		mGoingAway = true;
+		for (auto &[id, entry] : mStreams)
+			if (auto stream = entry.stream.lock())
+				streams.push_back(std::move(stream));
+
+		mStreams.clear();
+		for (auto &stream : mWaitingStreams)
+			streams.push_back(std::move(stream));
+
+		mWaitingStreams.clear();
+	}
+
+	changeState(State::Disconnected);
+	for (auto &stream : streams)
+		stream->reset();
+}
+
+void Http2Transport::startStream(shared_ptr<Http2Stream> stream) {
+	if (stream->mStopped)
+		return;
+
+	const uint32_t id = mNextStreamId;
+	mNextStreamId += 2;
+
+	binary block;
+	HpackEncoder::Encode(stream->mHandshake->generateHttp2Request(), block);
+
+	// The header block is split into CONTINUATION frames if needed
+	binary out;
+	const size_t maxFrameSize = mPeerSettings.maxFrameSize;
+	size_t offset = 0;
+	do {
+		const size_t length = std::min(block.size() - offset, maxFrameSize);
+		const bool last = offset + length == block.size();
+		appendFrame(out, offset == 0 ? HEADERS : CONTINUATION, last ? FLAG_END_HEADERS : 0, id,
+		            block.data() + offset, length);
+		offset += length;
+	} while (offset < block.size());
+
+	StreamEntry entry;
+	entry.stream = stream;
+	entry.sendWindow = mPeerSettings.initialWindowSize;
+	mStreams.emplace(id, std::move(entry));
+	stream->opened(id);
+
+	PLOG_DEBUG << "Opening HTTP/2 stream " << id;
+	outgoing(make_message(std::move(out)));
+}
+
+bool Http2Transport::flushPending(uint32_t id, StreamEntry &entry) {
+	binary out;
+	while (!entry.pending.empty()) {
+		const auto &message = entry.pending.front();
+		const size_t left = message->size() - entry.pendingOffset;
+		const int64_t window = std::min(mSendWindow, entry.sendWindow);
+		if (left > 0 && window <= 0)
+			break;
+
+		const size_t credit = size_t(std::max(window, int64_t(0)));
+		const size_t length = std::min({left, credit, size_t(mPeerSettings.maxFrameSize)});
+		appendFrame(out, DATA, 0, id, message->data() + entry.pendingOffset, length);
+		entry.pendingOffset += length;
+		entry.sendWindow -= int64_t(length);
+		mSendWindow -= int64_t(length);
+		if (entry.pendingOffset == message->size()) {
+			entry.pending.pop_front();
+			entry.pendingOffset = 0;
+		}
+	}
+
+	const bool flushed = entry.pending.empty();
+	if (flushed && entry.closing)
+		appendFrame(out, DATA, FLAG_END_STREAM, id, nullptr, 0);
+
+	if (!out.empty())
+		outgoing(make_message(std::move(out)));
+
+	return flushed;
+}
+
+void Http2Transport::appendFrame(binary &out, uint8_t type, uint8_t flags, uint32_t id,
+                                 const byte *payload, size_t length) const {
+	out.push_back(byte((length >> 16) & 0xFF));
+	out.push_back(byte((length >> 8) & 0xFF));
+	out.push_back(byte(length & 0xFF));
+	out.push_back(byte(type));
+	out.push_back(byte(flags));
+	appendUint32(out, id & 0x7FFFFFFF);
+	if (length > 0)
+		out.insert(out.end(), payload, payload + length);
+}
+
+bool Http2Transport::sendFrame(uint8_t type, uint8_t flags, uint32_t id, const byte *payload,
+                               size_t length) {
+	binary out;
+	out.reserve(FrameHeaderSize + length);
+	appendFrame(out, type, flags, id, payload, length);
+	return outgoing(make_message(std::move(out)));
+}
+
+bool Http2Transport::isAvailable() const {
+	std::lock_guard lock(mMutex);
+	if (state() != State::Connected || mGoingAway)
+		return false;
+
+	if (!mSettingsReceived)
+		return true; // the stream will wait for settings
+
+	return mPeerSettings.enableConnectProtocol &&
+	       mStreams.size() < size_t(mPeerSettings.maxConcurrentStreams);
+}
+
+Http2Stream::Http2Stream(shared_ptr<Http2Transport> session, shared_ptr<WsHandshake> handshake,
+                         state_callback callback)
+    : Transport(nullptr, std::move(callback)), mSession(std::move(session)),
+      mHandshake(std::move(handshake)) {
+	PLOG_DEBUG << "Initializing HTTP/2 stream";
+}
+
+Http2Stream::~Http2Stream() {
+	stop();
+
+	// The stream might be the last owner of the session and be destroyed from the session thread
+	TearDownProcessor::Instance().enqueue(
+	    [session = mSession, token = Init::Instance().token()]() mutable { session.reset(); });
+}
+
+void Http2Stream::start() {
+	changeState(State::Connecting);
+	mSession->openStream(shared_from_this());
+}
+
+void Http2Stream::stop() {
+	mStopped = true;
+	if (uint32_t id = mId.exchange(0))
+		mSession->closeStream(id);
+}
+
+bool Http2Stream::send(message_ptr message) {
+	if (state() != State::Connected)
+		throw std::runtime_error("HTTP/2 stream is not open");
+
+	if (!message || message->empty())
+		return false;
+
+	PLOG_VERBOSE << "Send size=" << message->size();
+	countSent(*message);
+	return mSession->sendData(mId, std::move(message));
+}
+
+void Http2Stream::opened(uint32_t id) { mId = id; }
+
+void Http2Stream::incomingHeaders(const HeaderList &headers, bool end) {
+	if (!std::exchange(mResponseReceived, true)) {
+		try {
+			mHandshake->parseHttp2Response(headers);
+		} catch (const std::exception &e) {
+			PLOG_WARNING << e.what();
+			stop();
+			changeState(State::Failed);
+			return;
+		}
+
+		PLOG_INFO << "HTTP/2 stream " << mId << " open";
+		changeState(State::Connected);
+	}
+
+	if (end)
+		incomingData(nullptr, true);
+}
+
+void Http2Stream::incomingData(message_ptr message, bool end) {
+	if (state() != State::Connected)
+		return;
+
+	if (message)
+		recv(std::move(message));
+
+	if (end) {
+		PLOG_DEBUG << "HTTP/2 stream " << mId << " closed by server";
+		changeState(State::Disconnected);
+		recv(nullptr);
+	}
+}
+
+void Http2Stream::reset(bool unsupported) {
+	mUnsupported = unsupported;
+	mId = 0;
+	if (state() == State::Connected) {
+		changeState(State::Disconnected);
+		recv(nullptr);
+	} else {
+		changeState(State::Failed);
+	}
+}
+
+} // namespace rtc::impl
+
+#endif
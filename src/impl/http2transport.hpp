@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_HTTP2_TRANSPORT_H
+#define RTC_IMPL_HTTP2_TRANSPORT_H
+
+#include "common.hpp"
+#include "hpack.hpp"
+#include "transport.hpp"
+#include "wshandshake.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace rtc::impl {
+
+class Http2Stream;
+
+// Client-side HTTP/2 connection (RFC 9113) carrying WebSockets on streams opened with extended
+// CONNECT (RFC 8441). Connections are registered by key so WebSockets to the same server share
+// them, and a connection is closed when its last stream is.
+class Http2Transport final : public Transport, public std::enable_shared_from_this<Http2Transport> {
+public:
+	static const string AlpnProtocol; // "h2"
+
+	// Return a registered connection accepting new streams, or nullptr
+	static shared_ptr<Http2Transport> Find(const string &key);
+
+	// Whether the server is known to negotiate HTTP/2 without supporting extended CONNECT
+	static bool IsUnsupported(const string &key);
+
+	// The lower transport must be connected, normally TLS with ALPN "h2", and is taken over
+	Http2Transport(shared_ptr<Transport> lower, string key);
+	~Http2Transport();
+
+	void start() override; // also registers the connection
+	void stop() override;
+
+	bool isActive() const { return true; }
+
+private:
+	friend class Http2Stream;
+
+	struct Settings {
+		uint32_t maxConcurrentStreams = UINT32_MAX;
+		uint32_t initialWindowSize = 65535;
+		uint32_t maxFrameSize = 16384;
+		bool enableConnectProtocol = false;
+	};
+
+	struct StreamEntry {
+		weak_ptr<Http2Stream> stream;
+		int64_t sendWindow;
+		size_t recvConsumed = 0;          // since the last window update
+		std::deque<message_ptr> pending; // data waiting for flow control credit
+		size_t pendingOffset = 0;        // in the first pending message
+		bool closing = false;            // send END_STREAM after pending data
+	};
+
+	// Called by Http2Stream
+	void openStream(shared_ptr<Http2Stream> stream);
+	bool sendData(uint32_t id, message_ptr message);
+	void closeStream(uint32_t id);
+
+	void incoming(message_ptr message) override;
+	void processFrame(uint8_t type, uint8_t flags, uint32_t id, const byte *payload,
+	                  size_t length);
+	void processHeaders(uint32_t id, bool end);
+	void processSettings(const byte *payload, size_t length);
+	void processData(uint32_t id, uint8_t flags, const byte *payload, size_t length);
+	void processWindowUpdate(uint32_t id, const byte *payload, size_t length);
+	void processGoAway(const byte *payload, size_t length);
+	void fail(uint32_t errorCode, const string &reason);
+
+	// Require mMutex to be locked
+	void startStream(shared_ptr<Http2Stream> stream);
+	bool flushPending(uint32_t id, StreamEntry &entry);
+	void appendFrame(binary &out, uint8_t type, uint8_t flags, uint32_t id, const byte *payload,
+	                 size_t length) const;
+	bool sendFrame(uint8_t type, uint8_t flags, uint32_t id, const byte *payload = nullptr,
+	               size_t length = 0);
+	bool isAvailable() const;
+
+	const string mKey;
+
+	mutable std::mutex mMutex;
+	Settings mPeerSettings;
+	bool mSettingsReceived = false;
+	bool mGoingAway = false;
+	uint32_t mNextStreamId = 1;
+	int64_t mSendWindow = 65535;
+	size_t mRecvConsumed = 0;
+	std::unordered_map<uint32_t, StreamEntry> mStreams;
+	std::vector<shared_ptr<Http2Stream>> mWaitingStreams; // until settings are received
+
+	// Only accessed from incoming()
+	binary mBuffer;
+	binary mHeaderBlock;
+	uint32_t mHeaderStreamId = 0; // stream of the header block being received, 0 if none
+	bool mHeaderEndStream = false;
+	HpackDecoder mDecoder;
+};
+
+// WebSocket stream on an HTTP/2 connection, the lower transport of a WsTransport
+class Http2Stream final : public Transport, public std::enable_shared_from_this<Http2Stream> {
+public:
+	Http2Stream(shared_ptr<Http2Transport> session, shared_ptr<WsHandshake> handshake,
+	            state_callback callback);
+	~Http2Stream();
+
+	void start() override;
+	void stop() override;
+	bool send(message_ptr message) override;
+
+	bool isActive() const { return true; }
+
+	// Whether the stream failed because the server does not support extended CONNECT
+	bool isUnsupported() const { return mUnsupported; }
+
+private:
+	friend class Http2Transport;
+
+	// Called by Http2Transport without its lock
+	void opened(uint32_t id);
+	void incomingHeaders(const HeaderList &headers, bool end);
+	void incomingData(message_ptr message, bool end);
+	void reset(bool unsupported = false);
+
+	const shared_ptr<Http2Transport> mSession;
+	const shared_ptr<WsHandshake> mHandshake;
+	std::atomic<uint32_t> mId = 0; // 0 until opened
+	std::atomic<bool> mUnsupported = false;
+	std::atomic<bool> mStopped = false;
+	bool mResponseReceived = false;
+};
+
+} // namespace rtc::impl
+
+#endif
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "iceportpool.hpp"
+#include "internals.hpp"
+#include "threadpool.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace rtc::impl {
+
+namespace {
+
+const int MAX_RESERVE_ATTEMPTS = 16; // per reserved port
+
+}
+
+IcePortPool &IcePortPool::Instance() {
+	static IcePortPool *instance = new IcePortPool;
+	return *instance;
+}
+
+IcePortPool::IcePortPool() {}
+
+IcePortPool::~IcePortPool() {}
+
+void IcePortPool::setSettings(IcePortPoolSettings s) {
+	if (s.portRangeBegin == 0 || s.portRangeEnd < s.portRangeBegin)
+		throw std::invalid_argument("Invalid ICE port pool range");
+
+	std::lock_guard lock(mMutex);
+	++mEpoch; // invalidate the pending refill
+	mRefilling = false;
+	for (auto &reservation : mReservations)
+		Close(reservation);
+
+	mReservations.clear();
+	mReleased.clear();
+	mSettings = std::move(s);
+	refill();
+}
+
+void IcePortPool::start() {
+	std::lock_guard lock(mMutex);
+	if (std::exchange(mStarted, true))
+		return;
+
+	if (mSettings.size > 0) {
+		PLOG_DEBUG << "Starting ICE port pool, size=" << mSettings.size;
+	}
+	refill();
+}
+
+void IcePortPool::stop() {
+	std::lock_guard lock(mMutex);
+	if (mStarted) {
+		PLOG_DEBUG << "Stopping ICE port pool";
+	}
+
+	mStarted = false;
+	mRefilling = false;
+	++mEpoch; // invalidate the pending refill
+	for (auto &reservation : mReservations)
+		Close(reservation);
+
+	mReservations.clear();
+	mReleased.clear();
+}
+
+optional<uint16_t> IcePortPool::acquire(uint16_t rangeBegin, uint16_t rangeEnd,
+                                        const optional<string> &bindAddress) {
+	std::lock_guard lock(mMutex);
+	if (rangeBegin != mSettings.portRangeBegin || rangeEnd != mSettings.portRangeEnd ||
+	    bindAddress != mSettings.bindAddress)
+		return nullopt;
+
+	if (mReservations.empty()) {
+		if (mStarted && mSettings.size > 0) {
+			PLOG_DEBUG << "ICE port pool is empty";
+		}
+		refill();
+		return nullopt;
+	}
+
+	// Close the reservation right before the agent binds the port
+	auto reservation = mReservations.front();
+	mReservations.pop_front();
+	Close(reservation);
+	refill();
+
+	PLOG_VERBOSE << "Using pooled ICE port " << reservation.port;
+	return reservation.port;
+}
+
+void IcePortPool::release(uint16_t port) {
+	std::lock_guard lock(mMutex);
+	if (!mStarted || port < mSettings.portRangeBegin || port > mSettings.portRangeEnd)
+		return;
+
+	mReleased.push_back(port);
+	refill();
+}
+
+void IcePortPool::refill() {
+	// Requires mMutex to be locked
+	if (!mStarted || mRefilling || mReservations.size() >= mSettings.size)
+		return;
+
+	// Ports are reserved one at a time not to hog the thread pool
+	mRefilling = true;
+	ThreadPool::Instance().post([this, epoch = mEpoch]() { reserveOne(epoch); });
+}
+
+optional<uint16_t> IcePortPool::nextCandidatePort() {
+	// Requires mMutex to be locked
+	while (!mReleased.empty()) {
+		uint16_t port = mReleased.back();
+		mReleased.pop_back();
+		if (!isReserved(port))
+			return port;
+	}
+
+	const uint32_t count = uint32_t(mSettings.portRangeEnd - mSettings.portRangeBegin) + 1;
+	if (mReservations.size() >= count)
+		return nullopt; // the whole range is reserved
+
+	std::uniform_int_distribution<uint32_t> dist(0, count - 1);
+	auto engine = utils::random_engine();
+	for (int i = 0; i < MAX_RESERVE_ATTEMPTS; ++i) {
+		uint16_t port = uint16_t(mSettings.portRangeBegin + dist(engine));
+		if (!isReserved(port))
+			return port;
+	}
+	return nullopt;
+}
+
+bool IcePortPool::isReserved(uint16_t port) const {
+	// Requires mMutex to be locked
+	return std::any_of(mReservations.begin(), mReservations.end(),
+	                   [port](const Reservation &r) { return r.port == port; });
+}
+
+void IcePortPool::reserveOne(unsigned int epoch) {
+	optional<string> bindAddress;
+	{
+		std::lock_guard lock(mMutex);
+		if (epoch != mEpoch)
+			return;
+
+		bindAddress = mSettings.bindAddress;
+	}
+
+	// Binding happens outside of the lock, ports in use elsewhere are skipped
+	optional<Reservation> reservation;
+	for (int i = 0; i < MAX_RESERVE_ATTEMPTS && !reservation; ++i) {
+		optional<uint16_t> port;
+		{
+			std::lock_guard lock(mMutex);
+			if (epoch != mEpoch)
+				return;
+
+			port = nextCandidatePort();
+		}
+		if (!port)
+			break;
+
+		reservation = Reserve(*port, bindAddress);
+	}
+
+	std::lock_guard lock(mMutex);
+	if (epoch != mEpoch) {
+		if (reservation)
+			Close(*reservation);
+		return;
+	}
+
+	mRefilling = false;
+	if (!reservation) {
+		PLOG_WARNING << "Failed to reserve a port for the ICE port pool";
+		return; // not retried until the next request
+	}
+
+	if (isReserved(reservation->port) || mReservations.size() >= mSettings.size) {
+		Close(*reservation);
+		return;
+	}
+
+	mReservations.push_back(*reservation);
+	refill();
+}
+
+optional<IcePortPool::Reservation> IcePortPool::Reserve(uint16_t port,
+                                                        const optional<string> &bindAddress) {
+	struct addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_protocol = IPPROTO_UDP;
+	hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+	if (!bindAddress)
+		hints.ai_family = AF_INET6; // dual-stack like the agents
+
+	struct addrinfo *result = nullptr;
+	if (getaddrinfo(bindAddress ? bindAddress->c_str() : nullptr, std::to_string(port).c_str(),
+	                &hints, &result))
+		return nullopt;
+
+	socket_t sock = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (sock == INVALID_SOCKET) {
+		freeaddrinfo(result);
+		return nullopt;
+	}
+
+	if (result->ai_family == AF_INET6) {
+		int disabled = 0;
+		::setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char *>(&disabled),
+		             sizeof(disabled));
+	}
+
+	int ret = ::bind(sock, result->ai_addr, socklen_t(result->ai_addrlen));
+	freeaddrinfo(result);
+	if (ret < 0) {
+		::closesocket(sock);
+		return nullopt;
+	}
+
+	return Reservation{port, sock};
+}
+
+void IcePortPool::Close(Reservation &reservation) {
+	if (reservation.sock != INVALID_SOCKET) {
+		::closesocket(reservation.sock);
+		reservation.sock = INVALID_SOCKET;
+	}
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_ICE_PORT_POOL_H
+#define RTC_IMPL_ICE_PORT_POOL_H
+
+#include "common.hpp"
+#include "global.hpp" // for IcePortPoolSettings
+#include "socket.hpp"
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace rtc::impl {
+
+// Keeps UDP ports of a range reserved in advance, so that ICE agents created with the same range
+// bind a port known to be free instead of probing the range during connection setup. A reserved
+// socket is closed just before the agent binds its port, which is reserved again once released.
+class IcePortPool final {
+public:
+	static IcePortPool &Instance();
+
+	IcePortPool(const IcePortPool &) = delete;
+	IcePortPool &operator=(const IcePortPool &) = delete;
+	IcePortPool(IcePortPool &&) = delete;
+	IcePortPool &operator=(IcePortPool &&) = delete;
+
+	void setSettings(IcePortPoolSettings s);
+
+	void start(); // start reserving, called on preload
+	void stop();  // stop reserving and close reserved sockets, called on cleanup
+
+	// Returns a free port if the pool matches the range and bind address
+	optional<uint16_t> acquire(uint16_t rangeBegin, uint16_t rangeEnd,
+	                           const optional<string> &bindAddress);
+	void release(uint16_t port); // the port may be reserved again
+
+private:
+	IcePortPool();
+	~IcePortPool();
+
+	struct Reservation {
+		uint16_t port;
+		socket_t sock;
+	};
+
+	// The following require mMutex to be locked
+	void refill();
+	optional<uint16_t> nextCandidatePort();
+	bool isReserved(uint16_t port) const;
+
+	void reserveOne(unsigned int epoch);
+	static optional<Reservation> Reserve(uint16_t port, const optional<string> &bindAddress);
+	static void Close(Reservation &reservation);
+
+	IcePortPoolSettings mSettings;
+	std::deque<Reservation> mReservations;
+	std::vector<uint16_t> mReleased; // released by agents, tried first
+	bool mStarted = false;
+	bool mRefilling = false;
+	unsigned int mEpoch = 0; // incremented on stop and on settings change
+	std::mutex mMutex;
+};
+
+} // namespace rtc::impl
+
+#endif
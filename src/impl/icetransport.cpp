@@ -8,12 +8,17 @@
 
 #include "icetransport.hpp"
 #include "configuration.hpp"
+#include "dnscache.hpp"
+#include "iceportpool.hpp"
 #include "internals.hpp"
 #include "transport.hpp"
 #include "utils.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <sstream>
 
@@ -27,6 +32,11 @@
 #include <sys/socket.h>
 #endif
 
+#ifdef __linux__
+#include <netinet/udp.h> // for UDP_SEGMENT
+#include <sys/uio.h>
+#endif
+
 #include <sys/types.h>
 
 using namespace std::chrono_literals;
@@ -34,11 +44,18 @@ using std::chrono::system_clock;
 
 namespace rtc::impl {
 
+namespace {
+
+// Explicit Congestion Notification takes the least-significant 2 bits of the DS field
+int ds_field(const Message &message) { return int((message.dscp << 2) | (message.ecn & 0x03)); }
+
+} // namespace
+
 #if !USE_NICE // libjuice
 
-const int MAX_TURN_SERVERS_COUNT = 2;
+const unsigned int MAX_TURN_SERVERS_COUNT = 2;
 
-void IceTransport::Init() {
+void IceTransport::Init(unsigned int /*mainLoopsCount*/) {
 	// Dummy
 }
 
@@ -53,10 +70,16 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
       mMid("0"), mGatheringState(GatheringState::New),
       mCandidateCallback(std::move(candidateCallback)),
       mGatheringStateChangeCallback(std::move(gatheringStateChangeCallback)),
+      mMaxTurnAllocations(std::min(config.maxTurnAllocations.value_or(MAX_TURN_SERVERS_COUNT),
+                                   MAX_TURN_SERVERS_COUNT)),
       mAgent(nullptr, nullptr) {
 
 	PLOG_DEBUG << "Initializing ICE transport (libjuice)";
 
+	if (config.networkImpairment)
+		mImpairment = std::make_shared<Impairment>(
+		    *config.networkImpairment, [this](message_ptr message) { return outgoing(message); });
+
 	juice_log_level_t level;
 	auto logger = plog::get();
 	switch (logger ? logger->getMaxSeverity() : plog::none) {
@@ -83,13 +106,18 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 	juice_set_log_handler(IceTransport::LogCallback);
 	juice_set_log_level(level);
 
-	juice_config_t jconfig = {};
+	juice_config_t &jconfig = mJuiceConfig;
+	jconfig = {};
 	jconfig.cb_state_changed = IceTransport::StateChangeCallback;
 	jconfig.cb_candidate = IceTransport::CandidateCallback;
 	jconfig.cb_gathering_done = IceTransport::GatheringDoneCallback;
 	jconfig.cb_recv = IceTransport::RecvCallback;
 	jconfig.user_ptr = this;
 
+	if (config.enableUdpSegmentationOffload) {
+		PLOG_WARNING << "UDP segmentation offload is not available with libjuice";
+	}
+
 	if (config.enableIceUdpMux) {
 		PLOG_DEBUG << "Enabling ICE UDP mux";
 		jconfig.concurrency_mode = JUICE_CONCURRENCY_MODE_MUX;
@@ -101,13 +129,23 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 	std::vector<IceServer> servers = config.iceServers;
 	std::shuffle(servers.begin(), servers.end(), utils::random_engine());
 
-	// Pick a STUN server
+	// Pick a STUN server, resolved through the cache so the agent doesn't resolve it again
 	for (auto &server : servers) {
 		if (!server.hostname.empty() && server.type == IceServer::Type::Stun) {
 			if (server.port == 0)
 				server.port = 3478; // STUN UDP port
+
+			auto addresses =
+			    DnsCache::Instance().resolve(server.hostname, server.port, AF_UNSPEC, SOCK_DGRAM);
+			if (addresses.empty()) {
+				PLOG_WARNING << "Unable to resolve STUN server address: " << server.hostname << ':'
+				             << server.port;
+				continue;
+			}
+
 			PLOG_INFO << "Using STUN server \"" << server.hostname << ":" << server.port << "\"";
-			jconfig.stun_server_host = server.hostname.c_str();
+			mStunNode = addresses.front().node;
+			jconfig.stun_server_host = mStunNode.c_str();
 			jconfig.stun_server_port = server.port;
 			break;
 		}
@@ -115,24 +153,53 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 
 	// Bind address
 	if (config.bindAddress) {
-		jconfig.bind_address = config.bindAddress->c_str();
+		mBindAddress = *config.bindAddress;
+		jconfig.bind_address = mBindAddress->c_str();
 	}
 
 	// Port range
-	if (config.portRangeBegin > 1024 ||
-	    (config.portRangeEnd != 0 && config.portRangeEnd != 65535)) {
-		jconfig.local_port_range_begin = config.portRangeBegin;
-		jconfig.local_port_range_end = config.portRangeEnd;
+	if (config.enableIceUdpMux && config.iceUdpMuxShards > 1) {
+		// Agents are assigned to shards in turn, a shard being a mux socket on its own port, so
+		// that all packets of a peer go through the same socket and thread
+		static std::atomic<unsigned int> nextShard = 0;
+		unsigned int shards = config.iceUdpMuxShards;
+		if (size_t(config.portRangeBegin) + shards - 1 > 65535)
+			throw std::invalid_argument("Invalid ICE UDP mux shards count");
+
+		auto port = uint16_t(config.portRangeBegin + nextShard++ % shards);
+		PLOG_DEBUG << "Using ICE UDP mux shard on port " << port;
+		jconfig.local_port_range_begin = port;
+		jconfig.local_port_range_end = port;
+	} else {
+		if (config.portRangeBegin > 1024 ||
+		    (config.portRangeEnd != 0 && config.portRangeEnd != 65535)) {
+			jconfig.local_port_range_begin = config.portRangeBegin;
+			jconfig.local_port_range_end = config.portRangeEnd;
+		}
+		mPortRange = {jconfig.local_port_range_begin, jconfig.local_port_range_end};
+
+		if (!config.enableIceUdpMux &&
+		    (mPooledPort = IcePortPool::Instance().acquire(config.portRangeBegin,
+		                                                   config.portRangeEnd, config.bindAddress))) {
+			// The pooled port was reserved in advance, so the agent doesn't need to probe the range
+			jconfig.local_port_range_begin = *mPooledPort;
+			jconfig.local_port_range_end = *mPooledPort;
+		}
 	}
 
 	// Create agent
 	mAgent = decltype(mAgent)(juice_create(&jconfig), juice_destroy);
-	if (!mAgent)
+	if (!mAgent) {
+		if (mPooledPort)
+			IcePortPool::Instance().release(*mPooledPort);
+
 		throw std::runtime_error("Failed to create the ICE agent");
+	}
 
 	// ICE-TCP
-	juice_set_ice_tcp_mode(mAgent.get(), config.enableIceTcp ? JUICE_ICE_TCP_MODE_ACTIVE
-	                                                         : JUICE_ICE_TCP_MODE_NONE);
+	mIceTcp = config.enableIceTcp;
+	juice_set_ice_tcp_mode(mAgent.get(),
+	                       mIceTcp ? JUICE_ICE_TCP_MODE_ACTIVE : JUICE_ICE_TCP_MODE_NONE);
 
 	// Add TURN servers
 	for (const auto &server : servers)
@@ -160,15 +227,23 @@ void IceTransport::addIceServer(IceServer server) {
 		return;
 	}
 
-	if (mTurnServersAdded >= MAX_TURN_SERVERS_COUNT)
+	if (mTurnAllocations >= mMaxTurnAllocations)
 		return;
 
 	if (server.port == 0)
 		server.port = 3478; // TURN UDP port
 
+	auto addresses =
+	    DnsCache::Instance().resolve(server.hostname, server.port, AF_UNSPEC, SOCK_DGRAM);
+	if (addresses.empty()) {
+		PLOG_WARNING << "Unable to resolve TURN server address: " << server.hostname << ':'
+		             << server.port;
+		return;
+	}
+
 	PLOG_INFO << "Using TURN server \"" << server.hostname << ":" << server.port << "\"";
 	juice_turn_server_t turn_server = {};
-	turn_server.host = server.hostname.c_str();
+	turn_server.host = addresses.front().node.c_str();
 	turn_server.username = server.username.c_str();
 	turn_server.password = server.password.c_str();
 	turn_server.port = server.port;
@@ -176,12 +251,54 @@ void IceTransport::addIceServer(IceServer server) {
 	if (juice_add_turn_server(mAgent.get(), &turn_server) != 0)
 		throw std::runtime_error("Failed to add TURN server");
 
-	++mTurnServersAdded;
+	++mTurnAllocations;
+	if (mPooledPort)
+		mTurnServers.push_back(std::move(server));
+}
+
+void IceTransport::recreateAgentWithoutPooledPort() {
+	// The reserved port was taken between its reservation and the bind by the agent: as the agent
+	// has not gathered yet, replace it with one probing the configured range, keeping the ICE
+	// credentials already sent to the remote peer and replaying its settings
+	PLOG_WARNING << "Pooled port " << *mPooledPort << " is not available, using the port range";
+	auto local = getLocalDescription(Description::Type::Offer);
+
+	mAgent.reset();
+	IcePortPool::Instance().release(*std::exchange(mPooledPort, nullopt));
+
+	mJuiceConfig.local_port_range_begin = mPortRange.first;
+	mJuiceConfig.local_port_range_end = mPortRange.second;
+	mAgent = decltype(mAgent)(juice_create(&mJuiceConfig), juice_destroy);
+	if (!mAgent)
+		throw std::runtime_error("Failed to create the ICE agent");
+
+	juice_set_ice_tcp_mode(mAgent.get(),
+	                       mIceTcp ? JUICE_ICE_TCP_MODE_ACTIVE : JUICE_ICE_TCP_MODE_NONE);
+
+	if (auto uFrag = local.iceUfrag(), pwd = local.icePwd(); uFrag && pwd)
+		setIceAttributes(*uFrag, *pwd);
+
+	mTurnAllocations = 0;
+	for (auto &server : std::exchange(mTurnServers, {}))
+		addIceServer(std::move(server));
+
+	if (mRemoteSdp && juice_set_remote_description(mAgent.get(), mRemoteSdp->c_str()) < 0)
+		throw std::invalid_argument("Invalid ICE settings from remote SDP");
+
+	for (const auto &candidate : std::exchange(mRemoteCandidates, {}))
+		juice_add_remote_candidate(mAgent.get(), candidate.c_str());
 }
 
 IceTransport::~IceTransport() {
 	PLOG_DEBUG << "Destroying ICE transport";
+	if (mImpairment)
+		mImpairment->stop();
+
+	mSendRetryTimer.cancel();
 	mAgent.reset();
+
+	if (mPooledPort)
+		IcePortPool::Instance().release(*mPooledPort);
 }
 
 Description::Role IceTransport::role() const { return mRole; }
@@ -220,9 +337,12 @@ void IceTransport::setRemoteDescription(const Description &description) {
 		throw std::invalid_argument("Incompatible roles with remote description");
 
 	mMid = description.bundleMid();
-	if (juice_set_remote_description(mAgent.get(),
-	                                 description.generateApplicationSdp("\r\n").c_str()) < 0)
+	string sdp = description.generateApplicationSdp("\r\n");
+	if (juice_set_remote_description(mAgent.get(), sdp.c_str()) < 0)
 		throw std::invalid_argument("Invalid ICE settings from remote SDP");
+
+	if (mPooledPort)
+		mRemoteSdp = std::move(sdp); // replayed if the agent is recreated
 }
 
 bool IceTransport::addRemoteCandidate(const Candidate &candidate) {
@@ -230,7 +350,24 @@ bool IceTransport::addRemoteCandidate(const Candidate &candidate) {
 	if (!candidate.isResolved())
 		return false;
 
-	return juice_add_remote_candidate(mAgent.get(), string(candidate).c_str()) >= 0;
+	string str(candidate);
+	if (juice_add_remote_candidate(mAgent.get(), str.c_str()) < 0)
+		return false;
+
+	if (mPooledPort)
+		mRemoteCandidates.push_back(std::move(str)); // replayed if the agent is recreated
+
+	return true;
+}
+
+size_t IceTransport::addRemoteCandidates(const std::vector<Candidate> &candidates) {
+	// libjuice has no batch call, but it is cheap per candidate
+	size_t count = 0;
+	for (const auto &candidate : candidates)
+		if (addRemoteCandidate(candidate))
+			++count;
+
+	return count;
 }
 
 void IceTransport::gatherLocalCandidates(string mid, std::vector<IceServer> additionalIceServers) {
@@ -244,8 +381,18 @@ void IceTransport::gatherLocalCandidates(string mid, std::vector<IceServer> addi
 	changeGatheringState(GatheringState::InProgress);
 
 	if (juice_gather_candidates(mAgent.get()) < 0) {
-		throw std::runtime_error("Failed to gather local ICE candidates");
+		if (!mPooledPort)
+			throw std::runtime_error("Failed to gather local ICE candidates");
+
+		recreateAgentWithoutPooledPort();
+		if (juice_gather_candidates(mAgent.get()) < 0)
+			throw std::runtime_error("Failed to gather local ICE candidates");
 	}
+
+	// The agent won't be recreated anymore
+	mTurnServers.clear();
+	mRemoteSdp.reset();
+	mRemoteCandidates.clear();
 }
 
 optional<string> IceTransport::getLocalAddress() const {
@@ -289,14 +436,53 @@ bool IceTransport::send(message_ptr message) {
 		return false;
 
 	PLOG_VERBOSE << "Send size=" << message->size();
+	countSent(*message);
+	if (mImpairment)
+		return mImpairment->send(std::move(message));
+
 	return outgoing(message);
 }
 
-bool IceTransport::outgoing(message_ptr message) {
-	// Explicit Congestion Notification takes the least-significant 2 bits of the DS field
-	int ds = int(message->dscp << 2);
-	return juice_send_diffserv(mAgent.get(), reinterpret_cast<const char *>(message->data()),
-	                           message->size(), ds) >= 0;
+bool IceTransport::sendBatch(message_vector messages) {
+	auto s = state();
+	if (s != State::Connected && s != State::Completed)
+		return false;
+
+	if (mImpairment) {
+		bool result = true;
+		for (auto &message : messages) {
+			if (message) {
+				countSent(*message);
+				result = mImpairment->send(std::move(message)) && result;
+			}
+		}
+		return result;
+	}
+
+	// libjuice has no batched send, so packets are only sent in a row without further checks
+	PLOG_VERBOSE << "Send batch count=" << messages.size();
+	bool result = true;
+	for (auto &message : messages) {
+		if (message) {
+			countSent(*message);
+			result = outgoing(std::move(message)) && result;
+		}
+	}
+
+	return result;
+}
+
+IceTransport::SendResult IceTransport::trySend(const message_ptr &message) {
+	int ret = juice_send_diffserv(mAgent.get(), reinterpret_cast<const char *>(message->data()),
+	                              message->size(), ds_field(*message));
+	if (ret >= 0)
+		return SendResult::Sent;
+
+#ifdef JUICE_ERR_AGAIN
+	if (ret == JUICE_ERR_AGAIN)
+		return SendResult::WouldBlock;
+#endif
+	return SendResult::Failed; // older libjuice versions don't report a full socket buffer
 }
 
 void IceTransport::changeGatheringState(GatheringState state) {
@@ -392,14 +578,22 @@ void IceTransport::LogCallback(juice_log_level_t level, const char *message) {
 
 #else // USE_NICE == 1
 
-IceTransport::MainLoopWrapper *IceTransport::MainLoop = nullptr;
+std::vector<unique_ptr<IceTransport::MainLoopWrapper>> IceTransport::MainLoops;
+std::atomic<size_t> IceTransport::NextMainLoop = 0;
 
-IceTransport::MainLoopWrapper::MainLoopWrapper()
-    : mMainLoop(g_main_loop_new(nullptr, FALSE), g_main_loop_unref) {
+IceTransport::MainLoopWrapper::MainLoopWrapper(string threadName)
+    : mContext(g_main_context_new(), g_main_context_unref),
+      mMainLoop(g_main_loop_new(mContext.get(), FALSE), g_main_loop_unref) {
 	if (!mMainLoop)
 		throw std::runtime_error("Failed to create the glib main loop");
 
-	mThread = std::thread(g_main_loop_run, mMainLoop.get());
+	mThread = std::thread([loop = mMainLoop.get(), context = mContext.get(),
+	                       threadName = std::move(threadName)]() {
+		utils::this_thread::set_name(threadName);
+		g_main_context_push_thread_default(context);
+		g_main_loop_run(loop);
+		g_main_context_pop_thread_default(context);
+	});
 }
 
 IceTransport::MainLoopWrapper::~MainLoopWrapper() {
@@ -407,23 +601,26 @@ IceTransport::MainLoopWrapper::~MainLoopWrapper() {
 	mThread.join();
 }
 
-GMainLoop *IceTransport::MainLoopWrapper::get() const { return mMainLoop.get(); }
+GMainContext *IceTransport::MainLoopWrapper::context() const { return mContext.get(); }
 
-void IceTransport::Init() {
+void IceTransport::Init(unsigned int mainLoopsCount) {
 	g_log_set_handler("libnice", G_LOG_LEVEL_MASK, LogCallback, nullptr);
 
 	IF_PLOG(plog::verbose) {
 		nice_debug_enable(false); // do not output STUN debug messages
 	}
 
-	MainLoop = new MainLoopWrapper;
-}
+	if (mainLoopsCount == 0)
+		mainLoopsCount = std::max(std::thread::hardware_concurrency(), 1u);
 
-void IceTransport::Cleanup() {
-	delete MainLoop;
-	MainLoop = nullptr;
+	PLOG_DEBUG << "Starting " << mainLoopsCount << " glib main loops";
+	for (unsigned int i = 0; i < mainLoopsCount; ++i)
+		MainLoops.emplace_back(std::make_unique<MainLoopWrapper>(
+		    mainLoopsCount > 1 ? "RTC nice " + std::to_string(i) : "RTC nice"));
 }
 
+void IceTransport::Cleanup() { MainLoops.clear(); }
+
 static void closeNiceAgentCallback(GObject *niceAgent, GAsyncResult *, gpointer) {
 	g_object_unref(niceAgent);
 }
@@ -433,6 +630,13 @@ static void closeNiceAgent(NiceAgent *niceAgent) {
 	nice_agent_close_async(niceAgent, closeNiceAgentCallback, nullptr);
 }
 
+static void destroySource(GSource *source) {
+	if (source) {
+		g_source_destroy(source); // no-op if already dispatched
+		g_source_unref(source);
+	}
+}
+
 IceTransport::IceTransport(const Configuration &config, candidate_callback candidateCallback,
                            state_callback stateChangeCallback,
                            gathering_state_callback gatheringStateChangeCallback)
@@ -440,13 +644,22 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
       mMid("0"), mGatheringState(GatheringState::New),
       mCandidateCallback(std::move(candidateCallback)),
       mGatheringStateChangeCallback(std::move(gatheringStateChangeCallback)),
-      mNiceAgent(nullptr, nullptr), mOutgoingDscp(0) {
+      mMaxTurnAllocations(
+          config.maxTurnAllocations.value_or(std::numeric_limits<unsigned int>::max())),
+      mNiceAgent(nullptr, nullptr), mOutgoingDs(0) {
 
 	PLOG_DEBUG << "Initializing ICE transport (libnice)";
 
-	if (!MainLoop)
+	if (config.networkImpairment)
+		mImpairment = std::make_shared<Impairment>(
+		    *config.networkImpairment, [this](message_ptr message) { return outgoing(message); });
+
+	if (MainLoops.empty())
 		throw std::logic_error("Main loop for nice agent is not created");
 
+	// All callbacks of the agent, including reception, run on the thread of its main loop
+	mMainContext = MainLoops[NextMainLoop++ % MainLoops.size()]->context();
+
 	// RFC 8445: The nomination process that was referred to as "aggressive nomination" in RFC 5245
 	// has been deprecated in this specification.
 	// libnice defaults to aggressive nomation therefore we change to regular nomination.
@@ -457,7 +670,7 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 	// Create agent
 	mNiceAgent = decltype(mNiceAgent)(
 	    nice_agent_new_full(
-	        g_main_loop_get_context(MainLoop->get()),
+	        mMainContext,
 	        NICE_COMPATIBILITY_RFC5245, // RFC 5245 was obsoleted by RFC 8445 but this should be OK
 	        flags),
 	    closeNiceAgent);
@@ -521,12 +734,20 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 		PLOG_WARNING << "ICE UDP mux is not available with libnice";
 	}
 
+	if (config.enableUdpSegmentationOffload) {
+#ifdef UDP_SEGMENT
+		PLOG_DEBUG << "Enabling UDP segmentation offload";
+		mSegmentationOffload = true;
+#else
+		PLOG_WARNING << "UDP segmentation offload is not available on this platform";
+#endif
+	}
+
 	// Randomize order
 	std::vector<IceServer> servers = config.iceServers;
 	std::shuffle(servers.begin(), servers.end(), utils::random_engine());
 
 	// Add one STUN server
-	bool success = false;
 	for (auto &server : servers) {
 		if (server.hostname.empty())
 			continue;
@@ -535,40 +756,20 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 		if (server.port == 0)
 			server.port = 3478; // STUN UDP port
 
-		struct addrinfo hints = {};
-		hints.ai_family = AF_INET; // IPv4
-		hints.ai_socktype = SOCK_DGRAM;
-		hints.ai_protocol = IPPROTO_UDP;
-		hints.ai_flags = AI_ADDRCONFIG;
-		struct addrinfo *result = nullptr;
-		if (getaddrinfo(server.hostname.c_str(), std::to_string(server.port).c_str(), &hints,
-		                &result) != 0) {
+		// IPv4 only
+		auto addresses =
+		    DnsCache::Instance().resolve(server.hostname, server.port, AF_INET, SOCK_DGRAM);
+		if (addresses.empty()) {
 			PLOG_WARNING << "Unable to resolve STUN server address: " << server.hostname << ':'
 			             << server.port;
 			continue;
 		}
 
-		for (auto p = result; p; p = p->ai_next) {
-			if (p->ai_family == AF_INET) {
-				char nodebuffer[MAX_NUMERICNODE_LEN];
-				char servbuffer[MAX_NUMERICSERV_LEN];
-				if (getnameinfo(p->ai_addr, p->ai_addrlen, nodebuffer, MAX_NUMERICNODE_LEN,
-				                servbuffer, MAX_NUMERICSERV_LEN,
-				                NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
-					PLOG_INFO << "Using STUN server \"" << server.hostname << ":" << server.port
-					          << "\"";
-					g_object_set(G_OBJECT(mNiceAgent.get()), "stun-server", nodebuffer, nullptr);
-					g_object_set(G_OBJECT(mNiceAgent.get()), "stun-server-port",
-					             std::stoul(servbuffer), nullptr);
-					success = true;
-					break;
-				}
-			}
-		}
-
-		freeaddrinfo(result);
-		if (success)
-			break;
+		PLOG_INFO << "Using STUN server \"" << server.hostname << ":" << server.port << "\"";
+		g_object_set(G_OBJECT(mNiceAgent.get()), "stun-server", addresses.front().node.c_str(),
+		             nullptr);
+		g_object_set(G_OBJECT(mNiceAgent.get()), "stun-server-port", guint(server.port), nullptr);
+		break;
 	}
 
 	// Add TURN servers
@@ -582,13 +783,14 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 	                 G_CALLBACK(CandidateCallback), this);
 	g_signal_connect(G_OBJECT(mNiceAgent.get()), "candidate-gathering-done",
 	                 G_CALLBACK(GatheringDoneCallback), this);
+	g_signal_connect(G_OBJECT(mNiceAgent.get()), "new-selected-pair",
+	                 G_CALLBACK(SelectedPairCallback), this);
 
 	nice_agent_set_stream_name(mNiceAgent.get(), mStreamId, "application");
 	nice_agent_set_port_range(mNiceAgent.get(), mStreamId, 1, config.portRangeBegin,
 	                          config.portRangeEnd);
 
-	nice_agent_attach_recv(mNiceAgent.get(), mStreamId, 1, g_main_loop_get_context(MainLoop->get()),
-	                       RecvCallback, this);
+	nice_agent_attach_recv(mNiceAgent.get(), mStreamId, 1, mMainContext, RecvCallback, this);
 }
 
 void IceTransport::setIceAttributes([[maybe_unused]] string uFrag, [[maybe_unused]] string pwd) {
@@ -605,63 +807,64 @@ void IceTransport::addIceServer(IceServer server) {
 		return;
 	}
 
+	if (mTurnAllocations >= mMaxTurnAllocations)
+		return;
+
 	if (server.port == 0)
 		server.port = server.relayType == IceServer::RelayType::TurnTls ? 5349 : 3478;
 
-	struct addrinfo hints = {};
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype =
-	    server.relayType == IceServer::RelayType::TurnUdp ? SOCK_DGRAM : SOCK_STREAM;
-	hints.ai_protocol =
-	    server.relayType == IceServer::RelayType::TurnUdp ? IPPROTO_UDP : IPPROTO_TCP;
-	hints.ai_flags = AI_ADDRCONFIG;
-	struct addrinfo *result = nullptr;
-	if (getaddrinfo(server.hostname.c_str(), std::to_string(server.port).c_str(), &hints,
-	                &result) != 0) {
+	auto addresses = DnsCache::Instance().resolve(
+	    server.hostname, server.port, AF_UNSPEC,
+	    server.relayType == IceServer::RelayType::TurnUdp ? SOCK_DGRAM : SOCK_STREAM);
+	if (addresses.empty()) {
 		PLOG_WARNING << "Unable to resolve TURN server address: " << server.hostname << ':'
 		             << server.port;
 		return;
 	}
 
-	for (auto p = result; p; p = p->ai_next) {
-		if (p->ai_family == AF_INET || p->ai_family == AF_INET6) {
-			char nodebuffer[MAX_NUMERICNODE_LEN];
-			char servbuffer[MAX_NUMERICSERV_LEN];
-			if (getnameinfo(p->ai_addr, p->ai_addrlen, nodebuffer, MAX_NUMERICNODE_LEN, servbuffer,
-			                MAX_NUMERICSERV_LEN, NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
-				PLOG_INFO << "Using TURN server \"" << server.hostname << ":" << server.port
-				          << "\"";
-				NiceRelayType niceRelayType;
-				switch (server.relayType) {
-				case IceServer::RelayType::TurnTcp:
-					niceRelayType = NICE_RELAY_TYPE_TURN_TCP;
-					break;
-				case IceServer::RelayType::TurnTls:
-					niceRelayType = NICE_RELAY_TYPE_TURN_TLS;
-					break;
-				default:
-					niceRelayType = NICE_RELAY_TYPE_TURN_UDP;
-					break;
-				}
-				nice_agent_set_relay_info(mNiceAgent.get(), mStreamId, 1, nodebuffer,
-				                          std::stoul(servbuffer), server.username.c_str(),
-				                          server.password.c_str(), niceRelayType);
-			}
-		}
+	NiceRelayType niceRelayType;
+	switch (server.relayType) {
+	case IceServer::RelayType::TurnTcp:
+		niceRelayType = NICE_RELAY_TYPE_TURN_TCP;
+		break;
+	case IceServer::RelayType::TurnTls:
+		niceRelayType = NICE_RELAY_TYPE_TURN_TLS;
+		break;
+	default:
+		niceRelayType = NICE_RELAY_TYPE_TURN_UDP;
+		break;
 	}
 
-	freeaddrinfo(result);
+	// Each address makes its own allocation
+	for (const auto &address : addresses) {
+		if (mTurnAllocations >= mMaxTurnAllocations)
+			break;
+
+		PLOG_INFO << "Using TURN server \"" << server.hostname << ":" << server.port << "\"";
+		if (nice_agent_set_relay_info(mNiceAgent.get(), mStreamId, 1, address.node.c_str(),
+		                              server.port, server.username.c_str(),
+		                              server.password.c_str(), niceRelayType))
+			++mTurnAllocations;
+	}
 }
 
 IceTransport::~IceTransport() {
 	PLOG_DEBUG << "Destroying ICE transport";
-	nice_agent_attach_recv(mNiceAgent.get(), mStreamId, 1, g_main_loop_get_context(MainLoop->get()),
-	                       NULL, NULL);
+	if (mImpairment)
+		mImpairment->stop();
+
+	mSendRetryTimer.cancel();
+
+	nice_agent_attach_recv(mNiceAgent.get(), mStreamId, 1, mMainContext, NULL, NULL);
 	nice_agent_remove_stream(mNiceAgent.get(), mStreamId);
-	mNiceAgent.reset();
 
-	if (mTimeoutId)
-		g_source_remove(mTimeoutId);
+	{
+		std::lock_guard lock(mOutgoingMutex);
+		unpinFastPath();
+	}
+
+	mNiceAgent.reset();
+	cancelTimeout();
 }
 
 Description::Role IceTransport::role() const { return mRole; }
@@ -734,6 +937,34 @@ bool IceTransport::addRemoteCandidate(const Candidate &candidate) {
 	return ret > 0;
 }
 
+size_t IceTransport::addRemoteCandidates(const std::vector<Candidate> &candidates) {
+	// Pass all candidates in a single call, so the agent lock is taken once
+	GSList *list = nullptr;
+	for (const auto &candidate : candidates) {
+		if (!candidate.isResolved())
+			continue;
+
+		string sdp(candidate);
+		NiceCandidate *cand =
+		    nice_agent_parse_remote_candidate_sdp(mNiceAgent.get(), mStreamId, sdp.c_str());
+		if (!cand) {
+			PLOG_WARNING << "Rejected ICE candidate: " << sdp;
+			continue;
+		}
+
+		list = g_slist_prepend(list, cand);
+	}
+
+	if (!list)
+		return 0;
+
+	list = g_slist_reverse(list);
+	int ret = nice_agent_set_remote_candidates(mNiceAgent.get(), mStreamId, 1, list);
+
+	g_slist_free_full(list, reinterpret_cast<GDestroyNotify>(nice_candidate_free));
+	return ret > 0 ? size_t(ret) : 0;
+}
+
 void IceTransport::gatherLocalCandidates(string mid, std::vector<IceServer> additionalIceServers) {
 	mMid = std::move(mid);
 
@@ -773,19 +1004,288 @@ bool IceTransport::send(message_ptr message) {
 		return false;
 
 	PLOG_VERBOSE << "Send size=" << message->size();
+	countSent(*message);
+	if (mImpairment)
+		return mImpairment->send(std::move(message));
+
 	return outgoing(message);
 }
 
-bool IceTransport::outgoing(message_ptr message) {
+bool IceTransport::sendBatch(message_vector messages) {
+	auto s = state();
+	if (s != State::Connected && s != State::Completed)
+		return false;
+
+	if (mImpairment) {
+		bool result = true;
+		for (auto &message : messages) {
+			if (message) {
+				countSent(*message);
+				result = mImpairment->send(std::move(message)) && result;
+			}
+		}
+		return result;
+	}
+
+	PLOG_VERBOSE << "Send batch count=" << messages.size();
+	for (const auto &message : messages)
+		if (message)
+			countSent(*message);
+
+	// The batch is only sent if nothing is queued, otherwise it is queued behind
+	auto batchSend = [this](message_vector &batch, message_vector &blocked) {
+		return trySendBatch(batch, blocked);
+	};
+	return mSendQueue.sendBatch(std::move(messages), batchSend);
+}
+
+bool IceTransport::trySendBatch(message_vector &messages, message_vector &blocked) {
+	// Called by mSendQueue with its lock held
+	std::lock_guard lock(mOutgoingMutex);
+	bool result = true;
+	std::vector<GOutputVector> buffers;
+	std::vector<NiceOutputMessage> outputs;
+	message_vector batch; // messages of buffers
+	buffers.reserve(messages.size());
+	outputs.reserve(messages.size());
+	batch.reserve(messages.size());
+
+	// Consecutive packets are passed to libnice in a single call, which allows it to send
+	// them with a single system call when the platform supports it
+	auto flush = [&]() {
+		if (buffers.empty())
+			return true;
+
+		outputs.clear();
+		for (auto &buffer : buffers)
+			outputs.push_back({&buffer, 1});
+
+		GError *error = nullptr;
+		gint sent = nice_agent_send_messages_nonblocking(mNiceAgent.get(), mStreamId, 1,
+		                                                 outputs.data(), guint(outputs.size()),
+		                                                 nullptr, &error);
+		bool wouldBlock = false;
+		if (sent < gint(outputs.size())) {
+			// A partial send means the socket buffer is full
+			wouldBlock = !error || g_error_matches(error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+			if (wouldBlock)
+				blocked.assign(batch.begin() + std::max(sent, gint(0)), batch.end());
+			else
+				result = false;
+		}
+		if (error)
+			g_error_free(error);
+
+		buffers.clear();
+		batch.clear();
+		return !wouldBlock;
+	};
+
+	auto it = messages.begin();
+	while (it != messages.end()) {
+		if (!*it) {
+			++it;
+			continue;
+		}
+
+		const auto &message = *it;
+		const int ds = ds_field(*message);
+		if (mOutgoingDs != ds) {
+			if (!flush()) // ToS applies to the whole stream
+				break;
+
+			mOutgoingDs = ds;
+			nice_agent_set_stream_tos(mNiceAgent.get(), mStreamId, ds);
+		}
+
+#ifdef UDP_SEGMENT
+		if (mSegmentationOffload) {
+			// Look for a run of packets with the same size and DS, the last one may be
+			// shorter as it is typically the case for the last packet of a video frame
+			const size_t size = message->size();
+			const size_t maxCount =
+			    std::min(MaxSegmentsCount, MaxSegmentedSize / std::max(size, size_t(1)));
+			auto next = [&](auto end) {
+				return end != messages.end() && size_t(end - it) < maxCount && *end &&
+				       ds_field(**end) == ds;
+			};
+			auto end = it + 1;
+			while (next(end) && (*end)->size() == size)
+				++end;
+
+			if (next(end) && (*end)->size() < size)
+				++end;
+
+			if (end - it >= 2) {
+				if (!flush()) // keep packets in order
+					break;
+
+				if (sendSegmented(it, end)) {
+					it = end;
+					continue;
+				}
+			}
+		}
+#endif
+
+		buffers.push_back({message->data(), message->size()});
+		batch.push_back(message);
+		++it;
+	}
+
+	if (it == messages.end())
+		flush();
+
+	// Following packets are queued behind the blocked ones
+	if (!blocked.empty())
+		blocked.insert(blocked.end(), std::make_move_iterator(it),
+		               std::make_move_iterator(messages.end()));
+
+	return result;
+}
+
+#ifdef UDP_SEGMENT
+bool IceTransport::sendSegmented(message_vector::const_iterator begin,
+                                 message_vector::const_iterator end) {
+	// Requires mOutgoingMutex to be locked
+	auto path = fastPath(); // relayed or TCP packets must be framed by libnice
+	if (!path)
+		return false;
+
+	std::vector<struct iovec> iov;
+	iov.reserve(size_t(end - begin));
+	for (auto it = begin; it != end; ++it)
+		iov.push_back({(*it)->data(), (*it)->size()});
+
+	// The kernel splits the payload in datagrams of the segment size
+	uint16_t segmentSize = uint16_t((*begin)->size());
+	union {
+		char buf[CMSG_SPACE(sizeof(uint16_t))];
+		struct cmsghdr align; // the buffer must be aligned for cmsghdr
+	} control = {};
+	struct msghdr msg = {};
+	msg.msg_name = const_cast<struct sockaddr_storage *>(&path->addr);
+	msg.msg_namelen = path->addrlen;
+	msg.msg_iov = iov.data();
+	msg.msg_iovlen = iov.size();
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_UDP;
+	cmsg->cmsg_type = UDP_SEGMENT;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+	std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+
+	ssize_t ret = sendmsg(g_socket_get_fd(path->socket), &msg, MSG_DONTWAIT);
+	int err = errno;
+	if (ret < 0) {
+		if (err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS)
+			return false; // transient, the packets will go through libnice
+
+		// Typically EIO when the device doesn't support it, fall back to sending normally
+		PLOG_WARNING << "UDP segmentation offload failed, errno=" << err << ", disabling it";
+		mSegmentationOffload = false;
+		return false;
+	}
+
+	PLOG_VERBOSE << "Sent " << (end - begin) << " segments of size " << segmentSize;
+	return true;
+}
+#endif
+
+IceTransport::SendResult IceTransport::trySend(const message_ptr &message) {
 	std::lock_guard lock(mOutgoingMutex);
-	if (mOutgoingDscp != message->dscp) {
-		mOutgoingDscp = message->dscp;
-		// Explicit Congestion Notification takes the least-significant 2 bits of the DS field
-		int ds = int(message->dscp << 2);
+	if (const int ds = ds_field(*message); mOutgoingDs != ds) {
+		mOutgoingDs = ds;
 		nice_agent_set_stream_tos(mNiceAgent.get(), mStreamId, ds); // ToS is the legacy name for DS
 	}
-	return nice_agent_send(mNiceAgent.get(), mStreamId, 1, message->size(),
-	                       reinterpret_cast<const char *>(message->data())) >= 0;
+
+	// The stream ToS is set on the sockets, so it also applies to the fast path
+	if (auto result = sendFastPath(message); result != SendResult::Failed)
+		return result;
+
+	GOutputVector buffer = {message->data(), message->size()};
+	NiceOutputMessage output = {&buffer, 1};
+	GError *error = nullptr;
+	gint sent = nice_agent_send_messages_nonblocking(mNiceAgent.get(), mStreamId, 1, &output, 1,
+	                                                 nullptr, &error);
+	if (sent == 1)
+		return SendResult::Sent;
+
+	// Nothing sent without error also means the socket buffer is full
+	bool wouldBlock = !error || g_error_matches(error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK);
+	if (error)
+		g_error_free(error);
+
+	return wouldBlock ? SendResult::WouldBlock : SendResult::Failed;
+}
+
+const IceTransport::FastPath *IceTransport::fastPath() {
+	// Requires mOutgoingMutex to be locked
+	if (mFastPathStale.exchange(false))
+		unpinFastPath();
+
+	if (mFastPath) {
+		if (!g_socket_is_closed(mFastPath->socket))
+			return &*mFastPath;
+
+		unpinFastPath();
+	}
+
+	if (std::exchange(mFastPathChecked, true))
+		return nullptr; // not pinnable until the selected pair changes
+
+	NiceCandidate *local = nullptr;
+	NiceCandidate *remote = nullptr;
+	if (!nice_agent_get_selected_pair(mNiceAgent.get(), mStreamId, 1, &local, &remote))
+		return nullptr;
+
+	if (local->transport != NICE_CANDIDATE_TRANSPORT_UDP ||
+	    local->type == NICE_CANDIDATE_TYPE_RELAYED || remote->type == NICE_CANDIDATE_TYPE_RELAYED)
+		return nullptr;
+
+	GSocket *socket = nice_agent_get_selected_socket(mNiceAgent.get(), mStreamId, 1);
+	if (!socket)
+		return nullptr;
+
+	FastPath path = {};
+	path.socket = socket; // keep the reference
+	nice_address_copy_to_sockaddr(&remote->addr, reinterpret_cast<struct sockaddr *>(&path.addr));
+	path.addrlen = path.addr.ss_family == AF_INET6 ? sizeof(struct sockaddr_in6)
+	                                                : sizeof(struct sockaddr_in);
+
+	PLOG_DEBUG << "Pinned ICE fast path to " << AddressToString(remote->addr);
+	mFastPath.emplace(path);
+	return &*mFastPath;
+}
+
+void IceTransport::unpinFastPath() {
+	// Requires mOutgoingMutex to be locked
+	mFastPathChecked = false;
+	if (mFastPath) {
+		g_object_unref(mFastPath->socket);
+		mFastPath.reset();
+	}
+}
+
+IceTransport::SendResult IceTransport::sendFastPath(const message_ptr &message) {
+	// Requires mOutgoingMutex to be locked
+	auto path = fastPath();
+	if (!path)
+		return SendResult::Failed;
+
+	if (::sendto(g_socket_get_fd(path->socket), reinterpret_cast<const char *>(message->data()),
+	             int(message->size()), 0, reinterpret_cast<const struct sockaddr *>(&path->addr),
+	             path->addrlen) >= 0)
+		return SendResult::Sent;
+
+	if (sockerrno == SEAGAIN || sockerrno == SEWOULDBLOCK)
+		return SendResult::WouldBlock;
+
+	PLOG_DEBUG << "ICE fast path send failed, errno=" << sockerrno << ", unpinning it";
+	unpinFastPath();
+	mFastPathChecked = true; // don't pin again until the selected pair changes
+	return SendResult::Failed;
 }
 
 void IceTransport::changeGatheringState(GatheringState state) {
@@ -793,9 +1293,23 @@ void IceTransport::changeGatheringState(GatheringState state) {
 		mGatheringStateChangeCallback(mGatheringState);
 }
 
+void IceTransport::setTimeout(std::chrono::milliseconds timeout) {
+	// g_timeout_add() would attach to the global default context
+	GSource *source = g_timeout_source_new(guint(timeout.count()));
+	g_source_set_callback(source, TimeoutCallback, this, nullptr);
+
+	std::lock_guard lock(mTimeoutMutex);
+	destroySource(std::exchange(mTimeoutSource, source));
+	g_source_attach(source, mMainContext);
+}
+
+void IceTransport::cancelTimeout() {
+	std::lock_guard lock(mTimeoutMutex);
+	destroySource(std::exchange(mTimeoutSource, nullptr));
+}
+
 void IceTransport::processTimeout() {
 	PLOG_WARNING << "ICE timeout";
-	mTimeoutId = 0;
 	changeState(State::Failed);
 }
 
@@ -806,17 +1320,15 @@ void IceTransport::processCandidate(const string &candidate) {
 void IceTransport::processGatheringDone() { changeGatheringState(GatheringState::Complete); }
 
 void IceTransport::processStateChange(unsigned int state) {
+	mFastPathStale = true; // consent failures and restarts go through a state change
+
 	if (state == NICE_COMPONENT_STATE_FAILED && mTrickleTimeout.count() > 0) {
-		if (mTimeoutId)
-			g_source_remove(mTimeoutId);
-		mTimeoutId = g_timeout_add(mTrickleTimeout.count() /* ms */, TimeoutCallback, this);
+		setTimeout(mTrickleTimeout);
 		return;
 	}
 
-	if (state == NICE_COMPONENT_STATE_CONNECTED && mTimeoutId) {
-		g_source_remove(mTimeoutId);
-		mTimeoutId = 0;
-	}
+	if (state == NICE_COMPONENT_STATE_CONNECTED)
+		cancelTimeout();
 
 	switch (state) {
 	case NICE_COMPONENT_STATE_DISCONNECTED:
@@ -878,6 +1390,13 @@ void IceTransport::StateChangeCallback(NiceAgent * /*agent*/, guint /*streamId*/
 	}
 }
 
+void IceTransport::SelectedPairCallback(NiceAgent * /*agent*/, guint /*streamId*/,
+                                        guint /*componentId*/, gchar * /*localFoundation*/,
+                                        gchar * /*remoteFoundation*/, gpointer userData) {
+	auto iceTransport = static_cast<rtc::impl::IceTransport *>(userData);
+	iceTransport->mFastPathStale = true;
+}
+
 void IceTransport::RecvCallback(NiceAgent * /*agent*/, guint /*streamId*/, guint /*componentId*/,
                                 guint len, gchar *buf, gpointer userData) {
 	auto iceTransport = static_cast<rtc::impl::IceTransport *>(userData);
@@ -944,4 +1463,44 @@ bool IceTransport::getSelectedCandidatePair(Candidate *local, Candidate *remote)
 
 #endif
 
+IceTransportStats IceTransport::iceStats() {
+	IceTransportStats stats;
+	static_cast<TransportStats &>(stats) = Transport::stats();
+	Candidate local, remote;
+	if (getSelectedCandidatePair(&local, &remote)) {
+		stats.localCandidate = std::move(local);
+		stats.remoteCandidate = std::move(remote);
+	}
+	stats.turnAllocations = mTurnAllocations.load();
+	return stats;
+}
+
+size_t IceTransport::bufferedAmount() const { return mSendQueue.amount(); }
+
+void IceTransport::onBufferedAmount(amount_callback callback) {
+	mBufferedAmountCallback = std::move(callback);
+}
+
+bool IceTransport::outgoing(message_ptr message) { return mSendQueue.send(std::move(message)); }
+
+void IceTransport::flushSendQueue() {
+	// Packets are dropped if the transport is not connected anymore
+	auto s = state();
+	mSendQueue.flush(s != State::Connected && s != State::Completed);
+}
+
+void IceTransport::scheduleSendRetry(std::chrono::milliseconds delay) {
+	// Neither libjuice nor libnice signal when the socket is writable again
+	mSendRetryTimer =
+	    ThreadPool::Instance().setTimer(delay, weak_bind(&IceTransport::flushSendQueue, this));
+}
+
+void IceTransport::triggerBufferedAmount(size_t amount) {
+	try {
+		mBufferedAmountCallback(amount);
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "ICE buffered amount callback: " << e.what();
+	}
+}
+
 } // namespace rtc::impl
@@ -14,31 +14,42 @@
 #include "configuration.hpp"
 #include "description.hpp"
 #include "global.hpp"
+#include "impairment.hpp"
 #include "peerconnection.hpp"
+#include "sendqueue.hpp"
+#include "threadpool.hpp"
 #include "transport.hpp"
 
 #if !USE_NICE
 #include <juice/juice.h>
 #else
+#include "socket.hpp"
+
 #include <nice/agent.h>
 #endif
 
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <mutex>
 #include <thread>
 
 namespace rtc::impl {
 
-class IceTransport : public Transport {
+class IceTransport : public Transport, public std::enable_shared_from_this<IceTransport> {
 public:
-	static void Init();
+	static void Init(unsigned int mainLoopsCount = 1); // the count is only used with libnice
 	static void Cleanup();
 
 	enum class GatheringState { New = 0, InProgress = 1, Complete = 2 };
 
 	using candidate_callback = std::function<void(const Candidate &candidate)>;
 	using gathering_state_callback = std::function<void(GatheringState state)>;
+	using amount_callback = std::function<void(size_t amount)>;
+
+	// Packets which would block because the socket buffer is full are queued up to this amount
+	// and sent again as soon as possible, so senders can back off instead of losing them
+	static constexpr size_t MaxBufferedAmount = 256 * 1024;
 
 	IceTransport(const Configuration &config, candidate_callback candidateCallback,
 	             state_callback stateChangeCallback,
@@ -50,6 +61,7 @@ public:
 	Description getLocalDescription(Description::Type type) const;
 	void setRemoteDescription(const Description &description);
 	bool addRemoteCandidate(const Candidate &candidate);
+	size_t addRemoteCandidates(const std::vector<Candidate> &candidates); // returns count added
 	void gatherLocalCandidates(string mid, std::vector<IceServer> additionalIceServers = {});
 	void setIceAttributes(string uFrag, string pwd);
 
@@ -57,11 +69,33 @@ public:
 	optional<string> getRemoteAddress() const;
 
 	bool send(message_ptr message) override; // false if dropped
+	bool sendBatch(message_vector messages) override; // false if any message is dropped
+
+	size_t bufferedAmount() const; // total size of packets waiting for the socket
+	void onBufferedAmount(amount_callback callback); // called without lock on change
 
 	bool getSelectedCandidatePair(Candidate *local, Candidate *remote);
+	IceTransportStats iceStats();
 
 private:
-	bool outgoing(message_ptr message) override;
+	using SendResult = SendQueue::Result;
+
+	bool outgoing(message_ptr message) override; // queues the message if it would block
+	SendResult trySend(const message_ptr &message);
+#if USE_NICE
+	bool trySendBatch(message_vector &messages, message_vector &blocked); // see SendQueue
+#endif
+
+	void flushSendQueue();
+	void scheduleSendRetry(std::chrono::milliseconds delay); // called with the queue locked
+	void triggerBufferedAmount(size_t amount);
+
+	synchronized_callback<size_t> mBufferedAmountCallback;
+	Timer mSendRetryTimer; // protected by the lock of mSendQueue
+	SendQueue mSendQueue{MaxBufferedAmount,
+	                     [this](const message_ptr &message) { return trySend(message); },
+	                     [this](std::chrono::milliseconds delay) { scheduleSendRetry(delay); },
+	                     [this](size_t amount) { triggerBufferedAmount(amount); }};
 
 	void changeGatheringState(GatheringState state);
 
@@ -80,9 +114,25 @@ private:
 	candidate_callback mCandidateCallback;
 	gathering_state_callback mGatheringStateChangeCallback;
 
+	unsigned int mMaxTurnAllocations;
+	std::atomic<unsigned int> mTurnAllocations = 0;
+
+	shared_ptr<Impairment> mImpairment; // for testing only
+
 #if !USE_NICE
 	unique_ptr<juice_agent_t, void (*)(juice_agent_t *)> mAgent;
-	int mTurnServersAdded = 0;
+	optional<uint16_t> mPooledPort;
+
+	// Kept to recreate the agent with the port range if the pooled port was taken
+	void recreateAgentWithoutPooledPort();
+	juice_config_t mJuiceConfig = {};
+	string mStunNode;
+	optional<string> mBindAddress;
+	std::pair<uint16_t, uint16_t> mPortRange = {0, 0};
+	bool mIceTcp = false;
+	std::vector<IceServer> mTurnServers;
+	optional<string> mRemoteSdp;
+	std::vector<string> mRemoteCandidates;
 
 	static void StateChangeCallback(juice_agent_t *agent, juice_state_t state, void *user_ptr);
 	static void CandidateCallback(juice_agent_t *agent, const char *sdp, void *user_ptr);
@@ -90,23 +140,55 @@ private:
 	static void RecvCallback(juice_agent_t *agent, const char *data, size_t size, void *user_ptr);
 	static void LogCallback(juice_log_level_t level, const char *message);
 #else
+	// Main loop running its own context on a dedicated thread
 	class MainLoopWrapper {
 	public:
-		MainLoopWrapper();
+		MainLoopWrapper(string threadName);
 		~MainLoopWrapper();
-		GMainLoop *get() const;
+		GMainContext *context() const;
 
 	private:
+		unique_ptr<GMainContext, void (*)(GMainContext *)> mContext;
 		unique_ptr<GMainLoop, void (*)(GMainLoop *)> mMainLoop;
 		std::thread mThread;
 	};
-	static MainLoopWrapper *MainLoop;
+	// Agents are spread over the main loops in turn
+	static std::vector<unique_ptr<MainLoopWrapper>> MainLoops;
+	static std::atomic<size_t> NextMainLoop;
+
+	GMainContext *mMainContext = nullptr; // of the main loop running the agent
+	GSource *mTimeoutSource = nullptr;    // attached to mMainContext, protected by mTimeoutMutex
+	std::mutex mTimeoutMutex;             // state changes run on the thread of the main loop
+	void setTimeout(std::chrono::milliseconds timeout);
+	void cancelTimeout();
 
 	unique_ptr<NiceAgent, void (*)(NiceAgent *)> mNiceAgent;
 	uint32_t mStreamId = 0;
-	guint mTimeoutId = 0;
 	std::mutex mOutgoingMutex;
-	unsigned int mOutgoingDscp;
+	int mOutgoingDs; // DS field, DSCP and ECN
+
+	// With UDP segmentation offload, runs of equal-sized packets are sent on the selected socket
+	// directly in a single datagram burst, it gets disabled if the device doesn't support it
+	static constexpr size_t MaxSegmentsCount = 64;    // UDP_MAX_SEGMENTS on Linux
+	static constexpr size_t MaxSegmentedSize = 65000; // below the max UDP payload size
+	bool sendSegmented(message_vector::const_iterator begin, message_vector::const_iterator end);
+	bool mSegmentationOffload = false; // protected by mOutgoingMutex
+
+	// Once a direct UDP pair is selected, packets are sent on its socket without going through
+	// the agent. The pinned path is dropped on selected pair or state change.
+	struct FastPath {
+		GSocket *socket;
+		struct sockaddr_storage addr;
+		socklen_t addrlen;
+	};
+	// The following require mOutgoingMutex to be locked
+	const FastPath *fastPath();
+	void unpinFastPath();
+	SendResult sendFastPath(const message_ptr &message); // Failed means through the agent
+
+	optional<FastPath> mFastPath;         // protected by mOutgoingMutex
+	bool mFastPathChecked = false;        // protected by mOutgoingMutex
+	std::atomic<bool> mFastPathStale = false;
 
 	static string AddressToString(const NiceAddress &addr);
 
@@ -114,6 +196,9 @@ private:
 	static void GatheringDoneCallback(NiceAgent *agent, guint streamId, gpointer userData);
 	static void StateChangeCallback(NiceAgent *agent, guint streamId, guint componentId,
 	                                guint state, gpointer userData);
+	static void SelectedPairCallback(NiceAgent *agent, guint streamId, guint componentId,
+	                                 gchar *localFoundation, gchar *remoteFoundation,
+	                                 gpointer userData);
 	static void RecvCallback(NiceAgent *agent, guint stream_id, guint component_id, guint len,
 	                         gchar *buf, gpointer userData);
 	static gboolean TimeoutCallback(gpointer userData);
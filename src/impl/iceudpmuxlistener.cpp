@@ -15,8 +15,8 @@ namespace rtc::impl {
 #if !USE_NICE
 void IceUdpMuxListener::UnhandledStunRequestCallback(const juice_mux_binding_request *info,
                                                      void *user_ptr) {
-	auto listener = static_cast<IceUdpMuxListener *>(user_ptr);
-	if (!listener)
+	auto shard = static_cast<Shard *>(user_ptr);
+	if (!shard)
 		return;
 
 	IceUdpMuxRequest request;
@@ -24,18 +24,34 @@ void IceUdpMuxListener::UnhandledStunRequestCallback(const juice_mux_binding_req
 	request.remoteUfrag = info->remote_ufrag;
 	request.remoteAddress = info->address;
 	request.remotePort = info->port;
-	listener->unhandledStunRequestCallback(std::move(request));
+	request.localPort = shard->port;
+	shard->listener->unhandledStunRequestCallback(std::move(request));
 }
 #endif
 
-IceUdpMuxListener::IceUdpMuxListener(uint16_t port, [[maybe_unused]] optional<string> bindAddress) : port(port) {
+IceUdpMuxListener::IceUdpMuxListener(uint16_t port, [[maybe_unused]] optional<string> bindAddress,
+                                     unsigned int shards)
+    : port(port) {
 	PLOG_VERBOSE << "Creating IceUdpMuxListener";
 
+	if (shards == 0 || size_t(port) + shards - 1 > 65535)
+		throw std::invalid_argument("Invalid ICE UDP mux shards count");
+
+	for (unsigned int i = 0; i < shards; ++i)
+		mShards.emplace_back(std::make_unique<Shard>(Shard{this, uint16_t(port + i)}));
+
 #if !USE_NICE
-	PLOG_DEBUG << "Registering ICE UDP mux listener for port " << port;
-	if (juice_mux_listen(bindAddress ? bindAddress->c_str() : NULL, port,
-	                     IceUdpMuxListener::UnhandledStunRequestCallback, this) < 0) {
-		throw std::runtime_error("Failed to register ICE UDP mux listener");
+	for (size_t i = 0; i < mShards.size(); ++i) {
+		auto shard = mShards[i].get();
+		PLOG_DEBUG << "Registering ICE UDP mux listener for port " << shard->port;
+		if (juice_mux_listen(bindAddress ? bindAddress->c_str() : NULL, shard->port,
+		                     IceUdpMuxListener::UnhandledStunRequestCallback, shard) < 0) {
+			// Unregister the shards already registered
+			for (size_t j = 0; j < i; ++j)
+				juice_mux_listen(NULL, mShards[j]->port, NULL, NULL);
+
+			throw std::runtime_error("Failed to register ICE UDP mux listener");
+		}
 	}
 #else
 	PLOG_WARNING << "ICE UDP mux is not available with libnice";
@@ -52,9 +68,11 @@ void IceUdpMuxListener::stop() {
 		return;
 
 #if !USE_NICE
-	PLOG_DEBUG << "Unregistering ICE UDP mux listener for port " << port;
-	if (juice_mux_listen(NULL, port, NULL, NULL) < 0) {
-		PLOG_ERROR << "Failed to unregister ICE UDP mux listener";
+	for (const auto &shard : mShards) {
+		PLOG_DEBUG << "Unregistering ICE UDP mux listener for port " << shard->port;
+		if (juice_mux_listen(NULL, shard->port, NULL, NULL) < 0) {
+			PLOG_ERROR << "Failed to unregister ICE UDP mux listener";
+		}
 	}
 #endif
 }
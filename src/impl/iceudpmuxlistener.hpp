@@ -19,11 +19,14 @@
 #endif
 
 #include <atomic>
+#include <memory>
+#include <vector>
 
 namespace rtc::impl {
 
 struct IceUdpMuxListener final {
-	IceUdpMuxListener(uint16_t port, optional<string> bindAddress = nullopt);
+	IceUdpMuxListener(uint16_t port, optional<string> bindAddress = nullopt,
+	                  unsigned int shards = 1);
 	~IceUdpMuxListener();
 
 	void stop();
@@ -32,11 +35,18 @@ struct IceUdpMuxListener final {
 	synchronized_callback<IceUdpMuxRequest> unhandledStunRequestCallback;
 
 private:
+	// Each shard is a separate mux socket on its own port, received on its own thread by libjuice
+	struct Shard {
+		IceUdpMuxListener *listener;
+		uint16_t port;
+	};
+
 #if !USE_NICE
 	static void UnhandledStunRequestCallback(const juice_mux_binding_request *info, void *user_ptr);
 #endif
 
-	std::atomic<bool> mStopped;
+	std::vector<std::unique_ptr<Shard>> mShards;
+	std::atomic<bool> mStopped = false;
 };
 
 }
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "impairment.hpp"
+#include "internals.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+Impairment::Impairment(NetworkImpairment settings, send_func send)
+    : mSettings(std::move(settings)), mSend(std::move(send)), mGenerator(mSettings.seed),
+      mLinkFreeTime(clock::now()) {
+	PLOG_WARNING << "Network impairment enabled, loss=" << mSettings.lossRate
+	             << ", delay=" << mSettings.delay.count()
+	             << "ms, jitter=" << mSettings.jitter.count()
+	             << "ms, bitrate=" << mSettings.bitrate.value_or(0);
+}
+
+Impairment::~Impairment() { stop(); }
+
+bool Impairment::send(message_ptr message) {
+	const auto now = clock::now();
+	clock::time_point time;
+	bool duplicate = false;
+	{
+		std::lock_guard lock(mMutex);
+		if (mStopped)
+			return false;
+
+		// Like on a real network, dropped packets are not reported to the sender
+		if (draw(mSettings.lossRate))
+			return true;
+
+		time = now;
+		if (mSettings.bitrate && *mSettings.bitrate > 0) {
+			using std::chrono::duration_cast;
+			const double rate = double(*mSettings.bitrate) / 8; // bytes per second
+			const auto burst = duration_cast<clock::duration>(
+			    std::chrono::duration<double>(double(mSettings.burstSize) / rate));
+			const auto transmission = duration_cast<clock::duration>(
+			    std::chrono::duration<double>(double(message->size()) / rate));
+
+			// The link may lag behind by the burst duration, which is the credit of the bucket
+			const auto linkFreeTime = std::max(mLinkFreeTime, now - burst) + transmission;
+			if (linkFreeTime - now > mSettings.maxQueueDelay)
+				return true; // queue overflow
+
+			mLinkFreeTime = linkFreeTime;
+			time = std::max(now, linkFreeTime);
+		}
+
+		if (!draw(mSettings.reorderRate)) {
+			time += mSettings.delay;
+			if (mSettings.jitter > std::chrono::milliseconds::zero()) {
+				std::uniform_int_distribution<clock::rep> dist(
+				    0, std::chrono::duration_cast<clock::duration>(mSettings.jitter).count());
+				time += clock::duration(dist(mGenerator));
+			}
+		}
+
+		duplicate = draw(mSettings.duplicateRate);
+	}
+
+	if (duplicate)
+		sendAt(time, std::make_shared<Message>(*message));
+
+	sendAt(time, std::move(message));
+	return true;
+}
+
+void Impairment::stop() {
+	std::lock_guard lock(mMutex);
+	mStopped = true;
+}
+
+bool Impairment::draw(double probability) {
+	if (probability <= 0.)
+		return false;
+
+	return std::uniform_real_distribution<double>(0., 1.)(mGenerator) < probability;
+}
+
+void Impairment::sendAt(clock::time_point time, message_ptr message) {
+	auto task = [weak_this = weak_from_this(), message = std::move(message)]() {
+		if (auto locked = weak_this.lock()) {
+			// Holding the mutex while sending guarantees stop() waits for pending sends
+			std::lock_guard lock(locked->mMutex);
+			if (!locked->mStopped)
+				locked->mSend(message);
+		}
+	};
+
+	if (time <= clock::now())
+		task();
+	else
+		ThreadPool::Instance().setTimer(time, std::move(task));
+}
+
+} // namespace rtc::impl
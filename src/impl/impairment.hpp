@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_IMPAIRMENT_H
+#define RTC_IMPL_IMPAIRMENT_H
+
+#include "common.hpp"
+#include "configuration.hpp" // for NetworkImpairment
+#include "message.hpp"
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <random>
+
+namespace rtc::impl {
+
+// Emulates an impaired network path in front of a send function: packets are dropped, duplicated,
+// delayed, and reordered at random, and the bandwidth is limited by a token bucket. Delayed
+// packets are sent from the thread pool. For testing and benchmarking only.
+class Impairment final : public std::enable_shared_from_this<Impairment> {
+public:
+	using clock = std::chrono::steady_clock;
+	using send_func = std::function<bool(message_ptr message)>;
+
+	Impairment(NetworkImpairment settings, send_func send);
+	~Impairment();
+
+	Impairment(const Impairment &) = delete;
+	Impairment &operator=(const Impairment &) = delete;
+
+	bool send(message_ptr message); // false if stopped
+	void stop(); // pending packets are dropped and send is never called after it returns
+
+private:
+	bool draw(double probability); // requires mMutex to be locked
+	void sendAt(clock::time_point time, message_ptr message);
+
+	const NetworkImpairment mSettings;
+	const send_func mSend;
+
+	std::mutex mMutex;
+	std::mt19937 mGenerator;
+	clock::time_point mLinkFreeTime; // when the emulated link finishes sending queued packets
+	bool mStopped = false;
+};
+
+} // namespace rtc::impl
+
+#endif
@@ -8,10 +8,15 @@
 
 #include "init.hpp"
 #include "certificate.hpp"
+#include "certificatepool.hpp"
 #include "dtlstransport.hpp"
+#include "executor.hpp"
+#include "iceportpool.hpp"
 #include "icetransport.hpp"
 #include "internals.hpp"
+#include "messagepool.hpp"
 #include "pollservice.hpp"
+#include "processor.hpp"
 #include "sctptransport.hpp"
 #include "threadpool.hpp"
 #include "tls.hpp"
@@ -33,6 +38,23 @@
 
 namespace rtc::impl {
 
+namespace {
+
+std::vector<unsigned int> ResolveCpus(const std::vector<unsigned int> &cpus,
+                                      optional<unsigned int> numaNode) {
+	if (!cpus.empty() || !numaNode)
+		return cpus;
+
+	auto nodeCpus = utils::numa_node_cpus(*numaNode);
+	if (nodeCpus.empty()) {
+		PLOG_WARNING << "No CPUs found for NUMA node " << *numaNode << ", ignoring placement";
+	}
+
+	return nodeCpus;
+}
+
+} // namespace
+
 struct Init::TokenPayload {
 	TokenPayload(std::shared_future<void> *cleanupFuture) {
 		Init::Instance().doInit();
@@ -83,14 +105,39 @@ init_token Init::token() {
 }
 
 void Init::preload() {
-	std::lock_guard lock(mMutex);
-	if (!mGlobal) {
-		mGlobal = std::make_shared<TokenPayload>(&mCleanupFuture);
-		mWeak = *mGlobal;
+	{
+		std::lock_guard lock(mMutex);
+		if (!mGlobal) {
+			mGlobal = std::make_shared<TokenPayload>(&mCleanupFuture);
+			mWeak = *mGlobal;
+		}
+	}
+
+	// Pooled certificates hold tokens, so the pool is only filled while preloaded
+	CertificatePool::Instance().start();
+	IcePortPool::Instance().start();
+
+	// Warm the subsystems in parallel, on dedicated threads since the thread pool might be
+	// driven by an external loop
+	const std::array<Subsystem, SubsystemsCount> subsystems = {
+	    Subsystem::Sctp, Subsystem::Dtls, Subsystem::Srtp, Subsystem::Tls, Subsystem::Ice};
+	std::vector<std::future<void>> futures;
+	for (auto subsystem : subsystems)
+		futures.push_back(
+		    std::async(std::launch::async, [this, subsystem]() { initSubsystem(subsystem); }));
+
+	for (auto &future : futures) {
+		try {
+			future.get();
+		} catch (const std::exception &e) {
+			PLOG_WARNING << "Preload failed: " << e.what(); // retried on first use
+		}
 	}
 }
 
 std::shared_future<void> Init::cleanup() {
+	CertificatePool::Instance().stop(); // release the tokens held by pooled certificates
+	IcePortPool::Instance().stop();
 	std::lock_guard lock(mMutex);
 	mGlobal.reset();
 	return mCleanupFuture;
@@ -102,9 +149,28 @@ void Init::setThreadPoolSize(unsigned int count) {
 
 }
 
+void Init::setPollServiceSize(unsigned int count) {
+	std::lock_guard lock(mMutex);
+	mPollServiceSize = count;
+}
+
+void Init::setIceThreadCount(unsigned int count) {
+	std::lock_guard lock(mMutex);
+	mIceThreadCount = count;
+}
+
+void Init::setThreadPoolSettings(ThreadPoolSettings s) {
+	std::lock_guard lock(mMutex);
+	Processor::SetBatchSettings(s.processorBatchSize, s.processorTimeBudget);
+	DtlsTransport::SetMaxPendingHandshakes(s.maxPendingHandshakes);
+	ExecutorPool::Instance().setSettings(s.executorCount, s.pinExecutors,
+	                                     ResolveCpus(s.executorCpus, s.executorNumaNode));
+	mThreadPoolSettings = std::move(s); // store for next init
+}
+
 void Init::setSctpSettings(SctpSettings s) {
 	std::lock_guard lock(mMutex);
-	if (mGlobal)
+	if (isInitialized(Subsystem::Sctp))
 		SctpTransport::SetSettings(s);
 
 	mCurrentSctpSettings = std::move(s); // store for next init
@@ -124,13 +190,34 @@ void Init::doInit() {
 		throw std::runtime_error("WSAStartup failed, error=" + std::to_string(WSAGetLastError()));
 #endif
 
-	unsigned int count = mThreadPoolSize > 0 ? mThreadPoolSize : std::thread::hardware_concurrency();
+	auto workerCpus =
+	    ResolveCpus(mThreadPoolSettings.workerCpus, mThreadPoolSettings.workerNumaNode);
+	unsigned int count = mThreadPoolSize > 0   ? mThreadPoolSize
+	                     : !workerCpus.empty() ? unsigned(workerCpus.size())
+	                                           : std::thread::hardware_concurrency();
 	count = std::max(count, MIN_THREADPOOL_SIZE);
-	PLOG_DEBUG << "Spawning " << count << " threads";
-	ThreadPool::Instance().spawn(count);
+	const bool external = mThreadPoolSettings.externalLoop;
+	ThreadPool::Instance().setWorkStealing(mThreadPoolSettings.workStealing && !external);
+	ThreadPool::Instance().setExternal(external);
+	ThreadPool::Instance().setAffinity(std::move(workerCpus));
+	if (external) {
+		PLOG_DEBUG << "Using an external event loop, no thread pool workers";
+	} else {
+		PLOG_DEBUG << "Spawning " << count << " threads";
+		ThreadPool::Instance().spawn(count);
+
+		const unsigned int controlCount = mThreadPoolSettings.controlThreadCount.value_or(
+		    std::max(std::thread::hardware_concurrency() / 4, 1u));
+		PLOG_DEBUG << "Spawning " << controlCount << " control-plane threads";
+		ThreadPool::ControlInstance().setLowPriority(true);
+		ThreadPool::ControlInstance().spawn(int(controlCount));
+	}
 
 #if RTC_ENABLE_WEBSOCKET
-	PollService::Instance().start();
+	unsigned int pollCount =
+	    mPollServiceSize > 0 ? mPollServiceSize : std::max(std::thread::hardware_concurrency(), 1u);
+	PLOG_DEBUG << "Spawning " << pollCount << " poll threads";
+	PollService::Instance().start(pollCount);
 #endif
 
 #if USE_GNUTLS
@@ -141,16 +228,92 @@ void Init::doInit() {
 	openssl::init();
 #endif
 
-	SctpTransport::Init();
-	SctpTransport::SetSettings(mCurrentSctpSettings);
-	DtlsTransport::Init();
+	// Other subsystems are initialized on first use
+}
+
+void Init::initSubsystem(Subsystem subsystem) {
+	std::unique_lock lock(mSubsystemsMutex);
+	auto &state = mSubsystems[size_t(subsystem)];
+	mSubsystemsCondition.wait(lock, [&state]() { return state != SubsystemState::Initializing; });
+	if (state == SubsystemState::Initialized)
+		return;
+
+	state = SubsystemState::Initializing;
+	lock.unlock();
+
+	try {
+		doInitSubsystem(subsystem);
+
+	} catch (...) {
+		lock.lock();
+		state = SubsystemState::Uninitialized;
+		mSubsystemsCondition.notify_all();
+		throw;
+	}
+
+	lock.lock();
+	state = SubsystemState::Initialized;
+	mSubsystemsCondition.notify_all();
+}
+
+void Init::doInitSubsystem(Subsystem subsystem) {
+	switch (subsystem) {
+	case Subsystem::Sctp: {
+		// Hold mMutex so that settings changed concurrently are not missed
+		std::lock_guard lock(mMutex);
+		PLOG_DEBUG << "SCTP initialization";
+		SctpTransport::Init(mCurrentSctpSettings);
+		SctpTransport::SetSettings(mCurrentSctpSettings);
+		break;
+	}
+	case Subsystem::Dtls:
+		PLOG_DEBUG << "DTLS initialization";
+		DtlsTransport::Init();
+		break;
+	case Subsystem::Srtp:
+#if RTC_ENABLE_MEDIA
+		PLOG_DEBUG << "SRTP initialization";
+		DtlsSrtpTransport::Init();
+#endif
+		break;
+	case Subsystem::Tls:
 #if RTC_ENABLE_WEBSOCKET
-	TlsTransport::Init();
+		PLOG_DEBUG << "TLS initialization";
+		TlsTransport::Init();
+#endif
+		break;
+	case Subsystem::Ice: {
+		std::lock_guard lock(mMutex);
+		PLOG_DEBUG << "ICE initialization";
+		IceTransport::Init(mIceThreadCount);
+		break;
+	}
+	}
+}
+
+bool Init::isInitialized(Subsystem subsystem) const {
+	std::lock_guard lock(mSubsystemsMutex);
+	return mSubsystems[size_t(subsystem)] == SubsystemState::Initialized;
+}
+
+void Init::doCleanupSubsystems() {
+	// Requires mMutex to be locked, no token is held so no subsystem is initializing
+	std::lock_guard lock(mSubsystemsMutex);
+	auto cleanup = [this](Subsystem subsystem, void (*func)()) {
+		auto &state = mSubsystems[size_t(subsystem)];
+		if (std::exchange(state, SubsystemState::Uninitialized) == SubsystemState::Initialized)
+			func();
+	};
+
+	cleanup(Subsystem::Sctp, &SctpTransport::Cleanup);
+	cleanup(Subsystem::Dtls, &DtlsTransport::Cleanup);
+#if RTC_ENABLE_WEBSOCKET
+	cleanup(Subsystem::Tls, &TlsTransport::Cleanup);
 #endif
 #if RTC_ENABLE_MEDIA
-	DtlsSrtpTransport::Init();
+	cleanup(Subsystem::Srtp, &DtlsSrtpTransport::Cleanup);
 #endif
-	IceTransport::Init();
+	cleanup(Subsystem::Ice, &IceTransport::Cleanup);
 }
 
 void Init::doCleanup() {
@@ -163,21 +326,19 @@ void Init::doCleanup() {
 
 	PLOG_DEBUG << "Global cleanup";
 
+	TearDownProcessor::Instance().join();
+	ExecutorPool::Instance().join();
+	ThreadPool::ControlInstance().join();
 	ThreadPool::Instance().join();
+	ThreadPool::ControlInstance().clear();
 	ThreadPool::Instance().clear();
 #if RTC_ENABLE_WEBSOCKET
 	PollService::Instance().join();
 #endif
 
-	SctpTransport::Cleanup();
-	DtlsTransport::Cleanup();
-#if RTC_ENABLE_WEBSOCKET
-	TlsTransport::Cleanup();
-#endif
-#if RTC_ENABLE_MEDIA
-	DtlsSrtpTransport::Cleanup();
-#endif
-	IceTransport::Cleanup();
+	doCleanupSubsystems();
+
+	MessagePool::Instance().clear();
 
 #ifdef _WIN32
 	WSACleanup();
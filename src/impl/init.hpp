@@ -10,9 +10,11 @@
 #define RTC_IMPL_INIT_H
 
 #include "common.hpp"
-#include "global.hpp" // for SctpSettings
+#include "global.hpp" // for SctpSettings and ThreadPoolSettings
 
+#include <array>
 #include <chrono>
+#include <condition_variable>
 #include <future>
 #include <mutex>
 
@@ -22,6 +24,9 @@ using init_token = shared_ptr<void>;
 
 class Init {
 public:
+	// Subsystems are initialized on first use, so that processes pay only for the features they use
+	enum class Subsystem { Sctp = 0, Dtls, Srtp, Tls, Ice };
+
 	static Init &Instance();
 
 	Init(const Init &) = delete;
@@ -34,23 +39,42 @@ public:
 	std::shared_future<void> cleanup();
 
 	void setThreadPoolSize(unsigned int count);
+	void setPollServiceSize(unsigned int count);
+	void setIceThreadCount(unsigned int count);
+	void setThreadPoolSettings(ThreadPoolSettings s);
 	void setSctpSettings(SctpSettings s);
 
+	// Blocks until the subsystem is initialized, the caller must hold a token
+	void initSubsystem(Subsystem subsystem);
+
 private:
+	enum class SubsystemState { Uninitialized, Initializing, Initialized };
+	static constexpr size_t SubsystemsCount = 5;
+
 	Init();
 	~Init();
 
 	void doInit();
 	void doCleanup();
+	void doInitSubsystem(Subsystem subsystem);
+	void doCleanupSubsystems(); // requires mMutex to be locked
+	bool isInitialized(Subsystem subsystem) const;
 
 	std::optional<shared_ptr<void>> mGlobal;
 	weak_ptr<void> mWeak;
 	bool mInitialized = false;
 	SctpSettings mCurrentSctpSettings = {};
 	unsigned int mThreadPoolSize = 0;
+	unsigned int mPollServiceSize = 0;
+	unsigned int mIceThreadCount = 1;
+	ThreadPoolSettings mThreadPoolSettings = {};
 	std::mutex mMutex;
 	std::shared_future<void> mCleanupFuture;
 
+	std::array<SubsystemState, SubsystemsCount> mSubsystems = {};
+	mutable std::mutex mSubsystemsMutex; // locked after mMutex if both are
+	std::condition_variable mSubsystemsCondition;
+
 	struct TokenPayload;
 };
 
@@ -27,6 +27,38 @@
 #pragma warning(pop)
 #endif
 
+// Log statements below RTC_MIN_LOG_LEVEL are compiled out, the condition being a constant, so that
+// their arguments are never evaluated on hot paths. Levels match plog severity, 6 is verbose.
+#ifndef RTC_MIN_LOG_LEVEL
+#define RTC_MIN_LOG_LEVEL 6
+#endif
+
+#define RTC_LOG_COMPILED(severity) (int(severity) <= RTC_MIN_LOG_LEVEL)
+
+#define RTC_PLOG(severity)                                                                         \
+	if (!RTC_LOG_COMPILED(severity)) {                                                             \
+		;                                                                                          \
+	} else                                                                                         \
+		PLOG(severity)
+
+#undef IF_PLOG
+#define IF_PLOG(severity)                                                                          \
+	if (!RTC_LOG_COMPILED(severity)) {                                                             \
+		;                                                                                          \
+	} else                                                                                         \
+		IF_PLOG_(PLOG_DEFAULT_INSTANCE_ID, severity)
+
+#undef PLOG_VERBOSE
+#undef PLOG_DEBUG
+#undef PLOG_INFO
+#undef PLOG_WARNING
+#undef PLOG_ERROR
+#define PLOG_VERBOSE RTC_PLOG(plog::verbose)
+#define PLOG_DEBUG RTC_PLOG(plog::debug)
+#define PLOG_INFO RTC_PLOG(plog::info)
+#define PLOG_WARNING RTC_PLOG(plog::warning)
+#define PLOG_ERROR RTC_PLOG(plog::error)
+
 namespace rtc {
 
 const size_t MAX_NUMERICNODE_LEN = 48; // Max IPv6 string representation length
@@ -38,10 +70,18 @@ const uint16_t MAX_SCTP_STREAMS_COUNT = 1024; // Max number of negotiated SCTP s
                                               // RFC 8831 recommends 65535 but usrsctp needs a lot
                                               // of memory, Chromium historically limits to 1024.
 
+const uint16_t DEFAULT_DATA_CHANNEL_PRIORITY = 256; // RFC 8832 "normal" priority
+
+const size_t DEFAULT_BUFFERED_AMOUNT_HIGH_THRESHOLD = 1024 * 1024; // Async sends wait above this
+
+const size_t COALESCING_MAX_MESSAGE_SIZE = 256; // Max size of a message to coalesce
+const size_t COALESCING_TARGET_SIZE = 1100;     // Coalesced messages are sent at this size
+
 const size_t DEFAULT_LOCAL_MAX_MESSAGE_SIZE = 256 * 1024; // Default local max message size
 const size_t DEFAULT_REMOTE_MAX_MESSAGE_SIZE = 65536;     // Remote max message size if not in SDP
 
 const size_t DEFAULT_WS_MAX_MESSAGE_SIZE = 256 * 1024;   // Default max message size for WebSockets
+const size_t DEFAULT_WS_COMPRESSION_THRESHOLD = 256;     // Min message size to compress
 
 const size_t RECV_QUEUE_LIMIT = 1024; // Max per-channel queue size (messages)
 
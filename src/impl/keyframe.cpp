@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "keyframe.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace rtc::impl {
+
+namespace {
+
+uint16_t read16(const byte *p) {
+	return uint16_t(std::to_integer<uint16_t>(p[0]) << 8 | std::to_integer<uint16_t>(p[1]));
+}
+
+uint8_t at(const byte *p, size_t i) { return std::to_integer<uint8_t>(p[i]); }
+
+bool isH264Keyframe(uint8_t type) { return type == 5 || type == 7; } // IDR or SPS
+
+bool isH265Keyframe(uint8_t type) {
+	return (type >= 16 && type <= 21) || (type >= 32 && type <= 34); // IRAP or parameter sets
+}
+
+// Returns true if the aggregation packet contains a NAL unit for which pred is true
+template <typename Pred>
+bool anyAggregated(const byte *payload, size_t size, size_t offset, Pred pred) {
+	while (offset + 2 < size) {
+		const size_t length = read16(payload + offset);
+		offset += 2;
+		if (length == 0 || offset + length > size)
+			break;
+
+		if (pred(payload + offset))
+			return true;
+
+		offset += length;
+	}
+	return false;
+}
+
+} // namespace
+
+VideoCodec video_codec_from_format(string format) {
+	std::transform(format.begin(), format.end(), format.begin(),
+	               [](unsigned char c) { return char(std::toupper(c)); });
+
+	if (format == "H264")
+		return VideoCodec::H264;
+	else if (format == "H265")
+		return VideoCodec::H265;
+	else if (format == "VP8")
+		return VideoCodec::VP8;
+	else if (format == "VP9")
+		return VideoCodec::VP9;
+	else if (format == "AV1")
+		return VideoCodec::AV1;
+	else
+		return VideoCodec::Unknown;
+}
+
+bool is_keyframe_start(VideoCodec codec, const Message &message, const RtpHeader &rtp) {
+	if (codec == VideoCodec::Unknown)
+		return false;
+
+	const size_t headerSize = rtp.getSize() + rtp.getExtensionHeaderSize();
+	const size_t paddingSize = rtp.padding() ? std::to_integer<uint8_t>(message.back()) : 0;
+	if (headerSize + paddingSize >= message.size())
+		return false;
+
+	const byte *payload = message.data() + headerSize;
+	const size_t size = message.size() - headerSize - paddingSize;
+	switch (codec) {
+	case VideoCodec::H264: {
+		// RFC 6184 5.7.1. STAP-A and 5.8. FU-A
+		const uint8_t type = at(payload, 0) & 0x1F;
+		if (type == 24)
+			return anyAggregated(payload, size, 1, [](const byte *nalu) {
+				return isH264Keyframe(at(nalu, 0) & 0x1F);
+			});
+		if (type == 28)
+			return size >= 2 && (at(payload, 1) & 0x80) && isH264Keyframe(at(payload, 1) & 0x1F);
+
+		return isH264Keyframe(type);
+	}
+	case VideoCodec::H265: {
+		// RFC 7798 4.4.2. Aggregation Packets and 4.4.3. Fragmentation Units
+		const uint8_t type = (at(payload, 0) >> 1) & 0x3F;
+		if (type == 48)
+			return anyAggregated(payload, size, 2, [](const byte *nalu) {
+				return isH265Keyframe((at(nalu, 0) >> 1) & 0x3F);
+			});
+		if (type == 49)
+			return size >= 3 && (at(payload, 2) & 0x80) && isH265Keyframe(at(payload, 2) & 0x3F);
+
+		return isH265Keyframe(type);
+	}
+	case VideoCodec::VP8: {
+		// RFC 7741 4.2. VP8 Payload Descriptor and 4.3. VP8 Payload Header
+		const uint8_t first = at(payload, 0);
+		if (!(first & 0x10) || (first & 0x07) != 0) // S=1 and PID=0
+			return false;
+
+		size_t offset = 1;
+		if (first & 0x80) { // X
+			if (size < 2)
+				return false;
+
+			const uint8_t extension = at(payload, 1);
+			offset = 2;
+			if (extension & 0x80) // I
+				offset += offset < size && (at(payload, offset) & 0x80) ? 2 : 1;
+			if (extension & 0x40) // L
+				offset += 1;
+			if (extension & 0x30) // T or K
+				offset += 1;
+		}
+		return offset < size && !(at(payload, offset) & 0x01); // P=0
+	}
+	case VideoCodec::VP9: {
+		// RFC 9628 4.2. VP9 Payload Descriptor
+		const uint8_t first = at(payload, 0);
+		if ((first & 0x40) || !(first & 0x08)) // P=0 and B=1
+			return false;
+
+		if (!(first & 0x20)) // L
+			return true;
+
+		size_t offset = 1;
+		if (first & 0x80) // I
+			offset += offset < size && (at(payload, offset) & 0x80) ? 2 : 1;
+
+		return offset < size && ((at(payload, offset) >> 1) & 0x07) == 0; // SID=0
+	}
+	case VideoCodec::AV1:
+		// AV1 RTP Payload Format 4.4. AV1 Aggregation Header
+		return (at(payload, 0) & 0x08) != 0; // N=1
+	default:
+		return false;
+	}
+}
+
+} // namespace rtc::impl
+
+#endif /* RTC_ENABLE_MEDIA */
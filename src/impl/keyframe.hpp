@@ -0,0 +1,32 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_KEYFRAME_H
+#define RTC_IMPL_KEYFRAME_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "common.hpp"
+#include "message.hpp"
+#include "rtp.hpp"
+
+namespace rtc::impl {
+
+enum class VideoCodec { Unknown, H264, H265, VP8, VP9, AV1 };
+
+// Returns the video codec for an RTP map format, Unknown if it is not supported
+VideoCodec video_codec_from_format(string format);
+
+// Returns true if the RTP packet carries the start of a keyframe
+bool is_keyframe_start(VideoCodec codec, const Message &message, const RtpHeader &rtp);
+
+} // namespace rtc::impl
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif
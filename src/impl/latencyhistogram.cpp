@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "latencyhistogram.hpp"
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+LatencyHistogram::Registry &LatencyHistogram::GetRegistry() {
+	// Histograms are static objects in other translation units, so construct on first use
+	static Registry registry;
+	return registry;
+}
+
+std::vector<Histogram> LatencyHistogram::Snapshot() {
+	auto &registry = GetRegistry();
+	std::vector<Histogram> histograms;
+	{
+		std::lock_guard lock(registry.mutex);
+		histograms.reserve(registry.histograms.size());
+		for (const auto *histogram : registry.histograms)
+			histograms.push_back(histogram->snapshot());
+	}
+
+	std::sort(histograms.begin(), histograms.end(),
+	          [](const Histogram &a, const Histogram &b) { return a.name < b.name; });
+	return histograms;
+}
+
+LatencyHistogram::LatencyHistogram(std::string name, std::string description)
+    : mName(std::move(name)), mDescription(std::move(description)) {
+	if constexpr (Enabled) {
+		auto &registry = GetRegistry();
+		std::lock_guard lock(registry.mutex);
+		registry.histograms.push_back(this);
+	}
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t value) {
+	if (value < SubBucketCount)
+		return size_t(value);
+
+	value = std::min(value, (uint64_t(1) << MaxBits) - 1);
+
+	int msb = 0; // index of the most significant bit
+	for (int shift = 32; shift > 0; shift /= 2)
+		if (value >> (msb + shift))
+			msb += shift;
+
+	const int shift = msb - SubBucketBits;
+	const size_t sub = size_t(value >> shift) & (SubBucketCount - 1);
+	return SubBucketCount * size_t(shift + 1) + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+	if (index < SubBucketCount)
+		return uint64_t(index);
+
+	const int shift = int(index / SubBucketCount) - 1;
+	const uint64_t sub = index % SubBucketCount;
+	return ((SubBucketCount + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::recordNanoseconds(int64_t value) {
+	if constexpr (Enabled) {
+		const uint64_t v = uint64_t(std::max(value, int64_t(0)));
+		mBuckets[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+		mCount.fetch_add(1, std::memory_order_relaxed);
+		mSum.fetch_add(v, std::memory_order_relaxed);
+
+		uint64_t max = mMax.load(std::memory_order_relaxed);
+		while (v > max && !mMax.compare_exchange_weak(max, v, std::memory_order_relaxed)) {
+		}
+	}
+}
+
+Histogram LatencyHistogram::snapshot() const {
+	using std::chrono::nanoseconds;
+	Histogram histogram;
+	histogram.name = mName;
+	histogram.description = mDescription;
+
+	// Counters are read independently, so the snapshot is only consistent if recording is idle
+	for (size_t i = 0; i < mBuckets.size(); ++i)
+		if (auto count = mBuckets[i].load(std::memory_order_relaxed))
+			histogram.buckets.emplace_back(nanoseconds(BucketUpperBound(i)), count);
+
+	histogram.count = mCount.load(std::memory_order_relaxed);
+	histogram.sum = nanoseconds(mSum.load(std::memory_order_relaxed));
+	histogram.max = nanoseconds(mMax.load(std::memory_order_relaxed));
+	return histogram;
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_LATENCY_HISTOGRAM_H
+#define RTC_IMPL_LATENCY_HISTOGRAM_H
+
+#include "common.hpp"
+#include "global.hpp" // for Histogram
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#ifndef RTC_LATENCY_HISTOGRAMS
+#define RTC_LATENCY_HISTOGRAMS 0
+#endif
+
+namespace rtc::impl {
+
+// Histogram of durations with logarithmic buckets, like an HDR histogram with 8 sub-buckets per
+// power of two, so values are recorded with a relative error below 12.5%. Recording is lock-free.
+// Histograms are only compiled in with RTC_LATENCY_HISTOGRAMS, otherwise recording is a no-op and
+// timestamps are not even taken.
+class LatencyHistogram final {
+public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr bool Enabled = RTC_LATENCY_HISTOGRAMS != 0;
+
+	static std::vector<Histogram> Snapshot(); // sorted by name
+
+	// Returns a null time point if disabled
+	static clock::time_point Now() {
+		if constexpr (Enabled)
+			return clock::now();
+		else
+			return {};
+	}
+
+	LatencyHistogram(std::string name, std::string description);
+
+	LatencyHistogram(const LatencyHistogram &) = delete;
+	LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+	void record(clock::duration duration) {
+		using std::chrono::nanoseconds;
+		if constexpr (Enabled)
+			recordNanoseconds(std::chrono::duration_cast<nanoseconds>(duration).count());
+	}
+
+	void recordSince(clock::time_point start) {
+		if constexpr (Enabled)
+			record(clock::now() - start);
+	}
+
+private:
+	static constexpr int SubBucketBits = 3;
+	static constexpr int SubBucketCount = 1 << SubBucketBits;
+	static constexpr int MaxBits = 40; // about 18 minutes in nanoseconds, larger values are clamped
+	static constexpr size_t BucketCount = SubBucketCount * (MaxBits - SubBucketBits + 1);
+
+	static size_t BucketIndex(uint64_t value);
+	static uint64_t BucketUpperBound(size_t index);
+
+	struct Registry {
+		std::mutex mutex;
+		std::vector<const LatencyHistogram *> histograms;
+	};
+
+	static Registry &GetRegistry();
+
+	void recordNanoseconds(int64_t value);
+	Histogram snapshot() const;
+
+	const string mName;
+	const string mDescription;
+
+	std::array<std::atomic<uint64_t>, Enabled ? BucketCount : 0> mBuckets = {};
+	std::atomic<uint64_t> mCount = 0;
+	std::atomic<uint64_t> mSum = 0; // nanoseconds
+	std::atomic<uint64_t> mMax = 0; // nanoseconds
+};
+
+// Records the time spent in a scope
+class LatencyScope final {
+public:
+	explicit LatencyScope(LatencyHistogram &histogram)
+	    : mHistogram(histogram), mStart(LatencyHistogram::Now()) {}
+	~LatencyScope() { mHistogram.recordSince(mStart); }
+
+	LatencyScope(const LatencyScope &) = delete;
+	LatencyScope &operator=(const LatencyScope &) = delete;
+
+private:
+	LatencyHistogram &mHistogram;
+	const LatencyHistogram::clock::time_point mStart;
+};
+
+} // namespace rtc::impl
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_LOCKFREE_QUEUE_H
+#define RTC_IMPL_LOCKFREE_QUEUE_H
+
+#include "common.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace rtc::impl {
+
+// Bounded lock-free queue with the same limit and amount semantics as Queue, based on Dmitry
+// Vyukov's bounded MPMC ring. Any number of threads may push. pop() is safe from multiple
+// threads, but peek() and exchange() require a single consumer. Contrary to Queue, push() does not
+// block when the queue is full, it returns false and the element is dropped.
+template <typename T> class LockFreeQueue {
+public:
+	using amount_function = std::function<size_t(const T &element)>;
+
+	LockFreeQueue(size_t limit, // elements (must not be 0)
+	              amount_function func = nullptr);
+	~LockFreeQueue();
+
+	void stop();
+	bool running() const;
+	bool empty() const;
+	bool full() const;
+	size_t size() const;   // elements
+	size_t amount() const; // amount
+	size_t footprint() const; // bytes allocated for the ring
+	bool push(T element);  // false if full or stopped
+	optional<T> pop();
+	optional<T> peek();
+	optional<T> exchange(T element);
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T element;
+	};
+
+	static size_t RoundUpPowerOfTwo(size_t n);
+
+	const size_t mLimit;
+	const size_t mMask;
+	std::vector<Cell> mCells;
+	amount_function mAmountFunction;
+
+	alignas(64) std::atomic<size_t> mEnqueuePos = 0;
+	alignas(64) std::atomic<size_t> mDequeuePos = 0;
+	alignas(64) std::atomic<size_t> mAmount = 0;
+	std::atomic<bool> mStopping = false;
+};
+
+template <typename T>
+LockFreeQueue<T>::LockFreeQueue(size_t limit, amount_function func)
+    : mLimit(limit), mMask(RoundUpPowerOfTwo(limit) - 1), mCells(mMask + 1) {
+	if (limit == 0)
+		throw std::invalid_argument("Lock-free queue must be bounded");
+
+	for (size_t i = 0; i < mCells.size(); ++i)
+		mCells[i].sequence.store(i, std::memory_order_relaxed);
+
+	mAmountFunction = func ? func : []([[maybe_unused]] const T &element) -> size_t { return 1; };
+}
+
+template <typename T> LockFreeQueue<T>::~LockFreeQueue() { stop(); }
+
+template <typename T> void LockFreeQueue<T>::stop() { mStopping = true; }
+
+template <typename T> bool LockFreeQueue<T>::running() const { return !empty() || !mStopping; }
+
+template <typename T> bool LockFreeQueue<T>::empty() const { return size() == 0; }
+
+template <typename T> bool LockFreeQueue<T>::full() const { return size() >= mLimit; }
+
+template <typename T> size_t LockFreeQueue<T>::size() const {
+	size_t dequeuePos = mDequeuePos.load(std::memory_order_acquire);
+	size_t enqueuePos = mEnqueuePos.load(std::memory_order_acquire);
+	return enqueuePos >= dequeuePos ? enqueuePos - dequeuePos : 0;
+}
+
+template <typename T> size_t LockFreeQueue<T>::amount() const { return mAmount.load(); }
+
+template <typename T> size_t LockFreeQueue<T>::footprint() const {
+	return mCells.size() * sizeof(Cell);
+}
+
+template <typename T> bool LockFreeQueue<T>::push(T element) {
+	if (mStopping)
+		return false;
+
+	Cell *cell;
+	size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+	while (true) {
+		if (pos - mDequeuePos.load(std::memory_order_acquire) >= mLimit)
+			return false; // full
+
+		cell = &mCells[pos & mMask];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		auto diff = ptrdiff_t(seq) - ptrdiff_t(pos);
+		if (diff == 0) {
+			if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return false; // full
+		} else {
+			pos = mEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	mAmount += mAmountFunction(element);
+	cell->element = std::move(element);
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T> optional<T> LockFreeQueue<T>::pop() {
+	Cell *cell;
+	size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+	while (true) {
+		cell = &mCells[pos & mMask];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		auto diff = ptrdiff_t(seq) - ptrdiff_t(pos + 1);
+		if (diff == 0) {
+			if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return nullopt; // empty
+		} else {
+			pos = mDequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	optional<T> element{std::move(cell->element)};
+	cell->element = T();
+	cell->sequence.store(pos + mMask + 1, std::memory_order_release);
+	mAmount -= mAmountFunction(*element);
+	return element;
+}
+
+template <typename T> optional<T> LockFreeQueue<T>::peek() {
+	size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+	Cell &cell = mCells[pos & mMask];
+	if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+		return nullopt;
+
+	return std::make_optional(cell.element);
+}
+
+template <typename T> optional<T> LockFreeQueue<T>::exchange(T element) {
+	size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+	Cell &cell = mCells[pos & mMask];
+	if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+		return nullopt;
+
+	mAmount += mAmountFunction(element);
+	mAmount -= mAmountFunction(cell.element);
+	std::swap(cell.element, element);
+	return std::make_optional(std::move(element));
+}
+
+template <typename T> size_t LockFreeQueue<T>::RoundUpPowerOfTwo(size_t n) {
+	size_t p = 1;
+	while (p < n)
+		p <<= 1;
+	return p;
+}
+
+} // namespace rtc::impl
+
+#endif
@@ -8,19 +8,66 @@
 
 #include "logcounter.hpp"
 
+#include <algorithm>
+
 namespace rtc::impl {
 
-LogCounter::LogCounter(plog::Severity severity, const std::string &text,
+namespace {
+
+bool IsLogged(plog::Severity severity) {
+	if (!RTC_LOG_COMPILED(severity))
+		return false;
+
+	auto logger = plog::get();
+	return logger && severity <= logger->getMaxSeverity();
+}
+
+} // namespace
+
+LogCounter::Registry &LogCounter::GetRegistry() {
+	// Counters are static objects in other translation units, so construct on first use
+	static Registry registry;
+	return registry;
+}
+
+std::vector<Metric> LogCounter::Snapshot() {
+	auto &registry = GetRegistry();
+	std::vector<Metric> metrics;
+	{
+		std::lock_guard lock(registry.mutex);
+		metrics.reserve(registry.counters.size());
+		for (const auto &weak : registry.counters)
+			if (auto data = weak.lock())
+				metrics.push_back({data->mName, data->mText,
+				                   data->mTotal.load(std::memory_order_relaxed)});
+	}
+
+	std::sort(metrics.begin(), metrics.end(),
+	          [](const Metric &a, const Metric &b) { return a.name < b.name; });
+	return metrics;
+}
+
+LogCounter::LogCounter(const char *name, plog::Severity severity, const char *text,
                        std::chrono::seconds duration) {
 	mData = std::make_shared<LogData>();
+	mData->mName = name;
 	mData->mDuration = duration;
 	mData->mSeverity = severity;
 	mData->mText = text;
+
+	auto &registry = GetRegistry();
+	std::lock_guard lock(registry.mutex);
+	registry.counters.push_back(mData);
 }
 
 LogCounter &LogCounter::operator++(int) {
-	if (mData->mCount++ == 0) {
-		ThreadPool::Instance().schedule(
+	mData->mTotal.fetch_add(1, std::memory_order_relaxed);
+	if (!IsLogged(mData->mSeverity))
+		return *this;
+
+	// Only the first event of a period schedules the log line
+	if (mData->mCount.fetch_add(1, std::memory_order_relaxed) == 0) {
+		ThreadPool::Instance().setTimer(
 		    mData->mDuration,
 		    [](weak_ptr<LogData> data) {
 			    if (auto ptr = data.lock()) {
@@ -10,27 +10,44 @@
 #define RTC_SERVER_LOGCOUNTER_HPP
 
 #include "common.hpp"
+#include "global.hpp" // for Metric
 #include "threadpool.hpp"
 
 #include <atomic>
 #include <chrono>
+#include <mutex>
+#include <vector>
 
 namespace rtc::impl {
 
+// Counter of events logged periodically, also registered as a metric under a stable name
+// Incrementing is lock-free, the log line is only scheduled if its severity is actually logged.
 class LogCounter {
 private:
 	struct LogData {
+		const char *mName; // static string
 		plog::Severity mSeverity;
-		std::string mText;
+		const char *mText; // static string
 		std::chrono::steady_clock::duration mDuration;
 
-		std::atomic<int> mCount = 0;
+		std::atomic<int> mCount = 0;      // since the last log line
+		std::atomic<uint64_t> mTotal = 0; // since startup, for metrics
 	};
 
+	struct Registry {
+		std::mutex mutex;
+		std::vector<weak_ptr<LogData>> counters;
+	};
+
+	static Registry &GetRegistry();
+
 	shared_ptr<LogData> mData;
 
 public:
-	LogCounter(plog::Severity severity, const std::string &text,
+	static std::vector<Metric> Snapshot(); // sorted by name
+
+	// name and text must be string literals, they are not copied
+	LogCounter(const char *name, plog::Severity severity, const char *text,
 	           std::chrono::seconds duration = std::chrono::seconds(1));
 
 	LogCounter &operator++(int);
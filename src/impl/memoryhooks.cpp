@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "memoryhooks.hpp"
+#include "internals.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+
+namespace rtc::impl {
+
+namespace {
+
+std::mutex mutex;
+std::atomic<bool> frozen = false;
+
+// Set once before use, so loads don't need to be ordered with the allocations
+std::atomic<void *(*)(size_t)> allocateFunc = nullptr;
+std::atomic<void *(*)(void *, size_t)> reallocateFunc = nullptr;
+std::atomic<void (*)(void *)> deallocateFunc = nullptr;
+
+} // namespace
+
+void MemoryHooks::Set(Allocator allocator) {
+	const bool set = allocator.allocate || allocator.reallocate || allocator.deallocate;
+	if (set && (!allocator.allocate || !allocator.reallocate || !allocator.deallocate))
+		throw std::invalid_argument("Allocator functions must be all set or all unset");
+
+	std::lock_guard lock(mutex);
+	if (frozen)
+		throw std::logic_error("The allocator must be set before the library allocates memory");
+
+	PLOG_DEBUG << (set ? "Setting custom allocator" : "Resetting allocator");
+	allocateFunc = allocator.allocate;
+	reallocateFunc = allocator.reallocate;
+	deallocateFunc = allocator.deallocate;
+}
+
+bool MemoryHooks::IsSet() { return allocateFunc.load(std::memory_order_relaxed) != nullptr; }
+
+void MemoryHooks::Freeze() {
+	if (frozen.load(std::memory_order_relaxed))
+		return;
+
+	std::lock_guard lock(mutex);
+	frozen = true;
+}
+
+void *MemoryHooks::Allocate(size_t size) noexcept {
+	Freeze();
+	auto func = allocateFunc.load(std::memory_order_relaxed);
+	return func ? func(size) : std::malloc(size);
+}
+
+void *MemoryHooks::Reallocate(void *ptr, size_t size) noexcept {
+	Freeze();
+	auto func = reallocateFunc.load(std::memory_order_relaxed);
+	return func ? func(ptr, size) : std::realloc(ptr, size);
+}
+
+void MemoryHooks::Free(void *ptr) noexcept {
+	auto func = deallocateFunc.load(std::memory_order_relaxed);
+	if (func)
+		func(ptr);
+	else
+		std::free(ptr);
+}
+
+} // namespace rtc::impl
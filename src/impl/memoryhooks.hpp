@@ -0,0 +1,32 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_MEMORY_HOOKS_H
+#define RTC_IMPL_MEMORY_HOOKS_H
+
+#include "common.hpp"
+#include "global.hpp" // for Allocator
+
+namespace rtc::impl {
+
+// Memory functions set with SetAllocator(), they default to the C heap. They follow the semantics
+// of malloc, realloc, and free, so they may be passed directly to the underlying libraries.
+class MemoryHooks final {
+public:
+	static void Set(Allocator allocator); // throws std::logic_error once frozen
+	static bool IsSet();
+	static void Freeze(); // called before memory is first allocated with the functions
+
+	static void *Allocate(size_t size) noexcept;
+	static void *Reallocate(void *ptr, size_t size) noexcept;
+	static void Free(void *ptr) noexcept;
+};
+
+} // namespace rtc::impl
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "messagepool.hpp"
+#include "memoryhooks.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace rtc::impl {
+
+namespace {
+
+// Blocks come from the functions set with SetAllocator()
+void *allocate_block(size_t size) {
+	if (void *block = MemoryHooks::Allocate(size))
+		return block;
+
+	throw std::bad_alloc();
+}
+
+} // namespace
+
+MessagePool &MessagePool::Instance() {
+	static MessagePool *instance = new MessagePool;
+	return *instance;
+}
+
+MessagePool::MessagePool()
+    : mNodes(new Node[utils::numa_nodes_count()]), mNodesCount(utils::numa_nodes_count()) {}
+
+MessagePool::~MessagePool() { clear(); }
+
+void MessagePool::setSettings(const MessagePoolSettings &s) {
+	mEnabled = s.enabled;
+	mMaxBuffersCount = s.maxBuffersPerSizeClass.value_or(DefaultMaxBuffersCount);
+	if (!mEnabled || mNumaLocal.exchange(s.numaLocal) != s.numaLocal)
+		clear();
+
+	if (s.numaLocal && mNodesCount < 2) {
+		PLOG_DEBUG << "Single NUMA node, the message pool is shared";
+	}
+}
+
+message_ptr MessagePool::make(size_t size, Message::Type type, size_t tailroom) {
+	if (!mEnabled && tailroom == 0)
+		return std::make_shared<Message>(size, type);
+
+	return std::allocate_shared<Message>(Allocator<Message>(), acquire(size, tailroom), type);
+}
+
+message_ptr MessagePool::make(binary &&data, Message::Type type) {
+	if (!mEnabled)
+		return std::make_shared<Message>(std::move(data), type);
+
+	return std::allocate_shared<Message>(Allocator<Message>(), std::move(data), type);
+}
+
+shared_ptr<FrameInfo> MessagePool::makeFrameInfo(FrameInfo info) {
+	if (!mEnabled)
+		return std::make_shared<FrameInfo>(std::move(info));
+
+	return std::allocate_shared<FrameInfo>(Allocator<FrameInfo>(), std::move(info));
+}
+
+binary MessagePool::acquire(size_t size, size_t tailroom) {
+	auto it = std::lower_bound(SizeClasses.begin(), SizeClasses.end(), size + tailroom);
+	if (it == SizeClasses.end() || !mEnabled) {
+		++mMisses;
+		binary buffer;
+		buffer.reserve(size + tailroom);
+		buffer.resize(size);
+		return buffer;
+	}
+
+	auto &bucket = currentNode().buckets[it - SizeClasses.begin()];
+	binary buffer;
+	{
+		std::lock_guard lock(bucket.mutex);
+		if (!bucket.buffers.empty()) {
+			buffer = std::move(bucket.buffers.back());
+			bucket.buffers.pop_back();
+		}
+	}
+
+	if (buffer.capacity() > 0)
+		++mHits;
+	else {
+		++mMisses;
+		buffer.reserve(*it);
+	}
+
+	buffer.resize(size);
+	return buffer;
+}
+
+void MessagePool::recycle(binary &&buffer) noexcept {
+	const size_t capacity = buffer.capacity();
+	if (capacity < SizeClasses.front() || capacity > 2 * SizeClasses.back() || !mEnabled)
+		return;
+
+	// Store the buffer in the largest size class it can satisfy
+	auto it = std::upper_bound(SizeClasses.begin(), SizeClasses.end(), capacity);
+	auto &bucket = currentNode().buckets[(it - SizeClasses.begin()) - 1];
+	try {
+		std::lock_guard lock(bucket.mutex);
+		if (bucket.buffers.size() < mMaxBuffersCount) {
+			buffer.clear();
+			bucket.buffers.emplace_back(std::move(buffer));
+		}
+	} catch (...) {
+		// Drop the buffer
+	}
+}
+
+void *MessagePool::allocateBlock(size_t size) {
+	if (size > BlockSize)
+		return allocate_block(size);
+
+	if (mEnabled) {
+		auto &node = currentNode();
+		std::lock_guard lock(node.blocksMutex);
+		if (!node.blocks.empty()) {
+			void *block = node.blocks.back();
+			node.blocks.pop_back();
+			return block;
+		}
+	}
+
+	return allocate_block(BlockSize);
+}
+
+void MessagePool::deallocateBlock(void *block, size_t size) noexcept {
+	if (size > BlockSize) {
+		MemoryHooks::Free(block);
+		return;
+	}
+
+	try {
+		auto &node = currentNode();
+		std::lock_guard lock(node.blocksMutex);
+		if (mEnabled && node.blocks.size() < mMaxBuffersCount * SizeClassesCount) {
+			node.blocks.push_back(block);
+			return;
+		}
+	} catch (...) {
+		// Free the block
+	}
+
+	MemoryHooks::Free(block);
+}
+
+size_t MessagePool::hits() const { return mHits.load(); }
+
+size_t MessagePool::misses() const { return mMisses.load(); }
+
+void MessagePool::clear() {
+	PLOG_DEBUG << "Clearing message pool, hits=" << mHits.load() << ", misses=" << mMisses.load();
+
+	for (size_t i = 0; i < mNodesCount; ++i) {
+		auto &node = mNodes[i];
+		for (auto &bucket : node.buckets) {
+			std::lock_guard lock(bucket.mutex);
+			bucket.buffers.clear();
+			bucket.buffers.shrink_to_fit();
+		}
+
+		std::lock_guard lock(node.blocksMutex);
+		for (void *block : node.blocks)
+			MemoryHooks::Free(block);
+
+		node.blocks.clear();
+		node.blocks.shrink_to_fit();
+	}
+}
+
+MessagePool::Node &MessagePool::currentNode() {
+	if (!mNumaLocal)
+		return mNodes[0];
+
+	return mNodes[utils::this_thread::numa_node() % mNodesCount];
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_MESSAGE_POOL_H
+#define RTC_IMPL_MESSAGE_POOL_H
+
+#include "common.hpp"
+#include "global.hpp" // for MessagePoolSettings
+#include "internals.hpp"
+#include "message.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace rtc::impl {
+
+// Recycles message buffers in size classes and allocates the Message object together with its
+// shared_ptr control block in a pooled block, so that make_message() does not hit the heap in the
+// steady state. Buffers too large for any size class fall back to the global heap. In NUMA-local
+// mode, each node has its own buckets and blocks, so buffers stay on the node that touched them.
+class MessagePool final {
+public:
+	static MessagePool &Instance();
+
+	MessagePool(const MessagePool &) = delete;
+	MessagePool &operator=(const MessagePool &) = delete;
+	MessagePool(MessagePool &&) = delete;
+	MessagePool &operator=(MessagePool &&) = delete;
+
+	void setSettings(const MessagePoolSettings &s);
+
+	message_ptr make(size_t size, Message::Type type, size_t tailroom = 0);
+	message_ptr make(binary &&data, Message::Type type);
+	shared_ptr<FrameInfo> makeFrameInfo(FrameInfo info); // in a pooled block too
+
+	binary acquire(size_t size, size_t tailroom = 0); // returns a buffer of the requested size
+	void recycle(binary &&buffer) noexcept;
+
+	void *allocateBlock(size_t size);
+	void deallocateBlock(void *block, size_t size) noexcept;
+
+	size_t hits() const;   // buffer requests served from the pool
+	size_t misses() const; // buffer requests served from the heap
+	void clear();
+
+	template <typename T> class Allocator;
+
+private:
+	MessagePool();
+	~MessagePool();
+
+	static constexpr size_t SizeClassesCount = 5;
+	static constexpr std::array<size_t, SizeClassesCount> SizeClasses = {
+	    256, DEFAULT_MTU + 256, 4096, 16384, 65536 + 1024};
+	static constexpr size_t DefaultMaxBuffersCount = 1024; // per size class
+	static constexpr size_t BlockSize = 256; // big enough for Message and its control block
+
+	struct Bucket {
+		std::vector<binary> buffers;
+		std::mutex mutex;
+	};
+
+	struct Node {
+		std::array<Bucket, SizeClassesCount> buckets;
+		std::vector<void *> blocks;
+		std::mutex blocksMutex;
+	};
+
+	Node &currentNode();
+
+	unique_ptr<Node[]> mNodes; // one per NUMA node, allocated once
+	size_t mNodesCount = 1;
+
+	std::atomic<bool> mEnabled = true;
+	std::atomic<bool> mNumaLocal = false;
+	std::atomic<size_t> mMaxBuffersCount = DefaultMaxBuffersCount;
+	std::atomic<size_t> mHits = 0;
+	std::atomic<size_t> mMisses = 0;
+};
+
+// Allocator for std::allocate_shared(), it takes its memory from pooled blocks and hands the buffer
+// back to the pool when the Message is destroyed
+template <typename T> class MessagePool::Allocator {
+public:
+	using value_type = T;
+
+	Allocator() = default;
+	template <typename U> Allocator(const Allocator<U> &) noexcept {}
+
+	T *allocate(size_t n) {
+		return static_cast<T *>(MessagePool::Instance().allocateBlock(n * sizeof(T)));
+	}
+
+	void deallocate(T *p, size_t n) noexcept {
+		MessagePool::Instance().deallocateBlock(p, n * sizeof(T));
+	}
+
+	template <typename U> void destroy(U *p) noexcept {
+		if constexpr (std::is_same_v<U, Message>)
+			MessagePool::Instance().recycle(std::move(static_cast<binary &>(*p)));
+
+		p->~U();
+	}
+
+	template <typename U> bool operator==(const Allocator<U> &) const noexcept { return true; }
+	template <typename U> bool operator!=(const Allocator<U> &) const noexcept { return false; }
+};
+
+} // namespace rtc::impl
+
+#endif
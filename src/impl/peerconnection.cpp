@@ -8,6 +8,7 @@
  */
 
 #include "peerconnection.hpp"
+#include "candidatepaircache.hpp"
 #include "certificate.hpp"
 #include "dtlstransport.hpp"
 #include "icetransport.hpp"
@@ -17,16 +18,20 @@
 #include "processor.hpp"
 #include "rtp.hpp"
 #include "sctptransport.hpp"
+#include "smallvector.hpp"
 #include "utils.hpp"
 
 #if RTC_ENABLE_MEDIA
 #include "dtlssrtptransport.hpp"
+
+#include "rtc/rtcpreceivingsession.hpp"
+#include "rtc/rtcpsrreporter.hpp"
 #endif
 
 #include <algorithm>
 #include <array>
 #include <iomanip>
-#include <set>
+#include <random>
 #include <sstream>
 #include <thread>
 
@@ -34,21 +39,43 @@ using namespace std::placeholders;
 
 namespace rtc::impl {
 
-static LogCounter COUNTER_MEDIA_TRUNCATED(plog::warning,
-                                          "Number of truncated RTP packets over past second");
-static LogCounter COUNTER_SRTP_DECRYPT_ERROR(plog::warning,
-                                             "Number of SRTP decryption errors over past second");
-static LogCounter COUNTER_SRTP_ENCRYPT_ERROR(plog::warning,
-                                             "Number of SRTP encryption errors over past second");
-static LogCounter
-    COUNTER_UNKNOWN_PACKET_TYPE(plog::warning,
-                                "Number of unknown RTCP packet types over past second");
+static LogCounter COUNTER_MEDIA_TRUNCATED("rtc_media_truncated_packets", plog::warning,
+                                          "Number of truncated RTP packets");
+static LogCounter COUNTER_SRTP_DECRYPT_ERROR("rtc_srtp_decryption_errors", plog::warning,
+                                             "Number of SRTP decryption errors");
+static LogCounter COUNTER_SRTP_ENCRYPT_ERROR("rtc_srtp_encryption_errors", plog::warning,
+                                             "Number of SRTP encryption errors");
+static LogCounter COUNTER_UNKNOWN_PACKET_TYPE("rtc_rtcp_unknown_packet_types", plog::warning,
+                                              "Number of unknown RTCP packet types");
 
 const string PemBeginCertificateTag = "-----BEGIN CERTIFICATE-----";
 
-PeerConnection::PeerConnection(Configuration config_) : config(std::move(config_)) {
+// RFC 3550 6.2: RTCP traffic is limited to 5% of the session bandwidth, with a minimum interval
+const auto MinReportInterval = std::chrono::seconds(1);
+const double RtcpBandwidthFraction = 0.05;
+const size_t RtcpOverhead = 28; // UDP/IPv4 headers
+
+// RFC 7022: Short-term persistent CNAME, used in reports when no local track has one
+static string GenerateReportCname() {
+	binary bytes(12);
+	std::generate(bytes.begin(), bytes.end(),
+	              [engine = utils::random_bytes_engine()]() mutable { return byte(engine()); });
+	return utils::base64_encode(bytes);
+}
+
+// Local candidates gathered within this window are issued together to localCandidatesCallback
+const auto LocalCandidatesBatchWindow = std::chrono::milliseconds(20);
+
+PeerConnection::PeerConnection(Configuration config_)
+    : config(std::move(config_)), mReportInterval(MinReportInterval),
+      mReportCname(GenerateReportCname()) {
 	PLOG_VERBOSE << "Creating PeerConnection";
 
+	if (config.enableExecutorAffinity) {
+		mExecutor = ExecutorPool::Instance().next();
+		mProcessor.setExecutor(mExecutor);
+	}
+
 	if (config.certificatePemFile && config.keyPemFile) {
 		std::promise<certificate_ptr> cert;
 		cert.set_value(std::make_shared<Certificate>(
@@ -87,8 +114,9 @@ PeerConnection::~PeerConnection() {
 void PeerConnection::close() {
 	if (!closing.exchange(true)) {
 		PLOG_VERBOSE << "Closing PeerConnection";
-		if (auto transport = std::atomic_load(&mSctpTransport))
-			transport->stop();
+		auto transport = std::atomic_load(&mSctpTransport);
+		if (transport && !TearDownProcessor::Instance().fastClose())
+			transport->stop(); // graceful shutdown, then the transport closes
 		else
 			remoteClose();
 	}
@@ -132,6 +160,29 @@ size_t PeerConnection::remoteMaxMessageSize() const {
 	return std::min(remoteMax, localMax);
 }
 
+size_t PeerConnection::pathMtu() const {
+	const size_t mtu = mPathMtu;
+	return mtu > 0 ? mtu : config.mtu.value_or(DEFAULT_MTU);
+}
+
+void PeerConnection::setPathMtu(size_t mtu) {
+	if (mtu < 576) // Min MTU for IPv4
+		throw std::invalid_argument("Invalid MTU value");
+
+	if (mPathMtu.exchange(mtu) == mtu)
+		return;
+
+	PLOG_DEBUG << "Path MTU set to " << mtu;
+	if (auto sctp = getSctpTransport())
+		sctp->setMtu(mtu);
+}
+
+void PeerConnection::setDataChannelPacer(shared_ptr<MediaHandler> pacer) {
+	std::atomic_store(&mDataChannelPacer, pacer);
+	if (auto sctp = getSctpTransport())
+		sctp->setPacer(std::move(pacer));
+}
+
 // Helper for PeerConnection::initXTransport methods: start and emplace the transport
 template <typename T>
 shared_ptr<T> emplaceTransport(PeerConnection *pc, shared_ptr<T> *member, shared_ptr<T> transport) {
@@ -158,6 +209,7 @@ shared_ptr<IceTransport> PeerConnection::initIceTransport() {
 			return transport;
 
 		PLOG_VERBOSE << "Starting ICE transport";
+		Init::Instance().initSubsystem(Init::Subsystem::Ice);
 
 		auto transport = std::make_shared<IceTransport>(
 		    config, weak_bind(&PeerConnection::processLocalCandidate, this, _1),
@@ -167,25 +219,41 @@ shared_ptr<IceTransport> PeerConnection::initIceTransport() {
 					    switch (transportState) {
 					    case IceTransport::State::Connecting:
 						    changeIceState(IceState::Checking);
-						    changeState(State::Connecting);
+						    if (!mIceRecovering)
+							    changeState(State::Connecting);
 						    break;
 					    case IceTransport::State::Connected:
 						    changeIceState(IceState::Connected);
-						    initDtlsTransport();
+						    if (config.enableConnectionCache)
+							    mProcessor.enqueue(&PeerConnection::storeCandidatePair,
+							                       shared_from_this());
+						    if (endIceRecovery())
+							    changeState(State::Connected);
+						    else
+							    initDtlsTransport();
 						    break;
 					    case IceTransport::State::Completed:
 						    changeIceState(IceState::Completed);
+						    if (config.enableConnectionCache)
+							    mProcessor.enqueue(&PeerConnection::storeCandidatePair,
+							                       shared_from_this());
+						    if (endIceRecovery())
+							    changeState(State::Connected);
 						    break;
 					    case IceTransport::State::Failed:
 						    changeIceState(IceState::Failed);
 						    changeState(State::Failed);
 						    mProcessor.enqueue(&PeerConnection::remoteClose, shared_from_this());
 						    break;
-					    case IceTransport::State::Disconnected:
+					    case IceTransport::State::Disconnected: {
 						    changeIceState(IceState::Disconnected);
+						    bool recovering = beginIceRecovery();
 						    changeState(State::Disconnected);
-						    mProcessor.enqueue(&PeerConnection::remoteClose, shared_from_this());
+						    if (!recovering)
+							    mProcessor.enqueue(&PeerConnection::remoteClose,
+							                       shared_from_this());
 						    break;
+					    }
 					    default:
 						    // Ignore
 						    break;
@@ -198,8 +266,11 @@ shared_ptr<IceTransport> PeerConnection::initIceTransport() {
 					    switch (gatheringState) {
 					    case IceTransport::GatheringState::InProgress:
 						    changeGatheringState(GatheringState::InProgress);
+						    scheduleGatheringDeadline();
 						    break;
 					    case IceTransport::GatheringState::Complete:
+						    cancelGatheringDeadline();
+						    flushLocalCandidates(); // before the gathering state change
 						    endLocalCandidates();
 						    changeGatheringState(GatheringState::Complete);
 						    break;
@@ -210,6 +281,9 @@ shared_ptr<IceTransport> PeerConnection::initIceTransport() {
 				    });
 		    });
 
+		// Tracks share the queue of packets waiting for the socket
+		transport->onBufferedAmount(weak_bind(&PeerConnection::forwardBufferedAmount, this, _1));
+
 		return emplaceTransport(this, &mIceTransport, std::move(transport));
 
 	} catch (const std::exception &e) {
@@ -227,10 +301,12 @@ shared_ptr<DtlsTransport> PeerConnection::initDtlsTransport() {
 		PLOG_VERBOSE << "Starting DTLS transport";
 
 		CertificateFingerprint::Algorithm fingerprintAlgorithm;
+		optional<string> expectedFingerprint;
 		{
 			std::lock_guard lock(mRemoteDescriptionMutex);
 			if (mRemoteDescription && mRemoteDescription->fingerprint()) {
 				mRemoteFingerprintAlgorithm = mRemoteDescription->fingerprint()->algorithm;
+				expectedFingerprint = mRemoteDescription->fingerprint()->value;
 			}
 			fingerprintAlgorithm = mRemoteFingerprintAlgorithm;
 		}
@@ -269,16 +345,30 @@ shared_ptr<DtlsTransport> PeerConnection::initDtlsTransport() {
 				});
 		};
 
+		Init::Instance().initSubsystem(Init::Subsystem::Dtls);
+
 		shared_ptr<DtlsTransport> transport;
 		auto local = localDescription();
 		if (config.forceMediaTransport || (local && local->hasAudioOrVideo())) {
 #if RTC_ENABLE_MEDIA
 			PLOG_INFO << "This connection requires media support";
+			Init::Instance().initSubsystem(Init::Subsystem::Srtp);
 
 			// DTLS-SRTP
-			transport = std::make_shared<DtlsSrtpTransport>(
+			auto srtpTransport = std::make_shared<DtlsSrtpTransport>(
 			    lower, certificate, config.mtu, fingerprintAlgorithm, verifierCallback,
 			    weak_bind(&PeerConnection::forwardMedia, this, _1), dtlsStateChangeCallback);
+
+			if (config.enableParallelSrtp)
+				srtpTransport->enableParallelProtection();
+
+			if (config.enableMediaEcn)
+				srtpTransport->enableEcn();
+
+			if (!config.srtpProfiles.empty())
+				srtpTransport->setSrtpProfiles(config.srtpProfiles);
+
+			transport = std::move(srtpTransport);
 #else
 			PLOG_WARNING << "Ignoring media support (not compiled with media support)";
 #endif
@@ -291,6 +381,21 @@ shared_ptr<DtlsTransport> PeerConnection::initDtlsTransport() {
 			                                            dtlsStateChangeCallback);
 		}
 
+		// Sessions are only resumed between the same pair of certificates
+		if ((config.enableDtlsSessionResumption || config.enableConnectionCache) &&
+		    expectedFingerprint)
+			transport->enableSessionResumption(certificate->fingerprint().value + ' ' +
+			                                   *expectedFingerprint);
+
+		if (config.enableDtls13)
+			transport->enableDtls13();
+
+		if (mExecutor)
+			transport->setExecutor(mExecutor);
+
+		if (config.enableInlineMediaReceive)
+			transport->enableInlineDemux();
+
 		return emplaceTransport(this, &mDtlsTransport, std::move(transport));
 
 	} catch (const std::exception &e) {
@@ -324,9 +429,10 @@ shared_ptr<SctpTransport> PeerConnection::initSctpTransport() {
 		ports.local = local->application()->sctpPort().value_or(DEFAULT_SCTP_PORT);
 		ports.remote = remote->application()->sctpPort().value_or(DEFAULT_SCTP_PORT);
 
+		Init::Instance().initSubsystem(Init::Subsystem::Sctp);
+
 		auto transport = std::make_shared<SctpTransport>(
 		    lower, config, std::move(ports), weak_bind(&PeerConnection::forwardMessage, this, _1),
-		    weak_bind(&PeerConnection::forwardBufferedAmount, this, _1, _2),
 		    [this, weak_this = weak_from_this()](SctpTransport::State transportState) {
 			    if (auto locked = weak_this.lock())
 				    std::invoke([=]() {
@@ -352,6 +458,15 @@ shared_ptr<SctpTransport> PeerConnection::initSctpTransport() {
 				    });
 		    });
 
+		if (mExecutor)
+			transport->setExecutor(mExecutor);
+
+		if (size_t mtu = mPathMtu)
+			transport->setMtu(mtu);
+
+		if (auto pacer = std::atomic_load(&mDataChannelPacer))
+			transport->setPacer(std::move(pacer));
+
 		return emplaceTransport(this, &mSctpTransport, std::move(transport));
 
 	} catch (const std::exception &e) {
@@ -373,9 +488,36 @@ shared_ptr<SctpTransport> PeerConnection::getSctpTransport() const {
 	return std::atomic_load(&mSctpTransport);
 }
 
+size_t PeerConnection::memoryUsage() {
+	// Only buffers are accounted, not the contexts of the underlying libraries
+	size_t usage = 0;
+	if (auto ice = getIceTransport())
+		usage += ice->bufferedAmount();
+
+	if (auto sctp = getSctpTransport())
+		usage += sctp->memoryUsage();
+
+	if (auto dtls = getDtlsTransport())
+		usage += dtls->memoryUsage();
+
+	iterateDataChannels(
+	    [&usage](shared_ptr<DataChannel> channel) { usage += channel->availableAmount(); });
+	iterateTracks([&usage](shared_ptr<Track> track) { usage += track->availableAmount(); });
+	return usage;
+}
+
 void PeerConnection::closeTransports() {
 	PLOG_VERBOSE << "Closing transports";
 
+	cancelGatheringDeadline();
+	cancelReports();
+	{
+		std::lock_guard lock(mLocalCandidatesMutex);
+		mLocalCandidatesTimer.cancel();
+		mPendingLocalCandidates.clear();
+	}
+	cancelIceRecovery();
+
 	// Change ICE state to sink state Closed
 	changeIceState(IceState::Closed);
 
@@ -392,10 +534,11 @@ void PeerConnection::closeTransports() {
 	auto dtls = std::atomic_exchange(&mDtlsTransport, decltype(mDtlsTransport)(nullptr));
 	auto ice = std::atomic_exchange(&mIceTransport, decltype(mIceTransport)(nullptr));
 
-	if (sctp) {
+	if (sctp)
 		sctp->onRecv(nullptr);
-		sctp->onBufferedAmount(nullptr);
-	}
+
+	// With fast close, SCTP is not stopped, closing its socket without linger aborts the association
+	const bool stopSctp = !TearDownProcessor::Instance().fastClose();
 
 	using array = std::array<shared_ptr<Transport>, 3>;
 	array transports{std::move(sctp), std::move(dtls), std::move(ice)};
@@ -405,10 +548,11 @@ void PeerConnection::closeTransports() {
 			t->onStateChange(nullptr);
 
 	TearDownProcessor::Instance().enqueue(
-	    [transports = std::move(transports), token = Init::Instance().token()]() mutable {
-		    for (const auto &t : transports) {
-			    if (t) {
-				    t->stop();
+	    [transports = std::move(transports), stopSctp, token = Init::Instance().token()]() mutable {
+		    for (size_t i = 0; i < transports.size(); ++i) {
+			    if (transports[i]) {
+				    if (i > 0 || stopSctp)
+					    transports[i]->stop();
 				    break;
 			    }
 		    }
@@ -418,6 +562,13 @@ void PeerConnection::closeTransports() {
 	    });
 }
 
+void PeerConnection::prewarm() {
+	// The ICE agent binds its sockets on creation, and waiting for the certificate here means
+	// the DTLS transport won't have to
+	initIceTransport();
+	mCertificate.wait();
+}
+
 void PeerConnection::endLocalCandidates() {
 	std::lock_guard lock(mLocalDescriptionMutex);
 	if (mLocalDescription)
@@ -503,7 +654,7 @@ void PeerConnection::forwardMessage(message_ptr message) {
 		    weak_bind(&PeerConnection::triggerDataChannel, this, weak_ptr<DataChannel>{channel});
 
 		std::unique_lock lock(mDataChannelsMutex); // we are going to emplace
-		mDataChannels.emplace(stream, channel);
+		insertDataChannel(stream, channel);
 	} else if (!found) {
 		if (message->type == Message::Reset)
 			return; // ignore
@@ -528,15 +679,13 @@ void PeerConnection::forwardMessage(message_ptr message) {
 	}
 }
 
-void PeerConnection::forwardMedia([[maybe_unused]] message_ptr message) {
+void PeerConnection::forwardMedia([[maybe_unused]] message_vector messages) {
 #if RTC_ENABLE_MEDIA
-	if (!message)
+	if (messages.empty())
 		return;
 
 	// TODO: outgoing
 	if (auto handler = getMediaHandler()) {
-		message_vector messages{std::move(message)};
-
 		try {
 			handler->incomingChain(messages, [this](message_ptr message) {
 				auto transport = std::atomic_load(&mDtlsTransport);
@@ -547,105 +696,291 @@ void PeerConnection::forwardMedia([[maybe_unused]] message_ptr message) {
 			PLOG_WARNING << "Exception in global incoming media handler: " << e.what();
 			return;
 		}
+	}
 
-		for (auto &m : messages)
-			dispatchMedia(std::move(m));
+	dispatchMedia(std::move(messages));
+#endif
+}
 
-	} else {
-		dispatchMedia(std::move(message));
+void PeerConnection::forwardBufferedAmount(size_t amount) {
+	iterateTracks([amount](shared_ptr<Track> track) { track->triggerBufferedAmount(amount); });
+}
+
+// Each track receives its messages of a batch at once, in order
+struct PeerConnection::TrackBatches {
+	SmallVector<shared_ptr<Track>, 4> tracks;
+	SmallVector<message_vector, 4> messages;
+
+	void add(shared_ptr<Track> track, message_ptr message) {
+		size_t i = 0;
+		while (i < tracks.size() && tracks[i] != track)
+			++i;
+
+		if (i == tracks.size()) {
+			tracks.push_back(std::move(track));
+			messages.push_back({});
+		}
+		messages[i].push_back(std::move(message));
+	}
+
+	void deliver() {
+		for (size_t i = 0; i < tracks.size(); ++i)
+			tracks[i]->incoming(std::move(messages[i]));
+	}
+};
+
+void PeerConnection::dispatchMedia([[maybe_unused]] message_vector messages) {
+#if RTC_ENABLE_MEDIA
+	auto routes = std::atomic_load(&mTrackRoutes);
+	if (!routes)
+		return;
+
+	if (routes->single) {
+		if (auto track = routes->single->lock())
+			track->incoming(std::move(messages));
+		return;
 	}
+
+	TrackBatches batches;
+	for (auto &message : messages) {
+		if (message->type == Message::Control && dispatchRtcp(message, *routes, batches))
+			continue;
+
+		if (auto track = routeBySsrc(*message, *routes))
+			batches.add(std::move(track), std::move(message));
+	}
+	batches.deliver();
 #endif
 }
 
-void PeerConnection::dispatchMedia([[maybe_unused]] message_ptr message) {
+shared_ptr<Track> PeerConnection::routeBySsrc([[maybe_unused]] const Message &message,
+                                              [[maybe_unused]] const TrackRoutes &routes) {
 #if RTC_ENABLE_MEDIA
-	std::shared_lock lock(mTracksMutex); // read-only
-	if (mTrackLines.size() == 1) {
-		if (auto track = mTrackLines.front().lock())
-			track->incoming(message);
-		return;
+	uint32_t ssrc = uint32_t(message.stream);
+
+	if (auto it = routes.bySsrc.find(ssrc); it != routes.bySsrc.end())
+		return it->second.lock();
+
+	if (auto track = routeByMid(message, routes)) {
+		// Streams without signaled SSRCs, like simulcast layers, are identified by their MID
+		std::unique_lock lock(mTracksMutex);
+		if (mTracksBySsrc.find(ssrc) != mTracksBySsrc.end())
+			return track; // learned concurrently
+
+		// Cap the SSRCs learned per track, as the remote peer may send any number of them,
+		// forgetting the oldest one
+		auto &learned = mLearnedSsrcs[track->mid()];
+		if (learned.size() >= MaxLearnedSsrcsPerTrack) {
+			PLOG_DEBUG << "Too many SSRCs for track, forgetting SSRC " << learned.front();
+			mTracksBySsrc.erase(learned.front());
+			learned.pop_front();
+		}
+		learned.push_back(ssrc);
+
+		PLOG_DEBUG << "Routing SSRC " << ssrc << " to track, mid=\"" << track->mid() << "\"";
+		mTracksBySsrc.insert_or_assign(ssrc, track);
+		publishTrackRoutes();
+		return track;
 	}
-	// Browsers like to compound their packets with a random SSRC.
-	// we have to do this monstrosity to distribute the report blocks
-	if (message->type == Message::Control) {
-		std::set<uint32_t> ssrcs;
+
+	/*
+	 * TODO: So the problem is that when stop sending streams, we stop getting report blocks for
+	 * those streams Therefore when we get compound RTCP packets, they are empty, and we can't
+	 * forward them. Therefore, it is expected that we don't know where to forward packets. Is
+	 * this ideal? No! Do I know how to fix it? No!
+	 */
+	// PLOG_WARNING << "Track not found for SSRC " << ssrc << ", dropping";
+#endif
+	return nullptr;
+}
+
+bool PeerConnection::dispatchRtcp([[maybe_unused]] const message_ptr &message,
+                                  [[maybe_unused]] const TrackRoutes &routes,
+                                  [[maybe_unused]] TrackBatches &batches) {
+#if RTC_ENABLE_MEDIA
+	// Browsers like to compound their packets with a random SSRC, so sub-packets and report blocks
+	// are routed to the tracks of their SSRCs in a single pass, then each track receives a compound
+	// packet with only what concerns it.
+	struct Route {
+		size_t target = 0; // index in targets
 		size_t offset = 0;
-		while ((sizeof(RtcpHeader) + offset) <= message->size()) {
-			auto header = reinterpret_cast<RtcpHeader *>(message->data() + offset);
-			if (header->lengthInBytes() > message->size() - offset) {
-				COUNTER_MEDIA_TRUNCATED++;
-				break;
+		uint32_t blocks = 0; // report blocks to keep for SR and RR packets
+	};
+	const uint32_t allBlocks = ~uint32_t(0);
+
+	SmallVector<shared_ptr<Track>, 4> targets;
+	SmallVector<Route, 16> routed;
+	bool found = false;
+
+	auto route = [&](uint32_t ssrc, size_t offset, uint32_t blocks) {
+		found = true;
+		auto it = routes.bySsrc.find(ssrc);
+		if (it == routes.bySsrc.end())
+			return;
+
+		auto track = it->second.lock();
+		if (!track)
+			return;
+
+		size_t target = 0;
+		while (target < targets.size() && targets[target] != track)
+			++target;
+
+		if (target == targets.size())
+			targets.push_back(std::move(track));
+
+		// Routes to the same track for a sub-packet are consecutive, merge them
+		for (size_t i = routed.size(); i > 0 && routed[i - 1].offset == offset; --i) {
+			if (routed[i - 1].target == target) {
+				routed[i - 1].blocks |= blocks;
+				return;
 			}
-			offset += header->lengthInBytes();
-			if (header->payloadType() == 205 || header->payloadType() == 206) {
-				auto rtcpfb = reinterpret_cast<RtcpFbHeader *>(header);
-				ssrcs.insert(rtcpfb->packetSenderSSRC());
-				ssrcs.insert(rtcpfb->mediaSourceSSRC());
-
-			} else if (header->payloadType() == 200) {
-				auto rtcpsr = reinterpret_cast<RtcpSr *>(header);
-				ssrcs.insert(rtcpsr->senderSSRC());
-				for (int i = 0; i < rtcpsr->header.reportCount(); ++i)
-					ssrcs.insert(rtcpsr->getReportBlock(i)->getSSRC());
-			} else if (header->payloadType() == 201) {
-				auto rtcprr = reinterpret_cast<RtcpRr *>(header);
-				ssrcs.insert(rtcprr->senderSSRC());
-				for (int i = 0; i < rtcprr->header.reportCount(); ++i)
-					ssrcs.insert(rtcprr->getReportBlock(i)->getSSRC());
-			} else if (header->payloadType() == 202) {
-				auto sdes = reinterpret_cast<RtcpSdes *>(header);
-				if (!sdes->isValid()) {
-					PLOG_WARNING << "RTCP SDES packet is invalid";
-					continue;
-				}
-				for (unsigned int i = 0; i < sdes->chunksCount(); i++) {
-					auto chunk = sdes->getChunk(i);
-					ssrcs.insert(chunk->ssrc());
-				}
+		}
+		routed.push_back(Route{target, offset, blocks});
+	};
+
+	size_t offset = 0;
+	while ((sizeof(RtcpHeader) + offset) <= message->size()) {
+		auto header = reinterpret_cast<RtcpHeader *>(message->data() + offset);
+		const size_t length = header->lengthInBytes();
+		if (length > message->size() - offset) {
+			COUNTER_MEDIA_TRUNCATED++;
+			break;
+		}
+		if (header->payloadType() == 205 || header->payloadType() == 206) {
+			auto rtcpfb = reinterpret_cast<RtcpFbHeader *>(header);
+			if (length >= sizeof(RtcpFbHeader)) {
+				route(rtcpfb->packetSenderSSRC(), offset, allBlocks);
+				route(rtcpfb->mediaSourceSSRC(), offset, allBlocks);
+			}
+		} else if (header->payloadType() == 200) {
+			auto rtcpsr = reinterpret_cast<RtcpSr *>(header);
+			if (length >= RtcpSr::Size(header->reportCount())) {
+				route(rtcpsr->senderSSRC(), offset, 0);
+				for (int i = 0; i < header->reportCount(); ++i)
+					route(rtcpsr->getReportBlock(i)->getSSRC(), offset, uint32_t(1) << i);
+			}
+		} else if (header->payloadType() == 201) {
+			auto rtcprr = reinterpret_cast<RtcpRr *>(header);
+			if (length >= RtcpRr::SizeWithReportBlocks(header->reportCount())) {
+				route(rtcprr->senderSSRC(), offset, 0);
+				for (int i = 0; i < header->reportCount(); ++i)
+					route(rtcprr->getReportBlock(i)->getSSRC(), offset, uint32_t(1) << i);
+			}
+		} else if (header->payloadType() == 202) {
+			auto sdes = reinterpret_cast<RtcpSdes *>(header);
+			if (sdes->isValid()) {
+				for (unsigned int i = 0; i < sdes->chunksCount(); i++)
+					route(sdes->getChunk(i)->ssrc(), offset, allBlocks);
 			} else {
-				// PT=203 == Goodbye
-				// PT=204 == Application Specific
-				// PT=207 == Extended Report
-				if (header->payloadType() != 203 && header->payloadType() != 204 &&
-				    header->payloadType() != 207) {
-					COUNTER_UNKNOWN_PACKET_TYPE++;
-				}
+				PLOG_WARNING << "RTCP SDES packet is invalid";
+			}
+		} else {
+			// PT=203 == Goodbye
+			// PT=204 == Application Specific
+			// PT=207 == Extended Report
+			if (header->payloadType() != 203 && header->payloadType() != 204 &&
+			    header->payloadType() != 207) {
+				COUNTER_UNKNOWN_PACKET_TYPE++;
 			}
 		}
+		offset += length;
+	}
 
-		if (!ssrcs.empty()) {
-			for (uint32_t ssrc : ssrcs) {
-				if (auto it = mTracksBySsrc.find(ssrc); it != mTracksBySsrc.end()) {
-					if (auto track = it->second.lock())
-						track->incoming(message);
-				}
-			}
-			return;
+	if (targets.empty())
+		return found;
+
+	auto isWhole = [&](const Route &r) {
+		auto header = reinterpret_cast<const RtcpHeader *>(message->data() + r.offset);
+		const uint8_t pt = header->payloadType();
+		if (pt != 200 && pt != 201)
+			return true;
+
+		const uint32_t mask = (uint32_t(1) << header->reportCount()) - 1;
+		return (r.blocks & mask) == mask;
+	};
+
+	// If a single track is concerned, it gets the packet as is
+	if (targets.size() == 1) {
+		bool whole = true;
+		for (size_t i = 0; i < routed.size() && whole; ++i)
+			whole = isWhole(routed[i]);
+
+		if (whole) {
+			batches.add(std::move(targets[0]), message);
+			return true;
 		}
 	}
 
-	uint32_t ssrc = uint32_t(message->stream);
+	for (size_t t = 0; t < targets.size(); ++t) {
+		auto compound = make_message(message->size(), message);
+		size_t size = 0;
+		for (size_t i = 0; i < routed.size(); ++i) {
+			const auto &r = routed[i];
+			if (r.target != t)
+				continue;
 
-	if (auto it = mTracksBySsrc.find(ssrc); it != mTracksBySsrc.end()) {
-		if (auto track = it->second.lock())
-			track->incoming(message);
-	} else {
-		/*
-		 * TODO: So the problem is that when stop sending streams, we stop getting report blocks for
-		 * those streams Therefore when we get compound RTCP packets, they are empty, and we can't
-		 * forward them. Therefore, it is expected that we don't know where to forward packets. Is
-		 * this ideal? No! Do I know how to fix it? No!
-		 */
-		// PLOG_WARNING << "Track not found for SSRC " << ssrc << ", dropping";
-		return;
+			auto header = reinterpret_cast<const RtcpHeader *>(message->data() + r.offset);
+			auto dest = compound->data() + size;
+			if (isWhole(r)) {
+				std::memcpy(dest, header, header->lengthInBytes());
+				size += header->lengthInBytes();
+				continue;
+			}
+
+			// Keep the sender part and the report blocks about the track
+			const size_t base =
+			    header->payloadType() == 200 ? RtcpSr::Size(0) : RtcpRr::SizeWithReportBlocks(0);
+			std::memcpy(dest, header, base);
+			size_t blockSize = base;
+			uint8_t count = 0;
+			for (int i = 0; i < header->reportCount(); ++i) {
+				if (r.blocks & (uint32_t(1) << i)) {
+					std::memcpy(dest + blockSize,
+					            reinterpret_cast<const byte *>(header) + base +
+					                i * sizeof(RtcpReportBlock),
+					            sizeof(RtcpReportBlock));
+					blockSize += sizeof(RtcpReportBlock);
+					++count;
+				}
+			}
+			auto destHeader = reinterpret_cast<RtcpHeader *>(dest);
+			destHeader->setReportCount(count);
+			destHeader->setLength(uint16_t(blockSize / 4 - 1));
+			size += blockSize;
+		}
+		compound->resize(size);
+		batches.add(std::move(targets[t]), std::move(compound));
 	}
+	return true;
+#else
+	return false;
 #endif
 }
 
-void PeerConnection::forwardBufferedAmount(uint16_t stream, size_t amount) {
-	[[maybe_unused]] auto [channel, found] = findDataChannel(stream);
-	if (channel)
-		channel->triggerBufferedAmount(amount);
+shared_ptr<Track> PeerConnection::routeByMid([[maybe_unused]] const Message &message,
+                                             [[maybe_unused]] const TrackRoutes &routes) const {
+#if RTC_ENABLE_MEDIA
+	// RFC 8843 15. BUNDLE-Related RTP/RTCP Header Extensions
+	if (routes.midExtId == 0 || message.type == Message::Control)
+		return nullptr;
+
+	auto rtp = reinterpret_cast<const RtpHeader *>(message.data());
+	if (message.size() < sizeof(RtpHeader) || !rtp->extension() ||
+	    rtp->getSize() + sizeof(RtpExtensionHeader) > message.size() ||
+	    rtp->getSize() + rtp->getExtensionHeaderSize() > message.size())
+		return nullptr;
+
+	size_t size = 0;
+	auto element = rtp->getExtensionHeader()->findHeader(routes.midExtId, size);
+	if (!element || size == 0)
+		return nullptr;
+
+	string mid(reinterpret_cast<const char *>(element), size);
+	if (auto it = routes.byMid.find(mid); it != routes.byMid.end())
+		return it->second.lock();
+#endif
+	return nullptr;
 }
 
 shared_ptr<DataChannel> PeerConnection::emplaceDataChannel(string label, DataChannelInit init) {
@@ -655,10 +990,17 @@ shared_ptr<DataChannel> PeerConnection::emplaceDataChannel(string label, DataCha
 	auto channel =
 	    init.negotiated
 	        ? std::make_shared<DataChannel>(weak_from_this(), std::move(label),
-	                                        std::move(init.protocol), std::move(init.reliability))
+	                                        std::move(init.protocol), std::move(init.reliability),
+	                                        init.priority)
 	        : std::make_shared<OutgoingDataChannel>(weak_from_this(), std::move(label),
 	                                                std::move(init.protocol),
-	                                                std::move(init.reliability));
+	                                                std::move(init.reliability), init.priority);
+
+	if (init.coalescingWindow)
+		channel->setCoalescingWindow(*init.coalescingWindow);
+
+	if (init.maxAvailableAmount)
+		channel->setMaxAvailableAmount(*init.maxAvailableAmount);
 
 	// If the user supplied a stream id, use it, otherwise assign it later
 	if (init.id) {
@@ -667,7 +1009,7 @@ shared_ptr<DataChannel> PeerConnection::emplaceDataChannel(string label, DataCha
 			throw std::invalid_argument("DataChannel stream id is too high");
 
 		channel->assignStream(stream);
-		mDataChannels.emplace(std::make_pair(stream, channel));
+		insertDataChannel(stream, channel);
 
 	} else {
 		mUnassignedDataChannels.push_back(channel);
@@ -685,17 +1027,91 @@ shared_ptr<DataChannel> PeerConnection::emplaceDataChannel(string label, DataCha
 	return channel;
 }
 
+std::vector<shared_ptr<DataChannel>>
+PeerConnection::emplaceNegotiatedDataChannels(std::vector<string> labels, DataChannelInit init) {
+	if (!init.id)
+		throw std::invalid_argument("Negotiated DataChannels require a first stream id");
+
+	const size_t first = *init.id;
+	if (labels.empty())
+		return {};
+
+	if (first + labels.size() - 1 > maxDataChannelStream())
+		throw std::invalid_argument("DataChannel stream ids are too high");
+
+	std::vector<shared_ptr<DataChannel>> channels;
+	channels.reserve(labels.size());
+	{
+		std::unique_lock lock(mDataChannelsMutex); // we are going to emplace
+		for (size_t i = 0; i < labels.size(); ++i)
+			if (isDataChannelStreamUsed(uint16_t(first + i)))
+				throw std::invalid_argument("DataChannel stream id " + std::to_string(first + i) +
+				                            " is already used");
+
+		// Reserve the whole range at once
+		if (mDataChannels.size() < first + labels.size())
+			mDataChannels.resize(first + labels.size());
+
+		for (size_t i = 0; i < labels.size(); ++i) {
+			auto channel = std::make_shared<DataChannel>(weak_from_this(), std::move(labels[i]),
+			                                             init.protocol, init.reliability,
+			                                             init.priority);
+			if (init.coalescingWindow)
+				channel->setCoalescingWindow(*init.coalescingWindow);
+
+			if (init.maxAvailableAmount)
+				channel->setMaxAvailableAmount(*init.maxAvailableAmount);
+
+			const uint16_t stream = uint16_t(first + i);
+			channel->assignStream(stream);
+			insertDataChannel(stream, channel);
+			channels.push_back(std::move(channel));
+		}
+	}
+
+	// If SCTP is connected, open now
+	auto sctpTransport = std::atomic_load(&mSctpTransport);
+	if (sctpTransport && sctpTransport->state() == SctpTransport::State::Connected) {
+		SctpTransport::WriteScope scope(sctpTransport.get());
+		for (const auto &channel : channels)
+			channel->open(sctpTransport);
+	}
+
+	return channels;
+}
+
+bool PeerConnection::isDataChannelStreamUsed(uint16_t stream) const {
+	return stream < mDataChannels.size() && mDataChannels[stream].used;
+}
+
+bool PeerConnection::insertDataChannel(uint16_t stream, weak_ptr<DataChannel> channel) {
+	if (isDataChannelStreamUsed(stream))
+		return false;
+
+	if (stream >= mDataChannels.size())
+		mDataChannels.resize(size_t(stream) + 1);
+
+	mDataChannels[stream] = DataChannelSlot{std::move(channel), true};
+	++mDataChannelsCount;
+	return true;
+}
+
 std::pair<shared_ptr<DataChannel>, bool> PeerConnection::findDataChannel(uint16_t stream) {
 	std::shared_lock lock(mDataChannelsMutex); // read-only
-	if (auto it = mDataChannels.find(stream); it != mDataChannels.end())
-		return std::make_pair(it->second.lock(), true);
+	if (isDataChannelStreamUsed(stream))
+		return std::make_pair(mDataChannels[stream].channel.lock(), true);
 	else
 		return std::make_pair(nullptr, false);
 }
 
 bool PeerConnection::removeDataChannel(uint16_t stream) {
 	std::unique_lock lock(mDataChannelsMutex); // we are going to erase
-	return mDataChannels.erase(stream) != 0;
+	if (!isDataChannelStreamUsed(stream))
+		return false;
+
+	mDataChannels[stream] = DataChannelSlot{};
+	--mDataChannelsCount;
+	return true;
 }
 
 uint16_t PeerConnection::maxDataChannelStream() const {
@@ -726,7 +1142,7 @@ void PeerConnection::assignDataChannels() {
 			if (stream > maxStream)
 				throw std::runtime_error("Too many DataChannels");
 
-			if (mDataChannels.find(stream) == mDataChannels.end())
+			if (!isDataChannelStreamUsed(stream))
 				break;
 
 			stream += 2;
@@ -735,7 +1151,7 @@ void PeerConnection::assignDataChannels() {
 		PLOG_DEBUG << "Assigning stream " << stream << " to DataChannel";
 
 		channel->assignStream(stream);
-		mDataChannels.emplace(std::make_pair(stream, channel));
+		insertDataChannel(stream, channel);
 	}
 
 	mUnassignedDataChannels.clear();
@@ -746,9 +1162,12 @@ void PeerConnection::iterateDataChannels(
 	std::vector<shared_ptr<DataChannel>> locked;
 	{
 		std::shared_lock lock(mDataChannelsMutex); // read-only
-		locked.reserve(mDataChannels.size());
-		for (auto it = mDataChannels.begin(); it != mDataChannels.end(); ++it) {
-			auto channel = it->second.lock();
+		locked.reserve(mDataChannelsCount);
+		for (const auto &slot : mDataChannels) {
+			if (!slot.used)
+				continue;
+
+			auto channel = slot.channel.lock();
 			if (channel && !channel->isClosed())
 				locked.push_back(std::move(channel));
 		}
@@ -764,11 +1183,14 @@ void PeerConnection::iterateDataChannels(
 }
 
 void PeerConnection::openDataChannels() {
-	if (auto transport = std::atomic_load(&mSctpTransport))
+	if (auto transport = std::atomic_load(&mSctpTransport)) {
+		// Open requests are pipelined, then passed down together
+		SctpTransport::WriteScope scope(transport.get());
 		iterateDataChannels([&](shared_ptr<DataChannel> channel) {
 			if (!channel->isOpen())
 				channel->open(transport);
 		});
+	}
 }
 
 void PeerConnection::closeDataChannels() {
@@ -799,6 +1221,7 @@ shared_ptr<Track> PeerConnection::emplaceTrack(Description::Media description) {
 		track = std::make_shared<Track>(weak_from_this(), std::move(description));
 		mTracks.emplace(std::make_pair(track->mid(), track));
 		mTrackLines.emplace_back(track);
+		publishTrackRoutes();
 	}
 
 	auto handler = getMediaHandler();
@@ -842,9 +1265,9 @@ void PeerConnection::iterateRemoteTracks(std::function<void(shared_ptr<Track> tr
 		std::shared_lock lock(mTracksMutex); // read-only
 		locked.reserve(remote->mediaCount());
 		for(int i = 0; i < remote->mediaCount(); ++i) {
-			auto media = remote->media(i);
-			if (std::holds_alternative<Description::Media *>(media)) {
-				auto remoteMedia = std::get<Description::Media *>(media);
+			auto media = std::as_const(*remote).media(i);
+			if (std::holds_alternative<const Description::Media *>(media)) {
+				auto remoteMedia = std::get<const Description::Media *>(media);
 				if (!remoteMedia->isRemoved())
 					if (auto it = mTracks.find(remoteMedia->mid()); it != mTracks.end())
 						if (auto track = it->second.lock())
@@ -885,6 +1308,9 @@ void PeerConnection::openTracks() {
 			}
 		}
 	});
+
+	if (srtpTransport)
+		scheduleReports();
 #endif
 }
 
@@ -938,9 +1364,9 @@ void PeerConnection::populateLocalDescription(Description &description) const {
 		for (int i = 0; i < remote->mediaCount(); ++i) {
 			std::visit( // reciprocate each media
 			    rtc::overloaded{
-			        [&](Description::Application *remoteApp) {
+			        [&](const Description::Application *remoteApp) {
 				        std::shared_lock lock(mDataChannelsMutex);
-				        if (!mDataChannels.empty() || !mUnassignedDataChannels.empty()) {
+				        if (mDataChannelsCount > 0 || !mUnassignedDataChannels.empty()) {
 					        // Prefer local description
 					        Description::Application app(remoteApp->mid());
 					        app.setSctpPort(localSctpPort);
@@ -962,7 +1388,7 @@ void PeerConnection::populateLocalDescription(Description &description) const {
 							description.addMedia(std::move(reciprocated));
 						}
 			        },
-			        [&](Description::Media *remoteMedia) {
+			        [&](const Description::Media *remoteMedia) {
 				        std::shared_lock lock(mTracksMutex);
 				        auto it = mTracks.find(remoteMedia->mid());
 					    auto track = it != mTracks.end() ? it->second.lock() : nullptr;
@@ -988,7 +1414,7 @@ void PeerConnection::populateLocalDescription(Description &description) const {
 					    }
 			        },
 			    },
-			    remote->media(i));
+			    std::as_const(*remote).media(i));
 		}
 	}
 
@@ -1013,7 +1439,7 @@ void PeerConnection::populateLocalDescription(Description &description) const {
 		// Add application for data channels
 		if (!description.hasApplication()) {
 			std::shared_lock lock(mDataChannelsMutex);
-			if (!mDataChannels.empty() || !mUnassignedDataChannels.empty()) {
+			if (mDataChannelsCount > 0 || !mUnassignedDataChannels.empty()) {
 				// Prevents mid collision with remote or local tracks
 				unsigned int m = 0;
 				while (description.hasMid(std::to_string(m)))
@@ -1041,8 +1467,14 @@ void PeerConnection::processLocalDescription(Description description) {
 	if (description.mediaCount() == 0)
 		throw std::logic_error("Local description has no media line");
 
-	// Update the SSRC cache
-	updateTrackSsrcCache(description);
+	// Update the SSRC cache for media which changed since the previous local description
+	auto previous = localDescription();
+	auto changed = previous ? description.changedMedia(*previous) : std::vector<int>();
+	if (!previous)
+		for (int i = 0; i < description.mediaCount(); ++i)
+			changed.push_back(i);
+
+	updateTrackSsrcCache(description, changed, previous);
 
 	{
 		// Set as local description
@@ -1078,17 +1510,68 @@ void PeerConnection::processLocalCandidate(Candidate candidate) {
 	candidate.resolve(Candidate::ResolveMode::Simple);
 	mLocalDescription->addCandidate(candidate);
 
-	mProcessor.enqueue(&PeerConnection::trigger<Candidate>, shared_from_this(),
-	                   &localCandidateCallback, std::move(candidate));
+	// Host candidates are gathered first, so they are all in with the first server-reflexive one
+	bool srflx = candidate.type() == Candidate::Type::ServerReflexive;
+
+	if (localCandidatesCallback) {
+		// Batch candidates so signaling sends one message for many candidates
+		std::lock_guard candidatesLock(mLocalCandidatesMutex);
+		mPendingLocalCandidates.push_back(std::move(candidate));
+		if (mPendingLocalCandidates.size() == 1)
+			mLocalCandidatesTimer = ThreadPool::Instance().setTimer(
+			    LocalCandidatesBatchWindow, [weak_this = weak_from_this()]() {
+				    if (auto locked = weak_this.lock())
+					    locked->flushLocalCandidates();
+			    });
+	} else {
+		mProcessor.enqueue(&PeerConnection::trigger<Candidate>, shared_from_this(),
+		                   &localCandidateCallback, std::move(candidate));
+	}
+
+	if (srflx)
+		completeGatheringEarly();
+}
+
+void PeerConnection::flushLocalCandidates() {
+	std::vector<Candidate> candidates;
+	{
+		std::lock_guard lock(mLocalCandidatesMutex);
+		mLocalCandidatesTimer.cancel();
+		std::swap(candidates, mPendingLocalCandidates);
+	}
+
+	if (candidates.empty())
+		return;
+
+	PLOG_VERBOSE << "Issuing " << candidates.size() << " local candidates";
+	mProcessor.enqueue(&PeerConnection::trigger<std::vector<Candidate>>, shared_from_this(),
+	                   &localCandidatesCallback, std::move(candidates));
 }
 
 void PeerConnection::processRemoteDescription(Description description) {
+	// On renegotiation, only media which changed need to be processed
+	auto previous = remoteDescription();
+	std::vector<int> changed;
+	if (previous) {
+		changed = description.changedMedia(*previous);
+		PLOG_DEBUG << "Remote description has " << changed.size() << " changed media out of "
+		           << description.mediaCount();
+	} else {
+		changed.resize(description.mediaCount());
+		for (int i = 0; i < description.mediaCount(); ++i)
+			changed[i] = i;
+	}
+
 	// Create tracks from remote description
-	for (int i = 0; i < description.mediaCount(); ++i) {
-		auto media = description.media(i);
-		if (std::holds_alternative<Description::Media *>(media)) {
-			auto remoteMedia = std::get<Description::Media *>(media);
-			std::unique_lock lock(mTracksMutex); // we may emplace a track
+	std::vector<shared_ptr<Track>> newTracks;
+	{
+		std::unique_lock lock(mTracksMutex); // we may emplace tracks
+		for (int i : changed) {
+			auto media = std::as_const(description).media(i);
+			if (!std::holds_alternative<const Description::Media *>(media))
+				continue;
+
+			auto remoteMedia = std::get<const Description::Media *>(media);
 			if (auto it = mTracks.find(remoteMedia->mid()); it != mTracks.end())
 				continue;
 
@@ -1107,6 +1590,13 @@ void PeerConnection::processRemoteDescription(Description description) {
 			auto track = std::make_shared<Track>(weak_from_this(), std::move(reciprocated));
 			mTracks.emplace(std::make_pair(track->mid(), track));
 			mTrackLines.emplace_back(track);
+			newTracks.push_back(std::move(track));
+		}
+
+		if (!newTracks.empty())
+			publishTrackRoutes();
+
+		for (const auto &track : newTracks) {
 			triggerTrack(track); // The user may modify the track description
 
 			auto handler = getMediaHandler();
@@ -1119,7 +1609,7 @@ void PeerConnection::processRemoteDescription(Description description) {
 	}
 
 	// Update the SSRC cache for existing tracks
-	updateTrackSsrcCache(description);
+	updateTrackSsrcCache(description, changed, previous);
 
 	{
 		// Set as remote description
@@ -1149,43 +1639,93 @@ void PeerConnection::processRemoteDescription(Description description) {
 }
 
 void PeerConnection::processRemoteCandidate(Candidate candidate) {
+	std::vector<Candidate> candidates;
+	candidates.push_back(std::move(candidate));
+	processRemoteCandidates(std::move(candidates));
+}
+
+void PeerConnection::processRemoteCandidates(std::vector<Candidate> candidates) {
 	auto iceTransport = std::atomic_load(&mIceTransport);
+	std::vector<Candidate> resolved, unresolved;
 	{
-		// Set as remote candidate
+		// Set as remote candidates, locking once for the batch
 		std::lock_guard lock(mRemoteDescriptionMutex);
 		if (!mRemoteDescription)
-			throw std::logic_error("Got a remote candidate without remote description");
+			throw std::logic_error("Got remote candidates without remote description");
 
 		if (!iceTransport)
-			throw std::logic_error("Got a remote candidate without ICE transport");
-
-		candidate.hintMid(mRemoteDescription->bundleMid());
-
-		if (mRemoteDescription->hasCandidate(candidate))
-			return; // already in description, ignore
-
-		candidate.resolve(Candidate::ResolveMode::Simple);
-		mRemoteDescription->addCandidate(candidate);
+			throw std::logic_error("Got remote candidates without ICE transport");
+
+		const string bundleMid = mRemoteDescription->bundleMid();
+		for (auto &candidate : candidates) {
+			candidate.hintMid(bundleMid);
+			if (mRemoteDescription->hasCandidate(candidate))
+				continue; // already in description, ignore
+
+			candidate.resolve(Candidate::ResolveMode::Simple);
+			mRemoteDescription->addCandidate(candidate);
+			if (candidate.isResolved())
+				resolved.push_back(std::move(candidate));
+			else
+				unresolved.push_back(std::move(candidate));
+		}
 	}
 
-	if (candidate.isResolved()) {
-		iceTransport->addRemoteCandidate(std::move(candidate));
-	} else {
-		// We might need a lookup, do it asynchronously
+	if (!resolved.empty())
+		iceTransport->addRemoteCandidates(resolved);
+
+	if (!unresolved.empty()) {
+		// Lookups are done sequentially on a single thread for the batch, through the DNS cache
 		// We don't use the thread pool because we have no control on the timeout
-		if ((iceTransport = std::atomic_load(&mIceTransport))) {
-			weak_ptr<IceTransport> weakIceTransport{iceTransport};
-			std::thread t([weakIceTransport, candidate = std::move(candidate)]() mutable {
-				utils::this_thread::set_name("RTC resolver");
+		weak_ptr<IceTransport> weakIceTransport{iceTransport};
+		std::thread t([weakIceTransport, unresolved = std::move(unresolved)]() mutable {
+			utils::this_thread::set_name("RTC resolver");
+			for (auto &candidate : unresolved)
 				if (candidate.resolve(Candidate::ResolveMode::Lookup))
 					if (auto iceTransport = weakIceTransport.lock())
 						iceTransport->addRemoteCandidate(std::move(candidate));
-			});
-			t.detach();
-		}
+		});
+		t.detach();
 	}
 }
 
+void PeerConnection::storeCandidatePair() {
+	auto iceTransport = std::atomic_load(&mIceTransport);
+	auto remote = remoteDescription();
+	if (!iceTransport || !remote || !remote->fingerprint())
+		return;
+
+	// The selected pair might still change until ICE completes, the last one is kept
+	Candidate candidate;
+	if (iceTransport->getSelectedCandidatePair(nullptr, &candidate))
+		CandidatePairCache::Instance().store(remote->fingerprint()->value, std::move(candidate));
+}
+
+void PeerConnection::prioritizeCachedCandidate(std::vector<Candidate> &candidates) {
+	if (!config.enableConnectionCache)
+		return;
+
+	auto remote = remoteDescription();
+	if (!remote || !remote->fingerprint())
+		return;
+
+	auto cached = CandidatePairCache::Instance().retrieve(remote->fingerprint()->value);
+	if (!cached)
+		return;
+
+	// The candidate replaces the signaled one with the same address, it is added anyway if it was
+	// not signaled (yet) since the peer is likely reachable at the same address
+	PLOG_DEBUG << "Checking cached remote candidate first: " << *cached;
+	auto same = [&](Candidate &candidate) {
+		candidate.resolve(Candidate::ResolveMode::Simple);
+		return candidate.isResolved() &&
+		       candidate.transportType() == Candidate::TransportType::Udp &&
+		       candidate.address() == cached->address() && candidate.port() == cached->port();
+	};
+	candidates.erase(std::remove_if(candidates.begin(), candidates.end(), same), candidates.end());
+	candidates.insert(candidates.begin(), std::move(*cached));
+}
+
 string PeerConnection::localBundleMid() const {
 	std::lock_guard lock(mLocalDescriptionMutex);
 	return mLocalDescription ? mLocalDescription->bundleMid() : "0";
@@ -1196,7 +1736,7 @@ bool PeerConnection::negotiationNeeded() const {
 
 	{
 		std::shared_lock lock(mDataChannelsMutex);
-		if (!mDataChannels.empty() || !mUnassignedDataChannels.empty())
+		if (mDataChannelsCount > 0 || !mUnassignedDataChannels.empty())
 			if(!description || !description->hasApplication()) {
 				PLOG_DEBUG << "Negotiation needed for data channels";
 				return true;
@@ -1214,8 +1754,9 @@ bool PeerConnection::negotiationNeeded() const {
 
 		if(description) {
 			for(int i = 0; i < description->mediaCount(); ++i) {
-				if (std::holds_alternative<Description::Media *>(description->media(i))) {
-					auto media = std::get<Description::Media *>(description->media(i));
+				auto entry = std::as_const(*description).media(i);
+				if (std::holds_alternative<const Description::Media *>(entry)) {
+					auto media = std::get<const Description::Media *>(entry);
 					if (!media->isRemoved())
 						if (auto it = mTracks.find(media->mid()); it != mTracks.end())
 							if (auto track = it->second.lock(); !track || track->isClosed()) {
@@ -1358,6 +1899,222 @@ bool PeerConnection::changeGatheringState(GatheringState newState) {
 	return true;
 }
 
+void PeerConnection::scheduleGatheringDeadline() {
+	// With relay policy, only relayed candidates are issued so there is nothing to finalize early
+	if (!config.gatheringDeadline || config.iceTransportPolicy == TransportPolicy::Relay)
+		return;
+
+	std::lock_guard lock(mGatheringDeadlineMutex);
+	mGatheringDeadlineTimer.cancel();
+	mGatheringDeadlineTimer = ThreadPool::Instance().setTimer(
+	    *config.gatheringDeadline, [weak_this = weak_from_this()]() {
+		    if (auto locked = weak_this.lock()) {
+			    PLOG_DEBUG << "Gathering deadline reached";
+			    locked->completeGatheringEarly();
+		    }
+	    });
+}
+
+void PeerConnection::cancelGatheringDeadline() {
+	std::lock_guard lock(mGatheringDeadlineMutex);
+	mGatheringDeadlineTimer.cancel();
+}
+
+void PeerConnection::completeGatheringEarly() {
+	if (!config.gatheringDeadline || config.iceTransportPolicy == TransportPolicy::Relay)
+		return;
+
+	// The local description stays open, so late candidates still trickle
+	if (gatheringState.load() == GatheringState::InProgress &&
+	    changeGatheringState(GatheringState::Complete)) {
+		PLOG_DEBUG << "Gathering completed early, remaining candidates will trickle";
+		cancelGatheringDeadline();
+	}
+}
+
+bool PeerConnection::beginIceRecovery() {
+	// Only an established connection is worth keeping, DTLS and SCTP don't depend on the path
+	if (!config.iceDisconnectedTimeout || state.load() != State::Connected)
+		return false;
+
+	std::lock_guard lock(mIceRecoveryMutex);
+	if (mIceRecovering)
+		return true;
+
+	PLOG_INFO << "ICE disconnected, waiting for a new path";
+	mIceRecovering = true;
+	mIceRecoveryTimer = ThreadPool::Instance().setTimer(
+	    *config.iceDisconnectedTimeout, [weak_this = weak_from_this()]() {
+		    auto locked = weak_this.lock();
+		    if (!locked)
+			    return;
+
+		    {
+			    std::lock_guard lock(locked->mIceRecoveryMutex);
+			    if (!locked->mIceRecovering)
+				    return;
+
+			    locked->mIceRecovering = false;
+		    }
+		    PLOG_WARNING << "ICE did not recover before the timeout, closing";
+		    locked->mProcessor.enqueue(&PeerConnection::remoteClose, locked);
+	    });
+	return true;
+}
+
+bool PeerConnection::endIceRecovery() {
+	{
+		std::lock_guard lock(mIceRecoveryMutex);
+		if (!mIceRecovering)
+			return false;
+
+		mIceRecovering = false;
+		mIceRecoveryTimer.cancel();
+	}
+
+	Candidate local, remote;
+	if (auto transport = std::atomic_load(&mIceTransport);
+	    transport && transport->getSelectedCandidatePair(&local, &remote))
+		PLOG_INFO << "ICE recovered without a new handshake, path is now " << local << " <-> "
+		          << remote;
+	else
+		PLOG_INFO << "ICE recovered without a new handshake";
+
+	return true;
+}
+
+void PeerConnection::cancelIceRecovery() {
+	std::lock_guard lock(mIceRecoveryMutex);
+	mIceRecovering = false;
+	mIceRecoveryTimer.cancel();
+}
+
+void PeerConnection::scheduleReports() {
+	std::lock_guard lock(mReportMutex);
+	if (mReportTimer || mReportsCancelled)
+		return;
+
+	// RFC 3550 6.3.1: The interval is randomized to avoid synchronization, and divided by e-3/2 to
+	// compensate for the timer reconsideration algorithm converging under the average value
+	auto engine = utils::random_engine();
+	const double factor = std::uniform_real_distribution<double>(0.5, 1.5)(engine) / 1.21828;
+	const auto interval =
+	    std::chrono::duration_cast<std::chrono::milliseconds>(mReportInterval * factor);
+
+	mReportTimer = ThreadPool::Instance().setTimer(
+	    interval, [weak_this = weak_from_this()]() {
+		    if (auto locked = weak_this.lock()) {
+			    {
+				    std::lock_guard lock(locked->mReportMutex);
+				    locked->mReportTimer = Timer();
+			    }
+			    locked->sendReports();
+			    locked->scheduleReports();
+		    }
+	    });
+}
+
+void PeerConnection::cancelReports() {
+	std::lock_guard lock(mReportMutex);
+	mReportTimer.cancel();
+	mReportsCancelled = true;
+}
+
+void PeerConnection::sendReports() {
+#if RTC_ENABLE_MEDIA
+	// Reports of all tracks are sent together, as they share the bundled transport
+	std::vector<RtcpSrReporter::Report> reports;
+	std::vector<RtcpReportBlock> blocks;
+	std::vector<binary> feedback;
+	optional<SSRC> localSsrc;
+	optional<string> localCname;
+	shared_ptr<Track> sender;
+	uint64_t rtpBytes = 0;
+	iterateTracks([&](shared_ptr<Track> track) {
+		if (!track->isOpen())
+			return;
+
+		const auto stats = track->stats();
+		rtpBytes += stats.rtpBytesSent + stats.rtpBytesReceived;
+
+		const size_t count = reports.size() + blocks.size();
+		std::function<void(shared_ptr<MediaHandler>)> collect;
+		collect = [&](shared_ptr<MediaHandler> handler) {
+			for (; handler; handler = handler->next()) {
+				if (auto reporter = std::dynamic_pointer_cast<RtcpSrReporter>(handler)) {
+					if (auto report = reporter->prepareReport())
+						reports.push_back(std::move(*report));
+
+				} else if (auto session = std::dynamic_pointer_cast<RtcpReceivingSession>(handler)) {
+					auto sessionBlocks = session->prepareReportBlocks();
+					blocks.insert(blocks.end(), sessionBlocks.begin(), sessionBlocks.end());
+					if (auto packet = session->prepareFeedback(); !packet.empty())
+						feedback.push_back(std::move(packet));
+				}
+				collect(handler->inner());
+			}
+		};
+		collect(track->getMediaHandler());
+
+		if (!localSsrc) {
+			const auto description = track->description();
+			if (auto ssrcs = description.getSSRCs(); !ssrcs.empty()) {
+				localSsrc = ssrcs.front();
+				localCname = description.getCNameForSsrc(*localSsrc);
+			}
+		}
+
+		if (!sender && reports.size() + blocks.size() > count)
+			sender = track;
+	});
+
+	if (!sender)
+		return;
+
+	// Receive-only endpoints have no SSRC, 1 is used like other implementations
+	const SSRC receiverSsrc = localSsrc.value_or(1);
+	const string receiverCname = localCname.value_or(mReportCname);
+	const size_t maxSize = pathMtu() - 14 - 8 - 40; // SRTCP/UDP/IPv6
+	size_t sentSize = 0, sentCount = 0;
+	try {
+		for (auto &message : RtcpSrReporter::MakeCompoundPackets(
+		         reports, blocks, receiverSsrc, receiverCname, maxSize, feedback)) {
+			sentSize += message->size();
+			++sentCount;
+			sender->transportSend(std::move(message));
+		}
+
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "Failed to send RTCP reports: " << e.what();
+	}
+
+	// RFC 3550 6.3.1: Compute the next deterministic interval from the average RTCP packet size,
+	// the number of members, and the bandwidth observed since the last reports
+	const auto now = std::chrono::steady_clock::now();
+	std::lock_guard lock(mReportMutex);
+	for (size_t i = 0; i < sentCount; ++i) {
+		const double size = double(sentSize / sentCount + RtcpOverhead);
+		mAvgRtcpSize = mAvgRtcpSize > 0. ? mAvgRtcpSize + (size - mAvgRtcpSize) / 16. : size;
+	}
+
+	const double elapsed = std::chrono::duration<double>(now - mLastReportTime).count();
+	if (mLastReportTime != std::chrono::steady_clock::time_point() && elapsed > 0. &&
+	    rtpBytes > mLastRtpBytes) {
+		const double bandwidth = double(rtpBytes - mLastRtpBytes) * 8. / elapsed; // bit/s
+		const size_t members = reports.size() + blocks.size() + 1;
+		const double interval =
+		    double(members) * mAvgRtcpSize * 8. / (bandwidth * RtcpBandwidthFraction);
+		mReportInterval = std::max(std::chrono::duration<double>(interval),
+		                           std::chrono::duration<double>(MinReportInterval));
+	} else {
+		mReportInterval = MinReportInterval;
+	}
+
+	mLastRtpBytes = rtpBytes;
+	mLastReportTime = now;
+#endif
+}
+
 bool PeerConnection::changeSignalingState(SignalingState newState) {
 	if (signalingState.exchange(newState) == newState)
 		return false;
@@ -1376,6 +2133,7 @@ void PeerConnection::resetCallbacks() {
 	dataChannelCallback = nullptr;
 	localDescriptionCallback = nullptr;
 	localCandidateCallback = nullptr;
+	localCandidatesCallback = nullptr;
 	stateChangeCallback = nullptr;
 	iceStateChangeCallback = nullptr;
 	gatheringStateChangeCallback = nullptr;
@@ -1391,39 +2149,90 @@ CertificateFingerprint PeerConnection::remoteFingerprint() {
 		return {};
 }
 
-void PeerConnection::updateTrackSsrcCache(const Description &description) {
+void PeerConnection::updateTrackSsrcCache(const Description &description,
+                                          const std::vector<int> &changed,
+                                          const optional<Description> &previous) {
+	if (changed.empty())
+		return;
+
+	// SSRCs previously announced for each mid, which may have been removed since
+	std::unordered_map<string, std::vector<uint32_t>> previousSsrcs;
+	if (previous)
+		for (int i = 0; i < previous->mediaCount(); ++i) {
+			auto entry = previous->media(i);
+			if (auto media = std::get_if<const Description::Media *>(&entry))
+				previousSsrcs.emplace((*media)->mid(), (*media)->getSSRCs());
+		}
+
 	std::unique_lock lock(mTracksMutex); // for safely writing to mTracksBySsrc
 
-	// Setup SSRC -> Track mapping
-	for (int i = 0; i < description.mediaCount(); ++i)
-		std::visit( // ssrc -> track mapping
-		    rtc::overloaded{
-		        [&](Description::Application const *) { return; },
-		        [&](Description::Media const *media) {
-			        const auto ssrcs = media->getSSRCs();
-
-			        // Note: We don't want to lock (or do any other lookups), if we
-			        // already know there's no SSRCs to loop over.
-			        if (ssrcs.size() <= 0) {
-				        return;
-			        }
-
-			        std::shared_ptr<Track> track{nullptr};
-			        if (auto it = mTracks.find(media->mid()); it != mTracks.end())
-				        if (auto track_for_mid = it->second.lock())
-					        track = track_for_mid;
-
-			        if (!track) {
-				        // Unable to find track for MID
-				        return;
-			        }
-
-			        for (auto ssrc : ssrcs) {
-				        mTracksBySsrc.insert_or_assign(ssrc, track);
-			        }
-		        },
-		    },
-		    description.media(i));
+	// Patch the SSRC -> Track mapping for changed media only
+	bool updated = false;
+	for (int i : changed) {
+		auto entry = description.media(i);
+		auto media = std::get_if<const Description::Media *>(&entry);
+		if (!media)
+			continue;
+
+		shared_ptr<Track> track;
+		if (auto it = mTracks.find((*media)->mid()); it != mTracks.end())
+			track = it->second.lock();
+
+		if (!track) {
+			// Unable to find track for MID
+			continue;
+		}
+
+		const auto ssrcs = (*media)->getSSRCs();
+		if (auto it = previousSsrcs.find((*media)->mid()); it != previousSsrcs.end()) {
+			for (auto ssrc : it->second) {
+				if (std::find(ssrcs.begin(), ssrcs.end(), ssrc) != ssrcs.end())
+					continue;
+
+				// The SSRC is not announced anymore
+				if (auto jt = mTracksBySsrc.find(ssrc);
+				    jt != mTracksBySsrc.end() && jt->second.lock() == track) {
+					mTracksBySsrc.erase(jt);
+					updated = true;
+				}
+			}
+		}
+
+		auto &learned = mLearnedSsrcs[(*media)->mid()];
+		for (auto ssrc : ssrcs) {
+			// A signaled SSRC is not subject to the learned SSRCs cap
+			learned.erase(std::remove(learned.begin(), learned.end(), ssrc), learned.end());
+			mTracksBySsrc.insert_or_assign(ssrc, track);
+			updated = true;
+		}
+	}
+
+	if (updated)
+		publishTrackRoutes();
+}
+
+void PeerConnection::publishTrackRoutes() {
+	// Requires mTracksMutex to be locked
+	auto routes = std::make_shared<TrackRoutes>();
+	routes->bySsrc = mTracksBySsrc;
+	for (const auto &[mid, weakTrack] : mTracks) {
+		auto track = weakTrack.lock();
+		if (!track)
+			continue;
+
+		routes->byMid.emplace(mid, track);
+		if (routes->midExtId == 0) {
+			auto description = track->description();
+			for (int extId : description.extIds())
+				if (description.extMap(extId)->uri == "urn:ietf:params:rtp-hdrext:sdes:mid" &&
+				    extId > 0 && extId < 256)
+					routes->midExtId = uint8_t(extId);
+		}
+	}
+	if (mTrackLines.size() == 1)
+		routes->single = mTrackLines.front();
+
+	std::atomic_store(&mTrackRoutes, shared_ptr<const TrackRoutes>(std::move(routes)));
 }
 
 } // namespace rtc::impl
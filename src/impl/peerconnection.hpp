@@ -20,6 +20,7 @@
 
 #include "rtc/peerconnection.hpp"
 
+#include <deque>
 #include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
@@ -42,6 +43,9 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	optional<Description> localDescription() const;
 	optional<Description> remoteDescription() const;
 	size_t remoteMaxMessageSize() const;
+	size_t pathMtu() const;
+	void setPathMtu(size_t mtu);
+	void setDataChannelPacer(shared_ptr<MediaHandler> pacer);
 
 	shared_ptr<IceTransport> initIceTransport();
 	shared_ptr<DtlsTransport> initDtlsTransport();
@@ -49,16 +53,22 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	shared_ptr<IceTransport> getIceTransport() const;
 	shared_ptr<DtlsTransport> getDtlsTransport() const;
 	shared_ptr<SctpTransport> getSctpTransport() const;
+	size_t memoryUsage();
 	void closeTransports();
+	void prewarm(); // initializes what does not depend on signaling, for PeerConnectionPool
 
 	void endLocalCandidates();
 	void rollbackLocalDescription();
 	bool checkFingerprint(const std::string &fingerprint);
 	void forwardMessage(message_ptr message);
-	void forwardMedia(message_ptr message);
-	void forwardBufferedAmount(uint16_t stream, size_t amount);
+	void forwardMedia(message_vector messages);
+	void forwardBufferedAmount(size_t amount);
+	void storeCandidatePair();
+	void prioritizeCachedCandidate(std::vector<Candidate> &candidates);
 
 	shared_ptr<DataChannel> emplaceDataChannel(string label, DataChannelInit init);
+	std::vector<shared_ptr<DataChannel>> emplaceNegotiatedDataChannels(std::vector<string> labels,
+	                                                                   DataChannelInit init);
 	std::pair<shared_ptr<DataChannel>, bool> findDataChannel(uint16_t stream);
 	bool removeDataChannel(uint16_t stream);
 	uint16_t maxDataChannelStream() const;
@@ -80,6 +90,7 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	void processLocalCandidate(Candidate candidate);
 	void processRemoteDescription(Description description);
 	void processRemoteCandidate(Candidate candidate);
+	void processRemoteCandidates(std::vector<Candidate> candidates);
 	string localBundleMid() const;
 
 	bool negotiationNeeded() const;
@@ -99,7 +110,17 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	bool changeState(State newState);
 	bool changeIceState(IceState newState);
 	bool changeGatheringState(GatheringState newState);
+	void scheduleGatheringDeadline();
+	void cancelGatheringDeadline();
+	void completeGatheringEarly(); // if the gathering deadline is enabled
+	void flushLocalCandidates();   // triggers the batch callback with pending candidates
+	bool beginIceRecovery();       // if the disconnected timeout is enabled
+	bool endIceRecovery();
+	void cancelIceRecovery();
 	bool changeSignalingState(SignalingState newState);
+	void scheduleReports();
+	void cancelReports();
+	void sendReports();
 
 	void resetCallbacks();
 
@@ -125,6 +146,7 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	synchronized_callback<shared_ptr<rtc::DataChannel>> dataChannelCallback;
 	synchronized_callback<Description> localDescriptionCallback;
 	synchronized_callback<Candidate> localCandidateCallback;
+	synchronized_callback<std::vector<Candidate>> localCandidatesCallback; // takes precedence
 	synchronized_callback<State> stateChangeCallback;
 	synchronized_callback<IceState> iceStateChangeCallback;
 	synchronized_callback<GatheringState> gatheringStateChangeCallback;
@@ -132,12 +154,15 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	synchronized_callback<shared_ptr<rtc::Track>> trackCallback;
 
 private:
-	void dispatchMedia(message_ptr message);
-	void updateTrackSsrcCache(const Description &description);
+	void dispatchMedia(message_vector messages);
+	void updateTrackSsrcCache(const Description &description, const std::vector<int> &changed,
+	                          const optional<Description> &previous);
+	void publishTrackRoutes(); // requires mTracksMutex to be locked
 
 	const init_token mInitToken = Init::Instance().token();
 	future_certificate_ptr mCertificate;
 
+	shared_ptr<Executor> mExecutor; // set with executor affinity
 	Processor mProcessor;
 	optional<Description> mLocalDescription;
 	optional<Description> mCurrentLocalDescription;
@@ -155,15 +180,63 @@ private:
 	shared_ptr<DtlsTransport> mDtlsTransport;
 	shared_ptr<SctpTransport> mSctpTransport;
 
-	std::unordered_map<uint16_t, weak_ptr<DataChannel>> mDataChannels; // by stream ID
+	// DataChannels by stream ID in a flat array grown on demand, for constant-time lookup
+	struct DataChannelSlot {
+		weak_ptr<DataChannel> channel;
+		bool used = false;
+	};
+	std::vector<DataChannelSlot> mDataChannels;
+	size_t mDataChannelsCount = 0; // used slots
+	bool isDataChannelStreamUsed(uint16_t stream) const;                    // requires lock
+	bool insertDataChannel(uint16_t stream, weak_ptr<DataChannel> channel); // requires lock
 	std::vector<weak_ptr<DataChannel>> mUnassignedDataChannels;
 	mutable std::shared_mutex mDataChannelsMutex;
 
 	std::unordered_map<string, weak_ptr<Track>> mTracks;         // by mid
 	std::unordered_map<uint32_t, weak_ptr<Track>> mTracksBySsrc; // by SSRC
+	std::unordered_map<string, std::deque<uint32_t>> mLearnedSsrcs; // not signaled, by MID
+	static const size_t MaxLearnedSsrcsPerTrack = 16;
 	std::vector<weak_ptr<Track>> mTrackLines;                    // by SDP order
 	mutable std::shared_mutex mTracksMutex;
 
+	// Immutable routing snapshot for incoming media, replaced atomically when tracks change so
+	// that dispatchMedia() doesn't take mTracksMutex for every packet
+	struct TrackRoutes {
+		std::unordered_map<uint32_t, weak_ptr<Track>> bySsrc;
+		std::unordered_map<string, weak_ptr<Track>> byMid;
+		optional<weak_ptr<Track>> single; // set iff there is exactly one track line
+		uint8_t midExtId = 0;             // MID header extension id, 0 if not negotiated
+	};
+	shared_ptr<const TrackRoutes> mTrackRoutes;
+
+	struct TrackBatches; // messages grouped by track
+	bool dispatchRtcp(const message_ptr &message, const TrackRoutes &routes, TrackBatches &batches);
+	shared_ptr<Track> routeBySsrc(const Message &message, const TrackRoutes &routes);
+	shared_ptr<Track> routeByMid(const Message &message, const TrackRoutes &routes) const;
+
+	Timer mGatheringDeadlineTimer;
+	std::mutex mGatheringDeadlineMutex;
+
+	std::vector<Candidate> mPendingLocalCandidates; // for localCandidatesCallback
+	Timer mLocalCandidatesTimer;                    // set while candidates are pending
+	std::mutex mLocalCandidatesMutex;
+
+	Timer mIceRecoveryTimer;
+	std::atomic<bool> mIceRecovering = false;
+	std::mutex mIceRecoveryMutex;
+
+	std::atomic<size_t> mPathMtu = 0; // 0 if not set, Configuration::mtu is used instead
+	shared_ptr<MediaHandler> mDataChannelPacer; // accessed atomically
+
+	Timer mReportTimer; // set while reports are scheduled, kept once cancelled
+	bool mReportsCancelled = false;
+	std::chrono::duration<double> mReportInterval; // deterministic interval, see RFC 3550 6.3.1
+	double mAvgRtcpSize = 0.;                      // in bytes, including UDP/IP headers
+	uint64_t mLastRtpBytes = 0;
+	std::chrono::steady_clock::time_point mLastReportTime;
+	const string mReportCname; // for receiver reports if no local track has a CNAME
+	std::mutex mReportMutex;
+
 	Queue<shared_ptr<DataChannel>> mPendingDataChannels;
 	Queue<shared_ptr<Track>> mPendingTracks;
 };
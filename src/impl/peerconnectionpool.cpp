@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "peerconnectionpool.hpp"
+#include "internals.hpp"
+#include "peerconnection.hpp"
+#include "threadpool.hpp"
+
+namespace rtc::impl {
+
+PeerConnectionPool::PeerConnectionPool(Configuration config_, size_t size_)
+    : config(std::move(config_)), size(size_) {
+	PLOG_VERBOSE << "Creating PeerConnection pool, size=" << size;
+}
+
+PeerConnectionPool::~PeerConnectionPool() { PLOG_VERBOSE << "Destroying PeerConnection pool"; }
+
+void PeerConnectionPool::start() {
+	std::lock_guard lock(mMutex);
+	mStarted = true;
+	refill();
+}
+
+void PeerConnectionPool::stop() {
+	std::deque<shared_ptr<rtc::PeerConnection>> connections;
+	{
+		std::lock_guard lock(mMutex);
+		mStarted = false;
+		std::swap(connections, mConnections);
+	}
+
+	for (auto &pc : connections)
+		pc->close();
+}
+
+shared_ptr<rtc::PeerConnection> PeerConnectionPool::take() {
+	{
+		std::lock_guard lock(mMutex);
+		while (!mConnections.empty()) {
+			auto pc = std::move(mConnections.front());
+			mConnections.pop_front();
+			refill();
+
+			// A pooled connection might have failed in the meantime
+			if (pc->state() == rtc::PeerConnection::State::New)
+				return pc;
+		}
+
+		refill();
+	}
+
+	PLOG_DEBUG << "PeerConnection pool is empty, creating a connection";
+	return std::make_shared<rtc::PeerConnection>(config);
+}
+
+size_t PeerConnectionPool::available() const {
+	std::lock_guard lock(mMutex);
+	return mConnections.size();
+}
+
+shared_ptr<rtc::PeerConnection> PeerConnectionPool::create() const {
+	auto pc = std::make_shared<rtc::PeerConnection>(config);
+	pc->impl()->prewarm();
+	return pc;
+}
+
+void PeerConnectionPool::refill() {
+	// Requires mMutex to be locked
+	if (!mStarted || mRefilling || mConnections.size() >= size)
+		return;
+
+	mRefilling = true;
+	ThreadPool::Control().post([weak_this = weak_from_this()]() {
+		if (auto locked = weak_this.lock())
+			locked->fill();
+	});
+}
+
+void PeerConnectionPool::fill() {
+	shared_ptr<rtc::PeerConnection> pc;
+	try {
+		pc = create();
+
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "Failed to create a pooled PeerConnection: " << e.what();
+		std::lock_guard lock(mMutex);
+		mRefilling = false; // retried on next take
+		return;
+	}
+
+	std::unique_lock lock(mMutex);
+	mRefilling = false;
+	if (!mStarted) {
+		lock.unlock();
+		pc->close();
+		return;
+	}
+
+	mConnections.push_back(std::move(pc));
+	PLOG_VERBOSE << "PeerConnection pool filled to " << mConnections.size() << '/' << size;
+
+	// One connection per task, so that the control pool is not held for long
+	refill();
+}
+
+} // namespace rtc::impl
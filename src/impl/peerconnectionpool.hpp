@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_PEER_CONNECTION_POOL_H
+#define RTC_IMPL_PEER_CONNECTION_POOL_H
+
+#include "common.hpp"
+#include "init.hpp"
+
+#include "rtc/peerconnection.hpp"
+
+#include <deque>
+#include <mutex>
+
+namespace rtc::impl {
+
+struct PeerConnectionPool final : std::enable_shared_from_this<PeerConnectionPool> {
+	PeerConnectionPool(Configuration config_, size_t size_);
+	~PeerConnectionPool();
+
+	void start();
+	void stop();
+
+	shared_ptr<rtc::PeerConnection> take();
+	size_t available() const;
+
+	const Configuration config;
+	const size_t size;
+
+private:
+	shared_ptr<rtc::PeerConnection> create() const;
+	void refill(); // requires mMutex to be locked
+	void fill();
+
+	const init_token mInitToken = Init::Instance().token();
+
+	std::deque<shared_ptr<rtc::PeerConnection>> mConnections;
+	bool mStarted = false;
+	bool mRefilling = false;
+	mutable std::mutex mMutex;
+};
+
+} // namespace rtc::impl
+
+#endif
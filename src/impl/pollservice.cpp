@@ -14,6 +14,18 @@
 
 #include <algorithm>
 #include <cassert>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if RTC_POLL_SERVICE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif RTC_POLL_SERVICE_KQUEUE
+#include <sys/event.h>
+#include <unistd.h>
+#endif
 
 namespace rtc::impl {
 
@@ -21,23 +33,166 @@ using namespace std::chrono_literals;
 using std::chrono::duration_cast;
 using std::chrono::milliseconds;
 
+// Timeouts are rounded up to coarse ticks, so that timeouts of many sockets expire together and
+// are processed in a single wakeup
+const auto TimeoutTick = 250ms;
+
+// Each loop runs its own thread with its own socket set
+class PollService::Loop final {
+public:
+	Loop();
+	~Loop();
+
+	void start();
+	void join();
+	void add(socket_t sock, Params params);
+	void remove(socket_t sock);
+	void addStats(PollServiceStats &stats);
+
+private:
+	using Callback = std::function<void(Event)>;
+	using TodoList = std::vector<std::pair<Callback, Event>>;
+	using TimeoutMap = std::multimap<clock::time_point, socket_t>;
+
+	// Activity only moves the deadline forward, the scheduled check is moved lazily when it
+	// fires, so busy sockets don't touch the timeout map on every event
+	struct SocketEntry {
+		Params params;
+		optional<TimeoutMap::iterator> until; // scheduled check, not later than the deadline tick
+		clock::time_point deadline;
+	};
+
+	struct Events {
+		bool in = false;
+		bool out = false;
+		bool hup = false;
+		bool error = false;
+	};
+
+	// The following functions expect mMutex to be locked
+	void registerSocket(socket_t sock, Direction direction, bool update);
+	void unregisterSocket(socket_t sock);
+	void resetTimeout(socket_t sock, SocketEntry &entry);
+	void scheduleTimeout(socket_t sock, SocketEntry &entry);
+	void erase(socket_t sock);
+	void processEvents(socket_t sock, Events events, TodoList &todo);
+
+	int waitTimeout(); // in milliseconds, -1 means infinite
+	void wait(int timeout, TodoList &todo);
+	void processTimeouts(TodoList &todo);
+	void runLoop();
+
+	using SocketMap = std::unordered_map<socket_t, SocketEntry>;
+	unique_ptr<SocketMap> mSocks;
+	unique_ptr<TimeoutMap> mTimeouts;
+	unique_ptr<PollInterrupter> mInterrupter;
+
+#if RTC_POLL_SERVICE_EPOLL || RTC_POLL_SERVICE_KQUEUE
+	int mPollFd = -1; // persistent registrations
+	int mInterrupterFd = -1;
+#else
+	std::vector<struct pollfd> mPollFds;
+#endif
+
+	std::recursive_mutex mMutex;
+	std::thread mThread;
+	bool mStopped;
+
+	std::atomic<uint64_t> mWakeups = 0;
+	std::atomic<uint64_t> mBusyTime = 0; // in nanoseconds
+};
+
 PollService &PollService::Instance() {
 	static PollService *instance = new PollService;
 	return *instance;
 }
 
-PollService::PollService() : mStopped(true) {}
+PollService::PollService() {}
 
 PollService::~PollService() {}
 
-void PollService::start() {
+void PollService::start(unsigned int count) {
+	count = std::max(count, 1u);
+	PLOG_DEBUG << "Starting poll service with " << count << " threads";
+	for (unsigned int i = 0; i < count; ++i) {
+		auto loop = std::make_unique<Loop>();
+		loop->start();
+		mLoops.emplace_back(std::move(loop));
+	}
+}
+
+void PollService::join() {
+	for (auto &loop : mLoops)
+		loop->join();
+
+	mLoops.clear();
+}
+
+void PollService::add(socket_t sock, Params params) { loop(sock).add(sock, std::move(params)); }
+
+void PollService::remove(socket_t sock) { loop(sock).remove(sock); }
+
+PollServiceStats PollService::stats() const {
+	PollServiceStats stats;
+	stats.threads = mLoops.size();
+	for (auto &loop : mLoops)
+		loop->addStats(stats);
+
+	return stats;
+}
+
+PollService::Loop &PollService::loop(socket_t sock) {
+	assert(!mLoops.empty());
+	// Sockets are assigned to loops by descriptor so that add() and remove() always agree
+#ifdef _WIN32
+	const size_t index = size_t(sock) >> 2; // socket handles are multiples of 4
+#else
+	const size_t index = size_t(sock);
+#endif
+	return *mLoops[index % mLoops.size()];
+}
+
+PollService::Loop::Loop() : mStopped(true) {}
+
+PollService::Loop::~Loop() {}
+
+void PollService::Loop::start() {
 	mSocks = std::make_unique<SocketMap>();
+	mTimeouts = std::make_unique<TimeoutMap>();
 	mInterrupter = std::make_unique<PollInterrupter>();
+
+	struct pollfd pfd = {};
+	mInterrupter->prepare(pfd);
+#if RTC_POLL_SERVICE_EPOLL
+	mPollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	if (mPollFd < 0)
+		throw std::runtime_error("epoll_create1 failed, errno=" + std::to_string(errno));
+
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN; // level-triggered, drained by the interrupter
+	ev.data.fd = pfd.fd;
+	if (::epoll_ctl(mPollFd, EPOLL_CTL_ADD, pfd.fd, &ev) < 0)
+		throw std::runtime_error("epoll_ctl failed, errno=" + std::to_string(errno));
+
+	mInterrupterFd = pfd.fd;
+#elif RTC_POLL_SERVICE_KQUEUE
+	mPollFd = ::kqueue();
+	if (mPollFd < 0)
+		throw std::runtime_error("kqueue failed, errno=" + std::to_string(errno));
+
+	struct kevent change;
+	EV_SET(&change, pfd.fd, EVFILT_READ, EV_ADD, 0, 0, NULL); // level-triggered
+	if (::kevent(mPollFd, &change, 1, NULL, 0, NULL) < 0)
+		throw std::runtime_error("kevent failed, errno=" + std::to_string(errno));
+
+	mInterrupterFd = pfd.fd;
+#endif
+
 	mStopped = false;
-	mThread = std::thread(&PollService::runLoop, this);
+	mThread = std::thread(&Loop::runLoop, this);
 }
 
-void PollService::join() {
+void PollService::Loop::join() {
 	std::unique_lock lock(mMutex);
 	if (std::exchange(mStopped, true))
 		return;
@@ -47,163 +202,386 @@ void PollService::join() {
 	mInterrupter->interrupt();
 	mThread.join();
 
+#if RTC_POLL_SERVICE_EPOLL || RTC_POLL_SERVICE_KQUEUE
+	::close(mPollFd);
+	mPollFd = -1;
+	mInterrupterFd = -1;
+#endif
+
 	mSocks.reset();
+	mTimeouts.reset();
 	mInterrupter.reset();
 }
 
-void PollService::add(socket_t sock, Params params) {
+void PollService::Loop::add(socket_t sock, Params params) {
 	assert(sock != INVALID_SOCKET);
 	assert(params.callback);
 
 	std::unique_lock lock(mMutex);
 	PLOG_VERBOSE << "Registering socket in poll service, direction=" << params.direction;
-	auto until = params.timeout ? std::make_optional(clock::now() + *params.timeout) : nullopt;
 	assert(mSocks);
-	mSocks->insert_or_assign(sock, SocketEntry{std::move(params), std::move(until)});
+	auto it = mSocks->find(sock);
+	const bool update = it != mSocks->end();
+	if (update)
+		it->second.params = std::move(params);
+	else
+		it = mSocks->emplace(sock, SocketEntry{std::move(params), nullopt, {}}).first;
 
-	assert(mInterrupter);
-	mInterrupter->interrupt();
+	try {
+		registerSocket(sock, it->second.params.direction, update);
+	} catch (...) {
+		erase(sock);
+		throw;
+	}
+
+	// Only interrupt if the wait timeout is now shorter, registrations are persistent
+	assert(mTimeouts);
+	resetTimeout(sock, it->second);
+	bool interrupt = it->second.until && *it->second.until == mTimeouts->begin();
+#if !RTC_POLL_SERVICE_EPOLL && !RTC_POLL_SERVICE_KQUEUE
+	interrupt = true; // the poll set must be prepared again
+#endif
+	if (interrupt) {
+		assert(mInterrupter);
+		mInterrupter->interrupt();
+	}
 }
 
-void PollService::remove(socket_t sock) {
+void PollService::Loop::remove(socket_t sock) {
 	assert(sock != INVALID_SOCKET);
 
 	std::unique_lock lock(mMutex);
 	PLOG_VERBOSE << "Unregistering socket in poll service";
 	assert(mSocks);
-	mSocks->erase(sock);
+	erase(sock);
 
+#if !RTC_POLL_SERVICE_EPOLL && !RTC_POLL_SERVICE_KQUEUE
 	assert(mInterrupter);
 	mInterrupter->interrupt();
+#endif
+}
+
+void PollService::Loop::addStats(PollServiceStats &stats) {
+	{
+		std::unique_lock lock(mMutex);
+		if (mSocks)
+			stats.sockets += mSocks->size();
+	}
+	stats.wakeups += mWakeups.load(std::memory_order_relaxed);
+	stats.busyTime += std::chrono::nanoseconds(mBusyTime.load(std::memory_order_relaxed));
+}
+
+void PollService::Loop::registerSocket([[maybe_unused]] socket_t sock,
+                                 [[maybe_unused]] Direction direction,
+                                 [[maybe_unused]] bool update) {
+#if RTC_POLL_SERVICE_EPOLL
+	struct epoll_event ev = {};
+	ev.events = EPOLLET; // edge-triggered
+	if (direction != Direction::Out)
+		ev.events |= EPOLLIN;
+	if (direction != Direction::In)
+		ev.events |= EPOLLOUT;
+
+	ev.data.fd = sock;
+	// Modifying also re-arms the edge-triggered events
+	if (::epoll_ctl(mPollFd, update ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, sock, &ev) < 0) {
+		int op = errno == ENOENT ? EPOLL_CTL_ADD : errno == EEXIST ? EPOLL_CTL_MOD : -1;
+		if (op < 0 || ::epoll_ctl(mPollFd, op, sock, &ev) < 0)
+			throw std::runtime_error("epoll_ctl failed, errno=" + std::to_string(errno));
+	}
+#elif RTC_POLL_SERVICE_KQUEUE
+	struct kevent changes[2];
+	EV_SET(&changes[0], sock, EVFILT_READ, direction != Direction::Out ? EV_ADD | EV_CLEAR : EV_DELETE,
+	       0, 0, NULL);
+	EV_SET(&changes[1], sock, EVFILT_WRITE, direction != Direction::In ? EV_ADD | EV_CLEAR : EV_DELETE,
+	       0, 0, NULL);
+	for (auto &change : changes)
+		if (::kevent(mPollFd, &change, 1, NULL, 0, NULL) < 0 &&
+		    !(change.flags & EV_DELETE && errno == ENOENT))
+			throw std::runtime_error("kevent failed, errno=" + std::to_string(errno));
+#endif
+}
+
+void PollService::Loop::unregisterSocket([[maybe_unused]] socket_t sock) {
+	// Errors are ignored as the socket might already be closed
+#if RTC_POLL_SERVICE_EPOLL
+	::epoll_ctl(mPollFd, EPOLL_CTL_DEL, sock, NULL);
+#elif RTC_POLL_SERVICE_KQUEUE
+	struct kevent change;
+	EV_SET(&change, sock, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+	::kevent(mPollFd, &change, 1, NULL, 0, NULL);
+	EV_SET(&change, sock, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+	::kevent(mPollFd, &change, 1, NULL, 0, NULL);
+#endif
+}
+
+void PollService::Loop::resetTimeout(socket_t sock, SocketEntry &entry) {
+	const auto &timeout = entry.params.timeout;
+	if (!timeout) {
+		if (entry.until) {
+			mTimeouts->erase(*entry.until);
+			entry.until.reset();
+		}
+		return;
+	}
+
+	entry.deadline = clock::now() + *timeout;
+
+	// An earlier check is kept, it will reschedule itself when it fires
+	if (!entry.until || (*entry.until)->first > entry.deadline + TimeoutTick)
+		scheduleTimeout(sock, entry);
+}
+
+void PollService::Loop::scheduleTimeout(socket_t sock, SocketEntry &entry) {
+	const auto tick = duration_cast<clock::duration>(TimeoutTick);
+	const auto since = entry.deadline.time_since_epoch();
+	const auto time = clock::time_point(((since + tick - clock::duration(1)) / tick) * tick);
+	if (entry.until) {
+		// Reuse the node instead of reallocating it
+		auto node = mTimeouts->extract(*entry.until);
+		node.key() = time;
+		entry.until = mTimeouts->insert(std::move(node));
+	} else {
+		entry.until = mTimeouts->emplace(time, sock);
+	}
+}
+
+void PollService::Loop::erase(socket_t sock) {
+	auto it = mSocks->find(sock);
+	if (it == mSocks->end())
+		return;
+
+	if (it->second.until)
+		mTimeouts->erase(*it->second.until);
+
+	mSocks->erase(it);
+	unregisterSocket(sock);
+}
+
+void PollService::Loop::processEvents(socket_t sock, Events events, TodoList &todo) {
+	auto it = mSocks->find(sock);
+	if (it == mSocks->end())
+		return;
+
+	try {
+		auto &entry = it->second;
+		auto &params = entry.params;
+
+		if (events.error ||
+		    (events.hup &&
+		     params.direction == Direction::Out)) { // MacOS sets POLLHUP on connection failure
+			PLOG_VERBOSE << "Poll error event";
+			todo.emplace_back(std::move(params.callback), Event::Error);
+			erase(sock);
+
+		} else if (events.in || events.out || events.hup) {
+			resetTimeout(sock, entry);
+
+			const auto &callback = params.callback; // can't move, we may need it below
+			if (events.in || events.hup) {          // Windows does not set POLLIN on close
+				PLOG_VERBOSE << "Poll in event";
+				todo.emplace_back(callback, Event::In);
+			}
+			if (events.out) {
+				PLOG_VERBOSE << "Poll out event";
+				todo.emplace_back(callback, Event::Out);
+			}
+		}
+
+	} catch (const std::exception &e) {
+		PLOG_WARNING << e.what();
+		erase(sock);
+	}
+}
+
+int PollService::Loop::waitTimeout() {
+	std::unique_lock lock(mMutex);
+	if (mTimeouts->empty()) {
+		PLOG_VERBOSE << "Entering poll";
+		return -1;
+	}
+
+	auto next = mTimeouts->begin()->first;
+	auto msecs = duration_cast<milliseconds>(
+	    std::max(clock::duration::zero(), next - clock::now() + 1ms));
+	PLOG_VERBOSE << "Entering poll, timeout=" << msecs.count() << "ms";
+	return static_cast<int>(msecs.count());
+}
+
+#if RTC_POLL_SERVICE_EPOLL
+
+void PollService::Loop::wait(int timeout, TodoList &todo) {
+	const int maxEvents = 256;
+	struct epoll_event events[maxEvents];
+	int ret;
+	do {
+		ret = ::epoll_wait(mPollFd, events, maxEvents, timeout);
+	} while (ret < 0 && errno == EINTR);
+
+	PLOG_VERBOSE << "Exiting poll";
+
+	if (ret < 0)
+		throw std::runtime_error("epoll_wait failed, errno=" + std::to_string(errno));
+
+	std::unique_lock lock(mMutex);
+	for (int i = 0; i < ret; ++i) {
+		const auto &ev = events[i];
+		if (ev.data.fd == mInterrupterFd) {
+			struct pollfd pfd = {};
+			pfd.fd = mInterrupterFd;
+			pfd.revents = POLLIN;
+			mInterrupter->process(pfd);
+			continue;
+		}
+
+		Events e;
+		e.in = ev.events & EPOLLIN;
+		e.out = ev.events & EPOLLOUT;
+		e.hup = ev.events & EPOLLHUP;
+		e.error = ev.events & EPOLLERR;
+		processEvents(ev.data.fd, e, todo);
+	}
 }
 
-void PollService::prepare(std::vector<struct pollfd> &pfds, optional<clock::time_point> &next) {
+#elif RTC_POLL_SERVICE_KQUEUE
+
+void PollService::Loop::wait(int timeout, TodoList &todo) {
+	const int maxEvents = 256;
+	struct kevent events[maxEvents];
+	struct timespec ts = {};
+	ts.tv_sec = timeout / 1000;
+	ts.tv_nsec = (timeout % 1000) * 1000000L;
+	int ret;
+	do {
+		ret = ::kevent(mPollFd, NULL, 0, events, maxEvents, timeout >= 0 ? &ts : NULL);
+	} while (ret < 0 && errno == EINTR);
+
+	PLOG_VERBOSE << "Exiting poll";
+
+	if (ret < 0)
+		throw std::runtime_error("kevent failed, errno=" + std::to_string(errno));
+
 	std::unique_lock lock(mMutex);
-	pfds.resize(1 + mSocks->size());
-	next.reset();
-
-	auto it = pfds.begin();
-	mInterrupter->prepare(*it++);
-	for (const auto &[sock, entry] : *mSocks) {
-		it->fd = sock;
-		switch (entry.params.direction) {
-		case Direction::In:
-			it->events = POLLIN;
-			break;
-		case Direction::Out:
-			it->events = POLLOUT;
-			break;
-		default:
-			it->events = POLLIN | POLLOUT;
-			break;
+	for (int i = 0; i < ret; ++i) {
+		const auto &ev = events[i];
+		const auto sock = static_cast<socket_t>(ev.ident);
+		if (sock == mInterrupterFd) {
+			struct pollfd pfd = {};
+			pfd.fd = mInterrupterFd;
+			pfd.revents = POLLIN;
+			mInterrupter->process(pfd);
+			continue;
 		}
-		if (entry.until)
-			next = next ? std::min(*next, *entry.until) : *entry.until;
 
-		++it;
+		Events e;
+		e.in = ev.filter == EVFILT_READ;
+		e.out = ev.filter == EVFILT_WRITE;
+		e.hup = ev.flags & EV_EOF;
+		e.error = ev.flags & EV_ERROR || (ev.flags & EV_EOF && ev.fflags != 0);
+		processEvents(sock, e, todo);
 	}
 }
 
-void PollService::process(std::vector<struct pollfd> &pfds) {
-	using Callback = decltype(std::declval<Params>().callback);
-	std::vector<std::pair<Callback, Event>> todo;
+#else // poll
+
+void PollService::Loop::wait(int timeout, TodoList &todo) {
 	{
 		std::unique_lock lock(mMutex);
-		auto it = pfds.begin();
-		if (it != pfds.end()) {
-			mInterrupter->process(*it++);
-		}
-		while (it != pfds.end()) {
-			socket_t sock = it->fd;
-			auto jt = mSocks->find(sock);
-			if (jt != mSocks->end()) {
-				try {
-					auto &entry = jt->second;
-					const auto &params = entry.params;
-
-					if (it->revents & POLLNVAL || it->revents & POLLERR ||
-					    (it->revents & POLLHUP &&
-					     !(it->events & POLLIN))) { // MacOS sets POLLHUP on connection failure
-						PLOG_VERBOSE << "Poll error event";
-						todo.emplace_back(std::move(params.callback), Event::Error);
-						mSocks->erase(sock);
-					} else if (it->revents & POLLIN || it->revents & POLLOUT || it->revents & POLLHUP) {
-						entry.until = params.timeout
-						                  ? std::make_optional(clock::now() + *params.timeout)
-						                  : nullopt;
-
-						const auto &callback = params.callback; // can't move, we may need it below
-						if (it->revents & POLLIN ||
-						    it->revents & POLLHUP) { // Windows does not set POLLIN on close
-							PLOG_VERBOSE << "Poll in event";
-							todo.emplace_back(callback, Event::In);
-						}
-						if (it->revents & POLLOUT) {
-							PLOG_VERBOSE << "Poll out event";
-							todo.emplace_back(callback, Event::Out);
-						}
-
-					} else if (entry.until && clock::now() >= *entry.until) {
-						PLOG_VERBOSE << "Poll timeout event";
-						todo.emplace_back(std::move(params.callback), Event::Timeout);
-						mSocks->erase(sock);
-					}
-
-				} catch (const std::exception &e) {
-					PLOG_WARNING << e.what();
-					mSocks->erase(sock);
-				}
+		mPollFds.resize(1 + mSocks->size());
+		auto it = mPollFds.begin();
+		mInterrupter->prepare(*it++);
+		for (const auto &[sock, entry] : *mSocks) {
+			it->fd = sock;
+			switch (entry.params.direction) {
+			case Direction::In:
+				it->events = POLLIN;
+				break;
+			case Direction::Out:
+				it->events = POLLOUT;
+				break;
+			default:
+				it->events = POLLIN | POLLOUT;
+				break;
 			}
-
 			++it;
 		}
 	}
 
-	// Now perform the callbacks
-	for (auto &[callback, event] : todo) {
-		callback(event);
+	int ret;
+	do {
+		ret = ::poll(mPollFds.data(), static_cast<nfds_t>(mPollFds.size()), timeout);
+	} while (ret < 0 && (sockerrno == SEINTR || sockerrno == SEAGAIN));
+
+	PLOG_VERBOSE << "Exiting poll";
+
+	if (ret < 0) {
+#ifdef _WIN32
+		if (sockerrno == WSAENOTSOCK)
+			return; // prepare again as the fd has been removed
+#endif
+		throw std::runtime_error("poll failed, errno=" + std::to_string(sockerrno));
+	}
+
+	std::unique_lock lock(mMutex);
+	auto it = mPollFds.begin();
+	mInterrupter->process(*it++);
+	for (; it != mPollFds.end(); ++it) {
+		Events e;
+		e.in = it->revents & POLLIN;
+		e.out = it->revents & POLLOUT;
+		e.hup = it->revents & POLLHUP;
+		e.error = it->revents & POLLNVAL || it->revents & POLLERR;
+		processEvents(it->fd, e, todo);
+	}
+}
+
+#endif
+
+void PollService::Loop::processTimeouts(TodoList &todo) {
+	std::unique_lock lock(mMutex);
+	const auto now = clock::now();
+	while (!mTimeouts->empty() && mTimeouts->begin()->first <= now) {
+		socket_t sock = mTimeouts->begin()->second;
+		auto it = mSocks->find(sock);
+		if (it == mSocks->end()) {
+			mTimeouts->erase(mTimeouts->begin()); // should not happen
+			continue;
+		}
+
+		auto &entry = it->second;
+		if (entry.deadline > now) {
+			// There was activity since the check was scheduled
+			scheduleTimeout(sock, entry);
+			continue;
+		}
+
+		PLOG_VERBOSE << "Poll timeout event";
+		todo.emplace_back(std::move(it->second.params.callback), Event::Timeout);
+		erase(sock);
 	}
 }
 
-void PollService::runLoop() {
+void PollService::Loop::runLoop() {
 	utils::this_thread::set_name("RTC poll");
 	PLOG_DEBUG << "Poll service started";
 
 	try {
 		assert(mSocks);
-		std::vector<struct pollfd> pfds;
-		optional<clock::time_point> next;
+		TodoList todo;
 		while (!mStopped) {
-			prepare(pfds, next);
-
-			int ret;
-			do {
-				int timeout;
-				if (next) {
-					auto msecs = duration_cast<milliseconds>(
-					    std::max(clock::duration::zero(), *next - clock::now() + 1ms));
-					PLOG_VERBOSE << "Entering poll, timeout=" << msecs.count() << "ms";
-					timeout = static_cast<int>(msecs.count());
-				} else {
-					PLOG_VERBOSE << "Entering poll";
-					timeout = -1;
-				}
-
-				ret = ::poll(pfds.data(), static_cast<nfds_t>(pfds.size()), timeout);
-
-				PLOG_VERBOSE << "Exiting poll";
+			wait(waitTimeout(), todo);
+			const auto start = clock::now();
+			processTimeouts(todo);
 
-			} while (ret < 0 && (sockerrno == SEINTR || sockerrno == SEAGAIN));
+			// Now perform the callbacks
+			for (auto &[callback, event] : todo)
+				callback(event);
 
-			if (ret < 0) {
-#ifdef _WIN32
-				if (sockerrno == WSAENOTSOCK)
-					continue; // prepare again as the fd has been removed
-#endif
-				throw std::runtime_error("poll failed, errno=" + std::to_string(sockerrno));
-			}
+			todo.clear();
 
-			process(pfds);
+			auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+			mWakeups.fetch_add(1, std::memory_order_relaxed);
+			mBusyTime.fetch_add(uint64_t(busy.count()), std::memory_order_relaxed);
 		}
 	} catch (const std::exception &e) {
 		PLOG_FATAL << "Poll service failed: " << e.what();
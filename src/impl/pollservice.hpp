@@ -10,19 +10,25 @@
 #define RTC_IMPL_POLL_SERVICE_H
 
 #include "common.hpp"
+#include "global.hpp" // for PollServiceStats
 #include "internals.hpp"
 #include "pollinterrupter.hpp"
 #include "socket.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
 
+#include <atomic>
 #include <chrono>
 #include <functional>
-#include <mutex>
-#include <thread>
-#include <unordered_map>
 #include <vector>
 
+// Use edge-triggered epoll or kqueue where available, poll() otherwise
+#if defined(__linux__)
+#define RTC_POLL_SERVICE_EPOLL 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define RTC_POLL_SERVICE_KQUEUE 1
+#endif
+
 namespace rtc::impl {
 
 class PollService {
@@ -36,7 +42,7 @@ public:
 	PollService(PollService &&) = delete;
 	PollService &operator=(PollService &&) = delete;
 
-	void start();
+	void start(unsigned int count = 1); // threads
 	void join();
 
 	enum class Direction { Both, In, Out };
@@ -51,26 +57,16 @@ public:
 	void add(socket_t sock, Params params);
 	void remove(socket_t sock);
 
+	PollServiceStats stats() const;
+
 private:
 	PollService();
 	~PollService();
 
-	void prepare(std::vector<struct pollfd> &pfds, optional<clock::time_point> &next);
-	void process(std::vector<struct pollfd> &pfds);
-	void runLoop();
-
-	struct SocketEntry {
-		Params params;
-		optional<clock::time_point> until;
-	};
-
-	using SocketMap = std::unordered_map<socket_t, SocketEntry>;
-	unique_ptr<SocketMap> mSocks;
-	unique_ptr<PollInterrupter> mInterrupter;
+	class Loop;
+	Loop &loop(socket_t sock);
 
-	std::recursive_mutex mMutex;
-	std::thread mThread;
-	bool mStopped;
+	std::vector<unique_ptr<Loop>> mLoops;
 };
 
 std::ostream &operator<<(std::ostream &out, PollService::Direction direction);
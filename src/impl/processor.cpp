@@ -8,28 +8,96 @@
 
 #include "processor.hpp"
 
+#include <algorithm>
+
 namespace rtc::impl {
 
+std::atomic<size_t> Processor::BatchSize = Processor::DefaultBatchSize;
+std::atomic<Processor::clock::duration::rep> Processor::TimeBudget =
+    Processor::DefaultTimeBudget.count();
+LatencyHistogram Processor::TaskLatency("rtc_processor_task_latency",
+                                        "Time from enqueuing a task in a processor to running it");
+
+void Processor::SetBatchSettings(optional<size_t> batchSize, optional<clock::duration> timeBudget) {
+	BatchSize = batchSize.value_or(DefaultBatchSize);
+	TimeBudget = timeBudget.value_or(DefaultTimeBudget).count();
+}
+
 Processor::Processor(size_t limit) : mTasks(limit) {}
 
 Processor::~Processor() { join(); }
 
+void Processor::setExecutor(shared_ptr<Executor> executor) {
+	std::unique_lock lock(mMutex);
+	mExecutor = std::move(executor);
+}
+
+void Processor::setControlPlane() {
+	std::unique_lock lock(mMutex);
+	mControlPlane = true;
+}
+
 void Processor::join() {
 	std::unique_lock lock(mMutex);
 	mCondition.wait(lock, [this]() { return !mPending && mTasks.empty(); });
 }
 
-void Processor::schedule() {
+void Processor::process() {
 	std::unique_lock lock(mMutex);
-	if (auto next = mTasks.pop()) {
-		ThreadPool::Instance().enqueue(std::move(*next));
-	} else {
+	auto task = mTasks.pop();
+	if (!task) {
 		// No more tasks
 		mPending = false;
 		mCondition.notify_all();
+		return;
 	}
+	lock.unlock();
+
+	const size_t batchSize = std::max(BatchSize.load(), size_t(1));
+	const auto deadline = clock::now() + clock::duration(TimeBudget.load());
+	size_t count = 0;
+	while (true) {
+		(*task)();
+
+		lock.lock();
+		if (++count >= batchSize || clock::now() >= deadline) {
+			if (mTasks.empty()) {
+				mPending = false;
+				mCondition.notify_all();
+			} else {
+				// Yield the worker, the remaining tasks will be processed on the next hop
+				schedule();
+			}
+			lock.unlock(); // the task must be destroyed without the lock
+			return;
+		}
+
+		auto next = mTasks.pop();
+		if (!next) {
+			// No more tasks
+			mPending = false;
+			mCondition.notify_all();
+			lock.unlock(); // the task must be destroyed without the lock
+			return;
+		}
+
+		lock.unlock();
+		task = std::move(next); // the previous task is destroyed while the next one is held
+	}
+}
+
+void Processor::schedule() {
+	if (mExecutor)
+		mExecutor->post([this]() { process(); });
+	else if (mControlPlane)
+		ThreadPool::Control().post([this]() { process(); });
+	else
+		ThreadPool::Instance().post([this]() { process(); });
 }
 
+LatencyHistogram TearDownProcessor::TaskDuration("rtc_teardown_task_duration",
+                                                  "Time to run a teardown task");
+
 TearDownProcessor &TearDownProcessor::Instance() {
 	static TearDownProcessor *instance = new TearDownProcessor;
 	return *instance;
@@ -39,4 +107,53 @@ TearDownProcessor::TearDownProcessor() {}
 
 TearDownProcessor::~TearDownProcessor() {}
 
+void TearDownProcessor::setSettings(const TearDownSettings &s) {
+	std::lock_guard lock(mMutex);
+	mConcurrency = std::max(s.concurrency.value_or(DefaultConcurrency), size_t(1));
+	mFastClose = s.fastClose;
+
+	// Start the additional runners if the concurrency was raised
+	while (mRunning < std::min(mConcurrency, mTasks.size())) {
+		++mRunning;
+		ThreadPool::Control().post([this]() { run(); });
+	}
+}
+
+bool TearDownProcessor::fastClose() const { return mFastClose; }
+
+TearDownStats TearDownProcessor::stats() const {
+	std::lock_guard lock(mMutex);
+	TearDownStats stats;
+	stats.pendingTasks = mTasks.size();
+	stats.runningTasks = mRunning;
+	stats.completedTasks = mCompleted;
+	return stats;
+}
+
+void TearDownProcessor::join() {
+	std::unique_lock lock(mMutex);
+	mCondition.wait(lock, [this]() { return mRunning == 0 && mTasks.empty(); });
+}
+
+void TearDownProcessor::run() {
+	// Each runner processes tasks until the queue is empty, so at most mConcurrency run at once
+	std::unique_lock lock(mMutex);
+	while (!mTasks.empty() && mRunning <= mConcurrency) {
+		Task task = std::move(mTasks.front());
+		mTasks.pop();
+		lock.unlock();
+
+		const auto start = LatencyHistogram::Now();
+		task();
+		task = nullptr; // the task must be destroyed without the lock, it releases the objects
+		TaskDuration.recordSince(start);
+
+		lock.lock();
+		++mCompleted;
+	}
+
+	--mRunning;
+	mCondition.notify_all();
+}
+
 } // namespace rtc::impl
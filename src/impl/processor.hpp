@@ -10,20 +10,32 @@
 #define RTC_IMPL_PROCESSOR_H
 
 #include "common.hpp"
+#include "executor.hpp"
+#include "global.hpp" // for TearDownSettings
+#include "latencyhistogram.hpp"
 #include "queue.hpp"
+#include "task.hpp"
 #include "threadpool.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <tuple>
 
 namespace rtc::impl {
 
-// Processed tasks in order by delegating them to the thread pool
+// Processed tasks in order by delegating them to the thread pool. Up to a batch of tasks is run
+// per thread pool hop, tasks must keep alive the object owning the processor.
 class Processor {
 public:
+	using clock = std::chrono::steady_clock;
+
+	static void SetBatchSettings(optional<size_t> batchSize, optional<clock::duration> timeBudget);
+
 	Processor(size_t limit = 0);
 	virtual ~Processor();
 
@@ -34,41 +46,116 @@ public:
 
 	void join();
 
+	// Tasks are processed on the executor instead of the thread pool, must be set before enqueuing
+	void setExecutor(shared_ptr<Executor> executor);
+
 	template <class F, class... Args> void enqueue(F &&f, Args &&...args) noexcept;
 
+protected:
+	void setControlPlane(); // process on the control-plane pool, must be set before enqueuing
+
 private:
-	void schedule();
+	void process();
+	void schedule(); // mMutex must be locked
 
-	Queue<std::function<void()>> mTasks;
-	bool mPending = false; // true iff a task is pending in the thread pool
+	static constexpr size_t DefaultBatchSize = 32;                             // tasks
+	static constexpr clock::duration DefaultTimeBudget = std::chrono::milliseconds(1); // per batch
+	static std::atomic<size_t> BatchSize;
+	static std::atomic<clock::duration::rep> TimeBudget;
+	static LatencyHistogram TaskLatency; // from enqueuing to running
+
+	Queue<Task> mTasks;
+	bool mPending = false; // true iff processing is pending in the thread pool
+	shared_ptr<Executor> mExecutor;
+	bool mControlPlane = false;
 
 	mutable std::mutex mMutex;
 	std::condition_variable mCondition;
 };
 
-class TearDownProcessor final : public Processor {
+// Runs teardown tasks on the control-plane pool. Unlike Processor, tasks are not ordered: they
+// release independent objects and may block, for instance joining threads, so they run in
+// parallel up to a bounded concurrency to drain thousands of connections quickly.
+class TearDownProcessor final {
 public:
 	static TearDownProcessor &Instance();
 
+	TearDownProcessor(const TearDownProcessor &) = delete;
+	TearDownProcessor &operator=(const TearDownProcessor &) = delete;
+	TearDownProcessor(TearDownProcessor &&) = delete;
+	TearDownProcessor &operator=(TearDownProcessor &&) = delete;
+
+	void setSettings(const TearDownSettings &s);
+	bool fastClose() const;
+	TearDownStats stats() const;
+
+	void join();
+
+	template <class F, class... Args> void enqueue(F &&f, Args &&...args) noexcept;
+
 private:
+	using clock = std::chrono::steady_clock;
+
 	TearDownProcessor();
 	~TearDownProcessor();
+
+	void run();
+
+	static constexpr size_t DefaultConcurrency = 4;
+	static LatencyHistogram TaskDuration;
+
+	std::queue<Task> mTasks;
+	size_t mConcurrency = DefaultConcurrency;
+	size_t mRunning = 0;
+	uint64_t mCompleted = 0;
+	std::atomic<bool> mFastClose = false;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCondition;
 };
 
 template <class F, class... Args> void Processor::enqueue(F &&f, Args &&...args) noexcept {
-	std::unique_lock lock(mMutex);
-	auto bound = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-	auto task = [this, bound = std::move(bound)]() mutable {
-		scope_guard guard(std::bind(&Processor::schedule, this)); // chain the next task
-		return bound();
+	auto task = [f = std::forward<F>(f),
+	             args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+		try {
+			std::apply(std::move(f), std::move(args));
+		} catch (const std::exception &e) {
+			PLOG_WARNING << e.what();
+		}
 	};
 
-	if (!mPending) {
-		ThreadPool::Instance().enqueue(std::move(task));
-		mPending = true;
+	std::unique_lock lock(mMutex);
+	if constexpr (LatencyHistogram::Enabled) {
+		mTasks.push([task = std::move(task), start = LatencyHistogram::Now()]() mutable {
+			TaskLatency.recordSince(start);
+			task();
+		});
 	} else {
 		mTasks.push(std::move(task));
 	}
+
+	if (!mPending) {
+		schedule();
+		mPending = true;
+	}
+}
+
+template <class F, class... Args> void TearDownProcessor::enqueue(F &&f, Args &&...args) noexcept {
+	auto task = [f = std::forward<F>(f),
+	             args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+		try {
+			std::apply(std::move(f), std::move(args));
+		} catch (const std::exception &e) {
+			PLOG_WARNING << e.what();
+		}
+	};
+
+	std::unique_lock lock(mMutex);
+	mTasks.push(std::move(task));
+	if (mRunning < mConcurrency) {
+		++mRunning;
+		ThreadPool::Control().post([this]() { run(); });
+	}
 }
 
 } // namespace rtc::impl
@@ -0,0 +1,310 @@
+/**
+ * Copyright (c) 2020-2021 Paul-Louis Ageneau
+ * Copyright (c) 2023 Eric Gressman
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "proxytransport.hpp"
+#include "http.hpp"
+#include "socket.hpp"
+#include "tcptransport.hpp"
+#include "utils.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+namespace rtc::impl {
+
+using std::to_string;
+using std::chrono::system_clock;
+
+namespace {
+
+const uint8_t Socks5Version = 0x05;
+const uint8_t Socks5NoAuthentication = 0x00;
+const uint8_t Socks5UsernamePassword = 0x02;
+const uint8_t Socks5Connect = 0x01;
+const uint8_t Socks5AddressIpv4 = 0x01;
+const uint8_t Socks5AddressDomain = 0x03;
+const uint8_t Socks5AddressIpv6 = 0x04;
+
+bool hasCredentials(const ProxyServer &proxy) { return proxy.username || proxy.password; }
+
+void appendSocks5String(binary &out, const string &str) {
+	if (str.size() > 255)
+		throw std::invalid_argument("String too long for SOCKS5: " + str);
+
+	out.push_back(byte(str.size()));
+	auto data = reinterpret_cast<const byte *>(str.data());
+	out.insert(out.end(), data, data + str.size());
+}
+
+} // namespace
+
+ProxyTransport::ProxyTransport(shared_ptr<TcpTransport> lower, ProxyServer proxy,
+                               std::string hostname, std::string service,
+                               state_callback stateCallback)
+    : Transport(lower, std::move(stateCallback)), mProxy(std::move(proxy)),
+      mHostname(std::move(hostname)), mService(std::move(service)) {
+	PLOG_DEBUG << "Initializing proxy transport";
+	if (!lower->isActive())
+		throw std::logic_error("Proxy transport expects the lower transport to be active");
+}
+
+ProxyTransport::~ProxyTransport() { unregisterIncoming(); }
+
+void ProxyTransport::start() {
+	registerIncoming();
+
+	changeState(State::Connecting);
+	if (mProxy.type == ProxyServer::Type::Socks5)
+		sendSocks5Requests();
+	else
+		sendHttpRequest();
+}
+
+void ProxyTransport::stop() { unregisterIncoming(); }
+
+bool ProxyTransport::send(message_ptr message) {
+	if (state() != State::Connected)
+		throw std::runtime_error("Proxy connection is not open");
+
+	PLOG_VERBOSE << "Send size=" << message->size();
+	return outgoing(message);
+}
+
+bool ProxyTransport::isActive() const { return true; }
+
+string ProxyTransport::service() const { return mService; }
+
+void ProxyTransport::incoming(message_ptr message) {
+	auto s = state();
+	if (s != State::Connecting && s != State::Connected)
+		return; // Drop
+
+	if (message) {
+		PLOG_VERBOSE << "Incoming size=" << message->size();
+
+		try {
+			if (state() == State::Connecting) {
+				mBuffer.insert(mBuffer.end(), message->begin(), message->end());
+				bool connected = false;
+				if (mProxy.type == ProxyServer::Type::Socks5) {
+					// Replies might arrive together, as requests are sent at once
+					while (mSocks5Step != Socks5Step::Done) {
+						size_t len = parseSocks5Reply(mBuffer.data(), mBuffer.size());
+						if (len == 0)
+							break;
+
+						mBuffer.erase(mBuffer.begin(), mBuffer.begin() + len);
+					}
+
+					connected = mSocks5Step == Socks5Step::Done;
+
+				} else if (size_t len = parseHttpResponse(mBuffer.data(), mBuffer.size())) {
+					mBuffer.erase(mBuffer.begin(), mBuffer.begin() + len);
+					connected = true;
+				}
+
+				if (connected) {
+					PLOG_INFO << "Proxy connection open";
+					changeState(State::Connected);
+
+					if (!mBuffer.empty()) {
+						recv(make_message(mBuffer));
+						mBuffer.clear();
+					}
+				}
+			} else if (state() == State::Connected) {
+				recv(std::move(message));
+			}
+
+			return;
+		} catch (const std::exception &e) {
+			PLOG_ERROR << e.what();
+		}
+	}
+
+	if (state() == State::Connected) {
+		PLOG_INFO << "Proxy disconnected";
+		changeState(State::Disconnected);
+		recv(nullptr);
+	} else {
+		PLOG_ERROR << "Proxy connection failed";
+		changeState(State::Failed);
+	}
+}
+
+bool ProxyTransport::sendHttpRequest() {
+	PLOG_DEBUG << "Sending HTTP request to proxy";
+
+	const string request = generateHttpRequest();
+	auto data = reinterpret_cast<const byte *>(request.data());
+	return outgoing(make_message(data, data + request.size()));
+}
+
+string ProxyTransport::generateHttpRequest() {
+	// IPv6 addresses must be enclosed in brackets in the authority
+	const string host = mHostname.find(':') != string::npos ? "[" + mHostname + "]" : mHostname;
+	const string authority = host + ":" + mService;
+	string request = "CONNECT " + authority + " HTTP/1.1\r\nHost: " + authority + "\r\n";
+	if (hasCredentials(mProxy)) {
+		// Basic authentication (RFC 7617)
+		const string credentials = mProxy.username.value_or("") + ":" + mProxy.password.value_or("");
+		auto data = reinterpret_cast<const byte *>(credentials.data());
+		request += "Proxy-Authorization: Basic " +
+		           utils::base64_encode(binary(data, data + credentials.size())) + "\r\n";
+	}
+	request += "\r\n";
+	return request;
+}
+
+size_t ProxyTransport::parseHttpResponse(std::byte *buffer, size_t size) {
+	std::list<string> lines;
+	size_t length = parseHttpLines(buffer, size, lines);
+	if (length == 0)
+		return 0;
+
+	if (lines.empty())
+		throw std::runtime_error("Invalid response from HTTP proxy");
+
+	std::istringstream status(std::move(lines.front()));
+	lines.pop_front();
+
+	string protocol;
+	unsigned int code = 0;
+	status >> protocol >> code;
+
+	if (code != 200)
+		throw std::runtime_error("Unexpected response code " + to_string(code) +
+		                         " from HTTP proxy");
+
+	return length;
+}
+
+bool ProxyTransport::sendSocks5Requests() {
+	PLOG_DEBUG << "Sending SOCKS5 requests to proxy";
+
+	// The requests are pipelined to save round trips, the server processes them in order
+	return outgoing(make_message(generateSocks5Requests()));
+}
+
+binary ProxyTransport::generateSocks5Requests() {
+	uint16_t port;
+	try {
+		port = utils::to_uint16(std::stoi(mService));
+	} catch (...) {
+		throw std::invalid_argument("Invalid port for SOCKS5 proxy: " + mService);
+	}
+
+	binary out;
+
+	// Method selection, only the one we are going to use is offered
+	const bool authenticate = hasCredentials(mProxy);
+	out.push_back(byte(Socks5Version));
+	out.push_back(byte(1));
+	out.push_back(byte(authenticate ? Socks5UsernamePassword : Socks5NoAuthentication));
+
+	if (authenticate) {
+		// Username/password authentication (RFC 1929)
+		out.push_back(byte(0x01));
+		appendSocks5String(out, mProxy.username.value_or(""));
+		appendSocks5String(out, mProxy.password.value_or(""));
+	}
+
+	out.push_back(byte(Socks5Version));
+	out.push_back(byte(Socks5Connect));
+	out.push_back(byte(0x00)); // reserved
+
+	// Hostnames are resolved by the proxy
+	struct in_addr addr4 = {};
+	struct in6_addr addr6 = {};
+	if (inet_pton(AF_INET, mHostname.c_str(), &addr4) == 1) {
+		out.push_back(byte(Socks5AddressIpv4));
+		auto data = reinterpret_cast<const byte *>(&addr4);
+		out.insert(out.end(), data, data + sizeof(addr4));
+	} else if (inet_pton(AF_INET6, mHostname.c_str(), &addr6) == 1) {
+		out.push_back(byte(Socks5AddressIpv6));
+		auto data = reinterpret_cast<const byte *>(&addr6);
+		out.insert(out.end(), data, data + sizeof(addr6));
+	} else {
+		out.push_back(byte(Socks5AddressDomain));
+		appendSocks5String(out, mHostname);
+	}
+
+	out.push_back(byte(port >> 8));
+	out.push_back(byte(port & 0xFF));
+	return out;
+}
+
+size_t ProxyTransport::parseSocks5Reply(const std::byte *buffer, size_t size) {
+	auto data = reinterpret_cast<const uint8_t *>(buffer);
+	switch (mSocks5Step) {
+	case Socks5Step::Method: {
+		if (size < 2)
+			return 0;
+
+		if (data[0] != Socks5Version)
+			throw std::runtime_error("Invalid response from SOCKS5 proxy");
+
+		const bool authenticate = hasCredentials(mProxy);
+		if (data[1] != (authenticate ? Socks5UsernamePassword : Socks5NoAuthentication))
+			throw std::runtime_error("SOCKS5 proxy refused the authentication method");
+
+		mSocks5Step = authenticate ? Socks5Step::Authentication : Socks5Step::Connect;
+		return 2;
+	}
+	case Socks5Step::Authentication: {
+		if (size < 2)
+			return 0;
+
+		if (data[1] != 0x00)
+			throw std::runtime_error("SOCKS5 proxy authentication failed");
+
+		mSocks5Step = Socks5Step::Connect;
+		return 2;
+	}
+	case Socks5Step::Connect: {
+		if (size < 5)
+			return 0;
+
+		if (data[0] != Socks5Version)
+			throw std::runtime_error("Invalid response from SOCKS5 proxy");
+
+		if (data[1] != 0x00)
+			throw std::runtime_error("SOCKS5 proxy connection failed with code " +
+			                         to_string(data[1]));
+
+		// The bound address is not needed
+		size_t addrLen;
+		switch (data[3]) {
+		case Socks5AddressIpv4:
+			addrLen = 4;
+			break;
+		case Socks5AddressIpv6:
+			addrLen = 16;
+			break;
+		case Socks5AddressDomain:
+			addrLen = 1 + data[4];
+			break;
+		default:
+			throw std::runtime_error("Invalid address type in response from SOCKS5 proxy");
+		}
+
+		const size_t len = 4 + addrLen + 2;
+		if (size < len)
+			return 0;
+
+		mSocks5Step = Socks5Step::Done;
+		return len;
+	}
+	default:
+		return 0;
+	}
+}
+
+} // namespace rtc::impl
+
+#endif
@@ -11,6 +11,7 @@
 #define RTC_IMPL_TCP_PROXY_TRANSPORT_H
 
 #include "common.hpp"
+#include "configuration.hpp"
 #include "transport.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
@@ -19,28 +20,38 @@ namespace rtc::impl {
 
 class TcpTransport;
 
-class HttpProxyTransport final : public Transport,
-                                 public std::enable_shared_from_this<HttpProxyTransport> {
+// Tunnel through an HTTP proxy with CONNECT (RFC 9110) or a SOCKS5 proxy (RFC 1928)
+class ProxyTransport final : public Transport,
+                             public std::enable_shared_from_this<ProxyTransport> {
 public:
-	HttpProxyTransport(shared_ptr<TcpTransport> lower, std::string hostname, std::string service,
-	                   state_callback stateCallback);
-	~HttpProxyTransport();
+	ProxyTransport(shared_ptr<TcpTransport> lower, ProxyServer proxy, std::string hostname,
+	               std::string service, state_callback stateCallback);
+	~ProxyTransport();
 
 	void start() override;
 	void stop() override;
 	bool send(message_ptr message) override;
 
 	bool isActive() const;
+	string service() const; // of the remote server, not the proxy
 
 private:
+	// SOCKS5 replies expected in order, since the requests are sent at once
+	enum class Socks5Step { Method, Authentication, Connect, Done };
+
 	void incoming(message_ptr message) override;
 	bool sendHttpRequest();
 	string generateHttpRequest();
 	size_t parseHttpResponse(std::byte *buffer, size_t size);
+	bool sendSocks5Requests();
+	binary generateSocks5Requests();
+	size_t parseSocks5Reply(const std::byte *buffer, size_t size); // returns 0 if incomplete
 
+	const ProxyServer mProxy;
 	string mHostname;
 	string mService;
 	binary mBuffer;
+	Socks5Step mSocks5Step = Socks5Step::Method;
 };
 
 } // namespace rtc::impl
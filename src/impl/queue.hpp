@@ -16,6 +16,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace rtc::impl {
 
@@ -35,6 +36,7 @@ public:
 	size_t amount() const; // amount
 	void push(T element);
 	optional<T> pop();
+	std::vector<T> popAll(); // pops all elements at once
 	optional<T> peek();
 	optional<T> exchange(T element);
 
@@ -109,6 +111,19 @@ template <typename T> optional<T> Queue<T>::pop() {
 	return element;
 }
 
+template <typename T> std::vector<T> Queue<T>::popAll() {
+	std::unique_lock lock(mMutex);
+	std::vector<T> elements;
+	elements.reserve(mQueue.size());
+	while (!mQueue.empty()) {
+		elements.emplace_back(std::move(mQueue.front()));
+		mQueue.pop();
+	}
+	mAmount = 0;
+	mPushCondition.notify_all();
+	return elements;
+}
+
 template <typename T> optional<T> Queue<T>::peek() {
 	std::unique_lock lock(mMutex);
 	return !mQueue.empty() ? std::make_optional(mQueue.front()) : nullopt;
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "sctppacket.hpp"
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+namespace {
+
+constexpr size_t ChunkHeaderSize = 4;
+
+uint16_t read16(const byte *p) {
+	return uint16_t(std::to_integer<uint16_t>(p[0]) << 8 | std::to_integer<uint16_t>(p[1]));
+}
+
+enum ChunkType : uint8_t {
+	ChunkInit = 1,
+	ChunkInitAck = 2,
+	ChunkAbort = 6,
+	ChunkCookieEcho = 10,
+	ChunkShutdownComplete = 14,
+};
+
+} // namespace
+
+// RFC 9653 5.2: Packets containing INIT or COOKIE ECHO may reach an endpoint without any state
+// for the association, and ABORT or SHUTDOWN COMPLETE may be sent in response to out of the blue
+// packets, so they must always carry a correct checksum.
+bool sctp_requires_checksum(const byte *data, size_t len) {
+	size_t offset = SctpCommonHeaderSize;
+	while (offset + ChunkHeaderSize <= len) {
+		switch (std::to_integer<uint8_t>(data[offset])) {
+		case ChunkInit:
+		case ChunkInitAck:
+		case ChunkAbort:
+		case ChunkCookieEcho:
+		case ChunkShutdownComplete:
+			return true;
+		default:
+			break;
+		}
+		const size_t length = read16(data + offset + 2);
+		if (length < ChunkHeaderSize)
+			break;
+
+		offset += (length + 3) & ~size_t(3); // chunks are padded to 4 bytes
+	}
+	return false;
+}
+
+// INIT and INIT ACK are never bundled with other chunks
+bool sctp_parse_zero_checksum_acceptable(const byte *data, size_t len, bool &accepted) {
+	constexpr size_t InitFixedSize = 16; // tag, a_rwnd, streams, and initial TSN
+	constexpr uint16_t ZeroChecksumAcceptable = 0x8001;
+	constexpr uint32_t EdmidLowerLayerDtls = 1;
+
+	if (len < SctpCommonHeaderSize + ChunkHeaderSize + InitFixedSize)
+		return false;
+
+	const byte *chunk = data + SctpCommonHeaderSize;
+	const uint8_t type = std::to_integer<uint8_t>(chunk[0]);
+	if (type != ChunkInit && type != ChunkInitAck)
+		return false;
+
+	const size_t end = std::min(len, SctpCommonHeaderSize + read16(chunk + 2));
+	size_t offset = SctpCommonHeaderSize + ChunkHeaderSize + InitFixedSize;
+	accepted = false;
+	while (offset + 4 <= end) {
+		const uint16_t paramType = read16(data + offset);
+		const size_t paramLength = read16(data + offset + 2);
+		if (paramLength < 4)
+			break;
+
+		if (paramType == ZeroChecksumAcceptable && paramLength >= 8 && offset + 8 <= end) {
+			const uint32_t edmid = uint32_t(read16(data + offset + 4)) << 16 |
+			                       read16(data + offset + 6);
+			accepted = edmid == EdmidLowerLayerDtls;
+			break;
+		}
+
+		offset += (paramLength + 3) & ~size_t(3);
+	}
+	return true;
+}
+
+} // namespace rtc::impl
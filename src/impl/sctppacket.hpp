@@ -0,0 +1,30 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_SCTP_PACKET_H
+#define RTC_IMPL_SCTP_PACKET_H
+
+#include "common.hpp"
+
+namespace rtc::impl {
+
+// RFC 9260 3. SCTP Packet Format: a 12-byte common header followed by chunks
+constexpr size_t SctpCommonHeaderSize = 12;
+constexpr size_t SctpChecksumOffset = 8;
+
+// Whether the packet contains a chunk which must always carry a correct checksum, even when the
+// remote peer accepts a zero checksum (RFC 9653 5.2)
+bool sctp_requires_checksum(const byte *data, size_t len);
+
+// Returns whether the packet is an INIT or INIT ACK, and if so sets accepted to whether it holds a
+// Zero Checksum Acceptable parameter for DTLS (RFC 9653 5.1)
+bool sctp_parse_zero_checksum_acceptable(const byte *data, size_t len, bool &accepted);
+
+} // namespace rtc::impl
+
+#endif
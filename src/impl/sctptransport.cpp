@@ -7,21 +7,27 @@
  */
 
 #include "sctptransport.hpp"
+#include "channel.hpp"
+#include "crc32c.hpp"
 #include "dtlstransport.hpp"
 #include "internals.hpp"
+#include "latencyhistogram.hpp"
 #include "logcounter.hpp"
+#include "messagepool.hpp"
+#include "sctppacket.hpp"
+#include "tracing.hpp"
 #include "utils.hpp"
 
 #include <algorithm>
 #include <chrono>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <limits>
 #include <shared_mutex>
 #include <thread>
-#include <unordered_set>
 #include <vector>
 
 // RFC 8831: SCTP MUST support performing Path MTU discovery without relying on ICMP or ICMPv6 as
@@ -53,79 +59,140 @@ using namespace std::chrono;
 
 namespace rtc::impl {
 
+using std::to_integer;
 using utils::to_uint16;
 using utils::to_uint32;
 
-static LogCounter COUNTER_UNKNOWN_PPID(plog::warning,
+static LogCounter COUNTER_UNKNOWN_PPID("rtc_sctp_unknown_ppid_packets", plog::warning,
                                        "Number of SCTP packets received with an unknown PPID");
 
-class SctpTransport::InstancesSet {
-public:
-	void insert(SctpTransport *instance) {
-		std::unique_lock lock(mMutex);
-		mSet.insert(instance);
-	}
+static LatencyHistogram HISTOGRAM_QUEUE_RESIDENCE("rtc_sctp_send_queue_residence",
+                                                  "Time spent by messages in SCTP send queues");
 
-	void erase(SctpTransport *instance) {
-		std::unique_lock lock(mMutex);
-		mSet.erase(instance);
-	}
+struct SctpTransport::Token {
+	SctpTransport *instance = nullptr; // null once the instance is destroyed
+	std::shared_mutex mutex;           // held shared by callbacks, exclusively on destruction
+};
+
+std::atomic<size_t> SctpTransport::InstancesCount = 0;
+std::mutex SctpTransport::TokensMutex;
+std::vector<std::unique_ptr<SctpTransport::Token>> SctpTransport::Tokens;
+std::vector<SctpTransport::Token *> SctpTransport::FreeTokens;
+
+std::unique_ptr<SctpTransport::Token, SctpTransport::TokenReleaser> SctpTransport::AcquireToken() {
+	std::lock_guard lock(TokensMutex);
+	if (FreeTokens.empty())
+		return std::unique_ptr<Token, TokenReleaser>(
+		    Tokens.emplace_back(std::make_unique<Token>()).get());
 
-	using shared_lock = std::shared_lock<std::shared_mutex>;
-	optional<shared_lock> lock(SctpTransport *instance) noexcept {
-		shared_lock lock(mMutex);
-		return mSet.find(instance) != mSet.end() ? std::make_optional(std::move(lock)) : nullopt;
+	auto token = FreeTokens.back();
+	FreeTokens.pop_back();
+	return std::unique_ptr<Token, TokenReleaser>(token);
+}
+
+void SctpTransport::TokenReleaser::operator()(Token *token) const {
+	{
+		// Wait for callbacks in progress
+		std::unique_lock lock(token->mutex);
+		if (std::exchange(token->instance, nullptr))
+			--InstancesCount;
 	}
 
-private:
-	std::unordered_set<SctpTransport *> mSet;
-	std::shared_mutex mMutex;
-};
+	std::lock_guard lock(TokensMutex);
+	FreeTokens.push_back(token);
+}
 
-SctpTransport::InstancesSet* SctpTransport::Instances = nullptr;
+bool SctpTransport::Threadless = false;
+steady_clock::duration SctpTransport::TimersTick = 10ms;
+std::mutex SctpTransport::TimersMutex;
+bool SctpTransport::TimersScheduled = false;
+steady_clock::time_point SctpTransport::TimersTime;
+
+void SctpTransport::Init(const SctpSettings &s) {
+	Threadless = s.threadlessTimers;
+	if (Threadless) {
+		PLOG_DEBUG << "Initializing usrsctp without timer thread";
+		usrsctp_init_nothreads(0, SctpTransport::WriteCallback, SctpTransport::DebugCallback);
+		TimersTime = steady_clock::now();
+		TimersTick = std::max<steady_clock::duration>(s.timersTick.value_or(10ms), 1ms);
+	} else {
+		usrsctp_init(0, SctpTransport::WriteCallback, SctpTransport::DebugCallback);
+	}
 
-void SctpTransport::Init() {
-	usrsctp_init(0, SctpTransport::WriteCallback, SctpTransport::DebugCallback);
 	usrsctp_sysctl_set_sctp_pr_enable(1);  // Enable Partial Reliability Extension (RFC 3758)
 	usrsctp_sysctl_set_sctp_ecn_enable(0); // Disable Explicit Congestion Notification
-#ifndef SCTP_ACCEPT_ZERO_CHECKSUM
 	usrsctp_enable_crc32c_offload(); // We'll compute CRC32 only for outgoing packets
-#endif
 #ifdef SCTP_DEBUG
 	usrsctp_sysctl_set_sctp_debug_on(SCTP_DEBUG_ALL);
 #endif
+}
+
+namespace {
+
+struct ProfileDefaults {
+	size_t bufferSize;              // in bytes
+	size_t maxChunksOnQueue;        // in chunks
+	size_t initialCongestionWindow; // in MTUs
+	size_t maxBurst;                // in MTUs
+	unsigned int congestionControlModule;
+	milliseconds delayedSackTime;
+	milliseconds minRetransmitTimeout;
+};
 
-	Instances = new InstancesSet;
+ProfileDefaults profile_defaults(SctpSettings::Profile profile) {
+	switch (profile) {
+	case SctpSettings::Profile::Throughput:
+		// Large windows for high bandwidth-delay product links, with HSTCP to grow the congestion
+		// window faster than standard congestion control once it is large
+		return {4 * 1024 * 1024, 64 * 1024, 10, 32, 1, 20ms, 200ms};
+	case SctpSettings::Profile::Latency:
+		// Small windows to limit queuing, SACKs are sent immediately and losses detected earlier
+		return {256 * 1024, 10 * 1024, 10, 4, 0, 0ms, 100ms};
+	case SctpSettings::Profile::LowMemory:
+		return {256 * 1024, 1024, 10, 4, 0, 20ms, 200ms};
+	default:
+		return {1024 * 1024, 10 * 1024, 10, 10, 0, 20ms, 200ms};
+	}
 }
 
+} // namespace
+
+std::atomic<bool> SctpTransport::AutoTuneBuffers = false;
+std::atomic<size_t> SctpTransport::MaxAutoTuneBufferSize = DefaultMaxAutoTuneBufferSize;
+
 void SctpTransport::SetSettings(const SctpSettings &s) {
+	const auto defaults = profile_defaults(s.profile);
+
 	// The send and receive window size of usrsctp is 256KiB, which is too small for realistic RTTs,
 	// therefore we increase it to 1MiB by default for better performance.
 	// See https://bugzilla.mozilla.org/show_bug.cgi?id=1051685
-	usrsctp_sysctl_set_sctp_recvspace(to_uint32(s.recvBufferSize.value_or(1024 * 1024)));
-	usrsctp_sysctl_set_sctp_sendspace(to_uint32(s.sendBufferSize.value_or(1024 * 1024)));
+	usrsctp_sysctl_set_sctp_recvspace(to_uint32(s.recvBufferSize.value_or(defaults.bufferSize)));
+	usrsctp_sysctl_set_sctp_sendspace(to_uint32(s.sendBufferSize.value_or(defaults.bufferSize)));
 
 	// Increase maximum chunks number on queue to 10K by default
-	usrsctp_sysctl_set_sctp_max_chunks_on_queue(to_uint32(s.maxChunksOnQueue.value_or(10 * 1024)));
+	usrsctp_sysctl_set_sctp_max_chunks_on_queue(
+	    to_uint32(s.maxChunksOnQueue.value_or(defaults.maxChunksOnQueue)));
 
 	// Increase initial congestion window size to 10 MTUs (RFC 6928) by default
-	usrsctp_sysctl_set_sctp_initial_cwnd(to_uint32(s.initialCongestionWindow.value_or(10)));
+	usrsctp_sysctl_set_sctp_initial_cwnd(
+	    to_uint32(s.initialCongestionWindow.value_or(defaults.initialCongestionWindow)));
 
 	// Set max burst to 10 MTUs by default (max burst is initially 0, meaning disabled)
-	usrsctp_sysctl_set_sctp_max_burst_default(to_uint32(s.maxBurst.value_or(10)));
+	usrsctp_sysctl_set_sctp_max_burst_default(to_uint32(s.maxBurst.value_or(defaults.maxBurst)));
 
 	// Use standard SCTP congestion control (RFC 4960) by default
 	// See https://github.com/paullouisageneau/libdatachannel/issues/354
-	usrsctp_sysctl_set_sctp_default_cc_module(to_uint32(s.congestionControlModule.value_or(0)));
+	usrsctp_sysctl_set_sctp_default_cc_module(
+	    to_uint32(s.congestionControlModule.value_or(defaults.congestionControlModule)));
 
 	// Reduce SACK delay to 20ms by default (the recommended default value from RFC 4960 is 200ms)
 	usrsctp_sysctl_set_sctp_delayed_sack_time_default(
-	    to_uint32(s.delayedSackTime.value_or(20ms).count()));
+	    to_uint32(s.delayedSackTime.value_or(defaults.delayedSackTime).count()));
 
 	// RTO settings
 	// RFC 2988 recommends a 1s min RTO, which is very high, but TCP on Linux has a 200ms min RTO
 	usrsctp_sysctl_set_sctp_rto_min_default(
-	    to_uint32(s.minRetransmitTimeout.value_or(200ms).count()));
+	    to_uint32(s.minRetransmitTimeout.value_or(defaults.minRetransmitTimeout).count()));
 	// Set only 10s as max RTO instead of 60s for shorter connection timeout
 	usrsctp_sysctl_set_sctp_rto_max_default(
 	    to_uint32(s.maxRetransmitTimeout.value_or(10000ms).count()));
@@ -145,23 +212,31 @@ void SctpTransport::SetSettings(const SctpSettings &s) {
 	// Heartbeat interval
 	usrsctp_sysctl_set_sctp_heartbeat_interval_default(
 	    to_uint32(s.heartbeatInterval.value_or(10000ms).count()));
+
+	// Auto-tuning applies to newly-created associations
+	AutoTuneBuffers = s.autoTuneBuffers;
+	MaxAutoTuneBufferSize = s.maxAutoTuneBufferSize.value_or(DefaultMaxAutoTuneBufferSize);
 }
 
 void SctpTransport::Cleanup() {
-	while (usrsctp_finish())
+	// The thread pool is already joined, so remaining timers are handled here
+	while (usrsctp_finish()) {
 		std::this_thread::sleep_for(100ms);
+		if (Threadless)
+			usrsctp_handle_timers(100);
+	}
 
-	delete Instances;
-	Instances = nullptr;
+	std::lock_guard lock(TokensMutex);
+	FreeTokens.clear();
+	Tokens.clear();
 }
 
 SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &config, Ports ports,
-                             message_callback recvCallback, amount_callback bufferedAmountCallback,
-                             state_callback stateChangeCallback)
+                             message_callback recvCallback, state_callback stateChangeCallback)
     : Transport(lower, std::move(stateChangeCallback)),
       mMaxMessageSize(config.maxMessageSize.value_or(DEFAULT_LOCAL_MAX_MESSAGE_SIZE)),
-      mPorts(std::move(ports)), mSendQueue(0, message_size_func),
-      mBufferedAmountCallback(std::move(bufferedAmountCallback)) {
+      mLowMemory(config.enableLowMemoryMode), mPorts(std::move(ports)),
+      mToken(AcquireToken()) {
 	onRecv(std::move(recvCallback));
 
 	PLOG_DEBUG << "Initializing SCTP transport";
@@ -170,7 +245,7 @@ SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &c
 	if (!mSock)
 		throw std::runtime_error("Could not create SCTP socket, errno=" + std::to_string(errno));
 
-	usrsctp_set_upcall(mSock, &SctpTransport::UpcallCallback, this);
+	usrsctp_set_upcall(mSock, &SctpTransport::UpcallCallback, mToken.get());
 
 	if (usrsctp_set_non_blocking(mSock, 1))
 		throw std::runtime_error("Unable to set non-blocking mode, errno=" + std::to_string(errno));
@@ -219,8 +294,16 @@ SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &c
 		                         std::to_string(errno));
 
 	struct sctp_paddrparams spp = {};
-	// Enable SCTP heartbeats
-	spp.spp_flags = SPP_HB_ENABLE;
+	if (config.keepaliveInterval && config.keepaliveInterval->count() <= 0) {
+		// Disable SCTP heartbeats, ICE consent checks still detect dead peers
+		spp.spp_flags = SPP_HB_DISABLE;
+		PLOG_VERBOSE << "SCTP heartbeats disabled";
+	} else {
+		// Enable SCTP heartbeats
+		spp.spp_flags = SPP_HB_ENABLE;
+		if (config.keepaliveInterval)
+			spp.spp_hbinterval = to_uint32(config.keepaliveInterval->count());
+	}
 
 	// RFC 8261 5. DTLS considerations:
 	// If path MTU discovery is performed by the SCTP layer and IPv4 is used as the network-layer
@@ -267,14 +350,64 @@ SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &c
 		throw std::runtime_error("Could not set socket option SCTP_INITMSG, errno=" +
 		                         std::to_string(errno));
 
+	// RFC 8260: I-DATA chunks allow the sender to interleave messages of different streams, so a
+	// large message on a stream does not block small ones on other streams.
+	// See https://www.rfc-editor.org/rfc/rfc8260.html
+	bool interleaving = config.enableSctpInterleaving;
+#ifndef SCTP_INTERLEAVING_SUPPORTED
+	if (interleaving) {
+		PLOG_WARNING << "SCTP interleaving is not supported by usrsctp";
+		interleaving = false;
+	}
+#endif
+
 	// Prevent fragmented interleave of messages (i.e. level 0), see RFC 6458 section 8.1.20.
 	// Unless the user has set the fragmentation interleave level to 0, notifications
-	// may also be interleaved with partially delivered messages.
-	int level = 0;
+	// may also be interleaved with partially delivered messages. I-DATA requires level 2, where
+	// partial messages of different streams are interleaved.
+	int level = interleaving ? 2 : 0;
 	if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_FRAGMENT_INTERLEAVE, &level, sizeof(level)))
-		throw std::runtime_error("Could not disable SCTP fragmented interleave, errno=" +
+		throw std::runtime_error("Could not set SCTP fragmented interleave level, errno=" +
 		                         std::to_string(errno));
 
+#ifdef SCTP_INTERLEAVING_SUPPORTED
+	if (interleaving) {
+		struct sctp_assoc_value iav = {};
+		iav.assoc_id = SCTP_ALL_ASSOC;
+		iav.assoc_value = 1;
+		if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_INTERLEAVING_SUPPORTED, &iav,
+		                       sizeof(iav)))
+			throw std::runtime_error("Could not enable SCTP interleaving, errno=" +
+			                         std::to_string(errno));
+
+		PLOG_VERBOSE << "SCTP interleaving enabled";
+	}
+#endif
+
+	// The priority scheduler serves streams with the same priority round robin, which also lets
+	// them interleave with I-DATA
+	if (config.enableSctpStreamPriorities) {
+		struct sctp_assoc_value sav = {};
+		sav.assoc_id = SCTP_ALL_ASSOC;
+		sav.assoc_value = SCTP_SS_PRIORITY;
+		if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_PLUGGABLE_SS, &sav, sizeof(sav)) == 0) {
+			PLOG_VERBOSE << "SCTP priority scheduler enabled";
+			mPriorityScheduler = true;
+		} else {
+			PLOG_WARNING << "Could not set SCTP priority scheduler, errno=" << errno;
+		}
+	}
+
+	if (!mPriorityScheduler && interleaving) {
+		// The default scheduler sends messages in order, round robin lets streams interleave
+		struct sctp_assoc_value sav = {};
+		sav.assoc_id = SCTP_ALL_ASSOC;
+		sav.assoc_value = SCTP_SS_ROUND_ROBIN;
+		if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_PLUGGABLE_SS, &sav, sizeof(sav)))
+			throw std::runtime_error("Could not set SCTP stream scheduler, errno=" +
+			                         std::to_string(errno));
+	}
+
 #ifdef SCTP_ACCEPT_ZERO_CHECKSUM // not available in usrsctp v0.9.5.0
 	// When using SCTP over DTLS, the data integrity is ensured by DTLS. Therefore, there's no
 	// need to check CRC32c additionally when receiving. See
@@ -301,6 +434,12 @@ SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &c
 	rcvBuf = std::max(rcvBuf, minBuf);
 	sndBuf = std::max(sndBuf, minBuf);
 
+	// In low-memory mode, buffers start at the minimum and grow with auto-tuning only if needed
+	if (mLowMemory) {
+		PLOG_DEBUG << "SCTP low-memory mode enabled";
+		rcvBuf = sndBuf = minBuf;
+	}
+
 	if (usrsctp_setsockopt(mSock, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf)))
 		throw std::runtime_error("Could not set SCTP recv buffer size, errno=" +
 		                         std::to_string(errno));
@@ -309,13 +448,29 @@ SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &c
 		throw std::runtime_error("Could not set SCTP send buffer size, errno=" +
 		                         std::to_string(errno));
 
-	usrsctp_register_address(this);
-	Instances->insert(this);
+	mRecvBufferSize = mInitialRecvBufferSize = size_t(rcvBuf);
+	mSendBufferSize = mInitialSendBufferSize = size_t(sndBuf);
+	mAutoTune = AutoTuneBuffers || mLowMemory;
+
+	usrsctp_register_address(mToken.get());
+	{
+		std::unique_lock lock(mToken->mutex);
+		mToken->instance = this;
+		++InstancesCount;
+	}
+
+	if (Threadless)
+		StartTimers();
 }
 
 SctpTransport::~SctpTransport() {
 	PLOG_DEBUG << "Destroying SCTP transport";
 
+	{
+		std::lock_guard lock(mAutoTuneTimerMutex);
+		mAutoTuneTimer.cancel();
+	}
+
 	mProcessor.join(); // if we are here, the processor must be empty
 
 	// Before unregistering incoming() from the lower layer, we need to make sure the thread from
@@ -327,12 +482,12 @@ SctpTransport::~SctpTransport() {
 
 	usrsctp_close(mSock);
 
-	usrsctp_deregister_address(this);
-	Instances->erase(this);
+	usrsctp_deregister_address(mToken.get());
+	mToken.reset();
 }
 
-void SctpTransport::onBufferedAmount(amount_callback callback) {
-	mBufferedAmountCallback = std::move(callback);
+void SctpTransport::setExecutor(shared_ptr<Executor> executor) {
+	mProcessor.setExecutor(std::move(executor));
 }
 
 void SctpTransport::start() {
@@ -346,7 +501,7 @@ struct sockaddr_conn SctpTransport::getSockAddrConn(uint16_t port) {
 	struct sockaddr_conn sconn = {};
 	sconn.sconn_family = AF_CONN;
 	sconn.sconn_port = htons(port);
-	sconn.sconn_addr = this;
+	sconn.sconn_addr = mToken.get();
 #ifdef HAVE_SCONN_LEN
 	sconn.sconn_len = sizeof(sconn);
 #endif
@@ -372,8 +527,9 @@ void SctpTransport::connect() {
 }
 
 bool SctpTransport::send(message_ptr message) {
+	WriteScope scope(this);
 	std::lock_guard lock(mSendMutex);
-	if (state() != State::Connected)
+	if (state() != State::Connected || mSendClosed)
 		return false;
 
 	if (!message)
@@ -384,17 +540,242 @@ bool SctpTransport::send(message_ptr message) {
 	if (message->size() > mMaxMessageSize)
 		throw std::invalid_argument("Message is too large");
 
+	if (coalesce(message))
+		return true;
+
 	// Flush the queue, and if nothing is pending, try to send directly
-	if (trySendQueue() && trySendMessage(message))
+	if (trySendQueue() && trySendMessage(*message, message->data(), message->size()))
 		return true;
 
-	mSendQueue.push(message);
-	updateBufferedAmount(to_uint16(message->stream), ptrdiff_t(message_size_func(message)));
+	const auto stream = to_uint16(message->stream);
+	const auto amount = ptrdiff_t(message_size_func(message));
+	if (enqueueSend({std::move(message), nullptr}))
+		updateBufferedAmount(stream, amount);
+
 	return false;
 }
 
+bool SctpTransport::send(message_ptr message, unique_ptr<LentData> lent) {
+	WriteScope scope(this);
+	std::lock_guard lock(mSendMutex);
+	if (state() != State::Connected || mSendClosed)
+		return false;
+
+	PLOG_VERBOSE << "Send lent size=" << lent->size;
+
+	if (lent->size > mMaxMessageSize)
+		throw std::invalid_argument("Message is too large");
+
+	// usrsctp copies the data into its send buffer, so it is released as soon as it is sent
+	if (trySendQueue() && trySendMessage(*message, lent->data, lent->size))
+		return true;
+
+	// Keep the lent data until it is sent, so it is still not copied
+	PendingMessage pending{std::move(message), std::move(lent)};
+	const auto stream = to_uint16(pending.message->stream);
+	const auto amount = ptrdiff_t(pending.amount());
+	if (enqueueSend(std::move(pending)))
+		updateBufferedAmount(stream, amount);
+
+	return false;
+}
+
+bool SctpTransport::send(message_vector messages) {
+	WriteScope scope(this); // packets of all messages are written at once
+	std::lock_guard lock(mSendMutex);
+	if (state() != State::Connected || mSendClosed)
+		return false;
+
+	PLOG_VERBOSE << "Send count=" << messages.size();
+
+	for (const auto &message : messages)
+		if (message->size() > mMaxMessageSize)
+			throw std::invalid_argument("Message is too large");
+
+	// Flush the queue, then send directly until a message must be buffered, keeping the order
+	bool sent = trySendQueue();
+	for (auto &message : messages) {
+		if (coalesce(message))
+			continue;
+
+		if (sent && trySendMessage(*message, message->data(), message->size()))
+			continue;
+
+		sent = false;
+		const auto stream = to_uint16(message->stream);
+		const auto amount = ptrdiff_t(message_size_func(message));
+		if (enqueueSend({std::move(message), nullptr}))
+			updateBufferedAmount(stream, amount);
+	}
+
+	return sent;
+}
+
+SctpTransport::LentData::LentData(const byte *data, size_t size, std::function<void()> release)
+    : data(data), size(size), release(std::move(release)) {}
+
+SctpTransport::LentData::~LentData() {
+	if (!release)
+		return;
+
+	try {
+		release();
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "Uncaught exception in release callback: " << e.what();
+	}
+}
+
+bool SctpTransport::enqueueSend(PendingMessage pending) {
+	// Requires mSendMutex to be locked
+	if (mSendClosed) {
+		PLOG_DEBUG << "SCTP send after close, dropping message";
+		return false;
+	}
+
+	pending.enqueued = LatencyHistogram::Now();
+
+	// The lifetime also covers the time spent in the queue, so stale messages are not sent late
+	const auto &reliability = pending.message->reliability;
+	if (reliability && reliability->maxPacketLifeTime && pending.amount() > 0)
+		pending.expiry = steady_clock::now() + *reliability->maxPacketLifeTime;
+
+	const auto stream = to_uint16(pending.message->stream);
+	mSendQueues.push(stream, std::move(pending));
+	return true;
+}
+
+void SctpTransport::setStreamPriority(uint16_t stream, uint16_t priority) {
+	std::lock_guard lock(mSendMutex);
+	mSendQueues.setPriority(stream, priority);
+	if (state() == State::Connected)
+		applyStreamPriority(stream, priority);
+}
+
+void SctpTransport::setStreamCoalescing(uint16_t stream, std::chrono::milliseconds window) {
+	std::lock_guard lock(mSendMutex);
+	mStreamCoalescingWindows[stream] = window;
+}
+
+void SctpTransport::setMtu(size_t mtu) {
+	// As usrsctp does not implement path MTU discovery, the path MTU is set explicitly, for
+	// instance once it has been discovered by probing with media
+	struct sctp_paddrparams spp = {};
+	spp.spp_flags = SPP_PMTUD_DISABLE;
+	size_t pmtu = mtu - 12 - 48 - 8 - 40; // SCTP/DTLS/UDP/IPv6
+	spp.spp_pathmtu = to_uint32(pmtu);
+	if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_PEER_ADDR_PARAMS, &spp, sizeof(spp))) {
+		PLOG_WARNING << "Could not set SCTP MTU, errno=" << errno;
+		return;
+	}
+
+	PLOG_VERBOSE << "SCTP MTU set to " << pmtu;
+}
+
+bool SctpTransport::coalesce(const message_ptr &message) {
+	// Requires mSendMutex to be locked
+	const uint16_t stream = to_uint16(message->stream);
+	auto wit = mStreamCoalescingWindows.find(stream);
+	if (wit == mStreamCoalescingWindows.end())
+		return false;
+
+	const bool eligible = (message->type == Message::Binary || message->type == Message::String) &&
+	                      message->size() <= COALESCING_MAX_MESSAGE_SIZE;
+
+	// Coalesced messages share the same reliability, and the order must be kept
+	auto it = mCoalescingBuffers.find(stream);
+	if (it != mCoalescingBuffers.end() &&
+	    (!eligible || it->second.pending.message->reliability != message->reliability)) {
+		enqueueCoalesced(stream);
+		it = mCoalescingBuffers.end();
+	}
+
+	if (!eligible)
+		return false;
+
+	if (it == mCoalescingBuffers.end()) {
+		auto buffer = make_message(COALESCING_TARGET_SIZE + COALESCING_MAX_MESSAGE_SIZE + 3,
+		                           Message::Binary, stream, message->reliability);
+		buffer->clear(); // keep the capacity
+		it = mCoalescingBuffers.emplace(stream, CoalescingBuffer{}).first;
+		it->second.pending = PendingMessage{std::move(buffer), nullptr, true};
+		it->second.timer = ThreadPool::Instance().setTimer(
+		    wit->second, [weak_this = weak_from_this(), stream]() {
+			    if (auto locked = weak_this.lock())
+				    locked->flushCoalesced(stream);
+		    });
+	}
+
+	auto &buffer = *it->second.pending.message;
+	const auto size = uint16_t(message->size());
+	buffer.push_back(byte(message->type == Message::String ? 1 : 0));
+	buffer.push_back(byte(size >> 8));
+	buffer.push_back(byte(size & 0xFF));
+	buffer.insert(buffer.end(), message->begin(), message->end());
+
+	// Coalesced bytes are buffered from now on, the framing included as it is sent too
+	updateBufferedAmount(stream, ptrdiff_t(size) + 3);
+
+	if (buffer.size() >= COALESCING_TARGET_SIZE) {
+		enqueueCoalesced(stream);
+		trySendQueue();
+	}
+	return true;
+}
+
+void SctpTransport::enqueueCoalesced(uint16_t stream) {
+	// Requires mSendMutex to be locked
+	auto it = mCoalescingBuffers.find(stream);
+	if (it == mCoalescingBuffers.end())
+		return;
+
+	auto coalescing = std::move(it->second);
+	mCoalescingBuffers.erase(it);
+	coalescing.timer.cancel();
+
+	// The buffered amount was already increased when messages were coalesced
+	const auto amount = ptrdiff_t(coalescing.pending.amount());
+	if (!enqueueSend(std::move(coalescing.pending)))
+		updateBufferedAmount(stream, -amount);
+}
+
+void SctpTransport::flushCoalesced(uint16_t stream) {
+	try {
+		WriteScope scope(this);
+		std::lock_guard lock(mSendMutex);
+		if (state() != State::Connected)
+			return;
+
+		enqueueCoalesced(stream);
+		trySendQueue();
+
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "SCTP flush: " << e.what();
+	}
+}
+
+void SctpTransport::attachStream(uint16_t stream, weak_ptr<Channel> channel) {
+	std::lock_guard lock(mSendMutex);
+	mStreamChannels[stream] = std::move(channel);
+}
+
+void SctpTransport::applyStreamPriority(uint16_t stream, uint16_t priority) {
+	// Requires mSendMutex to be locked
+	if (!mPriorityScheduler)
+		return;
+
+	// Lower values are scheduled first by the usrsctp priority scheduler
+	struct sctp_stream_value ssv = {};
+	ssv.assoc_id = SCTP_ALL_ASSOC;
+	ssv.stream_id = stream;
+	ssv.stream_value = uint16_t(std::numeric_limits<uint16_t>::max() - priority);
+	if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_SS_VALUE, &ssv, sizeof(ssv))) {
+		PLOG_DEBUG << "Could not set SCTP stream priority, errno=" << errno;
+	}
+}
+
 bool SctpTransport::flush() {
 	try {
+		WriteScope scope(this);
 		std::lock_guard lock(mSendMutex);
 		if (state() != State::Connected)
 			return false;
@@ -408,20 +789,38 @@ bool SctpTransport::flush() {
 	}
 }
 
+void SctpTransport::pauseRecv() {
+	// Pause and resume calls from different channels might be reordered
+	if (++mRecvPauseCount <= 0)
+		enqueueRecv();
+}
+
+void SctpTransport::resumeRecv() {
+	if (--mRecvPauseCount <= 0)
+		enqueueRecv();
+}
+
 void SctpTransport::closeStream(unsigned int stream) {
 	std::lock_guard lock(mSendMutex);
 
 	// RFC 8831 6.7. Closing a Data Channel
 	// Closing of a data channel MUST be signaled by resetting the corresponding outgoing streams
 	// See https://www.rfc-editor.org/rfc/rfc8831.html#section-6.7
-	mSendQueue.push(make_message(0, Message::Reset, to_uint16(stream)));
+	enqueueCoalesced(to_uint16(stream));
+	enqueueSend({make_message(0, Message::Reset, to_uint16(stream)), nullptr});
 
 	// This method must not call the buffered callback synchronously
 	mProcessor.enqueue(&SctpTransport::flush, shared_from_this());
 }
 
 void SctpTransport::close() {
-	mSendQueue.stop();
+	{
+		std::lock_guard lock(mSendMutex);
+		while (!mCoalescingBuffers.empty())
+			enqueueCoalesced(mCoalescingBuffers.begin()->first);
+	}
+
+	mSendClosed = true;
 	if (state() == State::Connected) {
 		mProcessor.enqueue(&SctpTransport::flush, shared_from_this());
 	} else if (state() == State::Connecting) {
@@ -464,7 +863,18 @@ void SctpTransport::incoming(message_ptr message) {
 
 	PLOG_VERBOSE << "Incoming size=" << message->size();
 
-	usrsctp_conninput(this, message->data(), message->size(), 0);
+#ifdef SCTP_ACCEPT_ZERO_CHECKSUM
+	if (bool accepted;
+	    sctp_parse_zero_checksum_acceptable(message->data(), message->size(), accepted)) {
+		if (accepted != mPeerAcceptsZeroChecksum.exchange(accepted)) {
+			PLOG_DEBUG << "SCTP zero checksum " << (accepted ? "accepted" : "not accepted")
+			           << " by the remote peer";
+		}
+	}
+#endif
+
+	WriteScope scope(this);
+	usrsctp_conninput(mToken.get(), message->data(), message->size(), 0);
 }
 
 bool SctpTransport::outgoing(message_ptr message) {
@@ -475,19 +885,28 @@ bool SctpTransport::outgoing(message_ptr message) {
 }
 
 void SctpTransport::doRecv() {
+	WriteScope scope(this); // reading may trigger window updates
 	std::lock_guard lock(mRecvMutex);
 	--mPendingRecvCount;
 	try {
+		auto &pool = MessagePool::Instance();
 		while (state() != State::Disconnected && state() != State::Failed) {
-			const size_t bufferSize = 65536;
-			byte buffer[bufferSize];
+			if (mRecvPauseCount.load() > 0)
+				break; // resumeRecv() will read again
+
+			// Receive directly into a pooled chunk, which may be handed over as message data
+			if (mRecvChunk.capacity() < RecvChunkSize)
+				mRecvChunk = pool.acquire(RecvChunkSize);
+			else
+				mRecvChunk.resize(RecvChunkSize); // does not reallocate
+
 			socklen_t fromlen = 0;
 			struct sctp_rcvinfo info = {};
 			socklen_t infolen = sizeof(info);
 			unsigned int infotype = 0;
 			int flags = 0;
-			ssize_t len = usrsctp_recvv(mSock, buffer, bufferSize, nullptr, &fromlen, &info,
-			                            &infolen, &infotype, &flags);
+			ssize_t len = usrsctp_recvv(mSock, mRecvChunk.data(), RecvChunkSize, nullptr, &fromlen,
+			                            &info, &infolen, &infotype, &flags);
 			if (len < 0) {
 				if (errno == EWOULDBLOCK || errno == EAGAIN || errno == ECONNRESET)
 					break;
@@ -503,7 +922,8 @@ void SctpTransport::doRecv() {
 			// therefore partial notifications and messages need to be handled separately.
 			if (flags & MSG_NOTIFICATION) {
 				// SCTP event notification
-				mPartialNotification.insert(mPartialNotification.end(), buffer, buffer + len);
+				mPartialNotification.insert(mPartialNotification.end(), mRecvChunk.begin(),
+				                            mRecvChunk.begin() + len);
 
 				if (flags & MSG_EOR) {
 					// Notification is complete, process it
@@ -515,29 +935,96 @@ void SctpTransport::doRecv() {
 
 			} else {
 				// SCTP message
-				mPartialMessage.insert(mPartialMessage.end(), buffer, buffer + len);
-				if (mPartialMessage.size() > mMaxMessageSize) {
-					PLOG_WARNING << "SCTP message is too large, truncating it";
-					mPartialMessage.resize(mMaxMessageSize);
+				if (infotype != SCTP_RECVV_RCVINFO)
+					throw std::runtime_error("Missing SCTP recv info");
+
+				// Small messages received at once, like state updates on unordered unreliable
+				// channels, skip reassembly entirely
+				auto it = mPartialMessages.find(info.rcv_sid);
+				if (it == mPartialMessages.end() && (flags & MSG_EOR) &&
+				    size_t(len) < RecvCopyThreshold && size_t(len) <= mMaxMessageSize &&
+				    tryProcessSmallData(mRecvChunk.data(), size_t(len), info.rcv_sid,
+				                        PayloadId(ntohl(info.rcv_ppid))))
+					continue;
+
+				// Messages received at once don't need to be stored as partial
+				PartialMessage complete;
+				auto &partial = it != mPartialMessages.end() ? it->second
+				                : (flags & MSG_EOR)          ? complete
+				                                             : mPartialMessages[info.rcv_sid];
+				size_t size = size_t(len);
+				if (partial.size + size > mMaxMessageSize) {
+					if (partial.size < mMaxMessageSize) { // warn only once per message
+						PLOG_WARNING << "SCTP message is too large, truncating it";
+					}
+					size = mMaxMessageSize - std::min(partial.size, mMaxMessageSize);
+				}
+
+				if (size > 0) {
+					if (size < RecvKeepThreshold) {
+						// Copy small data, including fragments and message tails, not to hold a
+						// whole chunk while queued
+						binary message = pool.acquire(size);
+						std::copy(mRecvChunk.begin(), mRecvChunk.begin() + size, message.begin());
+						partial.chunks.emplace_back(std::move(message));
+					} else {
+						mRecvChunk.resize(size);
+						partial.chunks.emplace_back(std::move(mRecvChunk));
+						mRecvChunk = binary();
+					}
+					partial.size += size;
 				}
 
 				if (flags & MSG_EOR) {
 					// Message is complete, process it
-					binary message;
-					mPartialMessage.swap(message);
-					if (infotype != SCTP_RECVV_RCVINFO)
-						throw std::runtime_error("Missing SCTP recv info");
-
+					binary message = assemblePartialMessage(partial);
+					if (it != mPartialMessages.end())
+						mPartialMessages.erase(it);
 					processData(std::move(message), info.rcv_sid, PayloadId(ntohl(info.rcv_ppid)));
 				}
 			}
 		}
+
+		// In low-memory mode, don't hold a chunk while idle, the pool is shared between transports
+		if (mLowMemory && mRecvChunk.capacity() > 0) {
+			pool.recycle(std::move(mRecvChunk));
+			mRecvChunk = binary();
+		}
 	} catch (const std::exception &e) {
 		PLOG_WARNING << e.what();
 	}
+
+	size_t usage = mRecvChunk.capacity() + mPartialNotification.capacity() +
+	               mPartialStringData.capacity() + mPartialBinaryData.capacity();
+	for (const auto &[stream, partial] : mPartialMessages)
+		for (const auto &chunk : partial.chunks)
+			usage += chunk.capacity();
+
+	mRecvMemoryUsage.store(usage, std::memory_order_relaxed);
+}
+
+binary SctpTransport::assemblePartialMessage(PartialMessage &partial) {
+	binary message;
+	if (partial.chunks.size() == 1) {
+		message = std::move(partial.chunks.front()); // no copy
+	} else if (!partial.chunks.empty()) {
+		// Copy chunks once into a buffer of the final size
+		auto &pool = MessagePool::Instance();
+		message = pool.acquire(partial.size);
+		auto it = message.begin();
+		for (auto &chunk : partial.chunks) {
+			it = std::copy(chunk.begin(), chunk.end(), it);
+			pool.recycle(std::move(chunk));
+		}
+	}
+
+	partial.chunks.clear();
+	partial.size = 0;
+	return message;
 }
 
 void SctpTransport::doFlush() {
+	WriteScope scope(this);
 	std::lock_guard lock(mSendMutex);
 	--mPendingFlushCount;
 	try {
@@ -571,16 +1058,47 @@ void SctpTransport::enqueueFlush() {
 
 bool SctpTransport::trySendQueue() {
 	// Requires mSendMutex to be locked
-	while (auto next = mSendQueue.peek()) {
-		message_ptr message = std::move(*next);
-		if (!trySendMessage(message))
+	optional<steady_clock::time_point> now;
+	while (!mSendQueues.empty()) {
+		const uint16_t stream = mSendQueues.next();
+		auto &front = mSendQueues.front(stream);
+		if (front.expiry) {
+			if (!now)
+				now = steady_clock::now();
+
+			if (*front.expiry <= *now) {
+				// Drop the expired message, it would be abandoned by the peer anyway
+				PLOG_VERBOSE << "SCTP dropping expired message on stream " << stream;
+				PendingMessage expired = mSendQueues.drop(stream);
+				updateBufferedAmount(stream, -ptrdiff_t(expired.amount()));
+				++mMessagesExpired;
+				continue;
+			}
+		}
+
+		if (!trySendMessage(*front.message, front.data(), front.size(), front.coalesced)) {
+			sendResets();
 			return false;
+		}
 
-		mSendQueue.pop();
-		updateBufferedAmount(to_uint16(message->stream), -ptrdiff_t(message_size_func(message)));
+		// Lent data is released when the pending message goes out of scope
+		PendingMessage pending = mSendQueues.pop(stream, front.size());
+		HISTOGRAM_QUEUE_RESIDENCE.recordSince(pending.enqueued);
+		updateBufferedAmount(stream, -ptrdiff_t(pending.amount()));
+
+		const auto &message = pending.message;
+		if (message->type == Message::Reset) {
+			// The stream may be reused
+			mSendQueues.erasePriority(stream);
+			mStreamCoalescingWindows.erase(stream);
+			mStreamChannels.erase(stream);
+		}
 	}
 
-	if (!mSendQueue.running() && !std::exchange(mSendShutdown, true)) {
+	// Streams reset meanwhile must be reset before shutdown
+	sendResets();
+
+	if (mSendClosed && !std::exchange(mSendShutdown, true)) {
 		PLOG_DEBUG << "SCTP shutdown";
 		if (usrsctp_shutdown(mSock, SHUT_WR)) {
 			if (errno == ENOTCONN) {
@@ -596,42 +1114,49 @@ bool SctpTransport::trySendQueue() {
 	return true;
 }
 
-bool SctpTransport::trySendMessage(message_ptr message) {
+bool SctpTransport::trySendMessage(const Message &message, const byte *data, size_t size,
+                                   bool coalesced) {
 	// Requires mSendMutex to be locked
 	if (state() != State::Connected)
 		return false;
 
 	uint32_t ppid;
-	switch (message->type) {
+	switch (message.type) {
 	case Message::String:
-		ppid = !message->empty() ? PPID_STRING : PPID_STRING_EMPTY;
+		ppid = size > 0 ? PPID_STRING : PPID_STRING_EMPTY;
 		break;
 	case Message::Binary:
-		ppid = !message->empty() ? PPID_BINARY : PPID_BINARY_EMPTY;
+		if (coalesced)
+			ppid = PPID_COALESCED;
+		else
+			ppid = size > 0 ? PPID_BINARY : PPID_BINARY_EMPTY;
 		break;
 	case Message::Control:
 		ppid = PPID_CONTROL;
 		break;
 	case Message::Reset:
-		sendReset(uint16_t(message->stream));
+		// Resets are sent in batch by trySendQueue()
+		mPendingResets.push_back(uint16_t(message.stream));
 		return true;
 	default:
 		// Ignore
 		return true;
 	}
 
-	PLOG_VERBOSE << "SCTP try send size=" << message->size();
+	PLOG_VERBOSE << "SCTP try send size=" << size;
 
 	// TODO: Implement SCTP ndata specification draft when supported everywhere
 	// See https://datatracker.ietf.org/doc/html/draft-ietf-tsvwg-sctp-ndata-08
 
-	const Reliability reliability = message->reliability ? *message->reliability : Reliability();
+	static const Reliability DefaultReliability;
+	const Reliability &reliability =
+	    message.reliability ? *message.reliability : DefaultReliability;
 
 	struct sctp_sendv_spa spa = {};
 
 	// set sndinfo
 	spa.sendv_flags |= SCTP_SEND_SNDINFO_VALID;
-	spa.sendv_sndinfo.snd_sid = uint16_t(message->stream);
+	spa.sendv_sndinfo.snd_sid = uint16_t(message.stream);
 	spa.sendv_sndinfo.snd_ppid = htonl(ppid);
 	spa.sendv_sndinfo.snd_flags |= SCTP_EOR; // implicit here
 
@@ -670,9 +1195,8 @@ bool SctpTransport::trySendMessage(message_ptr message) {
 	}
 
 	ssize_t ret;
-	if (!message->empty()) {
-		ret = usrsctp_sendv(mSock, message->data(), message->size(), nullptr, 0, &spa, sizeof(spa),
-		                    SCTP_SENDV_SPA, 0);
+	if (size > 0) {
+		ret = usrsctp_sendv(mSock, data, size, nullptr, 0, &spa, sizeof(spa), SCTP_SENDV_SPA, 0);
 	} else {
 		const char zero = 0;
 		ret = usrsctp_sendv(mSock, &zero, 1, nullptr, 0, &spa, sizeof(spa), SCTP_SENDV_SPA, 0);
@@ -688,9 +1212,11 @@ bool SctpTransport::trySendMessage(message_ptr message) {
 		throw std::runtime_error("Sending failed, errno=" + std::to_string(errno));
 	}
 
-	PLOG_VERBOSE << "SCTP sent size=" << message->size();
-	if (message->type == Message::Binary || message->type == Message::String)
-		mBytesSent += message->size();
+	PLOG_VERBOSE << "SCTP sent size=" << size;
+	if (message.type == Message::Binary || message.type == Message::String) {
+		mBytesSent += size;
+		++mMessagesSent;
+	}
 	return true;
 }
 
@@ -700,47 +1226,75 @@ void SctpTransport::updateBufferedAmount(uint16_t streamId, ptrdiff_t delta) {
 	if (delta == 0)
 		return;
 
-	auto it = mBufferedAmount.insert(std::make_pair(streamId, 0)).first;
-	size_t amount = size_t(std::max(ptrdiff_t(it->second) + delta, ptrdiff_t(0)));
-	if (amount == 0)
-		mBufferedAmount.erase(it);
-	else
-		it->second = amount;
-
-	// Synchronously call the buffered amount callback
-	triggerBufferedAmount(streamId, amount);
-}
+	auto it = mStreamChannels.find(streamId);
+	if (it == mStreamChannels.end())
+		return;
 
-void SctpTransport::triggerBufferedAmount(uint16_t streamId, size_t amount) {
-	try {
-		mBufferedAmountCallback(streamId, amount);
-	} catch (const std::exception &e) {
-		PLOG_WARNING << "SCTP buffered amount callback: " << e.what();
-	}
+	// Synchronously update the channel, which calls the low callback on threshold crossing
+	if (auto channel = it->second.lock())
+		channel->updateBufferedAmount(delta);
+	else
+		mStreamChannels.erase(it);
 }
 
-void SctpTransport::sendReset(uint16_t streamId) {
+void SctpTransport::sendResets() {
 	// Requires mSendMutex to be locked
-	if (state() != State::Connected)
+	if (mPendingResets.empty() || state() != State::Connected)
 		return;
 
-	PLOG_DEBUG << "SCTP resetting stream " << streamId;
-
+	// RFC 6525 allows a single request to reset a list of outgoing streams, so closing many
+	// channels at once takes a single round trip
 	using srs_t = struct sctp_reset_streams;
-	const size_t len = sizeof(srs_t) + sizeof(uint16_t);
-	byte buffer[len] = {};
-	srs_t &srs = *reinterpret_cast<srs_t *>(buffer);
+	const size_t count = std::min(mPendingResets.size(), size_t(MAX_SCTP_STREAMS_COUNT));
+	const size_t len = sizeof(srs_t) + count * sizeof(uint16_t);
+	binary buffer(len, byte(0));
+	srs_t &srs = *reinterpret_cast<srs_t *>(buffer.data());
 	srs.srs_flags = SCTP_STREAM_RESET_OUTGOING;
-	srs.srs_number_streams = 1;
-	srs.srs_stream_list[0] = streamId;
+	srs.srs_number_streams = uint16_t(count);
+	std::copy(mPendingResets.begin(), mPendingResets.begin() + count, srs.srs_stream_list);
+
+	PLOG_DEBUG << "SCTP resetting " << count << " stream(s)";
+
+	if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_RESET_STREAMS, &srs, socklen_t(len)) == 0) {
+		mPendingResets.erase(mPendingResets.begin(), mPendingResets.begin() + count);
+		mResetsDeferred = !mPendingResets.empty();
+		return;
+	}
 
-	if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_RESET_STREAMS, &srs, len)) {
-		if (errno == EINVAL) {
-			PLOG_DEBUG << "SCTP stream " << streamId << " already reset";
+	switch (errno) {
+	case EALREADY:
+	case EBUSY:
+	case EAGAIN:
+		// A request is still outstanding, keep the streams until the reset event
+		PLOG_VERBOSE << "SCTP reset deferred, errno=" << errno;
+		mResetsDeferred = true;
+		return;
+
+	case EINVAL:
+		if (count > 1) {
+			// A stream in the list was already reset, fall back to resetting them one by one
+			srs.srs_number_streams = 1;
+			const size_t singleLen = sizeof(srs_t) + sizeof(uint16_t);
+			for (size_t i = 0; i < count; ++i) {
+				srs.srs_stream_list[0] = mPendingResets[i];
+				if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_RESET_STREAMS, &srs,
+				                       socklen_t(singleLen))) {
+					PLOG_DEBUG << "SCTP reset stream " << mPendingResets[i]
+					           << " failed, errno=" << errno;
+				}
+			}
 		} else {
-			PLOG_WARNING << "SCTP reset stream " << streamId << " failed, errno=" << errno;
+			PLOG_DEBUG << "SCTP stream " << mPendingResets.front() << " already reset";
 		}
+		break;
+
+	default:
+		PLOG_WARNING << "SCTP reset of " << count << " stream(s) failed, errno=" << errno;
+		break;
 	}
+
+	mPendingResets.erase(mPendingResets.begin(), mPendingResets.begin() + count);
+	mResetsDeferred = !mPendingResets.empty();
 }
 
 void SctpTransport::handleUpcall() noexcept {
@@ -748,6 +1302,7 @@ void SctpTransport::handleUpcall() noexcept {
 		PLOG_VERBOSE << "Handle upcall";
 
 		int events = usrsctp_get_events(mSock);
+		Tracing::Trace(TracePoint::SctpUpcall, this, uint64_t(events));
 
 		if (events & SCTP_EVENT_READ)
 			enqueueRecv();
@@ -763,11 +1318,35 @@ void SctpTransport::handleUpcall() noexcept {
 int SctpTransport::handleWrite(byte *data, size_t len, uint8_t /*tos*/,
                                uint8_t /*set_df*/) noexcept {
 	try {
+		// Set the CRC32 ourselves as we have enabled CRC32 offloading, unless the remote peer
+		// accepts a zero checksum
+		if (len >= SctpCommonHeaderSize) {
+			byte *checksum = data + SctpChecksumOffset;
+			std::memset(checksum, 0, 4);
+			if (!mPeerAcceptsZeroChecksum || sctp_requires_checksum(data, len)) {
+				const uint32_t crc = crc32c(data, len);
+				for (int i = 0; i < 4; ++i)
+					checksum[i] = byte((crc >> (8 * i)) & 0xFF); // least significant first
+			}
+		}
+
 		std::unique_lock lock(mWriteMutex);
 		PLOG_VERBOSE << "Handle write, len=" << len;
 
-		if (!outgoing(make_message(data, data + len)))
-			return -1;
+		if (CurrentWriteScope == this && !mWriteBatchFailed) {
+			auto message = make_message(data, data + len);
+			message->dscp = 10; // see outgoing()
+			mWriteBatch.push_back(std::move(message));
+		} else if (mPacer) {
+			auto message = make_message(data, data + len);
+			message->dscp = 10;
+			sendPaced({std::move(message)});
+		} else {
+			if (!outgoing(make_message(data, data + len)))
+				return -1;
+
+			mWriteBatchFailed = false;
+		}
 
 		mWritten = true;
 		mWrittenOnce = true;
@@ -794,18 +1373,18 @@ void SctpTransport::processData(binary &&data, uint16_t sid, PayloadId ppid) {
 		break;
 
 	case PPID_STRING_PARTIAL: // deprecated
-		mPartialStringData.insert(mPartialStringData.end(), data.begin(), data.end());
-		mPartialStringData.resize(mMaxMessageSize);
+		appendPartial(mPartialStringData, data);
 		break;
 
 	case PPID_STRING:
 		if (mPartialStringData.empty()) {
 			mBytesReceived += data.size();
+			++mMessagesReceived;
 			recv(make_message(std::move(data), Message::String, sid));
 		} else {
-			mPartialStringData.insert(mPartialStringData.end(), data.begin(), data.end());
-			mPartialStringData.resize(mMaxMessageSize);
+			appendPartial(mPartialStringData, data);
 			mBytesReceived += mPartialStringData.size();
+			++mMessagesReceived;
 			auto message = make_message(std::move(mPartialStringData), Message::String, sid);
 			mPartialStringData.clear();
 			recv(std::move(message));
@@ -818,18 +1397,18 @@ void SctpTransport::processData(binary &&data, uint16_t sid, PayloadId ppid) {
 		break;
 
 	case PPID_BINARY_PARTIAL: // deprecated
-		mPartialBinaryData.insert(mPartialBinaryData.end(), data.begin(), data.end());
-		mPartialBinaryData.resize(mMaxMessageSize);
+		appendPartial(mPartialBinaryData, data);
 		break;
 
 	case PPID_BINARY:
 		if (mPartialBinaryData.empty()) {
 			mBytesReceived += data.size();
+			++mMessagesReceived;
 			recv(make_message(std::move(data), Message::Binary, sid));
 		} else {
-			mPartialBinaryData.insert(mPartialBinaryData.end(), data.begin(), data.end());
-			mPartialBinaryData.resize(mMaxMessageSize);
+			appendPartial(mPartialBinaryData, data);
 			mBytesReceived += mPartialBinaryData.size();
+			++mMessagesReceived;
 			auto message = make_message(std::move(mPartialBinaryData), Message::Binary, sid);
 			mPartialBinaryData.clear();
 			recv(std::move(message));
@@ -841,6 +1420,28 @@ void SctpTransport::processData(binary &&data, uint16_t sid, PayloadId ppid) {
 		mPartialBinaryData.clear();
 		break;
 
+	case PPID_COALESCED: {
+		// Unpack messages coalesced by a remote libdatachannel
+		size_t pos = 0;
+		while (pos + 3 <= data.size()) {
+			auto type = data[pos] == byte(1) ? Message::String : Message::Binary;
+			size_t size = (size_t(data[pos + 1]) << 8) | size_t(data[pos + 2]);
+			pos += 3;
+			if (size > data.size() - pos)
+				break;
+
+			auto begin = data.begin() + pos;
+			mBytesReceived += size;
+			++mMessagesReceived;
+			recv(make_message(begin, begin + size, type, sid));
+			pos += size;
+		}
+		if (pos != data.size()) {
+			PLOG_WARNING << "Truncated coalesced SCTP message";
+		}
+		break;
+	}
+
 	default:
 		// Unknown
 		COUNTER_UNKNOWN_PPID++;
@@ -849,6 +1450,46 @@ void SctpTransport::processData(binary &&data, uint16_t sid, PayloadId ppid) {
 	}
 }
 
+bool SctpTransport::tryProcessSmallData(const byte *data, size_t size, uint16_t sid,
+                                        PayloadId ppid) {
+	Message::Type type;
+	switch (ppid) {
+	case PPID_STRING:
+		if (!mPartialStringData.empty())
+			return false; // end of a deprecated PPID-based fragmented message
+
+		type = Message::String;
+		break;
+
+	case PPID_BINARY:
+		if (!mPartialBinaryData.empty())
+			return false; // same
+
+		type = Message::Binary;
+		break;
+
+	default:
+		return false; // general path
+	}
+
+	binary message = MessagePool::Instance().acquire(size);
+	std::copy(data, data + size, message.begin());
+	mBytesReceived += size;
+	++mMessagesReceived;
+	recv(make_message(std::move(message), type, sid));
+	return true;
+}
+
+void SctpTransport::appendPartial(binary &partial, const binary &data) {
+	// Used for deprecated PPID-based fragmentation only
+	size_t size = std::min(data.size(), mMaxMessageSize - std::min(partial.size(), mMaxMessageSize));
+	if (size < data.size()) {
+		PLOG_WARNING << "SCTP message is too large, truncating it";
+	}
+
+	partial.insert(partial.end(), data.begin(), data.begin() + size);
+}
+
 void SctpTransport::processNotification(const union sctp_notification *notify, size_t len) {
 	if (len != size_t(notify->sn_header.sn_length)) {
 		PLOG_WARNING << "Unexpected notification length, expected=" << notify->sn_header.sn_length
@@ -870,7 +1511,19 @@ void SctpTransport::processNotification(const union sctp_notification *notify, s
 			    std::min(sac.sac_inbound_streams, sac.sac_outbound_streams));
 
 			PLOG_INFO << "SCTP connected";
+			{
+				std::lock_guard lock(mSendMutex);
+				for (auto [stream, priority] : mSendQueues.priorities())
+					applyStreamPriority(stream, priority);
+			}
 			changeState(State::Connected);
+
+			if (mAutoTune) {
+				mAutoTuneBytesSent = mBytesSent;
+				mAutoTuneBytesReceived = mBytesReceived;
+				mAutoTuneTime = steady_clock::now();
+				scheduleAutoTune();
+			}
 		} else {
 			if (state() == State::Connected) {
 				PLOG_INFO << "SCTP disconnected";
@@ -931,6 +1584,11 @@ void SctpTransport::processNotification(const union sctp_notification *notify, s
 				recv(make_message(0, Message::Reset, streamId));
 			}
 		}
+
+		// The outstanding request is complete, send the resets deferred meanwhile
+		if (mResetsDeferred.exchange(false))
+			flush();
+
 		break;
 	}
 
@@ -943,6 +1601,9 @@ void SctpTransport::processNotification(const union sctp_notification *notify, s
 void SctpTransport::clearStats() {
 	mBytesReceived = 0;
 	mBytesSent = 0;
+	mMessagesReceived = 0;
+	mMessagesSent = 0;
+	mMessagesExpired = 0;
 }
 
 size_t SctpTransport::bytesSent() { return mBytesSent; }
@@ -961,28 +1622,242 @@ optional<milliseconds> SctpTransport::rtt() {
 	return milliseconds(status.sstat_primary.spinfo_srtt);
 }
 
+void SctpTransport::scheduleAutoTune() {
+	std::lock_guard lock(mAutoTuneTimerMutex);
+	auto weak_this = weak_from_this();
+	mAutoTuneTimer = ThreadPool::Instance().setTimer(mAutoTuneInterval, [weak_this]() {
+		if (auto locked = weak_this.lock())
+			locked->mProcessor.enqueue(&SctpTransport::autoTune, locked);
+	});
+}
+
+void SctpTransport::autoTune() {
+	if (state() != State::Connected)
+		return;
+
+	struct sctp_status status = {};
+	socklen_t len = sizeof(status);
+	if (usrsctp_getsockopt(mSock, IPPROTO_SCTP, SCTP_STATUS, &status, &len)) {
+		PLOG_WARNING << "Could not get SCTP status for auto-tuning, errno=" << errno;
+		return;
+	}
+
+	// Stats might have been cleared in the meantime
+	auto now = steady_clock::now();
+	size_t sent = mBytesSent, received = mBytesReceived;
+	size_t sentDelta = sent >= mAutoTuneBytesSent ? sent - mAutoTuneBytesSent : 0;
+	size_t receivedDelta =
+	    received >= mAutoTuneBytesReceived ? received - mAutoTuneBytesReceived : 0;
+	auto elapsed = duration_cast<microseconds>(now - mAutoTuneTime).count();
+	mAutoTuneBytesSent = sent;
+	mAutoTuneBytesReceived = received;
+	mAutoTuneTime = now;
+
+	if (sentDelta == 0 && receivedDelta == 0) {
+		if (++mIdleIntervals >= IdleShrinkIntervals) {
+			shrinkBuffer(SO_SNDBUF, mSendBufferSize, mInitialSendBufferSize);
+			shrinkBuffer(SO_RCVBUF, mRecvBufferSize, mInitialRecvBufferSize);
+			if (mLowMemory)
+				mAutoTuneInterval = std::min<steady_clock::duration>(mAutoTuneInterval * 2,
+				                                                     MaxAutoTuneInterval);
+		}
+		scheduleAutoTune();
+		return;
+	}
+
+	mIdleIntervals = 0;
+	mAutoTuneInterval = AutoTuneInterval;
+
+	auto srtt = int64_t(status.sstat_primary.spinfo_srtt); // in milliseconds
+	if (elapsed > 0 && srtt > 0) {
+		// If the throughput is limited by a buffer, the bandwidth-delay product is close to its
+		// size, so targeting twice the product doubles it each interval until the link is filled
+		auto bdp = [&](size_t bytes) { return size_t(int64_t(bytes) * srtt * 1000 / elapsed); };
+		size_t cwnd = size_t(status.sstat_primary.spinfo_cwnd);
+		growBuffer(SO_SNDBUF, mSendBufferSize, 2 * std::max(bdp(sentDelta), cwnd));
+		growBuffer(SO_RCVBUF, mRecvBufferSize, 2 * bdp(receivedDelta));
+	}
+
+	scheduleAutoTune();
+}
+
+void SctpTransport::growBuffer(int option, size_t &current, size_t target) {
+	size_t size = std::min(target, size_t(MaxAutoTuneBufferSize));
+	size = std::min(size, size_t(std::numeric_limits<int>::max()));
+	if (size > current && setBufferSize(option, size))
+		current = size;
+}
+
+void SctpTransport::shrinkBuffer(int option, size_t &current, size_t initial) {
+	if (current > initial && setBufferSize(option, initial))
+		current = initial;
+}
+
+bool SctpTransport::setBufferSize(int option, size_t size) {
+	int value = int(size);
+	if (usrsctp_setsockopt(mSock, SOL_SOCKET, option, &value, sizeof(value))) {
+		PLOG_WARNING << "Could not set SCTP buffer size for auto-tuning, errno=" << errno;
+		return false;
+	}
+
+	PLOG_DEBUG << "SCTP auto-tuned " << (option == SO_SNDBUF ? "send" : "recv")
+	           << " buffer size=" << size;
+	return true;
+}
+
+void SctpTransport::StartTimers() {
+	std::lock_guard lock(TimersMutex);
+	ScheduleTimers();
+}
+
+void SctpTransport::ScheduleTimers() {
+	// Requires TimersMutex to be locked
+	if (std::exchange(TimersScheduled, true))
+		return;
+
+	// Align on the tick so that wakeups land in the same slots whenever rescheduled
+	auto now = steady_clock::now();
+	auto next = now + TimersTick - now.time_since_epoch() % TimersTick;
+	ThreadPool::Instance().setTimer(next, &SctpTransport::HandleTimers);
+}
+
+void SctpTransport::HandleTimers() {
+	uint32_t elapsed;
+	{
+		std::lock_guard lock(TimersMutex);
+		auto now = steady_clock::now();
+		auto ms = duration_cast<milliseconds>(now - TimersTime);
+		TimersTime += ms; // keep the remainder for the next tick
+		elapsed = to_uint32(ms.count());
+	}
+
+	// Elapsed time while idle is passed as a whole so usrsctp ticks stay in sync with real time
+	usrsctp_handle_timers(elapsed);
+
+	std::lock_guard lock(TimersMutex);
+	TimersScheduled = false;
+	if (InstancesCount > 0)
+		ScheduleTimers(); // stop ticking when idle
+}
+
+size_t SctpTransport::memoryUsage() {
+	// Must not lock mRecvMutex, as it may be called from a message callback
+	size_t usage = mRecvMemoryUsage.load(std::memory_order_relaxed);
+	{
+		std::lock_guard lock(mSendMutex);
+		mSendQueues.forEach([&usage](uint16_t, const PendingMessage &pending) {
+			usage += pending.message->capacity();
+		});
+
+		for (const auto &[stream, coalescing] : mCoalescingBuffers)
+			usage += coalescing.pending.message->capacity();
+	}
+	{
+		std::lock_guard lock(mWriteMutex);
+		for (const auto &message : mWriteBatch)
+			usage += message->capacity();
+	}
+	return usage;
+}
+
+SctpTransportStats SctpTransport::sctpStats() {
+	SctpTransportStats stats;
+	stats.packetsSent = mMessagesSent.load(std::memory_order_relaxed);
+	stats.bytesSent = mBytesSent.load(std::memory_order_relaxed);
+	stats.packetsReceived = mMessagesReceived.load(std::memory_order_relaxed);
+	stats.bytesReceived = mBytesReceived.load(std::memory_order_relaxed);
+	stats.expiredMessages = mMessagesExpired.load(std::memory_order_relaxed);
+	stats.memoryUsage = memoryUsage();
+
+	// usrsctp does not expose retransmission counters, report the association status instead
+	struct sctp_status status = {};
+	socklen_t len = sizeof(status);
+	if (state() == State::Connected &&
+	    usrsctp_getsockopt(mSock, IPPROTO_SCTP, SCTP_STATUS, &status, &len) == 0) {
+		stats.rtt = milliseconds(status.sstat_primary.spinfo_srtt);
+		stats.congestionWindow = status.sstat_primary.spinfo_cwnd;
+		stats.peerReceiveWindow = status.sstat_rwnd;
+		stats.pendingChunks = status.sstat_penddata;
+		stats.unacknowledgedChunks = status.sstat_unackdata;
+	}
+	return stats;
+}
+
 void SctpTransport::UpcallCallback(struct socket *, void *arg, int /* flags */) {
-	auto *transport = static_cast<SctpTransport *>(arg);
+	auto *token = static_cast<Token *>(arg);
 
-	if (auto locked = Instances->lock(transport))
+	std::shared_lock lock(token->mutex);
+	if (auto *transport = token->instance)
 		transport->handleUpcall();
 }
 
-int SctpTransport::WriteCallback(void *ptr, void *data, size_t len, uint8_t tos, uint8_t set_df) {
-	auto *transport = static_cast<SctpTransport *>(ptr);
+thread_local SctpTransport *SctpTransport::CurrentWriteScope = nullptr;
+
+SctpTransport::WriteScope::WriteScope(SctpTransport *transport)
+    : mTransport(transport), mPrevious(std::exchange(CurrentWriteScope, transport)) {}
+
+SctpTransport::WriteScope::~WriteScope() {
+	CurrentWriteScope = mPrevious;
+	if (mPrevious != mTransport) // outermost scope for the transport
+		mTransport->flushWriteBatch();
+}
 
-#ifndef SCTP_ACCEPT_ZERO_CHECKSUM
-	// Set the CRC32 ourselves as we have enabled CRC32 offloading
-	if (len >= 12) {
-		uint32_t *checksum = reinterpret_cast<uint32_t *>(data) + 2;
-		*checksum = 0;
-		*checksum = usrsctp_crc32c(data, len);
+void SctpTransport::flushWriteBatch() {
+	try {
+		std::unique_lock lock(mWriteMutex);
+		if (mWriteBatch.empty())
+			return;
+
+		message_vector batch;
+		batch.swap(mWriteBatch);
+		PLOG_VERBOSE << "Flushing SCTP write batch, count=" << batch.size();
+		if (mPacer) {
+			sendPaced(std::move(batch));
+		} else if (!Transport::outgoingBatch(std::move(batch))) {
+			// The packets were already reported as written, usrsctp will retransmit them
+			PLOG_DEBUG << "SCTP write batch failed, sending directly";
+			mWriteBatchFailed = true;
+		}
+
+	} catch (const std::exception &e) {
+		PLOG_ERROR << "SCTP write: " << e.what();
+		std::lock_guard lock(mWriteMutex);
+		mWriteBatchFailed = true;
 	}
-#endif
+}
+
+void SctpTransport::setPacer(shared_ptr<MediaHandler> pacer) {
+	std::unique_lock lock(mWriteMutex);
+	if (pacer && !mPacedSendCallback)
+		mPacedSendCallback = [weak_this = weak_from_this()](message_ptr message) {
+			// The pacer sends later from the thread pool, possibly after the transport is gone
+			if (auto locked = weak_this.lock())
+				locked->Transport::outgoing(std::move(message));
+		};
+
+	mPacer = std::move(pacer);
+}
+
+void SctpTransport::sendPaced(message_vector messages) {
+	// Requires mWriteMutex to be locked
+	try {
+		mPacer->outgoingChain(messages, mPacedSendCallback);
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "SCTP pacer: " << e.what();
+	}
+
+	// Messages left by the handler are sent right away
+	if (!messages.empty())
+		Transport::outgoingBatch(std::move(messages));
+}
+
+int SctpTransport::WriteCallback(void *ptr, void *data, size_t len, uint8_t tos, uint8_t set_df) {
+	auto *token = static_cast<Token *>(ptr);
 
 	// Workaround for sctplab/usrsctp#405: Send callback is invoked on already closed socket
 	// https://github.com/sctplab/usrsctp/issues/405
-	if (auto locked = Instances->lock(transport))
+	std::shared_lock lock(token->mutex);
+	if (auto *transport = token->instance)
 		return transport->handleWrite(static_cast<byte *>(data), len, tos, set_df);
 	else
 		return -1;
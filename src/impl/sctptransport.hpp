@@ -12,10 +12,15 @@
 #include "common.hpp"
 #include "configuration.hpp"
 #include "global.hpp"
+#include "mediahandler.hpp"
 #include "processor.hpp"
 #include "queue.hpp"
+#include "streamscheduler.hpp"
+#include "threadpool.hpp"
 #include "transport.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <map>
@@ -25,31 +30,55 @@
 
 namespace rtc::impl {
 
+struct Channel;
+
 class SctpTransport final : public Transport, public std::enable_shared_from_this<SctpTransport> {
 public:
-	static void Init();
+	static void Init(const SctpSettings &s);
 	static void SetSettings(const SctpSettings &s);
 	static void Cleanup();
 
-	using amount_callback = std::function<void(uint16_t streamId, size_t amount)>;
-
 	struct Ports {
 		uint16_t local = DEFAULT_SCTP_PORT;
 		uint16_t remote = DEFAULT_SCTP_PORT;
 	};
 
 	SctpTransport(shared_ptr<Transport> lower, const Configuration &config, Ports ports,
-	              message_callback recvCallback, amount_callback bufferedAmountCallback,
-	              state_callback stateChangeCallback);
+	              message_callback recvCallback, state_callback stateChangeCallback);
 	~SctpTransport();
 
-	void onBufferedAmount(amount_callback callback);
-
 	void start() override;
 	void stop() override;
+
+	// Processing runs on the executor instead of the thread pool, call before start()
+	void setExecutor(shared_ptr<Executor> executor);
+
+	// Caller-owned data sent without copy, released on destruction once it is not needed anymore
+	struct LentData {
+		LentData(const byte *data, size_t size, std::function<void()> release);
+		LentData(const LentData &) = delete; // a copy would release twice
+		LentData &operator=(const LentData &) = delete;
+		~LentData();
+
+		const byte *data;
+		size_t size;
+		std::function<void()> release;
+	};
+
 	bool send(message_ptr message) override; // false if buffered
+	bool send(message_ptr message, unique_ptr<LentData> lent); // message only holds the metadata
+	bool send(message_vector messages); // false if any is buffered
 	bool flush();
 	void closeStream(unsigned int stream);
+	void setStreamPriority(uint16_t stream, uint16_t priority); // RFC 8832 priority
+	void setStreamCoalescing(uint16_t stream, std::chrono::milliseconds window);
+	void setMtu(size_t mtu); // path MTU, replaces Configuration::mtu
+	void setPacer(shared_ptr<MediaHandler> pacer); // outgoing packets go through it, may be null
+	void attachStream(uint16_t stream, weak_ptr<Channel> channel); // for buffered amount
+	// Reading stops while any channel paused it, then the receive window throttles the peer.
+	// Like SCTP flow control, this applies to the whole association.
+	void pauseRecv();
+	void resumeRecv();
 	void close();
 
 	unsigned int maxStream() const;
@@ -59,6 +88,21 @@ public:
 	size_t bytesSent();
 	size_t bytesReceived();
 	optional<std::chrono::milliseconds> rtt();
+	size_t memoryUsage(); // bytes held in transport buffers
+	SctpTransportStats sctpStats();
+
+	// Packets written by usrsctp while the current thread is in a write scope (i.e. sending,
+	// flushing, or receiving) are batched and passed down together when the scope ends.
+	// Callers may open one around consecutive sends, like opening many channels at once.
+	class WriteScope final {
+	public:
+		WriteScope(SctpTransport *transport);
+		~WriteScope();
+
+	private:
+		SctpTransport *const mTransport;
+		SctpTransport *const mPrevious;
+	};
 
 private:
 	// Order seems wrong but these are the actual values
@@ -70,7 +114,10 @@ private:
 		PPID_BINARY = 53,
 		PPID_STRING_PARTIAL = 54,
 		PPID_STRING_EMPTY = 56,
-		PPID_BINARY_EMPTY = 57
+		PPID_BINARY_EMPTY = 57,
+		// Not registered, small messages coalesced by libdatachannel, each one prefixed with its
+		// type (0 for binary, 1 for string) and its 16-bit length in network byte order
+		PPID_COALESCED = 0x4C444331
 	};
 
 	struct sockaddr_conn getSockAddrConn(uint16_t port);
@@ -85,18 +132,27 @@ private:
 	void enqueueRecv();
 	void enqueueFlush();
 	bool trySendQueue();
-	bool trySendMessage(message_ptr message);
+	bool trySendMessage(const Message &message, const byte *data, size_t size,
+	                    bool coalesced = false);
 	void updateBufferedAmount(uint16_t streamId, ptrdiff_t delta);
-	void triggerBufferedAmount(uint16_t streamId, size_t amount);
-	void sendReset(uint16_t streamId);
+	void sendResets();
 
 	void handleUpcall() noexcept;
 	int handleWrite(byte *data, size_t len, uint8_t tos, uint8_t set_df) noexcept;
 
 	void processData(binary &&data, uint16_t streamId, PayloadId ppid);
+	bool tryProcessSmallData(const byte *data, size_t size, uint16_t streamId, PayloadId ppid);
+	struct PartialMessage {
+		std::vector<binary> chunks;
+		size_t size = 0;
+	};
+
+	binary assemblePartialMessage(PartialMessage &partial);
+	void appendPartial(binary &partial, const binary &data);
 	void processNotification(const union sctp_notification *notify, size_t len);
 
 	const size_t mMaxMessageSize;
+	const bool mLowMemory;
 	const Ports mPorts;
 	struct socket *mSock;
 	std::optional<uint16_t> mNegotiatedStreamsCount;
@@ -105,29 +161,139 @@ private:
 	std::atomic<int> mPendingRecvCount = 0;
 	std::atomic<int> mPendingFlushCount = 0;
 	std::mutex mRecvMutex;
-	std::recursive_mutex mSendMutex; // buffered amount callback is synchronous
-	Queue<message_ptr> mSendQueue;
+	std::recursive_mutex mSendMutex; // buffered amount low callback is synchronous
+	// Receive buffer usage, published by doRecv() since mRecvMutex is held during callbacks
+	std::atomic<size_t> mRecvMemoryUsage = 0;
+	// Queued messages are sent with weighted fair queueing between streams, see StreamScheduler
+	struct PendingMessage {
+		message_ptr message;
+		unique_ptr<LentData> lent; // data of the message if set
+		bool coalesced = false;    // the message holds coalesced messages
+		std::chrono::steady_clock::time_point enqueued = {}; // set only with latency histograms
+		optional<std::chrono::steady_clock::time_point> expiry = nullopt; // with a max lifetime
+
+		const byte *data() const { return lent ? lent->data : message->data(); }
+		size_t size() const { return lent ? lent->size : message->size(); }
+		size_t amount() const { // like message_size_func()
+			return message->type == Message::Binary || message->type == Message::String ? size()
+			                                                                            : 0;
+		}
+	};
+	bool enqueueSend(PendingMessage pending); // requires mSendMutex to be locked, false if closed
+	void applyStreamPriority(uint16_t stream, uint16_t priority);
+
+	// Small messages of streams with a coalescing window are appended to a pending coalesced
+	// message, which is sent when it is large enough or when the window expires
+	struct CoalescingBuffer {
+		PendingMessage pending;
+		Timer timer;
+	};
+	bool coalesce(const message_ptr &message); // requires mSendMutex to be locked
+	void enqueueCoalesced(uint16_t stream);    // requires mSendMutex to be locked
+	void flushCoalesced(uint16_t stream);
+
+	std::map<uint16_t, std::chrono::milliseconds> mStreamCoalescingWindows;
+	std::map<uint16_t, CoalescingBuffer> mCoalescingBuffers;
+
+	StreamScheduler<PendingMessage> mSendQueues; // also holds the stream priorities
+	bool mPriorityScheduler = false;             // SCTP_SS_PRIORITY is enabled
+	std::atomic<bool> mSendClosed = false;
 	bool mSendShutdown = false;
-	std::map<uint16_t, size_t> mBufferedAmount;
-	amount_callback mBufferedAmountCallback;
+	// Buffered amounts are counted by the channels themselves so that reading them is lock-free
+	std::map<uint16_t, weak_ptr<Channel>> mStreamChannels;
+	// Streams to reset, sent together in a single request once the queue is processed
+	std::vector<uint16_t> mPendingResets;
+	std::atomic<bool> mResetsDeferred = false; // a request is outstanding, retry on reset event
 
+	static thread_local SctpTransport *CurrentWriteScope;
+	void flushWriteBatch();
+
+	void sendPaced(message_vector messages); // requires mWriteMutex to be locked
+
+	message_vector mWriteBatch; // protected by mWriteMutex
+	// After a batch failed to be sent, packets are sent directly so that failures are reported to
+	// usrsctp, until a send succeeds. Protected by mWriteMutex.
+	bool mWriteBatchFailed = false;
+	shared_ptr<MediaHandler> mPacer; // protected by mWriteMutex
+	message_callback mPacedSendCallback;
 	std::mutex mWriteMutex;
 	std::condition_variable mWrittenCondition;
 	std::atomic<bool> mWritten = false;     // written outside lock
 	std::atomic<bool> mWrittenOnce = false; // same
+	std::atomic<bool> mPeerAcceptsZeroChecksum = false; // as announced in INIT or INIT ACK
+
+	// Received chunks are pooled buffers, a fragmented message is kept as a list of chunks and
+	// assembled once complete. With interleaving, fragments of different streams may alternate.
+	static constexpr size_t RecvChunkSize = 65536;
+	static constexpr size_t RecvCopyThreshold = 4096; // smaller messages are copied to fit
+	static constexpr size_t RecvKeepThreshold = RecvChunkSize / 2; // smaller data doesn't pin
+	binary mRecvChunk;
+	std::map<uint16_t, PartialMessage> mPartialMessages; // by stream ID
 
-	binary mPartialMessage, mPartialNotification;
+	binary mPartialNotification;
 	binary mPartialStringData, mPartialBinaryData;
 
 	// Stats
 	std::atomic<size_t> mBytesSent = 0, mBytesReceived = 0;
+	std::atomic<uint64_t> mMessagesSent = 0, mMessagesReceived = 0;
+	std::atomic<uint64_t> mMessagesExpired = 0;
+
+	std::atomic<int> mRecvPauseCount = 0; // may be transiently negative
+
+	// When auto-tuning, buffers grow to twice the bandwidth-delay product observed each interval,
+	// and shrink back to their initial size after an idle period. In low-memory mode, buffers start
+	// small and the interval backs off while idle.
+	static constexpr size_t DefaultMaxAutoTuneBufferSize = 16 * 1024 * 1024;
+	static constexpr auto AutoTuneInterval = std::chrono::seconds(1);
+	static constexpr auto MaxAutoTuneInterval = std::chrono::seconds(32);
+	static constexpr int IdleShrinkIntervals = 10;
+	static std::atomic<bool> AutoTuneBuffers;
+	static std::atomic<size_t> MaxAutoTuneBufferSize;
+
+	void scheduleAutoTune();
+	void autoTune();
+	void growBuffer(int option, size_t &current, size_t target);
+	void shrinkBuffer(int option, size_t &current, size_t initial);
+	bool setBufferSize(int option, size_t size);
+
+	bool mAutoTune = false;
+	size_t mSendBufferSize = 0, mRecvBufferSize = 0; // auto-tuned on the processor
+	size_t mInitialSendBufferSize = 0, mInitialRecvBufferSize = 0;
+	size_t mAutoTuneBytesSent = 0, mAutoTuneBytesReceived = 0;
+	int mIdleIntervals = 0;
+	std::chrono::steady_clock::duration mAutoTuneInterval = AutoTuneInterval;
+	std::chrono::steady_clock::time_point mAutoTuneTime;
+	Timer mAutoTuneTimer;
+	std::mutex mAutoTuneTimerMutex;
 
 	static void UpcallCallback(struct socket *sock, void *arg, int flags);
 	static int WriteCallback(void *sctp_ptr, void *data, size_t len, uint8_t tos, uint8_t set_df);
 	static void DebugCallback(const char *format, ...);
 
-	class InstancesSet;
-	static InstancesSet* Instances;
+	// Per-instance token passed to usrsctp as the address and the upcall argument, so callbacks
+	// check the instance without global synchronization. As usrsctp may call back after the socket
+	// is closed (sctplab/usrsctp#405), tokens are recycled instead of freed before Cleanup().
+	struct Token;
+	struct TokenReleaser {
+		void operator()(Token *token) const;
+	};
+	static std::unique_ptr<Token, TokenReleaser> AcquireToken();
+	static std::atomic<size_t> InstancesCount;
+	static std::mutex TokensMutex;                     // only locked on creation and destruction
+	static std::vector<std::unique_ptr<Token>> Tokens; // protected by TokensMutex, freed on cleanup
+	static std::vector<Token *> FreeTokens;            // protected by TokensMutex
+
+	std::unique_ptr<Token, TokenReleaser> mToken; // the instance is set once constructed
+
+	// Without the usrsctp timer thread, timers are ticked on the thread pool while instances exist
+	static void StartTimers();
+	static void ScheduleTimers(); // requires TimersMutex to be locked
+	static void HandleTimers();
+	static bool Threadless;                                  // set on init
+	static std::chrono::steady_clock::duration TimersTick;   // set on init
+	static std::mutex TimersMutex;
+	static bool TimersScheduled;                             // protected by TimersMutex
+	static std::chrono::steady_clock::time_point TimersTime; // protected by TimersMutex
 };
 
 } // namespace rtc::impl
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "sendqueue.hpp"
+#include "internals.hpp"
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+SendQueue::SendQueue(size_t maxAmount, send_callback send, retry_callback retry,
+                     amount_callback amount)
+    : mMaxAmount(maxAmount), mSend(std::move(send)), mRetry(std::move(retry)),
+      mAmountCallback(std::move(amount)) {}
+
+bool SendQueue::send(message_ptr message) {
+	bool result;
+	{
+		std::lock_guard lock(mMutex);
+		if (mQueue.empty()) {
+			switch (mSend(message)) {
+			case Result::Sent:
+				return true;
+			case Result::Failed:
+				return false;
+			case Result::WouldBlock:
+				break;
+			}
+		}
+
+		result = enqueue({std::move(message)});
+	}
+
+	triggerAmount();
+	return result;
+}
+
+bool SendQueue::sendBatch(message_vector messages, const batch_callback &batch) {
+	bool result = true;
+	{
+		std::lock_guard lock(mMutex);
+		if (mQueue.empty()) {
+			message_vector blocked;
+			result = batch(messages, blocked);
+			if (blocked.empty())
+				return result;
+
+			messages = std::move(blocked);
+		}
+
+		// Keep packets behind the queued ones
+		result = enqueue(std::move(messages)) && result;
+	}
+
+	triggerAmount();
+	return result;
+}
+
+void SendQueue::flush(bool drop) {
+	{
+		std::lock_guard lock(mMutex);
+		bool progress = false;
+		size_t amount = mAmount;
+		while (!mQueue.empty()) {
+			const auto &message = mQueue.front();
+			if (!drop && mSend(message) == Result::WouldBlock)
+				break;
+
+			amount -= std::min(message->size(), amount);
+			mQueue.pop_front();
+			progress = true;
+		}
+
+		mAmount = amount;
+		if (mQueue.empty()) {
+			PLOG_DEBUG << "Send queue is flushed";
+		} else {
+			mRetryDelay = progress ? RetryMinDelay : std::min(mRetryDelay * 2, RetryMaxDelay);
+			mRetry(mRetryDelay);
+		}
+
+		if (!progress)
+			return;
+	}
+
+	triggerAmount();
+}
+
+size_t SendQueue::amount() const { return mAmount; }
+
+bool SendQueue::enqueue(message_vector messages) {
+	// Requires mMutex to be locked
+	const bool wasEmpty = mQueue.empty();
+	bool result = true;
+	size_t amount = mAmount;
+	for (auto &message : messages) {
+		if (!message)
+			continue;
+
+		if (amount + message->size() > mMaxAmount) {
+			PLOG_VERBOSE << "Send queue is full, dropping packet";
+			result = false;
+			continue;
+		}
+
+		amount += message->size();
+		mQueue.push_back(std::move(message));
+	}
+
+	mAmount = amount;
+	if (wasEmpty && !mQueue.empty()) {
+		PLOG_DEBUG << "Socket buffer is full, queueing packets";
+		mRetryDelay = RetryMinDelay;
+		mRetry(mRetryDelay);
+	}
+	return result;
+}
+
+void SendQueue::triggerAmount() {
+	try {
+		if (mAmountCallback)
+			mAmountCallback(mAmount);
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "Send queue amount callback: " << e.what();
+	}
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_SEND_QUEUE_H
+#define RTC_IMPL_SEND_QUEUE_H
+
+#include "common.hpp"
+#include "message.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace rtc::impl {
+
+// Packets waiting for a full socket buffer, sent again in order. Packets are sent directly only
+// while nothing is queued, and the decision is taken under the lock so that they can't overtake
+// packets another thread is queueing. As the socket does not signal when it is writable again,
+// flush() must be called after the delay passed to the retry callback, which backs off as long as
+// nothing can be sent.
+class SendQueue final {
+public:
+	enum class Result { Sent, WouldBlock, Failed };
+
+	using send_callback = std::function<Result(const message_ptr &message)>;
+	// Sends messages in order and returns false on failure, packets from the first one which would
+	// block are moved to blocked
+	using batch_callback = std::function<bool(message_vector &messages, message_vector &blocked)>;
+	using retry_callback = std::function<void(std::chrono::milliseconds delay)>;
+	using amount_callback = std::function<void(size_t amount)>;
+
+	static constexpr auto RetryMinDelay = std::chrono::milliseconds(1);
+	static constexpr auto RetryMaxDelay = std::chrono::milliseconds(16);
+
+	// Callbacks are called under the lock, except the amount callback
+	SendQueue(size_t maxAmount, send_callback send, retry_callback retry, amount_callback amount);
+	~SendQueue() = default;
+
+	bool send(message_ptr message); // false if failed or dropped
+	bool sendBatch(message_vector messages, const batch_callback &batch); // same, for any message
+	void flush(bool drop = false); // retries the queued packets, or drops them
+	size_t amount() const;         // total size of queued packets
+
+private:
+	bool enqueue(message_vector messages); // requires mMutex to be locked
+	void triggerAmount();
+
+	const size_t mMaxAmount;
+	const send_callback mSend;
+	const retry_callback mRetry;
+	const amount_callback mAmountCallback;
+
+	std::deque<message_ptr> mQueue;                        // protected by mMutex
+	std::chrono::milliseconds mRetryDelay = RetryMinDelay; // protected by mMutex
+	std::atomic<size_t> mAmount = 0;
+	std::mutex mMutex;
+};
+
+} // namespace rtc::impl
+
+#endif
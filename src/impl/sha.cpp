@@ -10,9 +10,11 @@
 
 #if RTC_ENABLE_WEBSOCKET
 
+#include <stdexcept>
+
 #if USE_GNUTLS
 
-#include <nettle/sha1.h>
+#include <gnutls/crypto.h>
 
 #elif USE_MBEDTLS
 
@@ -35,11 +37,11 @@ namespace {
 binary Sha1(const byte *data, size_t size) {
 #if USE_GNUTLS
 
-	binary output(SHA1_DIGEST_SIZE);
-	struct sha1_ctx ctx;
-	sha1_init(&ctx);
-	sha1_update(&ctx, size, reinterpret_cast<const uint8_t *>(data));
-	sha1_digest(&ctx, SHA1_DIGEST_SIZE, reinterpret_cast<uint8_t *>(output.data()));
+	// GnuTLS registers its accelerated implementations, unlike Nettle without fat binary support
+	binary output(gnutls_hash_get_len(GNUTLS_DIG_SHA1));
+	if (gnutls_hash_fast(GNUTLS_DIG_SHA1, data, size, output.data()) != GNUTLS_E_SUCCESS)
+		throw std::runtime_error("SHA-1 computation failed");
+
 	return output;
 
 #elif USE_MBEDTLS
@@ -51,6 +53,8 @@ binary Sha1(const byte *data, size_t size) {
 
 #else
 
+	// The low-level API dispatches to the accelerated implementation for the CPU, and it is faster
+	// than EVP_Digest() for small inputs as it does not fetch the algorithm
 	binary output(SHA_DIGEST_LENGTH);
 	SHA_CTX ctx;
 	SHA1_Init(&ctx);
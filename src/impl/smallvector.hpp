@@ -0,0 +1,57 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_SMALL_VECTOR_H
+#define RTC_IMPL_SMALL_VECTOR_H
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace rtc::impl {
+
+// Vector storing its first N elements inline, so that it does not allocate while small
+// T must be default-constructible, as inline elements are constructed upfront
+template <typename T, size_t N> class SmallVector {
+public:
+	size_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+
+	T &operator[](size_t i) { return i < N ? mInline[i] : mHeap[i - N]; }
+	const T &operator[](size_t i) const { return i < N ? mInline[i] : mHeap[i - N]; }
+
+	T &back() { return (*this)[mSize - 1]; }
+
+	void push_back(T value) {
+		if (mSize < N)
+			mInline[mSize] = std::move(value);
+		else
+			mHeap.push_back(std::move(value));
+
+		++mSize;
+	}
+
+	void clear() {
+		for (size_t i = 0; i < std::min(mSize, N); ++i)
+			mInline[i] = T{};
+
+		mHeap.clear();
+		mSize = 0;
+	}
+
+private:
+	std::array<T, N> mInline = {};
+	std::vector<T> mHeap;
+	size_t mSize = 0;
+};
+
+} // namespace rtc::impl
+
+#endif
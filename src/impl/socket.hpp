@@ -36,6 +36,7 @@
 
 #define NO_IFADDRS
 #define NO_PMTUDISC
+#define NO_KTLS
 
 typedef SOCKET socket_t;
 typedef SOCKADDR sockaddr;
@@ -81,6 +82,12 @@ typedef ULONG nfds_t;
 #define NO_PMTUDISC
 #endif
 
+#if defined(__linux__) && __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#else
+#define NO_KTLS
+#endif
+
 #ifdef __ANDROID__
 #define NO_IFADDRS
 #else
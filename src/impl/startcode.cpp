@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "startcode.hpp"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RTC_START_CODE_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RTC_START_CODE_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define RTC_START_CODE_NEON 1
+#endif
+
+#if defined(_MSC_VER) && (RTC_START_CODE_AVX2 || RTC_START_CODE_SSE2)
+#include <intrin.h>
+#endif
+
+namespace rtc::impl {
+
+namespace {
+
+#if RTC_START_CODE_AVX2 || RTC_START_CODE_SSE2
+inline unsigned int count_trailing_zeros(uint32_t x) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return unsigned(index);
+#else
+	return unsigned(__builtin_ctz(x));
+#endif
+}
+#endif
+
+} // namespace
+
+// Vectors compare 3 shifted loads at once to find 00 00 01, a block with no match is skipped
+// without branching per byte. AVX2 is only used if enabled at compile time, SSE2 and NEON are part
+// of the baseline on x86_64 and ARM64. The remaining bytes are searched with memchr for 0x01.
+const byte *find_start_code(const byte *begin, const byte *end) {
+	const byte *p = begin;
+
+#if RTC_START_CODE_AVX2
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i one = _mm256_set1_epi8(1);
+		for (; end - p >= 34; p += 32) {
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1));
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 2));
+			__m256i m = _mm256_and_si256(
+			    _mm256_and_si256(_mm256_cmpeq_epi8(a, zero), _mm256_cmpeq_epi8(b, zero)),
+			    _mm256_cmpeq_epi8(c, one));
+			if (uint32_t mask = uint32_t(_mm256_movemask_epi8(m)))
+				return p + count_trailing_zeros(mask);
+		}
+	}
+#endif
+
+#if RTC_START_CODE_SSE2
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi8(1);
+		for (; end - p >= 18; p += 16) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2));
+			__m128i m = _mm_and_si128(
+			    _mm_and_si128(_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)),
+			    _mm_cmpeq_epi8(c, one));
+			if (uint32_t mask = uint32_t(_mm_movemask_epi8(m)))
+				return p + count_trailing_zeros(mask);
+		}
+	}
+#elif RTC_START_CODE_NEON
+	{
+		const uint8x16_t zero = vdupq_n_u8(0);
+		const uint8x16_t one = vdupq_n_u8(1);
+		for (; end - p >= 18; p += 16) {
+			uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+			uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(p + 1));
+			uint8x16_t c = vld1q_u8(reinterpret_cast<const uint8_t *>(p + 2));
+			uint8x16_t m =
+			    vandq_u8(vandq_u8(vceqq_u8(a, zero), vceqq_u8(b, zero)), vceqq_u8(c, one));
+			uint64x2_t m64 = vreinterpretq_u64_u8(m);
+			if (vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1))
+				break; // the match is found below
+		}
+	}
+#endif
+
+	while (end - p >= 3) {
+		auto q = static_cast<const byte *>(std::memchr(p + 2, 1, size_t(end - p - 2)));
+		if (!q)
+			break;
+
+		if (q[-1] == byte(0) && q[-2] == byte(0))
+			return q - 2;
+
+		p = q - 1;
+	}
+
+	return end;
+}
+
+} // namespace rtc::impl
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_START_CODE_H
+#define RTC_IMPL_START_CODE_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "common.hpp"
+#include "nalunit.hpp"
+
+namespace rtc::impl {
+
+// Returns the first 00 00 01 sequence in [begin, end), or end if there is none
+const byte *find_start_code(const byte *begin, const byte *end);
+
+// Calls callback(offset, size) for each NAL unit of a frame with start sequences (Annex B)
+// Data before the first start sequence is ignored. A frame without any start sequence results in
+// a single empty NAL unit.
+template <typename F>
+void split_start_sequences(const binary &frame, NalUnit::Separator separator, F &&callback) {
+	using Separator = NalUnit::Separator;
+	const byte *data = frame.data();
+	const byte *end = data + frame.size();
+
+	// Returns the next start sequence accepted by the separator and sets its length
+	auto next = [&](const byte *from, size_t &length) -> const byte * {
+		const byte *p = from;
+		while ((p = find_start_code(p, end)) != end) {
+			if (separator != Separator::ShortStartSequence && p > from && p[-1] == byte(0)) {
+				length = 4;
+				return p - 1;
+			}
+			if (separator != Separator::LongStartSequence) {
+				length = 3;
+				return p;
+			}
+			p += 3;
+		}
+		return end;
+	};
+
+	size_t length = 0;
+	const byte *p = next(data, length);
+	size_t start = p != end ? size_t(p - data) + length : frame.size();
+	while ((p = next(data + start, length)) != end) {
+		callback(start, size_t(p - data) - start);
+		start = size_t(p - data) + length;
+	}
+	callback(start, frame.size() - start);
+}
+
+} // namespace rtc::impl
+
+#endif /* RTC_ENABLE_MEDIA */
+
+#endif
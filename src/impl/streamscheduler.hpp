@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_STREAM_SCHEDULER_H
+#define RTC_IMPL_STREAM_SCHEDULER_H
+
+#include "common.hpp"
+#include "internals.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <map>
+
+namespace rtc::impl {
+
+// Per-stream queues served with weighted fair queueing, weights being the stream priorities. Each
+// stream advances a virtual time in inverse proportion to its weight as its elements are served,
+// and the stream with the lowest virtual time is served first. A stream becoming active starts at
+// the current virtual time, so it can't claim the time it was idle. It is not thread-safe.
+template <typename T> class StreamScheduler final {
+public:
+	bool empty() const;
+	void push(uint16_t stream, T element);
+	uint16_t next() const;               // stream to serve, the scheduler must not be empty
+	T &front(uint16_t stream);           // the stream must not be empty
+	T pop(uint16_t stream, size_t size); // the element was served, size is its size in bytes
+	T drop(uint16_t stream);             // the element was not served, time does not advance
+
+	void setPriority(uint16_t stream, uint16_t priority);
+	void erasePriority(uint16_t stream);
+	uint16_t priority(uint16_t stream) const;
+	const std::map<uint16_t, uint16_t> &priorities() const;
+
+	template <typename F> void forEach(F &&f) const; // calls f(stream, element) for each element
+
+private:
+	struct Queue {
+		std::deque<T> elements;
+		uint64_t virtualTime = 0;
+	};
+
+	T take(typename std::map<uint16_t, Queue>::iterator it);
+
+	std::map<uint16_t, Queue> mQueues; // by stream ID, only non-empty ones
+	std::map<uint16_t, uint16_t> mPriorities;
+	uint64_t mVirtualTime = 0;
+};
+
+template <typename T> bool StreamScheduler<T>::empty() const { return mQueues.empty(); }
+
+template <typename T> void StreamScheduler<T>::push(uint16_t stream, T element) {
+	auto [it, inserted] = mQueues.try_emplace(stream);
+	if (inserted)
+		it->second.virtualTime = mVirtualTime; // the stream becomes active now
+
+	it->second.elements.push_back(std::move(element));
+}
+
+template <typename T> uint16_t StreamScheduler<T>::next() const {
+	assert(!mQueues.empty());
+	auto it = std::min_element(mQueues.begin(), mQueues.end(), [](const auto &a, const auto &b) {
+		return a.second.virtualTime < b.second.virtualTime;
+	});
+	return it->first;
+}
+
+template <typename T> T &StreamScheduler<T>::front(uint16_t stream) {
+	auto it = mQueues.find(stream);
+	assert(it != mQueues.end());
+	return it->second.elements.front();
+}
+
+template <typename T> T StreamScheduler<T>::pop(uint16_t stream, size_t size) {
+	auto it = mQueues.find(stream);
+	assert(it != mQueues.end());
+	const uint64_t weight = std::max(priority(stream), uint16_t(1));
+	mVirtualTime = it->second.virtualTime;
+	it->second.virtualTime += (uint64_t(size) + 1) * 1024 / weight;
+	return take(it);
+}
+
+template <typename T> T StreamScheduler<T>::drop(uint16_t stream) {
+	auto it = mQueues.find(stream);
+	assert(it != mQueues.end());
+	return take(it);
+}
+
+template <typename T>
+T StreamScheduler<T>::take(typename std::map<uint16_t, Queue>::iterator it) {
+	auto &elements = it->second.elements;
+	T element = std::move(elements.front());
+	elements.pop_front();
+	if (elements.empty())
+		mQueues.erase(it);
+
+	return element;
+}
+
+template <typename T> void StreamScheduler<T>::setPriority(uint16_t stream, uint16_t priority) {
+	mPriorities[stream] = priority;
+}
+
+template <typename T> void StreamScheduler<T>::erasePriority(uint16_t stream) {
+	mPriorities.erase(stream);
+}
+
+template <typename T> uint16_t StreamScheduler<T>::priority(uint16_t stream) const {
+	auto it = mPriorities.find(stream);
+	return it != mPriorities.end() ? it->second : DEFAULT_DATA_CHANNEL_PRIORITY;
+}
+
+template <typename T>
+const std::map<uint16_t, uint16_t> &StreamScheduler<T>::priorities() const {
+	return mPriorities;
+}
+
+template <typename T> template <typename F> void StreamScheduler<T>::forEach(F &&f) const {
+	for (const auto &[stream, queue] : mQueues)
+		for (const auto &element : queue.elements)
+			f(stream, element);
+}
+
+} // namespace rtc::impl
+
+#endif
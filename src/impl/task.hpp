@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_TASK_H
+#define RTC_IMPL_TASK_H
+
+#include "common.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rtc::impl {
+
+// Move-only type-erased void() callable with small buffer optimization: callables up to
+// InlineSize bytes are stored inline, so that dispatching them doesn't hit the heap.
+class Task final {
+public:
+	static constexpr size_t InlineSize = 6 * sizeof(void *);
+
+	Task() noexcept = default;
+	Task(std::nullptr_t) noexcept {}
+
+	template <class F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task> &&
+	                                               !std::is_same_v<std::decay_t<F>, std::nullptr_t>>>
+	Task(F &&f) {
+		using T = std::decay_t<F>;
+		if constexpr (IsInline<T>) {
+			new (&mStorage) T(std::forward<F>(f));
+			mOps = &InlineOps<T>;
+		} else {
+			*reinterpret_cast<T **>(&mStorage) = new T(std::forward<F>(f));
+			mOps = &HeapOps<T>;
+		}
+	}
+
+	Task(Task &&other) noexcept { moveFrom(other); }
+
+	Task &operator=(Task &&other) noexcept {
+		if (&other != this) {
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	Task(const Task &) = delete;
+	Task &operator=(const Task &) = delete;
+
+	~Task() { reset(); }
+
+	void operator()() { mOps->invoke(&mStorage); }
+	explicit operator bool() const noexcept { return mOps != nullptr; }
+
+	void reset() noexcept {
+		if (mOps) {
+			mOps->destroy(&mStorage);
+			mOps = nullptr;
+		}
+	}
+
+private:
+	struct Ops {
+		void (*invoke)(void *storage);
+		void (*move)(void *dst, void *src) noexcept; // destroys src
+		void (*destroy)(void *storage) noexcept;
+	};
+
+	template <class T>
+	static constexpr bool IsInline = sizeof(T) <= InlineSize &&
+	                                 alignof(T) <= alignof(std::max_align_t) &&
+	                                 std::is_nothrow_move_constructible_v<T>;
+
+	template <class T>
+	static constexpr Ops InlineOps = {
+	    [](void *storage) { (*static_cast<T *>(storage))(); },
+	    [](void *dst, void *src) noexcept {
+		    new (dst) T(std::move(*static_cast<T *>(src)));
+		    static_cast<T *>(src)->~T();
+	    },
+	    [](void *storage) noexcept { static_cast<T *>(storage)->~T(); }};
+
+	template <class T>
+	static constexpr Ops HeapOps = {
+	    [](void *storage) { (**static_cast<T **>(storage))(); },
+	    [](void *dst, void *src) noexcept { *static_cast<T **>(dst) = *static_cast<T **>(src); },
+	    [](void *storage) noexcept { delete *static_cast<T **>(storage); }};
+
+	void moveFrom(Task &other) noexcept {
+		if (other.mOps) {
+			other.mOps->move(&mStorage, &other.mStorage);
+			mOps = std::exchange(other.mOps, nullptr);
+		}
+	}
+
+	alignas(std::max_align_t) std::byte mStorage[InlineSize];
+	const Ops *mOps = nullptr;
+};
+
+} // namespace rtc::impl
+
+#endif
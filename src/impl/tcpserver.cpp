@@ -19,11 +19,26 @@
 #include <unistd.h>
 #endif
 
+// Only use options which make the kernel balance incoming connections across listeners
+#if defined(SO_REUSEPORT_LB)
+#define RTC_SO_REUSEPORT SO_REUSEPORT_LB // FreeBSD
+#elif defined(__linux__) && defined(SO_REUSEPORT)
+#define RTC_SO_REUSEPORT SO_REUSEPORT
+#endif
+
 namespace rtc::impl {
 
-TcpServer::TcpServer(uint16_t port, const char *bindAddress) {
+bool TcpServer::IsReusePortSupported() {
+#ifdef RTC_SO_REUSEPORT
+	return true;
+#else
+	return false;
+#endif
+}
+
+TcpServer::TcpServer(uint16_t port, const char *bindAddress, bool reusePort) {
 	PLOG_DEBUG << "Initializing TCP server";
-	listen(port, bindAddress);
+	listen(port, bindAddress, reusePort);
 }
 
 TcpServer::~TcpServer() { close(); }
@@ -93,7 +108,7 @@ void TcpServer::close() {
 	}
 }
 
-void TcpServer::listen(uint16_t port, const char *bindAddress) {
+void TcpServer::listen(uint16_t port, const char *bindAddress, bool reusePort) {
 	PLOG_DEBUG << "Listening on port " << port;
 
 	struct addrinfo hints = {};
@@ -134,6 +149,17 @@ void TcpServer::listen(uint16_t port, const char *bindAddress) {
 		::setsockopt(mSock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&enabled),
 		             sizeof(enabled));
 
+		// Enable REUSEPORT so that several listeners can share the port
+		if (reusePort) {
+#ifdef RTC_SO_REUSEPORT
+			if (::setsockopt(mSock, SOL_SOCKET, RTC_SO_REUSEPORT,
+			                 reinterpret_cast<const char *>(&enabled), sizeof(enabled)) < 0)
+				throw std::runtime_error("Failed to enable port reuse on TCP server socket");
+#else
+			throw std::logic_error("Port reuse is not supported on this platform");
+#endif
+		}
+
 		// Listen on both IPv6 and IPv4
 		if (ai->ai_family == AF_INET6)
 			::setsockopt(mSock, IPPROTO_IPV6, IPV6_V6ONLY,
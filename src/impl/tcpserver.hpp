@@ -21,7 +21,9 @@ namespace rtc::impl {
 
 class TcpServer final {
 public:
-	TcpServer(uint16_t port, const char *bindAddress = nullptr);
+	static bool IsReusePortSupported(); // true if listeners can share a port with reusePort
+
+	TcpServer(uint16_t port, const char *bindAddress = nullptr, bool reusePort = false);
 	~TcpServer();
 
 	TcpServer(const TcpServer &other) = delete;
@@ -33,7 +35,7 @@ public:
 	uint16_t port() const { return mPort; }
 
 private:
-	void listen(uint16_t port, const char *bindAddress);
+	void listen(uint16_t port, const char *bindAddress, bool reusePort);
 
 	uint16_t mPort;
 	socket_t mSock = INVALID_SOCKET;
@@ -7,6 +7,7 @@
  */
 
 #include "tcptransport.hpp"
+#include "dnscache.hpp"
 #include "internals.hpp"
 #include "threadpool.hpp"
 
@@ -14,10 +15,13 @@
 
 #ifndef _WIN32
 #include <fcntl.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 
 namespace rtc::impl {
 
@@ -28,6 +32,61 @@ using std::chrono::milliseconds;
 
 namespace {
 
+// Queued messages are coalesced in vectored writes
+#if defined(IOV_MAX) && IOV_MAX < 64
+const size_t SEND_VECTOR_MAX_COUNT = IOV_MAX;
+#else
+const size_t SEND_VECTOR_MAX_COUNT = 64;
+#endif
+const size_t SEND_VECTOR_MAX_SIZE = 256 * 1024; // bytes
+
+// RFC 8305 recommended values
+const auto RESOLUTION_DELAY = 50ms;          // wait for AAAA records once A records are received
+const auto CONNECTION_ATTEMPT_DELAY = 250ms; // before starting the next attempt in parallel
+const auto CONNECTION_TIMEOUT = 10s;         // for each attempt
+
+using address_list = std::vector<std::tuple<struct sockaddr_storage, socklen_t>>;
+
+void append_addrinfo(const char *node, const char *service, int family, int flags,
+                     address_list &out) {
+	struct addrinfo hints = {};
+	hints.ai_family = family;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = flags;
+
+	struct addrinfo *result = nullptr;
+	if (getaddrinfo(node, service, &hints, &result))
+		return;
+
+	for (auto ai = result; ai; ai = ai->ai_next) {
+		if (ai->ai_family != family || ai->ai_addrlen > sizeof(struct sockaddr_storage))
+			continue;
+
+		struct sockaddr_storage addr;
+		std::memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
+		out.emplace_back(addr, socklen_t(ai->ai_addrlen));
+	}
+
+	freeaddrinfo(result);
+}
+
+// Blocks while resolving, hostnames with a numeric service go through the DNS cache
+address_list lookup(const string &hostname, const string &service, int family) {
+	address_list out;
+	char *end = nullptr;
+	const unsigned long port = std::strtoul(service.c_str(), &end, 10);
+	if (!service.empty() && *end == '\0' && port <= 65535) {
+		auto addresses = DnsCache::Instance().resolve(hostname, uint16_t(port), family, SOCK_STREAM);
+		for (const auto &address : addresses)
+			append_addrinfo(address.node.c_str(), service.c_str(), address.family,
+			                AI_NUMERICHOST | AI_NUMERICSERV, out);
+	} else {
+		append_addrinfo(hostname.c_str(), service.c_str(), family, AI_ADDRCONFIG, out);
+	}
+	return out;
+}
+
 bool unmap_inet6_v4mapped(struct sockaddr *sa, socklen_t *len) {
 	if (sa->sa_family != AF_INET6)
 		return false;
@@ -63,7 +122,7 @@ TcpTransport::TcpTransport(socket_t sock, state_callback callback)
 	PLOG_DEBUG << "Initializing TCP transport with socket";
 
 	// Configure socket
-	configureSocket();
+	configureSocket(mSock);
 
 	// Retrieve hostname and service
 	struct sockaddr_storage addr;
@@ -126,12 +185,12 @@ void TcpTransport::incoming(message_ptr message) {
 
 bool TcpTransport::outgoing(message_ptr message) {
 	// mSendMutex must be locked
-	// Flush the queue, and if nothing is pending, try to send directly
-	if (trySendQueue() && trySendMessage(message))
+	// Queue the message and flush the queue, it is sent directly if nothing is pending
+	const size_t size = message->size();
+	mSendQueue.push_back(std::move(message));
+	if (trySendQueue(size))
 		return true;
 
-	mSendQueue.push(message);
-	updateBufferedAmount(ptrdiff_t(message->size()));
 	setPoll(PollService::Direction::Both);
 	return false;
 }
@@ -140,6 +199,52 @@ bool TcpTransport::isActive() const { return mIsActive; }
 
 string TcpTransport::remoteAddress() const { return mHostname + ':' + mService; }
 
+string TcpTransport::service() const { return mService; }
+
+#ifndef NO_KTLS
+bool TcpTransport::enableKernelTlsTx(const void *cryptoInfo, size_t size) {
+	std::lock_guard lock(mSendMutex);
+	if (mSock == INVALID_SOCKET)
+		throw std::runtime_error("TCP socket is closed");
+
+	// Queued data is already encrypted, it must not go through the kernel TLS layer
+	if (!mSendQueue.empty())
+		return false;
+
+	if (::setsockopt(mSock, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0)
+		throw std::runtime_error("Failed to attach kernel TLS to socket, errno=" +
+		                         std::to_string(sockerrno));
+
+	if (::setsockopt(mSock, SOL_TLS, TLS_TX, cryptoInfo, socklen_t(size)) < 0)
+		throw std::runtime_error("Failed to set kernel TLS transmission keys, errno=" +
+		                         std::to_string(sockerrno));
+
+	PLOG_DEBUG << "Kernel TLS transmission enabled";
+	mKernelTlsTx = true;
+	return true;
+}
+
+bool TcpTransport::sendKernelTlsAlert(uint8_t level, uint8_t description) {
+	std::lock_guard lock(mSendMutex);
+	if (!mKernelTlsTx)
+		throw std::logic_error("Kernel TLS transmission is not enabled");
+
+	if (state() != State::Connected)
+		return false;
+
+	binary alert{byte(level), byte(description)};
+	return outgoing(make_message(std::move(alert), Message::Control));
+}
+#else
+bool TcpTransport::enableKernelTlsTx(const void *, size_t) {
+	throw std::logic_error("Kernel TLS is not supported on this platform");
+}
+
+bool TcpTransport::sendKernelTlsAlert(uint8_t, uint8_t) {
+	throw std::logic_error("Kernel TLS is not supported on this platform");
+}
+#endif
+
 void TcpTransport::connect() {
 	if (state() == State::Connecting)
 		throw std::logic_error("TCP connection is already in progress");
@@ -150,90 +255,92 @@ void TcpTransport::connect() {
 	PLOG_DEBUG << "Connecting to " << mHostname << ":" << mService;
 	changeState(State::Connecting);
 
-	ThreadPool::Instance().enqueue(weak_bind(&TcpTransport::resolve, this));
-}
+	{
+		std::lock_guard lock(mSendMutex);
+		mResolved6.clear();
+		mResolved4.clear();
+		mPendingResolutions = 2;
+		mNextIpv6 = true;
+	}
 
-void TcpTransport::resolve() {
-	std::lock_guard lock(mSendMutex);
-	mResolved.clear();
+	// Resolve both families in parallel so a slow AAAA query does not delay IPv4
+	ThreadPool::Instance().post(weak_bind(&TcpTransport::resolve, this, AF_INET6));
+	ThreadPool::Instance().post(weak_bind(&TcpTransport::resolve, this, AF_INET));
+}
 
+void TcpTransport::resolve(int family) {
 	if (state() != State::Connecting)
 		return; // Cancelled
 
-	try {
-		PLOG_DEBUG << "Resolving " << mHostname << ":" << mService;
-
-		struct addrinfo hints = {};
-		hints.ai_family = AF_UNSPEC;
-		hints.ai_socktype = SOCK_STREAM;
-		hints.ai_protocol = IPPROTO_TCP;
-		hints.ai_flags = AI_ADDRCONFIG;
-
-		struct addrinfo *result = nullptr;
-		if (getaddrinfo(mHostname.c_str(), mService.c_str(), &hints, &result))
-			throw std::runtime_error("Resolution failed for \"" + mHostname + ":" + mService +
-			                         "\"");
+	const bool ipv6 = family == AF_INET6;
+	PLOG_DEBUG << "Resolving " << mHostname << ":" << mService << (ipv6 ? " (IPv6)" : " (IPv4)");
+	auto addresses = lookup(mHostname, mService, family);
 
-		try {
-			struct addrinfo *ai = result;
-			while (ai) {
-				struct sockaddr_storage addr;
-				std::memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
-				mResolved.emplace_back(addr, socklen_t(ai->ai_addrlen));
-				ai = ai->ai_next;
-			}
+	std::lock_guard lock(mSendMutex);
+	if (state() != State::Connecting)
+		return; // Cancelled
 
-		} catch (...) {
-			freeaddrinfo(result);
-			throw;
-		}
+	auto &resolved = ipv6 ? mResolved6 : mResolved4;
+	resolved.insert(resolved.end(), addresses.begin(), addresses.end());
+	--mPendingResolutions;
 
-		freeaddrinfo(result);
+	if (mAttemptTimer)
+		return; // the scheduled attempt will use the new addresses
 
-	} catch (const std::exception &e) {
-		PLOG_WARNING << e.what();
-		changeState(State::Failed);
-		return;
-	}
+	// RFC 8305 3: When A records are received first, wait a short time for AAAA records
+	const bool waitIpv6 = !ipv6 && mPendingResolutions > 0 && mAttempts.empty();
+	scheduleAttempt(waitIpv6 ? RESOLUTION_DELAY : 0ms);
+}
 
-	ThreadPool::Instance().enqueue(weak_bind(&TcpTransport::attempt, this));
+void TcpTransport::scheduleAttempt(milliseconds delay) {
+	// Requires mSendMutex to be locked
+	mAttemptTimer.cancel();
+	mAttemptTimer = ThreadPool::Instance().setTimer(delay, weak_bind(&TcpTransport::attempt, this));
 }
 
 void TcpTransport::attempt() {
-	try {
-		std::lock_guard lock(mSendMutex);
+	std::lock_guard lock(mSendMutex);
+	mAttemptTimer.cancel();
+	mAttemptTimer = Timer();
 
-		if (state() != State::Connecting)
-			return; // Cancelled
+	if (state() != State::Connecting)
+		return; // Cancelled
 
-		if (mSock != INVALID_SOCKET) {
-			::closesocket(mSock);
-			mSock = INVALID_SOCKET;
-		}
+	// RFC 8305 4: Alternate between families, starting with IPv6
+	while (!mResolved6.empty() || !mResolved4.empty()) {
+		const bool ipv6 = mResolved4.empty() || (mNextIpv6 && !mResolved6.empty());
+		auto &resolved = ipv6 ? mResolved6 : mResolved4;
+		auto [addr, addrlen] = resolved.front();
+		resolved.pop_front();
+		mNextIpv6 = !ipv6;
 
-		if (mResolved.empty()) {
-			PLOG_WARNING << "Connection to " << mHostname << ":" << mService << " failed";
-			changeState(State::Failed);
-			return;
+		socket_t sock;
+		try {
+			sock = createSocket(reinterpret_cast<const struct sockaddr *>(&addr), addrlen);
+		} catch (const std::runtime_error &e) {
+			PLOG_DEBUG << e.what();
+			continue;
 		}
 
-		auto [addr, addrlen] = mResolved.front();
-		mResolved.pop_front();
+		mAttempts.push_back(sock);
+		auto callback = weak_bind(&TcpTransport::processConnect, this, sock, _1);
+		PollService::Instance().add(sock, {PollService::Direction::Out, CONNECTION_TIMEOUT,
+		                                   std::move(callback)});
 
-		createSocket(reinterpret_cast<const struct sockaddr *>(&addr), addrlen);
-
-	} catch (const std::runtime_error &e) {
-		PLOG_DEBUG << e.what();
-		ThreadPool::Instance().enqueue(weak_bind(&TcpTransport::attempt, this));
+		// RFC 8305 5: Start the next attempt if this one has not succeeded in the meantime
+		scheduleAttempt(CONNECTION_ATTEMPT_DELAY);
 		return;
 	}
 
-	const auto timeout = 10s;
-	PollService::Instance().add(mSock, {PollService::Direction::Out, timeout, 
-	    weak_bind(&TcpTransport::processConnect, this, _1)});
+	// Nothing left to try, the next resolution or a failure will trigger an attempt
+	if (mAttempts.empty() && mPendingResolutions == 0) {
+		PLOG_WARNING << "Connection to " << mHostname << ":" << mService << " failed";
+		changeState(State::Failed);
+	}
 }
 
-void TcpTransport::createSocket(const struct sockaddr *addr, socklen_t addrlen) {
+socket_t TcpTransport::createSocket(const struct sockaddr *addr, socklen_t addrlen) {
+	socket_t sock = INVALID_SOCKET;
 	try {
 		char node[MAX_NUMERICNODE_LEN];
 		char serv[MAX_NUMERICSERV_LEN];
@@ -245,45 +352,46 @@ void TcpTransport::createSocket(const struct sockaddr *addr, socklen_t addrlen)
 		PLOG_VERBOSE << "Creating TCP socket";
 
 		// Create socket
-		mSock = ::socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
-		if (mSock == INVALID_SOCKET)
+		sock = ::socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+		if (sock == INVALID_SOCKET)
 			throw std::runtime_error("TCP socket creation failed");
 
 		// Configure socket
-		configureSocket();
+		configureSocket(sock);
 
 		// Initiate connection
-		int ret = ::connect(mSock, addr, addrlen);
+		int ret = ::connect(sock, addr, addrlen);
 		if (ret < 0 && sockerrno != SEINPROGRESS && sockerrno != SEWOULDBLOCK) {
 			std::ostringstream msg;
 			msg << "TCP connection to " << node << ":" << serv << " failed, errno=" << sockerrno;
 			throw std::runtime_error(msg.str());
 		}
 
+		return sock;
+
 	} catch (...) {
-		if (mSock != INVALID_SOCKET) {
-			::closesocket(mSock);
-			mSock = INVALID_SOCKET;
-		}
+		if (sock != INVALID_SOCKET)
+			::closesocket(sock);
+
 		throw;
 	}
 }
 
-void TcpTransport::configureSocket() {
+void TcpTransport::configureSocket(socket_t sock) {
 	// Set non-blocking
 	ctl_t nbio = 1;
-	if (::ioctlsocket(mSock, FIONBIO, &nbio) < 0)
+	if (::ioctlsocket(sock, FIONBIO, &nbio) < 0)
 		throw std::runtime_error("Failed to set socket non-blocking mode");
 
 	// Disable the Nagle algorithm
 	int nodelay = 1;
-	::setsockopt(mSock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&nodelay),
+	::setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&nodelay),
 	             sizeof(nodelay));
 
 #ifdef __APPLE__
 	// MacOS lacks MSG_NOSIGNAL and requires SO_NOSIGPIPE instead
 	const sockopt_t enabled = 1;
-	if (::setsockopt(mSock, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled)) < 0)
+	if (::setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled)) < 0)
 		throw std::runtime_error("Failed to disable SIGPIPE for socket");
 #endif
 }
@@ -296,6 +404,13 @@ void TcpTransport::setPoll(PollService::Direction direction) {
 
 void TcpTransport::close() {
 	std::lock_guard lock(mSendMutex);
+	mAttemptTimer.cancel();
+	for (socket_t sock : mAttempts) {
+		PollService::Instance().remove(sock);
+		::closesocket(sock);
+	}
+	mAttempts.clear();
+
 	if (mSock != INVALID_SOCKET) {
 		PLOG_DEBUG << "Closing TCP socket";
 		PollService::Instance().remove(mSock);
@@ -305,53 +420,104 @@ void TcpTransport::close() {
 	changeState(State::Disconnected);
 }
 
-bool TcpTransport::trySendQueue() {
+bool TcpTransport::trySendQueue(size_t added) {
 	// mSendMutex must be locked
-	while (auto next = mSendQueue.peek()) {
-		message_ptr message = std::move(*next);
-		size_t size = message->size();
-		if (!trySendMessage(message)) { // replaces message
-			mSendQueue.exchange(message);
-			updateBufferedAmount(-ptrdiff_t(size) + ptrdiff_t(message->size()));
-			return false;
+	size_t sent = 0;
+	while (!mSendQueue.empty()) {
+#ifdef _WIN32
+		WSABUF buffers[SEND_VECTOR_MAX_COUNT];
+#else
+		struct iovec buffers[SEND_VECTOR_MAX_COUNT];
+#endif
+		size_t count = 0;
+		size_t total = 0;
+		size_t offset = mSendOffset;
+#ifndef NO_KTLS
+		// A TLS alert must be sent alone as it is a record of a different type
+		const bool alert = mKernelTlsTx && mSendQueue.front()->type == Message::Control;
+#endif
+		for (auto it = mSendQueue.begin(); it != mSendQueue.end() && count < SEND_VECTOR_MAX_COUNT &&
+		                                   total < SEND_VECTOR_MAX_SIZE;
+		     ++it) {
+			const auto &message = *it;
+#ifndef NO_KTLS
+			if (mKernelTlsTx && it != mSendQueue.begin() &&
+			    (alert || message->type == Message::Control))
+				break;
+#endif
+			auto data = reinterpret_cast<char *>(message->data()) + offset;
+			size_t size = message->size() - offset;
+			offset = 0;
+			if (size == 0)
+				continue;
+#ifdef _WIN32
+			buffers[count].buf = data;
+			buffers[count].len = ULONG(size);
+#else
+			buffers[count].iov_base = data;
+			buffers[count].iov_len = size;
+#endif
+			++count;
+			total += size;
 		}
 
-		mSendQueue.pop();
-		updateBufferedAmount(-ptrdiff_t(size));
-	}
-
-	return true;
-}
-
-bool TcpTransport::trySendMessage(message_ptr &message) {
-	// mSendMutex must be locked
-
-	auto data = reinterpret_cast<const char *>(message->data());
-	auto size = message->size();
-	while (size) {
-#if defined(__APPLE__) || defined(_WIN32)
+#ifdef _WIN32
+		DWORD dwlen = 0;
+		int len = ::WSASend(mSock, buffers, DWORD(count), &dwlen, 0, NULL, NULL) == 0 ? int(dwlen) : -1;
+#else
+		struct msghdr msg = {};
+		msg.msg_iov = buffers;
+		msg.msg_iovlen = count;
+#ifndef NO_KTLS
+		union {
+			char buf[CMSG_SPACE(sizeof(unsigned char))];
+			struct cmsghdr align;
+		} control;
+		if (alert) {
+			msg.msg_control = control.buf;
+			msg.msg_controllen = sizeof(control.buf);
+			struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+			cmsg->cmsg_level = SOL_TLS;
+			cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+			*CMSG_DATA(cmsg) = 21; // alert
+		}
+#endif
+#if defined(__APPLE__)
 		int flags = 0;
 #else
 		int flags = MSG_NOSIGNAL;
 #endif
-		int len = ::send(mSock, data, int(size), flags);
+		auto len = ::sendmsg(mSock, &msg, flags);
+#endif
 		if (len < 0) {
-			if (sockerrno == SEAGAIN || sockerrno == SEWOULDBLOCK) {
-				if (size < message->size())
-					message = make_message(message->end() - size, message->end());
-
-				return false;
-			} else {
-				PLOG_ERROR << "Connection closed, errno=" << sockerrno;
-				throw std::runtime_error("Connection closed");
+			if (sockerrno == SEAGAIN || sockerrno == SEWOULDBLOCK)
+				break;
+
+			PLOG_ERROR << "Connection closed, errno=" << sockerrno;
+			throw std::runtime_error("Connection closed");
+		}
+
+		// Track partial progress by offset instead of copying the remaining data
+		size_t remaining = size_t(len);
+		sent += remaining;
+		while (!mSendQueue.empty()) {
+			size_t left = mSendQueue.front()->size() - mSendOffset;
+			if (remaining < left) {
+				mSendOffset += remaining;
+				break;
 			}
+			remaining -= left;
+			mSendQueue.pop_front();
+			mSendOffset = 0;
 		}
 
-		data += len;
-		size -= len;
+		if (size_t(len) < total)
+			break; // the socket buffer is full, the next write would not succeed
 	}
-	message = nullptr;
-	return true;
+
+	updateBufferedAmount(ptrdiff_t(added) - ptrdiff_t(sent));
+	return mSendQueue.empty();
 }
 
 void TcpTransport::updateBufferedAmount(ptrdiff_t delta) {
@@ -402,7 +568,10 @@ void TcpTransport::process(PollService::Event event) {
 		}
 
 		case PollService::Event::In: {
-			const size_t bufferSize = 4096;
+			// Reads rely on PollService readiness, there is deliberately no io_uring engine, as
+			// multishot receive would need a second I/O model handling idle timeouts and send
+			// backpressure for little gain over large reads.
+			const size_t bufferSize = 16384;
 			char buffer[bufferSize];
 			int len;
 			while ((len = ::recv(mSock, buffer, bufferSize, 0)) > 0) {
@@ -410,6 +579,9 @@ void TcpTransport::process(PollService::Event event) {
 				incoming(make_message(b, b + len));
 			}
 
+			// Read until EAGAIN or end of stream: with edge-triggered polling, a FIN received
+			// after a short read would not be notified again.
+
 			if (len == 0)
 				break; // clean close
 
@@ -436,39 +608,61 @@ void TcpTransport::process(PollService::Event event) {
 	recv(nullptr);
 }
 
-void TcpTransport::processConnect(PollService::Event event) {
-	try {
-		if (event == PollService::Event::Error)
-			throw std::runtime_error("TCP connection failed");
+void TcpTransport::processConnect(socket_t sock, PollService::Event event) {
+	{
+		std::lock_guard lock(mSendMutex);
+		auto it = std::find(mAttempts.begin(), mAttempts.end(), sock);
+		if (it == mAttempts.end() || state() != State::Connecting)
+			return; // Cancelled
 
-		if (event == PollService::Event::Timeout)
-			throw std::runtime_error("TCP connection timed out");
+		try {
+			if (event == PollService::Event::Error)
+				throw std::runtime_error("TCP connection failed");
 
-		if (event != PollService::Event::Out)
-			return;
+			if (event == PollService::Event::Timeout)
+				throw std::runtime_error("TCP connection timed out");
 
-		int err = 0;
-		socklen_t errlen = sizeof(err);
-		if (::getsockopt(mSock, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&err),
-						 &errlen) != 0)
-			throw std::runtime_error("Failed to get socket error code");
+			if (event != PollService::Event::Out)
+				return;
 
-		if (err != 0) {
-			std::ostringstream msg;
-			msg << "TCP connection failed, errno=" << err;
-			throw std::runtime_error(msg.str());
-		}
+			int err = 0;
+			socklen_t errlen = sizeof(err);
+			if (::getsockopt(sock, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&err),
+			                 &errlen) != 0)
+				throw std::runtime_error("Failed to get socket error code");
 
-		// Success
-		PLOG_INFO << "TCP connected";
-		changeState(State::Connected);
-		setPoll(PollService::Direction::In);
+			if (err != 0) {
+				std::ostringstream msg;
+				msg << "TCP connection failed, errno=" << err;
+				throw std::runtime_error(msg.str());
+			}
 
-	} catch (const std::exception &e) {
-		PLOG_DEBUG << e.what();
-		PollService::Instance().remove(mSock);
-		ThreadPool::Instance().enqueue(weak_bind(&TcpTransport::attempt, this));
+		} catch (const std::exception &e) {
+			PLOG_DEBUG << e.what();
+			mAttempts.erase(it);
+			PollService::Instance().remove(sock);
+			::closesocket(sock);
+			scheduleAttempt(0ms); // try the next address right away
+			return;
+		}
+
+		// Success, cancel the other attempts
+		mAttempts.erase(it);
+		for (socket_t other : mAttempts) {
+			PollService::Instance().remove(other);
+			::closesocket(other);
+		}
+		mAttempts.clear();
+		mAttemptTimer.cancel();
+		mAttemptTimer = Timer();
+		mResolved6.clear();
+		mResolved4.clear();
+		mSock = sock;
 	}
+
+	PLOG_INFO << "TCP connected";
+	changeState(State::Connected);
+	setPoll(PollService::Direction::In);
 }
 
 } // namespace rtc::impl
@@ -11,19 +11,23 @@
 
 #include "common.hpp"
 #include "pollservice.hpp"
-#include "queue.hpp"
 #include "socket.hpp"
+#include "threadpool.hpp"
 #include "transport.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
 
 #include <chrono>
-#include <list>
+#include <deque>
 #include <mutex>
 #include <tuple>
+#include <vector>
 
 namespace rtc::impl {
 
+// Active connections follow Happy Eyeballs v2 (RFC 8305): IPv6 and IPv4 addresses are resolved in
+// parallel, then connection attempts alternate between families and are staggered, the first one
+// to succeed being kept.
 class TcpTransport final : public Transport, public std::enable_shared_from_this<TcpTransport> {
 public:
 	using amount_callback = std::function<void(size_t amount)>;
@@ -43,34 +47,51 @@ public:
 
 	bool isActive() const;
 	string remoteAddress() const;
+	string service() const;
+
+	// Attach kernel TLS to the socket for transmission, cryptoInfo is a tls12_crypto_info_* struct.
+	// Returns false if ciphertext is still queued, in which case the caller should retry later.
+	bool enableKernelTlsTx(const void *cryptoInfo, size_t size);
+
+	// Queue a TLS alert, which is sent as an alert record through the kernel TLS layer
+	bool sendKernelTlsAlert(uint8_t level, uint8_t description);
 
 private:
+	using address_t = std::tuple<struct sockaddr_storage, socklen_t>;
+
 	void connect();
-	void resolve();
+	void resolve(int family);
 	void attempt();
-	void createSocket(const struct sockaddr *addr, socklen_t addrlen);
-	void configureSocket();
+	void scheduleAttempt(std::chrono::milliseconds delay); // requires mSendMutex to be locked
+	socket_t createSocket(const struct sockaddr *addr, socklen_t addrlen);
+	void configureSocket(socket_t sock);
 	void setPoll(PollService::Direction direction);
 	void close();
 
-	bool trySendQueue();
-	bool trySendMessage(message_ptr &message);
+	bool trySendQueue(size_t added = 0); // added bytes are not yet accounted as buffered
 	void updateBufferedAmount(ptrdiff_t delta);
 	void triggerBufferedAmount(size_t amount);
 
 	void process(PollService::Event event);
-	void processConnect(PollService::Event event);
+	void processConnect(socket_t sock, PollService::Event event);
 
 	const bool mIsActive;
 	string mHostname, mService;
 	amount_callback mBufferedAmountCallback;
 	optional<std::chrono::milliseconds> mReadTimeout;
 
-	std::list<std::tuple<struct sockaddr_storage, socklen_t>> mResolved;
+	// Connection state, protected by mSendMutex
+	std::deque<address_t> mResolved6, mResolved4;
+	int mPendingResolutions = 0;
+	bool mNextIpv6 = true;           // family of the next attempt, if available
+	std::vector<socket_t> mAttempts; // sockets of attempts in progress
+	Timer mAttemptTimer;             // next attempt, if scheduled
 
 	socket_t mSock;
-	Queue<message_ptr> mSendQueue;
+	std::deque<message_ptr> mSendQueue;
+	size_t mSendOffset = 0; // bytes of the first queued message which are already sent
 	size_t mBufferedAmount = 0;
+	bool mKernelTlsTx = false; // queued Control messages are TLS alerts
 	std::mutex mSendMutex;
 };
 
@@ -7,28 +7,220 @@
  */
 
 #include "threadpool.hpp"
+#include "latencyhistogram.hpp"
+#include "tracing.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+#endif
+
 namespace rtc::impl {
 
 ThreadPool &ThreadPool::Instance() {
-	static ThreadPool *instance = new ThreadPool;
+	static ThreadPool *instance = new ThreadPool("RTC worker");
+	return *instance;
+}
+
+ThreadPool &ThreadPool::ControlInstance() {
+	static ThreadPool *instance = new ThreadPool("RTC control");
 	return *instance;
 }
 
-ThreadPool::ThreadPool() {}
+ThreadPool &ThreadPool::Control() {
+	auto &control = ControlInstance();
+	return control.mWorkersCount > 0 ? control : Instance();
+}
+
+ThreadPool::ThreadPool(string name) : mName(std::move(name)) {}
 
 ThreadPool::~ThreadPool() {}
 
+bool Timer::cancel() { return mPool && mPool->cancel(*this); }
+
+namespace {
+
+thread_local int CurrentWorkerIndex = -1; // index of the current worker, -1 if not a worker
+
+LatencyHistogram HISTOGRAM_QUEUE_WAIT("rtc_threadpool_queue_wait",
+                                      "Time spent by immediate tasks in the thread pool queues");
+
+} // namespace
+
 int ThreadPool::count() const {
 	std::unique_lock lock(mWorkersMutex);
 	return int(mWorkers.size());
 }
 
+void ThreadPool::setWorkStealing(bool enabled) {
+	std::unique_lock lock(mWorkersMutex);
+	if (!mWorkers.empty())
+		throw std::logic_error("Work stealing must be set before spawning workers");
+
+	mWorkStealing = enabled;
+}
+
+void ThreadPool::setAffinity(std::vector<unsigned int> cpus) {
+	std::unique_lock lock(mWorkersMutex);
+	if (!mWorkers.empty())
+		throw std::logic_error("Affinity must be set before spawning workers");
+
+	mAffinity = std::move(cpus);
+}
+
+void ThreadPool::setExternal(bool enabled) {
+	std::unique_lock lock(mWorkersMutex);
+	if (!mWorkers.empty())
+		throw std::logic_error("External mode must be set before spawning workers");
+
+	if (enabled && mWorkStealing)
+		throw std::logic_error("Work stealing is not supported with an external event loop");
+
+#ifndef _WIN32
+	if (enabled && mEventFds[0] < 0) {
+#if defined(__linux__)
+		mEventFds[0] = mEventFds[1] = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (mEventFds[0] < 0)
+			throw std::runtime_error("Failed to create event descriptor");
+#else
+		if (::pipe(mEventFds) != 0)
+			throw std::runtime_error("Failed to create event pipe");
+
+		for (int fd : mEventFds) {
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+#endif
+	}
+#endif
+
+	mExternal = enabled;
+}
+
+void ThreadPool::setLowPriority(bool enabled) {
+	std::unique_lock lock(mWorkersMutex);
+	if (!mWorkers.empty())
+		throw std::logic_error("Priority must be set before spawning workers");
+
+	mLowPriority = enabled;
+}
+
+bool ThreadPool::isExternal() const { return mExternal; }
+
+int ThreadPool::eventDescriptor() const { return mExternal ? mEventFds[0] : -1; }
+
+size_t ThreadPool::runExternal(clock::duration timeout) {
+	drainExternal();
+
+	// Run at most the tasks ready on entry so tasks posting tasks can't starve the loop
+	size_t count = 0;
+	size_t limit = 0;
+	{
+		std::unique_lock lock(mMutex);
+		const auto end = clock::now() + timeout;
+		while (true) {
+			const auto now = clock::now();
+			mTimers.advance(now, mTasks);
+			mTaskTimes.resize(mTasks.size(), now); // expired tasks are queued from now
+			if (!mTasks.empty() || now >= end || mJoining)
+				break;
+
+			auto deadline = mTimers.next();
+			mTasksCondition.wait_until(lock, deadline ? std::min(*deadline, end) : end);
+		}
+		limit = mTasks.size();
+		++mBusyWorkers; // join() waits for the running tasks
+	}
+
+	while (count < limit) {
+		Task task;
+		{
+			std::unique_lock lock(mMutex);
+			if (mTasks.empty())
+				break;
+
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+			mTaskTimes.pop_front();
+		}
+
+		TraceScope scope(TracePoint::TaskBegin, TracePoint::TaskEnd);
+		task();
+		mTasksExecuted.fetch_add(1, std::memory_order_relaxed);
+		++count;
+	}
+
+	// Tasks posted in the meantime need another run
+	std::unique_lock lock(mMutex);
+	--mBusyWorkers;
+	mWaitingCondition.notify_all();
+	if (!mTasks.empty())
+		signalExternal();
+
+	return count;
+}
+
+optional<ThreadPool::clock::duration> ThreadPool::nextTimeout() const {
+	std::unique_lock lock(mMutex);
+	if (!mTasks.empty())
+		return clock::duration::zero();
+
+	auto deadline = mTimers.next();
+	if (!deadline)
+		return nullopt;
+
+	return std::max(*deadline - clock::now(), clock::duration::zero());
+}
+
+void ThreadPool::signalExternal() {
+	// mMutex must be locked
+	if (mExternalSignaled.exchange(true))
+		return; // already readable
+
+#ifndef _WIN32
+	if (mEventFds[1] >= 0) {
+		const uint64_t value = 1; // written as a whole for eventfd, any byte works for a pipe
+		[[maybe_unused]] auto ret = ::write(mEventFds[1], &value, sizeof(value));
+	}
+#endif
+}
+
+void ThreadPool::drainExternal() {
+	if (!mExternalSignaled.load())
+		return;
+
+#ifndef _WIN32
+	if (mEventFds[0] >= 0) {
+		uint64_t buffer[8];
+		while (::read(mEventFds[0], buffer, sizeof(buffer)) > 0) {
+		}
+	}
+#endif
+
+	// The flag is cleared after reading, otherwise a signal in between would be read while the
+	// flag stays set. Tasks posted before it is cleared are in the queue checked by the caller.
+	std::unique_lock lock(mMutex);
+	mExternalSignaled = false;
+}
+
 void ThreadPool::spawn(int count) {
 	std::unique_lock lock(mWorkersMutex);
+	if (mWorkStealing && mWorkerQueuesCount == 0 && count > 0) {
+		// Workers spawned later share the existing queues
+		mWorkerQueues.reset(new WorkerQueue[count]);
+		mWorkerQueuesCount.store(size_t(count), std::memory_order_release);
+	}
+
 	while (count-- > 0)
-		mWorkers.emplace_back(std::bind(&ThreadPool::run, this));
+		mWorkers.emplace_back(std::bind(&ThreadPool::runWorker, this, mWorkers.size()));
+
+	mWorkersCount = mWorkers.size();
 }
 
 void ThreadPool::join() {
@@ -44,18 +236,29 @@ void ThreadPool::join() {
 		w.join();
 
 	mWorkers.clear();
+	mWorkersCount = 0;
 
 	mJoining = false;
 }
 
 void ThreadPool::clear() {
 	std::unique_lock lock(mMutex);
-	while (!mTasks.empty())
-		mTasks.pop();
+	mTasks.clear();
+	mTaskTimes.clear();
+	mTimers.clear();
+
+	const size_t count = mWorkerQueuesCount.load(std::memory_order_acquire);
+	for (size_t i = 0; i < count; ++i) {
+		auto &queue = mWorkerQueues[i];
+		std::unique_lock queueLock(queue.mutex);
+		mPendingCount -= queue.tasks.size();
+		queue.tasks.clear();
+		queue.times.clear();
+	}
 }
 
 void ThreadPool::run() {
-	utils::this_thread::set_name("RTC worker");
+	utils::this_thread::set_name(mName);
 	++mBusyWorkers;
 	scope_guard guard([&]() { --mBusyWorkers; });
 	while (runOne()) {
@@ -64,25 +267,200 @@ void ThreadPool::run() {
 
 bool ThreadPool::runOne() {
 	if (auto task = dequeue()) {
+		TraceScope scope(TracePoint::TaskBegin, TracePoint::TaskEnd);
 		task();
+		mTasksExecuted.fetch_add(1, std::memory_order_relaxed);
 		return true;
 	}
 	return false;
 }
 
-std::function<void()> ThreadPool::dequeue() {
+void ThreadPool::runWorker(size_t index) {
+	CurrentWorkerIndex = int(index);
+	// Workers share the whole CPU set so the scheduler can still balance them
+	if (!mAffinity.empty() && !utils::this_thread::set_affinity(mAffinity)) {
+		PLOG_WARNING << "Failed to set the CPU affinity of worker " << index;
+	}
+
+	if (mLowPriority && !utils::this_thread::set_low_priority()) {
+		PLOG_DEBUG << "Failed to lower the priority of worker " << index;
+	}
+
+	run();
+}
+
+bool ThreadPool::cancel(const Timer &timer) {
+	if (!timer)
+		return false;
+
+	std::unique_lock lock(mMutex);
+	return mTimers.cancel(timer.mId);
+}
+
+ThreadPoolStats ThreadPool::stats() const {
+	ThreadPoolStats stats;
+	stats.workers = size_t(count());
+	stats.busyWorkers = size_t(std::max(mBusyWorkers.load(), 0));
+	stats.tasksExecuted = mTasksExecuted.load(std::memory_order_relaxed);
+
+	const auto now = clock::now();
+	auto oldest = now;
+	{
+		std::unique_lock lock(mMutex);
+		stats.queuedTasks = mTasks.size();
+		stats.pendingTimers = mTimers.size();
+		if (!mTaskTimes.empty())
+			oldest = mTaskTimes.front();
+	}
+
+	const size_t count = mWorkerQueuesCount.load(std::memory_order_acquire);
+	for (size_t i = 0; i < count; ++i) {
+		auto &queue = mWorkerQueues[i];
+		std::unique_lock lock(queue.mutex);
+		stats.queuedTasks += queue.tasks.size();
+		if (!queue.times.empty())
+			oldest = std::min(oldest, queue.times.front()); // the front is the oldest
+	}
+
+	stats.oldestTaskAge = std::chrono::duration_cast<std::chrono::microseconds>(now - oldest);
+	return stats;
+}
+
+void ThreadPool::push(clock::time_point time, Task func) {
+	if (time > clock::now())
+		pushTimer(time, std::move(func));
+	else
+		pushImmediate(std::move(func));
+}
+
+TimerWheel::id_t ThreadPool::pushTimer(clock::time_point time, Task func) {
+	std::unique_lock lock(mMutex);
+	auto deadline = mTimers.next();
+	auto id = mTimers.add(time, std::move(func));
+	if (!deadline || time < *deadline) {
+		mTasksCondition.notify_one(); // sleeping workers need an earlier deadline
+		if (mExternal)
+			signalExternal(); // the external loop needs to rearm its timer
+	}
+
+	return id;
+}
+
+void ThreadPool::pushImmediate(Task func) {
+	if constexpr (LatencyHistogram::Enabled) {
+		func = [func = std::move(func), start = LatencyHistogram::Now()]() mutable {
+			HISTOGRAM_QUEUE_WAIT.recordSince(start);
+			func();
+		};
+	}
+
+	if (mWorkStealing) {
+		pushLocal(std::move(func));
+		return;
+	}
+
+	std::unique_lock lock(mMutex);
+	mTasks.emplace_back(std::move(func));
+	mTaskTimes.emplace_back(clock::now());
+	mTasksCondition.notify_one();
+	if (mExternal)
+		signalExternal();
+}
+
+Task ThreadPool::popExpired() {
+	// mMutex must be locked
+	const auto now = clock::now();
+	mTimers.advance(now, mTasks);
+	mTaskTimes.resize(mTasks.size(), now); // expired tasks are queued from now
+	if (mTasks.empty())
+		return nullptr;
+
+	auto func = std::move(mTasks.front());
+	mTasks.pop_front();
+	mTaskTimes.pop_front();
+	if (!mTasks.empty())
+		mTasksCondition.notify_one();
+
+	return func;
+}
+
+void ThreadPool::pushLocal(Task func) {
+	const size_t count = mWorkerQueuesCount.load(std::memory_order_acquire);
+	if (count == 0) {
+		// No workers yet, keep the task in the shared queue
+		std::unique_lock lock(mMutex);
+		mTasks.emplace_back(std::move(func));
+		mTaskTimes.emplace_back(clock::now());
+		mTasksCondition.notify_one();
+		return;
+	}
+
+	// Workers push to their own queue, other threads distribute tasks in a round-robin fashion
+	const size_t index =
+	    CurrentWorkerIndex >= 0 ? size_t(CurrentWorkerIndex) % count : mNextQueue++ % count;
+	{
+		auto &queue = mWorkerQueues[index];
+		std::unique_lock lock(queue.mutex);
+		queue.tasks.emplace_back(std::move(func));
+		queue.times.emplace_back(clock::now());
+		++mPendingCount;
+	}
+
+	// Wake up a sleeping worker if any, it will steal the task if necessary
+	if (mIdleWorkers > 0) {
+		std::unique_lock lock(mMutex);
+		mTasksCondition.notify_one();
+	}
+}
+
+Task ThreadPool::dequeue() {
+	return mWorkStealing ? dequeueWorkStealing() : dequeueShared();
+}
+
+Task ThreadPool::dequeueShared() {
 	std::unique_lock lock(mMutex);
 	while (!mJoining) {
-		std::optional<clock::time_point> time;
-		if (!mTasks.empty()) {
-			time = mTasks.top().time;
-			if (*time <= clock::now()) {
-				auto func = std::move(mTasks.top().func);
-				mTasks.pop();
+		if (auto func = popExpired())
+			return func;
+
+		auto time = mTimers.next();
+		--mBusyWorkers;
+		scope_guard guard([&]() { ++mBusyWorkers; });
+		mWaitingCondition.notify_all();
+		if (time)
+			mTasksCondition.wait_until(lock, *time);
+		else
+			mTasksCondition.wait(lock);
+	}
+	return nullptr;
+}
+
+Task ThreadPool::dequeueWorkStealing() {
+	const size_t index = CurrentWorkerIndex >= 0 ? size_t(CurrentWorkerIndex) : 0;
+	while (!mJoining) {
+		if (mPendingCount > 0) {
+			if (auto func = popLocal(index))
+				return func;
+
+			if (auto func = steal(index))
 				return func;
-			}
 		}
 
+		std::unique_lock lock(mMutex);
+		if (mJoining)
+			break;
+
+		if (auto func = popExpired())
+			return func;
+
+		auto time = mTimers.next();
+
+		// Register as idle before checking for pending tasks so pushLocal() can't miss us
+		++mIdleWorkers;
+		scope_guard idleGuard([&]() { --mIdleWorkers; });
+		if (mPendingCount > 0)
+			continue;
+
 		--mBusyWorkers;
 		scope_guard guard([&]() { ++mBusyWorkers; });
 		mWaitingCondition.notify_all();
@@ -94,4 +472,54 @@ std::function<void()> ThreadPool::dequeue() {
 	return nullptr;
 }
 
+Task ThreadPool::popLocal(size_t index) {
+	const size_t count = mWorkerQueuesCount.load(std::memory_order_acquire);
+	if (count == 0)
+		return nullptr;
+
+	auto &queue = mWorkerQueues[index % count];
+	std::unique_lock lock(queue.mutex);
+	if (queue.tasks.empty())
+		return nullptr;
+
+	auto func = std::move(queue.tasks.front());
+	queue.tasks.pop_front();
+	queue.times.pop_front();
+	--mPendingCount;
+	return func;
+}
+
+Task ThreadPool::steal(size_t index) {
+	// The first pass skips the queues being accessed, the second one waits for them, so a worker
+	// which lost every race backs off on the queue mutexes instead of spinning on mPendingCount
+	const size_t count = mWorkerQueuesCount.load(std::memory_order_acquire);
+	for (bool blocking : {false, true}) {
+		bool contended = false;
+		for (size_t i = 1; i < count; ++i) {
+			auto &queue = mWorkerQueues[(index + i) % count];
+			std::unique_lock lock(queue.mutex, std::defer_lock);
+			if (blocking) {
+				lock.lock();
+			} else if (!lock.try_lock()) {
+				contended = true;
+				continue;
+			}
+
+			if (queue.tasks.empty())
+				continue;
+
+			// Steal from the back to reduce contention with the owner
+			auto func = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			queue.times.pop_back();
+			--mPendingCount;
+			return func;
+		}
+
+		if (!contended)
+			break;
+	}
+	return nullptr;
+}
+
 } // namespace rtc::impl
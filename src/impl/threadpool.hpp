@@ -12,6 +12,8 @@
 #include "common.hpp"
 #include "init.hpp"
 #include "internals.hpp"
+#include "task.hpp"
+#include "timerwheel.hpp"
 
 #include <chrono>
 #include <condition_variable>
@@ -20,9 +22,9 @@
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <thread>
+#include <tuple>
 #include <vector>
 
 namespace rtc::impl {
@@ -30,11 +32,38 @@ namespace rtc::impl {
 template <class F, class... Args>
 using invoke_future_t = std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>;
 
+class ThreadPool;
+
+// Handle to a task scheduled with ThreadPool::setTimer(), cancelling it removes the task from the
+// timer wheel in constant time. Cancelling a task which already ran or was cancelled is a no-op.
+class Timer final {
+public:
+	Timer() = default;
+
+	bool cancel(); // true if the task was pending and won't run
+	explicit operator bool() const { return mId != 0; }
+
+private:
+	Timer(TimerWheel::id_t id, ThreadPool *pool) : mId(id), mPool(pool) {}
+
+	TimerWheel::id_t mId = 0;
+	ThreadPool *mPool = nullptr;
+
+	friend class ThreadPool;
+};
+
 class ThreadPool final {
 public:
 	using clock = std::chrono::steady_clock;
 
-	static ThreadPool &Instance();
+	static ThreadPool &Instance(); // media path and user callbacks
+
+	// CPU-heavy control-plane tasks, like certificate generation, DTLS handshakes, and teardown, run
+	// on a dedicated pool with lower priority so that a burst of new connections does not delay the
+	// media of the existing ones. Control() falls back to the main pool if the dedicated one has no
+	// workers, for instance with an external event loop.
+	static ThreadPool &ControlInstance();
+	static ThreadPool &Control();
 
 	ThreadPool(const ThreadPool &) = delete;
 	ThreadPool &operator=(const ThreadPool &) = delete;
@@ -48,9 +77,24 @@ public:
 	void run();
 	bool runOne();
 
+	// Must be set before spawning workers
+	void setWorkStealing(bool enabled);
+	void setAffinity(std::vector<unsigned int> cpus); // empty for no affinity
+	void setExternal(bool enabled); // no workers, tasks are run by an external event loop
+	void setLowPriority(bool enabled);
+
+	// External event loop integration
+	bool isExternal() const;
+	size_t runExternal(clock::duration timeout); // returns the number of tasks run
+	int eventDescriptor() const; // readable when tasks are ready, -1 if unsupported
+	optional<clock::duration> nextTimeout() const; // zero if tasks are ready, nullopt if none
+
 	template <class F, class... Args>
 	auto enqueue(F &&f, Args &&...args) noexcept -> invoke_future_t<F, Args...>;
 
+	// Fire-and-forget enqueue, without the future. A Task is posted as is, so it must not throw.
+	template <class F, class... Args> void post(F &&f, Args &&...args) noexcept;
+
 	template <class F, class... Args>
 	auto schedule(clock::duration delay, F &&f, Args &&...args) noexcept
 	    -> invoke_future_t<F, Args...>;
@@ -59,23 +103,66 @@ public:
 	auto schedule(clock::time_point time, F &&f, Args &&...args) noexcept
 	    -> invoke_future_t<F, Args...>;
 
+	// Cancellable delayed task, without the future
+	template <class F, class... Args>
+	Timer setTimer(clock::duration delay, F &&f, Args &&...args) noexcept;
+
+	template <class F, class... Args>
+	Timer setTimer(clock::time_point time, F &&f, Args &&...args) noexcept;
+
+	bool cancel(const Timer &timer);
+
+	ThreadPoolStats stats() const;
+
 private:
-	ThreadPool();
+	explicit ThreadPool(string name);
 	~ThreadPool();
 
-	std::function<void()> dequeue(); // returns null function if joining
-
+	template <class F, class... Args> static Task MakeTask(F &&f, Args &&...args);
+
+	void push(clock::time_point time, Task func);
+	TimerWheel::id_t pushTimer(clock::time_point time, Task func);
+	void pushImmediate(Task func);
+	Task popExpired(); // mMutex must be locked
+	void pushLocal(Task func);
+	Task dequeue(); // returns null function if joining
+	Task dequeueShared();
+	Task dequeueWorkStealing();
+	Task popLocal(size_t index);
+	Task steal(size_t index);
+	void runWorker(size_t index);
+	void signalExternal(); // mMutex must be locked
+	void drainExternal();
+
+	const string mName; // of worker threads
 	std::vector<std::thread> mWorkers;
+	std::atomic<size_t> mWorkersCount = 0;
+	std::atomic<bool> mLowPriority = false;
+	std::vector<unsigned int> mAffinity; // CPUs of the workers
 	std::atomic<int> mBusyWorkers = 0;
 	std::atomic<bool> mJoining = false;
 
-	struct Task {
-		clock::time_point time;
-		std::function<void()> func;
-		bool operator>(const Task &other) const { return time > other.time; }
-		bool operator<(const Task &other) const { return time < other.time; }
+	// With work stealing, each worker owns a deque for immediate tasks, while delayed tasks are kept
+	// in the timer wheel. Idle workers steal from the other deques before going to sleep.
+	struct WorkerQueue {
+		std::deque<Task> tasks;
+		std::deque<clock::time_point> times; // queuing times of tasks
+		std::mutex mutex;
 	};
-	std::priority_queue<Task, std::deque<Task>, std::greater<Task>> mTasks;
+	unique_ptr<WorkerQueue[]> mWorkerQueues; // allocated once, never reallocated
+	std::atomic<size_t> mWorkerQueuesCount = 0;
+	std::atomic<bool> mWorkStealing = false;
+	std::atomic<bool> mExternal = false;
+	std::atomic<bool> mExternalSignaled = false;
+	int mEventFds[2] = {-1, -1}; // eventfd or pipe, created once
+	std::atomic<size_t> mPendingCount = 0; // immediate tasks in worker queues
+	std::atomic<int> mIdleWorkers = 0;
+	std::atomic<size_t> mNextQueue = 0;
+
+	std::deque<Task> mTasks;                 // immediate and expired tasks
+	std::deque<clock::time_point> mTaskTimes; // queuing times of tasks
+	TimerWheel mTimers;                      // delayed tasks
+	std::atomic<uint64_t> mTasksExecuted = 0;
 
 	std::condition_variable mTasksCondition, mWaitingCondition;
 	mutable std::mutex mMutex, mWorkersMutex;
@@ -86,6 +173,10 @@ auto ThreadPool::enqueue(F &&f, Args &&...args) noexcept -> invoke_future_t<F, A
 	return schedule(clock::now(), std::forward<F>(f), std::forward<Args>(args)...);
 }
 
+template <class F, class... Args> void ThreadPool::post(F &&f, Args &&...args) noexcept {
+	pushImmediate(MakeTask(std::forward<F>(f), std::forward<Args>(args)...));
+}
+
 template <class F, class... Args>
 auto ThreadPool::schedule(clock::duration delay, F &&f, Args &&...args) noexcept
     -> invoke_future_t<F, Args...> {
@@ -95,7 +186,6 @@ auto ThreadPool::schedule(clock::duration delay, F &&f, Args &&...args) noexcept
 template <class F, class... Args>
 auto ThreadPool::schedule(clock::time_point time, F &&f, Args &&...args) noexcept
     -> invoke_future_t<F, Args...> {
-	std::unique_lock lock(mMutex);
 	using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
 	auto bound = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
 	auto task = std::make_shared<std::packaged_task<R()>>([bound = std::move(bound)]() mutable {
@@ -108,11 +198,42 @@ auto ThreadPool::schedule(clock::time_point time, F &&f, Args &&...args) noexcep
 	});
 	std::future<R> result = task->get_future();
 
-	mTasks.push({time, [task = std::move(task)]() { return (*task)(); }});
-	mTasksCondition.notify_one();
+	push(time, [task = std::move(task)]() { return (*task)(); });
 	return result;
 }
 
+template <class F, class... Args>
+Timer ThreadPool::setTimer(clock::duration delay, F &&f, Args &&...args) noexcept {
+	return setTimer(clock::now() + delay, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template <class F, class... Args>
+Timer ThreadPool::setTimer(clock::time_point time, F &&f, Args &&...args) noexcept {
+	try {
+		auto task = MakeTask(std::forward<F>(f), std::forward<Args>(args)...);
+		return Timer(pushTimer(time, std::move(task)), this);
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "Failed to set timer: " << e.what();
+		return Timer();
+	}
+}
+
+template <class F, class... Args> Task ThreadPool::MakeTask(F &&f, Args &&...args) {
+	if constexpr (std::is_same_v<std::decay_t<F>, Task> && sizeof...(Args) == 0) {
+		return std::forward<F>(f); // already wrapped, avoid nesting
+	} else {
+		// Store the arguments in a tuple rather than using std::bind, so that small tasks fit inline
+		return [f = std::forward<F>(f),
+		        args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+			try {
+				std::apply(std::move(f), std::move(args));
+			} catch (const std::exception &e) {
+				PLOG_WARNING << e.what();
+			}
+		};
+	}
+}
+
 } // namespace rtc::impl
 
 #endif
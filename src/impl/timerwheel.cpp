@@ -0,0 +1,207 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "timerwheel.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace rtc::impl {
+
+TimerWheel::TimerWheel(clock::time_point start) : mStart(start) {
+	for (auto &slots : mSlots)
+		slots.fill(-1);
+}
+
+TimerWheel::id_t TimerWheel::add(clock::time_point time, Task func) {
+	int32_t index;
+	if (mFree >= 0) {
+		index = mFree;
+		mFree = mEntries[index].next;
+	} else {
+		if (mEntries.size() >= size_t(std::numeric_limits<int32_t>::max()))
+			throw std::length_error("Too many timers");
+
+		index = int32_t(mEntries.size());
+		mEntries.emplace_back();
+	}
+
+	auto &entry = mEntries[index];
+	// Round up so that the timer never expires early
+	auto elapsed = std::max(time - mStart, clock::duration::zero());
+	entry.tick = uint64_t((elapsed + Resolution - clock::duration(1)) / Resolution);
+	entry.func = std::move(func);
+	entry.pending = true;
+	link(index);
+	++mCount;
+
+	return (id_t(entry.generation) << 32) | id_t(index);
+}
+
+bool TimerWheel::cancel(id_t id) {
+	auto index = int32_t(id & 0xFFFFFFFF);
+	auto generation = uint32_t(id >> 32);
+	if (id == 0 || size_t(index) >= mEntries.size())
+		return false;
+
+	auto &entry = mEntries[index];
+	if (!entry.pending || entry.generation != generation)
+		return false;
+
+	unlink(index);
+	release(index);
+	return true;
+}
+
+void TimerWheel::clear() {
+	for (int32_t index = 0; index < int32_t(mEntries.size()); ++index)
+		if (mEntries[index].pending) {
+			unlink(index);
+			release(index);
+		}
+}
+
+void TimerWheel::advance(clock::time_point now, std::deque<Task> &expired) {
+	if (now < mStart)
+		return;
+
+	const uint64_t nowTick = uint64_t((now - mStart) / Resolution);
+	while (mCurrent <= nowTick) {
+		if (mCount == 0) {
+			mCurrent = nowTick + 1;
+			break;
+		}
+
+		// Cascade from the higher levels first when their slot turns
+		if ((mCurrent & SlotMask) == 0)
+			for (int level = LevelsCount - 1; level > 0; --level) {
+				const int shift = SlotBits * level;
+				if ((mCurrent & ((uint64_t(1) << shift) - 1)) == 0)
+					cascade(level, int((mCurrent >> shift) & SlotMask));
+			}
+
+		if (mOccupied[0] == 0) {
+			// Nothing to expire before the next turn of the first level
+			mCurrent = std::min((mCurrent | SlotMask) + 1, nowTick + 1);
+			continue;
+		}
+
+		const int slot = int(mCurrent & SlotMask);
+		int32_t index = mSlots[0][slot];
+		mSlots[0][slot] = -1;
+		mOccupied[0] &= ~(uint64_t(1) << slot);
+		while (index >= 0) {
+			auto &entry = mEntries[index];
+			int32_t next = entry.next;
+			entry.prev = entry.next = -1;
+			if (entry.tick <= mCurrent) {
+				expired.emplace_back(std::move(entry.func));
+				release(index);
+			} else {
+				link(index);
+			}
+			index = next;
+		}
+
+		++mCurrent;
+	}
+}
+
+optional<TimerWheel::clock::time_point> TimerWheel::next() const {
+	if (mCount == 0)
+		return nullopt;
+
+	uint64_t best = std::numeric_limits<uint64_t>::max();
+	for (int level = 0; level < LevelsCount; ++level) {
+		const uint64_t bits = mOccupied[level];
+		if (bits == 0)
+			continue;
+
+		const int shift = SlotBits * level;
+		const uint64_t block = mCurrent >> shift;
+		const int current = int(block & SlotMask);
+		// On higher levels, the current slot has already been cascaded unless the turn is pending
+		const bool pending = level == 0 || (mCurrent & ((uint64_t(1) << shift) - 1)) == 0;
+		for (int k = pending ? 0 : 1; k <= SlotsCount; ++k) {
+			if (bits & (uint64_t(1) << ((current + k) & SlotMask))) {
+				const uint64_t tick = level == 0 ? mCurrent + k : (block + k) << shift;
+				best = std::min(best, tick);
+				break;
+			}
+		}
+	}
+
+	return mStart + best * Resolution;
+}
+
+void TimerWheel::link(int32_t index) {
+	auto &entry = mEntries[index];
+	uint64_t tick = std::max(entry.tick, mCurrent);
+	uint64_t delta = tick - mCurrent;
+	if (delta >= Range) {
+		// Too far away, park it in the last level, it will be reinserted when cascaded
+		tick = mCurrent + Range - 1;
+		delta = Range - 1;
+	}
+
+	int level = 0;
+	while (level < LevelsCount - 1 && delta >= (uint64_t(1) << (SlotBits * (level + 1))))
+		++level;
+
+	const int slot = int((tick >> (SlotBits * level)) & SlotMask);
+	entry.level = uint8_t(level);
+	entry.slot = uint8_t(slot);
+	entry.prev = -1;
+	entry.next = mSlots[level][slot];
+	if (entry.next >= 0)
+		mEntries[entry.next].prev = index;
+
+	mSlots[level][slot] = index;
+	mOccupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::unlink(int32_t index) {
+	auto &entry = mEntries[index];
+	if (entry.prev >= 0)
+		mEntries[entry.prev].next = entry.next;
+	else
+		mSlots[entry.level][entry.slot] = entry.next;
+
+	if (entry.next >= 0)
+		mEntries[entry.next].prev = entry.prev;
+
+	if (mSlots[entry.level][entry.slot] < 0)
+		mOccupied[entry.level] &= ~(uint64_t(1) << entry.slot);
+
+	entry.prev = entry.next = -1;
+}
+
+void TimerWheel::release(int32_t index) {
+	auto &entry = mEntries[index];
+	entry.func = nullptr;
+	entry.pending = false;
+	if (++entry.generation == 0)
+		entry.generation = 1;
+
+	entry.next = mFree;
+	mFree = index;
+	--mCount;
+}
+
+void TimerWheel::cascade(int level, int slot) {
+	int32_t index = mSlots[level][slot];
+	mSlots[level][slot] = -1;
+	mOccupied[level] &= ~(uint64_t(1) << slot);
+	while (index >= 0) {
+		int32_t next = mEntries[index].next;
+		link(index);
+		index = next;
+	}
+}
+
+} // namespace rtc::impl
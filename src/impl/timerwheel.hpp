@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_TIMER_WHEEL_H
+#define RTC_IMPL_TIMER_WHEEL_H
+
+#include "common.hpp"
+#include "task.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace rtc::impl {
+
+// Hierarchical timer wheel with O(1) insertion and cancellation. Timers are stored in a slab and
+// linked in per-slot lists, so they don't need to be allocated individually. The wheel has a
+// resolution of 1ms and covers about 4.6 hours, timers further away are parked in the last level
+// and reinserted as it turns. It is not thread-safe, the owner must synchronize accesses.
+class TimerWheel final {
+public:
+	using clock = std::chrono::steady_clock;
+	using id_t = uint64_t; // 0 is never a valid id
+
+	TimerWheel(clock::time_point start = clock::now());
+	~TimerWheel() = default;
+
+	id_t add(clock::time_point time, Task func);
+	bool cancel(id_t id); // true if the timer was pending
+	void clear();
+
+	// Move the functions of expired timers to expired, in expiration order
+	void advance(clock::time_point now, std::deque<Task> &expired);
+
+	// Lower bound of the next expiration time, if any timer is pending
+	optional<clock::time_point> next() const;
+
+	bool empty() const { return mCount == 0; }
+	size_t size() const { return mCount; }
+
+private:
+	static constexpr auto Resolution = std::chrono::milliseconds(1);
+	static constexpr int SlotBits = 6;
+	static constexpr int SlotsCount = 1 << SlotBits;
+	static constexpr uint64_t SlotMask = SlotsCount - 1;
+	static constexpr int LevelsCount = 4;
+	static constexpr uint64_t Range = uint64_t(1) << (SlotBits * LevelsCount); // in ticks
+
+	struct Entry {
+		uint64_t tick = 0; // expiration tick
+		Task func;
+		uint32_t generation = 1;
+		int32_t prev = -1;
+		int32_t next = -1;
+		uint8_t level = 0;
+		uint8_t slot = 0;
+		bool pending = false;
+	};
+
+	void link(int32_t index);
+	void unlink(int32_t index);
+	void release(int32_t index);
+	void cascade(int level, int slot);
+
+	const clock::time_point mStart;
+	uint64_t mCurrent = 0; // next tick to process
+	size_t mCount = 0;
+
+	std::vector<Entry> mEntries;
+	int32_t mFree = -1; // head of the free list, linked with next
+	std::array<std::array<int32_t, SlotsCount>, LevelsCount> mSlots;
+	std::array<uint64_t, LevelsCount> mOccupied = {}; // bitmap of non-empty slots per level
+};
+
+} // namespace rtc::impl
+
+#endif
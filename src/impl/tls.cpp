@@ -7,6 +7,8 @@
  */
 
 #include "tls.hpp"
+#include "internals.hpp"
+#include "memoryhooks.hpp"
 
 #include <fstream>
 #include <stdexcept>
@@ -150,6 +152,20 @@ std::shared_ptr<mbedtls_x509_crt> new_x509_crt() {
 
 #else // OPENSSL
 
+namespace {
+
+using rtc::impl::MemoryHooks;
+
+void *openssl_malloc(size_t size, const char *, int) { return MemoryHooks::Allocate(size); }
+
+void *openssl_realloc(void *ptr, size_t size, const char *, int) {
+	return MemoryHooks::Reallocate(ptr, size);
+}
+
+void openssl_free(void *ptr, const char *, int) { MemoryHooks::Free(ptr); }
+
+} // namespace
+
 namespace rtc::openssl {
 
 void init() {
@@ -158,6 +174,14 @@ void init() {
 
 	std::lock_guard lock(mutex);
 	if (!std::exchange(done, true)) {
+		// Memory functions can only be changed before OpenSSL allocates anything
+		if (MemoryHooks::IsSet() &&
+		    !CRYPTO_set_mem_functions(openssl_malloc, openssl_realloc, openssl_free)) {
+			PLOG_WARNING << "Failed to set OpenSSL memory functions, OpenSSL is already in use";
+		}
+
+		MemoryHooks::Freeze();
+
 		uint64_t ssl_opts = OPENSSL_INIT_LOAD_SSL_STRINGS | OPENSSL_INIT_LOAD_CRYPTO_STRINGS;
 #ifdef OPENSSL_INIT_NO_ATEXIT
 		ssl_opts |= OPENSSL_INIT_NO_ATEXIT;
@@ -72,7 +72,9 @@ std::shared_ptr<mbedtls_x509_crt> new_x509_crt();
 
 #include <openssl/bio.h>
 #include <openssl/err.h>
+#include <openssl/kdf.h>
 #include <openssl/pem.h>
+#include <openssl/rand.h>
 #include <openssl/x509.h>
 
 #ifndef BIO_EOF
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "tlssessioncache.hpp"
+
+namespace rtc::impl {
+
+TlsSessionCache &TlsSessionCache::Instance() {
+	static TlsSessionCache *instance = new TlsSessionCache;
+	return *instance;
+}
+
+TlsSessionCache::TlsSessionCache() {}
+
+TlsSessionCache::~TlsSessionCache() {}
+
+optional<binary> TlsSessionCache::retrieve(const string &key) {
+	std::lock_guard lock(mMutex);
+	auto it = mIndex.find(key);
+	if (it == mIndex.end()) {
+		++mMisses;
+		return nullopt;
+	}
+
+	++mHits;
+	mEntries.splice(mEntries.begin(), mEntries, it->second);
+	return it->second->second;
+}
+
+void TlsSessionCache::store(const string &key, binary session) {
+	std::lock_guard lock(mMutex);
+	if (auto it = mIndex.find(key); it != mIndex.end()) {
+		it->second->second = std::move(session);
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		return;
+	}
+
+	mEntries.emplace_front(key, std::move(session));
+	mIndex.emplace(key, mEntries.begin());
+
+	if (mEntries.size() > MaxEntriesCount) {
+		mIndex.erase(mEntries.back().first);
+		mEntries.pop_back();
+	}
+}
+
+void TlsSessionCache::erase(const string &key) {
+	std::lock_guard lock(mMutex);
+	if (auto it = mIndex.find(key); it != mIndex.end()) {
+		mEntries.erase(it->second);
+		mIndex.erase(it);
+	}
+}
+
+void TlsSessionCache::clear() {
+	std::lock_guard lock(mMutex);
+	mIndex.clear();
+	mEntries.clear();
+}
+
+size_t TlsSessionCache::hits() const { return mHits.load(); }
+
+size_t TlsSessionCache::misses() const { return mMisses.load(); }
+
+size_t TlsSessionCache::resumed() const { return mResumed.load(); }
+
+void TlsSessionCache::countResumed() { ++mResumed; }
+
+} // namespace rtc::impl
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_TLS_SESSION_CACHE_H
+#define RTC_IMPL_TLS_SESSION_CACHE_H
+
+#include "common.hpp"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace rtc::impl {
+
+// Client-side cache of serialized TLS and DTLS sessions, keyed by peer, so that reconnecting
+// clients can resume sessions instead of performing full handshakes. Least recently used entries
+// are evicted.
+class TlsSessionCache final {
+public:
+	static TlsSessionCache &Instance();
+
+	TlsSessionCache(const TlsSessionCache &) = delete;
+	TlsSessionCache &operator=(const TlsSessionCache &) = delete;
+	TlsSessionCache(TlsSessionCache &&) = delete;
+	TlsSessionCache &operator=(TlsSessionCache &&) = delete;
+
+	optional<binary> retrieve(const string &key); // counts a hit or a miss
+	void store(const string &key, binary session);
+	void erase(const string &key);
+	void clear();
+
+	size_t hits() const;    // lookups which found a session
+	size_t misses() const;  // lookups which found nothing
+	size_t resumed() const; // handshakes which actually resumed a session
+	void countResumed();
+
+private:
+	TlsSessionCache();
+	~TlsSessionCache();
+
+	static constexpr size_t MaxEntriesCount = 256;
+
+	using Entry = std::pair<string, binary>;
+	std::list<Entry> mEntries; // most recently used first
+	std::unordered_map<string, std::list<Entry>::iterator> mIndex;
+	mutable std::mutex mMutex;
+
+	std::atomic<size_t> mHits = 0;
+	std::atomic<size_t> mMisses = 0;
+	std::atomic<size_t> mResumed = 0;
+};
+
+} // namespace rtc::impl
+
+#endif
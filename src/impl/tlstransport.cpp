@@ -7,13 +7,15 @@
  */
 
 #include "tlstransport.hpp"
-#include "httpproxytransport.hpp"
+#include "proxytransport.hpp"
 #include "tcptransport.hpp"
 #include "threadpool.hpp"
+#include "tlssessioncache.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
 
 #include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <cstring>
 #include <exception>
@@ -28,10 +30,28 @@ void TlsTransport::enqueueRecv() {
 
 	if (auto shared_this = weak_from_this().lock()) {
 		++mPendingRecvCount;
-		ThreadPool::Instance().enqueue(&TlsTransport::doRecv, std::move(shared_this));
+
+		// Like for DTLS, the CPU-heavy handshake must not delay established connections
+		if (state() == State::Connected)
+			ThreadPool::Instance().post(&TlsTransport::doRecv, std::move(shared_this));
+		else if (mHandshakeExecutor)
+			mHandshakeExecutor->post([locked = std::move(shared_this)]() { locked->doRecv(); });
+		else
+			ThreadPool::Control().post(&TlsTransport::doRecv, std::move(shared_this));
 	}
 }
 
+void TlsTransport::setHandshakeExecutor(shared_ptr<Executor> executor) {
+	mHandshakeExecutor = std::move(executor);
+}
+
+string TlsTransport::sessionCacheKey() const {
+	// Sessions established without verification, or verified against other CAs, must not be resumed
+	// by a verified transport
+	string trust = mVerified ? "verified:" + mTrust : "unverified";
+	return trust + '@' + mHost.value_or("") + ':' + mService;
+}
+
 #if USE_GNUTLS
 
 namespace {
@@ -49,6 +69,18 @@ gnutls_certificate_credentials_t default_certificate_credentials() {
 	return *creds;
 }
 
+// Process-wide key so that session tickets are valid across server transports
+const gnutls_datum_t *session_ticket_key() {
+	static std::mutex mutex;
+	static gnutls_datum_t key = {};
+
+	std::lock_guard lock(mutex);
+	if (!key.data)
+		gnutls::check(gnutls_session_ticket_key_generate(&key));
+
+	return &key;
+}
+
 } // namespace
 
 void TlsTransport::Init() {
@@ -59,12 +91,15 @@ void TlsTransport::Cleanup() {
 	// Nothing to do
 }
 
-TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>> lower,
+bool TlsTransport::IsKernelTlsSupported() { return false; }
+
+TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>> lower,
                            optional<string> host, certificate_ptr certificate,
                            state_callback callback)
     : Transport(std::visit([](auto l) { return std::static_pointer_cast<Transport>(l); }, lower),
                 std::move(callback)),
-      mHost(std::move(host)), mIsClient(std::visit([](auto l) { return l->isActive(); }, lower)),
+      mHost(std::move(host)), mService(std::visit([](auto l) { return l->service(); }, lower)),
+      mIsClient(std::visit([](auto l) { return l->isActive(); }, lower)),
       mIncomingQueue(RECV_QUEUE_LIMIT, message_size_func) {
 
 	PLOG_DEBUG << "Initializing TLS transport (GnuTLS)";
@@ -87,6 +122,10 @@ TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProx
 			gnutls_server_name_set(mSession, GNUTLS_NAME_DNS, mHost->data(), mHost->size());
 		}
 
+		if (!mIsClient)
+			gnutls::check(gnutls_session_ticket_enable_server(mSession, session_ticket_key()),
+			              "Failed to enable TLS session tickets");
+
 		gnutls_session_set_ptr(mSession, this);
 		gnutls_transport_set_ptr(mSession, this);
 		gnutls_transport_set_push_function(mSession, WriteCallback);
@@ -110,6 +149,7 @@ void TlsTransport::start() {
 	PLOG_DEBUG << "Starting TLS transport";
 	registerIncoming();
 	changeState(State::Connecting);
+	restoreSession();
 	enqueueRecv(); // to initiate the handshake
 }
 
@@ -182,6 +222,11 @@ void TlsTransport::doRecv() {
 			} while (!gnutls::check(ret, "Handshake failed")); // Re-call on non-fatal error
 
 			PLOG_INFO << "TLS handshake finished";
+			if (gnutls_session_is_resumed(mSession)) {
+				PLOG_DEBUG << "TLS session resumed";
+				TlsSessionCache::Instance().countResumed();
+			}
+			storeSession();
 			changeState(State::Connected);
 			postHandshake();
 		}
@@ -207,6 +252,7 @@ void TlsTransport::doRecv() {
 					}
 					auto *b = reinterpret_cast<byte *>(buffer);
 					recv(make_message(b, b + ret));
+					storeSession(); // a TLS 1.3 ticket might have been received
 				}
 			}
 		}
@@ -226,6 +272,64 @@ void TlsTransport::doRecv() {
 	}
 }
 
+void TlsTransport::enableKernelTls() {
+	PLOG_WARNING << "Kernel TLS is not supported with GnuTLS";
+}
+
+void TlsTransport::setAlpnProtocols(std::vector<string> protocols) {
+	std::vector<gnutls_datum_t> datums;
+	for (auto &protocol : protocols)
+		datums.push_back({reinterpret_cast<unsigned char *>(protocol.data()),
+		                  static_cast<unsigned int>(protocol.size())});
+
+	// The protocols are copied
+	gnutls::check(gnutls_alpn_set_protocols(mSession, datums.data(),
+	                                        static_cast<unsigned int>(datums.size()), 0),
+	              "Failed to set ALPN protocols");
+}
+
+optional<string> TlsTransport::alpnProtocol() const {
+	gnutls_datum_t datum;
+	if (gnutls_alpn_get_selected_protocol(mSession, &datum) != GNUTLS_E_SUCCESS)
+		return nullopt;
+
+	return string(reinterpret_cast<const char *>(datum.data), datum.size);
+}
+
+void TlsTransport::restoreSession() {
+	if (!mIsClient || !mHost)
+		return;
+
+	auto key = sessionCacheKey();
+	if (auto session = TlsSessionCache::Instance().retrieve(key)) {
+		PLOG_DEBUG << "Resuming TLS session with " << *mHost;
+		if (gnutls_session_set_data(mSession, session->data(), session->size()) !=
+		    GNUTLS_E_SUCCESS) {
+			PLOG_WARNING << "Failed to restore TLS session";
+			TlsSessionCache::Instance().erase(key);
+		}
+	}
+}
+
+void TlsTransport::storeSession() {
+	if (!mIsClient || !mHost || mSessionStored)
+		return;
+
+	// With TLS 1.3, resumption data is only available after a session ticket has been received
+	if (gnutls_protocol_get_version(mSession) == GNUTLS_TLS1_3 &&
+	    !(gnutls_session_get_flags(mSession) & GNUTLS_SFLAGS_SESSION_TICKET))
+		return;
+
+	gnutls_datum_t data = {};
+	if (gnutls_session_get_data2(mSession, &data) != GNUTLS_E_SUCCESS)
+		return;
+
+	auto *b = reinterpret_cast<const byte *>(data.data);
+	TlsSessionCache::Instance().store(sessionCacheKey(), binary(b, b + data.size));
+	gnutls_free(data.data);
+	mSessionStored = true;
+}
+
 ssize_t TlsTransport::WriteCallback(gnutls_transport_ptr_t ptr, const void *data, size_t len) {
 	TlsTransport *t = static_cast<TlsTransport *>(ptr);
 	try {
@@ -305,6 +409,51 @@ int TlsTransport::TimeoutCallback(gnutls_transport_ptr_t ptr, unsigned int /* ms
 
 #elif USE_MBEDTLS
 
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+#define RTC_MBEDTLS_SESSION_TICKETS 1
+#include "mbedtls/ssl_ticket.h"
+
+namespace {
+
+// Process-wide ticket context so that session tickets are valid across server transports
+struct TicketContext {
+	TicketContext() {
+		mbedtls_entropy_init(&entropy);
+		mbedtls_ctr_drbg_init(&drbg);
+		mbedtls_ssl_ticket_init(&ticket);
+		mbedtls::check(mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0));
+		mbedtls::check(mbedtls_ssl_ticket_setup(&ticket, mbedtls_ctr_drbg_random, &drbg,
+		                                        MBEDTLS_CIPHER_AES_256_GCM, 86400));
+	}
+
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context drbg;
+	mbedtls_ssl_ticket_context ticket;
+	std::mutex mutex; // the ticket context might not be thread-safe
+};
+
+TicketContext &ticket_context() {
+	static TicketContext *context = new TicketContext;
+	return *context;
+}
+
+int ticket_write(void *p, const mbedtls_ssl_session *session, unsigned char *start,
+                 const unsigned char *end, size_t *tlen, uint32_t *lifetime) {
+	auto *context = static_cast<TicketContext *>(p);
+	std::lock_guard lock(context->mutex);
+	return mbedtls_ssl_ticket_write(&context->ticket, session, start, end, tlen, lifetime);
+}
+
+int ticket_parse(void *p, mbedtls_ssl_session *session, unsigned char *buf, size_t len) {
+	auto *context = static_cast<TicketContext *>(p);
+	std::lock_guard lock(context->mutex);
+	return mbedtls_ssl_ticket_parse(&context->ticket, session, buf, len);
+}
+
+} // namespace
+
+#endif
+
 void TlsTransport::Init() {
 	// Nothing to do
 }
@@ -313,12 +462,15 @@ void TlsTransport::Cleanup() {
 	// Nothing to do
 }
 
-TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>> lower,
+bool TlsTransport::IsKernelTlsSupported() { return false; }
+
+TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>> lower,
                            optional<string> host, certificate_ptr certificate,
                            state_callback callback)
     : Transport(std::visit([](auto l) { return std::static_pointer_cast<Transport>(l); }, lower),
                 std::move(callback)),
-      mHost(std::move(host)), mIsClient(std::visit([](auto l) { return l->isActive(); }, lower)),
+      mHost(std::move(host)), mService(std::visit([](auto l) { return l->service(); }, lower)),
+      mIsClient(std::visit([](auto l) { return l->isActive(); }, lower)),
       mIncomingQueue(RECV_QUEUE_LIMIT, message_size_func) {
 
 	PLOG_DEBUG << "Initializing TLS transport (MbedTLS)";
@@ -346,6 +498,12 @@ TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProx
 			mbedtls::check(mbedtls_ssl_conf_own_cert(&mConf, crt.get(), pk.get()));
 		}
 
+#if RTC_MBEDTLS_SESSION_TICKETS
+		if (!mIsClient)
+			mbedtls_ssl_conf_session_tickets_cb(&mConf, ticket_write, ticket_parse,
+			                                    &ticket_context());
+#endif
+
 		if (mIsClient && mHost) {
 			PLOG_VERBOSE << "Server Name Indication: " << *mHost;
 			mbedtls_ssl_set_hostname(&mSsl, mHost->c_str());
@@ -377,6 +535,7 @@ void TlsTransport::start() {
 	PLOG_DEBUG << "Starting TLS transport";
 	registerIncoming();
 	changeState(State::Connecting);
+	restoreSession();
 	enqueueRecv(); // to initiate the handshake
 }
 
@@ -457,6 +616,7 @@ void TlsTransport::doRecv() {
 
 				if (mbedtls::check(ret, "Handshake failed")) {
 					PLOG_INFO << "TLS handshake finished";
+					storeSession();
 					changeState(State::Connected);
 					postHandshake();
 					break;
@@ -506,6 +666,81 @@ void TlsTransport::doRecv() {
 	}
 }
 
+void TlsTransport::enableKernelTls() {
+	PLOG_WARNING << "Kernel TLS is not supported with Mbed TLS";
+}
+
+void TlsTransport::setAlpnProtocols(std::vector<string> protocols) {
+	std::lock_guard lock(mSslMutex);
+	mAlpnProtocols = std::move(protocols);
+	mAlpnList.clear();
+	for (const auto &protocol : mAlpnProtocols)
+		mAlpnList.push_back(protocol.c_str());
+
+	mAlpnList.push_back(nullptr);
+
+	// The list is not copied, the context refers to the configuration
+	mbedtls::check(mbedtls_ssl_conf_alpn_protocols(&mConf, mAlpnList.data()));
+}
+
+optional<string> TlsTransport::alpnProtocol() const {
+	std::lock_guard lock(mSslMutex);
+	if (const char *protocol = mbedtls_ssl_get_alpn_protocol(&mSsl))
+		return string(protocol);
+
+	return nullopt;
+}
+
+void TlsTransport::restoreSession() {
+	if (!mIsClient || !mHost)
+		return;
+
+	auto key = sessionCacheKey();
+	if (auto data = TlsSessionCache::Instance().retrieve(key)) {
+		PLOG_DEBUG << "Resuming TLS session with " << *mHost;
+		mbedtls_ssl_session session;
+		mbedtls_ssl_session_init(&session);
+		int ret = mbedtls_ssl_session_load(
+		    &session, reinterpret_cast<const unsigned char *>(data->data()), data->size());
+		if (ret == 0) {
+			std::lock_guard lock(mSslMutex);
+			ret = mbedtls_ssl_set_session(&mSsl, &session);
+		}
+		mbedtls_ssl_session_free(&session);
+
+		if (ret != 0) {
+			PLOG_WARNING << "Failed to restore TLS session";
+			TlsSessionCache::Instance().erase(key);
+		}
+	}
+}
+
+void TlsTransport::storeSession() {
+	if (!mIsClient || !mHost)
+		return;
+
+	// Mbed TLS does not tell whether the session was resumed, so only the cache hits are counted
+	mbedtls_ssl_session session;
+	mbedtls_ssl_session_init(&session);
+	{
+		std::lock_guard lock(mSslMutex);
+		if (mbedtls_ssl_get_session(&mSsl, &session) != 0) {
+			mbedtls_ssl_session_free(&session);
+			return;
+		}
+	}
+
+	size_t len = 0;
+	mbedtls_ssl_session_save(&session, NULL, 0, &len); // get the required length
+	binary data(len);
+	if (len > 0 && mbedtls_ssl_session_save(&session, reinterpret_cast<unsigned char *>(data.data()),
+	                                        data.size(), &len) == 0) {
+		data.resize(len);
+		TlsSessionCache::Instance().store(sessionCacheKey(), std::move(data));
+	}
+	mbedtls_ssl_session_free(&session);
+}
+
 int TlsTransport::WriteCallback(void *ctx, const unsigned char *buf, size_t len) {
 	auto *t = static_cast<TlsTransport *>(ctx);
 	auto *b = reinterpret_cast<const byte *>(buf);
@@ -568,12 +803,86 @@ void TlsTransport::Cleanup() {
 	// Nothing to do
 }
 
-TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>> lower,
+namespace {
+
+// Process-wide keys so that session tickets are valid across server transports
+const unsigned char *session_ticket_keys() {
+	static unsigned char keys[80]; // name, HMAC secret, and AES key
+	static std::once_flag once;
+	std::call_once(once, []() {
+		openssl::check(RAND_bytes(keys, sizeof(keys)), "Failed to generate TLS ticket keys");
+	});
+	return keys;
+}
+
+const unsigned char SessionIdContext[] = "libdatachannel";
+
+#ifndef NO_KTLS
+// HKDF-Expand-Label() from RFC 8446 with an empty context
+bool hkdf_expand_label(const EVP_MD *md, const binary &secret, const string &label,
+                       unsigned char *out, size_t len) {
+	const string fullLabel = "tls13 " + label;
+	std::vector<unsigned char> info;
+	info.push_back(static_cast<unsigned char>(len >> 8));
+	info.push_back(static_cast<unsigned char>(len & 0xFF));
+	info.push_back(static_cast<unsigned char>(fullLabel.size()));
+	info.insert(info.end(), fullLabel.begin(), fullLabel.end());
+	info.push_back(0); // empty context
+
+	auto ctx = unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)>(
+	    EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL), EVP_PKEY_CTX_free);
+	return ctx && EVP_PKEY_derive_init(ctx.get()) > 0 &&
+	       EVP_PKEY_CTX_hkdf_mode(ctx.get(), EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0 &&
+	       EVP_PKEY_CTX_set_hkdf_md(ctx.get(), md) > 0 &&
+	       EVP_PKEY_CTX_set1_hkdf_key(ctx.get(),
+	                                  reinterpret_cast<const unsigned char *>(secret.data()),
+	                                  int(secret.size())) > 0 &&
+	       EVP_PKEY_CTX_add1_hkdf_info(ctx.get(), info.data(), int(info.size())) > 0 &&
+	       EVP_PKEY_derive(ctx.get(), out, &len) > 0;
+}
+
+// Fill a kernel crypto info structure, Linux expects the IV split into salt and explicit IV
+template <typename T>
+bool make_crypto_info(T &info, uint16_t cipherType, const EVP_MD *md, const binary &secret,
+                      uint64_t seq) {
+	std::memset(&info, 0, sizeof(info));
+	info.info.version = TLS_1_3_VERSION;
+	info.info.cipher_type = cipherType;
+
+	unsigned char iv[sizeof(info.salt) + sizeof(info.iv)];
+	if (!hkdf_expand_label(md, secret, "key", info.key, sizeof(info.key)) ||
+	    !hkdf_expand_label(md, secret, "iv", iv, sizeof(iv)))
+		return false;
+
+	std::memcpy(info.salt, iv, sizeof(info.salt));
+	std::memcpy(info.iv, iv + sizeof(info.salt), sizeof(info.iv));
+	OPENSSL_cleanse(iv, sizeof(iv));
+
+	for (int i = int(sizeof(info.rec_seq)) - 1; i >= 0; --i) { // big-endian
+		info.rec_seq[i] = static_cast<unsigned char>(seq & 0xFF);
+		seq >>= 8;
+	}
+	return true;
+}
+#endif
+
+} // namespace
+
+bool TlsTransport::IsKernelTlsSupported() {
+#ifndef NO_KTLS
+	return true;
+#else
+	return false;
+#endif
+}
+
+TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>> lower,
                            optional<string> host, certificate_ptr certificate,
                            state_callback callback)
     : Transport(std::visit([](auto l) { return std::static_pointer_cast<Transport>(l); }, lower),
                 std::move(callback)),
-      mHost(std::move(host)), mIsClient(std::visit([](auto l) { return l->isActive(); }, lower)),
+      mHost(std::move(host)), mService(std::visit([](auto l) { return l->service(); }, lower)),
+      mIsClient(std::visit([](auto l) { return l->isActive(); }, lower)),
       mIncomingQueue(RECV_QUEUE_LIMIT, message_size_func) {
 
 	PLOG_DEBUG << "Initializing TLS transport (OpenSSL)";
@@ -615,11 +924,28 @@ TlsTransport::TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProx
 		SSL_CTX_set_info_callback(mCtx, InfoCallback);
 		SSL_CTX_set_verify(mCtx, SSL_VERIFY_NONE, NULL);
 
+		if (mIsClient) {
+			// Sessions are stored in the global cache as they arrive, including TLS 1.3 tickets
+			SSL_CTX_set_session_cache_mode(mCtx, SSL_SESS_CACHE_CLIENT |
+			                                         SSL_SESS_CACHE_NO_INTERNAL_STORE);
+			SSL_CTX_sess_set_new_cb(mCtx, NewSessionCallback);
+		} else {
+			openssl::check(SSL_CTX_set_tlsext_ticket_keys(
+			                   mCtx, const_cast<unsigned char *>(session_ticket_keys()), 80),
+			               "Failed to set TLS ticket keys");
+			openssl::check(SSL_CTX_set_session_id_context(mCtx, SessionIdContext,
+			                                              sizeof(SessionIdContext) - 1),
+			               "Failed to set TLS session id context");
+		}
+
 		if (!(mSsl = SSL_new(mCtx)))
 			throw std::runtime_error("Failed to create SSL instance");
 
 		SSL_set_ex_data(mSsl, TransportExIndex, this);
 
+		if (auto tcp = std::get_if<shared_ptr<TcpTransport>>(&lower))
+			mTcpTransport = *tcp;
+
 		if (mIsClient && mHost) {
 			SSL_set_hostflags(mSsl, 0);
 			openssl::check(SSL_set1_host(mSsl, mHost->c_str()), "Failed to set SSL host");
@@ -661,6 +987,7 @@ void TlsTransport::start() {
 	PLOG_DEBUG << "Starting TLS transport";
 	registerIncoming();
 	changeState(State::Connecting);
+	restoreSession();
 
 	// Initiate the handshake
 	int ret, err;
@@ -694,6 +1021,9 @@ bool TlsTransport::send(message_ptr message) {
 	bool result;
 	{
 		std::lock_guard lock(mSslMutex);
+		if (mKernelTlsEnabled || (mKernelTlsRequested && tryKernelTls()))
+			return outgoing(message); // the kernel will encrypt
+
 		int ret = SSL_write(mSsl, message->data(), int(message->size()));
 		err = SSL_get_error(mSsl, ret);
 		result = flushOutput();
@@ -758,6 +1088,10 @@ void TlsTransport::doRecv() {
 
 				if (openssl::check_error(err, "Handshake failed")) {
 					PLOG_INFO << "TLS handshake finished";
+					if (SSL_session_reused(mSsl)) {
+						PLOG_DEBUG << "TLS session resumed";
+						TlsSessionCache::Instance().countResumed();
+					}
 					changeState(State::Connected);
 					postHandshake();
 				}
@@ -790,7 +1124,14 @@ void TlsTransport::doRecv() {
 		}
 
 		std::lock_guard lock(mSslMutex);
-		SSL_shutdown(mSsl);
+		if (mKernelTlsEnabled) {
+			// Send close_notify through the kernel instead
+			SSL_set_quiet_shutdown(mSsl, 1);
+			SSL_shutdown(mSsl);
+			mTcpTransport->sendKernelTlsAlert(1, 0); // warning, close_notify
+		} else {
+			SSL_shutdown(mSsl);
+		}
 
 	} catch (const std::exception &e) {
 		PLOG_ERROR << "TLS recv: " << e.what();
@@ -812,12 +1153,169 @@ bool TlsTransport::flushOutput() {
 	const size_t bufferSize = 4096;
 	byte buffer[bufferSize];
 	int len;
-	while ((len = BIO_read(mOutBio, buffer, bufferSize)) > 0)
+	while ((len = BIO_read(mOutBio, buffer, bufferSize)) > 0) {
+		// The kernel owns the record sequence now, records encrypted by OpenSSL can't be sent. This
+		// happens for instance if the peer requests a key update, which the kernel can't follow.
+		if (mKernelTlsEnabled)
+			throw std::runtime_error("Unexpected TLS output after kernel offload, size=" +
+			                         std::to_string(len));
+
 		result = outgoing(make_message(buffer, buffer + len));
+	}
 
 	return result;
 }
 
+void TlsTransport::enableKernelTls() {
+#ifndef NO_KTLS
+	if (!mTcpTransport) {
+		PLOG_WARNING << "Kernel TLS requires a direct TCP connection, ignoring it";
+		return;
+	}
+
+	std::lock_guard lock(mSslMutex);
+	mKernelTlsRequested = true;
+	SSL_CTX_set_keylog_callback(mCtx, KeylogCallback);
+	SSL_set_msg_callback(mSsl, MessageCallback);
+#else
+	PLOG_WARNING << "Kernel TLS is not supported on this platform";
+#endif
+}
+
+void TlsTransport::setAlpnProtocols(std::vector<string> protocols) {
+	binary wire; // length-prefixed protocols
+	for (const auto &protocol : protocols) {
+		if (protocol.empty() || protocol.size() > 255)
+			throw std::invalid_argument("Invalid ALPN protocol: " + protocol);
+
+		wire.push_back(byte(protocol.size()));
+		auto data = reinterpret_cast<const byte *>(protocol.data());
+		wire.insert(wire.end(), data, data + protocol.size());
+	}
+
+	std::lock_guard lock(mSslMutex);
+	// Unlike most OpenSSL functions, this one returns 0 on success
+	if (SSL_set_alpn_protos(mSsl, reinterpret_cast<const unsigned char *>(wire.data()),
+	                        static_cast<unsigned int>(wire.size())) != 0)
+		throw std::runtime_error("Failed to set ALPN protocols");
+}
+
+optional<string> TlsTransport::alpnProtocol() const {
+	const unsigned char *data = nullptr;
+	unsigned int length = 0;
+	std::lock_guard lock(mSslMutex);
+	SSL_get0_alpn_selected(mSsl, &data, &length);
+	if (!data || length == 0)
+		return nullopt;
+
+	return string(reinterpret_cast<const char *>(data), length);
+}
+
+bool TlsTransport::tryKernelTls() {
+	// Requires mSslMutex to be locked
+#ifndef NO_KTLS
+	auto giveUp = [this](const string &reason) {
+		PLOG_DEBUG << "Not using kernel TLS: " << reason;
+		mKernelTlsRequested = false;
+		OPENSSL_cleanse(mWriteSecret.data(), mWriteSecret.size());
+		mWriteSecret.clear();
+		return false;
+	};
+
+	if (SSL_version(mSsl) != TLS1_3_VERSION)
+		return giveUp("TLS version is not 1.3");
+
+	if (mWriteSecret.empty())
+		return giveUp("traffic secret is unavailable");
+
+	flushOutput(); // in case something is pending
+
+	const SSL_CIPHER *cipher = SSL_get_current_cipher(mSsl);
+	const EVP_MD *md = cipher ? SSL_CIPHER_get_handshake_digest(cipher) : nullptr;
+	if (!md)
+		return giveUp("unknown cipher");
+
+	try {
+		bool ok, enabled = false;
+		switch (SSL_CIPHER_get_id(cipher)) {
+		case TLS1_3_CK_AES_128_GCM_SHA256: {
+			tls12_crypto_info_aes_gcm_128 info;
+			ok = make_crypto_info(info, TLS_CIPHER_AES_GCM_128, md, mWriteSecret,
+			                      mWriteRecordsCount);
+			enabled = ok && mTcpTransport->enableKernelTlsTx(&info, sizeof(info));
+			OPENSSL_cleanse(&info, sizeof(info));
+			break;
+		}
+		case TLS1_3_CK_AES_256_GCM_SHA384: {
+			tls12_crypto_info_aes_gcm_256 info;
+			ok = make_crypto_info(info, TLS_CIPHER_AES_GCM_256, md, mWriteSecret,
+			                      mWriteRecordsCount);
+			enabled = ok && mTcpTransport->enableKernelTlsTx(&info, sizeof(info));
+			OPENSSL_cleanse(&info, sizeof(info));
+			break;
+		}
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+		case TLS1_3_CK_CHACHA20_POLY1305_SHA256: {
+			tls12_crypto_info_chacha20_poly1305 info;
+			ok = make_crypto_info(info, TLS_CIPHER_CHACHA20_POLY1305, md, mWriteSecret,
+			                      mWriteRecordsCount);
+			enabled = ok && mTcpTransport->enableKernelTlsTx(&info, sizeof(info));
+			OPENSSL_cleanse(&info, sizeof(info));
+			break;
+		}
+#endif
+		default:
+			return giveUp(string("unsupported cipher ") + SSL_CIPHER_get_name(cipher));
+		}
+
+		if (!ok)
+			return giveUp("key derivation failed");
+
+		if (!enabled)
+			return false; // ciphertext is still queued, retry on next send
+
+	} catch (const std::exception &e) {
+		PLOG_WARNING << e.what();
+		return giveUp("kernel TLS is unavailable");
+	}
+
+	PLOG_INFO << "TLS encryption offloaded to the kernel";
+	OPENSSL_cleanse(mWriteSecret.data(), mWriteSecret.size());
+	mWriteSecret.clear();
+	mKernelTlsRequested = false;
+	mKernelTlsEnabled = true;
+	return true;
+#else
+	mKernelTlsRequested = false;
+	return false;
+#endif
+}
+
+void TlsTransport::restoreSession() {
+	if (!mIsClient || !mHost)
+		return;
+
+	auto key = sessionCacheKey();
+	if (auto data = TlsSessionCache::Instance().retrieve(key)) {
+		PLOG_DEBUG << "Resuming TLS session with " << *mHost;
+		auto p = reinterpret_cast<const unsigned char *>(data->data());
+		SSL_SESSION *session = d2i_SSL_SESSION(NULL, &p, long(data->size()));
+		if (session && SSL_SESSION_is_resumable(session)) {
+			std::lock_guard lock(mSslMutex);
+			SSL_set_session(mSsl, session); // increments the reference count
+		} else {
+			PLOG_WARNING << "Failed to restore TLS session";
+			TlsSessionCache::Instance().erase(key);
+		}
+		if (session)
+			SSL_SESSION_free(session);
+	}
+}
+
+void TlsTransport::storeSession() {
+	// Sessions are stored from NewSessionCallback()
+}
+
 void TlsTransport::InfoCallback(const SSL *ssl, int where, int ret) {
 	TlsTransport *t =
 	    static_cast<TlsTransport *>(SSL_get_ex_data(ssl, TlsTransport::TransportExIndex));
@@ -830,6 +1328,64 @@ void TlsTransport::InfoCallback(const SSL *ssl, int where, int ret) {
 	}
 }
 
+void TlsTransport::KeylogCallback(const SSL *ssl, const char *line) {
+	TlsTransport *t =
+	    static_cast<TlsTransport *>(SSL_get_ex_data(ssl, TlsTransport::TransportExIndex));
+
+	// Format is "<label> <client random> <secret>", keep only our application traffic secret
+	const string label = t->mIsClient ? "CLIENT_TRAFFIC_SECRET_0 " : "SERVER_TRAFFIC_SECRET_0 ";
+	if (std::strncmp(line, label.c_str(), label.size()) != 0)
+		return;
+
+	const char *hex = std::strrchr(line, ' ') + 1;
+	binary secret;
+	for (size_t i = 0; std::isxdigit(hex[i]) && std::isxdigit(hex[i + 1]); i += 2)
+		secret.push_back(byte(std::stoi(string(hex + i, 2), nullptr, 16)));
+
+	// The write key changes right after, so following records are numbered from 0
+	t->mWriteSecret = std::move(secret);
+	t->mWriteRecordsCount = 0;
+}
+
+void TlsTransport::MessageCallback(int writeP, [[maybe_unused]] int version, int contentType,
+                                   const void *buf, size_t len, SSL *ssl,
+                                   [[maybe_unused]] void *arg) {
+	TlsTransport *t =
+	    static_cast<TlsTransport *>(SSL_get_ex_data(ssl, TlsTransport::TransportExIndex));
+
+	if (!writeP)
+		return;
+
+	if (contentType == SSL3_RT_HEADER) {
+		++t->mWriteRecordsCount;
+
+	} else if (contentType == SSL3_RT_HANDSHAKE && len > 0 &&
+	           static_cast<const unsigned char *>(buf)[0] == SSL3_MT_KEY_UPDATE) {
+		// The secret we have is obsolete
+		OPENSSL_cleanse(t->mWriteSecret.data(), t->mWriteSecret.size());
+		t->mWriteSecret.clear();
+	}
+}
+
+int TlsTransport::NewSessionCallback(SSL *ssl, SSL_SESSION *session) {
+	TlsTransport *t =
+	    static_cast<TlsTransport *>(SSL_get_ex_data(ssl, TlsTransport::TransportExIndex));
+
+	if (!t->mHost)
+		return 0;
+
+	int len = i2d_SSL_SESSION(session, NULL);
+	if (len <= 0)
+		return 0;
+
+	binary data(len);
+	auto p = reinterpret_cast<unsigned char *>(data.data());
+	if (i2d_SSL_SESSION(session, &p) == len)
+		TlsSessionCache::Instance().store(t->sessionCacheKey(), std::move(data));
+
+	return 0; // the session is not retained
+}
+
 #endif
 
 } // namespace rtc::impl
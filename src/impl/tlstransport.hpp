@@ -11,6 +11,7 @@
 
 #include "certificate.hpp"
 #include "common.hpp"
+#include "executor.hpp"
 #include "queue.hpp"
 #include "tls.hpp"
 #include "transport.hpp"
@@ -19,18 +20,20 @@
 
 #include <atomic>
 #include <thread>
+#include <vector>
 
 namespace rtc::impl {
 
 class TcpTransport;
-class HttpProxyTransport;
+class ProxyTransport;
 
 class TlsTransport : public Transport, public std::enable_shared_from_this<TlsTransport> {
 public:
 	static void Init();
 	static void Cleanup();
+	static bool IsKernelTlsSupported();
 
-	TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>> lower,
+	TlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>> lower,
 	             optional<string> host, certificate_ptr certificate, state_callback callback);
 	virtual ~TlsTransport();
 
@@ -40,6 +43,16 @@ public:
 
 	bool isClient() const { return mIsClient; }
 
+	// Offload encryption to the kernel once connected, must be called before start()
+	void enableKernelTls();
+
+	// The handshake runs on the executor instead of the control-plane pool, call before start()
+	void setHandshakeExecutor(shared_ptr<Executor> executor);
+
+	// Client-side ALPN (RFC 7301), protocols in order of preference, call before start()
+	void setAlpnProtocols(std::vector<string> protocols);
+	optional<string> alpnProtocol() const; // negotiated protocol, once connected
+
 protected:
 	virtual void incoming(message_ptr message) override;
 	virtual bool outgoing(message_ptr message) override;
@@ -48,12 +61,21 @@ protected:
 	void enqueueRecv();
 	void doRecv();
 
+	// Client-side session resumption
+	string sessionCacheKey() const;
+	void restoreSession();
+	void storeSession();
+
 	const optional<string> mHost;
+	const string mService;
 	const bool mIsClient;
+	bool mVerified = false; // set by VerifiedTlsTransport, sessions are cached separately
+	string mTrust;          // trusted CA set by VerifiedTlsTransport, part of the cache key
 
 	Queue<message_ptr> mIncomingQueue;
 	std::atomic<int> mPendingRecvCount = 0;
 	std::mutex mRecvMutex;
+	shared_ptr<Executor> mHandshakeExecutor;
 
 #if USE_GNUTLS
 	gnutls_session_t mSession;
@@ -62,6 +84,8 @@ protected:
 	size_t mIncomingMessagePosition = 0;
 	std::atomic<bool> mOutgoingResult = true;
 
+	bool mSessionStored = false;
+
 	static ssize_t WriteCallback(gnutls_transport_ptr_t ptr, const void *data, size_t len);
 	static ssize_t ReadCallback(gnutls_transport_ptr_t ptr, void *data, size_t maxlen);
 	static int TimeoutCallback(gnutls_transport_ptr_t ptr, unsigned int ms);
@@ -72,9 +96,12 @@ protected:
 	mbedtls_ssl_config mConf;
 	mbedtls_ssl_context mSsl;
 
-	std::recursive_mutex mSslMutex;
+	mutable std::recursive_mutex mSslMutex;
 	std::atomic<bool> mOutgoingResult = true;
 
+	std::vector<string> mAlpnProtocols;
+	std::vector<const char *> mAlpnList; // null-terminated, points into mAlpnProtocols
+
 	message_ptr mIncomingMessage;
 	size_t mIncomingMessagePosition = 0;
 
@@ -85,13 +112,27 @@ protected:
 	SSL_CTX *mCtx;
 	SSL *mSsl;
 	BIO *mInBio, *mOutBio;
-	std::mutex mSslMutex;
+	mutable std::mutex mSslMutex;
 
 	bool flushOutput();
 
 	static int TransportExIndex;
 
 	static void InfoCallback(const SSL *ssl, int where, int ret);
+	static int NewSessionCallback(SSL *ssl, SSL_SESSION *session);
+
+	// Kernel TLS transmission offload (TLS 1.3 only)
+	bool tryKernelTls(); // requires mSslMutex to be locked
+
+	shared_ptr<TcpTransport> mTcpTransport; // null if the lower transport is a proxy
+	bool mKernelTlsRequested = false;
+	bool mKernelTlsEnabled = false;
+	binary mWriteSecret;           // current application traffic secret for writing
+	uint64_t mWriteRecordsCount = 0; // records written with mWriteSecret
+
+	static void KeylogCallback(const SSL *ssl, const char *line);
+	static void MessageCallback(int writeP, int version, int contentType, const void *buf,
+	                            size_t len, SSL *ssl, void *arg);
 #endif
 };
 
@@ -0,0 +1,41 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "tracing.hpp"
+#include "internals.hpp"
+
+#include <memory>
+
+namespace rtc::impl {
+
+namespace {
+
+shared_ptr<TraceCallback> CurrentCallback; // accessed atomically
+
+} // namespace
+
+std::atomic<bool> Tracing::Enabled = false;
+
+void Tracing::SetCallback(TraceCallback callback) {
+	auto ptr = callback ? std::make_shared<TraceCallback>(std::move(callback)) : nullptr;
+	Enabled = bool(ptr);
+	std::atomic_store(&CurrentCallback, std::move(ptr));
+}
+
+void Tracing::Dispatch(const TraceEvent &event) {
+	// The callback is kept alive while called, even if it is replaced concurrently
+	if (auto callback = std::atomic_load(&CurrentCallback)) {
+		try {
+			(*callback)(event);
+		} catch (const std::exception &e) {
+			PLOG_WARNING << "Uncaught exception in trace callback: " << e.what();
+		}
+	}
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_TRACING_H
+#define RTC_IMPL_TRACING_H
+
+#include "common.hpp"
+#include "global.hpp" // for TracePoint
+
+#include <atomic>
+
+#ifndef RTC_USDT_PROBES
+#define RTC_USDT_PROBES 0
+#endif
+
+#if RTC_USDT_PROBES
+#include <sys/sdt.h>
+#endif
+
+namespace rtc::impl {
+
+class Tracing final {
+public:
+	static void SetCallback(TraceCallback callback);
+
+	static bool IsEnabled() { return Enabled.load(std::memory_order_relaxed); }
+
+	// On Linux, tracepoints are also exposed as the USDT probe libdatachannel:trace, with the
+	// point, the object, and the value as arguments, so they can be traced with eBPF even without
+	// callback. Without callback, the cost is a load and a predicted branch.
+	static void Trace(TracePoint point, const void *object = nullptr, uint64_t value = 0) {
+#if RTC_USDT_PROBES
+		DTRACE_PROBE3(libdatachannel, trace, int(point), object, value);
+#endif
+		if (IsEnabled())
+			Dispatch({point, object, value});
+	}
+
+private:
+	static void Dispatch(const TraceEvent &event);
+
+	static std::atomic<bool> Enabled;
+};
+
+// Traces the begin and end points around a scope
+class TraceScope final {
+public:
+	TraceScope(TracePoint begin, TracePoint end, const void *object = nullptr, uint64_t value = 0)
+	    : mEnd(end), mObject(object), mValue(value) {
+		Tracing::Trace(begin, object, value);
+	}
+	~TraceScope() { Tracing::Trace(mEnd, mObject, mValue); }
+
+	TraceScope(const TraceScope &) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+	const TracePoint mEnd;
+	const void *const mObject;
+	const uint64_t mValue;
+};
+
+} // namespace rtc::impl
+
+#endif
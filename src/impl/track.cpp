@@ -8,20 +8,29 @@
 
 #include "track.hpp"
 #include "internals.hpp"
+#include "latencyhistogram.hpp"
 #include "logcounter.hpp"
 #include "peerconnection.hpp"
 #include "rtp.hpp"
 
+#include <algorithm>
+
 namespace rtc::impl {
 
-static LogCounter COUNTER_MEDIA_BAD_DIRECTION(plog::warning,
+static LogCounter COUNTER_MEDIA_BAD_DIRECTION("rtc_track_bad_direction_packets", plog::warning,
                                               "Number of media packets sent in invalid directions");
-static LogCounter COUNTER_QUEUE_FULL(plog::warning,
+static LogCounter COUNTER_QUEUE_FULL("rtc_track_queue_full_drops", plog::warning,
                                      "Number of media packets dropped due to a full queue");
 
+static LatencyHistogram HISTOGRAM_INCOMING_CHAIN("rtc_track_incoming_chain_latency",
+                                                 "Time spent in incoming media handler chains");
+static LatencyHistogram HISTOGRAM_OUTGOING_CHAIN("rtc_track_outgoing_chain_latency",
+                                                 "Time spent in outgoing media handler chains");
+
 Track::Track(weak_ptr<PeerConnection> pc, Description::Media desc)
     : mPeerConnection(pc), mMediaDescription(std::move(desc)),
       mRecvQueue(RECV_QUEUE_LIMIT, [](const message_ptr &m) { return m->size(); }) {
+	updateCache();
 
 	// Discard messages by default if track is send only
 	if (mMediaDescription.direction() == Description::Direction::SendOnly)
@@ -42,10 +51,7 @@ string Track::mid() const {
 	return mMediaDescription.mid();
 }
 
-Description::Direction Track::direction() const {
-	std::shared_lock lock(mMutex);
-	return mMediaDescription.direction();
-}
+Description::Direction Track::direction() const { return mDirection.load(); }
 
 Description::Media Track::description() const {
 	std::shared_lock lock(mMutex);
@@ -59,10 +65,11 @@ void Track::setDescription(Description::Media desc) {
 			throw std::logic_error("Media description mid does not match track mid");
 
 		mMediaDescription = std::move(desc);
+		updateCache();
 	}
 
 	if (auto handler = getMediaHandler())
-		handler->media(description());
+		handler->mediaChain(description());
 }
 
 void Track::close() {
@@ -97,6 +104,10 @@ optional<message_variant> Track::peek() {
 	return nullopt;
 }
 
+optional<message_ptr> Track::receiveMessage() { return mRecvQueue.pop(); }
+
+optional<message_ptr> Track::peekMessage() { return mRecvQueue.peek(); }
+
 size_t Track::availableAmount() const { return mRecvQueue.amount(); }
 
 bool Track::isOpen(void) const {
@@ -111,11 +122,11 @@ bool Track::isOpen(void) const {
 bool Track::isClosed(void) const { return mIsClosed; }
 
 size_t Track::maxMessageSize() const {
-	optional<size_t> mtu;
+	size_t mtu = DEFAULT_MTU;
 	if (auto pc = mPeerConnection.lock())
-		mtu = pc->config.mtu;
+		mtu = pc->pathMtu();
 
-	return mtu.value_or(DEFAULT_MTU) - 12 - 8 - 40; // SRTP/UDP/IPv6
+	return mtu - 12 - 8 - 40; // SRTP/UDP/IPv6
 }
 
 #if RTC_ENABLE_MEDIA
@@ -134,19 +145,34 @@ void Track::incoming(message_ptr message) {
 	if (!message)
 		return;
 
+	incoming(message_vector{std::move(message)});
+}
+
+void Track::incoming(message_vector messages) {
 	auto dir = direction();
-	if ((dir == Description::Direction::SendOnly || dir == Description::Direction::Inactive) &&
-	    message->type != Message::Control) {
-		COUNTER_MEDIA_BAD_DIRECTION++;
-		return;
+	if (dir == Description::Direction::SendOnly || dir == Description::Direction::Inactive) {
+		auto it = std::remove_if(messages.begin(), messages.end(), [](const message_ptr &m) {
+			if (m->type == Message::Control)
+				return false;
+
+			COUNTER_MEDIA_BAD_DIRECTION++;
+			return true;
+		});
+		messages.erase(it, messages.end());
 	}
 
-	message_vector messages{std::move(message)};
+	if (messages.empty())
+		return;
+
+	for (const auto &m : messages)
+		countReceived(*m);
+
 	if (auto handler = getMediaHandler()) {
+		LatencyScope latency(HISTOGRAM_INCOMING_CHAIN);
 		try {
 			handler->incomingChain(messages, [weak_this = weak_from_this()](message_ptr m) {
 				if (auto locked = weak_this.lock()) {
-					locked->transportSend(m);
+					locked->transportSend(std::move(m));
 				}
 			});
 		} catch (const std::exception &e) {
@@ -186,21 +212,58 @@ bool Track::outgoing(message_ptr message) {
 
 	if (handler) {
 		message_vector messages{std::move(message)};
+		{
+			LatencyScope latency(HISTOGRAM_OUTGOING_CHAIN);
+			handler->outgoingChain(messages, [weak_this = weak_from_this()](message_ptr m) {
+				if (auto locked = weak_this.lock()) {
+					locked->transportSend(m);
+				}
+			});
+		}
+
+		return transportSend(std::move(messages));
+
+	} else {
+		return transportSend(std::move(message));
+	}
+}
+
+bool Track::outgoing(message_vector messages) {
+	if (mIsClosed)
+		throw std::runtime_error("Track is closed");
+
+	if (messages.empty())
+		return false;
+
+	auto handler = getMediaHandler();
+	if (!handler)
+		for (auto &message : messages)
+			if (IsRtcp(*message))
+				message->type = Message::Control;
+
+	auto dir = direction();
+	if (dir == Description::Direction::RecvOnly || dir == Description::Direction::Inactive) {
+		auto it = std::remove_if(messages.begin(), messages.end(), [](const message_ptr &m) {
+			return m->type != Message::Control;
+		});
+		for (auto jt = it; jt != messages.end(); ++jt)
+			COUNTER_MEDIA_BAD_DIRECTION++;
+
+		messages.erase(it, messages.end());
+		if (messages.empty())
+			return false;
+	}
+
+	if (handler) {
+		LatencyScope latency(HISTOGRAM_OUTGOING_CHAIN);
 		handler->outgoingChain(messages, [weak_this = weak_from_this()](message_ptr m) {
 			if (auto locked = weak_this.lock()) {
 				locked->transportSend(m);
 			}
 		});
-
-		bool ret = false;
-		for (auto &m : messages)
-			ret = transportSend(std::move(m));
-
-		return ret;
-
-	} else {
-		return transportSend(std::move(message));
 	}
+
+	return transportSend(std::move(messages));
 }
 
 bool Track::transportSend([[maybe_unused]] message_ptr message) {
@@ -211,49 +274,140 @@ bool Track::transportSend([[maybe_unused]] message_ptr message) {
 		transport = mDtlsSrtpTransport.lock();
 		if (!transport)
 			throw std::runtime_error("Track is not open");
-
-		// Set recommended medium-priority DSCP value
-		// See https://www.rfc-editor.org/rfc/rfc8837.html#section-5
-		if (mMediaDescription.type() == "audio")
-			message->dscp = 46; // EF: Expedited Forwarding
-		else
-			message->dscp = 36; // AF42: Assured Forwarding class 4, medium drop probability
 	}
 
-	return transport->sendMedia(message);
+	message->dscp = mDscp.load(std::memory_order_relaxed);
+
+	countSent(*message);
+	return transport->sendMedia(std::move(message));
 #else
 	throw std::runtime_error("Track is disabled (not compiled with media support)");
 #endif
 }
 
-void Track::setMediaHandler(shared_ptr<MediaHandler> handler) {
+bool Track::transportSend([[maybe_unused]] message_vector messages) {
+#if RTC_ENABLE_MEDIA
+	if (messages.empty())
+		return false;
+
+	shared_ptr<DtlsSrtpTransport> transport;
 	{
-		std::unique_lock lock(mMutex);
-		mMediaHandler = handler;
+		std::shared_lock lock(mMutex);
+		transport = mDtlsSrtpTransport.lock();
+		if (!transport)
+			throw std::runtime_error("Track is not open");
+	}
+
+	const unsigned int dscp = mDscp.load(std::memory_order_relaxed);
+	for (auto &message : messages)
+		if (message) {
+			message->dscp = dscp;
+			countSent(*message);
+		}
+
+	return transport->sendMedia(std::move(messages));
+#else
+	throw std::runtime_error("Track is disabled (not compiled with media support)");
+#endif
+}
+
+TrackStats Track::stats() const {
+	TrackStats stats;
+	stats.rtpPacketsSent = mRtpPacketsSent.load(std::memory_order_relaxed);
+	stats.rtpBytesSent = mRtpBytesSent.load(std::memory_order_relaxed);
+	stats.rtcpPacketsSent = mRtcpPacketsSent.load(std::memory_order_relaxed);
+	stats.rtpPacketsReceived = mRtpPacketsReceived.load(std::memory_order_relaxed);
+	stats.rtpBytesReceived = mRtpBytesReceived.load(std::memory_order_relaxed);
+	stats.rtcpPacketsReceived = mRtcpPacketsReceived.load(std::memory_order_relaxed);
+	stats.nacksReceived = mNacksReceived.load(std::memory_order_relaxed);
+	stats.plisReceived = mPlisReceived.load(std::memory_order_relaxed);
+	stats.firsReceived = mFirsReceived.load(std::memory_order_relaxed);
+	if (int pt = mSentPayloadType.load(std::memory_order_relaxed); pt >= 0)
+		stats.sentPayloadType = pt;
+	if (int pt = mReceivedPayloadType.load(std::memory_order_relaxed); pt >= 0)
+		stats.receivedPayloadType = pt;
+	return stats;
+}
+
+void Track::countSent(const Message &message) {
+	if (IsRtcp(message)) {
+		mRtcpPacketsSent.fetch_add(1, std::memory_order_relaxed);
+	} else if (message.size() >= sizeof(RtpHeader)) {
+		auto rtp = reinterpret_cast<const RtpHeader *>(message.data());
+		mRtpPacketsSent.fetch_add(1, std::memory_order_relaxed);
+		mRtpBytesSent.fetch_add(message.size(), std::memory_order_relaxed);
+		mSentPayloadType.store(rtp->payloadType(), std::memory_order_relaxed);
 	}
+}
+
+void Track::countReceived(const Message &message) {
+	if (message.type != Message::Control && !IsRtcp(message)) {
+		if (message.size() >= sizeof(RtpHeader)) {
+			auto rtp = reinterpret_cast<const RtpHeader *>(message.data());
+			mRtpPacketsReceived.fetch_add(1, std::memory_order_relaxed);
+			mRtpBytesReceived.fetch_add(message.size(), std::memory_order_relaxed);
+			mReceivedPayloadType.store(rtp->payloadType(), std::memory_order_relaxed);
+		}
+		return;
+	}
+
+	mRtcpPacketsReceived.fetch_add(1, std::memory_order_relaxed);
+
+	// Count feedback messages in the compound packet
+	// See https://www.rfc-editor.org/rfc/rfc4585.html#section-6.1
+	size_t offset = 0;
+	while (offset + sizeof(RtcpHeader) <= message.size()) {
+		auto header = reinterpret_cast<const RtcpHeader *>(message.data() + offset);
+		uint8_t pt = header->payloadType();
+		uint8_t fmt = header->reportCount();
+		if (pt == 205 && fmt == 1) // Generic NACK
+			mNacksReceived.fetch_add(1, std::memory_order_relaxed);
+		else if (pt == 206 && fmt == 1) // PLI
+			mPlisReceived.fetch_add(1, std::memory_order_relaxed);
+		else if (pt == 206 && fmt == 4) // FIR
+			mFirsReceived.fetch_add(1, std::memory_order_relaxed);
+
+		offset += header->lengthInBytes();
+	}
+}
+
+void Track::setMediaHandler(shared_ptr<MediaHandler> handler) {
+	std::atomic_store(&mMediaHandler, handler);
 
 	if (handler)
-		handler->media(description());
+		handler->mediaChain(description());
 }
 
-shared_ptr<MediaHandler> Track::getMediaHandler() {
-	std::shared_lock lock(mMutex);
-	return mMediaHandler;
+shared_ptr<MediaHandler> Track::getMediaHandler() { return std::atomic_load(&mMediaHandler); }
+
+void Track::updateCache() {
+	mDirection.store(mMediaDescription.direction());
+
+	// Set recommended medium-priority DSCP value
+	// See https://www.rfc-editor.org/rfc/rfc8837.html#section-5
+	mDscp.store(mMediaDescription.type() == "audio"
+	                ? 46  // EF: Expedited Forwarding
+	                : 36, // AF42: Assured Forwarding class 4, medium drop probability
+	            std::memory_order_relaxed);
 }
 
 void Track::flushPendingMessages() {
 	if (!mOpenTriggered)
 		return;
 
-	while (messageCallback || frameCallback) {
+	while (messageViewCallback || messageCallback || frameViewCallback || frameCallback) {
 		auto next = mRecvQueue.pop();
 		if (!next)
 			break;
 
 		auto message = next.value();
 		try {
-			if (message->frameInfo && frameCallback) {
+			if (message->frameInfo && frameViewCallback) {
+				frameViewCallback(std::move(message));
+			} else if (message->frameInfo && frameCallback) {
 				frameCallback(std::move(*message), std::move(*message->frameInfo));
+			} else if (!message->frameInfo && messageViewCallback) {
+				messageViewCallback(std::move(message));
 			} else if (!message->frameInfo && messageCallback) {
 				messageCallback(trackMessageToVariant(message));
 			}
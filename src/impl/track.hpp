@@ -14,6 +14,7 @@
 #include "description.hpp"
 #include "mediahandler.hpp"
 #include "queue.hpp"
+#include "stats.hpp"
 
 #if RTC_ENABLE_MEDIA
 #include "dtlssrtptransport.hpp"
@@ -33,10 +34,14 @@ public:
 
 	void close();
 	void incoming(message_ptr message);
+	void incoming(message_vector messages); // runs the handler chain once for the batch
 	bool outgoing(message_ptr message);
+	bool outgoing(message_vector messages); // runs the handler chain once for the batch
 
 	optional<message_variant> receive() override;
 	optional<message_variant> peek() override;
+	optional<message_ptr> receiveMessage() override;
+	optional<message_ptr> peekMessage() override;
 	size_t availableAmount() const override;
 	void flushPendingMessages() override;
 	message_variant trackMessageToVariant(message_ptr message);
@@ -60,24 +65,40 @@ public:
 #endif
 
 	bool transportSend(message_ptr message);
+	bool transportSend(message_vector messages);
+
+	TrackStats stats() const;
 
 	synchronized_callback<binary, FrameInfo> frameCallback;
+	synchronized_callback<message_ptr> frameViewCallback; // takes precedence
 
 private:
+	void updateCache(); // requires mMutex to be locked
+	void countSent(const Message &message);
+	void countReceived(const Message &message);
+
 	const weak_ptr<PeerConnection> mPeerConnection;
 #if RTC_ENABLE_MEDIA
 	weak_ptr<DtlsSrtpTransport> mDtlsSrtpTransport;
 #endif
 
 	Description::Media mMediaDescription;
-	shared_ptr<MediaHandler> mMediaHandler;
+	shared_ptr<MediaHandler> mMediaHandler; // accessed atomically, the send path takes no lock
 
 	mutable std::shared_mutex mMutex;
 
+	// Cached from the description for the send path
+	std::atomic<Description::Direction> mDirection;
+	std::atomic<unsigned int> mDscp;
+
 	std::atomic<bool> mIsClosed = false;
 
 	Queue<message_ptr> mRecvQueue;
 
+	std::atomic<uint64_t> mRtpPacketsSent = 0, mRtpBytesSent = 0, mRtcpPacketsSent = 0;
+	std::atomic<uint64_t> mRtpPacketsReceived = 0, mRtpBytesReceived = 0, mRtcpPacketsReceived = 0;
+	std::atomic<uint64_t> mNacksReceived = 0, mPlisReceived = 0, mFirsReceived = 0;
+	std::atomic<int> mSentPayloadType = -1, mReceivedPayloadType = -1; // -1 if none
 };
 
 } // namespace rtc::impl
@@ -7,9 +7,57 @@
  */
 
 #include "transport.hpp"
+#include "tracing.hpp"
+
+#include <algorithm>
 
 namespace rtc::impl {
 
+namespace {
+
+// Counts a recv() call in progress, scopes form a stack of the calls of the current thread
+class DispatchScope final {
+public:
+	DispatchScope(const Transport *transport, const std::atomic<unsigned int> &epoch,
+	              std::atomic<unsigned int> counters[2]);
+	~DispatchScope();
+
+	const Transport *const transport;
+	DispatchScope *const previous;
+	const unsigned int slot;
+
+private:
+	std::atomic<unsigned int> &mCounter;
+};
+
+thread_local DispatchScope *CurrentDispatch = nullptr;
+
+// The counter is incremented before the handler is read, so setRecvHandler() either sees the call
+// in progress or the call sees the new handler
+DispatchScope::DispatchScope(const Transport *transport_, const std::atomic<unsigned int> &epoch,
+                             std::atomic<unsigned int> counters[2])
+    : transport(transport_), previous(CurrentDispatch), slot(epoch.load() & 1),
+      mCounter(counters[slot]) {
+	mCounter.fetch_add(1);
+	CurrentDispatch = this;
+}
+
+DispatchScope::~DispatchScope() {
+	CurrentDispatch = previous;
+	mCounter.fetch_sub(1); // ordered before the read of the waiters count in recv()
+}
+
+unsigned int dispatch_depth(const Transport *transport, unsigned int slot) {
+	unsigned int depth = 0;
+	for (auto scope = CurrentDispatch; scope; scope = scope->previous)
+		if (scope->transport == transport && scope->slot == slot)
+			++depth;
+
+	return depth;
+}
+
+} // namespace
+
 Transport::Transport(shared_ptr<Transport> lower, state_callback callback)
     : mLower(std::move(lower)), mStateChangeCallback(std::move(callback)) {}
 
@@ -25,7 +73,9 @@ Transport::~Transport() {
 void Transport::registerIncoming() {
 	if (mLower) {
 		PLOG_VERBOSE << "Registering incoming callback";
-		mLower->onRecv(std::bind(&Transport::incoming, this, std::placeholders::_1));
+		auto handler = std::make_unique<RecvHandler>();
+		handler->upper = this;
+		mLower->setRecvHandler(std::move(handler));
 	}
 }
 
@@ -38,7 +88,50 @@ void Transport::unregisterIncoming() {
 
 Transport::State Transport::state() const { return mState; }
 
-void Transport::onRecv(message_callback callback) { mRecvCallback = std::move(callback); }
+void Transport::onRecv(message_callback callback) {
+	if (callback) {
+		auto handler = std::make_unique<RecvHandler>();
+		handler->callback = std::move(callback);
+		setRecvHandler(std::move(handler));
+	} else {
+		setRecvHandler(nullptr);
+	}
+}
+
+void Transport::setRecvHandler(unique_ptr<RecvHandler> handler) {
+	std::lock_guard lock(mRecvHandlerMutex);
+	mRecvHandler.store(handler.get());
+	if (handler)
+		mRecvHandlers.push_back(std::move(handler));
+
+	// Like a callback under a mutex, wait for calls in progress with a previous handler so the
+	// upper layer can be destroyed once unregistered. New calls count on the slot of the current
+	// epoch, so flipping it twice lets each slot drain in turn even under constant traffic. Calls
+	// of the current thread, when the handler is replaced from a callback, can't be waited for and
+	// keep their handler alive.
+	bool ownCalls = false;
+	for (int i = 0; i < 2; ++i) {
+		const unsigned int slot = mRecvEpoch.fetch_add(1) & 1;
+		const unsigned int own = dispatch_depth(this, slot);
+		ownCalls = ownCalls || own > 0;
+		if (mRecvDispatching[slot].load() > own) {
+			// The waiters count is incremented before the counter is checked under the mutex, so
+			// a call finishing in between either sees it and notifies, or is seen as finished
+			mRecvWaiters.fetch_add(1);
+			std::unique_lock drainLock(mRecvDrainMutex);
+			mRecvDrainedCondition.wait(drainLock,
+			                           [&]() { return mRecvDispatching[slot].load() <= own; });
+			mRecvWaiters.fetch_sub(1);
+		}
+	}
+
+	if (!ownCalls) {
+		auto current = mRecvHandler.load();
+		mRecvHandlers.erase(std::remove_if(mRecvHandlers.begin(), mRecvHandlers.end(),
+		                                   [current](const auto &h) { return h.get() != current; }),
+		                    mRecvHandlers.end());
+	}
+}
 
 void Transport::onStateChange(state_callback callback) {
 	mStateChangeCallback = std::move(callback);
@@ -50,18 +143,59 @@ void Transport::stop() { unregisterIncoming(); }
 
 bool Transport::send(message_ptr message) { return outgoing(message); }
 
+bool Transport::sendBatch(message_vector messages) {
+	// By default, send messages one by one
+	bool result = true;
+	for (auto &message : messages)
+		if (message)
+			result = send(std::move(message)) && result;
+
+	return result;
+}
+
+TransportStats Transport::stats() const {
+	TransportStats stats;
+	stats.packetsSent = mPacketsSent.load(std::memory_order_relaxed);
+	stats.bytesSent = mBytesSent.load(std::memory_order_relaxed);
+	stats.packetsReceived = mPacketsReceived.load(std::memory_order_relaxed);
+	stats.bytesReceived = mBytesReceived.load(std::memory_order_relaxed);
+	return stats;
+}
+
 void Transport::recv(message_ptr message) {
-	try {
-		mRecvCallback(message);
-	} catch (const std::exception &e) {
-		PLOG_WARNING << e.what();
+	if (message) {
+		mPacketsReceived.fetch_add(1, std::memory_order_relaxed);
+		mBytesReceived.fetch_add(message->size(), std::memory_order_relaxed);
+		Tracing::Trace(TracePoint::TransportRecv, this, message->size());
+	}
+
+	{
+		DispatchScope scope(this, mRecvEpoch, mRecvDispatching);
+		try {
+			if (auto handler = mRecvHandler.load()) {
+				if (handler->upper)
+					handler->upper->incoming(std::move(message));
+				else
+					handler->callback(std::move(message));
+			}
+		} catch (const std::exception &e) {
+			PLOG_WARNING << e.what();
+		}
+	}
+
+	// Wake up setRecvHandler() if it is waiting for calls in progress to finish
+	if (mRecvWaiters.load() > 0) {
+		std::lock_guard lock(mRecvDrainMutex);
+		mRecvDrainedCondition.notify_all();
 	}
 }
 
 void Transport::changeState(State state) {
 	try {
-		if (mState.exchange(state) != state)
+		if (mState.exchange(state) != state) {
+			Tracing::Trace(TracePoint::TransportStateChange, this, uint64_t(state));
 			mStateChangeCallback(state);
+		}
 	} catch (const std::exception &e) {
 		PLOG_WARNING << e.what();
 	}
@@ -69,11 +203,29 @@ void Transport::changeState(State state) {
 
 void Transport::incoming(message_ptr message) { recv(message); }
 
+void Transport::countSent(const Message &message) {
+	mPacketsSent.fetch_add(1, std::memory_order_relaxed);
+	mBytesSent.fetch_add(message.size(), std::memory_order_relaxed);
+	Tracing::Trace(TracePoint::TransportSend, this, message.size());
+}
+
 bool Transport::outgoing(message_ptr message) {
-	if (mLower)
-		return mLower->send(message);
-	else
+	if (!mLower)
 		return false;
+
+	countSent(*message);
+	return mLower->send(message);
+}
+
+bool Transport::outgoingBatch(message_vector messages) {
+	if (!mLower)
+		return false;
+
+	for (const auto &message : messages)
+		if (message)
+			countSent(*message);
+
+	return mLower->sendBatch(std::move(messages));
 }
 
 } // namespace rtc::impl
@@ -13,10 +13,14 @@
 #include "init.hpp"
 #include "internals.hpp"
 #include "message.hpp"
+#include "stats.hpp"
 
 #include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace rtc::impl {
 
@@ -38,21 +42,46 @@ public:
 	virtual void start();
 	virtual void stop();
 	virtual bool send(message_ptr message);
+	virtual bool sendBatch(message_vector messages); // false if any message is dropped
+
+	TransportStats stats() const;
 
 protected:
 	void recv(message_ptr message);
+	void countSent(const Message &message); // for transports sending to the network
 	void changeState(State state);
 	virtual void incoming(message_ptr message);
 	virtual bool outgoing(message_ptr message);
+	bool outgoingBatch(message_vector messages);
 
 private:
+	// Handler for received messages, immutable once published
+	struct RecvHandler {
+		Transport *upper = nullptr; // if set, messages are passed to upper->incoming()
+		message_callback callback;  // otherwise
+	};
+
+	void setRecvHandler(unique_ptr<RecvHandler> handler);
+
 	const init_token mInitToken = Init::Instance().token();
 
 	shared_ptr<Transport> mLower;
 	synchronized_callback<State> mStateChangeCallback;
-	synchronized_callback<message_ptr> mRecvCallback;
+
+	// recv() reads the handler without locking, a handler is only freed once no call is in progress
+	std::atomic<const RecvHandler *> mRecvHandler = nullptr;
+	std::atomic<unsigned int> mRecvEpoch = 0;               // its parity selects the counter
+	std::atomic<unsigned int> mRecvDispatching[2] = {0, 0}; // calls in progress
+	std::vector<unique_ptr<RecvHandler>> mRecvHandlers;     // protected by mRecvHandlerMutex
+	std::mutex mRecvHandlerMutex;
+	std::atomic<unsigned int> mRecvWaiters = 0; // setRecvHandler() calls waiting for a slot
+	std::mutex mRecvDrainMutex;
+	std::condition_variable mRecvDrainedCondition;
 
 	std::atomic<State> mState = State::Disconnected;
+
+	std::atomic<uint64_t> mPacketsSent = 0, mBytesSent = 0;
+	std::atomic<uint64_t> mPacketsReceived = 0, mBytesReceived = 0;
 };
 
 } // namespace rtc::impl
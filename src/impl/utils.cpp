@@ -13,8 +13,12 @@
 #include <algorithm>
 #include <cctype>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <iterator>
+#include <mutex>
 #include <sstream>
 #include <thread>
 
@@ -24,7 +28,15 @@
 typedef HRESULT(WINAPI *pfnSetThreadDescription)(HANDLE, PCWSTR);
 #endif
 #if defined(__linux__)
-#include <sys/prctl.h> // for prctl(PR_SET_NAME)
+#include <pthread.h>      // for pthread_setaffinity_np
+#include <sched.h>        // for sched_getcpu
+#include <sys/prctl.h>    // for prctl(PR_SET_NAME)
+#include <sys/resource.h> // for setpriority
+#include <sys/syscall.h>  // for SYS_gettid
+#include <unistd.h>
+#endif
+#if defined(__APPLE__)
+#include <pthread.h>
 #endif
 #if defined(__FreeBSD__)
 #include <pthread_np.h> // for pthread_set_name_np
@@ -80,41 +92,114 @@ string url_decode(const string &str) {
 	return result;
 }
 
+namespace {
+
+const char Base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Pairs of characters for every 12-bit value, so 3 bytes are encoded with 2 lookups
+struct Base64PairTable {
+	char pairs[4096][2];
+
+	Base64PairTable() {
+		for (int i = 0; i < 4096; ++i) {
+			pairs[i][0] = Base64Alphabet[i >> 6];
+			pairs[i][1] = Base64Alphabet[i & 0x3F];
+		}
+	}
+};
+
+// Decoded values, or 0xFF for invalid characters
+struct Base64DecodeTable {
+	uint8_t values[256];
+
+	Base64DecodeTable() {
+		std::fill(std::begin(values), std::end(values), uint8_t(0xFF));
+		for (int i = 0; i < 64; ++i)
+			values[uint8_t(Base64Alphabet[i])] = uint8_t(i);
+	}
+};
+
+} // namespace
+
 string base64_encode(const binary &data) {
-	static const char tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
-	string out;
-	out.reserve(3 * ((data.size() + 3) / 4));
-	int i = 0;
-	while (data.size() - i >= 3) {
-		auto d0 = to_integer<uint8_t>(data[i]);
-		auto d1 = to_integer<uint8_t>(data[i + 1]);
-		auto d2 = to_integer<uint8_t>(data[i + 2]);
-		out += tab[d0 >> 2];
-		out += tab[((d0 & 3) << 4) | (d1 >> 4)];
-		out += tab[((d1 & 0x0F) << 2) | (d2 >> 6)];
-		out += tab[d2 & 0x3F];
+	static const Base64PairTable table;
+
+	const size_t size = data.size();
+	string out(4 * ((size + 2) / 3), '=');
+	auto src = reinterpret_cast<const uint8_t *>(data.data());
+	char *dst = out.data();
+	size_t i = 0;
+	while (size - i >= 3) {
+		const uint32_t word = uint32_t(src[i]) << 16 | uint32_t(src[i + 1]) << 8 | src[i + 2];
+		std::memcpy(dst, table.pairs[word >> 12], 2);
+		std::memcpy(dst + 2, table.pairs[word & 0xFFF], 2);
+		dst += 4;
 		i += 3;
 	}
 
-	int left = int(data.size() - i);
+	const size_t left = size - i;
 	if (left) {
-		auto d0 = to_integer<uint8_t>(data[i]);
-		out += tab[d0 >> 2];
-		if (left == 1) {
-			out += tab[(d0 & 3) << 4];
-			out += '=';
-		} else { // left == 2
-			auto d1 = to_integer<uint8_t>(data[i + 1]);
-			out += tab[((d0 & 3) << 4) | (d1 >> 4)];
-			out += tab[(d1 & 0x0F) << 2];
-		}
-		out += '=';
+		const uint32_t word = uint32_t(src[i]) << 16 | (left == 2 ? uint32_t(src[i + 1]) << 8 : 0);
+		std::memcpy(dst, table.pairs[word >> 12], 2);
+		if (left == 2)
+			dst[2] = Base64Alphabet[(word >> 6) & 0x3F];
+	}
+
+	return out;
+}
+
+binary base64_decode(std::string_view str) {
+	static const Base64DecodeTable table;
+
+	if (str.size() % 4 != 0)
+		throw std::invalid_argument("Invalid base64 length");
+
+	size_t padding = 0;
+	if (!str.empty() && str.back() == '=')
+		padding = str[str.size() - 2] == '=' ? 2 : 1;
+
+	const size_t size = str.size() - padding;
+	binary out(3 * (str.size() / 4) - padding);
+	auto src = reinterpret_cast<const uint8_t *>(str.data());
+	auto dst = reinterpret_cast<uint8_t *>(out.data());
+	uint8_t invalid = 0; // checked once at the end instead of for every character
+	size_t i = 0;
+	while (size - i >= 4) {
+		const uint8_t v0 = table.values[src[i]], v1 = table.values[src[i + 1]],
+		              v2 = table.values[src[i + 2]], v3 = table.values[src[i + 3]];
+		invalid |= v0 | v1 | v2 | v3;
+		const uint32_t word = uint32_t(v0) << 18 | uint32_t(v1) << 12 | uint32_t(v2) << 6 | v3;
+		dst[0] = uint8_t(word >> 16);
+		dst[1] = uint8_t(word >> 8);
+		dst[2] = uint8_t(word);
+		dst += 3;
+		i += 4;
+	}
+
+	if (padding) {
+		const uint8_t v0 = table.values[src[i]], v1 = table.values[src[i + 1]];
+		const uint8_t v2 = padding == 1 ? table.values[src[i + 2]] : 0;
+		invalid |= v0 | v1 | v2;
+		const uint32_t word = uint32_t(v0) << 18 | uint32_t(v1) << 12 | uint32_t(v2) << 6;
+		dst[0] = uint8_t(word >> 16);
+		if (padding == 1)
+			dst[1] = uint8_t(word >> 8);
 	}
 
+	// Valid values are below 64, so the high bits are set only if a character is invalid
+	if (invalid & 0xC0)
+		throw std::invalid_argument("Invalid base64 character");
+
 	return out;
 }
 
+uint64_t ntp_time() {
+	const auto now = std::chrono::system_clock::now();
+	const double secs = std::chrono::duration<double>(now.time_since_epoch()).count();
+	// Assume the epoch is 01/01/1970 and adds the number of seconds between 1900 and 1970
+	return uint64_t(std::floor((secs + 2208988800.) * double(uint64_t(1) << 32)));
+}
+
 std::seed_seq random_seed() {
 	std::vector<unsigned int> seed;
 
@@ -172,12 +257,176 @@ void thread_set_name_self(const char *name) {
 #endif
 }
 
+struct ThreadRegistry {
+	std::mutex mutex;
+	std::map<uint64_t, string> threads;
+};
+
+ThreadRegistry &GetThreadRegistry() {
+	// Never destroyed as threads might exit after static destruction
+	static ThreadRegistry *registry = new ThreadRegistry;
+	return *registry;
+}
+
+// Unregisters the thread on exit
+struct ThreadRegistration {
+	uint64_t id = 0;
+
+	~ThreadRegistration() {
+		if (id == 0)
+			return;
+
+		auto &registry = GetThreadRegistry();
+		std::lock_guard lock(registry.mutex);
+		registry.threads.erase(id);
+	}
+};
+
+thread_local ThreadRegistration CurrentRegistration;
+
 } // namespace
 
 namespace this_thread {
 
-void set_name(const string &name) { thread_set_name_self(name.c_str()); }
+#if defined(__linux__)
+const int LowPriorityNice = 5;
+#endif
+
+void set_name(const string &name) {
+	thread_set_name_self(name.c_str());
+
+	CurrentRegistration.id = native_id();
+	auto &registry = GetThreadRegistry();
+	std::lock_guard lock(registry.mutex);
+	registry.threads[CurrentRegistration.id] = name;
+}
+
+uint64_t native_id() {
+#if defined(_WIN32)
+	return uint64_t(GetCurrentThreadId());
+#elif defined(__linux__)
+	return uint64_t(syscall(SYS_gettid));
+#elif defined(__APPLE__)
+	uint64_t id = 0;
+	pthread_threadid_np(nullptr, &id);
+	return id;
+#elif defined(__FreeBSD__)
+	return uint64_t(pthread_getthreadid_np());
+#else
+	return uint64_t(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
+}
+
+bool set_affinity(const std::vector<unsigned int> &cpus) {
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (unsigned int cpu : cpus)
+		if (cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+
+	return !cpus.empty() && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	(void)cpus;
+	return false;
+#endif
+}
+
+bool set_low_priority() {
+#if defined(_WIN32)
+	return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL) != 0;
+#elif defined(__linux__)
+	// On Linux, the nice value is per thread
+	return setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), LowPriorityNice) == 0;
+#else
+	return false;
+#endif
+}
+
+unsigned int numa_node() {
+#if defined(__linux__)
+	// Map from CPU to node, built once as the topology is not expected to change
+	static const std::vector<unsigned int> nodes = []() {
+		std::vector<unsigned int> table;
+		for (unsigned int node = 0; node < numa_nodes_count(); ++node)
+			for (unsigned int cpu : numa_node_cpus(node)) {
+				if (cpu >= table.size())
+					table.resize(cpu + 1, 0);
+
+				table[cpu] = node;
+			}
+
+		return table;
+	}();
+
+	int cpu = sched_getcpu(); // cheap, served by the vDSO
+	return cpu >= 0 && size_t(cpu) < nodes.size() ? nodes[cpu] : 0;
+#else
+	return 0;
+#endif
+}
 
 } // namespace this_thread
 
+namespace {
+
+#if defined(__linux__)
+string numa_node_path(unsigned int node) {
+	return "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+}
+#endif
+
+} // namespace
+
+unsigned int numa_nodes_count() {
+#if defined(__linux__)
+	static const unsigned int count = []() {
+		unsigned int n = 0;
+		while (std::ifstream(numa_node_path(n)).good())
+			++n;
+
+		return std::max(n, 1u);
+	}();
+	return count;
+#else
+	return 1;
+#endif
+}
+
+std::vector<unsigned int> numa_node_cpus(unsigned int node) {
+	std::vector<unsigned int> cpus;
+#if defined(__linux__)
+	// The list is formatted like "0-3,8-11"
+	std::ifstream file(numa_node_path(node));
+	string list;
+	if (!std::getline(file, list))
+		return cpus;
+
+	try {
+		for (const auto &range : explode(list, ',')) {
+			auto bounds = explode(range, '-');
+			if (bounds.empty() || bounds.size() > 2)
+				continue;
+
+			unsigned long first = std::stoul(bounds[0]);
+			unsigned long last = bounds.size() > 1 ? std::stoul(bounds[1]) : first;
+			for (unsigned long cpu = first; cpu <= last; ++cpu)
+				cpus.push_back(unsigned(cpu));
+		}
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "Failed to parse CPU list of NUMA node " << node << ": " << e.what();
+		cpus.clear();
+	}
+#else
+	(void)node;
+#endif
+	return cpus;
+}
+
+std::vector<std::pair<uint64_t, string>> registered_threads() {
+	auto &registry = GetThreadRegistry();
+	std::lock_guard lock(registry.mutex);
+	return {registry.threads.begin(), registry.threads.end()};
+}
+
 } // namespace rtc::impl::utils
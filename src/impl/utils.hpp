@@ -16,6 +16,7 @@
 #include <map>
 #include <random>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
 namespace rtc::impl::utils {
@@ -31,6 +32,12 @@ string url_decode(const string &str);
 // See https://www.rfc-editor.org/rfc/rfc4648.html#section-4
 string base64_encode(const binary &data);
 
+// Decode base64 (RFC 4648), throws std::invalid_argument on invalid input
+binary base64_decode(std::string_view str);
+
+// Return the current time as a 64-bit NTP timestamp (RFC 5905)
+uint64_t ntp_time();
+
 // Return a random seed sequence
 std::seed_seq random_seed();
 
@@ -79,10 +86,30 @@ template <typename T> uint32_t to_uint32(T i) {
 
 namespace this_thread {
 
+// Names the current thread and registers it with its name as role until it exits
 void set_name(const string &name);
 
+// Returns the native thread id, as reported by profilers (TID on Linux)
+uint64_t native_id();
+
+// Restricts the current thread to a set of CPUs, returns false if unsupported or failed
+bool set_affinity(const std::vector<unsigned int> &cpus);
+
+// Lowers the scheduling priority of the current thread, returns false if unsupported or failed
+bool set_low_priority();
+
+// Returns the NUMA node of the CPU running the current thread, 0 if unknown
+unsigned int numa_node();
+
 } // namespace this_thread
 
+// NUMA topology, on Linux only, other platforms are seen as a single node without CPU list
+unsigned int numa_nodes_count();
+std::vector<unsigned int> numa_node_cpus(unsigned int node); // empty if unknown
+
+// Returns the native ids and names of the living threads registered with set_name()
+std::vector<std::pair<uint64_t, string>> registered_threads();
+
 } // namespace rtc::impl::utils
 
 #endif
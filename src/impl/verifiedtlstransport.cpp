@@ -8,6 +8,8 @@
 
 #include "verifiedtlstransport.hpp"
 #include "common.hpp"
+#include "sha.hpp"
+#include "utils.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
 
@@ -16,11 +18,13 @@ namespace rtc::impl {
 static const string PemBeginCertificateTag = "-----BEGIN CERTIFICATE-----";
 
 VerifiedTlsTransport::VerifiedTlsTransport(
-    variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>> lower, string host,
+    variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>> lower, string host,
     certificate_ptr certificate, state_callback callback, [[maybe_unused]] optional<string> cacert)
     : TlsTransport(std::move(lower), std::move(host), std::move(certificate), std::move(callback)) {
 
 	PLOG_DEBUG << "Setting up TLS certificate verification";
+	mVerified = true;
+	mTrust = cacert ? utils::base64_encode(Sha1(*cacert)) : "system";
 
 #if USE_GNUTLS
 	gnutls_session_set_verify_cert(mSession, mHost->c_str(), 0);
@@ -17,7 +17,7 @@ namespace rtc::impl {
 
 class VerifiedTlsTransport final : public TlsTransport {
 public:
-	VerifiedTlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>> lower,
+	VerifiedTlsTransport(variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>> lower,
 	                     string host, certificate_ptr certificate, state_callback callback,
 	                     optional<string> cacert);
 	~VerifiedTlsTransport();
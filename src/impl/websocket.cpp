@@ -14,10 +14,12 @@
 #include "processor.hpp"
 #include "utils.hpp"
 
-#include "httpproxytransport.hpp"
+#include "http2transport.hpp"
+#include "proxytransport.hpp"
 #include "tcptransport.hpp"
 #include "tlstransport.hpp"
 #include "verifiedtlstransport.hpp"
+#include "wsdeflate.hpp"
 #include "wstransport.hpp"
 
 #include <array>
@@ -56,13 +58,16 @@ WebSocket::WebSocket(optional<Configuration> optConfig, certificate_ptr certific
 
 	mIsSecure = mCertificate != nullptr;
 
-	if (config.proxyServer) {
-		if (config.proxyServer->type == ProxyServer::Type::Socks5)
-			throw std::invalid_argument(
-			    "Proxy server support for WebSocket is not implemented for Socks5");
-		if (config.proxyServer->username || config.proxyServer->password) {
-			PLOG_WARNING << "HTTP authentication support for proxy is not implemented";
-		}
+	if (config.enableCompression && !WsDeflate::IsAvailable()) {
+		PLOG_WARNING << "WebSocket compression support is disabled, ignoring it";
+	}
+
+	if (config.compressionWindowBits &&
+	    (*config.compressionWindowBits < 9 || *config.compressionWindowBits > 15))
+		throw std::invalid_argument("WebSocket compression window bits must be between 9 and 15");
+
+	if (config.enableKernelTls && !TlsTransport::IsKernelTlsSupported()) {
+		PLOG_WARNING << "Kernel TLS is not supported, ignoring it";
 	}
 }
 
@@ -126,15 +131,43 @@ void WebSocket::open(const string &url) {
 
 	mHostname = hostname; // for TLS SNI and Proxy
 	mService = service;   // For proxy
-	std::atomic_store(&mWsHandshake, std::make_shared<WsHandshake>(host, path, config.protocols));
+	std::atomic_store(&mWsHandshake, std::make_shared<WsHandshake>(host, path, config.protocols,
+	                                                             compressionParameters()));
 
 	changeState(State::Connecting);
 
+	mHttp2Key.reset();
+	if (mIsSecure && config.enableHttp2) {
+		if (mCertificate) {
+			PLOG_WARNING << "WebSocket over HTTP/2 with a client certificate is not supported";
+		} else {
+			// Only WebSockets with the same TLS and proxy settings may share a connection
+			string key = config.disableTlsVerification ? "noverify;" : "verify;";
+			key += config.caCertificatePemFile.value_or("") + ';' + hostname + ';' + service;
+			if (const auto &proxy = config.proxyServer)
+				key += ';' + proxy->hostname + ':' + std::to_string(proxy->port) + ';' +
+				       proxy->username.value_or("");
+
+			mHttp2Key.emplace(std::move(key));
+			if (auto session = Http2Transport::Find(*mHttp2Key)) {
+				PLOG_DEBUG << "Using existing HTTP/2 connection for WebSocket";
+				scheduleConnectionTimeout();
+				initHttp2Stream(std::move(session));
+				return;
+			}
+		}
+	}
+
+	openTcpTransport();
+}
+
+void WebSocket::openTcpTransport() {
 	if (config.proxyServer) {
 		setTcpTransport(std::make_shared<TcpTransport>(
 		    config.proxyServer->hostname, std::to_string(config.proxyServer->port), nullptr));
 	} else {
-		setTcpTransport(std::make_shared<TcpTransport>(hostname, service, nullptr));
+		setTcpTransport(
+		    std::make_shared<TcpTransport>(mHostname.value(), mService.value(), nullptr));
 	}
 }
 
@@ -174,9 +207,28 @@ optional<message_variant> WebSocket::peek() {
 	return next ? std::make_optional(to_variant(std::move(**next))) : nullopt;
 }
 
+optional<message_ptr> WebSocket::receiveMessage() { return mRecvQueue.pop(); }
+
+optional<message_ptr> WebSocket::peekMessage() { return mRecvQueue.peek(); }
+
+std::vector<message_ptr> WebSocket::receiveMessages() { return mRecvQueue.popAll(); }
+
 size_t WebSocket::availableAmount() const { return mRecvQueue.amount(); }
 
-bool WebSocket::changeState(State newState) { return state.exchange(newState) != newState; }
+bool WebSocket::changeState(State newState) {
+	if (newState != State::Connecting)
+		std::atomic_store(&mHandshakeToken, shared_ptr<void>());
+
+	return state.exchange(newState) != newState;
+}
+
+void WebSocket::setHandshakeExecutor(shared_ptr<Executor> executor) {
+	mHandshakeExecutor = std::move(executor);
+}
+
+void WebSocket::setHandshakeToken(shared_ptr<void> token) {
+	std::atomic_store(&mHandshakeToken, std::move(token));
+}
 
 bool WebSocket::outgoing(message_ptr message) {
 	if (state != State::Open || !mWsTransport)
@@ -188,18 +240,38 @@ bool WebSocket::outgoing(message_ptr message) {
 	return mWsTransport->send(message);
 }
 
+bool WebSocket::outgoing(message_ptr message, message_ptr serverFrame) {
+	if (state != State::Open || !mWsTransport)
+		throw std::runtime_error("WebSocket is not open");
+
+	if (message->size() > maxMessageSize())
+		throw std::runtime_error("Message size exceeds limit");
+
+	// Client frames need their own masking key
+	if (mWsTransport->isClient())
+		return mWsTransport->send(message);
+
+	return mWsTransport->sendServerFrame(std::move(serverFrame));
+}
+
 void WebSocket::incoming(message_ptr message) {
 	if (!message) {
+		flushPendingMessages();
 		remoteClose();
 		return;
 	}
 
 	if (message->type == Message::String || message->type == Message::Binary) {
 		mRecvQueue.push(message);
-		triggerAvailable(mRecvQueue.size());
+		triggerAvailable(mRecvQueue.size(), false); // messages are flushed on flushIncoming()
 	}
 }
 
+void WebSocket::flushIncoming() {
+	// Messages from a single read are delivered together
+	flushPendingMessages();
+}
+
 // Helper for WebSocket::initXTransport methods: start and emplace the transport
 template <typename T>
 shared_ptr<T> emplaceTransport(WebSocket *ws, shared_ptr<T> *member, shared_ptr<T> transport) {
@@ -277,9 +349,9 @@ shared_ptr<TcpTransport> WebSocket::setTcpTransport(shared_ptr<TcpTransport> tra
 	}
 }
 
-shared_ptr<HttpProxyTransport> WebSocket::initProxyTransport() {
+shared_ptr<ProxyTransport> WebSocket::initProxyTransport() {
 	PLOG_VERBOSE << "Starting Tcp Proxy transport";
-	using State = HttpProxyTransport::State;
+	using State = ProxyTransport::State;
 	try {
 		if (auto transport = std::atomic_load(&mProxyTransport))
 			return transport;
@@ -313,8 +385,9 @@ shared_ptr<HttpProxyTransport> WebSocket::initProxyTransport() {
 				});
 		};
 
-		auto transport = std::make_shared<HttpProxyTransport>(
-		    lower, mHostname.value(), mService.value(), stateChangeCallback);
+		auto transport = std::make_shared<ProxyTransport>(lower, config.proxyServer.value(),
+		                                                  mHostname.value(), mService.value(),
+		                                                  stateChangeCallback);
 
 		return emplaceTransport(this, &mProxyTransport, std::move(transport));
 
@@ -332,7 +405,7 @@ shared_ptr<TlsTransport> WebSocket::initTlsTransport() {
 		if (auto transport = std::atomic_load(&mTlsTransport))
 			return transport;
 
-		variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>> lower;
+		variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>> lower;
 		if (config.proxyServer) {
 			auto transport = std::atomic_load(&mProxyTransport);
 			if (!transport)
@@ -351,9 +424,15 @@ shared_ptr<TlsTransport> WebSocket::initTlsTransport() {
 			if(auto locked = weak_this.lock())
 				std::invoke([=]() {
 					switch (transportState) {
-					case State::Connected:
-						initWsTransport();
+					case State::Connected: {
+						auto transport = std::atomic_load(&mTlsTransport);
+						if (mHttp2Key && transport &&
+						    transport->alpnProtocol() == Http2Transport::AlpnProtocol)
+							initHttp2Transport();
+						else
+							initWsTransport();
 						break;
+					}
 					case State::Failed:
 						triggerError("TLS connection failed");
 						remoteClose();
@@ -377,6 +456,8 @@ shared_ptr<TlsTransport> WebSocket::initTlsTransport() {
 		}
 #endif
 
+		Init::Instance().initSubsystem(Init::Subsystem::Tls);
+
 		shared_ptr<TlsTransport> transport;
 		if (verify)
 			transport = std::make_shared<VerifiedTlsTransport>(lower, mHostname.value(),
@@ -386,6 +467,15 @@ shared_ptr<TlsTransport> WebSocket::initTlsTransport() {
 			transport =
 			    std::make_shared<TlsTransport>(lower, mHostname, mCertificate, stateChangeCallback);
 
+		if (config.enableKernelTls && TlsTransport::IsKernelTlsSupported())
+			transport->enableKernelTls();
+
+		if (mHandshakeExecutor)
+			transport->setHandshakeExecutor(mHandshakeExecutor);
+
+		if (mHttp2Key && !Http2Transport::IsUnsupported(*mHttp2Key))
+			transport->setAlpnProtocols({Http2Transport::AlpnProtocol, "http/1.1"});
+
 		return emplaceTransport(this, &mTlsTransport, std::move(transport));
 
 	} catch (const std::exception &e) {
@@ -395,6 +485,103 @@ shared_ptr<TlsTransport> WebSocket::initTlsTransport() {
 	}
 }
 
+shared_ptr<Http2Stream> WebSocket::initHttp2Transport() {
+	PLOG_VERBOSE << "Starting HTTP/2 transport";
+	shared_ptr<Http2Transport> session;
+
+	// We are on the TLS thread, so the session must not be destroyed here if the stream fails
+	scope_guard guard([&]() {
+		TearDownProcessor::Instance().enqueue(
+		    [session = std::move(session), token = Init::Instance().token()]() mutable {
+			    session.reset();
+		    });
+	});
+
+	try {
+		// The connection is handed over to the session, other WebSockets may then share it
+		auto tls = std::atomic_exchange(&mTlsTransport, decltype(mTlsTransport)(nullptr));
+		auto proxy = std::atomic_exchange(&mProxyTransport, decltype(mProxyTransport)(nullptr));
+		auto tcp = std::atomic_exchange(&mTcpTransport, decltype(mTcpTransport)(nullptr));
+		if (!tls)
+			throw std::logic_error("No underlying TLS transport for HTTP/2 transport");
+
+		tls->onStateChange(nullptr);
+		if (proxy)
+			proxy->onStateChange(nullptr);
+
+		if (tcp) {
+			tcp->onBufferedAmount(nullptr);
+			tcp->onStateChange(nullptr);
+		}
+
+		session = std::make_shared<Http2Transport>(std::move(tls), mHttp2Key.value());
+		session->start();
+
+	} catch (const std::exception &e) {
+		PLOG_ERROR << e.what();
+		remoteClose();
+		throw std::runtime_error("HTTP/2 transport initialization failed");
+	}
+
+	return initHttp2Stream(session);
+}
+
+shared_ptr<Http2Stream> WebSocket::initHttp2Stream(shared_ptr<Http2Transport> session) {
+	PLOG_VERBOSE << "Starting HTTP/2 stream";
+	using State = Http2Stream::State;
+	try {
+		if (auto transport = std::atomic_load(&mHttp2Stream))
+			return transport;
+
+		auto stateChangeCallback = [this, weak_this = weak_from_this()](State transportState) {
+			if(auto locked = weak_this.lock())
+				std::invoke([=]() {
+					switch (transportState) {
+					case State::Connected:
+						initWsTransport();
+						break;
+					case State::Failed: {
+						auto transport = std::atomic_load(&mHttp2Stream);
+						if (transport && transport->isUnsupported() &&
+						    state == WebSocket::State::Connecting) {
+							// The server does not support extended CONNECT, try HTTP/1.1 instead
+							PLOG_INFO << "WebSocket over HTTP/2 is not supported, using HTTP/1.1";
+							std::atomic_store(&mHttp2Stream, decltype(mHttp2Stream)(nullptr));
+							transport->onStateChange(nullptr);
+							TearDownProcessor::Instance().enqueue(
+							    [transport, token = Init::Instance().token()]() mutable {
+								    transport.reset();
+							    });
+							openTcpTransport();
+							break;
+						}
+						triggerError("HTTP/2 stream failed");
+						remoteClose();
+						break;
+					}
+					case State::Disconnected:
+						if(state == WebSocket::State::Connecting)
+							remoteClose();
+						break;
+					default:
+						// Ignore
+						break;
+					}
+				});
+		};
+
+		auto transport =
+		    std::make_shared<Http2Stream>(std::move(session), mWsHandshake, stateChangeCallback);
+
+		return emplaceTransport(this, &mHttp2Stream, std::move(transport));
+
+	} catch (const std::exception &e) {
+		PLOG_ERROR << e.what();
+		remoteClose();
+		throw std::runtime_error("HTTP/2 stream initialization failed");
+	}
+}
+
 shared_ptr<WsTransport> WebSocket::initWsTransport() {
 	PLOG_VERBOSE << "Starting WebSocket transport";
 	using State = WsTransport::State;
@@ -402,9 +589,10 @@ shared_ptr<WsTransport> WebSocket::initWsTransport() {
 		if (auto transport = std::atomic_load(&mWsTransport))
 			return transport;
 
-		variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>, shared_ptr<TlsTransport>>
-		    lower;
-		if (mIsSecure) {
+		WsTransport::LowerTransport lower;
+		if (auto transport = std::atomic_load(&mHttp2Stream)) {
+			lower = transport;
+		} else if (mIsSecure) {
 			auto transport = std::atomic_load(&mTlsTransport);
 			if (!transport)
 				throw std::logic_error("No underlying TLS transport for WebSocket transport");
@@ -425,7 +613,7 @@ shared_ptr<WsTransport> WebSocket::initWsTransport() {
 		}
 
 		if (!atomic_load(&mWsHandshake))
-			atomic_store(&mWsHandshake, std::make_shared<WsHandshake>());
+			atomic_store(&mWsHandshake, std::make_shared<WsHandshake>(compressionParameters()));
 
 		auto stateChangeCallback = [this, weak_this = weak_from_this()](State transportState) {
 			if(auto locked = weak_this.lock())
@@ -455,6 +643,7 @@ shared_ptr<WsTransport> WebSocket::initWsTransport() {
 		auto transport = std::make_shared<WsTransport>(lower, mWsHandshake, config,
 		                                               weak_bind(&WebSocket::incoming, this, _1),
 		                                               stateChangeCallback);
+		transport->onFlush(weak_bind(&WebSocket::flushIncoming, this));
 
 		return emplaceTransport(this, &mWsTransport, std::move(transport));
 
@@ -489,6 +678,7 @@ void WebSocket::closeTransports() {
 
 	// Pass the pointers to a thread, allowing to terminate a transport from its own thread
 	auto ws = std::atomic_exchange(&mWsTransport, decltype(mWsTransport)(nullptr));
+	auto http2 = std::atomic_exchange(&mHttp2Stream, decltype(mHttp2Stream)(nullptr));
 	auto tls = std::atomic_exchange(&mTlsTransport, decltype(mTlsTransport)(nullptr));
 	auto tcp = std::atomic_exchange(&mTcpTransport, decltype(mTcpTransport)(nullptr));
 
@@ -498,8 +688,8 @@ void WebSocket::closeTransports() {
 	if (tcp)
 		tcp->onBufferedAmount(nullptr);
 
-	using array = std::array<shared_ptr<Transport>, 3>;
-	array transports{std::move(ws), std::move(tls), std::move(tcp)};
+	using array = std::array<shared_ptr<Transport>, 4>;
+	array transports{std::move(ws), std::move(http2), std::move(tls), std::move(tcp)};
 
 	for (const auto &t : transports)
 		if (t)
@@ -525,7 +715,7 @@ void WebSocket::scheduleConnectionTimeout() {
 	auto defaultTimeout = 30s;
 	auto timeout = config.connectionTimeout.value_or(milliseconds(defaultTimeout));
 	if (timeout > milliseconds::zero()) {
-		ThreadPool::Instance().schedule(timeout, [weak_this = weak_from_this()]() {
+		ThreadPool::Instance().setTimer(timeout, [weak_this = weak_from_this()]() {
 			if (auto locked = weak_this.lock()) {
 				if (locked->state == WebSocket::State::Connecting) {
 					PLOG_WARNING << "WebSocket connection timed out";
@@ -537,6 +727,16 @@ void WebSocket::scheduleConnectionTimeout() {
 	}
 }
 
+optional<WsHandshake::Compression> WebSocket::compressionParameters() const {
+	if (!config.enableCompression || !WsDeflate::IsAvailable())
+		return nullopt;
+
+	WsHandshake::Compression compression;
+	compression.windowBits = config.compressionWindowBits.value_or(15);
+	compression.contextTakeover = !config.disableCompressionContextTakeover;
+	return compression;
+}
+
 } // namespace rtc::impl
 
 #endif
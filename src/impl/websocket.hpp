@@ -13,12 +13,15 @@
 
 #include "channel.hpp"
 #include "common.hpp"
-#include "httpproxytransport.hpp"
+#include "executor.hpp"
+#include "http2transport.hpp"
 #include "init.hpp"
 #include "message.hpp"
+#include "proxytransport.hpp"
 #include "queue.hpp"
 #include "tcptransport.hpp"
 #include "tlstransport.hpp"
+#include "wshandshake.hpp"
 #include "wstransport.hpp"
 
 #include "rtc/websocket.hpp"
@@ -39,10 +42,15 @@ struct WebSocket final : public Channel, public std::enable_shared_from_this<Web
 	void close();
 	void remoteClose();
 	bool outgoing(message_ptr message);
-	void incoming(message_ptr message);
+	bool outgoing(message_ptr message, message_ptr serverFrame); // frame shared by many clients
+	void incoming(message_ptr message); // messages are delivered on flushIncoming()
+	void flushIncoming();
 
 	optional<message_variant> receive() override;
 	optional<message_variant> peek() override;
+	optional<message_ptr> receiveMessage() override;
+	optional<message_ptr> peekMessage() override;
+	std::vector<message_ptr> receiveMessages() override;
 	size_t availableAmount() const override;
 
 	bool isOpen() const;
@@ -51,9 +59,15 @@ struct WebSocket final : public Channel, public std::enable_shared_from_this<Web
 
 	bool changeState(State state);
 
+	// For WebSocketServer admission control, call before setTcpTransport()
+	void setHandshakeExecutor(shared_ptr<Executor> executor);
+	void setHandshakeToken(shared_ptr<void> token); // released once not connecting anymore
+
 	shared_ptr<TcpTransport> setTcpTransport(shared_ptr<TcpTransport> transport);
-	shared_ptr<HttpProxyTransport> initProxyTransport();
+	shared_ptr<ProxyTransport> initProxyTransport();
 	shared_ptr<TlsTransport> initTlsTransport();
+	shared_ptr<Http2Stream> initHttp2Transport(); // takes over the TLS transport
+	shared_ptr<Http2Stream> initHttp2Stream(shared_ptr<Http2Transport> session);
 	shared_ptr<WsTransport> initWsTransport();
 	shared_ptr<TcpTransport> getTcpTransport() const;
 	shared_ptr<TlsTransport> getTlsTransport() const;
@@ -69,7 +83,9 @@ struct WebSocket final : public Channel, public std::enable_shared_from_this<Web
 private:
 	static certificate_ptr loadCertificate(const Configuration& config);
 
+	void openTcpTransport();
 	void scheduleConnectionTimeout();
+	optional<WsHandshake::Compression> compressionParameters() const;
 
 	const init_token mInitToken = Init::Instance().token();
 
@@ -78,13 +94,18 @@ private:
 
 	optional<string> mHostname; // for TLS SNI and Proxy
 	optional<string> mService;  // for Proxy
+	optional<string> mHttp2Key; // set if HTTP/2 may be used, identifies shared connections
 
 	shared_ptr<TcpTransport> mTcpTransport;
-	shared_ptr<HttpProxyTransport> mProxyTransport;
+	shared_ptr<ProxyTransport> mProxyTransport;
 	shared_ptr<TlsTransport> mTlsTransport;
+	shared_ptr<Http2Stream> mHttp2Stream;
 	shared_ptr<WsTransport> mWsTransport;
 	shared_ptr<WsHandshake> mWsHandshake;
 
+	shared_ptr<Executor> mHandshakeExecutor;
+	shared_ptr<void> mHandshakeToken;
+
 	Queue<message_ptr> mRecvQueue;
 };
 
@@ -11,17 +11,25 @@
 #include "websocketserver.hpp"
 #include "common.hpp"
 #include "internals.hpp"
+#include "logcounter.hpp"
 #include "threadpool.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
+
 namespace rtc::impl {
 
 using namespace std::placeholders;
 
 const string PemBeginCertificateTag = "-----BEGIN CERTIFICATE-----";
 
+static LogCounter COUNTER_REJECTED_CONNECTIONS(
+    "rtc_websocketserver_rejected_connections", plog::warning,
+    "Number of WebSocketServer connections rejected because too many handshakes were pending");
+
 WebSocketServer::WebSocketServer(Configuration config_)
-    : config(std::move(config_)), mStopped(false) {
+    : config(std::move(config_)), mStopped(false),
+      mHandshakes(std::make_shared<std::atomic<unsigned int>>(0)) {
 	PLOG_VERBOSE << "Creating WebSocketServer";
 
 	// Create certificate
@@ -46,11 +54,27 @@ WebSocketServer::WebSocketServer(Configuration config_)
 	if (config.bindAddress) {
 		bindAddress = config.bindAddress->c_str();
 	}
-	// Create TCP server
-	tcpServer = std::make_unique<TcpServer>(config.port, bindAddress);
 
-	// Create server thread
-	mThread = std::thread(&WebSocketServer::runLoop, this);
+	unsigned int acceptorsCount = std::max(config.acceptorsCount.value_or(1), 1u);
+	if (acceptorsCount > 1 && !TcpServer::IsReusePortSupported()) {
+		PLOG_WARNING << "Port reuse is not supported, falling back to a single acceptor";
+		acceptorsCount = 1;
+	}
+
+	// Create TCP servers, the kernel will spread incoming connections across them
+	const bool reusePort = acceptorsCount > 1;
+	tcpServers.emplace_back(std::make_unique<TcpServer>(config.port, bindAddress, reusePort));
+	const uint16_t port = tcpServers.front()->port(); // the port might have been picked randomly
+	while (tcpServers.size() < acceptorsCount)
+		tcpServers.emplace_back(std::make_unique<TcpServer>(port, bindAddress, reusePort));
+
+	if (config.enableTls && config.handshakeThreads)
+		for (unsigned int i = 0; i < *config.handshakeThreads; ++i)
+			mHandshakeExecutors.emplace_back(std::make_shared<Executor>());
+
+	// Create server threads
+	for (auto &tcpServer : tcpServers)
+		mThreads.emplace_back(&WebSocketServer::runLoop, this, tcpServer.get());
 }
 
 WebSocketServer::~WebSocketServer() {
@@ -62,12 +86,21 @@ void WebSocketServer::stop() {
 	if (mStopped.exchange(true))
 		return;
 
-	PLOG_DEBUG << "Stopping WebSocketServer thread";
-	tcpServer->close();
-	mThread.join();
+	PLOG_DEBUG << "Stopping WebSocketServer threads";
+	for (auto &tcpServer : tcpServers)
+		tcpServer->close();
+
+	for (auto &thread : mThreads)
+		thread.join();
+
+	// Pending handshakes continue on the thread pool
+	for (auto &executor : mHandshakeExecutors)
+		executor->join();
 }
 
-void WebSocketServer::runLoop() {
+uint16_t WebSocketServer::port() const { return tcpServers.front()->port(); }
+
+void WebSocketServer::runLoop(TcpServer *tcpServer) {
 	utils::this_thread::set_name("RTC server");
 	PLOG_INFO << "Starting WebSocketServer";
 
@@ -80,8 +113,21 @@ void WebSocketServer::runLoop() {
 				WebSocket::Configuration clientConfig;
 				clientConfig.connectionTimeout = config.connectionTimeout;
 				clientConfig.maxMessageSize = config.maxMessageSize;
+				clientConfig.enableCompression = config.enableCompression;
+				clientConfig.disableCompressionContextTakeover =
+				    config.disableCompressionContextTakeover;
+				clientConfig.compressionWindowBits = config.compressionWindowBits;
+				clientConfig.compressionThreshold = config.compressionThreshold;
+				clientConfig.enableKernelTls = config.enableKernelTls;
 
 				auto impl = std::make_shared<WebSocket>(std::move(clientConfig), mCertificate);
+				if (!admit(impl)) {
+					// Reject early, releasing the transport closes the socket
+					COUNTER_REJECTED_CONNECTIONS++;
+					incoming.reset();
+					continue;
+				}
+
 				impl->changeState(WebSocket::State::Connecting);
 				impl->setTcpTransport(incoming);
 				clientCallback(std::make_shared<rtc::WebSocket>(impl));
@@ -97,6 +143,45 @@ void WebSocketServer::runLoop() {
 	PLOG_INFO << "Stopped WebSocketServer";
 }
 
+size_t WebSocketServer::broadcast(const std::vector<shared_ptr<WebSocket>> &clients,
+                                  message_ptr message) {
+	// The frame is built once, then each connection only encrypts it if it uses TLS
+	auto frame = WsTransport::MakeServerFrame(message);
+	size_t count = 0;
+	for (const auto &ws : clients) {
+		try {
+			if (ws && ws->isOpen()) {
+				ws->outgoing(message, frame);
+				++count;
+			}
+		} catch (const std::exception &e) {
+			PLOG_DEBUG << "WebSocketServer broadcast: " << e.what();
+		}
+	}
+	return count;
+}
+
+bool WebSocketServer::admit(const shared_ptr<WebSocket> &ws) {
+	if (config.maxConcurrentHandshakes) {
+		const unsigned int max = *config.maxConcurrentHandshakes;
+		unsigned int count = mHandshakes->load();
+		do {
+			if (count >= max)
+				return false;
+		} while (!mHandshakes->compare_exchange_weak(count, count + 1));
+
+		ws->setHandshakeToken(
+		    shared_ptr<void>(nullptr, [handshakes = mHandshakes](void *) { --*handshakes; }));
+	}
+
+	if (!mHandshakeExecutors.empty()) {
+		size_t index = mNextHandshakeExecutor++ % mHandshakeExecutors.size();
+		ws->setHandshakeExecutor(mHandshakeExecutors[index]);
+	}
+
+	return true;
+}
+
 } // namespace rtc::impl
 
 #endif
@@ -13,6 +13,7 @@
 
 #include "certificate.hpp"
 #include "common.hpp"
+#include "executor.hpp"
 #include "init.hpp"
 #include "message.hpp"
 #include "tcpserver.hpp"
@@ -23,6 +24,7 @@
 
 #include <atomic>
 #include <thread>
+#include <vector>
 
 namespace rtc::impl {
 
@@ -34,18 +36,27 @@ struct WebSocketServer final : public std::enable_shared_from_this<WebSocketServ
 
 	void stop();
 
+	uint16_t port() const;
+	size_t broadcast(const std::vector<shared_ptr<WebSocket>> &clients, message_ptr message);
+
 	const Configuration config;
-	unique_ptr<TcpServer> tcpServer;
+	std::vector<unique_ptr<TcpServer>> tcpServers; // listeners sharing the same port
 	synchronized_callback<shared_ptr<rtc::WebSocket>> clientCallback;
 
 private:
 	const init_token mInitToken = Init::Instance().token();
 
-	void runLoop();
+	void runLoop(TcpServer *tcpServer);
+	bool admit(const shared_ptr<WebSocket> &ws);
 
 	certificate_ptr mCertificate;
-	std::thread mThread;
+	std::vector<std::thread> mThreads; // one accept thread per listener
 	std::atomic<bool> mStopped;
+
+	// Clients still handshaking, shared with their tokens which may outlive the server
+	const shared_ptr<std::atomic<unsigned int>> mHandshakes;
+	std::vector<shared_ptr<Executor>> mHandshakeExecutors;
+	std::atomic<size_t> mNextHandshakeExecutor = 0;
 };
 
 } // namespace rtc::impl
@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "wsdeflate.hpp"
+#include "internals.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+#if USE_ZLIB
+
+namespace {
+
+// RFC 7692: Remove 4 octets (that are 0x00 0x00 0xff 0xff) from the tail end
+const byte EmptyBlockTail[4] = {byte(0x00), byte(0x00), byte(0xFF), byte(0xFF)};
+
+const size_t ChunkSize = 16384;
+
+} // namespace
+
+bool WsDeflate::IsAvailable() { return true; }
+
+WsDeflate::WsDeflate(int windowBits, bool contextTakeover) : mContextTakeover(contextTakeover) {
+	// zlib does not support raw deflate with a window of 256 bytes
+	if (windowBits < 9 || windowBits > 15)
+		throw std::invalid_argument("Invalid WebSocket compression window bits");
+
+	// Negative window bits select raw deflate, without zlib header and trailer
+	if (deflateInit2(&mDeflateStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -windowBits, 8,
+	                 Z_DEFAULT_STRATEGY) != Z_OK)
+		throw std::runtime_error("Failed to initialize deflate stream");
+
+	// The peer may use any window up to 15 bits
+	if (inflateInit2(&mInflateStream, -15) != Z_OK) {
+		deflateEnd(&mDeflateStream);
+		throw std::runtime_error("Failed to initialize inflate stream");
+	}
+}
+
+WsDeflate::~WsDeflate() {
+	deflateEnd(&mDeflateStream);
+	inflateEnd(&mInflateStream);
+}
+
+binary WsDeflate::compress(const byte *data, size_t size) {
+	binary out(deflateBound(&mDeflateStream, uLong(size)) + 16);
+	mDeflateStream.next_in = reinterpret_cast<Bytef *>(const_cast<byte *>(data));
+	mDeflateStream.avail_in = uInt(size);
+	size_t written = 0;
+	do {
+		if (written == out.size())
+			out.resize(out.size() + ChunkSize);
+
+		mDeflateStream.next_out = reinterpret_cast<Bytef *>(out.data() + written);
+		mDeflateStream.avail_out = uInt(out.size() - written);
+		if (deflate(&mDeflateStream, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+			throw std::runtime_error("WebSocket compression failed");
+
+		written = out.size() - mDeflateStream.avail_out;
+	} while (mDeflateStream.avail_out == 0);
+
+	// The sync flush ends with an empty stored block
+	if (written >= 4 && std::equal(EmptyBlockTail, EmptyBlockTail + 4, out.data() + written - 4))
+		written -= 4;
+
+	out.resize(written);
+
+	if (!mContextTakeover)
+		deflateReset(&mDeflateStream);
+
+	return out;
+}
+
+binary WsDeflate::decompress(const byte *data, size_t size, size_t maxSize) {
+	binary out;
+	out.reserve(std::min(size * 4, maxSize));
+
+	// Inflate one extra byte to detect messages which are too large
+	const size_t limit = maxSize + 1;
+	auto run = [&](const byte *in, size_t len) {
+		mInflateStream.next_in = reinterpret_cast<Bytef *>(const_cast<byte *>(in));
+		mInflateStream.avail_in = uInt(len);
+		while (mInflateStream.avail_in > 0 && out.size() < limit) {
+			size_t written = out.size();
+			out.resize(std::min(written + std::max(ChunkSize, len), limit));
+			mInflateStream.next_out = reinterpret_cast<Bytef *>(out.data() + written);
+			mInflateStream.avail_out = uInt(out.size() - written);
+			int ret = inflate(&mInflateStream, Z_SYNC_FLUSH);
+			bool full = mInflateStream.avail_out == 0;
+			out.resize(out.size() - mInflateStream.avail_out);
+			if (ret == Z_STREAM_END) {
+				// The peer terminated the stream with a final block
+				inflateReset(&mInflateStream);
+				break;
+			}
+			if (ret != Z_OK && !(ret == Z_BUF_ERROR && full))
+				throw std::runtime_error("WebSocket decompression failed");
+		}
+	};
+
+	run(data, size);
+	run(EmptyBlockTail, 4);
+
+	if (out.size() > maxSize) {
+		PLOG_WARNING << "WebSocket message is too large, truncating it";
+		out.resize(maxSize);
+		// The remaining input is lost, so the compression context can't be kept
+		inflateReset(&mInflateStream);
+	}
+
+	return out;
+}
+
+#else
+
+bool WsDeflate::IsAvailable() { return false; }
+
+WsDeflate::WsDeflate(int, bool) : mContextTakeover(false) {
+	throw std::logic_error("WebSocket compression support is disabled");
+}
+
+WsDeflate::~WsDeflate() {}
+
+binary WsDeflate::compress(const byte *, size_t) {
+	throw std::logic_error("WebSocket compression support is disabled");
+}
+
+binary WsDeflate::decompress(const byte *, size_t, size_t) {
+	throw std::logic_error("WebSocket compression support is disabled");
+}
+
+#endif
+
+} // namespace rtc::impl
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_WS_DEFLATE_H
+#define RTC_IMPL_WS_DEFLATE_H
+
+#include "common.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#if USE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <stdexcept>
+
+namespace rtc::impl {
+
+// Message compressor and decompressor for the permessage-deflate extension (RFC 7692)
+class WsDeflate final {
+public:
+	static bool IsAvailable(); // false if built without zlib
+
+	WsDeflate(int windowBits, bool contextTakeover);
+	~WsDeflate();
+
+	WsDeflate(const WsDeflate &) = delete;
+	WsDeflate &operator=(const WsDeflate &) = delete;
+
+	binary compress(const byte *data, size_t size);
+	binary decompress(const byte *data, size_t size, size_t maxSize); // truncates to maxSize
+
+private:
+#if USE_ZLIB
+	z_stream mDeflateStream = {};
+	z_stream mInflateStream = {};
+#endif
+	const bool mContextTakeover;
+};
+
+} // namespace rtc::impl
+
+#endif
+
+#endif
@@ -17,9 +17,9 @@
 #include <algorithm>
 #include <chrono>
 #include <climits>
+#include <map>
 #include <iostream>
 #include <random>
-#include <sstream>
 
 using std::string;
 
@@ -28,10 +28,20 @@ namespace rtc::impl {
 using std::to_string;
 using std::chrono::system_clock;
 
-WsHandshake::WsHandshake() {}
+namespace {
+
+// Enough for a response with a few protocols, the compression response is added
+const size_t ResponseReserveSize = 256;
+
+} // namespace
+
+WsHandshake::WsHandshake(optional<Compression> compression)
+    : mCompressionConfig(std::move(compression)) {}
 
-WsHandshake::WsHandshake(string host, string path, std::vector<string> protocols)
-    : mHost(std::move(host)), mPath(std::move(path)), mProtocols(std::move(protocols)) {
+WsHandshake::WsHandshake(string host, string path, std::vector<string> protocols,
+                         optional<Compression> compression)
+    : mHost(std::move(host)), mPath(std::move(path)), mProtocols(std::move(protocols)),
+      mCompressionConfig(std::move(compression)) {
 
 	if (mHost.empty())
 		throw std::invalid_argument("WebSocket HTTP host cannot be empty");
@@ -55,6 +65,11 @@ std::vector<string> WsHandshake::protocols() const {
 	return mProtocols;
 }
 
+optional<WsHandshake::Compression> WsHandshake::compression() const {
+	std::unique_lock lock(mMutex);
+	return mCompression;
+}
+
 string WsHandshake::generateHttpRequest() {
 	std::unique_lock lock(mMutex);
 	mKey = generateKey();
@@ -73,6 +88,9 @@ string WsHandshake::generateHttpRequest() {
 	if (!mProtocols.empty())
 		out += "Sec-WebSocket-Protocol: " + utils::implode(mProtocols, ',') + "\r\n";
 
+	if (mCompressionConfig)
+		out += "Sec-WebSocket-Extensions: " + generateCompressionOffer() + "\r\n";
+
 	out += "\r\n";
 
 	return out;
@@ -81,15 +99,32 @@ string WsHandshake::generateHttpRequest() {
 string WsHandshake::generateHttpResponse() {
 	std::unique_lock lock(mMutex);
 
-	string out = "HTTP/1.1 101 Switching Protocols\r\n"
-	             "Server: libdatachannel\r\n"
-	             "Connection: Upgrade\r\n"
-	             "Upgrade: websocket\r\n"
-	             "Sec-WebSocket-Accept: " +
-	             computeAcceptKey(mKey) + "\r\n";
+	// The response is appended to a single buffer allocated once
+	string out;
+	out.reserve(ResponseReserveSize + mCompressionResponse.size());
+	out += "HTTP/1.1 101 Switching Protocols\r\n"
+	       "Server: libdatachannel\r\n"
+	       "Connection: Upgrade\r\n"
+	       "Upgrade: websocket\r\n"
+	       "Sec-WebSocket-Accept: ";
+	out += computeAcceptKey(mKey);
+	out += "\r\n";
 
-	if (!mProtocols.empty())
-		out += "Sec-WebSocket-Protocol: " + utils::implode(mProtocols, ',') + "\r\n";
+	if (!mProtocols.empty()) {
+		out += "Sec-WebSocket-Protocol: ";
+		for (auto it = mProtocols.begin(); it != mProtocols.end(); ++it) {
+			if (it != mProtocols.begin())
+				out += ',';
+			out += *it;
+		}
+		out += "\r\n";
+	}
+
+	if (mCompression) {
+		out += "Sec-WebSocket-Extensions: ";
+		out += mCompressionResponse;
+		out += "\r\n";
+	}
 
 	out += "\r\n";
 
@@ -108,6 +143,8 @@ string GetHttpErrorName(int responseCode) {
 		return "Method Not Allowed";
 	case 426:
 		return "Upgrade Required";
+	case 431:
+		return "Request Header Fields Too Large";
 	case 500:
 		return "Internal Server Error";
 	default:
@@ -115,6 +152,20 @@ string GetHttpErrorName(int responseCode) {
 	}
 }
 
+// Returns the next space-separated token of the line and advances past it
+std::string_view nextToken(std::string_view &line) {
+	size_t first = line.find_first_not_of(' ');
+	if (first == std::string_view::npos) {
+		line = {};
+		return {};
+	}
+
+	size_t last = std::min(line.find(' ', first), line.size());
+	auto token = line.substr(first, last - first);
+	line.remove_prefix(last);
+	return token;
+}
+
 } // namespace
 
 string WsHandshake::generateHttpError(int responseCode) {
@@ -140,98 +191,159 @@ size_t WsHandshake::parseHttpRequest(const byte *buffer, size_t size) {
 		throw RequestError("Invalid HTTP request for WebSocket", 400);
 
 	std::unique_lock lock(mMutex);
-	std::list<string> lines;
-	size_t length = parseHttpLines(buffer, size, lines);
+	HttpHead head;
+	size_t length;
+	try {
+		length = parseHttpHead(buffer, size, head);
+	} catch (const std::length_error &) {
+		throw RequestError("Too many HTTP headers in WebSocket request", 431);
+	}
 	if (length == 0)
 		return 0;
 
-	if (lines.empty())
+	if (head.startLine.empty())
 		throw RequestError("Invalid HTTP request for WebSocket", 400);
 
-	std::istringstream requestLine(std::move(lines.front()));
-	lines.pop_front();
-
-	string method, path, protocol;
-	requestLine >> method >> path >> protocol;
+	auto requestLine = head.startLine;
+	auto method = nextToken(requestLine);
+	auto path = nextToken(requestLine);
 	PLOG_DEBUG << "WebSocket request method=\"" << method << "\", path=\"" << path << "\"";
 	if (method != "GET")
-		throw RequestError("Invalid request method \"" + method + "\" for WebSocket", 405);
-
-	mPath = std::move(path);
-
-	auto headers = parseHttpHeaders(lines);
+		throw RequestError("Invalid request method \"" + string(method) + "\" for WebSocket", 405);
 
-	auto h = headers.find("host");
-	if (h == headers.end())
+	auto host = head.find("host");
+	if (!host)
 		throw RequestError("WebSocket host header missing in request", 400);
 
-	mHost = std::move(h->second);
-
-	h = headers.find("upgrade");
-	if (h == headers.end())
+	auto upgrade = head.find("upgrade");
+	if (!upgrade)
 		throw RequestError("WebSocket upgrade header missing in request", 426);
 
-	string upgrade;
-	std::transform(h->second.begin(), h->second.end(), std::back_inserter(upgrade),
-	               [](char c) { return std::tolower(c); });
-	if (upgrade != "websocket")
+	if (!HttpHead::equalsIgnoreCase(*upgrade, "websocket"))
 		throw RequestError("WebSocket upgrade header mismatching", 426);
 
-	h = headers.find("sec-websocket-key");
-	if (h == headers.end())
+	auto key = head.find("sec-websocket-key");
+	if (!key)
 		throw RequestError("WebSocket key header missing in request", 400);
 
-	mKey = std::move(h->second);
+	// RFC 6455: The request MUST include a header field with the name Sec-WebSocket-Key. [...] The
+	// value is a base64-encoded value that, when decoded, is 16 bytes in length.
+	bool validKey;
+	try {
+		validKey = utils::base64_decode(*key).size() == 16;
+	} catch (const std::invalid_argument &) {
+		validKey = false;
+	}
+	if (!validKey)
+		throw RequestError("WebSocket key header is invalid", 400);
+
+	mPath.assign(path);
+	mHost.assign(*host);
+	mKey.assign(*key);
 
-	h = headers.find("sec-websocket-protocol");
-	if (h != headers.end())
-		mProtocols = utils::explode(h->second, ',');
+	if (auto protocols = head.find("sec-websocket-protocol"))
+		mProtocols = utils::explode(string(*protocols), ',');
+
+	mCompression.reset();
+	if (mCompressionConfig)
+		head.forEach("sec-websocket-extensions", [this](std::string_view extensions) {
+			if (!mCompression)
+				acceptCompressionOffer(string(extensions));
+		});
 
 	return length;
 }
 
 size_t WsHandshake::parseHttpResponse(const byte *buffer, size_t size) {
 	std::unique_lock lock(mMutex);
-	std::list<string> lines;
-	size_t length = parseHttpLines(buffer, size, lines);
+	HttpHead head;
+	size_t length;
+	try {
+		length = parseHttpHead(buffer, size, head);
+	} catch (const std::length_error &) {
+		throw Error("Too many HTTP headers in WebSocket response");
+	}
 	if (length == 0)
 		return 0;
 
-	if (lines.empty())
+	if (head.startLine.empty())
 		throw Error("Invalid HTTP response for WebSocket");
 
-	std::istringstream status(std::move(lines.front()));
-	lines.pop_front();
-
-	string protocol;
+	auto status = head.startLine;
+	nextToken(status); // protocol
+	auto codeToken = nextToken(status);
 	unsigned int code = 0;
-	status >> protocol >> code;
+	for (char c : codeToken) {
+		if (c < '0' || c > '9' || code > 999) {
+			code = 0;
+			break;
+		}
+		code = code * 10 + unsigned(c - '0');
+	}
 	PLOG_DEBUG << "WebSocket response code=" << code;
 	if (code != 101)
 		throw std::runtime_error("Unexpected response code " + to_string(code) + " for WebSocket");
 
-	auto headers = parseHttpHeaders(lines);
-
-	auto h = headers.find("upgrade");
-	if (h == headers.end())
+	auto upgrade = head.find("upgrade");
+	if (!upgrade)
 		throw Error("WebSocket update header missing");
 
-	string upgrade;
-	std::transform(h->second.begin(), h->second.end(), std::back_inserter(upgrade),
-	               [](char c) { return std::tolower(c); });
-	if (upgrade != "websocket")
+	if (!HttpHead::equalsIgnoreCase(*upgrade, "websocket"))
 		throw Error("WebSocket update header mismatching");
 
-	h = headers.find("sec-websocket-accept");
-	if (h == headers.end())
+	auto accept = head.find("sec-websocket-accept");
+	if (!accept)
 		throw Error("WebSocket accept header missing");
 
-	if (h->second != computeAcceptKey(mKey))
+	if (*accept != computeAcceptKey(mKey))
 		throw Error("WebSocket accept header is invalid");
 
+	mCompression.reset();
+	head.forEach("sec-websocket-extensions", [this](std::string_view extensions) {
+		parseCompressionResponse(string(extensions));
+	});
+
 	return length;
 }
 
+HeaderList WsHandshake::generateHttp2Request() {
+	std::unique_lock lock(mMutex);
+
+	// RFC 8441: The :scheme and :path pseudo-headers are required, the :authority pseudo-header
+	// field conveys the same information as the Host header in HTTP/1.1.
+	HeaderList headers = {
+	    {":method", "CONNECT"},  {":protocol", "websocket"}, {":scheme", "https"},
+	    {":path", mPath},        {":authority", mHost},      {"sec-websocket-version", "13"},
+	};
+
+	if (!mProtocols.empty())
+		headers.emplace_back("sec-websocket-protocol", utils::implode(mProtocols, ','));
+
+	if (mCompressionConfig)
+		headers.emplace_back("sec-websocket-extensions", generateCompressionOffer());
+
+	return headers;
+}
+
+void WsHandshake::parseHttp2Response(const HeaderList &headers) {
+	std::unique_lock lock(mMutex);
+
+	// RFC 8441: A successful response is a 2xx, there is no Sec-WebSocket-Accept
+	auto status = std::find_if(headers.begin(), headers.end(),
+	                           [](const auto &header) { return header.first == ":status"; });
+	if (status == headers.end())
+		throw Error("HTTP/2 status missing in WebSocket response");
+
+	PLOG_DEBUG << "WebSocket response status=" << status->second;
+	if (status->second.size() != 3 || status->second[0] != '2')
+		throw std::runtime_error("Unexpected response code " + status->second + " for WebSocket");
+
+	mCompression.reset();
+	for (const auto &[name, value] : headers)
+		if (name == "sec-websocket-extensions")
+			parseCompressionResponse(value);
+}
+
 string WsHandshake::generateKey() {
 	// RFC 6455: The request MUST include a header field with the name Sec-WebSocket-Key.  The value
 	// of this header field MUST be a nonce consisting of a randomly selected 16-byte value that has
@@ -246,6 +358,199 @@ string WsHandshake::computeAcceptKey(const string &key) {
 	return utils::base64_encode(Sha1(string(key) + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
 }
 
+namespace {
+
+const string PerMessageDeflate = "permessage-deflate";
+
+// zlib does not support raw deflate with a window of 256 bytes
+const int MinWindowBits = 9;
+const int MaxWindowBits = 15;
+
+string trim(const string &str) {
+	const char *whitespace = " \t";
+	size_t first = str.find_first_not_of(whitespace);
+	if (first == string::npos)
+		return "";
+
+	size_t last = str.find_last_not_of(whitespace);
+	return str.substr(first, last - first + 1);
+}
+
+string lowercase(string str) {
+	std::transform(str.begin(), str.end(), str.begin(), [](char c) { return std::tolower(c); });
+	return str;
+}
+
+struct Extension {
+	string name;
+	std::map<string, optional<string>> params;
+	bool valid = true; // false if a parameter is duplicated
+};
+
+// Parse a Sec-WebSocket-Extensions header value as defined in RFC 6455 section 9.1
+std::vector<Extension> parseExtensions(const string &value) {
+	std::vector<Extension> extensions;
+	for (const auto &item : utils::explode(value, ',')) {
+		auto tokens = utils::explode(item, ';');
+		if (tokens.empty() || trim(tokens.front()).empty())
+			continue;
+
+		Extension extension;
+		extension.name = lowercase(trim(tokens.front()));
+		for (auto t = std::next(tokens.begin()); t != tokens.end(); ++t) {
+			string param = trim(*t);
+			if (param.empty())
+				continue;
+
+			optional<string> paramValue;
+			if (size_t pos = param.find('='); pos != string::npos) {
+				string v = trim(param.substr(pos + 1));
+				if (v.size() >= 2 && v.front() == '"' && v.back() == '"')
+					v = v.substr(1, v.size() - 2);
+
+				paramValue.emplace(std::move(v));
+				param = trim(param.substr(0, pos));
+			}
+
+			if (!extension.params.emplace(lowercase(param), std::move(paramValue)).second)
+				extension.valid = false;
+		}
+		extensions.emplace_back(std::move(extension));
+	}
+	return extensions;
+}
+
+// RFC 7692: The value MUST be a decimal integer in the range 8 to 15 with no leading zeros
+optional<int> parseWindowBits(const string &value) {
+	if (value.empty() || value.size() > 2 || value.front() == '0' ||
+	    !std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; }))
+		return nullopt;
+
+	int bits = std::stoi(value);
+	if (bits < 8 || bits > MaxWindowBits)
+		return nullopt;
+
+	return bits;
+}
+
+} // namespace
+
+string WsHandshake::generateCompressionOffer() const {
+	// The configuration applies in both directions
+	const int windowBits = std::clamp(mCompressionConfig->windowBits, MinWindowBits, MaxWindowBits);
+	string out = PerMessageDeflate;
+	if (windowBits < MaxWindowBits) {
+		out += "; client_max_window_bits=" + to_string(windowBits);
+		out += "; server_max_window_bits=" + to_string(windowBits);
+	} else {
+		out += "; client_max_window_bits";
+	}
+
+	if (!mCompressionConfig->contextTakeover)
+		out += "; client_no_context_takeover; server_no_context_takeover";
+
+	return out;
+}
+
+void WsHandshake::acceptCompressionOffer(const string &extensions) {
+	for (const auto &offer : parseExtensions(extensions)) {
+		if (offer.name != PerMessageDeflate || !offer.valid)
+			continue;
+
+		const int windowBits =
+		    std::clamp(mCompressionConfig->windowBits, MinWindowBits, MaxWindowBits);
+		Compression compression = *mCompressionConfig;
+		compression.windowBits = windowBits;
+		bool clientContextTakeover = mCompressionConfig->contextTakeover;
+		optional<int> clientWindowBits;
+		bool acceptable = true;
+		for (const auto &[name, value] : offer.params) {
+			if (name == "server_no_context_takeover" && !value) {
+				compression.contextTakeover = false;
+
+			} else if (name == "client_no_context_takeover" && !value) {
+				clientContextTakeover = false;
+
+			} else if (name == "server_max_window_bits" && value) {
+				auto bits = parseWindowBits(*value);
+				if (!bits || *bits < MinWindowBits) {
+					acceptable = false;
+					break;
+				}
+				compression.windowBits = std::min(compression.windowBits, *bits);
+
+			} else if (name == "client_max_window_bits") {
+				auto bits = value ? parseWindowBits(*value) : optional<int>(MaxWindowBits);
+				if (!bits) {
+					acceptable = false;
+					break;
+				}
+				clientWindowBits = std::min(*bits, windowBits);
+
+			} else {
+				acceptable = false;
+				break;
+			}
+		}
+
+		if (!acceptable)
+			continue; // Decline this offer
+
+		mCompressionResponse = PerMessageDeflate;
+		if (!compression.contextTakeover)
+			mCompressionResponse += "; server_no_context_takeover";
+		if (!clientContextTakeover)
+			mCompressionResponse += "; client_no_context_takeover";
+		if (compression.windowBits < MaxWindowBits)
+			mCompressionResponse += "; server_max_window_bits=" + to_string(compression.windowBits);
+		if (clientWindowBits && *clientWindowBits < MaxWindowBits)
+			mCompressionResponse += "; client_max_window_bits=" + to_string(*clientWindowBits);
+
+		PLOG_DEBUG << "WebSocket accepted compression: " << mCompressionResponse;
+		mCompression.emplace(std::move(compression));
+		return;
+	}
+}
+
+void WsHandshake::parseCompressionResponse(const string &extensions) {
+	for (const auto &extension : parseExtensions(extensions)) {
+		if (extension.name != PerMessageDeflate)
+			throw Error("Unexpected WebSocket extension \"" + extension.name + "\"");
+
+		if (!mCompressionConfig || mCompression || !extension.valid)
+			throw Error("Invalid WebSocket compression negotiation");
+
+		Compression compression = *mCompressionConfig;
+		compression.windowBits = std::clamp(compression.windowBits, MinWindowBits, MaxWindowBits);
+		for (const auto &[name, value] : extension.params) {
+			if (name == "client_no_context_takeover" && !value) {
+				compression.contextTakeover = false;
+
+			} else if (name == "client_max_window_bits" && value) {
+				auto bits = parseWindowBits(*value);
+				if (!bits || *bits < MinWindowBits)
+					throw Error("Unsupported WebSocket compression window bits");
+
+				compression.windowBits = std::min(compression.windowBits, *bits);
+
+			} else if (name == "server_no_context_takeover" && !value) {
+				// The decompressor handles both cases
+
+			} else if (name == "server_max_window_bits" && value) {
+				if (!parseWindowBits(*value))
+					throw Error("Invalid WebSocket compression window bits");
+
+			} else {
+				throw Error("Invalid WebSocket compression parameter \"" + name + "\"");
+			}
+		}
+
+		PLOG_DEBUG << "WebSocket negotiated compression, windowBits=" << compression.windowBits
+		           << ", contextTakeover=" << compression.contextTakeover;
+		mCompression.emplace(std::move(compression));
+	}
+}
+
 WsHandshake::Error::Error(const string &w) : std::runtime_error(w) {}
 
 WsHandshake::RequestError::RequestError(const string &w, int responseCode)
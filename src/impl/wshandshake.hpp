@@ -10,10 +10,10 @@
 #define RTC_IMPL_WS_HANDSHAKE_H
 
 #include "common.hpp"
+#include "hpack.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
 
-#include <list>
 #include <map>
 #include <stdexcept>
 #include <vector>
@@ -22,12 +22,20 @@ namespace rtc::impl {
 
 class WsHandshake final {
 public:
-	WsHandshake();
-	WsHandshake(string host, string path = "/", std::vector<string> protocols = {});
+	// permessage-deflate parameters (RFC 7692), they apply to the local compressor
+	struct Compression {
+		int windowBits = 15;
+		bool contextTakeover = true;
+	};
+
+	explicit WsHandshake(optional<Compression> compression = nullopt);
+	WsHandshake(string host, string path = "/", std::vector<string> protocols = {},
+	            optional<Compression> compression = nullopt);
 
 	string host() const;
 	string path() const;
 	std::vector<string> protocols() const;
+	optional<Compression> compression() const; // negotiated compression, if any
 
 	string generateHttpRequest();
 	string generateHttpResponse();
@@ -50,14 +58,25 @@ public:
 	size_t parseHttpRequest(const byte *buffer, size_t size);
 	size_t parseHttpResponse(const byte *buffer, size_t size);
 
+	// Extended CONNECT over HTTP/2 (RFC 8441), there is no key exchange
+	HeaderList generateHttp2Request();
+	void parseHttp2Response(const HeaderList &headers);
+
 private:
 	static string generateKey();
 	static string computeAcceptKey(const string &key);
 
+	string generateCompressionOffer() const;
+	void acceptCompressionOffer(const string &extensions);
+	void parseCompressionResponse(const string &extensions);
+
 	string mHost;
 	string mPath;
 	std::vector<string> mProtocols;
 	string mKey;
+	const optional<Compression> mCompressionConfig;
+	optional<Compression> mCompression;
+	string mCompressionResponse;
 	mutable std::mutex mMutex;
 };
 
@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef RTC_IMPL_WS_MASK_H
+#define RTC_IMPL_WS_MASK_H
+
+#include "common.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RTC_WS_MASK_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define RTC_WS_MASK_NEON 1
+#endif
+
+namespace rtc::impl {
+
+// Copy size bytes from src to dst while applying the WebSocket masking key, src and dst may be the
+// same. SSE2 and NEON are part of the baseline on x86_64 and ARM64, so no runtime dispatch is
+// needed, other targets process 8 bytes at a time.
+inline void apply_mask(byte *dst, const byte *src, size_t size, const byte *maskingKey) {
+	uint32_t key32;
+	std::memcpy(&key32, maskingKey, 4);
+	size_t i = 0;
+
+#if RTC_WS_MASK_SSE2
+	const __m128i key128 = _mm_set1_epi32(int(key32));
+	for (; i + 16 <= size; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(v, key128));
+	}
+#elif RTC_WS_MASK_NEON
+	const uint8x16_t key128 = vreinterpretq_u8_u32(vdupq_n_u32(key32));
+	for (; i + 16 <= size; i += 16) {
+		uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(src + i));
+		vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), veorq_u8(v, key128));
+	}
+#endif
+
+	const uint64_t key64 = (uint64_t(key32) << 32) | key32;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t v;
+		std::memcpy(&v, src + i, 8);
+		v ^= key64;
+		std::memcpy(dst + i, &v, 8);
+	}
+
+	// i is a multiple of 4 here, so the key is not shifted
+	for (; i < size; ++i)
+		dst[i] = src[i] ^ maskingKey[i % 4];
+}
+
+} // namespace rtc::impl
+
+#endif
@@ -7,16 +7,19 @@
  */
 
 #include "wstransport.hpp"
-#include "httpproxytransport.hpp"
+#include "http2transport.hpp"
+#include "proxytransport.hpp"
 #include "tcptransport.hpp"
 #include "threadpool.hpp"
 #include "tlstransport.hpp"
 #include "utils.hpp"
+#include "wsmask.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <numeric>
 #include <random>
@@ -53,8 +56,11 @@ WsTransport::WsTransport(LowerTransport lower, shared_ptr<WsHandshake> handshake
           std::visit(rtc::overloaded{[](auto l) { return l->isActive(); },
                                      [](shared_ptr<TlsTransport> l) { return l->isClient(); }},
                      lower)),
+      mIsHttp2(std::holds_alternative<shared_ptr<Http2Stream>>(lower)),
       mMaxMessageSize(config.maxMessageSize.value_or(DEFAULT_WS_MAX_MESSAGE_SIZE)),
-      mMaxOutstandingPings(config.maxOutstandingPings.value_or(0)) {
+      mMaxOutstandingPings(config.maxOutstandingPings.value_or(0)),
+      mCompressionThreshold(
+          config.compressionThreshold.value_or(DEFAULT_WS_COMPRESSION_THRESHOLD)) {
 
 	onRecv(std::move(recvCallback));
 
@@ -67,12 +73,19 @@ void WsTransport::start() {
 	registerIncoming();
 
 	changeState(State::Connecting);
-	if (mIsClient)
+	if (mIsHttp2) {
+		PLOG_INFO << "WebSocket client-side open over HTTP/2";
+		initCompression();
+		changeState(State::Connected);
+	} else if (mIsClient) {
 		sendHttpRequest();
+	}
 }
 
 void WsTransport::stop() { close(); }
 
+void WsTransport::onFlush(std::function<void()> callback) { mFlushCallback = std::move(callback); }
+
 bool WsTransport::send(message_ptr message) {
 	if (state() != State::Connected)
 		throw std::runtime_error("WebSocket is not open");
@@ -81,8 +94,16 @@ bool WsTransport::send(message_ptr message) {
 		return false;
 
 	PLOG_VERBOSE << "Send size=" << message->size();
-	return sendFrame({message->type == Message::String ? TEXT_FRAME : BINARY_FRAME, message->data(),
-	                  message->size(), true, mIsClient});
+	const Opcode opcode = message->type == Message::String ? TEXT_FRAME : BINARY_FRAME;
+	if (mDeflate && message->size() >= mCompressionThreshold) {
+		// Keep the lock while sending so compressed messages are sent in compression order
+		std::lock_guard lock(mDeflateMutex);
+		binary compressed = mDeflate->compress(message->data(), message->size());
+		PLOG_VERBOSE << "Compressed size=" << compressed.size();
+		return sendFrame({opcode, compressed.data(), compressed.size(), true, mIsClient, true});
+	}
+
+	return sendFrame({opcode, message->data(), message->size(), true, mIsClient});
 }
 
 void WsTransport::close() {
@@ -102,7 +123,7 @@ void WsTransport::close() {
 		return;
 	}
 
-	ThreadPool::Instance().schedule(std::chrono::seconds(10), [weak_this = weak_from_this()]() {
+	ThreadPool::Instance().setTimer(std::chrono::seconds(10), [weak_this = weak_from_this()]() {
 		if (auto locked = weak_this.lock()) {
 			PLOG_DEBUG << "WebSocket close timeout";
 			locked->changeState(State::Disconnected);
@@ -119,13 +140,16 @@ void WsTransport::incoming(message_ptr message) {
 		PLOG_VERBOSE << "Incoming size=" << message->size();
 
 		try {
-			mBuffer.insert(mBuffer.end(), message->begin(), message->end());
-
+			bool buffered = false;
 			if (state() == State::Connecting) {
+				mBuffer.insert(mBuffer.end(), message->begin(), message->end());
+				buffered = true;
+
 				if (mIsClient) {
 					if (size_t len =
 					        mHandshake->parseHttpResponse(mBuffer.data(), mBuffer.size())) {
 						PLOG_INFO << "WebSocket client-side open";
+						initCompression();
 						changeState(State::Connected);
 						mBuffer.erase(mBuffer.begin(), mBuffer.begin() + len);
 					}
@@ -133,6 +157,7 @@ void WsTransport::incoming(message_ptr message) {
 					if (size_t len = mHandshake->parseHttpRequest(mBuffer.data(), mBuffer.size())) {
 						PLOG_INFO << "WebSocket server-side open";
 						sendHttpResponse();
+						initCompression();
 						changeState(State::Connected);
 						mBuffer.erase(mBuffer.begin(), mBuffer.begin() + len);
 					}
@@ -147,6 +172,13 @@ void WsTransport::incoming(message_ptr message) {
 					sendFrame({PING, reinterpret_cast<byte *>(&dummy), 4, true, mIsClient});
 					addOutstandingPing();
 				} else {
+					if (!buffered) {
+						if (mBuffer.empty() && message.use_count() == 1)
+							// Take over the received buffer instead of copying it
+							mBuffer = std::move(static_cast<binary &>(*message));
+						else
+							mBuffer.insert(mBuffer.end(), message->begin(), message->end());
+					}
 					if (mIgnoreLength > 0) {
 						size_t len = std::min(mIgnoreLength, mBuffer.size());
 						mBuffer.erase(mBuffer.begin(), mBuffer.begin() + len);
@@ -154,16 +186,29 @@ void WsTransport::incoming(message_ptr message) {
 					}
 					if (mIgnoreLength == 0) {
 						Frame frame;
-						while (size_t len = parseFrame(mBuffer.data(), mBuffer.size(), frame)) {
-							recvFrame(frame);
-							if (len > mBuffer.size()) {
-								mIgnoreLength = len - mBuffer.size();
+						size_t offset = 0;
+						while (size_t len = parseFrame(mBuffer.data() + offset,
+						                               mBuffer.size() - offset, frame)) {
+							size_t left = mBuffer.size() - offset;
+							if (len > left) {
+								recvFrame(frame);
+								mIgnoreLength = len - left;
+								offset = mBuffer.size();
+								break;
+							}
+							if (len == mBuffer.size()) {
+								// The frame fills the whole buffer, let recvFrame() consume it
+								recvFrame(frame, &mBuffer);
 								mBuffer.clear();
+								offset = 0;
 								break;
 							}
-							mBuffer.erase(mBuffer.begin(), mBuffer.begin() + len);
+							recvFrame(frame);
+							offset += len;
 						}
+						mBuffer.erase(mBuffer.begin(), mBuffer.begin() + offset);
 					}
+					mFlushCallback();
 				}
 			}
 
@@ -252,6 +297,7 @@ size_t WsTransport::parseFrame(byte *buffer, size_t size, Frame &frame) {
 	auto b2 = to_integer<uint8_t>(*cur++);
 
 	frame.fin = (b1 & 0x80) != 0;
+	frame.compressed = (b1 & 0x40) != 0;
 	frame.mask = (b2 & 0x80) != 0;
 	frame.opcode = static_cast<Opcode>(b1 & 0x0F);
 	frame.length = b2 & 0x7F;
@@ -291,16 +337,20 @@ size_t WsTransport::parseFrame(byte *buffer, size_t size, Frame &frame) {
 	frame.payload = cur;
 
 	if (maskingKey)
-		for (size_t i = 0; i < frame.length; ++i)
-			frame.payload[i] ^= maskingKey[i % 4];
+		apply_mask(frame.payload, frame.payload, frame.length, maskingKey);
 
 	return frame.payload + length - buffer; // can be more than buffer size
 }
 
-void WsTransport::recvFrame(const Frame &frame) {
+void WsTransport::recvFrame(const Frame &frame, binary *buffer) {
 	PLOG_DEBUG << "WebSocket received frame: opcode=" << int(frame.opcode)
 	           << ", length=" << frame.length;
 
+	// RFC 7692: The RSV1 bit is set only on the first frame of a compressed message
+	if (frame.compressed &&
+	    (!mDeflate || (frame.opcode != TEXT_FRAME && frame.opcode != BINARY_FRAME)))
+		throw std::runtime_error("Unexpected RSV1 bit in WebSocket frame");
+
 	switch (frame.opcode) {
 	case TEXT_FRAME:
 	case BINARY_FRAME: {
@@ -313,34 +363,50 @@ void WsTransport::recvFrame(const Frame &frame) {
 			PLOG_WARNING << "WebSocket unfinished message: type="
 			             << (mPartialOpcode == TEXT_FRAME ? "text" : "binary")
 			             << ", size=" << mPartial.size();
-			auto type = mPartialOpcode == TEXT_FRAME ? Message::String : Message::Binary;
-			recv(make_message(mPartial.begin(), mPartial.end(), type));
-			mPartial.clear();
+			recvPartial();
 		}
 		mPartialOpcode = frame.opcode;
+		mPartialCompressed = frame.compressed;
 		if (frame.fin) {
 			PLOG_DEBUG << "WebSocket finished message: type="
 			           << (frame.opcode == TEXT_FRAME ? "text" : "binary") << ", size=" << size;
 			auto type = frame.opcode == TEXT_FRAME ? Message::String : Message::Binary;
-			recv(make_message(frame.payload, frame.payload + size, type));
+			if (frame.compressed) {
+				auto data = mDeflate->decompress(frame.payload, size, mMaxMessageSize);
+				recv(make_message(std::move(data), type));
+			} else if (buffer) {
+				// Strip the header in place and hand over the buffer
+				auto header = frame.payload - buffer->data();
+				buffer->erase(buffer->begin(), buffer->begin() + header);
+				buffer->resize(size);
+				recv(make_message(std::move(*buffer), type));
+			} else {
+				recv(make_message(frame.payload, frame.payload + size, type));
+			}
 		} else {
+			mPartial.reserve(size);
 			mPartial.insert(mPartial.end(), frame.payload, frame.payload + size);
 		}
 		break;
 	}
 	case CONTINUATION: {
-		mPartial.insert(mPartial.end(), frame.payload, frame.payload + frame.length);
-		if (mPartial.size() > mMaxMessageSize) {
+		size_t size = frame.length;
+		if (mPartial.size() + size > mMaxMessageSize) {
 			PLOG_WARNING << "WebSocket message is too large, truncating it";
-			mPartial.resize(mMaxMessageSize);
+			size = mMaxMessageSize - std::min(mPartial.size(), mMaxMessageSize);
 		}
+
+		// Reserve from the declared length, growing geometrically for long fragment sequences
+		if (size_t required = mPartial.size() + size; required > mPartial.capacity())
+			mPartial.reserve(
+			    std::max(required, std::min(mPartial.capacity() * 2, mMaxMessageSize)));
+
+		mPartial.insert(mPartial.end(), frame.payload, frame.payload + size);
 		if (frame.fin) {
 			PLOG_DEBUG << "WebSocket finished message: type="
 			           << (frame.opcode == TEXT_FRAME ? "text" : "binary")
 			           << ", size=" << mPartial.size();
-			auto type = mPartialOpcode == TEXT_FRAME ? Message::String : Message::Binary;
-			recv(make_message(mPartial.begin(), mPartial.end(), type));
-			mPartial.clear();
+			recvPartial();
 		}
 		break;
 	}
@@ -368,16 +434,50 @@ void WsTransport::recvFrame(const Frame &frame) {
 	}
 }
 
+void WsTransport::recvPartial() {
+	auto type = mPartialOpcode == TEXT_FRAME ? Message::String : Message::Binary;
+	if (mPartialCompressed)
+		recv(make_message(mDeflate->decompress(mPartial.data(), mPartial.size(), mMaxMessageSize),
+		                  type));
+	else
+		recv(make_message(std::move(mPartial), type));
+
+	mPartial.clear();
+	mPartialCompressed = false;
+}
+
 bool WsTransport::sendFrame(const Frame &frame) {
 	std::lock_guard lock(mSendMutex);
 
 	PLOG_DEBUG << "WebSocket sending frame: opcode=" << int(frame.opcode)
 	           << ", length=" << frame.length;
 
+	return outgoing(BuildFrame(frame));
+}
+
+message_ptr WsTransport::MakeServerFrame(message_ptr message) {
+	const Opcode opcode = message->type == Message::String ? TEXT_FRAME : BINARY_FRAME;
+	return BuildFrame({opcode, message->data(), message->size(), true, false});
+}
+
+bool WsTransport::sendServerFrame(message_ptr frame) {
+	if (state() != State::Connected)
+		throw std::runtime_error("WebSocket is not open");
+
+	if (mIsClient)
+		throw std::logic_error("Client frames must be masked");
+
+	// The frame is shared, lower transports only read it
+	std::lock_guard lock(mSendMutex);
+	PLOG_VERBOSE << "WebSocket sending shared frame, size=" << frame->size();
+	return outgoing(std::move(frame));
+}
+
+message_ptr WsTransport::BuildFrame(const Frame &frame) {
 	byte buffer[14];
 	byte *cur = buffer;
 
-	*cur++ = byte((frame.opcode & 0x0F) | (frame.fin ? 0x80 : 0));
+	*cur++ = byte((frame.opcode & 0x0F) | (frame.fin ? 0x80 : 0) | (frame.compressed ? 0x40 : 0));
 
 	if (frame.length < 0x7E) {
 		*cur++ = byte((frame.length & 0x7F) | (frame.mask ? 0x80 : 0));
@@ -391,24 +491,35 @@ bool WsTransport::sendFrame(const Frame &frame) {
 		cur += 8;
 	}
 
+	const byte *maskingKey = nullptr;
 	if (frame.mask) {
-		byte *maskingKey = reinterpret_cast<byte *>(cur);
-
-		auto u = reinterpret_cast<uint8_t *>(maskingKey);
+		auto u = reinterpret_cast<uint8_t *>(cur);
 		std::generate(u, u + 4, utils::random_bytes_engine());
+		maskingKey = cur;
 		cur += 4;
-
-		for (size_t i = 0; i < frame.length; ++i)
-			frame.payload[i] ^= maskingKey[i % 4];
 	}
 
 	const size_t length = cur - buffer; // header length
 	auto message = make_message(length + frame.length);
 	std::copy(buffer, buffer + length, message->begin()); // header
-	std::copy(frame.payload, frame.payload + frame.length,
-	          message->begin() + length); // payload
 
-	return outgoing(std::move(message));
+	// Mask the payload while copying it, so the caller's buffer is left untouched
+	byte *payload = message->data() + length;
+	if (maskingKey)
+		apply_mask(payload, frame.payload, frame.length, maskingKey);
+	else
+		std::copy(frame.payload, frame.payload + frame.length, payload);
+
+	return message;
+}
+
+void WsTransport::initCompression() {
+	if (auto compression = mHandshake->compression()) {
+		PLOG_DEBUG << "WebSocket compression enabled, windowBits=" << compression->windowBits
+		           << ", contextTakeover=" << compression->contextTakeover;
+		mDeflate =
+		    std::make_unique<WsDeflate>(compression->windowBits, compression->contextTakeover);
+	}
 }
 
 void WsTransport::addOutstandingPing() {
@@ -12,6 +12,7 @@
 #include "common.hpp"
 #include "transport.hpp"
 #include "configuration.hpp"
+#include "wsdeflate.hpp"
 #include "wshandshake.hpp"
 
 #if RTC_ENABLE_WEBSOCKET
@@ -20,14 +21,16 @@
 
 namespace rtc::impl {
 
-class HttpProxyTransport;
+class Http2Stream;
+class ProxyTransport;
 class TcpTransport;
 class TlsTransport;
 
 class WsTransport final : public Transport, public std::enable_shared_from_this<WsTransport> {
 public:
 	using LowerTransport =
-	    variant<shared_ptr<TcpTransport>, shared_ptr<HttpProxyTransport>, shared_ptr<TlsTransport>>;
+	    variant<shared_ptr<TcpTransport>, shared_ptr<ProxyTransport>, shared_ptr<TlsTransport>,
+	            shared_ptr<Http2Stream>>;
 
 	WsTransport(LowerTransport lower, shared_ptr<WsHandshake> handshake,
 	            const WebSocketConfiguration &config, message_callback recvCallback,
@@ -42,6 +45,13 @@ public:
 
 	bool isClient() const { return mIsClient; }
 
+	// Called after the messages of a single read are passed to the receive callback
+	void onFlush(std::function<void()> callback);
+
+	// Server frames are not masked, so a frame built once may be sent to many clients as is
+	static message_ptr MakeServerFrame(message_ptr message);
+	bool sendServerFrame(message_ptr frame); // the frame must come from MakeServerFrame()
+
 private:
 	enum Opcode : uint8_t {
 		CONTINUATION = 0,
@@ -58,6 +68,7 @@ private:
 		size_t length = 0;
 		bool fin = true;
 		bool mask = true;
+		bool compressed = false; // RSV1 bit, set on the first frame of a compressed message
 	};
 
 	bool sendHttpRequest();
@@ -65,23 +76,32 @@ private:
 	bool sendHttpResponse();
 
 	size_t parseFrame(byte *buffer, size_t size, Frame &frame);
-	void recvFrame(const Frame &frame);
+	void recvFrame(const Frame &frame, binary *buffer = nullptr); // buffer may be consumed
+	void recvPartial();
 	bool sendFrame(const Frame &frame);
+	static message_ptr BuildFrame(const Frame &frame);
+	void initCompression();
 
 	void addOutstandingPing();
 
 	const shared_ptr<WsHandshake> mHandshake;
 	const bool mIsClient;
+	const bool mIsHttp2; // the handshake is done by the HTTP/2 stream
 	const size_t mMaxMessageSize;
 	const int mMaxOutstandingPings;
+	const size_t mCompressionThreshold;
 
 	binary mBuffer;
 	binary mPartial;
 	Opcode mPartialOpcode;
+	bool mPartialCompressed = false;
+	unique_ptr<WsDeflate> mDeflate; // set before the transport is connected
+	std::mutex mDeflateMutex;
 	size_t mIgnoreLength = 0;
 	std::mutex mSendMutex;
 	int mOutstandingPings = 0;
 	std::atomic<bool> mCloseSent = false;
+	synchronized_callback<> mFlushCallback;
 };
 
 } // namespace rtc::impl
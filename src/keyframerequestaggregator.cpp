@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "keyframerequestaggregator.hpp"
+
+#include "impl/internals.hpp"
+
+#include <utility>
+
+namespace rtc {
+
+KeyframeRequestAggregator::KeyframeRequestAggregator(std::chrono::milliseconds window)
+    : mWindow(window) {}
+
+bool KeyframeRequestAggregator::requestKeyframe(const message_callback &send) {
+	const auto now = std::chrono::steady_clock::now();
+	optional<std::chrono::steady_clock::time_point> previous;
+	{
+		std::lock_guard lock(mMutex);
+		if (mLastRequest && now < *mLastRequest + mWindow) {
+			++mCoalesced;
+			PLOG_VERBOSE << "Coalesced keyframe request";
+			return true;
+		}
+
+		// Concurrent requests are coalesced while this one is sent
+		previous = std::exchange(mLastRequest, now);
+	}
+
+	if (MediaHandler::requestKeyframe(send))
+		return true;
+
+	std::lock_guard lock(mMutex);
+	if (mLastRequest == now)
+		mLastRequest = previous;
+
+	return false;
+}
+
+void KeyframeRequestAggregator::setWindow(std::chrono::milliseconds window) {
+	std::lock_guard lock(mMutex);
+	mWindow = window;
+}
+
+size_t KeyframeRequestAggregator::coalescedCount() const {
+	std::lock_guard lock(mMutex);
+	return mCoalesced;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
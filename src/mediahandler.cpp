@@ -9,6 +9,7 @@
 #include "mediahandler.hpp"
 
 #include "impl/internals.hpp"
+#include "impl/tracing.hpp"
 
 namespace rtc {
 
@@ -56,6 +57,15 @@ bool MediaHandler::requestBitrate(unsigned int bitrate, const message_callback &
 		return false;
 }
 
+bool MediaHandler::requestRetransmission(const std::vector<uint16_t> &sequenceNumbers,
+                                         const message_callback &send) {
+	// Default implementation is to call next handler
+	if (auto handler = next())
+		return handler->requestRetransmission(sequenceNumbers, send);
+	else
+		return false;
+}
+
 void MediaHandler::mediaChain(const Description::Media &desc) {
 	media(desc);
 
@@ -67,11 +77,17 @@ void MediaHandler::incomingChain(message_vector &messages, const message_callbac
 	if (auto handler = next())
 		handler->incomingChain(messages, send);
 
+	impl::TraceScope scope(TracePoint::MediaIncomingBegin, TracePoint::MediaIncomingEnd, this,
+	                       messages.size());
 	incoming(messages, send);
 }
 
 void MediaHandler::outgoingChain(message_vector &messages, const message_callback &send) {
-	outgoing(messages, send);
+	{
+		impl::TraceScope scope(TracePoint::MediaOutgoingBegin, TracePoint::MediaOutgoingEnd, this,
+		                       messages.size());
+		outgoing(messages, send);
+	}
 
 	if (auto handler = next())
 		return handler->outgoingChain(messages, send);
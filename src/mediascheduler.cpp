@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "mediascheduler.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/threadpool.hpp"
+
+namespace rtc {
+
+MediaScheduler::MediaScheduler(std::chrono::milliseconds maxLag)
+    : mScheduler(std::make_shared<Scheduler>(maxLag)) {}
+
+MediaScheduler::~MediaScheduler() { mScheduler->clear(); }
+
+MediaScheduler::StreamId MediaScheduler::addStream(std::chrono::microseconds interval,
+                                                   FrameCallback callback) {
+	if (interval <= std::chrono::microseconds::zero())
+		throw std::invalid_argument("Frame interval must be positive");
+
+	if (!callback)
+		throw std::invalid_argument("Frame callback is empty");
+
+	return mScheduler->add(interval, std::move(callback));
+}
+
+void MediaScheduler::removeStream(StreamId id) { mScheduler->remove(id); }
+
+size_t MediaScheduler::streamsCount() const { return mScheduler->count(); }
+
+size_t MediaScheduler::resyncCount() const { return mScheduler->resyncCount(); }
+
+MediaScheduler::Scheduler::Scheduler(clock::duration maxLag) : mMaxLag(maxLag) {}
+
+MediaScheduler::StreamId MediaScheduler::Scheduler::add(clock::duration interval,
+                                                        FrameCallback callback) {
+	std::lock_guard lock(mMutex);
+	const auto now = clock::now();
+	const StreamId id = mNextId++;
+	Stream stream;
+	stream.interval = interval;
+	stream.start = now;
+	stream.callback = std::make_shared<FrameCallback>(std::move(callback));
+	mStreams.emplace(id, std::move(stream));
+	mQueue.push(Entry{now, id});
+	schedule(now);
+	return id;
+}
+
+void MediaScheduler::Scheduler::remove(StreamId id) {
+	// The queue entry is skipped when it becomes due
+	std::lock_guard lock(mMutex);
+	mStreams.erase(id);
+}
+
+void MediaScheduler::Scheduler::clear() {
+	std::lock_guard lock(mMutex);
+	mStreams.clear();
+	mQueue = decltype(mQueue)();
+}
+
+size_t MediaScheduler::Scheduler::count() const {
+	std::lock_guard lock(mMutex);
+	return mStreams.size();
+}
+
+size_t MediaScheduler::Scheduler::resyncCount() const {
+	std::lock_guard lock(mMutex);
+	return mResyncCount;
+}
+
+void MediaScheduler::Scheduler::run() {
+	struct Frame {
+		StreamId id;
+		uint64_t index;
+		std::chrono::microseconds time;
+		shared_ptr<FrameCallback> callback;
+		bool keep = true;
+	};
+
+	// Due frames of all streams are delivered by a single task
+	std::vector<Frame> frames;
+	{
+		std::lock_guard lock(mMutex);
+		const auto now = clock::now();
+		if (mScheduled && *mScheduled <= now)
+			mScheduled.reset();
+
+		while (!mQueue.empty() && mQueue.top().time <= now) {
+			Entry entry = mQueue.top();
+			mQueue.pop();
+			auto it = mStreams.find(entry.id);
+			if (it == mStreams.end())
+				continue; // removed
+
+			const auto &stream = it->second;
+			auto elapsed = stream.interval * int64_t(stream.index);
+			if (stream.start + elapsed != entry.time)
+				continue; // stale
+
+			frames.push_back(
+			    Frame{entry.id, stream.index,
+			          std::chrono::duration_cast<std::chrono::microseconds>(elapsed),
+			          stream.callback});
+		}
+	}
+
+	for (auto &frame : frames) {
+		try {
+			frame.keep = (*frame.callback)(frame.index, frame.time);
+		} catch (const std::exception &e) {
+			PLOG_WARNING << "Media scheduler frame callback: " << e.what();
+		}
+	}
+
+	std::lock_guard lock(mMutex);
+	const auto now = clock::now();
+	for (const auto &frame : frames) {
+		auto it = mStreams.find(frame.id);
+		if (it == mStreams.end())
+			continue; // removed while running
+
+		if (!frame.keep) {
+			mStreams.erase(it);
+			continue;
+		}
+
+		// The next frame is due at an absolute time so that timer lateness does not accumulate
+		auto &stream = it->second;
+		++stream.index;
+		auto time = stream.start + stream.interval * int64_t(stream.index);
+		if (now - time > mMaxLag) {
+			PLOG_DEBUG << "Media scheduler stream lagging, resynchronizing";
+			stream.start = now - stream.interval * int64_t(stream.index);
+			time = now;
+			++mResyncCount;
+		}
+		mQueue.push(Entry{time, frame.id});
+	}
+
+	if (!mQueue.empty())
+		schedule(mQueue.top().time);
+}
+
+void MediaScheduler::Scheduler::schedule(clock::time_point time) {
+	// Requires mMutex to be locked
+	if (mScheduled && *mScheduled <= time)
+		return; // a timer will run before
+
+	mScheduled = time;
+	impl::ThreadPool::Instance().setTimer(time, weak_bind(&Scheduler::run, this));
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -8,25 +8,32 @@
 
 #include "message.hpp"
 
+#include "impl/messagepool.hpp"
+
 namespace rtc {
 
 message_ptr make_message(size_t size, Message::Type type, unsigned int stream,
                          shared_ptr<Reliability> reliability) {
-	auto message = std::make_shared<Message>(size, type);
+	auto message = impl::MessagePool::Instance().make(size, type);
 	message->stream = stream;
-	message->reliability = reliability;
+	message->reliability = std::move(reliability);
 	return message;
 }
 
+message_ptr make_message_with_tailroom(size_t size, size_t tailroom, Message::Type type) {
+	return impl::MessagePool::Instance().make(size, type, tailroom);
+}
+
 message_ptr make_message(binary &&data, Message::Type type, unsigned int stream, shared_ptr<Reliability> reliability) {
-	auto message = std::make_shared<Message>(std::move(data), type);
+	auto message = impl::MessagePool::Instance().make(std::move(data), type);
 	message->stream = stream;
-	message->reliability = reliability;
+	message->reliability = std::move(reliability);
 	return message;
 }
+
 message_ptr make_message(binary &&data, shared_ptr<FrameInfo> frameInfo) {
-	auto message = std::make_shared<Message>(std::move(data));
-	message->frameInfo = frameInfo;
+	auto message = impl::MessagePool::Instance().make(std::move(data), Message::Binary);
+	message->frameInfo = std::move(frameInfo);
 	return message;
 }
 
@@ -34,7 +41,7 @@ message_ptr make_message(size_t size, message_ptr orig) {
 	if (!orig)
 		return nullptr;
 
-	auto message = std::make_shared<Message>(size, orig->type);
+	auto message = impl::MessagePool::Instance().make(size, orig->type);
 	std::copy(orig->begin(), orig->begin() + std::min(size, orig->size()), message->begin());
 	message->stream = orig->stream;
 	message->reliability = orig->reliability;
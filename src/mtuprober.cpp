@@ -0,0 +1,223 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "mtuprober.hpp"
+#include "rtp.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace rtc {
+
+namespace {
+
+// Common path MTUs, for instance with tunnels or PPPoE below Ethernet
+const size_t CandidateMtus[] = {1360, 1400, 1440, 1480, 1492, 1500};
+
+} // namespace
+
+MtuProber::MtuProber(shared_ptr<RtpPacketizationConfig> rtpConfig, mtu_callback onMtu,
+                     size_t baseMtu, size_t maxMtu)
+    : mRtpConfig(std::move(rtpConfig)), mOnMtu(std::move(onMtu)), mMtu(baseMtu) {
+	if (!mRtpConfig)
+		throw std::invalid_argument("MTU prober requires an RTP configuration");
+
+	if (baseMtu < 576) // Min MTU for IPv4
+		throw std::invalid_argument("Invalid base MTU value");
+
+	for (size_t mtu : CandidateMtus)
+		if (mtu > baseMtu && mtu <= maxMtu)
+			mCandidates.push_back(mtu);
+
+	if (maxMtu > baseMtu && (mCandidates.empty() || mCandidates.back() < maxMtu))
+		mCandidates.push_back(maxMtu);
+
+	mConfirmedSize = baseMtu - DatagramOverhead;
+}
+
+void MtuProber::media(const Description::Media &desc) {
+	const auto rtxSsrc = desc.getRtxSSRC(mRtpConfig->ssrc);
+	const auto rtxPayloadType = desc.getRtxPayloadType(mRtpConfig->payloadType);
+
+	std::lock_guard lock(mMutex);
+	if (!rtxSsrc || !rtxPayloadType) {
+		mRtxSsrc.reset();
+		return;
+	}
+
+	if (mRtxSsrc != rtxSsrc) {
+		// RFC 3550: The initial value of the sequence number SHOULD be random
+		auto engine = impl::utils::random_engine();
+		mRtxSequenceNumber = uint16_t(std::uniform_int_distribution<uint32_t>(0, 0xFFFF)(engine));
+	}
+	mRtxSsrc = rtxSsrc;
+	mRtxPayloadType = uint8_t(*rtxPayloadType);
+}
+
+void MtuProber::outgoing(message_vector &messages, const message_callback &) {
+	std::lock_guard lock(mMutex);
+	if (mFragmentSize > 0) {
+		// The packetizer runs on the same thread before the prober
+		mRtpConfig->maxFragmentSize = mFragmentSize;
+		mFragmentSize = 0;
+	}
+
+	const Message *largest = nullptr;
+	for (const auto &message : messages) {
+		if (message->type != Message::Binary || message->size() < sizeof(RtpHeader))
+			continue;
+
+		auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+		const size_t headerSize = rtp->getSize() + rtp->getExtensionHeaderSize();
+		if (rtp->version() != 2 || rtp->padding() || headerSize > message->size())
+			continue;
+
+		mMaxHeaderSize = std::max(mMaxHeaderSize, headerSize);
+		if (!largest || message->size() > largest->size())
+			largest = message.get();
+	}
+
+	// The packet is copied as it will be encrypted in place by the transport
+	if (largest)
+		mTemplate.assign(largest->begin(), largest->end());
+
+	const auto now = clock::now();
+	if (mCompleted) {
+		if (now - *mCompleted < RaiseInterval)
+			return;
+
+		// RFC 8899 5.2. Probe again for a larger MTU
+		mCompleted.reset();
+		mFailures = 0;
+	}
+
+	if (mCandidate >= mCandidates.size() || now - mLastProbe < ProbeInterval)
+		return;
+
+	if (mProbeSize > 0) {
+		// The previous probe was neither acknowledged nor reported as lost in time
+		mProbeSize = 0;
+		if (++mFailures >= MaxProbes) {
+			complete(now);
+			return;
+		}
+	}
+
+	probe(messages, now);
+}
+
+void MtuProber::feedback(const std::vector<TwccHandler::PacketResult> &results) {
+	optional<size_t> changed;
+	{
+		std::lock_guard lock(mMutex);
+		const auto now = clock::now();
+		for (const auto &result : results) {
+			if (result.size == 0) // unknown packet
+				continue;
+
+			if (result.received) {
+				mConfirmedSize = std::max(mConfirmedSize, result.size);
+				if (mProbeSize > 0 && result.size >= mProbeSize) {
+					mProbeSize = 0;
+					mFailures = 0;
+				}
+			} else if (mProbeSize > 0 && result.size >= mProbeSize) {
+				mProbeSize = 0;
+				if (++mFailures >= MaxProbes)
+					complete(now);
+			}
+		}
+
+		// Skip the candidates confirmed, by probes or by media packets
+		const size_t confirmedMtu = mConfirmedSize + DatagramOverhead;
+		while (mCandidate < mCandidates.size() &&
+		       confirmedMtu + ExtensionsMargin >= mCandidates[mCandidate])
+			++mCandidate;
+
+		if (confirmedMtu > mMtu) {
+			mMtu = confirmedMtu;
+			changed = confirmedMtu;
+
+			// Keep room for the largest header, and for extensions added after the prober
+			const size_t overhead = mMaxHeaderSize + ExtensionsMargin;
+			if (mConfirmedSize > overhead + RTC_DEFAULT_MAX_FRAGMENT_SIZE)
+				mFragmentSize = mConfirmedSize - overhead;
+
+			PLOG_DEBUG << "Path MTU raised to " << confirmedMtu;
+		}
+
+		if (mCandidate >= mCandidates.size() && !mCompleted)
+			complete(now);
+	}
+
+	if (changed && mOnMtu)
+		mOnMtu(*changed);
+}
+
+size_t MtuProber::mtu() const {
+	std::lock_guard lock(mMutex);
+	return mMtu;
+}
+
+bool MtuProber::isSearching() const {
+	std::lock_guard lock(mMutex);
+	return !mCompleted && mCandidate < mCandidates.size();
+}
+
+void MtuProber::probe(message_vector &messages, clock::time_point now) {
+	if (mTemplate.empty() || !mRtxSsrc)
+		return;
+
+	// RTP padding is limited, so the probe might need several steps to reach the candidate
+	const size_t size = mTemplate.size() + sizeof(uint16_t); // with the original sequence number
+	const size_t target = mCandidates[mCandidate] - DatagramOverhead - ExtensionsMargin;
+	if (target <= size)
+		return; // media packets will confirm it
+
+	// RFC 4588 4. RTP Payload Format: the original sequence number precedes the original payload,
+	// and the probe has its own sequence number so SRTP replay protection does not drop it
+	auto original = reinterpret_cast<const RtpHeader *>(mTemplate.data());
+	const size_t headerSize = original->getSize() + original->getExtensionHeaderSize();
+	const size_t probeSize = std::min(target, size + MaxPaddingSize);
+	auto probe = make_message_with_tailroom(probeSize, DEFAULT_MEDIA_TAILROOM, Message::Binary);
+	auto rtx = reinterpret_cast<RtpRtx *>(probe->data());
+	std::memcpy(probe->data(), mTemplate.data(), headerSize);
+	std::memcpy(rtx->getBody(), mTemplate.data() + headerSize, mTemplate.size() - headerSize);
+	std::memset(probe->data() + size, 0, probeSize - size);
+	rtx->setOriginalSeqNo(original->seqNumber());
+	rtx->header.setSsrc(*mRtxSsrc);
+	rtx->header.setPayloadType(mRtxPayloadType);
+	rtx->header.setSeqNumber(mRtxSequenceNumber++);
+	if (probeSize > size) {
+		rtx->header.setPadding(true);
+		probe->back() = byte(probeSize - size); // RTP padding count
+	}
+
+	// The receiver drops the retransmission as a duplicate, after accounting for it in feedback
+	messages.push_back(std::move(probe));
+	mProbeSize = probeSize;
+	mLastProbe = now;
+	PLOG_VERBOSE << "Probing path MTU " << mCandidates[mCandidate] << ", probe size "
+	             << probeSize;
+}
+
+void MtuProber::complete(clock::time_point now) {
+	mCompleted = now;
+	mProbeSize = 0;
+	PLOG_DEBUG << "Path MTU search complete, MTU=" << mMtu;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -11,55 +11,602 @@
 #include <memory>
 
 #include "pacinghandler.hpp"
+#include "rtp.hpp"
 
 #include "impl/internals.hpp"
 #include "impl/threadpool.hpp"
+#include "impl/utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
 
 namespace rtc {
 
-PacingHandler::PacingHandler(double bitsPerSecond, std::chrono::milliseconds sendInterval)
-    : mBytesPerSecond(bitsPerSecond / 8), mBudget(0.), mSendInterval(sendInterval) {};
+namespace {
+
+// Padding-only packets carry at most 255 bytes of padding, keep them small like other
+// implementations so that padding does not overshoot the budget much
+const size_t MaxPaddingSize = 224;
+
+} // namespace
+
+PacingHandler::PacingHandler(double bitsPerSecond, std::chrono::milliseconds sendInterval,
+                             optional<std::chrono::milliseconds> maxQueueDelay)
+    : PacingHandler(std::make_shared<Pacer>(
+          bitsPerSecond, sendInterval,
+          maxQueueDelay ? std::make_optional<clock::duration>(*maxQueueDelay) : nullopt),
+      nullopt) {}
+
+PacingHandler::PacingHandler(shared_ptr<Pacer> pacer, optional<Priority> priority)
+    : mPacer(std::move(pacer)), mPriority(priority) {}
 
-void PacingHandler::schedule(const message_callback &send) {
-	if (!mHaveScheduled.exchange(true))
-		impl::ThreadPool::Instance().schedule(mSendInterval,
-		                                      weak_bind(&PacingHandler::run, this, send));
+PacingHandler::~PacingHandler() { mPacer->removeOwner(this); }
+
+shared_ptr<PacingHandler> PacingHandler::fork(optional<Priority> priority) const {
+	return shared_ptr<PacingHandler>(new PacingHandler(mPacer, priority));
 }
 
-void PacingHandler::run(const message_callback &send) {
-	const std::lock_guard<std::mutex> lock(mMutex);
-	mHaveScheduled.store(false);
-
-	// Update the budget and cap it
-	auto now = std::chrono::high_resolution_clock::now();
-	auto newBudget = std::chrono::duration<double>(now - mLastRun).count() * mBytesPerSecond;
-	auto maxBudget = std::chrono::duration<double>(mSendInterval).count() * mBytesPerSecond;
-	mBudget = std::min(mBudget + newBudget, maxBudget);
-	mLastRun = std::chrono::high_resolution_clock::now();
-
-	// Send packets while there is budget, allow a single partial packet over budget
-	while (!mRtpBuffer.empty() && mBudget > 0) {
-		auto size = int(mRtpBuffer.front()->size());
-		send(std::move(mRtpBuffer.front()));
-		mRtpBuffer.pop();
-		mBudget -= size;
-	}
+void PacingHandler::media(const Description::Media &desc) {
+	std::vector<uint8_t> rtxPayloadTypes;
+	optional<uint8_t> rtxPayloadType;
+	for (int pt : desc.payloadTypes())
+		if (auto rtxPt = desc.getRtxPayloadType(pt)) {
+			rtxPayloadTypes.push_back(uint8_t(*rtxPt));
+			if (!rtxPayloadType)
+				rtxPayloadType = uint8_t(*rtxPt);
+		}
+
+	optional<SSRC> rtxSsrc;
+	for (auto ssrc : desc.getSSRCs())
+		if ((rtxSsrc = desc.getRtxSSRC(ssrc)))
+			break;
 
-	if (!mRtpBuffer.empty()) {
-		schedule(send);
+	const bool isAudio = desc.type() == "audio";
+	mIsAudio = isAudio;
+
+	bool padding = false;
+	{
+		std::lock_guard lock(mMutex);
+		mRtxPayloadTypes = std::move(rtxPayloadTypes);
+		if (!isAudio && rtxSsrc && rtxPayloadType) {
+			if (mRtxSsrc != rtxSsrc) {
+				// RFC 3550: The initial value of the sequence number SHOULD be random
+				auto engine = impl::utils::random_engine();
+				mRtxSequenceNumber = uint16_t(std::uniform_int_distribution<uint32_t>()(engine));
+			}
+			mRtxSsrc = rtxSsrc;
+			mRtxPayloadType = *rtxPayloadType;
+			padding = true;
+		} else {
+			mRtxSsrc.reset();
+		}
 	}
+
+	if (padding)
+		mPacer->addPaddingSource(weak_from_this());
 }
 
 void PacingHandler::outgoing(message_vector &messages, const message_callback &send) {
+	const auto now = std::chrono::steady_clock::now();
+	std::vector<Priority> priorities;
+	priorities.reserve(messages.size());
+	Limits limits;
+	{
+		std::lock_guard lock(mMutex);
+		size_t kept = 0;
+		for (auto &m : messages) {
+			const auto priority = classify(m);
+			if (priority == Priority::Video && m->frameInfo && m->frameInfo->keyframe) {
+				mKeyframesMarked = true;
+				mWaitingKeyframe = false;
+			}
+
+			// Frames can't be decoded after a dropped reference frame until the next keyframe
+			if (priority == Priority::Video && mWaitingKeyframe)
+				continue;
+
+			priorities.push_back(priority);
+			auto &message = messages[kept++];
+			if (&message != &m)
+				message = std::move(m);
+
+			if (!mRtxSsrc || message->type == Message::Control ||
+			    message->size() < sizeof(RtpHeader))
+				continue;
 
-	std::lock_guard<std::mutex> lock(mMutex);
+			// Padding shares the RTX stream, so retransmissions are numbered here too
+			auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+			if (rtp->ssrc() == *mRtxSsrc)
+				rtp->setSeqNumber(mRtxSequenceNumber++);
+			else if (priorities.back() == Priority::Video)
+				mLastTimestamp = rtp->timestamp();
+		}
 
-	for (auto &m : messages) {
-		mRtpBuffer.push(std::move(m));
+		if (const size_t dropped = messages.size() - kept; dropped > 0) {
+			PLOG_VERBOSE << "Dropped " << dropped << " packets waiting for a keyframe";
+			messages.resize(kept);
+		}
+
+		if (mRtxSsrc)
+			mSend = send;
+
+		limits = mLimits;
 	}
+
+	for (size_t i = 0; i < messages.size(); ++i)
+		mPacer->enqueue(priorities[i], Entry{std::move(messages[i]), send, now, this});
+
 	messages.clear();
 
-	schedule(send);
+	if ((limits.maxBytes || limits.maxDelay) && mPacer->limit(this, limits) && !mIsAudio) {
+		{
+			std::lock_guard lock(mMutex);
+			mWaitingKeyframe = mKeyframesMarked;
+		}
+		mOnKeyframeNeeded();
+	}
+}
+
+void PacingHandler::setQueueLimits(optional<size_t> maxBytes,
+                                   optional<std::chrono::milliseconds> maxDelay) {
+	std::lock_guard lock(mMutex);
+	mLimits.maxBytes = maxBytes;
+	mLimits.maxDelay = maxDelay ? std::make_optional<clock::duration>(*maxDelay) : nullopt;
+}
+
+void PacingHandler::onKeyframeNeeded(std::function<void()> callback) {
+	mOnKeyframeNeeded = std::move(callback);
+}
+
+void PacingHandler::setBitrate(double bitsPerSecond) { mPacer->setBitrate(bitsPerSecond); }
+
+void PacingHandler::probe(double bitsPerSecond, std::chrono::milliseconds duration) {
+	mPacer->probe(bitsPerSecond, duration);
+}
+
+void PacingHandler::setPaddingBitrate(double bitsPerSecond) {
+	mPacer->setPaddingBitrate(bitsPerSecond);
+}
+
+void PacingHandler::setPaddingHandler(shared_ptr<MediaHandler> handler) {
+	std::lock_guard lock(mMutex);
+	mPaddingHandler = std::move(handler);
+}
+
+size_t PacingHandler::droppedCount() const { return mPacer->droppedCount(); }
+
+size_t PacingHandler::paddingBytes() const { return mPacer->paddingBytes(); }
+
+PacingHandler::Priority PacingHandler::classify(const message_ptr &message) const {
+	// Requires mMutex to be locked
+	if (mPriority)
+		return *mPriority;
+
+	if (message->type == Message::Control || message->size() < sizeof(RtpHeader))
+		return Priority::Audio;
+
+	auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+	if (std::find(mRtxPayloadTypes.begin(), mRtxPayloadTypes.end(), rtp->payloadType()) !=
+	    mRtxPayloadTypes.end())
+		return Priority::Retransmission;
+
+	if (rtp->padding()) {
+		// Padding-only packets are used for probing
+		size_t headerSize = rtp->getSize();
+		if (rtp->extension() && headerSize + sizeof(RtpExtensionHeader) <= message->size())
+			headerSize += rtp->getExtensionHeaderSize();
+
+		const size_t paddingSize = std::to_integer<uint8_t>(message->back());
+		if (headerSize <= message->size() && message->size() - headerSize == paddingSize)
+			return Priority::Padding;
+	}
+
+	return mIsAudio ? Priority::Audio : Priority::Video;
+}
+
+std::vector<PacingHandler::Entry> PacingHandler::generatePadding(size_t size) {
+	message_vector messages;
+	message_callback send;
+	shared_ptr<MediaHandler> handler;
+	{
+		std::lock_guard lock(mMutex);
+		if (!mRtxSsrc || !mSend)
+			return {};
+
+		// RFC 4588: Padding-only packets on the RTX stream have no original sequence number
+		const size_t count = (size + MaxPaddingSize - 1) / MaxPaddingSize;
+		messages.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			auto message = make_message_with_tailroom(sizeof(RtpHeader) + MaxPaddingSize,
+			                                          DEFAULT_MEDIA_TAILROOM, Message::Binary);
+			std::memset(message->data(), 0, message->size());
+			auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+			rtp->preparePacket();
+			rtp->setPadding(true);
+			rtp->setPayloadType(mRtxPayloadType);
+			rtp->setSsrc(*mRtxSsrc);
+			rtp->setSeqNumber(mRtxSequenceNumber++);
+			rtp->setTimestamp(mLastTimestamp);
+			message->back() = byte(MaxPaddingSize);
+			messages.push_back(std::move(message));
+		}
+
+		send = mSend;
+		handler = mPaddingHandler;
+	}
+
+	if (handler)
+		handler->outgoing(messages, send);
+
+	const auto now = clock::now();
+	std::vector<Entry> entries;
+	entries.reserve(messages.size());
+	for (auto &message : messages)
+		entries.push_back(Entry{std::move(message), send, now, this});
+
+	return entries;
+}
+
+PacingHandler::Pacer::Pacer(double bitsPerSecond, clock::duration sendInterval,
+                            optional<clock::duration> maxQueueDelay)
+    : mSendInterval(sendInterval), mMaxQueueDelay(maxQueueDelay),
+      mBytesPerSecond(bitsPerSecond / 8), mLastRefill(clock::now()) {}
+
+void PacingHandler::Pacer::enqueue(Priority priority, Entry entry) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	mQueues[size_t(priority)].push_back(std::move(entry));
+	schedule(clock::now());
+}
+
+void PacingHandler::Pacer::setBitrate(double bitsPerSecond) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	refill(clock::now()); // the budget so far is accounted at the previous rate
+	mBytesPerSecond = bitsPerSecond / 8;
+}
+
+void PacingHandler::Pacer::probe(double bitsPerSecond, clock::duration duration) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	const auto now = clock::now();
+	refill(now);
+	mProbe = Probe{bitsPerSecond / 8, now + duration};
+	PLOG_VERBOSE << "Starting probe cluster at " << bitsPerSecond << " bps";
+	schedule(now);
+}
+
+void PacingHandler::Pacer::setPaddingBitrate(double bitsPerSecond) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	const auto now = clock::now();
+	refill(now);
+	mPaddingBytesPerSecond = bitsPerSecond / 8;
+	schedule(now);
+}
+
+void PacingHandler::Pacer::addPaddingSource(weak_ptr<MediaHandler> source) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	auto it = std::find_if(mPaddingSources.begin(), mPaddingSources.end(),
+	                       [&](const weak_ptr<MediaHandler> &other) {
+		                       return !other.owner_before(source) && !source.owner_before(other);
+	                       });
+	if (it == mPaddingSources.end())
+		mPaddingSources.push_back(std::move(source));
+
+	schedule(clock::now());
+}
+
+void PacingHandler::Pacer::removeOwner(const PacingHandler *owner) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	mLastFrames.erase(owner);
+}
+
+bool PacingHandler::Pacer::limit(const PacingHandler *owner, const Limits &limits) {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	const auto now = clock::now();
+
+	struct Frame {
+		std::pair<SSRC, uint32_t> id;
+		size_t size = 0;
+		clock::time_point time;
+		uint8_t layer = 0;
+		bool keyframe = false;
+		bool dropped = false;
+	};
+
+	// The frame being sent can't be dropped without sending a partial frame
+	optional<std::pair<SSRC, uint32_t>> started;
+	if (auto it = mLastFrames.find(owner); it != mLastFrames.end())
+		started = it->second;
+
+	std::vector<Frame> frames;
+	size_t bytes = 0;
+	optional<clock::time_point> startedTime;
+	for (auto priority : {Priority::Audio, Priority::Video}) {
+		for (const auto &entry : mQueues[size_t(priority)]) {
+			const auto &message = entry.message;
+			if (entry.owner != owner || message->type == Message::Control ||
+			    message->size() < sizeof(RtpHeader))
+				continue;
+
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			const auto id = std::make_pair(rtp->ssrc(), rtp->timestamp());
+			bytes += message->size();
+			if (id == started) {
+				startedTime = startedTime ? std::min(*startedTime, entry.time) : entry.time;
+				continue;
+			}
+
+			// Packets of a frame are contiguous, so search from the back
+			auto it = std::find_if(frames.rbegin(), frames.rend(),
+			                       [&](const Frame &frame) { return frame.id == id; });
+			auto &frame = it != frames.rend() ? *it : frames.emplace_back();
+			if (frame.size == 0) {
+				frame.id = id;
+				frame.time = entry.time;
+				if (const auto &info = message->frameInfo) {
+					frame.layer = info->temporalLayer.value_or(0);
+					frame.keyframe = info->keyframe;
+				}
+			}
+			frame.size += message->size();
+		}
+	}
+
+	auto exceeded = [&]() {
+		if (limits.maxBytes && bytes > *limits.maxBytes)
+			return true;
+
+		if (!limits.maxDelay)
+			return false;
+
+		auto oldest = startedTime;
+		for (const auto &frame : frames)
+			if (!frame.dropped && (!oldest || frame.time < *oldest))
+				oldest = frame.time;
+
+		return oldest && now - *oldest > *limits.maxDelay;
+	};
+
+	auto dropFrame = [&](Frame &frame) {
+		frame.dropped = true;
+		bytes -= frame.size;
+	};
+
+	bool reference = false;
+	while (exceeded()) {
+		// Frames of the highest temporal layer are not a reference for others, oldest first
+		Frame *frame = nullptr;
+		for (auto &f : frames)
+			if (!f.dropped && f.layer > 0 && (!frame || f.layer > frame->layer))
+				frame = &f;
+
+		if (frame) {
+			dropFrame(*frame);
+			continue;
+		}
+
+		// Dropping a reference frame makes the next ones useless until a keyframe, so frames are
+		// dropped from the oldest up to the next queued keyframe, which can still be decoded
+		auto it = std::find_if(frames.begin(), frames.end(),
+		                       [](const Frame &f) { return !f.dropped; });
+		if (it == frames.end())
+			break;
+
+		dropFrame(*it);
+		for (++it; it != frames.end() && !it->keyframe; ++it)
+			if (!it->dropped)
+				dropFrame(*it);
+
+		// Without a queued keyframe, the encoder must send one
+		if (it == frames.end())
+			reference = true;
+	}
+
+	std::vector<std::pair<SSRC, uint32_t>> dropped;
+	for (const auto &frame : frames)
+		if (frame.dropped)
+			dropped.push_back(frame.id);
+
+	if (!dropped.empty()) {
+		PLOG_DEBUG << "Pacer dropped " << dropped.size() << " frames over the queue limits";
+		drop(dropped, owner);
+	}
+
+	return reference;
+}
+
+size_t PacingHandler::Pacer::droppedCount() const {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	return mDropped;
+}
+
+size_t PacingHandler::Pacer::paddingBytes() const {
+	const std::lock_guard<std::mutex> lock(mMutex);
+	return mPaddingBytes;
+}
+
+void PacingHandler::Pacer::schedule(clock::time_point now) {
+	// Requires mMutex to be locked
+	if (mScheduled)
+		return;
+
+	const bool empty =
+	    std::all_of(mQueues.begin(), mQueues.end(), [](const auto &q) { return q.empty(); });
+	if (empty && !isPadding())
+		return;
+
+	// Run as soon as the budget allows it, the time is absolute so that errors don't accumulate
+	refill(now);
+	auto time = empty ? now + mSendInterval : now;
+	if (mBudget < 0.) {
+		if (mBytesPerSecond > 0.)
+			time += std::chrono::duration_cast<clock::duration>(
+			    std::chrono::duration<double>(-mBudget / mBytesPerSecond));
+		else
+			time += mSendInterval;
+	}
+
+	mScheduled = true;
+	impl::ThreadPool::Instance().setTimer(time, weak_bind(&Pacer::run, this));
+}
+
+void PacingHandler::Pacer::refill(clock::time_point now) {
+	// Requires mMutex to be locked
+	const double elapsed = std::chrono::duration<double>(now - mLastRefill).count();
+	const double interval = std::chrono::duration<double>(mSendInterval).count();
+	const double probeRate = mProbe ? mProbe->bytesPerSecond : 0.;
+	const double rate = std::max(mBytesPerSecond, probeRate);
+	const double paddingRate = mProbe ? probeRate : mPaddingBytesPerSecond;
+	if (elapsed > 0.) {
+		mBudget = std::min(mBudget + elapsed * rate, interval * rate);
+		mPaddingBudget = std::clamp(mPaddingBudget + elapsed * paddingRate,
+		                            -interval * paddingRate, interval * paddingRate);
+	}
+
+	if (mProbe && now >= mProbe->end)
+		mProbe.reset();
+
+	mLastRefill = now;
+}
+
+bool PacingHandler::Pacer::isPadding() const {
+	// Requires mMutex to be locked
+	return (mProbe || mPaddingBytesPerSecond > 0.) && !mPaddingSources.empty();
+}
+
+shared_ptr<PacingHandler> PacingHandler::Pacer::nextPaddingSource() {
+	// Requires mMutex to be locked
+	mPaddingSources.erase(std::remove_if(mPaddingSources.begin(), mPaddingSources.end(),
+	                                     [](const auto &source) { return source.expired(); }),
+	                      mPaddingSources.end());
+
+	// Padding is spread over tracks in turn
+	if (mPaddingSources.empty())
+		return nullptr;
+
+	auto source = mPaddingSources[mNextPaddingSource++ % mPaddingSources.size()].lock();
+	return std::static_pointer_cast<PacingHandler>(source);
+}
+
+void PacingHandler::Pacer::dropStale(clock::time_point now) {
+	// Requires mMutex to be locked
+	if (!mMaxQueueDelay)
+		return;
+
+	for (auto &queue : mQueues) {
+		if (queue.empty() || now - queue.front().time <= *mMaxQueueDelay)
+			continue;
+
+		if (&queue == &mQueues[size_t(Priority::Data)]) {
+			// SCTP packets are not RTP, the association will retransmit them
+			auto it = std::find_if(queue.begin(), queue.end(), [&](const Entry &entry) {
+				return now - entry.time <= *mMaxQueueDelay;
+			});
+			const size_t dropped = size_t(it - queue.begin());
+			queue.erase(queue.begin(), it);
+			mDropped += dropped;
+			PLOG_DEBUG << "Pacer dropped " << dropped << " stale SCTP packets";
+			continue;
+		}
+
+		// Drop stale packets and the rest of their frames, which would be useless
+		std::vector<std::pair<SSRC, uint32_t>> frames;
+		auto it = std::remove_if(queue.begin(), queue.end(), [&](const Entry &entry) {
+			const auto &message = entry.message;
+			if (message->type == Message::Control || message->size() < sizeof(RtpHeader))
+				return now - entry.time > *mMaxQueueDelay;
+
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			auto frame = std::make_pair(rtp->ssrc(), rtp->timestamp());
+			if (now - entry.time > *mMaxQueueDelay) {
+				if (std::find(frames.begin(), frames.end(), frame) == frames.end())
+					frames.push_back(frame);
+
+				return true;
+			}
+			return std::find(frames.begin(), frames.end(), frame) != frames.end();
+		});
+
+		const size_t dropped = size_t(queue.end() - it);
+		queue.erase(it, queue.end());
+		mDropped += dropped;
+		PLOG_DEBUG << "Pacer dropped " << dropped << " stale packets";
+	}
+}
+
+void PacingHandler::Pacer::drop(const std::vector<std::pair<SSRC, uint32_t>> &frames,
+                                const PacingHandler *owner) {
+	// Requires mMutex to be locked
+	for (auto priority : {Priority::Audio, Priority::Video}) {
+		auto &queue = mQueues[size_t(priority)];
+		auto it = std::remove_if(queue.begin(), queue.end(), [&](const Entry &entry) {
+			const auto &message = entry.message;
+			if (entry.owner != owner || message->type == Message::Control ||
+			    message->size() < sizeof(RtpHeader))
+				return false;
+
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			return std::find(frames.begin(), frames.end(),
+			                 std::make_pair(rtp->ssrc(), rtp->timestamp())) != frames.end();
+		});
+		mDropped += size_t(queue.end() - it);
+		queue.erase(it, queue.end());
+	}
+}
+
+void PacingHandler::Pacer::run() {
+	std::vector<Entry> entries;
+	shared_ptr<PacingHandler> paddingSource;
+	size_t paddingSize = 0;
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		const auto now = clock::now();
+		refill(now);
+		dropStale(now);
+
+		// Send packets by priority while there is budget, allow a single partial packet over
+		// budget
+		for (auto &queue : mQueues) {
+			while (!queue.empty() && mBudget > 0.) {
+				const auto &front = queue.front();
+				const double size = double(front.message->size());
+				mBudget -= size;
+				mPaddingBudget -= size;
+				if (front.owner && &queue != &mQueues[size_t(Priority::Data)] &&
+				    front.message->type != Message::Control &&
+				    front.message->size() >= sizeof(RtpHeader)) {
+					auto rtp = reinterpret_cast<const RtpHeader *>(front.message->data());
+					mLastFrames[front.owner] = std::make_pair(rtp->ssrc(), rtp->timestamp());
+				}
+				entries.push_back(std::move(queue.front()));
+				queue.pop_front();
+			}
+		}
+
+		// Fill the budget left with padding, media counting towards the padding rate
+		if (mBudget > 0. && mPaddingBudget > 0. && isPadding()) {
+			paddingSize = size_t(std::min(mBudget, mPaddingBudget));
+			paddingSource = nextPaddingSource();
+		}
+	}
+
+	// Send outside of the lock so enqueuing is not blocked by the transport, the run stays
+	// scheduled meanwhile so packets can't be reordered by a concurrent run
+	for (auto &entry : entries)
+		entry.send(std::move(entry.message));
+
+	size_t paddingSent = 0;
+	if (paddingSource)
+		for (auto &entry : paddingSource->generatePadding(paddingSize)) {
+			paddingSent += entry.message->size();
+			entry.send(std::move(entry.message));
+		}
+
+	const std::lock_guard<std::mutex> lock(mMutex);
+	mBudget -= double(paddingSent);
+	mPaddingBudget -= double(paddingSent);
+	mPaddingBytes += paddingSent;
+	mScheduled = false;
+	schedule(clock::now());
 }
 
 } // namespace rtc
@@ -75,6 +75,14 @@ optional<Description> PeerConnection::remoteDescription() const {
 
 size_t PeerConnection::remoteMaxMessageSize() const { return impl()->remoteMaxMessageSize(); }
 
+size_t PeerConnection::pathMtu() const { return impl()->pathMtu(); }
+
+void PeerConnection::setPathMtu(size_t mtu) { impl()->setPathMtu(mtu); }
+
+void PeerConnection::setDataChannelPacer(shared_ptr<MediaHandler> pacer) {
+	impl()->setDataChannelPacer(std::move(pacer));
+}
+
 bool PeerConnection::hasMedia() const {
 	auto local = localDescription();
 	return local && local->hasAudioOrVideo();
@@ -256,12 +264,16 @@ void PeerConnection::setRemoteDescription(Description description) {
 
 	iceTransport->setRemoteDescription(description); // ICE transport might reject the description
 
+	// The cached candidate only matters to the initial connection, not to renegotiations
+	const bool initial = !impl()->remoteDescription();
 	impl()->processRemoteDescription(std::move(description));
 	impl()->changeSignalingState(newSignalingState);
+	if (initial)
+		impl()->prioritizeCachedCandidate(remoteCandidates);
 	signalingLock.unlock();
 
-	for (const auto &candidate : remoteCandidates)
-		addRemoteCandidate(candidate);
+	if (!remoteCandidates.empty())
+		addRemoteCandidates(std::move(remoteCandidates));
 
 	if (!impl()->config.disableAutoNegotiation) {
 		switch (newSignalingState) {
@@ -288,6 +300,12 @@ void PeerConnection::addRemoteCandidate(Candidate candidate) {
 	impl()->processRemoteCandidate(std::move(candidate));
 }
 
+void PeerConnection::addRemoteCandidates(std::vector<Candidate> candidates) {
+	std::unique_lock signalingLock(impl()->signalingMutex);
+	PLOG_VERBOSE << "Adding " << candidates.size() << " remote candidates";
+	impl()->processRemoteCandidates(std::move(candidates));
+}
+
 Description PeerConnection::createOffer() {
 	auto iceTransport = impl()->initIceTransport();
 	if (!iceTransport)
@@ -339,6 +357,24 @@ shared_ptr<DataChannel> PeerConnection::createDataChannel(string label, DataChan
 	return channel;
 }
 
+std::vector<shared_ptr<DataChannel>>
+PeerConnection::createNegotiatedDataChannels(std::vector<string> labels, DataChannelInit init) {
+	auto channelImpls = impl()->emplaceNegotiatedDataChannels(std::move(labels), std::move(init));
+	std::vector<shared_ptr<DataChannel>> channels;
+	channels.reserve(channelImpls.size());
+	for (auto &channelImpl : channelImpls)
+		channels.push_back(std::make_shared<DataChannel>(std::move(channelImpl)));
+
+	if (!impl()->config.disableAutoNegotiation &&
+	    impl()->signalingState.load() == SignalingState::Stable) {
+		// We might need to make a new offer
+		if (!channels.empty() && impl()->negotiationNeeded())
+			setLocalDescription(Description::Type::Offer);
+	}
+
+	return channels;
+}
+
 void PeerConnection::onDataChannel(
     std::function<void(shared_ptr<DataChannel> dataChannel)> callback) {
 	impl()->dataChannelCallback = callback;
@@ -365,6 +401,11 @@ void PeerConnection::onLocalCandidate(std::function<void(Candidate candidate)> c
 	impl()->localCandidateCallback = callback;
 }
 
+void PeerConnection::onLocalCandidates(
+    std::function<void(std::vector<Candidate> candidates)> callback) {
+	impl()->localCandidatesCallback = callback;
+}
+
 void PeerConnection::onStateChange(std::function<void(State state)> callback) {
 	impl()->stateChangeCallback = callback;
 }
@@ -408,6 +449,24 @@ optional<std::chrono::milliseconds> PeerConnection::rtt() {
 	return sctpTransport ? sctpTransport->rtt() : nullopt;
 }
 
+optional<std::chrono::milliseconds> PeerConnection::dtlsHandshakeDuration() {
+	auto dtlsTransport = impl()->getDtlsTransport();
+	return dtlsTransport ? dtlsTransport->handshakeDuration() : nullopt;
+}
+
+size_t PeerConnection::memoryUsage() { return impl()->memoryUsage(); }
+
+PeerConnectionStats PeerConnection::getStats() {
+	PeerConnectionStats stats;
+	if (auto iceTransport = impl()->getIceTransport())
+		stats.ice = iceTransport->iceStats();
+	if (auto dtlsTransport = impl()->getDtlsTransport())
+		stats.dtls = dtlsTransport->dtlsStats();
+	if (auto sctpTransport = impl()->getSctpTransport())
+		stats.sctp = sctpTransport->sctpStats();
+	return stats;
+}
+
 CertificateFingerprint PeerConnection::remoteFingerprint() {
 	return impl()->remoteFingerprint();
 }
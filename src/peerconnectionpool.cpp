@@ -0,0 +1,26 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "peerconnectionpool.hpp"
+
+#include "impl/peerconnectionpool.hpp"
+
+namespace rtc {
+
+PeerConnectionPool::PeerConnectionPool(Configuration config, size_t size)
+    : CheshireCat<impl::PeerConnectionPool>(std::move(config), size) {
+	impl()->start();
+}
+
+PeerConnectionPool::~PeerConnectionPool() { impl()->stop(); }
+
+shared_ptr<PeerConnection> PeerConnectionPool::take() { return impl()->take(); }
+
+size_t PeerConnectionPool::available() const { return impl()->available(); }
+
+} // namespace rtc
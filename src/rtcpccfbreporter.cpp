@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtcpccfbreporter.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/utils.hpp"
+
+#include <algorithm>
+
+namespace rtc {
+
+namespace {
+
+void write16(byte *p, uint16_t value) {
+	p[0] = byte(value >> 8);
+	p[1] = byte(value);
+}
+
+void write32(byte *p, uint32_t value) {
+	write16(p, uint16_t(value >> 16));
+	write16(p + 2, uint16_t(value));
+}
+
+} // namespace
+
+RtcpCcfbReporter::RtcpCcfbReporter(SSRC senderSsrc, std::chrono::milliseconds interval)
+    : mSenderSsrc(senderSsrc), mInterval(interval), mLastReport(clock::now()) {}
+
+void RtcpCcfbReporter::incoming(message_vector &messages, const message_callback &send) {
+	const auto now = clock::now();
+	message_ptr feedback;
+	{
+		std::lock_guard lock(mMutex);
+		for (const auto &message : messages) {
+			if (message->type != Message::Binary || message->size() < sizeof(RtpHeader))
+				continue;
+
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			if (rtp->version() != 2)
+				continue;
+
+			// The ECN codepoint is the one set on the message by the transport, if known
+			record(rtp->ssrc(), rtp->seqNumber(), message->ecn, now);
+		}
+
+		if (now - mLastReport >= mInterval)
+			feedback = generate(now);
+	}
+
+	if (feedback)
+		send(std::move(feedback));
+}
+
+RtcpCcfbReporter::EcnCounts RtcpCcfbReporter::ecnCounts(SSRC ssrc) const {
+	std::lock_guard lock(mMutex);
+	if (auto it = mStreams.find(ssrc); it != mStreams.end())
+		return it->second.counts;
+
+	return {};
+}
+
+void RtcpCcfbReporter::record(SSRC ssrc, uint16_t seq, unsigned int ecn, clock::time_point now) {
+	// Requires mMutex to be locked
+	auto [it, inserted] = mStreams.try_emplace(ssrc);
+	auto &stream = it->second;
+	switch (ecn & 0x03) {
+	case 0:
+		++stream.counts.notEct;
+		break;
+	case 1:
+		++stream.counts.ect1;
+		break;
+	case 2:
+		++stream.counts.ect0;
+		break;
+	default:
+		++stream.counts.ce;
+		break;
+	}
+
+	uint16_t offset = uint16_t(seq - stream.beginSeq);
+	if (inserted || offset >= MaxReportsCount) {
+		if (!inserted && !stream.arrivals.empty())
+			return; // late packet or too far ahead, not reported
+
+		// Start the next report from this packet
+		stream.beginSeq = seq;
+		offset = 0;
+	}
+
+	if (stream.arrivals.size() <= offset)
+		stream.arrivals.resize(offset + 1);
+
+	auto &arrival = stream.arrivals[offset];
+	arrival.received = true;
+	arrival.ecn = uint8_t(ecn & 0x03);
+	arrival.time = now;
+}
+
+message_ptr RtcpCcfbReporter::generate(clock::time_point now) {
+	// Requires mMutex to be locked
+	size_t size = 8; // header and sender SSRC
+	for (const auto &[ssrc, stream] : mStreams)
+		if (!stream.arrivals.empty())
+			size += 8 + ((stream.arrivals.size() * 2 + 3) & ~size_t(3)); // padded to 32 bits
+
+	if (size == 8)
+		return nullptr;
+
+	size += 4; // report timestamp
+	mLastReport = now;
+
+	// RFC 8888 3.1. RTCP Congestion Control Feedback Report
+	// See https://www.rfc-editor.org/rfc/rfc8888.html#section-3.1
+	auto message = make_message_with_tailroom(size, DEFAULT_MEDIA_TAILROOM, Message::Control);
+	auto p = message->data();
+	std::fill(p, p + size, byte(0));
+	p[0] = byte(0x80 | 11); // V=2, FMT=11
+	p[1] = byte(205);       // RTPFB
+	write16(p + 2, uint16_t(size / 4 - 1));
+	write32(p + 4, mSenderSsrc);
+	p += 8;
+
+	for (auto &[ssrc, stream] : mStreams) {
+		if (stream.arrivals.empty())
+			continue;
+
+		const auto count = uint16_t(stream.arrivals.size());
+		write32(p, ssrc);
+		write16(p + 4, stream.beginSeq);
+		write16(p + 6, count);
+		p += 8;
+
+		for (const auto &arrival : stream.arrivals) {
+			if (arrival.received) {
+				// Arrival time offset before the report timestamp, in 1/1024 seconds
+				using ato_duration = std::chrono::duration<int64_t, std::ratio<1, 1024>>;
+				auto ato = std::chrono::duration_cast<ato_duration>(now - arrival.time).count();
+				ato = std::clamp<int64_t>(ato, 0, 0x1FFE); // 0x1FFE means over-range
+				write16(p, uint16_t(0x8000 | (arrival.ecn << 13) | ato));
+			}
+			p += 2;
+		}
+
+		if (count % 2)
+			p += 2; // padding
+
+		stream.beginSeq = uint16_t(stream.beginSeq + count);
+		stream.arrivals.clear();
+	}
+
+	write32(p, uint32_t(impl::utils::ntp_time() >> 16)); // middle 32 bits
+	return message;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
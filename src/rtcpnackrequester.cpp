@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtcpnackrequester.hpp"
+#include "rtcpreceivingsession.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/threadpool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+namespace rtc {
+
+namespace {
+
+// Requests are not repeated more often than this, whatever the round-trip time
+const auto MinRetryInterval = std::chrono::milliseconds(10);
+
+} // namespace
+
+RtcpNackRequester::RtcpNackRequester(unsigned int maxRetries, std::chrono::milliseconds maxAge,
+                                     size_t maxMissing)
+    : mMaxRetries(maxRetries), mMaxAge(maxAge), mMaxMissing(maxMissing) {}
+
+void RtcpNackRequester::media(const Description::Media &desc) {
+	std::vector<uint8_t> rtxPayloadTypes;
+	for (int pt : desc.payloadTypes())
+		if (auto rtxPt = desc.getRtxPayloadType(pt))
+			rtxPayloadTypes.push_back(uint8_t(*rtxPt));
+
+	std::lock_guard lock(mMutex);
+	mRtxPayloadTypes = std::move(rtxPayloadTypes);
+}
+
+void RtcpNackRequester::incoming(message_vector &messages, const message_callback &send) {
+	const auto now = clock::now();
+	bool keyframe = false;
+	{
+		std::lock_guard lock(mMutex);
+		for (const auto &message : messages) {
+			if (message->type == Message::Control || message->size() < sizeof(RtpHeader))
+				continue;
+
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			if (std::find(mRtxPayloadTypes.begin(), mRtxPayloadTypes.end(), rtp->payloadType()) !=
+			    mRtxPayloadTypes.end()) {
+				// RFC 4588: The payload of retransmissions starts with the original sequence number
+				size_t headerSize = rtp->getSize();
+				if (rtp->extension() && headerSize + sizeof(RtpExtensionHeader) <= message->size())
+					headerSize += rtp->getExtensionHeaderSize();
+
+				size_t size = message->size();
+				if (rtp->padding())
+					size -= std::min(size, std::to_integer<size_t>(message->back()));
+
+				if (headerSize + sizeof(uint16_t) <= size) {
+					uint16_t osn;
+					std::memcpy(&osn, message->data() + headerSize, sizeof(osn));
+					recovered(ntohs(osn));
+				}
+				continue;
+			}
+
+			if (mSsrc != rtp->ssrc()) {
+				// The first packet, or a new stream
+				mSsrc = rtp->ssrc();
+				mHighest = (uint64_t(1) << 16) + rtp->seqNumber();
+				mMissing.clear();
+				continue;
+			}
+
+			received(rtp->seqNumber(), now, keyframe);
+		}
+
+		if (mMissing.empty() && !keyframe)
+			return;
+
+		mSend = send;
+	}
+
+	request(now, send, keyframe);
+}
+
+size_t RtcpNackRequester::requestedCount() const {
+	std::lock_guard lock(mMutex);
+	return mRequested;
+}
+
+size_t RtcpNackRequester::unrecoveredCount() const {
+	std::lock_guard lock(mMutex);
+	return mUnrecovered;
+}
+
+void RtcpNackRequester::run() {
+	const auto now = clock::now();
+	message_callback send;
+	{
+		std::lock_guard lock(mMutex);
+		mScheduled = false;
+		send = mSend;
+	}
+
+	if (send)
+		request(now, send, false);
+}
+
+void RtcpNackRequester::request(clock::time_point now, const message_callback &send,
+                                bool keyframe) {
+	// Retransmissions take at least a round-trip time to arrive
+	const auto rtt = roundTripTime();
+	const auto retryInterval =
+	    std::max(std::chrono::duration_cast<clock::duration>(rtt + rtt / 4),
+	             std::chrono::duration_cast<clock::duration>(MinRetryInterval));
+
+	std::vector<uint16_t> sequenceNumbers;
+	{
+		std::lock_guard lock(mMutex);
+		for (auto it = mMissing.begin(); it != mMissing.end();) {
+			auto &missing = it->second;
+			if (now >= missing.detected + mMaxAge ||
+			    (missing.retries >= mMaxRetries && now >= missing.nextRequest)) {
+				PLOG_VERBOSE << "Giving up on missing RTP packet, seq=" << uint16_t(it->first);
+				++mUnrecovered;
+				keyframe = true;
+				it = mMissing.erase(it);
+				continue;
+			}
+
+			if (now >= missing.nextRequest && missing.retries < mMaxRetries) {
+				sequenceNumbers.push_back(uint16_t(it->first));
+				missing.nextRequest = now + retryInterval;
+				++missing.retries;
+			}
+			++it;
+		}
+
+		mRequested += sequenceNumbers.size();
+
+		// A keyframe takes at least a round-trip time to arrive too
+		if (keyframe) {
+			if (!mLastKeyframeRequest || now >= *mLastKeyframeRequest + retryInterval)
+				mLastKeyframeRequest = now;
+			else
+				keyframe = false;
+		}
+
+		schedule();
+	}
+
+	if (!sequenceNumbers.empty()) {
+		PLOG_VERBOSE << "Requesting retransmission of " << sequenceNumbers.size() << " packets";
+		MediaHandler::requestRetransmission(sequenceNumbers, send);
+	}
+
+	if (keyframe) {
+		PLOG_DEBUG << "Missing RTP packets were not recovered, requesting a keyframe";
+		MediaHandler::requestKeyframe(send);
+	}
+}
+
+std::chrono::microseconds RtcpNackRequester::roundTripTime() {
+	for (auto handler = next(); handler; handler = handler->next())
+		if (auto session = std::dynamic_pointer_cast<RtcpReceivingSession>(handler))
+			if (auto rtt = session->roundTripTime())
+				return *rtt;
+
+	return DefaultRoundTripTime;
+}
+
+void RtcpNackRequester::received(uint16_t seqNo, clock::time_point now, bool &keyframe) {
+	const uint64_t extended = extend(seqNo);
+	if (extended <= mHighest) {
+		// Reordered or retransmitted without RTX
+		mMissing.erase(extended);
+		return;
+	}
+
+	const uint64_t gap = extended - mHighest - 1;
+	mHighest = extended;
+	if (gap > mMaxMissing) {
+		PLOG_DEBUG << "Too many missing RTP packets, requesting a keyframe";
+		mUnrecovered += mMissing.size() + gap;
+		mMissing.clear();
+		keyframe = true;
+		return;
+	}
+
+	for (uint64_t missing = extended - gap; missing < extended; ++missing)
+		mMissing.emplace(missing, Missing{now, now});
+
+	while (mMissing.size() > mMaxMissing) {
+		mMissing.erase(mMissing.begin());
+		++mUnrecovered;
+		keyframe = true;
+	}
+}
+
+void RtcpNackRequester::recovered(uint16_t seqNo) {
+	if (mSsrc)
+		mMissing.erase(extend(seqNo));
+}
+
+uint64_t RtcpNackRequester::extend(uint16_t seqNo) const {
+	return uint64_t(int64_t(mHighest) + int16_t(seqNo - uint16_t(mHighest)));
+}
+
+void RtcpNackRequester::schedule() {
+	if (mScheduled || mMissing.empty())
+		return;
+
+	auto time = mMissing.begin()->second.nextRequest;
+	for (const auto &[seqNo, missing] : mMissing)
+		time = std::min(time, missing.nextRequest);
+
+	mScheduled = true;
+	impl::ThreadPool::Instance().setTimer(time, weak_bind(&RtcpNackRequester::run, this));
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -12,13 +12,30 @@
 #include "rtp.hpp"
 
 #include "impl/internals.hpp"
+#include "impl/utils.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <random>
 
 namespace rtc {
 
-RtcpNackResponder::RtcpNackResponder(size_t maxSize)
-    : mStorage(std::make_shared<Storage>(maxSize)) {}
+namespace {
+
+size_t roundUpPowerOfTwo(size_t n) {
+	size_t p = 1;
+	while (p < n)
+		p <<= 1;
+	return p;
+}
+
+} // namespace
+
+RtcpNackResponder::RtcpNackResponder(size_t maxSize,
+                                     optional<std::chrono::milliseconds> maxAge,
+                                     optional<size_t> maxBytes)
+    : mStorage(std::make_shared<Storage>(maxSize, maxAge, maxBytes)) {}
 
 void RtcpNackResponder::incoming(message_vector &messages, const message_callback &send) {
 	for (const auto &message : messages) {
@@ -36,19 +53,21 @@ void RtcpNackResponder::incoming(message_vector &messages, const message_callbac
 			if (nack->header.header.payloadType() != 205 || nack->header.header.reportCount() != 1)
 				continue;
 
+			// Sequence numbers are read from the fields directly instead of being collected
 			unsigned int fieldsCount = nack->getSeqNoCount();
-			std::vector<uint16_t> missingSequenceNumbers;
 			for (unsigned int i = 0; i < fieldsCount; i++) {
-				auto field = nack->parts[i];
-				auto newMissingSeqenceNumbers = field.getSequenceNumbers();
-				missingSequenceNumbers.insert(missingSequenceNumbers.end(),
-				                              newMissingSeqenceNumbers.begin(),
-				                              newMissingSeqenceNumbers.end());
+				auto &field = nack->parts[i];
+				const uint16_t pid = field.pid();
+				const uint16_t blp = field.blp();
+				for (int b = -1; b < 16; ++b) {
+					// The PID itself, then the following packets flagged in the bitmask
+					if (b >= 0 && !(blp & (1 << b)))
+						continue;
+
+					if (auto packet = mStorage->get(uint16_t(pid + b + 1)))
+						send(retransmission(std::move(packet)));
+				}
 			}
-
-			for (auto sequenceNumber : missingSequenceNumbers)
-				if (auto packet = mStorage->get(sequenceNumber))
-					send(packet);
 		}
 	}
 }
@@ -60,22 +79,91 @@ void RtcpNackResponder::outgoing(message_vector &messages,
 			mStorage->store(message);
 }
 
-RtcpNackResponder::Storage::Element::Element(message_ptr packet, uint16_t sequenceNumber,
-                                             shared_ptr<Element> next)
-    : packet(packet), sequenceNumber(sequenceNumber), next(next) {}
+void RtcpNackResponder::media(const Description::Media &desc) {
+	std::lock_guard lock(mRtxMutex);
+	mRtxPayloadTypes.clear();
+	for (int pt : desc.payloadTypes())
+		if (auto rtxPt = desc.getRtxPayloadType(pt))
+			mRtxPayloadTypes.emplace(uint8_t(pt), uint8_t(*rtxPt));
+
+	// Keep the sequence numbers of the existing RTX streams on renegotiation
+	std::unordered_map<SSRC, RtxStream> streams;
+	for (auto ssrc : desc.getSSRCs()) {
+		if (auto rtxSsrc = desc.getRtxSSRC(ssrc)) {
+			auto it = mRtxStreams.find(ssrc);
+			if (it != mRtxStreams.end() && it->second.ssrc == *rtxSsrc) {
+				streams.emplace(ssrc, it->second);
+			} else {
+				// RFC 3550: The initial value of the sequence number SHOULD be random
+				auto uniform = std::uniform_int_distribution<uint32_t>(0, 0xFFFF);
+				auto engine = impl::utils::random_engine();
+				streams.emplace(ssrc, RtxStream{*rtxSsrc, uint16_t(uniform(engine))});
+			}
+		}
+	}
+	mRtxStreams = std::move(streams);
+}
+
+message_ptr RtcpNackResponder::retransmission(message_ptr packet) {
+	auto rtp = reinterpret_cast<const RtpHeader *>(packet->data());
+	const size_t headerSize = size_t(rtp->getBody() - reinterpret_cast<const char *>(rtp));
+	if (headerSize > packet->size())
+		return packet;
+
+	SSRC rtxSsrc;
+	uint8_t rtxPayloadType;
+	uint16_t sequenceNumber;
+	{
+		std::lock_guard lock(mRtxMutex);
+		auto it = mRtxStreams.find(rtp->ssrc());
+		auto jt = mRtxPayloadTypes.find(rtp->payloadType());
+		if (it == mRtxStreams.end() || jt == mRtxPayloadTypes.end())
+			return packet; // RTX not negotiated, resend as-is
+
+		rtxSsrc = it->second.ssrc;
+		rtxPayloadType = jt->second;
+		sequenceNumber = it->second.sequenceNumber++;
+	}
 
-size_t RtcpNackResponder::Storage::size() { return storage.size(); }
+	// RFC 4588 4. RTP Payload Format: the original sequence number (OSN) precedes the original
+	// payload, the header is the original one with the RTX stream SSRC, payload type, and sequence
+	// number. The packet is copied as the stored one must not be altered.
+	const size_t size = packet->size() + sizeof(uint16_t);
+	auto rtx = make_message_with_tailroom(size, DEFAULT_MEDIA_TAILROOM, packet->type);
+	rtx->stream = packet->stream;
+	rtx->dscp = packet->dscp;
+	rtx->ecn = packet->ecn;
+	auto dest = reinterpret_cast<RtpRtx *>(rtx->data());
+	std::memcpy(rtx->data(), packet->data(), headerSize);
+	std::memcpy(dest->getBody(), packet->data() + headerSize, packet->size() - headerSize);
+	dest->setOriginalSeqNo(rtp->seqNumber());
+	dest->header.setSsrc(rtxSsrc);
+	dest->header.setPayloadType(rtxPayloadType);
+	dest->header.setSeqNumber(sequenceNumber);
+	return rtx;
+}
 
-RtcpNackResponder::Storage::Storage(size_t _maxSize) : maxSize(_maxSize) {
+RtcpNackResponder::Storage::Storage(size_t maxSize, optional<std::chrono::milliseconds> maxAge,
+                                    optional<size_t> maxBytes)
+    : capacity(std::clamp(maxSize, size_t(1), size_t(0x8000))),
+      mask(roundUpPowerOfTwo(capacity) - 1), ring(mask + 1), maxAge(maxAge), maxBytes(maxBytes) {
 	assert(maxSize > 0);
-	storage.reserve(maxSize);
+}
+
+RtcpNackResponder::Storage::Slot &RtcpNackResponder::Storage::slot(uint16_t sequenceNumber) {
+	return ring[sequenceNumber & mask];
 }
 
 message_ptr RtcpNackResponder::Storage::get(uint16_t sequenceNumber) {
 	std::lock_guard lock(mutex);
-	auto position = storage.find(sequenceNumber);
-	return position != storage.end() ? storage.at(sequenceNumber)->packet
-	                                 : nullptr;
+	auto &s = slot(sequenceNumber);
+	if (!s.packet || s.sequenceNumber != sequenceNumber)
+		return nullptr;
+
+	if (maxAge && clock::now() - s.time > *maxAge)
+		return nullptr;
+
+	return s.packet;
 }
 
 void RtcpNackResponder::Storage::store(message_ptr packet) {
@@ -84,27 +172,74 @@ void RtcpNackResponder::Storage::store(message_ptr packet) {
 
 	auto rtp = reinterpret_cast<RtpHeader *>(packet->data());
 	auto sequenceNumber = rtp->seqNumber();
+	const auto now = clock::now();
 
 	std::lock_guard lock(mutex);
-	assert((storage.empty() && !oldest && !newest) || (!storage.empty() && oldest && newest));
-
-	if (size() == 0) {
-		newest = std::make_shared<Element>(packet, sequenceNumber);
-		oldest = newest;
-	} else {
-		auto current = std::make_shared<Element>(packet, sequenceNumber);
-		newest->next = current;
-		newest = current;
+	expire(now);
+
+	if (empty) {
+		oldest = newest = sequenceNumber;
+		empty = false;
+
+	} else if (int16_t(sequenceNumber - newest) > 0) {
+		newest = sequenceNumber;
+		// Slide the window, slots leaving it are the ones about to be reused. All stored packets
+		// are within the previous window, so evicting at most capacity of them is enough.
+		const size_t window = size_t(uint16_t(newest - oldest)) + 1;
+		if (window > capacity) {
+			for (size_t i = 0; i < std::min(window - capacity, capacity); ++i)
+				evict(uint16_t(oldest + i));
+
+			oldest = uint16_t(newest - (capacity - 1));
+		}
+
+	} else if (int16_t(sequenceNumber - oldest) < 0) {
+		return; // older than the window
 	}
 
-	storage.emplace(sequenceNumber, newest);
+	auto &s = slot(sequenceNumber);
+	if (s.packet)
+		bytes -= s.packet->size();
 
-	if (size() > maxSize) {
-		assert(oldest);
-		if (oldest) {
-			storage.erase(oldest->sequenceNumber);
-			oldest = oldest->next;
-		}
+	bytes += packet->size();
+	s.packet = std::move(packet);
+	s.sequenceNumber = sequenceNumber;
+	s.time = now;
+
+	if (maxBytes)
+		while (!empty && bytes > *maxBytes)
+			evictOldest();
+}
+
+void RtcpNackResponder::Storage::evict(uint16_t sequenceNumber) {
+	// Requires mutex to be locked
+	auto &s = slot(sequenceNumber);
+	if (s.packet && s.sequenceNumber == sequenceNumber) {
+		bytes -= s.packet->size();
+		s.packet.reset();
+	}
+}
+
+void RtcpNackResponder::Storage::evictOldest() {
+	// Requires mutex to be locked
+	evict(oldest);
+	if (oldest == newest)
+		empty = true;
+	else
+		++oldest;
+}
+
+void RtcpNackResponder::Storage::expire(clock::time_point now) {
+	// Requires mutex to be locked
+	if (!maxAge)
+		return;
+
+	while (!empty) {
+		const auto &s = slot(oldest);
+		if (s.packet && s.sequenceNumber == oldest && now - s.time <= *maxAge)
+			break;
+
+		evictOldest(); // also skips the holes of the window
 	}
 }
 
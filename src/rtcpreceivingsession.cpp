@@ -13,7 +13,9 @@
 #include "track.hpp"
 
 #include "impl/logcounter.hpp"
+#include "impl/utils.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <mutex>
 #include <utility>
@@ -26,11 +28,15 @@
 
 namespace rtc {
 
-static impl::LogCounter COUNTER_BAD_RTP_HEADER(plog::warning, "Number of malformed RTP headers");
-static impl::LogCounter COUNTER_UNKNOWN_PPID(plog::warning, "Number of Unknown PPID messages");
-static impl::LogCounter COUNTER_BAD_NOTIF_LEN(plog::warning,
+static impl::LogCounter COUNTER_BAD_RTP_HEADER("rtc_rtcp_session_bad_rtp_headers", plog::warning,
+                                               "Number of malformed RTP headers");
+static impl::LogCounter COUNTER_UNKNOWN_PPID("rtc_rtcp_session_unknown_ppid_messages",
+                                             plog::warning, "Number of Unknown PPID messages");
+static impl::LogCounter COUNTER_BAD_NOTIF_LEN("rtc_rtcp_session_bad_notification_lengths",
+                                              plog::warning,
                                               "Number of Bad-Lengthed notifications");
-static impl::LogCounter COUNTER_BAD_SCTP_STATUS(plog::warning,
+static impl::LogCounter COUNTER_BAD_SCTP_STATUS("rtc_rtcp_session_bad_sctp_status",
+                                                plog::warning,
                                                 "Number of unknown SCTP_STATUS errors");
 
 RtcpReceivingSession::SyncTimestamps RtcpReceivingSession::getSyncTimestamps(){
@@ -38,195 +44,392 @@ RtcpReceivingSession::SyncTimestamps RtcpReceivingSession::getSyncTimestamps(){
 	return mSyncTimestamps;
 }
 
-void RtcpReceivingSession::incoming(message_vector &messages, const message_callback &send) {
+void RtcpReceivingSession::media(const Description::Media &desc) {
+	std::unordered_map<uint8_t, int> clockRates;
+	for (int pt : desc.payloadTypes())
+		if (auto map = desc.rtpMap(pt))
+			clockRates.emplace(uint8_t(pt), map->clockRate);
+
+	auto ssrcs = desc.getSSRCs();
+
+	std::lock_guard lock(mStatsMutex);
+	mClockRates = std::move(clockRates);
+	mLocalSsrcs = std::unordered_set<SSRC>(ssrcs.begin(), ssrcs.end());
+}
+
+void RtcpReceivingSession::incoming(message_vector &messages,
+                                    [[maybe_unused]] const message_callback &send) {
+	const auto now = clock::now();
 	message_vector result;
-	for (auto message : messages) {
-		switch (message->type) {
-		case Message::Binary: {
-			if (message->size() < sizeof(RtpHeader)) {
-				COUNTER_BAD_RTP_HEADER++;
-				PLOG_VERBOSE << "RTP packet is too small, size=" << message->size();
-				continue;
-			}
+	{
+		std::lock_guard lock(mStatsMutex);
+		for (auto &message : messages) {
+			switch (message->type) {
+			case Message::Binary: {
+				if (message->size() < sizeof(RtpHeader)) {
+					COUNTER_BAD_RTP_HEADER++;
+					PLOG_VERBOSE << "RTP packet is too small, size=" << message->size();
+					continue;
+				}
 
-			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+				auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
 
-			// https://www.rfc-editor.org/rfc/rfc3550.html#appendix-A.1
-			if (rtp->version() != 2) {
-				COUNTER_BAD_RTP_HEADER++;
-				PLOG_VERBOSE << "RTP packet is not version 2";
-				continue;
-			}
+				// https://www.rfc-editor.org/rfc/rfc3550.html#appendix-A.1
+				if (rtp->version() != 2) {
+					COUNTER_BAD_RTP_HEADER++;
+					PLOG_VERBOSE << "RTP packet is not version 2";
+					continue;
+				}
 
-			if (rtp->payloadType() == 201 || rtp->payloadType() == 200) {
-				COUNTER_BAD_RTP_HEADER++;
-				PLOG_VERBOSE << "RTP packet has a payload type indicating RR/SR";
-				continue;
-			}
+				if (rtp->payloadType() == 201 || rtp->payloadType() == 200) {
+					COUNTER_BAD_RTP_HEADER++;
+					PLOG_VERBOSE << "RTP packet has a payload type indicating RR/SR";
+					continue;
+				}
 
-			mSsrc = rtp->ssrc();
+				mSsrc = rtp->ssrc();
 
-			updateSeq(rtp->seqNumber());
+				auto &source = mSources[rtp->ssrc()];
+				if (auto it = mClockRates.find(rtp->payloadType()); it != mClockRates.end())
+					source.clockRate = it->second;
 
-			result.push_back(std::move(message));
-			break;
-		}
+				source.update(rtp->seqNumber());
+				source.updateJitter(rtp->timestamp(), now);
+				source.reported = false;
+
+				result.push_back(std::move(message));
+				break;
+			}
 
-		case Message::Control: {
-			auto rr = reinterpret_cast<const RtcpRr *>(message->data());
-			if (rr->header.payloadType() == 201) { // RR
-				mSsrc = rr->senderSSRC();
-				rr->log();
-			} else if (rr->header.payloadType() == 200) { // SR
-				mSsrc = rr->senderSSRC();
-				auto sr = reinterpret_cast<const RtcpSr *>(message->data());
-				{
-					std::lock_guard lock(mSyncMutex);
-					mSyncTimestamps.rtpTimestamp = sr->rtpTimestamp();
-					mSyncTimestamps.ntpTimestamp = sr->ntpTimestamp();
+			case Message::Control: {
+				// Walk the compound packet
+				size_t offset = 0;
+				while (offset + sizeof(RtcpHeader) <= message->size()) {
+					auto header = reinterpret_cast<const RtcpHeader *>(message->data() + offset);
+					const size_t length = header->lengthInBytes();
+					if (length < sizeof(RtcpHeader) || offset + length > message->size())
+						break;
+
+					if (header->payloadType() == 200) {
+						if (offset == 0)
+							mSsrc = reinterpret_cast<const RtcpSr *>(header)->senderSSRC();
+					} else if (header->payloadType() == 201 && offset == 0) {
+						mSsrc = reinterpret_cast<const RtcpRr *>(header)->senderSSRC();
+					}
+
+					processReport(header, now);
+					offset += length;
 				}
-				sr->log();
+				break;
+			}
 
-				// TODO For the time being, we will send RR's/REMB's when we get an SR
-				pushRR(send, 0);
-				if (unsigned int bitrate = mRequestedBitrate.load(); bitrate > 0)
-					pushREMB(send, bitrate);
+			default:
+				break;
 			}
-			break;
 		}
+	}
+
+	messages.swap(result);
+}
 
-		default:
-			break;
+void RtcpReceivingSession::processReport(const RtcpHeader *header, clock::time_point now) {
+	const size_t length = header->lengthInBytes();
+	const RtcpReportBlock *blocks = nullptr;
+	size_t headerSize = 0;
+	if (header->payloadType() == 200) { // SR
+		if (length < RtcpSr::Size(0))
+			return;
+
+		auto sr = reinterpret_cast<const RtcpSr *>(header);
+		sr->log();
+		{
+			std::lock_guard lock(mSyncMutex);
+			mSyncTimestamps.rtpTimestamp = sr->rtpTimestamp();
+			mSyncTimestamps.ntpTimestamp = sr->ntpTimestamp();
 		}
+
+		auto &source = mSources[sr->senderSSRC()];
+		source.lastSrNtp = uint32_t(sr->ntpTimestamp() >> 16);
+		source.lastSrTime = now;
+
+		blocks = sr->getReportBlock(0);
+		headerSize = RtcpSr::Size(0);
+
+	} else if (header->payloadType() == 201) { // RR
+		if (length < RtcpRr::SizeWithReportBlocks(0))
+			return;
+
+		auto rr = reinterpret_cast<const RtcpRr *>(header);
+		rr->log();
+
+		blocks = rr->getReportBlock(0);
+		headerSize = RtcpRr::SizeWithReportBlocks(0);
+
+	} else {
+		return;
 	}
 
-	messages.swap(result);
+	// Compute the round-trip time from blocks about local streams
+	// See https://www.rfc-editor.org/rfc/rfc3550.html#section-6.4.1
+	const size_t count =
+	    std::min(size_t(header->reportCount()), (length - headerSize) / sizeof(RtcpReportBlock));
+	for (size_t i = 0; i < count; ++i) {
+		const auto &block = blocks[i];
+		const uint32_t lastSr = ntohl(block._lastReport);
+		if (lastSr == 0 || mLocalSsrcs.find(block.getSSRC()) == mLocalSsrcs.end())
+			continue;
+
+		const uint32_t arrival = uint32_t(impl::utils::ntp_time() >> 16);
+		const uint32_t rtt = arrival - lastSr - block.delaySinceSR(); // in 1/65536 seconds
+		if (int32_t(rtt) < 0)
+			continue;
+
+		mRoundTripTime = std::chrono::microseconds(uint64_t(rtt) * 1000000 / 65536);
+	}
 }
 
-bool RtcpReceivingSession::requestBitrate(unsigned int bitrate, const message_callback &send) {
-	PLOG_DEBUG << "Requesting bitrate: " << bitrate << std::endl;
-	mRequestedBitrate.store(bitrate);
-	pushREMB(send, bitrate);
-	return true;
+std::vector<RtcpReceivingSession::Stats> RtcpReceivingSession::stats() const {
+	std::lock_guard lock(mStatsMutex);
+	std::vector<Stats> result;
+	result.reserve(mSources.size());
+	for (const auto &[ssrc, source] : mSources) {
+		if (!source.started || source.probation > 0)
+			continue;
+
+		Stats stats;
+		stats.ssrc = ssrc;
+		stats.packetsReceived = source.received;
+		stats.packetsLost = source.lost();
+		stats.fractionLost = double(source.fraction) / 256.;
+		stats.extendedHighestSeqNo = source.cycles + source.maxSeq;
+		stats.jitter = std::chrono::microseconds(uint64_t(source.jitter >> 4) * 1000000 /
+		                                         uint64_t(source.clockRate));
+		result.push_back(std::move(stats));
+	}
+	return result;
 }
 
-void RtcpReceivingSession::pushREMB(const message_callback &send, unsigned int bitrate) {
-	auto message = make_message(RtcpRemb::SizeWithSSRCs(1), Message::Control);
-	auto remb = reinterpret_cast<RtcpRemb *>(message->data());
-	remb->preparePacket(mSsrc, 1, bitrate);
-	remb->setSsrc(0, mSsrc);
-	send(message);
+optional<std::chrono::microseconds> RtcpReceivingSession::roundTripTime() const {
+	std::lock_guard lock(mStatsMutex);
+	return mRoundTripTime;
 }
 
-void RtcpReceivingSession::pushRR(const message_callback &send, unsigned int lastSrDelay) {
-	auto message = make_message(RtcpRr::SizeWithReportBlocks(1), Message::Control);
-	auto rr = reinterpret_cast<RtcpRr *>(message->data());
-	rr->preparePacket(mSsrc, 1);
-
-	// calculate packets lost, packet expected, fraction
-	auto extended_max = mCycles + mMaxSeq;
-    auto expected = extended_max - mBaseSeq + 1;
-	auto lost = 0;
-	if (mReceived > 0) {
-		lost = expected - mReceived;
-	} 
-
-	auto expected_interval = expected - mExpectedPrior;
-    mExpectedPrior = expected;
-    auto received_interval = mReceived - mReceivedPrior;
-    mReceivedPrior = mReceived;
-    auto lost_interval = expected_interval - received_interval;
-
-	uint8_t fraction;
-
-	if (expected_interval == 0 || lost_interval <= 0) {  
-		fraction = 0;
-	}	
-	else { 
-		fraction = (lost_interval << 8) / expected_interval;
+std::vector<RtcpReportBlock> RtcpReceivingSession::prepareReportBlocks() {
+	const auto now = clock::now();
+	std::lock_guard lock(mStatsMutex);
+	std::vector<RtcpReportBlock> result;
+	for (auto &[ssrc, source] : mSources) {
+		if (source.reported || !source.started || source.probation > 0)
+			continue;
+
+		// See https://www.rfc-editor.org/rfc/rfc3550.html#appendix-A.3
+		const uint32_t expected = source.cycles + source.maxSeq - source.baseSeq + 1;
+		const uint32_t expectedInterval = expected - source.expectedPrior;
+		source.expectedPrior = expected;
+		const uint32_t receivedInterval = source.received - source.receivedPrior;
+		source.receivedPrior = source.received;
+		const int64_t lostInterval = int64_t(expectedInterval) - int64_t(receivedInterval);
+		source.fraction = expectedInterval == 0 || lostInterval <= 0
+		                      ? 0
+		                      : uint8_t(std::min((lostInterval << 8) / expectedInterval,
+		                                         int64_t(255)));
+
+		// Cumulative number lost is a 24-bit signed integer
+		const int32_t lost = std::clamp(source.lost(), -0x800000, 0x7FFFFF);
+
+		uint32_t delaySinceSr = 0;
+		if (source.lastSrNtp != 0)
+			delaySinceSr = uint32_t(std::chrono::duration<double>(now - source.lastSrTime).count() *
+			                        65536.); // in 1/65536 seconds
+
+		RtcpReportBlock block;
+		block.preparePacket(ssrc, source.fraction, uint32_t(lost), source.maxSeq,
+		                    uint16_t(source.cycles >> 16), source.jitter >> 4,
+		                    uint64_t(source.lastSrNtp) << 16, delaySinceSr);
+		block.log();
+		result.push_back(block);
+		source.reported = true;
 	}
-	auto syncTimestamps = getSyncTimestamps();
-	rr->getReportBlock(0)->preparePacket(mSsrc, fraction, lost, uint16_t(mGreatestSeqNo), mMaxSeq, 0, syncTimestamps.ntpTimestamp,
-	                                     lastSrDelay);
-	rr->log();
-	send(message);
+	return result;
 }
 
-bool RtcpReceivingSession::requestKeyframe(const message_callback &send) {
-	pushPLI(send);
-	return true;
-}
+binary RtcpReceivingSession::prepareFeedback() {
+	const unsigned int bitrate = mRequestedBitrate.load();
+	if (bitrate == 0)
+		return {};
 
-void RtcpReceivingSession::pushPLI(const message_callback &send) {
-	auto message = make_message(RtcpPli::Size(), Message::Control);
-	auto *pli = reinterpret_cast<RtcpPli *>(message->data());
-	pli->preparePacket(mSsrc);
-	send(message);
+	std::lock_guard lock(mStatsMutex);
+	if (mSsrc == 0)
+		return {};
+
+	binary packet(RtcpRemb::SizeWithSSRCs(1));
+	auto remb = reinterpret_cast<RtcpRemb *>(packet.data());
+	remb->preparePacket(mSsrc, 1, bitrate);
+	remb->setSsrc(0, mSsrc);
+	return packet;
 }
 
-void RtcpReceivingSession::initSeq(uint16_t seq) {
-	mBaseSeq = seq;
-	mMaxSeq = seq;
-	mBadSeq = RTP_SEQ_MOD + 1;   /* so seq == bad_seq is false */
-	mCycles = 0;
-	mReceived = 0;
-	mReceivedPrior = 0;
-	mExpectedPrior = 0;
+void RtcpReceivingSession::Source::init(uint16_t seq) {
+	baseSeq = seq;
+	maxSeq = seq;
+	badSeq = RTP_SEQ_MOD + 1; /* so seq == bad_seq is false */
+	cycles = 0;
+	received = 0;
+	receivedPrior = 0;
+	expectedPrior = 0;
 }
 
-bool RtcpReceivingSession::updateSeq(uint16_t seq) {
-	uint16_t udelta = seq - mMaxSeq;
+bool RtcpReceivingSession::Source::update(uint16_t seq) {
 	const int MAX_DROPOUT = 3000;
 	const int MAX_MISORDER = 100;
 	const int MIN_SEQUENTIAL = 2;
 
+	if (!started) {
+		init(seq);
+		maxSeq = uint16_t(seq - 1);
+		probation = MIN_SEQUENTIAL;
+		started = true;
+	}
+
+	uint16_t udelta = uint16_t(seq - maxSeq);
+
 	/*
 	* Source is not valid until MIN_SEQUENTIAL packets with
 	* sequential sequence numbers have been received.
 	*/
-	if (mProbation) {
+	if (probation) {
 		/* packet is in sequence */
-		if (seq == mMaxSeq + 1) {
-			mProbation--;
-			mMaxSeq = seq;
-			if (mProbation == 0) {
-				initSeq(seq);
-				mReceived++;
+		if (seq == uint16_t(maxSeq + 1)) {
+			probation--;
+			maxSeq = seq;
+			if (probation == 0) {
+				init(seq);
+				received++;
 				return true;
 			}
 		} else {
-			mProbation = MIN_SEQUENTIAL - 1;
-			mMaxSeq = seq;
+			probation = MIN_SEQUENTIAL - 1;
+			maxSeq = seq;
 		}
 		return false;
 	} else if (udelta < MAX_DROPOUT) {
 		/* in order, with permissible gap */
-		if (seq < mMaxSeq) {
+		if (seq < maxSeq) {
 			/*
 			* Sequence number wrapped - count another 64K cycle.
 			*/
-			mCycles += RTP_SEQ_MOD;
+			cycles += RTP_SEQ_MOD;
 		}
-		mMaxSeq = seq;
+		maxSeq = seq;
 	} else if (udelta <= RTP_SEQ_MOD - MAX_MISORDER) {
 		/* the sequence number made a very large jump */
-		if (seq == mBadSeq) {
+		if (seq == badSeq) {
 			/*
 			* Two sequential packets -- assume that the other side
 			* restarted without telling us so just re-sync
 			* (i.e., pretend this was the first packet).
 			*/
-			initSeq(seq);
+			init(seq);
 		}
 		else {
-			mBadSeq = (seq + 1) & (RTP_SEQ_MOD-1);
+			badSeq = (seq + 1) & (RTP_SEQ_MOD-1);
 			return false;
 		}
+	} else {
+		/* duplicate or reordered packet */
+	}
+	received++;
+	return true;
+}
+
+void RtcpReceivingSession::Source::updateJitter(uint32_t timestamp, clock::time_point arrivalTime) {
+	// See https://www.rfc-editor.org/rfc/rfc3550.html#appendix-A.8
+	const double secs = std::chrono::duration<double>(arrivalTime.time_since_epoch()).count();
+	const uint32_t arrival = uint32_t(uint64_t(secs * clockRate)); // in timestamp units
+	const uint32_t t = arrival - timestamp;
+	if (transit) {
+		const int64_t d = std::abs(int64_t(int32_t(t - *transit)));
+		jitter = uint32_t(int64_t(jitter) + d - ((int64_t(jitter) + 8) >> 4));
 	}
-	mReceived++;
+	transit = t;
+}
+
+int32_t RtcpReceivingSession::Source::lost() const {
+	const uint32_t expected = cycles + maxSeq - baseSeq + 1;
+	return int32_t(expected - received);
+}
+
+bool RtcpReceivingSession::requestBitrate(unsigned int bitrate, const message_callback &send) {
+	PLOG_DEBUG << "Requesting bitrate: " << bitrate << std::endl;
+	mRequestedBitrate.store(bitrate);
+	pushREMB(send, bitrate);
+	return true;
+}
+
+void RtcpReceivingSession::pushREMB(const message_callback &send, unsigned int bitrate) {
+	auto message = make_message_with_tailroom(RtcpRemb::SizeWithSSRCs(1), DEFAULT_MEDIA_TAILROOM,
+	                                          Message::Control);
+	auto remb = reinterpret_cast<RtcpRemb *>(message->data());
+	remb->preparePacket(mSsrc, 1, bitrate);
+	remb->setSsrc(0, mSsrc);
+	send(message);
+}
+
+bool RtcpReceivingSession::requestKeyframe(const message_callback &send) {
+	pushPLI(send);
+	return true;
+}
+
+void RtcpReceivingSession::pushPLI(const message_callback &send) {
+	auto message = make_message_with_tailroom(RtcpPli::Size(), DEFAULT_MEDIA_TAILROOM, Message::Control);
+	auto *pli = reinterpret_cast<RtcpPli *>(message->data());
+	pli->preparePacket(mSsrc);
+	send(message);
+}
+
+bool RtcpReceivingSession::requestRetransmission(const std::vector<uint16_t> &sequenceNumbers,
+                                                 const message_callback &send) {
+	if (sequenceNumbers.empty())
+		return false;
+
+	pushNACK(send, sequenceNumbers);
 	return true;
 }
 
+void RtcpReceivingSession::pushNACK(const message_callback &send,
+                                    const std::vector<uint16_t> &sequenceNumbers) {
+	// Each part covers a sequence number and the 16 following ones, sequence numbers are sorted
+	unsigned int count = 0;
+	uint16_t pid = 0;
+	for (auto seqNo : sequenceNumbers) {
+		if (count == 0 || uint16_t(seqNo - pid) > 16) {
+			pid = seqNo;
+			++count;
+		}
+	}
+
+	auto message = make_message_with_tailroom(RtcpNack::Size(count), DEFAULT_MEDIA_TAILROOM,
+	                                          Message::Control);
+	auto nack = reinterpret_cast<RtcpNack *>(message->data());
+	nack->preparePacket(mSsrc, count);
+
+	unsigned int i = 0;
+	for (auto seqNo : sequenceNumbers) {
+		const uint16_t delta = uint16_t(seqNo - pid);
+		if (i == 0 || delta > 16) {
+			pid = seqNo;
+			nack->parts[i].setPid(pid);
+			nack->parts[i].setBlp(0);
+			++i;
+		} else if (delta > 0) {
+			auto &part = nack->parts[i - 1];
+			part.setBlp(uint16_t(part.blp() | 1u << (delta - 1)));
+		}
+	}
+
+	send(message);
+}
+
 } // namespace rtc
 
 #endif // RTC_ENABLE_MEDIA
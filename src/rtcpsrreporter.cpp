@@ -10,25 +10,135 @@
 
 #include "rtcpsrreporter.hpp"
 
+#include "impl/utils.hpp"
+
+#include <algorithm>
 #include <cassert>
 #include <chrono>
-#include <cmath>
+#include <utility>
 
-using namespace std::chrono_literals;
+namespace rtc {
 
-namespace {
+std::vector<message_ptr> RtcpSrReporter::MakeCompoundPackets(
+    const std::vector<Report> &reports, const std::vector<RtcpReportBlock> &blocks,
+    SSRC receiverSsrc, const string &receiverCname, size_t maxSize,
+    const std::vector<binary> &feedback) {
+	const size_t srSize = RtcpSr::Size(0);
+	const size_t sdesHeaderSize = RtcpSdes::Size({});
+	const size_t rrHeaderSize = RtcpRr::SizeWithReportBlocks(0);
+	const size_t blockSize = sizeof(RtcpReportBlock);
+	const size_t maxCount = 31; // SDES source count and RR report count are 5 bits
+
+	auto chunkSize = [](const string &cname) {
+		return size_t(RtcpSdesChunk::Size({uint8_t(cname.size())}));
+	};
+
+	// RFC 3550 6.1: Each compound packet must include an SDES packet with the CNAME, so packets
+	// without sender reports carry the one of the receiver
+	const size_t receiverSdesSize = sdesHeaderSize + chunkSize(receiverCname);
+	auto writeSdes = [](byte *ptr, const std::vector<std::pair<SSRC, const string *>> &chunks) {
+		auto sdes = reinterpret_cast<RtcpSdes *>(ptr);
+		for (size_t i = 0; i < chunks.size(); ++i) {
+			auto chunk = sdes->getChunk(int(i));
+			chunk->setSSRC(chunks[i].first);
+			auto item = chunk->getItem(0);
+			item->type = 1;
+			item->setText(*chunks[i].second);
+		}
+		sdes->preparePacket(uint8_t(chunks.size()));
+	};
+
+	std::vector<message_ptr> result;
+	auto report = reports.begin();
+	auto block = blocks.begin();
+	while (report != reports.end() || block != blocks.end()) {
+		// Take as many reports and blocks as fit, but at least one
+		const auto firstReport = report;
+		size_t size = 0;
+		while (report != reports.end() && size_t(report - firstReport) < maxCount &&
+		       (report == firstReport ||
+		        size + srSize + chunkSize(report->cname) + sdesHeaderSize <= maxSize)) {
+			size += srSize + chunkSize(report->cname);
+			++report;
+		}
+		const size_t reportCount = size_t(report - firstReport);
+		size += reportCount > 0 ? sdesHeaderSize : receiverSdesSize;
+
+		const auto firstBlock = block;
+		while (block != blocks.end()) {
+			const size_t count = size_t(block - firstBlock);
+			const size_t added = count % maxCount == 0 ? rrHeaderSize + blockSize : blockSize;
+			if (size + added > maxSize && (count > 0 || reportCount > 0))
+				break;
+
+			size += added;
+			++block;
+		}
+		const size_t blockCount = size_t(block - firstBlock);
+
+		auto msg = make_message_with_tailroom(size, DEFAULT_MEDIA_TAILROOM, Message::Control);
+		auto ptr = msg->data();
+		for (auto r = firstReport; r != report; ++r) {
+			auto sr = reinterpret_cast<RtcpSr *>(ptr);
+			sr->setNtpTimestamp(r->ntpTimestamp);
+			sr->setRtpTimestamp(r->rtpTimestamp);
+			sr->setPacketCount(r->packetCount);
+			sr->setOctetCount(r->octetCount);
+			sr->preparePacket(r->ssrc, 0);
+			ptr += srSize;
+		}
+
+		const SSRC senderSsrc = reportCount > 0 ? firstReport->ssrc : receiverSsrc;
+		for (size_t i = 0; i < blockCount; i += maxCount) {
+			const size_t count = std::min(blockCount - i, maxCount);
+			auto rr = reinterpret_cast<RtcpRr *>(ptr);
+			rr->preparePacket(senderSsrc, uint8_t(count));
+			for (size_t j = 0; j < count; ++j)
+				*rr->getReportBlock(int(j)) = *(firstBlock + (i + j));
+
+			ptr += RtcpRr::SizeWithReportBlocks(uint8_t(count));
+		}
+
+		std::vector<std::pair<SSRC, const string *>> chunks;
+		for (auto r = firstReport; r != report; ++r)
+			chunks.emplace_back(r->ssrc, &r->cname);
+
+		if (chunks.empty())
+			chunks.emplace_back(receiverSsrc, &receiverCname);
+
+		writeSdes(ptr, chunks);
+
+		result.push_back(std::move(msg));
+	}
 
-// TODO: move to utils
-uint64_t ntp_time() {
-	const auto now = std::chrono::system_clock::now();
-	const double secs = std::chrono::duration<double>(now.time_since_epoch()).count();
-	// Assume the epoch is 01/01/1970 and adds the number of seconds between 1900 and 1970
-	return uint64_t(std::floor((secs + 2208988800.) * double(uint64_t(1) << 32)));
-}
+	// RFC 4585: Feedback packets are placed after the reports and SDES in compound packets
+	for (const auto &packet : feedback) {
+		if (packet.empty())
+			continue;
 
-} // namespace
+		const size_t size =
+		    !result.empty() && result.back()->size() + packet.size() <= maxSize
+		        ? result.back()->size()
+		        : 0;
+		if (size == 0) {
+			// A compound packet must start with a report, leave an empty receiver report
+			auto msg = make_message_with_tailroom(rrHeaderSize + receiverSdesSize,
+			                                      DEFAULT_MEDIA_TAILROOM, Message::Control);
+			reinterpret_cast<RtcpRr *>(msg->data())->preparePacket(receiverSsrc, 0);
+			writeSdes(msg->data() + rrHeaderSize, {{receiverSsrc, &receiverCname}});
+			result.push_back(std::move(msg));
+		}
+
+		auto &last = result.back();
+		auto msg = make_message_with_tailroom(last->size() + packet.size(), DEFAULT_MEDIA_TAILROOM,
+		                                      Message::Control);
+		std::copy(last->begin(), last->end(), msg->begin());
+		std::copy(packet.begin(), packet.end(), msg->begin() + last->size());
+		last = std::move(msg);
+	}
 
-namespace rtc {
+	return result;
+}
 
 RtcpSrReporter::RtcpSrReporter(shared_ptr<RtpPacketizationConfig> rtpConfig) : rtpConfig(rtpConfig) {}
 
@@ -38,13 +148,15 @@ void RtcpSrReporter::setNeedsToReport() {
 	// Dummy
 }
 
-uint32_t RtcpSrReporter::lastReportedTimestamp() const { return mLastReportedTimestamp; }
-
-void RtcpSrReporter::outgoing(message_vector &messages, const message_callback &send) {
-	if (messages.empty())
-		return;
+uint32_t RtcpSrReporter::lastReportedTimestamp() const {
+	return mLastReportedTimestamp.load(std::memory_order_relaxed);
+}
 
-	uint32_t timestamp = 0;
+void RtcpSrReporter::outgoing(message_vector &messages,
+                              [[maybe_unused]] const message_callback &send) {
+	uint32_t packetCount = 0;
+	uint32_t payloadOctets = 0;
+	const RtpHeader *last = nullptr;
 	for (const auto &message : messages) {
 		if (message->type == Message::Control)
 			continue;
@@ -52,49 +164,50 @@ void RtcpSrReporter::outgoing(message_vector &messages, const message_callback &
 		if (message->size() < sizeof(RtpHeader))
 			continue;
 
-		auto header = reinterpret_cast<RtpHeader *>(message->data());
+		auto header = reinterpret_cast<const RtpHeader *>(message->data());
 		if(header->ssrc() != rtpConfig->ssrc)
 			continue;
 
-		timestamp = header->timestamp();
-
-		addToReport(header, message->size());
+		assert(!header->padding());
+		++packetCount;
+		payloadOctets += uint32_t(message->size() - header->getSize());
+		last = header;
 	}
 
-	auto now = std::chrono::steady_clock::now();
-	if (now >= mLastReportTime + 1s) {
-		send(getSenderReport(timestamp));
-		mLastReportedTimestamp = timestamp;
-		mLastReportTime = now;
-	}
-}
+	if (!last)
+		return;
 
-void RtcpSrReporter::addToReport(RtpHeader *header, size_t size) {
-	mPacketCount += 1;
-	assert(!header->padding());
-	mPayloadOctets += uint32_t(size - header->getSize());
+	mPacketCount.fetch_add(packetCount, std::memory_order_relaxed);
+	mPayloadOctets.fetch_add(payloadOctets, std::memory_order_relaxed);
+	mLastTimestamp.store(last->timestamp(), std::memory_order_relaxed);
+	mLastTime.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+	                std::memory_order_relaxed);
 }
 
-message_ptr RtcpSrReporter::getSenderReport(uint32_t timestamp) {
-	auto srSize = RtcpSr::Size(0);
-	auto msg = make_message(srSize + RtcpSdes::Size({{uint8_t(rtpConfig->cname.size())}}),
-	                        Message::Control);
-	auto sr = reinterpret_cast<RtcpSr *>(msg->data());
-	sr->setNtpTimestamp(ntp_time());
-	sr->setRtpTimestamp(timestamp);
-	sr->setPacketCount(mPacketCount);
-	sr->setOctetCount(mPayloadOctets);
-	sr->preparePacket(rtpConfig->ssrc, 0);
-
-	auto sdes = reinterpret_cast<RtcpSdes *>(msg->data() + srSize);
-	auto chunk = sdes->getChunk(0);
-	chunk->setSSRC(rtpConfig->ssrc);
-	auto item = chunk->getItem(0);
-	item->type = 1;
-	item->setText(rtpConfig->cname);
-	sdes->preparePacket(1);
-
-	return msg;
+optional<RtcpSrReporter::Report> RtcpSrReporter::prepareReport() {
+	const uint32_t packetCount = mPacketCount.load(std::memory_order_relaxed);
+	if (packetCount == mReportedPacketCount.exchange(packetCount, std::memory_order_relaxed))
+		return nullopt;
+
+	// The RTP timestamp must correspond to the NTP timestamp, so it is extrapolated from the last
+	// packet with the elapsed time
+	const auto lastTime = std::chrono::steady_clock::time_point(
+	    std::chrono::steady_clock::duration(mLastTime.load(std::memory_order_relaxed)));
+	const double elapsed =
+	    std::chrono::duration<double>(std::chrono::steady_clock::now() - lastTime).count();
+	const uint32_t timestamp = mLastTimestamp.load(std::memory_order_relaxed) +
+	                           uint32_t(std::max(elapsed, 0.) * rtpConfig->clockRate);
+
+	mLastReportedTimestamp.store(timestamp, std::memory_order_relaxed);
+
+	Report report;
+	report.ssrc = rtpConfig->ssrc;
+	report.cname = rtpConfig->cname;
+	report.ntpTimestamp = impl::utils::ntp_time();
+	report.rtpTimestamp = timestamp;
+	report.packetCount = packetCount;
+	report.octetCount = mPayloadOctets.load(std::memory_order_relaxed);
+	return report;
 }
 
 } // namespace rtc
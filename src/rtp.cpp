@@ -101,6 +101,8 @@ void RtpHeader::setTimestamp(uint32_t i) { _timestamp = htonl(i); }
 
 void RtpHeader::setExtension(bool extension) { _first = (_first & ~0x10) | ((extension & 1) << 4); }
 
+void RtpHeader::setPadding(bool padding) { _first = (_first & ~0x20) | ((padding & 1) << 5); }
+
 void RtpHeader::log() const {
 	PLOG_VERBOSE << "RtpHeader V: " << (int)version() << " P: " << (padding() ? "P" : " ")
 	             << " X: " << (extension() ? "X" : " ") << " CC: " << (int)csrcCount()
@@ -172,6 +174,52 @@ size_t RtpExtensionHeader::writeHeader(bool twoByteHeader, size_t offset, uint8_
 	}
 }
 
+const byte *RtpExtensionHeader::findHeader(uint8_t id, size_t &size) const {
+	// RFC 8285 4.2. One-Byte Header and 4.3. Two-Byte Header
+	const bool twoByteHeader = (profileSpecificId() & 0xFFF0) == 0x1000;
+	if (!twoByteHeader && profileSpecificId() != 0xBEDE)
+		return nullptr;
+
+	auto buf = reinterpret_cast<const byte *>(getBody());
+	const size_t total = getSize();
+	size_t offset = 0;
+	while (offset < total) {
+		uint8_t elementId = std::to_integer<uint8_t>(buf[offset]);
+		if (elementId == 0) {
+			++offset; // padding
+			continue;
+		}
+
+		size_t elementSize;
+		if (twoByteHeader) {
+			if (offset + 2 > total)
+				break;
+
+			elementSize = std::to_integer<uint8_t>(buf[offset + 1]);
+			offset += 2;
+		} else {
+			if (elementId >> 4 == 15)
+				break; // reserved, stop parsing
+
+			elementSize = (elementId & 0x0F) + 1;
+			elementId >>= 4;
+			offset += 1;
+		}
+
+		if (offset + elementSize > total)
+			break;
+
+		if (elementId == id) {
+			size = elementSize;
+			return buf + offset;
+		}
+
+		offset += elementSize;
+	}
+
+	return nullptr;
+}
+
 SSRC RtcpReportBlock::getSSRC() const { return ntohl(_ssrc); }
 
 void RtcpReportBlock::preparePacket(SSRC in_ssrc, uint8_t fraction,
@@ -203,7 +251,7 @@ void RtcpReportBlock::setPacketsLost(uint8_t fractionLost,
 uint8_t RtcpReportBlock::getFractionLost() const {
 	// Fraction lost is expressed as 8-bit fixed point number
 	// In order to get actual lost percentage divide the result by 256
-	return (uint8_t) ((ntohl(_fractionLostAndPacketsLost) & 0xFF00000) >> 24);
+	return (uint8_t) ((ntohl(_fractionLostAndPacketsLost) & 0xFF000000) >> 24);
 }
 
 uint32_t RtcpReportBlock::getPacketsLostCount() const {
@@ -666,6 +714,8 @@ bool RtcpNack::addMissingPacket(unsigned int *fciCount, uint16_t *fciPID, uint16
 
 uint16_t RtpRtx::getOriginalSeqNo() const { return ntohs(*(uint16_t *)(header.getBody())); }
 
+void RtpRtx::setOriginalSeqNo(uint16_t osn) { *(uint16_t *)(header.getBody()) = htons(osn); }
+
 const char *RtpRtx::getBody() const { return header.getBody() + sizeof(uint16_t); }
 
 char *RtpRtx::getBody() { return header.getBody() + sizeof(uint16_t); }
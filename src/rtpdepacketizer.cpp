@@ -12,6 +12,9 @@
 #include "rtp.hpp"
 
 #include "impl/logcounter.hpp"
+#include "impl/messagepool.hpp"
+
+#include <algorithm>
 
 namespace rtc {
 
@@ -24,6 +27,7 @@ RtpDepacketizer::~RtpDepacketizer() {}
 void RtpDepacketizer::incoming(message_vector &messages,
                                [[maybe_unused]] const message_callback &send) {
 	message_vector result;
+	shared_ptr<FrameInfo> frameInfo; // shared by consecutive packets of the same frame
 	for (auto &message : messages) {
 		if (message->type == Message::Control) {
 			result.push_back(std::move(message));
@@ -37,8 +41,11 @@ void RtpDepacketizer::incoming(message_vector &messages,
 
 		auto pkt = reinterpret_cast<const rtc::RtpHeader *>(message->data());
 		auto headerSize = sizeof(rtc::RtpHeader) + pkt->csrcCount() + pkt->getExtensionHeaderSize();
-		result.push_back(make_message(message->begin() + headerSize, message->end(),
-		                              createFrameInfo(pkt->timestamp(), pkt->payloadType())));
+		if (!frameInfo || frameInfo->timestamp != pkt->timestamp() ||
+		    frameInfo->payloadType != pkt->payloadType() || frameInfo->ssrc != pkt->ssrc())
+			frameInfo = createFrameInfo(*pkt);
+
+		result.push_back(make_message(message->begin() + headerSize, message->end(), frameInfo));
 	}
 
 	messages.swap(result);
@@ -46,7 +53,7 @@ void RtpDepacketizer::incoming(message_vector &messages,
 
 shared_ptr<FrameInfo> RtpDepacketizer::createFrameInfo(uint32_t timestamp,
                                                        uint8_t payloadType) const {
-	auto frameInfo = std::make_shared<FrameInfo>(timestamp);
+	auto frameInfo = impl::MessagePool::Instance().makeFrameInfo(FrameInfo(timestamp));
 	if (mClockRate > 0)
 		frameInfo->timestampSeconds =
 		    std::chrono::duration<double>(double(timestamp) / double(mClockRate));
@@ -54,14 +61,26 @@ shared_ptr<FrameInfo> RtpDepacketizer::createFrameInfo(uint32_t timestamp,
 	return frameInfo;
 }
 
+shared_ptr<FrameInfo> RtpDepacketizer::createFrameInfo(const RtpHeader &header) const {
+	auto frameInfo = createFrameInfo(header.timestamp(), header.payloadType());
+	frameInfo->ssrc = header.ssrc();
+	return frameInfo;
+}
+
 VideoRtpDepacketizer::VideoRtpDepacketizer() : RtpDepacketizer(ClockRate) {}
 
 VideoRtpDepacketizer::~VideoRtpDepacketizer() {}
 
-void VideoRtpDepacketizer::incoming(message_vector &messages,
-                                    [[maybe_unused]] const message_callback &send) {
+void VideoRtpDepacketizer::setTargetDelay(std::chrono::milliseconds delay) {
+	std::lock_guard lock(mMutex);
+	mTargetDelay = delay;
+}
+
+void VideoRtpDepacketizer::incoming(message_vector &messages, const message_callback &send) {
+	std::lock_guard lock(mMutex);
+	const auto now = clock::now();
 	message_vector result;
-	for (auto message : messages) {
+	for (auto &message : messages) {
 		if (message->type == Message::Control) {
 			result.push_back(std::move(message));
 			continue;
@@ -72,38 +91,207 @@ void VideoRtpDepacketizer::incoming(message_vector &messages,
 			continue;
 		}
 
-		auto header = reinterpret_cast<const RtpHeader *>(message->data());
+		insert(std::move(message), now, send);
+	};
+
+	process(result, send, now);
+	messages.swap(result);
+}
+
+void VideoRtpDepacketizer::insert(message_ptr message, clock::time_point now,
+                                  const message_callback &send) {
+	auto header = reinterpret_cast<const RtpHeader *>(message->data());
+	if (mSsrc && header->ssrc() != *mSsrc) {
+		PLOG_DEBUG << "RTP stream changed, SSRC=" << header->ssrc();
+		reset();
+	}
+
+	mSsrc = header->ssrc();
+	if (!mNextSeqNumber) {
+		if (mPackets.empty())
+			mPackets.resize(MaxBufferedCount);
+
+		mNextSeqNumber = header->seqNumber();
+		mHighestSeqNumber = header->seqNumber();
+	}
+
+	const int64_t seqNumber =
+	    mHighestSeqNumber + int16_t(header->seqNumber() - uint16_t(mHighestSeqNumber));
+
+	if (seqNumber < *mNextSeqNumber) {
+		PLOG_VERBOSE << "Dropping late RTP packet, seq=" << header->seqNumber();
+		if (mLastGiveUp && seqNumber >= mLastGiveUp->begin && seqNumber < mLastGiveUp->end)
+			updateDelay(now - mLastGiveUp->detected); // we gave up too early
+		return;
+	}
+
+	if (seqNumber - *mNextSeqNumber >= int64_t(MaxBufferedCount)) {
+		PLOG_DEBUG << "RTP sequence number out of the jitter buffer, seq=" << header->seqNumber();
+		reset();
+		requestKeyframe(send);
+		insert(std::move(message), now, send);
+		return;
+	}
+
+	if (find(seqNumber))
+		return; // duplicate
+
+	if (seqNumber > mHighestSeqNumber) {
+		if (const auto count = seqNumber - mHighestSeqNumber - 1;
+		    count > 0 && count <= int64_t(MaxNackCount)) {
+			std::vector<uint16_t> missing;
+			missing.reserve(size_t(count));
+			for (int64_t s = mHighestSeqNumber + 1; s < seqNumber; ++s)
+				missing.push_back(uint16_t(s));
+
+			requestRetransmission(missing, send);
+		}
+		mHighestSeqNumber = seqNumber;
+
+	} else if (seqNumber < mHighestSeqNumber) {
+		// The packet was missing since the arrival of the next one
+		updateDelay(now - find(findNext(seqNumber))->arrival);
+	}
+
+	auto &packet = mPackets[size_t(seqNumber) % MaxBufferedCount];
+	packet.message = std::move(message);
+	packet.arrival = now;
+	packet.seqNumber = seqNumber;
+	++mCount;
+}
+
+void VideoRtpDepacketizer::process(message_vector &result, const message_callback &send,
+                                   clock::time_point now) {
+	bool keyframeNeeded = false;
+	while (mCount > 0) {
+		const int64_t begin = findNext(*mNextSeqNumber);
+		auto first = reinterpret_cast<const RtpHeader *>(find(begin)->message->data());
+		const uint32_t timestamp = first->timestamp();
+		if (mLastTimestamp && timestamp == *mLastTimestamp) {
+			// Remaining packet of a dropped frame
+			erase(begin, begin + 1);
+			mNextSeqNumber = begin + 1;
+			continue;
+		}
+
+		const bool startKnown = begin == *mNextSeqNumber;
+
+		// Find the end of the frame, which is complete if its packets are contiguous until the
+		// marker bit or the timestamp changes
+		int64_t end = begin;
+		bool complete = false;
+		while (end <= mHighestSeqNumber) {
+			auto packet = find(end);
+			if (!packet)
+				break;
 
-		if (!mBuffer.empty()) {
-			auto first = *mBuffer.begin();
-			auto firstHeader = reinterpret_cast<const RtpHeader *>(first->data());
-			if (firstHeader->timestamp() != header->timestamp()) {
-				if (auto frame = reassemble(mBuffer))
-					result.push_back(frame);
+			auto header = reinterpret_cast<const RtpHeader *>(packet->message->data());
+			if (header->timestamp() != timestamp) {
+				complete = true;
+				break;
+			}
 
-				mBuffer.clear();
+			++end;
+			if (header->marker()) {
+				complete = true;
+				break;
 			}
 		}
 
-		mBuffer.insert(std::move(message));
+		if (startKnown && complete) {
+			emit(begin, end, result);
+			continue;
+		}
+
+		if (startKnown && end > mHighestSeqNumber)
+			break; // The rest of the frame has not arrived yet
 
-		if (header->marker()) {
-			if (auto frame = reassemble(mBuffer))
-				result.push_back(std::move(frame));
+		// Packets are missing, wait for them to be retransmitted or reordered
+		const auto detected = find(startKnown ? findNext(end) : begin)->arrival;
+		if (now - detected < waitDelay())
+			break;
 
-			mBuffer.clear();
+		PLOG_DEBUG << "Dropping incomplete video frame, timestamp=" << timestamp;
+		erase(begin, end);
+		mLastTimestamp = timestamp;
+		// The lost packets were waited for already, so the next packet is taken as a frame start
+		const int64_t next = mCount > 0 ? findNext(end) : end;
+		mLastGiveUp.emplace(GiveUp{*mNextSeqNumber, next, detected});
+		mNextSeqNumber = next;
+		keyframeNeeded = true;
+	}
+
+	if (keyframeNeeded)
+		requestKeyframe(send);
+}
+
+void VideoRtpDepacketizer::emit(int64_t begin, int64_t end, message_vector &result) {
+	// The buffer is kept so its capacity is reused
+	mFrame.clear();
+	for (int64_t seqNumber = begin; seqNumber < end; ++seqNumber)
+		mFrame.push_back(std::move(find(seqNumber)->message));
+
+	mCount -= mFrame.size();
+	mNextSeqNumber = end;
+	mLastTimestamp = reinterpret_cast<const RtpHeader *>(mFrame.front()->data())->timestamp();
+
+	if (auto frame = reassemble(mFrame))
+		result.push_back(std::move(frame));
+
+	mFrame.clear();
+}
+
+void VideoRtpDepacketizer::erase(int64_t begin, int64_t end) {
+	for (int64_t seqNumber = begin; seqNumber < end; ++seqNumber) {
+		if (auto packet = find(seqNumber)) {
+			packet->message.reset();
+			--mCount;
 		}
-	};
+	}
+}
 
-	messages.swap(result);
+void VideoRtpDepacketizer::reset() {
+	for (auto &packet : mPackets)
+		packet.message.reset();
+
+	mCount = 0;
+	mSsrc.reset();
+	mNextSeqNumber.reset();
+	mHighestSeqNumber = 0;
+	mLastTimestamp.reset();
+	mLastGiveUp.reset();
+}
+
+VideoRtpDepacketizer::Packet *VideoRtpDepacketizer::find(int64_t seqNumber) {
+	auto &packet = mPackets[size_t(seqNumber) % MaxBufferedCount];
+	return packet.message && packet.seqNumber == seqNumber ? &packet : nullptr;
 }
 
-bool VideoRtpDepacketizer::sequence_cmp::operator()(message_ptr a, message_ptr b) const {
-	assert(a->size() >= sizeof(RtpHeader) && b->size() >= sizeof(RtpHeader));
-	auto ha = reinterpret_cast<const rtc::RtpHeader *>(a->data());
-	auto hb = reinterpret_cast<const rtc::RtpHeader *>(b->data());
-	int16_t d = int16_t(hb->seqNumber() - ha->seqNumber());
-	return d > 0;
+int64_t VideoRtpDepacketizer::findNext(int64_t seqNumber) {
+	// The highest packet is always present when the buffer is not empty
+	while (!find(seqNumber))
+		++seqNumber;
+
+	return seqNumber;
+}
+
+void VideoRtpDepacketizer::updateDelay(clock::duration sample) {
+	// Smoothed like the RTT for the retransmission timeout, see RFC 6298
+	if (!mLateness) {
+		mLateness = sample;
+		mLatenessDeviation = sample / 2;
+	} else {
+		const auto diff = *mLateness > sample ? *mLateness - sample : sample - *mLateness;
+		mLatenessDeviation = (3 * mLatenessDeviation + diff) / 4;
+		mLateness = (7 * *mLateness + sample) / 8;
+	}
+}
+
+VideoRtpDepacketizer::clock::duration VideoRtpDepacketizer::waitDelay() const {
+	if (!mLateness)
+		return mTargetDelay;
+
+	return std::min(*mLateness + 4 * mLatenessDeviation, clock::duration(mTargetDelay));
 }
 
 } // namespace rtc
@@ -0,0 +1,256 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtpforwarder.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/keyframe.hpp"
+#include "impl/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+
+namespace rtc {
+
+RtpForwarder::RtpForwarder() {}
+
+void RtpForwarder::media(const Description::Media &desc) {
+	std::vector<uint8_t> rtxPayloadTypes;
+	std::unordered_map<uint8_t, int> clockRates;
+	std::unordered_map<uint8_t, impl::VideoCodec> codecs;
+	for (int pt : desc.payloadTypes()) {
+		if (auto rtxPt = desc.getRtxPayloadType(pt))
+			rtxPayloadTypes.push_back(uint8_t(*rtxPt));
+
+		if (auto map = desc.rtpMap(pt)) {
+			clockRates.emplace(uint8_t(pt), map->clockRate);
+			codecs.emplace(uint8_t(pt), impl::video_codec_from_format(map->format));
+		}
+	}
+
+	std::lock_guard lock(mMutex);
+	mRtxPayloadTypes = std::move(rtxPayloadTypes);
+	mClockRates = std::move(clockRates);
+	mCodecs = std::move(codecs);
+}
+
+void RtpForwarder::incoming(message_vector &messages,
+                            [[maybe_unused]] const message_callback &send) {
+	std::lock_guard lock(mMutex);
+
+	// Tracks closed meanwhile are dropped
+	mOutputs.erase(std::remove_if(mOutputs.begin(), mOutputs.end(),
+	                              [](const Output &output) { return output.track->isClosed(); }),
+	               mOutputs.end());
+
+	// Without tracks, packets are still cached for the first one
+	if (mOutputs.empty() && mCacheMaxSize == 0)
+		return;
+
+	for (const auto &message : messages) {
+		if (message->type != Message::Binary || message->size() < sizeof(RtpHeader))
+			continue;
+
+		auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+		if (std::find(mRtxPayloadTypes.begin(), mRtxPayloadTypes.end(), rtp->payloadType()) !=
+		    mRtxPayloadTypes.end())
+			continue;
+
+		// The header is rewritten in place for each track, then restored for the rest of the chain
+		std::array<byte, sizeof(RtpHeader)> header;
+		std::memcpy(header.data(), message->data(), header.size());
+		auto original = reinterpret_cast<const RtpHeader *>(header.data());
+		const bool keyframe = mCacheMaxSize > 0 && isKeyframeStart(*original, message);
+		if (mCacheMaxSize > 0)
+			cache(*original, keyframe, message);
+
+		for (auto &output : mOutputs)
+			if (output.started || start(output, *original, keyframe))
+				forward(output, *original, message);
+
+		std::memcpy(message->data(), header.data(), header.size());
+	}
+}
+
+void RtpForwarder::addTrack(shared_ptr<Track> track, SSRC ssrc, optional<uint8_t> payloadType) {
+	if (!track)
+		throw std::invalid_argument("Forwarding to a null track");
+
+	std::lock_guard lock(mMutex);
+	for (auto &output : mOutputs) {
+		if (output.track == track) {
+			output.ssrc = ssrc;
+			output.payloadType = payloadType;
+			return;
+		}
+	}
+
+	Output output;
+	output.track = std::move(track);
+	output.ssrc = ssrc;
+	output.payloadType = payloadType;
+	mOutputs.push_back(std::move(output));
+}
+
+void RtpForwarder::removeTrack(const shared_ptr<Track> &track) {
+	std::lock_guard lock(mMutex);
+	mOutputs.erase(std::remove_if(mOutputs.begin(), mOutputs.end(),
+	                              [&](const Output &output) { return output.track == track; }),
+	               mOutputs.end());
+}
+
+size_t RtpForwarder::trackCount() const {
+	std::lock_guard lock(mMutex);
+	return mOutputs.size();
+}
+
+void RtpForwarder::setSource(const shared_ptr<Track> &track, optional<SSRC> source) {
+	std::lock_guard lock(mMutex);
+	for (auto &output : mOutputs)
+		if (output.track == track)
+			output.filter = source;
+}
+
+void RtpForwarder::setKeyframeCache(size_t maxSize) {
+	std::lock_guard lock(mMutex);
+	mCacheMaxSize = maxSize;
+	if (maxSize == 0)
+		mCaches.clear();
+}
+
+bool RtpForwarder::hasCachedKeyframe() const {
+	std::lock_guard lock(mMutex);
+	return std::any_of(mCaches.begin(), mCaches.end(),
+	                   [](const auto &p) { return !p.second.packets.empty(); });
+}
+
+bool RtpForwarder::isKeyframeStart(const RtpHeader &rtp, const message_ptr &message) const {
+	// Requires mMutex to be locked
+	auto it = mCodecs.find(rtp.payloadType());
+	return it != mCodecs.end() && impl::is_keyframe_start(it->second, *message, rtp);
+}
+
+void RtpForwarder::cache(const RtpHeader &rtp, bool keyframe, const message_ptr &message) {
+	// Requires mMutex to be locked
+	auto &cache = mCaches[rtp.ssrc()];
+	if (keyframe && (cache.packets.empty() || cache.timestamp != rtp.timestamp())) {
+		cache.packets.clear();
+		cache.size = 0;
+		cache.timestamp = rtp.timestamp();
+	} else if (cache.packets.empty()) {
+		return; // wait for the next keyframe
+	}
+
+	if (cache.size + message->size() > mCacheMaxSize) {
+		PLOG_DEBUG << "Keyframe cache is full, waiting for the next keyframe";
+		cache.packets.clear();
+		cache.size = 0;
+		return;
+	}
+
+	// Packets are not modified by the rest of the chain, so the buffer is shared
+	cache.packets.push_back(message);
+	cache.size += message->size();
+}
+
+bool RtpForwarder::start(Output &output, const RtpHeader &rtp, bool keyframe) {
+	// Requires mMutex to be locked
+	const SSRC ssrc = rtp.ssrc();
+	if ((output.filter && *output.filter != ssrc) || !output.track->isOpen())
+		return false;
+
+	// Without cache, tracks start immediately, like for non-video payload types
+	auto codec = mCodecs.find(rtp.payloadType());
+	if (mCacheMaxSize == 0 || keyframe || codec == mCodecs.end() ||
+	    codec->second == impl::VideoCodec::Unknown) {
+		output.started = true;
+		return true;
+	}
+
+	auto it = mCaches.find(ssrc);
+	if (it == mCaches.end() || it->second.packets.empty())
+		return false; // wait for the next keyframe
+
+	// Send the cached packets before the current one, which is the last one
+	PLOG_DEBUG << "Starting forwarding with a cached keyframe, packets="
+	           << it->second.packets.size();
+	const auto &packets = it->second.packets;
+	std::array<byte, sizeof(RtpHeader)> header;
+	for (auto p = packets.begin(); p + 1 < packets.end(); ++p) {
+		const auto &packet = *p;
+		std::memcpy(header.data(), packet->data(), header.size());
+		forward(output, *reinterpret_cast<const RtpHeader *>(header.data()), packet);
+		std::memcpy(packet->data(), header.data(), header.size());
+	}
+
+	output.started = true;
+	return true;
+}
+
+void RtpForwarder::forward(Output &output, const RtpHeader &original,
+                           const message_ptr &message) {
+	// Requires mMutex to be locked
+	const SSRC ssrc = original.ssrc();
+	if ((output.filter && *output.filter != ssrc) || !output.track->isOpen())
+		return;
+
+	const uint16_t seqNumber = original.seqNumber();
+	const uint32_t timestamp = original.timestamp();
+	const uint8_t payloadType = original.payloadType();
+	const auto now = std::chrono::steady_clock::now();
+
+	if (output.source != ssrc) {
+		if (!output.source) {
+			// RFC 3550: The initial values of the sequence number and timestamp SHOULD be random
+			auto uniform = std::uniform_int_distribution<uint32_t>();
+			auto engine = impl::utils::random_engine();
+			output.lastSeqNumber = uint16_t(uniform(engine));
+			output.lastTimestamp = uniform(engine);
+		} else {
+			// Continue after the last packet, the timestamp advancing with the elapsed time
+			auto it = mClockRates.find(payloadType);
+			const int clockRate = it != mClockRates.end() ? it->second : 90000;
+			const auto elapsed = std::chrono::duration<double>(now - output.lastTime).count();
+			output.lastTimestamp += std::max(uint32_t(elapsed * clockRate), uint32_t(1));
+		}
+
+		PLOG_DEBUG << "Forwarding RTP stream with SSRC " << ssrc << " to SSRC " << output.ssrc;
+		output.source = ssrc;
+		output.seqOffset = uint16_t(output.lastSeqNumber + 1 - seqNumber);
+		output.timestampOffset = output.lastTimestamp - timestamp;
+	}
+
+	const uint16_t outSeqNumber = uint16_t(seqNumber + output.seqOffset);
+	const uint32_t outTimestamp = timestamp + output.timestampOffset;
+	if (int16_t(outSeqNumber - output.lastSeqNumber) > 0) {
+		output.lastSeqNumber = outSeqNumber;
+		output.lastTimestamp = outTimestamp;
+		output.lastTime = now;
+	}
+
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->setSsrc(output.ssrc);
+	rtp->setSeqNumber(outSeqNumber);
+	rtp->setTimestamp(outTimestamp);
+	rtp->setPayloadType(output.payloadType.value_or(payloadType));
+
+	try {
+		// The track copies the packet so it can be protected in place
+		output.track->send(message->data(), message->size());
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "Failed to forward RTP packet: " << e.what();
+	}
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -10,11 +10,23 @@
 
 #include "rtppacketizer.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
 namespace rtc {
 
+namespace {
+
+// Makes room for the packets of a frame at once, without losing geometric growth over frames
+void reserveMore(message_vector &messages, size_t count) {
+	const size_t required = messages.size() + count;
+	if (messages.capacity() < required)
+		messages.reserve(std::max(required, 2 * messages.capacity()));
+}
+
+} // namespace
+
 RtpPacketizer::RtpPacketizer(shared_ptr<RtpPacketizationConfig> rtpConfig) : rtpConfig(rtpConfig) {}
 
 RtpPacketizer::~RtpPacketizer() {}
@@ -24,56 +36,146 @@ std::vector<binary> RtpPacketizer::fragment(binary data) {
 	return {std::move(data)};
 }
 
+size_t RtpPacketizer::maxFragmentSize(size_t maxFragmentSize) const {
+	return rtpConfig->maxFragmentSize > 0 ? rtpConfig->maxFragmentSize : maxFragmentSize;
+}
+
+bool RtpPacketizer::slice([[maybe_unused]] const binary &frame,
+                          [[maybe_unused]] std::vector<Slice> &slices) {
+	// Default implementation, fragment() moves the frame as a single payload
+	return false;
+}
+
 message_ptr RtpPacketizer::packetize(const binary &payload, bool mark) {
-	size_t rtpExtHeaderSize = 0;
-	bool twoByteHeader = false;
+	auto message = createPacket(payload.size(), mark);
+	std::memcpy(message->data() + message->size() - payload.size(), payload.data(),
+	            payload.size());
+	return message;
+}
+
+// MID, RID, playout delay, and color space extensions are constant for a given configuration, so
+// they are encoded once in both header forms and copied to each packet
+struct RtpPacketizer::ExtensionTemplate {
+	// Configuration the template was built from
+	uint8_t midId, ridId, playoutDelayId, colorSpaceId;
+	optional<string> mid, rid;
+	uint16_t playoutDelayMin, playoutDelayMax;
+	std::array<uint8_t, 6> color;
+
+	bool twoByteRequired = false; // an extension does not fit in the one-byte header form
+	binary oneByte;               // elements in the one-byte header form, if not required
+	binary twoByte;               // elements in the two-byte header form
+
+	explicit ExtensionTemplate(const RtpPacketizationConfig &config);
+	bool matches(const RtpPacketizationConfig &config) const;
+
+private:
+	static std::array<uint8_t, 6> ColorOf(const RtpPacketizationConfig &config);
+	void append(uint8_t id, const byte *data, size_t size);
+};
+
+RtpPacketizer::ExtensionTemplate::ExtensionTemplate(const RtpPacketizationConfig &config)
+    : midId(config.midId), ridId(config.ridId), playoutDelayId(config.playoutDelayId),
+      colorSpaceId(config.colorSpaceId), mid(config.mid), rid(config.rid),
+      playoutDelayMin(config.playoutDelayMin), playoutDelayMax(config.playoutDelayMax),
+      color(ColorOf(config)) {
+
+	if (mid)
+		append(midId, reinterpret_cast<const byte *>(mid->data()), mid->size());
+
+	if (rid)
+		append(ridId, reinterpret_cast<const byte *>(rid->data()), rid->size());
+
+	if (playoutDelayId > 0) {
+		uint16_t min = playoutDelayMin & 0xFFF;
+		uint16_t max = playoutDelayMax & 0xFFF;
+
+		// 12 bits for min + 12 bits for max
+		byte data[] = {byte((min >> 4) & 0xFF), byte(((min & 0xF) << 4) | ((max >> 8) & 0xF)),
+		               byte(max & 0xFF)};
+		append(playoutDelayId, data, 3);
+	}
+
+	if (colorSpaceId > 0) {
+		uint8_t rangeChr = uint8_t((config.colorRange << 4) + (config.colorChromaSitingHorz << 2) +
+		                           config.colorChromaSitingVert);
+
+		byte data[] = {byte(config.colorPrimaries), byte(config.colorTransfer),
+		               byte(config.colorMatrix), byte(rangeChr)};
+		append(colorSpaceId, data, 4);
+	}
+
+	if (twoByteRequired)
+		oneByte.clear();
+}
+
+bool RtpPacketizer::ExtensionTemplate::matches(const RtpPacketizationConfig &config) const {
+	return midId == config.midId && ridId == config.ridId &&
+	       playoutDelayId == config.playoutDelayId && colorSpaceId == config.colorSpaceId &&
+	       playoutDelayMin == config.playoutDelayMin &&
+	       playoutDelayMax == config.playoutDelayMax && mid == config.mid && rid == config.rid &&
+	       color == ColorOf(config);
+}
+
+std::array<uint8_t, 6>
+RtpPacketizer::ExtensionTemplate::ColorOf(const RtpPacketizationConfig &config) {
+	return {config.colorChromaSitingHorz, config.colorChromaSitingVert, config.colorRange,
+	        config.colorPrimaries,        config.colorTransfer,         config.colorMatrix};
+}
+
+void RtpPacketizer::ExtensionTemplate::append(uint8_t id, const byte *data, size_t size) {
+	// RFC 8285 4.2. One-Byte Header and 4.3. Two-Byte Header
+	if (id == 0 || size == 0 || size > 255)
+		return;
+
+	if (id > 14 || size > 16) {
+		twoByteRequired = true;
+	} else {
+		oneByte.push_back(byte((id << 4) | uint8_t(size - 1)));
+		oneByte.insert(oneByte.end(), data, data + size);
+	}
+
+	twoByte.push_back(byte(id));
+	twoByte.push_back(byte(size));
+	twoByte.insert(twoByte.end(), data, data + size);
+}
+
+const RtpPacketizer::ExtensionTemplate &RtpPacketizer::extensionTemplate() {
+	if (!mExtensionTemplate || !mExtensionTemplate->matches(*rtpConfig))
+		mExtensionTemplate = std::make_unique<ExtensionTemplate>(*rtpConfig);
+
+	return *mExtensionTemplate;
+}
+
+message_ptr RtpPacketizer::createPacket(size_t payloadSize, bool mark) {
+	const auto &extensions = extensionTemplate();
 
+	// Video orientation and the dependency descriptor change between packets
 	const bool setVideoRotation =
 	    (rtpConfig->videoOrientationId != 0) && mark && (rtpConfig->videoOrientation != 0);
 
 	std::optional<DependencyDescriptorWriter> ddWriter;
-	if (rtpConfig->dependencyDescriptorContext.has_value()) {
+	if (rtpConfig->dependencyDescriptorContext.has_value() &&
+	    rtpConfig->dependencyDescriptorId != 0) {
 		ddWriter.emplace(*rtpConfig->dependencyDescriptorContext);
+		if (ddWriter->getSize() == 0)
+			ddWriter.reset();
 	}
+	const size_t ddSize = ddWriter ? ddWriter->getSize() : 0;
 
 	// Determine if a two-byte header is necessary
-	// Check for dependency descriptor extension
-	if (ddWriter.has_value()) {
-		auto sizeBytes = ddWriter->getSize();
-		if (sizeBytes > 16 || rtpConfig->dependencyDescriptorId > 14) {
-			twoByteHeader = true;
-		}
-	}
-	// Check for other extensions
-	if ((setVideoRotation && rtpConfig->videoOrientationId > 14) ||
-	    (rtpConfig->mid.has_value() && rtpConfig->midId > 14) ||
-	    (rtpConfig->rid.has_value() && rtpConfig->ridId > 14) ||
-	    rtpConfig->playoutDelayId > 14) {
-		twoByteHeader = true;
-	}
-	size_t headerSize = twoByteHeader ? 2 : 1;
+	const bool twoByteHeader = extensions.twoByteRequired ||
+	                           (setVideoRotation && rtpConfig->videoOrientationId > 14) ||
+	                           (ddWriter && (ddSize > 16 || rtpConfig->dependencyDescriptorId > 14));
+	const size_t headerSize = twoByteHeader ? 2 : 1;
+	const binary &constant = twoByteHeader ? extensions.twoByte : extensions.oneByte;
 
+	size_t rtpExtHeaderSize = constant.size();
 	if (setVideoRotation)
 		rtpExtHeaderSize += headerSize + 1;
 
-	const bool setPlayoutDelay = rtpConfig->playoutDelayId > 0;
-	const bool setColorSpace = rtpConfig->colorSpaceId > 0;
-
-	if (setPlayoutDelay)
-		rtpExtHeaderSize += headerSize + 3;
-
-	if (setColorSpace)
-		rtpExtHeaderSize += headerSize + 4;
-	
-	if (rtpConfig->mid.has_value())
-		rtpExtHeaderSize += headerSize + rtpConfig->mid->length();
-
-	if (rtpConfig->rid.has_value())
-		rtpExtHeaderSize += headerSize + rtpConfig->rid->length();
-
-	if (ddWriter.has_value()) {
-		rtpExtHeaderSize += headerSize + ddWriter->getSize();
-	}
+	if (ddWriter)
+		rtpExtHeaderSize += headerSize + ddSize;
 
 	if (rtpExtHeaderSize != 0)
 		rtpExtHeaderSize += 4;
@@ -82,7 +184,8 @@ message_ptr RtpPacketizer::packetize(const binary &payload, bool mark) {
 	// according to RFC 3550, sec. 5.3.1.
 	rtpExtHeaderSize = (rtpExtHeaderSize + 3) & ~3;
 
-	auto message = make_message(RtpHeaderSize + rtpExtHeaderSize + payload.size());
+	auto message = make_message_with_tailroom(RtpHeaderSize + rtpExtHeaderSize + payloadSize,
+	                                          DEFAULT_MEDIA_TAILROOM);
 	auto *rtp = (RtpHeader *)message->data();
 	rtp->setPayloadType(rtpConfig->payloadType);
 	rtp->setSeqNumber(rtpConfig->sequenceNumber++); // increase sequence number
@@ -100,65 +203,36 @@ message_ptr RtpPacketizer::packetize(const binary &payload, bool mark) {
 		extHeader->setProfileSpecificId(twoByteHeader ? 0x1000 : 0xbede);
 
 		auto headerLength = static_cast<uint16_t>(rtpExtHeaderSize / 4) - 1;
-
 		extHeader->setHeaderLength(headerLength);
-		extHeader->clearBody();
 
+		auto body = reinterpret_cast<byte *>(extHeader->getBody());
 		size_t offset = 0;
 		if (setVideoRotation) {
 			offset += extHeader->writeCurrentVideoOrientation(
 			    twoByteHeader, offset, rtpConfig->videoOrientationId, rtpConfig->videoOrientation);
 		}
 
-		if (rtpConfig->mid.has_value()) {
-			offset +=
-			    extHeader->writeHeader(twoByteHeader, offset, rtpConfig->midId,
-			                           reinterpret_cast<const std::byte *>(rtpConfig->mid->c_str()),
-			                           rtpConfig->mid->length());
-		}
-
-		if (rtpConfig->rid.has_value()) {
-			offset +=
-			    extHeader->writeHeader(twoByteHeader, offset, rtpConfig->ridId,
-			                           reinterpret_cast<const std::byte *>(rtpConfig->rid->c_str()),
-			                           rtpConfig->rid->length());
-		}
-
-		if (ddWriter.has_value()) {
-			auto sizeBytes = ddWriter->getSize();
-			std::vector<std::byte> buf(sizeBytes);
-			ddWriter->writeTo(buf.data(), sizeBytes);
-			offset += extHeader->writeHeader(
-			    twoByteHeader, offset, rtpConfig->dependencyDescriptorId, buf.data(), sizeBytes);
-		}
-
-		if (setPlayoutDelay) {
-			uint16_t min = rtpConfig->playoutDelayMin & 0xFFF;
-			uint16_t max = rtpConfig->playoutDelayMax & 0xFFF;
-
-			// 12 bits for min + 12 bits for max
-			byte data[] = {byte((min >> 4) & 0xFF), byte(((min & 0xF) << 4) | ((max >> 8) & 0xF)),
-			               byte(max & 0xFF)};
-
-			offset += extHeader->writeHeader(
-			    twoByteHeader, offset, rtpConfig->playoutDelayId, data, 3);
+		std::memcpy(body + offset, constant.data(), constant.size());
+		offset += constant.size();
+
+		if (ddWriter) {
+			// Write the descriptor in place after its element header
+			const uint8_t id = rtpConfig->dependencyDescriptorId;
+			if (twoByteHeader) {
+				body[offset++] = byte(id);
+				body[offset++] = byte(ddSize);
+			} else {
+				body[offset++] = byte((id << 4) | uint8_t(ddSize - 1));
+			}
+			ddWriter->writeTo(body + offset, ddSize);
+			offset += ddSize;
 		}
 
-		if (setColorSpace) {
-			uint8_t range_chr = (rtpConfig->colorRange << 4) + (rtpConfig->colorChromaSitingHorz << 2) + rtpConfig->colorChromaSitingVert;
-
-			byte data[] = {byte(rtpConfig->colorPrimaries), byte(rtpConfig->colorTransfer),
-			               byte(rtpConfig->colorMatrix), byte(range_chr)};
-
-			offset += extHeader->writeHeader(
-			    twoByteHeader, offset, rtpConfig->playoutDelayId, data, 4);
-		}
+		// Padding
+		std::memset(body + offset, 0, extHeader->getSize() - offset);
 	}
 
 	rtp->preparePacket();
-
-	std::memcpy(message->data() + RtpHeaderSize + rtpExtHeaderSize, payload.data(), payload.size());
-
 	return message;
 }
 
@@ -171,6 +245,7 @@ void RtpPacketizer::media([[maybe_unused]] const Description::Media &desc) {}
 void RtpPacketizer::outgoing(message_vector &messages,
                              [[maybe_unused]] const message_callback &send) {
 	message_vector result;
+	result.reserve(messages.size()); // exact for audio, a single packet per frame
 	for (const auto &message : messages) {
 		if (const auto &frameInfo = message->frameInfo) {
 			if (frameInfo->payloadType && frameInfo->payloadType != rtpConfig->payloadType)
@@ -185,7 +260,36 @@ void RtpPacketizer::outgoing(message_vector &messages,
 				rtpConfig->timestamp = frameInfo->timestamp;
 		}
 
+		// Write packets straight from the frame if possible
+		mSlices.clear();
+		if (slice(*message, mSlices)) {
+			reserveMore(result, mSlices.size());
+			for (size_t i = 0; i < mSlices.size(); i++) {
+				const auto &slice = mSlices[i];
+				if (rtpConfig->dependencyDescriptorContext.has_value()) {
+					auto &ctx = *rtpConfig->dependencyDescriptorContext;
+					ctx.descriptor.startOfFrame = i == 0;
+					ctx.descriptor.endOfFrame = i == mSlices.size() - 1;
+				}
+				bool mark = i == mSlices.size() - 1;
+				const size_t payloadSize = slice.prefixSize + slice.insertSize + slice.size;
+				auto packet = createPacket(payloadSize, mark);
+				auto payload = packet->data() + packet->size() - payloadSize;
+				std::memcpy(payload, slice.prefix.data(), slice.prefixSize);
+				payload += slice.prefixSize;
+				if (slice.insertSize > 0) {
+					std::memcpy(payload, slice.insert, slice.insertSize);
+					payload += slice.insertSize;
+				}
+				std::memcpy(payload, message->data() + slice.offset, slice.size);
+				packet->frameInfo = message->frameInfo;
+				result.push_back(std::move(packet));
+			}
+			continue;
+		}
+
 		auto payloads = fragment(std::move(*message));
+		reserveMore(result, payloads.size());
 		for (size_t i = 0; i < payloads.size(); i++) {
 			if (rtpConfig->dependencyDescriptorContext.has_value()) {
 				auto &ctx = *rtpConfig->dependencyDescriptorContext;
@@ -193,7 +297,9 @@ void RtpPacketizer::outgoing(message_vector &messages,
 				ctx.descriptor.endOfFrame = i == payloads.size() - 1;
 			}
 			bool mark = i == payloads.size() - 1;
-			result.push_back(packetize(payloads[i], mark));
+			auto packet = packetize(payloads[i], mark);
+			packet->frameInfo = message->frameInfo;
+			result.push_back(std::move(packet));
 		}
 	}
 
@@ -0,0 +1,357 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtprecorder.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/threadpool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace rtc {
+
+namespace {
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+// Dedicated thread running the writes of all recorders created with RtpRecorderInit::ioThread
+class IoThread final {
+public:
+	static IoThread &Instance() {
+		static IoThread instance;
+		return instance;
+	}
+
+	void post(std::function<void()> task) {
+		{
+			std::lock_guard lock(mMutex);
+			mTasks.push_back(std::move(task));
+		}
+		mCondition.notify_one();
+	}
+
+private:
+	IoThread() : mThread(&IoThread::run, this) {}
+
+	~IoThread() {
+		{
+			std::lock_guard lock(mMutex);
+			mJoining = true;
+		}
+		mCondition.notify_one();
+		mThread.join();
+	}
+
+	void run() {
+		std::unique_lock lock(mMutex);
+		while (true) {
+			mCondition.wait(lock, [this]() { return mJoining || !mTasks.empty(); });
+			if (mTasks.empty())
+				break;
+
+			auto task = std::move(mTasks.front());
+			mTasks.pop_front();
+			lock.unlock();
+			task();
+			lock.lock();
+		}
+	}
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<std::function<void()>> mTasks;
+	bool mJoining = false;
+	std::thread mThread; // last so it starts after the other members are initialized
+};
+
+void writeUint16(byte *dst, uint16_t value) {
+	dst[0] = byte(value >> 8);
+	dst[1] = byte(value & 0xFF);
+}
+
+void writeUint32(byte *dst, uint32_t value) {
+	writeUint16(dst, uint16_t(value >> 16));
+	writeUint16(dst + 2, uint16_t(value & 0xFFFF));
+}
+
+} // namespace
+
+class RtpRecorder::Writer final : public std::enable_shared_from_this<Writer> {
+public:
+	Writer(const string &path, RtpRecorderInit init);
+	~Writer();
+
+	void record(const message_vector &messages);
+	void flush();
+	void close(); // schedules pending packets without waiting
+
+	std::atomic<uint64_t> recordedCount = 0;
+	std::atomic<uint64_t> droppedCount = 0;
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	// rtpdump packet header: length including the header, RTP length or 0 for RTCP, offset in ms
+	static constexpr size_t PacketHeaderSize = 8;
+
+	void schedule();
+	void drain();
+	bool write(const void *data, size_t size);
+	bool write(const message_vector &entries);
+
+	const RtpRecorderInit mInit;
+	const clock::time_point mStart;
+	int mFile = -1;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	message_vector mPending; // packets copied after their rtpdump header
+	size_t mPendingSize = 0;
+	bool mScheduled = false; // true iff drain() is pending or running
+
+	// Only accessed by drain()
+	message_vector mWriting;
+	bool mFailed = false;
+#ifndef _WIN32
+	std::vector<struct iovec> mIov;
+#endif
+};
+
+RtpRecorder::Writer::Writer(const string &path, RtpRecorderInit init)
+    : mInit(std::move(init)), mStart(clock::now()) {
+#ifdef _WIN32
+	mFile = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+	mFile = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+	if (mFile < 0)
+		throw std::runtime_error("Failed to open recording file \"" + path +
+		                         "\": " + std::strerror(errno));
+
+	// rtpdump file header: text line, then start time, source address and port
+	const string line = "#!rtpplay1.0 0.0.0.0/0\n";
+	const auto now = std::chrono::system_clock::now().time_since_epoch();
+	const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now);
+	const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now - seconds);
+	std::array<byte, 16> header = {};
+	writeUint32(header.data(), uint32_t(seconds.count()));
+	writeUint32(header.data() + 4, uint32_t(micros.count()));
+	if (!write(line.data(), line.size()) || !write(header.data(), header.size()))
+		mFailed = true;
+}
+
+RtpRecorder::Writer::~Writer() {
+#ifdef _WIN32
+	::_close(mFile);
+#else
+	::close(mFile);
+#endif
+}
+
+void RtpRecorder::Writer::record(const message_vector &messages) {
+	const auto offset = uint32_t(duration_cast<milliseconds>(clock::now() - mStart).count());
+
+	std::unique_lock lock(mMutex);
+	for (const auto &message : messages) {
+		const bool rtcp = message->type == Message::Control;
+		if (!rtcp && message->type != Message::Binary)
+			continue;
+
+		const size_t length = PacketHeaderSize + message->size();
+		if (length > 0xFFFF || mPendingSize + message->size() > mInit.maxPendingSize) {
+			++droppedCount;
+			continue;
+		}
+
+		// The packet is copied as outgoing packets are encrypted in place by the transport
+		auto entry = make_message(length);
+		writeUint16(entry->data(), uint16_t(length));
+		writeUint16(entry->data() + 2, rtcp ? 0 : uint16_t(message->size()));
+		writeUint32(entry->data() + 4, offset);
+		if (!message->empty())
+			std::memcpy(entry->data() + PacketHeaderSize, message->data(), message->size());
+
+		mPending.push_back(std::move(entry));
+		mPendingSize += message->size();
+	}
+
+	if (mScheduled || mPending.empty())
+		return;
+
+	mScheduled = true;
+	lock.unlock();
+	schedule();
+}
+
+void RtpRecorder::Writer::schedule() {
+	// The task keeps the writer alive so packets are written after the recorder is destroyed
+	auto task = [self = shared_from_this()]() { self->drain(); };
+	if (mInit.ioThread)
+		IoThread::Instance().post(std::move(task));
+	else
+		impl::ThreadPool::Instance().post(std::move(task));
+}
+
+void RtpRecorder::Writer::close() {
+	std::unique_lock lock(mMutex);
+	if (mScheduled || mPending.empty())
+		return;
+
+	mScheduled = true;
+	lock.unlock();
+	schedule();
+}
+
+void RtpRecorder::Writer::flush() {
+	std::unique_lock lock(mMutex);
+	if (!mScheduled && !mPending.empty()) {
+		// Nothing is scheduled anymore, write on the caller thread
+		mScheduled = true;
+		lock.unlock();
+		drain();
+		return;
+	}
+
+	mCondition.wait(lock, [this]() { return !mScheduled && mPending.empty(); });
+}
+
+void RtpRecorder::Writer::drain() {
+	std::unique_lock lock(mMutex);
+	while (!mPending.empty()) {
+		mWriting.swap(mPending);
+		mPendingSize = 0;
+		lock.unlock();
+
+		if (!mFailed && write(mWriting)) {
+			recordedCount += mWriting.size();
+		} else {
+			mFailed = true;
+			droppedCount += mWriting.size();
+		}
+		mWriting.clear(); // the packets go back to the pool
+
+		lock.lock();
+	}
+
+	mScheduled = false;
+	mCondition.notify_all();
+}
+
+bool RtpRecorder::Writer::write(const void *data, size_t size) {
+	auto ptr = static_cast<const char *>(data);
+	while (size > 0) {
+#ifdef _WIN32
+		int len = ::_write(mFile, ptr, unsigned(std::min(size, size_t(INT_MAX))));
+#else
+		ssize_t len = ::write(mFile, ptr, size);
+#endif
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+
+			PLOG_WARNING << "Failed to write recording: " << std::strerror(errno);
+			return false;
+		}
+		ptr += len;
+		size -= size_t(len);
+	}
+	return true;
+}
+
+bool RtpRecorder::Writer::write(const message_vector &entries) {
+#ifdef _WIN32
+	// No vectored writes on Windows
+	for (const auto &entry : entries)
+		if (!write(entry->data(), entry->size()))
+			return false;
+
+	return true;
+#else
+	mIov.clear();
+	for (const auto &entry : entries)
+		mIov.push_back({entry->data(), entry->size()});
+
+	size_t i = 0;
+	while (i < mIov.size()) {
+		const int count = int(std::min(mIov.size() - i, size_t(IOV_MAX)));
+		ssize_t len = ::writev(mFile, mIov.data() + i, count);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+
+			PLOG_WARNING << "Failed to write recording: " << std::strerror(errno);
+			return false;
+		}
+
+		// Skip what was written, the last buffer might have been written partially
+		auto written = size_t(len);
+		while (i < mIov.size() && written >= mIov[i].iov_len)
+			written -= mIov[i++].iov_len;
+
+		if (written > 0) {
+			mIov[i].iov_base = static_cast<char *>(mIov[i].iov_base) + written;
+			mIov[i].iov_len -= written;
+		}
+	}
+	return true;
+#endif
+}
+
+RtpRecorder::RtpRecorder(const string &path, RtpRecorderInit init)
+    : mWriter(std::make_shared<Writer>(path, init)), mRecordOutgoing(init.recordOutgoing) {}
+
+RtpRecorder::~RtpRecorder() {
+	// The handler might be destroyed under a lock of the media path, so don't wait for the writes
+	try {
+		mWriter->close();
+	} catch (const std::exception &e) {
+		PLOG_WARNING << e.what();
+	}
+}
+
+void RtpRecorder::incoming(message_vector &messages, const message_callback &) {
+	mWriter->record(messages);
+}
+
+void RtpRecorder::outgoing(message_vector &messages, const message_callback &) {
+	if (mRecordOutgoing)
+		mWriter->record(messages);
+}
+
+void RtpRecorder::flush() { mWriter->flush(); }
+
+uint64_t RtpRecorder::recordedCount() const { return mWriter->recordedCount; }
+
+uint64_t RtpRecorder::droppedCount() const { return mWriter->droppedCount; }
+
+} // namespace rtc
+
+#endif // RTC_ENABLE_MEDIA
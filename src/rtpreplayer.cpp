@@ -0,0 +1,343 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtpreplayer.hpp"
+#include "rtp.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/threadpool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rtc {
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const string FilePrefix = "#!rtpplay1.0 ";
+const size_t MaxFirstLineSize = 128;
+const size_t FileHeaderSize = 16;  // start time, source address and port
+const size_t PacketHeaderSize = 8; // length, RTP length or 0 for RTCP, offset in ms
+
+// Time between the last packet and the first packet of the next loop
+const milliseconds LoopGap(20);
+
+uint16_t readUint16(const byte *src) {
+	return uint16_t(std::to_integer<uint16_t>(src[0]) << 8 | std::to_integer<uint16_t>(src[1]));
+}
+
+uint32_t readUint32(const byte *src) {
+	return uint32_t(readUint16(src)) << 16 | uint32_t(readUint16(src + 2));
+}
+
+} // namespace
+
+struct RtpDump::Mapping {
+	explicit Mapping(const string &path);
+	~Mapping();
+
+	const byte *data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	binary buffer; // read at once instead
+#endif
+};
+
+#ifdef _WIN32
+
+RtpDump::Mapping::Mapping(const string &path) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		throw std::runtime_error("Failed to open RTP dump \"" + path + "\"");
+
+	buffer.resize(size_t(file.tellg()));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char *>(buffer.data()), std::streamsize(buffer.size())))
+		throw std::runtime_error("Failed to read RTP dump \"" + path + "\"");
+
+	data = buffer.data();
+	size = buffer.size();
+}
+
+RtpDump::Mapping::~Mapping() {}
+
+#else
+
+RtpDump::Mapping::Mapping(const string &path) {
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw std::runtime_error("Failed to open RTP dump \"" + path +
+		                         "\": " + std::strerror(errno));
+
+	struct stat st;
+	if (::fstat(fd, &st) < 0) {
+		::close(fd);
+		throw std::runtime_error("Failed to stat RTP dump \"" + path + "\"");
+	}
+
+	size = size_t(st.st_size);
+	if (size > 0) {
+		void *ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr == MAP_FAILED) {
+			::close(fd);
+			throw std::runtime_error("Failed to map RTP dump \"" + path +
+			                         "\": " + std::strerror(errno));
+		}
+		data = static_cast<const byte *>(ptr);
+	}
+	::close(fd); // the mapping remains valid
+}
+
+RtpDump::Mapping::~Mapping() {
+	if (data)
+		::munmap(const_cast<byte *>(data), size);
+}
+
+#endif
+
+shared_ptr<RtpDump> RtpDump::Load(const string &path) {
+	return shared_ptr<RtpDump>(new RtpDump(std::make_unique<Mapping>(path)));
+}
+
+RtpDump::RtpDump(unique_ptr<Mapping> mapping) : mMapping(std::move(mapping)) {
+	const byte *data = mMapping->data;
+	const size_t size = mMapping->size;
+
+	auto begin = reinterpret_cast<const char *>(data);
+	auto end = begin + std::min(size, MaxFirstLineSize);
+	auto newline = std::find(begin, end, '\n');
+	if (newline == end || size_t(newline - begin) < FilePrefix.size() ||
+	    std::memcmp(begin, FilePrefix.data(), FilePrefix.size()) != 0)
+		throw std::invalid_argument("Invalid RTP dump header");
+
+	size_t offset = size_t(newline - begin) + 1 + FileHeaderSize;
+	while (offset + PacketHeaderSize <= size) {
+		const byte *header = data + offset;
+		const size_t length = readUint16(header);
+		const size_t rtpLength = readUint16(header + 2);
+		if (length < PacketHeaderSize || offset + length > size) {
+			PLOG_WARNING << "RTP dump is truncated, ignoring the end";
+			break;
+		}
+
+		Packet packet;
+		packet.data = header + PacketHeaderSize;
+		packet.size = length - PacketHeaderSize;
+		packet.offset = milliseconds(readUint32(header + 4));
+		packet.rtcp = rtpLength == 0;
+		if (!packet.rtcp)
+			++mRtpCount;
+
+		if (packet.size > 0)
+			mPackets.push_back(packet);
+
+		offset += length;
+	}
+
+	PLOG_DEBUG << "Loaded RTP dump with " << mPackets.size() << " packets";
+}
+
+RtpDump::~RtpDump() {}
+
+const std::vector<RtpDump::Packet> &RtpDump::packets() const { return mPackets; }
+
+milliseconds RtpDump::duration() const {
+	return !mPackets.empty() ? mPackets.back().offset - mPackets.front().offset : milliseconds(0);
+}
+
+size_t RtpDump::rtpCount() const { return mRtpCount; }
+
+class RtpReplayer::Player final : public std::enable_shared_from_this<Player> {
+public:
+	Player(shared_ptr<RtpDump> dump, shared_ptr<Track> track, RtpReplayerInit init);
+	~Player();
+
+	void start();
+	void stop();
+
+	bool isRunning() const;
+	uint64_t sentCount() const;
+	void onComplete(std::function<void()> callback);
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	void run();
+	void send(const RtpDump::Packet &packet); // requires mMutex to be locked
+	clock::duration scale(milliseconds offset) const;
+
+	const shared_ptr<RtpDump> mDump;
+	const shared_ptr<Track> mTrack;
+	const RtpReplayerInit mInit;
+
+	mutable std::mutex mMutex;
+	bool mRunning = false;
+	size_t mIndex = 0;
+	clock::time_point mStart;
+	uint16_t mSeqShift = 0;
+	uint32_t mTimestampShift = 0;
+	uint64_t mSent = 0;
+	binary mBuffer;
+	impl::Timer mTimer;
+	std::function<void()> mCompleteCallback;
+};
+
+RtpReplayer::Player::Player(shared_ptr<RtpDump> dump, shared_ptr<Track> track,
+                            RtpReplayerInit init)
+    : mDump(std::move(dump)), mTrack(std::move(track)), mInit(std::move(init)) {
+	if (!mDump || !mTrack)
+		throw std::invalid_argument("RTP replayer requires a dump and a track");
+
+	if (!(mInit.speed > 0.))
+		throw std::invalid_argument("RTP replay speed must be positive");
+}
+
+RtpReplayer::Player::~Player() { mTimer.cancel(); }
+
+void RtpReplayer::Player::start() {
+	std::lock_guard lock(mMutex);
+	if (mRunning || mDump->packets().empty())
+		return;
+
+	mRunning = true;
+	mIndex = 0;
+	mStart = clock::now() - scale(mDump->packets().front().offset);
+	mTimer = impl::ThreadPool::Instance().setTimer(clock::duration::zero(),
+	                                               weak_bind(&Player::run, this));
+}
+
+void RtpReplayer::Player::stop() {
+	std::lock_guard lock(mMutex);
+	mRunning = false;
+	mTimer.cancel();
+}
+
+bool RtpReplayer::Player::isRunning() const {
+	std::lock_guard lock(mMutex);
+	return mRunning;
+}
+
+uint64_t RtpReplayer::Player::sentCount() const {
+	std::lock_guard lock(mMutex);
+	return mSent;
+}
+
+void RtpReplayer::Player::onComplete(std::function<void()> callback) {
+	std::lock_guard lock(mMutex);
+	mCompleteCallback = std::move(callback);
+}
+
+void RtpReplayer::Player::run() {
+	std::unique_lock lock(mMutex);
+	if (!mRunning)
+		return;
+
+	const auto &packets = mDump->packets();
+	const auto now = clock::now();
+	try {
+		while (true) {
+			if (mIndex == packets.size()) {
+				if (!mInit.loop)
+					break;
+
+				// Continue sequence numbers and timestamps, assuming a single RTP stream
+				const auto period = mDump->duration() + LoopGap;
+				mStart += scale(period);
+				mSeqShift = uint16_t(mSeqShift + mDump->rtpCount());
+				mTimestampShift += uint32_t(uint64_t(period.count()) * mInit.clockRate / 1000);
+				mIndex = 0;
+			}
+
+			const auto &packet = packets[mIndex];
+			const auto time = mStart + scale(packet.offset);
+			if (time > now) {
+				// Timers are absolute so that errors don't accumulate
+				mTimer = impl::ThreadPool::Instance().setTimer(time, weak_bind(&Player::run, this));
+				return;
+			}
+
+			if (!packet.rtcp || mInit.rtcp)
+				send(packet);
+
+			++mIndex;
+		}
+
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "RTP replay failed: " << e.what();
+	}
+
+	mRunning = false;
+	auto callback = mCompleteCallback;
+	lock.unlock();
+
+	if (callback)
+		callback();
+}
+
+void RtpReplayer::Player::send(const RtpDump::Packet &packet) {
+	if (packet.rtcp || packet.size < sizeof(RtpHeader) ||
+	    (!mInit.ssrc && mSeqShift == 0 && mTimestampShift == 0)) {
+		mTrack->send(packet.data, packet.size);
+		++mSent;
+		return;
+	}
+
+	// The packet is rewritten in a copy since the dump is read-only
+	mBuffer.assign(packet.data, packet.data + packet.size);
+	auto rtp = reinterpret_cast<RtpHeader *>(mBuffer.data());
+	if (mInit.ssrc)
+		rtp->setSsrc(*mInit.ssrc);
+
+	rtp->setSeqNumber(uint16_t(rtp->seqNumber() + mSeqShift));
+	rtp->setTimestamp(rtp->timestamp() + mTimestampShift);
+	mTrack->send(mBuffer.data(), mBuffer.size());
+	++mSent;
+}
+
+RtpReplayer::Player::clock::duration RtpReplayer::Player::scale(milliseconds offset) const {
+	return std::chrono::duration_cast<clock::duration>(
+	    std::chrono::duration<double, std::milli>(offset) / mInit.speed);
+}
+
+RtpReplayer::RtpReplayer(shared_ptr<RtpDump> dump, shared_ptr<Track> track, RtpReplayerInit init)
+    : mPlayer(std::make_shared<Player>(std::move(dump), std::move(track), std::move(init))) {}
+
+RtpReplayer::~RtpReplayer() { mPlayer->stop(); }
+
+void RtpReplayer::start() { mPlayer->start(); }
+
+void RtpReplayer::stop() { mPlayer->stop(); }
+
+bool RtpReplayer::isRunning() const { return mPlayer->isRunning(); }
+
+uint64_t RtpReplayer::sentCount() const { return mPlayer->sentCount(); }
+
+void RtpReplayer::onComplete(std::function<void()> callback) {
+	mPlayer->onComplete(std::move(callback));
+}
+
+} // namespace rtc
+
+#endif // RTC_ENABLE_MEDIA
@@ -0,0 +1,246 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtprewriter.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <random>
+
+namespace rtc {
+
+namespace {
+
+bool equal_lowercase(const string &a, const string &b) {
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+		       return std::tolower(static_cast<unsigned char>(x)) ==
+		              std::tolower(static_cast<unsigned char>(y));
+	       });
+}
+
+bool same_codec(const Description::Media::RtpMap &a, const Description::Media::RtpMap &b) {
+	return a.clockRate == b.clockRate && equal_lowercase(a.format, b.format);
+}
+
+bool is_rtx(const Description::Media::RtpMap &map) { return equal_lowercase(map.format, "rtx"); }
+
+} // namespace
+
+RtpRewriter::RtpRewriter(SSRC ssrc) : mSsrc(ssrc) {
+	std::lock_guard lock(mMutex);
+	rebuildMaps();
+}
+
+void RtpRewriter::media(const Description::Media &desc) {
+	std::lock_guard lock(mMutex);
+	mMedia.emplace(desc);
+	rebuildMaps();
+}
+
+void RtpRewriter::setSourceMedia(const Description::Media &source) {
+	std::lock_guard lock(mMutex);
+	mSourceMedia.emplace(source);
+	rebuildMaps();
+}
+
+SSRC RtpRewriter::ssrc() const { return mSsrc; }
+
+optional<SSRC> RtpRewriter::source() const {
+	std::lock_guard lock(mMutex);
+	return mSource;
+}
+
+void RtpRewriter::outgoing(message_vector &messages,
+                           [[maybe_unused]] const message_callback &send) {
+	std::lock_guard lock(mMutex);
+	const auto now = std::chrono::steady_clock::now();
+
+	// Packets are rewritten in place, only dropped ones require moving the others
+	auto it = std::remove_if(messages.begin(), messages.end(), [&](const message_ptr &message) {
+		return message->type != Message::Control && !rewrite(*message, now);
+	});
+	messages.erase(it, messages.end());
+}
+
+void RtpRewriter::rebuildMaps() {
+	for (size_t i = 0; i < mPayloadTypes.size(); ++i)
+		mPayloadTypes[i] = uint8_t(i);
+
+	for (size_t i = 0; i < mExtIds.size(); ++i)
+		mExtIds[i] = uint8_t(i);
+
+	mClockRates.fill(0);
+	mRtx.fill(false);
+	mRemapExtensions = false;
+
+	const auto *source = mSourceMedia ? &*mSourceMedia : mMedia ? &*mMedia : nullptr;
+	if (!source)
+		return;
+
+	for (int pt : source->payloadTypes()) {
+		if (pt < 0 || pt >= 128 || !source->hasPayloadType(pt))
+			continue;
+
+		auto map = source->rtpMap(pt);
+		mClockRates[pt] = map->clockRate;
+		mRtx[pt] = mSourceMedia && is_rtx(*map);
+	}
+
+	if (!mSourceMedia || !mMedia)
+		return;
+
+	const auto &target = *mMedia;
+	for (int pt : source->payloadTypes()) {
+		if (pt < 0 || pt >= 128 || !source->hasPayloadType(pt) || mRtx[pt])
+			continue;
+
+		// Prefer the same payload type if it is the same codec
+		auto map = source->rtpMap(pt);
+		if (target.hasPayloadType(pt) && same_codec(*map, *target.rtpMap(pt)))
+			continue;
+
+		for (int targetPt : target.payloadTypes()) {
+			if (target.hasPayloadType(targetPt) && same_codec(*map, *target.rtpMap(targetPt))) {
+				mPayloadTypes[pt] = uint8_t(targetPt);
+				break;
+			}
+		}
+	}
+
+	// Extensions are matched by URI
+	mRemapExtensions = true;
+	mExtIds.fill(0);
+	for (int id : source->extIds()) {
+		if (id <= 0 || id >= 256)
+			continue;
+
+		const auto &uri = source->extMap(id)->uri;
+		for (int targetId : target.extIds()) {
+			if (targetId > 0 && targetId < 256 && target.extMap(targetId)->uri == uri) {
+				mExtIds[id] = uint8_t(targetId);
+				break;
+			}
+		}
+	}
+}
+
+bool RtpRewriter::rewrite(Message &message, std::chrono::steady_clock::time_point now) {
+	if (message.size() < sizeof(RtpHeader))
+		return true;
+
+	auto rtp = reinterpret_cast<RtpHeader *>(message.data());
+	const SSRC ssrc = rtp->ssrc();
+	const uint8_t payloadType = rtp->payloadType();
+
+	// Retransmissions refer to the original sequence numbers, so they are not forwarded
+	if (mRtx[payloadType])
+		return false;
+
+	const uint16_t seqNumber = rtp->seqNumber();
+	const uint32_t timestamp = rtp->timestamp();
+	if (mSource != ssrc) {
+		if (!mSource) {
+			// RFC 3550: The initial values of the sequence number and timestamp SHOULD be random
+			auto uniform = std::uniform_int_distribution<uint32_t>();
+			auto engine = impl::utils::random_engine();
+			mLastSeqNumber = uint16_t(uniform(engine));
+			mLastTimestamp = uniform(engine);
+		} else {
+			// Continue after the last packet, the timestamp advancing with the elapsed time
+			const int clockRate = mClockRates[payloadType] > 0 ? mClockRates[payloadType] : 90000;
+			const auto elapsed = std::chrono::duration<double>(now - mLastTime).count();
+			mLastTimestamp += std::max(uint32_t(elapsed * clockRate), uint32_t(1));
+		}
+
+		PLOG_DEBUG << "Rewriting RTP stream with SSRC " << ssrc << " to SSRC " << mSsrc;
+		mSource = ssrc;
+		mSeqOffset = uint16_t(mLastSeqNumber + 1 - seqNumber);
+		mTimestampOffset = mLastTimestamp - timestamp;
+	}
+
+	const uint16_t outSeqNumber = uint16_t(seqNumber + mSeqOffset);
+	const uint32_t outTimestamp = timestamp + mTimestampOffset;
+	if (int16_t(outSeqNumber - mLastSeqNumber) > 0) {
+		mLastSeqNumber = outSeqNumber;
+		mLastTimestamp = outTimestamp;
+		mLastTime = now;
+	}
+
+	rtp->setSsrc(mSsrc);
+	rtp->setSeqNumber(outSeqNumber);
+	rtp->setTimestamp(outTimestamp);
+	rtp->setPayloadType(mPayloadTypes[payloadType]);
+
+	if (mRemapExtensions && rtp->extension()) {
+		const size_t headerSize = rtp->getSize();
+		if (headerSize + sizeof(RtpExtensionHeader) <= message.size() &&
+		    headerSize + rtp->getExtensionHeaderSize() <= message.size()) {
+			auto ext = rtp->getExtensionHeader();
+			remapExtensions(ext, ext->getSize());
+		}
+	}
+
+	return true;
+}
+
+void RtpRewriter::remapExtensions(RtpExtensionHeader *ext, size_t size) {
+	// RFC 8285 4.2. One-Byte Header and 4.3. Two-Byte Header
+	const bool twoByteHeader = (ext->profileSpecificId() & 0xFFF0) == 0x1000;
+	if (!twoByteHeader && ext->profileSpecificId() != 0xBEDE)
+		return;
+
+	auto buf = reinterpret_cast<byte *>(ext->getBody());
+	size_t offset = 0;
+	while (offset < size) {
+		const size_t start = offset;
+		uint8_t id = std::to_integer<uint8_t>(buf[offset]);
+		if (id == 0) {
+			++offset; // padding
+			continue;
+		}
+
+		size_t elementSize;
+		if (twoByteHeader) {
+			if (offset + 2 > size)
+				break;
+
+			elementSize = std::to_integer<uint8_t>(buf[offset + 1]);
+			offset += 2;
+		} else {
+			if (id >> 4 == 15)
+				break; // reserved, stop parsing
+
+			elementSize = (id & 0x0F) + 1;
+			id >>= 4;
+			offset += 1;
+		}
+
+		if (offset + elementSize > size)
+			break;
+
+		const uint8_t targetId = mExtIds[id];
+		if (targetId == 0 || (!twoByteHeader && targetId > 14))
+			std::memset(buf + start, 0, offset + elementSize - start); // padding bytes
+		else if (twoByteHeader)
+			buf[start] = byte(targetId);
+		else
+			buf[start] = byte((targetId << 4) | (elementSize - 1));
+
+		offset += elementSize;
+	}
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
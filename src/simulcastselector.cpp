@@ -0,0 +1,300 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "simulcastselector.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/keyframe.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace rtc {
+
+SimulcastSelector::SimulcastSelector() : mForwarder(std::make_shared<RtpForwarder>()) {}
+
+void SimulcastSelector::media(const Description::Media &desc) {
+	uint8_t ridExtId = 0;
+	uint8_t repairedRidExtId = 0;
+	for (int extId : desc.extIds()) {
+		if (extId <= 0 || extId >= 256)
+			continue;
+
+		const auto &uri = desc.extMap(extId)->uri;
+		if (uri == RidExtensionUri)
+			ridExtId = uint8_t(extId);
+		else if (uri == RepairedRidExtensionUri)
+			repairedRidExtId = uint8_t(extId);
+	}
+
+	std::unordered_map<uint8_t, impl::VideoCodec> codecs;
+	for (int pt : desc.payloadTypes()) {
+		auto map = desc.rtpMap(pt);
+		if (!map)
+			continue;
+
+		codecs.emplace(uint8_t(pt), impl::video_codec_from_format(map->format));
+	}
+
+	if (ridExtId == 0) {
+		PLOG_DEBUG << "RID extension is not negotiated, simulcast layers are identified by SSRC";
+	}
+
+	mForwarder->media(desc);
+
+	std::lock_guard lock(mMutex);
+	mRidExtId = ridExtId;
+	mRepairedRidExtId = repairedRidExtId;
+	mCodecs = std::move(codecs);
+}
+
+void SimulcastSelector::incoming(message_vector &messages, const message_callback &send) {
+	std::lock_guard lock(mMutex);
+	const auto now = clock::now();
+
+	mSubscribers.erase(std::remove_if(mSubscribers.begin(), mSubscribers.end(),
+	                                  [](const Subscriber &s) { return s.track->isClosed(); }),
+	                   mSubscribers.end());
+
+	// Packets are passed to the forwarder in runs, so that a switch happens on its keyframe
+	message_vector run;
+	run.reserve(messages.size());
+	bool reselect = std::exchange(mReselect, false);
+	for (const auto &message : messages) {
+		if (message->type != Message::Binary || message->size() < sizeof(RtpHeader))
+			continue;
+
+		auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+		if (rtp->getSize() + rtp->getExtensionHeaderSize() > message->size())
+			continue;
+
+		const SSRC ssrc = rtp->ssrc();
+		auto [it, inserted] = mStreams.try_emplace(ssrc);
+		auto &stream = it->second;
+		if (inserted) {
+			PLOG_DEBUG << "New simulcast stream, SSRC=" << ssrc;
+			reselect = true;
+		}
+
+		// RID elements are usually only sent in the first packets of a stream
+		if (stream.rid.empty() && rtp->extension() &&
+		    rtp->getSize() + sizeof(RtpExtensionHeader) <= message->size()) {
+			auto ext = rtp->getExtensionHeader();
+			size_t size = 0;
+			const byte *element = nullptr;
+			if (mRidExtId != 0 && (element = ext->findHeader(mRidExtId, size))) {
+				stream.rid.assign(reinterpret_cast<const char *>(element), size);
+			} else if (mRepairedRidExtId != 0 &&
+			           (element = ext->findHeader(mRepairedRidExtId, size))) {
+				stream.rid.assign(reinterpret_cast<const char *>(element), size);
+				stream.repair = true;
+			}
+			if (!stream.rid.empty()) {
+				PLOG_DEBUG << "Simulcast stream SSRC=" << ssrc << " has RID \"" << stream.rid
+				           << "\"" << (stream.repair ? " (repair)" : "");
+			}
+		}
+
+		if (stream.repair)
+			continue; // retransmissions are not forwarded
+
+		if (measure(stream, message->size(), now))
+			reselect = true;
+
+		optional<bool> keyframe;
+		for (auto &subscriber : mSubscribers) {
+			if (subscriber.target != ssrc || subscriber.current == ssrc)
+				continue;
+
+			if (!keyframe)
+				keyframe = isKeyframe(*message, *rtp);
+
+			if (!*keyframe)
+				continue;
+
+			// Switch on the keyframe
+			mForwarder->incoming(run, send);
+			run.clear();
+			if (!subscriber.current)
+				mForwarder->addTrack(subscriber.track, subscriber.ssrc, subscriber.payloadType);
+
+			mForwarder->setSource(subscriber.track, ssrc);
+			PLOG_DEBUG << "Switched simulcast layer to SSRC=" << ssrc;
+			subscriber.current = ssrc;
+		}
+
+		run.push_back(message);
+	}
+
+	if (reselect) {
+		for (auto jt = mStreams.begin(); jt != mStreams.end();) {
+			if (now - jt->second.lastReceived > 10 * InactiveTimeout)
+				jt = mStreams.erase(jt);
+			else
+				++jt;
+		}
+
+		const auto layers = activeLayers(now);
+		for (auto &subscriber : mSubscribers)
+			select(subscriber, layers);
+	}
+
+	// Keyframes are requested on target layers until they are received
+	for (const auto &subscriber : mSubscribers)
+		if (subscriber.target && subscriber.target != subscriber.current)
+			pushPLI(*subscriber.target, send, now);
+
+	mForwarder->incoming(run, send);
+}
+
+void SimulcastSelector::addTrack(shared_ptr<Track> track, SSRC ssrc,
+                                 optional<uint8_t> payloadType) {
+	if (!track)
+		throw std::invalid_argument("Forwarding to a null track");
+
+	std::lock_guard lock(mMutex);
+	auto it = std::find_if(mSubscribers.begin(), mSubscribers.end(),
+	                       [&](const Subscriber &s) { return s.track == track; });
+	if (it != mSubscribers.end()) {
+		it->ssrc = ssrc;
+		it->payloadType = payloadType;
+		if (it->current)
+			mForwarder->addTrack(track, ssrc, payloadType);
+
+		return;
+	}
+
+	Subscriber subscriber;
+	subscriber.track = std::move(track);
+	subscriber.ssrc = ssrc;
+	subscriber.payloadType = payloadType;
+	mSubscribers.push_back(std::move(subscriber));
+	mReselect = true;
+}
+
+void SimulcastSelector::removeTrack(const shared_ptr<Track> &track) {
+	std::lock_guard lock(mMutex);
+	mSubscribers.erase(std::remove_if(mSubscribers.begin(), mSubscribers.end(),
+	                                  [&](const Subscriber &s) { return s.track == track; }),
+	                   mSubscribers.end());
+	mForwarder->removeTrack(track);
+}
+
+void SimulcastSelector::setBitrate(const shared_ptr<Track> &track, optional<unsigned int> bitrate) {
+	std::lock_guard lock(mMutex);
+	for (auto &subscriber : mSubscribers) {
+		if (subscriber.track == track) {
+			subscriber.bitrate = bitrate;
+			mReselect = true;
+		}
+	}
+}
+
+std::vector<SimulcastSelector::Layer> SimulcastSelector::layers() const {
+	std::lock_guard lock(mMutex);
+	std::vector<Layer> result;
+	for (const auto &[ssrc, stream] : activeLayers(clock::now()))
+		result.push_back(Layer{stream->rid, ssrc, unsigned(stream->bitrate)});
+
+	return result;
+}
+
+optional<SSRC> SimulcastSelector::selected(const shared_ptr<Track> &track) const {
+	std::lock_guard lock(mMutex);
+	for (const auto &subscriber : mSubscribers)
+		if (subscriber.track == track)
+			return subscriber.current;
+
+	return nullopt;
+}
+
+bool SimulcastSelector::measure(Stream &stream, size_t size, clock::time_point now) {
+	// Requires mMutex to be locked
+	stream.bytes += size;
+	stream.lastReceived = now;
+	if (stream.windowStart == clock::time_point()) {
+		stream.windowStart = now;
+		return false;
+	}
+
+	const auto elapsed = now - stream.windowStart;
+	if (elapsed < RateWindow)
+		return false;
+
+	const double rate = double(stream.bytes) * 8. / std::chrono::duration<double>(elapsed).count();
+	stream.bitrate = stream.bitrate > 0. ? 0.5 * stream.bitrate + 0.5 * rate : rate;
+	stream.bytes = 0;
+	stream.windowStart = now;
+	return true;
+}
+
+void SimulcastSelector::select(Subscriber &subscriber, const LayerList &layers) {
+	// Requires mMutex to be locked
+	if (layers.empty())
+		return;
+
+	double currentBitrate = 0.;
+	if (subscriber.current)
+		if (auto it = mStreams.find(*subscriber.current); it != mStreams.end())
+			currentBitrate = it->second.bitrate;
+
+	// Take the highest layer fitting in the bitrate, or the lowest one if none fits
+	SSRC target = subscriber.bitrate ? layers.front().first : layers.back().first;
+	if (subscriber.bitrate) {
+		const double available = double(*subscriber.bitrate);
+		for (const auto &[ssrc, stream] : layers) {
+			const bool up = stream->bitrate > currentBitrate && subscriber.current != ssrc;
+			if (stream->bitrate * (up ? SwitchUpMargin : 1.) <= available)
+				target = ssrc;
+		}
+	}
+
+	if (subscriber.target != target) {
+		PLOG_DEBUG << "Selecting simulcast layer SSRC=" << target;
+		subscriber.target = target;
+	}
+}
+
+bool SimulcastSelector::isKeyframe(const Message &message, const RtpHeader &rtp) const {
+	// Requires mMutex to be locked
+	auto it = mCodecs.find(rtp.payloadType());
+	return it != mCodecs.end() && impl::is_keyframe_start(it->second, message, rtp);
+}
+
+void SimulcastSelector::pushPLI(SSRC ssrc, const message_callback &send, clock::time_point now) {
+	// Requires mMutex to be locked
+	auto &last = mKeyframeRequests[ssrc];
+	if (last != clock::time_point() && now - last < KeyframeRequestInterval)
+		return;
+
+	last = now;
+	auto message =
+	    make_message_with_tailroom(RtcpPli::Size(), DEFAULT_MEDIA_TAILROOM, Message::Control);
+	auto *pli = reinterpret_cast<RtcpPli *>(message->data());
+	pli->preparePacket(ssrc);
+	send(message);
+}
+
+SimulcastSelector::LayerList SimulcastSelector::activeLayers(clock::time_point now) const {
+	// Requires mMutex to be locked
+	LayerList layers;
+	for (const auto &[ssrc, stream] : mStreams)
+		if (!stream.repair && stream.bitrate > 0. && now - stream.lastReceived <= InactiveTimeout)
+			layers.emplace_back(ssrc, &stream);
+
+	std::sort(layers.begin(), layers.end(), [](const auto &a, const auto &b) {
+		return a.second->bitrate < b.second->bitrate;
+	});
+	return layers;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "svclayerfilter.hpp"
+
+#include "impl/internals.hpp"
+
+namespace rtc {
+
+SvcLayerFilter::SvcLayerFilter() {}
+
+void SvcLayerFilter::media(const Description::Media &desc) {
+	uint8_t id = 0;
+	for (int extId : desc.extIds())
+		if (desc.extMap(extId)->uri == ExtensionUri && extId > 0 && extId < 256)
+			id = uint8_t(extId);
+
+	if (id == 0) {
+		PLOG_DEBUG << "Dependency descriptor extension is not negotiated";
+	}
+
+	std::lock_guard lock(mMutex);
+	mExtId = id;
+}
+
+void SvcLayerFilter::outgoing(message_vector &messages,
+                              [[maybe_unused]] const message_callback &send) {
+	std::lock_guard lock(mMutex);
+	if (mExtId == 0)
+		return;
+
+	message_vector result;
+	result.reserve(messages.size());
+	for (auto &message : messages) {
+		if (message->type == Message::Control || message->size() < sizeof(RtpHeader)) {
+			result.push_back(std::move(message));
+			continue;
+		}
+
+		if (!filter(*message)) {
+			++mSeqOffset;
+			++mDropped;
+			continue;
+		}
+
+		if (mSeqOffset != 0) {
+			auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+			rtp->setSeqNumber(uint16_t(rtp->seqNumber() - mSeqOffset));
+		}
+
+		result.push_back(std::move(message));
+	}
+
+	messages.swap(result);
+}
+
+void SvcLayerFilter::setDecodeTarget(optional<int> decodeTarget) {
+	std::lock_guard lock(mMutex);
+	mMaxLayers.reset();
+	if (decodeTarget == mDecodeTarget)
+		mPendingDecodeTarget.reset();
+	else
+		mPendingDecodeTarget.emplace(decodeTarget);
+}
+
+void SvcLayerFilter::setMaxLayers(int spatialId, int temporalId) {
+	std::lock_guard lock(mMutex);
+	mMaxLayers.emplace(spatialId, temporalId);
+	resolveMaxLayers();
+}
+
+optional<int> SvcLayerFilter::decodeTarget() const {
+	std::lock_guard lock(mMutex);
+	return mDecodeTarget;
+}
+
+size_t SvcLayerFilter::droppedCount() const {
+	std::lock_guard lock(mMutex);
+	return mDropped;
+}
+
+bool SvcLayerFilter::filter(Message &message) {
+	// Requires mMutex to be locked
+	auto rtp = reinterpret_cast<RtpHeader *>(message.data());
+	if (!rtp->extension() || rtp->getSize() + sizeof(RtpExtensionHeader) > message.size() ||
+	    rtp->getSize() + rtp->getExtensionHeaderSize() > message.size())
+		return true;
+
+	size_t size = 0;
+	auto element = rtp->getExtensionHeader()->findHeader(mExtId, size);
+	if (!element)
+		return true;
+
+	try {
+		DependencyDescriptorReader(element, size).readTo(mContext);
+	} catch (const std::invalid_argument &e) {
+		PLOG_VERBOSE << "Invalid dependency descriptor: " << e.what();
+		return true;
+	}
+
+	const auto &descriptor = mContext.descriptor;
+	const auto &dtis = descriptor.dependencyTemplate.decodeTargetIndications;
+	if (descriptor.structureAttached)
+		resolveMaxLayers();
+
+	// Forwarding all frames again requires a new structure, which comes with a keyframe
+	if (mPendingDecodeTarget && descriptor.startOfFrame) {
+		const auto &pending = *mPendingDecodeTarget;
+		if (pending ? size_t(*pending) < dtis.size() &&
+		                  dtis[*pending] == DecodeTargetIndication::Switch
+		            : descriptor.structureAttached) {
+			PLOG_DEBUG << "Switched to decode target "
+			           << (pending ? std::to_string(*pending) : "all");
+			mDecodeTarget = pending;
+			mPendingDecodeTarget.reset();
+		}
+	}
+
+	if (!mDecodeTarget || size_t(*mDecodeTarget) >= dtis.size())
+		return true;
+
+	if (dtis[*mDecodeTarget] == DecodeTargetIndication::NotPresent)
+		return false;
+
+	// The marker of the last frame of the temporal unit may be dropped with upper spatial layers
+	const int spatialId = mContext.structure.decodeTargetLayers(*mDecodeTarget).first;
+	if (descriptor.endOfFrame && descriptor.dependencyTemplate.spatialId == spatialId)
+		rtp->setMarker(true);
+
+	return true;
+}
+
+void SvcLayerFilter::resolveMaxLayers() {
+	// Requires mMutex to be locked
+	const auto &structure = mContext.structure;
+	if (!mMaxLayers || structure.decodeTargetCount == 0)
+		return;
+
+	// Take the highest decode target within the max layers, or the first one if none fits
+	int best = 0;
+	optional<std::pair<int, int>> bestLayers;
+	for (int dt = 0; dt < structure.decodeTargetCount; ++dt) {
+		auto layers = structure.decodeTargetLayers(dt);
+		if (layers.first <= mMaxLayers->first && layers.second <= mMaxLayers->second &&
+		    (!bestLayers || layers > *bestLayers)) {
+			best = dt;
+			bestLayers = layers;
+		}
+	}
+
+	if (mDecodeTarget == best)
+		mPendingDecodeTarget.reset();
+	else
+		mPendingDecodeTarget.emplace(best);
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
@@ -9,8 +9,11 @@
 #include "track.hpp"
 
 #include "impl/internals.hpp"
+#include "impl/messagepool.hpp"
 #include "impl/track.hpp"
 
+#include <unordered_map>
+
 namespace rtc {
 
 Track::Track(impl_ptr<impl::Track> impl)
@@ -32,7 +35,12 @@ void Track::close() { impl()->close(); }
 
 bool Track::send(message_variant data) { return impl()->outgoing(make_message(std::move(data))); }
 
-bool Track::send(const byte *data, size_t size) { return send(binary(data, data + size)); }
+bool Track::send(const byte *data, size_t size) {
+	// Reserve tailroom so the packet can be protected in place
+	auto message = make_message_with_tailroom(size, DEFAULT_MEDIA_TAILROOM);
+	std::copy(data, data + size, message->begin());
+	return impl()->outgoing(std::move(message));
+}
 
 bool Track::isOpen(void) const { return impl()->isOpen(); }
 
@@ -40,19 +48,77 @@ bool Track::isClosed(void) const { return impl()->isClosed(); }
 
 size_t Track::maxMessageSize() const { return impl()->maxMessageSize(); }
 
+TrackStats Track::getStats() const { return impl()->stats(); }
+
 void Track::sendFrame(binary data, FrameInfo info) {
-	impl()->outgoing(make_message(std::move(data), std::make_shared<FrameInfo>(std::move(info))));
+	auto frameInfo = impl::MessagePool::Instance().makeFrameInfo(std::move(info));
+	impl()->outgoing(make_message(std::move(data), std::move(frameInfo)));
 }
 
 void Track::sendFrame(const byte *data, size_t size, FrameInfo info) {
-	sendFrame(binary(data, data + size), std::move(info));
+	// Packets are generated synchronously, so the frame only needs a pooled copy
+	auto frameInfo = impl::MessagePool::Instance().makeFrameInfo(std::move(info));
+	impl()->outgoing(make_message(data, data + size, std::move(frameInfo)));
+}
+
+void Track::sendFrames(const std::vector<FrameData> &frames) {
+	message_vector messages;
+	messages.reserve(frames.size());
+	for (const auto &frame : frames)
+		messages.push_back(make_message(frame.data, frame.data + frame.size,
+		                                impl::MessagePool::Instance().makeFrameInfo(frame.info)));
+
+	impl()->outgoing(std::move(messages));
+}
+
+bool Track::SendFrames(const std::vector<std::pair<shared_ptr<Track>, FrameData>> &frames) {
+	// Group frames per track, keeping their order
+	std::vector<std::pair<Track *, message_vector>> batches;
+	std::unordered_map<Track *, size_t> indices;
+	for (const auto &[track, frame] : frames) {
+		if (!track)
+			continue;
+
+		auto [it, inserted] = indices.emplace(track.get(), batches.size());
+		if (inserted)
+			batches.emplace_back(track.get(), message_vector{});
+
+		auto frameInfo = impl::MessagePool::Instance().makeFrameInfo(frame.info);
+		batches[it->second].second.push_back(
+		    make_message(frame.data, frame.data + frame.size, std::move(frameInfo)));
+	}
+
+	// A closed track must not prevent sending on the others
+	bool success = true;
+	for (auto &[track, messages] : batches) {
+		try {
+			if (!track->impl()->outgoing(std::move(messages)))
+				success = false;
+		} catch (const std::exception &e) {
+			PLOG_WARNING << "Failed to send frames on track \"" << track->mid()
+			             << "\": " << e.what();
+			success = false;
+		}
+	}
+	return success;
 }
 
 void Track::onFrame(std::function<void(binary data, FrameInfo frame)> callback) {
+	impl()->frameViewCallback = nullptr;
 	impl()->frameCallback = callback;
 	impl()->flushPendingMessages();
 }
 
+void Track::onFrameView(std::function<void(shared_ptr<const Message> frame)> callback) {
+	impl()->frameCallback = nullptr;
+	if (callback)
+		impl()->frameViewCallback = [callback](message_ptr frame) { callback(frame); };
+	else
+		impl()->frameViewCallback = nullptr;
+
+	impl()->flushPendingMessages();
+}
+
 void Track::setMediaHandler(shared_ptr<MediaHandler> handler) {
 	impl()->setMediaHandler(std::move(handler));
 }
@@ -0,0 +1,458 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "twcchandler.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace rtc {
+
+namespace {
+
+using ticks = std::chrono::duration<int64_t, std::ratio<1, 4000>>;     // 250us
+using reference = std::chrono::duration<int64_t, std::ratio<64, 1000>>; // 64ms
+
+const uint8_t TWCC_FMT = 15;
+
+uint16_t read16(const byte *p) {
+	return uint16_t(std::to_integer<uint16_t>(p[0]) << 8 | std::to_integer<uint16_t>(p[1]));
+}
+
+void write16(byte *p, uint16_t value) {
+	p[0] = byte(value >> 8);
+	p[1] = byte(value);
+}
+
+void write32(byte *p, uint32_t value) {
+	write16(p, uint16_t(value >> 16));
+	write16(p + 2, uint16_t(value));
+}
+
+// Packet status symbols
+const uint8_t NOT_RECEIVED = 0;
+const uint8_t SMALL_DELTA = 1;
+const uint8_t LARGE_DELTA = 2;
+
+// Returns the packet status chunks encoding the symbols
+std::vector<uint16_t> encode_chunks(const std::vector<uint8_t> &symbols) {
+	std::vector<uint16_t> chunks;
+	size_t i = 0;
+	while (i < symbols.size()) {
+		const size_t remaining = symbols.size() - i;
+		size_t run = 1;
+		while (run < remaining && run < 0x1FFF && symbols[i + run] == symbols[i])
+			++run;
+
+		if (run >= 7) {
+			// Run length chunk
+			chunks.push_back(uint16_t(symbols[i] << 13 | run));
+			i += run;
+			continue;
+		}
+
+		const size_t count14 = std::min<size_t>(14, remaining);
+		if (std::all_of(symbols.begin() + i, symbols.begin() + i + count14,
+		                [](uint8_t s) { return s != LARGE_DELTA; })) {
+			// Status vector chunk with 1-bit symbols
+			uint16_t chunk = 0x8000;
+			for (size_t j = 0; j < count14; ++j)
+				chunk |= uint16_t(symbols[i + j] << (13 - j));
+
+			chunks.push_back(chunk);
+			i += count14;
+			continue;
+		}
+
+		// Status vector chunk with 2-bit symbols
+		const size_t count7 = std::min<size_t>(7, remaining);
+		uint16_t chunk = 0xC000;
+		for (size_t j = 0; j < count7; ++j)
+			chunk |= uint16_t(symbols[i + j] << (12 - 2 * j));
+
+		chunks.push_back(chunk);
+		i += count7;
+	}
+	return chunks;
+}
+
+} // namespace
+
+TwccHandler::Session::Session(feedback_callback onFeedback, SSRC senderSsrc,
+                              clock::duration interval)
+    : senderSsrc(senderSsrc), interval(interval), epoch(clock::now()),
+      onFeedback(std::move(onFeedback)), history(HistorySize), lastFeedback(epoch) {
+	auto uniform = std::uniform_int_distribution<uint32_t>(0, 0xFFFF);
+	auto engine = impl::utils::random_engine();
+	nextSequenceNumber = uint16_t(uniform(engine));
+}
+
+TwccHandler::TwccHandler(feedback_callback onFeedback, SSRC senderSsrc,
+                         std::chrono::milliseconds interval)
+    : TwccHandler(std::make_shared<Session>(std::move(onFeedback), senderSsrc, interval)) {}
+
+TwccHandler::TwccHandler(shared_ptr<Session> session) : mSession(std::move(session)) {}
+
+shared_ptr<TwccHandler> TwccHandler::fork() const {
+	return shared_ptr<TwccHandler>(new TwccHandler(mSession));
+}
+
+void TwccHandler::media(const Description::Media &desc) {
+	uint8_t id = 0;
+	for (int extId : desc.extIds())
+		if (desc.extMap(extId)->uri == ExtensionUri && extId > 0 && extId < 256)
+			id = uint8_t(extId);
+
+	if (id == 0) {
+		PLOG_DEBUG << "Transport-wide congestion control extension is not negotiated";
+	}
+	mExtId = id;
+}
+
+void TwccHandler::incoming(message_vector &messages, const message_callback &send) {
+	const uint8_t id = mExtId;
+	const auto now = clock::now();
+	bool received = false;
+	for (const auto &message : messages) {
+		if (message->type == Message::Control) {
+			size_t offset = 0;
+			while (offset + sizeof(RtcpHeader) <= message->size()) {
+				auto header = reinterpret_cast<const RtcpHeader *>(message->data() + offset);
+				const size_t length = header->lengthInBytes();
+				if (length < sizeof(RtcpHeader) || offset + length > message->size())
+					break;
+
+				if (header->payloadType() == 205 && header->reportCount() == TWCC_FMT)
+					parseFeedback(message->data() + offset, length);
+
+				offset += length;
+			}
+
+		} else if (message->type == Message::Binary && id != 0) {
+			record(message, id, now);
+			received = true;
+		}
+	}
+
+	if (!received)
+		return;
+
+	message_ptr feedback;
+	{
+		std::lock_guard lock(mSession->receiveMutex);
+		if (now - mSession->lastFeedback >= mSession->interval ||
+		    mSession->arrivals.size() >= MaxReportsCount)
+			feedback = generate(now);
+	}
+
+	if (feedback)
+		send(std::move(feedback));
+}
+
+void TwccHandler::outgoing(message_vector &messages,
+                           [[maybe_unused]] const message_callback &send) {
+	const uint8_t id = mExtId;
+	if (id == 0)
+		return;
+
+	for (auto &message : messages)
+		if (message->type == Message::Binary)
+			message = stamp(std::move(message), id);
+}
+
+message_ptr TwccHandler::stamp(message_ptr message, uint8_t id) {
+	if (message->size() < sizeof(RtpHeader))
+		return message;
+
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	const size_t headerSize = rtp->getSize();
+	if (headerSize + (rtp->extension() ? sizeof(RtpExtensionHeader) : 0) > message->size())
+		return message;
+
+	const size_t extSize = rtp->extension() ? rtp->getExtensionHeaderSize() : 0;
+	if (headerSize + extSize > message->size())
+		return message;
+
+	bool twoByteHeader = id > 14;
+	size_t bodySize = 0;
+	if (auto ext = rtp->extension() ? rtp->getExtensionHeader() : nullptr) {
+		const uint16_t profile = ext->profileSpecificId();
+		if ((profile & 0xFFF0) == 0x1000)
+			twoByteHeader = true;
+		else if (profile != 0xBEDE || twoByteHeader)
+			return message; // the element can't be added
+
+		bodySize = ext->getSize();
+	}
+
+	std::lock_guard lock(mSession->sendMutex);
+	const uint16_t sequenceNumber = mSession->nextSequenceNumber++;
+	byte value[2];
+	write16(value, sequenceNumber);
+
+	message_ptr result;
+	if (rtp->extension()) {
+		size_t elementSize;
+		if (auto element = rtp->getExtensionHeader()->findHeader(id, elementSize)) {
+			// The element is already present, overwrite it in place
+			if (elementSize == 2) {
+				std::memcpy(const_cast<byte *>(element), value, 2);
+				result = message;
+			}
+		}
+	}
+
+	if (!result) {
+		// Append the element to the extension header, this requires a copy of the packet
+		const size_t newBodySize = (bodySize + (twoByteHeader ? 2 : 1) + 2 + 3) & ~size_t(3);
+		const size_t payloadSize = message->size() - headerSize - extSize;
+		const size_t size = headerSize + sizeof(RtpExtensionHeader) + newBodySize + payloadSize;
+		result = make_message_with_tailroom(size, DEFAULT_MEDIA_TAILROOM, message->type);
+		result->stream = message->stream;
+		result->dscp = message->dscp;
+		result->ecn = message->ecn;
+		result->reliability = message->reliability;
+		result->frameInfo = message->frameInfo;
+
+		std::memcpy(result->data(), message->data(), headerSize);
+		auto dest = reinterpret_cast<RtpHeader *>(result->data());
+		dest->setExtension(true);
+		auto ext = dest->getExtensionHeader();
+		ext->setProfileSpecificId(twoByteHeader ? 0x1000 : 0xBEDE);
+		ext->setHeaderLength(uint16_t(newBodySize / 4));
+		ext->clearBody();
+		if (bodySize > 0)
+			std::memcpy(ext->getBody(), rtp->getExtensionHeader()->getBody(), bodySize);
+
+		ext->writeHeader(twoByteHeader, bodySize, id, value, 2);
+		std::memcpy(dest->getBody(), message->data() + headerSize + extSize, payloadSize);
+	}
+
+	auto &sent = mSession->history[sequenceNumber % HistorySize];
+	sent.valid = true;
+	sent.sequenceNumber = sequenceNumber;
+	sent.time = clock::now();
+	sent.size = result->size();
+	return result;
+}
+
+void TwccHandler::parseFeedback(const byte *data, size_t size) {
+	// See draft-holmer-rmcat-transport-wide-cc-extensions-01 3.1. Transport-wide RTCP Feedback
+	if (size < 20)
+		return;
+
+	const uint16_t baseSequenceNumber = read16(data + 12);
+	const uint16_t count = read16(data + 14);
+	int32_t referenceTime = int32_t(read16(data + 16)) << 8 | std::to_integer<int32_t>(data[18]);
+	if (referenceTime & 0x800000)
+		referenceTime -= 0x1000000; // signed 24-bit
+
+	// Packet status chunks
+	std::vector<uint8_t> symbols;
+	symbols.reserve(count);
+	size_t offset = 20;
+	while (symbols.size() < count) {
+		if (offset + 2 > size)
+			return;
+
+		const uint16_t chunk = read16(data + offset);
+		offset += 2;
+		const size_t remaining = count - symbols.size();
+		if (!(chunk & 0x8000)) {
+			// Run length chunk
+			const size_t run = std::min<size_t>(chunk & 0x1FFF, remaining);
+			symbols.insert(symbols.end(), run, uint8_t((chunk >> 13) & 0x03));
+
+		} else if (!(chunk & 0x4000)) {
+			// Status vector chunk with 1-bit symbols
+			for (size_t j = 0; j < std::min<size_t>(14, remaining); ++j)
+				symbols.push_back(uint8_t((chunk >> (13 - j)) & 0x01));
+
+		} else {
+			// Status vector chunk with 2-bit symbols
+			for (size_t j = 0; j < std::min<size_t>(7, remaining); ++j)
+				symbols.push_back(uint8_t((chunk >> (12 - 2 * j)) & 0x03));
+		}
+	}
+
+	// Receive deltas
+	std::vector<PacketResult> results;
+	results.reserve(count);
+	auto arrivalTime = std::chrono::duration_cast<std::chrono::microseconds>(
+	    reference(referenceTime));
+	{
+		std::lock_guard lock(mSession->sendMutex);
+		for (size_t i = 0; i < symbols.size(); ++i) {
+			PacketResult result;
+			result.sequenceNumber = uint16_t(baseSequenceNumber + i);
+			if (symbols[i] == SMALL_DELTA || symbols[i] == LARGE_DELTA) {
+				int64_t delta;
+				if (symbols[i] == SMALL_DELTA) {
+					if (offset + 1 > size)
+						return;
+
+					delta = std::to_integer<uint8_t>(data[offset]);
+					offset += 1;
+				} else {
+					if (offset + 2 > size)
+						return;
+
+					delta = int16_t(read16(data + offset));
+					offset += 2;
+				}
+
+				result.received = true;
+				result.arrivalDelta = std::chrono::duration_cast<std::chrono::microseconds>(
+				    ticks(delta));
+				arrivalTime += result.arrivalDelta;
+				result.arrivalTime = arrivalTime;
+
+			} else if (symbols[i] != NOT_RECEIVED) {
+				return; // reserved
+			}
+
+			const auto &sent = mSession->history[result.sequenceNumber % HistorySize];
+			if (sent.valid && sent.sequenceNumber == result.sequenceNumber) {
+				result.sendTime = sent.time;
+				result.size = sent.size;
+			}
+
+			results.push_back(std::move(result));
+		}
+	}
+
+	mSession->onFeedback(std::move(results));
+}
+
+void TwccHandler::record(const message_ptr &message, uint8_t id, clock::time_point now) {
+	if (message->size() < sizeof(RtpHeader))
+		return;
+
+	auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+	if (rtp->version() != 2 || !rtp->extension() ||
+	    rtp->getSize() + sizeof(RtpExtensionHeader) > message->size() ||
+	    rtp->getSize() + rtp->getExtensionHeaderSize() > message->size())
+		return;
+
+	size_t size = 0;
+	auto element = rtp->getExtensionHeader()->findHeader(id, size);
+	if (!element || size != 2)
+		return;
+
+	const uint16_t sequenceNumber = read16(element);
+
+	std::lock_guard lock(mSession->receiveMutex);
+	auto &session = *mSession;
+	int64_t unwrapped = sequenceNumber;
+	if (session.lastReceived)
+		unwrapped = *session.lastReceived +
+		            int16_t(uint16_t(sequenceNumber - uint16_t(*session.lastReceived)));
+
+	if (!session.lastReceived || unwrapped > *session.lastReceived)
+		session.lastReceived = unwrapped;
+
+	if (session.nextReported && unwrapped < *session.nextReported)
+		return; // already reported as lost
+
+	session.arrivals.emplace(unwrapped, now);
+	session.mediaSsrc = rtp->ssrc();
+}
+
+message_ptr TwccHandler::generate(clock::time_point now) {
+	// Requires receiveMutex to be locked
+	auto &session = *mSession;
+	if (session.arrivals.empty())
+		return nullptr;
+
+	const int64_t first = session.arrivals.begin()->first;
+	int64_t begin = first;
+	if (session.nextReported && first - *session.nextReported < MaxReportsCount)
+		begin = *session.nextReported; // report the missing packets as lost
+
+	// The reference time is the arrival time of the first received packet in multiples of 64ms
+	const auto firstArrival = session.arrivals.begin()->second - session.epoch;
+	const int64_t referenceTime = std::chrono::floor<reference>(firstArrival).count();
+	int64_t previous = std::chrono::duration_cast<ticks>(reference(referenceTime)).count();
+
+	std::vector<uint8_t> symbols;
+	std::vector<int16_t> deltas;
+	auto it = session.arrivals.begin();
+	int64_t end = begin;
+	while (it != session.arrivals.end() && end - begin < MaxReportsCount) {
+		if (it->first != end) {
+			symbols.push_back(NOT_RECEIVED);
+			++end;
+			continue;
+		}
+
+		const int64_t arrival = std::chrono::floor<ticks>(it->second - session.epoch).count();
+		const int64_t delta = arrival - previous;
+		if (delta < -0x8000 || delta > 0x7FFF)
+			break; // does not fit, the packet will be reported in the next feedback
+
+		symbols.push_back(delta >= 0 && delta <= 0xFF ? SMALL_DELTA : LARGE_DELTA);
+		deltas.push_back(int16_t(delta));
+		previous = arrival;
+		++it;
+		++end;
+	}
+
+	session.arrivals.erase(session.arrivals.begin(), it);
+	session.nextReported = end;
+	session.lastFeedback = now;
+
+	const auto chunks = encode_chunks(symbols);
+	size_t size = 20 + chunks.size() * 2;
+	for (auto delta : deltas)
+		size += delta >= 0 && delta <= 0xFF ? 1 : 2;
+
+	const size_t padding = (4 - size % 4) % 4;
+	size += padding;
+
+	auto message = make_message_with_tailroom(size, DEFAULT_MEDIA_TAILROOM, Message::Control);
+	auto p = message->data();
+	std::fill(p, p + size, byte(0));
+	p[0] = byte((padding ? 0xA0 : 0x80) | TWCC_FMT); // V=2, P, FMT=15
+	p[1] = byte(205);                                // RTPFB
+	write16(p + 2, uint16_t(size / 4 - 1));
+	write32(p + 4, session.senderSsrc);
+	write32(p + 8, session.mediaSsrc);
+	write16(p + 12, uint16_t(begin));
+	write16(p + 14, uint16_t(symbols.size()));
+	write32(p + 16, uint32_t(referenceTime) << 8 | session.feedbackCount++);
+
+	size_t offset = 20;
+	for (auto chunk : chunks) {
+		write16(p + offset, chunk);
+		offset += 2;
+	}
+
+	for (auto delta : deltas) {
+		if (delta >= 0 && delta <= 0xFF) {
+			p[offset++] = byte(delta);
+		} else {
+			write16(p + offset, uint16_t(delta));
+			offset += 2;
+		}
+	}
+
+	if (padding)
+		p[size - 1] = byte(padding);
+
+	return message;
+}
+
+} // namespace rtc
+
+#endif /* RTC_ENABLE_MEDIA */
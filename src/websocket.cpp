@@ -57,6 +57,22 @@ bool WebSocket::send(const byte *data, size_t size) {
 	return impl()->outgoing(make_message(data, data + size, Message::Binary));
 }
 
+void WebSocket::onMessages(
+    std::function<void(std::vector<shared_ptr<const Message>> messages)> callback) {
+	impl()->messageCallback = nullptr;
+	impl()->messageViewCallback = nullptr;
+	if (callback)
+		impl()->messagesCallback = [callback](std::vector<message_ptr> messages) {
+			using std::make_move_iterator;
+			callback(std::vector<shared_ptr<const Message>>(make_move_iterator(messages.begin()),
+			                                                make_move_iterator(messages.end())));
+		};
+	else
+		impl()->messagesCallback = nullptr;
+
+	impl()->flushPendingMessages();
+}
+
 optional<string> WebSocket::remoteAddress() const {
 	auto tcpTransport = impl()->getTcpTransport();
 	return tcpTransport ? make_optional(tcpTransport->remoteAddress()) : nullopt;
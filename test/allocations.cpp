@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Allocation counting tests, built with the CMake option ALLOCATION_TESTS
+// The global operator new is replaced to count allocations process-wide, including the ones of the
+// library and of both peers, and the steady-state loops must stay under a budget per message. The
+// budgets are upper bounds: lower them as hot paths become allocation-free, so any regression,
+// like a std::function or a make_shared reintroduced in a loop, makes the tests fail.
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ALLOCATION_TESTS
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+
+namespace {
+
+std::atomic<uint64_t> AllocationCount = 0;
+
+void *countedAlloc(size_t size) noexcept {
+	AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size > 0 ? size : 1);
+}
+
+} // namespace
+
+// Aligned variants are not replaced, as over-aligned allocations are not expected on hot paths
+void *operator new(size_t size) {
+	if (void *ptr = countedAlloc(size))
+		return ptr;
+
+	throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+// Allocations per message in steady state, for the sender and the receiver together. Each budget
+// is the count of allocations left on the path, rounded up, so a single allocation more per message
+// fails. Queues add a fraction of an allocation when they grow a block.
+// DataChannel: the SCTP write batch and the DTLS record batch of the message, and the same for the
+// SACK sent every two packets.
+const double DataChannelBudget = 4.;
+// Track: the vector of the frame and the callback passed to the handler chain, the packets of the
+// packetizer and of SRTP protection, and the batch of unprotected packets.
+const double TrackBudget = 6.;
+
+const int WarmupCount = 1000;
+const int MeasureCount = 5000;
+
+void connect(PeerConnection &pc1, PeerConnection &pc2) {
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+}
+
+bool waitFor(const std::atomic<int> &counter, int target) {
+	int attempts = 100;
+	while (counter < target && attempts--)
+		this_thread::sleep_for(100ms);
+
+	return counter >= target;
+}
+
+// Sends count messages with send(), then waits for at least minReceived of them to be received,
+// and returns the number of allocations per message, or a negative value if messages were lost
+template <typename F>
+double measure(int count, int minReceived, std::atomic<int> &received, F send) {
+	received = 0;
+	const uint64_t before = AllocationCount.load();
+	for (int i = 0; i < count; ++i)
+		send();
+
+	if (!waitFor(received, minReceived))
+		return -1.;
+
+	const uint64_t allocations = AllocationCount.load() - before;
+	return double(allocations) / double(count);
+}
+
+TestResult checkBudget(const string &name, double allocations, double budget) {
+	if (allocations < 0.)
+		return TestResult(false, name + ": messages were not received");
+
+	cout << name << ": " << allocations << " allocations per message (budget " << budget << ")"
+	     << endl;
+	if (allocations > budget)
+		return TestResult(false, name + ": " + to_string(allocations) +
+		                             " allocations per message exceed the budget");
+
+	return TestResult(true);
+}
+
+} // namespace
+
+TestResult test_allocations_datachannel() {
+	InitLogger(LogLevel::Warning);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+	connect(pc1, pc2);
+
+	std::atomic<int> received = 0;
+	shared_ptr<DataChannel> dc2;
+	pc2.onDataChannel([&received, &dc2](shared_ptr<DataChannel> dc) {
+		// Received messages are shared instead of copied
+		dc->onMessageView([&received](shared_ptr<const Message>) { ++received; });
+		std::atomic_store(&dc2, dc);
+	});
+
+	auto dc1 = pc1.createDataChannel("allocations");
+	int attempts = 100;
+	while ((!dc1->isOpen() || !std::atomic_load(&dc2)) && attempts--)
+		this_thread::sleep_for(100ms);
+
+	if (!dc1->isOpen())
+		return TestResult(false, "DataChannel is not open");
+
+	const binary message(1024, byte(0xA5));
+	auto send = [&dc1, &message]() {
+		while (dc1->bufferedAmount() > 1024 * 1024)
+			this_thread::sleep_for(1ms);
+
+		dc1->send(message.data(), message.size());
+	};
+
+	measure(WarmupCount, WarmupCount, received, send); // fill the pools
+	auto result = checkBudget("DataChannel send and receive",
+	                          measure(MeasureCount, MeasureCount, received, send),
+	                          DataChannelBudget);
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+	return result;
+}
+
+#if RTC_ENABLE_MEDIA
+
+TestResult test_allocations_track() {
+	InitLogger(LogLevel::Warning);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+	connect(pc1, pc2);
+
+	std::atomic<int> received = 0;
+	shared_ptr<Track> t2;
+	pc2.onTrack([&received, &t2](shared_ptr<Track> track) {
+		// Received RTP packets, after SRTP unprotection, are shared instead of copied
+		track->onMessageView([&received](shared_ptr<const Message>) { ++received; });
+		std::atomic_store(&t2, track);
+	});
+
+	const SSRC ssrc = 42;
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	media.addSSRC(ssrc, "allocations");
+	auto t1 = pc1.addTrack(media);
+	auto config = make_shared<RtpPacketizationConfig>(ssrc, "allocations", 96, 90000);
+	t1->setMediaHandler(
+	    make_shared<H264RtpPacketizer>(NalUnit::Separator::LongStartSequence, config));
+
+	pc1.setLocalDescription();
+
+	int attempts = 100;
+	while ((!t1->isOpen() || !std::atomic_load(&t2) || !std::atomic_load(&t2)->isOpen()) &&
+	       attempts--)
+		this_thread::sleep_for(100ms);
+
+	if (!t1->isOpen())
+		return TestResult(false, "Track is not open");
+
+	// A single NAL unit frame fitting in one RTP packet
+	binary frame(1000, byte(0xA5));
+	frame[0] = frame[1] = frame[2] = byte(0);
+	frame[3] = byte(1);
+	frame[4] = byte(0x41); // non-IDR slice
+
+	uint32_t timestamp = 0;
+	auto send = [&t1, &frame, &timestamp]() {
+		t1->sendFrame(frame.data(), frame.size(), FrameInfo(timestamp += 3000));
+		this_thread::sleep_for(100us); // avoid overflowing the receiver socket buffer
+	};
+
+	// RTP is unreliable, so a few packets might be lost
+	const int minReceived = MeasureCount * 99 / 100;
+	measure(WarmupCount, WarmupCount * 99 / 100, received, send); // fill the pools
+	auto result = checkBudget("Track sendFrame and SRTP receive",
+	                          measure(MeasureCount, minReceived, received, send), TrackBudget);
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+	return result;
+}
+
+#endif
+
+#endif
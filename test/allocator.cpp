@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.h"
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/memoryhooks.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace rtc;
+using namespace std;
+
+using impl::MemoryHooks;
+
+namespace {
+
+void *testAllocate(size_t size) { return std::malloc(size); }
+void *testReallocate(void *ptr, size_t size) { return std::realloc(ptr, size); }
+void testDeallocate(void *ptr) { std::free(ptr); }
+
+} // namespace
+
+TestResult test_allocator() {
+	try {
+		// Incomplete allocators are rejected whether or not the hooks are frozen
+		Allocator partial;
+		partial.allocate = testAllocate;
+		partial.deallocate = testDeallocate;
+		try {
+			SetAllocator(partial);
+			return TestResult(false, "Incomplete allocator accepted");
+		} catch (const std::invalid_argument &) {
+		}
+		if (rtcSetAllocator(testAllocate, nullptr, testDeallocate) != RTC_ERR_INVALID)
+			return TestResult(false, "rtcSetAllocator accepted an incomplete allocator");
+
+		// The library has allocated by now, and an allocation freezes the hooks regardless
+		PeerConnection pc;
+		MemoryHooks::Free(MemoryHooks::Allocate(16));
+
+		Allocator allocator;
+		allocator.allocate = testAllocate;
+		allocator.reallocate = testReallocate;
+		allocator.deallocate = testDeallocate;
+		try {
+			SetAllocator(allocator);
+			return TestResult(false, "Allocator changed after memory was allocated");
+		} catch (const std::logic_error &) {
+		}
+		try {
+			SetAllocator(Allocator{});
+			return TestResult(false, "Allocator reset after memory was allocated");
+		} catch (const std::logic_error &) {
+		}
+		if (rtcSetAllocator(testAllocate, testReallocate, testDeallocate) != RTC_ERR_FAILURE)
+			return TestResult(false, "rtcSetAllocator succeeded after memory was allocated");
+
+		if (MemoryHooks::IsSet())
+			return TestResult(false, "Rejected allocator was installed");
+
+		// The default functions follow the semantics of malloc, realloc, and free
+		auto ptr = static_cast<char *>(MemoryHooks::Allocate(64));
+		if (!ptr)
+			return TestResult(false, "Allocation failed");
+
+		std::memset(ptr, 0x5A, 64);
+		ptr = static_cast<char *>(MemoryHooks::Reallocate(ptr, 4096));
+		if (!ptr)
+			return TestResult(false, "Reallocation failed");
+
+		bool preserved = true;
+		for (int i = 0; i < 64; ++i)
+			preserved &= ptr[i] == 0x5A;
+
+		MemoryHooks::Free(ptr);
+		if (!preserved)
+			return TestResult(false, "Reallocation did not preserve the contents");
+
+		MemoryHooks::Free(nullptr);
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+// RTP packet with a one-byte header audio level element, flag and level in -dBov
+message_ptr makeRtp(SSRC ssrc, uint8_t extId, bool voice, uint8_t level) {
+	auto message = make_message(sizeof(RtpHeader) + 8 + 4);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(111);
+	rtp->setSsrc(ssrc);
+	rtp->setExtension(true);
+	auto ext = rtp->getExtensionHeader();
+	ext->setProfileSpecificId(0xBEDE);
+	ext->setHeaderLength(1);
+	ext->clearBody();
+	const byte value = byte((voice ? 0x80 : 0) | level);
+	ext->writeOneByteHeader(0, extId, &value, 1);
+	return message;
+}
+
+void feed(AudioLevelHandler &handler, message_ptr message) {
+	message_vector messages{std::move(message)};
+	handler.incoming(messages, [](message_ptr) {});
+}
+
+Description::Audio makeMedia(int extId) {
+	Description::Audio audio("audio", Description::Direction::RecvOnly);
+	audio.addOpusCodec(111);
+	if (extId > 0)
+		audio.addExtMap(Description::Entry::ExtMap(extId, AudioLevelHandler::ExtensionUri));
+
+	return audio;
+}
+
+} // namespace
+
+TestResult test_audio_level_handler() {
+	try {
+		// Levels are ignored until the extension is negotiated
+		{
+			AudioLevelHandler handler;
+			feed(handler, makeRtp(1, 1, true, 20));
+			handler.media(makeMedia(0));
+			feed(handler, makeRtp(1, 1, true, 20));
+			if (handler.level(1) || !handler.topSpeakers(10).empty())
+				return TestResult(false, "Level recorded without the negotiated extension");
+		}
+
+		AudioLevelHandler handler(0.5, 200ms);
+		handler.media(makeMedia(3));
+
+		// Other elements, packets without extension and control messages are ignored
+		feed(handler, makeRtp(1, 4, false, 20));
+		auto plain = make_message(sizeof(RtpHeader) + 4);
+		reinterpret_cast<RtpHeader *>(plain->data())->preparePacket();
+		reinterpret_cast<RtpHeader *>(plain->data())->setSsrc(1);
+		feed(handler, plain);
+		auto control = makeRtp(1, 3, false, 20);
+		control->type = Message::Control;
+		feed(handler, control);
+		if (handler.level(1))
+			return TestResult(false, "Level recorded from a packet without the element");
+
+		// The first packet sets the level, the next ones are smoothed
+		feed(handler, makeRtp(1, 3, false, 20));
+		auto level = handler.level(1);
+		if (!level || level->ssrc != 1 || level->level != 20. || level->voiceActivity)
+			return TestResult(false, "Wrong level of the first packet");
+
+		feed(handler, makeRtp(1, 3, true, 60));
+		level = handler.level(1);
+		if (!level || level->level != 40. || !level->voiceActivity)
+			return TestResult(false, "Wrong smoothed level");
+
+		// Speakers are ranked from the loudest, 0 dBov being the loudest, across forked handlers
+		auto forked = handler.fork();
+		forked->media(makeMedia(5)); // negotiated for its own track
+		feed(*forked, makeRtp(2, 5, true, 10));
+		feed(handler, makeRtp(3, 3, true, 90));
+		auto top = handler.topSpeakers(2);
+		if (top.size() != 2 || top[0].ssrc != 2 || top[1].ssrc != 1)
+			return TestResult(false, "Wrong top speakers");
+
+		if (forked->topSpeakers(10).size() != 3)
+			return TestResult(false, "Levels not shared with the forked handler");
+
+		// Streams without packets for the timeout are not speakers anymore
+		this_thread::sleep_for(300ms);
+		feed(handler, makeRtp(3, 3, false, 90));
+		top = handler.topSpeakers(10);
+		if (handler.level(1) || top.size() != 1 || top[0].ssrc != 3)
+			return TestResult(false, "Timed out streams still reported");
+
+		// A stream heard again after a silence restarts from its new level
+		feed(handler, makeRtp(1, 3, false, 100));
+		level = handler.level(1);
+		if (!level || level->level != 100.)
+			return TestResult(false, "Level not restarted after a silence");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <memory>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+using Bytes = vector<uint8_t>;
+
+// Packetizes a frame and returns the RTP payloads, checking the marker is on the last packet only
+vector<Bytes> packetize(AV1RtpPacketizer &packetizer, const Bytes &frame, bool &marked) {
+	binary data;
+	for (uint8_t b : frame)
+		data.push_back(byte(b));
+
+	message_vector messages{make_message(std::move(data))};
+	packetizer.outgoing(messages, [](message_ptr) {});
+
+	vector<Bytes> payloads;
+	marked = true;
+	for (size_t i = 0; i < messages.size(); ++i) {
+		auto rtp = reinterpret_cast<const RtpHeader *>(messages[i]->data());
+		if (bool(rtp->marker()) != (i + 1 == messages.size()))
+			marked = false;
+
+		Bytes payload;
+		for (size_t j = rtp->getSize() + rtp->getExtensionHeaderSize(); j < messages[i]->size();
+		     ++j)
+			payload.push_back(std::to_integer<uint8_t>(messages[i]->at(j)));
+
+		payloads.push_back(std::move(payload));
+	}
+	return payloads;
+}
+
+Bytes concat(std::initializer_list<Bytes> parts) {
+	Bytes result;
+	for (const auto &part : parts)
+		result.insert(result.end(), part.begin(), part.end());
+	return result;
+}
+
+} // namespace
+
+TestResult test_av1_packetizer() {
+	try {
+		using Packetization = AV1RtpPacketizer::Packetization;
+		auto config = make_shared<RtpPacketizationConfig>(1, "video", 96, 90000);
+
+		const Bytes delimiter = {0x12, 0x00};
+		const Bytes sequenceHeader = {0x0A, 0x03, 0xA1, 0xA2, 0xA3}; // type 1, with size
+		const Bytes frameObu = {0x32, 0x04, 0xF1, 0xF2, 0xF3, 0xF4}; // type 6, with size
+		bool marked = false;
+
+		// The sequence header is aggregated with the next OBU, preceded by its length
+		AV1RtpPacketizer packetizer(Packetization::TemporalUnit, config, 100);
+		auto payloads = packetize(packetizer, concat({delimiter, sequenceHeader, frameObu}), marked);
+		if (payloads.size() != 1 || !marked ||
+		    payloads[0] != concat({{0x28, 0x05}, sequenceHeader, frameObu}))
+			return TestResult(false, "Wrong aggregation of the sequence header");
+
+		// Without delimiter, and without sequence header
+		payloads = packetize(packetizer, frameObu, marked);
+		if (payloads.size() != 1 || payloads[0] != concat({{0x10}, frameObu}))
+			return TestResult(false, "Wrong packet for a single OBU");
+
+		// Fragmentation with Z and Y flags
+		Bytes largeObu = {0x32, 0x12};
+		for (uint8_t i = 0; i < 18; ++i)
+			largeObu.push_back(i);
+
+		AV1RtpPacketizer small(Packetization::TemporalUnit, config, 10);
+		payloads = packetize(small, largeObu, marked);
+		if (payloads.size() != 3 || !marked ||
+		    payloads[0] != concat({{0x50}, Bytes(largeObu.begin(), largeObu.begin() + 9)}) ||
+		    payloads[1] != concat({{0xD0}, Bytes(largeObu.begin() + 9, largeObu.begin() + 18)}) ||
+		    payloads[2] != concat({{0x90}, Bytes(largeObu.begin() + 18, largeObu.end())}))
+			return TestResult(false, "Wrong fragmentation of a large OBU");
+
+		// A sequence header that doesn't fit with the OBU is sent alone
+		const Bytes largeHeader = {0x0A, 0x07, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7};
+		payloads = packetize(small, concat({largeHeader, largeObu}), marked);
+		if (payloads.size() != 4 || payloads[0] != concat({{0x18}, largeHeader}) ||
+		    payloads[1] != concat({{0x50}, Bytes(largeObu.begin(), largeObu.begin() + 9)}))
+			return TestResult(false, "Wrong packets for a sequence header sent alone");
+
+		// A sequence header at the end of a temporal unit is sent with the next one
+		AV1RtpPacketizer trailing(Packetization::TemporalUnit, config, 100);
+		payloads = packetize(trailing, concat({frameObu, sequenceHeader}), marked);
+		if (payloads.size() != 1 || payloads[0] != concat({{0x10}, frameObu}))
+			return TestResult(false, "Trailing sequence header not deferred");
+
+		payloads = packetize(trailing, frameObu, marked);
+		if (payloads.size() != 1 || payloads[0] != concat({{0x28, 0x05}, sequenceHeader, frameObu}))
+			return TestResult(false, "Deferred sequence header not sent with the next OBU");
+
+		// The extension byte is part of the OBU header
+		const Bytes extendedObu = {0x36, 0x08, 0x02, 0xE1, 0xE2};
+		payloads = packetize(trailing, extendedObu, marked);
+		if (payloads.size() != 1 || payloads[0] != concat({{0x10}, extendedObu}))
+			return TestResult(false, "Wrong packet for an OBU with extension");
+
+		// A truncated OBU ends the temporal unit
+		const Bytes truncatedObu = {0x32, 0x10, 0x01, 0x02};
+		payloads = packetize(trailing, concat({frameObu, truncatedObu}), marked);
+		if (payloads.size() != 1 || payloads[0] != concat({{0x10}, frameObu}))
+			return TestResult(false, "Truncated OBU not ignored");
+
+		// OBU packetization takes the whole frame as a single OBU
+		AV1RtpPacketizer obu(Packetization::Obu, config, 100);
+		payloads = packetize(obu, frameObu, marked);
+		if (payloads.size() != 1 || payloads[0] != concat({{0x10}, frameObu}))
+			return TestResult(false, "Wrong packet with OBU packetization");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
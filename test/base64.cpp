@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/utils.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+#include "impl/wshandshake.hpp"
+#endif
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::utils::base64_decode;
+using impl::utils::base64_encode;
+
+namespace {
+
+binary toBinary(const string &str) {
+	binary data(str.size());
+	std::transform(str.begin(), str.end(), data.begin(), [](char c) { return byte(c); });
+	return data;
+}
+
+bool isInvalid(const string &str) {
+	try {
+		base64_decode(str);
+		return false;
+	} catch (const std::invalid_argument &) {
+		return true;
+	}
+}
+
+#if RTC_ENABLE_WEBSOCKET
+// Returns the response code of the request with the key, or 101 if it is accepted
+int handshake(const string &key, string *response = nullptr) {
+	const string request = "GET /chat HTTP/1.1\r\n"
+	                       "Host: server.example.com\r\n"
+	                       "Upgrade: websocket\r\n"
+	                       "Connection: Upgrade\r\n"
+	                       "Sec-WebSocket-Key: " +
+	                       key + "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+	impl::WsHandshake handshake;
+	try {
+		handshake.parseHttpRequest(reinterpret_cast<const byte *>(request.data()), request.size());
+	} catch (const impl::WsHandshake::RequestError &e) {
+		return e.responseCode();
+	}
+
+	if (response)
+		*response = handshake.generateHttpResponse();
+
+	return 101;
+}
+#endif
+
+} // namespace
+
+TestResult test_base64() {
+	try {
+		// Test vectors from RFC 4648 section 10
+		const vector<pair<string, string>> vectors = {
+		    {"", ""},           {"f", "Zg=="},         {"fo", "Zm8="},         {"foo", "Zm9v"},
+		    {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"},
+		};
+		for (const auto &[data, encoded] : vectors) {
+			if (base64_encode(toBinary(data)) != encoded)
+				return TestResult(false, "Wrong encoding of \"" + data + "\"");
+
+			if (base64_decode(encoded) != toBinary(data))
+				return TestResult(false, "Wrong decoding of \"" + encoded + "\"");
+		}
+
+		// All byte values and all tail lengths round-trip
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<int> distribution(0, 255);
+		for (size_t size = 0; size < 300; ++size) {
+			binary data(size);
+			for (auto &b : data)
+				b = byte(distribution(generator));
+
+			const string encoded = base64_encode(data);
+			if (encoded.size() != 4 * ((size + 2) / 3))
+				return TestResult(false, "Wrong encoded size");
+
+			if (base64_decode(encoded) != data)
+				return TestResult(false, "Round trip failed");
+		}
+
+		binary all(256);
+		for (size_t i = 0; i < all.size(); ++i)
+			all[i] = byte(i);
+
+		if (base64_decode(base64_encode(all)) != all)
+			return TestResult(false, "Round trip of all byte values failed");
+
+		// Invalid lengths, characters, and misplaced padding are rejected
+		const vector<string> invalid = {
+		    "Zg",   "Zm9",  "Zm9vY", "Zm9v!mFy", "Zm9vYmF\n", "Zm-v", "Zm_v",
+		    "Zg=!", "Z===", "====",  "Zg==Zm9v", "Zm=v",      "=m9v", "Zm9vYm\xC3\xA9",
+		};
+		for (const auto &str : invalid)
+			if (!isInvalid(str))
+				return TestResult(false, "Invalid base64 \"" + str + "\" accepted");
+
+#if RTC_ENABLE_WEBSOCKET
+		// The handshake key must decode to 16 bytes, sample from RFC 6455 section 1.3
+		string response;
+		if (handshake("dGhlIHNhbXBsZSBub25jZQ==", &response) != 101)
+			return TestResult(false, "Valid WebSocket key rejected");
+
+		if (response.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == string::npos)
+			return TestResult(false, "Wrong WebSocket accept key");
+
+		if (handshake("dGhlIHNhbXBsZSBub25j") != 400) // 15 bytes
+			return TestResult(false, "Short WebSocket key accepted");
+
+		if (handshake("dGhlIHNhbXBsZSBub25jZQ") != 400) // missing padding
+			return TestResult(false, "Unpadded WebSocket key accepted");
+
+		if (handshake("dGhlIHNhbXBsZSBub25j*Q==") != 400)
+			return TestResult(false, "Invalid WebSocket key accepted");
+#endif
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -8,11 +8,23 @@
 
 #include "rtc/rtc.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <future>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <variant>
 
 using namespace rtc;
 using namespace std;
@@ -24,17 +36,64 @@ using chrono::steady_clock;
 
 template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
 
-size_t benchmark(milliseconds duration) {
+// Network impairment applied on both sides, set with --impair
+static optional<NetworkImpairment> Impairment;
+
+// Parse a comma-separated list like "loss=0.01,delay=40,jitter=10,bitrate=2000000"
+NetworkImpairment parseImpairment(const string &spec) {
+	NetworkImpairment impairment;
+	size_t pos = 0;
+	while (pos < spec.size()) {
+		size_t end = spec.find(',', pos);
+		if (end == string::npos)
+			end = spec.size();
+
+		string item = spec.substr(pos, end - pos);
+		pos = end + 1;
+		size_t sep = item.find('=');
+		if (sep == string::npos)
+			throw invalid_argument("Invalid impairment parameter: " + item);
+
+		string key = item.substr(0, sep);
+		string value = item.substr(sep + 1);
+		if (key == "loss")
+			impairment.lossRate = std::stod(value);
+		else if (key == "duplicate")
+			impairment.duplicateRate = std::stod(value);
+		else if (key == "reorder")
+			impairment.reorderRate = std::stod(value);
+		else if (key == "delay")
+			impairment.delay = milliseconds(std::stoul(value));
+		else if (key == "jitter")
+			impairment.jitter = milliseconds(std::stoul(value));
+		else if (key == "bitrate")
+			impairment.bitrate = size_t(std::stoull(value));
+		else if (key == "seed")
+			impairment.seed = unsigned(std::stoul(value));
+		else
+			throw invalid_argument("Unknown impairment parameter: " + key);
+	}
+	return impairment;
+}
+
+Configuration benchmarkConfiguration() {
+	Configuration config;
+	config.networkImpairment = Impairment;
+	return config;
+}
+
+size_t benchmark(milliseconds duration, SctpSettings sctpSettings) {
 	rtc::InitLogger(LogLevel::Warning);
+	rtc::SetSctpSettings(std::move(sctpSettings)); // applied on init
 	rtc::Preload();
 
-	Configuration config1;
+	Configuration config1 = benchmarkConfiguration();
 	// config1.iceServers.emplace_back("stun:stun.l.google.com:19302");
 	// config1.mtu = 1500;
 
 	PeerConnection pc1(config1);
 
-	Configuration config2;
+	Configuration config2 = benchmarkConfiguration();
 	// config2.iceServers.emplace_back("stun:stun.l.google.com:19302");
 	// config2.mtu = 1500;
 
@@ -161,13 +220,1109 @@ size_t benchmark(milliseconds duration) {
 	return goodput;
 }
 
+size_t benchmark(milliseconds duration) { return benchmark(duration, SctpSettings{}); }
+
+// Compare the goodput of the default SCTP settings with the throughput profile and auto-tuning
+void benchmarkSctpProfiles(milliseconds duration) {
+	size_t defaultGoodput = benchmark(duration, SctpSettings{});
+
+	SctpSettings throughputSettings;
+	throughputSettings.profile = SctpSettings::Profile::Throughput;
+	size_t throughputGoodput = benchmark(duration, throughputSettings);
+
+	SctpSettings autoTuneSettings;
+	autoTuneSettings.profile = SctpSettings::Profile::Throughput;
+	autoTuneSettings.autoTuneBuffers = true;
+	size_t autoTuneGoodput = benchmark(duration, autoTuneSettings);
+
+	auto gain = [defaultGoodput](size_t goodput) {
+		return defaultGoodput > 0 ? (double(goodput) / defaultGoodput - 1.0) * 100.0 : 0.0;
+	};
+
+	cout << "Default profile goodput: " << defaultGoodput * 0.001 << " MB/s" << endl;
+	cout << "Throughput profile goodput: " << throughputGoodput * 0.001 << " MB/s ("
+	     << gain(throughputGoodput) << "%)" << endl;
+	cout << "Throughput profile with auto-tuning goodput: " << autoTuneGoodput * 0.001
+	     << " MB/s (" << gain(autoTuneGoodput) << "%)" << endl;
+}
+
+// Typical browser offer with audio, video, and a data channel
+static const string BenchmarkSdp =
+    "v=0\r\n"
+    "o=- 4611731400430051336 2 IN IP4 127.0.0.1\r\n"
+    "s=-\r\n"
+    "t=0 0\r\n"
+    "a=group:BUNDLE 0 1 2\r\n"
+    "a=extmap-allow-mixed\r\n"
+    "a=msid-semantic: WMS stream\r\n"
+    "m=audio 9 UDP/TLS/RTP/SAVPF 111 63 9 0 8 110\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+    "a=candidate:1467250027 1 udp 2122260223 192.168.0.196 46243 typ host generation 0\r\n"
+    "a=candidate:1853887674 1 udp 1686052607 203.0.113.7 46243 typ srflx raddr 192.168.0.196 "
+    "rport 46243 generation 0\r\n"
+    "a=ice-ufrag:8hhY\r\n"
+    "a=ice-pwd:asd88fgpdd777uzjYhagZg\r\n"
+    "a=ice-options:trickle\r\n"
+    "a=fingerprint:sha-256 49:66:12:17:0D:1C:91:AE:57:4C:C6:36:DD:D5:97:D2:"
+    "7D:62:C9:9A:7F:B9:A3:F2:67:D5:FB:7D:59:35:4E:69\r\n"
+    "a=setup:actpass\r\n"
+    "a=mid:0\r\n"
+    "a=extmap:1 urn:ietf:params:rtp-hdrext:ssrc-audio-level\r\n"
+    "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=sendrecv\r\n"
+    "a=msid:stream audio\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtpmap:111 opus/48000/2\r\n"
+    "a=rtcp-fb:111 transport-cc\r\n"
+    "a=fmtp:111 minptime=10;useinbandfec=1\r\n"
+    "a=rtpmap:63 red/48000/2\r\n"
+    "a=fmtp:63 111/111\r\n"
+    "a=rtpmap:9 G722/8000\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:110 telephone-event/48000\r\n"
+    "a=ssrc:1001 cname:benchmark\r\n"
+    "a=ssrc:1001 msid:stream audio\r\n"
+    "m=video 9 UDP/TLS/RTP/SAVPF 96 97 102 103\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=mid:1\r\n"
+    "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=sendrecv\r\n"
+    "a=msid:stream video\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtcp-rsize\r\n"
+    "a=rtpmap:96 VP8/90000\r\n"
+    "a=rtcp-fb:96 goog-remb\r\n"
+    "a=rtcp-fb:96 transport-cc\r\n"
+    "a=rtcp-fb:96 nack\r\n"
+    "a=rtcp-fb:96 nack pli\r\n"
+    "a=rtpmap:97 rtx/90000\r\n"
+    "a=fmtp:97 apt=96\r\n"
+    "a=rtpmap:102 H264/90000\r\n"
+    "a=rtcp-fb:102 nack\r\n"
+    "a=rtcp-fb:102 nack pli\r\n"
+    "a=fmtp:102 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42001f\r\n"
+    "a=rtpmap:103 rtx/90000\r\n"
+    "a=fmtp:103 apt=102\r\n"
+    "a=ssrc-group:FID 2001 2002\r\n"
+    "a=ssrc:2001 cname:benchmark\r\n"
+    "a=ssrc:2002 cname:benchmark\r\n"
+    "m=application 9 UDP/DTLS/SCTP webrtc-datachannel\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=mid:2\r\n"
+    "a=sctp-port:5000\r\n"
+    "a=max-message-size:262144\r\n";
+
+// Returns the count of descriptions parsed and generated per second
+size_t benchmarkDescription(milliseconds duration) {
+	// Media sections must be stable when parsing a generated description
+	Description parsed(BenchmarkSdp, Description::Type::Offer);
+	Description reparsed(string(parsed), Description::Type::Offer);
+	if (parsed.mediaCount() != 3 || reparsed.mediaCount() != parsed.mediaCount())
+		throw runtime_error("Unexpected media count in description");
+
+	auto generate = [](auto entry) { return std::visit([](auto *e) { return string(*e); }, entry); };
+	for (int i = 0; i < parsed.mediaCount(); ++i)
+		if (generate(parsed.media(i)) != generate(reparsed.media(i)))
+			throw runtime_error("Generated media description is not stable");
+
+	size_t count = 0;
+	size_t size = 0;
+	const auto startTime = steady_clock::now();
+	auto elapsed = steady_clock::duration::zero();
+	do {
+		for (int i = 0; i < 100; ++i) {
+			Description description(BenchmarkSdp, Description::Type::Offer);
+			size += string(description).size();
+		}
+		count += 100;
+		elapsed = steady_clock::now() - startTime;
+	} while (elapsed < duration);
+
+	const size_t rate = size_t(count * 1000 / std::max<int64_t>(
+	                                             duration_cast<milliseconds>(elapsed).count(), 1));
+	cout << "Description parsing and generation: " << rate << "/s (" << size / count
+	     << " bytes)" << endl;
+	return rate;
+}
+
+// Returns the goodput of a file transfer over channelCount data channels in KB/s
+size_t benchmarkFileTransfer(size_t fileSize, int channelCount) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	const string sourcePath = "benchmark-file-source.bin";
+	const string destinationPath = "benchmark-file-destination.bin";
+	{
+		std::remove(destinationPath.c_str());
+		ofstream source(sourcePath, ios::binary | ios::trunc);
+		string block(65536, '\xA5');
+		for (size_t written = 0; written < fileSize; written += block.size())
+			source.write(block.data(), std::min(block.size(), fileSize - written));
+	}
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+
+	std::mutex mutex;
+	vector<shared_ptr<DataChannel>> remoteChannels;
+	shared_ptr<FileReceiver> receiver;
+	promise<uint64_t> received;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		std::lock_guard lock(mutex);
+		remoteChannels.push_back(std::move(dc));
+		if (int(remoteChannels.size()) == channelCount) {
+			receiver = make_shared<FileReceiver>(destinationPath, remoteChannels);
+			receiver->onComplete([&received](uint64_t size) { received.set_value(size); });
+			receiver->onError([&received](string error) {
+				received.set_exception(make_exception_ptr(runtime_error(error)));
+			});
+		}
+	});
+
+	vector<shared_ptr<DataChannel>> channels;
+	promise<void> opened;
+	atomic<int> openCount = 0;
+	for (int i = 0; i < channelCount; ++i) {
+		auto dc = pc1.createDataChannel("file-" + to_string(i));
+		dc->onOpen([&opened, &openCount, channelCount]() {
+			if (++openCount == channelCount)
+				opened.set_value();
+		});
+		channels.push_back(std::move(dc));
+	}
+
+	if (opened.get_future().wait_for(10s) != future_status::ready)
+		throw runtime_error("Data channels not open");
+
+	FileSender sender(sourcePath, channels);
+	const auto startTime = steady_clock::now();
+	sender.start();
+
+	auto future = received.get_future();
+	if (future.wait_for(60s) != future_status::ready)
+		throw runtime_error("File transfer timed out");
+
+	const uint64_t size = future.get();
+	const auto transferDuration = duration_cast<milliseconds>(steady_clock::now() - startTime);
+	if (size != fileSize)
+		throw runtime_error("Unexpected received file size");
+
+	size_t goodput = size_t(size / std::max<int64_t>(transferDuration.count(), 1));
+	cout << "File transfer over " << channelCount << " channel(s): " << size / 1000 << " KB in "
+	     << transferDuration.count() << " ms, goodput: " << goodput * 0.001 << " MB/s" << endl;
+
+	pc1.close();
+	pc2.close();
+	std::remove(sourcePath.c_str());
+	std::remove(destinationPath.c_str());
+
+	rtc::Cleanup();
+	return goodput;
+}
+
+// Parameters of a case of the benchmark matrix
+struct MatrixCase {
+	size_t messageSize;
+	int channelCount;
+	string mode; // name of the reliability mode
+	Reliability reliability;
+};
+
+struct MatrixResult {
+	MatrixCase params;
+	size_t goodput; // KB/s
+	uint64_t sentCount;
+	uint64_t receivedCount;
+	vector<int64_t> rtts; // microseconds, sorted, empty if latency is not measured
+};
+
+// Shared with callbacks, which might outlive the benchmark function
+struct MatrixState {
+	bool measureLatency = false;
+	binary message;
+
+	atomic<uint64_t> sentCount = 0;
+	atomic<uint64_t> receivedCount = 0;
+	atomic<size_t> receivedSize = 0;
+	atomic<bool> running = true;
+
+	std::mutex mutex;
+	optional<steady_clock::time_point> firstReceivedTime;
+	vector<int64_t> rtts;
+};
+
+// With latency measurement, every 64th message is a probe holding its send time, which the
+// remote peer echoes back. Bytes 0 to 7 are the timestamp and byte 8 is the probe flag.
+const size_t ProbeHeaderSize = 9;
+const uint64_t ProbeInterval = 64;
+
+void sendUntilBuffered(DataChannel &dc, MatrixState &state) {
+	try {
+		while (state.running && dc.isOpen() && dc.bufferedAmount() == 0) {
+			const uint64_t count = state.sentCount++;
+			if (state.measureLatency && count % ProbeInterval == 0) {
+				binary probe = state.message;
+				const int64_t now = steady_clock::now().time_since_epoch().count();
+				std::memcpy(probe.data(), &now, sizeof(now));
+				probe[8] = byte(1);
+				dc.send(std::move(probe));
+			} else {
+				dc.send(state.message);
+			}
+		}
+	} catch (const std::exception &e) {
+		std::cout << "Send failed: " << e.what() << std::endl;
+	}
+}
+
+MatrixResult benchmarkCase(const MatrixCase &params, milliseconds duration, bool measureLatency) {
+	PeerConnection pc1(benchmarkConfiguration());
+	PeerConnection pc2(benchmarkConfiguration());
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+
+	auto state = make_shared<MatrixState>();
+	state->measureLatency = measureLatency;
+	state->message.resize(std::max(params.messageSize, ProbeHeaderSize), byte(0xFF));
+	state->message[8] = byte(0);
+
+	std::mutex remoteMutex;
+	vector<shared_ptr<DataChannel>> remoteChannels;
+	pc2.onDataChannel([&remoteMutex, &remoteChannels, state](shared_ptr<DataChannel> dc) {
+		dc->onMessage([wdc = make_weak_ptr(dc), state](variant<binary, string> message) {
+			if (!holds_alternative<binary>(message))
+				return;
+
+			const auto &bin = get<binary>(message);
+			if (state->receivedCount++ == 0) {
+				std::lock_guard lock(state->mutex);
+				state->firstReceivedTime = steady_clock::now();
+			}
+			state->receivedSize += bin.size();
+
+			if (bin.size() >= ProbeHeaderSize && bin[8] == byte(1))
+				if (auto dc = wdc.lock(); dc && dc->isOpen())
+					dc->send(binary(bin.begin(), bin.begin() + ProbeHeaderSize));
+		});
+
+		std::lock_guard lock(remoteMutex);
+		remoteChannels.push_back(std::move(dc));
+	});
+
+	DataChannelInit init;
+	init.reliability = params.reliability;
+
+	vector<shared_ptr<DataChannel>> channels;
+	promise<void> opened;
+	atomic<int> openCount = 0;
+	const int channelCount = params.channelCount;
+	for (int i = 0; i < channelCount; ++i) {
+		auto dc = pc1.createDataChannel("benchmark-" + to_string(i), init);
+		dc->onOpen([&opened, &openCount, channelCount]() {
+			if (++openCount == channelCount)
+				opened.set_value();
+		});
+		dc->onMessage([state](variant<binary, string> message) {
+			// Echoed probe
+			if (!holds_alternative<binary>(message))
+				return;
+
+			const auto &bin = get<binary>(message);
+			if (bin.size() != ProbeHeaderSize)
+				return;
+
+			int64_t sent;
+			std::memcpy(&sent, bin.data(), sizeof(sent));
+			const auto sentTime = steady_clock::time_point(steady_clock::duration(sent));
+			const auto rtt = steady_clock::now() - sentTime;
+			std::lock_guard lock(state->mutex);
+			state->rtts.push_back(chrono::duration_cast<chrono::microseconds>(rtt).count());
+		});
+		dc->onBufferedAmountLow([wdc = make_weak_ptr(dc), state]() {
+			if (auto dc = wdc.lock())
+				sendUntilBuffered(*dc, *state);
+		});
+		channels.push_back(std::move(dc));
+	}
+
+	if (opened.get_future().wait_for(10s) != future_status::ready)
+		throw runtime_error("Data channels not open");
+
+	for (const auto &dc : channels)
+		sendUntilBuffered(*dc, *state);
+
+	this_thread::sleep_for(duration);
+	state->running = false;
+	const auto endTime = steady_clock::now();
+
+	MatrixResult result;
+	result.params = params;
+	result.sentCount = state->sentCount.load();
+	result.receivedCount = state->receivedCount.load();
+	const size_t receivedSize = state->receivedSize.load();
+	{
+		std::lock_guard lock(state->mutex);
+		const auto transferDuration = duration_cast<milliseconds>(
+		    endTime - state->firstReceivedTime.value_or(endTime));
+		result.goodput =
+		    transferDuration.count() > 0 ? receivedSize / size_t(transferDuration.count()) : 0;
+		result.rtts = state->rtts;
+	}
+	std::sort(result.rtts.begin(), result.rtts.end());
+
+	for (const auto &dc : channels)
+		dc->close();
+
+	pc1.close();
+	pc2.close();
+	return result;
+}
+
+int64_t percentile(const vector<int64_t> &sorted, double q) {
+	if (sorted.empty())
+		return 0;
+
+	return sorted[std::min(sorted.size() - 1, size_t(q * double(sorted.size())))];
+}
+
+// Runs the benchmark for each combination of message size, channel count, and reliability mode
+void benchmarkMatrix(milliseconds duration, bool measureLatency, bool json) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	Reliability reliableOrdered;
+	Reliability reliableUnordered;
+	reliableUnordered.unordered = true;
+	Reliability unreliable;
+	unreliable.unordered = true;
+	unreliable.maxRetransmits = 0;
+	Reliability partial;
+	partial.maxPacketLifeTime = 100ms;
+
+	const vector<pair<string, Reliability>> modes = {
+	    {"reliable-ordered", reliableOrdered},
+	    {"reliable-unordered", reliableUnordered},
+	    {"unreliable-unordered", unreliable},
+	    {"lifetime-100ms-ordered", partial},
+	};
+
+	vector<MatrixResult> results;
+	for (size_t messageSize : {100, 1024, 16384, 65535}) {
+		for (int channelCount : {1, 8, 64}) {
+			for (const auto &[mode, reliability] : modes) {
+				MatrixCase params{messageSize, channelCount, mode, reliability};
+				auto result = benchmarkCase(params, duration, measureLatency);
+				cerr << "size=" << messageSize << " channels=" << channelCount << " mode=" << mode
+				     << ": goodput " << result.goodput * 0.001 << " MB/s, "
+				     << result.receivedCount << "/" << result.sentCount << " messages";
+				if (measureLatency)
+					cerr << ", RTT p50=" << percentile(result.rtts, 0.50)
+					     << "us p99=" << percentile(result.rtts, 0.99) << "us";
+				cerr << endl;
+				results.push_back(std::move(result));
+			}
+		}
+	}
+
+	if (json) {
+		cout << "{\n  \"benchmarks\": [";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const auto &r = results[i];
+			cout << (i > 0 ? "," : "") << "\n    {\"message_size\": " << r.params.messageSize
+			     << ", \"channels\": " << r.params.channelCount << ", \"mode\": \""
+			     << r.params.mode << "\", \"goodput_kbps\": " << r.goodput * 8
+			     << ", \"sent\": " << r.sentCount << ", \"received\": " << r.receivedCount;
+			if (measureLatency)
+				cout << ", \"rtt_samples\": " << r.rtts.size()
+				     << ", \"rtt_p50_us\": " << percentile(r.rtts, 0.50)
+				     << ", \"rtt_p90_us\": " << percentile(r.rtts, 0.90)
+				     << ", \"rtt_p99_us\": " << percentile(r.rtts, 0.99);
+			cout << "}";
+		}
+		cout << "\n  ]\n}" << endl;
+	}
+
+	rtc::Cleanup();
+}
+
+// Runs a few short end-to-end cases for the performance regression gate (perf-check target)
+// The JSON output follows the format of the microbenchmarks, so results can be compared the same
+// way: real_time is the time per received message, lower is better.
+void benchmarkShort(milliseconds duration, bool json) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	Reliability unreliable;
+	unreliable.unordered = true;
+	unreliable.maxRetransmits = 0;
+
+	const vector<MatrixCase> cases = {
+	    {1024, 1, "reliable-ordered", Reliability{}},
+	    {65535, 1, "reliable-ordered", Reliability{}},
+	    {1024, 8, "unreliable-unordered", unreliable},
+	};
+
+	if (json)
+		cout << "{\n  \"context\": {\n    \"library\": \"libdatachannel\"\n  },\n"
+		     << "  \"benchmarks\": [";
+
+	for (size_t i = 0; i < cases.size(); ++i) {
+		const auto &params = cases[i];
+		const auto result = benchmarkCase(params, duration, false);
+		const string name = "e2e/" + params.mode + "/" + std::to_string(params.messageSize) + "x" +
+		                    std::to_string(params.channelCount);
+		// goodput is in bytes per millisecond
+		const double bytesPerSecond = double(result.goodput) * 1000.;
+		const double nsPerMessage =
+		    result.goodput > 0 ? double(params.messageSize) * 1e9 / bytesPerSecond : 0.;
+
+		cerr << name << ": goodput " << result.goodput * 0.001 << " MB/s" << endl;
+		if (json)
+			cout << (i > 0 ? "," : "") << "\n    {\"name\": \"" << name
+			     << "\", \"run_type\": \"iteration\", \"iterations\": " << result.receivedCount
+			     << ", \"real_time\": " << std::fixed << std::setprecision(3) << nsPerMessage
+			     << ", \"time_unit\": \"ns\", \"bytes_per_second\": " << std::setprecision(0)
+			     << bytesPerSecond << "}";
+	}
+
+	if (json)
+		cout << "\n  ]\n}" << endl;
+
+	rtc::Cleanup();
+}
+
+// Returns a numeric field of /proc/self/status, like VmRSS in KB, or 0 if unavailable
+size_t readProcStatus(const string &key) {
+	ifstream status("/proc/self/status");
+	string line;
+	while (getline(status, line))
+		if (line.rfind(key + ":", 0) == 0)
+			return size_t(std::strtoull(line.c_str() + key.size() + 1, nullptr, 10));
+
+	return 0;
+}
+
+struct ScalePair {
+	unique_ptr<PeerConnection> pc1;
+	unique_ptr<PeerConnection> pc2;
+	shared_ptr<DataChannel> dc;
+};
+
+// Connects pairCount PeerConnection pairs over loopback, each with a data channel, and reports
+// the time from creation to the data channel being open, including certificate generation, ICE
+// gathering, DTLS, and SCTP. At most 64 pairs are connecting at the same time.
+void benchmarkScale(size_t pairCount, bool json) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	const size_t maxConnecting = 64;
+	const size_t baseRss = readProcStatus("VmRSS");
+
+	std::mutex mutex;
+	vector<int64_t> connectTimes; // milliseconds
+	atomic<size_t> openCount = 0;
+	atomic<size_t> failedCount = 0;
+	size_t maxQueuedTasks = 0;
+	size_t maxThreads = 0;
+	auto sample = [&]() {
+		maxQueuedTasks = std::max(maxQueuedTasks, rtc::GetThreadPoolStats().queuedTasks);
+		maxThreads = std::max(maxThreads, readProcStatus("Threads"));
+	};
+
+	vector<ScalePair> pairs;
+	pairs.reserve(pairCount);
+	const auto startTime = steady_clock::now();
+	const auto deadline = startTime + 60s + 10ms * pairCount;
+	while (openCount + failedCount < pairCount && steady_clock::now() < deadline) {
+		if (pairs.size() < pairCount && pairs.size() - openCount - failedCount < maxConnecting) {
+			ScalePair pair;
+			pair.pc1 = make_unique<PeerConnection>();
+			pair.pc2 = make_unique<PeerConnection>();
+			auto pc1 = pair.pc1.get();
+			auto pc2 = pair.pc2.get();
+			pc1->onLocalDescription([pc2](Description sdp) { pc2->setRemoteDescription(sdp); });
+			pc1->onLocalCandidate([pc2](Candidate cand) { pc2->addRemoteCandidate(cand); });
+			pc2->onLocalDescription([pc1](Description sdp) { pc1->setRemoteDescription(sdp); });
+			pc2->onLocalCandidate([pc1](Candidate cand) { pc1->addRemoteCandidate(cand); });
+			pc1->onStateChange([&failedCount](PeerConnection::State state) {
+				if (state == PeerConnection::State::Failed)
+					++failedCount;
+			});
+
+			const auto createdTime = steady_clock::now();
+			pair.dc = pc1->createDataChannel("scale");
+			pair.dc->onOpen([&, createdTime]() {
+				const auto elapsed = duration_cast<milliseconds>(steady_clock::now() - createdTime);
+				std::lock_guard lock(mutex);
+				connectTimes.push_back(elapsed.count());
+				++openCount;
+			});
+			pairs.push_back(std::move(pair));
+			continue;
+		}
+
+		sample();
+		this_thread::sleep_for(10ms);
+	}
+
+	const auto totalDuration = duration_cast<milliseconds>(steady_clock::now() - startTime);
+	sample();
+	const size_t rss = readProcStatus("VmRSS");
+	const size_t rssPerConnection =
+	    rss > baseRss && openCount > 0 ? (rss - baseRss) / (2 * openCount) : 0;
+	const auto poolStats = rtc::GetThreadPoolStats();
+
+	vector<int64_t> sorted;
+	{
+		std::lock_guard lock(mutex);
+		sorted = connectTimes;
+	}
+	std::sort(sorted.begin(), sorted.end());
+
+	cerr << pairCount << " pairs: " << openCount << " connected, " << failedCount << " failed in "
+	     << totalDuration.count() << " ms, time to connected p50=" << percentile(sorted, 0.50)
+	     << "ms p99=" << percentile(sorted, 0.99) << "ms, RSS per PeerConnection "
+	     << rssPerConnection << " KB, max queued tasks " << maxQueuedTasks << ", "
+	     << poolStats.workers << " workers, max threads " << maxThreads << endl;
+
+	if (json)
+		cout << "{\"pairs\": " << pairCount << ", \"connected\": " << openCount
+		     << ", \"failed\": " << failedCount << ", \"duration_ms\": " << totalDuration.count()
+		     << ", \"connect_p50_ms\": " << percentile(sorted, 0.50)
+		     << ", \"connect_p90_ms\": " << percentile(sorted, 0.90)
+		     << ", \"connect_p99_ms\": " << percentile(sorted, 0.99)
+		     << ", \"connect_max_ms\": " << (sorted.empty() ? 0 : sorted.back())
+		     << ", \"rss_per_connection_kb\": " << rssPerConnection
+		     << ", \"max_queued_tasks\": " << maxQueuedTasks
+		     << ", \"workers\": " << poolStats.workers << ", \"max_threads\": " << maxThreads
+		     << "}" << endl;
+
+	for (auto &pair : pairs) {
+		pair.pc1->close();
+		pair.pc2->close();
+	}
+	pairs.clear();
+
+	rtc::Cleanup();
+}
+
+#if RTC_ENABLE_WEBSOCKET
+
+struct WebSocketState {
+	std::mutex mutex;
+	vector<int64_t> rtts; // microseconds
+	atomic<bool> running = false;
+	atomic<size_t> echoed = 0;
+	binary payload;
+};
+
+// Opens clientCount WebSocket clients against a local echo WebSocketServer, then measures the
+// echo rate and latency for each message size, with one message in flight per client. Many
+// clients require raising the file descriptor limit, for instance with ulimit -n.
+void benchmarkWebSocket(size_t clientCount, bool tls, bool json) {
+	rtc::InitLogger(LogLevel::Warning);
+
+	const uint16_t port = 48090;
+	const size_t maxConnecting = 256;
+
+	WebSocketServer::Configuration serverConfig;
+	serverConfig.port = port;
+	serverConfig.enableTls = tls; // a self-signed certificate is generated
+	serverConfig.bindAddress = "127.0.0.1";
+	WebSocketServer server(std::move(serverConfig));
+
+	std::mutex serverMutex;
+	vector<shared_ptr<WebSocket>> serverClients;
+	server.onClient([&](shared_ptr<WebSocket> incoming) {
+		incoming->onMessage([wclient = make_weak_ptr(incoming)](variant<binary, string> message) {
+			if (auto client = wclient.lock())
+				client->send(std::move(message));
+		});
+		std::lock_guard lock(serverMutex);
+		serverClients.push_back(std::move(incoming));
+	});
+
+	auto state = std::make_shared<WebSocketState>();
+	std::mutex mutex;
+	vector<int64_t> handshakeTimes; // milliseconds
+	atomic<size_t> openCount = 0;
+	atomic<size_t> failedCount = 0;
+
+	const string url = string(tls ? "wss" : "ws") + "://127.0.0.1:" + std::to_string(port) + "/";
+	vector<shared_ptr<WebSocket>> clients;
+	clients.reserve(clientCount);
+	const auto startTime = steady_clock::now();
+	const auto deadline = startTime + 30s + 10ms * clientCount;
+	while (openCount + failedCount < clientCount && steady_clock::now() < deadline) {
+		if (clients.size() < clientCount &&
+		    clients.size() - openCount - failedCount < maxConnecting) {
+			WebSocket::Configuration config;
+			config.disableTlsVerification = true;
+			auto ws = std::make_shared<WebSocket>(std::move(config));
+			const auto createdTime = steady_clock::now();
+			ws->onOpen([&, createdTime]() {
+				const auto elapsed = duration_cast<milliseconds>(steady_clock::now() - createdTime);
+				std::lock_guard lock(mutex);
+				handshakeTimes.push_back(elapsed.count());
+				++openCount;
+			});
+			ws->onError([&failedCount](string) { ++failedCount; });
+			ws->onMessage([state, wws = make_weak_ptr(ws)](variant<binary, string> message) {
+				auto bin = get_if<binary>(&message);
+				if (!bin || bin->size() < sizeof(int64_t))
+					return;
+
+				int64_t sentTime;
+				std::memcpy(&sentTime, bin->data(), sizeof(sentTime));
+				const int64_t now = duration_cast<chrono::microseconds>(
+				                        steady_clock::now().time_since_epoch())
+				                        .count();
+				++state->echoed;
+				{
+					std::lock_guard lock(state->mutex);
+					state->rtts.push_back(now - sentTime);
+				}
+				if (!state->running)
+					return;
+
+				if (auto ws = wws.lock()) {
+					std::memcpy(bin->data(), &now, sizeof(now));
+					ws->send(std::move(*bin));
+				}
+			});
+			ws->open(url);
+			clients.push_back(std::move(ws));
+			continue;
+		}
+
+		this_thread::sleep_for(10ms);
+	}
+
+	const auto stormDuration = duration_cast<milliseconds>(steady_clock::now() - startTime);
+	vector<int64_t> sortedHandshakes;
+	{
+		std::lock_guard lock(mutex);
+		sortedHandshakes = handshakeTimes;
+	}
+	std::sort(sortedHandshakes.begin(), sortedHandshakes.end());
+	const double handshakeRate =
+	    double(openCount) * 1000. / double(std::max<int64_t>(stormDuration.count(), 1));
+
+	cerr << clientCount << " WebSocket clients" << (tls ? " with TLS" : "") << ": " << openCount
+	     << " open, " << failedCount << " failed in " << stormDuration.count() << " ms ("
+	     << int64_t(handshakeRate) << " handshakes/s), handshake p50="
+	     << percentile(sortedHandshakes, 0.50) << "ms p99=" << percentile(sortedHandshakes, 0.99)
+	     << "ms" << endl;
+
+	if (json)
+		cout << "{\"clients\": " << clientCount << ", \"tls\": " << (tls ? "true" : "false")
+		     << ", \"open\": " << openCount << ", \"failed\": " << failedCount
+		     << ", \"handshakes_per_second\": " << int64_t(handshakeRate)
+		     << ", \"handshake_p50_ms\": " << percentile(sortedHandshakes, 0.50)
+		     << ", \"handshake_p99_ms\": " << percentile(sortedHandshakes, 0.99) << ", \"echo\": [";
+
+	const milliseconds duration = 3s;
+	const vector<size_t> messageSizes = {64, 1024, 16384, 65536};
+	for (size_t i = 0; i < messageSizes.size(); ++i) {
+		const size_t size = messageSizes[i];
+		{
+			std::lock_guard lock(state->mutex);
+			state->rtts.clear();
+		}
+		state->echoed = 0;
+		state->running = true;
+
+		const auto echoStartTime = steady_clock::now();
+		for (auto &ws : clients) {
+			if (!ws->isOpen())
+				continue;
+
+			binary message(size, byte(0xA5));
+			const int64_t now = duration_cast<chrono::microseconds>(
+			                        steady_clock::now().time_since_epoch())
+			                        .count();
+			std::memcpy(message.data(), &now, sizeof(now));
+			ws->send(std::move(message));
+		}
+
+		this_thread::sleep_for(duration);
+		state->running = false;
+		const auto echoDuration = duration_cast<milliseconds>(steady_clock::now() - echoStartTime);
+		const size_t echoed = state->echoed;
+		this_thread::sleep_for(500ms); // let in-flight messages drain
+
+		vector<int64_t> sortedRtts;
+		{
+			std::lock_guard lock(state->mutex);
+			sortedRtts = state->rtts;
+		}
+		std::sort(sortedRtts.begin(), sortedRtts.end());
+		const double rate = double(echoed) * 1000. / double(echoDuration.count());
+
+		cerr << "Echo size " << size << ": " << int64_t(rate) << " messages/s, "
+		     << int64_t(rate * double(size) * 8 / 1000) << " kbit/s, RTT p50="
+		     << percentile(sortedRtts, 0.50) << "us p99=" << percentile(sortedRtts, 0.99) << "us"
+		     << endl;
+
+		if (json)
+			cout << (i > 0 ? ", " : "") << "{\"size\": " << size
+			     << ", \"messages_per_second\": " << int64_t(rate)
+			     << ", \"rtt_p50_us\": " << percentile(sortedRtts, 0.50)
+			     << ", \"rtt_p90_us\": " << percentile(sortedRtts, 0.90)
+			     << ", \"rtt_p99_us\": " << percentile(sortedRtts, 0.99) << "}";
+	}
+
+	if (json)
+		cout << "]}" << endl;
+
+	for (auto &ws : clients)
+		ws->close();
+
+	this_thread::sleep_for(1s);
+	clients.clear();
+	server.stop();
+	{
+		std::lock_guard lock(serverMutex);
+		serverClients.clear();
+	}
+
+	rtc::Cleanup();
+}
+
+#endif
+
+#if RTC_ENABLE_MEDIA
+
+// Counts incoming RTP packets and reports the end of frames from the marker bit
+class PacketCounter final : public MediaHandler {
+public:
+	using frame_callback = std::function<void(uint32_t timestamp)>;
+
+	explicit PacketCounter(frame_callback onFrameEnd = nullptr)
+	    : mOnFrameEnd(std::move(onFrameEnd)) {}
+
+	void incoming(message_vector &messages,
+	              [[maybe_unused]] const message_callback &send) override {
+		for (const auto &message : messages) {
+			if (message->type == Message::Control || message->size() < sizeof(RtpHeader))
+				continue;
+
+			++packets;
+			bytes += message->size();
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			if (mOnFrameEnd && rtp->marker())
+				mOnFrameEnd(rtp->timestamp());
+		}
+	}
+
+	atomic<uint64_t> packets = 0;
+	atomic<uint64_t> bytes = 0;
+
+private:
+	const frame_callback mOnFrameEnd;
+};
+
+struct MediaResult {
+	string codec;
+	uint64_t sentFrames = 0;
+	uint64_t receivedFrames = 0;
+	uint64_t receivedPackets = 0;
+	double framesPerSecond = 0;
+	double packetsPerSecond = 0;
+	double bitrate = 0;        // Mbit/s
+	double cpuMsPerMbit = 0;   // process CPU time
+	vector<int64_t> latencies; // microseconds, sorted
+};
+
+void appendNalUnit(binary &frame, std::initializer_list<uint8_t> header, size_t size) {
+	for (uint8_t b : {0x00, 0x00, 0x00, 0x01})
+		frame.push_back(byte(b));
+	for (uint8_t b : header)
+		frame.push_back(byte(b));
+	frame.insert(frame.end(), size - header.size(), byte(0xA5)); // no start sequence
+}
+
+// Synthetic frames, with a keyframe 4 times larger every 30 frames
+binary makeFrame(const string &codec, uint64_t index, size_t size) {
+	const bool keyframe = index % 30 == 0;
+	if (keyframe)
+		size *= 4;
+
+	binary frame;
+	if (codec == "h264") {
+		if (keyframe) {
+			appendNalUnit(frame, {0x67}, 16);   // SPS
+			appendNalUnit(frame, {0x68}, 8);    // PPS
+			appendNalUnit(frame, {0x65}, size); // IDR slice
+		} else {
+			appendNalUnit(frame, {0x41}, size); // non-IDR slice
+		}
+	} else if (codec == "av1") {
+		frame.push_back(byte(0x12)); // temporal delimiter with size field
+		frame.push_back(byte(0x00));
+		frame.push_back(byte(0x32)); // frame OBU with size field
+		for (size_t s = size; s > 0; s >>= 7) // LEB128
+			frame.push_back(byte((s & 0x7F) | (s > 0x7F ? 0x80 : 0x00)));
+		frame.insert(frame.end(), size, byte(0xA5));
+	} else {
+		frame.resize(160, byte(0xA5)); // 20 ms of Opus at 64 kbit/s
+	}
+	return frame;
+}
+
+// Pushes frames through Track::sendFrame with a full handler chain over a loopback connection
+MediaResult benchmarkMediaCodec(const string &codec, milliseconds duration) {
+	const bool audio = codec == "opus";
+	const int frameRate = audio ? 50 : 60;
+	const size_t frameSize = audio ? 160 : 20000; // about 12 Mbit/s for video
+	const uint32_t clockRate = audio ? OpusRtpPacketizer::DefaultClockRate : 90000;
+	const uint8_t payloadType = audio ? 111 : 96;
+	const SSRC ssrc = 42;
+
+	PeerConnection pc1(benchmarkConfiguration());
+	PeerConnection pc2(benchmarkConfiguration());
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+
+	std::mutex mutex;
+	std::unordered_map<uint32_t, steady_clock::time_point> sendTimes; // by RTP timestamp
+	vector<int64_t> latencies;
+	atomic<uint64_t> receivedFrames = 0;
+	auto onFrameEnd = [&](uint32_t timestamp) {
+		const auto now = steady_clock::now();
+		std::lock_guard lock(mutex);
+		if (auto it = sendTimes.find(timestamp); it != sendTimes.end()) {
+			latencies.push_back(
+			    chrono::duration_cast<chrono::microseconds>(now - it->second).count());
+			sendTimes.erase(it);
+			++receivedFrames;
+		}
+	};
+
+	// AV1 has no depacketizer, so frames are detected from the marker bit
+	auto counter = make_shared<PacketCounter>(
+	    codec == "av1" ? PacketCounter::frame_callback(onFrameEnd) : nullptr);
+	shared_ptr<Track> remoteTrack;
+	pc2.onTrack([&](shared_ptr<Track> track) {
+		// Incoming messages go through the chain from the last handler, so the counter is chained
+		// after the depacketizer to count packets before they are assembled into frames
+		if (codec == "h264")
+			track->setMediaHandler(make_shared<H264RtpDepacketizer>());
+		else if (audio)
+			track->setMediaHandler(make_shared<OpusRtpDepacketizer>());
+
+		track->chainMediaHandler(counter);
+		track->chainMediaHandler(make_shared<RtcpReceivingSession>());
+		track->onFrameView([&onFrameEnd](shared_ptr<const Message> frame) {
+			onFrameEnd(frame->frameInfo->timestamp);
+		});
+		std::atomic_store(&remoteTrack, track);
+	});
+
+	shared_ptr<Track> track;
+	auto config = make_shared<RtpPacketizationConfig>(ssrc, "benchmark", payloadType, clockRate);
+	if (audio) {
+		Description::Audio media("audio", Description::Direction::SendOnly);
+		media.addOpusCodec(payloadType);
+		media.addSSRC(ssrc, "benchmark");
+		track = pc1.addTrack(media);
+		track->setMediaHandler(make_shared<OpusRtpPacketizer>(config));
+	} else {
+		Description::Video media("video", Description::Direction::SendOnly);
+		if (codec == "h264")
+			media.addH264Codec(payloadType);
+		else
+			media.addAV1Codec(payloadType);
+		media.addSSRC(ssrc, "benchmark");
+		track = pc1.addTrack(media);
+		if (codec == "h264")
+			track->setMediaHandler(make_shared<H264RtpPacketizer>(
+			    NalUnit::Separator::LongStartSequence, config));
+		else
+			track->setMediaHandler(make_shared<AV1RtpPacketizer>(
+			    AV1RtpPacketizer::Packetization::TemporalUnit, config));
+	}
+	track->chainMediaHandler(make_shared<RtcpSrReporter>(config));
+	track->chainMediaHandler(make_shared<RtcpNackResponder>());
+	track->chainMediaHandler(make_shared<PacingHandler>(100e6, 5ms));
+
+	pc1.setLocalDescription();
+
+	int attempts = 100;
+	shared_ptr<Track> remote;
+	while ((!(remote = std::atomic_load(&remoteTrack)) || !remote->isOpen() || !track->isOpen()) &&
+	       attempts--)
+		this_thread::sleep_for(100ms);
+
+	if (!remote || !remote->isOpen() || !track->isOpen())
+		throw runtime_error("Track is not open");
+
+	const uint32_t timestampStep = clockRate / uint32_t(frameRate);
+	const auto frameInterval = chrono::duration_cast<steady_clock::duration>(1s) / frameRate;
+	const std::clock_t startCpu = std::clock();
+	const auto startTime = steady_clock::now();
+	const auto endTime = startTime + duration;
+	uint64_t sentFrames = 0;
+	for (auto next = startTime; next < endTime; next += frameInterval) {
+		this_thread::sleep_until(next);
+		const uint32_t timestamp = uint32_t(sentFrames) * timestampStep;
+		auto frame = makeFrame(codec, sentFrames, frameSize);
+		{
+			std::lock_guard lock(mutex);
+			sendTimes[timestamp] = steady_clock::now();
+		}
+		track->sendFrame(std::move(frame), FrameInfo(timestamp));
+		++sentFrames;
+	}
+
+	this_thread::sleep_for(500ms); // let the last frames arrive
+	const double cpuMs = 1000.0 * double(std::clock() - startCpu) / CLOCKS_PER_SEC;
+	const double seconds = chrono::duration<double>(steady_clock::now() - startTime).count();
+
+	MediaResult result;
+	result.codec = codec;
+	result.sentFrames = sentFrames;
+	result.receivedFrames = receivedFrames.load();
+	result.receivedPackets = counter->packets.load();
+	result.framesPerSecond = double(result.receivedFrames) / seconds;
+	result.packetsPerSecond = double(result.receivedPackets) / seconds;
+	result.bitrate = double(counter->bytes.load()) * 8 / seconds / 1e6;
+	result.cpuMsPerMbit = result.bitrate > 0 ? cpuMs / (result.bitrate * seconds) : 0;
+	{
+		std::lock_guard lock(mutex);
+		result.latencies = latencies;
+	}
+	std::sort(result.latencies.begin(), result.latencies.end());
+
+	track->close();
+	pc1.close();
+	pc2.close();
+	return result;
+}
+
+void benchmarkMedia(milliseconds duration, bool json) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	vector<MediaResult> results;
+	for (const string codec : {"h264", "av1", "opus"}) {
+		auto r = benchmarkMediaCodec(codec, duration);
+		cerr << "Media " << r.codec << ": " << r.receivedFrames << "/" << r.sentFrames
+		     << " frames, " << r.framesPerSecond << " frames/s, " << r.packetsPerSecond
+		     << " packets/s, " << r.bitrate << " Mbit/s, " << r.cpuMsPerMbit
+		     << " CPU ms/Mbit, frame latency p50=" << percentile(r.latencies, 0.50)
+		     << "us p99=" << percentile(r.latencies, 0.99) << "us" << endl;
+		results.push_back(std::move(r));
+	}
+
+	if (json) {
+		cout << "{\n  \"benchmarks\": [";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const auto &r = results[i];
+			cout << (i > 0 ? "," : "") << "\n    {\"codec\": \"" << r.codec
+			     << "\", \"sent_frames\": " << r.sentFrames
+			     << ", \"received_frames\": " << r.receivedFrames
+			     << ", \"frames_per_second\": " << r.framesPerSecond
+			     << ", \"packets_per_second\": " << r.packetsPerSecond
+			     << ", \"bitrate_mbps\": " << r.bitrate
+			     << ", \"cpu_ms_per_mbit\": " << r.cpuMsPerMbit
+			     << ", \"latency_p50_us\": " << percentile(r.latencies, 0.50)
+			     << ", \"latency_p90_us\": " << percentile(r.latencies, 0.90)
+			     << ", \"latency_p99_us\": " << percentile(r.latencies, 0.99) << "}";
+		}
+		cout << "\n  ]\n}" << endl;
+	}
+
+	rtc::Cleanup();
+}
+
+#endif
+
 #ifdef BENCHMARK_MAIN
 int main(int argc, char **argv) {
 	try {
+		const vector<string> args(argv + 1, argv + argc);
+		auto hasArg = [&args](const string &arg) {
+			return std::find(args.begin(), args.end(), arg) != args.end();
+		};
+
+		if (auto it = std::find(args.begin(), args.end(), "--impair"); it != args.end()) {
+			if (it + 1 == args.end())
+				throw invalid_argument("Missing value for --impair");
+
+			Impairment = parseImpairment(*(it + 1));
+		}
+
+		if (hasArg("--matrix")) {
+			// Machine-readable results are written to stdout with --json
+			benchmarkMatrix(2s, hasArg("--latency"), hasArg("--json"));
+			return 0;
+		}
+
+		if (hasArg("--short")) {
+			benchmarkShort(3s, hasArg("--json"));
+			return 0;
+		}
+
+		if (hasArg("--scale")) {
+			// Pass the number of pairs as the next argument, or several sizes are run
+			auto it = std::find(args.begin(), args.end(), "--scale");
+			vector<size_t> counts = {1000, 5000, 10000};
+			if (it + 1 != args.end() && std::isdigit(static_cast<unsigned char>((*(it + 1))[0])))
+				counts = {size_t(std::stoul(*(it + 1)))};
+
+			for (size_t count : counts)
+				benchmarkScale(count, hasArg("--json"));
+
+			return 0;
+		}
+
+#if RTC_ENABLE_WEBSOCKET
+		if (hasArg("--websocket")) {
+			// Pass the number of clients as the next argument, TLS is enabled with --tls
+			auto it = std::find(args.begin(), args.end(), "--websocket");
+			size_t count = 1000;
+			if (it + 1 != args.end() && std::isdigit(static_cast<unsigned char>((*(it + 1))[0])))
+				count = size_t(std::stoul(*(it + 1)));
+
+			benchmarkWebSocket(count, hasArg("--tls"), hasArg("--json"));
+			return 0;
+		}
+#endif
+
+#if RTC_ENABLE_MEDIA
+		if (hasArg("--media")) {
+			benchmarkMedia(10s, hasArg("--json"));
+			return 0;
+		}
+#endif
+
 		size_t goodput = benchmark(30s);
 		if (goodput == 0)
 			throw runtime_error("No data received");
 
+		if (argc > 1 && string(argv[1]) == "--sctp-profiles")
+			benchmarkSctpProfiles(30s);
+
+		if (argc > 1 && string(argv[1]) == "--sdp")
+			benchmarkDescription(5s);
+
+		if (argc > 1 && string(argv[1]) == "--file") {
+			// Compare with the goodput of a bare send loop above
+			benchmarkFileTransfer(256 * 1024 * 1024, 1);
+			benchmarkFileTransfer(256 * 1024 * 1024, 4);
+		}
+
 		return 0;
 
 	} catch (const std::exception &e) {
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "impl/channel.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+// Channel without messages, only its buffered amount accounting is used
+struct TestChannel final : impl::Channel {
+	optional<message_variant> receive() override { return nullopt; }
+	optional<message_variant> peek() override { return nullopt; }
+	optional<message_ptr> receiveMessage() override { return nullopt; }
+	optional<message_ptr> peekMessage() override { return nullopt; }
+	size_t availableAmount() const override { return 0; }
+};
+
+const int ThreadsCount = 8;
+const int UpdatesCount = 10000;
+
+// Applies the delta concurrently from several threads, as parallel sends would
+void updateConcurrently(impl::Channel &channel, ptrdiff_t delta) {
+	vector<thread> threads;
+	for (int i = 0; i < ThreadsCount; ++i)
+		threads.emplace_back([&channel, delta]() {
+			for (int j = 0; j < UpdatesCount; ++j)
+				channel.updateBufferedAmount(delta);
+		});
+
+	for (auto &t : threads)
+		t.join();
+}
+
+} // namespace
+
+TestResult test_buffered_amount() {
+	try {
+		// Concurrent updates are not lost, and the callback fires once on the crossing
+		{
+			TestChannel channel;
+			std::atomic<int> lowCount = 0;
+			channel.bufferedAmountLowThreshold = 1000;
+			channel.bufferedAmountLowCallback = [&lowCount]() { ++lowCount; };
+
+			updateConcurrently(channel, 100);
+			if (channel.bufferedAmount != size_t(ThreadsCount * UpdatesCount * 100))
+				return TestResult(false, "Concurrent increases lost");
+
+			if (lowCount != 0)
+				return TestResult(false, "Callback fired while increasing");
+
+			updateConcurrently(channel, -100);
+			if (channel.bufferedAmount != 0)
+				return TestResult(false, "Concurrent decreases lost");
+
+			if (lowCount != 1)
+				return TestResult(false, "Callback not fired exactly once on the crossing");
+		}
+
+		// Interleaved increases and decreases keep the balance, and crossing again fires again
+		{
+			TestChannel channel;
+			std::atomic<int> lowCount = 0;
+			channel.bufferedAmountLowCallback = [&lowCount]() { ++lowCount; };
+			channel.updateBufferedAmount(ptrdiff_t(ThreadsCount) * UpdatesCount);
+
+			vector<thread> threads;
+			for (int i = 0; i < ThreadsCount; ++i)
+				threads.emplace_back([&channel, i]() {
+					for (int j = 0; j < UpdatesCount; ++j)
+						channel.updateBufferedAmount(i % 2 == 0 ? 3 : -1);
+				});
+
+			for (auto &t : threads)
+				t.join();
+
+			const size_t expected = size_t(ThreadsCount) * UpdatesCount * 2;
+			if (channel.bufferedAmount != expected || lowCount != 0)
+				return TestResult(false, "Wrong amount after interleaved updates");
+
+			channel.updateBufferedAmount(-ptrdiff_t(expected));
+			channel.updateBufferedAmount(10);
+			channel.updateBufferedAmount(-10);
+			if (channel.bufferedAmount != 0 || lowCount != 2)
+				return TestResult(false, "Callback not fired on each crossing");
+		}
+
+		// The amount never goes below zero
+		{
+			TestChannel channel;
+			channel.updateBufferedAmount(10);
+			channel.updateBufferedAmount(-20);
+			if (channel.bufferedAmount != 0)
+				return TestResult(false, "Buffered amount went below zero");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+TestResult test_candidate_batches() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	// Batches are counted, and must all be passed before gathering is complete
+	struct Counters {
+		std::atomic<int> batches = 0;
+		std::atomic<int> candidates = 0;
+		std::atomic<bool> empty = false;
+		std::atomic<bool> late = false;
+		std::atomic<bool> complete = false;
+		std::atomic<bool> single = false;
+	};
+	Counters counters1, counters2;
+
+	auto wire = [](PeerConnection &local, PeerConnection &remote, Counters &counters) {
+		local.onLocalDescription([&remote](Description sdp) { remote.setRemoteDescription(sdp); });
+
+		// The batched callback takes precedence, so the single one is never called
+		local.onLocalCandidate([&counters](Candidate) { counters.single = true; });
+		local.onLocalCandidates([&remote, &counters](vector<Candidate> candidates) {
+			if (candidates.empty())
+				counters.empty = true;
+
+			if (counters.complete)
+				counters.late = true;
+
+			++counters.batches;
+			counters.candidates += int(candidates.size());
+			remote.addRemoteCandidates(std::move(candidates));
+		});
+
+		local.onGatheringStateChange([&counters](PeerConnection::GatheringState state) {
+			if (state == PeerConnection::GatheringState::Complete)
+				counters.complete = true;
+		});
+	};
+	wire(pc1, pc2, counters1);
+	wire(pc2, pc1, counters2);
+
+	shared_ptr<DataChannel> dc2;
+	std::atomic<bool> received = false;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		dc->onMessage([&received](message_variant) { received = true; });
+		std::atomic_store(&dc2, dc);
+	});
+
+	auto dc1 = pc1.createDataChannel("test");
+
+	int attempts = 10;
+	while ((!dc1->isOpen() || !counters1.complete || !counters2.complete) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!dc1->isOpen() || pc1.state() != PeerConnection::State::Connected ||
+	    pc2.state() != PeerConnection::State::Connected)
+		return TestResult(false, "PeerConnection is not connected with batched candidates");
+
+	if (!counters1.complete || !counters2.complete)
+		return TestResult(false, "Gathering not complete");
+
+	dc1->send("hello");
+	attempts = 10;
+	while (!received && attempts--)
+		this_thread::sleep_for(100ms);
+
+	if (!received)
+		return TestResult(false, "Message not received");
+
+	for (const auto *counters : {&counters1, &counters2}) {
+		if (counters->batches == 0 || counters->candidates == 0)
+			return TestResult(false, "No local candidate batch");
+
+		if (counters->empty)
+			return TestResult(false, "Empty local candidate batch");
+
+		if (counters->late)
+			return TestResult(false, "Local candidate batch after gathering was complete");
+
+		if (counters->single)
+			return TestResult(false, "Single candidate callback called with a batched one");
+	}
+
+	// Candidates gathered at about the same time are batched
+	if (counters1.batches >= counters1.candidates && counters2.batches >= counters2.candidates &&
+	    counters1.candidates + counters2.candidates > 2)
+		return TestResult(false, "Local candidates not batched");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	// Once closed, there is no transport to add remote candidates to
+	bool thrown = false;
+	try {
+		pc1.addRemoteCandidates(
+		    {Candidate("a=candidate:1 1 UDP 2122317823 127.0.0.1 40000 typ host", "0")});
+	} catch (const std::logic_error &) {
+		thrown = true;
+	}
+	if (!thrown)
+		return TestResult(false, "Remote candidates added after close");
+
+	return TestResult(true);
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/candidatepaircache.hpp"
+
+#include <string>
+
+using namespace rtc;
+using namespace std;
+
+using impl::CandidatePairCache;
+
+namespace {
+
+Candidate makeCandidate(const string &address, uint16_t port, const string &type = "host",
+                        const string &transport = "UDP") {
+	string sdp = "candidate:1 1 " + transport + " 2122260223 " + address + ' ' + to_string(port) +
+	             " typ " + type;
+	if (type == "relay" || type == "srflx")
+		sdp += " raddr 0.0.0.0 rport 0";
+	if (transport == "TCP")
+		sdp += " tcptype passive";
+
+	Candidate candidate(std::move(sdp));
+	candidate.resolve(Candidate::ResolveMode::Simple);
+	return candidate;
+}
+
+bool matches(const optional<Candidate> &candidate, const string &address, uint16_t port) {
+	return candidate && candidate->isResolved() && candidate->address() == address &&
+	       candidate->port() == port;
+}
+
+} // namespace
+
+TestResult test_candidate_pair_cache() {
+	auto &cache = CandidatePairCache::Instance();
+	cache.clear();
+
+	try {
+		if (cache.retrieve("unknown"))
+			return TestResult(false, "Unknown key retrieved");
+
+		// The stored remote candidate is retrieved with the highest priority
+		cache.store("peer", makeCandidate("192.0.2.1", 5000));
+		auto cached = cache.retrieve("peer");
+		if (!matches(cached, "192.0.2.1", 5000) || cached->type() != Candidate::Type::Host ||
+		    cached->transportType() != Candidate::TransportType::Udp ||
+		    cached->priority() != 0x7FFFFFFF)
+			return TestResult(false, "Wrong cached candidate");
+
+		cache.store("peer", makeCandidate("2001:db8::1", 6000, "srflx"));
+		cached = cache.retrieve("peer");
+		if (!matches(cached, "2001:db8::1", 6000) ||
+		    cached->type() != Candidate::Type::ServerReflexive)
+			return TestResult(false, "Cached candidate not replaced");
+
+		// Relayed, TCP, or unresolved candidates are not stored and clear the entry
+		cache.store("peer", makeCandidate("192.0.2.2", 5000, "relay"));
+		if (cache.retrieve("peer"))
+			return TestResult(false, "Relayed candidate cached");
+
+		cache.store("peer", makeCandidate("192.0.2.1", 5000));
+		cache.store("peer", makeCandidate("192.0.2.1", 5000, "host", "TCP"));
+		if (cache.retrieve("peer"))
+			return TestResult(false, "TCP candidate cached");
+
+		cache.store("peer", makeCandidate("192.0.2.1", 5000));
+		cache.store("peer", Candidate("candidate:1 1 UDP 1 example.invalid 5000 typ host"));
+		if (cache.retrieve("peer"))
+			return TestResult(false, "Unresolved candidate cached");
+
+		// Entries are erased
+		cache.store("peer", makeCandidate("192.0.2.1", 5000));
+		cache.erase("peer");
+		if (cache.retrieve("peer"))
+			return TestResult(false, "Entry not erased");
+
+		// The least recently used entry is evicted beyond 1024 entries
+		const int count = 1024;
+		for (int i = 0; i < count; ++i)
+			cache.store("peer" + to_string(i), makeCandidate("192.0.2.1", uint16_t(10000 + i)));
+
+		if (!matches(cache.retrieve("peer0"), "192.0.2.1", 10000)) // now most recently used
+			return TestResult(false, "Entry evicted before the cache is full");
+
+		cache.store("new", makeCandidate("192.0.2.3", 5000));
+		if (cache.retrieve("peer1") || !cache.retrieve("peer0") || !cache.retrieve("peer2") ||
+		    !matches(cache.retrieve("new"), "192.0.2.3", 5000))
+			return TestResult(false, "Wrong entry evicted");
+
+		cache.clear();
+		if (cache.retrieve("peer0") || cache.retrieve("new"))
+			return TestResult(false, "Cache not cleared");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		cache.clear();
+		return TestResult(false, e.what());
+	}
+}
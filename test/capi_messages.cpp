@@ -0,0 +1,288 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "test.hpp"
+#include <rtc/rtc.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+static void sleep(unsigned int secs) { Sleep(secs * 1000); }
+#else
+#include <unistd.h> // for sleep
+#endif
+
+typedef struct {
+	int pc;
+	int dc;
+	bool connected;
+} Peer;
+
+static Peer *peer1 = NULL;
+static Peer *peer2 = NULL;
+
+static void RTC_API descriptionCallback(int pc, const char *sdp, const char *type, void *ptr) {
+	Peer *other = (Peer *)ptr == peer1 ? peer2 : peer1;
+	rtcSetRemoteDescription(other->pc, sdp, type);
+}
+
+static void RTC_API candidateCallback(int pc, const char *cand, const char *mid, void *ptr) {
+	Peer *other = (Peer *)ptr == peer1 ? peer2 : peer1;
+	rtcAddRemoteCandidate(other->pc, cand, mid);
+}
+
+static void RTC_API openCallback(int id, void *ptr) {
+	Peer *peer = (Peer *)ptr;
+	peer->connected = true;
+}
+
+static void RTC_API dataChannelCallback(int pc, int dc, void *ptr) {
+	Peer *peer = (Peer *)ptr;
+	// No message callback, so messages are queued for rtcReceiveMessages()
+	rtcSetOpenCallback(dc, openCallback);
+	peer->dc = dc;
+	peer->connected = true;
+}
+
+static Peer *createPeer() {
+	Peer *peer = (Peer *)malloc(sizeof(Peer));
+	if (!peer)
+		return nullptr;
+	memset(peer, 0, sizeof(Peer));
+
+	rtcConfiguration config;
+	memset(&config, 0, sizeof(config));
+	peer->pc = rtcCreatePeerConnection(&config);
+	rtcSetUserPointer(peer->pc, peer);
+	rtcSetDataChannelCallback(peer->pc, dataChannelCallback);
+	rtcSetLocalDescriptionCallback(peer->pc, descriptionCallback);
+	rtcSetLocalCandidateCallback(peer->pc, candidateCallback);
+	return peer;
+}
+
+static void deletePeer(Peer *peer) {
+	if (peer) {
+		if (peer->dc)
+			rtcDeleteDataChannel(peer->dc);
+		if (peer->pc)
+			rtcDeletePeerConnection(peer->pc);
+		free(peer);
+	}
+}
+
+static bool waitAvailable(int dc, int amount) {
+	int attempts = 10;
+	while (rtcGetAvailableAmount(dc) < amount && attempts--)
+		sleep(1);
+
+	return rtcGetAvailableAmount(dc) >= amount;
+}
+
+static bool connectPeers() {
+	rtcInitLogger(RTC_LOG_DEBUG, nullptr);
+
+	peer1 = createPeer();
+	peer2 = createPeer();
+	if (!peer1 || !peer2)
+		return false;
+
+	peer1->dc = rtcCreateDataChannel(peer1->pc, "test");
+	rtcSetOpenCallback(peer1->dc, openCallback);
+
+	int attempts = 10;
+	while ((!peer1->connected || !peer2->connected || !rtcIsOpen(peer2->dc)) && attempts--)
+		sleep(1);
+
+	if (!peer1->connected || !peer2->connected || !rtcIsOpen(peer2->dc)) {
+		fprintf(stderr, "DataChannel is not connected\n");
+		return false;
+	}
+
+	return true;
+}
+
+static int test_capi_messages_main() {
+	char storage[4][16];
+	rtcMessageBuffer buffers[4];
+	int count;
+
+	if (!connectPeers())
+		goto error;
+
+	// Null pointers are rejected
+	if (rtcSendMessages(peer1->dc, NULL, NULL, 1) != RTC_ERR_INVALID ||
+	    rtcSendMessageBuffers(peer1->dc, NULL, 1) != RTC_ERR_INVALID ||
+	    rtcReceiveMessages(peer2->dc, NULL, 1) != RTC_ERR_INVALID) {
+		fprintf(stderr, "Null pointers not rejected\n");
+		goto error;
+	}
+
+	// Negative sizes indicate null-terminated strings, like rtcSendMessage()
+	{
+		const char *data[3] = {"one", "\x01\x02\x03\x04", "three"};
+		const int sizes[3] = {-1, 4, -1};
+		if (rtcSendMessages(peer1->dc, data, sizes, 3) != RTC_ERR_SUCCESS) {
+			fprintf(stderr, "rtcSendMessages failed\n");
+			goto error;
+		}
+
+		char binary[2] = {'\x05', '\x06'};
+		rtcMessageBuffer sent[2] = {{binary, 2}, {(char *)"four", -1}};
+		if (rtcSendMessageBuffers(peer1->dc, sent, 2) != RTC_ERR_SUCCESS) {
+			fprintf(stderr, "rtcSendMessageBuffers failed\n");
+			goto error;
+		}
+	}
+
+	if (!waitAvailable(peer2->dc, 3 + 4 + 5 + 2 + 4)) {
+		fprintf(stderr, "Messages not received\n");
+		goto error;
+	}
+
+	// A first buffer too small fails and reports the required size
+	buffers[0].data = storage[0];
+	buffers[0].size = 3;
+	if (rtcReceiveMessages(peer2->dc, buffers, 1) != RTC_ERR_TOO_SMALL || buffers[0].size != -4) {
+		fprintf(stderr, "rtcReceiveMessages did not fail with a buffer too small\n");
+		goto error;
+	}
+
+	// Reception stops at the first message not fitting its buffer
+	for (int i = 0; i < 4; ++i) {
+		buffers[i].data = storage[i];
+		buffers[i].size = i == 2 ? 4 : 16;
+	}
+	count = rtcReceiveMessages(peer2->dc, buffers, 4);
+	if (count != 2 || buffers[0].size != -4 || strcmp(storage[0], "one") != 0 ||
+	    buffers[1].size != 4 || memcmp(storage[1], "\x01\x02\x03\x04", 4) != 0) {
+		fprintf(stderr, "rtcReceiveMessages returned wrong messages\n");
+		goto error;
+	}
+
+	for (int i = 0; i < 4; ++i) {
+		buffers[i].data = storage[i];
+		buffers[i].size = 16;
+	}
+	count = rtcReceiveMessages(peer2->dc, buffers, 4);
+	if (count != 3 || buffers[0].size != -6 || strcmp(storage[0], "three") != 0 ||
+	    buffers[1].size != 2 || memcmp(storage[1], "\x05\x06", 2) != 0 ||
+	    buffers[2].size != -5 || strcmp(storage[2], "four") != 0) {
+		fprintf(stderr, "rtcReceiveMessages returned wrong messages\n");
+		goto error;
+	}
+
+	if (rtcReceiveMessages(peer2->dc, buffers, 4) != RTC_ERR_NOT_AVAIL ||
+	    rtcReceiveMessages(peer2->dc, buffers, 0) != 0) {
+		fprintf(stderr, "rtcReceiveMessages returned messages from an empty queue\n");
+		goto error;
+	}
+
+	deletePeer(peer1);
+	sleep(1);
+	deletePeer(peer2);
+	sleep(1);
+
+	printf("Success\n");
+	return 0;
+
+error:
+	deletePeer(peer1);
+	deletePeer(peer2);
+	return -1;
+}
+
+static int test_capi_opaque_messages_main() {
+	rtcMessage *message = NULL;
+	rtcMessageView *view = NULL;
+
+	if (!connectPeers())
+		goto error;
+
+	if (rtcReceiveOpaqueMessage(peer2->dc, NULL) != RTC_ERR_INVALID ||
+	    rtcReceiveMessageView(peer2->dc, NULL) != RTC_ERR_INVALID ||
+	    rtcReceiveOpaqueMessage(peer2->dc, &message) != RTC_ERR_NOT_AVAIL ||
+	    rtcReceiveMessageView(peer2->dc, &view) != RTC_ERR_NOT_AVAIL) {
+		fprintf(stderr, "Wrong results without messages\n");
+		goto error;
+	}
+
+	rtcSendMessage(peer1->dc, "\x01\x02\x03", 3);
+	rtcSendMessage(peer1->dc, "hello", -1);
+	rtcSendMessage(peer1->dc, "\x04\x05", 2);
+	if (!waitAvailable(peer2->dc, 3 + 5 + 2)) {
+		fprintf(stderr, "Messages not received\n");
+		goto error;
+	}
+
+	// Opaque messages own the received data, and strings are not null-terminated
+	if (rtcReceiveOpaqueMessage(peer2->dc, &message) != RTC_ERR_SUCCESS ||
+	    rtcGetOpaqueMessageSize(message) != 3 || rtcIsOpaqueMessageString(message) ||
+	    memcmp(rtcGetOpaqueMessageData(message), "\x01\x02\x03", 3) != 0) {
+		fprintf(stderr, "Wrong binary opaque message\n");
+		goto error;
+	}
+	rtcDeleteOpaqueMessage(message);
+
+	if (rtcReceiveOpaqueMessage(peer2->dc, &message) != RTC_ERR_SUCCESS ||
+	    rtcGetOpaqueMessageSize(message) != 5 || !rtcIsOpaqueMessageString(message) ||
+	    memcmp(rtcGetOpaqueMessageData(message), "hello", 5) != 0) {
+		fprintf(stderr, "Wrong string opaque message\n");
+		goto error;
+	}
+	rtcDeleteOpaqueMessage(message);
+	message = NULL;
+
+	// Views reference the received data until released
+	if (rtcReceiveMessageView(peer2->dc, &view) != RTC_ERR_SUCCESS ||
+	    rtcGetMessageViewSize(view) != 2 || rtcIsMessageViewString(view) ||
+	    memcmp(rtcGetMessageViewData(view), "\x04\x05", 2) != 0) {
+		fprintf(stderr, "Wrong message view\n");
+		goto error;
+	}
+	rtcReleaseMessageView(view);
+	view = NULL;
+
+	if (rtcGetOpaqueMessageSize(NULL) != RTC_ERR_INVALID || rtcGetMessageViewSize(NULL) >= 0 ||
+	    rtcGetOpaqueMessageData(NULL) || rtcGetMessageViewData(NULL)) {
+		fprintf(stderr, "Null messages not rejected\n");
+		goto error;
+	}
+
+	if (rtcGetAvailableAmount(peer2->dc) != 0) {
+		fprintf(stderr, "Messages left after reception\n");
+		goto error;
+	}
+
+	deletePeer(peer1);
+	sleep(1);
+	deletePeer(peer2);
+	sleep(1);
+
+	printf("Success\n");
+	return 0;
+
+error:
+	deletePeer(peer1);
+	deletePeer(peer2);
+	return -1;
+}
+
+TestResult test_capi_messages() {
+	if (test_capi_messages_main())
+		return TestResult(false, "Vectored messages failed");
+	return TestResult(true);
+}
+
+TestResult test_capi_opaque_messages() {
+	if (test_capi_opaque_messages_main())
+		return TestResult(false, "Opaque messages failed");
+	return TestResult(true);
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+TestResult test_coalescing() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	std::mutex mutex;
+	vector<message_variant> received;
+	shared_ptr<DataChannel> dc2;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		dc->onMessage([&](message_variant message) {
+			std::lock_guard lock(mutex);
+			received.push_back(std::move(message));
+		});
+		std::atomic_store(&dc2, dc);
+	});
+
+	DataChannelInit init;
+	init.coalescingWindow = 500ms;
+	auto dc1 = pc1.createDataChannel("test", init);
+
+	std::atomic<int> lowCount = 0;
+	dc1->onBufferedAmountLow([&lowCount]() { ++lowCount; });
+
+	int attempts = 10;
+	shared_ptr<DataChannel> adc2;
+	while ((!(adc2 = std::atomic_load(&dc2)) || !adc2->isOpen() || !dc1->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!adc2 || !adc2->isOpen() || !dc1->isOpen())
+		return TestResult(false, "DataChannel is not open");
+
+	// Small messages are held during the window, and counted in the buffered amount
+	vector<message_variant> messages;
+	size_t expectedAmount = 0;
+	for (int i = 0; i < 10; ++i) {
+		if (i % 2) {
+			messages.emplace_back(string("message ") + to_string(i));
+			expectedAmount += std::get<string>(messages.back()).size() + 3;
+		} else {
+			messages.emplace_back(binary(20, byte(i)));
+			expectedAmount += std::get<binary>(messages.back()).size() + 3;
+		}
+		dc1->send(messages.back());
+	}
+
+	if (dc1->bufferedAmount() != expectedAmount)
+		return TestResult(false, "Wrong buffered amount for coalesced messages, expected " +
+		                             to_string(expectedAmount) + ", got " +
+		                             to_string(dc1->bufferedAmount()));
+
+	{
+		std::lock_guard lock(mutex);
+		if (!received.empty())
+			return TestResult(false, "Coalesced messages received before the end of the window");
+	}
+
+	// They are unpacked on the remote side, in order and with their type
+	attempts = 20;
+	while (attempts--) {
+		{
+			std::lock_guard lock(mutex);
+			if (received.size() >= messages.size())
+				break;
+		}
+		this_thread::sleep_for(100ms);
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		if (received != messages)
+			return TestResult(false, "Wrong coalesced messages received");
+	}
+
+	if (dc1->bufferedAmount() != 0 || lowCount != 1)
+		return TestResult(false, "Buffered amount not back to zero after coalesced messages");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
@@ -11,6 +11,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -28,6 +29,20 @@ TestResult test_connectivity() { return test_connectivity(false); }
 
 TestResult test_connectivity_fail_on_wrong_fingerprint() { return test_connectivity(true); }
 
+TestResult test_connectivity_ice_threads() {
+	// The count is applied when ICE is initialized, so this must run after a cleanup. With libnice,
+	// the two agents of the connection are placed on different main loop threads.
+	SetIceThreadCount(2);
+	auto result = test_connectivity(false);
+
+	// Restore the default for the following tests
+	SetIceThreadCount(1);
+	if (Cleanup().wait_for(10s) == future_status::timeout)
+		return TestResult(false, "Cleanup timeout");
+
+	return result;
+}
+
 TestResult test_connectivity(bool signal_wrong_fingerprint) {
 	InitLogger(LogLevel::Debug);
 
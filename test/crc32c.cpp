@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/crc32c.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::crc32c;
+
+namespace {
+
+// Bitwise reference implementation
+uint32_t reference(const byte *data, size_t size) {
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < size; ++i) {
+		crc ^= to_integer<uint32_t>(data[i]);
+		for (int k = 0; k < 8; ++k)
+			crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+	}
+	return ~crc;
+}
+
+binary make_binary(const vector<uint8_t> &values) {
+	binary data;
+	for (uint8_t value : values)
+		data.push_back(byte(value));
+
+	return data;
+}
+
+} // namespace
+
+TestResult test_crc32c() {
+	try {
+		cout << "CRC32c: " << (impl::crc32c_accelerated() ? "accelerated" : "software") << endl;
+
+		// RFC 3720 B.4. CRC Examples
+		binary incrementing, decrementing;
+		for (int i = 0; i < 32; ++i) {
+			incrementing.push_back(byte(i));
+			decrementing.push_back(byte(31 - i));
+		}
+
+		const binary command = make_binary({
+		    0x01, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		    0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+		    0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x18, 0x28, 0x00, 0x00, 0x00,
+		    0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		});
+
+		const string check = "123456789";
+		const vector<pair<binary, uint32_t>> vectors = {
+		    {binary(32, byte(0x00)), 0x8A9136AA},
+		    {binary(32, byte(0xFF)), 0x62A8AB43},
+		    {incrementing, 0x46DD794E},
+		    {decrementing, 0x113FDB5C},
+		    {command, 0xD9963A56},
+		    {binary(reinterpret_cast<const byte *>(check.data()),
+		            reinterpret_cast<const byte *>(check.data()) + check.size()),
+		     0xE3069283},
+		};
+
+		for (const auto &[data, expected] : vectors)
+			if (crc32c(data.data(), data.size()) != expected ||
+			    reference(data.data(), data.size()) != expected)
+				return TestResult(false, "Wrong CRC32c for RFC 3720 example");
+
+		if (crc32c(nullptr, 0) != 0)
+			return TestResult(false, "Wrong CRC32c for empty data");
+
+		// Unaligned starts, and all lengths to cover the word loops and the tails
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<int> distribution(0, 255);
+		binary buffer(1024 + 16);
+		for (auto &b : buffer)
+			b = byte(distribution(generator));
+
+		for (size_t offset = 0; offset < 16; ++offset) {
+			for (size_t size = 0; size <= 128; ++size) {
+				const byte *data = buffer.data() + offset;
+				if (crc32c(data, size) != reference(data, size))
+					return TestResult(false, "Wrong CRC32c for unaligned data, offset=" +
+					                             to_string(offset) + ", size=" + to_string(size));
+			}
+
+			const byte *data = buffer.data() + offset;
+			if (crc32c(data, 1024) != reference(data, 1024))
+				return TestResult(false, "Wrong CRC32c for long unaligned data");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,298 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+using Dti = DecodeTargetIndication;
+
+const SSRC MediaSsrc = 42;
+const uint8_t ExtId = 5;
+
+// L1T2 structure with a template id offset of 60: the templates are a keyframe, a base layer
+// frame, and an upper temporal layer frame. Decode target 0 is the base layer, decode target 1
+// includes both layers, both are protected by chain 0. The render resolution is 640x360.
+const binary StructureDescriptor = {
+    byte(0xFC), byte(0x00), byte(0x01), byte(0x87), byte(0x81), byte(0x1E), byte(0xA8), byte(0x51),
+    byte(0x41), byte(0x01), byte(0x0C), byte(0x09), byte(0xFC), byte(0x05), byte(0x9C),
+};
+
+// Frame 2 with the upper temporal layer template, mandatory fields only
+const binary TemporalDescriptor = {byte(0xFE), byte(0x00), byte(0x02)};
+
+// Frame 3 with the base layer template, custom frame diffs 2 and 20, custom chain diff 3
+const binary CustomDescriptor = {byte(0xFD), byte(0x00), byte(0x03), byte(0x1A),
+                                 byte(0x30), byte(0x98), byte(0x06)};
+
+// Frame 4 with the keyframe template, not the end of the frame, no active decode targets
+const binary InactiveDescriptor = {byte(0xBC), byte(0x00), byte(0x04), byte(0x40)};
+
+void read(const binary &descriptor, DependencyDescriptorContext &context) {
+	DependencyDescriptorReader(descriptor.data(), descriptor.size()).readTo(context);
+}
+
+bool isTemplate(const FrameDependencyTemplate &frameTemplate, int spatialId, int temporalId,
+                const vector<Dti> &dtis, const vector<int> &frameDiffs,
+                const vector<int> &chainDiffs) {
+	return frameTemplate.spatialId == spatialId && frameTemplate.temporalId == temporalId &&
+	       frameTemplate.decodeTargetIndications == dtis &&
+	       frameTemplate.frameDiffs == frameDiffs && frameTemplate.chainDiffs == chainDiffs;
+}
+
+template <typename F> bool throwsInvalid(F &&f) {
+	try {
+		f();
+		return false;
+	} catch (const invalid_argument &) {
+		return true;
+	}
+}
+
+// RTP packet carrying the current descriptor of the context in a two-byte header extension
+message_ptr makePacket(uint16_t seqNumber, const DependencyDescriptorContext &context) {
+	DependencyDescriptorWriter writer(context);
+	binary descriptor(writer.getSize());
+	writer.writeTo(descriptor.data(), descriptor.size());
+
+	const size_t extSize = (2 + descriptor.size() + 3) / 4 * 4;
+	auto message = make_message(sizeof(RtpHeader) + sizeof(RtpExtensionHeader) + extSize + 10);
+	std::fill(message->begin(), message->end(), byte(0));
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(MediaSsrc);
+	rtp->setSeqNumber(seqNumber);
+	rtp->setTimestamp(uint32_t(context.descriptor.frameNumber) * 3000);
+	rtp->setExtension(true);
+	auto ext = rtp->getExtensionHeader();
+	ext->setProfileSpecificId(0x1000);
+	ext->setHeaderLength(uint16_t(extSize / 4));
+	ext->writeTwoByteHeader(0, ExtId, descriptor.data(), descriptor.size());
+	return message;
+}
+
+// Sends a packet for each frame, given by its template index in the structure, returns the
+// packets forwarded by the filter
+message_vector forward(SvcLayerFilter &filter, DependencyDescriptorContext &context,
+                       uint16_t &seqNumber, const vector<size_t> &templates) {
+	message_vector messages;
+	for (auto index : templates) {
+		auto &descriptor = context.descriptor;
+		descriptor.frameNumber++;
+		descriptor.structureAttached = index == 0; // with the keyframe
+		descriptor.dependencyTemplate = context.structure.templates[index];
+		messages.push_back(makePacket(seqNumber++, context));
+	}
+	filter.outgoing(messages, nullptr);
+	return messages;
+}
+
+vector<uint16_t> seqNumbers(const message_vector &messages) {
+	vector<uint16_t> result;
+	for (const auto &message : messages)
+		result.push_back(reinterpret_cast<const RtpHeader *>(message->data())->seqNumber());
+	return result;
+}
+
+vector<uint32_t> timestamps(const message_vector &messages) {
+	vector<uint32_t> result;
+	for (const auto &message : messages)
+		result.push_back(reinterpret_cast<const RtpHeader *>(message->data())->timestamp());
+	return result;
+}
+
+shared_ptr<SvcLayerFilter> makeFilter() {
+	Description::Video video("video", Description::Direction::SendOnly);
+	video.addAV1Codec(96);
+	video.addExtMap(Description::Entry::ExtMap(ExtId, SvcLayerFilter::ExtensionUri));
+	auto filter = make_shared<SvcLayerFilter>();
+	filter->media(video);
+	return filter;
+}
+
+} // namespace
+
+TestResult test_dependency_descriptor() {
+	try {
+		DependencyDescriptorContext context;
+
+		// The attached structure is read entirely
+		read(StructureDescriptor, context);
+		const auto &structure = context.structure;
+		if (structure.templateIdOffset != 60 || structure.decodeTargetCount != 2 ||
+		    structure.chainCount != 1 || structure.decodeTargetProtectedBy != vector<int>{0, 0})
+			return TestResult(false, "Wrong template dependency structure");
+
+		if (structure.templates.size() != 3 ||
+		    !isTemplate(structure.templates[0], 0, 0, {Dti::Switch, Dti::Switch}, {}, {0}) ||
+		    !isTemplate(structure.templates[1], 0, 0, {Dti::Switch, Dti::Switch}, {2}, {2}) ||
+		    !isTemplate(structure.templates[2], 0, 1, {Dti::NotPresent, Dti::Discardable}, {1},
+		                {1}))
+			return TestResult(false, "Wrong templates");
+
+		if (structure.resolutions.size() != 1 || structure.resolutions[0].width != 640 ||
+		    structure.resolutions[0].height != 360)
+			return TestResult(false, "Wrong render resolutions");
+
+		if (structure.decodeTargetLayers(0) != make_pair(0, 0) ||
+		    structure.decodeTargetLayers(1) != make_pair(0, 1))
+			return TestResult(false, "Wrong decode target layers");
+
+		const auto &descriptor = context.descriptor;
+		if (!descriptor.startOfFrame || !descriptor.endOfFrame || descriptor.frameNumber != 1 ||
+		    !descriptor.structureAttached ||
+		    !isTemplate(descriptor.dependencyTemplate, 0, 0, {Dti::Switch, Dti::Switch}, {}, {0}))
+			return TestResult(false, "Wrong descriptor with the attached structure");
+
+		if (!descriptor.resolution || descriptor.resolution->width != 640 ||
+		    descriptor.activeDecodeTargetsBitmask != 0b11u || context.activeChains != 0b1)
+			return TestResult(false, "Wrong active decode targets of the attached structure");
+
+		// The writer produces the same bytes
+		DependencyDescriptorWriter writer(context);
+		binary written(writer.getSize());
+		writer.writeTo(written.data(), written.size());
+		if (written != StructureDescriptor)
+			return TestResult(false, "Writer does not match the known bytes");
+
+		// Mandatory fields only, the template is taken from the structure with the id offset
+		read(TemporalDescriptor, context);
+		if (descriptor.frameNumber != 2 || descriptor.structureAttached ||
+		    descriptor.activeDecodeTargetsBitmask ||
+		    !isTemplate(descriptor.dependencyTemplate, 0, 1, {Dti::NotPresent, Dti::Discardable},
+		                {1}, {1}))
+			return TestResult(false, "Wrong descriptor without extended fields");
+
+		if (!descriptor.resolution || descriptor.resolution->height != 360 ||
+		    context.activeChains != 0b1)
+			return TestResult(false, "Context not kept without attached structure");
+
+		// Custom frame diffs and chain diffs override the template
+		read(CustomDescriptor, context);
+		if (descriptor.frameNumber != 3 ||
+		    !isTemplate(descriptor.dependencyTemplate, 0, 0, {Dti::Switch, Dti::Switch}, {2, 20},
+		                {3}))
+			return TestResult(false, "Wrong descriptor with custom fields");
+
+		// Chains protecting no active decode target are inactive
+		read(InactiveDescriptor, context);
+		if (descriptor.frameNumber != 4 || !descriptor.startOfFrame || descriptor.endOfFrame ||
+		    descriptor.activeDecodeTargetsBitmask != 0u || context.activeChains.any())
+			return TestResult(false, "Wrong descriptor with active decode targets");
+
+		// Invalid descriptors are rejected and leave the context unchanged
+		if (!throwsInvalid([&] { read({byte(0xFF), byte(0x00), byte(0x05)}, context); }))
+			return TestResult(false, "Unknown template id accepted");
+
+		binary truncated(StructureDescriptor.begin(), StructureDescriptor.begin() + 10);
+		if (!throwsInvalid([&] { read(truncated, context); }))
+			return TestResult(false, "Truncated structure accepted");
+
+		if (descriptor.frameNumber != 4 || structure.templates.size() != 3)
+			return TestResult(false, "Context changed by an invalid descriptor");
+
+		DependencyDescriptorContext empty;
+		if (!throwsInvalid([&] { read(TemporalDescriptor, empty); }))
+			return TestResult(false, "Descriptor accepted without structure");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_svc_layer_filter() {
+	try {
+		// Temporal layers with the L1T2 structure: template 0 is a keyframe, 1 a base layer frame,
+		// and 2 an upper layer frame
+		{
+			DependencyDescriptorContext context;
+			read(StructureDescriptor, context);
+			auto filter = makeFilter();
+			uint16_t seqNumber = 100;
+
+			// All frames are forwarded by default
+			auto forwarded = forward(*filter, context, seqNumber, {0, 2, 1, 2});
+			if (seqNumbers(forwarded) != vector<uint16_t>{100, 101, 102, 103})
+				return TestResult(false, "Frames dropped without decode target");
+
+			// The base layer is selected on its next switch frame, the upper layer frame before it
+			// is still forwarded
+			filter->setDecodeTarget(0);
+			forwarded = forward(*filter, context, seqNumber, {2, 1, 2, 1, 2});
+			if (timestamps(forwarded) != vector<uint32_t>{6 * 3000, 7 * 3000, 9 * 3000})
+				return TestResult(false, "Wrong frames forwarded for the base layer");
+
+			// Sequence numbers are contiguous despite the drops
+			if (seqNumbers(forwarded) != vector<uint16_t>{104, 105, 106} ||
+			    filter->droppedCount() != 2 || filter->decodeTarget() != 0)
+				return TestResult(false, "Wrong sequence numbers after drops");
+
+			// Both layers are selected on the next switch frame, the upper layer frame before it
+			// is still dropped
+			filter->setMaxLayers(0, 1);
+			forwarded = forward(*filter, context, seqNumber, {2, 1, 2});
+			if (timestamps(forwarded) != vector<uint32_t>{12 * 3000, 13 * 3000} ||
+			    seqNumbers(forwarded) != vector<uint16_t>{107, 108} || filter->decodeTarget() != 1)
+				return TestResult(false, "Wrong frames forwarded after raising the layers");
+		}
+
+		// Spatial layers with an L2T1 structure: decode target 0 is the lower spatial layer,
+		// decode target 1 includes both
+		{
+			DependencyDescriptorContext context;
+			auto &structure = context.structure;
+			structure.decodeTargetCount = 2;
+			structure.chainCount = 1;
+			structure.decodeTargetProtectedBy = {0, 0};
+			structure.templates.push_back({0, 0, {Dti::Switch, Dti::Switch}, {}, {0}});
+			structure.templates.push_back({1, 0, {Dti::NotPresent, Dti::Switch}, {1}, {1}});
+			context.activeChains.set(0);
+			context.descriptor.dependencyTemplate = structure.templates[0];
+			context.descriptor.structureAttached = true;
+
+			auto filter = makeFilter();
+			filter->setDecodeTarget(0);
+			message_vector messages{makePacket(200, context)}; // lower layer of the keyframe
+			context.descriptor.frameNumber = 1;
+			context.descriptor.structureAttached = false;
+			context.descriptor.dependencyTemplate = structure.templates[1];
+			auto upper = makePacket(201, context);
+			reinterpret_cast<RtpHeader *>(upper->data())->setMarker(true);
+			messages.push_back(std::move(upper));
+
+			filter->outgoing(messages, nullptr);
+			if (messages.size() != 1 || seqNumbers(messages) != vector<uint16_t>{200})
+				return TestResult(false, "Upper spatial layer not dropped");
+
+			// The marker moves to the last frame of the temporal unit which is kept
+			if (!reinterpret_cast<const RtpHeader *>(messages[0]->data())->marker())
+				return TestResult(false, "Marker not set on the highest kept spatial layer");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+const string Sdp = "v=0\r\n"
+                   "o=- 4611731400430051336 2 IN IP4 127.0.0.1\r\n"
+                   "s=-\r\n"
+                   "t=0 0\r\n"
+                   "a=group:BUNDLE 0 1 2\r\n"
+                   "a=ice-ufrag:8hhY\r\n"
+                   "a=ice-pwd:asd88fgpdd777uzjYhagZg\r\n"
+                   "a=fingerprint:sha-256 49:66:12:17:0D:1C:91:AE:57:4C:C6:36:DD:D5:97:D2:"
+                   "7D:62:C9:9A:7F:B9:A3:F2:67:D5:FB:7D:59:35:4E:69\r\n"
+                   "a=setup:actpass\r\n"
+                   "m=audio 9 UDP/TLS/RTP/SAVPF 111\r\n"
+                   "c=IN IP4 0.0.0.0\r\n"
+                   "a=mid:0\r\n"
+                   "a=sendrecv\r\n"
+                   "a=rtcp-mux\r\n"
+                   "a=rtpmap:111 opus/48000/2\r\n"
+                   "a=fmtp:111 minptime=10;useinbandfec=1\r\n"
+                   "a=ssrc:1001 cname:test\r\n"
+                   "m=video 9 UDP/TLS/RTP/SAVPF 96\r\n"
+                   "c=IN IP4 0.0.0.0\r\n"
+                   "a=mid:1\r\n"
+                   "a=sendrecv\r\n"
+                   "a=rtcp-mux\r\n"
+                   "a=rtpmap:96 VP8/90000\r\n"
+                   "a=rtcp-fb:96 nack\r\n"
+                   "a=ssrc:2001 cname:test\r\n"
+                   "m=application 9 UDP/DTLS/SCTP webrtc-datachannel\r\n"
+                   "c=IN IP4 0.0.0.0\r\n"
+                   "a=mid:2\r\n"
+                   "a=sctp-port:5000\r\n"
+                   "a=max-message-size:262144\r\n";
+
+const void *entry(const Description &description, int index) {
+	return std::visit([](auto *e) -> const void * { return e; }, description.media(index));
+}
+
+bool shared(const Description &a, const Description &b, int index) {
+	return entry(a, index) == entry(b, index);
+}
+
+} // namespace
+
+TestResult test_description_sharing() {
+	try {
+		// Identical parsed entries are shared
+		const Description first(Sdp, Description::Type::Offer);
+		const Description second(Sdp, Description::Type::Answer);
+		if (first.mediaCount() != 3 || second.mediaCount() != 3)
+			return TestResult(false, "Wrong media count");
+
+		for (int i = 0; i < 3; ++i)
+			if (!shared(first, second, i))
+				return TestResult(false, "Identical entries not shared");
+
+		if (first.application() != second.application() || first.application() != entry(first, 2))
+			return TestResult(false, "Application not shared");
+
+		if (!second.changedMedia(first).empty())
+			return TestResult(false, "Shared entries reported as changed");
+
+		// Entries differing by a single line are not
+		string otherSdp = Sdp;
+		otherSdp.replace(otherSdp.find("VP8"), 3, "VP9");
+		const Description other(otherSdp, Description::Type::Offer);
+		if (!shared(first, other, 0) || shared(first, other, 1) || !shared(first, other, 2))
+			return TestResult(false, "Different entries shared");
+
+		if (other.changedMedia(first) != vector<int>{1})
+			return TestResult(false, "Wrong changed media");
+
+		// Copies share entries and copy them on modification only
+		const string expected = string(first);
+		Description copy = first;
+		for (int i = 0; i < 3; ++i)
+			if (!shared(first, std::as_const(copy), i))
+				return TestResult(false, "Entries not shared by the copy");
+
+		std::get<Description::Media *>(copy.media(1))->addAttribute("x-test");
+		copy.application()->setSctpPort(5001);
+
+		if (string(first) != expected || string(second) != expected)
+			return TestResult(false, "Modification of a copy changed the original");
+
+		const Description &constCopy = copy;
+		if (!shared(first, constCopy, 0) || shared(first, constCopy, 1) ||
+		    shared(first, constCopy, 2))
+			return TestResult(false, "Wrong entries copied on modification");
+
+		if (constCopy.application() != entry(constCopy, 2) ||
+		    constCopy.application()->sctpPort() != 5001)
+			return TestResult(false, "Application not copied on modification");
+
+		if (string(copy).find("a=x-test") == string::npos)
+			return TestResult(false, "Modification of a copy lost");
+
+		if (constCopy.changedMedia(first) != vector<int>{1, 2})
+			return TestResult(false, "Copied entries not reported as changed");
+
+		// Mutable access to an entry owned alone does not copy it
+		const void *owned = entry(constCopy, 1);
+		std::get<Description::Media *>(copy.media(1))->addAttribute("x-other");
+		if (entry(constCopy, 1) != owned)
+			return TestResult(false, "Entry owned alone copied on modification");
+
+		// A modified parsed description does not leak into later parses
+		Description modified(Sdp, Description::Type::Offer);
+		std::get<Description::Media *>(modified.media(0))->addAttribute("x-test");
+		const Description reparsed(Sdp, Description::Type::Offer);
+		if (!shared(first, reparsed, 0) || string(reparsed) != expected)
+			return TestResult(false, "Modified entry shared with a later parse");
+
+		// Adding media never shares it
+		Description added = first;
+		Description::Audio audio("3", Description::Direction::SendOnly);
+		audio.addOpusCodec(111);
+		const int index = added.addMedia(audio);
+		const Description &constAdded = added;
+		if (index != 3 || constAdded.mediaCount() != 4 || !shared(first, constAdded, 0))
+			return TestResult(false, "Wrong entries after adding media");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
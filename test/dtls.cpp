@@ -0,0 +1,294 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "rtc/rtp.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+// Defined in connectivity.cpp
+extern const char *key_pem;
+extern const char *cert_pem;
+
+namespace {
+
+struct PairResult {
+	bool connected = false;
+	bool received = false; // a message or an RTP packet went through
+	optional<DtlsTransportStats> dtls1;
+	optional<DtlsTransportStats> dtls2;
+};
+
+// Connects two peers, with a video track if media is set or a data channel otherwise, and sends
+// a message from the first one to the second one
+PairResult connectPair(const Configuration &config1, const Configuration &config2, bool media) {
+	PeerConnection pc1(config1);
+	PeerConnection pc2(config2);
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(sdp); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(sdp); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+
+	PairResult result;
+	std::atomic<bool> received = false;
+	std::function<bool()> send;
+	shared_ptr<Track> t1;
+	shared_ptr<DataChannel> dc1;
+	if (media) {
+#if RTC_ENABLE_MEDIA
+		pc2.onTrack([&received](shared_ptr<Track> t) {
+			t->onMessage([&received](binary) { received = true; }, nullptr);
+		});
+
+		Description::Video video("video", Description::Direction::SendOnly);
+		video.addH264Codec(96);
+		video.addSSRC(1234, "video-send");
+		t1 = pc1.addTrack(video);
+		pc1.setLocalDescription();
+
+		send = [&t1]() {
+			if (!t1->isOpen())
+				return false;
+
+			binary packet(sizeof(RtpHeader) + 4, std::byte{1});
+			auto rtp = reinterpret_cast<RtpHeader *>(packet.data());
+			rtp->preparePacket();
+			rtp->setPayloadType(96);
+			rtp->setSeqNumber(1);
+			rtp->setSsrc(1234);
+			return t1->send(packet);
+		};
+#else
+		throw std::logic_error("Media support is disabled");
+#endif
+	} else {
+		pc2.onDataChannel([&received](shared_ptr<DataChannel> dc) {
+			dc->onMessage([&received](message_variant) { received = true; });
+		});
+
+		dc1 = pc1.createDataChannel("test");
+		send = [&dc1]() { return dc1->isOpen() && dc1->send("hello"); };
+	}
+
+	int attempts = 10;
+	while ((pc1.state() != PeerConnection::State::Connected ||
+	        pc2.state() != PeerConnection::State::Connected) &&
+	       pc1.state() != PeerConnection::State::Failed &&
+	       pc2.state() != PeerConnection::State::Failed && attempts--)
+		this_thread::sleep_for(1s);
+
+	result.connected = pc1.state() == PeerConnection::State::Connected &&
+	                   pc2.state() == PeerConnection::State::Connected;
+
+	if (result.connected) {
+		attempts = 50;
+		while (!received && attempts--) {
+			send();
+			this_thread::sleep_for(100ms);
+		}
+		result.received = received;
+	}
+
+	result.dtls1 = pc1.getStats().dtls;
+	result.dtls2 = pc2.getStats().dtls;
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return result;
+}
+
+} // namespace
+
+TestResult test_srtp_profiles() {
+	InitLogger(LogLevel::Debug);
+
+	try {
+		// Both peers negotiate the same profile, the cheapest one on this CPU by default
+		auto result = connectPair({}, {}, true);
+		if (!result.connected || !result.received)
+			return TestResult(false, "Media not received with the default profiles");
+
+		if (!result.dtls1 || result.dtls1->srtpProfile.empty() || !result.dtls2 ||
+		    result.dtls2->srtpProfile != result.dtls1->srtpProfile)
+			return TestResult(false, "Negotiated SRTP profile not reported");
+
+		// The preferred profile is negotiated, except with backends which only support the
+		// mandatory one
+		Configuration config;
+		config.srtpProfiles = {SrtpProfile::Aes128CmSha1_32};
+		result = connectPair(config, config, true);
+		if (!result.connected || !result.received)
+			return TestResult(false, "Media not received with the preferred profile");
+
+		if (!result.dtls1 || !result.dtls2 ||
+		    result.dtls2->srtpProfile != result.dtls1->srtpProfile ||
+		    (result.dtls1->srtpProfile != "SRTP_AES128_CM_SHA1_32" &&
+		     result.dtls1->srtpProfile != "SRTP_AES128_CM_SHA1_80"))
+			return TestResult(false, "Preferred SRTP profile not negotiated");
+
+		// The mandatory profile is always offered, so a peer with other preferences still connects
+		Configuration other;
+		other.srtpProfiles = {SrtpProfile::AeadAes256Gcm};
+		result = connectPair(config, other, true);
+		if (!result.connected || !result.received)
+			return TestResult(false, "Media not received with different preferences");
+
+		if (!result.dtls1 || !result.dtls2 ||
+		    result.dtls2->srtpProfile != result.dtls1->srtpProfile)
+			return TestResult(false, "Peers with different preferences disagree on the profile");
+
+		// Data-only transports don't negotiate SRTP
+		result = connectPair({}, {}, false);
+		if (!result.connected || !result.dtls1 || !result.dtls1->srtpProfile.empty())
+			return TestResult(false, "SRTP profile reported without media");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_pending_handshakes() {
+	InitLogger(LogLevel::Debug);
+
+	auto rejected = []() -> uint64_t {
+		for (const auto &metric : GetMetrics())
+			if (metric.name == "rtc_dtls_handshakes_rejected")
+				return metric.value;
+
+		return 0;
+	};
+
+	try {
+		// Both peers handshake at the same time, so the handshake of one of them is rejected
+		const auto before = rejected();
+		ThreadPoolSettings settings;
+		settings.maxPendingHandshakes = 1;
+		SetThreadPoolSettings(settings);
+		auto result = connectPair({}, {}, false);
+		SetThreadPoolSettings({});
+
+		if (result.connected)
+			return TestResult(false, "Connected beyond the pending handshakes limit");
+
+		if (rejected() <= before)
+			return TestResult(false, "Rejected handshake not counted");
+
+		// Under the limit, handshakes proceed and are no longer pending once done
+		settings.maxPendingHandshakes = 2;
+		SetThreadPoolSettings(settings);
+		result = connectPair({}, {}, false);
+		SetThreadPoolSettings({});
+
+		if (!result.connected || !result.received)
+			return TestResult(false, "Not connected under the pending handshakes limit");
+
+		if (GetThreadPoolStats().pendingHandshakes != 0)
+			return TestResult(false, "Handshakes still pending after closing");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		SetThreadPoolSettings({});
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_shared_dtls_context() {
+	InitLogger(LogLevel::Debug);
+
+	try {
+		// Transports with the same certificate share their context, including a client and a
+		// server of the same pair, and connections handshaking concurrently
+		Configuration config;
+		config.certificatePemFile = cert_pem;
+		config.keyPemFile = key_pem;
+
+		Configuration resuming = config;
+		resuming.enableDtlsSessionResumption = true;
+
+		const Configuration other;
+		vector<std::future<PairResult>> futures;
+		futures.push_back(std::async(std::launch::async, connectPair, config, config, false));
+		futures.push_back(std::async(std::launch::async, connectPair, config, other, false));
+		futures.push_back(std::async(std::launch::async, connectPair, other, config, false));
+		futures.push_back(std::async(std::launch::async, connectPair, resuming, resuming, false));
+		for (auto &future : futures) {
+			auto result = future.get();
+			if (!result.connected || !result.received)
+				return TestResult(false, "Connection with a shared DTLS context failed");
+		}
+
+		// The context expired with the last transport, a new one is created
+		auto result = connectPair(config, config, false);
+		if (!result.connected || !result.received)
+			return TestResult(false, "Connection with a new DTLS context failed");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_dtls13() {
+	InitLogger(LogLevel::Debug);
+
+	// Names depend on the backend, like "DTLSv1.2" or "DTLS1.2"
+	auto is = [](const optional<DtlsTransportStats> &stats, const string &version) {
+		return stats && stats->version.size() > version.size() &&
+		       stats->version.compare(stats->version.size() - version.size(), string::npos,
+		                              version) == 0;
+	};
+
+	try {
+		// DTLS 1.2 is used by default
+		auto result = connectPair({}, {}, false);
+		if (!result.connected || !result.received || !is(result.dtls1, "1.2") ||
+		    !is(result.dtls2, "1.2"))
+			return TestResult(false, "DTLS 1.2 not negotiated by default");
+
+		// DTLS 1.3 is only negotiated if both peers enable it, and falls back to DTLS 1.2 with
+		// backends which don't support it
+		Configuration config;
+		config.enableDtls13 = true;
+		result = connectPair(config, config, false);
+		if (!result.connected || !result.received || !result.dtls1 || !result.dtls2 ||
+		    result.dtls1->version != result.dtls2->version ||
+		    (!is(result.dtls1, "1.3") && !is(result.dtls1, "1.2")))
+			return TestResult(false, "Wrong DTLS version with DTLS 1.3 enabled");
+
+		for (const auto &[config1, config2] : {std::make_pair(config, Configuration{}),
+		                                       std::make_pair(Configuration{}, config)}) {
+			result = connectPair(config1, config2, false);
+			if (!result.connected || !result.received || !is(result.dtls1, "1.2") ||
+			    !is(result.dtls2, "1.2"))
+				return TestResult(false, "DTLS 1.2 not negotiated with a single peer enabling 1.3");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,186 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/executor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using impl::Executor;
+using impl::ExecutorPool;
+
+TestResult test_executor() {
+	try {
+		// Keep the library initialized, as tasks posted after join go to the thread pool
+		PeerConnection pc;
+
+		// Tasks run in order on a single thread
+		{
+			auto executor = make_shared<Executor>();
+			std::mutex mutex;
+			vector<int> order;
+			std::set<std::thread::id> threads;
+			for (int i = 0; i < 100; ++i)
+				executor->post([&, i]() {
+					std::lock_guard lock(mutex);
+					order.push_back(i);
+					threads.insert(std::this_thread::get_id());
+				});
+
+			executor->join(); // runs the remaining tasks
+			for (int i = 0; i < 100; ++i)
+				if (order.size() != 100 || order[i] != i)
+					return TestResult(false, "Executor tasks not run in order");
+
+			if (threads.size() != 1 || *threads.begin() == std::this_thread::get_id())
+				return TestResult(false, "Executor tasks not run on a single thread");
+
+			// Once joined, tasks are run by the thread pool
+			promise<void> run;
+			executor->post([&run]() { run.set_value(); });
+			if (run.get_future().wait_for(5s) != future_status::ready)
+				return TestResult(false, "Task posted after join not run");
+		}
+
+		// A task may release the last reference to its executor, sanitizers detect use after free
+		std::atomic<int> released = 0;
+		for (int i = 0; i < 100; ++i) {
+			auto executor = make_shared<Executor>();
+			std::atomic<bool> dropped = false;
+			executor->post([copy = executor, &dropped, &released]() mutable {
+				while (!dropped)
+					this_thread::yield();
+
+				copy.reset(); // the last reference
+				++released;
+			});
+			executor.reset();
+			dropped = true;
+
+			int attempts = 500;
+			while (released <= i && attempts--)
+				this_thread::sleep_for(10ms);
+
+			if (released <= i)
+				return TestResult(false, "Self-releasing task not run");
+		}
+		this_thread::sleep_for(100ms); // let detached threads exit
+
+#if defined(__linux__)
+		// An executor may be pinned to a core
+		{
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+				unsigned int cpu = 0;
+				while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &set))
+					++cpu;
+
+				auto executor = make_shared<Executor>(cpu);
+				promise<int> current;
+				executor->post([&current]() { current.set_value(sched_getcpu()); });
+				auto future = current.get_future();
+				if (future.wait_for(5s) != future_status::ready || future.get() != int(cpu))
+					return TestResult(false, "Executor not pinned to its core");
+			}
+		}
+#endif
+
+		// Executors are spawned up to the configured count, then assigned in turn
+		ExecutorPool::Instance().setSettings(2, false, {});
+		auto first = ExecutorPool::Instance().next();
+		auto second = ExecutorPool::Instance().next();
+		auto third = ExecutorPool::Instance().next();
+		auto fourth = ExecutorPool::Instance().next();
+		ExecutorPool::Instance().setSettings(nullopt, false, {});
+		if (first == second || (third != first && third != second) || fourth == third)
+			return TestResult(false, "Executors not assigned in turn");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_executor_affinity() {
+	InitLogger(LogLevel::Debug);
+
+	Configuration config;
+	config.enableExecutorAffinity = true;
+	PeerConnection pc1(config);
+	PeerConnection pc2(config);
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(sdp); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(sdp); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+
+	// All messages of the connection are received on its executor
+	std::mutex mutex;
+	std::set<std::thread::id> threads;
+	std::atomic<int> received = 0;
+	shared_ptr<DataChannel> dc2;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		dc->onMessage([&](message_variant) {
+			std::lock_guard lock(mutex);
+			threads.insert(std::this_thread::get_id());
+			++received;
+		});
+		std::atomic_store(&dc2, dc);
+	});
+
+	auto dc1 = pc1.createDataChannel("test");
+	int attempts = 10;
+	while ((!dc1->isOpen() || !std::atomic_load(&dc2)) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!dc1->isOpen() || !std::atomic_load(&dc2))
+		return TestResult(false, "DataChannel is not open");
+
+	const int count = 100;
+	for (int i = 0; i < count; ++i)
+		dc1->send("message " + to_string(i));
+
+	attempts = 10;
+	while (received < count && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (received != count)
+		return TestResult(false, "Messages not received");
+
+	{
+		std::lock_guard lock(mutex);
+		if (threads.size() != 1)
+			return TestResult(false, "Messages received on " + to_string(threads.size()) +
+			                             " threads instead of the executor");
+	}
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
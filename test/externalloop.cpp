@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+TestResult test_external_loop() {
+#ifndef _WIN32
+	try {
+		// The pool can only switch to external mode without workers
+		if (rtc::Cleanup().wait_for(10s) == future_status::timeout)
+			return TestResult(false, "Cleanup timeout");
+
+		auto &pool = impl::ThreadPool::Instance();
+		pool.setWorkStealing(false);
+		pool.setExternal(true);
+		const int fd = pool.eventDescriptor();
+		if (fd < 0) {
+			pool.setExternal(false);
+			return TestResult(false, "No event descriptor");
+		}
+
+		// The loop only runs tasks when the descriptor is readable, so a lost wakeup stalls it
+		std::atomic<bool> done = false;
+		std::atomic<bool> stalled = false;
+		std::thread loop([&]() {
+			while (!done) {
+				struct pollfd pfd = {fd, POLLIN, 0};
+				if (::poll(&pfd, 1, 1000) == 0) {
+					auto timeout = pool.nextTimeout();
+					if (timeout && *timeout == chrono::steady_clock::duration::zero())
+						stalled = true;
+				}
+				pool.runExternal(0ms);
+			}
+		});
+
+		const int producers = 4;
+		const int count = 50000;
+		std::atomic<int> executed = 0;
+		vector<std::thread> threads;
+		for (int p = 0; p < producers; ++p)
+			threads.emplace_back([&]() {
+				for (int i = 0; i < count; ++i) {
+					pool.post([&executed]() { ++executed; });
+					if (i % 64 == 0)
+						this_thread::yield();
+				}
+			});
+
+		for (auto &t : threads)
+			t.join();
+
+		int attempts = 100;
+		while (executed < producers * count && attempts--)
+			this_thread::sleep_for(100ms);
+
+		done = true;
+		pool.post([]() {}); // wake up the loop
+		loop.join();
+		while (pool.runExternal(0ms) > 0) {
+		}
+		pool.setExternal(false);
+
+		if (stalled)
+			return TestResult(false, "Tasks were ready but the event descriptor was not readable");
+
+		if (executed != producers * count)
+			return TestResult(false, "Tasks not run by the external loop");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+#else
+	return TestResult(true);
+#endif
+}
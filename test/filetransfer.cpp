@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+// Chunk in the FileSender format: type, offset, then file size
+binary makeChunk(uint8_t type, uint64_t offset, uint64_t fileSize, size_t dataSize) {
+	binary chunk(1 + 8 + 8 + dataSize, byte(0x5A));
+	chunk[0] = byte(type);
+	for (size_t i = 0; i < 8; ++i) {
+		chunk[1 + i] = byte((offset >> (8 * (7 - i))) & 0xFF);
+		chunk[9 + i] = byte((fileSize >> (8 * (7 - i))) & 0xFF);
+	}
+	return chunk;
+}
+
+string readFile(const string &path) {
+	ifstream file(path, ios::binary);
+	return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TestResult test_file_transfer() {
+	InitLogger(LogLevel::Debug);
+
+	const string sourcePath = "test-file-source.bin";
+	const string destinationPath = "test-file-destination.bin";
+	const string forgedPath = "test-file-forged.bin";
+	std::remove(destinationPath.c_str());
+	std::remove(forgedPath.c_str());
+
+	string content(200000, '\0');
+	for (size_t i = 0; i < content.size(); ++i)
+		content[i] = char(i % 253);
+
+	ofstream(sourcePath, ios::binary | ios::trunc).write(content.data(), content.size());
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	std::mutex mutex;
+	vector<shared_ptr<DataChannel>> remoteChannels;
+	shared_ptr<DataChannel> forgedChannel;
+	shared_ptr<FileReceiver> receiver, forgedReceiver;
+	promise<uint64_t> received;
+	promise<string> forgedError;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		std::lock_guard lock(mutex);
+		if (dc->label() == "forged") {
+			forgedReceiver = make_shared<FileReceiver>(forgedPath, dc);
+			forgedReceiver->onError([&forgedError](string error) { forgedError.set_value(error); });
+			forgedChannel = std::move(dc);
+			return;
+		}
+
+		remoteChannels.push_back(std::move(dc));
+		if (remoteChannels.size() == 2) {
+			receiver = make_shared<FileReceiver>(destinationPath, remoteChannels);
+			receiver->onComplete([&received](uint64_t size) { received.set_value(size); });
+			receiver->onError([&received](string error) {
+				received.set_exception(make_exception_ptr(runtime_error(error)));
+			});
+		}
+	});
+
+	auto dc1 = pc1.createDataChannel("file-0");
+	auto dc2 = pc1.createDataChannel("file-1");
+	auto forged = pc1.createDataChannel("forged");
+
+	int attempts = 10;
+	auto ready = [&]() {
+		std::lock_guard lock(mutex);
+		return receiver && forgedReceiver && dc1->isOpen() && dc2->isOpen() && forged->isOpen();
+	};
+	while (!ready() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!ready())
+		return TestResult(false, "DataChannels are not open");
+
+	// A file sent over two channels is received entirely
+	FileSender sender(sourcePath, {dc1, dc2}, {0, 16384, 4});
+	sender.start();
+
+	auto future = received.get_future();
+	if (future.wait_for(10s) != future_status::ready)
+		return TestResult(false, "File transfer timed out");
+
+	try {
+		if (future.get() != content.size())
+			return TestResult(false, "Wrong received file size");
+	} catch (const exception &e) {
+		return TestResult(false, string("File transfer failed: ") + e.what());
+	}
+
+	if (!receiver->isComplete() || receiver->resumeOffset() != content.size() ||
+	    readFile(destinationPath) != content)
+		return TestResult(false, "Wrong received file content");
+
+	// A chunk beyond the announced size is never written
+	forged->send(makeChunk(0, 0, 10, 4));
+	forged->send(makeChunk(0, 1000000000000ULL, 10, 4));
+
+	auto errorFuture = forgedError.get_future();
+	if (errorFuture.wait_for(5s) != future_status::ready)
+		return TestResult(false, "Chunk beyond the announced size accepted");
+
+	if (forgedReceiver->size() != 10 || forgedReceiver->receivedAmount() != 4)
+		return TestResult(false, "Data written beyond the announced size");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	std::remove(sourcePath.c_str());
+	std::remove(destinationPath.c_str());
+	std::remove(forgedPath.c_str());
+
+	return TestResult(true);
+}
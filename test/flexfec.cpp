@@ -0,0 +1,207 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+const SSRC MediaSsrc = 42;
+const SSRC FecSsrc = 43;
+const SSRC OtherSsrc = 44;
+const int FecPayloadType = 120;
+
+Description::Video makeMedia() {
+	Description::Video video("video", Description::Direction::SendRecv);
+	video.addVP8Codec(96);
+	video.addFlexFecCodec(FecPayloadType);
+	video.addSSRC(MediaSsrc, "cname");
+	video.addFecSSRC(MediaSsrc, FecSsrc);
+	return video;
+}
+
+// Packets of various sizes and contents, so recovering a wrong one is detected
+message_ptr makePacket(uint16_t seqNumber) {
+	auto message = make_message(sizeof(RtpHeader) + 50 + seqNumber % 7 * 13);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(MediaSsrc);
+	rtp->setSeqNumber(seqNumber);
+	rtp->setTimestamp(1000 + seqNumber / 3 * 3000);
+	for (size_t i = sizeof(RtpHeader); i < message->size(); ++i)
+		message->at(i) = byte(seqNumber * 31 + i);
+	return message;
+}
+
+bool isFec(const Message &message) {
+	return reinterpret_cast<const RtpHeader *>(message.data())->payloadType() == FecPayloadType;
+}
+
+uint16_t seqNumber(const Message &message) {
+	return reinterpret_cast<const RtpHeader *>(message.data())->seqNumber();
+}
+
+// Protects the packets with a constant block size of 1 / protection, returns the FEC packets
+vector<message_ptr> protect(double protection, uint16_t first, uint16_t count) {
+	FlexFecEncoder encoder(protection, protection);
+	encoder.media(makeMedia());
+	message_vector messages;
+	for (uint16_t i = 0; i < count; ++i)
+		messages.push_back(makePacket(uint16_t(first + i)));
+
+	encoder.outgoing(messages, nullptr);
+	vector<message_ptr> fecs;
+	for (auto &message : messages)
+		if (isFec(*message))
+			fecs.push_back(message);
+
+	return fecs;
+}
+
+// Feeds the media packets which are not lost, then the FEC packets, returns the media packets
+// passed on, indexed by sequence number
+map<uint16_t, message_ptr> receive(FlexFecDecoder &decoder, uint16_t first, uint16_t count,
+                                   const set<uint16_t> &lost, vector<message_ptr> fecs) {
+	message_vector messages;
+	for (uint16_t i = 0; i < count; ++i)
+		if (lost.find(uint16_t(first + i)) == lost.end())
+			messages.push_back(makePacket(uint16_t(first + i)));
+
+	for (auto &fec : fecs)
+		messages.push_back(std::move(fec));
+
+	decoder.incoming(messages, nullptr);
+	map<uint16_t, message_ptr> result;
+	for (auto &message : messages) {
+		if (isFec(*message))
+			throw runtime_error("FEC packet passed on");
+
+		result.emplace(seqNumber(*message), message);
+	}
+	return result;
+}
+
+bool isOriginal(const map<uint16_t, message_ptr> &received, uint16_t seqNumber) {
+	auto it = received.find(seqNumber);
+	return it != received.end() && *it->second == *makePacket(seqNumber);
+}
+
+void write32(Message &message, size_t offset, uint32_t value) {
+	for (size_t i = 0; i < 4; ++i)
+		message[offset + i] = byte(value >> (24 - 8 * i));
+}
+
+} // namespace
+
+TestResult test_flexfec() {
+	try {
+		// A single loss in each block is recovered, identical to the original
+		{
+			auto fecs = protect(0.25, 1000, 12);
+			if (fecs.size() != 3)
+				return TestResult(false, "Wrong FEC packet count");
+
+			FlexFecDecoder decoder;
+			decoder.media(makeMedia());
+			auto received = receive(decoder, 1000, 12, {1001, 1006, 1011}, fecs);
+			if (decoder.recoveredCount() != 3 || received.size() != 12)
+				return TestResult(false, "Single losses not recovered");
+
+			for (uint16_t i = 1000; i < 1012; ++i)
+				if (!isOriginal(received, i))
+					return TestResult(false, "Recovered packet differs from the original");
+
+			auto rtp = reinterpret_cast<const RtpHeader *>(received[1006]->data());
+			if (received[1006]->stream != MediaSsrc || rtp->version() != 2)
+				return TestResult(false, "Wrong header of the recovered packet");
+		}
+
+		// A block spanning the sequence number wraparound is recovered
+		{
+			auto fecs = protect(0.25, 65534, 4);
+			FlexFecDecoder decoder;
+			decoder.media(makeMedia());
+			auto received = receive(decoder, 65534, 4, {0}, fecs);
+			if (decoder.recoveredCount() != 1 || !isOriginal(received, 0))
+				return TestResult(false, "Loss not recovered across the wraparound");
+		}
+
+		// A packet recovered with one FEC packet allows recovering another one with a second
+		// FEC packet protecting both, even if the second one arrives first
+		{
+			auto pairs = protect(0.5, 2000, 4);   // protects 2000-2001 and 2002-2003
+			auto overlap = protect(0.25, 2001, 4); // protects 2001-2004
+			if (pairs.size() != 2 || overlap.size() != 1)
+				return TestResult(false, "Wrong FEC packet count");
+
+			FlexFecDecoder decoder;
+			decoder.media(makeMedia());
+			auto received = receive(decoder, 2000, 5, {2001, 2002}, {overlap[0], pairs[0]});
+			if (decoder.recoveredCount() != 2 || !isOriginal(received, 2001) ||
+			    !isOriginal(received, 2002))
+				return TestResult(false, "Chained recovery failed");
+		}
+
+		// Two losses in a block can't be recovered, and nothing is made up
+		{
+			auto fecs = protect(0.25, 3000, 4);
+			FlexFecDecoder decoder;
+			decoder.media(makeMedia());
+			auto received = receive(decoder, 3000, 4, {3001, 3002}, fecs);
+			if (decoder.recoveredCount() != 0 || received.size() != 2)
+				return TestResult(false, "Double loss recovered");
+
+			// The FEC packet still waits for the missing packets
+			received = receive(decoder, 3001, 1, {}, {});
+			if (decoder.recoveredCount() != 1 || !isOriginal(received, 3002))
+				return TestResult(false, "Loss not recovered once another packet arrived");
+		}
+
+		// The FEC packet protects another stream, which can't be recovered
+		{
+			auto fecs = protect(0.25, 4000, 4);
+			write32(*fecs[0], sizeof(RtpHeader) + 12, OtherSsrc);
+			FlexFecDecoder decoder;
+			decoder.media(makeMedia());
+			auto received = receive(decoder, 4000, 4, {4002}, fecs);
+			if (decoder.recoveredCount() != 0 || received.size() != 3)
+				return TestResult(false, "Packet recovered with an SSRC mismatch");
+		}
+
+		// The mask does not include the lost packet, which can't be recovered
+		{
+			auto fecs = protect(0.25, 5000, 4);
+			auto mask = sizeof(RtpHeader) + 18;
+			fecs[0]->at(mask) &= byte(~0x10); // the third packet
+			FlexFecDecoder decoder;
+			decoder.media(makeMedia());
+			auto received = receive(decoder, 5000, 4, {5002}, fecs);
+			if (decoder.recoveredCount() != 0 || received.size() != 3)
+				return TestResult(false, "Packet recovered with a mask mismatch");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
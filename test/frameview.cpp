@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+struct ReceivedFrame {
+	binary data;
+	FrameInfo info;
+};
+
+// Sends a single NAL unit frame, an IDR slice for even ids or a non-IDR slice otherwise, with the
+// id as RTP sequence number and the second payload byte
+bool sendFrame(Track &track, SSRC ssrc, uint8_t id) {
+	binary packet(sizeof(RtpHeader) + 2);
+	auto rtp = reinterpret_cast<RtpHeader *>(packet.data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSeqNumber(id);
+	rtp->setTimestamp(uint32_t(id) * 3000);
+	rtp->setSsrc(ssrc);
+	rtp->setMarker(true);
+	packet[sizeof(RtpHeader)] = byte(id % 2 == 0 ? 0x65 : 0x41);
+	packet[sizeof(RtpHeader) + 1] = byte(id);
+	return track.send(packet);
+}
+
+// Checks the frame was reassembled from the frame sent with the id
+bool isFrame(const ReceivedFrame &frame, SSRC ssrc, uint8_t id) {
+	const binary expected = {byte(0x00), byte(0x00), byte(0x00), byte(0x01),
+	                         byte(id % 2 == 0 ? 0x65 : 0x41), byte(id)};
+	return frame.data == expected && frame.info.ssrc == ssrc &&
+	       frame.info.timestamp == uint32_t(id) * 3000 && frame.info.payloadType == 96 &&
+	       frame.info.keyframe == (id % 2 == 0);
+}
+
+} // namespace
+
+TestResult test_track_frame_view() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	std::mutex mutex;
+	vector<ReceivedFrame> views;
+	vector<ReceivedFrame> copies;
+	std::atomic<bool> nullView = false;
+	std::atomic<bool> withoutInfo = false;
+
+	shared_ptr<Track> t2;
+	pc2.onTrack([&](shared_ptr<Track> t) {
+		t->setMediaHandler(make_shared<H264RtpDepacketizer>());
+		t->onMessage([&withoutInfo](binary) { withoutInfo = true; }, nullptr);
+		t->onFrameView([&](shared_ptr<const Message> frame) {
+			if (!frame || !frame->frameInfo) {
+				nullView = true;
+				return;
+			}
+
+			std::lock_guard lock(mutex);
+			views.push_back(ReceivedFrame{binary(frame->begin(), frame->end()), *frame->frameInfo});
+		});
+		std::atomic_store(&t2, t);
+	});
+
+	const SSRC ssrc = 4000;
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	media.addSSRC(ssrc, "video-send");
+	auto t1 = pc1.addTrack(media);
+
+	pc1.setLocalDescription();
+
+	int attempts = 10;
+	shared_ptr<Track> at2;
+	while ((!(at2 = std::atomic_load(&t2)) || !at2->isOpen() || !t1->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!at2 || !at2->isOpen() || !t1->isOpen())
+		return TestResult(false, "Track is not open");
+
+	auto count = [&mutex](const vector<ReceivedFrame> &frames) {
+		std::lock_guard lock(mutex);
+		return frames.size();
+	};
+
+	// Frames are sent until a keyframe and a delta frame went through, as packets may be lost
+	uint8_t id = 0;
+	attempts = 50;
+	while (count(views) < 4 && attempts--) {
+		sendFrame(*t1, ssrc, id++);
+		this_thread::sleep_for(100ms);
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		if (views.size() < 4)
+			return TestResult(false, "Frames not received by the view callback");
+
+		bool keyframe = false, delta = false;
+		for (const auto &frame : views) {
+			const auto received = std::to_integer<uint8_t>(frame.data.back());
+			if (!isFrame(frame, ssrc, received))
+				return TestResult(false, "Wrong frame or frame info in the view callback");
+
+			(received % 2 == 0 ? keyframe : delta) = true;
+		}
+
+		if (!keyframe || !delta)
+			return TestResult(false, "Frames of both kinds not received");
+	}
+
+	// Setting onFrame() replaces the view callback
+	at2->onFrame([&](binary data, FrameInfo info) {
+		std::lock_guard lock(mutex);
+		copies.push_back(ReceivedFrame{std::move(data), std::move(info)});
+	});
+	const size_t viewCount = count(views);
+	attempts = 50;
+	while (count(copies) < 2 && attempts--) {
+		sendFrame(*t1, ssrc, id++);
+		this_thread::sleep_for(100ms);
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		if (copies.size() < 2)
+			return TestResult(false, "Frames not received by the frame callback");
+
+		for (const auto &frame : copies)
+			if (!isFrame(frame, ssrc, std::to_integer<uint8_t>(frame.data.back())))
+				return TestResult(false, "Wrong frame or frame info in the frame callback");
+
+		if (views.size() != viewCount)
+			return TestResult(false, "Frames received by the replaced view callback");
+	}
+
+	// And setting onFrameView() again replaces the frame callback
+	at2->onFrameView([&](shared_ptr<const Message> frame) {
+		std::lock_guard lock(mutex);
+		views.push_back(ReceivedFrame{binary(frame->begin(), frame->end()), *frame->frameInfo});
+	});
+	const size_t copyCount = count(copies);
+	attempts = 50;
+	while (count(views) < viewCount + 2 && attempts--) {
+		sendFrame(*t1, ssrc, id++);
+		this_thread::sleep_for(100ms);
+	}
+
+	if (count(views) < viewCount + 2 || count(copies) != copyCount)
+		return TestResult(false, "Frame callback not replaced by the view callback");
+
+	if (nullView)
+		return TestResult(false, "Frame view without frame info");
+
+	if (withoutInfo)
+		return TestResult(false, "Frame delivered to the message callback");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif
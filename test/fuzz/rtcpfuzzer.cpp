@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Fuzzing harness for RTCP compound packets, walked like in PeerConnection::dispatchRtcp() and
+// passed through the RTCP media handlers as received from the peer
+
+#include "rtc/rtc.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+using namespace rtc;
+
+namespace {
+
+volatile uint64_t Sink = 0;
+
+// Reads every field reachable from the sub-packets of a compound packet, after the same bounds
+// checks as the library, so out-of-bounds reads are caught by the address sanitizer
+void walk(const byte *data, size_t size) {
+	uint64_t sum = 0;
+	size_t offset = 0;
+	while (offset + sizeof(RtcpHeader) <= size) {
+		auto header = reinterpret_cast<const RtcpHeader *>(data + offset);
+		const size_t length = header->lengthInBytes();
+		if (offset + length > size)
+			break;
+
+		const auto pt = header->payloadType();
+		const auto count = header->reportCount();
+		if (pt == 200 && length >= RtcpSr::Size(count)) {
+			auto sr = reinterpret_cast<const RtcpSr *>(header);
+			sum += sr->senderSSRC() + sr->ntpTimestamp() + sr->packetCount();
+			for (int i = 0; i < count; ++i)
+				sum += sr->getReportBlock(i)->getSSRC() + sr->getReportBlock(i)->jitter();
+
+		} else if (pt == 201 && length >= RtcpRr::SizeWithReportBlocks(count)) {
+			auto rr = reinterpret_cast<const RtcpRr *>(header);
+			sum += rr->senderSSRC();
+			for (int i = 0; i < count; ++i)
+				sum += rr->getReportBlock(i)->getPacketsLostCount();
+
+		} else if (pt == 202) {
+			auto sdes = reinterpret_cast<const RtcpSdes *>(header);
+			if (sdes->isValid())
+				for (unsigned int i = 0; i < sdes->chunksCount(); ++i)
+					sum += sdes->getChunk(int(i))->ssrc();
+
+		} else if ((pt == 205 || pt == 206) && length >= sizeof(RtcpFbHeader)) {
+			auto fb = reinterpret_cast<const RtcpFbHeader *>(header);
+			sum += fb->packetSenderSSRC() + fb->mediaSourceSSRC();
+			if (pt == 205 && count == 1) {
+				auto nack = reinterpret_cast<RtcpNack *>(const_cast<RtcpHeader *>(header));
+				const unsigned int seqNoCount = nack->getSeqNoCount();
+				if (length >= RtcpNack::Size(seqNoCount))
+					for (unsigned int i = 0; i < seqNoCount; ++i)
+						for (auto seqNo : nack->parts[i].getSequenceNumbers())
+							sum += seqNo;
+			}
+		}
+
+		if (length == 0)
+			break;
+
+		offset += length;
+	}
+	Sink = Sink + sum;
+}
+
+shared_ptr<MediaHandler> makeChain() {
+	auto config = std::make_shared<RtpPacketizationConfig>(1, "fuzz", 96, 90000);
+	auto chain = std::make_shared<RtcpReceivingSession>();
+	chain->addToChain(std::make_shared<RtcpNackResponder>());
+	chain->addToChain(std::make_shared<RtcpSrReporter>(config));
+	chain->addToChain(std::make_shared<RembHandler>([](unsigned int bitrate) { Sink = bitrate; }));
+	chain->addToChain(std::make_shared<PliHandler>([]() { Sink = Sink + 1; }));
+	chain->addToChain(std::make_shared<TwccHandler>());
+	chain->addToChain(std::make_shared<GccHandler>());
+	chain->addToChain(std::make_shared<RtcpCcfbReporter>());
+	return chain;
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	static const auto chain = makeChain();
+	const message_callback ignore = [](message_ptr) {};
+
+	auto bytes = reinterpret_cast<const byte *>(data);
+	walk(bytes, size);
+
+	message_vector messages;
+	messages.push_back(make_message(bytes, bytes + size, Message::Control));
+	chain->incomingChain(messages, ignore);
+	return 0;
+}
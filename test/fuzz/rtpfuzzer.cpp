@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Fuzzing harness for RTP packets: header extension walking, then depacketization and receiving
+// media handlers as received from the peer
+
+#include "rtc/rtc.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace rtc;
+
+namespace {
+
+volatile uint64_t Sink = 0;
+
+// Looks up every header extension id after the same bounds checks as the library, so
+// out-of-bounds reads are caught by the address sanitizer
+void walk(const byte *data, size_t size) {
+	if (size < sizeof(RtpHeader))
+		return;
+
+	auto rtp = reinterpret_cast<const RtpHeader *>(data);
+	if (rtp->getSize() > size || !rtp->extension())
+		return;
+
+	if (rtp->getSize() + sizeof(RtpExtensionHeader) > size ||
+	    rtp->getSize() + rtp->getExtensionHeaderSize() > size)
+		return;
+
+	uint64_t sum = 0;
+	auto extension = rtp->getExtensionHeader();
+	for (uint8_t id = 1; id < 15; ++id) {
+		size_t valueSize = 0;
+		if (auto value = extension->findHeader(id, valueSize))
+			for (size_t i = 0; i < valueSize; ++i)
+				sum += uint8_t(value[i]);
+	}
+	Sink = Sink + sum;
+}
+
+std::vector<shared_ptr<MediaHandler>> makeChains() {
+	std::vector<shared_ptr<MediaHandler>> chains;
+	chains.push_back(std::make_shared<H264RtpDepacketizer>());
+	chains.push_back(std::make_shared<H265RtpDepacketizer>());
+	chains.push_back(std::make_shared<OpusRtpDepacketizer>());
+
+	auto receiving = std::make_shared<RtcpReceivingSession>();
+	receiving->addToChain(std::make_shared<TwccHandler>());
+	receiving->addToChain(std::make_shared<RtcpCcfbReporter>());
+	receiving->addToChain(std::make_shared<FlexFecDecoder>());
+	chains.push_back(std::move(receiving));
+	return chains;
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	static const auto chains = makeChains();
+	const message_callback ignore = [](message_ptr) {};
+
+	auto bytes = reinterpret_cast<const byte *>(data);
+	walk(bytes, size);
+
+	// The chains are stateful, so successive inputs are reassembled together like a stream
+	for (const auto &chain : chains) {
+		message_vector messages;
+		messages.push_back(make_message(bytes, bytes + size, Message::Binary));
+		chain->incomingChain(messages, ignore);
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Driver for fuzzing harnesses built without libFuzzer, for instance with GCC
+// Usage: <fuzzer> [--iterations=<count>] <file|directory>...
+// Each input, like a corpus entry or a crash reproducer, is run iterations times, then the
+// throughput is reported, so the harness doubles as a benchmark of the parsers.
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace fs = std::filesystem;
+using std::chrono::steady_clock;
+
+int main(int argc, char **argv) {
+	unsigned long iterations = 1;
+	std::vector<fs::path> paths;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg.rfind("--iterations=", 0) == 0)
+			iterations = std::stoul(arg.substr(13));
+		else if (!fs::is_directory(arg))
+			paths.emplace_back(arg);
+		else
+			for (const auto &entry : fs::directory_iterator(arg))
+				if (entry.is_regular_file())
+					paths.push_back(entry.path());
+	}
+
+	if (paths.empty()) {
+		std::cerr << "Usage: " << argv[0] << " [--iterations=<count>] <file|directory>..."
+		          << std::endl;
+		return 1;
+	}
+
+	std::vector<std::vector<uint8_t>> inputs;
+	size_t totalSize = 0;
+	for (const auto &path : paths) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			std::cerr << "Unable to read " << path << std::endl;
+			return 1;
+		}
+		inputs.emplace_back(std::istreambuf_iterator<char>(file),
+		                    std::istreambuf_iterator<char>());
+		totalSize += inputs.back().size();
+	}
+
+	const auto start = steady_clock::now();
+	for (unsigned long i = 0; i < iterations; ++i)
+		for (const auto &input : inputs)
+			LLVMFuzzerTestOneInput(input.data(), input.size());
+
+	const double seconds = std::chrono::duration<double>(steady_clock::now() - start).count();
+	const double runs = double(iterations) * double(inputs.size());
+	std::cout << "Ran " << inputs.size() << " inputs " << iterations << " times in " << seconds
+	          << " s: " << (seconds > 0 ? runs / seconds : 0.) << " exec/s, "
+	          << (seconds > 0 ? double(totalSize) * double(iterations) / seconds / 1e6 : 0.)
+	          << " MB/s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include "impl/gccestimator.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using impl::GccEstimator;
+using PacketResult = GccEstimator::PacketResult;
+
+namespace {
+
+const double StartBitrate = 300000.;
+const double MinBitrate = 30000.;
+const double MaxBitrate = 5000000.;
+
+// Synthetic link: a packet of 1200 bytes every 10ms, reported every 10 packets
+struct Link {
+	GccEstimator estimator{StartBitrate, MinBitrate, MaxBitrate};
+	GccEstimator::clock::time_point origin = GccEstimator::clock::now();
+	chrono::microseconds elapsed = 0us;
+	chrono::microseconds delay = 50ms; // one-way delay
+	uint16_t sequenceNumber = 0;
+
+	// Runs for the duration, the delay grows by delayGrowth per packet and one packet out of
+	// lossInterval is lost, returns the target bitrates after each feedback
+	vector<double> run(chrono::milliseconds duration, chrono::microseconds delayGrowth = 0us,
+	                   int lossInterval = 0) {
+		vector<double> targets;
+		vector<PacketResult> results;
+		const auto end = elapsed + duration;
+		while (elapsed < end) {
+			PacketResult result;
+			result.sequenceNumber = sequenceNumber++;
+			result.sendTime = origin + elapsed;
+			result.size = 1200;
+			result.received = lossInterval == 0 || result.sequenceNumber % lossInterval != 0;
+			if (result.received)
+				result.arrivalTime = elapsed + delay;
+
+			results.push_back(result);
+			delay += delayGrowth;
+			elapsed += 10ms;
+
+			if (results.size() == 10) {
+				estimator.update(results, origin + elapsed + delay);
+				targets.push_back(estimator.targetBitrate());
+				results.clear();
+			}
+		}
+		return targets;
+	}
+};
+
+} // namespace
+
+TestResult test_gcc_estimator() {
+	try {
+		// A steady delay keeps increasing the bitrate from the start, up to what goes through
+		{
+			Link link;
+			if (link.estimator.targetBitrate() != StartBitrate || !link.estimator.isStartup())
+				return TestResult(false, "Wrong initial state");
+
+			auto targets = link.run(5s);
+			for (size_t i = 1; i < targets.size(); ++i)
+				if (targets[i] < targets[i - 1])
+					return TestResult(false, "Bitrate decreased with a steady delay");
+
+			// The acknowledged bitrate is 960kbps, the estimate is capped at 1.5 times that
+			const double target = link.estimator.targetBitrate();
+			if (target < 2. * StartBitrate || target > 1.5 * 960000. + 10000. + 1.)
+				return TestResult(false, "Wrong bitrate after a steady delay");
+
+			if (!link.estimator.isStartup() || !link.estimator.isIncreasing())
+				return TestResult(false, "Startup ended without congestion");
+		}
+
+		// A rising delay is detected as overuse, and the bitrate goes below what goes through
+		{
+			// Long enough for the delay-based estimate to be the limit, the loss-based one
+			// increases slower
+			Link link;
+			link.run(8s);
+			const double before = link.estimator.targetBitrate();
+
+			// 2ms more for each packet sent every 10ms
+			auto targets = link.run(1s, 2ms);
+			const double after = link.estimator.targetBitrate();
+			if (after >= before || link.estimator.isStartup())
+				return TestResult(false, "No decrease on a rising delay");
+
+			// The decrease is multiplicative, relative to the acknowledged bitrate of 800kbps
+			if (after > 0.85 * 960000. || after < 0.5 * 800000.)
+				return TestResult(false, "Wrong bitrate after overuse");
+
+			// Once the delay is steady again, the bitrate does not decrease anymore
+			link.run(2s);
+			targets = link.run(2s);
+			for (size_t i = 1; i < targets.size(); ++i)
+				if (targets[i] < targets[i - 1])
+					return TestResult(false, "Bitrate decreased after the delay settled");
+		}
+
+		// A high loss rate backs off the bitrate, down to the minimum
+		{
+			Link link;
+			link.run(1s);
+			const double before = link.estimator.targetBitrate();
+
+			// 20% loss decreases by 10% every 20 packets
+			link.run(200ms, 0us, 5);
+			const double after = link.estimator.targetBitrate();
+			if (after > 0.9 * before + 1. || link.estimator.isStartup())
+				return TestResult(false, "No backoff on loss");
+
+			link.run(20s, 0us, 5);
+			if (link.estimator.targetBitrate() != MinBitrate)
+				return TestResult(false, "Bitrate not clamped to the minimum on loss");
+
+			// A low loss rate lets it increase again
+			link.run(2s, 0us, 100);
+			if (link.estimator.targetBitrate() <= MinBitrate)
+				return TestResult(false, "No increase after loss stopped");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
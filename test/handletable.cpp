@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "impl/handletable.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::HandleTable;
+
+namespace {
+
+// Counts live objects, so releases can be checked
+struct Counted {
+	Counted(int value_, std::atomic<int> &live_) : value(value_), live(live_) { ++live; }
+	~Counted() { --live; }
+
+	const int value;
+	std::atomic<int> &live;
+};
+
+} // namespace
+
+TestResult test_handle_table() {
+	try {
+		std::atomic<int> live = 0;
+		HandleTable<Counted> table;
+
+		// Handles are positive and unique, also across chunks of slots
+		vector<int> ids;
+		std::set<int> unique;
+		for (int i = 0; i < 3000; ++i) {
+			int id = table.emplace(i, live);
+			if (id <= 0 || !unique.insert(id).second)
+				return TestResult(false, "Invalid or duplicate handle");
+
+			ids.push_back(id);
+		}
+
+		for (int i = 0; i < 3000; ++i) {
+			auto object = table.get(ids[i]);
+			if (!object || object->value != i)
+				return TestResult(false, "Handle does not resolve to its object");
+		}
+
+		if (table.get(0) || table.get(-1) || table.get(ids.back() + 1) ||
+		    table.get(int(0x7FFFFFFF)))
+			return TestResult(false, "Invalid handle resolved");
+
+		// Erased objects are released once not referenced anymore
+		auto erased = table.erase(ids[10]);
+		if (!erased || erased->value != 10 || table.get(ids[10]) || table.erase(ids[10]))
+			return TestResult(false, "Erased handle still resolves");
+
+		if (live != 3000)
+			return TestResult(false, "Object released while still referenced");
+
+		erased.reset();
+		if (live != 2999)
+			return TestResult(false, "Erased object not released");
+
+		// A reused slot gets a new generation, so a stale handle does not resolve to the new object
+		int reused = table.emplace(-1, live);
+		if ((reused & 0xFFFFF) != (ids[10] & 0xFFFFF) || reused == ids[10])
+			return TestResult(false, "Slot not reused with a new generation");
+
+		if (table.get(ids[10]) || table.erase(ids[10]))
+			return TestResult(false, "Stale handle resolves to a reused slot");
+
+		auto object = table.get(reused);
+		if (!object || object->value != -1)
+			return TestResult(false, "Handle of a reused slot does not resolve");
+
+		object.reset();
+
+		// Clear releases everything
+		auto cleared = table.clear();
+		if (cleared.size() != 3000 || table.get(ids[0]) || table.get(reused))
+			return TestResult(false, "Handles not cleared");
+
+		cleared.clear();
+		if (live != 0)
+			return TestResult(false, "Cleared objects not released");
+
+		// Concurrent lookups against emplace and erase, sanitizers detect any use after release
+		std::atomic<bool> stop = false;
+		std::atomic<int> current = table.emplace(0, live);
+		std::atomic<bool> mismatch = false;
+		vector<std::thread> readers;
+		for (int t = 0; t < 4; ++t) {
+			readers.emplace_back([&]() {
+				while (!stop) {
+					int id = current.load();
+					if (auto o = table.get(id); o && (o->value < 0 || o->value >= 20000))
+						mismatch = true;
+				}
+			});
+		}
+
+		for (int i = 1; i < 20000; ++i) {
+			int id = table.emplace(i, live);
+			table.erase(current.exchange(id));
+		}
+		stop = true;
+		for (auto &reader : readers)
+			reader.join();
+
+		if (mismatch)
+			return TestResult(false, "Wrong object resolved concurrently");
+
+		table.erase(current);
+		if (live != 0)
+			return TestResult(false, "Objects leaked by concurrent operations");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
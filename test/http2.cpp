@@ -0,0 +1,584 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include "impl/hpack.hpp"
+#include "impl/http2transport.hpp"
+#include "impl/wshandshake.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::HeaderList;
+using impl::HpackDecoder;
+using impl::HpackEncoder;
+using impl::Http2Stream;
+using impl::Http2Transport;
+using impl::Transport;
+
+namespace {
+
+binary fromHex(const string &hex) {
+	binary data;
+	string digits;
+	for (char c : hex)
+		if (c != ' ')
+			digits.push_back(c);
+
+	for (size_t i = 0; i + 1 < digits.size(); i += 2)
+		data.push_back(byte(std::stoi(digits.substr(i, 2), nullptr, 16)));
+
+	return data;
+}
+
+HeaderList decode(HpackDecoder &decoder, const binary &block) {
+	return decoder.decode(block.data(), block.size());
+}
+
+bool isInvalid(HpackDecoder &decoder, const binary &block) {
+	try {
+		decode(decoder, block);
+		return false;
+	} catch (const std::invalid_argument &) {
+		return true;
+	}
+}
+
+// RFC 7541 Appendix C.3 and C.4, the same requests without and with Huffman coding
+const vector<HeaderList> Requests = {
+    {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}},
+    {{":method", "GET"},
+     {":scheme", "http"},
+     {":path", "/"},
+     {":authority", "www.example.com"},
+     {"cache-control", "no-cache"}},
+    {{":method", "GET"},
+     {":scheme", "https"},
+     {":path", "/index.html"},
+     {":authority", "www.example.com"},
+     {"custom-key", "custom-value"}},
+};
+
+const vector<string> RequestsPlain = {
+    "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d",
+    "8286 84be 5808 6e6f 2d63 6163 6865",
+    "8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65",
+};
+
+const vector<string> RequestsHuffman = {
+    "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff",
+    "8286 84be 5886 a8eb 1064 9cbf",
+    "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf",
+};
+
+// RFC 7541 Appendix C.5 and C.6, the same responses without and with Huffman coding, with a
+// dynamic table of 256 bytes so entries are evicted
+const string Date1 = "Mon, 21 Oct 2013 20:13:21 GMT";
+const string Date2 = "Mon, 21 Oct 2013 20:13:22 GMT";
+const string Location = "https://www.example.com";
+const string Cookie = "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1";
+
+const vector<HeaderList> Responses = {
+    {{":status", "302"}, {"cache-control", "private"}, {"date", Date1}, {"location", Location}},
+    {{":status", "307"}, {"cache-control", "private"}, {"date", Date1}, {"location", Location}},
+    {{":status", "200"},
+     {"cache-control", "private"},
+     {"date", Date2},
+     {"location", Location},
+     {"content-encoding", "gzip"},
+     {"set-cookie", Cookie}},
+};
+
+const vector<string> ResponsesPlain = {
+    "4803 3330 3258 0770 7269 7661 7465 611d 4d6f 6e2c 2032 3120 4f63 7420 3230 3133 2032 303a "
+    "3133 3a32 3120 474d 546e 1768 7474 7073 3a2f 2f77 7777 2e65 7861 6d70 6c65 2e63 6f6d",
+    "4803 3330 37c1 c0bf",
+    "88c1 611d 4d6f 6e2c 2032 3120 4f63 7420 3230 3133 2032 303a 3133 3a32 3220 474d 54c0 5a04 "
+    "677a 6970 7738 666f 6f3d 4153 444a 4b48 514b 425a 584f 5157 454f 5049 5541 5851 5745 4f49 "
+    "553b 206d 6178 2d61 6765 3d33 3630 303b 2076 6572 7369 6f6e 3d31",
+};
+
+const vector<string> ResponsesHuffman = {
+    "4882 6402 5885 aec3 771a 4b61 96d0 7abe 9410 54d4 44a8 2005 9504 0b81 66e0 82a6 2d1b ff6e "
+    "919d 29ad 1718 63c7 8f0b 97c8 e9ae 82ae 43d3",
+    "4883 640e ffc1 c0bf",
+    "88c1 6196 d07a be94 1054 d444 a820 0595 040b 8166 e084 a62d 1bff c05a 839b d9ab 77ad 94e7 "
+    "821d d7f2 e6c7 b335 dfdf cd5b 3960 d5af 2708 7f36 72c1 ab27 0fb5 291f 9587 3160 65c0 03ed "
+    "4ee5 b106 3d50 07",
+};
+
+enum : uint8_t {
+	DATA = 0x0,
+	HEADERS = 0x1,
+	SETTINGS = 0x4,
+	PUSH_PROMISE = 0x5,
+	PING = 0x6,
+	GOAWAY = 0x7,
+	WINDOW_UPDATE = 0x8,
+	CONTINUATION = 0x9,
+};
+
+enum : uint8_t {
+	FLAG_END_STREAM = 0x1,
+	FLAG_ACK = 0x1,
+	FLAG_END_HEADERS = 0x4,
+	FLAG_PADDED = 0x8,
+	FLAG_PRIORITY = 0x20,
+};
+
+const string ClientPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+struct Frame {
+	uint8_t type;
+	uint8_t flags;
+	uint32_t id;
+	binary payload;
+};
+
+uint32_t readUint32(const binary &data, size_t offset) {
+	auto p = reinterpret_cast<const uint8_t *>(data.data() + offset);
+	return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+void appendUint32(binary &out, uint32_t value) {
+	for (int shift = 24; shift >= 0; shift -= 8)
+		out.push_back(byte((value >> shift) & 0xFF));
+}
+
+binary makeFrame(uint8_t type, uint8_t flags, uint32_t id, const binary &payload = {}) {
+	binary out;
+	const size_t length = payload.size();
+	out.push_back(byte((length >> 16) & 0xFF));
+	out.push_back(byte((length >> 8) & 0xFF));
+	out.push_back(byte(length & 0xFF));
+	out.push_back(byte(type));
+	out.push_back(byte(flags));
+	appendUint32(out, id);
+	out.insert(out.end(), payload.begin(), payload.end());
+	return out;
+}
+
+binary makeSettings(const vector<pair<uint16_t, uint32_t>> &settings) {
+	binary payload;
+	for (auto [id, value] : settings) {
+		payload.push_back(byte(id >> 8));
+		payload.push_back(byte(id & 0xFF));
+		appendUint32(payload, value);
+	}
+	return makeFrame(SETTINGS, 0, 0, payload);
+}
+
+vector<Frame> parseFrames(const binary &data, size_t offset = 0) {
+	vector<Frame> frames;
+	while (data.size() - offset >= 9) {
+		auto p = reinterpret_cast<const uint8_t *>(data.data() + offset);
+		const size_t length = size_t(p[0]) << 16 | size_t(p[1]) << 8 | p[2];
+		if (data.size() - offset < 9 + length)
+			throw std::runtime_error("Truncated HTTP/2 frame sent");
+
+		Frame frame;
+		frame.type = p[3];
+		frame.flags = p[4];
+		frame.id = readUint32(data, offset + 5) & 0x7FFFFFFF;
+		frame.payload.assign(data.begin() + offset + 9, data.begin() + offset + 9 + length);
+		frames.push_back(std::move(frame));
+		offset += 9 + length;
+	}
+	if (offset != data.size())
+		throw std::runtime_error("Truncated HTTP/2 frame header sent");
+
+	return frames;
+}
+
+// Connected transport standing for TLS, recording what is sent
+class FakeLower final : public Transport {
+public:
+	FakeLower() { changeState(State::Connected); }
+
+	bool send(message_ptr message) override {
+		std::lock_guard lock(mMutex);
+		mSent.insert(mSent.end(), message->begin(), message->end());
+		return true;
+	}
+
+	void inject(const binary &data) { recv(make_message(data.begin(), data.end())); }
+
+	binary take() {
+		std::lock_guard lock(mMutex);
+		return std::exchange(mSent, binary());
+	}
+
+	vector<Frame> takeFrames() { return parseFrames(take()); }
+
+private:
+	std::mutex mMutex;
+	binary mSent;
+};
+
+const pair<uint16_t, uint32_t> EnableConnectProtocol = {0x8, 1};
+
+// Returns the error code of the GOAWAY sent in response to the frames, or -1 if there is none
+int64_t connectionError(const binary &frames, bool settings = true) {
+	auto lower = make_shared<FakeLower>();
+	auto session = make_shared<Http2Transport>(lower, "http2 test;errors");
+	session->start();
+	lower->take();
+	if (settings) {
+		lower->inject(makeSettings({EnableConnectProtocol}));
+		lower->take();
+	}
+
+	lower->inject(frames);
+	for (const auto &frame : lower->takeFrames())
+		if (frame.type == GOAWAY && frame.payload.size() >= 8)
+			return session->state() == Transport::State::Disconnected
+			           ? int64_t(readUint32(frame.payload, 4))
+			           : -1;
+
+	return -1;
+}
+
+} // namespace
+
+TestResult test_hpack() {
+	try {
+		// RFC 7541 Appendix C.2
+		{
+			HpackDecoder decoder;
+			const auto literal =
+			    fromHex("400a 6375 7374 6f6d 2d6b 6579 0d63 7573 746f 6d2d 6865 6164 6572");
+			if (decode(decoder, literal) != HeaderList{{"custom-key", "custom-header"}})
+				return TestResult(false, "Wrong literal with indexing");
+
+			// The field was indexed
+			if (decode(decoder, fromHex("be")) != HeaderList{{"custom-key", "custom-header"}})
+				return TestResult(false, "Literal with indexing not indexed");
+
+			if (decode(decoder, fromHex("040c 2f73 616d 706c 652f 7061 7468")) !=
+			    HeaderList{{":path", "/sample/path"}})
+				return TestResult(false, "Wrong literal without indexing");
+
+			if (decode(decoder, fromHex("1008 7061 7373 776f 7264 0673 6563 7265 74")) !=
+			    HeaderList{{"password", "secret"}})
+				return TestResult(false, "Wrong literal never indexed");
+
+			if (decode(decoder, fromHex("82")) != HeaderList{{":method", "GET"}})
+				return TestResult(false, "Wrong indexed field");
+
+			// Neither of the last literals was indexed
+			if (!isInvalid(decoder, fromHex("bf")))
+				return TestResult(false, "Literal without indexing indexed");
+		}
+
+		// RFC 7541 Appendix C.3 and C.4, each decoder keeps its table across requests
+		for (const auto *blocks : {&RequestsPlain, &RequestsHuffman}) {
+			HpackDecoder decoder;
+			for (size_t i = 0; i < blocks->size(); ++i)
+				if (decode(decoder, fromHex((*blocks)[i])) != Requests[i])
+					return TestResult(false, "Wrong request " + to_string(i + 1) +
+					                             (blocks == &RequestsHuffman ? " (Huffman)" : ""));
+		}
+
+		// RFC 7541 Appendix C.5 and C.6, with eviction
+		for (const auto *blocks : {&ResponsesPlain, &ResponsesHuffman}) {
+			HpackDecoder decoder(256);
+			for (size_t i = 0; i < blocks->size(); ++i)
+				if (decode(decoder, fromHex((*blocks)[i])) != Responses[i])
+					return TestResult(false, "Wrong response " + to_string(i + 1) +
+					                             (blocks == &ResponsesHuffman ? " (Huffman)" : ""));
+
+			// Only the last three entries are left
+			if (decode(decoder, fromHex("bebf c0")) !=
+			    HeaderList{{"set-cookie", Cookie}, {"content-encoding", "gzip"}, {"date", Date2}})
+				return TestResult(false, "Wrong dynamic table after eviction");
+
+			if (!isInvalid(decoder, fromHex("c1")))
+				return TestResult(false, "Evicted entry still indexed");
+
+			// A size update to 0 empties the table
+			if (!decode(decoder, fromHex("20")).empty() || !isInvalid(decoder, fromHex("be")))
+				return TestResult(false, "Table not emptied by a size update");
+		}
+
+		// Size updates must be at the beginning of a block and within the advertised size
+		{
+			HpackDecoder decoder(256);
+			if (decode(decoder, fromHex("3fe101 82")) != HeaderList{{":method", "GET"}})
+				return TestResult(false, "Valid size update rejected");
+
+			if (!isInvalid(decoder, fromHex("3fe201")))
+				return TestResult(false, "Size update above the maximum accepted");
+
+			if (!isInvalid(decoder, fromHex("82 20")))
+				return TestResult(false, "Size update after a field accepted");
+		}
+
+		// Invalid blocks
+		{
+			HpackDecoder decoder;
+			const vector<pair<string, string>> invalid = {
+			    {"80", "Index 0"},
+			    {"be", "Index out of range"},
+			    {"ff", "Truncated integer"},
+			    {"ff80 8080 8080", "Integer overflow"},
+			    {"0005 61", "Truncated string"},
+			    {"0084 ffff ffff 00", "Huffman EOS"},
+			    {"0081 1800", "Huffman padding with zeros"},
+			    {"0082 1fff 00", "Huffman padding of 8 bits"},
+			};
+			for (const auto &[hex, description] : invalid)
+				if (!isInvalid(decoder, fromHex(hex)))
+					return TestResult(false, description + " accepted");
+
+			// "a" with valid padding
+			if (decode(decoder, fromHex("0081 1f00")) != HeaderList{{"a", ""}})
+				return TestResult(false, "Valid Huffman padding rejected");
+
+			binary block;
+			HpackEncoder::Encode({{"a", string(HpackDecoder::MaxHeaderListSize, 'x')}}, block);
+			if (!isInvalid(decoder, block))
+				return TestResult(false, "Header list above the maximum size accepted");
+		}
+
+		// The encoder uses the static table and never indexes
+		{
+			binary block;
+			HpackEncoder::Encode({{":method", "GET"}, {":path", "/chat"}}, block);
+			if (block != fromHex("82 0405 2f63 6861 74"))
+				return TestResult(false, "Wrong encoding");
+
+			HeaderList headers = {{":method", "CONNECT"},
+			                      {":protocol", "websocket"},
+			                      {":authority", "example.com"},
+			                      {"long-value", string(300, 'v')}};
+			block.clear();
+			HpackEncoder::Encode(headers, block);
+			HpackDecoder decoder;
+			if (decode(decoder, block) != headers || decode(decoder, block) != headers ||
+			    !isInvalid(decoder, fromHex("be")))
+				return TestResult(false, "Encoded fields indexed or not decoded");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_http2_frames() {
+	InitLogger(LogLevel::Debug);
+
+	try {
+		const string key = "http2 test;example.com;443";
+		auto lower = make_shared<FakeLower>();
+		auto session = make_shared<Http2Transport>(lower, key);
+		session->start();
+
+		// The preface is followed by settings and the connection window update
+		auto sent = lower->take();
+		if (sent.size() < ClientPreface.size() ||
+		    string(reinterpret_cast<const char *>(sent.data()), ClientPreface.size()) !=
+		        ClientPreface)
+			return TestResult(false, "Client preface not sent");
+
+		auto frames = parseFrames(sent, ClientPreface.size());
+		if (frames.size() != 2 || frames[0].type != SETTINGS || frames[0].flags != 0 ||
+		    frames[0].payload != fromHex("0002 0000 0000 0004 0010 0000") ||
+		    frames[1].type != WINDOW_UPDATE || frames[1].id != 0 ||
+		    readUint32(frames[1].payload, 0) != uint32_t((1 << 24) - 65535))
+			return TestResult(false, "Wrong initial frames");
+
+		if (Http2Transport::Find(key) != session)
+			return TestResult(false, "Connection not registered");
+
+		// The stream waits for the server settings
+		std::mutex mutex;
+		binary received;
+		std::atomic<bool> closed = false;
+		std::atomic<Transport::State> streamState = Transport::State::Disconnected;
+		auto handshake = make_shared<impl::WsHandshake>("example.com", "/chat");
+		auto stateCallback = [&streamState](Transport::State state) { streamState = state; };
+		auto stream = make_shared<Http2Stream>(session, handshake, stateCallback);
+		stream->onRecv([&](message_ptr message) {
+			if (!message) {
+				closed = true;
+				return;
+			}
+			std::lock_guard lock(mutex);
+			received.insert(received.end(), message->begin(), message->end());
+		});
+		stream->start();
+		if (!lower->take().empty())
+			return TestResult(false, "Stream opened before settings");
+
+		// Server settings, split across messages, with a stream window of 10 bytes
+		const auto settings = makeSettings({EnableConnectProtocol, {0x4, 10}});
+		for (auto b : settings)
+			lower->inject(binary{b});
+
+		frames = lower->takeFrames();
+		if (frames.size() != 2 || frames[0].type != SETTINGS || frames[0].flags != FLAG_ACK ||
+		    !frames[0].payload.empty() || frames[1].type != HEADERS || frames[1].id != 1 ||
+		    frames[1].flags != FLAG_END_HEADERS)
+			return TestResult(false, "Settings not acknowledged or stream not opened");
+
+		HpackDecoder decoder;
+		if (decode(decoder, frames[1].payload) != handshake->generateHttp2Request())
+			return TestResult(false, "Wrong extended CONNECT request");
+
+		// Response headers, padded with priority and followed by a CONTINUATION frame
+		binary block;
+		HpackEncoder::Encode({{":status", "200"}, {"server", "test"}}, block);
+		binary payload = {byte(3), byte(0), byte(0), byte(0), byte(0), byte(0)};
+		payload.push_back(block.front());
+		payload.insert(payload.end(), 3, byte(0));
+		binary response = makeFrame(HEADERS, FLAG_PADDED | FLAG_PRIORITY, 1, payload);
+		const auto continuation =
+		    makeFrame(CONTINUATION, FLAG_END_HEADERS, 1, binary(block.begin() + 1, block.end()));
+		response.insert(response.end(), continuation.begin(), continuation.end());
+		lower->inject(response);
+		if (streamState != Transport::State::Connected)
+			return TestResult(false, "Stream not connected after the response");
+
+		// Padded data is delivered without padding
+		lower->inject(makeFrame(DATA, FLAG_PADDED, 1, fromHex("02 6865 6c6c 6f 0000")));
+		{
+			std::lock_guard lock(mutex);
+			if (string(reinterpret_cast<const char *>(received.data()), received.size()) != "hello")
+				return TestResult(false, "Wrong data received on the stream");
+		}
+
+		// Pings are acknowledged with the same payload
+		const auto ping = fromHex("0102 0304 0506 0708");
+		lower->inject(makeFrame(PING, 0, 0, ping));
+		frames = lower->takeFrames();
+		if (frames.size() != 1 || frames[0].type != PING || frames[0].flags != FLAG_ACK ||
+		    frames[0].payload != ping)
+			return TestResult(false, "Ping not acknowledged");
+
+		// Data is sent within the stream window, then the rest after a window update
+		stream->send(make_message(binary(100, byte(0x42))));
+		frames = lower->takeFrames();
+		if (frames.size() != 1 || frames[0].type != DATA || frames[0].id != 1 ||
+		    frames[0].payload != binary(10, byte(0x42)))
+			return TestResult(false, "Data not limited by the stream window");
+
+		binary increment;
+		appendUint32(increment, 1000);
+		lower->inject(makeFrame(WINDOW_UPDATE, 0, 1, increment));
+		frames = lower->takeFrames();
+		if (frames.size() != 1 || frames[0].type != DATA || frames[0].payload.size() != 90)
+			return TestResult(false, "Data not sent after the window update");
+
+		// The server closes the stream
+		lower->inject(makeFrame(DATA, FLAG_END_STREAM, 1));
+		if (!closed || streamState != Transport::State::Disconnected)
+			return TestResult(false, "Stream not closed by the server");
+
+		// A waiting stream released by its owner is closed once opened, outside of the lock
+		{
+			auto lower = make_shared<FakeLower>();
+			auto session = make_shared<Http2Transport>(lower, "http2 test;released");
+			session->start();
+			lower->take();
+
+			auto stream = make_shared<Http2Stream>(
+			    session, make_shared<impl::WsHandshake>("example.com", "/"), nullptr);
+			stream->start();
+			stream.reset();
+
+			lower->inject(makeSettings({EnableConnectProtocol}));
+			frames = lower->takeFrames();
+			if (frames.size() != 3 || frames[1].type != HEADERS || frames[2].type != DATA ||
+			    frames[2].id != 1 || frames[2].flags != FLAG_END_STREAM)
+				return TestResult(false, "Released stream not closed");
+		}
+
+		// Waiting streams fail if the server does not support extended CONNECT
+		{
+			const string unsupportedKey = "http2 test;unsupported";
+			auto lower = make_shared<FakeLower>();
+			auto session = make_shared<Http2Transport>(lower, unsupportedKey);
+			session->start();
+
+			std::atomic<bool> failed = false;
+			auto stream = make_shared<Http2Stream>(
+			    session, make_shared<impl::WsHandshake>("example.com", "/"),
+			    [&failed](Transport::State state) { failed = state == Transport::State::Failed; });
+			stream->start();
+			lower->inject(makeSettings({}));
+			if (!failed || !stream->isUnsupported())
+				return TestResult(false, "Stream not failed without extended CONNECT");
+
+			if (!Http2Transport::IsUnsupported(unsupportedKey) ||
+			    Http2Transport::Find(unsupportedKey))
+				return TestResult(false, "Connection without extended CONNECT still available");
+		}
+
+		// Protocol errors close the connection with GOAWAY
+		const int64_t ProtocolError = 0x1, FlowControlError = 0x3, FrameSizeError = 0x6,
+		              CompressionError = 0x9;
+
+		if (connectionError(makeFrame(DATA, 0, 1), false) != ProtocolError)
+			return TestResult(false, "Frame before settings accepted");
+
+		if (connectionError(fromHex("004001 00 00 00000001")) != FrameSizeError)
+			return TestResult(false, "Frame above the maximum size accepted");
+
+		if (connectionError(makeFrame(PUSH_PROMISE, FLAG_END_HEADERS, 1, fromHex("0000 0002"))) !=
+		    ProtocolError)
+			return TestResult(false, "Push promise accepted");
+
+		binary interleaved = makeFrame(HEADERS, 0, 1, fromHex("88"));
+		const auto data = makeFrame(DATA, 0, 1, fromHex("00"));
+		interleaved.insert(interleaved.end(), data.begin(), data.end());
+		if (connectionError(interleaved) != ProtocolError)
+			return TestResult(false, "Frame interleaved in a header block accepted");
+
+		if (connectionError(makeFrame(HEADERS, FLAG_END_HEADERS, 1, fromHex("80"))) !=
+		    CompressionError)
+			return TestResult(false, "Invalid header block accepted");
+
+		if (connectionError(makeFrame(DATA, 0, 0, fromHex("00"))) != ProtocolError)
+			return TestResult(false, "Data on stream 0 accepted");
+
+		if (connectionError(makeFrame(SETTINGS, 0, 0, fromHex("0004 0000 00"))) != FrameSizeError)
+			return TestResult(false, "Truncated settings accepted");
+
+		if (connectionError(makeFrame(PING, 0, 0, fromHex("0102 0304"))) != ProtocolError)
+			return TestResult(false, "Short ping accepted");
+
+		if (connectionError(makeFrame(WINDOW_UPDATE, 0, 0, fromHex("0000 0000"))) != ProtocolError)
+			return TestResult(false, "Zero window increment accepted");
+
+		if (connectionError(makeFrame(WINDOW_UPDATE, 0, 0, fromHex("7fff ffff"))) !=
+		    FlowControlError)
+			return TestResult(false, "Connection window overflow accepted");
+
+		stream->stop();
+		session->stop();
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
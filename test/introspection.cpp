@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+TestResult test_introspection() {
+	InitLogger(LogLevel::Debug);
+
+	// Keep the library initialized
+	PeerConnection pc;
+
+	// Saturate the pool so that further tasks are queued
+	auto &pool = impl::ThreadPool::Instance();
+	const auto initial = GetThreadPoolStats();
+	if (initial.workers == 0)
+		return TestResult(false, "No thread pool workers");
+
+	promise<void> release;
+	shared_future<void> released = release.get_future().share();
+	std::atomic<size_t> started = 0;
+	for (size_t i = 0; i < initial.workers; ++i)
+		pool.post([released, &started]() {
+			++started;
+			released.wait();
+		});
+
+	int attempts = 100;
+	while (started < initial.workers && attempts--)
+		this_thread::sleep_for(10ms);
+
+	if (started < initial.workers)
+		return TestResult(false, "Blocking tasks not started");
+
+	std::atomic<bool> queuedRun = false;
+	pool.post([&queuedRun]() { queuedRun = true; });
+	auto timer = pool.setTimer(10min, []() {});
+	this_thread::sleep_for(100ms);
+
+	auto saturated = GetThreadPoolStats();
+	release.set_value();
+
+	if (saturated.workers != initial.workers || saturated.busyWorkers != initial.workers)
+		return TestResult(false, "Busy workers not reported");
+
+	if (saturated.queuedTasks < 1 || saturated.oldestTaskAge < 100ms)
+		return TestResult(false, "Queued task or its age not reported");
+
+	if (saturated.pendingTimers < 1)
+		return TestResult(false, "Pending timer not reported");
+
+	attempts = 100;
+	while (!queuedRun && attempts--)
+		this_thread::sleep_for(10ms);
+
+	if (!queuedRun)
+		return TestResult(false, "Queued task not run");
+
+	pool.cancel(timer);
+	this_thread::sleep_for(100ms);
+
+	auto idle = GetThreadPoolStats();
+	if (idle.tasksExecuted < saturated.tasksExecuted + initial.workers + 1 ||
+	    idle.busyWorkers != 0 || idle.queuedTasks != 0 ||
+	    idle.oldestTaskAge != chrono::microseconds::zero() ||
+	    idle.pendingTimers >= saturated.pendingTimers)
+		return TestResult(false, "Idle thread pool stats are wrong");
+
+#if RTC_ENABLE_WEBSOCKET
+	// Sockets of WebSockets are registered with the poll service, which wakes up on events
+	const auto before = GetPollServiceStats();
+
+	WebSocketServer::Configuration serverConfig;
+	serverConfig.port = 48083;
+	serverConfig.bindAddress = "127.0.0.1";
+	WebSocketServer server(std::move(serverConfig));
+
+	shared_ptr<WebSocket> client;
+	server.onClient(
+	    [&client](shared_ptr<WebSocket> incoming) { std::atomic_store(&client, incoming); });
+
+	WebSocket ws;
+	ws.open("ws://127.0.0.1:48083/");
+
+	attempts = 10;
+	while (!ws.isOpen() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!ws.isOpen())
+		return TestResult(false, "WebSocket is not open");
+
+	auto open = GetPollServiceStats();
+	if (open.threads == 0 || open.sockets < before.sockets + 2)
+		return TestResult(false, "WebSocket sockets not registered");
+
+	if (open.wakeups <= before.wakeups || open.busyTime <= before.busyTime)
+		return TestResult(false, "Poll service wakeups not counted");
+
+	ws.close();
+	if (auto c = std::atomic_load(&client))
+		c->close();
+
+	server.stop();
+	this_thread::sleep_for(1s);
+
+	if (GetPollServiceStats().sockets != before.sockets)
+		return TestResult(false, "WebSocket sockets not unregistered");
+#else
+	if (GetPollServiceStats().threads != 0)
+		return TestResult(false, "Poll service stats returned without WebSocket support");
+#endif
+
+	return TestResult(true);
+}
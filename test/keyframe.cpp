@@ -0,0 +1,353 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include "impl/keyframe.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using impl::VideoCodec;
+
+namespace {
+
+// Counts the keyframe requests reaching it, failing them on demand
+class RequestCounter final : public MediaHandler {
+public:
+	bool requestKeyframe(const message_callback &) override {
+		++count;
+		return !fail;
+	}
+
+	std::atomic<int> count = 0;
+	std::atomic<bool> fail = false;
+};
+
+bool isKeyframeStart(VideoCodec codec, vector<uint8_t> payload) {
+	Message message(sizeof(RtpHeader) + payload.size());
+	auto rtp = reinterpret_cast<RtpHeader *>(message.data());
+	rtp->preparePacket();
+	for (size_t i = 0; i < payload.size(); ++i)
+		message[sizeof(RtpHeader) + i] = byte(payload[i]);
+
+	return impl::is_keyframe_start(codec, message, *rtp);
+}
+
+message_ptr makeRtp(SSRC ssrc, uint16_t seq, uint32_t timestamp, vector<uint8_t> payload) {
+	auto message = make_message(sizeof(RtpHeader) + payload.size());
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSeqNumber(seq);
+	rtp->setTimestamp(timestamp);
+	rtp->setSsrc(ssrc);
+	for (size_t i = 0; i < payload.size(); ++i)
+		message->at(sizeof(RtpHeader) + i) = byte(payload[i]);
+
+	return message;
+}
+
+// A connected pair of peer connections with a video track from the first one to the second one
+struct VideoPair {
+	static const SSRC ssrc = 2000;
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+	shared_ptr<Track> track;
+	shared_ptr<Track> remoteTrack;
+
+	std::mutex mutex;
+	vector<binary> received; // RTP packets received by the remote track
+
+	bool connect() {
+		pc1.onLocalDescription([this](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+		pc1.onLocalCandidate(
+		    [this](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+		pc2.onLocalDescription([this](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+		pc2.onLocalCandidate(
+		    [this](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+		pc2.onTrack([this](shared_ptr<Track> t) {
+			t->onMessage(
+			    [this](binary message) {
+				    std::lock_guard lock(mutex);
+				    received.push_back(std::move(message));
+			    },
+			    nullptr);
+			std::atomic_store(&remoteTrack, t);
+		});
+
+		Description::Video media("video", Description::Direction::SendOnly);
+		media.addH264Codec(96);
+		media.addSSRC(ssrc, "video-send");
+		track = pc1.addTrack(media);
+		pc1.setLocalDescription();
+
+		int attempts = 10;
+		shared_ptr<Track> t2;
+		while ((!(t2 = std::atomic_load(&remoteTrack)) || !t2->isOpen() || !track->isOpen()) &&
+		       attempts--)
+			this_thread::sleep_for(1s);
+
+		return t2 && t2->isOpen() && track->isOpen();
+	}
+
+	// Returns the second payload byte of received packets, used as packet id
+	vector<uint8_t> receivedIds(size_t expected) {
+		int attempts = 20;
+		while (attempts--) {
+			{
+				std::lock_guard lock(mutex);
+				if (received.size() >= expected)
+					break;
+			}
+			this_thread::sleep_for(100ms);
+		}
+
+		std::lock_guard lock(mutex);
+		vector<uint8_t> ids;
+		for (const auto &packet : received) {
+			auto rtp = reinterpret_cast<const RtpHeader *>(packet.data());
+			if (packet.size() < rtp->getSize() + 2 || rtp->ssrc() != ssrc)
+				continue;
+
+			ids.push_back(std::to_integer<uint8_t>(packet[rtp->getSize() + 1]));
+		}
+		return ids;
+	}
+
+	void close() {
+		pc1.close();
+		pc2.close();
+		this_thread::sleep_for(1s);
+	}
+};
+
+} // namespace
+
+TestResult test_keyframe_requests() {
+	try {
+		// Requests are forwarded at most once per window
+		auto counter = make_shared<RequestCounter>();
+		auto aggregator = make_shared<KeyframeRequestAggregator>(100ms);
+		aggregator->addToChain(counter);
+
+		const message_callback send = [](message_ptr) {};
+		for (int i = 0; i < 5; ++i)
+			if (!aggregator->requestKeyframe(send))
+				return TestResult(false, "Keyframe request failed");
+
+		if (counter->count != 1 || aggregator->coalescedCount() != 4)
+			return TestResult(false, "Keyframe requests not coalesced");
+
+		this_thread::sleep_for(150ms);
+		aggregator->requestKeyframe(send);
+		if (counter->count != 2 || aggregator->coalescedCount() != 4)
+			return TestResult(false, "Keyframe request not forwarded after the window");
+
+		// A failed request doesn't open a window
+		this_thread::sleep_for(150ms);
+		counter->fail = true;
+		if (aggregator->requestKeyframe(send))
+			return TestResult(false, "Failed keyframe request reported as sent");
+
+		counter->fail = false;
+		if (!aggregator->requestKeyframe(send) || counter->count != 4)
+			return TestResult(false, "Keyframe request coalesced with a failed one");
+
+		aggregator->setWindow(10s);
+		if (!aggregator->requestKeyframe(send) || counter->count != 4 ||
+		    aggregator->coalescedCount() != 5)
+			return TestResult(false, "Keyframe request not coalesced with the new window");
+
+		// Without a next handler, the request can't be sent
+		KeyframeRequestAggregator alone;
+		if (alone.requestKeyframe(send))
+			return TestResult(false, "Keyframe request sent without a next handler");
+
+		// Keyframe detection
+		if (impl::video_codec_from_format("h264") != VideoCodec::H264 ||
+		    impl::video_codec_from_format("VP8") != VideoCodec::VP8 ||
+		    impl::video_codec_from_format("opus") != VideoCodec::Unknown)
+			return TestResult(false, "Wrong video codec from format");
+
+		// H264: single IDR, SPS, non-IDR, STAP-A with SPS, FU-A start and middle of IDR
+		if (!isKeyframeStart(VideoCodec::H264, {0x65, 0x88}) ||
+		    !isKeyframeStart(VideoCodec::H264, {0x67, 0x42}) ||
+		    isKeyframeStart(VideoCodec::H264, {0x41, 0x9A}) ||
+		    !isKeyframeStart(VideoCodec::H264, {0x18, 0x00, 0x02, 0x09, 0xF0, 0x00, 0x02, 0x67,
+		                                        0x42}) ||
+		    isKeyframeStart(VideoCodec::H264, {0x18, 0x00, 0x02, 0x41, 0x9A}) ||
+		    !isKeyframeStart(VideoCodec::H264, {0x7C, 0x85, 0x88}) ||
+		    isKeyframeStart(VideoCodec::H264, {0x7C, 0x05, 0x88}))
+			return TestResult(false, "Wrong H264 keyframe detection");
+
+		// H265: IDR_W_RADL, TRAIL_R, FU start of CRA
+		if (!isKeyframeStart(VideoCodec::H265, {0x26, 0x01, 0xAF}) ||
+		    isKeyframeStart(VideoCodec::H265, {0x02, 0x01, 0xAF}) ||
+		    !isKeyframeStart(VideoCodec::H265, {0x62, 0x01, 0x95, 0xAF}))
+			return TestResult(false, "Wrong H265 keyframe detection");
+
+		// VP8: start of partition 0 with P=0, with P=1, and continuation
+		if (!isKeyframeStart(VideoCodec::VP8, {0x10, 0x00}) ||
+		    isKeyframeStart(VideoCodec::VP8, {0x10, 0x01}) ||
+		    isKeyframeStart(VideoCodec::VP8, {0x00, 0x00}) ||
+		    !isKeyframeStart(VideoCodec::VP8, {0x90, 0x80, 0x81, 0x23, 0x00}))
+			return TestResult(false, "Wrong VP8 keyframe detection");
+
+		// VP9: beginning of a non-inter-predicted frame, and of an inter-predicted one
+		if (!isKeyframeStart(VideoCodec::VP9, {0x08, 0x00}) ||
+		    isKeyframeStart(VideoCodec::VP9, {0x48, 0x00}))
+			return TestResult(false, "Wrong VP9 keyframe detection");
+
+		// AV1: N bit of the aggregation header
+		if (!isKeyframeStart(VideoCodec::AV1, {0x18, 0x0A}) ||
+		    isKeyframeStart(VideoCodec::AV1, {0x10, 0x32}))
+			return TestResult(false, "Wrong AV1 keyframe detection");
+
+		// Empty payload
+		if (isKeyframeStart(VideoCodec::H264, {}))
+			return TestResult(false, "Keyframe detected in an empty payload");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_rtp_forwarder_keyframe_cache() {
+	InitLogger(LogLevel::Debug);
+
+	VideoPair pair;
+	if (!pair.connect())
+		return TestResult(false, "Track is not open");
+
+	Description::Video incoming("video", Description::Direction::RecvOnly);
+	incoming.addH264Codec(96);
+
+	const message_callback send = [](message_ptr) {};
+	auto feed = [&send](RtpForwarder &forwarder, message_ptr message) {
+		message_vector messages{std::move(message)};
+		forwarder.incoming(messages, send);
+	};
+
+	// With the cache, an added track waits for the next keyframe
+	RtpForwarder first;
+	first.media(incoming);
+	first.setKeyframeCache(100000);
+	first.addTrack(pair.track, VideoPair::ssrc);
+	feed(first, makeRtp(7, 1, 1000, {0x41, 1}));
+	feed(first, makeRtp(7, 2, 4000, {0x65, 2}));
+	feed(first, makeRtp(7, 3, 4000, {0x65, 3}));
+	feed(first, makeRtp(7, 4, 7000, {0x41, 4}));
+	first.removeTrack(pair.track);
+
+	auto ids = pair.receivedIds(3);
+	if (ids != vector<uint8_t>{2, 3, 4})
+		return TestResult(false, "Track did not wait for a keyframe");
+
+	// A track added later starts with the cached keyframe, even if it is the first one
+	RtpForwarder second;
+	second.media(incoming);
+	second.setKeyframeCache(100000);
+	feed(second, makeRtp(8, 10, 1000, {0x41, 10})); // not cached, before the keyframe
+	feed(second, makeRtp(8, 11, 4000, {0x67, 11}));
+	feed(second, makeRtp(8, 12, 4000, {0x65, 12}));
+	feed(second, makeRtp(8, 13, 7000, {0x41, 13}));
+	if (!second.hasCachedKeyframe())
+		return TestResult(false, "Keyframe not cached without tracks");
+
+	second.addTrack(pair.track, VideoPair::ssrc);
+	feed(second, makeRtp(8, 14, 10000, {0x41, 14}));
+
+	ids = pair.receivedIds(7);
+	if (ids != vector<uint8_t>{2, 3, 4, 11, 12, 13, 14})
+		return TestResult(false, "Track did not start with the cached keyframe");
+
+	// A new keyframe replaces the cache, and a cache too small for the keyframe is dropped
+	second.setKeyframeCache(sizeof(RtpHeader) + 10);
+	feed(second, makeRtp(8, 15, 13000, {0x65, 15}));
+	feed(second, makeRtp(8, 16, 13000, {0x65, 16}));
+	if (second.hasCachedKeyframe())
+		return TestResult(false, "Keyframe cached beyond the maximum size");
+
+	second.setKeyframeCache(0);
+	if (second.hasCachedKeyframe())
+		return TestResult(false, "Keyframe cache not cleared when disabled");
+
+	pair.close();
+	return TestResult(true);
+}
+
+TestResult test_broadcast_keyframe_cache() {
+	InitLogger(LogLevel::Debug);
+
+	VideoPair pair;
+	if (!pair.connect())
+		return TestResult(false, "Track is not open");
+
+	auto config = make_shared<RtpPacketizationConfig>(77, "video", 96, H264RtpPacketizer::ClockRate);
+	auto packetizer =
+	    make_shared<H264RtpPacketizer>(H264RtpPacketizer::Separator::LongStartSequence, config);
+	BroadcastGroup group(packetizer);
+	group.setKeyframeCache(100000);
+
+	// Annex B frames with NAL units carrying their id in their second byte
+	auto frame = [](vector<std::pair<uint8_t, uint8_t>> nalus) {
+		binary data;
+		for (auto [type, id] : nalus)
+			for (uint8_t b : {0x00, 0x00, 0x00, 0x01, int(type), int(id), 0xAA, 0xBB})
+				data.push_back(byte(b));
+		return data;
+	};
+
+	// The codec is known from the track description, so tracks wait for a keyframe
+	group.addTrack(pair.track, VideoPair::ssrc);
+	group.sendFrame(frame({{0x41, 1}}), FrameInfo(uint32_t(1000)));
+	group.sendFrame(frame({{0x67, 2}, {0x65, 3}}), FrameInfo(uint32_t(4000)));
+	group.sendFrame(frame({{0x41, 4}}), FrameInfo(uint32_t(7000)));
+
+	auto ids = pair.receivedIds(3);
+	if (ids != vector<uint8_t>{2, 3, 4} || !group.hasCachedKeyframe())
+		return TestResult(false, "Track did not wait for a keyframe");
+
+	// A track added again starts with the cached packets since the keyframe
+	group.removeTrack(pair.track);
+	if (group.trackCount() != 0)
+		return TestResult(false, "Track not removed");
+
+	group.sendFrame(frame({{0x41, 5}}), FrameInfo(uint32_t(10000)));
+	group.addTrack(pair.track, VideoPair::ssrc);
+	group.sendFrame(frame({{0x41, 6}}), FrameInfo(uint32_t(13000)));
+
+	ids = pair.receivedIds(8);
+	if (ids != vector<uint8_t>{2, 3, 4, 2, 3, 4, 5, 6})
+		return TestResult(false, "Track did not start with the cached keyframe");
+
+	group.setKeyframeCache(0);
+	if (group.hasCachedKeyframe())
+		return TestResult(false, "Keyframe cache not cleared when disabled");
+
+	pair.close();
+	return TestResult(true);
+}
+
+#endif
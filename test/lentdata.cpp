@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+TestResult test_lent_data() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	// Messages are received as views
+	std::mutex mutex;
+	vector<binary> received;
+	vector<string> receivedStrings;
+	shared_ptr<DataChannel> dc2;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		dc->onMessageView(
+		    [&](const byte *data, size_t size) {
+			    std::lock_guard lock(mutex);
+			    received.emplace_back(data, data + size);
+		    },
+		    [&](string_view data) {
+			    std::lock_guard lock(mutex);
+			    receivedStrings.emplace_back(data);
+		    });
+		std::atomic_store(&dc2, dc);
+	});
+
+	auto dc1 = pc1.createDataChannel("test");
+
+	int attempts = 10;
+	shared_ptr<DataChannel> adc2;
+	while ((!(adc2 = std::atomic_load(&dc2)) || !adc2->isOpen() || !dc1->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!adc2 || !adc2->isOpen() || !dc1->isOpen())
+		return TestResult(false, "DataChannel is not open");
+
+	// Lent data is sent as is, and each release callback is called exactly once
+	const vector<size_t> sizes = {1, 1000, 65536};
+	vector<binary> buffers;
+	for (size_t size : sizes) {
+		binary buffer(size);
+		for (size_t i = 0; i < size; ++i)
+			buffer[i] = byte(i % 251);
+
+		buffers.push_back(std::move(buffer));
+	}
+
+	vector<int> releases(sizes.size(), 0);
+	for (size_t i = 0; i < buffers.size(); ++i)
+		dc1->send(buffers[i].data(), buffers[i].size(), [&mutex, &releases, i]() {
+			std::lock_guard lock(mutex);
+			++releases[i];
+		});
+
+	attempts = 50;
+	while (attempts--) {
+		{
+			std::lock_guard lock(mutex);
+			if (received.size() >= buffers.size())
+				break;
+		}
+		this_thread::sleep_for(100ms);
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		if (received != buffers)
+			return TestResult(false, "Wrong lent data received");
+
+		for (int count : releases)
+			if (count != 1)
+				return TestResult(false, "Release of sent lent data not called exactly once");
+	}
+
+	// Large strings are lent to the transport, smaller ones are copied, all are received as strings
+	vector<string> strings;
+	for (size_t size : {size_t(5), size_t(4095), size_t(4096), size_t(100000)}) {
+		string str(size, ' ');
+		for (size_t i = 0; i < size; ++i)
+			str[i] = char('a' + i % 26);
+
+		strings.push_back(std::move(str));
+	}
+
+	for (const auto &str : strings) {
+		string copy = str;
+		dc1->send(std::move(copy));
+	}
+
+	attempts = 50;
+	while (attempts--) {
+		{
+			std::lock_guard lock(mutex);
+			if (receivedStrings.size() >= strings.size())
+				break;
+		}
+		this_thread::sleep_for(100ms);
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		if (receivedStrings != strings)
+			return TestResult(false, "Wrong strings received");
+
+		if (received.size() != buffers.size())
+			return TestResult(false, "Strings received as binary");
+	}
+
+	if (dc1->bufferedAmount() != 0)
+		return TestResult(false, "Lent strings still buffered");
+
+	// Lent data is released once even if sending fails
+	dc1->close();
+	attempts = 10;
+	while (!dc1->isClosed() && attempts--)
+		this_thread::sleep_for(100ms);
+
+	std::atomic<int> failedReleases = 0;
+	try {
+		dc1->send(buffers[0].data(), buffers[0].size(), [&failedReleases]() { ++failedReleases; });
+		return TestResult(false, "Sending lent data on a closed DataChannel succeeded");
+	} catch (const std::exception &) {
+	}
+
+	if (failedReleases != 1)
+		return TestResult(false, "Release of unsent lent data not called exactly once");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
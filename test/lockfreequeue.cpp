@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "impl/lockfreequeue.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::LockFreeQueue;
+
+TestResult test_lockfree_queue() {
+	try {
+		try {
+			LockFreeQueue<int> unbounded(0);
+			return TestResult(false, "Unbounded queue was accepted");
+		} catch (const invalid_argument &) {
+			// expected
+		}
+
+		// Limits and amount accounting
+		LockFreeQueue<string> queue(3, [](const string &s) { return s.size(); });
+		if (!queue.empty() || queue.full() || queue.size() != 0 || queue.amount() != 0)
+			return TestResult(false, "New queue is not empty");
+
+		if (!queue.push("a") || !queue.push("bb") || !queue.push("ccc"))
+			return TestResult(false, "Push failed before the limit");
+
+		if (!queue.full() || queue.size() != 3 || queue.amount() != 6)
+			return TestResult(false, "Wrong size or amount after push");
+
+		if (queue.push("dddd"))
+			return TestResult(false, "Push succeeded on a full queue");
+
+		if (queue.amount() != 6)
+			return TestResult(false, "Rejected element was accounted");
+
+		// Peek and exchange act on the head
+		auto head = queue.peek();
+		if (!head || *head != "a" || queue.size() != 3)
+			return TestResult(false, "Wrong peek result");
+
+		auto old = queue.exchange("eeeee");
+		if (!old || *old != "a" || queue.amount() != 10)
+			return TestResult(false, "Wrong exchange result");
+
+		// FIFO order
+		auto first = queue.pop();
+		auto second = queue.pop();
+		if (!first || *first != "eeeee" || !second || *second != "bb")
+			return TestResult(false, "Wrong pop order");
+
+		if (queue.size() != 1 || queue.amount() != 3)
+			return TestResult(false, "Wrong size or amount after pop");
+
+		// Stopping rejects new elements but lets the remaining ones be popped
+		queue.stop();
+		if (queue.push("f"))
+			return TestResult(false, "Push succeeded on a stopped queue");
+
+		if (!queue.running())
+			return TestResult(false, "Stopped queue with elements is not running");
+
+		auto last = queue.pop();
+		if (!last || *last != "ccc")
+			return TestResult(false, "Remaining element lost after stop");
+
+		if (queue.running() || queue.pop() || queue.peek() || queue.exchange("g"))
+			return TestResult(false, "Stopped empty queue is still running");
+
+		// Concurrent producers and consumers
+		const int producers = 4;
+		const int consumers = 2;
+		const int count = 100000;
+		LockFreeQueue<int> mpmc(64);
+		atomic<int64_t> sum = 0;
+		atomic<int> popped = 0;
+		atomic<bool> done = false;
+
+		vector<thread> threads;
+		for (int p = 0; p < producers; ++p)
+			threads.emplace_back([&mpmc] {
+				for (int i = 1; i <= count; ++i)
+					while (!mpmc.push(i))
+						this_thread::yield();
+			});
+
+		for (int c = 0; c < consumers; ++c)
+			threads.emplace_back([&] {
+				while (!done || !mpmc.empty()) {
+					if (auto element = mpmc.pop()) {
+						sum += *element;
+						++popped;
+					} else {
+						this_thread::yield();
+					}
+				}
+			});
+
+		for (int p = 0; p < producers; ++p)
+			threads[p].join();
+
+		done = true;
+		for (size_t i = producers; i < threads.size(); ++i)
+			threads[i].join();
+
+		const int64_t expected = producers * (int64_t(count) * (count + 1) / 2);
+		if (popped != producers * count || sum != expected)
+			return TestResult(false, "Elements lost or duplicated under concurrency");
+
+		if (!mpmc.empty() || mpmc.amount() != 0)
+			return TestResult(false, "Queue is not empty after concurrent use");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
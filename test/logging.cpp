@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/internals.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+int Evaluated = 0;
+
+int evaluate() { return ++Evaluated; }
+
+optional<uint64_t> metricValue(const string &name) {
+	for (const auto &metric : GetMetrics())
+		if (metric.name == name)
+			return metric.value;
+
+	return nullopt;
+}
+
+} // namespace
+
+TestResult test_log_levels() {
+	// Statements below the minimum level are compiled out, so their arguments are never evaluated,
+	// whatever the logger level. The minimum is expanded where statements are, so it can be lowered.
+	InitLogger(LogLevel::Verbose);
+	const int compiledEvaluated = [] {
+		Evaluated = 0;
+#pragma push_macro("RTC_MIN_LOG_LEVEL")
+#undef RTC_MIN_LOG_LEVEL
+#define RTC_MIN_LOG_LEVEL 3 // warning
+		PLOG_VERBOSE << evaluate();
+		PLOG_DEBUG << evaluate();
+		PLOG_INFO << evaluate();
+		IF_PLOG(plog::debug) { evaluate(); }
+		if (RTC_LOG_COMPILED(plog::info) || !RTC_LOG_COMPILED(plog::warning))
+			evaluate();
+#pragma pop_macro("RTC_MIN_LOG_LEVEL")
+		return Evaluated;
+	}();
+	if (compiledEvaluated != 0)
+		return TestResult(false, "Arguments of a compiled out log statement evaluated");
+
+#if RTC_ENABLE_MEDIA
+	// Log counters are always counted, but only logged if their level is enabled
+	std::mutex mutex;
+	vector<string> lines;
+	auto callback = [&](LogLevel, string message) {
+		std::lock_guard lock(mutex);
+		if (message.find("Number of malformed RTP headers") != string::npos)
+			lines.push_back(std::move(message));
+	};
+	InitLogger(LogLevel::Warning, callback);
+
+	const string name = "rtc_rtcp_session_bad_rtp_headers";
+	auto before = metricValue(name);
+	if (!before)
+		return TestResult(false, "Missing metric " + name);
+
+	RtcpReceivingSession session;
+	auto feed = [&session](size_t count) {
+		message_vector messages;
+		for (size_t i = 0; i < count; ++i)
+			messages.push_back(make_message(4)); // too short for an RTP header
+
+		session.incoming(messages, [](message_ptr) {});
+	};
+
+	// A single line is logged per period, with the count of events
+	feed(3);
+	this_thread::sleep_for(2s);
+	{
+		std::lock_guard lock(mutex);
+		const bool compiled = RTC_LOG_COMPILED(plog::warning);
+		if (lines.size() != (compiled ? 1 : 0) ||
+		    (compiled && lines.front().find(": 3 (over 1 seconds)") == string::npos))
+			return TestResult(false, "Wrong log counter lines");
+	}
+
+	InitLogger(LogLevel::Error, callback);
+	feed(2);
+	this_thread::sleep_for(2s);
+	{
+		std::lock_guard lock(mutex);
+		if (lines.size() > 1)
+			return TestResult(false, "Log counter logged below the logger level");
+	}
+
+	auto after = metricValue(name);
+	InitLogger(LogLevel::Debug, [](LogLevel, string) {}); // the console appender remains
+
+	if (!after || *after != *before + 5)
+		return TestResult(false, "Log counter not counted while not logged");
+#endif
+
+	return TestResult(true);
+}
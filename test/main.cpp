@@ -23,17 +23,103 @@ using chrono::steady_clock;
 
 TestResult test_connectivity();
 TestResult test_connectivity_fail_on_wrong_fingerprint();
+TestResult test_connectivity_ice_threads();
 TestResult test_pem();
 TestResult test_negotiated();
+TestResult test_negotiated_bulk();
 TestResult test_reliability();
+TestResult test_expired_messages();
+TestResult test_recv_backpressure();
 TestResult test_turn_connectivity();
 TestResult test_track();
+TestResult test_track_parallel_srtp();
+TestResult test_track_renegotiation_traffic();
 TestResult test_capi_connectivity();
 TestResult test_capi_track();
 TestResult test_websocket();
 TestResult test_websocketserver();
 TestResult test_capi_websocketserver();
+TestResult test_allocations_datachannel();
+TestResult test_allocations_track();
+TestResult test_lockfree_queue();
+TestResult test_timer_wheel();
+TestResult test_websocket_compression();
+TestResult test_stats();
+TestResult test_max_turn_allocations();
+TestResult test_rtcp_sr_reporter();
+TestResult test_rtcp_sr_reporter_timer();
+TestResult test_rtcp_receiving_session();
+TestResult test_keyframe_requests();
+TestResult test_rtp_forwarder_keyframe_cache();
+TestResult test_broadcast_keyframe_cache();
+TestResult test_av1_packetizer();
+TestResult test_rtcp_routing();
+TestResult test_media_batch_delivery();
+TestResult test_lent_data();
+TestResult test_coalescing();
+TestResult test_file_transfer();
+TestResult test_handle_table();
+TestResult test_capi_messages();
+TestResult test_capi_opaque_messages();
+TestResult test_metrics();
+TestResult test_latency_histograms();
+TestResult test_tracing();
+TestResult test_introspection();
+TestResult test_log_levels();
+TestResult test_threads();
+TestResult test_executor();
+TestResult test_executor_affinity();
+TestResult test_external_loop();
+TestResult test_srtp_profiles();
+TestResult test_pending_handshakes();
+TestResult test_shared_dtls_context();
+TestResult test_dtls13();
+TestResult test_media_scheduler();
+TestResult test_rtp_extension_template();
+TestResult test_audio_level_handler();
+TestResult test_track_frame_view();
+TestResult test_rtp_recorder();
+TestResult test_rtp_replayer();
+TestResult test_mtu_prober();
+TestResult test_candidate_batches();
+TestResult test_peer_connection_pool();
+TestResult test_poll_timeouts();
+TestResult test_base64();
+TestResult test_websocket_proxy();
+TestResult test_hpack();
+TestResult test_http2_frames();
+TestResult test_websocket_messages();
+TestResult test_pacing_handler();
+TestResult test_pacing_padding();
+TestResult test_pacing_limits();
+TestResult test_datachannel_pacer();
+TestResult test_description_sharing();
+TestResult test_rtp_rewriter();
+TestResult test_rtcp_nack_requester();
+TestResult test_crc32c();
+TestResult test_sctp_packet();
+TestResult test_tcp_happy_eyeballs();
+TestResult test_tcp_read_until_eof();
+TestResult test_transport_recv_handler();
+TestResult test_send_queue();
+TestResult test_candidate_pair_cache();
+TestResult test_allocator();
+TestResult test_twcc_handler();
+TestResult test_gcc_estimator();
+TestResult test_flexfec();
+TestResult test_video_jitter_buffer();
+TestResult test_video_reassembly();
+TestResult test_rtcp_nack_responder();
+TestResult test_rtcp_nack_responder_rtx();
+TestResult test_dependency_descriptor();
+TestResult test_svc_layer_filter();
+TestResult test_stream_scheduler();
+TestResult test_buffered_amount();
+TestResult test_websocket_mask();
+TestResult test_start_code();
+TestResult test_work_stealing();
 size_t benchmark(chrono::milliseconds duration);
+size_t benchmarkDescription(chrono::milliseconds duration);
 
 void test_benchmark() {
 	size_t goodput = benchmark(10s);
@@ -46,6 +132,16 @@ void test_benchmark() {
 		throw runtime_error("Goodput is too low");
 }
 
+TestResult test_description() {
+	try {
+		if (benchmarkDescription(1s) == 0)
+			return TestResult(false, "no description parsed");
+		return TestResult(true);
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
 TestResult test_cleanup() {
 	try {
 		// Every created object must have been destroyed, otherwise the wait will block
@@ -71,19 +167,129 @@ static const vector<Test> tests = {
     Test("WebRTC connectivity", test_connectivity),
     Test("WebRTC broken fingerprint", test_connectivity_fail_on_wrong_fingerprint),
     Test("pem", test_pem),
+    Test("SDP parsing and generation", test_description),
     // TODO: Temporarily disabled as the Open Relay TURN server is unreliable
     // new Test("WebRTC TURN connectivity", test_turn_connectivity),
     Test("WebRTC negotiated DataChannel", test_negotiated),
+    Test("WebRTC bulk negotiated DataChannels", test_negotiated_bulk),
     Test("WebRTC reliability mode", test_reliability),
+    Test("WebRTC expired messages", test_expired_messages),
+    Test("WebRTC receive backpressure", test_recv_backpressure),
 #if RTC_ENABLE_MEDIA
     Test("WebRTC track", test_track),
+    Test("WebRTC parallel SRTP tracks", test_track_parallel_srtp),
+    Test("WebRTC track renegotiation during traffic", test_track_renegotiation_traffic),
 #endif
 #if RTC_ENABLE_WEBSOCKET
     // TODO: Temporarily disabled as the echo service is unreliable
     // new Test("WebSocket", test_websocket),
     Test("WebSocketServer", test_websocketserver),
+#endif
+    Test("Lock-free queue", test_lockfree_queue),
+    Test("Timer wheel", test_timer_wheel),
+#if RTC_ENABLE_WEBSOCKET
+    Test("WebSocket compression", test_websocket_compression),
+#endif
+    Test("Stats", test_stats),
+    Test("Max TURN allocations", test_max_turn_allocations),
+#if RTC_ENABLE_MEDIA
+    Test("RTCP sender reports", test_rtcp_sr_reporter),
+    Test("WebRTC sender report timer", test_rtcp_sr_reporter_timer),
+    Test("RTCP receiver statistics", test_rtcp_receiving_session),
+    Test("Keyframe requests and detection", test_keyframe_requests),
+    Test("WebRTC RTP forwarder keyframe cache", test_rtp_forwarder_keyframe_cache),
+    Test("WebRTC broadcast keyframe cache", test_broadcast_keyframe_cache),
+    Test("AV1 packetizer", test_av1_packetizer),
+    Test("WebRTC compound RTCP routing", test_rtcp_routing),
+    Test("WebRTC batched media delivery", test_media_batch_delivery),
+#endif
+    Test("WebRTC lent data", test_lent_data),
+    Test("WebRTC message coalescing", test_coalescing),
+    Test("WebRTC file transfer", test_file_transfer),
+    Test("Handle table", test_handle_table),
+    Test("Metrics", test_metrics),
+    Test("Latency histograms", test_latency_histograms),
+    Test("Tracepoints", test_tracing),
+    Test("Introspection", test_introspection),
+    Test("Log levels", test_log_levels),
+    Test("Threads", test_threads),
+    Test("Executor", test_executor),
+    Test("WebRTC executor affinity", test_executor_affinity),
+    Test("ThreadPool external loop", test_external_loop),
+#if RTC_ENABLE_MEDIA
+    Test("SRTP profile negotiation", test_srtp_profiles),
+#endif
+    Test("DTLS pending handshakes limit", test_pending_handshakes),
+    Test("DTLS shared context", test_shared_dtls_context),
+    Test("DTLS 1.3 negotiation", test_dtls13),
+#if RTC_ENABLE_MEDIA
+    Test("Media scheduler", test_media_scheduler),
+    Test("RTP header extension template", test_rtp_extension_template),
+    Test("Audio level handler", test_audio_level_handler),
+    Test("WebRTC track frame view", test_track_frame_view),
+    Test("RTP recorder", test_rtp_recorder),
+    Test("WebRTC RTP replayer", test_rtp_replayer),
+    Test("MTU prober", test_mtu_prober),
+#endif
+    Test("WebRTC batched candidates", test_candidate_batches),
+    Test("WebRTC PeerConnection pool", test_peer_connection_pool),
+#if RTC_ENABLE_WEBSOCKET
+    Test("Poll service timeouts", test_poll_timeouts),
+#endif
+    Test("Base64", test_base64),
+#if RTC_ENABLE_WEBSOCKET
+    Test("WebSocket proxy", test_websocket_proxy),
+    Test("HPACK", test_hpack),
+    Test("HTTP/2 framing", test_http2_frames),
+    Test("WebSocket batched messages", test_websocket_messages),
+#endif
+#if RTC_ENABLE_MEDIA
+    Test("Pacing handler", test_pacing_handler),
+    Test("Pacing handler padding", test_pacing_padding),
+    Test("Pacing handler limits", test_pacing_limits),
+    Test("WebRTC DataChannel pacer", test_datachannel_pacer),
+#endif
+    Test("Description sharing", test_description_sharing),
+#if RTC_ENABLE_MEDIA
+    Test("RTP rewriter", test_rtp_rewriter),
+    Test("RTCP NACK requester", test_rtcp_nack_requester),
+#endif
+    Test("CRC32c", test_crc32c),
+    Test("SCTP packet", test_sctp_packet),
+#if RTC_ENABLE_WEBSOCKET
+    Test("TCP Happy Eyeballs", test_tcp_happy_eyeballs),
+    Test("TCP read until end of stream", test_tcp_read_until_eof),
+#endif
+    Test("Transport receive handler", test_transport_recv_handler),
+    Test("Send queue", test_send_queue),
+    Test("Candidate pair cache", test_candidate_pair_cache),
+    Test("Allocator", test_allocator),
+#if RTC_ENABLE_MEDIA
+    Test("TWCC handler", test_twcc_handler),
+    Test("GCC estimator", test_gcc_estimator),
+    Test("FlexFEC", test_flexfec),
+    Test("Video jitter buffer", test_video_jitter_buffer),
+    Test("Video reassembly", test_video_reassembly),
+    Test("RTCP NACK responder", test_rtcp_nack_responder),
+    Test("RTCP NACK responder RTX", test_rtcp_nack_responder_rtx),
+    Test("Dependency descriptor", test_dependency_descriptor),
+    Test("SVC layer filter", test_svc_layer_filter),
+#endif
+    Test("Stream scheduler", test_stream_scheduler),
+    Test("DataChannel buffered amount", test_buffered_amount),
+    Test("WebSocket frame masking", test_websocket_mask),
+#if RTC_ENABLE_MEDIA
+    Test("H264 start code search", test_start_code),
+#endif
+    Test("Thread pool work stealing", test_work_stealing),
+#if RTC_ALLOCATION_TESTS
+    Test("DataChannel allocations", test_allocations_datachannel),
+#if RTC_ENABLE_MEDIA
+    Test("Track allocations", test_allocations_track),
+#endif
 #endif
     Test("Cleanup", test_cleanup),
+    Test("WebRTC connectivity with ICE threads", test_connectivity_ice_threads),
     // C API tests
     Test("WebRTC C API connectivity", test_capi_connectivity),
 #if RTC_ENABLE_MEDIA
@@ -92,6 +298,8 @@ static const vector<Test> tests = {
 #if RTC_ENABLE_WEBSOCKET
     Test("WebSocketServer C API", test_capi_websocketserver),
 #endif
+    Test("WebRTC C API vectored messages", test_capi_messages),
+    Test("WebRTC C API opaque messages", test_capi_opaque_messages),
     Test("C API cleanup", test_capi_cleanup),
 };
 
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+// Records the batches of incoming RTP packets passed to the handler
+class BatchRecorder final : public MediaHandler {
+public:
+	void incoming(message_vector &messages, const message_callback &) override {
+		std::lock_guard lock(mutex);
+		++batches;
+		maxBatchSize = std::max(maxBatchSize, messages.size());
+		for (const auto &message : messages) {
+			if (message->type == Message::Control || message->size() < sizeof(RtpHeader))
+				continue;
+
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			seqNumbers.push_back(rtp->seqNumber());
+		}
+	}
+
+	std::mutex mutex;
+	size_t batches = 0;
+	size_t maxBatchSize = 0;
+	vector<uint16_t> seqNumbers;
+};
+
+} // namespace
+
+TestResult test_media_batch_delivery() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	auto recorder = make_shared<BatchRecorder>();
+	std::atomic<size_t> received = 0;
+	shared_ptr<Track> t2;
+	pc2.onTrack([&](shared_ptr<Track> t) {
+		t->setMediaHandler(recorder);
+		t->onMessage([&received](binary) { ++received; }, nullptr);
+		std::atomic_store(&t2, t);
+	});
+
+	const SSRC ssrc = 3000;
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	media.addSSRC(ssrc, "video-send");
+	auto t1 = pc1.addTrack(media);
+
+	pc1.setLocalDescription();
+
+	int attempts = 10;
+	shared_ptr<Track> at2;
+	while ((!(at2 = std::atomic_load(&t2)) || !at2->isOpen() || !t1->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!at2 || !at2->isOpen() || !t1->isOpen())
+		return TestResult(false, "Track is not open");
+
+	// Bursts are sent faster than they are processed, so the receiver gets batches
+	const uint16_t bursts = 5;
+	const uint16_t burstSize = 100;
+	uint16_t seq = 65500; // wraps around during the test
+	for (uint16_t b = 0; b < bursts; ++b) {
+		for (uint16_t i = 0; i < burstSize; ++i) {
+			binary packet(sizeof(RtpHeader) + 100);
+			auto rtp = reinterpret_cast<RtpHeader *>(packet.data());
+			rtp->preparePacket();
+			rtp->setPayloadType(96);
+			rtp->setSeqNumber(seq++);
+			rtp->setTimestamp(3000 * b);
+			rtp->setSsrc(ssrc);
+			t1->send(std::move(packet));
+		}
+		this_thread::sleep_for(100ms);
+	}
+
+	const size_t total = size_t(bursts) * burstSize;
+	attempts = 50;
+	while (received < total && attempts--)
+		this_thread::sleep_for(100ms);
+
+	// Every packet goes through the handler chain then to the track, once and in order
+	std::lock_guard lock(recorder->mutex);
+	if (received != total || recorder->seqNumbers.size() != total)
+		return TestResult(false, "Packets lost or duplicated in batch delivery");
+
+	for (size_t i = 0; i < total; ++i)
+		if (recorder->seqNumbers[i] != uint16_t(65500 + i))
+			return TestResult(false, "Packets reordered in batch delivery");
+
+	if (recorder->maxBatchSize <= 1 || recorder->batches >= total)
+		return TestResult(false, "Packets were not delivered in batches");
+
+	cout << "Received " << total << " packets in " << recorder->batches
+	     << " batches, the largest with " << recorder->maxBatchSize << " packets" << endl;
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif
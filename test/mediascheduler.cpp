@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+// Records the frames of a stream, and whether its callback was ever called concurrently
+struct FrameRecorder {
+	std::mutex mutex;
+	vector<std::pair<uint64_t, chrono::microseconds>> frames;
+	std::atomic<bool> running = false;
+	std::atomic<bool> concurrent = false;
+
+	void record(uint64_t index, chrono::microseconds time) {
+		if (running.exchange(true))
+			concurrent = true;
+
+		{
+			std::lock_guard lock(mutex);
+			frames.emplace_back(index, time);
+		}
+		running = false;
+	}
+
+	size_t count() {
+		std::lock_guard lock(mutex);
+		return frames.size();
+	}
+
+	// Frames are numbered in turn from 0, at their media time from the start
+	bool consistent(chrono::microseconds interval) {
+		std::lock_guard lock(mutex);
+		for (size_t i = 0; i < frames.size(); ++i)
+			if (frames[i].first != i || frames[i].second != interval * int64_t(i))
+				return false;
+
+		return !concurrent;
+	}
+};
+
+} // namespace
+
+TestResult test_media_scheduler() {
+	try {
+		// Keep the library initialized, as frames are delivered on the thread pool
+		PeerConnection pc;
+
+		{
+			MediaScheduler scheduler;
+			bool thrown = false;
+			try {
+				scheduler.addStream(0us, [](uint64_t, chrono::microseconds) { return true; });
+			} catch (const std::invalid_argument &) {
+				thrown = true;
+			}
+			if (!thrown)
+				return TestResult(false, "Stream with a zero interval accepted");
+		}
+
+		// Streams with different intervals are delivered on time, the first frame immediately
+		{
+			MediaScheduler scheduler;
+			FrameRecorder fast, slow;
+			const auto start = chrono::steady_clock::now();
+			std::atomic<int64_t> firstDelay = -1;
+			auto id = scheduler.addStream(10ms, [&](uint64_t index, chrono::microseconds time) {
+				if (index == 0)
+					firstDelay = chrono::duration_cast<chrono::milliseconds>(
+					                 chrono::steady_clock::now() - start)
+					                 .count();
+				fast.record(index, time);
+				return true;
+			});
+			scheduler.addStream(20ms, [&](uint64_t index, chrono::microseconds time) {
+				slow.record(index, time);
+				return true;
+			});
+
+			if (scheduler.streamsCount() != 2)
+				return TestResult(false, "Wrong streams count");
+
+			this_thread::sleep_for(1s);
+			scheduler.removeStream(id);
+			const size_t slowCount = slow.count();
+			this_thread::sleep_for(100ms); // let a running callback return
+			const size_t fastCount = fast.count();
+			this_thread::sleep_for(200ms);
+
+			if (firstDelay < 0 || firstDelay > 100)
+				return TestResult(false, "First frame not delivered immediately");
+
+			// Lateness is corrected on the next frame, so the count matches the elapsed time
+			if (fastCount < 90 || fastCount > 103 || slowCount < 45 || slowCount > 52)
+				return TestResult(false, "Wrong frame counts: " + to_string(fastCount) + " and " +
+				                             to_string(slowCount));
+
+			if (fast.count() != fastCount)
+				return TestResult(false, "Frames delivered after the stream was removed");
+
+			if (!fast.consistent(10ms) || !slow.consistent(20ms))
+				return TestResult(false, "Wrong frame indexes or times");
+
+			if (scheduler.streamsCount() != 1 || scheduler.resyncCount() != 0)
+				return TestResult(false, "Wrong streams or resync count");
+		}
+
+		// Returning false removes the stream
+		{
+			MediaScheduler scheduler;
+			std::atomic<uint64_t> last = 0;
+			scheduler.addStream(5ms, [&](uint64_t index, chrono::microseconds) {
+				last = index;
+				return index < 4;
+			});
+			this_thread::sleep_for(200ms);
+			if (last != 4 || scheduler.streamsCount() != 0)
+				return TestResult(false, "Stream not removed when its callback returned false");
+		}
+
+		// A lagging stream is resynchronized instead of delivering a burst of late frames
+		{
+			MediaScheduler scheduler(50ms);
+			FrameRecorder recorder;
+			std::atomic<int> afterBlock = 0;
+			std::atomic<bool> blocked = false;
+			scheduler.addStream(10ms, [&](uint64_t index, chrono::microseconds time) {
+				recorder.record(index, time);
+				if (blocked)
+					++afterBlock;
+
+				if (index == 5) {
+					this_thread::sleep_for(300ms);
+					blocked = true;
+				}
+				return true;
+			});
+			this_thread::sleep_for(400ms);
+			const int delivered = afterBlock;
+
+			if (scheduler.resyncCount() != 1)
+				return TestResult(false, "Lagging stream not resynchronized");
+
+			// Without resynchronization, about 30 frames would be delivered at once after the block
+			if (delivered > 15)
+				return TestResult(false, "Late frames delivered in a burst");
+
+			std::lock_guard lock(recorder.mutex);
+			for (size_t i = 0; i < recorder.frames.size(); ++i)
+				if (recorder.frames[i].first != i)
+					return TestResult(false, "Frame indexes skipped on resynchronization");
+		}
+
+		// Destroying the scheduler removes its streams
+		std::atomic<int> called = 0;
+		{
+			MediaScheduler scheduler;
+			scheduler.addStream(5ms, [&called](uint64_t, chrono::microseconds) {
+				++called;
+				return true;
+			});
+			this_thread::sleep_for(100ms);
+		}
+		this_thread::sleep_for(50ms); // let a running callback return
+		const int count = called;
+		this_thread::sleep_for(100ms);
+		if (called != count)
+			return TestResult(false, "Frames delivered after the scheduler was destroyed");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.h"
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+optional<uint64_t> metricValue(const string &name) {
+	for (const auto &metric : GetMetrics())
+		if (metric.name == name)
+			return metric.value;
+
+	return nullopt;
+}
+
+} // namespace
+
+TestResult test_metrics() {
+	try {
+		// Metrics have stable unique names and are sorted by name
+		auto metrics = GetMetrics();
+		if (metrics.empty())
+			return TestResult(false, "No metrics registered");
+
+		std::set<string> names;
+		for (const auto &metric : metrics) {
+			if (metric.name.rfind("rtc_", 0) != 0 || metric.description.empty())
+				return TestResult(false, "Invalid metric " + metric.name);
+
+			if (!names.insert(metric.name).second)
+				return TestResult(false, "Duplicate metric " + metric.name);
+		}
+
+		if (!std::is_sorted(metrics.begin(), metrics.end(),
+		                    [](const Metric &a, const Metric &b) { return a.name < b.name; }))
+			return TestResult(false, "Metrics are not sorted by name");
+
+#if RTC_ENABLE_MEDIA
+		// Counters are incremented when events happen, even if they are not logged
+		const string name = "rtc_rtcp_session_bad_rtp_headers";
+		auto before = metricValue(name);
+		if (!before)
+			return TestResult(false, "Missing metric " + name);
+
+		RtcpReceivingSession session;
+		message_vector messages;
+		messages.push_back(make_message(4)); // too short for an RTP header
+		messages.push_back(make_message(4));
+		session.incoming(messages, [](message_ptr) {});
+
+		auto after = metricValue(name);
+		if (!after || *after != *before + 2)
+			return TestResult(false, "Metric not incremented");
+#endif
+
+		// The C API exposes them in the Prometheus text format
+		int size = rtcGetMetrics(nullptr, 0);
+		if (size <= 0)
+			return TestResult(false, "rtcGetMetrics failed to return the size");
+
+		if (rtcGetMetrics(std::vector<char>(1).data(), 1) != RTC_ERR_TOO_SMALL)
+			return TestResult(false, "rtcGetMetrics accepted a buffer too small");
+
+		std::vector<char> buffer(size_t(size) + 64); // they may grow in the meantime
+		if (rtcGetMetrics(buffer.data(), int(buffer.size())) <= 0)
+			return TestResult(false, "rtcGetMetrics failed");
+
+		const string text(buffer.data());
+		const auto &first = metrics.front();
+		const string expected = "# HELP " + first.name + "_total " + first.description + "\n" +
+		                        "# TYPE " + first.name + "_total counter\n" + first.name +
+		                        "_total ";
+		if (text.rfind(expected, 0) != 0)
+			return TestResult(false, "Wrong Prometheus text format");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_latency_histograms() {
+	using chrono::nanoseconds;
+
+	// Quantiles are upper bounds of buckets, never above the maximum
+	Histogram histogram;
+	histogram.count = 10;
+	histogram.max = 900ns;
+	histogram.buckets = {{100ns, 5}, {500ns, 4}, {1000ns, 1}};
+	if (histogram.quantile(0.5) != 100ns || histogram.quantile(0.9) != 500ns ||
+	    histogram.quantile(0.99) != 900ns || histogram.quantile(1.) != 900ns)
+		return TestResult(false, "Wrong histogram quantiles");
+
+	// Run thread pool tasks and a DTLS handshake
+	InitLogger(LogLevel::Debug);
+	{
+		PeerConnection pc1;
+		PeerConnection pc2;
+		pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(sdp); });
+		pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+		pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(sdp); });
+		pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+
+		auto dc = pc1.createDataChannel("test");
+		int attempts = 10;
+		while (!dc->isOpen() && attempts--)
+			this_thread::sleep_for(1s);
+
+		if (!dc->isOpen())
+			return TestResult(false, "DataChannel is not open");
+
+		dc->send("hello");
+		pc1.close();
+		pc2.close();
+	}
+	this_thread::sleep_for(1s);
+
+	auto histograms = GetLatencyHistograms();
+#if RTC_LATENCY_HISTOGRAMS
+	if (!std::is_sorted(histograms.begin(), histograms.end(),
+	                    [](const Histogram &a, const Histogram &b) { return a.name < b.name; }))
+		return TestResult(false, "Histograms are not sorted by name");
+
+	bool queueWait = false;
+	for (const auto &h : histograms) {
+		if (h.name.rfind("rtc_", 0) != 0 || h.description.empty())
+			return TestResult(false, "Invalid histogram " + h.name);
+
+		uint64_t count = 0;
+		nanoseconds previous = nanoseconds(-1);
+		for (const auto &[bound, n] : h.buckets) {
+			if (bound <= previous || n == 0)
+				return TestResult(false, "Invalid buckets in histogram " + h.name);
+
+			previous = bound;
+			count += n;
+		}
+
+		// Each recorded value falls in a bucket, and buckets are precise to 12.5%
+		if (count != h.count || (h.count > 0 && (h.max > previous || h.max * 8 < previous * 7)) ||
+		    h.sum > h.max * int64_t(h.count))
+			return TestResult(false, "Inconsistent histogram " + h.name);
+
+		if (h.name == "rtc_threadpool_queue_wait")
+			queueWait = h.count > 0;
+	}
+
+	if (!queueWait)
+		return TestResult(false, "Thread pool queue wait not recorded");
+#else
+	if (!histograms.empty())
+		return TestResult(false, "Histograms returned while disabled");
+#endif
+
+	return TestResult(true);
+}
@@ -0,0 +1,668 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+// Microbenchmarks of hot paths in isolation, as opposed to the end-to-end benchmark
+// Usage: microbench [--filter=<substring>] [--min-time=<milliseconds>] [--json]
+// The JSON output follows the format of Google Benchmark, so its tools can compare runs.
+
+#include "rtc/rtc.hpp"
+
+#include "impl/queue.hpp"
+#include "impl/threadpool.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+#include "impl/sha.hpp"
+#include "impl/utils.hpp"
+#include "impl/wshandshake.hpp"
+#endif
+
+#if RTC_ENABLE_MEDIA
+#if RTC_SYSTEM_SRTP
+#include <srtp2/srtp.h>
+#else
+#include "srtp.h"
+#endif
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using chrono::duration_cast;
+using chrono::nanoseconds;
+using chrono::steady_clock;
+
+namespace {
+
+// Prevents the compiler from optimizing out a computed value
+volatile uintptr_t Sink = 0;
+template <typename T> void keep(const T &value) { Sink = Sink + uintptr_t(&value); }
+
+// A benchmark runs the given number of iterations and returns the time spent in the measured part
+using BenchmarkFunc = function<steady_clock::duration(uint64_t iterations)>;
+
+struct Benchmark {
+	string name;
+	size_t bytesPerIteration; // 0 if not relevant
+	BenchmarkFunc func;
+};
+
+struct Result {
+	string name;
+	uint64_t iterations;
+	double nsPerIteration;
+	double bytesPerSecond;
+};
+
+template <typename F> steady_clock::duration timeLoop(uint64_t iterations, F &&body) {
+	const auto start = steady_clock::now();
+	for (uint64_t i = 0; i < iterations; ++i)
+		body(i);
+	return steady_clock::now() - start;
+}
+
+Result run(const Benchmark &benchmark, steady_clock::duration minTime) {
+	benchmark.func(1); // warm up
+
+	// Grow the iteration count until the measured time reaches the minimum
+	uint64_t iterations = 1;
+	steady_clock::duration elapsed;
+	while (true) {
+		elapsed = benchmark.func(iterations);
+		if (elapsed >= minTime || iterations >= (uint64_t(1) << 40))
+			break;
+
+		const auto measured = std::max<steady_clock::rep>(elapsed.count(), 1);
+		const double ratio = double(minTime.count()) / double(measured);
+		iterations = std::max(iterations * 2, uint64_t(double(iterations) * ratio * 1.2));
+	}
+
+	const double ns = double(duration_cast<nanoseconds>(elapsed).count());
+	Result result;
+	result.name = benchmark.name;
+	result.iterations = iterations;
+	result.nsPerIteration = ns / double(iterations);
+	result.bytesPerSecond =
+	    ns > 0 ? double(benchmark.bytesPerIteration) * double(iterations) * 1e9 / ns : 0.;
+	return result;
+}
+
+void printConsole(const vector<Result> &results) {
+	cout << left << setw(40) << "Benchmark" << right << setw(16) << "Time (ns)" << setw(16)
+	     << "Iterations" << setw(16) << "MB/s" << endl;
+	for (const auto &r : results) {
+		cout << left << setw(40) << r.name << right << setw(16) << fixed << setprecision(1)
+		     << r.nsPerIteration << setw(16) << r.iterations << setw(16);
+		if (r.bytesPerSecond > 0)
+			cout << r.bytesPerSecond / 1e6;
+		else
+			cout << "-";
+		cout << endl;
+	}
+}
+
+void printJson(const vector<Result> &results) {
+	cout << "{\n  \"context\": {\n    \"library\": \"libdatachannel\",\n    \"num_cpus\": "
+	     << std::thread::hardware_concurrency() << "\n  },\n  \"benchmarks\": [";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const auto &r = results[i];
+		cout << (i > 0 ? "," : "") << "\n    {\"name\": \"" << r.name
+		     << "\", \"run_type\": \"iteration\", \"iterations\": " << r.iterations
+		     << ", \"real_time\": " << fixed << setprecision(3) << r.nsPerIteration
+		     << ", \"time_unit\": \"ns\"";
+		if (r.bytesPerSecond > 0)
+			cout << ", \"bytes_per_second\": " << setprecision(0) << r.bytesPerSecond;
+		cout << "}";
+	}
+	cout << "\n  ]\n}" << endl;
+}
+
+const string BenchmarkSdp = "v=0\r\n"
+                            "o=- 4611731400430051336 2 IN IP4 127.0.0.1\r\n"
+                            "s=-\r\n"
+                            "t=0 0\r\n"
+                            "a=group:BUNDLE 0 1 2\r\n"
+                            "a=msid-semantic: WMS stream\r\n"
+                            "m=audio 9 UDP/TLS/RTP/SAVPF 111 0\r\n"
+                            "c=IN IP4 0.0.0.0\r\n"
+                            "a=candidate:1 1 udp 2122260223 192.168.0.196 46243 typ host\r\n"
+                            "a=ice-ufrag:8hhY\r\n"
+                            "a=ice-pwd:asd88fgpdd777uzjYhagZg\r\n"
+                            "a=ice-options:trickle\r\n"
+                            "a=fingerprint:sha-256 49:66:12:17:0D:1C:91:AE:57:4C:C6:36:DD:D5:97:D2:"
+                            "7D:62:C9:9A:7F:B9:A3:F2:67:D5:FB:7D:59:35:4E:69\r\n"
+                            "a=setup:actpass\r\n"
+                            "a=mid:0\r\n"
+                            "a=sendrecv\r\n"
+                            "a=rtcp-mux\r\n"
+                            "a=rtpmap:111 opus/48000/2\r\n"
+                            "a=fmtp:111 minptime=10;useinbandfec=1\r\n"
+                            "a=rtpmap:0 PCMU/8000\r\n"
+                            "a=ssrc:1001 cname:benchmark\r\n"
+                            "m=video 9 UDP/TLS/RTP/SAVPF 96 97\r\n"
+                            "c=IN IP4 0.0.0.0\r\n"
+                            "a=mid:1\r\n"
+                            "a=sendrecv\r\n"
+                            "a=rtcp-mux\r\n"
+                            "a=rtpmap:96 H264/90000\r\n"
+                            "a=rtcp-fb:96 nack\r\n"
+                            "a=rtcp-fb:96 nack pli\r\n"
+                            "a=fmtp:96 profile-level-id=42e01f;packetization-mode=1\r\n"
+                            "a=rtpmap:97 rtx/90000\r\n"
+                            "a=fmtp:97 apt=96\r\n"
+                            "a=ssrc:2001 cname:benchmark\r\n"
+                            "m=application 9 UDP/DTLS/SCTP webrtc-datachannel\r\n"
+                            "c=IN IP4 0.0.0.0\r\n"
+                            "a=mid:2\r\n"
+                            "a=sctp-port:5000\r\n"
+                            "a=max-message-size:262144\r\n";
+
+vector<Benchmark> messageBenchmarks() {
+	vector<Benchmark> benchmarks;
+	for (size_t size : {64, 1200, 65536})
+		benchmarks.push_back({"make_message/" + to_string(size), size, [size](uint64_t n) {
+			                      return timeLoop(n, [size](uint64_t) {
+				                      auto message = make_message(size);
+				                      keep(message);
+			                      });
+		                      }});
+
+	benchmarks.push_back({"queue/push_pop", 0, [](uint64_t n) {
+		                      impl::Queue<message_ptr> queue;
+		                      auto message = make_message(1200);
+		                      return timeLoop(n, [&](uint64_t) {
+			                      queue.push(message);
+			                      auto popped = queue.pop();
+			                      keep(popped);
+		                      });
+	                      }});
+
+	benchmarks.push_back({"threadpool/enqueue", 0, [](uint64_t n) {
+		                      std::atomic<uint64_t> done = 0;
+		                      auto &pool = impl::ThreadPool::Instance();
+		                      const auto start = steady_clock::now();
+		                      for (uint64_t i = 0; i < n; ++i)
+			                      pool.enqueue([&done]() { ++done; });
+
+		                      while (done.load() < n)
+			                      std::this_thread::yield();
+
+		                      return steady_clock::now() - start;
+	                      }});
+
+	return benchmarks;
+}
+
+vector<Benchmark> descriptionBenchmarks() {
+	vector<Benchmark> benchmarks;
+	benchmarks.push_back({"sdp/parse", BenchmarkSdp.size(), [](uint64_t n) {
+		                      return timeLoop(n, [](uint64_t) {
+			                      Description description(BenchmarkSdp, Description::Type::Offer);
+			                      keep(description);
+		                      });
+	                      }});
+
+	benchmarks.push_back({"sdp/generate", BenchmarkSdp.size(), [](uint64_t n) {
+		                      Description description(BenchmarkSdp, Description::Type::Offer);
+		                      return timeLoop(n, [&](uint64_t) {
+			                      string sdp = description.generateSdp();
+			                      keep(sdp);
+		                      });
+	                      }});
+
+	return benchmarks;
+}
+
+#if RTC_ENABLE_WEBSOCKET
+
+const string HandshakeRequest = "GET /chat HTTP/1.1\r\n"
+                                "Host: server.example.com\r\n"
+                                "Upgrade: websocket\r\n"
+                                "Connection: Upgrade\r\n"
+                                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                "Sec-WebSocket-Version: 13\r\n"
+                                "Origin: http://example.com\r\n"
+                                "\r\n";
+
+vector<Benchmark> websocketBenchmarks() {
+	vector<Benchmark> benchmarks;
+	benchmarks.push_back({"sha1/accept_key", 60, [](uint64_t n) {
+		                      const string input =
+		                          "dGhlIHNhbXBsZSBub25jZQ==258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+		                      return timeLoop(n, [&](uint64_t) {
+			                      auto digest = impl::Sha1(input);
+			                      keep(digest);
+		                      });
+	                      }});
+
+	benchmarks.push_back({"base64/encode/1200", 1200, [](uint64_t n) {
+		                      const binary data(1200, byte(0xA5));
+		                      return timeLoop(n, [&](uint64_t) {
+			                      string encoded = impl::utils::base64_encode(data);
+			                      keep(encoded);
+		                      });
+	                      }});
+
+	benchmarks.push_back({"base64/decode/1200", 1200, [](uint64_t n) {
+		                      const string encoded =
+		                          impl::utils::base64_encode(binary(1200, byte(0xA5)));
+		                      return timeLoop(n, [&](uint64_t) {
+			                      binary decoded = impl::utils::base64_decode(encoded);
+			                      keep(decoded);
+		                      });
+	                      }});
+
+	// Server side of the opening handshake, the inverse of the time is handshakes per second
+	benchmarks.push_back({"websocket/handshake", HandshakeRequest.size(), [](uint64_t n) {
+		                      auto request = reinterpret_cast<const byte *>(HandshakeRequest.data());
+		                      return timeLoop(n, [&](uint64_t) {
+			                      impl::WsHandshake handshake;
+			                      handshake.parseHttpRequest(request, HandshakeRequest.size());
+			                      string response = handshake.generateHttpResponse();
+			                      keep(response);
+		                      });
+	                      }});
+
+	return benchmarks;
+}
+
+#endif
+
+#if RTC_ENABLE_MEDIA
+
+const size_t FrameSize = 32 * 1024;
+
+void appendNalUnit(binary &frame, std::initializer_list<uint8_t> header, size_t size) {
+	for (uint8_t b : {0x00, 0x00, 0x00, 0x01})
+		frame.push_back(byte(b));
+	for (uint8_t b : header)
+		frame.push_back(byte(b));
+	frame.insert(frame.end(), size - header.size(), byte(0xA5)); // no start sequence
+}
+
+binary makeH264Frame() {
+	binary frame;
+	appendNalUnit(frame, {0x67}, 16);            // SPS
+	appendNalUnit(frame, {0x68}, 8);             // PPS
+	appendNalUnit(frame, {0x65}, FrameSize - 24); // IDR slice
+	return frame;
+}
+
+// A 4K keyframe is typically a few hundred kilobytes
+const size_t LargeFrameSize = 256 * 1024;
+
+binary makeH265Frame(size_t size = FrameSize) {
+	binary frame;
+	appendNalUnit(frame, {0x40, 0x01}, 24);       // VPS
+	appendNalUnit(frame, {0x42, 0x01}, 32);       // SPS
+	appendNalUnit(frame, {0x44, 0x01}, 8);        // PPS
+	appendNalUnit(frame, {0x26, 0x01}, size - 64); // IDR_W_RADL slice
+	return frame;
+}
+
+binary makeAV1TemporalUnit() {
+	binary frame;
+	frame.push_back(byte(0x12)); // temporal delimiter with size field
+	frame.push_back(byte(0x00));
+	frame.push_back(byte(0x32)); // frame OBU with size field
+	for (size_t size = FrameSize; size > 0; size >>= 7) // LEB128
+		frame.push_back(byte((size & 0x7F) | (size > 0x7F ? 0x80 : 0x00)));
+	frame.insert(frame.end(), FrameSize, byte(0xA5));
+	return frame;
+}
+
+shared_ptr<RtpPacketizationConfig> makeRtpConfig() {
+	return std::make_shared<RtpPacketizationConfig>(2001, "benchmark", 96,
+	                                                VideoRtpDepacketizer::ClockRate);
+}
+
+const message_callback IgnoreSend = [](message_ptr) {};
+
+message_vector packetize(MediaHandler &packetizer, RtpPacketizationConfig &config,
+                         const binary &frame) {
+	config.timestamp += 3000;
+	message_vector messages{make_message(frame.begin(), frame.end())};
+	packetizer.outgoing(messages, IgnoreSend);
+	return messages;
+}
+
+template <typename Packetizer, typename... Args>
+Benchmark packetizeBenchmark(string name, binary frame, Args... args) {
+	return {std::move(name), frame.size(), [frame, args...](uint64_t n) {
+		        auto config = makeRtpConfig();
+		        auto packetizer = std::make_shared<Packetizer>(args..., config);
+		        return timeLoop(n, [&](uint64_t) {
+			        auto packets = packetize(*packetizer, *config, frame);
+			        keep(packets);
+		        });
+	        }};
+}
+
+template <typename Packetizer, typename Depacketizer, typename Separator>
+Benchmark depacketizeBenchmark(string name, binary frame, Separator separator) {
+	return {std::move(name), frame.size(), [frame, separator](uint64_t n) {
+		        auto config = makeRtpConfig();
+		        auto packetizer = std::make_shared<Packetizer>(separator, config);
+		        shared_ptr<MediaHandler> depacketizer = std::make_shared<Depacketizer>(separator);
+		        steady_clock::duration elapsed{0};
+		        for (uint64_t i = 0; i < n; ++i) {
+			        auto messages = packetize(*packetizer, *config, frame);
+			        const auto start = steady_clock::now();
+			        depacketizer->incomingChain(messages, IgnoreSend);
+			        elapsed += steady_clock::now() - start;
+			        keep(messages);
+		        }
+		        return elapsed;
+	        }};
+}
+
+vector<Benchmark> packetizationBenchmarks() {
+	using Separator = NalUnit::Separator;
+	vector<Benchmark> benchmarks;
+	benchmarks.push_back(packetizeBenchmark<H264RtpPacketizer>(
+	    "h264/packetize", makeH264Frame(), Separator::LongStartSequence));
+	benchmarks.push_back(depacketizeBenchmark<H264RtpPacketizer, H264RtpDepacketizer>(
+	    "h264/depacketize", makeH264Frame(), Separator::LongStartSequence));
+	benchmarks.push_back(packetizeBenchmark<H265RtpPacketizer>(
+	    "h265/packetize", makeH265Frame(), Separator::LongStartSequence));
+	benchmarks.push_back(depacketizeBenchmark<H265RtpPacketizer, H265RtpDepacketizer>(
+	    "h265/depacketize", makeH265Frame(), Separator::LongStartSequence));
+	benchmarks.push_back(depacketizeBenchmark<H265RtpPacketizer, H265RtpDepacketizer>(
+	    "h265/depacketize/4k", makeH265Frame(LargeFrameSize), Separator::LongStartSequence));
+	benchmarks.push_back(packetizeBenchmark<AV1RtpPacketizer>(
+	    "av1/packetize", makeAV1TemporalUnit(), AV1RtpPacketizer::Packetization::TemporalUnit));
+	return benchmarks;
+}
+
+const size_t RtpPacketSize = 1200;
+
+struct SrtpSession {
+	srtp_t session = nullptr;
+
+	SrtpSession(srtp_ssrc_type_t type, srtp_profile_t profile = srtp_profile_aes128_cm_sha1_80) {
+		// Large enough for the AES-256 key and the salt of any profile
+		static const auto key = []() {
+			std::array<uint8_t, SRTP_AES_256_KEY_LEN + SRTP_SALT_LEN> key;
+			for (size_t i = 0; i < key.size(); ++i)
+				key[i] = uint8_t(i + 1);
+			return key;
+		}();
+
+		srtp_policy_t policy = {};
+		if (srtp_crypto_policy_set_from_profile_for_rtp(&policy.rtp, profile) ||
+		    srtp_crypto_policy_set_from_profile_for_rtcp(&policy.rtcp, profile))
+			throw runtime_error("SRTP profile is not supported");
+
+		policy.ssrc.type = type;
+		policy.key = const_cast<uint8_t *>(key.data());
+		policy.window_size = 1024;
+		policy.allow_repeat_tx = true;
+		if (srtp_err_status_t err = srtp_create(&session, &policy))
+			throw runtime_error("srtp_create failed, status=" + to_string(int(err)));
+	}
+
+	~SrtpSession() { srtp_dealloc(session); }
+
+	SrtpSession(const SrtpSession &) = delete;
+	SrtpSession &operator=(const SrtpSession &) = delete;
+};
+
+// Returns a protected RTP packet with room for the SRTP trailer
+binary protectPacket(SrtpSession &out, uint16_t seqNumber) {
+	binary packet(RtpPacketSize + SRTP_MAX_TRAILER_LEN, byte(0xA5));
+	auto rtp = reinterpret_cast<RtpHeader *>(packet.data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(2001);
+	rtp->setSeqNumber(seqNumber);
+	rtp->setTimestamp(seqNumber * 3000u);
+	int size = int(RtpPacketSize);
+	if (srtp_err_status_t err = srtp_protect(out.session, packet.data(), &size))
+		throw runtime_error("srtp_protect failed, status=" + to_string(int(err)));
+
+	packet.resize(size_t(size));
+	return packet;
+}
+
+bool isSrtpProfileSupported(srtp_profile_t profile) {
+	srtp_policy_t policy = {};
+	return srtp_crypto_policy_set_from_profile_for_rtp(&policy.rtp, profile) == srtp_err_status_ok;
+}
+
+vector<Benchmark> srtpBenchmarks() {
+	// AES-CM with HMAC-SHA1 keeps the unsuffixed names, AES-GCM is skipped if libSRTP lacks it
+	const std::pair<string, srtp_profile_t> profiles[] = {
+	    {"", srtp_profile_aes128_cm_sha1_80},
+	    {"/aes128gcm", srtp_profile_aead_aes_128_gcm},
+	    {"/aes256gcm", srtp_profile_aead_aes_256_gcm},
+	};
+
+	vector<Benchmark> benchmarks;
+	for (const auto &[suffix, profile] : profiles) {
+		if (!isSrtpProfileSupported(profile))
+			continue;
+
+		benchmarks.push_back({"srtp/protect" + suffix, RtpPacketSize, [profile](uint64_t n) {
+			                      SrtpSession out(ssrc_any_outbound, profile);
+			                      steady_clock::duration elapsed{0};
+			                      for (uint64_t i = 0; i < n; ++i) {
+				                      const auto start = steady_clock::now();
+				                      auto packet = protectPacket(out, uint16_t(i));
+				                      elapsed += steady_clock::now() - start;
+				                      keep(packet);
+			                      }
+			                      return elapsed;
+		                      }});
+
+		benchmarks.push_back({"srtp/unprotect" + suffix, RtpPacketSize, [profile](uint64_t n) {
+			                      SrtpSession out(ssrc_any_outbound, profile);
+			                      SrtpSession in(ssrc_any_inbound, profile);
+			                      steady_clock::duration elapsed{0};
+			                      for (uint64_t i = 0; i < n; ++i) {
+				                      auto packet = protectPacket(out, uint16_t(i));
+				                      int size = int(packet.size());
+				                      const auto start = steady_clock::now();
+				                      auto err = srtp_unprotect(in.session, packet.data(), &size);
+				                      elapsed += steady_clock::now() - start;
+				                      if (err != srtp_err_status_ok)
+					                      throw runtime_error("srtp_unprotect failed, status=" +
+					                                          to_string(int(err)));
+			                      }
+			                      return elapsed;
+		                      }});
+	}
+
+	return benchmarks;
+}
+
+// Compound packet with a sender report and a NACK, as received on a video track
+binary makeRtcpCompound() {
+	binary packet(RtcpSr::Size(1) + RtcpNack::Size(4));
+	auto sr = reinterpret_cast<RtcpSr *>(packet.data());
+	sr->preparePacket(1001, 1);
+	sr->getReportBlock(0)->preparePacket(2001, 0, 2, 1000, 0, 10, 0, 0);
+
+	auto nack = reinterpret_cast<RtcpNack *>(packet.data() + RtcpSr::Size(1));
+	nack->preparePacket(2001, 4);
+	unsigned int fciCount = 0;
+	uint16_t fciPid = 0;
+	for (uint16_t seqNumber : {10, 50, 100, 150})
+		nack->addMissingPacket(&fciCount, &fciPid, seqNumber);
+
+	nack->header.header.setLength(uint16_t((RtcpNack::Size(fciCount) / 4) - 1));
+	packet.resize(RtcpSr::Size(1) + RtcpNack::Size(fciCount));
+	return packet;
+}
+
+// RTP packet with five one-byte header extensions, looked up by id like on reception
+binary makeRtpWithExtensions() {
+	const size_t extensionSize = 20;
+	binary packet(sizeof(RtpHeader) + sizeof(RtpExtensionHeader) + extensionSize + 1000);
+	auto rtp = reinterpret_cast<RtpHeader *>(packet.data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(42);
+	rtp->setExtension(true);
+
+	auto extension = rtp->getExtensionHeader();
+	extension->setProfileSpecificId(0xBEDE);
+	extension->setHeaderLength(uint16_t(extensionSize / 4));
+	extension->clearBody();
+	size_t offset = 0;
+	const byte value[3] = {byte(1), byte(2), byte(3)};
+	for (uint8_t id : {1, 3, 5, 9, 13})
+		offset += extension->writeOneByteHeader(offset, id, value, sizeof(value));
+
+	return packet;
+}
+
+vector<Benchmark> rtcpBenchmarks() {
+	vector<Benchmark> benchmarks;
+	const binary compound = makeRtcpCompound();
+	benchmarks.push_back({"rtcp/parse", compound.size(), [compound](uint64_t n) {
+		                      return timeLoop(n, [&](uint64_t) {
+			                      uint64_t sum = 0;
+			                      size_t offset = 0;
+			                      while (offset + sizeof(RtcpHeader) <= compound.size()) {
+				                      auto header = reinterpret_cast<const RtcpHeader *>(
+				                          compound.data() + offset);
+				                      const size_t length = header->lengthInBytes();
+				                      if (length == 0 || offset + length > compound.size())
+					                      break;
+
+				                      if (header->payloadType() == 200) {
+					                      auto sr = reinterpret_cast<const RtcpSr *>(header);
+					                      for (int i = 0; i < header->reportCount(); ++i)
+						                      sum += sr->getReportBlock(i)->getPacketsLostCount();
+				                      } else if (header->payloadType() == 205) {
+					                      auto nack = reinterpret_cast<RtcpNack *>(
+					                          const_cast<RtcpHeader *>(header));
+					                      for (unsigned int i = 0; i < nack->getSeqNoCount(); ++i)
+						                      for (auto seq : nack->parts[i].getSequenceNumbers())
+							                      sum += seq;
+				                      }
+				                      offset += length;
+			                      }
+			                      keep(sum);
+		                      });
+	                      }});
+
+	// Same chain as the RTCP fuzzing harness
+	auto config = std::make_shared<RtpPacketizationConfig>(1, "microbench", 96, 90000);
+	shared_ptr<MediaHandler> chain = std::make_shared<RtcpReceivingSession>();
+	chain->addToChain(std::make_shared<RtcpNackResponder>());
+	chain->addToChain(std::make_shared<RtcpSrReporter>(config));
+	chain->addToChain(std::make_shared<PliHandler>([]() {}));
+	benchmarks.push_back({"rtcp/handlers", compound.size(), [compound, chain](uint64_t n) {
+		                      return timeLoop(n, [&](uint64_t) {
+			                      message_vector messages;
+			                      messages.push_back(make_message(
+			                          compound.begin(), compound.end(), Message::Control));
+			                      chain->incomingChain(messages, IgnoreSend);
+		                      });
+	                      }});
+
+	const binary packet = makeRtpWithExtensions();
+	benchmarks.push_back({"rtp/extensions", 0, [packet](uint64_t n) {
+		                      auto rtp = reinterpret_cast<const RtpHeader *>(packet.data());
+		                      return timeLoop(n, [&](uint64_t) {
+			                      size_t sum = 0;
+			                      auto extension = rtp->getExtensionHeader();
+			                      for (uint8_t id = 1; id < 15; ++id) {
+				                      size_t size = 0;
+				                      if (extension->findHeader(id, size))
+					                      sum += size;
+			                      }
+			                      keep(sum);
+		                      });
+	                      }});
+
+	return benchmarks;
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char **argv) {
+	string filter;
+	auto minTime = duration_cast<steady_clock::duration>(500ms);
+	bool json = false;
+	for (int i = 1; i < argc; ++i) {
+		const string arg = argv[i];
+		if (arg.rfind("--filter=", 0) == 0)
+			filter = arg.substr(9);
+		else if (arg.rfind("--min-time=", 0) == 0)
+			minTime = chrono::milliseconds(std::stoi(arg.substr(11)));
+		else if (arg == "--json")
+			json = true;
+		else {
+			cerr << "Usage: " << argv[0]
+			     << " [--filter=<substring>] [--min-time=<milliseconds>] [--json]" << endl;
+			return 1;
+		}
+	}
+
+	try {
+		rtc::InitLogger(LogLevel::Warning);
+		rtc::Preload();
+
+		vector<Benchmark> benchmarks;
+		auto append = [&benchmarks](vector<Benchmark> other) {
+			for (auto &b : other)
+				benchmarks.push_back(std::move(b));
+		};
+
+		append(messageBenchmarks());
+		append(descriptionBenchmarks());
+#if RTC_ENABLE_WEBSOCKET
+		append(websocketBenchmarks());
+#endif
+#if RTC_ENABLE_MEDIA
+		// libSRTP is initialized by Preload()
+		append(packetizationBenchmarks());
+		append(srtpBenchmarks());
+		append(rtcpBenchmarks());
+#endif
+
+		vector<Result> results;
+		for (const auto &benchmark : benchmarks) {
+			if (!filter.empty() && benchmark.name.find(filter) == string::npos)
+				continue;
+
+			results.push_back(run(benchmark, minTime));
+			if (!json)
+				cerr << "Finished " << benchmark.name << endl;
+		}
+
+		if (json)
+			printJson(results);
+		else
+			printConsole(results);
+
+		rtc::Cleanup().wait();
+		return 0;
+
+	} catch (const std::exception &e) {
+		cerr << "Microbenchmark failed: " << e.what() << endl;
+		return -1;
+	}
+}
@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+const SSRC ssrc = 1000;
+const SSRC rtxSsrc = 2000;
+
+// Media packet with a payload of the given size filled with a pattern
+message_ptr makeRtp(uint16_t seq, size_t payloadSize) {
+	auto message = make_message(sizeof(RtpHeader) + payloadSize);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSeqNumber(seq);
+	rtp->setTimestamp(3000);
+	rtp->setSsrc(ssrc);
+	for (size_t i = 0; i < payloadSize; ++i)
+		message->at(sizeof(RtpHeader) + i) = byte(i & 0xFF);
+
+	return message;
+}
+
+Description::Video makeMedia(bool rtx) {
+	Description::Video video("video", Description::Direction::SendOnly);
+	video.addH264Codec(96);
+	video.addSSRC(ssrc, "video-send");
+	if (rtx) {
+		video.addRtxCodec(97, 96, 90000);
+		video.addRtxSSRC(ssrc, rtxSsrc);
+	}
+	return video;
+}
+
+// Returns the probe appended to the messages, or nullptr if there is none
+message_ptr outgoing(MtuProber &prober, message_vector messages, size_t mediaCount) {
+	prober.outgoing(messages, [](message_ptr) {});
+	return messages.size() > mediaCount ? messages.back() : nullptr;
+}
+
+// Checks the probe is the retransmission of the media packet on the RTX stream, padded to size
+bool isProbe(const message_ptr &probe, uint16_t originalSeq, size_t payloadSize, size_t size) {
+	if (!probe || probe->size() != size)
+		return false;
+
+	auto rtx = reinterpret_cast<const RtpRtx *>(probe->data());
+	const size_t paddingSize = size - (sizeof(RtpHeader) + 2 + payloadSize);
+	if (rtx->header.ssrc() != rtxSsrc || rtx->header.payloadType() != 97 ||
+	    rtx->header.timestamp() != 3000 || rtx->getOriginalSeqNo() != originalSeq ||
+	    !rtx->header.padding() || std::to_integer<size_t>(probe->back()) != paddingSize)
+		return false;
+
+	auto body = reinterpret_cast<const uint8_t *>(rtx->getBody());
+	for (size_t i = 0; i < payloadSize; ++i)
+		if (body[i] != uint8_t(i & 0xFF))
+			return false;
+
+	return true;
+}
+
+TwccHandler::PacketResult result(bool received, size_t size) {
+	TwccHandler::PacketResult result;
+	result.received = received;
+	result.size = size;
+	return result;
+}
+
+} // namespace
+
+TestResult test_mtu_prober() {
+	try {
+		// Probes are 1360 - 58 - 8 = 1294 bytes to probe the first candidate MTU above 1280
+		const size_t probeSize = 1294;
+		const size_t payloadSize = 1200;
+
+		// Without RTX, there is no probing
+		{
+			auto config = make_shared<RtpPacketizationConfig>(ssrc, "cname", 96, 90000);
+			MtuProber prober(config);
+			prober.media(makeMedia(false));
+			if (outgoing(prober, {makeRtp(1, payloadSize)}, 1))
+				return TestResult(false, "Probe sent without RTX");
+		}
+
+		size_t notified = 0;
+		auto config = make_shared<RtpPacketizationConfig>(ssrc, "cname", 96, 90000);
+		MtuProber prober(config, [&notified](size_t mtu) { notified = mtu; });
+		prober.media(makeMedia(true));
+		if (!prober.isSearching() || prober.mtu() != RTC_DEFAULT_MTU)
+			return TestResult(false, "Wrong initial state");
+
+		// The probe is a retransmission of the largest media packet with its own sequence number
+		auto media = makeRtp(10, payloadSize);
+		auto probe = outgoing(prober, {makeRtp(9, 100), media}, 2);
+		if (!isProbe(probe, 10, payloadSize, probeSize))
+			return TestResult(false, "Wrong first probe");
+
+		const auto firstSeq = reinterpret_cast<const RtpHeader *>(probe->data())->seqNumber();
+
+		// The template is a copy, as media packets are encrypted in place after the prober
+		std::fill(media->begin(), media->end(), byte(0xFF));
+
+		// A probe is neither acknowledged nor lost in time, so the next one is sent from the
+		// template after the interval
+		if (outgoing(prober, {}, 0))
+			return TestResult(false, "Probe sent before the interval");
+
+		this_thread::sleep_for(MtuProber::ProbeInterval + 50ms);
+		probe = outgoing(prober, {}, 0);
+		if (!isProbe(probe, 10, payloadSize, probeSize))
+			return TestResult(false, "Probe not built from a copy of the media packet");
+
+		const auto secondSeq = reinterpret_cast<const RtpHeader *>(probe->data())->seqNumber();
+		if (secondSeq != uint16_t(firstSeq + 1))
+			return TestResult(false, "Probes not numbered in sequence");
+
+		// Once the probe is acknowledged, the MTU and the fragment size are raised
+		prober.feedback({result(true, probeSize)});
+		if (prober.mtu() != probeSize + 58 || notified != probeSize + 58)
+			return TestResult(false, "MTU not raised after the probe was acknowledged");
+
+		outgoing(prober, {makeRtp(11, 100)}, 1);
+		if (config->maxFragmentSize != probeSize - sizeof(RtpHeader) - 8)
+			return TestResult(false, "Fragment size not raised");
+
+		// Lost probes end the search after MaxProbes
+		for (int i = 0; i < MtuProber::MaxProbes; ++i) {
+			this_thread::sleep_for(MtuProber::ProbeInterval + 50ms);
+			probe = outgoing(prober, {makeRtp(uint16_t(12 + i), payloadSize)}, 1);
+			if (!probe || probe->size() <= probeSize)
+				return TestResult(false, "Next candidate not probed");
+
+			prober.feedback({result(false, probe->size())});
+		}
+
+		if (prober.isSearching() || prober.mtu() != probeSize + 58)
+			return TestResult(false, "Search not complete after lost probes");
+
+		this_thread::sleep_for(MtuProber::ProbeInterval + 50ms);
+		if (outgoing(prober, {makeRtp(20, payloadSize)}, 1))
+			return TestResult(false, "Probe sent after the search completed");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -9,11 +9,13 @@
 #include "rtc/rtc.hpp"
 #include "test.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
 #include <thread>
+#include <vector>
 
 using namespace rtc;
 using namespace std;
@@ -98,3 +100,139 @@ TestResult test_negotiated() {
 
 	return TestResult(true);
 }
+
+TestResult test_negotiated_bulk() {
+	InitLogger(LogLevel::Debug);
+
+	try {
+		// A first stream id is required, and a range with a used stream id is rejected as a whole
+		PeerConnection pc;
+		DataChannelInit init;
+		init.negotiated = true;
+		bool thrown = false;
+		try {
+			auto channels = pc.createNegotiatedDataChannels({"a", "b"}, init);
+		} catch (const std::invalid_argument &) {
+			thrown = true;
+		}
+		if (!thrown)
+			return TestResult(false, "Negotiated DataChannels created without a stream id");
+
+		init.id = 5;
+		auto single = pc.createDataChannel("single", init);
+		init.id = 3;
+		thrown = false;
+		try {
+			auto channels = pc.createNegotiatedDataChannels({"a", "b", "c", "d"}, init);
+		} catch (const std::invalid_argument &) {
+			thrown = true;
+		}
+		if (!thrown)
+			return TestResult(false, "Negotiated DataChannels created on a used stream id");
+
+		auto channel = pc.createDataChannel("after", init);
+		if (channel->stream() != 3)
+			return TestResult(false, "Stream id reserved by a rejected range");
+
+		if (!pc.createNegotiatedDataChannels({}, init).empty())
+			return TestResult(false, "DataChannels created without labels");
+
+		pc.close();
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+
+	Configuration config;
+	config.disableAutoNegotiation = true;
+	PeerConnection pc1(config);
+	PeerConnection pc2(config);
+
+	pc1.onLocalDescription([&pc2](Description sdp) {
+		pc2.setRemoteDescription(string(sdp));
+		pc2.setLocalDescription(); // Make the answer
+	});
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	auto makeLabels = [](int first, int count) {
+		vector<string> labels;
+		for (int i = 0; i < count; ++i)
+			labels.push_back("channel" + to_string(first + i));
+		return labels;
+	};
+
+	// Channels created before connecting are opened once SCTP is connected
+	DataChannelInit init;
+	init.negotiated = true;
+	init.id = 10;
+	const int count = 50;
+	auto channels1 = pc1.createNegotiatedDataChannels(makeLabels(0, count), init);
+	auto channels2 = pc2.createNegotiatedDataChannels(makeLabels(0, count), init);
+
+	pc1.setLocalDescription();
+
+	auto allOpen = [](const vector<shared_ptr<DataChannel>> &channels) {
+		return std::all_of(channels.begin(), channels.end(),
+		                   [](const auto &channel) { return channel->isOpen(); });
+	};
+
+	int attempts = 10;
+	while ((!allOpen(channels1) || !allOpen(channels2)) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (pc1.state() != PeerConnection::State::Connected ||
+	    pc2.state() != PeerConnection::State::Connected)
+		return TestResult(false, "PeerConnection is not connected");
+
+	// Channels created once connected are opened at once
+	init.id = 10 + count;
+	auto more1 = pc1.createNegotiatedDataChannels(makeLabels(count, count), init);
+	auto more2 = pc2.createNegotiatedDataChannels(makeLabels(count, count), init);
+	channels1.insert(channels1.end(), more1.begin(), more1.end());
+	channels2.insert(channels2.end(), more2.begin(), more2.end());
+
+	attempts = 10;
+	while ((!allOpen(channels1) || !allOpen(channels2)) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!allOpen(channels1) || !allOpen(channels2))
+		return TestResult(false, "Negotiated DataChannels are not open");
+
+	// Channels are on consecutive stream ids, and each one reaches its counterpart
+	std::atomic<int> received = 0;
+	std::atomic<bool> mismatch = false;
+	for (size_t i = 0; i < channels2.size(); ++i) {
+		auto label = channels2[i]->label();
+		channels2[i]->onMessage([label, &received, &mismatch](message_variant message) {
+			if (!holds_alternative<string>(message) || get<string>(message) != label)
+				mismatch = true;
+
+			++received;
+		});
+	}
+
+	for (size_t i = 0; i < channels1.size(); ++i) {
+		if (channels1[i]->stream() != 10 + i || channels2[i]->stream() != 10 + i ||
+		    channels1[i]->label() != "channel" + to_string(i))
+			return TestResult(false, "Wrong negotiated DataChannel stream id or label");
+
+		channels1[i]->send(channels1[i]->label());
+	}
+
+	attempts = 10;
+	while (received < int(channels1.size()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (received != int(channels1.size()) || mismatch)
+		return TestResult(false, "Messages not received on the negotiated DataChannels");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
@@ -0,0 +1,478 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+using clock_type = chrono::steady_clock;
+
+// Records the order of the packets sent by the pacer, tagged by the first byte
+struct Recorder {
+	std::mutex mutex;
+	vector<pair<byte, size_t>> sent;
+	clock_type::time_point last;
+
+	message_callback callback() {
+		return [this](message_ptr message) {
+			std::lock_guard lock(mutex);
+			sent.emplace_back(message->at(0), to_integer<size_t>(message->at(1)));
+			last = clock_type::now();
+		};
+	}
+
+	size_t size() {
+		std::lock_guard lock(mutex);
+		return sent.size();
+	}
+};
+
+// Packets of 1000 bytes tagged with the kind and the index, they are not parsed as RTP
+void enqueue(PacingHandler &handler, Recorder &recorder, byte kind, size_t count) {
+	message_vector messages;
+	for (size_t i = 0; i < count; ++i) {
+		binary data(1000, byte(0));
+		data[0] = kind;
+		data[1] = byte(i);
+		messages.push_back(make_message(std::move(data)));
+	}
+	handler.outgoing(messages, recorder.callback());
+}
+
+bool waitFor(const std::function<bool()> &condition, chrono::milliseconds timeout) {
+	const auto end = clock_type::now() + timeout;
+	while (!condition() && clock_type::now() < end)
+		this_thread::sleep_for(10ms);
+
+	return condition();
+}
+
+// RTP packets sent by the pacer
+struct PacketRecorder {
+	struct Packet {
+		SSRC ssrc;
+		uint8_t payloadType;
+		uint16_t seqNumber;
+		uint32_t timestamp;
+		bool padding;
+		size_t size;
+	};
+
+	std::mutex mutex;
+	vector<Packet> sent;
+
+	message_callback callback() {
+		return [this](message_ptr message) {
+			auto rtp = reinterpret_cast<const RtpHeader *>(message->data());
+			std::lock_guard lock(mutex);
+			sent.push_back({rtp->ssrc(), rtp->payloadType(), rtp->seqNumber(), rtp->timestamp(),
+			                rtp->padding(), message->size()});
+		};
+	}
+
+	vector<Packet> packets() {
+		std::lock_guard lock(mutex);
+		return sent;
+	}
+};
+
+message_ptr makeRtp(SSRC ssrc, uint8_t payloadType, uint16_t seqNumber, uint32_t timestamp,
+                    size_t payloadSize = 100) {
+	auto message = make_message(sizeof(RtpHeader) + payloadSize);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(payloadType);
+	rtp->setSeqNumber(seqNumber);
+	rtp->setTimestamp(timestamp);
+	rtp->setSsrc(ssrc);
+	return message;
+}
+
+// Video with RTX, which is required for padding
+Description::Video makeVideo() {
+	Description::Video video("video", Description::Direction::SendOnly);
+	video.addVP8Codec(96);
+	video.addRtxCodec(97, 96, 90000);
+	video.addSSRC(1000, "video-send");
+	video.addSSRC(1001, "video-send");
+	video.addRtxSSRC(1000, 1001);
+	return video;
+}
+
+// Video frame of a single packet of 1000 bytes
+message_ptr makeFrame(uint32_t timestamp, bool keyframe = false, uint8_t layer = 0) {
+	auto message = makeRtp(1000, 96, uint16_t(timestamp), timestamp, 1000 - sizeof(RtpHeader));
+	message->frameInfo = make_shared<FrameInfo>(timestamp);
+	message->frameInfo->keyframe = keyframe;
+	if (layer > 0)
+		message->frameInfo->temporalLayer = layer;
+
+	return message;
+}
+
+// Video track paced at 10 kB/s with a queue limit, the first frame being sent already
+struct LimitedTrack {
+	shared_ptr<PacingHandler> pacer = make_shared<PacingHandler>(80e3, 10ms);
+	PacketRecorder recorder;
+	std::atomic<size_t> keyframesNeeded = 0;
+
+	LimitedTrack(size_t maxBytes) {
+		pacer->setQueueLimits(maxBytes);
+		pacer->onKeyframeNeeded([this]() { ++keyframesNeeded; });
+		send({makeFrame(0, true)});
+		this_thread::sleep_for(50ms);
+	}
+
+	void send(message_vector messages) { pacer->outgoing(messages, recorder.callback()); }
+
+	// Returns the timestamps of the frames sent once queues are empty
+	vector<uint32_t> sent() {
+		this_thread::sleep_for(600ms);
+		vector<uint32_t> timestamps;
+		for (const auto &packet : recorder.packets())
+			timestamps.push_back(packet.timestamp);
+
+		return timestamps;
+	}
+};
+
+size_t paddingBytes(const vector<PacketRecorder::Packet> &packets) {
+	size_t size = 0;
+	for (const auto &packet : packets)
+		if (packet.padding)
+			size += packet.size;
+
+	return size;
+}
+
+} // namespace
+
+TestResult test_pacing_handler() {
+	// Keep the library initialized, as the pacer runs on the thread pool
+	PeerConnection pc;
+
+	try {
+		const byte Data{'D'};
+		const byte Audio{'A'};
+
+		// SCTP packets are queued after media and paced, 1000 bytes every 10ms
+		{
+			auto base = make_shared<PacingHandler>(800e3, 10ms);
+			auto data = base->fork(PacingHandler::Priority::Data);
+			auto audio = base->fork(PacingHandler::Priority::Audio);
+
+			Recorder recorder;
+			const auto start = clock_type::now();
+			enqueue(*data, recorder, Data, 30);
+			enqueue(*audio, recorder, Audio, 3);
+
+			if (!waitFor([&]() { return recorder.size() == 33; }, 3s))
+				return TestResult(false, "Paced packets not sent");
+
+			std::lock_guard lock(recorder.mutex);
+			size_t nextData = 0, audioSent = 0;
+			for (const auto &[kind, index] : recorder.sent) {
+				if (kind == Data) {
+					if (index != nextData++)
+						return TestResult(false, "SCTP packets reordered");
+				} else if (++audioSent == 3 && nextData > 5) {
+					return TestResult(false, "Audio queued behind SCTP packets");
+				}
+			}
+
+			if (recorder.last - start < 200ms)
+				return TestResult(false, "SCTP packets not paced");
+
+			if (base->droppedCount() != 0)
+				return TestResult(false, "Packets dropped without queue delay limit");
+		}
+
+		// Stale SCTP packets are dropped by age only, the oldest first
+		{
+			auto base = make_shared<PacingHandler>(800e3, 10ms, 100ms);
+			auto data = base->fork(PacingHandler::Priority::Data);
+
+			Recorder recorder;
+			enqueue(*data, recorder, Data, 50);
+			this_thread::sleep_for(1s);
+
+			std::lock_guard lock(recorder.mutex);
+			const size_t sent = recorder.sent.size();
+			for (size_t i = 0; i < sent; ++i)
+				if (recorder.sent[i].second != i)
+					return TestResult(false, "Wrong stale SCTP packets dropped");
+
+			if (sent == 0 || sent >= 50)
+				return TestResult(false, "Stale SCTP packets not dropped");
+
+			if (sent + base->droppedCount() != 50)
+				return TestResult(false, "Wrong count of dropped SCTP packets");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_pacing_padding() {
+	// Keep the library initialized, as the pacer runs on the thread pool
+	PeerConnection pc;
+
+	try {
+		// Padding is only sent at the padding rate, 100 kB/s
+		auto pacer = make_shared<PacingHandler>(8e6, 5ms);
+		pacer->media(makeVideo());
+
+		PacketRecorder recorder;
+		message_vector messages{makeRtp(1000, 96, 1, 3000)};
+		pacer->outgoing(messages, recorder.callback());
+		this_thread::sleep_for(200ms);
+		if (recorder.packets().size() != 1 || pacer->paddingBytes() != 0)
+			return TestResult(false, "Padding sent without padding rate");
+
+		pacer->setPaddingBitrate(800e3);
+		this_thread::sleep_for(500ms);
+		pacer->setPaddingBitrate(0.);
+		this_thread::sleep_for(100ms);
+
+		auto packets = recorder.packets();
+		const size_t padded = paddingBytes(packets);
+		if (padded < 25000 || padded > 75000 || pacer->paddingBytes() != padded)
+			return TestResult(false, "Wrong amount of padding");
+
+		// Padding-only packets go on the RTX stream with consecutive sequence numbers
+		optional<uint16_t> lastSeqNumber;
+		for (size_t i = 1; i < packets.size(); ++i) {
+			const auto &packet = packets[i];
+			if (!packet.padding || packet.ssrc != 1001 || packet.payloadType != 97 ||
+			    packet.timestamp != 3000)
+				return TestResult(false, "Wrong padding packet");
+
+			if (lastSeqNumber && packet.seqNumber != uint16_t(*lastSeqNumber + 1))
+				return TestResult(false, "Padding sequence numbers not consecutive");
+
+			lastSeqNumber = packet.seqNumber;
+		}
+
+		this_thread::sleep_for(200ms);
+		if (recorder.packets().size() != packets.size())
+			return TestResult(false, "Padding sent after it was disabled");
+
+		// Retransmissions share the RTX sequence numbers with padding
+		const size_t count = packets.size();
+		messages = {makeRtp(1001, 97, 5000, 3000), makeRtp(1001, 97, 5000, 3000)};
+		pacer->outgoing(messages, recorder.callback());
+		this_thread::sleep_for(100ms);
+		packets = recorder.packets();
+		if (packets.size() != count + 2 || packets.back().padding ||
+		    packets[packets.size() - 2].seqNumber != uint16_t(*lastSeqNumber + 1) ||
+		    packets.back().seqNumber != uint16_t(*lastSeqNumber + 2))
+			return TestResult(false, "Retransmissions not renumbered");
+
+		// A probe cluster pads up to its rate for its duration, 200 kB/s for 200ms
+		const size_t before = pacer->paddingBytes();
+		pacer->probe(1.6e6, 200ms);
+		this_thread::sleep_for(400ms);
+		const size_t probed = pacer->paddingBytes() - before;
+		if (probed < 20000 || probed > 60000)
+			return TestResult(false, "Wrong amount of padding for the probe cluster");
+
+		this_thread::sleep_for(200ms);
+		if (pacer->paddingBytes() != before + probed)
+			return TestResult(false, "Padding sent after the probe cluster");
+
+		// GCC pads up to the target during startup, for a bounded time without feedback
+		auto gccPacer = make_shared<PacingHandler>(8e6, 5ms);
+		auto gcc = make_shared<GccHandler>(gccPacer, 400000);
+		gcc->addToChain(gccPacer);
+		gcc->mediaChain(makeVideo());
+
+		PacketRecorder gccRecorder;
+		messages = {makeRtp(1000, 96, 1, 3000)};
+		gcc->outgoingChain(messages, gccRecorder.callback());
+		this_thread::sleep_for(1s);
+		const size_t startup = gccPacer->paddingBytes();
+		if (startup < 30000) // 50 kB/s without the initial probe
+			return TestResult(false, "No padding during startup");
+
+		this_thread::sleep_for(5s);
+		const size_t padding = gccPacer->paddingBytes();
+		this_thread::sleep_for(500ms);
+		if (gccPacer->paddingBytes() != padding)
+			return TestResult(false, "Padding not stopped after startup");
+
+		if (gcc->targetBitrate() != 400000)
+			return TestResult(false, "Target bitrate changed without feedback");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_pacing_limits() {
+	// Keep the library initialized, as the pacer runs on the thread pool
+	PeerConnection pc;
+
+	try {
+		// Frames of the highest temporal layer are dropped first, oldest first
+		{
+			LimitedTrack track(3000);
+			track.send({makeFrame(1), makeFrame(2, false, 1), makeFrame(3, false, 2),
+			            makeFrame(4, false, 1), makeFrame(5)});
+			if (track.sent() != vector<uint32_t>{0, 1, 4, 5} || track.pacer->droppedCount() != 2)
+				return TestResult(false, "Wrong frames dropped by temporal layer");
+
+			if (track.keyframesNeeded != 0)
+				return TestResult(false, "Keyframe needed after dropping non-reference frames");
+		}
+
+		// Reference frames are dropped up to the next queued keyframe only
+		{
+			LimitedTrack track(2500);
+			track.send({makeFrame(1), makeFrame(2), makeFrame(3, true), makeFrame(4)});
+			if (track.sent() != vector<uint32_t>{0, 3, 4} || track.pacer->droppedCount() != 2)
+				return TestResult(false, "Wrong reference frames dropped");
+
+			if (track.keyframesNeeded != 0)
+				return TestResult(false, "Keyframe needed while one is queued");
+		}
+
+		// Without a queued keyframe, one is needed and frames are dropped until it is sent
+		{
+			LimitedTrack track(2500);
+			track.send({makeFrame(1), makeFrame(2), makeFrame(3)});
+			if (track.keyframesNeeded != 1 || track.pacer->droppedCount() != 3)
+				return TestResult(false, "Keyframe not needed after dropping reference frames");
+
+			track.send({makeFrame(4)});
+			track.send({makeFrame(5, true), makeFrame(6)});
+			if (track.sent() != vector<uint32_t>{0, 5, 6})
+				return TestResult(false, "Frames sent before the keyframe");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_datachannel_pacer() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	// Set before the SCTP transport exists, 4 Mbps
+	pc1.setDataChannelPacer(
+	    make_shared<PacingHandler>(4e6, 5ms)->fork(PacingHandler::Priority::Data));
+
+	std::atomic<size_t> received1 = 0, received2 = 0;
+	shared_ptr<DataChannel> dc2;
+	std::mutex mutex;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		dc->onMessage([&received2](binary data) { received2 += data.size(); }, nullptr);
+		std::lock_guard lock(mutex);
+		dc2 = std::move(dc);
+	});
+
+	auto dc1 = pc1.createDataChannel("pacer");
+	dc1->onMessage([&received1](binary data) { received1 += data.size(); }, nullptr);
+
+	int attempts = 10;
+	auto ready = [&]() {
+		std::lock_guard lock(mutex);
+		return dc1->isOpen() && dc2 && dc2->isOpen();
+	};
+	while (!ready() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!ready())
+		return TestResult(false, "DataChannel is not open");
+
+	const size_t messageSize = 16384;
+	const size_t total = 64 * messageSize; // 1 MiB
+	auto transfer = [&](DataChannel &dc, std::atomic<size_t> &received,
+	                    optional<chrono::milliseconds> &elapsed) {
+		const size_t target = received + total;
+		const auto start = clock_type::now();
+		for (size_t i = 0; i < total / messageSize; ++i)
+			dc.send(binary(messageSize, byte(i)));
+
+		if (!waitFor([&]() { return received >= target; }, 20s))
+			return false;
+
+		elapsed = chrono::duration_cast<chrono::milliseconds>(clock_type::now() - start);
+		return received == target;
+	};
+
+	// 1 MiB at 4 Mbps takes about 2s
+	optional<chrono::milliseconds> elapsed;
+	if (!transfer(*dc1, received2, elapsed))
+		return TestResult(false, "Paced transfer failed");
+
+	cout << "Paced transfer took " << elapsed->count() << " ms" << endl;
+	if (*elapsed < 1500ms)
+		return TestResult(false, "DataChannel traffic not paced");
+
+	// Null disables pacing
+	pc1.setDataChannelPacer(nullptr);
+	if (!transfer(*dc1, received2, elapsed))
+		return TestResult(false, "Transfer failed after the pacer was removed");
+
+	cout << "Transfer without pacer took " << elapsed->count() << " ms" << endl;
+
+	// Set on an established SCTP transport, 8 Mbps
+	pc2.setDataChannelPacer(
+	    make_shared<PacingHandler>(8e6, 5ms)->fork(PacingHandler::Priority::Data));
+
+	shared_ptr<DataChannel> remote;
+	{
+		std::lock_guard lock(mutex);
+		remote = dc2;
+	}
+	if (!transfer(*remote, received1, elapsed))
+		return TestResult(false, "Transfer failed after the pacer was set");
+
+	cout << "Paced transfer took " << elapsed->count() << " ms" << endl;
+	if (*elapsed < 700ms)
+		return TestResult(false, "DataChannel traffic not paced on the established transport");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif
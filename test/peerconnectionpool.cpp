@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+bool waitAvailable(const PeerConnectionPool &pool, size_t count) {
+	int attempts = 50;
+	while (pool.available() < count && attempts--)
+		this_thread::sleep_for(100ms);
+
+	return pool.available() == count;
+}
+
+} // namespace
+
+TestResult test_peer_connection_pool() {
+	InitLogger(LogLevel::Debug);
+
+	try {
+		// Without pooled connections, they are created on the spot
+		{
+			PeerConnectionPool pool({}, 0);
+			auto pc = pool.take();
+			if (!pc || pc->state() != PeerConnection::State::New)
+				return TestResult(false, "No connection from an empty pool");
+
+			this_thread::sleep_for(100ms);
+			if (pool.available() != 0)
+				return TestResult(false, "Pool of size 0 filled");
+		}
+
+		PeerConnectionPool pool({}, 2);
+		if (!waitAvailable(pool, 2))
+			return TestResult(false, "Pool not filled");
+
+		// Taken connections are new and distinct, and the pool refills in the background
+		std::set<PeerConnection *> taken;
+		vector<shared_ptr<PeerConnection>> connections;
+		for (int i = 0; i < 3; ++i) {
+			auto pc = pool.take();
+			if (!pc || pc->state() != PeerConnection::State::New)
+				return TestResult(false, "Taken connection is not new");
+
+			taken.insert(pc.get());
+			connections.push_back(std::move(pc));
+		}
+		if (taken.size() != 3)
+			return TestResult(false, "Same connection taken twice");
+
+		if (!waitAvailable(pool, 2))
+			return TestResult(false, "Pool not refilled");
+
+		// A pooled connection connects like any other
+		auto pc1 = pool.take();
+		PeerConnection pc2;
+
+		pc1->onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(sdp); });
+		pc1->onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+		pc2.onLocalDescription([&pc1](Description sdp) { pc1->setRemoteDescription(sdp); });
+		pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1->addRemoteCandidate(candidate); });
+
+		std::atomic<bool> received = false;
+		pc2.onDataChannel([&received](shared_ptr<DataChannel> dc) {
+			dc->onMessage([&received](message_variant) { received = true; });
+		});
+
+		auto dc1 = pc1->createDataChannel("test");
+		int attempts = 10;
+		while (!dc1->isOpen() && attempts--)
+			this_thread::sleep_for(1s);
+
+		if (!dc1->isOpen() || pc1->state() != PeerConnection::State::Connected)
+			return TestResult(false, "Pooled connection not connected");
+
+		dc1->send("hello");
+		attempts = 10;
+		while (!received && attempts--)
+			this_thread::sleep_for(100ms);
+
+		if (!received)
+			return TestResult(false, "Message not received on a pooled connection");
+
+		pc1->close();
+		pc2.close();
+		for (auto &pc : connections)
+			pc->close();
+
+		this_thread::sleep_for(1s);
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
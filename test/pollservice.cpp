@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include "impl/pollservice.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using impl::PollService;
+
+#ifndef _WIN32
+
+namespace {
+
+using clock_type = PollService::clock;
+
+// A connected pair of sockets, the first one being polled for reading
+struct Pair {
+	int sockets[2] = {-1, -1};
+
+	std::atomic<int> reads = 0;
+	std::atomic<int> timeouts = 0;
+	std::atomic<int> errors = 0;
+	std::atomic<clock_type::rep> timeoutTime = 0; // time since epoch of the timeout
+
+	Pair() {
+		if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0)
+			throw std::runtime_error("socketpair failed");
+	}
+
+	~Pair() {
+		PollService::Instance().remove(sockets[0]);
+		::close(sockets[0]);
+		::close(sockets[1]);
+	}
+
+	void add(clock_type::duration timeout) {
+		PollService::Params params;
+		params.direction = PollService::Direction::In;
+		params.timeout = timeout;
+		params.callback = [this](PollService::Event event) {
+			switch (event) {
+			case PollService::Event::In: {
+				char buffer[64];
+				while (::recv(sockets[0], buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+				}
+				++reads;
+				break;
+			}
+			case PollService::Event::Timeout:
+				timeoutTime = clock_type::now().time_since_epoch().count();
+				++timeouts;
+				break;
+			default:
+				++errors;
+				break;
+			}
+		};
+		PollService::Instance().add(sockets[0], std::move(params));
+	}
+
+	void write() {
+		const char c = 'x';
+		if (::send(sockets[1], &c, 1, 0) != 1)
+			throw std::runtime_error("send failed");
+	}
+
+	clock_type::time_point timedOut() const {
+		return clock_type::time_point(clock_type::duration(timeoutTime.load()));
+	}
+};
+
+} // namespace
+
+#endif
+
+TestResult test_poll_timeouts() {
+#ifndef _WIN32
+	// Keep the library initialized, as it runs the poll service
+	PeerConnection pc;
+
+	try {
+		const auto timeout = 300ms;
+		const auto tick = 250ms; // timeouts are rounded up to ticks
+
+		// Idle sockets time out once, after the timeout and within a tick
+		vector<unique_ptr<Pair>> idle;
+		const auto start = clock_type::now();
+		for (int i = 0; i < 20; ++i) {
+			idle.push_back(make_unique<Pair>());
+			idle.back()->add(timeout);
+			this_thread::sleep_for(5ms);
+		}
+
+		// Activity postpones the timeout
+		Pair busy;
+		busy.add(timeout);
+		for (int i = 0; i < 10; ++i) {
+			this_thread::sleep_for(100ms);
+			busy.write();
+		}
+		const auto lastWrite = clock_type::now();
+
+		// A removed socket never times out
+		Pair removed;
+		removed.add(timeout);
+		PollService::Instance().remove(removed.sockets[0]);
+
+		this_thread::sleep_for(timeout + 2 * tick);
+
+		for (const auto &pair : idle) {
+			if (pair->timeouts != 1 || pair->errors != 0)
+				return TestResult(false, "Idle socket did not time out once");
+
+			const auto elapsed = pair->timedOut() - start;
+			if (elapsed < timeout || elapsed > timeout + tick + 200ms)
+				return TestResult(false, "Idle socket timed out at the wrong time");
+		}
+
+		if (busy.reads == 0 || busy.errors != 0)
+			return TestResult(false, "Data not read on the busy socket");
+
+		if (busy.timeouts != 1 || busy.timedOut() < lastWrite + timeout - 50ms)
+			return TestResult(false, "Timeout not postponed by activity");
+
+		if (removed.timeouts != 0)
+			return TestResult(false, "Removed socket timed out");
+
+		// A timed-out socket is not polled anymore
+		const int reads = idle.front()->reads;
+		idle.front()->write();
+		this_thread::sleep_for(100ms);
+		if (idle.front()->reads != reads)
+			return TestResult(false, "Timed-out socket still polled");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+#else
+	return TestResult(true);
+#endif
+}
+
+#endif
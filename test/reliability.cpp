@@ -14,6 +14,7 @@
 #include <iostream>
 #include <memory>
 #include <thread>
+#include <vector>
 
 using namespace rtc;
 using namespace std;
@@ -123,7 +124,189 @@ TestResult test_reliability() {
 	if (count != 4)
 		return TestResult(false, "Some DataChannels are not open");
 
+	// Sending on a closed DataChannel is rejected, and nothing is queued
+	dcReliableOrdered->close();
+	try {
+		dcReliableOrdered->send("closed");
+		return TestResult(false, "Send on a closed DataChannel was accepted");
+	} catch (const std::runtime_error &) {
+		// expected
+	}
+
+	if (dcReliableOrdered->bufferedAmount() != 0)
+		return TestResult(false, "Send on a closed DataChannel was queued");
+
+	pc1.close();
+
+	return TestResult(true);
+}
+
+TestResult test_expired_messages() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	// Messages are not read on the receiving side, so reception pauses and the sender is throttled
+	shared_ptr<DataChannel> ttl2, reliable2;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		dc->setMaxAvailableAmount(64 * 1024);
+		if (dc->label() == "ttl")
+			std::atomic_store(&ttl2, dc);
+		else
+			std::atomic_store(&reliable2, dc);
+	});
+
+	DataChannelInit init;
+	init.reliability.maxPacketLifeTime = 200ms;
+	auto ttl1 = pc1.createDataChannel("ttl", init);
+	auto reliable1 = pc1.createDataChannel("reliable");
+
+	int attempts = 10;
+	while ((!ttl1->isOpen() || !reliable1->isOpen() || !std::atomic_load(&ttl2) ||
+	        !std::atomic_load(&reliable2)) &&
+	       attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!ttl1->isOpen() || !reliable1->isOpen() || !ttl2 || !reliable2)
+		return TestResult(false, "DataChannels are not open");
+
+	auto expired = [&pc1]() -> uint64_t {
+		auto stats = pc1.getStats().sctp;
+		return stats ? stats->expiredMessages : 0;
+	};
+
+	// Reads messages until none arrives for a while, returns the count
+	auto drain = [](const shared_ptr<DataChannel> &dc, int expected) {
+		int count = 0;
+		auto last = chrono::steady_clock::now();
+		while (chrono::steady_clock::now() - last < 1s && count < expected) {
+			while (dc->receive()) {
+				++count;
+				last = chrono::steady_clock::now();
+			}
+			this_thread::sleep_for(10ms);
+		}
+		return count;
+	};
+
+	// Far more than the transport buffers can hold, so most messages wait in the send queue
+	const int count = 400;
+	const binary message(16 * 1024, byte(0xFF));
+	for (int i = 0; i < count; ++i)
+		ttl1->send(message);
+
+	this_thread::sleep_for(500ms); // the lifetime is over
+
+	const int ttlReceived = drain(ttl2, count);
+	attempts = 10;
+	while (ttl1->bufferedAmount() > 0 && attempts--)
+		this_thread::sleep_for(100ms);
+
+	if (ttl1->bufferedAmount() != 0)
+		return TestResult(false, "Expired messages still buffered");
+
+	const auto expiredCount = expired();
+	if (expiredCount == 0 || ttlReceived + int(expiredCount) > count)
+		return TestResult(false, "Expired messages not dropped from the send queue");
+
+	// Without a lifetime, messages wait as long as necessary
+	for (int i = 0; i < count; ++i)
+		reliable1->send(message);
+
+	this_thread::sleep_for(500ms);
+
+	if (drain(reliable2, count) != count)
+		return TestResult(false, "Reliable messages lost");
+
+	if (expired() != expiredCount)
+		return TestResult(false, "Reliable messages expired");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+TestResult test_recv_backpressure() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	const size_t limit = 16 * 1024;
+	shared_ptr<DataChannel> dc2;
+	pc2.onDataChannel([&dc2, limit](shared_ptr<DataChannel> dc) {
+		dc->setMaxAvailableAmount(limit);
+		std::atomic_store(&dc2, dc);
+	});
+
+	auto dc1 = pc1.createDataChannel("test");
+
+	int attempts = 10;
+	while ((!dc1->isOpen() || !std::atomic_load(&dc2)) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!dc1->isOpen() || !dc2)
+		return TestResult(false, "DataChannel is not open");
+
+	// Without reading, reception pauses around the limit and the sender is throttled
+	const int large = 200;
+	const binary message(16 * 1024, byte(0xFF));
+	for (int i = 0; i < large; ++i)
+		dc1->send(message);
+
+	this_thread::sleep_for(1s);
+	if (dc2->availableAmount() >= size_t(large) * message.size() || dc1->bufferedAmount() == 0)
+		return TestResult(false, "Reception not paused");
+
+	// Reading concurrently with reception resumes and pauses it many times, and it must never
+	// stay paused with nothing left to read
+	const int small = 5000;
+	std::atomic<int> received = 0;
+	std::atomic<bool> done = false;
+	std::thread reader([&]() {
+		while (!done) {
+			if (dc2->receive())
+				++received;
+			else
+				this_thread::yield();
+		}
+	});
+
+	const binary smallMessage(512, byte(0xFF));
+	for (int i = 0; i < small; ++i)
+		dc1->send(smallMessage);
+
+	attempts = 100;
+	while (received < large + small && attempts--)
+		this_thread::sleep_for(100ms);
+
+	done = true;
+	reader.join();
+
+	if (received != large + small)
+		return TestResult(false, "Reception stalled, received " + to_string(received) + " of " +
+		                             to_string(large + small) + " messages");
+
 	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
 
 	return TestResult(true);
 }
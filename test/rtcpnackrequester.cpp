@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+const SSRC MediaSsrc = 42;
+const SSRC RtxSsrc = 43;
+
+// Records the requests passed down the chain
+class Recorder final : public MediaHandler {
+public:
+	bool requestRetransmission(const vector<uint16_t> &sequenceNumbers,
+	                           const message_callback &) override {
+		std::lock_guard lock(mMutex);
+		mRequested.insert(mRequested.end(), sequenceNumbers.begin(), sequenceNumbers.end());
+		return true;
+	}
+
+	bool requestKeyframe(const message_callback &) override {
+		std::lock_guard lock(mMutex);
+		++mKeyframes;
+		return true;
+	}
+
+	size_t requested(uint16_t seqNo) const {
+		std::lock_guard lock(mMutex);
+		return size_t(std::count(mRequested.begin(), mRequested.end(), seqNo));
+	}
+
+	size_t requested() const {
+		std::lock_guard lock(mMutex);
+		return mRequested.size();
+	}
+
+	size_t keyframes() const {
+		std::lock_guard lock(mMutex);
+		return mKeyframes;
+	}
+
+private:
+	vector<uint16_t> mRequested;
+	size_t mKeyframes = 0;
+	mutable std::mutex mMutex;
+};
+
+message_ptr makePacket(SSRC ssrc, uint8_t payloadType, uint16_t seqNo, binary payload = {}) {
+	auto message = make_message(sizeof(RtpHeader) + payload.size());
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(payloadType);
+	rtp->setSeqNumber(seqNo);
+	rtp->setTimestamp(0);
+	rtp->setSsrc(ssrc);
+	std::copy(payload.begin(), payload.end(), message->begin() + sizeof(RtpHeader));
+	return message;
+}
+
+// RFC 4588: The payload of a retransmission starts with the original sequence number
+message_ptr makeRtx(uint16_t seqNo, uint16_t osn) {
+	return makePacket(RtxSsrc, 97, seqNo,
+	                  {byte(osn >> 8), byte(osn & 0xFF), byte(0xAA), byte(0xAA)});
+}
+
+struct Chain {
+	shared_ptr<RtcpNackRequester> requester;
+	shared_ptr<Recorder> recorder = make_shared<Recorder>();
+
+	template <typename... Args> Chain(Args... args) {
+		requester = make_shared<RtcpNackRequester>(args...);
+		requester->addToChain(recorder);
+
+		Description::Video video("video", Description::Direction::RecvOnly);
+		video.addVP8Codec(96);
+		video.addRtxCodec(97, 96, 90000);
+		requester->mediaChain(video);
+	}
+
+	void receive(const vector<uint16_t> &seqNos) {
+		message_vector messages;
+		for (uint16_t seqNo : seqNos)
+			messages.push_back(makePacket(MediaSsrc, 96, seqNo));
+
+		requester->incoming(messages, [](message_ptr) {});
+	}
+
+	void receive(message_ptr message) {
+		message_vector messages{std::move(message)};
+		requester->incoming(messages, [](message_ptr) {});
+	}
+};
+
+} // namespace
+
+TestResult test_rtcp_nack_requester() {
+	// Keep the library initialized, as requests are repeated on the thread pool
+	PeerConnection pc;
+
+	try {
+		// Reordered packets are not requested again
+		{
+			Chain chain;
+			chain.receive({100, 101, 103});
+			if (chain.recorder->requested(102) != 1 || chain.recorder->requested() != 1)
+				return TestResult(false, "Missing packet not requested");
+
+			chain.receive({102, 104});
+			this_thread::sleep_for(400ms);
+			if (chain.recorder->requested() != 1 || chain.recorder->keyframes() != 0 ||
+			    chain.requester->unrecoveredCount() != 0)
+				return TestResult(false, "Reordered packet requested again");
+		}
+
+		// Retransmissions are recognized by their original sequence number
+		{
+			Chain chain;
+			chain.receive({100, 103});
+			chain.receive(makeRtx(5000, 101));
+			this_thread::sleep_for(200ms);
+			if (chain.recorder->requested(101) != 1 || chain.recorder->requested(102) < 2)
+				return TestResult(false, "Recovered packet requested again");
+
+			chain.receive(makeRtx(5001, 102));
+			const size_t requested = chain.recorder->requested(102);
+			this_thread::sleep_for(400ms);
+			if (chain.recorder->requested(102) != requested || chain.recorder->keyframes() != 0 ||
+			    chain.requester->requestedCount() != requested + 1)
+				return TestResult(false, "Requests repeated after the retransmission");
+		}
+
+		// A packet is given up after maxRetries requests, then a keyframe is requested
+		{
+			Chain chain(3u, 10000ms);
+			chain.receive({100, 102});
+			this_thread::sleep_for(800ms);
+			if (chain.recorder->requested(101) != 3)
+				return TestResult(false, "Wrong count of requests");
+
+			if (chain.recorder->keyframes() != 1 || chain.requester->unrecoveredCount() != 1)
+				return TestResult(false, "Keyframe not requested after maxRetries");
+		}
+
+		// A packet is given up after maxAge
+		{
+			Chain chain(100u, 200ms);
+			chain.receive({100, 102});
+			this_thread::sleep_for(600ms);
+			const size_t requested = chain.recorder->requested(101);
+			if (requested < 1 || requested > 3)
+				return TestResult(false, "Wrong count of requests before maxAge");
+
+			if (chain.recorder->keyframes() != 1 || chain.requester->unrecoveredCount() != 1)
+				return TestResult(false, "Keyframe not requested after maxAge");
+		}
+
+		// A gap beyond maxMissing is not requested, a keyframe is requested instead
+		{
+			Chain chain(10u, 1000ms, size_t(10));
+			chain.receive({100, 121});
+			if (chain.recorder->requested() != 0 || chain.recorder->keyframes() != 1 ||
+			    chain.requester->unrecoveredCount() != 20)
+				return TestResult(false, "Gap beyond maxMissing requested");
+
+			// The oldest missing packets are given up beyond maxMissing
+			chain.receive({127, 136});
+			if (chain.requester->unrecoveredCount() != 23 || chain.recorder->requested(122) != 0 ||
+			    chain.recorder->requested(125) != 1 || chain.recorder->requested(135) != 1)
+				return TestResult(false, "Oldest missing packets not given up");
+		}
+
+		// Sequence numbers wrap around
+		{
+			Chain chain;
+			chain.receive({65534, 65535, 2});
+			if (chain.recorder->requested(0) != 1 || chain.recorder->requested(1) != 1 ||
+			    chain.recorder->requested() != 2)
+				return TestResult(false, "Missing packets not requested across wraparound");
+
+			chain.receive(vector<uint16_t>{0});
+			chain.receive(makeRtx(7, 1));
+			chain.receive({65535}); // duplicate
+			this_thread::sleep_for(400ms);
+			if (chain.recorder->requested() != 2 || chain.recorder->keyframes() != 0 ||
+			    chain.requester->unrecoveredCount() != 0)
+				return TestResult(false, "Wrong requests across wraparound");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -0,0 +1,263 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+const SSRC MediaSsrc = 42;
+const SSRC RtxSsrc = 43;
+const SSRC OtherSsrc = 44;
+
+message_ptr makePacket(uint16_t seqNumber, size_t size = 100, SSRC ssrc = MediaSsrc) {
+	auto message = make_message(size);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(ssrc);
+	rtp->setSeqNumber(seqNumber);
+	rtp->setTimestamp(seqNumber * 3000u);
+	for (size_t i = sizeof(RtpHeader); i < message->size(); ++i)
+		message->at(i) = byte(seqNumber + i);
+	return message;
+}
+
+// Packet with a header extension and the marker bit, so the RTX header must be kept whole
+message_ptr makeExtendedPacket(uint16_t seqNumber) {
+	auto message = makePacket(seqNumber);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->setMarker(true);
+	rtp->setExtension(true);
+	auto ext = rtp->getExtensionHeader();
+	ext->setProfileSpecificId(0xBEDE);
+	ext->setHeaderLength(1);
+	return message;
+}
+
+Description::Video makeMedia() {
+	Description::Video video("video", Description::Direction::SendOnly);
+	video.addVP8Codec(96);
+	video.addRtxCodec(97, 96, 90000);
+	video.addSSRC(MediaSsrc, "cname");
+	video.addRtxSSRC(MediaSsrc, RtxSsrc);
+	video.addSSRC(OtherSsrc, "cname");
+	return video;
+}
+
+// Checks the RTX packet against the original, returns its sequence number
+optional<uint16_t> checkRtx(const Message &rtx, const Message &original) {
+	auto rtp = reinterpret_cast<const RtpHeader *>(original.data());
+	const size_t headerSize = size_t(rtp->getBody() - reinterpret_cast<const char *>(rtp));
+	auto header = reinterpret_cast<const RtpHeader *>(rtx.data());
+	if (rtx.size() != original.size() + 2 || header->ssrc() != RtxSsrc ||
+	    header->payloadType() != 97 || header->marker() != rtp->marker() ||
+	    header->timestamp() != rtp->timestamp() || rtx[0] != original[0])
+		return nullopt;
+
+	// The rest of the header is unchanged, including the extension
+	if (!std::equal(original.begin() + 12, original.begin() + headerSize, rtx.begin() + 12))
+		return nullopt;
+
+	// RFC 4588: the original sequence number precedes the original payload
+	const uint16_t osn = uint16_t(std::to_integer<uint16_t>(rtx[headerSize]) << 8 |
+	                              std::to_integer<uint16_t>(rtx[headerSize + 1]));
+	if (osn != rtp->seqNumber() ||
+	    !std::equal(original.begin() + headerSize, original.end(), rtx.begin() + headerSize + 2))
+		return nullopt;
+
+	return header->seqNumber();
+}
+
+// NACK for a packet and the following ones flagged in the bitmask
+message_ptr makeNack(uint16_t pid, uint16_t blp = 0) {
+	auto message = make_message(RtcpNack::Size(1), Message::Control);
+	auto nack = reinterpret_cast<RtcpNack *>(message->data());
+	nack->preparePacket(MediaSsrc, 1);
+	nack->parts[0].setPid(pid);
+	nack->parts[0].setBlp(blp);
+	return message;
+}
+
+void send(RtcpNackResponder &responder, message_ptr packet) {
+	message_vector messages{std::move(packet)};
+	responder.outgoing(messages, nullptr);
+}
+
+// Returns the retransmissions sent in response to the NACK
+message_vector request(RtcpNackResponder &responder, uint16_t pid, uint16_t blp = 0) {
+	message_vector retransmitted;
+	message_vector messages{makeNack(pid, blp)};
+	responder.incoming(messages,
+	                   [&retransmitted](message_ptr message) { retransmitted.push_back(message); });
+	return retransmitted;
+}
+
+bool isStored(RtcpNackResponder &responder, uint16_t seqNumber, size_t size = 100) {
+	auto retransmitted = request(responder, seqNumber);
+	return retransmitted.size() == 1 && *retransmitted[0] == *makePacket(seqNumber, size);
+}
+
+} // namespace
+
+TestResult test_rtcp_nack_responder() {
+	try {
+		// The window keeps the last packets across the wraparound, even for a ring size which
+		// does not divide the sequence number space
+		{
+			const size_t maxSize = 500;
+			RtcpNackResponder responder(maxSize);
+			const uint16_t first = 65000, count = 636, last = uint16_t(first + count - 1);
+			for (uint16_t i = 0; i < count; ++i)
+				send(responder, makePacket(uint16_t(first + i)));
+
+			for (uint16_t i = 0; i < count; ++i) {
+				const uint16_t seqNumber = uint16_t(first + i);
+				const bool inWindow = uint16_t(last - seqNumber) < maxSize;
+				if (isStored(responder, seqNumber) != inWindow)
+					return TestResult(false, inWindow ? "Packet in the window not retransmitted"
+					                                  : "Packet out of the window retransmitted");
+			}
+
+			// Packets older than the window are not stored
+			send(responder, makePacket(uint16_t(last - maxSize)));
+			if (isStored(responder, uint16_t(last - maxSize)))
+				return TestResult(false, "Packet older than the window stored");
+
+			// A jump forward further than the window clears it
+			send(responder, makePacket(uint16_t(last + 2 * maxSize)));
+			if (isStored(responder, last) || !isStored(responder, uint16_t(last + 2 * maxSize)))
+				return TestResult(false, "Window not moved on a jump forward");
+		}
+
+		// The bitmask requests the following packets
+		{
+			RtcpNackResponder responder;
+			for (uint16_t i = 0; i < 20; ++i)
+				send(responder, makePacket(i));
+
+			auto retransmitted = request(responder, 2, 0x8005); // 2, 3, 5, and 18
+			if (retransmitted.size() != 4 || *retransmitted[0] != *makePacket(2) ||
+			    *retransmitted[1] != *makePacket(3) || *retransmitted[2] != *makePacket(5) ||
+			    *retransmitted[3] != *makePacket(18))
+				return TestResult(false, "Wrong packets retransmitted for the bitmask");
+
+			if (!request(responder, 20).empty())
+				return TestResult(false, "Packet not sent yet retransmitted");
+		}
+
+		// Packets expire after the maximum age, whether or not more packets are stored
+		{
+			RtcpNackResponder responder(RtcpNackResponder::DefaultMaxSize, 50ms);
+			for (uint16_t i = 0; i < 10; ++i)
+				send(responder, makePacket(i));
+
+			if (!isStored(responder, 0) || !isStored(responder, 9))
+				return TestResult(false, "Recent packet not retransmitted");
+
+			this_thread::sleep_for(100ms);
+			if (isStored(responder, 9))
+				return TestResult(false, "Expired packet retransmitted");
+
+			send(responder, makePacket(10));
+			if (isStored(responder, 0) || isStored(responder, 9) || !isStored(responder, 10))
+				return TestResult(false, "Wrong packets after expiry");
+		}
+
+		// The oldest packets are evicted to stay below the maximum total size
+		{
+			RtcpNackResponder responder(RtcpNackResponder::DefaultMaxSize, nullopt, 1000);
+			for (uint16_t i = 0; i < 20; ++i)
+				send(responder, makePacket(i));
+
+			if (isStored(responder, 9) || !isStored(responder, 10) || !isStored(responder, 19))
+				return TestResult(false, "Wrong packets kept under the size limit");
+
+			// A large packet evicts several ones
+			send(responder, makePacket(20, 600));
+			if (isStored(responder, 15) || !isStored(responder, 16) ||
+			    !isStored(responder, 20, 600))
+				return TestResult(false, "Wrong packets kept after a large packet");
+
+			// A packet larger than the limit is not kept either
+			send(responder, makePacket(21, 1200));
+			if (isStored(responder, 20, 600) || isStored(responder, 21, 1200))
+				return TestResult(false, "Packet larger than the limit kept");
+
+			send(responder, makePacket(22));
+			if (!isStored(responder, 22))
+				return TestResult(false, "Packet not stored after the storage emptied");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_rtcp_nack_responder_rtx() {
+	try {
+		RtcpNackResponder responder;
+		responder.media(makeMedia());
+		send(responder, makePacket(10));
+		send(responder, makeExtendedPacket(11));
+
+		// Both packets are wrapped in RTX with consecutive sequence numbers
+		auto retransmitted = request(responder, 10, 0x0001);
+		if (retransmitted.size() != 2)
+			return TestResult(false, "Wrong RTX packet count");
+
+		auto first = checkRtx(*retransmitted[0], *makePacket(10));
+		auto second = checkRtx(*retransmitted[1], *makeExtendedPacket(11));
+		if (!first || !second)
+			return TestResult(false, "Wrong RTX packet");
+
+		if (*second != uint16_t(*first + 1))
+			return TestResult(false, "RTX sequence numbers not consecutive");
+
+		// The stored packet is not altered, and the RTX sequence continues on renegotiation
+		responder.media(makeMedia());
+		retransmitted = request(responder, 11);
+		auto third = retransmitted.size() == 1
+		                 ? checkRtx(*retransmitted[0], *makeExtendedPacket(11))
+		                 : nullopt;
+		if (!third || *third != uint16_t(*second + 1))
+			return TestResult(false, "Wrong RTX packet after renegotiation");
+
+		// A stream without RTX gets the original packet
+		{
+			RtcpNackResponder plain;
+			plain.media(makeMedia());
+			send(plain, makePacket(10, 100, OtherSsrc));
+			retransmitted = request(plain, 10);
+			if (retransmitted.size() != 1 || *retransmitted[0] != *makePacket(10, 100, OtherSsrc))
+				return TestResult(false, "Packet without RTX not resent as-is");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include "impl/utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+message_ptr makeRtp(SSRC ssrc, uint16_t seq, uint32_t timestamp) {
+	auto message = make_message(sizeof(RtpHeader) + 10);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSeqNumber(seq);
+	rtp->setTimestamp(timestamp);
+	rtp->setSsrc(ssrc);
+	return message;
+}
+
+void receive(RtcpReceivingSession &session, message_ptr message) {
+	message_vector messages{std::move(message)};
+	session.incoming(messages, [](message_ptr) {});
+}
+
+optional<RtcpReceivingSession::Stats> find(const vector<RtcpReceivingSession::Stats> &stats,
+                                           SSRC ssrc) {
+	for (const auto &s : stats)
+		if (s.ssrc == ssrc)
+			return s;
+
+	return nullopt;
+}
+
+} // namespace
+
+TestResult test_rtcp_receiving_session() {
+	try {
+		const SSRC localSsrc = 5555;
+		Description::Video media("video", Description::Direction::SendRecv);
+		media.addH264Codec(96);
+		media.addSSRC(localSsrc, "video-send");
+
+		RtcpReceivingSession session;
+		session.media(media);
+
+		// Sequence validation and loss (RFC 3550 A.1 and A.3)
+		for (uint16_t seq = 100; seq < 110; ++seq)
+			if (seq != 105)
+				receive(session, makeRtp(42, seq, 3000 * seq));
+
+		auto stats = find(session.stats(), 42);
+		if (!stats)
+			return TestResult(false, "Missing stats for a valid source");
+
+		// The first packet is in probation, so the base sequence number is 101
+		if (stats->packetsReceived != 8 || stats->packetsLost != 1 ||
+		    stats->extendedHighestSeqNo != 109)
+			return TestResult(false, "Wrong reception stats");
+
+		auto blocks = session.prepareReportBlocks();
+		if (blocks.size() != 1 || blocks[0].getSSRC() != 42 ||
+		    blocks[0].getPacketsLostCount() != 1 || blocks[0].getFractionLost() != (1 << 8) / 9 ||
+		    blocks[0].highestSeqNo() != 109 || blocks[0].seqNoCycles() != 0 ||
+		    blocks[0].getNTPOfSR() != 0)
+			return TestResult(false, "Wrong report block");
+
+		if (!session.prepareReportBlocks().empty())
+			return TestResult(false, "Report block without new packets");
+
+		// The fraction lost is per interval
+		receive(session, makeRtp(42, 110, 3000 * 110));
+		blocks = session.prepareReportBlocks();
+		if (blocks.size() != 1 || blocks[0].getFractionLost() != 0 ||
+		    blocks[0].getPacketsLostCount() != 1)
+			return TestResult(false, "Wrong report block for the second interval");
+
+		stats = find(session.stats(), 42);
+		if (!stats || stats->fractionLost != 0.)
+			return TestResult(false, "Wrong fraction lost in stats");
+
+		// Duplicates make the cumulative loss negative
+		receive(session, makeRtp(42, 110, 3000 * 110));
+		receive(session, makeRtp(42, 110, 3000 * 110));
+		receive(session, makeRtp(42, 105, 3000 * 105)); // late
+		stats = find(session.stats(), 42);
+		if (!stats || stats->packetsLost != -2 || stats->extendedHighestSeqNo != 110)
+			return TestResult(false, "Wrong stats with duplicates and reordering");
+
+		// Sequence number cycles
+		for (uint16_t seq : {65533, 65534, 65535, 0, 1})
+			receive(session, makeRtp(43, seq, 0));
+
+		stats = find(session.stats(), 43);
+		if (!stats || stats->extendedHighestSeqNo != 65536 + 1 || stats->packetsLost != 0)
+			return TestResult(false, "Wrong stats across a sequence number wraparound");
+
+		// Interarrival jitter (RFC 3550 A.8): packets with the same timestamp sent 20ms apart
+		for (uint16_t seq = 0; seq < 3; ++seq) {
+			receive(session, makeRtp(44, seq, 0));
+			this_thread::sleep_for(20ms);
+		}
+		stats = find(session.stats(), 44);
+		if (!stats || stats->jitter < 1ms || stats->jitter > 10ms)
+			return TestResult(false, "Wrong interarrival jitter");
+
+		// LSR and DLSR of the last sender report
+		const uint64_t ntp = impl::utils::ntp_time();
+		auto srMessage = make_message(RtcpSr::Size(0), Message::Control);
+		auto sr = reinterpret_cast<RtcpSr *>(srMessage->data());
+		sr->preparePacket(42, 0);
+		sr->setNtpTimestamp(ntp);
+		receive(session, srMessage);
+		receive(session, makeRtp(42, 111, 3000 * 111));
+		this_thread::sleep_for(50ms);
+
+		blocks = session.prepareReportBlocks();
+		auto it = std::find_if(blocks.begin(), blocks.end(),
+		                       [](const RtcpReportBlock &b) { return b.getSSRC() == 42; });
+		if (it == blocks.end() || ntohl(it->_lastReport) != uint32_t(ntp >> 16) ||
+		    it->delaySinceSR() < 65536 / 50 || it->delaySinceSR() > 65536)
+			return TestResult(false, "Wrong LSR or DLSR");
+
+		// Round-trip time from a report about a local stream (RFC 3550 6.4.1)
+		if (session.roundTripTime())
+			return TestResult(false, "Round-trip time without any report");
+
+		auto rrMessage = make_message(RtcpRr::SizeWithReportBlocks(2), Message::Control);
+		auto rr = reinterpret_cast<RtcpRr *>(rrMessage->data());
+		rr->preparePacket(42, 2);
+		const uint32_t now = uint32_t(impl::utils::ntp_time() >> 16);
+		// A block about another stream is ignored
+		rr->getReportBlock(0)->preparePacket(9999, 0, 0, 0, 0, 0, uint64_t(now - 65536) << 16, 0);
+		// Sent 100ms ago, held 50ms by the peer
+		rr->getReportBlock(1)->preparePacket(localSsrc, 0, 0, 0, 0, 0,
+		                                     uint64_t(now - 65536 / 10) << 16, 65536 / 20);
+		receive(session, rrMessage);
+
+		auto rtt = session.roundTripTime();
+		if (!rtt || *rtt < 40ms || *rtt > 100ms)
+			return TestResult(false, "Wrong round-trip time");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
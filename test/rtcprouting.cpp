@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+const SSRC videoSsrc = 1111;
+const SSRC audioSsrc = 2222;
+const SSRC unknownSsrc = 5;
+
+binary makeSr(SSRC sender, const vector<SSRC> &blocks) {
+	binary packet(RtcpSr::Size(unsigned(blocks.size())));
+	auto sr = reinterpret_cast<RtcpSr *>(packet.data());
+	sr->preparePacket(sender, uint8_t(blocks.size()));
+	sr->setPacketCount(42);
+	for (size_t i = 0; i < blocks.size(); ++i)
+		sr->getReportBlock(int(i))->preparePacket(blocks[i], 0, unsigned(i), 0, 0, 0, 0, 0);
+	return packet;
+}
+
+binary makeRr(SSRC sender, const vector<SSRC> &blocks) {
+	binary packet(RtcpRr::SizeWithReportBlocks(uint8_t(blocks.size())));
+	auto rr = reinterpret_cast<RtcpRr *>(packet.data());
+	rr->preparePacket(sender, uint8_t(blocks.size()));
+	for (size_t i = 0; i < blocks.size(); ++i)
+		rr->getReportBlock(int(i))->preparePacket(blocks[i], 0, unsigned(i), 0, 0, 0, 0, 0);
+	return packet;
+}
+
+binary makeSdes(SSRC ssrc, const string &cname) {
+	binary packet(RtcpSdes::Size({{uint8_t(cname.size())}}));
+	auto sdes = reinterpret_cast<RtcpSdes *>(packet.data());
+	auto chunk = sdes->getChunk(0);
+	chunk->setSSRC(ssrc);
+	auto item = chunk->getItem(0);
+	item->type = 1;
+	item->setText(cname);
+	sdes->preparePacket(1);
+	return packet;
+}
+
+binary makePli(SSRC sender, SSRC media) {
+	binary packet(RtcpPli::Size());
+	auto pli = reinterpret_cast<RtcpPli *>(packet.data());
+	pli->preparePacket(media);
+	pli->header.setPacketSenderSSRC(sender);
+	return packet;
+}
+
+binary concat(std::initializer_list<binary> parts) {
+	binary result;
+	for (const auto &part : parts)
+		result.insert(result.end(), part.begin(), part.end());
+	return result;
+}
+
+struct Received {
+	std::mutex mutex;
+	vector<binary> messages;
+
+	void push(binary message) {
+		std::lock_guard lock(mutex);
+		messages.push_back(std::move(message));
+	}
+
+	vector<binary> wait(size_t count) {
+		int attempts = 20;
+		while (attempts--) {
+			{
+				std::lock_guard lock(mutex);
+				if (messages.size() >= count)
+					break;
+			}
+			this_thread::sleep_for(100ms);
+		}
+		std::lock_guard lock(mutex);
+		return std::exchange(messages, {});
+	}
+};
+
+} // namespace
+
+TestResult test_rtcp_routing() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	Received video, audio;
+	std::atomic<int> opened = 0;
+	vector<shared_ptr<Track>> remoteTracks;
+	std::mutex tracksMutex;
+	pc2.onTrack([&](shared_ptr<Track> t) {
+		auto received = t->mid() == "video" ? &video : &audio;
+		t->onOpen([&opened]() { ++opened; });
+		t->onMessage([received](binary message) { received->push(std::move(message)); },
+		             nullptr);
+		std::lock_guard lock(tracksMutex);
+		remoteTracks.push_back(t);
+	});
+
+	Description::Video videoMedia("video", Description::Direction::SendOnly);
+	videoMedia.addH264Codec(96);
+	videoMedia.addSSRC(videoSsrc, "video-send");
+	auto t1 = pc1.addTrack(videoMedia);
+
+	Description::Audio audioMedia("audio", Description::Direction::SendOnly);
+	audioMedia.addOpusCodec(111);
+	audioMedia.addSSRC(audioSsrc, "audio-send");
+	auto t2 = pc1.addTrack(audioMedia);
+
+	pc1.setLocalDescription();
+
+	int attempts = 10;
+	while ((opened < 2 || !t1->isOpen() || !t2->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (opened < 2 || !t1->isOpen() || !t2->isOpen())
+		return TestResult(false, "Tracks are not open");
+
+	// A compound packet concerning a single track is delivered as is
+	auto whole = concat({makeSr(videoSsrc, {}), makeSdes(videoSsrc, "video-send")});
+	t1->send(whole);
+
+	auto videoMessages = video.wait(1);
+	if (videoMessages.size() != 1 || videoMessages[0] != whole)
+		return TestResult(false, "Compound packet for a single track not delivered as is");
+
+	// Sub-packets and report blocks are routed to their tracks
+	auto compound = concat({makeSr(videoSsrc, {audioSsrc, videoSsrc}),
+	                        makeRr(unknownSsrc, {audioSsrc}), makeSdes(videoSsrc, "video-send"),
+	                        makePli(unknownSsrc, audioSsrc)});
+	t1->send(compound);
+
+	// The SR keeps its sender part, with the report block about each track only
+	auto videoSr = makeSr(videoSsrc, {videoSsrc});
+	reinterpret_cast<RtcpSr *>(videoSr.data())->getReportBlock(0)->setPacketsLost(0, 1);
+	auto expectedVideo = concat({videoSr, makeSdes(videoSsrc, "video-send")});
+	auto expectedAudio = concat({makeSr(videoSsrc, {audioSsrc}), makeRr(unknownSsrc, {audioSsrc}),
+	                             makePli(unknownSsrc, audioSsrc)});
+
+	videoMessages = video.wait(1);
+	auto audioMessages = audio.wait(1);
+	if (videoMessages.size() != 1 || videoMessages[0] != expectedVideo)
+		return TestResult(false, "Wrong compound packet routed to the video track");
+
+	if (audioMessages.size() != 1 || audioMessages[0] != expectedAudio)
+		return TestResult(false, "Wrong compound packet routed to the audio track");
+
+	// Nothing is routed for unknown SSRCs
+	t1->send(concat({makeRr(unknownSsrc, {}), makePli(unknownSsrc, 6)}));
+	this_thread::sleep_for(1s);
+	if (!video.wait(0).empty() || !audio.wait(0).empty())
+		return TestResult(false, "Compound packet routed for unknown SSRCs");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif
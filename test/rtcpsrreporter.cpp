@@ -0,0 +1,316 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+message_ptr makeRtp(SSRC ssrc, uint16_t seq, uint32_t timestamp, size_t payloadSize) {
+	auto message = make_message(sizeof(RtpHeader) + payloadSize);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSeqNumber(seq);
+	rtp->setTimestamp(timestamp);
+	rtp->setSsrc(ssrc);
+	return message;
+}
+
+struct CompoundContent {
+	size_t srCount = 0;
+	size_t rrCount = 0;
+	size_t sdesChunks = 0;
+	size_t blockCount = 0;
+	vector<pair<SSRC, string>> cnames;
+	uint8_t lastType = 0;
+	bool valid = true;
+	bool startsWithReport = false;
+};
+
+CompoundContent parseCompound(const Message &message) {
+	CompoundContent content;
+	size_t offset = 0;
+	while (offset + sizeof(RtcpHeader) <= message.size()) {
+		auto header = reinterpret_cast<const RtcpHeader *>(message.data() + offset);
+		if (header->lengthInBytes() == 0 || offset + header->lengthInBytes() > message.size()) {
+			content.valid = false;
+			break;
+		}
+		if (offset == 0)
+			content.startsWithReport = header->payloadType() == 200 || header->payloadType() == 201;
+
+		switch (header->payloadType()) {
+		case 200:
+			++content.srCount;
+			break;
+		case 201:
+			++content.rrCount;
+			content.blockCount += header->reportCount();
+			break;
+		case 202: {
+			auto sdes = reinterpret_cast<const RtcpSdes *>(header);
+			if (!sdes->isValid()) {
+				content.valid = false;
+				break;
+			}
+			content.sdesChunks += sdes->chunksCount();
+			for (unsigned int i = 0; i < sdes->chunksCount(); ++i) {
+				auto chunk = sdes->getChunk(int(i));
+				content.cnames.emplace_back(chunk->ssrc(), chunk->getItem(0)->text());
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		content.lastType = header->payloadType();
+		offset += header->lengthInBytes();
+	}
+	if (offset != message.size())
+		content.valid = false;
+
+	return content;
+}
+
+} // namespace
+
+TestResult test_rtcp_sr_reporter() {
+	try {
+		// Reports count the packets of the track only
+		auto config = make_shared<RtpPacketizationConfig>(42, "cname", 96, 90000);
+		auto reporter = make_shared<RtcpSrReporter>(config);
+		if (reporter->prepareReport())
+			return TestResult(false, "Report prepared before any packet was sent");
+
+		message_vector messages;
+		messages.push_back(makeRtp(42, 1, 1000, 100));
+		messages.push_back(makeRtp(42, 2, 1000, 100));
+		messages.push_back(makeRtp(43, 1, 5000, 50)); // another stream
+		messages.push_back(make_message(8, Message::Control));
+		messages.push_back(makeRtp(42, 3, 4000, 100));
+		reporter->outgoing(messages, nullptr);
+
+		auto report = reporter->prepareReport();
+		if (!report || report->ssrc != 42 || report->cname != "cname" ||
+		    report->packetCount != 3 || report->octetCount != 300)
+			return TestResult(false, "Wrong report counts");
+
+		// The RTP timestamp is extrapolated from the last packet, never before it
+		if (int32_t(report->rtpTimestamp - 4000) < 0 ||
+		    reporter->lastReportedTimestamp() != report->rtpTimestamp)
+			return TestResult(false, "Wrong report RTP timestamp");
+
+		if (reporter->prepareReport())
+			return TestResult(false, "Report prepared without new packets");
+
+		messages.clear();
+		messages.push_back(makeRtp(42, 4, 7000, 10));
+		reporter->outgoing(messages, nullptr);
+		auto next = reporter->prepareReport();
+		if (!next || next->packetCount != 4 || next->octetCount != 310 ||
+		    next->ntpTimestamp < report->ntpTimestamp)
+			return TestResult(false, "Report counts are not cumulative");
+
+		// Compound packets hold at most 31 reports and fit in the maximum size
+		vector<RtcpSrReporter::Report> reports;
+		for (uint32_t i = 0; i < 40; ++i)
+			reports.push_back({1000 + i, "cname-" + to_string(i), 0, i, i, i});
+
+		const size_t maxSize = 1200;
+		auto packets = RtcpSrReporter::MakeCompoundPackets(reports, {}, 1, "receiver", maxSize);
+		size_t srCount = 0;
+		for (const auto &packet : packets) {
+			auto content = parseCompound(*packet);
+			if (!content.valid || !content.startsWithReport || packet->size() > maxSize)
+				return TestResult(false, "Invalid compound packet");
+
+			if (content.srCount == 0 || content.srCount > 31 ||
+			    content.sdesChunks != content.srCount)
+				return TestResult(false, "Wrong reports or CNAMEs in compound packet");
+
+			srCount += content.srCount;
+		}
+		if (packets.size() < 2 || srCount != reports.size())
+			return TestResult(false, "Reports lost or not split");
+
+		auto sr = reinterpret_cast<const RtcpSr *>(packets.front()->data());
+		if (sr->senderSSRC() != 1000 || sr->packetCount() != 0 || sr->header.reportCount() != 0)
+			return TestResult(false, "Wrong first sender report");
+
+		// The first report is always taken, even if it doesn't fit
+		packets = RtcpSrReporter::MakeCompoundPackets(reports, {}, 1, "receiver", 16);
+		if (packets.size() != reports.size())
+			return TestResult(false, "Wrong split with a small maximum size");
+
+		if (!RtcpSrReporter::MakeCompoundPackets({}, {}, 1, "receiver", maxSize).empty())
+			return TestResult(false, "Packet generated without reports");
+
+		// Packets without sender reports carry the CNAME of the receiver
+		vector<RtcpReportBlock> blocks(40);
+		for (size_t i = 0; i < blocks.size(); ++i)
+			blocks[i].setSSRC(SSRC(2000 + i));
+
+		packets = RtcpSrReporter::MakeCompoundPackets({}, blocks, 7, "receiver", 400);
+		size_t blockCount = 0;
+		for (const auto &packet : packets) {
+			auto content = parseCompound(*packet);
+			if (!content.valid || !content.startsWithReport || packet->size() > 400)
+				return TestResult(false, "Invalid compound packet with receiver reports");
+
+			if (content.srCount != 0 || content.rrCount == 0 ||
+			    content.cnames != vector<pair<SSRC, string>>{{7, "receiver"}})
+				return TestResult(false, "Receiver CNAME missing in compound packet");
+
+			blockCount += content.blockCount;
+		}
+		if (packets.size() < 2 || blockCount != blocks.size())
+			return TestResult(false, "Report blocks lost or not split");
+
+		// Feedback is appended after the SDES, in an empty receiver report if needed
+		const binary feedback = {byte(0x8F), byte(206), byte(0), byte(2), byte(0), byte(0),
+		                         byte(0),    byte(7),   byte(0), byte(0), byte(0), byte(1)};
+		packets = RtcpSrReporter::MakeCompoundPackets({}, {}, 7, "receiver", 1200, {feedback});
+		if (packets.size() != 1)
+			return TestResult(false, "Feedback not sent");
+
+		auto content = parseCompound(*packets[0]);
+		if (!content.valid || !content.startsWithReport || content.rrCount != 1 ||
+		    content.blockCount != 0 || content.lastType != 206 ||
+		    content.cnames != vector<pair<SSRC, string>>{{7, "receiver"}})
+			return TestResult(false, "Wrong compound packet for feedback only");
+
+		packets = RtcpSrReporter::MakeCompoundPackets({reports[0]}, {}, 7, "receiver", 1200,
+		                                              {feedback});
+		content = parseCompound(*packets[0]);
+		if (packets.size() != 1 || !content.valid || content.srCount != 1 ||
+		    content.lastType != 206 ||
+		    content.cnames != vector<pair<SSRC, string>>{{1000, "cname-0"}})
+			return TestResult(false, "Feedback not appended to sender reports");
+
+		// Feedback which does not fit goes in another compound packet
+		const size_t reportSize = packets[0]->size() - feedback.size();
+		packets = RtcpSrReporter::MakeCompoundPackets({reports[0]}, {}, 7, "receiver",
+		                                              reportSize, {feedback});
+		if (packets.size() != 2 || packets[0]->size() != reportSize)
+			return TestResult(false, "Feedback added beyond the maximum size");
+
+		content = parseCompound(*packets[1]);
+		if (!content.valid || content.rrCount != 1 || content.lastType != 206 ||
+		    content.cnames != vector<pair<SSRC, string>>{{7, "receiver"}})
+			return TestResult(false, "Wrong compound packet for feedback");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_rtcp_sr_reporter_timer() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	const SSRC ssrc = 1234;
+	std::atomic<uint32_t> reportedPackets = 0;
+	std::atomic<int> reports = 0;
+	std::atomic<bool> cname = false;
+	shared_ptr<Track> t2;
+	pc2.onTrack([&](shared_ptr<Track> t) {
+		t->onMessage(
+		    [&](binary message) {
+			    Message m(message.begin(), message.end(), Message::Control);
+			    auto content = parseCompound(m);
+			    if (!content.valid || content.srCount == 0)
+				    return;
+
+			    auto sr = reinterpret_cast<const RtcpSr *>(message.data());
+			    if (sr->senderSSRC() != ssrc)
+				    return;
+
+			    // The first report is followed by the SDES packet with the CNAME
+			    cname = content.sdesChunks > 0;
+			    reportedPackets = sr->packetCount();
+			    ++reports;
+		    },
+		    nullptr);
+		std::atomic_store(&t2, t);
+	});
+
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	media.addSSRC(ssrc, "video-send");
+	auto t1 = pc1.addTrack(media);
+
+	auto config = make_shared<RtpPacketizationConfig>(ssrc, "video-send", 96, 90000);
+	t1->setMediaHandler(make_shared<RtcpSrReporter>(config));
+
+	pc1.setLocalDescription();
+
+	int attempts = 10;
+	shared_ptr<Track> at2;
+	while ((!(at2 = std::atomic_load(&t2)) || !at2->isOpen() || !t1->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!at2 || !at2->isOpen() || !t1->isOpen())
+		return TestResult(false, "Track is not open");
+
+	// No report is sent before any packet
+	this_thread::sleep_for(2s);
+	if (reports > 0)
+		return TestResult(false, "Sender report sent before any packet");
+
+	const uint32_t count = 5;
+	for (uint16_t i = 0; i < count; ++i) {
+		auto rtp = makeRtp(ssrc, i, 3000 * i, 100);
+		t1->send(rtp->data(), rtp->size());
+	}
+
+	// Reports are sent by the per-connection timer every second
+	attempts = 5;
+	while ((reports == 0 || reportedPackets != count) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (reports == 0 || reportedPackets != count || !cname)
+		return TestResult(false, "Sender report not received from the timer");
+
+	// Nothing was sent since the last report
+	const int received = reports;
+	this_thread::sleep_for(3s);
+	if (reports > received + 1)
+		return TestResult(false, "Sender reports sent without new packets");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <memory>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+using Bytes = vector<uint8_t>;
+
+// Packetizes a 2-byte audio frame and returns the whole packet
+Bytes packetize(OpusRtpPacketizer &packetizer) {
+	message_vector messages{make_message(binary{byte(0xDE), byte(0xAD)})};
+	packetizer.outgoing(messages, [](message_ptr) {});
+	if (messages.size() != 1)
+		throw std::runtime_error("Frame not packetized in a single packet");
+
+	Bytes packet;
+	for (auto b : *messages.front())
+		packet.push_back(std::to_integer<uint8_t>(b));
+
+	return packet;
+}
+
+} // namespace
+
+TestResult test_rtp_extension_template() {
+	try {
+		auto config = make_shared<RtpPacketizationConfig>(0x11223344, "cname", 111, 48000);
+		config->sequenceNumber = 0x0102;
+		config->timestamp = 0x0A0B0C0D;
+		config->mid = "a";
+		config->midId = 1;
+		config->rid = "r0";
+		config->ridId = 2;
+		config->playoutDelayId = 3;
+		config->playoutDelayMin = 0x123;
+		config->playoutDelayMax = 0x456;
+		config->colorSpaceId = 4; // full range BT.709 by default
+		OpusRtpPacketizer packetizer(config);
+
+		// RFC 8285 4.2. One-Byte Header, padded to 32 bits
+		const Bytes oneByte = {
+		    0x90, 0xEF, 0x01, 0x02, 0x0A, 0x0B, 0x0C, 0x0D, 0x11, 0x22, 0x33, 0x44, // RTP header
+		    0xBE, 0xDE, 0x00, 0x04,                                                 // 4 words
+		    0x10, 0x61,                                                             // MID "a"
+		    0x21, 0x72, 0x30,                                                       // RID "r0"
+		    0x32, 0x12, 0x34, 0x56,                                                 // playout delay
+		    0x43, 0x01, 0x01, 0x01, 0x20,                                           // color space
+		    0x00, 0x00,                                                             // padding
+		    0xDE, 0xAD};                                                            // payload
+		if (packetize(packetizer) != oneByte)
+			return TestResult(false, "Wrong extensions in the one-byte header form");
+
+		// The template follows changes of the configuration
+		config->mid = "b";
+		config->sequenceNumber = 0x0102;
+		Bytes expected = oneByte;
+		expected[17] = 0x62;
+		if (packetize(packetizer) != expected)
+			return TestResult(false, "Extensions not updated after a configuration change");
+
+		// RFC 8285 4.3. Two-Byte Header, required by an id above 14
+		config->mid = "a";
+		config->midId = 15;
+		config->sequenceNumber = 0x0102;
+		const Bytes twoByte = {
+		    0x90, 0xEF, 0x01, 0x02, 0x0A, 0x0B, 0x0C, 0x0D, 0x11, 0x22, 0x33, 0x44, // RTP header
+		    0x10, 0x00, 0x00, 0x05,                                                 // 5 words
+		    0x0F, 0x01, 0x61,                                                       // MID "a"
+		    0x02, 0x02, 0x72, 0x30,                                                 // RID "r0"
+		    0x03, 0x03, 0x12, 0x34, 0x56,                                           // playout delay
+		    0x04, 0x04, 0x01, 0x01, 0x01, 0x20,                                     // color space
+		    0x00, 0x00,                                                             // padding
+		    0xDE, 0xAD};                                                            // payload
+		if (packetize(packetizer) != twoByte)
+			return TestResult(false, "Wrong extensions in the two-byte header form");
+
+		// Extensions with an id of 0 are not negotiated, so they are skipped
+		config->midId = 0;
+		config->ridId = 0;
+		config->playoutDelayId = 0;
+		config->sequenceNumber = 0x0102;
+		const Bytes colorOnly = {
+		    0x90, 0xEF, 0x01, 0x02, 0x0A, 0x0B, 0x0C, 0x0D, 0x11, 0x22, 0x33, 0x44, // RTP header
+		    0xBE, 0xDE, 0x00, 0x02,                                                 // 2 words
+		    0x43, 0x01, 0x01, 0x01, 0x20,                                           // color space
+		    0x00, 0x00, 0x00,                                                       // padding
+		    0xDE, 0xAD};                                                            // payload
+		if (packetize(packetizer) != colorOnly)
+			return TestResult(false, "Extension with an id of 0 written");
+
+		// Without extensions, there is no extension header
+		config->colorSpaceId = 0;
+		config->sequenceNumber = 0x0102;
+		const Bytes none = {0x80, 0xEF, 0x01, 0x02, 0x0A, 0x0B, 0x0C,
+		                    0x0D, 0x11, 0x22, 0x33, 0x44, 0xDE, 0xAD};
+		if (packetize(packetizer) != none)
+			return TestResult(false, "Extension header written without extensions");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
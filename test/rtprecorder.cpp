@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+const string path = "rtprecorder-test.rtpdump";
+
+struct DumpPacket {
+	bool rtcp;
+	vector<uint8_t> data;
+};
+
+uint32_t readUint(const vector<uint8_t> &buffer, size_t pos, size_t size) {
+	uint32_t value = 0;
+	for (size_t i = 0; i < size; ++i)
+		value = (value << 8) | buffer.at(pos + i);
+
+	return value;
+}
+
+// Parses an rtpdump file, throwing if it is malformed
+vector<DumpPacket> readDump() {
+	std::ifstream file(path, std::ios::binary);
+	const vector<uint8_t> buffer{std::istreambuf_iterator<char>(file),
+	                             std::istreambuf_iterator<char>()};
+
+	const string line = "#!rtpplay1.0 0.0.0.0/0\n";
+	if (buffer.size() < line.size() + 16 || !std::equal(line.begin(), line.end(), buffer.begin()))
+		throw std::runtime_error("Wrong rtpdump file header");
+
+	vector<DumpPacket> packets;
+	size_t pos = line.size() + 16;
+	while (pos < buffer.size()) {
+		const size_t length = readUint(buffer, pos, 2);
+		const size_t rtpLength = readUint(buffer, pos + 2, 2);
+		if (length < 8 || pos + length > buffer.size() || (rtpLength && rtpLength != length - 8))
+			throw std::runtime_error("Wrong rtpdump packet header");
+
+		const auto begin = buffer.begin() + pos;
+		packets.push_back(DumpPacket{rtpLength == 0, vector<uint8_t>(begin + 8, begin + length)});
+		pos += length;
+	}
+	return packets;
+}
+
+message_ptr makePacket(size_t size, uint8_t fill, Message::Type type = Message::Binary) {
+	auto message = make_message(size, type);
+	std::fill(message->begin(), message->end(), byte(fill));
+	return message;
+}
+
+bool matches(const DumpPacket &packet, bool rtcp, size_t size, uint8_t fill) {
+	return packet.rtcp == rtcp && packet.data.size() == size &&
+	       std::all_of(packet.data.begin(), packet.data.end(),
+	                   [fill](uint8_t b) { return b == fill; });
+}
+
+} // namespace
+
+TestResult test_rtp_recorder() {
+	// Keep the library initialized, as packets are written on the thread pool
+	PeerConnection pc;
+
+	try {
+		const message_callback send = [](message_ptr) {};
+
+		// Outgoing packets are not recorded by default
+		{
+			RtpRecorder recorder(path);
+			message_vector outgoing{makePacket(100, 0x01)};
+			recorder.outgoing(outgoing, send);
+			recorder.flush();
+			if (recorder.recordedCount() != 0 || !readDump().empty())
+				return TestResult(false, "Outgoing packet recorded by default");
+		}
+
+		RtpRecorderInit init;
+		init.recordOutgoing = true;
+		auto recorder = make_unique<RtpRecorder>(path, init);
+
+		// RTP and RTCP packets are recorded, and other messages are ignored
+		message_vector incoming{makePacket(200, 0x02), makePacket(40, 0x03, Message::Control),
+		                        makePacket(10, 0x04, Message::String)};
+		recorder->incoming(incoming, send);
+
+		// Packets are recorded as they were, even if modified in place afterwards like outgoing
+		// packets encrypted by the transport
+		message_vector outgoing{makePacket(300, 0x05)};
+		recorder->outgoing(outgoing, send);
+		std::fill(outgoing.front()->begin(), outgoing.front()->end(), byte(0xFF));
+		outgoing.front()->resize(310);
+
+		// Packets which don't fit in an rtpdump packet are dropped
+		message_vector oversized{makePacket(0x10000, 0x06)};
+		recorder->incoming(oversized, send);
+
+		recorder->flush();
+		if (recorder->recordedCount() != 3 || recorder->droppedCount() != 1)
+			return TestResult(false, "Wrong recorded or dropped count");
+
+		auto packets = readDump();
+		if (packets.size() != 3 || !matches(packets[0], false, 200, 0x02) ||
+		    !matches(packets[1], true, 40, 0x03) || !matches(packets[2], false, 300, 0x05))
+			return TestResult(false, "Wrong recorded packets");
+
+		// Pending packets are written after the recorder is destroyed, without waiting
+		message_vector last{makePacket(50, 0x07)};
+		recorder->incoming(last, send);
+		recorder.reset();
+
+		int attempts = 10;
+		while ((packets = readDump()).size() < 4 && attempts--)
+			this_thread::sleep_for(100ms);
+
+		if (packets.size() != 4 || !matches(packets[3], false, 50, 0x07))
+			return TestResult(false, "Pending packet not written after destruction");
+
+		std::remove(path.c_str());
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		std::remove(path.c_str());
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+const string path = "rtpreplayer-test.rtpdump";
+
+const SSRC recordedSsrc = 1111;
+const SSRC replayedSsrc = 5555;
+const uint16_t firstSeqNumber = 10;
+const uint32_t firstTimestamp = 1000;
+
+void writeUint(vector<char> &buffer, uint32_t value, size_t size) {
+	for (size_t i = size; i > 0; --i)
+		buffer.push_back(char((value >> ((i - 1) * 8)) & 0xFF));
+}
+
+void writePacket(vector<char> &buffer, const binary &packet, bool rtcp, uint32_t offset) {
+	writeUint(buffer, uint32_t(8 + packet.size()), 2);
+	writeUint(buffer, rtcp ? 0 : uint32_t(packet.size()), 2);
+	writeUint(buffer, offset, 4);
+	for (auto b : packet)
+		buffer.push_back(char(b));
+}
+
+// Writes 5 RTP packets sent every 20ms, with an RTCP packet in the middle, and appends the bytes
+void writeDump(const vector<char> &tail = {}) {
+	vector<char> buffer;
+	const string line = "#!rtpplay1.0 127.0.0.1/5000\n";
+	buffer.insert(buffer.end(), line.begin(), line.end());
+	buffer.resize(buffer.size() + 16);
+
+	for (int i = 0; i < 5; ++i) {
+		binary packet(sizeof(RtpHeader) + 4, byte(i));
+		auto rtp = reinterpret_cast<RtpHeader *>(packet.data());
+		rtp->preparePacket();
+		rtp->setPayloadType(96);
+		rtp->setSeqNumber(uint16_t(firstSeqNumber + i));
+		rtp->setTimestamp(firstTimestamp + uint32_t(i) * 3000);
+		rtp->setSsrc(recordedSsrc);
+		writePacket(buffer, packet, false, uint32_t(i) * 20);
+
+		if (i == 2)
+			writePacket(buffer, binary(8, byte(0xFF)), true, 50);
+	}
+
+	buffer.insert(buffer.end(), tail.begin(), tail.end());
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(buffer.data(), std::streamsize(buffer.size()));
+}
+
+// Expected timestamp of a replayed packet, shifted by a period of 80ms plus the gap of 20ms on
+// each loop at 90kHz
+uint32_t expectedTimestamp(uint16_t seqNumber) {
+	const int index = int(uint16_t(seqNumber - firstSeqNumber));
+	return firstTimestamp + uint32_t(index % 5) * 3000 + uint32_t(index / 5) * 9000;
+}
+
+} // namespace
+
+TestResult test_rtp_replayer() {
+	InitLogger(LogLevel::Debug);
+
+	try {
+		// Dumps are indexed with their RTCP packets, and a truncated end is ignored
+		const vector<char> truncated = {char(0x00), char(0x40), char(0x00), char(0x38), char(0x00),
+		                                char(0x00), char(0x00), char(0x64), char(0x80), char(0x60)};
+		writeDump(truncated);
+		auto dump = RtpDump::Load(path);
+		if (dump->packets().size() != 6 || dump->rtpCount() != 5 || dump->duration() != 80ms ||
+		    !dump->packets()[3].rtcp || dump->packets()[3].offset != 50ms ||
+		    dump->packets()[3].size != 8 || dump->packets()[0].size != sizeof(RtpHeader) + 4)
+			return TestResult(false, "Wrong RTP dump index");
+
+		bool thrown = false;
+		try {
+			std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a dump\n";
+			RtpDump::Load(path);
+		} catch (const std::invalid_argument &) {
+			thrown = true;
+		}
+		if (!thrown)
+			return TestResult(false, "Invalid RTP dump loaded");
+
+		std::remove(path.c_str());
+
+	} catch (const exception &e) {
+		std::remove(path.c_str());
+		return TestResult(false, e.what());
+	}
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	std::mutex mutex;
+	vector<binary> received;
+	shared_ptr<Track> t2;
+	pc2.onTrack([&](shared_ptr<Track> t) {
+		t->onMessage(
+		    [&](binary message) {
+			    std::lock_guard lock(mutex);
+			    received.push_back(std::move(message));
+		    },
+		    nullptr);
+		std::atomic_store(&t2, t);
+	});
+
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	media.addSSRC(replayedSsrc, "video-send");
+	auto t1 = pc1.addTrack(media);
+
+	pc1.setLocalDescription();
+
+	int attempts = 10;
+	shared_ptr<Track> at2;
+	while ((!(at2 = std::atomic_load(&t2)) || !at2->isOpen() || !t1->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!at2 || !at2->isOpen() || !t1->isOpen())
+		return TestResult(false, "Track is not open");
+
+	// Returns the received RTP packets, waiting for the expected count
+	auto receivedPackets = [&](size_t expected) {
+		int attempts = 20;
+		while (attempts--) {
+			{
+				std::lock_guard lock(mutex);
+				if (received.size() >= expected)
+					break;
+			}
+			this_thread::sleep_for(100ms);
+		}
+
+		std::lock_guard lock(mutex);
+		vector<binary> packets;
+		for (auto &packet : received)
+			if (packet.size() >= sizeof(RtpHeader) &&
+			    reinterpret_cast<const RtpHeader *>(packet.data())->payloadType() == 96)
+				packets.push_back(std::move(packet));
+
+		received.clear();
+		return packets;
+	};
+
+	try {
+		writeDump();
+		auto dump = RtpDump::Load(path);
+		std::remove(path.c_str()); // the dump is kept in memory
+
+		// The dump is replayed once at half speed with the SSRC of the track
+		{
+			RtpReplayerInit init;
+			init.speed = 0.5;
+			init.ssrc = replayedSsrc;
+			RtpReplayer replayer(dump, t1, init);
+
+			std::atomic<bool> completed = false;
+			replayer.onComplete([&completed]() { completed = true; });
+			const auto start = chrono::steady_clock::now();
+			replayer.start();
+			if (!replayer.isRunning())
+				return TestResult(false, "Replayer not running after start");
+
+			attempts = 100;
+			while (!completed && attempts--)
+				this_thread::sleep_for(10ms);
+
+			const auto elapsed = chrono::steady_clock::now() - start;
+			if (!completed || replayer.isRunning())
+				return TestResult(false, "Replay not completed");
+
+			if (elapsed < 140ms)
+				return TestResult(false, "Replay faster than the requested speed");
+
+			if (replayer.sentCount() != 5)
+				return TestResult(false, "Recorded RTCP packet replayed without the option");
+
+			auto packets = receivedPackets(5);
+			if (packets.size() != 5)
+				return TestResult(false, "Replayed packets not received");
+
+			for (size_t i = 0; i < packets.size(); ++i) {
+				auto rtp = reinterpret_cast<const RtpHeader *>(packets[i].data());
+				if (rtp->ssrc() != replayedSsrc || rtp->seqNumber() != firstSeqNumber + i ||
+				    rtp->timestamp() != expectedTimestamp(rtp->seqNumber()))
+					return TestResult(false, "Wrong replayed packet");
+			}
+		}
+
+		// When looping, sequence numbers and timestamps continue across loops
+		{
+			RtpReplayerInit init;
+			init.speed = 10.;
+			init.loop = true;
+			init.ssrc = replayedSsrc;
+			RtpReplayer replayer(dump, t1, init);
+			std::atomic<bool> completed = false;
+			replayer.onComplete([&completed]() { completed = true; });
+			replayer.start();
+			this_thread::sleep_for(200ms); // about 20 loops
+
+			replayer.stop();
+			const auto sent = replayer.sentCount();
+			this_thread::sleep_for(100ms);
+			if (replayer.isRunning() || replayer.sentCount() != sent)
+				return TestResult(false, "Packets replayed after stop");
+
+			if (sent < 15 || completed)
+				return TestResult(false, "Dump not looped");
+
+			auto packets = receivedPackets(size_t(sent));
+			if (packets.size() < 15)
+				return TestResult(false, "Looped packets not received");
+
+			for (const auto &packet : packets) {
+				auto rtp = reinterpret_cast<const RtpHeader *>(packet.data());
+				if (rtp->ssrc() != replayedSsrc ||
+				    uint16_t(rtp->seqNumber() - firstSeqNumber) >= sent ||
+				    rtp->timestamp() != expectedTimestamp(rtp->seqNumber()))
+					return TestResult(false, "Wrong looped packet");
+			}
+		}
+
+	} catch (const exception &e) {
+		std::remove(path.c_str());
+		return TestResult(false, e.what());
+	}
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <cstdint>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+const string MidUri = "urn:ietf:params:rtp-hdrext:sdes:mid";
+const string AbsSendTimeUri = "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time";
+
+// RTP packet with a one-byte header extension if ext is not empty, padded to a 32-bit boundary
+message_ptr makePacket(SSRC ssrc, uint8_t payloadType, uint16_t seqNumber, uint32_t timestamp,
+                       binary ext = {}) {
+	binary data(12, byte(0));
+	data[0] = byte(ext.empty() ? 0x80 : 0x90);
+	data[1] = byte(payloadType);
+	for (int i = 0; i < 2; ++i)
+		data[2 + i] = byte(seqNumber >> (8 * (1 - i)));
+	for (int i = 0; i < 4; ++i) {
+		data[4 + i] = byte(timestamp >> (8 * (3 - i)));
+		data[8 + i] = byte(ssrc >> (8 * (3 - i)));
+	}
+
+	if (!ext.empty()) {
+		ext.resize((ext.size() + 3) / 4 * 4, byte(0));
+		const size_t words = ext.size() / 4;
+		data.insert(data.end(), {byte(0xBE), byte(0xDE), byte(words >> 8), byte(words & 0xFF)});
+		data.insert(data.end(), ext.begin(), ext.end());
+	}
+
+	data.insert(data.end(), 20, byte(0xAA)); // payload
+	return make_message(std::move(data));
+}
+
+uint32_t read(const Message &message, size_t offset, size_t size) {
+	uint32_t value = 0;
+	for (size_t i = 0; i < size; ++i)
+		value = (value << 8) | to_integer<uint32_t>(message[offset + i]);
+	return value;
+}
+
+uint8_t payloadType(const Message &message) { return uint8_t(read(message, 1, 1) & 0x7F); }
+uint16_t seqNumber(const Message &message) { return uint16_t(read(message, 2, 2)); }
+uint32_t timestamp(const Message &message) { return read(message, 4, 4); }
+SSRC ssrc(const Message &message) { return read(message, 8, 4); }
+
+message_vector rewrite(RtpRewriter &rewriter, message_vector messages) {
+	rewriter.outgoing(messages, nullptr);
+	return messages;
+}
+
+} // namespace
+
+TestResult test_rtp_rewriter() {
+	try {
+		RtpRewriter rewriter(4242);
+		if (rewriter.ssrc() != 4242 || rewriter.source())
+			return TestResult(false, "Wrong initial SSRCs");
+
+		// Packets get the SSRC of the track with sequence numbers and timestamps translated
+		message_vector messages;
+		for (int i = 0; i < 5; ++i)
+			messages.push_back(makePacket(1, 96, uint16_t(65533 + i), uint32_t(3000 * i)));
+
+		auto control = make_message(binary(8, byte(0x42)), Message::Control);
+		messages.push_back(control);
+
+		messages = rewrite(rewriter, std::move(messages));
+		if (messages.size() != 6 || rewriter.source() != 1)
+			return TestResult(false, "Packets not forwarded");
+
+		const uint16_t firstSeqNumber = seqNumber(*messages[0]);
+		const uint32_t firstTimestamp = timestamp(*messages[0]);
+		for (int i = 0; i < 5; ++i) {
+			const auto &message = *messages[i];
+			if (ssrc(message) != 4242 || payloadType(message) != 96)
+				return TestResult(false, "Wrong rewritten SSRC or payload type");
+
+			if (seqNumber(message) != uint16_t(firstSeqNumber + i) ||
+			    timestamp(message) != firstTimestamp + uint32_t(3000 * i))
+				return TestResult(false, "Sequence numbers or timestamps not continuous");
+		}
+
+		if (messages[5] != control || *control != binary(8, byte(0x42)))
+			return TestResult(false, "Control message modified");
+
+		// A late packet is translated too, without moving the stream forward
+		messages = rewrite(rewriter, {makePacket(1, 96, 65535, 6000), makePacket(1, 96, 2, 15000)});
+		if (seqNumber(*messages[0]) != uint16_t(firstSeqNumber + 2) ||
+		    seqNumber(*messages[1]) != uint16_t(firstSeqNumber + 5))
+			return TestResult(false, "Wrong translation across wraparound");
+
+		// Changing the forwarded SSRC keeps the outgoing stream continuous
+		messages = rewrite(rewriter, {makePacket(2, 96, 50, 777), makePacket(2, 96, 51, 3777)});
+		if (rewriter.source() != 2 || ssrc(*messages[0]) != 4242)
+			return TestResult(false, "Forwarded SSRC change not followed");
+
+		const uint32_t lastTimestamp = firstTimestamp + 15000;
+		if (seqNumber(*messages[0]) != uint16_t(firstSeqNumber + 6) ||
+		    seqNumber(*messages[1]) != uint16_t(firstSeqNumber + 7))
+			return TestResult(false, "Sequence numbers not continuous after SSRC change");
+
+		if (int32_t(timestamp(*messages[0]) - lastTimestamp) <= 0 ||
+		    timestamp(*messages[1]) != timestamp(*messages[0]) + 3000)
+			return TestResult(false, "Timestamps not continuous after SSRC change");
+
+		// Payload types and extensions are mapped to the track, retransmissions are dropped
+		Description::Video target("video", Description::Direction::SendOnly);
+		target.addVP8Codec(96);
+		target.addH264Codec(100);
+		target.addExtMap(Description::Entry::ExtMap(9, MidUri));
+		rewriter.media(target);
+
+		Description::Video source("video", Description::Direction::RecvOnly);
+		source.addVP8Codec(100);
+		source.addRtxCodec(101, 100, 90000);
+		source.addExtMap(Description::Entry::ExtMap(3, MidUri));
+		source.addExtMap(Description::Entry::ExtMap(5, AbsSendTimeUri));
+		rewriter.setSourceMedia(source);
+
+		const binary ext = {byte(0x30), byte('v'), byte(0x52), byte(1), byte(2), byte(3)};
+		auto packet = makePacket(2, 100, 52, 6777, ext);
+		const size_t size = packet->size();
+		messages = rewrite(rewriter, {packet, makePacket(2, 101, 7, 6777)});
+		if (messages.size() != 1 || messages[0] != packet)
+			return TestResult(false, "Retransmission not dropped");
+
+		if (packet->size() != size || payloadType(*packet) != 96)
+			return TestResult(false, "Payload type not mapped by codec");
+
+		// The mid is remapped, the extension the track has not negotiated becomes padding
+		const binary expected = {byte(0x90), byte('v'), byte(0), byte(0),
+		                         byte(0),    byte(0),   byte(0), byte(0)};
+		if (!equal(expected.begin(), expected.end(), packet->begin() + 16))
+			return TestResult(false, "Header extensions not remapped");
+
+		if (seqNumber(*packet) != uint16_t(firstSeqNumber + 8))
+			return TestResult(false, "Dropped retransmission moved the stream");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
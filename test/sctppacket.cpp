@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/sctppacket.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::sctp_parse_zero_checksum_acceptable;
+using impl::sctp_requires_checksum;
+
+namespace {
+
+enum ChunkType : uint8_t {
+	Data = 0,
+	Init = 1,
+	InitAck = 2,
+	Sack = 3,
+	Abort = 6,
+	CookieEcho = 10,
+	CookieAck = 11,
+	ShutdownComplete = 14,
+};
+
+void write16(binary &data, uint16_t value) {
+	data.push_back(byte(value >> 8));
+	data.push_back(byte(value & 0xFF));
+}
+
+// Chunk with its header, padded to 4 bytes
+binary chunk(uint8_t type, binary value = {}) {
+	binary data = {byte(type), byte(0)};
+	write16(data, uint16_t(4 + value.size()));
+	data.insert(data.end(), value.begin(), value.end());
+	data.resize((data.size() + 3) & ~size_t(3), byte(0));
+	return data;
+}
+
+// Parameter of an INIT or INIT ACK chunk, padded to 4 bytes
+binary param(uint16_t type, binary value) {
+	binary data;
+	write16(data, type);
+	write16(data, uint16_t(4 + value.size()));
+	data.insert(data.end(), value.begin(), value.end());
+	data.resize((data.size() + 3) & ~size_t(3), byte(0));
+	return data;
+}
+
+binary zeroChecksumAcceptable(uint32_t edmid) {
+	binary value;
+	write16(value, uint16_t(edmid >> 16));
+	write16(value, uint16_t(edmid & 0xFFFF));
+	return param(0x8001, value);
+}
+
+binary init(uint8_t type, vector<binary> params) {
+	binary value(16, byte(0x11)); // tag, a_rwnd, streams, and initial TSN
+	for (const auto &p : params)
+		value.insert(value.end(), p.begin(), p.end());
+
+	return chunk(type, std::move(value));
+}
+
+binary packet(vector<binary> chunks) {
+	binary data(12, byte(0)); // ports, verification tag, and checksum
+	for (const auto &c : chunks)
+		data.insert(data.end(), c.begin(), c.end());
+
+	return data;
+}
+
+bool requiresChecksum(const binary &data) {
+	return sctp_requires_checksum(data.data(), data.size());
+}
+
+// Returns 1 if accepted, 0 if not, and -1 for other packets
+int zeroChecksum(const binary &data) {
+	bool accepted = false;
+	if (!sctp_parse_zero_checksum_acceptable(data.data(), data.size(), accepted))
+		return -1;
+
+	return accepted ? 1 : 0;
+}
+
+} // namespace
+
+TestResult test_sctp_packet() {
+	try {
+		// Zero Checksum Acceptable is parsed from INIT and INIT ACK
+		const auto cookie = param(7, binary(5, byte(0x42))); // State Cookie, padded
+		const auto extensions = param(0x8008, {byte(0x82)}); // Supported Extensions, padded
+		const auto initAck = init(InitAck, {cookie, extensions, zeroChecksumAcceptable(1)});
+		if (zeroChecksum(packet({init(Init, {zeroChecksumAcceptable(1)})})) != 1 ||
+		    zeroChecksum(packet({initAck})) != 1)
+			return TestResult(false, "Zero Checksum Acceptable not parsed");
+
+		if (zeroChecksum(packet({init(Init, {extensions})})) != 0 ||
+		    zeroChecksum(packet({init(InitAck, {})})) != 0)
+			return TestResult(false, "Zero Checksum Acceptable parsed while absent");
+
+		// Only the DTLS Error Detection Method is accepted
+		if (zeroChecksum(packet({init(Init, {zeroChecksumAcceptable(2)})})) != 0)
+			return TestResult(false, "Wrong Error Detection Method accepted");
+
+		// The parameter must fit in the chunk
+		auto truncated = packet({init(Init, {extensions, zeroChecksumAcceptable(1)})});
+		truncated[12 + 3] = byte(4 + 16 + 8 + 4); // chunk length without the last 4 bytes
+		if (zeroChecksum(truncated) != 0)
+			return TestResult(false, "Zero Checksum Acceptable parsed beyond the chunk");
+
+		// A zero-length parameter stops the parsing
+		const auto zeroLength = init(Init, {binary(4, byte(0)), zeroChecksumAcceptable(1)});
+		if (zeroChecksum(packet({zeroLength})) != 0)
+			return TestResult(false, "Zero-length parameter not handled");
+
+		// Other packets are ignored
+		const auto data = chunk(Data, binary(13, byte(0xAA)));
+		if (zeroChecksum(packet({data})) != -1 ||
+		    zeroChecksum(packet({chunk(CookieEcho, binary(32, byte(0)))})) != -1 ||
+		    zeroChecksum(packet({})) != -1 || zeroChecksum(binary(12 + 4 + 8, byte(1))) != -1)
+			return TestResult(false, "Other packet parsed as INIT");
+
+		// INIT, INIT ACK, COOKIE ECHO, ABORT and SHUTDOWN COMPLETE always get a checksum
+		for (uint8_t type : {Init, InitAck})
+			if (!requiresChecksum(packet({init(type, {zeroChecksumAcceptable(1)})})))
+				return TestResult(false, "INIT without checksum");
+
+		if (!requiresChecksum(packet({chunk(CookieEcho, binary(32, byte(0))), data})))
+			return TestResult(false, "COOKIE ECHO without checksum");
+
+		if (!requiresChecksum(packet({chunk(Abort)})) ||
+		    !requiresChecksum(packet({chunk(ShutdownComplete)})))
+			return TestResult(false, "ABORT or SHUTDOWN COMPLETE without checksum");
+
+		// Chunks are found after padded chunks
+		if (!requiresChecksum(packet({chunk(Sack, binary(12, byte(0))), data, chunk(Abort)})))
+			return TestResult(false, "Bundled ABORT without checksum");
+
+		// Other chunks may have a zero checksum
+		if (requiresChecksum(packet({data})) ||
+		    requiresChecksum(packet({chunk(CookieAck), data})) ||
+		    requiresChecksum(packet({chunk(Sack, binary(12, byte(0))), data, data})) ||
+		    requiresChecksum(packet({})))
+			return TestResult(false, "Checksum required for other chunks");
+
+		// A malformed chunk length stops the parsing
+		auto malformed = packet({data, chunk(Abort)});
+		malformed[12 + 3] = byte(0);
+		if (requiresChecksum(malformed))
+			return TestResult(false, "Malformed chunk length not handled");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,254 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/sendqueue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using impl::SendQueue;
+using Result = SendQueue::Result;
+
+namespace {
+
+// Socket which accepts packets until its buffer is full
+struct Socket {
+	std::atomic<int> capacity = 1000; // packets accepted before blocking
+	std::atomic<bool> failing = false;
+	vector<int> sent;
+	vector<chrono::milliseconds> retries;
+	vector<size_t> amounts;
+	std::mutex mutex;
+
+	Result send(const message_ptr &message) {
+		if (failing)
+			return Result::Failed;
+
+		if (capacity <= 0)
+			return Result::WouldBlock;
+
+		--capacity;
+		std::lock_guard lock(mutex);
+		sent.push_back(id(*message));
+		return Result::Sent;
+	}
+
+	// Sends packets in a row like a batched system call, stopping at the first one which blocks
+	bool sendBatch(message_vector &messages, message_vector &blocked) {
+		for (auto it = messages.begin(); it != messages.end(); ++it) {
+			if (send(*it) == Result::WouldBlock) {
+				blocked.assign(it, messages.end());
+				break;
+			}
+		}
+		return !failing;
+	}
+
+	SendQueue makeQueue(size_t maxAmount) {
+		return SendQueue(
+		    maxAmount, [this](const message_ptr &message) { return send(message); },
+		    [this](chrono::milliseconds delay) {
+			    std::lock_guard lock(mutex);
+			    retries.push_back(delay);
+		    },
+		    [this](size_t amount) {
+			    std::lock_guard lock(mutex);
+			    amounts.push_back(amount);
+		    });
+	}
+
+	static int id(const Message &message) {
+		return to_integer<int>(message[0]) << 16 | to_integer<int>(message[1]) << 8 |
+		       to_integer<int>(message[2]);
+	}
+};
+
+message_ptr makePacket(int id, size_t size = 100) {
+	binary data(size, byte(0));
+	data[0] = byte((id >> 16) & 0xFF);
+	data[1] = byte((id >> 8) & 0xFF);
+	data[2] = byte(id & 0xFF);
+	return make_message(std::move(data));
+}
+
+} // namespace
+
+TestResult test_send_queue() {
+	try {
+		// Packets are sent directly while the socket accepts them
+		{
+			Socket socket;
+			auto queue = socket.makeQueue(1000);
+			if (!queue.send(makePacket(1)) || socket.sent != vector<int>{1} ||
+			    queue.amount() != 0 || !socket.retries.empty() || !socket.amounts.empty())
+				return TestResult(false, "Packet not sent directly");
+		}
+
+		// Once the socket blocks, packets are queued behind the blocked one and retried with a
+		// backoff as long as nothing can be sent
+		{
+			Socket socket;
+			socket.capacity = 0;
+			auto queue = socket.makeQueue(1000);
+			for (int i = 1; i <= 3; ++i)
+				if (!queue.send(makePacket(i)))
+					return TestResult(false, "Blocked packet not queued");
+
+			if (!socket.sent.empty() || queue.amount() != 300 ||
+			    socket.amounts != vector<size_t>{100, 200, 300})
+				return TestResult(false, "Wrong buffered amount while queueing");
+
+			if (socket.retries != vector<chrono::milliseconds>{1ms})
+				return TestResult(false, "Retry not scheduled once");
+
+			// The socket accepts packets again, later packets still wait behind the queued ones
+			socket.capacity = 1000;
+			queue.send(makePacket(4));
+			if (!socket.sent.empty() || queue.amount() != 400)
+				return TestResult(false, "Packet overtook the queued ones");
+
+			socket.capacity = 0;
+			for (int i = 0; i < 5; ++i)
+				queue.flush();
+
+			const vector<chrono::milliseconds> backoff = {1ms, 2ms, 4ms, 8ms, 16ms, 16ms};
+			if (socket.retries != backoff || socket.amounts.size() != 4)
+				return TestResult(false, "Wrong retry backoff without progress");
+
+			// Progress resets the retry delay
+			socket.capacity = 1;
+			queue.flush();
+			if (socket.sent != vector<int>{1} || queue.amount() != 300 ||
+			    socket.retries.back() != 1ms || socket.amounts.back() != 300)
+				return TestResult(false, "Wrong retry after partial progress");
+
+			socket.capacity = 1000;
+			const size_t retries = socket.retries.size();
+			queue.flush();
+			if (socket.sent != vector<int>{1, 2, 3, 4} || queue.amount() != 0 ||
+			    socket.amounts.back() != 0 || socket.retries.size() != retries)
+				return TestResult(false, "Queue not flushed in order");
+
+			// Flushed, packets are sent directly again
+			queue.send(makePacket(5));
+			if (socket.sent.back() != 5 || socket.retries.size() != retries)
+				return TestResult(false, "Packet not sent directly after the flush");
+		}
+
+		// Packets beyond the maximum amount are dropped, and packets are dropped on failure
+		{
+			Socket socket;
+			socket.capacity = 0;
+			auto queue = socket.makeQueue(250);
+			if (!queue.send(makePacket(1)) || !queue.send(makePacket(2)) ||
+			    queue.send(makePacket(3)) || queue.amount() != 200)
+				return TestResult(false, "Packet beyond the maximum amount not dropped");
+
+			queue.flush(true); // drop
+			if (queue.amount() != 0 || !socket.sent.empty() || socket.amounts.back() != 0)
+				return TestResult(false, "Queue not dropped");
+
+			socket.capacity = 1000;
+			socket.failing = true;
+			if (queue.send(makePacket(4)) || queue.amount() != 0)
+				return TestResult(false, "Failed packet queued");
+		}
+
+		// Blocked packets of a batch are queued, and a batch waits behind queued packets
+		{
+			Socket socket;
+			socket.capacity = 2;
+			auto queue = socket.makeQueue(1000);
+			int calls = 0;
+			auto batch = [&](message_vector &messages, message_vector &blocked) {
+				++calls;
+				return socket.sendBatch(messages, blocked);
+			};
+
+			if (!queue.sendBatch({makePacket(1), makePacket(2), makePacket(3), makePacket(4)},
+			                     batch))
+				return TestResult(false, "Batch failed");
+
+			if (calls != 1 || socket.sent != vector<int>{1, 2} || queue.amount() != 200)
+				return TestResult(false, "Blocked packets of a batch not queued");
+
+			socket.capacity = 1000;
+			queue.sendBatch({makePacket(5), makePacket(6)}, batch);
+			if (calls != 1 || queue.amount() != 400)
+				return TestResult(false, "Batch sent while packets are queued");
+
+			queue.flush();
+			if (socket.sent != vector<int>{1, 2, 3, 4, 5, 6} || queue.amount() != 0)
+				return TestResult(false, "Batches not flushed in order");
+
+			queue.sendBatch({makePacket(7)}, batch);
+			if (calls != 2 || socket.sent.back() != 7)
+				return TestResult(false, "Batch not sent after the flush");
+		}
+
+		// Packets of each thread keep their order while the socket blocks intermittently
+		{
+			Socket socket;
+			auto queue = socket.makeQueue(1 << 30);
+			const int threadsCount = 4;
+			const int count = 2000;
+			std::atomic<bool> stop = false;
+			thread flusher([&]() {
+				int i = 0;
+				while (!stop) {
+					socket.capacity = ++i % 3 == 0 ? 0 : 8;
+					queue.flush();
+					this_thread::yield();
+				}
+			});
+
+			vector<thread> threads;
+			for (int t = 0; t < threadsCount; ++t)
+				threads.emplace_back([&queue, t]() {
+					for (int i = 0; i < count; ++i)
+						queue.send(makePacket(t << 16 | i, 10));
+				});
+
+			for (auto &t : threads)
+				t.join();
+
+			stop = true;
+			flusher.join();
+			socket.capacity = 1 << 30;
+			queue.flush();
+
+			vector<int> next(threadsCount, 0);
+			for (int id : socket.sent)
+				if ((id & 0xFFFF) != next[id >> 16]++)
+					return TestResult(false, "Packets of a thread reordered");
+
+			for (int n : next)
+				if (n != count)
+					return TestResult(false, "Packets lost");
+
+			if (queue.amount() != 0)
+				return TestResult(false, "Wrong final buffered amount");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include "impl/startcode.hpp"
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::find_start_code;
+using impl::split_start_sequences;
+using Separator = NalUnit::Separator;
+
+namespace {
+
+const size_t MaxSize = 80; // spans several 16-byte and 32-byte blocks
+
+const byte *naiveFind(const byte *begin, const byte *end) {
+	for (const byte *p = begin; end - p >= 3; ++p)
+		if (p[0] == byte(0) && p[1] == byte(0) && p[2] == byte(1))
+			return p;
+
+	return end;
+}
+
+// Compares the search with the naive scan from every start position
+bool matchesNaive(const binary &data) {
+	const byte *end = data.data() + data.size();
+	for (const byte *begin = data.data(); begin <= end; ++begin)
+		if (find_start_code(begin, end) != naiveFind(begin, end))
+			return false;
+
+	return true;
+}
+
+using Units = vector<pair<size_t, size_t>>; // offset and size
+
+Units split(const binary &frame, Separator separator) {
+	Units units;
+	split_start_sequences(frame, separator, [&units](size_t offset, size_t size) {
+		units.emplace_back(offset, size);
+	});
+	return units;
+}
+
+const binary LongStart = {byte(0), byte(0), byte(0), byte(1)};
+const binary ShortStart = {byte(0), byte(0), byte(1)};
+
+void append(binary &frame, const binary &bytes) {
+	frame.insert(frame.end(), bytes.begin(), bytes.end());
+}
+
+// NAL unit without any zero byte, so it can't be mistaken for a start sequence
+void appendNalUnit(binary &frame, size_t size) {
+	for (size_t i = 0; i < size; ++i)
+		frame.push_back(byte(0x41 + i % 64));
+}
+
+} // namespace
+
+TestResult test_start_code() {
+	try {
+		// A 3-byte start code at every position, including across block boundaries, in data
+		// without zeros and in zeros only, where it becomes part of a 4-byte start code
+		for (size_t size = 0; size <= MaxSize; ++size) {
+			for (size_t pos = 0; pos + 3 <= size; ++pos) {
+				for (byte fill : {byte(0xFF), byte(0)}) {
+					binary data(size, fill);
+					data[pos] = byte(0);
+					data[pos + 1] = byte(0);
+					data[pos + 2] = byte(1);
+					if (!matchesNaive(data))
+						return TestResult(false, "Wrong start code found for size " +
+						                             to_string(size) + ", position " +
+						                             to_string(pos));
+				}
+			}
+
+			// Near misses: 00 01 and 00 00 00 without 01
+			binary data(size, byte(0));
+			for (size_t i = 2; i < size; i += 3)
+				data[i] = byte(1 + (i % 2));
+			if (!matchesNaive(data))
+				return TestResult(false, "Wrong result on near misses for size " +
+				                             to_string(size));
+		}
+
+		// Random zero-heavy data
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<int> distribution(0, 4);
+		for (int i = 0; i < 1000; ++i) {
+			binary data(1 + i % 200);
+			for (auto &b : data) {
+				int value = distribution(generator);
+				b = byte(value <= 2 ? 0 : value == 3 ? 1 : 0x80);
+			}
+			if (!matchesNaive(data))
+				return TestResult(false, "Wrong start code found in random data");
+		}
+
+		// Splitting NAL units of every size, so the separators fall at every block offset
+		for (size_t first = 1; first <= 40; ++first) {
+			for (size_t second = 1; second <= 40; ++second) {
+				const pair<Separator, binary> cases[] = {
+				    {Separator::LongStartSequence, LongStart},
+				    {Separator::ShortStartSequence, ShortStart},
+				    {Separator::StartSequence, LongStart},
+				    {Separator::StartSequence, ShortStart},
+				};
+				for (const auto &[separator, start] : cases) {
+					binary frame;
+					append(frame, start);
+					appendNalUnit(frame, first);
+					append(frame, start);
+					appendNalUnit(frame, second);
+
+					const size_t length = start.size();
+					const Units expected = {{length, first}, {2 * length + first, second}};
+					if (split(frame, separator) != expected)
+						return TestResult(false, "Wrong NAL units for sizes " + to_string(first) +
+						                             " and " + to_string(second));
+				}
+
+				// A long start sequence with the short separator leaves a trailing zero
+				binary frame;
+				append(frame, LongStart);
+				appendNalUnit(frame, first);
+				append(frame, LongStart);
+				appendNalUnit(frame, second);
+				const Units expected = {{4, first + 1}, {8 + first, second}};
+				if (split(frame, Separator::ShortStartSequence) != expected)
+					return TestResult(false, "Wrong NAL units for a long start sequence with the "
+					                         "short separator");
+			}
+		}
+
+		// A short start sequence is not a separator for the long one
+		{
+			binary frame;
+			append(frame, LongStart);
+			appendNalUnit(frame, 20);
+			append(frame, ShortStart);
+			appendNalUnit(frame, 20);
+			if (split(frame, Separator::LongStartSequence) != Units{{4, 43}})
+				return TestResult(false, "Short start sequence split with the long separator");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
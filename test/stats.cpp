@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+
+TestResult test_stats() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	if (pc1.getStats().ice || pc1.getStats().dtls || pc1.getStats().sctp)
+		return TestResult(false, "Stats set before transports are created");
+
+	const int count = 10;
+	const string message = "Hello from 1";
+	std::atomic<int> received = 0;
+	std::atomic<bool> statsInCallback = false;
+	shared_ptr<DataChannel> dc2;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		dc2 = dc;
+		dc->onMessage([&](variant<binary, string> data) {
+			// Reading stats and memory usage from a message callback must not deadlock
+			auto stats = pc2.getStats();
+			pc2.memoryUsage();
+			statsInCallback = stats.sctp && stats.sctp->bytesReceived > 0;
+			if (holds_alternative<string>(data) && get<string>(data) == message)
+				++received;
+		});
+	});
+
+	auto dc1 = pc1.createDataChannel("stats");
+	dc1->onOpen([&]() {
+		for (int i = 0; i < count; ++i)
+			dc1->send(message);
+	});
+
+	int attempts = 10;
+	while (received < count && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (received != count || !dc2)
+		return TestResult(false, "Messages not received");
+
+	if (!statsInCallback)
+		return TestResult(false, "Wrong stats read from a message callback");
+
+	auto stats1 = pc1.getStats();
+	auto stats2 = pc2.getStats();
+	if (!stats1.ice || !stats1.dtls || !stats1.sctp || !stats2.ice || !stats2.dtls || !stats2.sctp)
+		return TestResult(false, "Stats missing for connected transports");
+
+	if (!stats1.ice->localCandidate || !stats1.ice->remoteCandidate)
+		return TestResult(false, "Selected candidate pair missing");
+
+	if (stats1.ice->packetsSent == 0 || stats1.ice->bytesReceived == 0 ||
+	    stats1.dtls->packetsSent == 0 || stats1.dtls->version.empty() ||
+	    !stats1.dtls->handshakeDuration)
+		return TestResult(false, "Wrong ICE or DTLS stats");
+
+	if (stats1.sctp->packetsSent < uint64_t(count) ||
+	    stats2.sctp->packetsReceived < uint64_t(count) || !stats1.sctp->rtt ||
+	    stats1.sctp->congestionWindow == 0)
+		return TestResult(false, "Wrong SCTP stats");
+
+	auto dcStats1 = dc1->getStats();
+	auto dcStats2 = dc2->getStats();
+	const auto bytes = uint64_t(count * message.size());
+	if (dcStats1.messagesSent != uint64_t(count) || dcStats1.bytesSent != bytes ||
+	    dcStats2.messagesReceived != uint64_t(count) || dcStats2.bytesReceived != bytes)
+		return TestResult(false, "Wrong DataChannel stats");
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+TestResult test_max_turn_allocations() {
+	InitLogger(LogLevel::Debug);
+
+	// Nothing listens on the servers, only the allocations made by the agent are counted
+	auto makeConfig = [](optional<unsigned int> maxTurnAllocations) {
+		Configuration config;
+		for (uint16_t port : {3478, 3479, 3480})
+			config.iceServers.emplace_back("127.0.0.1", port, "user", "password");
+
+		config.maxTurnAllocations = maxTurnAllocations;
+		return config;
+	};
+
+	auto turnAllocations = [](const Configuration &config) -> optional<unsigned int> {
+		PeerConnection pc(config);
+		auto dc = pc.createDataChannel("turn"); // starts gathering with auto negotiation
+		int attempts = 50;
+		while (!pc.getStats().ice && attempts--)
+			this_thread::sleep_for(100ms);
+
+		auto stats = pc.getStats();
+		pc.close();
+		return stats.ice ? make_optional(stats.ice->turnAllocations) : nullopt;
+	};
+
+	auto capped = turnAllocations(makeConfig(1));
+	if (!capped)
+		return TestResult(false, "ICE transport not created");
+
+	if (*capped != 1)
+		return TestResult(false, "Wrong TURN allocation count with a cap of 1");
+
+	if (turnAllocations(makeConfig(0)) != 0u)
+		return TestResult(false, "TURN allocation made with a cap of 0");
+
+	// Without a cap, libjuice is limited to 2 allocations and libnice makes them all
+	auto uncapped = turnAllocations(makeConfig(nullopt));
+	if (!uncapped || *uncapped < 2)
+		return TestResult(false, "Wrong TURN allocation count without a cap");
+
+	return TestResult(true);
+}
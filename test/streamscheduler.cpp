@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "impl/streamscheduler.hpp"
+#include "test.hpp"
+
+#include <map>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::StreamScheduler;
+
+namespace {
+
+const size_t MessageSize = 1000;
+
+// Serves the given count of messages, returns the count served per stream
+map<uint16_t, int> serve(StreamScheduler<int> &scheduler, int count) {
+	map<uint16_t, int> served;
+	for (int i = 0; i < count && !scheduler.empty(); ++i) {
+		uint16_t stream = scheduler.next();
+		scheduler.pop(stream, MessageSize);
+		++served[stream];
+	}
+	return served;
+}
+
+void fill(StreamScheduler<int> &scheduler, uint16_t stream, int count) {
+	for (int i = 0; i < count; ++i)
+		scheduler.push(stream, i);
+}
+
+} // namespace
+
+TestResult test_stream_scheduler() {
+	try {
+		// Under backlog, streams are served in proportion to their priorities
+		{
+			StreamScheduler<int> scheduler;
+			scheduler.setPriority(0, 512);
+			scheduler.setPriority(2, 128);
+			fill(scheduler, 0, 1000);
+			fill(scheduler, 2, 1000);
+			auto served = serve(scheduler, 500);
+			if (served[0] != 400 || served[2] != 100)
+				return TestResult(false, "Send ratio does not follow the priorities");
+
+			// The low priority stream gets everything once the other one is drained
+			served = serve(scheduler, 1500);
+			if (served[0] != 600 || served[2] != 900 || !scheduler.empty())
+				return TestResult(false, "Remaining messages not sent");
+		}
+
+		// Equal priorities alternate, and a stream without priority gets the default one
+		{
+			StreamScheduler<int> scheduler;
+			scheduler.setPriority(0, DEFAULT_DATA_CHANNEL_PRIORITY);
+			fill(scheduler, 0, 10);
+			fill(scheduler, 2, 10);
+			vector<uint16_t> order;
+			while (!scheduler.empty()) {
+				uint16_t stream = scheduler.next();
+				scheduler.pop(stream, MessageSize);
+				order.push_back(stream);
+			}
+
+			for (size_t i = 1; i < order.size(); ++i)
+				if (order[i] == order[i - 1])
+					return TestResult(false, "Equal priorities do not alternate");
+		}
+
+		// A stream becoming active can't claim the time it was idle
+		{
+			StreamScheduler<int> scheduler;
+			fill(scheduler, 0, 1000);
+			serve(scheduler, 100);
+			fill(scheduler, 2, 1000);
+			auto served = serve(scheduler, 100);
+			if (served[0] != 50 || served[2] != 50)
+				return TestResult(false, "Late stream not served fairly");
+		}
+
+		// Elements are kept in order per stream, and dropping one does not advance the time
+		{
+			StreamScheduler<int> scheduler;
+			fill(scheduler, 0, 3);
+			fill(scheduler, 2, 3);
+			if (scheduler.drop(0) != 0 || scheduler.front(0) != 1)
+				return TestResult(false, "Wrong element dropped");
+
+			int count = 0;
+			scheduler.forEach([&count](uint16_t, int) { ++count; });
+			if (count != 5)
+				return TestResult(false, "Wrong element count");
+
+			uint16_t stream = scheduler.next();
+			if (stream != 0 || scheduler.pop(stream, MessageSize) != 1)
+				return TestResult(false, "Drop advanced the virtual time");
+
+			scheduler.drop(0);
+			scheduler.setPriority(0, 512);
+			scheduler.erasePriority(0);
+			if (scheduler.next() != 2 ||
+			    scheduler.priority(0) != DEFAULT_DATA_CHANNEL_PRIORITY ||
+			    !scheduler.priorities().empty())
+				return TestResult(false, "Wrong state after the stream emptied");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
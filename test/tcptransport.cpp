@@ -0,0 +1,268 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include "impl/dnscache.hpp"
+#include "impl/tcpserver.hpp"
+#include "impl/tcptransport.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using impl::DnsCache;
+using impl::TcpServer;
+using impl::TcpTransport;
+using State = impl::Transport::State;
+
+namespace {
+
+// Connects to hostname, and returns the final state and the time it took to reach it
+pair<State, chrono::milliseconds> connect(const string &hostname, uint16_t port,
+                                          shared_ptr<TcpTransport> &transport) {
+	std::atomic<State> state = State::Disconnected;
+	transport = make_shared<TcpTransport>(hostname, to_string(port), [&state](State s) {
+		if (s != State::Connecting)
+			state = s;
+	});
+
+	const auto start = chrono::steady_clock::now();
+	transport->start();
+
+	int attempts = 100;
+	while (state == State::Disconnected && attempts--)
+		this_thread::sleep_for(10ms);
+
+	const auto elapsed = chrono::steady_clock::now() - start;
+	transport->onStateChange(nullptr);
+	return {state.load(), chrono::duration_cast<chrono::milliseconds>(elapsed)};
+}
+
+#ifndef _WIN32
+// Plain blocking socket connected to the server, so the test controls when the FIN is sent
+int connectRaw(uint16_t port) {
+	int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (sock < 0)
+		throw runtime_error("Failed to create socket");
+
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (::connect(sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+		::close(sock);
+		throw runtime_error("Failed to connect socket");
+	}
+	return sock;
+}
+
+void sendRaw(int sock, const binary &data) {
+	size_t sent = 0;
+	while (sent < data.size()) {
+		auto len = ::send(sock, data.data() + sent, data.size() - sent, 0);
+		if (len <= 0)
+			throw runtime_error("Failed to send");
+
+		sent += size_t(len);
+	}
+}
+
+// Collects what an accepted transport receives until the end of stream
+class Receiver {
+public:
+	explicit Receiver(shared_ptr<TcpTransport> transport) : mTransport(std::move(transport)) {
+		mTransport->onRecv([this](message_ptr message) {
+			std::lock_guard lock(mMutex);
+			if (!message)
+				mEnded = true;
+			else
+				mData.insert(mData.end(), message->begin(), message->end());
+		});
+		mTransport->start();
+	}
+
+	~Receiver() {
+		mTransport->onRecv(nullptr);
+		mTransport->stop();
+	}
+
+	// Waits for the end of stream, returns false on timeout
+	bool waitEnd(chrono::milliseconds timeout) const {
+		const auto deadline = chrono::steady_clock::now() + timeout;
+		while (!ended() && chrono::steady_clock::now() < deadline)
+			this_thread::sleep_for(10ms);
+
+		return ended() && mTransport->state() == State::Disconnected;
+	}
+
+	bool ended() const {
+		std::lock_guard lock(mMutex);
+		return mEnded;
+	}
+
+	binary data() const {
+		std::lock_guard lock(mMutex);
+		return mData;
+	}
+
+private:
+	shared_ptr<TcpTransport> mTransport;
+	mutable std::mutex mMutex;
+	binary mData;
+	bool mEnded = false;
+};
+
+binary makePayload(size_t size) {
+	binary payload(size);
+	for (size_t i = 0; i < size; ++i)
+		payload[i] = byte(i * 13 + i / 256);
+	return payload;
+}
+#endif
+
+} // namespace
+
+TestResult test_tcp_happy_eyeballs() {
+	// Keep the library initialized, as connections run on the thread pool and the poll service
+	PeerConnection pc;
+
+	try {
+		auto server = make_unique<TcpServer>(0, "127.0.0.1");
+		const uint16_t port = server->port();
+
+		// The IPv6 address is in the discard-only prefix (RFC 6666), so the attempt never succeeds
+		const string hostname = "happy-eyeballs.test";
+		auto &cache = DnsCache::Instance();
+		cache.insert(hostname, port, AF_INET6, SOCK_STREAM, {{AF_INET6, "100::1"}});
+		cache.insert(hostname, port, AF_INET, SOCK_STREAM, {{AF_INET, "127.0.0.1"}});
+
+		// The IPv4 attempt is started without waiting for the IPv6 one to time out
+		shared_ptr<TcpTransport> transport;
+		auto [state, elapsed] = connect(hostname, port, transport);
+		if (state != State::Connected)
+			return TestResult(false, "TCP connection through IPv4 failed");
+
+		if (elapsed >= 2s)
+			return TestResult(false, "TCP connection waited for the dead IPv6 address");
+
+		if (transport->remoteAddress() != hostname + ':' + to_string(port))
+			return TestResult(false, "Wrong remote address");
+
+		// The connection is kept once the other attempt is cancelled
+		auto accepted = server->accept();
+		if (!accepted)
+			return TestResult(false, "TCP connection not accepted");
+
+		this_thread::sleep_for(500ms);
+		if (transport->state() != State::Connected)
+			return TestResult(false, "TCP connection lost after cancelling the other attempt");
+
+		transport->stop();
+		transport.reset();
+		accepted.reset();
+
+		// Refused on IPv4 and IPv6, the connection fails without waiting for the timeout
+		server.reset();
+		const string refused = "refused.test";
+		cache.insert(refused, port, AF_INET6, SOCK_STREAM, {{AF_INET6, "::1"}});
+		cache.insert(refused, port, AF_INET, SOCK_STREAM, {{AF_INET, "127.0.0.1"}});
+		tie(state, elapsed) = connect(refused, port, transport);
+		if (state != State::Failed || elapsed >= 1s)
+			return TestResult(false, "Refused TCP connection did not fail");
+
+		transport.reset();
+		cache.clear();
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_tcp_read_until_eof() {
+#ifndef _WIN32
+	// Keep the library initialized, as connections run on the thread pool and the poll service
+	PeerConnection pc;
+
+	try {
+		TcpServer server(0, "127.0.0.1");
+
+		// The data and the FIN arrive before the first read, the reads must go past the short
+		// read of the last chunk to see the end of stream
+		{
+			const auto payload = makePayload(256 * 1024);
+			int sock = connectRaw(server.port());
+			std::thread sender([sock, &payload]() {
+				sendRaw(sock, payload);
+				::close(sock);
+			});
+
+			auto accepted = server.accept();
+			this_thread::sleep_for(200ms);
+			Receiver receiver(accepted);
+			const bool ended = receiver.waitEnd(5s);
+			sender.join();
+			if (!ended)
+				return TestResult(false, "End of stream after data not notified");
+
+			if (receiver.data() != payload)
+				return TestResult(false, "Data received before the end of stream differs");
+		}
+
+		// The FIN arrives alone after the data was read in several wakeups
+		{
+			const auto payload = makePayload(1000);
+			int sock = connectRaw(server.port());
+			auto accepted = server.accept();
+			Receiver receiver(accepted);
+			for (int i = 0; i < 3; ++i) {
+				sendRaw(sock, payload);
+				this_thread::sleep_for(100ms);
+			}
+
+			if (receiver.ended() || receiver.data().size() != 3 * payload.size())
+				return TestResult(false, "Data not received while the connection is open");
+
+			::shutdown(sock, SHUT_WR);
+			const bool ended = receiver.waitEnd(5s);
+			::close(sock);
+			if (!ended)
+				return TestResult(false, "End of stream alone not notified");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+#else
+	return TestResult(true);
+#endif
+}
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/threadpool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+TestResult test_work_stealing() {
+	try {
+		// Work stealing can only be enabled without workers
+		if (rtc::Cleanup().wait_for(10s) == future_status::timeout)
+			return TestResult(false, "Cleanup timeout");
+
+		auto &pool = impl::ThreadPool::Instance();
+		pool.setWorkStealing(true);
+		pool.spawn(3);
+
+		// A worker fills its own queue then blocks, so the other workers must steal every task
+		const int count = 10000;
+		std::atomic<int> executed = 0;
+		std::atomic<int> stolen = 0;
+		std::promise<bool> drained;
+		pool.post([&]() {
+			const auto blocked = this_thread::get_id();
+			for (int i = 0; i < count; ++i)
+				pool.post([&executed, &stolen, blocked]() {
+					if (this_thread::get_id() != blocked)
+						++stolen;
+
+					++executed;
+				});
+
+			const auto deadline = chrono::steady_clock::now() + 10s;
+			while (executed < count && chrono::steady_clock::now() < deadline)
+				this_thread::sleep_for(1ms);
+
+			drained.set_value(executed == count);
+		});
+
+		auto future = drained.get_future();
+		const bool timeout = future.wait_for(20s) == future_status::timeout;
+		const bool success = !timeout && future.get();
+
+		pool.join();
+		pool.setWorkStealing(false);
+
+		if (!success)
+			return TestResult(false, "Queue of the blocked worker not drained");
+
+		if (stolen != count)
+			return TestResult(false, "Tasks run by the blocked worker");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
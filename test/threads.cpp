@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/executor.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+size_t countThreads(const string &name) {
+	size_t count = 0;
+	for (const auto &thread : GetThreads())
+		if (thread.name == name)
+			++count;
+
+	return count;
+}
+
+} // namespace
+
+TestResult test_threads() {
+	try {
+		// Keep the library initialized
+		PeerConnection pc;
+
+		// Each worker of the thread pool is listed once with its role
+		auto threads = GetThreads();
+		std::set<uint64_t> ids;
+		for (const auto &thread : threads) {
+			if (thread.id == 0 || thread.name.empty())
+				return TestResult(false, "Invalid thread");
+
+			if (!ids.insert(thread.id).second)
+				return TestResult(false, "Duplicate thread id");
+
+#if defined(__linux__)
+			// The id is the TID, and the name is set on the thread, truncated by the kernel
+			std::ifstream comm("/proc/self/task/" + to_string(thread.id) + "/comm");
+			string name;
+			if (!std::getline(comm, name))
+				return TestResult(false, "Thread id is not a TID of the process");
+
+			if (thread.name.compare(0, 15, name) != 0)
+				return TestResult(false, "Thread name not set: " + name);
+#endif
+		}
+
+		const auto workers = GetThreadPoolStats().workers;
+		if (workers == 0 || countThreads("RTC worker") != workers)
+			return TestResult(false, "Thread pool workers not listed");
+
+		// Threads are registered while they live
+		const size_t executors = countThreads("RTC executor");
+		auto executor = std::make_unique<impl::Executor>();
+		int attempts = 100;
+		while (countThreads("RTC executor") != executors + 1 && attempts--)
+			this_thread::sleep_for(10ms);
+
+		if (countThreads("RTC executor") != executors + 1)
+			return TestResult(false, "Executor thread not listed");
+
+		executor.reset(); // joins the thread
+		if (countThreads("RTC executor") != executors)
+			return TestResult(false, "Exited thread still listed");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "impl/timerwheel.hpp"
+#include "test.hpp"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using impl::Task;
+using impl::TimerWheel;
+
+namespace {
+
+// Run expired tasks and return the number of tasks run
+size_t run(deque<Task> &expired) {
+	size_t count = expired.size();
+	while (!expired.empty()) {
+		expired.front()();
+		expired.pop_front();
+	}
+	return count;
+}
+
+} // namespace
+
+TestResult test_timer_wheel() {
+	try {
+		const auto start = TimerWheel::clock::now();
+		TimerWheel wheel(start);
+		deque<Task> expired;
+
+		if (!wheel.empty() || wheel.next())
+			return TestResult(false, "New wheel is not empty");
+
+		// Expiration order and rounding
+		vector<int> order;
+		wheel.add(start + 30ms, [&order] { order.push_back(3); });
+		wheel.add(start + 10ms, [&order] { order.push_back(1); });
+		wheel.add(start + 20ms, [&order] { order.push_back(2); });
+		auto overdue = wheel.add(start - 5ms, [&order] { order.push_back(0); });
+
+		auto next = wheel.next();
+		if (wheel.size() != 4 || !next || *next > start)
+			return TestResult(false, "Wrong size or next time after add");
+
+		wheel.advance(start + 9ms, expired);
+		if (run(expired) != 1 || order != vector<int>{0})
+			return TestResult(false, "Wrong timers expired before the first deadline");
+
+		// Timers never expire early
+		wheel.add(start + 10ms + 500us, [&order] { order.push_back(4); });
+		wheel.advance(start + 10ms, expired);
+		if (run(expired) != 1 || order != vector<int>{0, 1})
+			return TestResult(false, "Timer expired early or late");
+
+		// A cancelled timer doesn't run, and its id becomes stale
+		auto cancelled = wheel.add(start + 15ms, [&order] { order.push_back(-1); });
+		if (!wheel.cancel(cancelled) || wheel.cancel(cancelled) || wheel.cancel(overdue) ||
+		    wheel.cancel(0))
+			return TestResult(false, "Wrong cancel result");
+
+		// Reusing the cancelled slot must not revive the stale id
+		wheel.add(start + 25ms, [&order] { order.push_back(5); });
+		if (wheel.cancel(cancelled))
+			return TestResult(false, "Stale id cancelled a reused timer");
+
+		next = wheel.next();
+		if (!next || *next > start + 11ms)
+			return TestResult(false, "Next time is not a lower bound");
+
+		wheel.advance(start + 40ms, expired);
+		if (run(expired) != 4 || order != vector<int>{0, 1, 4, 2, 5, 3})
+			return TestResult(false, "Wrong expiration order");
+
+		if (!wheel.empty() || wheel.next())
+			return TestResult(false, "Wheel is not empty after expiration");
+
+		// Timers on higher levels and beyond the range of the wheel
+		int far = 0;
+		wheel.add(start + 10s, [&far] { far |= 1; });
+		wheel.add(start + 2h, [&far] { far |= 2; });
+		wheel.add(start + 10h, [&far] { far |= 4; });
+
+		wheel.advance(start + 10s - 1ms, expired);
+		if (run(expired) != 0)
+			return TestResult(false, "Far timer expired early");
+
+		wheel.advance(start + 10s, expired);
+		wheel.advance(start + 2h, expired);
+		if (run(expired) != 2 || far != 3)
+			return TestResult(false, "Far timers did not expire");
+
+		next = wheel.next();
+		if (!next || *next > start + 10h)
+			return TestResult(false, "Next time is not a lower bound for a parked timer");
+
+		wheel.advance(start + 10h - 1ms, expired);
+		if (run(expired) != 0)
+			return TestResult(false, "Parked timer expired early");
+
+		wheel.advance(start + 10h, expired);
+		if (run(expired) != 1 || far != 7)
+			return TestResult(false, "Parked timer did not expire");
+
+		// Clearing drops everything
+		wheel.add(start + 11h, [] {});
+		wheel.add(start + 12h, [] {});
+		wheel.clear();
+		if (!wheel.empty() || wheel.next())
+			return TestResult(false, "Wheel is not empty after clear");
+
+		// Randomized comparison against a reference set of pending timers
+		TimerWheel random(start);
+		map<int, pair<TimerWheel::id_t, uint64_t>> pending; // value -> id, deadline in ms
+		mt19937 generator(42);
+		uint64_t now = 0;
+		bool early = false;
+		bool unexpected = false;
+		uint64_t last = 0;
+		bool unordered = false;
+		auto check = [&](int value, uint64_t deadline) {
+			if (deadline > now)
+				early = true;
+			if (deadline < last)
+				unordered = true;
+			last = deadline;
+			if (pending.erase(value) == 0)
+				unexpected = true;
+		};
+		for (int i = 0; i < 20000; ++i) {
+			switch (generator() % 4) {
+			case 0:
+			case 1: {
+				uint64_t deadline = now + 1 + generator() % (i % 100 == 0 ? 1000000 : 5000);
+				auto id = random.add(start + chrono::milliseconds(deadline),
+				                     [&check, deadline, i] { check(i, deadline); });
+				pending.emplace(i, make_pair(id, deadline));
+				break;
+			}
+			case 2: {
+				now += generator() % 100;
+				random.advance(start + chrono::milliseconds(now), expired);
+				run(expired);
+				break;
+			}
+			default: {
+				if (pending.empty())
+					break;
+				auto it = pending.begin();
+				advance(it, generator() % pending.size());
+				if (!random.cancel(it->second.first))
+					return TestResult(false, "Randomized timer could not be cancelled");
+				pending.erase(it);
+				break;
+			}
+			}
+			if (random.size() != pending.size())
+				return TestResult(false, "Randomized wheel size mismatch");
+		}
+		now += 1000000;
+		random.advance(start + chrono::milliseconds(now), expired);
+		run(expired);
+
+		if (early || unexpected || unordered || !pending.empty() || !random.empty())
+			return TestResult(false, "Randomized timers expired incorrectly");
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
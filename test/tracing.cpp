@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+struct Recorder {
+	std::mutex mutex;
+	vector<TraceEvent> events;
+	std::map<std::thread::id, int> taskDepths; // begin and end must be balanced per thread
+	bool unbalanced = false;
+
+	void record(const TraceEvent &event) {
+		std::lock_guard lock(mutex);
+		events.push_back(event);
+		if (event.point == TracePoint::TaskBegin) {
+			++taskDepths[std::this_thread::get_id()];
+		} else if (event.point == TracePoint::TaskEnd) {
+			if (--taskDepths[std::this_thread::get_id()] < 0)
+				unbalanced = true;
+		}
+	}
+
+	size_t count(TracePoint point) {
+		std::lock_guard lock(mutex);
+		size_t n = 0;
+		for (const auto &event : events)
+			if (event.point == point)
+				++n;
+
+		return n;
+	}
+};
+
+} // namespace
+
+TestResult test_tracing() {
+	InitLogger(LogLevel::Debug);
+
+	auto recorder = std::make_shared<Recorder>();
+	SetTraceCallback([recorder](const TraceEvent &event) { recorder->record(event); });
+
+#if RTC_ENABLE_MEDIA
+	// Handlers are traced in chain order, with the count of messages
+	{
+		auto first = make_shared<MediaHandler>();
+		auto second = make_shared<MediaHandler>();
+		first->addToChain(second);
+
+		message_vector messages{make_message(10), make_message(10)};
+		first->incomingChain(messages, [](message_ptr) {});
+		first->outgoingChain(messages, [](message_ptr) {});
+
+		std::lock_guard lock(recorder->mutex);
+		vector<std::pair<TracePoint, const void *>> media;
+		for (const auto &event : recorder->events) {
+			if (event.point >= TracePoint::MediaIncomingBegin &&
+			    event.point <= TracePoint::MediaOutgoingEnd) {
+				if (event.value != 2)
+					return TestResult(false, "Wrong message count in media trace");
+
+				media.emplace_back(event.point, event.object);
+			}
+		}
+
+		const vector<std::pair<TracePoint, const void *>> expected = {
+		    {TracePoint::MediaIncomingBegin, second.get()},
+		    {TracePoint::MediaIncomingEnd, second.get()},
+		    {TracePoint::MediaIncomingBegin, first.get()},
+		    {TracePoint::MediaIncomingEnd, first.get()},
+		    {TracePoint::MediaOutgoingBegin, first.get()},
+		    {TracePoint::MediaOutgoingEnd, first.get()},
+		    {TracePoint::MediaOutgoingBegin, second.get()},
+		    {TracePoint::MediaOutgoingEnd, second.get()},
+		};
+		if (media != expected)
+			return TestResult(false, "Wrong media handler traces");
+	}
+#endif
+
+	// A connection traces tasks, transports, the DTLS handshake, and SCTP upcalls
+	{
+		PeerConnection pc1;
+		PeerConnection pc2;
+		pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(sdp); });
+		pc1.onLocalCandidate([&pc2](Candidate candidate) { pc2.addRemoteCandidate(candidate); });
+		pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(sdp); });
+		pc2.onLocalCandidate([&pc1](Candidate candidate) { pc1.addRemoteCandidate(candidate); });
+
+		auto dc = pc1.createDataChannel("test");
+		int attempts = 10;
+		while (!dc->isOpen() && attempts--)
+			this_thread::sleep_for(1s);
+
+		if (!dc->isOpen())
+			return TestResult(false, "DataChannel is not open");
+
+		dc->send("hello");
+		this_thread::sleep_for(1s);
+
+		pc1.close();
+		pc2.close();
+	}
+	this_thread::sleep_for(1s);
+
+	for (auto point : {TracePoint::TransportSend, TracePoint::TransportRecv,
+	                   TracePoint::TransportStateChange, TracePoint::DtlsHandshakeStep,
+	                   TracePoint::SctpUpcall, TracePoint::TaskBegin})
+		if (recorder->count(point) == 0)
+			return TestResult(false, "Missing tracepoint " + to_string(int(point)));
+
+	// Both peers start and finish a handshake, the start of each preceding its end
+	{
+		std::lock_guard lock(recorder->mutex);
+		if (recorder->unbalanced)
+			return TestResult(false, "Unbalanced task tracepoints");
+
+		std::map<const void *, int> handshakes;
+		for (const auto &event : recorder->events) {
+			if (event.point == TracePoint::DtlsHandshakeStart) {
+				handshakes[event.object] = 1;
+			} else if (event.point == TracePoint::DtlsHandshakeDone) {
+				if (handshakes[event.object] != 1)
+					return TestResult(false, "DTLS handshake done before it started");
+
+				handshakes[event.object] = 2;
+			}
+		}
+
+		int done = 0;
+		for (const auto &[object, state] : handshakes)
+			if (object && state == 2)
+				++done;
+
+		if (done != 2)
+			return TestResult(false, "DTLS handshakes not traced");
+	}
+
+	// Nothing is traced anymore without callback
+	SetTraceCallback(nullptr);
+	this_thread::sleep_for(100ms); // let calls in progress return
+	const size_t count = [&]() {
+		std::lock_guard lock(recorder->mutex);
+		return recorder->events.size();
+	}();
+
+	{
+		PeerConnection pc;
+		auto dc = pc.createDataChannel("test");
+		this_thread::sleep_for(1s);
+	}
+
+	std::lock_guard lock(recorder->mutex);
+	if (recorder->events.size() != count)
+		return TestResult(false, "Events traced after the callback was removed");
+
+	return TestResult(true);
+}
@@ -14,11 +14,15 @@
 #include <cstring>
 #include <future>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 using namespace rtc;
 using namespace std;
+using namespace chrono_literals;
 
 template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
 
@@ -192,3 +196,243 @@ TestResult test_track() {
 
 	return TestResult(true);
 }
+
+namespace {
+
+void signal(PeerConnection &pc1, PeerConnection &pc2) {
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+}
+
+Description::Video makeVideo(string mid, SSRC ssrc) {
+	Description::Video media(std::move(mid), Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	media.addSSRC(ssrc, "video-send");
+	return media;
+}
+
+binary makeRtp(SSRC ssrc, uint16_t seqNumber) {
+	binary packet(sizeof(RtpHeader) + 100);
+	auto rtp = reinterpret_cast<RtpHeader *>(packet.data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSeqNumber(seqNumber);
+	rtp->setTimestamp(seqNumber * 3000u);
+	rtp->setSsrc(ssrc);
+	for (size_t i = sizeof(RtpHeader); i < packet.size(); ++i)
+		packet[i] = byte(seqNumber + i);
+	return packet;
+}
+
+// Records the RTP packets received on remote tracks, by mid
+class Receiver {
+public:
+	struct Packet {
+		SSRC ssrc;
+		uint16_t seqNumber;
+	};
+
+	explicit Receiver(PeerConnection &pc) {
+		pc.onTrack([this](shared_ptr<Track> track) {
+			auto mid = track->mid();
+			track->onMessage(
+			    [this, mid](binary message) {
+				    if (message.size() < sizeof(RtpHeader))
+					    return;
+
+				    auto rtp = reinterpret_cast<const RtpHeader *>(message.data());
+				    if (rtp->payloadType() != 96)
+					    return; // RTCP
+
+				    std::lock_guard lock(mMutex);
+				    mPackets[mid].push_back({rtp->ssrc(), rtp->seqNumber()});
+			    },
+			    nullptr);
+
+			std::lock_guard lock(mMutex);
+			mTracks[mid] = std::move(track);
+		});
+	}
+
+	shared_ptr<Track> track(const string &mid) const {
+		std::lock_guard lock(mMutex);
+		auto it = mTracks.find(mid);
+		return it != mTracks.end() ? it->second : nullptr;
+	}
+
+	vector<Packet> packets(const string &mid) const {
+		std::lock_guard lock(mMutex);
+		auto it = mPackets.find(mid);
+		return it != mPackets.end() ? it->second : vector<Packet>{};
+	}
+
+	bool waitOpen(const vector<string> &mids, const vector<shared_ptr<Track>> &local) const {
+		for (int attempts = 10; attempts >= 0; --attempts) {
+			bool open = true;
+			for (const auto &mid : mids)
+				if (auto t = track(mid); !t || !t->isOpen())
+					open = false;
+			for (const auto &t : local)
+				if (!t->isOpen())
+					open = false;
+
+			if (open)
+				return true;
+
+			this_thread::sleep_for(1s);
+		}
+		return false;
+	}
+
+private:
+	mutable std::mutex mMutex;
+	map<string, shared_ptr<Track>> mTracks;
+	map<string, vector<Packet>> mPackets;
+};
+
+// Checks that the packets of the track all come from the SSRC, in order from 0
+bool isInOrder(const vector<Receiver::Packet> &packets, SSRC ssrc) {
+	for (size_t i = 0; i < packets.size(); ++i)
+		if (packets[i].ssrc != ssrc || packets[i].seqNumber != uint16_t(i))
+			return false;
+
+	return true;
+}
+
+} // namespace
+
+TestResult test_track_parallel_srtp() {
+	InitLogger(LogLevel::Debug);
+
+	Configuration config1;
+	config1.enableParallelSrtp = true;
+	PeerConnection pc1(config1);
+	PeerConnection pc2;
+	signal(pc1, pc2);
+	Receiver receiver(pc2);
+
+	const vector<SSRC> ssrcs = {1001, 1002, 1003};
+	vector<string> mids;
+	vector<shared_ptr<Track>> tracks;
+	for (size_t i = 0; i < ssrcs.size(); ++i) {
+		mids.push_back("video" + to_string(i));
+		tracks.push_back(pc1.addTrack(makeVideo(mids.back(), ssrcs[i])));
+	}
+
+	pc1.setLocalDescription();
+
+	if (!receiver.waitOpen(mids, tracks))
+		return TestResult(false, "Tracks are not open");
+
+	// The tracks send concurrently, each SSRC being protected by its own SRTP session
+	const uint16_t count = 200;
+	vector<thread> senders;
+	for (size_t i = 0; i < tracks.size(); ++i)
+		senders.emplace_back([&, i]() {
+			for (uint16_t seqNumber = 0; seqNumber < count; ++seqNumber) {
+				auto packet = makeRtp(ssrcs[i], seqNumber);
+				tracks[i]->send(packet.data(), packet.size());
+				if (seqNumber % 10 == 0)
+					this_thread::sleep_for(1ms);
+			}
+		});
+
+	for (auto &sender : senders)
+		sender.join();
+
+	auto received = [&]() {
+		for (const auto &mid : mids)
+			if (receiver.packets(mid).size() < count)
+				return false;
+		return true;
+	};
+	for (int attempts = 50; !received() && attempts > 0; --attempts)
+		this_thread::sleep_for(100ms);
+
+	for (size_t i = 0; i < mids.size(); ++i) {
+		auto packets = receiver.packets(mids[i]);
+		if (packets.size() != count)
+			return TestResult(false, "Wrong packet count on track " + mids[i]);
+
+		if (!isInOrder(packets, ssrcs[i]))
+			return TestResult(false, "Packets misrouted or reordered on track " + mids[i]);
+	}
+
+	pc1.close();
+	pc2.close();
+	return TestResult(true);
+}
+
+TestResult test_track_renegotiation_traffic() {
+	InitLogger(LogLevel::Debug);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+	signal(pc1, pc2);
+	Receiver receiver(pc2);
+
+	const SSRC ssrcA = 2001, ssrcB = 2002;
+	auto trackA = pc1.addTrack(makeVideo("a", ssrcA));
+	pc1.setLocalDescription();
+
+	if (!receiver.waitOpen({"a"}, {trackA}))
+		return TestResult(false, "Track is not open");
+
+	// Track A sends all along while track B is added then removed
+	std::atomic<bool> stop = false;
+	std::atomic<uint16_t> sent = 0;
+	thread sender([&]() {
+		for (uint16_t seqNumber = 0; !stop; ++seqNumber) {
+			auto packet = makeRtp(ssrcA, seqNumber);
+			trackA->send(packet.data(), packet.size());
+			sent = uint16_t(seqNumber + 1);
+			this_thread::sleep_for(2ms);
+		}
+	});
+
+	auto trackB = pc1.addTrack(makeVideo("b", ssrcB));
+	pc1.setLocalDescription();
+
+	bool opened = receiver.waitOpen({"a", "b"}, {trackA, trackB});
+	if (opened)
+		for (uint16_t seqNumber = 0; seqNumber < 50; ++seqNumber) {
+			auto packet = makeRtp(ssrcB, seqNumber);
+			trackB->send(packet.data(), packet.size());
+		}
+
+	this_thread::sleep_for(500ms);
+	size_t receivedBeforeRemoval = receiver.packets("a").size();
+
+	trackB->close();
+	pc1.setLocalDescription();
+
+	this_thread::sleep_for(2s);
+	stop = true;
+	sender.join();
+	this_thread::sleep_for(500ms);
+
+	if (!opened)
+		return TestResult(false, "Added track is not open");
+
+	auto packetsA = receiver.packets("a");
+	if (!isInOrder(packetsA, ssrcA))
+		return TestResult(false, "Packets misrouted or reordered on the first track");
+
+	if (packetsA.size() != sent)
+		return TestResult(false, "Packets lost on the first track during renegotiation");
+
+	if (packetsA.size() <= receivedBeforeRemoval)
+		return TestResult(false, "First track stopped receiving after the removal");
+
+	auto packetsB = receiver.packets("b");
+	if (packetsB.size() != 50 || !isInOrder(packetsB, ssrcB))
+		return TestResult(false, "Packets misrouted on the added track");
+
+	pc1.close();
+	pc2.close();
+	return TestResult(true);
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#include "impl/transport.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+// Transport passing messages to its receive handler on demand
+class Source final : public impl::Transport {
+public:
+	void receive() { recv(make_message(binary(8, byte(0x42)))); }
+};
+
+// State of a receive callback, which must not be called once replaced
+struct Receiver {
+	std::atomic<bool> alive = true;
+	std::atomic<int> calls = 0;
+};
+
+} // namespace
+
+TestResult test_transport_recv_handler() {
+	try {
+		// Handlers are replaced while messages are received from other threads
+		{
+			Source source;
+			std::atomic<bool> stop = false;
+			std::atomic<bool> calledAfterReplace = false;
+			std::atomic<int> total = 0;
+
+			auto makeCallback = [&](Receiver *receiver) {
+				return [&, receiver](message_ptr) {
+					if (!receiver->alive)
+						calledAfterReplace = true;
+
+					this_thread::sleep_for(50us);
+					++receiver->calls;
+					++total;
+				};
+			};
+
+			auto receiver = make_unique<Receiver>();
+			source.onRecv(makeCallback(receiver.get()));
+
+			vector<thread> threads;
+			for (int i = 0; i < 4; ++i)
+				threads.emplace_back([&]() {
+					while (!stop)
+						source.receive();
+				});
+
+			for (int i = 0; i < 200; ++i) {
+				auto next = make_unique<Receiver>();
+				source.onRecv(makeCallback(next.get()));
+				receiver->alive = false;
+				receiver = std::move(next); // the previous one is destroyed
+				this_thread::sleep_for(1ms);
+			}
+
+			source.onRecv(nullptr);
+			receiver->alive = false;
+			const int calls = receiver->calls;
+			this_thread::sleep_for(10ms);
+
+			stop = true;
+			for (auto &t : threads)
+				t.join();
+
+			if (calledAfterReplace || receiver->calls != calls)
+				return TestResult(false, "Receive callback called after being replaced");
+
+			if (total == 0)
+				return TestResult(false, "No message received");
+		}
+
+		// Replacing the handler waits for a blocked call to return
+		{
+			Source source;
+			std::atomic<bool> entered = false;
+			std::atomic<bool> returned = false;
+			source.onRecv([&](message_ptr) {
+				entered = true;
+				this_thread::sleep_for(200ms);
+				returned = true;
+			});
+
+			thread t([&]() { source.receive(); });
+			while (!entered)
+				this_thread::sleep_for(1ms);
+
+			source.onRecv(nullptr);
+			const bool waited = returned;
+			t.join();
+
+			if (!waited)
+				return TestResult(false, "Handler replaced during a call in progress");
+		}
+
+		// The handler is replaced from inside a callback, which keeps running with its state
+		{
+			Source source;
+			auto second = make_shared<Receiver>();
+			auto first = make_shared<Receiver>();
+			source.onRecv([&source, first, second](message_ptr) {
+				++first->calls;
+				source.onRecv([second](message_ptr) { ++second->calls; });
+				// The captures of this callback must still be valid here
+				++first->calls;
+			});
+
+			source.receive();
+			source.receive();
+			source.receive();
+			if (first->calls != 2 || second->calls != 2)
+				return TestResult(false, "Handler not replaced from inside a callback");
+
+			// The handler is also removed from inside a callback
+			source.onRecv([&source, second](message_ptr) {
+				source.onRecv(nullptr);
+				++second->calls;
+			});
+
+			source.receive();
+			source.receive();
+			if (second->calls != 3)
+				return TestResult(false, "Handler not removed from inside a callback");
+
+			// Later replacements free the handlers kept alive by their own calls
+			source.onRecv([second](message_ptr) { ++second->calls; });
+			source.receive();
+			source.onRecv(nullptr);
+			if (second->calls != 4 || first.use_count() != 1)
+				return TestResult(false, "Replaced handler not freed");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,350 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using PacketResult = TwccHandler::PacketResult;
+
+namespace {
+
+const uint8_t ExtId = 3;
+const SSRC MediaSsrc = 42;
+
+Description::Video makeMedia() {
+	Description::Video video("video", Description::Direction::SendRecv);
+	video.addH264Codec(96);
+	video.addExtMap(Description::Entry::ExtMap(ExtId, TwccHandler::ExtensionUri));
+	return video;
+}
+
+// RTP packet without extension, as sent by the track
+message_ptr makePlain(uint16_t seqNumber) {
+	auto message = make_message(sizeof(RtpHeader) + 100);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(MediaSsrc);
+	rtp->setSeqNumber(seqNumber);
+	return message;
+}
+
+// RTP packet carrying a transport-wide sequence number, as received
+message_ptr makeStamped(uint16_t twccSeqNumber) {
+	auto message = make_message(sizeof(RtpHeader) + 8 + 100);
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(MediaSsrc);
+	rtp->setExtension(true);
+	auto ext = rtp->getExtensionHeader();
+	ext->setProfileSpecificId(0xBEDE);
+	ext->setHeaderLength(1);
+	ext->clearBody();
+	const byte value[2] = {byte(twccSeqNumber >> 8), byte(twccSeqNumber & 0xFF)};
+	ext->writeOneByteHeader(0, ExtId, value, 2);
+	return message;
+}
+
+optional<uint16_t> twccSeqNumber(const Message &message) {
+	auto rtp = reinterpret_cast<const RtpHeader *>(message.data());
+	if (!rtp->extension())
+		return nullopt;
+
+	size_t size = 0;
+	auto element = rtp->getExtensionHeader()->findHeader(ExtId, size);
+	if (!element || size != 2)
+		return nullopt;
+
+	return uint16_t(to_integer<uint16_t>(element[0]) << 8 | to_integer<uint16_t>(element[1]));
+}
+
+uint32_t read(const Message &message, size_t offset, size_t size) {
+	uint32_t value = 0;
+	for (size_t i = 0; i < size; ++i)
+		value = (value << 8) | to_integer<uint32_t>(message[offset + i]);
+	return value;
+}
+
+// Feeds received packets and returns the feedback packets sent in response
+message_vector receive(TwccHandler &handler, message_vector messages) {
+	message_vector feedbacks;
+	handler.incoming(messages, [&feedbacks](message_ptr message) {
+		feedbacks.push_back(std::move(message));
+	});
+	return feedbacks;
+}
+
+// Feeds feedback packets and returns the results passed to the callback
+struct FeedbackSink {
+	vector<vector<PacketResult>> results;
+
+	TwccHandler::feedback_callback callback() {
+		return [this](vector<PacketResult> r) { results.push_back(std::move(r)); };
+	}
+};
+
+message_ptr makeControl(binary data) { return make_message(std::move(data), Message::Control); }
+
+} // namespace
+
+TestResult test_twcc_handler() {
+	try {
+		// Round trip: the sender stamps the packets, the receiver reports them, and the
+		// sender matches the reports with the send times and sizes
+		{
+			FeedbackSink sink;
+			TwccHandler sender(sink.callback(), 1);
+			TwccHandler receiver(nullptr, 2, 0ms); // feedback after every batch
+			sender.media(makeMedia());
+			receiver.media(makeMedia());
+
+			message_vector messages;
+			for (int i = 0; i < 10; ++i)
+				messages.push_back(makePlain(uint16_t(1000 + i)));
+
+			sender.outgoing(messages, nullptr);
+			if (messages.size() != 10)
+				return TestResult(false, "Stamping changed the packet count");
+
+			vector<size_t> sizes;
+			const auto base = twccSeqNumber(*messages[0]);
+			for (size_t i = 0; i < messages.size(); ++i) {
+				auto seq = twccSeqNumber(*messages[i]);
+				if (!seq || *seq != uint16_t(*base + i))
+					return TestResult(false, "Wrong transport-wide sequence numbers");
+
+				sizes.push_back(messages[i]->size());
+			}
+
+			// Packets 3 and 4 are lost
+			message_vector delivered;
+			for (size_t i = 0; i < messages.size(); ++i)
+				if (i != 3 && i != 4)
+					delivered.push_back(messages[i]);
+
+			auto feedbacks = receive(receiver, delivered);
+			if (feedbacks.size() != 1)
+				return TestResult(false, "No feedback generated");
+
+			// Symbols 1110011111 fit in a status vector chunk with 1-bit symbols
+			const auto &feedback = *feedbacks[0];
+			uint16_t expected = 0x8000;
+			for (int j = 0; j < 10; ++j)
+				if (j != 3 && j != 4)
+					expected |= uint16_t(1 << (13 - j));
+
+			if (read(feedback, 4, 4) != 2 || read(feedback, 8, 4) != MediaSsrc ||
+			    read(feedback, 12, 2) != *base || read(feedback, 14, 2) != 10 ||
+			    read(feedback, 20, 2) != expected)
+				return TestResult(false, "Wrong feedback for lost packets");
+
+			sender.incoming(feedbacks, nullptr);
+			if (sink.results.size() != 1 || sink.results[0].size() != 10)
+				return TestResult(false, "Feedback not parsed");
+
+			const auto &results = sink.results[0];
+			for (size_t i = 0; i < results.size(); ++i) {
+				const auto &result = results[i];
+				if (result.sequenceNumber != uint16_t(*base + i) ||
+				    result.received != (i != 3 && i != 4) || !result.sendTime ||
+				    result.size != sizes[i])
+					return TestResult(false, "Wrong round trip result");
+
+				// The batch arrived at once, after the 64ms resolution reference time
+				if (result.received && i > 0 && result.arrivalDelta.count() != 0)
+					return TestResult(false, "Wrong arrival delta");
+			}
+			if (results[0].arrivalDelta < 0us || results[0].arrivalDelta >= 64ms)
+				return TestResult(false, "Wrong first arrival delta");
+		}
+
+		// Run length chunks, for received packets and for lost packets
+		{
+			TwccHandler receiver(nullptr, 2, 0ms);
+			receiver.media(makeMedia());
+
+			message_vector messages;
+			for (int i = 0; i < 20; ++i)
+				messages.push_back(makeStamped(uint16_t(500 + i)));
+
+			auto feedbacks = receive(receiver, messages);
+			if (feedbacks.size() != 1)
+				return TestResult(false, "No feedback generated for the run");
+
+			// 20 header bytes, one chunk, 20 small deltas, and 2 padding bytes
+			const auto &feedback = *feedbacks[0];
+			const binary header = {byte(0xAF), byte(205), byte(0), byte(10)};
+			if (feedback.size() != 44 || !equal(header.begin(), header.end(), feedback.begin()) ||
+			    read(feedback, 12, 2) != 500 || read(feedback, 14, 2) != 20 ||
+			    read(feedback, 19, 1) != 0 || read(feedback, 20, 2) != (0x2000 | 20) ||
+			    read(feedback, 43, 1) != 2)
+				return TestResult(false, "Wrong run length feedback");
+
+			for (size_t i = 23; i < 42; ++i)
+				if (feedback[i] != byte(0))
+					return TestResult(false, "Non-zero delta in a batch");
+
+			// The missing packets since the previous feedback are reported as lost
+			feedbacks = receive(receiver, {makeStamped(540)});
+			if (feedbacks.size() != 1 || read(*feedbacks[0], 12, 2) != 520 ||
+			    read(*feedbacks[0], 14, 2) != 21 || read(*feedbacks[0], 19, 1) != 1 ||
+			    read(*feedbacks[0], 20, 2) != 20 || read(*feedbacks[0], 22, 2) != 0xA000)
+				return TestResult(false, "Wrong run length feedback for lost packets");
+		}
+
+		// Status vector chunks with 2-bit symbols for negative and large deltas
+		{
+			FeedbackSink sink;
+			TwccHandler parser(sink.callback(), 1);
+			TwccHandler receiver(nullptr, 2, 300ms);
+			receiver.media(makeMedia());
+
+			// Reordered, then late, all reported in one feedback after the interval
+			if (!receive(receiver, {makeStamped(101)}).empty())
+				return TestResult(false, "Feedback generated before the interval");
+
+			this_thread::sleep_for(5ms);
+			if (!receive(receiver, {makeStamped(100)}).empty())
+				return TestResult(false, "Feedback generated before the interval");
+
+			this_thread::sleep_for(300ms);
+			auto feedbacks = receive(receiver, {makeStamped(102)});
+			if (feedbacks.size() != 1)
+				return TestResult(false, "No feedback generated after the interval");
+
+			const auto &feedback = *feedbacks[0];
+			if (read(feedback, 12, 2) != 100 || read(feedback, 14, 2) != 3 ||
+			    read(feedback, 20, 2) != (0xC000 | 1 << 12 | 2 << 10 | 2 << 8))
+				return TestResult(false, "Wrong 2-bit status vector chunk");
+
+			parser.incoming(feedbacks, nullptr);
+			if (sink.results.size() != 1 || sink.results[0].size() != 3)
+				return TestResult(false, "Feedback with large deltas not parsed");
+
+			const auto &results = sink.results[0];
+			if (!results[0].received || !results[1].received || !results[2].received ||
+			    results[1].arrivalDelta > -4ms || results[2].arrivalDelta < 250ms ||
+			    results[2].arrivalTime - results[0].arrivalTime < 250ms)
+				return TestResult(false, "Wrong negative or large deltas");
+
+			if (results[0].sendTime || results[0].size != 0)
+				return TestResult(false, "Unknown packet matched a sent packet");
+		}
+
+		// Sequence numbers wrap around, the next feedback starts after the last reported
+		{
+			FeedbackSink sink;
+			TwccHandler parser(sink.callback(), 1);
+			TwccHandler receiver(nullptr, 2, 0ms);
+			receiver.media(makeMedia());
+
+			message_vector messages;
+			for (int i = 0; i < 5; ++i)
+				messages.push_back(makeStamped(uint16_t(65533 + i)));
+
+			auto feedbacks = receive(receiver, messages);
+			if (feedbacks.size() != 1 || read(*feedbacks[0], 12, 2) != 65533 ||
+			    read(*feedbacks[0], 14, 2) != 5)
+				return TestResult(false, "Wrong feedback across the wraparound");
+
+			parser.incoming(feedbacks, nullptr);
+			if (sink.results.size() != 1 || sink.results[0].size() != 5 ||
+			    sink.results[0][2].sequenceNumber != 65535 ||
+			    sink.results[0][3].sequenceNumber != 0 || !sink.results[0][4].received)
+				return TestResult(false, "Wrong results across the wraparound");
+
+			feedbacks = receive(receiver, {makeStamped(2)});
+			if (feedbacks.size() != 1 || read(*feedbacks[0], 12, 2) != 2 ||
+			    read(*feedbacks[0], 14, 2) != 1)
+				return TestResult(false, "Wrong feedback after the wraparound");
+		}
+
+		// Parse a known compound packet: a receiver report followed by the feedback
+		{
+			FeedbackSink sink;
+			TwccHandler handler(sink.callback(), 1);
+
+			// Symbols for 65534 to 9: S S L N S L N N N N S S (S small, L large, N lost)
+			const binary packet = {
+			    // Receiver report without report block
+			    byte(0x80), byte(201), byte(0x00), byte(0x01), byte(0), byte(0), byte(0), byte(2),
+			    // Feedback header with padding, length 8
+			    byte(0xAF), byte(205), byte(0x00), byte(0x08),
+			    byte(0), byte(0), byte(0), byte(2),       // sender SSRC
+			    byte(0), byte(0), byte(0), byte(42),      // media SSRC
+			    byte(0xFF), byte(0xFE), byte(0x00), byte(12), // base sequence number, count
+			    byte(0x00), byte(0x00), byte(0x02), byte(7),  // reference time 128ms, count 7
+			    // Run length chunk of 2 small deltas
+			    byte(0x20), byte(0x02),
+			    // Status vector chunk with 2-bit symbols L N S L N N N
+			    byte(0xE1), byte(0x80),
+			    // Status vector chunk with 1-bit symbols N S S
+			    byte(0x98), byte(0x00),
+			    // Deltas: 1ms, 63.75ms, -8192ms, 0, 8191.75ms, 250us, 500us
+			    byte(0x04), byte(0xFF), byte(0x80), byte(0x00), byte(0x00), byte(0x7F), byte(0xFF),
+			    byte(0x01), byte(0x02),
+			    // Padding
+			    byte(0x01)};
+
+			auto truncated = binary(packet.begin(), packet.end() - 3);
+			truncated[11] = byte(0x07); // the length covers the truncated packet
+			message_vector messages{makeControl(truncated)};
+			handler.incoming(messages, nullptr);
+			if (!sink.results.empty())
+				return TestResult(false, "Truncated feedback parsed");
+
+			messages = {makeControl(packet)};
+			handler.incoming(messages, nullptr);
+			if (sink.results.size() != 1 || sink.results[0].size() != 12)
+				return TestResult(false, "Known feedback not parsed");
+
+			struct Expected {
+				uint16_t seq;
+				bool received;
+				int64_t delta; // us
+				int64_t time;  // us
+			};
+			const vector<Expected> expected = {
+			    {65534, true, 1000, 129000},    {65535, true, 63750, 192750},
+			    {0, true, -8192000, -7999250},  {1, false, 0, 0},
+			    {2, true, 0, -7999250},         {3, true, 8191750, 192500},
+			    {4, false, 0, 0},               {5, false, 0, 0},
+			    {6, false, 0, 0},               {7, false, 0, 0},
+			    {8, true, 250, 192750},         {9, true, 500, 193250}};
+
+			for (size_t i = 0; i < expected.size(); ++i) {
+				const auto &result = sink.results[0][i];
+				if (result.sequenceNumber != expected[i].seq ||
+				    result.received != expected[i].received ||
+				    result.arrivalDelta.count() != expected[i].delta ||
+				    result.arrivalTime.count() != expected[i].time || result.sendTime)
+					return TestResult(false, "Wrong result for the known feedback");
+			}
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
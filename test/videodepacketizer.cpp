@@ -0,0 +1,323 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+namespace {
+
+const SSRC MediaSsrc = 42;
+
+message_ptr makeRtp(uint16_t seqNumber, uint32_t timestamp, bool marker, const binary &payload) {
+	auto message = make_message(sizeof(RtpHeader) + payload.size());
+	auto rtp = reinterpret_cast<RtpHeader *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(MediaSsrc);
+	rtp->setSeqNumber(seqNumber);
+	rtp->setTimestamp(timestamp);
+	rtp->setMarker(marker);
+	std::copy(payload.begin(), payload.end(), message->begin() + sizeof(RtpHeader));
+	return message;
+}
+
+// Non-IDR slice carrying its sequence number, so the reassembled frame shows its packets
+binary makeSlice(uint16_t seqNumber) { return {byte(0x41), byte(seqNumber >> 8), byte(seqNumber)}; }
+
+message_ptr makeSlicePacket(uint16_t seqNumber, uint32_t timestamp, bool marker) {
+	return makeRtp(seqNumber, timestamp, marker, makeSlice(seqNumber));
+}
+
+// Frame of the slices with long start codes
+binary expectedFrame(const vector<uint16_t> &seqNumbers) {
+	binary frame;
+	for (auto seqNumber : seqNumbers) {
+		const binary startCode = {byte(0), byte(0), byte(0), byte(1)};
+		const binary slice = makeSlice(seqNumber);
+		frame.insert(frame.end(), startCode.begin(), startCode.end());
+		frame.insert(frame.end(), slice.begin(), slice.end());
+	}
+	return frame;
+}
+
+// Depacketizer chained with an RTCP receiving session, which sends the requests as RTCP
+struct Receiver {
+	shared_ptr<MediaHandler> depacketizer;
+	message_vector rtcp;
+
+	explicit Receiver(shared_ptr<VideoRtpDepacketizer> handler) : depacketizer(handler) {
+		depacketizer->addToChain(make_shared<RtcpReceivingSession>());
+	}
+
+	message_vector receive(message_vector messages) {
+		depacketizer->incoming(messages, [this](message_ptr message) { rtcp.push_back(message); });
+		return messages;
+	}
+
+	// Sequence numbers requested with NACK since the last call
+	vector<uint16_t> nacked() {
+		vector<uint16_t> result;
+		for (const auto &message : rtcp) {
+			auto header = reinterpret_cast<RtcpHeader *>(message->data());
+			if (header->payloadType() != 205 || header->reportCount() != 1)
+				continue;
+
+			auto nack = reinterpret_cast<RtcpNack *>(message->data());
+			for (unsigned int i = 0; i < nack->getSeqNoCount(); ++i) {
+				auto seqNumbers = nack->parts[i].getSequenceNumbers();
+				result.insert(result.end(), seqNumbers.begin(), seqNumbers.end());
+			}
+		}
+		clear(205);
+		return result;
+	}
+
+	// PLI count since the last call
+	size_t plis() {
+		size_t count = 0;
+		for (const auto &message : rtcp) {
+			auto header = reinterpret_cast<const RtcpHeader *>(message->data());
+			count += header->payloadType() == 206 && header->reportCount() == 1 ? 1 : 0;
+		}
+		clear(206);
+		return count;
+	}
+
+	void clear(uint8_t payloadType) {
+		auto it = std::remove_if(rtcp.begin(), rtcp.end(), [payloadType](const message_ptr &m) {
+			return reinterpret_cast<const RtcpHeader *>(m->data())->payloadType() == payloadType;
+		});
+		rtcp.erase(it, rtcp.end());
+	}
+};
+
+bool isFrame(const message_ptr &message, uint32_t timestamp, const binary &expected) {
+	return message->frameInfo && message->frameInfo->timestamp == timestamp &&
+	       binary(message->begin(), message->end()) == expected;
+}
+
+} // namespace
+
+TestResult test_video_jitter_buffer() {
+	try {
+		// In-order frames are emitted as soon as their last packet arrives, without requests
+		{
+			Receiver receiver(make_shared<H264RtpDepacketizer>());
+			auto frames = receiver.receive({makeSlicePacket(10, 1000, false)});
+			if (!frames.empty())
+				return TestResult(false, "Incomplete frame emitted");
+
+			frames = receiver.receive({makeSlicePacket(11, 1000, true)});
+			if (frames.size() != 1 || !isFrame(frames[0], 1000, expectedFrame({10, 11})))
+				return TestResult(false, "In-order frame not emitted");
+
+			if (!receiver.rtcp.empty())
+				return TestResult(false, "RTCP sent for an in-order stream");
+		}
+
+		// Reordered packets are requested with NACK, then frames are emitted in order
+		{
+			Receiver receiver(make_shared<H264RtpDepacketizer>());
+			receiver.receive({makeSlicePacket(10, 1000, false)});
+			auto frames = receiver.receive({makeSlicePacket(13, 4000, false)});
+			if (!frames.empty() || receiver.nacked() != vector<uint16_t>{11, 12})
+				return TestResult(false, "Missing packets not requested");
+
+			frames = receiver.receive({makeSlicePacket(14, 4000, true)});
+			if (!frames.empty())
+				return TestResult(false, "Frame emitted before the previous one");
+
+			frames = receiver.receive({makeSlicePacket(12, 1000, true)});
+			if (!frames.empty())
+				return TestResult(false, "Frame emitted with a missing packet");
+
+			frames = receiver.receive({makeSlicePacket(11, 1000, false)});
+			if (frames.size() != 2 || !isFrame(frames[0], 1000, expectedFrame({10, 11, 12})) ||
+			    !isFrame(frames[1], 4000, expectedFrame({13, 14})))
+				return TestResult(false, "Reordered frames not emitted in order");
+
+			if (!receiver.nacked().empty() || receiver.plis() != 0)
+				return TestResult(false, "Packets requested again after reordering");
+
+			// A duplicate of an emitted packet is dropped
+			frames = receiver.receive({makeSlicePacket(12, 1000, true)});
+			if (!frames.empty())
+				return TestResult(false, "Late duplicate emitted");
+		}
+
+		// A frame still incomplete after the delay is dropped and a keyframe is requested
+		{
+			auto depacketizer = make_shared<H264RtpDepacketizer>();
+			depacketizer->setTargetDelay(20ms);
+			Receiver receiver(depacketizer);
+			receiver.receive({makeSlicePacket(20, 1000, false), makeSlicePacket(21, 1000, true)});
+			auto frames = receiver.receive({makeSlicePacket(23, 2000, true)});
+			if (!frames.empty() || receiver.nacked() != vector<uint16_t>{22})
+				return TestResult(false, "Lost packet not requested");
+
+			// Timeouts are evaluated on incoming packets
+			this_thread::sleep_for(100ms);
+			frames = receiver.receive({makeSlicePacket(24, 3000, false)});
+			if (!frames.empty() || receiver.plis() != 1)
+				return TestResult(false, "No keyframe requested on timeout");
+
+			frames = receiver.receive({makeSlicePacket(25, 3000, true)});
+			if (frames.size() != 1 || !isFrame(frames[0], 3000, expectedFrame({24, 25})))
+				return TestResult(false, "Next frame not emitted after the drop");
+
+			// The retransmission arrives too late, it does not produce a frame
+			frames = receiver.receive({makeSlicePacket(22, 2000, false)});
+			if (!frames.empty() || receiver.plis() != 0)
+				return TestResult(false, "Late packet emitted");
+		}
+
+		// Sequence numbers wrap around, within frames and between them
+		{
+			Receiver receiver(make_shared<H264RtpDepacketizer>());
+			message_vector frames;
+			auto receive = [&](uint16_t seqNumber, uint32_t timestamp, bool marker) {
+				auto result = receiver.receive({makeSlicePacket(seqNumber, timestamp, marker)});
+				frames.insert(frames.end(), result.begin(), result.end());
+			};
+
+			receive(65533, 1000, false);
+			receive(65535, 2000, false);
+			if (receiver.nacked() != vector<uint16_t>{65534})
+				return TestResult(false, "Missing packet not requested before the wraparound");
+
+			receive(65534, 1000, true);
+			receive(1, 2000, true);
+			if (receiver.nacked() != vector<uint16_t>{0})
+				return TestResult(false, "Missing packet not requested after the wraparound");
+
+			receive(0, 2000, false);
+			receive(2, 3000, true);
+			if (frames.size() != 3 || !isFrame(frames[0], 1000, expectedFrame({65533, 65534})) ||
+			    !isFrame(frames[1], 2000, expectedFrame({65535, 0, 1})) ||
+			    !isFrame(frames[2], 3000, expectedFrame({2})))
+				return TestResult(false, "Wrong frames across the wraparound");
+
+			if (receiver.plis() != 0)
+				return TestResult(false, "Keyframe requested across the wraparound");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+TestResult test_video_reassembly() {
+	try {
+		const binary longStartCode = {byte(0), byte(0), byte(0), byte(1)};
+		const binary shortStartCode = {byte(0), byte(0), byte(1)};
+		auto concat = [](std::initializer_list<binary> parts) {
+			binary result;
+			for (const auto &part : parts)
+				result.insert(result.end(), part.begin(), part.end());
+			return result;
+		};
+
+		// H264 FU-A fragments are joined into a single NAL unit with its header restored
+		{
+			Receiver receiver(make_shared<H264RtpDepacketizer>());
+			const binary a = {byte(1), byte(2), byte(3)}, b = {byte(4), byte(5)}, c = {byte(6)};
+			const byte indicator{0x7C}; // NRI=3, FU-A
+			auto frames = receiver.receive({
+			    makeRtp(100, 1000, false, concat({{indicator, byte(0x85)}, a})), // S, IDR
+			    makeRtp(101, 1000, false, concat({{indicator, byte(0x05)}, b})),
+			    makeRtp(102, 1000, true, concat({{indicator, byte(0x45)}, c})), // E
+			});
+			const binary expected = concat({longStartCode, {byte(0x65)}, a, b, c});
+			if (frames.size() != 1 || !isFrame(frames[0], 1000, expected))
+				return TestResult(false, "Wrong H264 frame from FU-A fragments");
+
+			if (!frames[0]->frameInfo->keyframe)
+				return TestResult(false, "H264 IDR frame not flagged as keyframe");
+		}
+
+		// H264 STAP-A units are split, then followed by the next packets of the frame
+		{
+			using Separator = H264RtpDepacketizer::Separator;
+			Receiver receiver(make_shared<H264RtpDepacketizer>(Separator::ShortStartSequence));
+			const binary sps = {byte(0x67), byte(0x42), byte(0x00)}, pps = {byte(0x68), byte(0xCE)};
+			const binary idr = {byte(0x65), byte(0x88), byte(0x84)};
+			auto frames = receiver.receive({
+			    makeRtp(200, 2000, false,
+			            concat({{byte(0x78), byte(0), byte(sps.size())}, sps,
+			                    {byte(0), byte(pps.size())}, pps})),
+			    makeRtp(201, 2000, true, idr),
+			});
+			const binary expected =
+			    concat({shortStartCode, sps, shortStartCode, pps, shortStartCode, idr});
+			if (frames.size() != 1 || !isFrame(frames[0], 2000, expected))
+				return TestResult(false, "Wrong H264 frame from STAP-A");
+
+			if (!frames[0]->frameInfo->keyframe)
+				return TestResult(false, "H264 IDR frame in STAP-A not flagged as keyframe");
+		}
+
+		// Without marker bit, a frame ends when the timestamp changes, and padding is stripped
+		{
+			Receiver receiver(make_shared<H264RtpDepacketizer>());
+			auto padded = makeRtp(301, 3000, false, concat({makeSlice(301), {byte(0), byte(2)}}));
+			reinterpret_cast<RtpHeader *>(padded->data())->setPadding(true);
+			auto frames =
+			    receiver.receive({makeSlicePacket(300, 3000, false), std::move(padded)});
+			if (!frames.empty())
+				return TestResult(false, "Frame emitted before it ended");
+
+			frames = receiver.receive({makeSlicePacket(302, 6000, true)});
+			if (frames.size() != 2 || !isFrame(frames[0], 3000, expectedFrame({300, 301})) ||
+			    !isFrame(frames[1], 6000, expectedFrame({302})))
+				return TestResult(false, "Frame not ended by the timestamp change");
+
+			if (frames[0]->frameInfo->keyframe)
+				return TestResult(false, "H264 non-IDR frame flagged as keyframe");
+		}
+
+		// H265 fragmentation units across the wraparound
+		{
+			Receiver receiver(make_shared<H265RtpDepacketizer>());
+			const binary a = {byte(1), byte(2)}, b = {byte(3), byte(4), byte(5)};
+			const binary header = {byte(49 << 1), byte(0x01)}; // FU, TID=1
+			auto frames = receiver.receive({
+			    makeRtp(65535, 4000, false, concat({header, {byte(0x80 | 19)}, a})), // S, IDR
+			    makeRtp(0, 4000, true, concat({header, {byte(0x40 | 19)}, b})),      // E
+			});
+			const binary expected = concat({longStartCode, {byte(19 << 1), byte(0x01)}, a, b});
+			if (frames.size() != 1 || !isFrame(frames[0], 4000, expected))
+				return TestResult(false, "Wrong H265 frame from fragmentation units");
+
+			if (!frames[0]->frameInfo->keyframe)
+				return TestResult(false, "H265 IDR frame not flagged as keyframe");
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include "impl/wshandshake.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+
+using impl::WsHandshake;
+
+namespace {
+
+template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
+
+// Run a handshake and return the compression negotiated by the client and the server
+pair<optional<WsHandshake::Compression>, optional<WsHandshake::Compression>>
+negotiate(optional<WsHandshake::Compression> clientConfig,
+          optional<WsHandshake::Compression> serverConfig) {
+	WsHandshake client("localhost", "/", {}, clientConfig);
+	WsHandshake server(serverConfig);
+
+	string request = client.generateHttpRequest();
+	server.parseHttpRequest(reinterpret_cast<const byte *>(request.data()), request.size());
+	string response = server.generateHttpResponse();
+	client.parseHttpResponse(reinterpret_cast<const byte *>(response.data()), response.size());
+
+	return {client.compression(), server.compression()};
+}
+
+// Handshake request with a custom Sec-WebSocket-Extensions header
+optional<WsHandshake::Compression> offer(const string &extensions,
+                                         WsHandshake::Compression serverConfig) {
+	WsHandshake server(serverConfig);
+	string request = "GET / HTTP/1.1\r\n"
+	                 "Host: localhost\r\n"
+	                 "Upgrade: websocket\r\n"
+	                 "Connection: Upgrade\r\n"
+	                 "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+	                 "Sec-WebSocket-Version: 13\r\n"
+	                 "Sec-WebSocket-Extensions: " +
+	                 extensions + "\r\n\r\n";
+
+	server.parseHttpRequest(reinterpret_cast<const byte *>(request.data()), request.size());
+	return server.compression();
+}
+
+} // namespace
+
+TestResult test_websocket_compression() {
+	InitLogger(LogLevel::Debug);
+
+	try {
+		// Negotiation (RFC 7692)
+		auto [none, noneServer] = negotiate(nullopt, WsHandshake::Compression{});
+		if (none || noneServer)
+			return TestResult(false, "Compression negotiated without a client offer");
+
+		auto [declined, declinedServer] = negotiate(WsHandshake::Compression{}, nullopt);
+		if (declined || declinedServer)
+			return TestResult(false, "Compression negotiated without server support");
+
+		auto [client, server] =
+		    negotiate(WsHandshake::Compression{10, false}, WsHandshake::Compression{12, true});
+		if (!client || !server)
+			return TestResult(false, "Compression not negotiated");
+
+		// Each side compresses with its own parameters, capped by what the peer accepts
+		if (client->windowBits != 10 || client->contextTakeover)
+			return TestResult(false, "Wrong client compression parameters");
+
+		if (server->windowBits != 10 || server->contextTakeover)
+			return TestResult(false, "Wrong server compression parameters");
+
+		auto accepted = offer("permessage-deflate; client_max_window_bits", {15, true});
+		if (!accepted || accepted->windowBits != 15 || !accepted->contextTakeover)
+			return TestResult(false, "Default offer not accepted");
+
+		// The first acceptable offer wins
+		accepted = offer("permessage-deflate; unknown_param, "
+		                 "permessage-deflate; server_max_window_bits=11",
+		                 {15, true});
+		if (!accepted || accepted->windowBits != 11)
+			return TestResult(false, "Fallback offer not accepted");
+
+		if (offer("permessage-deflate; server_max_window_bits=08", {15, true}) ||
+		    offer("permessage-deflate; server_max_window_bits=16", {15, true}) ||
+		    offer("permessage-deflate; server_max_window_bits=8", {15, true}) ||
+		    offer("permessage-deflate; server_no_context_takeover; server_no_context_takeover",
+		          {15, true}) ||
+		    offer("x-webkit-deflate-frame", {15, true}))
+			return TestResult(false, "Invalid offer accepted");
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+
+	// Compressed messages over a connection
+	WebSocketServer::Configuration serverConfig;
+	serverConfig.port = 48082;
+	serverConfig.bindAddress = "127.0.0.1";
+	serverConfig.maxMessageSize = 100000; // to test max message size after decompression
+	serverConfig.enableCompression = true;
+	serverConfig.compressionThreshold = 16;
+	WebSocketServer server(std::move(serverConfig));
+
+	shared_ptr<WebSocket> incoming;
+	server.onClient([&incoming](shared_ptr<WebSocket> ws) {
+		incoming = ws;
+		ws->onMessage([wws = make_weak_ptr(ws)](variant<binary, string> message) {
+			if (auto ws = wws.lock())
+				ws->send(std::move(message));
+		});
+	});
+
+	WebSocket::Configuration config;
+	config.enableCompression = true;
+	config.disableCompressionContextTakeover = true;
+	config.compressionWindowBits = 10;
+	WebSocket ws(std::move(config));
+
+	const string small = "Hello";
+	string large;
+	while (large.size() < 50000)
+		large += "Compressible message " + to_string(large.size()) + " ";
+
+	ws.onOpen([&]() {
+		cout << "WebSocket: Open" << endl;
+		ws.send(small);
+		ws.send(large);
+		ws.send(large); // a second time to check the context is reset properly
+		ws.send(binary(200000, byte(0x42))); // compresses well but exceeds the max size
+	});
+
+	std::atomic<int> received = 0;
+	std::atomic<bool> truncated = false;
+	std::atomic<bool> unexpected = false;
+	ws.onMessage([&](variant<binary, string> message) {
+		if (holds_alternative<string>(message)) {
+			const auto &str = get<string>(message);
+			if (str != (received == 0 ? small : large)) {
+				cout << "WebSocket: Received UNEXPECTED message" << endl;
+				unexpected = true;
+			}
+			++received;
+		} else {
+			const auto &bin = get<binary>(message);
+			truncated = bin.size() == 100000 &&
+			            std::all_of(bin.begin(), bin.end(), [](byte b) { return b == byte(0x42); });
+		}
+	});
+
+	ws.open("ws://localhost:48082/");
+
+	int attempts = 15;
+	while ((received < 3 || !truncated) && !unexpected && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!ws.isOpen())
+		return TestResult(false, "WebSocket is not open");
+
+	if (unexpected || received != 3)
+		return TestResult(false, "Compressed messages not received correctly");
+
+	if (!truncated)
+		return TestResult(false, "Large compressed message not truncated at max size");
+
+	ws.close();
+	this_thread::sleep_for(1s);
+
+	server.stop();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif
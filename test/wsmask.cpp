@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "impl/wsmask.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+using impl::apply_mask;
+
+namespace {
+
+const size_t MaxSize = 80; // covers the vector, 8-byte and tail loops several times
+const size_t MaxOffset = 16;
+
+const byte MaskingKey[4] = {byte(0x37), byte(0xFA), byte(0x21), byte(0x3D)};
+
+vector<byte> makeData(size_t size) {
+	vector<byte> data(size);
+	for (size_t i = 0; i < size; ++i)
+		data[i] = byte(i * 7 + 3);
+	return data;
+}
+
+// Byte-wise masking as specified in RFC 6455 5.3
+vector<byte> reference(const vector<byte> &data) {
+	vector<byte> masked(data.size());
+	for (size_t i = 0; i < data.size(); ++i)
+		masked[i] = data[i] ^ MaskingKey[i % 4];
+	return masked;
+}
+
+} // namespace
+
+TestResult test_websocket_mask() {
+	try {
+		const byte guard = byte(0xA5);
+		for (size_t size = 0; size <= MaxSize; ++size) {
+			const auto data = makeData(size);
+			const auto expected = reference(data);
+
+			// Copy between buffers with every misalignment of the source and the destination
+			for (size_t srcOffset = 0; srcOffset < MaxOffset; ++srcOffset) {
+				for (size_t dstOffset = 0; dstOffset < MaxOffset; ++dstOffset) {
+					vector<byte> src(MaxOffset + size);
+					std::copy(data.begin(), data.end(), src.begin() + srcOffset);
+					vector<byte> dst(MaxOffset + size + MaxOffset, guard);
+					apply_mask(dst.data() + dstOffset, src.data() + srcOffset, size, MaskingKey);
+
+					if (!std::equal(expected.begin(), expected.end(), dst.begin() + dstOffset))
+						return TestResult(false, "Wrong masked data for size " +
+						                             to_string(size) + ", offsets " +
+						                             to_string(srcOffset) + " and " +
+						                             to_string(dstOffset));
+
+					auto isGuard = [guard](byte b) { return b == guard; };
+					if (!std::all_of(dst.begin(), dst.begin() + dstOffset, isGuard) ||
+					    !std::all_of(dst.begin() + dstOffset + size, dst.end(), isGuard))
+						return TestResult(false, "Write outside the destination for size " +
+						                             to_string(size));
+				}
+			}
+
+			// In place, as for received frames, unmasking again restores the data
+			for (size_t offset = 0; offset < MaxOffset; ++offset) {
+				vector<byte> buffer(MaxOffset + size);
+				std::copy(data.begin(), data.end(), buffer.begin() + offset);
+				byte *p = buffer.data() + offset;
+				apply_mask(p, p, size, MaskingKey);
+				if (!std::equal(expected.begin(), expected.end(), p))
+					return TestResult(false, "Wrong in-place masked data for size " +
+					                             to_string(size) + ", offset " +
+					                             to_string(offset));
+
+				apply_mask(p, p, size, MaskingKey);
+				if (!std::equal(data.begin(), data.end(), p))
+					return TestResult(false, "Unmasking does not restore the data");
+			}
+		}
+
+		return TestResult(true);
+
+	} catch (const exception &e) {
+		return TestResult(false, e.what());
+	}
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2026 Paul-Louis Ageneau
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "rtc/rtc.hpp"
+#include "test.hpp"
+
+#if RTC_ENABLE_WEBSOCKET
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
+
+namespace {
+
+string toString(const Message &message) {
+	return string(reinterpret_cast<const char *>(message.data()), message.size());
+}
+
+} // namespace
+
+TestResult test_websocket_messages() {
+	InitLogger(LogLevel::Debug);
+
+	const size_t count = 200;
+	const size_t pullCount = 5;
+
+	WebSocketServer::Configuration serverConfig;
+	serverConfig.port = 48085;
+	serverConfig.bindAddress = "127.0.0.1";
+	WebSocketServer server(std::move(serverConfig));
+
+	std::mutex mutex;
+	vector<shared_ptr<WebSocket>> clients;
+	server.onClient([&](shared_ptr<WebSocket> incoming) {
+		// Messages are sent at once, then the connection is closed on "/close"
+		incoming->onOpen([wclient = make_weak_ptr(incoming)]() {
+			auto client = wclient.lock();
+			if (!client)
+				return;
+
+			const bool close = client->path() == "/close";
+			for (size_t i = 0; i < (close ? count : pullCount); ++i)
+				client->send("message " + to_string(i));
+
+			if (close)
+				client->close();
+		});
+
+		std::lock_guard lock(mutex);
+		clients.push_back(std::move(incoming));
+	});
+
+	// Batches replace the message callback and are all delivered before the close
+	WebSocket ws;
+	vector<string> received;
+	std::atomic<size_t> batches = 0;
+	std::atomic<bool> emptyBatch = false;
+	std::atomic<bool> single = false;
+	std::atomic<bool> closed = false;
+	std::atomic<size_t> receivedBeforeClose = 0;
+	ws.onMessage([&single](message_variant) { single = true; });
+	ws.onMessages([&](vector<shared_ptr<const Message>> messages) {
+		if (messages.empty())
+			emptyBatch = true;
+
+		++batches;
+		std::lock_guard lock(mutex);
+		for (const auto &message : messages)
+			received.push_back(toString(*message));
+	});
+	ws.onClosed([&]() {
+		{
+			std::lock_guard lock(mutex);
+			receivedBeforeClose = received.size();
+		}
+		closed = true;
+	});
+
+	ws.open("ws://localhost:48085/close");
+
+	int attempts = 10;
+	while (!closed && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!closed)
+		return TestResult(false, "WebSocket not closed by the server");
+
+	{
+		std::lock_guard lock(mutex);
+		if (received.size() != count)
+			return TestResult(false, "Wrong number of batched messages");
+
+		for (size_t i = 0; i < count; ++i)
+			if (received[i] != "message " + to_string(i))
+				return TestResult(false, "Batched messages out of order");
+	}
+
+	if (receivedBeforeClose != count)
+		return TestResult(false, "Batched messages not delivered before the close");
+
+	if (emptyBatch || batches == 0 || batches > count)
+		return TestResult(false, "Wrong batches");
+
+	if (single)
+		return TestResult(false, "Message callback called along with batches");
+
+	cout << "WebSocket: Received " << count << " messages in " << batches << " batches" << endl;
+
+	// Without callbacks, messages are queued and announced, then passed at once
+	WebSocket pull;
+	std::atomic<bool> available = false;
+	pull.onAvailable([&available]() { available = true; });
+	pull.open("ws://localhost:48085/pull");
+
+	const size_t amount = pullCount * string("message 0").size();
+	attempts = 100;
+	while ((!available || pull.availableAmount() < amount) && attempts--)
+		this_thread::sleep_for(100ms);
+
+	if (!available || pull.availableAmount() != amount)
+		return TestResult(false, "Queued messages not announced");
+
+	int pulled = 0;
+	bool ordered = true;
+	pull.onMessages([&](vector<shared_ptr<const Message>> messages) {
+		++pulled;
+		ordered = messages.size() == pullCount;
+		for (size_t i = 0; ordered && i < messages.size(); ++i)
+			ordered = toString(*messages[i]) == "message " + to_string(i);
+	});
+
+	if (pulled != 1 || !ordered || pull.availableAmount() != 0)
+		return TestResult(false, "Queued messages not passed in a single batch");
+
+	pull.close();
+	this_thread::sleep_for(1s);
+
+	server.stop();
+	this_thread::sleep_for(1s);
+
+	return TestResult(true);
+}
+
+#endif